@@ -30,6 +30,19 @@ extern void * memset(void *, int, __kernel_size_t);
 
 extern void __memzero(void *ptr, __kernel_size_t n);
 
+/*
+ * memcpy() and memset() for buffers of several KB, done with NEON outside of
+ * interrupt context when the size is at least NEON_STRING_MIN_SIZE.
+ */
+#ifdef CONFIG_ARM_NEON_MEMCPY
+#define NEON_STRING_MIN_SIZE	2048
+extern void *neon_memcpy(void *, const void *, __kernel_size_t);
+extern void *neon_memset(void *, int, __kernel_size_t);
+#else
+#define neon_memcpy(d, s, n)	memcpy(d, s, n)
+#define neon_memset(p, v, n)	memset(p, v, n)
+#endif
+
 #define memset(p,v,n)							\
 	({								\
 	 	void *__p = (p); size_t __n = n;			\
@@ -0,0 +1,24 @@
+/*
+ * linux/arch/arm/lib/lz4-neon.c
+ *
+ * LZ4 decompression with NEON copies.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __ARM_NEON__
+#error You should compile this file with '-mfloat-abi=softfp -mfpu=neon'
+#endif
+
+/*
+ * Pull in the reference implementation, with the literal and match copies
+ * done 8 bytes at a time by NEON loads and stores. The functions are called
+ * by lib/lz4 between kernel_neon_begin() and kernel_neon_end().
+ */
+#define LZ4_NEON
+#define lz4_decompress lz4_decompress_neon
+#define lz4_decompress_unknownoutputsize lz4_decompress_unknownoutputsize_neon
+
+#include "../../../lib/lz4/lz4_decompress.c"
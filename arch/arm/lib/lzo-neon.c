@@ -0,0 +1,24 @@
+/*
+ * linux/arch/arm/lib/lzo-neon.c
+ *
+ * LZO1X decompression with NEON copies.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __ARM_NEON__
+#error You should compile this file with '-mfloat-abi=softfp -mfpu=neon'
+#endif
+
+/*
+ * Pull in the reference implementation, with the literal and match copies
+ * done by NEON loads and stores, 16 bytes per loop as on x86-64. The
+ * function is called by lib/lzo between kernel_neon_begin() and
+ * kernel_neon_end().
+ */
+#define LZO_NEON
+#define lzo1x_decompress_safe lzo1x_decompress_safe_neon
+
+#include "../../../lib/lzo/lzo1x_decompress_safe.c"
@@ -0,0 +1,106 @@
+/*
+ * linux/arch/arm/lib/memcpy-neon-bench.c
+ *
+ * Throughput of memcpy() and memset() against their NEON versions
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <asm/sizes.h>
+
+#define BENCH_MAX_SIZE		SZ_1M
+
+/* Every size is run until this many bytes have been copied */
+static unsigned int total_mb = 64;
+module_param(total_mb, uint, 0444);
+MODULE_PARM_DESC(total_mb, "MB copied for each size and routine");
+
+enum bench_op {
+	BENCH_MEMCPY,
+	BENCH_NEON_MEMCPY,
+	BENCH_MEMSET,
+	BENCH_NEON_MEMSET,
+};
+
+static u32 __init bench_run(enum bench_op op, void *dst, void *src,
+			    size_t size)
+{
+	unsigned int loops = DIV_ROUND_UP(total_mb * SZ_1M, size);
+	unsigned int i;
+	ktime_t start;
+	s64 ns;
+
+	start = ktime_get();
+	for (i = 0; i < loops; i++) {
+		switch (op) {
+		case BENCH_MEMCPY:
+			memcpy(dst, src, size);
+			break;
+		case BENCH_NEON_MEMCPY:
+			neon_memcpy(dst, src, size);
+			break;
+		case BENCH_MEMSET:
+			memset(dst, i, size);
+			break;
+		case BENCH_NEON_MEMSET:
+			neon_memset(dst, i, size);
+			break;
+		}
+	}
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	if (ns <= 0)
+		return 0;
+
+	/* MB/s = bytes * 1000 / ns */
+	return div64_u64((u64)loops * size * 1000, ns) >> 20;
+}
+
+static int __init memcpy_neon_bench_init(void)
+{
+	void *src, *dst;
+	size_t size;
+
+	src = vmalloc(BENCH_MAX_SIZE);
+	dst = vmalloc(BENCH_MAX_SIZE);
+	if (!src || !dst) {
+		vfree(dst);
+		vfree(src);
+		return -ENOMEM;
+	}
+	memset(src, 0x5a, BENCH_MAX_SIZE);
+
+	pr_info("memcpy neon bench: neon from %u bytes, MB/s:\n",
+		NEON_STRING_MIN_SIZE);
+	pr_info("%8s %8s %12s %8s %12s\n", "size", "memcpy", "neon_memcpy",
+		"memset", "neon_memset");
+	for (size = 256; size <= BENCH_MAX_SIZE; size *= 4) {
+		pr_info("%8zu %8u %12u %8u %12u\n", size,
+			bench_run(BENCH_MEMCPY, dst, src, size),
+			bench_run(BENCH_NEON_MEMCPY, dst, src, size),
+			bench_run(BENCH_MEMSET, dst, src, size),
+			bench_run(BENCH_NEON_MEMSET, dst, src, size));
+	}
+
+	vfree(dst);
+	vfree(src);
+
+	return 0;
+}
+
+static void __exit memcpy_neon_bench_exit(void)
+{
+}
+
+module_init(memcpy_neon_bench_init);
+module_exit(memcpy_neon_bench_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Throughput of the NEON memcpy and memset");
@@ -0,0 +1,89 @@
+/*
+ * linux/arch/arm/lib/string-neon.c
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/export.h>
+#include <linux/kernel.h>
+#include <linux/hardirq.h>
+#include <linux/string.h>
+#include <asm/neon.h>
+#include <asm/sizes.h>
+
+#define NEON_BLOCK_SIZE		64
+
+/* Preemption is disabled while NEON is in use, give it a chance per chunk */
+#define NEON_CHUNK_SIZE		SZ_64K
+
+extern void __memcpy_neon_blocks(void *dst, const void *src, size_t n);
+extern void __memset_neon_blocks(void *dst, int c, size_t n);
+
+/*
+ * Saving the user VFP state in kernel_neon_begin() costs about as much as a
+ * NEON copy of a couple of KB wins over the integer copy, do shorter copies
+ * with the integer routines.
+ */
+static inline bool neon_string_usable(size_t n)
+{
+	return n >= NEON_STRING_MIN_SIZE && cpu_has_neon() && !in_interrupt();
+}
+
+/**
+ * neon_memcpy() - memcpy() of large buffers using NEON
+ *
+ * Copies of at least NEON_STRING_MIN_SIZE bytes are done with NEON when it
+ * may be used, that is outside of interrupt context. Shorter copies and
+ * copies in interrupt context are done by memcpy().
+ */
+void *neon_memcpy(void *dst, const void *src, size_t n)
+{
+	size_t bulk = n & ~(NEON_BLOCK_SIZE - 1);
+	size_t done;
+	size_t len;
+
+	if (!neon_string_usable(n))
+		return memcpy(dst, src, n);
+
+	for (done = 0; done < bulk; done += len) {
+		len = min_t(size_t, bulk - done, NEON_CHUNK_SIZE);
+		kernel_neon_begin();
+		__memcpy_neon_blocks(dst + done, src + done, len);
+		kernel_neon_end();
+	}
+
+	if (n != bulk)
+		memcpy(dst + bulk, src + bulk, n - bulk);
+
+	return dst;
+}
+EXPORT_SYMBOL(neon_memcpy);
+
+/**
+ * neon_memset() - memset() of large buffers using NEON
+ *
+ * Used the same way as neon_memcpy().
+ */
+void *neon_memset(void *dst, int c, size_t n)
+{
+	size_t bulk = n & ~(NEON_BLOCK_SIZE - 1);
+	size_t done;
+	size_t len;
+
+	if (!neon_string_usable(n))
+		return memset(dst, c, n);
+
+	for (done = 0; done < bulk; done += len) {
+		len = min_t(size_t, bulk - done, NEON_CHUNK_SIZE);
+		kernel_neon_begin();
+		__memset_neon_blocks(dst + done, c, len);
+		kernel_neon_end();
+	}
+
+	if (n != bulk)
+		memset(dst + bulk, c, n - bulk);
+
+	return dst;
+}
+EXPORT_SYMBOL(neon_memset);
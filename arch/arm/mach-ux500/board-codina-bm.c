@@ -500,6 +500,7 @@ static const struct ab8500_fg_parameters fg = {
 	.high_curr_time = 60,
 	.accu_charging = 20,
 	.accu_high_curr = 20,
+	.accu_low_curr = 60,
 	.high_curr_threshold = 50,
 	.lowbat_threshold = 3300,
 	.battok_falling_th_sel0 = 2860,
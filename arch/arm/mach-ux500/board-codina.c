@@ -1490,6 +1490,37 @@ struct platform_device usb_phonet_device = {
 
 #endif /* CONFIG_USB_ANDROID */
 
+#ifdef CONFIG_STE_DMA40
+#define U8500_I2C_DMA(id, dev_type)			\
+static struct stedma40_chan_cfg codina_i2c##id##_dma_rx = {	\
+	.mode = STEDMA40_MODE_LOGICAL,			\
+	.dir = STEDMA40_PERIPH_TO_MEM,			\
+	.src_dev_type = DB8500_DMA_DEV##dev_type##_RX,	\
+	.dst_dev_type = STEDMA40_DEV_DST_MEMORY,	\
+	.src_info.data_width = STEDMA40_BYTE_WIDTH,	\
+	.dst_info.data_width = STEDMA40_BYTE_WIDTH,	\
+};							\
+static struct stedma40_chan_cfg codina_i2c##id##_dma_tx = {	\
+	.mode = STEDMA40_MODE_LOGICAL,			\
+	.dir = STEDMA40_MEM_TO_PERIPH,			\
+	.src_dev_type = STEDMA40_DEV_SRC_MEMORY,	\
+	.dst_dev_type = DB8500_DMA_DEV##dev_type##_TX,	\
+	.src_info.data_width = STEDMA40_BYTE_WIDTH,	\
+	.dst_info.data_width = STEDMA40_BYTE_WIDTH,	\
+}
+#define U8500_I2C_DMA_PARAMS(id)			\
+	.dma_filter	= stedma40_filter,		\
+	.dma_rx_param	= &codina_i2c##id##_dma_rx,	\
+	.dma_tx_param	= &codina_i2c##id##_dma_tx,
+
+U8500_I2C_DMA(0, 15_I2C0);
+U8500_I2C_DMA(1, 4_I2C1);
+U8500_I2C_DMA(2, 6_I2C2);
+U8500_I2C_DMA(3, 5_I2C3);
+#else
+#define U8500_I2C_DMA_PARAMS(id)
+#endif
+
 #define U8500_I2C_CONTROLLER(id, _slsu, _tft, _rft, clk, t_out, _sm) \
 static struct nmk_i2c_controller codina_i2c##id##_data = { \
 	/*				\
@@ -1508,6 +1539,7 @@ static struct nmk_i2c_controller codina_i2c##id##_data = { \
 	/* Slave response timeout(ms) */\
 	.timeout	= t_out,	\
 	.sm		= _sm,		\
+	U8500_I2C_DMA_PARAMS(id)	\
 }
 
 /*
@@ -2360,9 +2392,21 @@ static void __init u8500_cryp1_hash1_init(void)
 	db8500_add_hash1(&u8500_hash1_platform_data);
 }
 
+/* Not needed to reach the home screen, bound once the initcalls are done */
+static const char * const codina_probe_late_drivers[] __initconst = {
+	"accsns_i2c",
+	"hscd_i2c",
+	"tmd2672_prox",
+	"db8500-modem-trace",
+};
 
 static void __init codina_init_machine(void)
 {
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(codina_probe_late_drivers); i++)
+		driver_probe_late(codina_probe_late_drivers[i]);
+
 	sec_common_init();
 
 	sec_common_init_early();
@@ -2602,6 +2646,7 @@ MACHINE_START(CODINA, "SAMSUNG CODINA")
 	/* Maintainer: SAMSUNG based on ST Ericsson */
 	.boot_params	= 0x100,
 	.map_io		= u8500_map_io,
+	.reserve	= ux500_hwmem_reserve,
 	.init_irq	= ux500_init_irq,
 	.timer		= &ux500_timer,
 	.init_machine	= codina_init_machine,
@@ -1546,6 +1546,37 @@ struct platform_device usb_phonet_device = {
 
 #endif /* CONFIG_USB_ANDROID */
 
+#ifdef CONFIG_STE_DMA40
+#define U8500_I2C_DMA(id, dev_type)			\
+static struct stedma40_chan_cfg codina_i2c##id##_dma_rx = {	\
+	.mode = STEDMA40_MODE_LOGICAL,			\
+	.dir = STEDMA40_PERIPH_TO_MEM,			\
+	.src_dev_type = DB8500_DMA_DEV##dev_type##_RX,	\
+	.dst_dev_type = STEDMA40_DEV_DST_MEMORY,	\
+	.src_info.data_width = STEDMA40_BYTE_WIDTH,	\
+	.dst_info.data_width = STEDMA40_BYTE_WIDTH,	\
+};							\
+static struct stedma40_chan_cfg codina_i2c##id##_dma_tx = {	\
+	.mode = STEDMA40_MODE_LOGICAL,			\
+	.dir = STEDMA40_MEM_TO_PERIPH,			\
+	.src_dev_type = STEDMA40_DEV_SRC_MEMORY,	\
+	.dst_dev_type = DB8500_DMA_DEV##dev_type##_TX,	\
+	.src_info.data_width = STEDMA40_BYTE_WIDTH,	\
+	.dst_info.data_width = STEDMA40_BYTE_WIDTH,	\
+}
+#define U8500_I2C_DMA_PARAMS(id)			\
+	.dma_filter	= stedma40_filter,		\
+	.dma_rx_param	= &codina_i2c##id##_dma_rx,	\
+	.dma_tx_param	= &codina_i2c##id##_dma_tx,
+
+U8500_I2C_DMA(0, 15_I2C0);
+U8500_I2C_DMA(1, 4_I2C1);
+U8500_I2C_DMA(2, 6_I2C2);
+U8500_I2C_DMA(3, 5_I2C3);
+#else
+#define U8500_I2C_DMA_PARAMS(id)
+#endif
+
 #define U8500_I2C_CONTROLLER(id, _slsu, _tft, _rft, clk, t_out, _sm) \
 static struct nmk_i2c_controller codina_i2c##id##_data = { \
 	/*				\
@@ -1564,6 +1595,7 @@ static struct nmk_i2c_controller codina_i2c##id##_data = { \
 	/* Slave response timeout(ms) */\
 	.timeout	= t_out,	\
 	.sm		= _sm,		\
+	U8500_I2C_DMA_PARAMS(id)	\
 }
 
 /*
@@ -2668,6 +2700,7 @@ MACHINE_START(CODINA, "SAMSUNG CODINA")
 	/* Maintainer: SAMSUNG based on ST Ericsson */
 	.atag_offset	= 0x100,
 	.map_io		= u8500_map_io,
+	.reserve	= ux500_hwmem_reserve,
 	.init_irq	= ux500_init_irq,
 	.timer		= &ux500_timer,
 	.handle_irq     = gic_handle_irq,
@@ -1115,6 +1115,10 @@ static struct amba_pl011_data uart0_plat = {
 	.dma_filter = stedma40_filter,
 	.dma_rx_param = &uart0_dma_cfg_rx,
 	.dma_tx_param = &uart0_dma_cfg_tx,
+	/* CG2900 A2DP and GNSS streams */
+	.dma_rx_buf_size = 4 * PAGE_SIZE,
+	.dma_rx_poll_rate = 5,
+	.dma_rx_poll_timeout = 100,
 #endif
 	.init = ux500_uart0_init,
 	.exit = ux500_uart0_exit,
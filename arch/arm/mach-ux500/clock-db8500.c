@@ -906,6 +906,7 @@ static struct clk sdmmcclk = {
 	.ops = &clk_ops_sdmmcclk,
 	.cg_sel = PRCMU_SDMMCCLK,
 	.mutex = &sdmmcclk_mutex,
+	.lazy_disable = true,
 };
 
 static struct clk soc0_pll = {
@@ -928,6 +929,7 @@ static struct clk b2r2clk = {
 	.cg_sel = PRCMU_B2R2CLK,
 	.mutex = &b2r2_mutex,
 	.rate = 200000000,
+	.lazy_disable = true,
 };
 
 static struct clk ddr_pll = {
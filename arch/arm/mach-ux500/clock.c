@@ -10,6 +10,8 @@
 #include <linux/errno.h>
 #include <linux/io.h>
 #include <linux/spinlock.h>
+#include <linux/suspend.h>
+#include <linux/workqueue.h>
 #include <linux/mfd/abx500/ux500_sysctrl.h>
 #include <linux/mfd/dbx500-prcmu.h>
 
@@ -140,6 +142,25 @@ void prcmu_reroute_clk_fp(void)
 
 #endif
 
+/*
+ * A clock with lazy_disable set is turned off only disable_delay_ms after
+ * its last disable, so that drivers enabling a clock around each transfer
+ * do not make two PRCMU requests per transfer. It is counted as disabled
+ * meanwhile, only the hardware and the parents are left on. Each enable
+ * in the grace period is counted in disables_avoided and saves a disable
+ * and an enable request.
+ */
+static unsigned int clk_disable_delay_ms = 20;
+module_param_named(disable_delay_ms, clk_disable_delay_ms, uint, 0644);
+static unsigned long clk_disables_avoided;
+module_param_named(disables_avoided, clk_disables_avoided, ulong, 0444);
+
+static bool clk_disable_lazy;	/* off until workqueues, and in suspend */
+static LIST_HEAD(clk_disable_list);
+static DEFINE_SPINLOCK(clk_disable_lock);
+static void clk_disable_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(clk_disable_work, clk_disable_work_fn);
+
 static void __clk_lock(struct clk *clk, void *last_lock, unsigned long *flags)
 {
 	if (clk->mutex != last_lock) {
@@ -160,6 +181,135 @@ static void __clk_unlock(struct clk *clk, void *last_lock, unsigned long flags)
 	}
 }
 
+/* Turns off a clock with no enable requests left, with its lock held */
+static void __clk_hw_disable(struct clk *clk)
+{
+	if ((clk->ops != NULL) && (clk->ops->disable != NULL))
+		clk->ops->disable(clk);
+	__clk_disable(clk->parent, clk->mutex);
+	__clk_disable(clk->bus_parent, clk->mutex);
+}
+
+static bool __clk_defer_disable(struct clk *clk)
+{
+	unsigned long delay = msecs_to_jiffies(clk_disable_delay_ms);
+	unsigned long flags;
+
+	if (!clk->lazy_disable || !clk_disable_lazy || !delay)
+		return false;
+
+	spin_lock_irqsave(&clk_disable_lock, flags);
+	clk->disable_pending = true;
+	clk->disable_at = jiffies + delay;
+	list_add_tail(&clk->disable_list, &clk_disable_list);
+	spin_unlock_irqrestore(&clk_disable_lock, flags);
+
+	schedule_delayed_work(&clk_disable_work, delay);
+
+	return true;
+}
+
+/* Returns true if the clock was still on, with its lock held */
+static bool __clk_cancel_disable(struct clk *clk)
+{
+	unsigned long flags;
+
+	if (!clk->disable_pending)
+		return false;
+
+	spin_lock_irqsave(&clk_disable_lock, flags);
+	list_del(&clk->disable_list);
+	clk->disable_pending = false;
+	clk_disables_avoided++;
+	spin_unlock_irqrestore(&clk_disable_lock, flags);
+
+	return true;
+}
+
+/* Turns the clock off now if it is in its grace period, with its lock held */
+static void __clk_flush_disable(struct clk *clk)
+{
+	unsigned long flags;
+
+	if (!clk->disable_pending)
+		return;
+
+	spin_lock_irqsave(&clk_disable_lock, flags);
+	list_del(&clk->disable_list);
+	clk->disable_pending = false;
+	spin_unlock_irqrestore(&clk_disable_lock, flags);
+
+	__clk_hw_disable(clk);
+}
+
+/* Turns off the clocks whose grace period is over, or all of them */
+static void clk_flush_disables(bool all)
+{
+	struct clk *clk;
+	unsigned long flags;
+	unsigned long clk_flags = 0;
+
+	for (;;) {
+		spin_lock_irqsave(&clk_disable_lock, flags);
+		if (list_empty(&clk_disable_list)) {
+			spin_unlock_irqrestore(&clk_disable_lock, flags);
+			return;
+		}
+		clk = list_first_entry(&clk_disable_list, struct clk,
+				       disable_list);
+		if (!all && time_before(jiffies, clk->disable_at)) {
+			schedule_delayed_work(&clk_disable_work,
+					      clk->disable_at - jiffies);
+			spin_unlock_irqrestore(&clk_disable_lock, flags);
+			return;
+		}
+		spin_unlock_irqrestore(&clk_disable_lock, flags);
+
+		/* The clock's own lock comes first, it may be a mutex */
+		__clk_lock(clk, NO_LOCK, &clk_flags);
+		__clk_flush_disable(clk);
+		__clk_unlock(clk, NO_LOCK, clk_flags);
+	}
+}
+
+static void clk_disable_work_fn(struct work_struct *work)
+{
+	clk_flush_disables(false);
+}
+
+/* Nothing may be left on behind the back of the suspend code */
+static int clk_disable_pm_notify(struct notifier_block *nb,
+				 unsigned long event, void *data)
+{
+	switch (event) {
+	case PM_SUSPEND_PREPARE:
+	case PM_HIBERNATION_PREPARE:
+		clk_disable_lazy = false;
+		cancel_delayed_work_sync(&clk_disable_work);
+		clk_flush_disables(true);
+		break;
+	case PM_POST_SUSPEND:
+	case PM_POST_HIBERNATION:
+		clk_disable_lazy = true;
+		break;
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block clk_disable_pm_nb = {
+	.notifier_call = clk_disable_pm_notify,
+};
+
+static int __init clk_disable_lazy_init(void)
+{
+	register_pm_notifier(&clk_disable_pm_nb);
+	clk_disable_lazy = true;
+
+	return 0;
+}
+core_initcall(clk_disable_lazy_init);
+
 void __clk_disable(struct clk *clk, void *current_lock)
 {
 	unsigned long flags = 0;
@@ -170,10 +320,8 @@ void __clk_disable(struct clk *clk, void *current_lock)
 	__clk_lock(clk, current_lock, &flags);
 
 	if (clk->enabled && (--clk->enabled == 0)) {
-		if ((clk->ops != NULL) && (clk->ops->disable != NULL))
-			clk->ops->disable(clk);
-		__clk_disable(clk->parent, clk->mutex);
-		__clk_disable(clk->bus_parent, clk->mutex);
+		if (!__clk_defer_disable(clk))
+			__clk_hw_disable(clk);
 	}
 
 	__clk_unlock(clk, current_lock, flags);
@@ -191,7 +339,7 @@ int __clk_enable(struct clk *clk, void *current_lock)
 
 	__clk_lock(clk, current_lock, &flags);
 
-	if (!clk->enabled) {
+	if (!clk->enabled && !__clk_cancel_disable(clk)) {
 		err = __clk_enable(clk->bus_parent, clk->mutex);
 		if (unlikely(err))
 			goto bus_parent_error;
@@ -365,6 +513,7 @@ int clk_set_rate(struct clk *clk, unsigned long rate)
 
 	__clk_lock(clk, NO_LOCK, &flags);
 
+	__clk_flush_disable(clk);
 	if (clk->enabled) {
 		err = -EBUSY;
 		goto unlock_and_return;
@@ -395,6 +544,7 @@ int clk_set_rate_rec(struct clk *clk, unsigned long rate)
 
 	__clk_lock(clk->parent, clk->mutex, &flags);
 
+	__clk_flush_disable(clk->parent);
 	if (clk->parent->enabled) {
 		err = -EBUSY;
 		goto unlock_and_return;
@@ -426,6 +576,8 @@ int clk_set_parent(struct clk *clk, struct clk *parent)
 
 	__clk_lock(clk, NO_LOCK, &flags);
 
+	/* The pending disable would drop a reference to the new parent */
+	__clk_flush_disable(clk);
 	if ((clk->ops != NULL) && (clk->ops->set_parent != NULL)) {
 		err = clk->ops->set_parent(clk, parent);
 		if (err)
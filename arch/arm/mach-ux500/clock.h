@@ -34,6 +34,11 @@
  *		if clk_set_parent() is implemented for the clock.
  * @regulator:	The regulator needed to have the clock functional, if any.
  * @clock:	The clock needed to control the clock, if any.
+ * @lazy_disable: A flag saying whether turning the clock off may be held
+ *		back for a short while after its last disable request.
+ * @disable_pending: A flag saying whether the clock is unused but still on.
+ * @disable_at:	The time, in jiffies, the clock is to be turned off at.
+ * @disable_list: The entry of the clock in the list of clocks to turn off.
  */
 struct clk {
 	const struct clkops *ops;
@@ -51,6 +56,10 @@ struct clk {
 	struct regulator *regulator;
 	struct clk *clock;
 	struct list_head list;
+	bool lazy_disable;
+	bool disable_pending;
+	unsigned long disable_at;
+	struct list_head disable_list;
 };
 
 /**
@@ -91,6 +100,7 @@ extern struct clkops sga_clk_ops;
 		.ops = &prcmu_clk_ops, \
 		.cg_sel = _cg_sel, \
 		.rate = _rate, \
+		.lazy_disable = true, \
 	}
 
 #define DEF_PRCMU_SCALABLE_CLK(_name, _cg_sel) \
@@ -98,6 +108,7 @@ extern struct clkops sga_clk_ops;
 		.name = #_name, \
 		.ops = &prcmu_scalable_clk_ops, \
 		.cg_sel = _cg_sel, \
+		.lazy_disable = true, \
 	}
 
 /* Use this for clocks that are only defined at OPP 100%. */
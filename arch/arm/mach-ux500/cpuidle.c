@@ -12,85 +12,196 @@
 #include <linux/module.h>
 #include <linux/cpuidle.h>
 #include <linux/clockchips.h>
-#include <linux/spinlock.h>
-#include <linux/atomic.h>
+#include <linux/delay.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/smp.h>
+#include <linux/io.h>
+#include <linux/irq.h>
 #include <linux/mfd/dbx500-prcmu.h>
 
 #include <asm/cpuidle.h>
 #include <asm/proc-fns.h>
+#include <asm/hardware/gic.h>
+
+#include <mach/hardware.h>
+#include <mach/cpuidle.h>
 
-static atomic_t master = ATOMIC_INIT(0);
-static DEFINE_SPINLOCK(master_lock);
 static DEFINE_PER_CPU(struct cpuidle_device, ux500_cpuidle_device);
+static void __iomem *gic_cpu_base;
+
+DEFINE_PER_CPU(struct ux500_idle_info, ux500_idle_info);
 
-static inline int ux500_enter_idle(struct cpuidle_device *dev,
-				   struct cpuidle_driver *drv, int index)
+/*
+ * Called right after the WFI with interrupts still masked, so the
+ * highest pending interrupt is the one that woke us up.
+ */
+static inline void ux500_idle_woken(struct ux500_idle_info *info)
 {
-	int this_cpu = smp_processor_id();
-	bool recouple = false;
+	info->wake_time = ktime_get();
+	info->wake_irq = readl_relaxed(gic_cpu_base + GIC_CPU_HIGHPRI) & 0x3ff;
+}
 
-	clockevents_notify(CLOCK_EVT_NOTIFY_BROADCAST_ENTER, &this_cpu);
+static inline void ux500_idle_account(struct ux500_idle_info *info,
+				      int index, ktime_t enter, ktime_t wfi)
+{
+	s64 cost;
 
-	if (atomic_inc_return(&master) == num_online_cpus()) {
+	cost = ktime_to_us(ktime_sub(ktime_get(), enter)) -
+		ktime_to_us(ktime_sub(info->wake_time, wfi));
+	if (cost < 0)
+		cost = 0;
 
-		/* With this lock, we prevent the other cpu to exit and enter
-		 * this function again and become the master */
-		if (!spin_trylock(&master_lock))
-			goto wfi;
+	info->overhead_us[index] = (info->overhead_us[index] * 7 + cost) >> 3;
+}
 
-		/* decouple the gic from the A9 cores */
-		if (prcmu_gic_decouple())
-			goto out;
+/* Outcomes of a coupled ApIdle attempt, as counted in coupled_stats */
+enum {
+	UX500_COUPLED_ENTERED,
+	UX500_COUPLED_ABORT_DECOUPLE,
+	UX500_COUPLED_ABORT_NOT_WFI,
+	UX500_COUPLED_ABORT_GIC_COPY,
+	UX500_COUPLED_ABORT_GIC_PENDING,
+	UX500_COUPLED_ABORT_PRCMU_PENDING,
+	UX500_COUPLED_ABORT_POWER_STATE,
+	UX500_COUPLED_NR_OUTCOMES,
+};
 
-		/* If an error occur, we will have to recouple the gic
-		 * manually */
-		recouple = true;
+static const char * const ux500_coupled_outcome_names[] = {
+	"entered", "gic_decouple", "cpu_not_wfi", "gic_copy",
+	"gic_pending", "prcmu_pending", "power_state",
+};
 
-		/* At this state, as the gic is decoupled, if the other
-		 * cpu is in WFI, we have the guarantee it won't be wake
-		 * up, so we can safely go to retention */
-		if (!prcmu_is_cpu_in_wfi(this_cpu ? 0 : 1))
-			goto out;
+/* Only updated by cpu0, which runs the retention sequence */
+static unsigned int coupled_stats[UX500_COUPLED_NR_OUTCOMES];
 
-		/* The prcmu will be in charge of watching the interrupts
-		 * and wake up the cpus */
-		if (prcmu_copy_gic_settings())
-			goto out;
+/* How long cpu0 waits for the other cpu to reach WFI, in us */
+#define UX500_COUPLED_WFI_WAIT_US	20
 
-		/* Check in the meantime an interrupt did
-		 * not occur on the gic ... */
-		if (prcmu_gic_pending_irq())
-			goto out;
+static int ux500_coupled_prepare(void)
+{
+	int outcome;
+	int i;
 
-		/* ... and the prcmu */
-		if (prcmu_pending_irq())
-			goto out;
+	/* decouple the gic from the A9 cores */
+	if (prcmu_gic_decouple())
+		return UX500_COUPLED_ABORT_DECOUPLE;
 
-		/* Go to the retention state, the prcmu will wait for the
-		 * cpu to go WFI and this is what happens after exiting this
-		 * 'master' critical section */
-		if (prcmu_set_power_state(PRCMU_AP_IDLE, true, true))
-			goto out;
+	/* At this state, as the gic is decoupled, if the other
+	 * cpu is in WFI, we have the guarantee it won't be wake
+	 * up, so we can safely go to retention. It is in the coupled
+	 * state as well, so it is worth waiting for it a little. */
+	for (i = 0; !prcmu_is_cpu_in_wfi(1); i++) {
+		if (i == UX500_COUPLED_WFI_WAIT_US) {
+			outcome = UX500_COUPLED_ABORT_NOT_WFI;
+			goto recouple;
+		}
+		udelay(1);
+	}
 
-		/* When we switch to retention, the prcmu is in charge
-		 * of recoupling the gic automatically */
-		recouple = false;
+	/* The prcmu will be in charge of watching the interrupts
+	 * and wake up the cpus */
+	if (prcmu_copy_gic_settings()) {
+		outcome = UX500_COUPLED_ABORT_GIC_COPY;
+		goto recouple;
+	}
 
-		spin_unlock(&master_lock);
+	/* Check in the meantime an interrupt did
+	 * not occur on the gic ... */
+	if (prcmu_gic_pending_irq()) {
+		outcome = UX500_COUPLED_ABORT_GIC_PENDING;
+		goto recouple;
 	}
-wfi:
-	cpu_do_idle();
-out:
-	atomic_dec(&master);
 
-	if (recouple) {
-		prcmu_gic_recouple();
-		spin_unlock(&master_lock);
+	/* ... and the prcmu */
+	if (prcmu_pending_irq()) {
+		outcome = UX500_COUPLED_ABORT_PRCMU_PENDING;
+		goto recouple;
+	}
+
+	/* Go to the retention state, the prcmu will wait for the
+	 * cpus to go WFI */
+	if (prcmu_set_power_state(PRCMU_AP_IDLE, true, true)) {
+		outcome = UX500_COUPLED_ABORT_POWER_STATE;
+		goto recouple;
+	}
+
+	/* When we switch to retention, the prcmu is in charge
+	 * of recoupling the gic automatically */
+	return UX500_COUPLED_ENTERED;
+
+recouple:
+	prcmu_gic_recouple();
+	return outcome;
+}
+
+/*
+ * The coupled code only lets the cpus out of the state together, so the
+ * first one to wake up brings the others out of WFI.
+ */
+static void ux500_coupled_wake_others(struct cpuidle_device *dev)
+{
+#ifdef CONFIG_ARCH_NEEDS_CPU_IDLE_COUPLED
+	int cpu;
+
+	for_each_cpu(cpu, &dev->coupled_cpus)
+		if (cpu != dev->cpu && cpu_online(cpu))
+			smp_send_reschedule(cpu);
+#endif
+}
+
+/*
+ * Called on all online cpus at about the same time by the coupled
+ * cpuidle code. cpu0 cannot be unplugged, so it runs the retention
+ * sequence while the other cpu waits in WFI.
+ */
+static int ux500_enter_coupled(struct cpuidle_device *dev,
+			       struct cpuidle_driver *drv, int index)
+{
+	struct ux500_idle_info *info = &__get_cpu_var(ux500_idle_info);
+	int this_cpu = smp_processor_id();
+	int outcome = UX500_COUPLED_ENTERED;
+	ktime_t enter, wfi;
+
+	enter = wfi = ktime_get();
+	info->wake_irq = UX500_IDLE_NO_IRQ;
+
+	clockevents_notify(CLOCK_EVT_NOTIFY_BROADCAST_ENTER, &this_cpu);
+
+	if (this_cpu == 0) {
+		outcome = ux500_coupled_prepare();
+		coupled_stats[outcome]++;
 	}
 
+	/* Aborts happen with an interrupt pending, do not wait for it */
+	if (outcome == UX500_COUPLED_ENTERED) {
+		wfi = ktime_get();
+		cpu_do_idle();
+		ux500_idle_woken(info);
+	}
+
+	ux500_coupled_wake_others(dev);
+
 	clockevents_notify(CLOCK_EVT_NOTIFY_BROADCAST_EXIT, &this_cpu);
 
+	/* Aborted attempts do not tell the cost of the state */
+	if (outcome == UX500_COUPLED_ENTERED) {
+		ux500_idle_account(info, index, enter, wfi);
+		if (info->wake_irq < UX500_IDLE_NO_IRQ)
+			irq_time_stats_wakeup(info->wake_irq);
+	}
+
+	return index;
+}
+
+static int ux500_enter_wfi(struct cpuidle_device *dev,
+			   struct cpuidle_driver *drv, int index)
+{
+	struct ux500_idle_info *info = &__get_cpu_var(ux500_idle_info);
+
+	cpu_do_idle();
+	ux500_idle_woken(info);
+
 	return index;
 }
 
@@ -99,12 +210,21 @@ static struct cpuidle_driver ux500_idle_driver = {
 	.owner = THIS_MODULE,
 	.en_core_tk_irqen = 1,
 	.states = {
-		ARM_CPUIDLE_WFI_STATE,
 		{
-			.enter		  = ux500_enter_idle,
+			.enter		  = ux500_enter_wfi,
+			.exit_latency	  = 1,
+			.target_residency = 1,
+			.power_usage	  = UINT_MAX,
+			.flags		  = CPUIDLE_FLAG_TIME_VALID,
+			.name		  = "WFI",
+			.desc		  = "ARM WFI",
+		},
+		{
+			.enter		  = ux500_enter_coupled,
 			.exit_latency	  = 70,
 			.target_residency = 260,
-			.flags		  = CPUIDLE_FLAG_TIME_VALID,
+			.flags		  = CPUIDLE_FLAG_TIME_VALID |
+					    CPUIDLE_FLAG_COUPLED,
 			.name		  = "ApIdle",
 			.desc		  = "ARM Retention",
 		},
@@ -128,6 +248,11 @@ int __init ux500_idle_init(void)
 	int ret, cpu;
 	struct cpuidle_device *device;
 
+	if (cpu_is_u5500())
+		gic_cpu_base = __io_address(U5500_GIC_CPU_BASE);
+	else
+		gic_cpu_base = __io_address(U8500_GIC_CPU_BASE);
+
         /* Configure wake up reasons */
 	prcmu_enable_wakeups(PRCMU_WAKEUP(ARM) | PRCMU_WAKEUP(RTC) |
 			     PRCMU_WAKEUP(ABB));
@@ -148,6 +273,10 @@ int __init ux500_idle_init(void)
 	for_each_online_cpu(cpu) {
 		device = &per_cpu(ux500_cpuidle_device, cpu);
 		device->cpu = cpu;
+#ifdef CONFIG_ARCH_NEEDS_CPU_IDLE_COUPLED
+		device->safe_state_index = 0;
+		cpumask_copy(&device->coupled_cpus, cpu_possible_mask);
+#endif
 		ret = cpuidle_register_device(device);
 		if (ret) {
 			printk(KERN_ERR "Failed to register cpuidle "
@@ -169,3 +298,36 @@ out_unregister:
 }
 
 device_initcall(ux500_idle_init);
+
+#ifdef CONFIG_DEBUG_FS
+static int ux500_coupled_stats_show(struct seq_file *s, void *data)
+{
+	int i;
+
+	for (i = 0; i < UX500_COUPLED_NR_OUTCOMES; i++)
+		seq_printf(s, "%-14s %u\n", ux500_coupled_outcome_names[i],
+			   ACCESS_ONCE(coupled_stats[i]));
+
+	return 0;
+}
+
+static int ux500_coupled_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ux500_coupled_stats_show, inode->i_private);
+}
+
+static const struct file_operations ux500_coupled_stats_fops = {
+	.open		= ux500_coupled_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init ux500_idle_debugfs_init(void)
+{
+	debugfs_create_file("ux500_coupled_idle", S_IRUGO, NULL, NULL,
+			    &ux500_coupled_stats_fops);
+	return 0;
+}
+late_initcall(ux500_idle_debugfs_init);
+#endif
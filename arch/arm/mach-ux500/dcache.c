@@ -212,6 +212,11 @@ u32 get_dcache_granularity(void)
 	return 32;
 }
 
+u32 get_dcache_clean_all_length(void)
+{
+	return inner_clean_breakpoint;
+}
+
 /*
  * Local functions
  */
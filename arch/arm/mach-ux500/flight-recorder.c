@@ -0,0 +1,389 @@
+/*
+ * Copyright (C) ST-Ericsson SA 2012
+ *
+ * Flight recorder of scheduler, interrupt, power and block events in a
+ * memory region that survives a reboot.
+ *
+ * License terms: GNU General Public License (GPL) version 2
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/io.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/vmalloc.h>
+#include <trace/events/block.h>
+#include <trace/events/irq.h>
+#include <trace/events/power.h>
+#include <trace/events/sched.h>
+
+#include <mach/flight-recorder.h>
+
+/*
+ * The region is given by "flight_rec=<size>@<address>" and must, like the
+ * ram_console region, be outside of the memory given to the kernel. It is
+ * split in one ring per possible cpu. A cpu only writes its own ring with
+ * interrupts off, so no lock is taken and an event costs a few uncached
+ * stores. At boot the rings left by the previous run are merged in time
+ * order and can be read in ftrace text format from /proc/last_flightrec.
+ */
+
+#define FLIGHT_REC_SIG (0x43524c46) /* FLRC */
+
+enum flight_rec_type {
+	FLIGHT_REC_SCHED_SWITCH = 1,
+	FLIGHT_REC_IRQ_ENTRY,
+	FLIGHT_REC_IRQ_EXIT,
+	FLIGHT_REC_CPU_FREQUENCY,
+	FLIGHT_REC_CPU_IDLE,
+	FLIGHT_REC_PRCMU_QOS,
+	FLIGHT_REC_BLOCK_ISSUE,
+	FLIGHT_REC_BLOCK_COMPLETE,
+};
+
+struct flight_rec_entry {
+	u64 time;
+	u32 arg;
+	u16 pid;
+	u8 type;
+	u8 flags;
+};
+
+struct flight_rec_ring {
+	u32 sig;
+	u32 size;
+	u32 head;
+	u32 reserved;
+	struct flight_rec_entry entries[0];
+};
+
+struct flight_rec_last {
+	struct flight_rec_entry entry;
+	unsigned int cpu;
+};
+
+static phys_addr_t flight_rec_paddr;
+static size_t flight_rec_size;
+
+/* Number of entries of a ring, a power of two */
+static u32 flight_rec_ring_size;
+static struct flight_rec_ring *flight_rec_rings[NR_CPUS];
+static DEFINE_PER_CPU(u32, flight_rec_head);
+
+static struct flight_rec_last *flight_rec_last;
+static size_t flight_rec_last_count;
+
+static void flight_rec_log(u8 type, u8 flags, u32 arg)
+{
+	struct flight_rec_ring *ring;
+	struct flight_rec_entry *e;
+	unsigned long irqflags;
+	u32 head;
+
+	local_irq_save(irqflags);
+	ring = flight_rec_rings[smp_processor_id()];
+	head = __this_cpu_read(flight_rec_head);
+	e = &ring->entries[head & (flight_rec_ring_size - 1)];
+	e->time = sched_clock();
+	e->arg = arg;
+	e->pid = current->pid;
+	e->type = type;
+	e->flags = flags;
+	__this_cpu_write(flight_rec_head, ++head);
+	ring->head = head;
+	local_irq_restore(irqflags);
+}
+
+static void flight_rec_sched_switch(void *ignore, struct task_struct *prev,
+				    struct task_struct *next)
+{
+	flight_rec_log(FLIGHT_REC_SCHED_SWITCH, prev->state, next->pid);
+}
+
+static void flight_rec_irq_entry(void *ignore, int irq,
+				 struct irqaction *action)
+{
+	flight_rec_log(FLIGHT_REC_IRQ_ENTRY, 0, irq);
+}
+
+static void flight_rec_irq_exit(void *ignore, int irq,
+				struct irqaction *action, int ret)
+{
+	flight_rec_log(FLIGHT_REC_IRQ_EXIT, ret, irq);
+}
+
+static void flight_rec_cpu_frequency(void *ignore, unsigned int frequency,
+				     unsigned int cpu_id)
+{
+	flight_rec_log(FLIGHT_REC_CPU_FREQUENCY, cpu_id, frequency);
+}
+
+static void flight_rec_cpu_idle(void *ignore, unsigned int state,
+				unsigned int cpu_id)
+{
+	flight_rec_log(FLIGHT_REC_CPU_IDLE, cpu_id, state);
+}
+
+static void flight_rec_block_issue(void *ignore, struct request_queue *q,
+				   struct request *rq)
+{
+	flight_rec_log(FLIGHT_REC_BLOCK_ISSUE, rq_data_dir(rq),
+		       blk_rq_pos(rq));
+}
+
+static void flight_rec_block_complete(void *ignore, struct request_queue *q,
+				      struct request *rq,
+				      unsigned int nr_bytes)
+{
+	flight_rec_log(FLIGHT_REC_BLOCK_COMPLETE, rq_data_dir(rq),
+		       blk_rq_pos(rq));
+}
+
+void ux500_flight_rec_qos(int prcmu_qos_class, s32 value)
+{
+	if (flight_rec_ring_size)
+		flight_rec_log(FLIGHT_REC_PRCMU_QOS, prcmu_qos_class, value);
+}
+
+static void *flight_rec_seq_start(struct seq_file *s, loff_t *pos)
+{
+	if (*pos == 0)
+		return SEQ_START_TOKEN;
+	if (*pos > flight_rec_last_count)
+		return NULL;
+	return &flight_rec_last[*pos - 1];
+}
+
+static void *flight_rec_seq_next(struct seq_file *s, void *v, loff_t *pos)
+{
+	++*pos;
+	return flight_rec_seq_start(s, pos);
+}
+
+static void flight_rec_seq_stop(struct seq_file *s, void *v)
+{
+}
+
+static char flight_rec_state(u8 state)
+{
+	if (state == TASK_RUNNING)
+		return 'R';
+	if (state & TASK_INTERRUPTIBLE)
+		return 'S';
+	if (state & TASK_UNINTERRUPTIBLE)
+		return 'D';
+	return 'T';
+}
+
+static int flight_rec_seq_show(struct seq_file *s, void *v)
+{
+	struct flight_rec_last *last = v;
+	struct flight_rec_entry *e = &last->entry;
+	unsigned long nsec;
+	u64 sec;
+
+	if (v == SEQ_START_TOKEN) {
+		seq_puts(s, "# tracer: nop\n#\n"
+			 "#           TASK-PID    CPU#    TIMESTAMP  FUNCTION\n"
+			 "#              | |       |          |         |\n");
+		return 0;
+	}
+
+	sec = e->time;
+	nsec = do_div(sec, NSEC_PER_SEC);
+	seq_printf(s, "%16s-%-5u [%03u] %5llu.%06lu: ",
+		   e->pid ? "<...>" : "<idle>", e->pid, last->cpu, sec,
+		   nsec / NSEC_PER_USEC);
+
+	switch (e->type) {
+	case FLIGHT_REC_SCHED_SWITCH:
+		seq_printf(s, "sched_switch: prev_pid=%u prev_state=%c ==> "
+			   "next_pid=%u\n", e->pid, flight_rec_state(e->flags),
+			   e->arg);
+		break;
+	case FLIGHT_REC_IRQ_ENTRY:
+		seq_printf(s, "irq_handler_entry: irq=%u\n", e->arg);
+		break;
+	case FLIGHT_REC_IRQ_EXIT:
+		seq_printf(s, "irq_handler_exit: irq=%u ret=%s\n", e->arg,
+			   e->flags ? "handled" : "unhandled");
+		break;
+	case FLIGHT_REC_CPU_FREQUENCY:
+		seq_printf(s, "cpu_frequency: state=%u cpu_id=%u\n", e->arg,
+			   e->flags);
+		break;
+	case FLIGHT_REC_CPU_IDLE:
+		seq_printf(s, "cpu_idle: state=%u cpu_id=%u\n", e->arg,
+			   e->flags);
+		break;
+	case FLIGHT_REC_PRCMU_QOS:
+		seq_printf(s, "prcmu_qos: class=%u value=%d\n", e->flags,
+			   (s32)e->arg);
+		break;
+	case FLIGHT_REC_BLOCK_ISSUE:
+		seq_printf(s, "block_rq_issue: %c %u\n",
+			   e->flags ? 'W' : 'R', e->arg);
+		break;
+	case FLIGHT_REC_BLOCK_COMPLETE:
+		seq_printf(s, "block_rq_complete: %c %u\n",
+			   e->flags ? 'W' : 'R', e->arg);
+		break;
+	default:
+		seq_printf(s, "unknown: type=%u\n", e->type);
+		break;
+	}
+
+	return 0;
+}
+
+static const struct seq_operations flight_rec_seq_ops = {
+	.start = flight_rec_seq_start,
+	.next = flight_rec_seq_next,
+	.stop = flight_rec_seq_stop,
+	.show = flight_rec_seq_show,
+};
+
+static int flight_rec_open(struct inode *inode, struct file *file)
+{
+	return seq_open(file, &flight_rec_seq_ops);
+}
+
+static const struct file_operations flight_rec_fops = {
+	.open = flight_rec_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = seq_release,
+};
+
+/* Merges the valid rings of the previous run in time order */
+static void __init flight_rec_save_last(void)
+{
+	u32 next[NR_CPUS];
+	u32 end[NR_CPUS];
+	u32 mask = flight_rec_ring_size - 1;
+	struct flight_rec_ring *ring;
+	size_t total = 0;
+	size_t n;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ring = flight_rec_rings[cpu];
+		end[cpu] = next[cpu] = 0;
+		if (ring->sig != FLIGHT_REC_SIG ||
+		    ring->size != flight_rec_ring_size)
+			continue;
+		end[cpu] = ring->head;
+		next[cpu] = ring->head - min(ring->head, ring->size);
+		total += end[cpu] - next[cpu];
+	}
+
+	if (!total)
+		return;
+
+	flight_rec_last = vmalloc(total * sizeof(*flight_rec_last));
+	if (!flight_rec_last) {
+		pr_err("flight recorder: failed to allocate buffer\n");
+		return;
+	}
+
+	for (n = 0; n < total; n++) {
+		struct flight_rec_entry *e = NULL;
+		int first = 0;
+
+		for_each_possible_cpu(cpu) {
+			struct flight_rec_entry *c;
+
+			if (next[cpu] == end[cpu])
+				continue;
+			c = &flight_rec_rings[cpu]->entries[next[cpu] & mask];
+			if (!e || c->time < e->time) {
+				e = c;
+				first = cpu;
+			}
+		}
+		flight_rec_last[n].entry = *e;
+		flight_rec_last[n].cpu = first;
+		next[first]++;
+	}
+	flight_rec_last_count = total;
+}
+
+static int __init flight_rec_init(void)
+{
+	size_t ring_bytes;
+	void *base;
+	u32 entries;
+	int ret;
+	int cpu;
+	int i = 0;
+
+	if (!flight_rec_size)
+		return 0;
+
+	if (flight_rec_size < num_possible_cpus() * PAGE_SIZE) {
+		pr_err("flight recorder: region of %zu bytes is too small\n",
+		       flight_rec_size);
+		return -EINVAL;
+	}
+	entries = (flight_rec_size / num_possible_cpus() -
+		   sizeof(struct flight_rec_ring)) /
+		sizeof(struct flight_rec_entry);
+
+	base = ioremap_wc(flight_rec_paddr, flight_rec_size);
+	if (!base) {
+		pr_err("flight recorder: failed to map region\n");
+		return -ENOMEM;
+	}
+
+	flight_rec_ring_size = rounddown_pow_of_two(entries);
+	ring_bytes = sizeof(struct flight_rec_ring) +
+		flight_rec_ring_size * sizeof(struct flight_rec_entry);
+	for_each_possible_cpu(cpu)
+		flight_rec_rings[cpu] = base + i++ * ring_bytes;
+
+	flight_rec_save_last();
+
+	for_each_possible_cpu(cpu) {
+		flight_rec_rings[cpu]->head = 0;
+		flight_rec_rings[cpu]->size = flight_rec_ring_size;
+		flight_rec_rings[cpu]->sig = FLIGHT_REC_SIG;
+	}
+
+	ret = register_trace_sched_switch(flight_rec_sched_switch, NULL);
+	ret |= register_trace_irq_handler_entry(flight_rec_irq_entry, NULL);
+	ret |= register_trace_irq_handler_exit(flight_rec_irq_exit, NULL);
+	ret |= register_trace_cpu_frequency(flight_rec_cpu_frequency, NULL);
+	ret |= register_trace_cpu_idle(flight_rec_cpu_idle, NULL);
+	ret |= register_trace_block_rq_issue(flight_rec_block_issue, NULL);
+	ret |= register_trace_block_rq_complete(flight_rec_block_complete,
+						NULL);
+	if (ret)
+		pr_warn("flight recorder: failed to register all probes\n");
+
+	if (flight_rec_last_count &&
+	    !proc_create("last_flightrec", S_IRUSR, NULL, &flight_rec_fops))
+		pr_err("flight recorder: failed to create proc entry\n");
+
+	pr_info("flight recorder: %u events per cpu, %zu saved\n",
+		flight_rec_ring_size, flight_rec_last_count);
+
+	return 0;
+}
+arch_initcall(flight_rec_init);
+
+static int __init flight_rec_setup(char *p)
+{
+	flight_rec_size = memparse(p, &p);
+	if (*p != '@') {
+		flight_rec_size = 0;
+		return 0;
+	}
+	flight_rec_paddr = memparse(p + 1, &p);
+
+	return 0;
+}
+early_param("flight_rec", flight_rec_setup);
@@ -13,10 +13,18 @@
 #include <linux/mm.h>
 #include <linux/err.h>
 #include <linux/slab.h>
+#include <linux/memblock.h>
+#include <linux/platform_device.h>
+#include <linux/dma-contiguous.h>
+#include <mach/devices.h>
+#include <mach/setup.h>
 
 /* CONA API */
 void *cona_create(const char *name, phys_addr_t region_paddr,
 							size_t region_size);
+#ifdef CONFIG_HWMEM_CMA
+void *cona_create_cma(const char *name, struct device *dev);
+#endif
 void *cona_alloc(void *instance, size_t size);
 void cona_free(void *instance, void *alloc);
 phys_addr_t cona_get_alloc_paddr(void *alloc);
@@ -42,6 +50,10 @@ static size_t hwmem_prot_size;
 static phys_addr_t hwmem_static_paddr;
 static size_t hwmem_static_size;
 
+#ifdef CONFIG_HWMEM_CMA
+static bool hwmem_cma;
+#endif
+
 static int __init parse_hwmem_prot_param(char *p)
 {
 
@@ -96,6 +108,49 @@ no_at:
 }
 early_param("hwmem_static", parse_hwmem_static_param);
 
+#ifdef CONFIG_HWMEM_CMA
+/*
+ * Turn the "hwmem" region into a CMA area owned by the hwmem device so that
+ * the page allocator can use it for movable allocations while it does not
+ * hold any buffers. This only works if the region is part of the memory
+ * given to the kernel, ie covered by a "mem" parameter. If it is not it is
+ * left alone and used as a carveout like before.
+ */
+void __init ux500_hwmem_reserve(void)
+{
+	phys_addr_t align = (phys_addr_t)PAGE_SIZE <<
+				max(MAX_ORDER - 1, pageblock_order);
+	phys_addr_t size = ALIGN(hwmem_size, align);
+
+	if (hwmem_size == 0)
+		return;
+
+	if (!IS_ALIGNED(hwmem_paddr, align) ||
+			!memblock_is_region_memory(hwmem_paddr, size)) {
+		pr_info("HWMEM: region not in system memory, using carveout\n");
+		return;
+	}
+
+	if (dma_declare_contiguous(&ux500_hwmem_device.dev, hwmem_size,
+							hwmem_paddr, 0)) {
+		pr_err("HWMEM: Failed to declare CMA area, using carveout\n");
+		return;
+	}
+
+	hwmem_cma = true;
+}
+#endif
+
+static void * __init create_contig_instance(void)
+{
+#ifdef CONFIG_HWMEM_CMA
+	if (hwmem_cma)
+		return cona_create_cma("hwmem_cona", &ux500_hwmem_device.dev);
+#endif
+
+	return cona_create("hwmem_cona", hwmem_paddr, hwmem_size);
+}
+
 static int __init setup_hwmem(void)
 {
 	static const unsigned int NUM_MEM_TYPES = 4;
@@ -136,8 +191,7 @@ static int __init setup_hwmem(void)
 	hwmem_mem_types[1].allocator_api.get_alloc_paddr = cona_get_alloc_paddr;
 	hwmem_mem_types[1].allocator_api.get_alloc_kaddr = cona_get_alloc_kaddr;
 	hwmem_mem_types[1].allocator_api.get_alloc_size = cona_get_alloc_size;
-	hwmem_mem_types[1].allocator_instance = cona_create("hwmem_cona",
-						hwmem_paddr, hwmem_size);
+	hwmem_mem_types[1].allocator_instance = create_contig_instance();
 	if (IS_ERR(hwmem_mem_types[1].allocator_instance)) {
 		ret = PTR_ERR(hwmem_mem_types[1].allocator_instance);
 		goto hwmem_ima_init_failed;
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) ST-Ericsson SA 2012
+ *
+ * License terms: GNU General Public License (GPL) version 2
+ */
+
+#ifndef __MACH_UX500_CPUIDLE_H
+#define __MACH_UX500_CPUIDLE_H
+
+#include <linux/percpu.h>
+#include <linux/ktime.h>
+#include <linux/cpuidle.h>
+
+/* GIC_CPU_HIGHPRI reads 1020 and above when nothing is pending */
+#define UX500_IDLE_NO_IRQ	1020
+
+/* Filled in by the ux500 idle states for the governor */
+struct ux500_idle_info {
+	unsigned int wake_irq;
+	ktime_t wake_time;
+	/* Time spent around the WFI to enter and leave each state, in us */
+	unsigned int overhead_us[CPUIDLE_STATE_MAX];
+};
+
+DECLARE_PER_CPU(struct ux500_idle_info, ux500_idle_info);
+
+#ifdef CONFIG_UX500_CPUIDLE_GOVERNOR
+void ux500_cpuidle_gov_mispredicts(int cpu, int state,
+				   unsigned int *too_deep,
+				   unsigned int *too_shallow);
+#else
+static inline void ux500_cpuidle_gov_mispredicts(int cpu, int state,
+						 unsigned int *too_deep,
+						 unsigned int *too_shallow)
+{
+	*too_deep = 0;
+	*too_shallow = 0;
+}
+#endif
+
+#endif
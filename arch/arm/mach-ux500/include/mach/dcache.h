@@ -22,5 +22,10 @@ void flush_cpu_dcache(void *vaddr, u32 paddr, u32 length, bool inner_only,
 bool speculative_data_prefetch(void);
 /* Returns 1 if no cache is present */
 u32 get_dcache_granularity(void);
+/*
+ * Length from which clean_cpu_dcache() cleans the entire inner cache rather
+ * than the range.
+ */
+u32 get_dcache_clean_all_length(void);
 
 #endif /* _MACH_UX500_DCACHE_H_ */
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) ST-Ericsson SA 2012
+ *
+ * License terms: GNU General Public License (GPL) version 2
+ */
+
+#ifndef __MACH_UX500_ENERGY_DVFS_H
+#define __MACH_UX500_ENERGY_DVFS_H
+
+/*
+ * One ARM/APE/DDR operating point and the power it draws with the ARM
+ * fully busy. Points are listed in any order.
+ */
+struct ux500_energy_point {
+	unsigned int arm_khz;
+	unsigned int ape_opp;
+	unsigned int ddr_opp;
+	unsigned int power_mw;
+};
+
+#ifdef CONFIG_UX500_ENERGY_DVFS
+int ux500_energy_dvfs_set_table(const struct ux500_energy_point *points,
+				unsigned int count);
+#else
+static inline int ux500_energy_dvfs_set_table(
+		const struct ux500_energy_point *points, unsigned int count)
+{
+	return 0;
+}
+#endif
+
+#endif
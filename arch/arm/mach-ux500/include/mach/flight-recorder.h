@@ -0,0 +1,16 @@
+/*
+ * Copyright (C) ST-Ericsson SA 2012
+ *
+ * License terms: GNU General Public License (GPL) version 2
+ */
+
+#ifndef __MACH_FLIGHT_RECORDER_H
+#define __MACH_FLIGHT_RECORDER_H
+
+#ifdef CONFIG_UX500_FLIGHT_RECORDER
+void ux500_flight_rec_qos(int prcmu_qos_class, s32 value);
+#else
+static inline void ux500_flight_rec_qos(int prcmu_qos_class, s32 value) {}
+#endif
+
+#endif
@@ -40,6 +40,12 @@ extern struct sys_timer ux500_timer;
 
 void ux500_restart(char mode, const char *cmd);
 
+#ifdef CONFIG_HWMEM_CMA
+extern void __init ux500_hwmem_reserve(void);
+#else
+static inline void ux500_hwmem_reserve(void) { }
+#endif
+
 #define __IO_DEV_DESC(x, sz)	{		\
 	.virtual	= IO_ADDRESS(x),	\
 	.pfn		= __phys_to_pfn(x),	\
@@ -0,0 +1,238 @@
+/*
+ * arch/arm/mach-ux500/pm/cpuidle_gov.c
+ *
+ * Predictive cpuidle governor for ux500.
+ *
+ * The next wakeup is predicted as the earliest of the next timer event
+ * and of the next expected wakeup of the interrupts that recently woke
+ * the CPU at a regular interval (modem, touch, ...). A state is only
+ * entered when the prediction beats its break-even time, which is its
+ * exit latency plus the entry and exit cost measured by the ux500 idle
+ * driver, the GIC decouple handshake included.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/cpuidle.h>
+#include <linux/pm_qos.h>
+#include <linux/tick.h>
+#include <linux/ktime.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <mach/cpuidle.h>
+
+#define UX500_GOV_IRQS			8
+#define UX500_GOV_MIN_SAMPLES		3
+#define UX500_GOV_MAX_INTERVAL_US	(2 * USEC_PER_SEC)
+/* A wakeup this close to the next timer event is the timer's */
+#define UX500_GOV_TIMER_SLACK_US	100
+
+struct ux500_gov_irq {
+	unsigned int irq;
+	unsigned int samples;
+	u32 interval_us;
+	ktime_t last;
+};
+
+struct ux500_gov_cpu {
+	struct ux500_gov_irq irqs[UX500_GOV_IRQS];
+	int last_state;
+	u32 timer_us;
+	u32 predicted_us;
+	bool needs_update;
+	unsigned int too_deep[CPUIDLE_STATE_MAX];
+	unsigned int too_shallow[CPUIDLE_STATE_MAX];
+};
+
+static DEFINE_PER_CPU(struct ux500_gov_cpu, ux500_gov_cpus);
+
+static inline u32 ux500_gov_break_even(struct cpuidle_state *s,
+				       struct ux500_idle_info *info, int i)
+{
+	return max(s->target_residency, s->exit_latency + info->overhead_us[i]);
+}
+
+static void ux500_gov_record(struct ux500_gov_cpu *g, unsigned int irq,
+			     ktime_t when)
+{
+	struct ux500_gov_irq *w, *victim = &g->irqs[0];
+	s64 interval;
+	int i;
+
+	for (i = 0; i < UX500_GOV_IRQS; i++) {
+		w = &g->irqs[i];
+		if (w->samples && w->irq == irq)
+			goto found;
+		if (!victim->samples)
+			continue;
+		if (!w->samples || w->last.tv64 < victim->last.tv64)
+			victim = w;
+	}
+
+	victim->irq = irq;
+	victim->samples = 1;
+	victim->interval_us = 0;
+	victim->last = when;
+	return;
+
+found:
+	interval = ktime_to_us(ktime_sub(when, w->last));
+	w->last = when;
+
+	/* The source went quiet for a while, start over */
+	if (interval > UX500_GOV_MAX_INTERVAL_US) {
+		w->samples = 1;
+		w->interval_us = 0;
+		return;
+	}
+
+	if (w->samples == 1)
+		w->interval_us = interval;
+	else
+		w->interval_us = (w->interval_us * 3 + interval) >> 2;
+
+	if (w->samples < UX500_GOV_MIN_SAMPLES)
+		w->samples++;
+}
+
+/* Time to the next expected interrupt wakeup, overdue ones are ignored */
+static u32 ux500_gov_predict_irq(struct ux500_gov_cpu *g, ktime_t now)
+{
+	u32 best = UINT_MAX;
+	s64 until;
+	int i;
+
+	for (i = 0; i < UX500_GOV_IRQS; i++) {
+		struct ux500_gov_irq *w = &g->irqs[i];
+
+		if (w->samples < UX500_GOV_MIN_SAMPLES)
+			continue;
+
+		until = ktime_to_us(ktime_sub(ktime_add_us(w->last,
+						w->interval_us), now));
+		if (until > 0 && until < best)
+			best = until;
+	}
+
+	return best;
+}
+
+static void ux500_gov_update(struct cpuidle_driver *drv,
+			     struct cpuidle_device *dev,
+			     struct ux500_gov_cpu *g,
+			     struct ux500_idle_info *info)
+{
+	unsigned int residency = cpuidle_get_last_residency(dev);
+	unsigned int irq = info->wake_irq;
+	int idx = g->last_state;
+	int next = idx + 1;
+
+	/* The tick code predicts the timer, IPIs and PPIs are not tracked */
+	if (irq >= 32 && irq < UX500_IDLE_NO_IRQ &&
+	    residency + UX500_GOV_TIMER_SLACK_US < g->timer_us)
+		ux500_gov_record(g, irq, info->wake_time);
+
+	if (idx > 0 &&
+	    residency < ux500_gov_break_even(&drv->states[idx], info, idx))
+		g->too_deep[idx]++;
+	else if (next < drv->state_count && !drv->states[next].disable &&
+		 g->predicted_us <
+			ux500_gov_break_even(&drv->states[next], info, next) &&
+		 residency >=
+			ux500_gov_break_even(&drv->states[next], info, next))
+		g->too_shallow[idx]++;
+}
+
+static int ux500_gov_select(struct cpuidle_driver *drv,
+			    struct cpuidle_device *dev)
+{
+	struct ux500_gov_cpu *g = &__get_cpu_var(ux500_gov_cpus);
+	struct ux500_idle_info *info = &__get_cpu_var(ux500_idle_info);
+	int latency_req = pm_qos_request(PM_QOS_CPU_DMA_LATENCY);
+	s64 timer_us;
+	int i;
+
+	if (g->needs_update) {
+		ux500_gov_update(drv, dev, g, info);
+		g->needs_update = false;
+	}
+
+	g->last_state = 0;
+
+	/* Special case when user has set very strict latency requirement */
+	if (unlikely(latency_req == 0))
+		return 0;
+
+	timer_us = ktime_to_us(tick_nohz_get_sleep_length());
+	g->timer_us = min_t(s64, timer_us, UINT_MAX);
+	g->predicted_us = min(g->timer_us,
+			      ux500_gov_predict_irq(g, ktime_get()));
+
+	/* A parked cpu has nothing to do until it is unparked */
+	if (cpu_parked(dev->cpu))
+		g->predicted_us = UINT_MAX;
+
+	for (i = CPUIDLE_DRIVER_STATE_START; i < drv->state_count; i++) {
+		struct cpuidle_state *s = &drv->states[i];
+
+		if (s->disable)
+			continue;
+		if (s->exit_latency > latency_req)
+			continue;
+		if (ux500_gov_break_even(s, info, i) > g->predicted_us)
+			continue;
+
+		g->last_state = i;
+	}
+
+	return g->last_state;
+}
+
+/* Keep it short, the work is done on the next select */
+static void ux500_gov_reflect(struct cpuidle_device *dev, int index)
+{
+	struct ux500_gov_cpu *g = &__get_cpu_var(ux500_gov_cpus);
+
+	g->last_state = index;
+	if (index >= 0)
+		g->needs_update = true;
+}
+
+static int ux500_gov_enable_device(struct cpuidle_driver *drv,
+				   struct cpuidle_device *dev)
+{
+	struct ux500_gov_cpu *g = &per_cpu(ux500_gov_cpus, dev->cpu);
+
+	memset(g, 0, sizeof(*g));
+
+	return 0;
+}
+
+void ux500_cpuidle_gov_mispredicts(int cpu, int state,
+				   unsigned int *too_deep,
+				   unsigned int *too_shallow)
+{
+	struct ux500_gov_cpu *g = &per_cpu(ux500_gov_cpus, cpu);
+
+	*too_deep = ACCESS_ONCE(g->too_deep[state]);
+	*too_shallow = ACCESS_ONCE(g->too_shallow[state]);
+}
+
+static struct cpuidle_governor ux500_governor = {
+	.name =		"ux500",
+	.rating =	30,
+	.enable =	ux500_gov_enable_device,
+	.select =	ux500_gov_select,
+	.reflect =	ux500_gov_reflect,
+	.owner =	THIS_MODULE,
+};
+
+static int __init ux500_gov_init(void)
+{
+	return cpuidle_register_governor(&ux500_governor);
+}
+core_initcall(ux500_gov_init);
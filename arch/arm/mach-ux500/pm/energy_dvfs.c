@@ -0,0 +1,523 @@
+/*
+ * arch/arm/mach-ux500/pm/energy_dvfs.c
+ *
+ * Energy model driven coordination of the ARM, APE and DDR OPPs.
+ *
+ * Every sample_ms the cycle, instruction, L1 data refill and dispatch
+ * stall counters of the online CPUs are read. The share of stalled
+ * cycles, when the miss rate says they come from memory, splits the busy
+ * time into a part that scales with the ARM clock and a part that scales
+ * with the DDR OPP. For every point of the energy table the busy time is
+ * predicted, and the cheapest point (power times busy time) that keeps
+ * the load under up_util is picked. Its APE and DDR OPPs are requested
+ * through PRCMU QoS, and, for memory bound loads only, its ARM frequency
+ * caps the cpufreq policy so that governors stop ramping the ARM for
+ * nothing.
+ *
+ * Boards may provide measured points with ux500_energy_dvfs_set_table(),
+ * the default table is a DB8500 estimate.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ */
+
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/perf_event.h>
+#include <linux/workqueue.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/mfd/dbx500-prcmu.h>
+#include <mach/energy_dvfs.h>
+
+#define ENERGY_DVFS_QOS_NAME	"energy_dvfs"
+
+static const struct ux500_energy_point db8500_energy_points[] = {
+	{  200000,  50,  50, 110 },
+	{  200000, 100, 100, 200 },
+	{  400000,  50,  50, 170 },
+	{  400000, 100, 100, 260 },
+	{  800000,  50,  50, 380 },
+	{  800000, 100, 100, 470 },
+	{ 1000000,  50,  50, 530 },
+	{ 1000000, 100, 100, 620 },
+};
+
+static const struct ux500_energy_point *energy_points = db8500_energy_points;
+static unsigned int energy_points_count = ARRAY_SIZE(db8500_energy_points);
+
+static unsigned int sample_ms = 50;
+module_param(sample_ms, uint, 0644);
+MODULE_PARM_DESC(sample_ms, "Sampling period of the PMU counters");
+
+static unsigned int up_util = 80;
+module_param(up_util, uint, 0644);
+MODULE_PARM_DESC(up_util, "Highest predicted load in percent an operating point may run at");
+
+static unsigned int mem_bound_pct = 25;
+module_param(mem_bound_pct, uint, 0644);
+MODULE_PARM_DESC(mem_bound_pct, "Share of memory stalls above which the ARM frequency is capped");
+
+static unsigned int min_mpki = 5;
+module_param(min_mpki, uint, 0644);
+MODULE_PARM_DESC(min_mpki, "L1 data refills per 1000 instructions below which stalls are not counted as memory");
+
+enum {
+	ENERGY_EV_CYCLES,
+	ENERGY_EV_INSTR,
+	ENERGY_EV_MISSES,
+	ENERGY_EV_STALLS,
+	ENERGY_NR_EV,
+};
+
+static const u64 energy_ev_config[ENERGY_NR_EV] = {
+	[ENERGY_EV_CYCLES]	= PERF_COUNT_HW_CPU_CYCLES,
+	[ENERGY_EV_INSTR]	= PERF_COUNT_HW_INSTRUCTIONS,
+	[ENERGY_EV_MISSES]	= PERF_COUNT_HW_CACHE_MISSES,
+	[ENERGY_EV_STALLS]	= PERF_COUNT_HW_STALLED_CYCLES_BACKEND,
+};
+
+struct energy_dvfs_cpu {
+	struct perf_event *ev[ENERGY_NR_EV];
+	u64 prev[ENERGY_NR_EV];
+};
+
+static DEFINE_PER_CPU(struct energy_dvfs_cpu, energy_dvfs_cpus);
+
+/* Serializes sampling, counter setup and table changes */
+static DEFINE_MUTEX(energy_dvfs_mutex);
+static bool energy_dvfs_running;
+static ktime_t last_sample;
+
+/* Last decision, for debugfs */
+static unsigned int last_util;
+static unsigned int last_mem;
+static int last_point = -1;
+static unsigned int arm_cap;
+
+static void energy_dvfs_sample(struct work_struct *work);
+static DECLARE_DELAYED_WORK(energy_dvfs_work, energy_dvfs_sample);
+
+static void energy_dvfs_overflow(struct perf_event *event,
+				 struct perf_sample_data *data,
+				 struct pt_regs *regs)
+{
+}
+
+static void energy_dvfs_release_cpu(unsigned int cpu)
+{
+	struct energy_dvfs_cpu *c = &per_cpu(energy_dvfs_cpus, cpu);
+	int i;
+
+	for (i = 0; i < ENERGY_NR_EV; i++) {
+		if (c->ev[i])
+			perf_event_release_kernel(c->ev[i]);
+		c->ev[i] = NULL;
+	}
+}
+
+static int energy_dvfs_setup_cpu(unsigned int cpu)
+{
+	struct energy_dvfs_cpu *c = &per_cpu(energy_dvfs_cpus, cpu);
+	struct perf_event_attr attr = {
+		.type		= PERF_TYPE_HARDWARE,
+		.size		= sizeof(struct perf_event_attr),
+		.pinned		= 1,
+	};
+	u64 enabled, running;
+	int i;
+
+	for (i = 0; i < ENERGY_NR_EV; i++) {
+		attr.config = energy_ev_config[i];
+		c->ev[i] = perf_event_create_kernel_counter(&attr, cpu, NULL,
+						energy_dvfs_overflow, NULL);
+		if (IS_ERR(c->ev[i])) {
+			int ret = PTR_ERR(c->ev[i]);
+
+			c->ev[i] = NULL;
+			energy_dvfs_release_cpu(cpu);
+			return ret;
+		}
+		c->prev[i] = perf_event_read_value(c->ev[i], &enabled,
+						   &running);
+	}
+
+	return 0;
+}
+
+static int energy_dvfs_policy_notifier(struct notifier_block *nb,
+				       unsigned long event, void *data)
+{
+	struct cpufreq_policy *policy = data;
+	unsigned int cap = ACCESS_ONCE(arm_cap);
+
+	if (event != CPUFREQ_ADJUST || !cap)
+		return NOTIFY_DONE;
+
+	cpufreq_verify_within_limits(policy, policy->min,
+				     max(cap, policy->min));
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block energy_dvfs_policy_nb = {
+	.notifier_call = energy_dvfs_policy_notifier,
+};
+
+static void energy_dvfs_set_cap(unsigned int cap)
+{
+	unsigned int cpu;
+
+	if (cap == arm_cap)
+		return;
+
+	arm_cap = cap;
+	for_each_online_cpu(cpu)
+		cpufreq_update_policy(cpu);
+}
+
+/* DDR 25% is not used on DB8500, it runs at 50% then */
+static inline unsigned int energy_dvfs_ddr_opp(void)
+{
+	int opp = prcmu_qos_requirement(PRCMU_QOS_DDR_OPP);
+
+	return opp > 50 ? 100 : 50;
+}
+
+/*
+ * Pick the cheapest point for a busy share of @util and a memory stall
+ * share of @mem (both per mille) measured at @arm_khz and @ddr_opp.
+ */
+static int energy_dvfs_choose(unsigned int util, unsigned int mem,
+			      unsigned int arm_khz, unsigned int ddr_opp,
+			      unsigned int max_khz)
+{
+	u64 cost, best_cost = ULLONG_MAX;
+	unsigned int t, fastest_t = UINT_MAX;
+	int i, best = -1, fastest = -1;
+
+	for (i = 0; i < energy_points_count; i++) {
+		const struct ux500_energy_point *p = &energy_points[i];
+		unsigned int busy;
+
+		if (p->arm_khz > max_khz)
+			continue;
+
+		/* Time to do the same work, per mille of the current one */
+		t = div_u64((u64)(1000 - mem) * arm_khz, p->arm_khz) +
+			mem * ddr_opp / p->ddr_opp;
+		busy = util * t / 1000;
+
+		if (t < fastest_t) {
+			fastest_t = t;
+			fastest = i;
+		}
+
+		if (busy > up_util * 10)
+			continue;
+
+		cost = (u64)p->power_mw * busy;
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = i;
+		}
+	}
+
+	return best >= 0 ? best : fastest;
+}
+
+static void energy_dvfs_apply(int point, unsigned int mem)
+{
+	const struct ux500_energy_point *p;
+
+	if (point < 0)
+		return;
+
+	p = &energy_points[point];
+	if (point != last_point) {
+		prcmu_qos_update_requirement(PRCMU_QOS_APE_OPP,
+					     ENERGY_DVFS_QOS_NAME, p->ape_opp);
+		prcmu_qos_update_requirement(PRCMU_QOS_DDR_OPP,
+					     ENERGY_DVFS_QOS_NAME, p->ddr_opp);
+		last_point = point;
+	}
+
+	/* Compute bound loads are left to the governor */
+	energy_dvfs_set_cap(mem >= mem_bound_pct * 10 ? p->arm_khz : 0);
+}
+
+static void energy_dvfs_sample(struct work_struct *work)
+{
+	u64 total[ENERGY_NR_EV] = { 0 };
+	u64 max_cycles = 0, capacity;
+	unsigned int arm_khz, util, mem = 0;
+	unsigned int cpu;
+	ktime_t now;
+	s64 elapsed_us;
+	int i;
+
+	get_online_cpus();
+	mutex_lock(&energy_dvfs_mutex);
+
+	if (!energy_dvfs_running)
+		goto out;
+
+	for_each_online_cpu(cpu) {
+		struct energy_dvfs_cpu *c = &per_cpu(energy_dvfs_cpus, cpu);
+		u64 enabled, running, val;
+
+		if (!c->ev[0])
+			continue;
+
+		for (i = 0; i < ENERGY_NR_EV; i++) {
+			val = perf_event_read_value(c->ev[i], &enabled,
+						    &running);
+			total[i] += val - c->prev[i];
+			if (i == ENERGY_EV_CYCLES)
+				max_cycles = max(max_cycles, val - c->prev[i]);
+			c->prev[i] = val;
+		}
+	}
+
+	now = ktime_get();
+	elapsed_us = ktime_to_us(ktime_sub(now, last_sample));
+	last_sample = now;
+
+	arm_khz = cpufreq_quick_get(0);
+	if (!arm_khz || elapsed_us <= 0 || !total[ENERGY_EV_CYCLES])
+		goto requeue;
+
+	/* The cycle counter stops in WFI, so this is the busiest core load */
+	capacity = div_u64((u64)arm_khz * elapsed_us, 1000);
+	util = min_t(u64, div64_u64(max_cycles * 1000, capacity), 1000);
+
+	if (total[ENERGY_EV_INSTR] &&
+	    div64_u64(total[ENERGY_EV_MISSES] * 1000,
+		      total[ENERGY_EV_INSTR]) >= min_mpki)
+		mem = min_t(u64, div64_u64(total[ENERGY_EV_STALLS] * 1000,
+					   total[ENERGY_EV_CYCLES]), 1000);
+
+	last_util = util;
+	last_mem = mem;
+	energy_dvfs_apply(energy_dvfs_choose(util, mem, arm_khz,
+					     energy_dvfs_ddr_opp(),
+					     cpufreq_quick_get_max(0)), mem);
+
+requeue:
+	queue_delayed_work(system_freezable_wq, &energy_dvfs_work,
+			   msecs_to_jiffies(sample_ms));
+out:
+	mutex_unlock(&energy_dvfs_mutex);
+	put_online_cpus();
+}
+
+static int energy_dvfs_start(void)
+{
+	unsigned int cpu;
+	int ret = 0;
+
+	get_online_cpus();
+	mutex_lock(&energy_dvfs_mutex);
+
+	if (energy_dvfs_running)
+		goto out;
+
+	for_each_online_cpu(cpu) {
+		ret = energy_dvfs_setup_cpu(cpu);
+		if (ret) {
+			pr_err("energy_dvfs: no PMU counters on cpu%u (%d)\n",
+			       cpu, ret);
+			for_each_online_cpu(cpu)
+				energy_dvfs_release_cpu(cpu);
+			goto out;
+		}
+	}
+
+	energy_dvfs_running = true;
+	last_sample = ktime_get();
+	last_point = -1;
+	queue_delayed_work(system_freezable_wq, &energy_dvfs_work,
+			   msecs_to_jiffies(sample_ms));
+out:
+	mutex_unlock(&energy_dvfs_mutex);
+	put_online_cpus();
+	return ret;
+}
+
+static void energy_dvfs_stop(void)
+{
+	unsigned int cpu;
+
+	mutex_lock(&energy_dvfs_mutex);
+	energy_dvfs_running = false;
+	mutex_unlock(&energy_dvfs_mutex);
+
+	/* The work requeues itself only while running */
+	cancel_delayed_work_sync(&energy_dvfs_work);
+
+	get_online_cpus();
+	mutex_lock(&energy_dvfs_mutex);
+	for_each_online_cpu(cpu)
+		energy_dvfs_release_cpu(cpu);
+
+	prcmu_qos_update_requirement(PRCMU_QOS_APE_OPP, ENERGY_DVFS_QOS_NAME,
+				     PRCMU_QOS_DEFAULT_VALUE);
+	prcmu_qos_update_requirement(PRCMU_QOS_DDR_OPP, ENERGY_DVFS_QOS_NAME,
+				     PRCMU_QOS_DEFAULT_VALUE);
+	last_point = -1;
+	energy_dvfs_set_cap(0);
+	mutex_unlock(&energy_dvfs_mutex);
+	put_online_cpus();
+}
+
+static bool enable = true;
+/* Boot parameters are parsed before the init below */
+static bool energy_dvfs_ready;
+
+static int enable_set(const char *val, const struct kernel_param *kp)
+{
+	bool old = enable;
+	int ret = param_set_bool(val, kp);
+
+	if (ret || old == enable || !energy_dvfs_ready)
+		return ret;
+
+	if (!enable) {
+		energy_dvfs_stop();
+		return 0;
+	}
+
+	ret = energy_dvfs_start();
+	if (ret)
+		enable = false;
+	return ret;
+}
+
+static struct kernel_param_ops enable_ops = {
+	.set = enable_set,
+	.get = param_get_bool,
+};
+
+module_param_cb(enable, &enable_ops, &enable, 0644);
+MODULE_PARM_DESC(enable, "Coordinate the ARM, APE and DDR OPPs");
+
+int ux500_energy_dvfs_set_table(const struct ux500_energy_point *points,
+				unsigned int count)
+{
+	if (!points || !count)
+		return -EINVAL;
+
+	mutex_lock(&energy_dvfs_mutex);
+	energy_points = points;
+	energy_points_count = count;
+	last_point = -1;
+	mutex_unlock(&energy_dvfs_mutex);
+
+	return 0;
+}
+
+static int __cpuinit energy_dvfs_cpu_callback(struct notifier_block *nfb,
+					unsigned long action, void *hcpu)
+{
+	unsigned int cpu = (unsigned long)hcpu;
+
+	mutex_lock(&energy_dvfs_mutex);
+	if (energy_dvfs_running) {
+		switch (action & ~CPU_TASKS_FROZEN) {
+		case CPU_ONLINE:
+			energy_dvfs_setup_cpu(cpu);
+			break;
+		case CPU_DOWN_PREPARE:
+			energy_dvfs_release_cpu(cpu);
+			break;
+		case CPU_DOWN_FAILED:
+			energy_dvfs_setup_cpu(cpu);
+			break;
+		}
+	}
+	mutex_unlock(&energy_dvfs_mutex);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block __refdata energy_dvfs_cpu_notifier = {
+	.notifier_call = energy_dvfs_cpu_callback,
+};
+
+#ifdef CONFIG_DEBUG_FS
+static int energy_dvfs_show(struct seq_file *s, void *data)
+{
+	int i;
+
+	mutex_lock(&energy_dvfs_mutex);
+	seq_printf(s, "util %u.%u%% mem %u.%u%% arm cap %u kHz\n\n",
+		   last_util / 10, last_util % 10, last_mem / 10,
+		   last_mem % 10, arm_cap);
+	seq_printf(s, "  %10s %4s %4s %8s\n", "arm_khz", "ape", "ddr",
+		   "power_mw");
+	for (i = 0; i < energy_points_count; i++)
+		seq_printf(s, "%c %10u %4u %4u %8u\n",
+			   i == last_point ? '*' : ' ',
+			   energy_points[i].arm_khz, energy_points[i].ape_opp,
+			   energy_points[i].ddr_opp, energy_points[i].power_mw);
+	mutex_unlock(&energy_dvfs_mutex);
+
+	return 0;
+}
+
+static int energy_dvfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, energy_dvfs_show, inode->i_private);
+}
+
+static const struct file_operations energy_dvfs_fops = {
+	.open		= energy_dvfs_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif
+
+/* After prcmu_qos_power_init() and the cpufreq driver */
+static int __init energy_dvfs_init(void)
+{
+	int ret;
+
+	prcmu_qos_add_requirement(PRCMU_QOS_APE_OPP, ENERGY_DVFS_QOS_NAME,
+				  PRCMU_QOS_DEFAULT_VALUE);
+	prcmu_qos_add_requirement(PRCMU_QOS_DDR_OPP, ENERGY_DVFS_QOS_NAME,
+				  PRCMU_QOS_DEFAULT_VALUE);
+
+	ret = cpufreq_register_notifier(&energy_dvfs_policy_nb,
+					CPUFREQ_POLICY_NOTIFIER);
+	if (ret)
+		goto err_notifier;
+
+	register_hotcpu_notifier(&energy_dvfs_cpu_notifier);
+
+#ifdef CONFIG_DEBUG_FS
+	debugfs_create_file("energy_dvfs", S_IRUGO, NULL, NULL,
+			    &energy_dvfs_fops);
+#endif
+
+	energy_dvfs_ready = true;
+	if (enable && energy_dvfs_start())
+		enable = false;
+
+	return 0;
+
+err_notifier:
+	prcmu_qos_remove_requirement(PRCMU_QOS_DDR_OPP, ENERGY_DVFS_QOS_NAME);
+	prcmu_qos_remove_requirement(PRCMU_QOS_APE_OPP, ENERGY_DVFS_QOS_NAME);
+	return ret;
+}
+late_initcall_sync(energy_dvfs_init);
+
+MODULE_DESCRIPTION("ux500 energy model driven ARM/APE/DDR OPP coordination");
+MODULE_LICENSE("GPL");
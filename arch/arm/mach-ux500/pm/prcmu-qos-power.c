@@ -20,6 +20,7 @@
 #include <linux/miscdevice.h>
 #include <linux/uaccess.h>
 #include <linux/cpufreq.h>
+#include <linux/workqueue.h>
 #include <linux/mfd/dbx500-prcmu.h>
 
 #ifdef CONFIG_DEBUG_FS
@@ -28,6 +29,7 @@
 #endif
 
 #include <mach/prcmu-debug.h>
+#include <mach/flight-recorder.h>
 
 #define ARM_THRESHOLD_FREQ 400000
 
@@ -57,8 +59,22 @@ struct requirement_list {
 		s32 kbps;
 	};
 	char *name;
+	/* Jiffies at which the value falls back to the default, 0 if never */
+	unsigned long expires;
+	unsigned long since;
+	unsigned int updates;
+	unsigned int dropped;
 };
 
+static DEFINE_SPINLOCK(prcmu_qos_lock);
+
+/*
+ * Lowered requirements are applied after this window so that a driver
+ * dropping and retaking its requirement does not bounce the OPP.
+ */
+static unsigned int coalesce_ms = 20;
+module_param(coalesce_ms, uint, 0644);
+
 static s32 max_compare(s32 v1, s32 v2);
 
 static int __prcmu_qos_update_requirement(int prcmu_qos_class, char *name,
@@ -72,6 +88,7 @@ struct prcmu_qos_object {
 	s32 default_value;
 	s32 max_value;
 	s32 force_value;
+	s32 ceiling_value;
 	atomic_t target_value;
 	s32 (*comparitor)(s32, s32);
 };
@@ -148,10 +165,24 @@ static struct prcmu_qos_object *prcmu_qos_array[] = {
 static int requirements_print(struct seq_file *s, struct prcmu_qos_object *qo)
 {
 	struct requirement_list *node;
-	//TODO locking
+	unsigned long flags, now = jiffies;
+	unsigned int rate;
+
+	spin_lock_irqsave(&prcmu_qos_lock, flags);
 	list_for_each_entry(node, &qo->requirements.list, list) {
-		seq_printf(s, "%s: %d\n", node->name, node->value);
+		/* Updates per second, in hundredths */
+		rate = div_u64((u64)node->updates * 100 * HZ,
+			       max(now - node->since, 1UL));
+		seq_printf(s, "%s: %d (%u updates, %u dropped, %u.%02u/s)",
+			   node->name, node->value, node->updates,
+			   node->dropped, rate / 100, rate % 100);
+		if (node->expires)
+			seq_printf(s, " expires in %u ms",
+				   time_after(node->expires, now) ?
+				   jiffies_to_msecs(node->expires - now) : 0);
+		seq_printf(s, "\n");
 	}
+	spin_unlock_irqrestore(&prcmu_qos_lock, flags);
 	return 0;
 }
 
@@ -212,7 +243,6 @@ fail:
 #endif
 
 static DEFINE_MUTEX(prcmu_qos_mutex);
-static DEFINE_SPINLOCK(prcmu_qos_lock);
 
 static bool ape_opp_50_partly_25_enabled;
 
@@ -335,6 +365,52 @@ static inline void __prcmu_qos_update_ddr_opp(s32 arm_kz_new_value,
 }
 
 
+/*
+ * Deferred re-evaluation of the targets, for coalesced lowerings and
+ * expiring requirements. reeval_deadline is only valid while the work
+ * is pending.
+ */
+static void update_target(int target, bool sem);
+static void prcmu_qos_reeval_fn(struct work_struct *work);
+static DECLARE_DEFERRED_WORK(prcmu_qos_reeval_work, prcmu_qos_reeval_fn);
+static DEFINE_SPINLOCK(prcmu_qos_reeval_lock);
+static unsigned long reeval_pending;
+static unsigned long reeval_deadline;
+
+static void prcmu_qos_reeval_fn(struct work_struct *work)
+{
+	int i;
+
+	for (i = 1; i < ARRAY_SIZE(prcmu_qos_array); i++)
+		if (test_and_clear_bit(i, &reeval_pending))
+			update_target(i, true);
+}
+
+static void prcmu_qos_reeval_at(int target, unsigned long when)
+{
+	unsigned long flags;
+
+	set_bit(target, &reeval_pending);
+
+	spin_lock_irqsave(&prcmu_qos_reeval_lock, flags);
+	if (!delayed_work_pending(&prcmu_qos_reeval_work) ||
+	    time_before(when, reeval_deadline)) {
+		cancel_delayed_work(&prcmu_qos_reeval_work);
+		reeval_deadline = when;
+		queue_delayed_work(system_power_efficient_wq,
+			&prcmu_qos_reeval_work,
+			time_after(when, jiffies) ? when - jiffies : 0);
+	}
+	spin_unlock_irqrestore(&prcmu_qos_reeval_lock, flags);
+}
+
+static void ape_opp_done(enum prcmu_val type, u8 opp, int status, void *data)
+{
+	if (status && status != -ECANCELED)
+		pr_err("prcmu qos: failed to set ape opp %d (%d)\n",
+		       opp, status);
+}
+
 static void update_target(int target, bool sem)
 {
 	static int recursivity;
@@ -342,6 +418,7 @@ static void update_target(int target, bool sem)
 	struct requirement_list *node;
 	unsigned long flags;
 	bool update = false;
+	unsigned long next_expiry = 0;
 	u8 op;
 
 	if (sem)
@@ -359,9 +436,23 @@ static void update_target(int target, bool sem)
 		list_for_each_entry(node,
 				    &prcmu_qos_array[target]->requirements.list,
 				    list) {
+			if (node->expires) {
+				if (time_after_eq(jiffies, node->expires)) {
+					node->value = prcmu_qos_array[target]->
+						default_value;
+					node->expires = 0;
+				} else if (!next_expiry ||
+					   time_before(node->expires,
+						       next_expiry)) {
+					next_expiry = node->expires;
+				}
+			}
 			extreme_value = prcmu_qos_array[target]->comparitor(
 				extreme_value, node->value);
 		}
+		if (prcmu_qos_array[target]->ceiling_value &&
+		    extreme_value > prcmu_qos_array[target]->ceiling_value)
+			extreme_value = prcmu_qos_array[target]->ceiling_value;
 		if (atomic_read(&prcmu_qos_array[target]->target_value)
 		    != extreme_value) {
 			update = true;
@@ -376,9 +467,14 @@ static void update_target(int target, bool sem)
 
 	spin_unlock_irqrestore(&prcmu_qos_lock, flags);
 
+	if (next_expiry)
+		prcmu_qos_reeval_at(target, next_expiry);
+
 	if (!update)
 		goto unlock_and_return;
 
+	ux500_flight_rec_qos(target, extreme_value);
+
 	if (prcmu_qos_array[target]->notifiers)
 		blocking_notifier_call_chain(prcmu_qos_array[target]->notifiers,
 					     (unsigned long)extreme_value,
@@ -484,7 +580,17 @@ static void update_target(int target, bool sem)
 			       extreme_value);
 			goto unlock_and_return;
 		}
-		(void)prcmu_set_ape_opp(op);
+		/*
+		 * Raise the OPP before returning, the requester relies on it.
+		 * Lowering it can wait for the firmware in the background.
+		 */
+		if (op == APE_100_OPP) {
+			prcmu_cancel_val_async(APE_OPP);
+			(void)prcmu_set_ape_opp(op);
+		} else {
+			(void)prcmu_set_val_async(APE_OPP, op, ape_opp_done,
+						  NULL);
+		}
 		prcmu_debug_ape_opp_log(op);
 		break;
 	case PRCMU_QOS_ARM_KHZ:
@@ -516,6 +622,34 @@ void prcmu_qos_force_opp(int prcmu_qos_class, s32 i)
 	update_target(prcmu_qos_class, true);
 }
 
+/**
+ * prcmu_qos_set_ceiling - cap the APE or DDR OPP whatever is requested
+ * @prcmu_qos_class: PRCMU_QOS_APE_OPP or PRCMU_QOS_DDR_OPP
+ * @value: highest OPP in %, 0 or PRCMU_QOS_DEFAULT_VALUE for no cap
+ *
+ * Meant for thermal limiting, requesters asking for more get less than
+ * they asked for while the ceiling is set.
+ */
+int prcmu_qos_set_ceiling(int prcmu_qos_class, s32 value)
+{
+	unsigned long flags;
+
+	if (prcmu_qos_class != PRCMU_QOS_APE_OPP &&
+	    prcmu_qos_class != PRCMU_QOS_DDR_OPP)
+		return -EINVAL;
+
+	if (value == PRCMU_QOS_DEFAULT_VALUE)
+		value = 0;
+
+	spin_lock_irqsave(&prcmu_qos_lock, flags);
+	prcmu_qos_array[prcmu_qos_class]->ceiling_value = value;
+	spin_unlock_irqrestore(&prcmu_qos_lock, flags);
+
+	update_target(prcmu_qos_class, true);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(prcmu_qos_set_ceiling);
+
 #define LPA_OVERRIDE_VOLTAGE_SETTING 0x22 /* 1.125V */
 
 int prcmu_qos_lpa_override(bool enable)
@@ -585,6 +719,8 @@ void prcmu_qos_voice_call_override(bool enable)
 
 	ape_opp_50_partly_25_enabled = enable;
 
+	/* Act on the OPP a pending lowering is about to set */
+	prcmu_flush_val_async(APE_OPP);
 	ape_opp = prcmu_get_ape_opp();
 
 	if (ape_opp == APE_50_OPP) {
@@ -661,6 +797,7 @@ static int __prcmu_qos_add_requirement(int prcmu_qos_class, char *name,
 	dep->name = kstrdup(name, GFP_KERNEL);
 	if (!dep->name)
 		goto cleanup;
+	dep->since = jiffies;
 
 	spin_lock_irqsave(&prcmu_qos_lock, flags);
 	list_add(&dep->list,
@@ -696,19 +833,31 @@ EXPORT_SYMBOL_GPL(prcmu_qos_add_requirement);
  * @prcmu_qos_class: identifies which list of qos request to us
  * @name: identifies the request
  * @value: defines the qos request
+ * @expires: jiffies at which the request falls back to default, 0 if never
  * @sem: manage update_target recursivity
  *
  * Updates an existing qos requirement for the prcmu_qos_class of parameters
  * along with updating the target prcmu_qos_class value.
  *
- * If the named request isn't in the list then no change is made.
+ * If the named request isn't in the list then no change is made. Updates
+ * that change nothing return without touching the target, and lowered
+ * requests are applied after coalesce_ms.
  */
-static int __prcmu_qos_update_requirement(int prcmu_qos_class, char *name,
-		s32 new_value, bool sem)
+static int __prcmu_qos_set_requirement(int prcmu_qos_class, char *name,
+		s32 new_value, unsigned long expires, bool sem)
 {
 	unsigned long flags;
 	struct requirement_list *node;
 	int pending_update = 0;
+	bool lowered = false;
+	s32 value;
+
+	if (new_value == PRCMU_QOS_DEFAULT_VALUE)
+		value = prcmu_qos_array[prcmu_qos_class]->default_value;
+	else if (new_value == PRCMU_QOS_MAX_VALUE)
+		value = prcmu_qos_array[prcmu_qos_class]->max_value;
+	else
+		value = new_value;
 
 	spin_lock_irqsave(&prcmu_qos_lock, flags);
 	list_for_each_entry(node,
@@ -716,34 +865,46 @@ static int __prcmu_qos_update_requirement(int prcmu_qos_class, char *name,
 		if (strcmp(node->name, name))
 			continue;
 
-		if (new_value == PRCMU_QOS_DEFAULT_VALUE)
-			node->value =
-				prcmu_qos_array[prcmu_qos_class]->default_value;
-		else if (new_value == PRCMU_QOS_MAX_VALUE)
-			node->value =
-				prcmu_qos_array[prcmu_qos_class]->max_value;
-		else
-			node->value = new_value;
+		node->updates++;
+		if (node->value == value && node->expires == expires) {
+			node->dropped++;
+			break;
+		}
+
+		lowered = value < node->value;
+		node->value = value;
+		node->expires = expires;
 		pending_update = 1;
 		break;
 	}
 	spin_unlock_irqrestore(&prcmu_qos_lock, flags);
 
-	if (pending_update) {
-		if (!prcmu_qos_cpufreq_init_done && prcmu_qos_class == PRCMU_QOS_ARM_KHZ) {
-			if (new_value != PRCMU_QOS_DEFAULT_VALUE) {
-				pr_err("prcmu-qos: ERROR: Not possible to request any "
-					"other kHz than DEFAULT during boot!\n");
-				dump_stack();
-			}
-		} else {
-			update_target(prcmu_qos_class, sem);
+	if (!pending_update)
+		return 0;
+
+	if (!prcmu_qos_cpufreq_init_done && prcmu_qos_class == PRCMU_QOS_ARM_KHZ) {
+		if (new_value != PRCMU_QOS_DEFAULT_VALUE) {
+			pr_err("prcmu-qos: ERROR: Not possible to request any "
+				"other kHz than DEFAULT during boot!\n");
+			dump_stack();
 		}
+	} else if (lowered && sem && coalesce_ms) {
+		prcmu_qos_reeval_at(prcmu_qos_class,
+				    jiffies + msecs_to_jiffies(coalesce_ms));
+	} else {
+		update_target(prcmu_qos_class, sem);
 	}
 
 	return 0;
 }
 
+static int __prcmu_qos_update_requirement(int prcmu_qos_class, char *name,
+		s32 new_value, bool sem)
+{
+	return __prcmu_qos_set_requirement(prcmu_qos_class, name, new_value,
+					   0, sem);
+}
+
 int ignore_usb_requirements = 0;
 module_param(ignore_usb_requirements, uint, 0644);
 
@@ -753,8 +914,7 @@ module_param(ignore_file_requirements, uint, 0644);
 int ignore_sva_requirements = 0;
 module_param(ignore_sva_requirements, uint, 0644);
 
-int prcmu_qos_update_requirement(int prcmu_qos_class, char *name,
-		s32 val)
+static s32 prcmu_qos_filter_value(int prcmu_qos_class, char *name, s32 val)
 {
 #if DEBUG
 	if (prcmu_qos_class == PRCMU_QOS_ARM_KHZ)
@@ -773,11 +933,44 @@ int prcmu_qos_update_requirement(int prcmu_qos_class, char *name,
 	if (ignore_sva_requirements &&
 	    (!strncmp(&name[0], "sva", 3)))
 		val = 25;
+	return val;
+}
+
+int prcmu_qos_update_requirement(int prcmu_qos_class, char *name,
+		s32 val)
+{
 	return __prcmu_qos_update_requirement(prcmu_qos_class, name,
-			val, true);
+			prcmu_qos_filter_value(prcmu_qos_class, name, val),
+			true);
 }
 EXPORT_SYMBOL_GPL(prcmu_qos_update_requirement);
 
+/**
+ * prcmu_qos_update_requirement_timeout - modifies a qos request for a while
+ * @prcmu_qos_class: identifies which list of qos request to us
+ * @name: identifies the request
+ * @val: defines the qos request
+ * @timeout_ms: time after which the request falls back to its default
+ *
+ * Like prcmu_qos_update_requirement(), for drivers that would otherwise
+ * drop their requirement on a timer of their own.
+ */
+int prcmu_qos_update_requirement_timeout(int prcmu_qos_class, char *name,
+		s32 val, unsigned int timeout_ms)
+{
+	unsigned long expires = 0;
+
+	if (timeout_ms) {
+		/* 0 means no expiry */
+		expires = (jiffies + msecs_to_jiffies(timeout_ms)) ?: 1;
+	}
+
+	return __prcmu_qos_set_requirement(prcmu_qos_class, name,
+			prcmu_qos_filter_value(prcmu_qos_class, name, val),
+			expires, true);
+}
+EXPORT_SYMBOL_GPL(prcmu_qos_update_requirement_timeout);
+
 
 /**
  * prcmu_qos_remove_requirement - modifies an existing qos request
@@ -987,8 +1180,8 @@ static void qos_delayed_work_down_fn(struct work_struct *work)
 	cpufreq_requirement_set = PRCMU_QOS_DEFAULT_VALUE;
 }
 
-static DECLARE_DELAYED_WORK(qos_delayed_work_up, qos_delayed_work_up_fn);
-static DECLARE_DELAYED_WORK(qos_delayed_work_down, qos_delayed_work_down_fn);
+static DECLARE_DEFERRED_WORK(qos_delayed_work_up, qos_delayed_work_up_fn);
+static DECLARE_DEFERRED_WORK(qos_delayed_work_down, qos_delayed_work_down_fn);
 
 static int qos_delayed_cpufreq_notifier(struct notifier_block *nb,
 			unsigned long event, void *data)
@@ -1028,8 +1221,9 @@ static int qos_delayed_cpufreq_notifier(struct notifier_block *nb,
 		 * one.
 		 */
 		if (new_ddr_target != cpufreq_requirement_set)
-			schedule_delayed_work(&qos_delayed_work_up,
-					      cpufreq_opp_delay);
+			queue_delayed_work(system_power_efficient_wq,
+					   &qos_delayed_work_up,
+					   cpufreq_opp_delay);
 	} else {
 		cancel_delayed_work_sync(&qos_delayed_work_up);
 		/*
@@ -1037,8 +1231,9 @@ static int qos_delayed_cpufreq_notifier(struct notifier_block *nb,
 		 * one.
 		 */
 		if (new_ddr_target != cpufreq_requirement_set)
-			schedule_delayed_work(&qos_delayed_work_down,
-					      cpufreq_opp_delay);
+			queue_delayed_work(system_power_efficient_wq,
+					   &qos_delayed_work_down,
+					   cpufreq_opp_delay);
 	}
 
 	return 0;
@@ -1083,7 +1278,7 @@ static void restore_ddr_opp_fn(struct work_struct *work)
 	prcmu_qos_update_requirement(PRCMU_QOS_DDR_OPP, "power HAL", QOS_DDR_OPP_NORMAL);
 	ddr_opp_boosted = 0;
 }
-static DECLARE_DELAYED_WORK(restore_ddr_opp_delayedwork, restore_ddr_opp_fn);
+static DECLARE_DEFERRED_WORK(restore_ddr_opp_delayedwork, restore_ddr_opp_fn);
 
 extern bool is_suspended_get(void);
 
@@ -1109,7 +1304,8 @@ static int set_qos_ddr_opp(const char *val, struct kernel_param *kp)
 			prcmu_qos_update_requirement(PRCMU_QOS_DDR_OPP, "power HAL", ddr_opp);
 
 		if (qos_ddr_opp_boost_dur_ms > 0) {
-			schedule_delayed_work(&restore_ddr_opp_delayedwork,
+			queue_delayed_work(system_power_efficient_wq,
+				&restore_ddr_opp_delayedwork,
 				msecs_to_jiffies(qos_ddr_opp_boost_dur_ms));
 			ddr_opp_boosted = 1;
 		}
@@ -1132,7 +1328,7 @@ static void restore_ape_opp_fn(struct work_struct *work)
 	prcmu_qos_update_requirement(PRCMU_QOS_APE_OPP, "power HAL", QOS_APE_OPP_NORMAL);
 	ape_opp_boosted = 0;
 }
-static DECLARE_DELAYED_WORK(restore_ape_opp_delayedwork, restore_ape_opp_fn);
+static DECLARE_DEFERRED_WORK(restore_ape_opp_delayedwork, restore_ape_opp_fn);
 
 static int set_qos_ape_opp(const char *val, struct kernel_param *kp)
 {
@@ -1156,7 +1352,8 @@ static int set_qos_ape_opp(const char *val, struct kernel_param *kp)
 			prcmu_qos_update_requirement(PRCMU_QOS_APE_OPP, "power HAL", ape_opp);
 
 		if (qos_ape_opp_boost_dur_ms > 0) {
-			schedule_delayed_work(&restore_ape_opp_delayedwork,
+			queue_delayed_work(system_power_efficient_wq,
+				&restore_ape_opp_delayedwork,
 				msecs_to_jiffies(qos_ape_opp_boost_dur_ms));
 			ape_opp_boosted = 1;
 		}
@@ -1179,7 +1376,7 @@ static void restore_arm_khz_fn(struct work_struct *work)
 	prcmu_qos_update_requirement(PRCMU_QOS_ARM_KHZ, "power HAL", QOS_ARM_KHZ_NORMAL);
 	arm_khz_boosted = 0;
 }
-static DECLARE_DELAYED_WORK(restore_arm_khz_delayedwork, restore_arm_khz_fn);
+static DECLARE_DEFERRED_WORK(restore_arm_khz_delayedwork, restore_arm_khz_fn);
 
 static int set_qos_arm_khz(const char *val, struct kernel_param *kp)
 {
@@ -1198,7 +1395,8 @@ static int set_qos_arm_khz(const char *val, struct kernel_param *kp)
 		prcmu_qos_update_requirement(PRCMU_QOS_ARM_KHZ, "power HAL", arm_khz);
 
 	if (qos_arm_khz_boost_dur_ms > 0) {
-		schedule_delayed_work(&restore_arm_khz_delayedwork,
+		queue_delayed_work(system_power_efficient_wq,
+			&restore_arm_khz_delayedwork,
 			msecs_to_jiffies(qos_arm_khz_boost_dur_ms));
 		arm_khz_boosted = 1;
 	}
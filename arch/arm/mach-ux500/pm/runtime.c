@@ -12,8 +12,12 @@
 
 #include <linux/init.h>
 #include <linux/kernel.h>
+#include <linux/module.h>
 #include <linux/io.h>
 #include <linux/err.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
 #include <linux/pm_runtime.h>
 #include <linux/platform_device.h>
 #include <linux/amba/bus.h>
@@ -29,18 +33,57 @@
 #define BIT_ACTIVE		1
 #define BIT_ENABLED	2
 
+/*
+ * Adaptive autosuspend: for the devices whose drivers use autosuspend,
+ * the delay follows how the device is used. A suspend that ends before
+ * the device has been suspended for COST_FACTOR times its resume time
+ * cost more than it saved, so the delay is doubled to cover the next
+ * such gap. Each suspend much longer than the delay shrinks it by a
+ * quarter, down to min_autosuspend_ms.
+ */
+#define ADAPTIVE_COST_FACTOR	10
+#define ADAPTIVE_LONG_FACTOR	8
+
+static bool adaptive_autosuspend = true;
+module_param(adaptive_autosuspend, bool, 0644);
+static unsigned int min_autosuspend_ms = 10;
+module_param(min_autosuspend_ms, uint, 0644);
+static unsigned int max_autosuspend_ms = 2000;
+module_param(max_autosuspend_ms, uint, 0644);
+
+struct pm_runtime_stats {
+	unsigned long suspends;
+	unsigned long short_suspends;
+	u64 resume_ns;			/* total */
+	u64 resume_max_ns;
+	u64 suspended_ns;		/* total, up to the last resume */
+	ktime_t suspended_at;
+};
+
 struct pm_runtime_data {
 	unsigned long flags;
 	struct ux500_regulator *regulator;
 	struct ux500_pins *pins;
+	struct device *dev;
+	struct list_head node;
+	struct pm_runtime_stats stats;
 };
 
+/* All the pm_runtime_data, for debugfs */
+static LIST_HEAD(prd_list);
+static DEFINE_SPINLOCK(prd_list_lock);
+
 static void __devres_release(struct device *dev, void *res)
 {
 	struct pm_runtime_data *prd = res;
+	unsigned long flags;
 
 	dev_dbg(dev, "__devres_release()\n");
 
+	spin_lock_irqsave(&prd_list_lock, flags);
+	list_del(&prd->node);
+	spin_unlock_irqrestore(&prd_list_lock, flags);
+
 	if (test_bit(BIT_ENABLED, &prd->flags)) {
 		if (prd->pins)
 			ux500_pins_disable(prd->pins);
@@ -93,6 +136,61 @@ static void platform_pm_runtime_used(struct device *dev,
 		set_bit(BIT_ONCE, &prd->flags);
 }
 
+static void ux500_pd_suspended(struct pm_runtime_data *prd)
+{
+	if (!prd)
+		return;
+
+	prd->stats.suspends++;
+	prd->stats.suspended_at = ktime_get();
+}
+
+static void ux500_pd_adapt(struct device *dev, struct pm_runtime_data *prd,
+			   u64 gap_ns, u64 resume_ns)
+{
+	int delay = dev->power.autosuspend_delay;
+
+	if (!adaptive_autosuspend || !dev->power.use_autosuspend || delay < 0)
+		return;
+
+	if (gap_ns < resume_ns * ADAPTIVE_COST_FACTOR) {
+		prd->stats.short_suspends++;
+		if (delay < max_autosuspend_ms)
+			delay = min_t(int, delay * 2 + 1, max_autosuspend_ms);
+	} else if (gap_ns > (u64)delay * NSEC_PER_MSEC * ADAPTIVE_LONG_FACTOR) {
+		if (delay > min_autosuspend_ms)
+			delay = max_t(int, delay - delay / 4, min_autosuspend_ms);
+	}
+
+	/*
+	 * power.lock is held here for irq safe devices, so the delay is set
+	 * without pm_runtime_set_autosuspend_delay(). It stays positive and
+	 * is only read at the next suspend.
+	 */
+	dev->power.autosuspend_delay = delay;
+}
+
+/* @start is the time the resume began */
+static void ux500_pd_resumed(struct device *dev, struct pm_runtime_data *prd,
+			     ktime_t start)
+{
+	ktime_t now = ktime_get();
+	u64 resume_ns;
+	u64 gap_ns;
+
+	if (!prd || !prd->stats.suspends)
+		return;
+
+	resume_ns = ktime_to_ns(ktime_sub(now, start));
+	gap_ns = ktime_to_ns(ktime_sub(start, prd->stats.suspended_at));
+
+	prd->stats.resume_ns += resume_ns;
+	prd->stats.resume_max_ns = max(prd->stats.resume_max_ns, resume_ns);
+	prd->stats.suspended_ns += gap_ns;
+
+	ux500_pd_adapt(dev, prd, gap_ns, resume_ns);
+}
+
 static int ux500_pd_runtime_idle(struct device *dev)
 {
 	return pm_runtime_suspend(dev);
@@ -126,6 +224,7 @@ static int ux500_pd_runtime_suspend(struct device *dev)
 		return ret;
 
 	ux500_pd_disable(prd);
+	ux500_pd_suspended(prd);
 
 	return 0;
 }
@@ -146,13 +245,19 @@ static void ux500_pd_enable(struct pm_runtime_data *prd)
 static int ux500_pd_runtime_resume(struct device *dev)
 {
 	struct pm_runtime_data *prd = __to_prd(dev);
+	ktime_t start = ktime_get();
+	int ret;
 
 	dev_vdbg(dev, "%s()\n", __func__);
 
 	platform_pm_runtime_used(dev, prd);
 	ux500_pd_enable(prd);
 
-	return pm_generic_runtime_resume(dev);
+	ret = pm_generic_runtime_resume(dev);
+	if (!ret)
+		ux500_pd_resumed(dev, prd, start);
+
+	return ret;
 }
 
 static int ux500_pd_suspend_noirq(struct device *dev)
@@ -297,6 +402,8 @@ static int ux500_pd_amba_runtime_suspend(struct device *dev)
 
 	if (ret)
 		ux500_pd_enable(prd);
+	else
+		ux500_pd_suspended(prd);
 
 	return ret;
 }
@@ -305,6 +412,7 @@ static int ux500_pd_amba_runtime_resume(struct device *dev)
 {
 	struct pm_runtime_data *prd = __to_prd(dev);
 	int (*callback)(struct device *) = NULL;
+	ktime_t start = ktime_get();
 	int ret;
 
 	dev_vdbg(dev, "%s()\n", __func__);
@@ -328,8 +436,10 @@ static int ux500_pd_amba_runtime_resume(struct device *dev)
 	 * that drivers are not able to use their pins/regulators during
 	 * runtime resume.
 	 */
-	if (!ret)
+	if (!ret) {
 		ux500_pd_enable(prd);
+		ux500_pd_resumed(dev, prd, start);
+	}
 
 	return ret;
 }
@@ -370,6 +480,12 @@ static int ux500_pd_bus_notify(struct notifier_block *nb,
 	if (action == BUS_NOTIFY_BIND_DRIVER) {
 		prd = devres_alloc(__devres_release, sizeof(*prd), GFP_KERNEL);
 		if (prd) {
+			unsigned long flags;
+
+			prd->dev = dev;
+			spin_lock_irqsave(&prd_list_lock, flags);
+			list_add_tail(&prd->node, &prd_list);
+			spin_unlock_irqrestore(&prd_list_lock, flags);
 			devres_add(dev, prd);
 			platform_pm_runtime_init(dev, prd);
 			if (enable)
@@ -393,6 +509,68 @@ static int ux500_pd_amba_bus_notify(struct notifier_block *nb,
 	return ux500_pd_bus_notify(nb, action, data, true);
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int ux500_pd_stats_show(struct seq_file *s, void *data)
+{
+	struct pm_runtime_data *prd;
+	unsigned long flags;
+	u64 suspended_ns;
+	unsigned long resumes;
+
+	seq_printf(s, "%-24s %9s %9s %9s %9s %11s %8s\n", "device",
+		   "suspends", "short", "resume_us", "max_us",
+		   "suspend_ms", "delay_ms");
+
+	spin_lock_irqsave(&prd_list_lock, flags);
+	list_for_each_entry(prd, &prd_list, node) {
+		struct device *dev = prd->dev;
+
+		suspended_ns = prd->stats.suspended_ns;
+		if (prd->stats.suspends && pm_runtime_status_suspended(dev))
+			suspended_ns += ktime_to_ns(ktime_sub(ktime_get(),
+						prd->stats.suspended_at));
+		resumes = prd->stats.suspends;
+		if (resumes && pm_runtime_status_suspended(dev))
+			resumes--;
+
+		seq_printf(s, "%-24s %9lu %9lu %9llu %9llu %11llu ",
+			   dev_name(dev), prd->stats.suspends,
+			   prd->stats.short_suspends,
+			   resumes ? div_u64(div_u64(prd->stats.resume_ns,
+						     resumes), NSEC_PER_USEC) : 0,
+			   div_u64(prd->stats.resume_max_ns, NSEC_PER_USEC),
+			   div_u64(suspended_ns, NSEC_PER_MSEC));
+		if (dev->power.use_autosuspend)
+			seq_printf(s, "%8d\n", dev->power.autosuspend_delay);
+		else
+			seq_printf(s, "%8s\n", "-");
+	}
+	spin_unlock_irqrestore(&prd_list_lock, flags);
+
+	return 0;
+}
+
+static int ux500_pd_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ux500_pd_stats_show, inode->i_private);
+}
+
+static const struct file_operations ux500_pd_stats_fops = {
+	.open		= ux500_pd_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init ux500_pd_debugfs_init(void)
+{
+	debugfs_create_file("runtime_pm", S_IRUGO, NULL, NULL,
+			    &ux500_pd_stats_fops);
+	return 0;
+}
+late_initcall(ux500_pd_debugfs_init);
+#endif
+
 #else /* CONFIG_PM_RUNTIME */
 
 #define ux500_pd_suspend_noirq	NULL
@@ -21,6 +21,7 @@
 #include <linux/cpufreq.h>
 #include <linux/mfd/dbx500-prcmu.h>
 #include <linux/platform_device.h>
+#include <linux/hotplug_mgr.h>
 #include <mach/usecase_gov.h>
 
 #define CPULOAD_MEAS_DELAY	3000 /* 3 secondes of delta */
@@ -77,6 +78,10 @@ static struct usecase_config *usecase_conf;
 static struct delayed_work work_usecase;
 static struct early_suspend usecase_early_suspend;
 
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+static struct hotplug_request usecase_hotplug_req;
+#endif
+
 static unsigned int system_min_freq;
 static unsigned int system_max_freq;
 
@@ -310,12 +315,18 @@ static void set_cpu_config(enum ux500_uc new_uc)
 		goto exit;
 
 	/* Cpu hotplug */
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+	/* Keeping the second CPU leaves the decision to the other clients */
+	hotplug_mgr_update_request(&usecase_hotplug_req,
+			usecase_conf[new_uc].second_cpu_online ? 0 : 1, 0);
+#else
 	if (!(usecase_conf[new_uc].second_cpu_online) &&
 	    (num_online_cpus() > 1))
 		cpu_down(1);
 	else if ((usecase_conf[new_uc].second_cpu_online) &&
 		 (num_online_cpus() < 2))
 		cpu_up(1);
+#endif
 
 	if (usecase_conf[new_uc].max_arm)
 		max_freq = usecase_conf[new_uc].max_arm;
@@ -386,7 +397,8 @@ void usecase_update_governor_state(void)
 			(usecase_conf[UX500_UC_USER].enable &&
 			usecase_conf[UX500_UC_USER].force_usecase)) &&
 			!is_work_scheduled) {
-			schedule_delayed_work_on(0, &work_usecase,
+			queue_delayed_work_on(0, system_power_efficient_wq,
+				&work_usecase,
 				msecs_to_jiffies(CPULOAD_MEAS_DELAY));
 			is_work_scheduled = true;
 		} else if (!is_early_suspend && is_work_scheduled) {
@@ -536,8 +548,8 @@ static void delayed_usecase_work(struct work_struct *work)
 	mutex_unlock(&usecase_mutex);
 
 	/* reprogramm scheduled work */
-	schedule_delayed_work_on(0, &work_usecase,
-				msecs_to_jiffies(CPULOAD_MEAS_DELAY));
+	queue_delayed_work_on(0, system_power_efficient_wq, &work_usecase,
+			      msecs_to_jiffies(CPULOAD_MEAS_DELAY));
 
 }
 
@@ -872,7 +884,8 @@ void usecase_force_governor_state(void)
 		 * governor to work.
 		 */
 		if (!is_work_scheduled) {
-			schedule_delayed_work_on(0, &work_usecase, 0);
+			queue_delayed_work_on(0, system_power_efficient_wq,
+					      &work_usecase, 0);
 			is_work_scheduled = true;
 		} else {
 			/* Exiting from early suspend. */
@@ -1066,6 +1079,7 @@ static int __init probe_usecase_devices(struct platform_device *pdev)
 	/* register delayed queuework */
 	INIT_DELAYED_WORK_DEFERRABLE(&work_usecase,
 				     delayed_usecase_work);
+	set_timer_slack_class(&work_usecase.timer, TIMER_SLACK_RELAXED);
 
 	ux500_ci_get_cstates(&cpudile_max_states);
 	cpuidle_deepest_state = cpudile_max_states - 1;
@@ -1081,6 +1095,9 @@ static int __init probe_usecase_devices(struct platform_device *pdev)
 
 	prcmu_qos_add_requirement(PRCMU_QOS_ARM_KHZ, "usecase",
 				  PRCMU_QOS_DEFAULT_VALUE);
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+	hotplug_mgr_add_request(&usecase_hotplug_req, "usecase", 0, 0);
+#endif
 
 	pr_info("Use-case governor initialized\n");
 
@@ -85,9 +85,10 @@ static void __init ux500_timer_init(void)
 	 * Since the MTU is located in the VAPE power domain
 	 * it will be cleared in sleep which makes it unsuitable.
 	 * We however need it as a timer tick (clockevent)
-	 * during boot to calibrate delay until twd is started.
-	 * RTC-RTT have problems as timer tick during boot since it is
-	 * depending on delay which is not yet calibrated. RTC-RTT is in the
+	 * during boot until twd is started, and udelay() counts its
+	 * ticks, so loops_per_jiffy is set from its rate instead of
+	 * calibrated. RTC-RTT have problems as timer tick during boot
+	 * since it is depending on delay. RTC-RTT is in the
 	 * always-on powerdomain and is used as clockevent instead of twd when
 	 * sleeping.
 	 *
@@ -8,6 +8,8 @@
 #ifndef __PLAT_I2C_H
 #define __PLAT_I2C_H
 
+#include <linux/dmaengine.h>
+
 enum i2c_freq_mode {
 	I2C_FREQ_MODE_STANDARD,		/* up to 100 Kb/s */
 	I2C_FREQ_MODE_FAST,		/* up to 400 Kb/s */
@@ -26,6 +28,11 @@ enum i2c_freq_mode {
  * @rft:	Rx FIFO Threshold in bytes
  * @timeout	Slave response timeout(ms)
  * @sm:		speed mode
+ * @dma_filter:	DMA channel filter, NULL to move all data by interrupts
+ * @dma_rx_param: filter parameter of the Rx channel
+ * @dma_tx_param: filter parameter of the Tx channel
+ * @dma_threshold: messages of at least this many bytes use DMA,
+ *		0 for the driver default
  */
 struct nmk_i2c_controller {
 	unsigned long	clk_freq;
@@ -34,6 +41,10 @@ struct nmk_i2c_controller {
 	unsigned char	rft;
 	int timeout;
 	enum i2c_freq_mode	sm;
+	bool		(*dma_filter)(struct dma_chan *chan, void *filter_param);
+	void		*dma_rx_param;
+	void		*dma_tx_param;
+	unsigned short	dma_threshold;
 };
 
 #endif	/* __PLAT_I2C_H */
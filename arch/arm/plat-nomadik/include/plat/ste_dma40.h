@@ -14,6 +14,7 @@
 #include <linux/interrupt.h>
 #include <linux/dmaengine.h>
 #include <linux/version.h>
+#include <linux/highmem.h>
 
 /* dev types for memcpy */
 #define STEDMA40_DEV_DST_MEMORY (-1)
@@ -108,6 +109,12 @@ struct stedma40_half_channel_info {
  * @dst_info: Parameters for dst half channel
  * @use_fixed_channel: if true, use physical channel specified by phy_channel
  * @phy_channel: physical channel to use, only if use_fixed_channel is true
+ * @periods_per_irq: for cyclic jobs on logical channels, interrupt only at
+ * the end of every periods_per_irq period, 0 or 1 interrupts every period.
+ * Ignored unless it evenly divides the number of periods.
+ * @cyclic_irq_callback: call the callback of cyclic jobs from the interrupt
+ * handler instead of the tasklet, to not add the tasklet scheduling to the
+ * latency. The callback is then called in hard interrupt context.
  *
  * This structure has to be filled by the client drivers.
  * It is recommended to do all dma configurations for clients in the machine.
@@ -128,6 +135,9 @@ struct stedma40_chan_cfg {
 
 	bool					 use_fixed_channel;
 	int					 phy_channel;
+
+	unsigned int				 periods_per_irq;
+	bool					 cyclic_irq_callback;
 };
 
 /**
@@ -229,4 +239,28 @@ dma_addr_t stedma40_get_dst_addr(struct dma_chan *chan);
  */
 bool stedma40_filter(struct dma_chan *chan, void *data);
 
+#ifdef CONFIG_STE_DMA40_COPY
+/**
+ * stedma40_copy_pages() - Copies physically contiguous pages, with the DMA
+ * if the copy is large enough to gain from it.
+ *
+ * @dst: First destination page
+ * @src: First source page
+ * @nr_pages: Number of pages to copy
+ *
+ * May sleep.
+ */
+void stedma40_copy_pages(struct page *dst, struct page *src,
+			 unsigned int nr_pages);
+#else
+static inline void stedma40_copy_pages(struct page *dst, struct page *src,
+				       unsigned int nr_pages)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr_pages; i++)
+		copy_highpage(dst + i, src + i);
+}
+#endif
+
 #endif
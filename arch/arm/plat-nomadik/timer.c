@@ -177,6 +177,16 @@ int read_current_timer(unsigned long *timer_val)
 	*timer_val = ~readl(mtu_base + MTU_VAL(0));
 	return 0;
 }
+
+/*
+ * The delay loop counts MTU ticks, so loops_per_jiffy is the MTU rate and
+ * does not depend on the cpu clock or the OPP. Secondary cpus take the
+ * value of the boot cpu instead of calibrating again.
+ */
+unsigned long __cpuinit calibrate_delay_is_known(void)
+{
+	return lpj_fine;
+}
 #endif
 
 /*
@@ -275,8 +285,11 @@ void __init nmdk_timer_init(void)
 	setup_irq(IRQ_MTU0, &nmdk_timer_irq);
 	clockevents_register_device(&nmdk_clkevt);
 #ifdef ARCH_HAS_READ_CURRENT_TIMER
-	if (!prcmu_is_ulppll_disabled())
+	if (!prcmu_is_ulppll_disabled()) {
 		set_delay_fn(nmdk_timer_delay_loop);
+		/* One loop is one tick, no need to calibrate */
+		lpj_fine = DIV_ROUND_UP(rate, HZ);
+	}
 #endif
 
 }
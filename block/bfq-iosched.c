@@ -160,6 +160,16 @@ static int T_slow[2];
 static int T_fast[2];
 static int device_speed_thresh[2];
 
+/*
+ * Reference values of the android profile: the sequential read rate of a
+ * typical phone eMMC (about 40MB/s, in the same unit as R_slow/R_fast) and
+ * the time to launch a large app from it. Tasks at or above the background
+ * nice level of Android are not weight-raised with the profile.
+ */
+static int R_android = 5120;
+static int T_android;
+#define BFQ_ANDROID_BG_NICE	10
+
 #define BFQ_SERVICE_TREE_INIT	((struct bfq_service_tree)		\
 				{ RB_ROOT, RB_ROOT, NULL, NULL, 0, 0 })
 
@@ -565,6 +575,18 @@ static inline unsigned int bfq_wr_duration(struct bfq_data *bfqd)
 	if (bfqd->bfq_wr_max_time > 0)
 		return bfqd->bfq_wr_max_time;
 
+	if (bfqd->android_profile) {
+		/*
+		 * Until the peak rate has been measured it still holds the
+		 * optimistic initial value, use the reference time as is.
+		 */
+		if (bfqd->peak_rate_samples < BFQ_PEAK_RATE_SAMPLES)
+			return T_android;
+		dur = (u64)R_android * T_android;
+		do_div(dur, bfqd->peak_rate);
+		return clamp_t(u64, dur, T_android / 2, T_android * 2);
+	}
+
 	dur = bfqd->RT_prod;
 	do_div(dur, bfqd->peak_rate);
 
@@ -634,6 +656,7 @@ static inline void bfq_reset_burst_list(struct bfq_data *bfqd,
 		hlist_del_init(&item->burst_list_node);
 	hlist_add_head(&bfqq->burst_list_node, &bfqd->burst_list);
 	bfqd->burst_size = 1;
+	bfqd->burst_tgid = bfqq->tgid;
 }
 
 /* Add bfqq to the list of queues in current burst (see bfq_handle_burst) */
@@ -642,7 +665,23 @@ static void bfq_add_to_burst(struct bfq_data *bfqd, struct bfq_queue *bfqq)
 	/* Increment burst size to take into account also bfqq */
 	bfqd->burst_size++;
 
-	if (bfqd->burst_size == bfqd->bfq_large_burst_thresh) {
+	if (bfqq->tgid != bfqd->burst_tgid)
+		bfqd->burst_tgid = 0;
+
+	/*
+	 * With the android profile, a burst of queues that all belong to
+	 * one process is an app being launched: the zygote child starts
+	 * many threads, each with its own queue, and they all wait for the
+	 * launch to complete. Keep such a burst weight-raised, it becomes
+	 * large only if a queue of another process joins it.
+	 */
+	if (bfqd->android_profile && bfqd->burst_tgid &&
+	    bfqd->burst_size >= bfqd->bfq_large_burst_thresh) {
+		hlist_add_head(&bfqq->burst_list_node, &bfqd->burst_list);
+		return;
+	}
+
+	if (bfqd->burst_size >= bfqd->bfq_large_burst_thresh) {
 		struct bfq_queue *pos, *bfqq_item;
 		struct hlist_node *p, *n;
 
@@ -868,6 +907,7 @@ static void bfq_add_request(struct request *rq)
 
 	if (!bfq_bfqq_busy(bfqq)) {
 		bool soft_rt, coop_or_in_burst,
+		     background = bfq_bfqq_background(bfqq),
 		     idle_for_long_time = time_is_before_jiffies(
 						bfqq->budget_timeout +
 						bfqd->bfq_wr_min_idle_time);
@@ -894,9 +934,10 @@ static void bfq_add_request(struct request *rq)
 		coop_or_in_burst = bfq_bfqq_in_large_burst(bfqq) ||
 			bfq_bfqq_cooperations(bfqq) >= bfqd->bfq_coop_thresh;
 		soft_rt = bfqd->bfq_wr_max_softrt_rate > 0 &&
-			!coop_or_in_burst &&
+			!coop_or_in_burst && !background &&
 			time_is_before_jiffies(bfqq->soft_rt_next_start);
-		interactive = !coop_or_in_burst && idle_for_long_time;
+		interactive = !coop_or_in_burst && !background &&
+			idle_for_long_time;
 		entity->budget = max_t(unsigned long, bfqq->max_budget,
 				       bfq_serv_to_charge(next_rq, bfqq));
 
@@ -942,7 +983,7 @@ static void bfq_add_request(struct request *rq)
 		} else if (old_wr_coeff > 1) {
 			if (interactive)
 				bfqq->wr_cur_max_time = bfq_wr_duration(bfqd);
-			else if (coop_or_in_burst ||
+			else if (coop_or_in_burst || background ||
 				 (bfqq->wr_cur_max_time ==
 				  bfqd->bfq_wr_rt_max_time &&
 				  !soft_rt)) {
@@ -3092,6 +3133,7 @@ retry:
 
 		if (bfqq != NULL) {
 			bfq_init_bfqq(bfqd, bfqq, current->pid, is_sync);
+			bfqq->tgid = current->tgid;
 			bfq_init_prio_data(bfqq, ioc);
 			bfq_init_entity(&bfqq->entity, bfqg);
 			bfq_log_bfqq(bfqd, bfqq, "allocated");
@@ -3549,6 +3591,7 @@ bfq_split_bfqq(struct bfq_io_cq *bic, struct bfq_queue *bfqq)
 
 	if (bfqq_process_refs(bfqq) == 1) {
 		bfqq->pid = current->pid;
+		bfqq->tgid = current->tgid;
 		bfq_clear_bfqq_coop(bfqq);
 		bfq_clear_bfqq_split_coop(bfqq);
 		return bfqq;
@@ -3625,6 +3668,13 @@ new_queue:
 	rq->elv.priv[0] = bic;
 	rq->elv.priv[1] = bfqq;
 
+	/* Sync queues belong to the task issuing the request */
+	if (is_sync && bfqd->android_profile &&
+	    task_nice(current) >= BFQ_ANDROID_BG_NICE)
+		bfq_mark_bfqq_background(bfqq);
+	else
+		bfq_clear_bfqq_background(bfqq);
+
 	/*
 	 * If a bfq_queue has only one process reference, it is owned
 	 * by only one bfq_io_cq: we can set the bic field of the
@@ -3993,6 +4043,7 @@ SHOW_FUNCTION(bfq_wr_min_idle_time_show, bfqd->bfq_wr_min_idle_time, 1);
 SHOW_FUNCTION(bfq_wr_min_inter_arr_async_show, bfqd->bfq_wr_min_inter_arr_async,
 	1);
 SHOW_FUNCTION(bfq_wr_max_softrt_rate_show, bfqd->bfq_wr_max_softrt_rate, 0);
+SHOW_FUNCTION(bfq_android_profile_show, bfqd->android_profile, 0);
 #undef SHOW_FUNCTION
 
 #define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
@@ -4109,6 +4160,20 @@ static ssize_t bfq_low_latency_store(struct elevator_queue *e,
 	return ret;
 }
 
+static ssize_t bfq_android_profile_store(struct elevator_queue *e,
+					 const char *page, size_t count)
+{
+	struct bfq_data *bfqd = e->elevator_data;
+	unsigned long uninitialized_var(__data);
+	int ret = bfq_var_store(&__data, (page), count);
+
+	if (__data > 1)
+		__data = 1;
+	bfqd->android_profile = __data;
+
+	return ret;
+}
+
 #define BFQ_ATTR(name) \
 	__ATTR(name, S_IRUGO|S_IWUSR, bfq_##name##_show, bfq_##name##_store)
 
@@ -4130,6 +4195,7 @@ static struct elv_fs_entry bfq_attrs[] = {
 	BFQ_ATTR(wr_min_idle_time),
 	BFQ_ATTR(wr_min_inter_arr_async),
 	BFQ_ATTR(wr_max_softrt_rate),
+	BFQ_ATTR(android_profile),
 	BFQ_ATTR(weights),
 	__ATTR_NULL
 };
@@ -4185,6 +4251,7 @@ static int __init bfq_init(void)
 	T_slow[1] = msecs_to_jiffies(1000);
 	T_fast[0] = msecs_to_jiffies(5500);
 	T_fast[1] = msecs_to_jiffies(2000);
+	T_android = msecs_to_jiffies(1500);
 
 	/*
 	 * Thresholds that determine the switch between speed classes (see
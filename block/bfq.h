@@ -209,6 +209,8 @@ struct bfq_group;
  *                         within an idle time slice; used only if the queue's
  *                         IO_bound has been cleared.
  * @pid: pid of the process owning the queue, used for logging purposes.
+ * @tgid: thread group of the process that created the queue, used by the
+ *        android profile to tell an app launch from unrelated activations.
  * @last_wr_start_finish: start time of the current weight-raising period if
  *                        the @bfq-queue is being weight-raised, otherwise
  *                        finish time of the last weight-raising period
@@ -272,6 +274,7 @@ struct bfq_queue {
 	unsigned int requests_within_timer;
 
 	pid_t pid;
+	pid_t tgid;
 	struct bfq_io_cq *bic;
 
 	/* weight-raising fields */
@@ -461,6 +464,8 @@ enum bfq_device_speed {
  * @large_burst: true if a large queue-activation burst is in progress.
  * @burst_list: head of the burst list (as for the above fields, more details
  * 		in the comments to the function bfq_handle_burst).
+ * @burst_tgid: thread group shared by all the queues in the burst list, 0
+ *              if they belong to more than one.
  * @low_latency: if set to true, low-latency heuristics are enabled.
  * @bfq_wr_coeff: maximum factor by which the weight of a weight-raised
  *                queue is multiplied.
@@ -477,6 +482,11 @@ enum bfq_device_speed {
  * @RT_prod: cached value of the product R*T used for computing the maximum
  *	     duration of the weight raising automatically.
  * @device_speed: device-speed class for the low-latency heuristic.
+ * @android_profile: if set to true, the low-latency heuristics are tuned for
+ *                   Android: an app launch is not treated as a large burst,
+ *                   the weight-raising duration is sized from eMMC reference
+ *                   values, and queues of background tasks are not
+ *                   weight-raised.
  * @oom_bfqq: fallback dummy bfqq for extreme OOM conditions.
  *
  * All the fields are protected by the @queue lock.
@@ -547,6 +557,7 @@ struct bfq_data {
 	unsigned long bfq_large_burst_thresh;
 	bool large_burst;
 	struct hlist_head burst_list;
+	pid_t burst_tgid;
 
 	bool low_latency;
 
@@ -560,6 +571,8 @@ struct bfq_data {
 	u64 RT_prod;
 	enum bfq_device_speed device_speed;
 
+	bool android_profile;
+
 	struct bfq_queue oom_bfqq;
 };
 
@@ -592,6 +605,10 @@ enum bfqq_state_flags {
 	BFQ_BFQQ_FLAG_coop,		/* bfqq is shared */
 	BFQ_BFQQ_FLAG_split_coop,	/* shared bfqq will be split */
 	BFQ_BFQQ_FLAG_just_split,	/* queue has just been split */
+	BFQ_BFQQ_FLAG_background,	/*
+					 * owner runs at a background nice
+					 * level (android profile only)
+					 */
 };
 
 #define BFQ_BFQQ_FNS(name)						\
@@ -623,6 +640,7 @@ BFQ_BFQQ_FNS(coop);
 BFQ_BFQQ_FNS(split_coop);
 BFQ_BFQQ_FNS(just_split);
 BFQ_BFQQ_FNS(softrt_update);
+BFQ_BFQQ_FNS(background);
 #undef BFQ_BFQQ_FNS
 
 /* Logging facilities. */
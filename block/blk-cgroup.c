@@ -1583,7 +1583,9 @@ static void blkiocg_destroy(struct cgroup *cgroup)
 		list_for_each_entry(blkiop, &blkio_list, list) {
 			if (blkiop->plid != blkg->plid)
 				continue;
-			blkiop->ops.blkio_unlink_group_fn(key, blkg);
+			/* CFQ without group scheduling registers no ops */
+			if (blkiop->ops.blkio_unlink_group_fn)
+				blkiop->ops.blkio_unlink_group_fn(key, blkg);
 		}
 		spin_unlock(&blkio_list_lock);
 	} while (1);
@@ -645,6 +645,10 @@ blk_init_allocated_queue(struct request_queue *q, request_fn_proc *rfn,
 	 */
 	if (!elevator_init(q, NULL)) {
 		blk_queue_congestion_threshold(q);
+		/* Not fatal, the queue just goes unthrottled */
+		wbt_init(q);
+		/* Nor this, discards are then issued as they come */
+		blk_discard_init(q);
 		return q;
 	}
 
@@ -1156,6 +1160,7 @@ void __blk_put_request(struct request_queue *q, struct request *req)
 		return;
 
 	elv_completed_request(q, req);
+	wbt_done(q, req);
 
 	/* this is a bio leak */
 	WARN_ON(req->bio != NULL);
@@ -1353,6 +1358,10 @@ void blk_queue_bio(struct request_queue *q, struct bio *bio)
 	 */
 	blk_queue_bounce(q, &bio);
 
+	/* Deferred discards are kept, writes into them trim them */
+	if (blk_discard_bio(q, bio))
+		return;
+
 	if (bio->bi_rw & (REQ_FLUSH | REQ_FUA)) {
 		spin_lock_irq(q->queue_lock);
 		where = ELEVATOR_INSERT_FLUSH;
@@ -1395,12 +1404,18 @@ get_rq:
 	if (sync)
 		rw_flags |= REQ_SYNC;
 
+	/* Might sleep, with the queue unlocked */
+	if (wbt_wait(q, bio))
+		rw_flags |= REQ_WBT;
+
 	/*
 	 * Grab a free request. This is might sleep but can not fail.
 	 * Returns with the queue unlocked.
 	 */
 	req = get_request_wait(q, rw_flags, bio);
 	if (unlikely(!req)) {
+		if (rw_flags & REQ_WBT)
+			wbt_cancel(q);
 		bio_endio(bio, -ENODEV);	/* @q is dead */
 		goto out_unlock;
 	}
@@ -2081,6 +2096,8 @@ void blk_start_request(struct request *req)
 
 	BUG_ON(test_bit(REQ_ATOM_COMPLETE, &req->atomic_flags));
 	blk_add_timer(req);
+	wbt_issue(req->q, req);
+	blk_ra_issue(req);
 }
 EXPORT_SYMBOL(blk_start_request);
 
@@ -2341,6 +2358,8 @@ static void blk_finish_request(struct request *req, int error)
 
 
 	blk_account_io_done(req);
+	if (!error)
+		blk_ra_done(req);
 
 	if (req->end_io)
 		req->end_io(req, error);
@@ -0,0 +1,490 @@
+/*
+ * Deferred discards, merged and issued while the device is idle
+ *
+ * Online discard in ext4 and f2fs turns every deletion into discards of
+ * a few blocks each. A discard is slow on eMMC and the filesystem waits
+ * for it, so deleting a large file holds up the journal and reads queue
+ * behind the erases. Discards issued with BLKDEV_DISCARD_DEFER are
+ * completed at once instead, and their range is kept on the queue,
+ * merged with the ranges it touches.
+ *
+ * The ranges are issued in sector order, a batch at a time, once no
+ * other I/O has been submitted for the idle time and the driver has
+ * nothing in flight, or at any time while the screen is off. A write
+ * into a range that is still pending first removes that part of it, the
+ * blocks may have been reused by then, and a write into the span of the
+ * batch being issued waits for that batch to complete.
+ *
+ * The idle time is /sys/block/<dev>/queue/discard_idle_ms, 0 stops the
+ * deferring. The bytes waiting are /sys/block/<dev>/queue/discard_pending.
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/blkdev.h>
+#include <linux/bio.h>
+#include <linux/fs.h>
+#include <linux/rbtree.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+#include <linux/wait.h>
+#include <linux/completion.h>
+#include <linux/earlysuspend.h>
+
+#include "blk.h"
+
+#define BLK_DISCARD_IDLE_MSEC	1000
+/* Discard bios issued per batch, and the wait before the next one */
+#define BLK_DISCARD_BATCH	32
+#define BLK_DISCARD_RETRY_MSEC	20
+/* Past that many ranges further discards are issued right away */
+#define BLK_DISCARD_MAX_RANGES	4096
+
+struct blk_discard_range {
+	struct rb_node node;
+	sector_t sector;
+	sector_t nr_sects;
+};
+
+struct blk_discard_queue {
+	struct request_queue *q;
+
+	struct rb_root ranges;
+	unsigned int nr_ranges;
+	u64 bytes;
+
+	/* the whole disk, held while ranges are pending */
+	struct block_device *bdev;
+
+	unsigned long last_io;
+	unsigned int idle_ms;
+
+	/* span of the batch being issued, writes into it wait */
+	bool issuing;
+	sector_t issue_start;
+	sector_t issue_end;
+	wait_queue_head_t wait;
+
+	struct delayed_work work;
+};
+
+struct blk_discard_batch {
+	atomic_t done;
+	struct completion *wait;
+};
+
+static bool blk_discard_screen_off;
+
+static inline sector_t range_end(struct blk_discard_range *r)
+{
+	return r->sector + r->nr_sects;
+}
+
+/* Last range starting at or before @sector, or NULL */
+static struct blk_discard_range *
+blk_discard_lookup(struct blk_discard_queue *dq, sector_t sector)
+{
+	struct rb_node *n = dq->ranges.rb_node;
+	struct blk_discard_range *r, *found = NULL;
+
+	while (n) {
+		r = rb_entry(n, struct blk_discard_range, node);
+		if (r->sector <= sector) {
+			found = r;
+			n = n->rb_right;
+		} else {
+			n = n->rb_left;
+		}
+	}
+
+	return found;
+}
+
+static void blk_discard_insert(struct blk_discard_queue *dq,
+			       struct blk_discard_range *new)
+{
+	struct rb_node **p = &dq->ranges.rb_node, *parent = NULL;
+	struct blk_discard_range *r;
+
+	while (*p) {
+		parent = *p;
+		r = rb_entry(parent, struct blk_discard_range, node);
+		if (new->sector < r->sector)
+			p = &parent->rb_left;
+		else
+			p = &parent->rb_right;
+	}
+	rb_link_node(&new->node, parent, p);
+	rb_insert_color(&new->node, &dq->ranges);
+	dq->nr_ranges++;
+}
+
+static void blk_discard_erase(struct blk_discard_queue *dq,
+			      struct blk_discard_range *r)
+{
+	rb_erase(&r->node, &dq->ranges);
+	dq->nr_ranges--;
+	kfree(r);
+}
+
+static inline struct blk_discard_range *
+blk_discard_next(struct blk_discard_range *r)
+{
+	struct rb_node *n = rb_next(&r->node);
+
+	return n ? rb_entry(n, struct blk_discard_range, node) : NULL;
+}
+
+/* Keep @bio's range, returns false if it has to be issued now */
+static bool blk_discard_park(struct blk_discard_queue *dq, struct bio *bio)
+{
+	sector_t sector = bio->bi_sector, end = sector + bio_sectors(bio);
+	struct blk_discard_range *prev, *next, *r;
+
+	if (dq->nr_ranges >= BLK_DISCARD_MAX_RANGES ||
+	    (dq->bdev && dq->bdev != bio->bi_bdev))
+		return false;
+
+	prev = blk_discard_lookup(dq, sector);
+	next = prev ? blk_discard_next(prev) : NULL;
+	if (!prev && !RB_EMPTY_ROOT(&dq->ranges))
+		next = rb_entry(rb_first(&dq->ranges),
+				struct blk_discard_range, node);
+
+	/* Pending ranges never overlap, a discard that would is issued */
+	if ((prev && range_end(prev) > sector) || (next && next->sector < end))
+		return false;
+
+	if (prev && range_end(prev) == sector) {
+		prev->nr_sects += end - sector;
+		if (next && next->sector == end) {
+			prev->nr_sects += next->nr_sects;
+			blk_discard_erase(dq, next);
+		}
+	} else if (next && next->sector == end) {
+		next->sector = sector;
+		next->nr_sects += end - sector;
+	} else {
+		r = kmalloc(sizeof(*r), GFP_ATOMIC);
+		if (!r)
+			return false;
+		r->sector = sector;
+		r->nr_sects = end - sector;
+		blk_discard_insert(dq, r);
+	}
+
+	if (!dq->bdev)
+		dq->bdev = bdgrab(bio->bi_bdev);
+	dq->bytes += bio->bi_size;
+
+	kblockd_schedule_delayed_work(dq->q, &dq->work,
+				      msecs_to_jiffies(dq->idle_ms));
+	return true;
+}
+
+/* Remove the sectors @bio writes from the pending ranges */
+static void blk_discard_trim(struct blk_discard_queue *dq, struct bio *bio)
+{
+	sector_t sector = bio->bi_sector, end = sector + bio_sectors(bio);
+	struct blk_discard_range *r, *next, *tail;
+
+	r = blk_discard_lookup(dq, sector);
+	if (!r && !RB_EMPTY_ROOT(&dq->ranges))
+		r = rb_entry(rb_first(&dq->ranges),
+			     struct blk_discard_range, node);
+
+	for (; r && r->sector < end; r = next) {
+		next = blk_discard_next(r);
+		if (range_end(r) <= sector)
+			continue;
+
+		if (r->sector >= sector && range_end(r) <= end) {
+			dq->bytes -= (u64)r->nr_sects << 9;
+			blk_discard_erase(dq, r);
+		} else if (r->sector < sector && range_end(r) > end) {
+			/* Split, or lose the tail if that fails */
+			tail = kmalloc(sizeof(*tail), GFP_ATOMIC);
+			if (tail) {
+				tail->sector = end;
+				tail->nr_sects = range_end(r) - end;
+				blk_discard_insert(dq, tail);
+				dq->bytes -= (u64)(end - sector) << 9;
+			} else {
+				dq->bytes -= (u64)(range_end(r) - sector) << 9;
+			}
+			r->nr_sects = sector - r->sector;
+		} else if (r->sector < sector) {
+			dq->bytes -= (u64)(range_end(r) - sector) << 9;
+			r->nr_sects = sector - r->sector;
+		} else {
+			dq->bytes -= (u64)(end - r->sector) << 9;
+			r->nr_sects = range_end(r) - end;
+			r->sector = end;
+		}
+	}
+}
+
+/**
+ * blk_discard_bio - look at a bio before it is queued
+ * @q: the queue
+ * @bio: the bio
+ *
+ * Returns true if @bio is a deferred discard that has been kept, it is
+ * completed then. Called without the queue lock, a write may wait.
+ */
+bool blk_discard_bio(struct request_queue *q, struct bio *bio)
+{
+	struct blk_discard_queue *dq = q->discard_q;
+	sector_t sector = bio->bi_sector, end = sector + bio_sectors(bio);
+	DEFINE_WAIT(wait);
+	bool parked;
+
+	if (!dq)
+		return false;
+
+	if (!(bio->bi_rw & REQ_DISCARD)) {
+		dq->last_io = jiffies;
+		if (!(bio->bi_rw & REQ_WRITE) || !bio_sectors(bio))
+			return false;
+
+		spin_lock_irq(q->queue_lock);
+		while (dq->issuing && sector < dq->issue_end &&
+		       end > dq->issue_start) {
+			prepare_to_wait(&dq->wait, &wait, TASK_UNINTERRUPTIBLE);
+			spin_unlock_irq(q->queue_lock);
+			io_schedule();
+			spin_lock_irq(q->queue_lock);
+		}
+		finish_wait(&dq->wait, &wait);
+		blk_discard_trim(dq, bio);
+		spin_unlock_irq(q->queue_lock);
+		return false;
+	}
+
+	if (!bio_flagged(bio, BIO_DISCARD_DEFER) ||
+	    (bio->bi_rw & REQ_SECURE) || !dq->idle_ms)
+		return false;
+
+	spin_lock_irq(q->queue_lock);
+	parked = blk_discard_park(dq, bio);
+	spin_unlock_irq(q->queue_lock);
+
+	if (parked)
+		bio_endio(bio, 0);
+	return parked;
+}
+
+static void blk_discard_end_io(struct bio *bio, int err)
+{
+	struct blk_discard_batch *b = bio->bi_private;
+
+	if (atomic_dec_and_test(&b->done))
+		complete(b->wait);
+	bio_put(bio);
+}
+
+static void blk_discard_issue(struct request_queue *q,
+			      struct block_device *bdev,
+			      struct blk_discard_batch *b,
+			      sector_t sector, sector_t nr_sects)
+{
+	unsigned int max_sects;
+	struct bio *bio;
+
+	max_sects = min(q->limits.max_discard_sectors, UINT_MAX >> 9);
+	if (q->limits.discard_granularity)
+		max_sects &= ~((q->limits.discard_granularity >> 9) - 1);
+	if (!max_sects)
+		return;
+
+	while (nr_sects) {
+		bio = bio_alloc(GFP_NOIO, 1);
+		if (!bio)
+			return;
+
+		bio->bi_sector = sector;
+		bio->bi_size = min_t(sector_t, nr_sects, max_sects) << 9;
+		bio->bi_bdev = bdev;
+		bio->bi_rw = REQ_WRITE | REQ_DISCARD;
+		bio->bi_end_io = blk_discard_end_io;
+		bio->bi_private = b;
+
+		sector += bio_sectors(bio);
+		nr_sects -= bio_sectors(bio);
+
+		/* Already remapped to the whole disk, skip the checks */
+		atomic_inc(&b->done);
+		q->make_request_fn(q, bio);
+	}
+}
+
+static void blk_discard_work_fn(struct work_struct *work)
+{
+	struct blk_discard_queue *dq =
+		container_of(work, struct blk_discard_queue, work.work);
+	struct request_queue *q = dq->q;
+	struct {
+		sector_t sector;
+		sector_t nr_sects;
+	} batch[BLK_DISCARD_BATCH];
+	struct blk_discard_range *r;
+	struct block_device *bdev, *put = NULL;
+	DECLARE_COMPLETION_ONSTACK(done);
+	struct blk_discard_batch b;
+	unsigned long idle, delay;
+	int i, n = 0;
+
+	spin_lock_irq(q->queue_lock);
+
+	/* Requeued while a batch is issued, that one carries on */
+	if (dq->issuing) {
+		spin_unlock_irq(q->queue_lock);
+		return;
+	}
+
+	idle = msecs_to_jiffies(dq->idle_ms);
+	if (dq->idle_ms && !blk_discard_screen_off &&
+	    (time_before(jiffies, dq->last_io + idle) || queue_in_flight(q))) {
+		delay = time_before(jiffies, dq->last_io + idle) ?
+			dq->last_io + idle - jiffies : idle;
+		goto out_resched;
+	}
+
+	while (n < BLK_DISCARD_BATCH && !RB_EMPTY_ROOT(&dq->ranges)) {
+		r = rb_entry(rb_first(&dq->ranges),
+			     struct blk_discard_range, node);
+		batch[n].sector = r->sector;
+		batch[n++].nr_sects = r->nr_sects;
+		dq->bytes -= (u64)r->nr_sects << 9;
+		blk_discard_erase(dq, r);
+	}
+
+	bdev = dq->bdev;
+	if (RB_EMPTY_ROOT(&dq->ranges)) {
+		put = dq->bdev;
+		dq->bdev = NULL;
+	}
+	if (n) {
+		dq->issuing = true;
+		dq->issue_start = batch[0].sector;
+		dq->issue_end = batch[n - 1].sector + batch[n - 1].nr_sects;
+	}
+	delay = msecs_to_jiffies(BLK_DISCARD_RETRY_MSEC);
+	spin_unlock_irq(q->queue_lock);
+
+	atomic_set(&b.done, 1);
+	b.wait = &done;
+
+	/* Not open any more, the discards have nobody to serve */
+	if (bdev && bdev->bd_disk)
+		for (i = 0; i < n; i++)
+			blk_discard_issue(q, bdev, &b, batch[i].sector,
+					  batch[i].nr_sects);
+
+	if (!atomic_dec_and_test(&b.done))
+		wait_for_completion(&done);
+
+	spin_lock_irq(q->queue_lock);
+	dq->issuing = false;
+	wake_up_all(&dq->wait);
+out_resched:
+	if (!RB_EMPTY_ROOT(&dq->ranges))
+		kblockd_schedule_delayed_work(q, &dq->work, delay);
+	spin_unlock_irq(q->queue_lock);
+
+	if (put)
+		bdput(put);
+}
+
+unsigned int blk_discard_idle_ms(struct request_queue *q)
+{
+	return q->discard_q ? q->discard_q->idle_ms : 0;
+}
+
+int blk_discard_set_idle_ms(struct request_queue *q, unsigned int msecs)
+{
+	struct blk_discard_queue *dq = q->discard_q;
+
+	if (!dq)
+		return -EINVAL;
+
+	spin_lock_irq(q->queue_lock);
+	dq->idle_ms = msecs;
+	/* Without deferring, issue what is pending */
+	if (!msecs && !RB_EMPTY_ROOT(&dq->ranges)) {
+		cancel_delayed_work(&dq->work);
+		kblockd_schedule_delayed_work(q, &dq->work, 0);
+	}
+	spin_unlock_irq(q->queue_lock);
+
+	return 0;
+}
+
+u64 blk_discard_pending(struct request_queue *q)
+{
+	return q->discard_q ? q->discard_q->bytes : 0;
+}
+
+int blk_discard_init(struct request_queue *q)
+{
+	struct blk_discard_queue *dq;
+
+	dq = kzalloc_node(sizeof(*dq), GFP_KERNEL, q->node);
+	if (!dq)
+		return -ENOMEM;
+
+	dq->q = q;
+	dq->ranges = RB_ROOT;
+	dq->idle_ms = BLK_DISCARD_IDLE_MSEC;
+	dq->last_io = jiffies;
+	init_waitqueue_head(&dq->wait);
+	INIT_DELAYED_WORK(&dq->work, blk_discard_work_fn);
+
+	q->discard_q = dq;
+	return 0;
+}
+
+void blk_discard_exit(struct request_queue *q)
+{
+	struct blk_discard_queue *dq = q->discard_q;
+	struct blk_discard_range *r;
+
+	if (!dq)
+		return;
+
+	cancel_delayed_work_sync(&dq->work);
+	/* The queue is gone, the pending discards are dropped */
+	while (!RB_EMPTY_ROOT(&dq->ranges)) {
+		r = rb_entry(rb_first(&dq->ranges),
+			     struct blk_discard_range, node);
+		blk_discard_erase(dq, r);
+	}
+	if (dq->bdev)
+		bdput(dq->bdev);
+
+	q->discard_q = NULL;
+	kfree(dq);
+}
+
+#ifdef CONFIG_HAS_EARLYSUSPEND
+static void blk_discard_early_suspend(struct early_suspend *h)
+{
+	blk_discard_screen_off = true;
+}
+
+static void blk_discard_late_resume(struct early_suspend *h)
+{
+	blk_discard_screen_off = false;
+}
+
+static struct early_suspend blk_discard_suspend = {
+	.suspend = blk_discard_early_suspend,
+	.resume = blk_discard_late_resume,
+};
+
+static int __init blk_discard_setup(void)
+{
+	register_early_suspend(&blk_discard_suspend);
+	return 0;
+}
+late_initcall(blk_discard_setup);
+#endif
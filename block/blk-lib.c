@@ -35,7 +35,9 @@ static void bio_batch_end_io(struct bio *bio, int err)
  * @flags:	BLKDEV_IFL_* flags to control behaviour
  *
  * Description:
- *    Issue a discard request for the sectors in question.
+ *    Issue a discard request for the sectors in question. With
+ *    BLKDEV_DISCARD_DEFER the queue may complete it at once and issue it
+ *    later, when the device is idle.
  */
 int blkdev_issue_discard(struct block_device *bdev, sector_t sector,
 		sector_t nr_sects, gfp_t gfp_mask, unsigned long flags)
@@ -89,6 +91,8 @@ int blkdev_issue_discard(struct block_device *bdev, sector_t sector,
 		bio->bi_end_io = bio_batch_end_io;
 		bio->bi_bdev = bdev;
 		bio->bi_private = &bb;
+		if (flags & BLKDEV_DISCARD_DEFER)
+			bio->bi_flags |= 1 << BIO_DISCARD_DEFER;
 
 		if (nr_sects > max_discard_sectors) {
 			bio->bi_size = max_discard_sectors << 9;
@@ -0,0 +1,69 @@
+/*
+ * Readahead adapted to the read latency of the device
+ *
+ * The cost of a read request differs a lot between devices: an eMMC
+ * reads a large request about as fast as a small one, an SD card pays
+ * for every byte. The time from dispatch to completion of the reads of a
+ * queue is averaged together with their size, and the readahead window of
+ * the bdi is scaled so that one window takes about the target time to
+ * read, between 1/8 and 4 times read_ahead_kb.
+ *
+ * The target is /sys/class/bdi/<bdi>/ra_target_usec, 0 disables the
+ * scaling. The resulting window is /sys/class/bdi/<bdi>/ra_window_kb.
+ */
+#include <linux/kernel.h>
+#include <linux/blkdev.h>
+#include <linux/backing-dev.h>
+#include <linux/ktime.h>
+
+#include "blk.h"
+
+/* Weight of a new sample in the averages, 1/2^shift */
+#define RA_AVG_SHIFT	3
+
+void blk_ra_issue(struct request *rq)
+{
+	if (rq->cmd_type == REQ_TYPE_FS && !(rq->cmd_flags & REQ_WRITE)) {
+		rq->ra_issue_ns = ktime_to_ns(ktime_get());
+		rq->ra_bytes = blk_rq_bytes(rq);
+	}
+}
+
+static unsigned long ra_avg(unsigned long avg, unsigned long sample)
+{
+	if (!avg)
+		return sample;
+	return avg - (avg >> RA_AVG_SHIFT) + (sample >> RA_AVG_SHIFT);
+}
+
+/* Called when @rq is completed, with the queue lock held */
+void blk_ra_done(struct request *rq)
+{
+	struct backing_dev_info *bdi = &rq->q->backing_dev_info;
+	unsigned int target = ACCESS_ONCE(bdi->ra_target_usec);
+	unsigned long ra_pages = ACCESS_ONCE(bdi->ra_pages);
+	u64 ns, window;
+
+	if (!rq->ra_issue_ns || !rq->ra_bytes)
+		return;
+
+	if (!target || !ra_pages) {
+		bdi->ra_scale = BDI_RA_SCALE_ONE;
+		return;
+	}
+
+	/* The averages are kept in 32 bits, more than 4s is an error anyway */
+	ns = ktime_to_ns(ktime_get()) - rq->ra_issue_ns;
+	bdi->ra_avg_ns = ra_avg(bdi->ra_avg_ns, min_t(u64, ns, UINT_MAX));
+	bdi->ra_avg_bytes = ra_avg(bdi->ra_avg_bytes, rq->ra_bytes);
+	if (!bdi->ra_avg_ns)
+		return;
+
+	/* Pages the device reads in the target time */
+	window = div_u64((u64)bdi->ra_avg_bytes * target * NSEC_PER_USEC,
+			 bdi->ra_avg_ns) >> PAGE_CACHE_SHIFT;
+
+	window = div_u64(window << BDI_RA_SCALE_SHIFT, ra_pages);
+	bdi->ra_scale = clamp_t(u64, window, BDI_RA_SCALE_ONE / 8,
+				BDI_RA_SCALE_ONE * 4);
+}
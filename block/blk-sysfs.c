@@ -275,6 +275,57 @@ queue_rq_affinity_store(struct request_queue *q, const char *page, size_t count)
 	return ret;
 }
 
+#ifdef CONFIG_BLK_WBT
+static ssize_t queue_wbt_lat_show(struct request_queue *q, char *page)
+{
+	return queue_var_show(wbt_lat_usec(q), page);
+}
+
+static ssize_t
+queue_wbt_lat_store(struct request_queue *q, const char *page, size_t count)
+{
+	unsigned long val;
+	ssize_t ret;
+	int err;
+
+	ret = queue_var_store(&val, page, count);
+	err = wbt_set_lat_usec(q, min(val, (unsigned long)UINT_MAX));
+	if (err)
+		return err;
+
+	return ret;
+}
+#endif
+
+#ifdef CONFIG_BLK_DISCARD_QUEUE
+static ssize_t queue_discard_idle_show(struct request_queue *q, char *page)
+{
+	return queue_var_show(blk_discard_idle_ms(q), page);
+}
+
+static ssize_t
+queue_discard_idle_store(struct request_queue *q, const char *page,
+			 size_t count)
+{
+	unsigned long val;
+	ssize_t ret;
+	int err;
+
+	ret = queue_var_store(&val, page, count);
+	err = blk_discard_set_idle_ms(q, min(val, (unsigned long)UINT_MAX));
+	if (err)
+		return err;
+
+	return ret;
+}
+
+static ssize_t queue_discard_pending_show(struct request_queue *q, char *page)
+{
+	return sprintf(page, "%llu\n",
+		       (unsigned long long)blk_discard_pending(q));
+}
+#endif
+
 static struct queue_sysfs_entry queue_requests_entry = {
 	.attr = {.name = "nr_requests", .mode = S_IRUGO | S_IWUSR },
 	.show = queue_requests_show,
@@ -389,6 +440,27 @@ static struct queue_sysfs_entry queue_random_entry = {
 	.store = queue_store_random,
 };
 
+#ifdef CONFIG_BLK_WBT
+static struct queue_sysfs_entry queue_wbt_lat_entry = {
+	.attr = {.name = "wbt_lat_usec", .mode = S_IRUGO | S_IWUSR },
+	.show = queue_wbt_lat_show,
+	.store = queue_wbt_lat_store,
+};
+#endif
+
+#ifdef CONFIG_BLK_DISCARD_QUEUE
+static struct queue_sysfs_entry queue_discard_idle_entry = {
+	.attr = {.name = "discard_idle_ms", .mode = S_IRUGO | S_IWUSR },
+	.show = queue_discard_idle_show,
+	.store = queue_discard_idle_store,
+};
+
+static struct queue_sysfs_entry queue_discard_pending_entry = {
+	.attr = {.name = "discard_pending", .mode = S_IRUGO },
+	.show = queue_discard_pending_show,
+};
+#endif
+
 static struct attribute *default_attrs[] = {
 	&queue_requests_entry.attr,
 	&queue_ra_entry.attr,
@@ -411,6 +483,13 @@ static struct attribute *default_attrs[] = {
 	&queue_rq_affinity_entry.attr,
 	&queue_iostats_entry.attr,
 	&queue_random_entry.attr,
+#ifdef CONFIG_BLK_WBT
+	&queue_wbt_lat_entry.attr,
+#endif
+#ifdef CONFIG_BLK_DISCARD_QUEUE
+	&queue_discard_idle_entry.attr,
+	&queue_discard_pending_entry.attr,
+#endif
 	NULL,
 };
 
@@ -489,6 +568,8 @@ static void blk_release_queue(struct kobject *kobj)
 	}
 
 	blk_throtl_exit(q);
+	wbt_exit(q);
+	blk_discard_exit(q);
 
 	if (rl->rq_pool)
 		mempool_destroy(rl->rq_pool);
@@ -0,0 +1,251 @@
+/*
+ * Writeback throttling, based on the completion latency of reads
+ *
+ * Background writeback can fill the device queue and keep it full for
+ * seconds, reads then wait behind it. The number of background writes
+ * allocated on a queue is limited to a depth that is halved every window
+ * in which the fastest read took longer than the latency target, and
+ * doubled back every window in which reads were fast, or there were none.
+ *
+ * Background writes are plain async writes, sync writes (O_DIRECT, fsync,
+ * integrity writeback in most filesystems) are never held back. This runs
+ * under the queue lock and does not depend on the I/O scheduler.
+ *
+ * The latency target is /sys/block/<dev>/queue/wbt_lat_usec, 0 disables
+ * the throttling. The current depth is /sys/class/bdi/<bdi>/wb_depth.
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/blkdev.h>
+#include <linux/slab.h>
+#include <linux/timer.h>
+#include <linux/wait.h>
+#include <linux/ktime.h>
+
+#include "blk.h"
+
+/* Window over which the read latency is looked at */
+#define WBT_WINDOW_MSEC		100
+#define WBT_DEFAULT_LAT_USEC	2000
+
+struct rq_wb {
+	struct request_queue *q;
+
+	/* background writes allocated and not freed yet */
+	unsigned int inflight;
+	unsigned int max_depth;
+	unsigned int depth;
+	unsigned int scale_step;
+
+	u64 lat_target_ns;
+
+	/* reads completed in the current window */
+	unsigned int nr_reads;
+	u64 min_lat_ns;
+
+	struct timer_list window_timer;
+	wait_queue_head_t wait;
+};
+
+static inline bool wbt_should_track(struct bio *bio)
+{
+	const unsigned long rw = bio->bi_rw;
+
+	return (rw & REQ_WRITE) &&
+		!(rw & (REQ_SYNC | REQ_META | REQ_FLUSH | REQ_FUA | REQ_DISCARD));
+}
+
+static void wbt_calc_depth(struct rq_wb *rwb)
+{
+	struct request_queue *q = rwb->q;
+
+	/* a quarter of the queue, like the async share of the congestion */
+	rwb->max_depth = max(q->nr_requests / 4, 1UL);
+	rwb->depth = max(rwb->max_depth >> rwb->scale_step, 1U);
+
+	q->backing_dev_info.wb_depth = rwb->lat_target_ns ? rwb->depth : 0;
+}
+
+static void wbt_reset_window(struct rq_wb *rwb)
+{
+	rwb->nr_reads = 0;
+	rwb->min_lat_ns = ULLONG_MAX;
+}
+
+static inline void wbt_arm_window(struct rq_wb *rwb)
+{
+	if (!timer_pending(&rwb->window_timer))
+		mod_timer(&rwb->window_timer,
+			  jiffies + msecs_to_jiffies(WBT_WINDOW_MSEC));
+}
+
+static void wbt_window_fn(unsigned long data)
+{
+	struct rq_wb *rwb = (struct rq_wb *)data;
+	struct request_queue *q = rwb->q;
+	unsigned int old_depth = rwb->depth;
+	unsigned long flags;
+
+	spin_lock_irqsave(q->queue_lock, flags);
+
+	if (rwb->nr_reads && rwb->min_lat_ns > rwb->lat_target_ns) {
+		if (rwb->depth > 1)
+			rwb->scale_step++;
+	} else if (rwb->scale_step) {
+		rwb->scale_step--;
+	}
+	wbt_calc_depth(rwb);
+	wbt_reset_window(rwb);
+
+	if (rwb->depth > old_depth)
+		wake_up_all(&rwb->wait);
+
+	/* Keep scaling back up once the writes are gone */
+	if (rwb->inflight || rwb->scale_step)
+		wbt_arm_window(rwb);
+
+	spin_unlock_irqrestore(q->queue_lock, flags);
+}
+
+/**
+ * wbt_wait - wait for room for a background write
+ * @q: the queue
+ * @bio: the bio a request is going to be allocated for
+ *
+ * Returns true if @bio is accounted as a background write, its request
+ * then has to be marked with REQ_WBT. Called with the queue lock held,
+ * which is dropped while waiting.
+ */
+bool wbt_wait(struct request_queue *q, struct bio *bio)
+{
+	struct rq_wb *rwb = q->rq_wb;
+	DEFINE_WAIT(wait);
+
+	if (!rwb || !rwb->lat_target_ns || !wbt_should_track(bio))
+		return false;
+
+	wbt_arm_window(rwb);
+
+	while (rwb->inflight >= rwb->depth) {
+		prepare_to_wait_exclusive(&rwb->wait, &wait,
+					  TASK_UNINTERRUPTIBLE);
+		if (rwb->inflight < rwb->depth)
+			break;
+
+		spin_unlock_irq(q->queue_lock);
+		io_schedule();
+		spin_lock_irq(q->queue_lock);
+
+		/* Disabled meanwhile */
+		if (!rwb->lat_target_ns)
+			break;
+	}
+	finish_wait(&rwb->wait, &wait);
+
+	rwb->inflight++;
+	return true;
+}
+
+/**
+ * wbt_cancel - drop the accounting of a background write
+ * @q: the queue
+ *
+ * For a bio accounted by wbt_wait() that got no request. Called with the
+ * queue lock held.
+ */
+void wbt_cancel(struct request_queue *q)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	rwb->inflight--;
+	if (rwb->inflight < rwb->depth)
+		wake_up(&rwb->wait);
+}
+
+void wbt_issue(struct request_queue *q, struct request *rq)
+{
+	if (q->rq_wb && rq->cmd_type == REQ_TYPE_FS &&
+	    !(rq->cmd_flags & REQ_WRITE))
+		rq->wbt_issue_ns = ktime_to_ns(ktime_get());
+}
+
+/* Called when @rq is freed, with the queue lock held */
+void wbt_done(struct request_queue *q, struct request *rq)
+{
+	struct rq_wb *rwb = q->rq_wb;
+	u64 lat;
+
+	if (!rwb)
+		return;
+
+	if (rq->cmd_flags & REQ_WBT) {
+		wbt_cancel(q);
+		return;
+	}
+
+	if (!rq->wbt_issue_ns || !rwb->lat_target_ns)
+		return;
+
+	lat = ktime_to_ns(ktime_get()) - rq->wbt_issue_ns;
+	rwb->nr_reads++;
+	if (lat < rwb->min_lat_ns)
+		rwb->min_lat_ns = lat;
+}
+
+unsigned int wbt_lat_usec(struct request_queue *q)
+{
+	if (!q->rq_wb)
+		return 0;
+
+	return div_u64(q->rq_wb->lat_target_ns, NSEC_PER_USEC);
+}
+
+int wbt_set_lat_usec(struct request_queue *q, unsigned int usec)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	if (!rwb)
+		return -EINVAL;
+
+	spin_lock_irq(q->queue_lock);
+	rwb->lat_target_ns = (u64)usec * NSEC_PER_USEC;
+	if (!usec)
+		rwb->scale_step = 0;
+	wbt_calc_depth(rwb);
+	wbt_reset_window(rwb);
+	wake_up_all(&rwb->wait);
+	spin_unlock_irq(q->queue_lock);
+
+	return 0;
+}
+
+int wbt_init(struct request_queue *q)
+{
+	struct rq_wb *rwb;
+
+	rwb = kzalloc_node(sizeof(*rwb), GFP_KERNEL, q->node);
+	if (!rwb)
+		return -ENOMEM;
+
+	rwb->q = q;
+	rwb->lat_target_ns = WBT_DEFAULT_LAT_USEC * NSEC_PER_USEC;
+	init_waitqueue_head(&rwb->wait);
+	setup_timer(&rwb->window_timer, wbt_window_fn, (unsigned long)rwb);
+	wbt_reset_window(rwb);
+	wbt_calc_depth(rwb);
+
+	q->rq_wb = rwb;
+	return 0;
+}
+
+void wbt_exit(struct request_queue *q)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	if (!rwb)
+		return;
+
+	del_timer_sync(&rwb->window_timer);
+	q->rq_wb = NULL;
+	kfree(rwb);
+}
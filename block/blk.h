@@ -234,4 +234,56 @@ static inline void blk_throtl_exit(struct request_queue *q) { }
 static inline void blk_throtl_release(struct request_queue *q) { }
 #endif /* CONFIG_BLK_DEV_THROTTLING */
 
+/*
+ * Writeback throttling
+ */
+#ifdef CONFIG_BLK_WBT
+extern bool wbt_wait(struct request_queue *q, struct bio *bio);
+extern void wbt_cancel(struct request_queue *q);
+extern void wbt_issue(struct request_queue *q, struct request *rq);
+extern void wbt_done(struct request_queue *q, struct request *rq);
+extern unsigned int wbt_lat_usec(struct request_queue *q);
+extern int wbt_set_lat_usec(struct request_queue *q, unsigned int usec);
+extern int wbt_init(struct request_queue *q);
+extern void wbt_exit(struct request_queue *q);
+#else /* CONFIG_BLK_WBT */
+static inline bool wbt_wait(struct request_queue *q, struct bio *bio)
+{
+	return false;
+}
+static inline void wbt_cancel(struct request_queue *q) { }
+static inline void wbt_issue(struct request_queue *q, struct request *rq) { }
+static inline void wbt_done(struct request_queue *q, struct request *rq) { }
+static inline int wbt_init(struct request_queue *q) { return 0; }
+static inline void wbt_exit(struct request_queue *q) { }
+#endif /* CONFIG_BLK_WBT */
+
+/*
+ * Deferred discards
+ */
+#ifdef CONFIG_BLK_DISCARD_QUEUE
+extern bool blk_discard_bio(struct request_queue *q, struct bio *bio);
+extern unsigned int blk_discard_idle_ms(struct request_queue *q);
+extern int blk_discard_set_idle_ms(struct request_queue *q,
+				   unsigned int msecs);
+extern u64 blk_discard_pending(struct request_queue *q);
+extern int blk_discard_init(struct request_queue *q);
+extern void blk_discard_exit(struct request_queue *q);
+#else /* CONFIG_BLK_DISCARD_QUEUE */
+static inline bool blk_discard_bio(struct request_queue *q, struct bio *bio)
+{
+	return false;
+}
+static inline int blk_discard_init(struct request_queue *q) { return 0; }
+static inline void blk_discard_exit(struct request_queue *q) { }
+#endif /* CONFIG_BLK_DISCARD_QUEUE */
+
+#ifdef CONFIG_BLK_RA_ADAPT
+extern void blk_ra_issue(struct request *rq);
+extern void blk_ra_done(struct request *rq);
+#else
+static inline void blk_ra_issue(struct request *rq) { }
+static inline void blk_ra_done(struct request *rq) { }
+#endif
+
 #endif /* BLK_INTERNAL_H */
@@ -11,7 +11,10 @@
 #include <linux/rbtree.h>
 #include <linux/ioprio.h>
 #include <linux/blktrace_api.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
 #include "blk.h"
+#include "blk-cgroup.h"
 
 #define VIOS_SCALE_SHIFT 10
 #define VIOS_SCALE (1 << VIOS_SCALE_SHIFT)
@@ -23,6 +26,15 @@
 
 #define VIOS_PRIO_SCALE (5)
 
+/* Idle window for sequential sync readers, in us */
+#define FIOPS_SLICE_IDLE (500)
+/* A request further than this from the previous one is a seek, in sectors */
+#define FIOPS_SEEK_THR (8 * 100)
+/* Don't idle for an ioc that is this far ahead of the others */
+#define FIOPS_IDLE_VIOS (16 * VIOS_SCALE)
+
+#define ttime_sample_valid(samples)	((samples) > 80)
+
 struct fiops_rb_root {
 	struct rb_root rb;
 	struct rb_node *left;
@@ -39,20 +51,54 @@ enum wl_prio_t {
 	FIOPS_PRIO_NR,
 };
 
+/*
+ * A group of iocs, one per blkio cgroup. Groups are served in the order of
+ * their vios, which are charged in inverse proportion to their weight.
+ */
+struct fiops_group {
+	struct blkio_group blkg;
+
+	struct fiops_rb_root service_tree[FIOPS_PRIO_NR];
+
+	struct rb_node rb_node;
+	u64 vios; /* key in grp_service_tree */
+	unsigned int busy_queues;
+
+	unsigned int weight;
+	unsigned int new_weight;
+	bool needs_update;
+#ifdef CONFIG_FIOPS_GROUP_IOSCHED
+	int ref;
+	struct hlist_node fiopsd_node;
+#endif
+};
+
 struct fiops_data {
 	struct request_queue *queue;
 
-	struct fiops_rb_root service_tree[FIOPS_PRIO_NR];
+	struct fiops_rb_root grp_service_tree;
+	struct fiops_group root_group;
+#ifdef CONFIG_FIOPS_GROUP_IOSCHED
+	struct hlist_head group_list;
+	/* Number of groups which are on blkcg->blkg_list */
+	unsigned int nr_blkcg_linked_grps;
+#endif
 
 	unsigned int busy_queues;
 	unsigned int in_flight[2];
 
 	struct work_struct unplug_work;
 
+	/* ioc whose next request is waited for, until idle_until */
+	struct fiops_ioc *idle_ioc;
+	u64 idle_until;
+	struct hrtimer idle_timer;
+
 	unsigned int read_scale;
 	unsigned int write_scale;
 	unsigned int sync_scale;
 	unsigned int async_scale;
+	unsigned int slice_idle;
 };
 
 struct fiops_ioc {
@@ -63,9 +109,18 @@ struct fiops_ioc {
 	struct rb_node rb_node;
 	u64 vios; /* key in service_tree */
 	struct fiops_rb_root *service_tree;
+	struct fiops_group *fiopsg;
 
 	unsigned int in_flight;
 
+	/* think time, in us, and position of the last sync request */
+	u64 last_end_request;
+	unsigned int ttime_total;
+	unsigned int ttime_samples;
+	unsigned int ttime_mean;
+	sector_t last_request_pos;
+	u32 seek_history;
+
 	struct rb_root sort_list;
 	struct list_head fifo;
 
@@ -74,12 +129,13 @@ struct fiops_ioc {
 	enum wl_prio_t wl_type;
 };
 
-#define ioc_service_tree(ioc) (&((ioc)->fiopsd->service_tree[(ioc)->wl_type]))
+#define ioc_service_tree(ioc) (&((ioc)->fiopsg->service_tree[(ioc)->wl_type]))
 #define RQ_CIC(rq)		icq_to_cic((rq)->elv.icq)
 
 enum ioc_state_flags {
 	FIOPS_IOC_FLAG_on_rr = 0,	/* on round-robin busy list */
 	FIOPS_IOC_FLAG_prio_changed,	/* task priority has changed */
+	FIOPS_IOC_FLAG_cgroup_changed,	/* task moved to another cgroup */
 };
 
 #define FIOPS_IOC_FNS(name)						\
@@ -98,6 +154,7 @@ static inline int fiops_ioc_##name(const struct fiops_ioc *ioc)	\
 
 FIOPS_IOC_FNS(on_rr);
 FIOPS_IOC_FNS(prio_changed);
+FIOPS_IOC_FNS(cgroup_changed);
 #undef FIOPS_IOC_FNS
 
 #define fiops_log_ioc(fiopsd, ioc, fmt, args...)	\
@@ -128,6 +185,307 @@ static inline struct fiops_ioc *fiops_cic_lookup(struct fiops_data *fiopsd,
 	return NULL;
 }
 
+static void fiops_init_group(struct fiops_group *fiopsg)
+{
+	int i;
+
+	for (i = IDLE_WORKLOAD; i <= RT_WORKLOAD; i++)
+		fiopsg->service_tree[i] = FIOPS_RB_ROOT;
+	RB_CLEAR_NODE(&fiopsg->rb_node);
+	fiopsg->weight = BLKIO_WEIGHT_DEFAULT;
+}
+
+#ifdef CONFIG_FIOPS_GROUP_IOSCHED
+static inline struct fiops_group *fiops_group_of_blkg(struct blkio_group *blkg)
+{
+	if (blkg)
+		return container_of(blkg, struct fiops_group, blkg);
+	return NULL;
+}
+
+static inline void fiops_blkiocg_update_io_add_stats(struct request *rq)
+{
+	blkiocg_update_io_add_stats(&RQ_CIC(rq)->fiopsg->blkg, NULL,
+			rq_data_dir(rq), rq_is_sync(rq));
+}
+
+static inline void fiops_blkiocg_update_io_remove_stats(struct request *rq)
+{
+	blkiocg_update_io_remove_stats(&RQ_CIC(rq)->fiopsg->blkg,
+			rq_data_dir(rq), rq_is_sync(rq));
+}
+
+static inline void fiops_blkiocg_update_io_merged_stats(struct request *rq,
+	int rw)
+{
+	blkiocg_update_io_merged_stats(&RQ_CIC(rq)->fiopsg->blkg,
+			rw & REQ_WRITE, rw & REQ_SYNC);
+}
+
+static inline void fiops_blkiocg_update_dispatch_stats(struct request *rq)
+{
+	blkiocg_update_dispatch_stats(&RQ_CIC(rq)->fiopsg->blkg,
+			blk_rq_bytes(rq), rq_data_dir(rq), rq_is_sync(rq));
+}
+
+static inline void fiops_blkiocg_update_completion_stats(struct request *rq)
+{
+	blkiocg_update_completion_stats(&RQ_CIC(rq)->fiopsg->blkg,
+			rq_start_time_ns(rq), rq_io_start_time_ns(rq),
+			rq_data_dir(rq), rq_is_sync(rq));
+}
+
+static void fiops_update_blkio_group_weight(void *key,
+	struct blkio_group *blkg, unsigned int weight)
+{
+	struct fiops_group *fiopsg = fiops_group_of_blkg(blkg);
+
+	fiopsg->new_weight = weight;
+	fiopsg->needs_update = true;
+}
+
+static void fiops_init_add_group_lists(struct fiops_data *fiopsd,
+	struct fiops_group *fiopsg, struct blkio_cgroup *blkcg)
+{
+	struct backing_dev_info *bdi = &fiopsd->queue->backing_dev_info;
+	unsigned int major, minor;
+
+	/* bdi->dev may not be set yet, find_group fills it in later */
+	if (bdi->dev) {
+		sscanf(dev_name(bdi->dev), "%u:%u", &major, &minor);
+		blkiocg_add_blkio_group(blkcg, &fiopsg->blkg, fiopsd,
+				MKDEV(major, minor), BLKIO_POLICY_PROP);
+	} else
+		blkiocg_add_blkio_group(blkcg, &fiopsg->blkg, fiopsd, 0,
+				BLKIO_POLICY_PROP);
+
+	fiopsd->nr_blkcg_linked_grps++;
+	fiopsg->weight = blkcg_get_weight(blkcg, fiopsg->blkg.dev);
+
+	hlist_add_head(&fiopsg->fiopsd_node, &fiopsd->group_list);
+}
+
+/* Sleeps, alloc_percpu() of the stats needs it */
+static struct fiops_group *fiops_alloc_group(struct fiops_data *fiopsd,
+	gfp_t gfp_mask)
+{
+	struct fiops_group *fiopsg;
+
+	fiopsg = kzalloc_node(sizeof(*fiopsg), gfp_mask, fiopsd->queue->node);
+	if (!fiopsg)
+		return NULL;
+
+	fiops_init_group(fiopsg);
+
+	/* Dropped by the elevator exit or the cgroup removal, whichever first */
+	fiopsg->ref = 1;
+
+	if (blkio_alloc_blkg_stats(&fiopsg->blkg)) {
+		kfree(fiopsg);
+		return NULL;
+	}
+
+	return fiopsg;
+}
+
+static struct fiops_group *
+fiops_find_group(struct fiops_data *fiopsd, struct blkio_cgroup *blkcg)
+{
+	struct backing_dev_info *bdi = &fiopsd->queue->backing_dev_info;
+	struct fiops_group *fiopsg;
+	unsigned int major, minor;
+
+	if (blkcg == &blkio_root_cgroup)
+		fiopsg = &fiopsd->root_group;
+	else
+		fiopsg = fiops_group_of_blkg(blkiocg_lookup_group(blkcg,
+						fiopsd));
+
+	if (fiopsg && !fiopsg->blkg.dev && bdi->dev && dev_name(bdi->dev)) {
+		sscanf(dev_name(bdi->dev), "%u:%u", &major, &minor);
+		fiopsg->blkg.dev = MKDEV(major, minor);
+	}
+
+	return fiopsg;
+}
+
+/*
+ * Group of the current task, the root group if it cannot be allocated.
+ * Called with the queue lock held, which is dropped to allocate a group if
+ * @gfp_mask allows sleeping.
+ */
+static struct fiops_group *fiops_get_group(struct fiops_data *fiopsd,
+	gfp_t gfp_mask)
+{
+	struct request_queue *q = fiopsd->queue;
+	struct fiops_group *fiopsg, *__fiopsg;
+	struct blkio_cgroup *blkcg;
+
+	rcu_read_lock();
+	blkcg = task_blkio_cgroup(current);
+	fiopsg = fiops_find_group(fiopsd, blkcg);
+	rcu_read_unlock();
+	if (fiopsg)
+		return fiopsg;
+	if (!(gfp_mask & __GFP_WAIT))
+		return &fiopsd->root_group;
+
+	spin_unlock_irq(q->queue_lock);
+	fiopsg = fiops_alloc_group(fiopsd, gfp_mask);
+	spin_lock_irq(q->queue_lock);
+
+	rcu_read_lock();
+	blkcg = task_blkio_cgroup(current);
+
+	/* Somebody else may have added it meanwhile */
+	__fiopsg = fiops_find_group(fiopsd, blkcg);
+	if (__fiopsg) {
+		if (fiopsg) {
+			free_percpu(fiopsg->blkg.stats_cpu);
+			kfree(fiopsg);
+		}
+		fiopsg = __fiopsg;
+	} else if (fiopsg) {
+		fiops_init_add_group_lists(fiopsd, fiopsg, blkcg);
+	} else {
+		fiopsg = &fiopsd->root_group;
+	}
+	rcu_read_unlock();
+
+	return fiopsg;
+}
+
+static inline struct fiops_group *fiops_ref_get_group(struct fiops_group *fiopsg)
+{
+	fiopsg->ref++;
+	return fiopsg;
+}
+
+static void fiops_put_group(struct fiops_group *fiopsg)
+{
+	BUG_ON(fiopsg->ref <= 0);
+	if (--fiopsg->ref)
+		return;
+
+	BUG_ON(fiopsg->busy_queues);
+	free_percpu(fiopsg->blkg.stats_cpu);
+	kfree(fiopsg);
+}
+
+static void fiops_destroy_group(struct fiops_data *fiopsd,
+	struct fiops_group *fiopsg)
+{
+	BUG_ON(hlist_unhashed(&fiopsg->fiopsd_node));
+	hlist_del_init(&fiopsg->fiopsd_node);
+
+	BUG_ON(!fiopsd->nr_blkcg_linked_grps);
+	fiopsd->nr_blkcg_linked_grps--;
+
+	/* The iocs still in the group keep it until they leave */
+	fiops_put_group(fiopsg);
+}
+
+static void fiops_release_groups(struct fiops_data *fiopsd)
+{
+	struct hlist_node *pos, *n;
+	struct fiops_group *fiopsg;
+
+	hlist_for_each_entry_safe(fiopsg, pos, n, &fiopsd->group_list,
+				  fiopsd_node) {
+		/* Or the cgroup removal got to it first and destroys it */
+		if (!blkiocg_del_blkio_group(&fiopsg->blkg))
+			fiops_destroy_group(fiopsd, fiopsg);
+	}
+}
+
+/*
+ * The cgroup of @blkg goes away, no new IO will come to the group. Called
+ * under rcu_read_lock(), which keeps @key valid.
+ */
+static void fiops_unlink_blkio_group(void *key, struct blkio_group *blkg)
+{
+	struct fiops_data *fiopsd = key;
+	unsigned long flags;
+
+	spin_lock_irqsave(fiopsd->queue->queue_lock, flags);
+	fiops_destroy_group(fiopsd, fiops_group_of_blkg(blkg));
+	spin_unlock_irqrestore(fiopsd->queue->queue_lock, flags);
+}
+
+/* Moves an ioc that has nothing queued to the group of its new cgroup */
+static void fiops_changed_cgroup(struct fiops_data *fiopsd,
+	struct fiops_ioc *ioc, gfp_t gfp_mask)
+{
+	struct fiops_group *fiopsg;
+
+	if (fiops_ioc_on_rr(ioc) || ioc->in_flight)
+		return;
+
+	fiopsg = fiops_get_group(fiopsd, gfp_mask);
+	/* The queue lock may have been dropped */
+	if (fiops_ioc_on_rr(ioc) || ioc->in_flight)
+		return;
+
+	fiops_clear_ioc_cgroup_changed(ioc);
+	if (fiopsg == ioc->fiopsg)
+		return;
+
+	fiops_log_ioc(fiopsd, ioc, "changed cgroup");
+	fiops_put_group(ioc->fiopsg);
+	ioc->fiopsg = fiops_ref_get_group(fiopsg);
+	/* Its service within the old group does not count in the new one */
+	ioc->vios = 0;
+}
+
+static int fiops_set_request(struct request_queue *q, struct request *rq,
+	gfp_t gfp_mask)
+{
+	struct fiops_data *fiopsd = q->elevator->elevator_data;
+	struct fiops_ioc *ioc = RQ_CIC(rq);
+	unsigned int changed;
+
+	might_sleep_if(gfp_mask & __GFP_WAIT);
+
+	spin_lock_irq(q->queue_lock);
+
+	changed = icq_get_changed(&ioc->icq);
+	if (unlikely(changed & ICQ_IOPRIO_CHANGED))
+		fiops_mark_ioc_prio_changed(ioc);
+	if (unlikely(changed & ICQ_CGROUP_CHANGED))
+		fiops_mark_ioc_cgroup_changed(ioc);
+
+	if (unlikely(fiops_ioc_cgroup_changed(ioc)))
+		fiops_changed_cgroup(fiopsd, ioc, gfp_mask);
+
+	spin_unlock_irq(q->queue_lock);
+
+	return 0;
+}
+
+static struct blkio_policy_type blkio_policy_fiops = {
+	.ops = {
+		.blkio_unlink_group_fn =	fiops_unlink_blkio_group,
+		.blkio_update_group_weight_fn =	fiops_update_blkio_group_weight,
+	},
+	.plid = BLKIO_POLICY_PROP,
+};
+#else
+static inline void fiops_blkiocg_update_io_add_stats(struct request *rq) {}
+static inline void fiops_blkiocg_update_io_remove_stats(struct request *rq) {}
+static inline void fiops_blkiocg_update_io_merged_stats(struct request *rq,
+	int rw) {}
+static inline void fiops_blkiocg_update_dispatch_stats(struct request *rq) {}
+static inline void fiops_blkiocg_update_completion_stats(struct request *rq) {}
+
+static inline struct fiops_group *fiops_ref_get_group(struct fiops_group *fiopsg)
+{
+	return fiopsg;
+}
+
+static inline void fiops_put_group(struct fiops_group *fiopsg) {}
+static inline void fiops_release_groups(struct fiops_data *fiopsd) {}
+#endif /* CONFIG_FIOPS_GROUP_IOSCHED */
+
 /*
  * The below is leftmost cache rbtree addon
  */
@@ -179,6 +537,109 @@ static void fiops_update_min_vios(struct fiops_rb_root *service_tree)
 	service_tree->min_vios = max_vios(service_tree->min_vios, ioc->vios);
 }
 
+static struct fiops_group *fiops_group_first(struct fiops_rb_root *root)
+{
+	if (!root->count)
+		return NULL;
+
+	if (!root->left)
+		root->left = rb_first(&root->rb);
+
+	if (root->left)
+		return rb_entry(root->left, struct fiops_group, rb_node);
+
+	return NULL;
+}
+
+static void fiops_update_group_min_vios(struct fiops_rb_root *st)
+{
+	struct fiops_group *fiopsg;
+
+	fiopsg = fiops_group_first(st);
+	if (fiopsg)
+		st->min_vios = max_vios(st->min_vios, fiopsg->vios);
+}
+
+static void __fiops_group_service_tree_add(struct fiops_rb_root *st,
+	struct fiops_group *fiopsg)
+{
+	struct rb_node **node = &st->rb.rb_node;
+	struct rb_node *parent = NULL;
+	struct fiops_group *__fiopsg;
+	int left = 1;
+
+	while (*node) {
+		parent = *node;
+		__fiopsg = rb_entry(parent, struct fiops_group, rb_node);
+
+		if ((s64)(fiopsg->vios - __fiopsg->vios) < 0)
+			node = &parent->rb_left;
+		else {
+			node = &parent->rb_right;
+			left = 0;
+		}
+	}
+
+	if (left)
+		st->left = &fiopsg->rb_node;
+
+	rb_link_node(&fiopsg->rb_node, parent, node);
+	rb_insert_color(&fiopsg->rb_node, &st->rb);
+	st->count++;
+}
+
+static void fiops_update_group_weight(struct fiops_group *fiopsg)
+{
+	if (fiopsg->needs_update) {
+		fiopsg->weight = fiopsg->new_weight;
+		fiopsg->needs_update = false;
+	}
+}
+
+/* The group got its first busy ioc */
+static void fiops_group_service_tree_add(struct fiops_data *fiopsd,
+	struct fiops_group *fiopsg)
+{
+	struct fiops_rb_root *st = &fiopsd->grp_service_tree;
+
+	BUG_ON(!RB_EMPTY_NODE(&fiopsg->rb_node));
+
+	/* No credit for the time it was idle */
+	fiopsg->vios = max_vios(st->min_vios, fiopsg->vios);
+	fiops_update_group_weight(fiopsg);
+	__fiops_group_service_tree_add(st, fiopsg);
+	fiops_update_group_min_vios(st);
+}
+
+static void fiops_group_service_tree_del(struct fiops_data *fiopsd,
+	struct fiops_group *fiopsg)
+{
+	struct fiops_rb_root *st = &fiopsd->grp_service_tree;
+
+	if (!RB_EMPTY_NODE(&fiopsg->rb_node))
+		fiops_rb_erase(&fiopsg->rb_node, st);
+	fiops_update_group_min_vios(st);
+}
+
+static void fiops_group_charge_vios(struct fiops_data *fiopsd,
+	struct fiops_group *fiopsg, u64 vios)
+{
+	struct fiops_rb_root *st = &fiopsd->grp_service_tree;
+
+	vios = div_u64(vios * BLKIO_WEIGHT_DEFAULT, fiopsg->weight);
+
+	if (RB_EMPTY_NODE(&fiopsg->rb_node)) {
+		fiopsg->vios += vios;
+		return;
+	}
+
+	fiops_rb_erase(&fiopsg->rb_node, st);
+	fiopsg->vios += vios;
+	fiops_update_group_weight(fiopsg);
+	__fiops_group_service_tree_add(st, fiopsg);
+	fiops_update_group_min_vios(st);
+}
+
 /*
  * The fiopsd->service_trees holds all pending fiops_ioc's that have
  * requests waiting to be processed. It is sorted in the order that
@@ -265,6 +726,8 @@ static void fiops_add_ioc_rr(struct fiops_data *fiopsd, struct fiops_ioc *ioc)
 	fiops_mark_ioc_on_rr(ioc);
 
 	fiopsd->busy_queues++;
+	if (!ioc->fiopsg->busy_queues++)
+		fiops_group_service_tree_add(fiopsd, ioc->fiopsg);
 
 	fiops_resort_rr_list(fiopsd, ioc);
 }
@@ -285,6 +748,9 @@ static void fiops_del_ioc_rr(struct fiops_data *fiopsd, struct fiops_ioc *ioc)
 
 	BUG_ON(!fiopsd->busy_queues);
 	fiopsd->busy_queues--;
+	BUG_ON(!ioc->fiopsg->busy_queues);
+	if (!--ioc->fiopsg->busy_queues)
+		fiops_group_service_tree_del(fiopsd, ioc->fiopsg);
 }
 
 /*
@@ -347,6 +813,8 @@ static u64 fiops_dispatch_request(struct fiops_data *fiopsd,
 
 	fiops_remove_request(rq);
 	elv_dispatch_add_tail(q, rq);
+	fiops_blkiocg_update_io_remove_stats(rq);
+	fiops_blkiocg_update_dispatch_stats(rq);
 
 	fiopsd->in_flight[rq_is_sync(rq)]++;
 	ioc->in_flight++;
@@ -354,22 +822,33 @@ static u64 fiops_dispatch_request(struct fiops_data *fiopsd,
 	return fiops_scaled_vios(fiopsd, ioc, rq);
 }
 
+static void fiops_clear_idle(struct fiops_data *fiopsd)
+{
+	fiopsd->idle_ioc = NULL;
+	hrtimer_try_to_cancel(&fiopsd->idle_timer);
+}
+
 static int fiops_forced_dispatch(struct fiops_data *fiopsd)
 {
+	struct fiops_group *fiopsg;
 	struct fiops_ioc *ioc;
 	int dispatched = 0;
 	int i;
 
-	for (i = RT_WORKLOAD; i >= IDLE_WORKLOAD; i--) {
-		while (!RB_EMPTY_ROOT(&fiopsd->service_tree[i].rb)) {
-			ioc = fiops_rb_first(&fiopsd->service_tree[i]);
+	fiops_clear_idle(fiopsd);
 
-			while (!list_empty(&ioc->fifo)) {
-				fiops_dispatch_request(fiopsd, ioc);
-				dispatched++;
+	while ((fiopsg = fiops_group_first(&fiopsd->grp_service_tree))) {
+		for (i = RT_WORKLOAD; i >= IDLE_WORKLOAD; i--) {
+			while (!RB_EMPTY_ROOT(&fiopsg->service_tree[i].rb)) {
+				ioc = fiops_rb_first(&fiopsg->service_tree[i]);
+
+				while (!list_empty(&ioc->fifo)) {
+					fiops_dispatch_request(fiopsd, ioc);
+					dispatched++;
+				}
+				if (fiops_ioc_on_rr(ioc))
+					fiops_del_ioc_rr(fiopsd, ioc);
 			}
-			if (fiops_ioc_on_rr(ioc))
-				fiops_del_ioc_rr(fiopsd, ioc);
 		}
 	}
 	return dispatched;
@@ -377,14 +856,33 @@ static int fiops_forced_dispatch(struct fiops_data *fiopsd)
 
 static struct fiops_ioc *fiops_select_ioc(struct fiops_data *fiopsd)
 {
+	struct fiops_group *fiopsg;
 	struct fiops_ioc *ioc;
 	struct fiops_rb_root *service_tree = NULL;
 	int i;
 	struct request *rq;
 
+	ioc = fiopsd->idle_ioc;
+	if (ioc) {
+		/* it came back in time, it keeps its turn */
+		if (!list_empty(&ioc->fifo)) {
+			fiops_log_ioc(fiopsd, ioc, "idle hit");
+			fiops_clear_idle(fiopsd);
+			return ioc;
+		}
+		if ((s64)(ktime_to_us(ktime_get()) - fiopsd->idle_until) < 0)
+			return NULL;
+		fiops_log_ioc(fiopsd, ioc, "idle expired");
+		fiops_clear_idle(fiopsd);
+	}
+
+	fiopsg = fiops_group_first(&fiopsd->grp_service_tree);
+	if (!fiopsg)
+		return NULL;
+
 	for (i = RT_WORKLOAD; i >= IDLE_WORKLOAD; i--) {
-		if (!RB_EMPTY_ROOT(&fiopsd->service_tree[i].rb)) {
-			service_tree = &fiopsd->service_tree[i];
+		if (!RB_EMPTY_ROOT(&fiopsg->service_tree[i].rb)) {
+			service_tree = &fiopsg->service_tree[i];
 			break;
 		}
 	}
@@ -401,7 +899,7 @@ static struct fiops_ioc *fiops_select_ioc(struct fiops_data *fiopsd)
 	 * to be starved, don't delay
 	 */
 	if (!rq_is_sync(rq) && fiopsd->in_flight[1] != 0 &&
-			service_tree->count == 1) {
+			fiopsd->busy_queues == 1) {
 		fiops_log_ioc(fiopsd, ioc,
 				"postpone async, in_flight async %d sync %d",
 				fiopsd->in_flight[0], fiopsd->in_flight[1]);
@@ -419,6 +917,8 @@ static void fiops_charge_vios(struct fiops_data *fiopsd,
 
 	fiops_log_ioc(fiopsd, ioc, "charge vios %lld, new vios %lld", vios, ioc->vios);
 
+	fiops_group_charge_vios(fiopsd, ioc->fiopsg, vios);
+
 	if (RB_EMPTY_ROOT(&ioc->sort_list))
 		fiops_del_ioc_rr(fiopsd, ioc);
 	else
@@ -483,15 +983,62 @@ static void fiops_init_prio_data(struct fiops_ioc *cic)
 	fiops_clear_ioc_prio_changed(cic);
 }
 
+static void fiops_update_io_thinktime(struct fiops_data *fiopsd,
+	struct fiops_ioc *ioc)
+{
+	u64 elapsed;
+
+	/* Only the time with nothing of its own pending counts */
+	if (!ioc->last_end_request || ioc->in_flight ||
+			!RB_EMPTY_ROOT(&ioc->sort_list))
+		return;
+
+	elapsed = ktime_to_us(ktime_get()) - ioc->last_end_request;
+	elapsed = min_t(u64, elapsed, 2 * fiopsd->slice_idle);
+
+	ioc->ttime_samples = (7 * ioc->ttime_samples + 256) / 8;
+	ioc->ttime_total = (7 * ioc->ttime_total + 256 * (u32)elapsed) / 8;
+	ioc->ttime_mean = (ioc->ttime_total + 128) / ioc->ttime_samples;
+}
+
+static void fiops_update_io_seektime(struct fiops_ioc *ioc,
+	struct request *rq)
+{
+	sector_t sdist = 0;
+
+	if (ioc->last_request_pos) {
+		if (ioc->last_request_pos < blk_rq_pos(rq))
+			sdist = blk_rq_pos(rq) - ioc->last_request_pos;
+		else
+			sdist = ioc->last_request_pos - blk_rq_pos(rq);
+	}
+
+	ioc->seek_history <<= 1;
+	ioc->seek_history |= (sdist > FIOPS_SEEK_THR);
+	ioc->last_request_pos = blk_rq_pos(rq) + blk_rq_sectors(rq);
+}
+
+static inline bool fiops_ioc_seeky(struct fiops_ioc *ioc)
+{
+	return hweight32(ioc->seek_history) > 32 / 8;
+}
+
 static void fiops_insert_request(struct request_queue *q, struct request *rq)
 {
+	struct fiops_data *fiopsd = q->elevator->elevator_data;
 	struct fiops_ioc *ioc = RQ_CIC(rq);
 
 	fiops_init_prio_data(ioc);
 
+	if (rq_is_sync(rq) && fiopsd->slice_idle) {
+		fiops_update_io_thinktime(fiopsd, ioc);
+		fiops_update_io_seektime(ioc, rq);
+	}
+
 	list_add_tail(&rq->queuelist, &ioc->fifo);
 
 	fiops_add_rq_rb(rq);
+	fiops_blkiocg_update_io_add_stats(rq);
 }
 
 /*
@@ -504,6 +1051,30 @@ static inline void fiops_schedule_dispatch(struct fiops_data *fiopsd)
 		kblockd_schedule_work(fiopsd->queue, &fiopsd->unplug_work);
 }
 
+/*
+ * Worth waiting for the next request of an ioc that just ran dry: a
+ * sequential sync reader that comes back within the idle window, and that
+ * is not ahead of the others already.
+ */
+static bool fiops_should_idle(struct fiops_data *fiopsd,
+	struct fiops_ioc *ioc, struct request *rq)
+{
+	struct fiops_rb_root *service_tree = ioc_service_tree(ioc);
+
+	if (!fiopsd->slice_idle || !fiopsd->busy_queues)
+		return false;
+	if (!rq_is_sync(rq) || rq_data_dir(rq) != READ ||
+			ioc->wl_type == IDLE_WORKLOAD)
+		return false;
+	if (ioc->in_flight || !RB_EMPTY_ROOT(&ioc->sort_list))
+		return false;
+	if (fiops_ioc_seeky(ioc) || !ttime_sample_valid(ioc->ttime_samples) ||
+			ioc->ttime_mean > fiopsd->slice_idle)
+		return false;
+
+	return (s64)(ioc->vios - service_tree->min_vios) < FIOPS_IDLE_VIOS;
+}
+
 static void fiops_completed_request(struct request_queue *q, struct request *rq)
 {
 	struct fiops_data *fiopsd = q->elevator->elevator_data;
@@ -511,10 +1082,24 @@ static void fiops_completed_request(struct request_queue *q, struct request *rq)
 
 	fiopsd->in_flight[rq_is_sync(rq)]--;
 	ioc->in_flight--;
+	fiops_blkiocg_update_completion_stats(rq);
 
 	fiops_log_ioc(fiopsd, ioc, "in_flight %d, busy queues %d",
 		ioc->in_flight, fiopsd->busy_queues);
 
+	if (rq_is_sync(rq))
+		ioc->last_end_request = ktime_to_us(ktime_get());
+
+	if (fiops_should_idle(fiopsd, ioc, rq)) {
+		fiops_log_ioc(fiopsd, ioc, "idle, ttime %u", ioc->ttime_mean);
+		fiopsd->idle_ioc = ioc;
+		fiopsd->idle_until = ioc->last_end_request + fiopsd->slice_idle;
+		hrtimer_start(&fiopsd->idle_timer,
+			ns_to_ktime((u64)fiopsd->slice_idle * NSEC_PER_USEC),
+			HRTIMER_MODE_REL);
+		return;
+	}
+
 	if (fiopsd->in_flight[0] + fiopsd->in_flight[1] == 0)
 		fiops_schedule_dispatch(fiopsd);
 }
@@ -569,6 +1154,8 @@ fiops_merged_requests(struct request_queue *q, struct request *rq,
 	struct fiops_data *fiopsd = q->elevator->elevator_data;
 
 	fiops_remove_request(next);
+	fiops_blkiocg_update_io_remove_stats(next);
+	fiops_blkiocg_update_io_merged_stats(rq, next->cmd_flags);
 
 	ioc = RQ_CIC(next);
 	/*
@@ -579,6 +1166,12 @@ fiops_merged_requests(struct request_queue *q, struct request *rq,
 		fiops_del_ioc_rr(fiopsd, ioc);
 }
 
+static void fiops_bio_merged(struct request_queue *q, struct request *req,
+	struct bio *bio)
+{
+	fiops_blkiocg_update_io_merged_stats(req, bio->bi_rw);
+}
+
 static int fiops_allow_merge(struct request_queue *q, struct request *rq,
 			   struct bio *bio)
 {
@@ -597,9 +1190,27 @@ static int fiops_allow_merge(struct request_queue *q, struct request *rq,
 static void fiops_exit_queue(struct elevator_queue *e)
 {
 	struct fiops_data *fiopsd = e->elevator_data;
+	struct request_queue *q = fiopsd->queue;
+	bool wait = false;
 
+	hrtimer_cancel(&fiopsd->idle_timer);
 	cancel_work_sync(&fiopsd->unplug_work);
 
+	spin_lock_irq(q->queue_lock);
+	fiops_release_groups(fiopsd);
+#ifdef CONFIG_FIOPS_GROUP_IOSCHED
+	/* Groups that the cgroup removal is tearing down still have a key */
+	if (fiopsd->nr_blkcg_linked_grps)
+		wait = true;
+#endif
+	spin_unlock_irq(q->queue_lock);
+
+	if (wait)
+		synchronize_rcu();
+
+#ifdef CONFIG_FIOPS_GROUP_IOSCHED
+	free_percpu(fiopsd->root_group.blkg.stats_cpu);
+#endif
 	kfree(fiopsd);
 }
 
@@ -614,10 +1225,21 @@ static void fiops_kick_queue(struct work_struct *work)
 	spin_unlock_irq(q->queue_lock);
 }
 
+/* The idle window is over, let the other iocs in */
+static enum hrtimer_restart fiops_idle_timer_fn(struct hrtimer *timer)
+{
+	struct fiops_data *fiopsd =
+		container_of(timer, struct fiops_data, idle_timer);
+
+	fiops_schedule_dispatch(fiopsd);
+
+	return HRTIMER_NORESTART;
+}
+
 static void *fiops_init_queue(struct request_queue *q)
 {
 	struct fiops_data *fiopsd;
-	int i;
+	struct fiops_group *fiopsg;
 
 	fiopsd = kzalloc_node(sizeof(*fiopsd), GFP_KERNEL, q->node);
 	if (!fiopsd)
@@ -625,15 +1247,40 @@ static void *fiops_init_queue(struct request_queue *q)
 
 	fiopsd->queue = q;
 
-	for (i = IDLE_WORKLOAD; i <= RT_WORKLOAD; i++)
-		fiopsd->service_tree[i] = FIOPS_RB_ROOT;
+	fiopsd->grp_service_tree = FIOPS_RB_ROOT;
+	fiopsg = &fiopsd->root_group;
+	fiops_init_group(fiopsg);
+	/* Give preference to the root group over the others, like CFQ */
+	fiopsg->weight = 2 * BLKIO_WEIGHT_DEFAULT;
+
+#ifdef CONFIG_FIOPS_GROUP_IOSCHED
+	/*
+	 * One reference is dropped with the groups on exit, the other one is
+	 * never, the root group is embedded.
+	 */
+	fiopsg->ref = 2;
+	if (blkio_alloc_blkg_stats(&fiopsg->blkg)) {
+		kfree(fiopsd);
+		return NULL;
+	}
+
+	rcu_read_lock();
+	blkiocg_add_blkio_group(&blkio_root_cgroup, &fiopsg->blkg, fiopsd, 0,
+				BLKIO_POLICY_PROP);
+	rcu_read_unlock();
+	fiopsd->nr_blkcg_linked_grps++;
+	hlist_add_head(&fiopsg->fiopsd_node, &fiopsd->group_list);
+#endif
 
 	INIT_WORK(&fiopsd->unplug_work, fiops_kick_queue);
+	hrtimer_init(&fiopsd->idle_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	fiopsd->idle_timer.function = fiops_idle_timer_fn;
 
 	fiopsd->read_scale = VIOS_READ_SCALE;
 	fiopsd->write_scale = VIOS_WRITE_SCALE;
 	fiopsd->sync_scale = VIOS_SYNC_SCALE;
 	fiopsd->async_scale = VIOS_ASYNC_SCALE;
+	fiopsd->slice_idle = FIOPS_SLICE_IDLE;
 
 	return fiopsd;
 }
@@ -648,9 +1295,22 @@ static void fiops_init_icq(struct io_cq *icq)
 	ioc->sort_list = RB_ROOT;
 
 	ioc->fiopsd = fiopsd;
+	/* Groups are allocated in set_request, which can sleep */
+	ioc->fiopsg = fiops_ref_get_group(&fiopsd->root_group);
 
 	ioc->pid = current->pid;
 	fiops_mark_ioc_prio_changed(ioc);
+	fiops_mark_ioc_cgroup_changed(ioc);
+}
+
+static void fiops_exit_icq(struct io_cq *icq)
+{
+	struct fiops_ioc *ioc = icq_to_cic(icq);
+
+	if (ioc->fiopsd->idle_ioc == ioc)
+		fiops_clear_idle(ioc->fiopsd);
+
+	fiops_put_group(ioc->fiopsg);
 }
 
 /*
@@ -681,6 +1341,7 @@ SHOW_FUNCTION(fiops_read_scale_show, fiopsd->read_scale);
 SHOW_FUNCTION(fiops_write_scale_show, fiopsd->write_scale);
 SHOW_FUNCTION(fiops_sync_scale_show, fiopsd->sync_scale);
 SHOW_FUNCTION(fiops_async_scale_show, fiopsd->async_scale);
+SHOW_FUNCTION(fiops_slice_idle_show, fiopsd->slice_idle);
 #undef SHOW_FUNCTION
 
 #define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX)				\
@@ -700,6 +1361,7 @@ STORE_FUNCTION(fiops_read_scale_store, &fiopsd->read_scale, 1, 100);
 STORE_FUNCTION(fiops_write_scale_store, &fiopsd->write_scale, 1, 100);
 STORE_FUNCTION(fiops_sync_scale_store, &fiopsd->sync_scale, 1, 100);
 STORE_FUNCTION(fiops_async_scale_store, &fiopsd->async_scale, 1, 100);
+STORE_FUNCTION(fiops_slice_idle_store, &fiopsd->slice_idle, 0, 100000);
 #undef STORE_FUNCTION
 
 #define FIOPS_ATTR(name) \
@@ -710,6 +1372,7 @@ static struct elv_fs_entry fiops_attrs[] = {
 	FIOPS_ATTR(write_scale),
 	FIOPS_ATTR(sync_scale),
 	FIOPS_ATTR(async_scale),
+	FIOPS_ATTR(slice_idle),
 	__ATTR_NULL
 };
 
@@ -719,12 +1382,17 @@ static struct elevator_type iosched_fiops = {
 		.elevator_merged_fn =		fiops_merged_request,
 		.elevator_merge_req_fn =	fiops_merged_requests,
 		.elevator_allow_merge_fn =	fiops_allow_merge,
+		.elevator_bio_merged_fn =	fiops_bio_merged,
 		.elevator_dispatch_fn =		fiops_dispatch_requests,
 		.elevator_add_req_fn =		fiops_insert_request,
 		.elevator_completed_req_fn =	fiops_completed_request,
+#ifdef CONFIG_FIOPS_GROUP_IOSCHED
+		.elevator_set_req_fn =		fiops_set_request,
+#endif
 		.elevator_former_req_fn =	elv_rb_former_request,
 		.elevator_latter_req_fn =	elv_rb_latter_request,
 		.elevator_init_icq_fn =		fiops_init_icq,
+		.elevator_exit_icq_fn =		fiops_exit_icq,
 		.elevator_init_fn =		fiops_init_queue,
 		.elevator_exit_fn =		fiops_exit_queue,
 	},
@@ -737,11 +1405,23 @@ static struct elevator_type iosched_fiops = {
 
 static int __init fiops_init(void)
 {
-	return elv_register(&iosched_fiops);
+	int ret;
+
+	ret = elv_register(&iosched_fiops);
+	if (ret)
+		return ret;
+
+#ifdef CONFIG_FIOPS_GROUP_IOSCHED
+	blkio_policy_register(&blkio_policy_fiops);
+#endif
+	return 0;
 }
 
 static void __exit fiops_exit(void)
 {
+#ifdef CONFIG_FIOPS_GROUP_IOSCHED
+	blkio_policy_unregister(&blkio_policy_fiops);
+#endif
 	elv_unregister(&iosched_fiops);
 }
 
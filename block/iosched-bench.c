@@ -0,0 +1,523 @@
+/*
+ * I/O scheduler benchmark
+ *
+ * Runs three Android like workloads at once against a scratch block
+ * device, under each I/O scheduler in turn:
+ *  - launch: bursts of small synchronous random reads, as an application
+ *    start pages its code and resources in,
+ *  - sqlite: transactions of a few synchronous 4k journal and database
+ *    writes, each followed by a cache flush,
+ *  - download: sequential 128k asynchronous writes, several in flight.
+ *
+ * Writing "<device> [seconds]" to <debugfs>/iosched_bench/run runs the
+ * workloads that long under each scheduler of the schedulers parameter,
+ * reading it gives one line of key=value pairs per scheduler and workload,
+ * with the latency percentiles and the throughput. The original scheduler
+ * is put back at the end.
+ *
+ * The device is overwritten. It is opened exclusively, so a mounted or
+ * swapped on partition is refused, but its scheduler is that of the whole
+ * disk.
+ */
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/blkdev.h>
+#include <linux/bio.h>
+#include <linux/completion.h>
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/elevator.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/random.h>
+#include <linux/semaphore.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#define BENCH_MAX_SAMPLES	65536
+#define BENCH_REPORT_SIZE	(4 * PAGE_SIZE)
+
+/* 64k reads at most, 128k download writes, this many in flight */
+#define BENCH_READ_ORDER	4
+#define BENCH_DOWNLOAD_ORDER	5
+#define BENCH_DOWNLOAD_DEPTH	4
+
+#define BENCH_LAUNCH_BURST	64
+#define BENCH_LAUNCH_PAUSE_MS	100
+#define BENCH_SQLITE_PAUSE_MS	20
+
+static char *schedulers = "noop,deadline,cfq,bfq,fiops,sioplus,zen,vr,tripndroid,lat";
+module_param(schedulers, charp, 0644);
+MODULE_PARM_DESC(schedulers, "Comma separated I/O schedulers to run the workloads under");
+
+static unsigned int duration = 10;
+module_param(duration, uint, 0644);
+MODULE_PARM_DESC(duration, "Default seconds to run the workloads for, per scheduler");
+
+static DEFINE_MUTEX(bench_mutex);
+
+static char *bench_report;
+static unsigned int bench_report_len;
+
+struct bench_worker;
+
+struct bench_ctx {
+	struct block_device *bdev;
+	/* Each workload has a third of the device, in 4k blocks */
+	sector_t region_blocks;
+	unsigned long deadline;
+};
+
+struct bench_worker {
+	const char *name;
+	int (*fn)(struct bench_ctx *ctx, struct bench_worker *w);
+	struct bench_ctx *ctx;
+	struct completion done;
+	struct semaphore inflight;
+	u32 *ns;
+	unsigned int count;
+	unsigned int errors;
+	u64 bytes;
+	int ret;
+};
+
+static void bench_end_io(struct bio *bio, int err)
+{
+	struct bench_worker *w = bio->bi_private;
+
+	if (err)
+		w->errors++;
+	bio_put(bio);
+	up(&w->inflight);
+}
+
+static void bench_sync_end_io(struct bio *bio, int err)
+{
+	if (err)
+		clear_bit(BIO_UPTODATE, &bio->bi_flags);
+	complete(bio->bi_private);
+}
+
+static struct bio *bench_bio(struct block_device *bdev, sector_t block,
+			     struct page *page, unsigned int order)
+{
+	struct bio *bio;
+	unsigned int i;
+
+	bio = bio_alloc(GFP_KERNEL, 1 << order);
+	if (!bio)
+		return NULL;
+
+	bio->bi_bdev = bdev;
+	bio->bi_sector = block << (PAGE_SHIFT - 9);
+	for (i = 0; i < (1 << order); i++)
+		bio_add_page(bio, page + i, PAGE_SIZE, 0);
+
+	return bio;
+}
+
+static int bench_sync_io(struct block_device *bdev, int rw, sector_t block,
+			 struct page *page, unsigned int order)
+{
+	DECLARE_COMPLETION_ONSTACK(done);
+	struct bio *bio;
+	int ret = 0;
+
+	bio = bench_bio(bdev, block, page, order);
+	if (!bio)
+		return -ENOMEM;
+
+	bio->bi_end_io = bench_sync_end_io;
+	bio->bi_private = &done;
+	submit_bio(rw, bio);
+	wait_for_completion(&done);
+
+	if (!test_bit(BIO_UPTODATE, &bio->bi_flags))
+		ret = -EIO;
+	bio_put(bio);
+
+	return ret;
+}
+
+static void bench_sample(struct bench_worker *w, ktime_t start)
+{
+	s64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (w->count < BENCH_MAX_SAMPLES)
+		w->ns[w->count++] = min_t(s64, ns, U32_MAX);
+}
+
+static bool bench_running(struct bench_ctx *ctx)
+{
+	return time_before(jiffies, ctx->deadline);
+}
+
+/* Mostly 4k with some readahead sized reads, anywhere in the region */
+static int bench_launch(struct bench_ctx *ctx, struct bench_worker *w)
+{
+	static const unsigned int orders[] = { 0, 0, 0, 0, 1, 2, 2, 4 };
+	struct page *page;
+	unsigned int i;
+
+	page = alloc_pages(GFP_KERNEL, BENCH_READ_ORDER);
+	if (!page)
+		return -ENOMEM;
+
+	while (bench_running(ctx)) {
+		for (i = 0; i < BENCH_LAUNCH_BURST && bench_running(ctx); i++) {
+			unsigned int order = orders[random32() %
+						    ARRAY_SIZE(orders)];
+			sector_t block = random32() %
+				(ctx->region_blocks - (1 << order));
+			ktime_t start = ktime_get();
+
+			if (bench_sync_io(ctx->bdev, READ_SYNC, block, page,
+					  order))
+				w->errors++;
+			bench_sample(w, start);
+			w->bytes += PAGE_SIZE << order;
+		}
+		msleep(BENCH_LAUNCH_PAUSE_MS);
+	}
+
+	__free_pages(page, BENCH_READ_ORDER);
+	return 0;
+}
+
+/* Journal pages, flush, database pages, flush: one sample a commit */
+static int bench_sqlite(struct bench_ctx *ctx, struct bench_worker *w)
+{
+	const sector_t base = ctx->region_blocks;
+	const sector_t journal = 16;
+	struct page *page;
+	unsigned int i, n;
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page)
+		return -ENOMEM;
+
+	while (bench_running(ctx)) {
+		ktime_t start = ktime_get();
+
+		n = 2 + random32() % 3;
+		for (i = 0; i < n; i++) {
+			if (bench_sync_io(ctx->bdev, WRITE_SYNC, base + i,
+					  page, 0))
+				w->errors++;
+		}
+		if (blkdev_issue_flush(ctx->bdev, GFP_KERNEL, NULL))
+			w->errors++;
+
+		for (i = 0; i < n; i++) {
+			sector_t block = base + journal + random32() %
+				(ctx->region_blocks - journal);
+
+			if (bench_sync_io(ctx->bdev, WRITE_SYNC, block, page,
+					  0))
+				w->errors++;
+		}
+		if (blkdev_issue_flush(ctx->bdev, GFP_KERNEL, NULL))
+			w->errors++;
+
+		bench_sample(w, start);
+		w->bytes += 2 * n * PAGE_SIZE;
+		msleep(BENCH_SQLITE_PAUSE_MS);
+	}
+
+	__free_page(page);
+	return 0;
+}
+
+/* Sequential writes through the region, over and over */
+static int bench_download(struct bench_ctx *ctx, struct bench_worker *w)
+{
+	const sector_t base = 2 * ctx->region_blocks;
+	const unsigned int step = 1 << BENCH_DOWNLOAD_ORDER;
+	sector_t block = 0;
+	struct page *page;
+	unsigned int i;
+
+	page = alloc_pages(GFP_KERNEL, BENCH_DOWNLOAD_ORDER);
+	if (!page)
+		return -ENOMEM;
+
+	while (bench_running(ctx)) {
+		struct bio *bio;
+		ktime_t start = ktime_get();
+
+		down(&w->inflight);
+		bench_sample(w, start);
+
+		if (block + step > ctx->region_blocks)
+			block = 0;
+		bio = bench_bio(ctx->bdev, base + block, page,
+				BENCH_DOWNLOAD_ORDER);
+		if (!bio) {
+			up(&w->inflight);
+			w->errors++;
+			continue;
+		}
+		bio->bi_end_io = bench_end_io;
+		bio->bi_private = w;
+		submit_bio(WRITE, bio);
+
+		block += step;
+		w->bytes += PAGE_SIZE << BENCH_DOWNLOAD_ORDER;
+	}
+
+	for (i = 0; i < BENCH_DOWNLOAD_DEPTH; i++)
+		down(&w->inflight);
+
+	__free_pages(page, BENCH_DOWNLOAD_ORDER);
+	return 0;
+}
+
+static int bench_thread(void *data)
+{
+	struct bench_worker *w = data;
+
+	w->ret = w->fn(w->ctx, w);
+	complete(&w->done);
+
+	return 0;
+}
+
+static int bench_cmp_u32(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a;
+	u32 y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void bench_report_worker(const char *sched, struct bench_worker *w,
+				unsigned int ms)
+{
+	unsigned int n = w->count;
+	u64 kbps = div_u64(w->bytes, ms ? ms : 1) * 1000 >> 10;
+
+	if (!n) {
+		bench_report_len += scnprintf(bench_report + bench_report_len,
+			BENCH_REPORT_SIZE - bench_report_len,
+			"scheduler=%s workload=%s ops=0 errors=%u ret=%d\n",
+			sched, w->name, w->errors, w->ret);
+		return;
+	}
+
+	sort(w->ns, n, sizeof(*w->ns), bench_cmp_u32, NULL);
+	bench_report_len += scnprintf(bench_report + bench_report_len,
+		BENCH_REPORT_SIZE - bench_report_len,
+		"scheduler=%s workload=%s ops=%u errors=%u kb_per_s=%llu "
+		"p50_us=%u p90_us=%u p99_us=%u max_us=%u\n",
+		sched, w->name, n, w->errors, kbps,
+		w->ns[n / 2] / 1000, w->ns[n * 9 / 10] / 1000,
+		w->ns[n * 99 / 100] / 1000, w->ns[n - 1] / 1000);
+}
+
+static struct bench_worker bench_workers[] = {
+	{ .name = "launch", .fn = bench_launch },
+	{ .name = "sqlite", .fn = bench_sqlite },
+	{ .name = "download", .fn = bench_download },
+};
+
+static int bench_run_sched(struct bench_ctx *ctx, const char *sched,
+			   unsigned int seconds)
+{
+	struct request_queue *q = bdev_get_queue(ctx->bdev);
+	struct task_struct *task;
+	unsigned long start;
+	int started = 0;
+	int ret;
+	int i;
+
+	ret = elevator_change(q, sched);
+	if (ret) {
+		bench_report_len += scnprintf(bench_report + bench_report_len,
+			BENCH_REPORT_SIZE - bench_report_len,
+			"scheduler=%s error=%d\n", sched, ret);
+		return 0;
+	}
+
+	start = jiffies;
+	ctx->deadline = start + seconds * HZ;
+	for (i = 0; i < ARRAY_SIZE(bench_workers); i++) {
+		struct bench_worker *w = &bench_workers[i];
+
+		w->ctx = ctx;
+		w->count = 0;
+		w->errors = 0;
+		w->bytes = 0;
+		w->ret = 0;
+		init_completion(&w->done);
+		sema_init(&w->inflight, BENCH_DOWNLOAD_DEPTH);
+
+		task = kthread_run(bench_thread, w, "iosched_bench/%s",
+				   w->name);
+		if (IS_ERR(task)) {
+			ret = PTR_ERR(task);
+			/* Stop the others early */
+			ctx->deadline = jiffies;
+			break;
+		}
+		started++;
+	}
+
+	for (i = 0; i < started; i++)
+		wait_for_completion(&bench_workers[i].done);
+
+	if (!ret) {
+		for (i = 0; i < ARRAY_SIZE(bench_workers); i++)
+			bench_report_worker(sched, &bench_workers[i],
+					    jiffies_to_msecs(jiffies - start));
+	}
+
+	return ret;
+}
+
+static int bench_run(const char *path, unsigned int seconds)
+{
+	const fmode_t mode = FMODE_READ | FMODE_WRITE | FMODE_EXCL;
+	struct bench_ctx ctx;
+	char orig[ELV_NAME_MAX];
+	char *list, *p, *sched;
+	struct request_queue *q;
+	int ret = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.bdev = blkdev_get_by_path(path, mode, &bench_mutex);
+	if (IS_ERR(ctx.bdev))
+		return PTR_ERR(ctx.bdev);
+
+	ctx.region_blocks = (i_size_read(ctx.bdev->bd_inode) >> PAGE_SHIFT) / 3;
+	if (ctx.region_blocks < 64 << BENCH_DOWNLOAD_ORDER) {
+		ret = -ENOSPC;
+		goto out_put;
+	}
+
+	q = bdev_get_queue(ctx.bdev);
+	if (!q->elevator) {
+		ret = -ENXIO;
+		goto out_put;
+	}
+	strlcpy(orig, q->elevator->type->elevator_name, sizeof(orig));
+
+	list = kstrdup(schedulers, GFP_KERNEL);
+	if (!list) {
+		ret = -ENOMEM;
+		goto out_put;
+	}
+
+	bench_report_len = 0;
+	p = list;
+	while ((sched = strsep(&p, ",")) && !ret) {
+		sched = strim(sched);
+		if (*sched)
+			ret = bench_run_sched(&ctx, sched, seconds);
+	}
+
+	elevator_change(q, orig);
+	kfree(list);
+
+out_put:
+	blkdev_put(ctx.bdev, mode);
+	return ret;
+}
+
+static ssize_t bench_read(struct file *filp, char __user *ubuf,
+			  size_t cnt, loff_t *ppos)
+{
+	ssize_t ret;
+
+	mutex_lock(&bench_mutex);
+	ret = simple_read_from_buffer(ubuf, cnt, ppos, bench_report,
+				      bench_report_len);
+	mutex_unlock(&bench_mutex);
+
+	return ret;
+}
+
+static ssize_t bench_write(struct file *filp, const char __user *ubuf,
+			   size_t cnt, loff_t *ppos)
+{
+	char buf[128];
+	unsigned int seconds = duration;
+	char *path, *arg;
+	int ret;
+
+	if (cnt >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, cnt))
+		return -EFAULT;
+	buf[cnt] = '\0';
+
+	arg = strim(buf);
+	path = strsep(&arg, " \t");
+	if (!*path)
+		return -EINVAL;
+	if (arg && kstrtouint(strim(arg), 0, &seconds))
+		return -EINVAL;
+	if (!seconds)
+		return -EINVAL;
+
+	mutex_lock(&bench_mutex);
+	ret = bench_run(path, seconds);
+	mutex_unlock(&bench_mutex);
+
+	return ret ? ret : cnt;
+}
+
+static const struct file_operations bench_fops = {
+	.open		= simple_open,
+	.read		= bench_read,
+	.write		= bench_write,
+	.llseek		= default_llseek,
+};
+
+static struct dentry *bench_dir;
+
+static int __init iosched_bench_init(void)
+{
+	int i;
+
+	bench_report = kzalloc(BENCH_REPORT_SIZE, GFP_KERNEL);
+	if (!bench_report)
+		goto err;
+
+	for (i = 0; i < ARRAY_SIZE(bench_workers); i++) {
+		bench_workers[i].ns = vmalloc(BENCH_MAX_SAMPLES * sizeof(u32));
+		if (!bench_workers[i].ns)
+			goto err;
+	}
+
+	bench_dir = debugfs_create_dir("iosched_bench", NULL);
+	if (!bench_dir)
+		goto err;
+	debugfs_create_file("run", 0600, bench_dir, NULL, &bench_fops);
+
+	return 0;
+
+err:
+	for (i = 0; i < ARRAY_SIZE(bench_workers); i++)
+		vfree(bench_workers[i].ns);
+	kfree(bench_report);
+	return -ENOMEM;
+}
+
+static void __exit iosched_bench_exit(void)
+{
+	int i;
+
+	debugfs_remove_recursive(bench_dir);
+	for (i = 0; i < ARRAY_SIZE(bench_workers); i++)
+		vfree(bench_workers[i].ns);
+	kfree(bench_report);
+}
+
+module_init(iosched_bench_init);
+module_exit(iosched_bench_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("I/O scheduler benchmark");
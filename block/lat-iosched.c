@@ -0,0 +1,524 @@
+/*
+ * Latency target IO scheduler
+ * Based on the Simple IO scheduler plus.
+ *
+ * Requests are kept in fifo lists, one per sync/async and direction, and
+ * dispatched in order with deadlines, reads first. On top of that the
+ * scheduler takes a latency goal for sync reads and sync writes. The time
+ * each request spends in the driver is measured when it completes, and
+ * while sync requests are around, the number of async writes the driver
+ * may hold is adjusted to keep the average sync latency under its goal:
+ * halved when a goal is missed, grown by one while they are met.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/blkdev.h>
+#include <linux/elevator.h>
+#include <linux/bio.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/slab.h>
+#include <linux/ktime.h>
+
+enum { ASYNC, SYNC };
+
+/* Tunables */
+static const int sync_read_expire = (HZ / 4);	/* max time before a sync read is submitted. */
+static const int sync_write_expire = (HZ / 4) * 5;	/* max time before a sync write is submitted. */
+
+static const int async_read_expire = (HZ / 2);	/* ditto for async, these limits are SOFT! */
+static const int async_write_expire = (HZ * 2);	/* ditto for async, these limits are SOFT! */
+
+static const int writes_starved = 2;		/* max times reads can starve a write */
+static const int fifo_batch     = 3;		/* # of sequential requests treated as one
+						   by the above parameters. For throughput. */
+
+static const int read_target = 20;		/* average sync read latency goal, in ms */
+static const int write_target = 100;		/* ditto for sync writes, 0 for none */
+static const int async_depth = 16;		/* max async writes held by the driver */
+
+/* Elevator data */
+struct lat_data {
+	/* Request queues */
+	struct list_head fifo_list[2][2];
+
+	/* Attributes */
+	unsigned int batched;
+	unsigned int starved;
+
+	/* Requests held by the driver */
+	unsigned int in_flight[2];
+	unsigned int async_writes;
+
+	/* Average sync latency per direction, in us, times 8 */
+	unsigned int avg_lat8[2];
+	/* Async writes the driver may hold while sync requests are around */
+	unsigned int async_limit;
+	/* Sync completions since the limit last changed */
+	unsigned int adjust_count;
+	/* Async writes were held back by the limit */
+	bool throttled;
+
+	/* Settings */
+	int fifo_expire[2][2];
+	int fifo_batch;
+	int writes_starved;
+	int lat_target[2];	/* in us */
+	int async_depth;
+};
+
+static inline u32 lat_now_us(void)
+{
+	return (u32)ktime_to_us(ktime_get());
+}
+
+static void
+lat_merged_requests(struct request_queue *q, struct request *rq,
+		    struct request *next)
+{
+	/*
+	 * If next expires before rq, assign its expire time to rq
+	 * and move into next position (next will be deleted) in fifo.
+	 */
+	if (!list_empty(&rq->queuelist) && !list_empty(&next->queuelist)) {
+		if (time_before(rq_fifo_time(next), rq_fifo_time(rq))) {
+			list_move(&rq->queuelist, &next->queuelist);
+			rq_set_fifo_time(rq, rq_fifo_time(next));
+		}
+	}
+
+	/* Delete next request */
+	rq_fifo_clear(next);
+}
+
+static void
+lat_add_request(struct request_queue *q, struct request *rq)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+	const int sync = rq_is_sync(rq);
+	const int data_dir = rq_data_dir(rq);
+
+	rq_set_fifo_time(rq, jiffies + ld->fifo_expire[sync][data_dir]);
+	list_add_tail(&rq->queuelist, &ld->fifo_list[sync][data_dir]);
+}
+
+/* Sync requests are queued or held by the driver */
+static inline bool lat_sync_busy(struct lat_data *ld)
+{
+	return ld->in_flight[SYNC] ||
+		!list_empty(&ld->fifo_list[SYNC][READ]) ||
+		!list_empty(&ld->fifo_list[SYNC][WRITE]);
+}
+
+static inline bool lat_async_write_allowed(struct lat_data *ld)
+{
+	return !lat_sync_busy(ld) || ld->async_writes < ld->async_limit;
+}
+
+static struct request *
+lat_expired_request(struct lat_data *ld, int sync, int data_dir)
+{
+	struct list_head *list = &ld->fifo_list[sync][data_dir];
+	struct request *rq;
+
+	if (list_empty(list))
+		return NULL;
+
+	rq = rq_entry_fifo(list->next);
+	if (time_after_eq(jiffies, rq_fifo_time(rq)))
+		return rq;
+
+	return NULL;
+}
+
+static inline struct request *
+lat_first_request(struct lat_data *ld, int sync, int data_dir)
+{
+	struct list_head *list = &ld->fifo_list[sync][data_dir];
+
+	if (list_empty(list))
+		return NULL;
+
+	return rq_entry_fifo(list->next);
+}
+
+static struct request *
+lat_choose_request(struct lat_data *ld, int force)
+{
+	bool writes_ok = force || lat_async_write_allowed(ld);
+	struct request *read, *write, *rq;
+
+	/*
+	 * Check expired requests after a batch of sequential requests.
+	 * Sync requests have priority over async, reads over writes.
+	 */
+	if (ld->batched >= ld->fifo_batch) {
+		ld->batched = 0;
+
+		rq = lat_expired_request(ld, SYNC, READ);
+		if (!rq)
+			rq = lat_expired_request(ld, SYNC, WRITE);
+		if (!rq)
+			rq = lat_expired_request(ld, ASYNC, READ);
+		if (!rq && writes_ok)
+			rq = lat_expired_request(ld, ASYNC, WRITE);
+		if (rq)
+			return rq;
+	}
+	ld->batched++;
+
+	read = lat_first_request(ld, SYNC, READ);
+	if (!read)
+		read = lat_first_request(ld, ASYNC, READ);
+
+	write = lat_first_request(ld, SYNC, WRITE);
+	if (!write && writes_ok)
+		write = lat_first_request(ld, ASYNC, WRITE);
+
+	if (!write && !list_empty(&ld->fifo_list[ASYNC][WRITE]))
+		ld->throttled = true;
+
+	/* Reads go first, until the writes behind them starved long enough */
+	if (read && (!write || ld->starved < ld->writes_starved))
+		return read;
+
+	return write;
+}
+
+static inline void
+lat_dispatch_request(struct lat_data *ld, struct request *rq)
+{
+	/*
+	 * Remove the request from the fifo list
+	 * and dispatch it.
+	 */
+	rq_fifo_clear(rq);
+	elv_dispatch_add_tail(rq->q, rq);
+
+	if (rq_data_dir(rq)) {
+		ld->starved = 0;
+	} else {
+		if (!list_empty(&ld->fifo_list[SYNC][WRITE]) ||
+				!list_empty(&ld->fifo_list[ASYNC][WRITE]))
+			ld->starved++;
+	}
+}
+
+static int
+lat_dispatch_requests(struct request_queue *q, int force)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+	struct request *rq;
+	int dispatched = 0;
+
+	/* The queue is being drained, nothing is held back */
+	if (force) {
+		while ((rq = lat_choose_request(ld, 1)) != NULL) {
+			lat_dispatch_request(ld, rq);
+			dispatched++;
+		}
+		return dispatched;
+	}
+
+	rq = lat_choose_request(ld, 0);
+	if (!rq)
+		return 0;
+
+	lat_dispatch_request(ld, rq);
+
+	return 1;
+}
+
+static void
+lat_activate_request(struct request_queue *q, struct request *rq)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+	const int sync = rq_is_sync(rq);
+
+	/* When the driver got it */
+	rq->elv.priv[0] = (void *)(unsigned long)lat_now_us();
+
+	ld->in_flight[sync]++;
+	if (!sync && rq_data_dir(rq) == WRITE)
+		ld->async_writes++;
+}
+
+static void
+lat_deactivate_request(struct request_queue *q, struct request *rq)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+	const int sync = rq_is_sync(rq);
+
+	ld->in_flight[sync]--;
+	if (!sync && rq_data_dir(rq) == WRITE)
+		ld->async_writes--;
+}
+
+/*
+ * Additive increase, multiplicative decrease of the async write limit,
+ * changed at most once per limit worth of sync completions so that the
+ * average catches up with the change.
+ */
+static void
+lat_adjust_limit(struct lat_data *ld, int data_dir)
+{
+	unsigned int avg = ld->avg_lat8[data_dir] >> 3;
+	unsigned int target = ld->lat_target[data_dir];
+
+	if (!target || ++ld->adjust_count < ld->async_limit)
+		return;
+
+	if (avg > target) {
+		ld->async_limit = max(ld->async_limit / 2, 1U);
+		ld->adjust_count = 0;
+	} else if (avg < target - target / 4 &&
+		   ld->async_limit < ld->async_depth) {
+		ld->async_limit++;
+		ld->adjust_count = 0;
+	}
+}
+
+static void
+lat_completed_request(struct request_queue *q, struct request *rq)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+	const int sync = rq_is_sync(rq);
+	const int data_dir = rq_data_dir(rq);
+	u32 lat;
+
+	lat_deactivate_request(q, rq);
+
+	if (sync) {
+		lat = lat_now_us() - (u32)(unsigned long)rq->elv.priv[0];
+		ld->avg_lat8[data_dir] += lat - (ld->avg_lat8[data_dir] >> 3);
+		lat_adjust_limit(ld, data_dir);
+	}
+
+	/* Called with the queue lock held, the driver is kicked later */
+	if (ld->throttled && lat_async_write_allowed(ld)) {
+		ld->throttled = false;
+		blk_run_queue_async(q);
+	}
+}
+
+static struct request *
+lat_former_request(struct request_queue *q, struct request *rq)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+	const int sync = rq_is_sync(rq);
+	const int data_dir = rq_data_dir(rq);
+
+	if (rq->queuelist.prev == &ld->fifo_list[sync][data_dir])
+		return NULL;
+
+	/* Return former request */
+	return list_entry(rq->queuelist.prev, struct request, queuelist);
+}
+
+static struct request *
+lat_latter_request(struct request_queue *q, struct request *rq)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+	const int sync = rq_is_sync(rq);
+	const int data_dir = rq_data_dir(rq);
+
+	if (rq->queuelist.next == &ld->fifo_list[sync][data_dir])
+		return NULL;
+
+	/* Return latter request */
+	return list_entry(rq->queuelist.next, struct request, queuelist);
+}
+
+static void *
+lat_init_queue(struct request_queue *q)
+{
+	struct lat_data *ld;
+
+	/* Allocate structure */
+	ld = kzalloc_node(sizeof(*ld), GFP_KERNEL, q->node);
+	if (!ld)
+		return NULL;
+
+	/* Initialize fifo lists */
+	INIT_LIST_HEAD(&ld->fifo_list[SYNC][READ]);
+	INIT_LIST_HEAD(&ld->fifo_list[SYNC][WRITE]);
+	INIT_LIST_HEAD(&ld->fifo_list[ASYNC][READ]);
+	INIT_LIST_HEAD(&ld->fifo_list[ASYNC][WRITE]);
+
+	/* Initialize data */
+	ld->fifo_expire[SYNC][READ] = sync_read_expire;
+	ld->fifo_expire[SYNC][WRITE] = sync_write_expire;
+	ld->fifo_expire[ASYNC][READ] = async_read_expire;
+	ld->fifo_expire[ASYNC][WRITE] = async_write_expire;
+	ld->fifo_batch = fifo_batch;
+	ld->writes_starved = writes_starved;
+	ld->lat_target[READ] = read_target * USEC_PER_MSEC;
+	ld->lat_target[WRITE] = write_target * USEC_PER_MSEC;
+	ld->async_depth = async_depth;
+	ld->async_limit = async_depth;
+
+	return ld;
+}
+
+static void
+lat_exit_queue(struct elevator_queue *e)
+{
+	struct lat_data *ld = e->elevator_data;
+
+	BUG_ON(!list_empty(&ld->fifo_list[SYNC][READ]));
+	BUG_ON(!list_empty(&ld->fifo_list[SYNC][WRITE]));
+	BUG_ON(!list_empty(&ld->fifo_list[ASYNC][READ]));
+	BUG_ON(!list_empty(&ld->fifo_list[ASYNC][WRITE]));
+
+	/* Free structure */
+	kfree(ld);
+}
+
+/*
+ * sysfs code
+ */
+
+static ssize_t
+lat_var_show(int var, char *page)
+{
+	return sprintf(page, "%d\n", var);
+}
+
+static ssize_t
+lat_var_store(int *var, const char *page, size_t count)
+{
+	char *p = (char *) page;
+
+	*var = simple_strtol(p, &p, 10);
+	return count;
+}
+
+#define SHOW_FUNCTION(__FUNC, __VAR, __CONV)				\
+static ssize_t __FUNC(struct elevator_queue *e, char *page)		\
+{									\
+	struct lat_data *ld = e->elevator_data;				\
+	int __data = __VAR;						\
+	if (__CONV == 1)						\
+		__data = jiffies_to_msecs(__data);			\
+	else if (__CONV == 2)						\
+		__data /= USEC_PER_MSEC;				\
+	return lat_var_show(__data, (page));				\
+}
+SHOW_FUNCTION(lat_sync_read_expire_show, ld->fifo_expire[SYNC][READ], 1);
+SHOW_FUNCTION(lat_sync_write_expire_show, ld->fifo_expire[SYNC][WRITE], 1);
+SHOW_FUNCTION(lat_async_read_expire_show, ld->fifo_expire[ASYNC][READ], 1);
+SHOW_FUNCTION(lat_async_write_expire_show, ld->fifo_expire[ASYNC][WRITE], 1);
+SHOW_FUNCTION(lat_fifo_batch_show, ld->fifo_batch, 0);
+SHOW_FUNCTION(lat_writes_starved_show, ld->writes_starved, 0);
+SHOW_FUNCTION(lat_read_target_show, ld->lat_target[READ], 2);
+SHOW_FUNCTION(lat_write_target_show, ld->lat_target[WRITE], 2);
+SHOW_FUNCTION(lat_async_depth_show, ld->async_depth, 0);
+SHOW_FUNCTION(lat_async_limit_show, ld->async_limit, 0);
+SHOW_FUNCTION(lat_read_latency_us_show, ld->avg_lat8[READ] >> 3, 0);
+SHOW_FUNCTION(lat_write_latency_us_show, ld->avg_lat8[WRITE] >> 3, 0);
+#undef SHOW_FUNCTION
+
+#define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
+static ssize_t __FUNC(struct elevator_queue *e, const char *page, size_t count)	\
+{									\
+	struct lat_data *ld = e->elevator_data;				\
+	int __data;							\
+	int ret = lat_var_store(&__data, (page), count);		\
+	if (__data < (MIN))						\
+		__data = (MIN);						\
+	else if (__data > (MAX))					\
+		__data = (MAX);						\
+	if (__CONV == 1)						\
+		*(__PTR) = msecs_to_jiffies(__data);			\
+	else if (__CONV == 2)						\
+		*(__PTR) = __data * USEC_PER_MSEC;			\
+	else								\
+		*(__PTR) = __data;					\
+	return ret;							\
+}
+STORE_FUNCTION(lat_sync_read_expire_store, &ld->fifo_expire[SYNC][READ], 0, INT_MAX, 1);
+STORE_FUNCTION(lat_sync_write_expire_store, &ld->fifo_expire[SYNC][WRITE], 0, INT_MAX, 1);
+STORE_FUNCTION(lat_async_read_expire_store, &ld->fifo_expire[ASYNC][READ], 0, INT_MAX, 1);
+STORE_FUNCTION(lat_async_write_expire_store, &ld->fifo_expire[ASYNC][WRITE], 0, INT_MAX, 1);
+STORE_FUNCTION(lat_fifo_batch_store, &ld->fifo_batch, 1, INT_MAX, 0);
+STORE_FUNCTION(lat_writes_starved_store, &ld->writes_starved, 1, INT_MAX, 0);
+STORE_FUNCTION(lat_read_target_store, &ld->lat_target[READ], 0, 10000, 2);
+STORE_FUNCTION(lat_write_target_store, &ld->lat_target[WRITE], 0, 10000, 2);
+#undef STORE_FUNCTION
+
+static ssize_t
+lat_async_depth_store(struct elevator_queue *e, const char *page, size_t count)
+{
+	struct lat_data *ld = e->elevator_data;
+	int __data;
+	int ret = lat_var_store(&__data, page, count);
+
+	ld->async_depth = clamp(__data, 1, 1024);
+	/* Start over from the new depth */
+	ld->async_limit = ld->async_depth;
+	ld->adjust_count = 0;
+	return ret;
+}
+
+#define DD_ATTR(name) \
+	__ATTR(name, S_IRUGO|S_IWUSR, lat_##name##_show, \
+				      lat_##name##_store)
+#define DD_ATTR_RO(name) \
+	__ATTR(name, S_IRUGO, lat_##name##_show, NULL)
+
+static struct elv_fs_entry lat_attrs[] = {
+	DD_ATTR(sync_read_expire),
+	DD_ATTR(sync_write_expire),
+	DD_ATTR(async_read_expire),
+	DD_ATTR(async_write_expire),
+	DD_ATTR(fifo_batch),
+	DD_ATTR(writes_starved),
+	DD_ATTR(read_target),
+	DD_ATTR(write_target),
+	DD_ATTR(async_depth),
+	DD_ATTR_RO(async_limit),
+	DD_ATTR_RO(read_latency_us),
+	DD_ATTR_RO(write_latency_us),
+	__ATTR_NULL
+};
+
+static struct elevator_type iosched_lat = {
+	.ops = {
+		.elevator_merge_req_fn		= lat_merged_requests,
+		.elevator_dispatch_fn		= lat_dispatch_requests,
+		.elevator_add_req_fn		= lat_add_request,
+		.elevator_activate_req_fn	= lat_activate_request,
+		.elevator_deactivate_req_fn	= lat_deactivate_request,
+		.elevator_completed_req_fn	= lat_completed_request,
+		.elevator_former_req_fn		= lat_former_request,
+		.elevator_latter_req_fn		= lat_latter_request,
+		.elevator_init_fn		= lat_init_queue,
+		.elevator_exit_fn		= lat_exit_queue,
+	},
+
+	.elevator_attrs = lat_attrs,
+	.elevator_name = "lat",
+	.elevator_owner = THIS_MODULE,
+};
+
+static int __init lat_init(void)
+{
+	/* Register elevator */
+	elv_register(&iosched_lat);
+
+	return 0;
+}
+
+static void __exit lat_exit(void)
+{
+	/* Unregister elevator */
+	elv_unregister(&iosched_lat);
+}
+
+module_init(lat_init);
+module_exit(lat_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Latency target IO scheduler");
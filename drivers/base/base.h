@@ -111,6 +111,8 @@ extern void bus_remove_driver(struct device_driver *drv);
 extern void driver_detach(struct device_driver *drv);
 extern int driver_probe_device(struct device_driver *drv, struct device *dev);
 extern void driver_deferred_probe_del(struct device *dev);
+extern void driver_probe_late_add(struct device_driver *drv);
+extern void driver_probe_late_del(struct device_driver *drv);
 static inline int driver_match_device(struct device_driver *drv,
 				      struct device *dev)
 {
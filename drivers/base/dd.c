@@ -179,6 +179,132 @@ static int deferred_probe_initcall(void)
 }
 late_initcall(deferred_probe_initcall);
 
+/*
+ * Late probe.
+ *
+ * The devices of drivers that do not matter for bringing up the system, for
+ * example sensors, can be left unbound until the initcalls are done. Such
+ * drivers are named on the probe_late= command line, or by the board file
+ * with driver_probe_late(), before they register. A work item binds their
+ * devices, in the order the drivers registered, after the last initcall, in
+ * parallel with the start of user space. Drivers probing with
+ * platform_driver_probe() must bind when they register and are never late.
+ *
+ * A driver whose probe needs the device of a late driver returns
+ * -EPROBE_DEFER, the late binding retries it.
+ */
+#define PROBE_LATE_MAX		16
+
+static const char *probe_late_names[PROBE_LATE_MAX];
+static int probe_late_num_names;
+static char probe_late_cmdline[256];
+static struct device_driver *probe_late_drivers[PROBE_LATE_MAX];
+static int probe_late_num_drivers;
+static bool probe_late_done;
+static DEFINE_MUTEX(probe_late_mutex);
+
+/**
+ * driver_probe_late() - Leave the devices of a driver for the late probe
+ * @name: Name of the driver, as registered
+ *
+ * Must be called before the driver registers, for example from the
+ * init_machine of the board.
+ */
+int driver_probe_late(const char *name)
+{
+	int ret = 0;
+
+	mutex_lock(&probe_late_mutex);
+	if (probe_late_num_names < PROBE_LATE_MAX)
+		probe_late_names[probe_late_num_names++] = name;
+	else
+		ret = -ENOMEM;
+	mutex_unlock(&probe_late_mutex);
+
+	return ret;
+}
+
+static int __init probe_late_setup(char *str)
+{
+	char *name;
+
+	strlcpy(probe_late_cmdline, str, sizeof(probe_late_cmdline));
+	str = probe_late_cmdline;
+	while ((name = strsep(&str, ",")) != NULL) {
+		if (*name)
+			driver_probe_late(name);
+	}
+
+	return 1;
+}
+__setup("probe_late=", probe_late_setup);
+
+void driver_probe_late_add(struct device_driver *drv)
+{
+	int i;
+
+	mutex_lock(&probe_late_mutex);
+	if (probe_late_done || drv->suppress_bind_attrs ||
+	    probe_late_num_drivers == PROBE_LATE_MAX)
+		goto out;
+
+	for (i = 0; i < probe_late_num_names; i++) {
+		if (!strcmp(drv->name, probe_late_names[i])) {
+			drv->probe_late = true;
+			probe_late_drivers[probe_late_num_drivers++] = drv;
+			break;
+		}
+	}
+out:
+	mutex_unlock(&probe_late_mutex);
+}
+
+void driver_probe_late_del(struct device_driver *drv)
+{
+	int i;
+
+	mutex_lock(&probe_late_mutex);
+	for (i = 0; i < probe_late_num_drivers; i++) {
+		if (probe_late_drivers[i] == drv)
+			probe_late_drivers[i] = NULL;
+	}
+	drv->probe_late = false;
+	mutex_unlock(&probe_late_mutex);
+}
+
+static void driver_probe_late_work_func(struct work_struct *work)
+{
+	struct device_driver *drv;
+	int i;
+
+	mutex_lock(&probe_late_mutex);
+	probe_late_done = true;
+	mutex_unlock(&probe_late_mutex);
+
+	for (i = 0; i < probe_late_num_drivers; i++) {
+		mutex_lock(&probe_late_mutex);
+		drv = probe_late_drivers[i];
+		probe_late_drivers[i] = NULL;
+		if (drv)
+			drv->probe_late = false;
+		mutex_unlock(&probe_late_mutex);
+
+		/* Probing may register drivers, do not hold the mutex */
+		if (drv && drv->bus->p->drivers_autoprobe) {
+			pr_debug("driver: '%s': late probe\n", drv->name);
+			driver_attach(drv);
+		}
+	}
+}
+static DECLARE_WORK(driver_probe_late_work, driver_probe_late_work_func);
+
+static int driver_probe_late_initcall(void)
+{
+	queue_work(system_unbound_wq, &driver_probe_late_work);
+	return 0;
+}
+late_initcall_sync(driver_probe_late_initcall);
+
 static void driver_bound(struct device *dev)
 {
 	if (klist_node_attached(&dev->p->knode_driver)) {
@@ -387,6 +513,9 @@ static int __device_attach(struct device_driver *drv, void *data)
 {
 	struct device *dev = data;
 
+	if (drv->probe_late)
+		return 0;
+
 	if (!driver_match_device(drv, dev))
 		return 0;
 
@@ -449,6 +578,9 @@ static int __driver_attach(struct device *dev, void *data)
 	 * is an error.
 	 */
 
+	if (drv->probe_late)
+		return 0;
+
 	if (!driver_match_device(drv, dev))
 		return 0;
 
@@ -181,9 +181,12 @@ int driver_register(struct device_driver *drv)
 		return -EBUSY;
 	}
 
+	driver_probe_late_add(drv);
 	ret = bus_add_driver(drv);
-	if (ret)
+	if (ret) {
+		driver_probe_late_del(drv);
 		return ret;
+	}
 	ret = driver_add_groups(drv, drv->groups);
 	if (ret)
 		bus_remove_driver(drv);
@@ -203,6 +206,7 @@ void driver_unregister(struct device_driver *drv)
 		WARN(1, "Unexpected driver unregister!\n");
 		return;
 	}
+	driver_probe_late_del(drv);
 	driver_remove_groups(drv, drv->groups);
 	bus_remove_driver(drv);
 }
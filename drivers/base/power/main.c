@@ -171,16 +171,14 @@ void device_pm_move_last(struct device *dev)
 
 static ktime_t initcall_debug_start(struct device *dev)
 {
-	ktime_t calltime = ktime_set(0, 0);
-
 	if (initcall_debug) {
 		pr_info("calling  %s+ @ %i, parent: %s\n",
 			dev_name(dev), task_pid_nr(current),
 			dev->parent ? dev_name(dev->parent) : "none");
-		calltime = ktime_get();
 	}
 
-	return calltime;
+	/* Also the start of the callback for dpm_times_record() */
+	return ktime_get();
 }
 
 static void initcall_debug_report(struct device *dev, ktime_t calltime,
@@ -392,6 +390,7 @@ static int dpm_run_callback(pm_callback_t cb, struct device *dev,
 	suspend_report_result(cb, error);
 
 	initcall_debug_report(dev, calltime, error);
+	dpm_times_record(dev, pm_verb(state.event), info, calltime, error);
 
 	return error;
 }
@@ -1080,6 +1079,8 @@ static int legacy_suspend(struct device *dev, pm_message_t state,
 	suspend_report_result(cb, error);
 
 	initcall_debug_report(dev, calltime, error);
+	dpm_times_record(dev, pm_verb(state.event), "legacy ", calltime,
+			 error);
 
 	return error;
 }
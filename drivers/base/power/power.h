@@ -1,3 +1,4 @@
+#include <linux/ktime.h>
 #include <linux/pm_qos.h>
 
 #ifdef CONFIG_PM_RUNTIME
@@ -32,6 +33,16 @@ extern void device_pm_move_before(struct device *, struct device *);
 extern void device_pm_move_after(struct device *, struct device *);
 extern void device_pm_move_last(struct device *);
 
+/* drivers/base/power/times.c */
+#ifdef CONFIG_PM_SLEEP_DEVICE_TIMES
+extern void dpm_times_record(struct device *dev, const char *verb,
+			     const char *info, ktime_t start, int error);
+#else
+static inline void dpm_times_record(struct device *dev, const char *verb,
+				    const char *info, ktime_t start,
+				    int error) {}
+#endif
+
 #else /* !CONFIG_PM_SLEEP */
 
 static inline void device_pm_init(struct device *dev)
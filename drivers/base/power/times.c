@@ -0,0 +1,116 @@
+/*
+ * drivers/base/power/times.c - Times of the device suspend and resume callbacks
+ *
+ * This file is released under the GPLv2.
+ */
+
+#include <linux/device.h>
+#include <linux/init.h>
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+#include <linux/seq_file.h>
+#include <linux/debugfs.h>
+
+#include "power.h"
+
+/*
+ * The last DPM_TIMES_ENTRIES callbacks run by the PM core are kept in a ring,
+ * oldest first in the pm_device_times debugfs file. The start times show
+ * which callbacks ran in parallel, the ones of async devices overlap.
+ */
+#define DPM_TIMES_ENTRIES	256
+#define DPM_TIMES_NAME_LEN	32
+
+struct dpm_times_entry {
+	char name[DPM_TIMES_NAME_LEN];
+	const char *verb;
+	const char *info;
+	ktime_t start;
+	u32 usecs;
+	int error;
+};
+
+static struct dpm_times_entry dpm_times[DPM_TIMES_ENTRIES];
+static unsigned int dpm_times_next;
+static unsigned int dpm_times_count;
+static DEFINE_SPINLOCK(dpm_times_lock);
+
+/**
+ * dpm_times_record - Keep the time of a device PM callback.
+ * @dev: Device the callback was run for.
+ * @verb: PM transition, as printed by the PM core.
+ * @info: Phase and kind of the callback, as printed by the PM core.
+ * @start: Time the callback was called at.
+ * @error: Value the callback returned.
+ */
+void dpm_times_record(struct device *dev, const char *verb, const char *info,
+		      ktime_t start, int error)
+{
+	u32 usecs = ktime_us_delta(ktime_get(), start);
+	struct dpm_times_entry *entry;
+	unsigned long flags;
+
+	spin_lock_irqsave(&dpm_times_lock, flags);
+	entry = &dpm_times[dpm_times_next];
+	strlcpy(entry->name, dev_name(dev), sizeof(entry->name));
+	entry->verb = verb;
+	entry->info = info ? info : "";
+	entry->start = start;
+	entry->usecs = usecs;
+	entry->error = error;
+	dpm_times_next = (dpm_times_next + 1) % DPM_TIMES_ENTRIES;
+	if (dpm_times_count < DPM_TIMES_ENTRIES)
+		dpm_times_count++;
+	spin_unlock_irqrestore(&dpm_times_lock, flags);
+}
+
+static int dpm_times_show(struct seq_file *m, void *unused)
+{
+	struct dpm_times_entry entry;
+	unsigned long flags;
+	unsigned int first;
+	unsigned int i;
+
+	seq_puts(m, "start_us        usecs error event    callback"
+		    "                device\n");
+
+	for (i = 0; ; i++) {
+		spin_lock_irqsave(&dpm_times_lock, flags);
+		if (i >= dpm_times_count) {
+			spin_unlock_irqrestore(&dpm_times_lock, flags);
+			break;
+		}
+		first = (dpm_times_next + DPM_TIMES_ENTRIES - dpm_times_count) %
+			DPM_TIMES_ENTRIES;
+		entry = dpm_times[(first + i) % DPM_TIMES_ENTRIES];
+		spin_unlock_irqrestore(&dpm_times_lock, flags);
+
+		seq_printf(m, "%-15lld %5u %5d %-8s %-23s %s\n",
+			   ktime_to_us(entry.start), entry.usecs, entry.error,
+			   entry.verb, entry.info, entry.name);
+	}
+
+	return 0;
+}
+
+static int dpm_times_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dpm_times_show, NULL);
+}
+
+static const struct file_operations dpm_times_fops = {
+	.owner = THIS_MODULE,
+	.open = dpm_times_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int __init dpm_times_debugfs_init(void)
+{
+	debugfs_create_file("pm_device_times", S_IRUGO, NULL, NULL,
+			    &dpm_times_fops);
+	return 0;
+}
+
+postcore_initcall(dpm_times_debugfs_init);
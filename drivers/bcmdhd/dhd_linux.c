@@ -353,6 +353,8 @@ typedef struct dhd_info {
 	bool rpcth_timer_active;
 	bool fdaggr;
 #endif
+	/* GRO context of the packets received in the DPC thread */
+	struct napi_struct rx_napi;
 } dhd_info_t;
 
 /* Flag to indicate if we should download firmware on driver load */
@@ -1736,6 +1738,12 @@ static const char *_get_packet_type_str(uint16 type)
 }
 #endif /* DHD_RX_DUMP */
 
+static int
+dhd_rx_napi_poll(struct napi_struct *napi, int budget)
+{
+	return 0;
+}
+
 void
 dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 {
@@ -1749,6 +1757,7 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 	wl_event_msg_t event;
 	int tout_rx = 0;
 	int tout_ctrl = 0;
+	struct sk_buff_head rxq;
 
 #ifdef DHD_RX_DUMP
 #ifdef DHD_RX_FULL_DUMP
@@ -1760,6 +1769,8 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 
 	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
 
+	__skb_queue_head_init(&rxq);
+
 	for (i = 0; pktbuf && i < numpkt; i++, pktbuf = pnext) {
 #ifdef WLBTAMP
 		struct ether_header *eh;
@@ -1940,25 +1951,22 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 		dhdp->dstats.rx_bytes += skb->len;
 		dhdp->rx_packets++; /* Local count */
 
-		if (in_interrupt()) {
-			netif_rx(skb);
-		} else {
-			/* If the receive is not processed inside an ISR,
-			 * the softirqd must be woken explicitly to service
-			 * the NET_RX_SOFTIRQ.  In 2.6 kernels, this is handled
-			 * by netif_rx_ni(), but in earlier kernels, we need
-			 * to do it manually.
-			 */
-#if LINUX_VERSION_CODE_FAKE >= KERNEL_VERSION(2, 6, 0)
-			netif_rx_ni(skb);
-#else
-			ulong flags;
+		__skb_queue_tail(&rxq, skb);
+	}
+
+	/* From the DPC thread the chain goes through GRO in one bottom half
+	 * disabled section, so the TCP segments of a glom are merged before
+	 * the stack sees them. The DPC thread is the only user of rx_napi.
+	 */
+	if (in_interrupt()) {
+		while ((skb = __skb_dequeue(&rxq)) != NULL)
 			netif_rx(skb);
-			local_irq_save(flags);
-			RAISE_RX_SOFTIRQ();
-			local_irq_restore(flags);
-#endif /* LINUX_VERSION_CODE_FAKE >= KERNEL_VERSION(2, 6, 0) */
-		}
+	} else {
+		local_bh_disable();
+		while ((skb = __skb_dequeue(&rxq)) != NULL)
+			napi_gro_receive(&dhd->rx_napi, skb);
+		napi_gro_flush(&dhd->rx_napi);
+		local_bh_enable();
 	}
 
 	DHD_OS_WAKE_LOCK_RX_TIMEOUT_ENABLE(dhdp, tout_rx);
@@ -3156,6 +3164,9 @@ dhd_attach(osl_t *osh, struct dhd_bus *bus, uint bus_hdrlen)
 	memcpy((void *)netdev_priv(net), &dhd, sizeof(dhd));
 	dhd->pub.osh = osh;
 
+	/* Never scheduled, only holds the GRO list of dhd_rx_frame() */
+	netif_napi_add(net, &dhd->rx_napi, dhd_rx_napi_poll, 64);
+
 	/* Link to info module */
 	dhd->pub.info = dhd;
 	/* Link to bus module */
@@ -13,9 +13,14 @@
 #include <linux/slab.h>
 #include <linux/wait.h>
 #include <linux/sched.h>
+#include <linux/cpu.h>
 
 #include "zcomp.h"
+#include "zcomp_lzo.h"
+#ifdef CONFIG_ZRAM_LZ4_COMPRESS
 #include "zcomp_lz4.h"
+#include "zcomp_lz4hc.h"
+#endif
 
 /*
  * single zcomp_strm backend
@@ -38,10 +43,17 @@ struct zcomp_strm_multi {
 	/* list of available strms */
 	struct list_head idle_strm;
 	wait_queue_head_t strm_wait;
+	/* preallocates and trims streams as CPUs come and go */
+	struct notifier_block cpu_notifier;
+	struct zcomp *comp;
 };
 
 static struct zcomp_backend *backends[] = {
+	&zcomp_lzo,
+#ifdef CONFIG_ZRAM_LZ4_COMPRESS
 	&zcomp_lz4,
+	&zcomp_lz4hc,
+#endif
 	NULL
 };
 
@@ -87,6 +99,16 @@ static struct zcomp_strm *zcomp_strm_alloc(struct zcomp *comp)
 	return zstrm;
 }
 
+/*
+ * there is no point in having more streams than CPUs that can run
+ * compression concurrently, so ->max_strm is also capped by the number
+ * of online CPUs
+ */
+static inline int zcomp_strm_multi_limit(struct zcomp_strm_multi *zs)
+{
+	return min_t(int, zs->max_strm, num_online_cpus());
+}
+
 /*
  * get idle zcomp_strm or wait until other process release
  * (zcomp_strm_release()) one for us
@@ -106,8 +128,9 @@ static struct zcomp_strm *zcomp_strm_multi_find(struct zcomp *comp)
 			return zstrm;
 		}
 		/* zstrm streams limit reached, wait for idle stream */
-		if (zs->avail_strm >= zs->max_strm) {
+		if (zs->avail_strm >= zcomp_strm_multi_limit(zs)) {
 			spin_unlock(&zs->strm_lock);
+			atomic64_inc(&comp->contended);
 			wait_event(zs->strm_wait, !list_empty(&zs->idle_strm));
 			continue;
 		}
@@ -120,6 +143,7 @@ static struct zcomp_strm *zcomp_strm_multi_find(struct zcomp *comp)
 			spin_lock(&zs->strm_lock);
 			zs->avail_strm--;
 			spin_unlock(&zs->strm_lock);
+			atomic64_inc(&comp->contended);
 			wait_event(zs->strm_wait, !list_empty(&zs->idle_strm));
 			continue;
 		}
@@ -134,7 +158,7 @@ static void zcomp_strm_multi_release(struct zcomp *comp, struct zcomp_strm *zstr
 	struct zcomp_strm_multi *zs = comp->stream;
 
 	spin_lock(&zs->strm_lock);
-	if (zs->avail_strm <= zs->max_strm) {
+	if (zs->avail_strm <= zcomp_strm_multi_limit(zs)) {
 		list_add(&zstrm->list, &zs->idle_strm);
 		spin_unlock(&zs->strm_lock);
 		wake_up(&zs->strm_wait);
@@ -146,26 +170,88 @@ static void zcomp_strm_multi_release(struct zcomp *comp, struct zcomp_strm *zstr
 	zcomp_strm_free(comp, zstrm);
 }
 
-/* change max_strm limit */
-static bool zcomp_strm_multi_set_max_streams(struct zcomp *comp, int num_strm)
+/*
+ * free idle streams above the current limit. called when the limit is
+ * lowered, either by user or by a CPU going offline.
+ */
+static void zcomp_strm_multi_trim(struct zcomp *comp)
 {
 	struct zcomp_strm_multi *zs = comp->stream;
 	struct zcomp_strm *zstrm;
 
 	spin_lock(&zs->strm_lock);
-	zs->max_strm = num_strm;
-	/*
-	 * if user has lowered the limit and there are idle streams,
-	 * immediately free as much streams (and memory) as we can.
-	 */
-	while (zs->avail_strm > num_strm && !list_empty(&zs->idle_strm)) {
+	while (zs->avail_strm > zcomp_strm_multi_limit(zs) &&
+			!list_empty(&zs->idle_strm)) {
 		zstrm = list_entry(zs->idle_strm.next,
 				struct zcomp_strm, list);
 		list_del(&zstrm->list);
-		zcomp_strm_free(comp, zstrm);
 		zs->avail_strm--;
+		spin_unlock(&zs->strm_lock);
+		zcomp_strm_free(comp, zstrm);
+		spin_lock(&zs->strm_lock);
 	}
 	spin_unlock(&zs->strm_lock);
+}
+
+/*
+ * allocate streams up to the current limit ahead of time, so that the
+ * write path does not have to allocate memory under memory pressure
+ */
+static void zcomp_strm_multi_fill(struct zcomp *comp)
+{
+	struct zcomp_strm_multi *zs = comp->stream;
+	struct zcomp_strm *zstrm;
+
+	spin_lock(&zs->strm_lock);
+	while (zs->avail_strm < zcomp_strm_multi_limit(zs)) {
+		zs->avail_strm++;
+		spin_unlock(&zs->strm_lock);
+
+		zstrm = zcomp_strm_alloc(comp);
+
+		spin_lock(&zs->strm_lock);
+		if (!zstrm) {
+			zs->avail_strm--;
+			break;
+		}
+		list_add(&zstrm->list, &zs->idle_strm);
+	}
+	spin_unlock(&zs->strm_lock);
+	wake_up(&zs->strm_wait);
+}
+
+static int zcomp_strm_multi_cpu_notifier(struct notifier_block *nb,
+		unsigned long action, void *pcpu)
+{
+	struct zcomp_strm_multi *zs = container_of(nb,
+			struct zcomp_strm_multi, cpu_notifier);
+
+	switch (action & ~CPU_TASKS_FROZEN) {
+	case CPU_ONLINE:
+		zcomp_strm_multi_fill(zs->comp);
+		break;
+	case CPU_DEAD:
+		zcomp_strm_multi_trim(zs->comp);
+		break;
+	}
+
+	return NOTIFY_OK;
+}
+
+/* change max_strm limit */
+static bool zcomp_strm_multi_set_max_streams(struct zcomp *comp, int num_strm)
+{
+	struct zcomp_strm_multi *zs = comp->stream;
+
+	spin_lock(&zs->strm_lock);
+	zs->max_strm = num_strm;
+	spin_unlock(&zs->strm_lock);
+	/*
+	 * if user has lowered the limit and there are idle streams,
+	 * immediately free as much streams (and memory) as we can.
+	 */
+	zcomp_strm_multi_trim(comp);
+	zcomp_strm_multi_fill(comp);
 	return true;
 }
 
@@ -174,6 +260,7 @@ static void zcomp_strm_multi_destroy(struct zcomp *comp)
 	struct zcomp_strm_multi *zs = comp->stream;
 	struct zcomp_strm *zstrm;
 
+	unregister_hotcpu_notifier(&zs->cpu_notifier);
 	while (!list_empty(&zs->idle_strm)) {
 		zstrm = list_entry(zs->idle_strm.next,
 				struct zcomp_strm, list);
@@ -202,20 +289,31 @@ static int zcomp_strm_multi_create(struct zcomp *comp, int max_strm)
 	init_waitqueue_head(&zs->strm_wait);
 	zs->max_strm = max_strm;
 	zs->avail_strm = 1;
+	zs->comp = comp;
 
 	zstrm = zcomp_strm_alloc(comp);
 	if (!zstrm) {
+		comp->stream = NULL;
 		kfree(zs);
 		return -ENOMEM;
 	}
 	list_add(&zstrm->list, &zs->idle_strm);
+
+	/* one stream per online CPU, the rest is on demand */
+	zcomp_strm_multi_fill(comp);
+	zs->cpu_notifier.notifier_call = zcomp_strm_multi_cpu_notifier;
+	register_hotcpu_notifier(&zs->cpu_notifier);
 	return 0;
 }
 
 static struct zcomp_strm *zcomp_strm_single_find(struct zcomp *comp)
 {
 	struct zcomp_strm_single *zs = comp->stream;
-	mutex_lock(&zs->strm_lock);
+
+	if (!mutex_trylock(&zs->strm_lock)) {
+		atomic64_inc(&comp->contended);
+		mutex_lock(&zs->strm_lock);
+	}
 	return zs->zstrm;
 }
 
@@ -255,6 +353,7 @@ static int zcomp_strm_single_create(struct zcomp *comp)
 	mutex_init(&zs->strm_lock);
 	zs->zstrm = zcomp_strm_alloc(comp);
 	if (!zs->zstrm) {
+		comp->stream = NULL;
 		kfree(zs);
 		return -ENOMEM;
 	}
@@ -285,6 +384,11 @@ bool zcomp_set_max_streams(struct zcomp *comp, int num_strm)
 	return comp->set_max_streams(comp, num_strm);
 }
 
+u64 zcomp_strm_contended(struct zcomp *comp)
+{
+	return (u64)atomic64_read(&comp->contended);
+}
+
 struct zcomp_strm *zcomp_strm_find(struct zcomp *comp)
 {
 	return comp->strm_find(comp);
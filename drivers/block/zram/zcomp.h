@@ -11,6 +11,7 @@
 #define _ZCOMP_H_
 
 #include <linux/mutex.h>
+#include <linux/atomic.h>
 
 struct zcomp_strm {
 	/* compression/decompression buffer */
@@ -43,6 +44,8 @@ struct zcomp_backend {
 struct zcomp {
 	void *stream;
 	struct zcomp_backend *backend;
+	/* number of times a writer had to wait for an idle stream */
+	atomic64_t contended;
 
 	struct zcomp_strm *(*strm_find)(struct zcomp *comp);
 	void (*strm_release)(struct zcomp *comp, struct zcomp_strm *zstrm);
@@ -65,4 +68,5 @@ int zcomp_decompress(struct zcomp *comp, const unsigned char *src,
 		size_t src_len, unsigned char *dst);
 
 bool zcomp_set_max_streams(struct zcomp *comp, int num_strm);
+u64 zcomp_strm_contended(struct zcomp *comp);
 #endif /* _ZCOMP_H_ */
@@ -0,0 +1,171 @@
+/*
+ * Compressed RAM block device: content based deduplication
+ *
+ * Identical pages (e.g. pages of forked zygote children) are compressed
+ * and stored once. Every stored object is indexed by a checksum of its
+ * uncompressed content; a new page whose checksum matches an existing
+ * object is compared byte by byte and, if identical, the table slot
+ * just takes a reference on the existing object.
+ *
+ * This code is released using a dual license strategy: BSD/GPL
+ * You can choose the licence that better fits your requirements.
+ *
+ * Released under the terms of 3-clause BSD License
+ * Released under the terms of GNU General Public License Version 2.0
+ *
+ */
+
+#define KMSG_COMPONENT "zram"
+#define pr_fmt(fmt) KMSG_COMPONENT ": " fmt
+
+#include <linux/kernel.h>
+#include <linux/jhash.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#include "zram_drv.h"
+
+u32 zram_dedup_checksum(unsigned char *mem)
+{
+	return jhash(mem, PAGE_SIZE, 0);
+}
+
+void zram_dedup_init(struct zram_meta *meta, bool use_dedup)
+{
+	meta->use_dedup = use_dedup;
+	meta->dedup_root = RB_ROOT;
+	spin_lock_init(&meta->dedup_lock);
+}
+
+/* called with meta->dedup_lock held */
+static bool zram_dedup_match(struct zram *zram, struct zram_entry *entry,
+				unsigned char *mem, unsigned char *buf)
+{
+	struct zram_meta *meta = zram->meta;
+	unsigned char *cmem;
+	bool match = false;
+
+	cmem = zs_map_object(meta->mem_pool, entry->handle, ZS_MM_RO);
+	if (entry->len == PAGE_SIZE) {
+		match = !memcmp(mem, cmem, PAGE_SIZE);
+	} else {
+		if (!zcomp_decompress(zram->comp, cmem, entry->len, buf))
+			match = !memcmp(mem, buf, PAGE_SIZE);
+	}
+	zs_unmap_object(meta->mem_pool, entry->handle);
+
+	return match;
+}
+
+/*
+ * Look up an object with the same content as @mem. @buf is a PAGE_SIZE
+ * scratch buffer used to decompress candidates. On success the returned
+ * entry has been referenced on behalf of the caller.
+ */
+struct zram_entry *zram_dedup_find(struct zram *zram, unsigned char *mem,
+				u32 checksum, unsigned char *buf)
+{
+	struct zram_meta *meta = zram->meta;
+	struct rb_node *rb_node, *node;
+	struct zram_entry *entry;
+
+	spin_lock(&meta->dedup_lock);
+	rb_node = meta->dedup_root.rb_node;
+	while (rb_node) {
+		entry = rb_entry(rb_node, struct zram_entry, rb_node);
+		if (checksum == entry->checksum)
+			break;
+		if (checksum < entry->checksum)
+			rb_node = rb_node->rb_left;
+		else
+			rb_node = rb_node->rb_right;
+	}
+
+	if (!rb_node)
+		goto miss;
+
+	/* entries with equal checksum are adjacent in the tree */
+	for (node = rb_node; node; node = rb_prev(node)) {
+		entry = rb_entry(node, struct zram_entry, rb_node);
+		if (entry->checksum != checksum)
+			break;
+		if (zram_dedup_match(zram, entry, mem, buf))
+			goto hit;
+	}
+	for (node = rb_next(rb_node); node; node = rb_next(node)) {
+		entry = rb_entry(node, struct zram_entry, rb_node);
+		if (entry->checksum != checksum)
+			break;
+		if (zram_dedup_match(zram, entry, mem, buf))
+			goto hit;
+	}
+miss:
+	spin_unlock(&meta->dedup_lock);
+	return NULL;
+
+hit:
+	entry->refcount++;
+	spin_unlock(&meta->dedup_lock);
+
+	return entry;
+}
+
+/*
+ * Index a freshly stored object. Returns NULL if the entry cannot be
+ * allocated; the caller still owns @handle then.
+ */
+struct zram_entry *zram_dedup_insert(struct zram_meta *meta,
+				unsigned long handle, size_t len, u32 checksum)
+{
+	struct rb_node **rb_node, *parent = NULL;
+	struct zram_entry *entry, *cur;
+
+	entry = kmalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return NULL;
+
+	entry->checksum = checksum;
+	entry->len = len;
+	entry->refcount = 1;
+	entry->handle = handle;
+
+	spin_lock(&meta->dedup_lock);
+	rb_node = &meta->dedup_root.rb_node;
+	while (*rb_node) {
+		parent = *rb_node;
+		cur = rb_entry(parent, struct zram_entry, rb_node);
+		if (checksum < cur->checksum)
+			rb_node = &parent->rb_left;
+		else
+			rb_node = &parent->rb_right;
+	}
+	rb_link_node(&entry->rb_node, parent, rb_node);
+	rb_insert_color(&entry->rb_node, &meta->dedup_root);
+	spin_unlock(&meta->dedup_lock);
+
+	return entry;
+}
+
+/*
+ * Drop a slot's reference. Returns true if that was the last one and the
+ * compressed object has been freed, false if other slots still share it.
+ */
+bool zram_dedup_put(struct zram_meta *meta, struct zram_entry *entry)
+{
+	bool freed = false;
+
+	spin_lock(&meta->dedup_lock);
+	if (--entry->refcount == 0) {
+		rb_erase(&entry->rb_node, &meta->dedup_root);
+		freed = true;
+	}
+	spin_unlock(&meta->dedup_lock);
+
+	if (freed) {
+		zs_free(meta->mem_pool, entry->handle);
+		kfree(entry);
+	}
+
+	return freed;
+}
@@ -0,0 +1,62 @@
+/*
+ * Compressed RAM block device: content based deduplication
+ *
+ * This code is released using a dual license strategy: BSD/GPL
+ * You can choose the licence that better fits your requirements.
+ *
+ * Released under the terms of 3-clause BSD License
+ * Released under the terms of GNU General Public License Version 2.0
+ *
+ */
+
+#ifndef _ZRAM_DEDUP_H_
+#define _ZRAM_DEDUP_H_
+
+#include <linux/types.h>
+#include <linux/rbtree.h>
+
+struct zram;
+struct zram_meta;
+
+/*
+ * One compressed object which may be shared by several table slots.
+ * Only used when deduplication is enabled for the device, table slots
+ * then point to zram_entry instead of holding a zsmalloc handle.
+ */
+struct zram_entry {
+	struct rb_node rb_node;
+	u32 checksum;
+	u32 len;
+	unsigned long refcount;
+	unsigned long handle;
+};
+
+#ifdef CONFIG_ZRAM_DEDUP
+u32 zram_dedup_checksum(unsigned char *mem);
+struct zram_entry *zram_dedup_find(struct zram *zram, unsigned char *mem,
+				u32 checksum, unsigned char *buf);
+struct zram_entry *zram_dedup_insert(struct zram_meta *meta,
+				unsigned long handle, size_t len, u32 checksum);
+bool zram_dedup_put(struct zram_meta *meta, struct zram_entry *entry);
+void zram_dedup_init(struct zram_meta *meta, bool use_dedup);
+#else
+static inline u32 zram_dedup_checksum(unsigned char *mem) { return 0; }
+static inline struct zram_entry *zram_dedup_find(struct zram *zram,
+		unsigned char *mem, u32 checksum, unsigned char *buf)
+{
+	return NULL;
+}
+static inline struct zram_entry *zram_dedup_insert(struct zram_meta *meta,
+		unsigned long handle, size_t len, u32 checksum)
+{
+	return NULL;
+}
+static inline bool zram_dedup_put(struct zram_meta *meta,
+		struct zram_entry *entry)
+{
+	return false;
+}
+static inline void zram_dedup_init(struct zram_meta *meta, bool use_dedup) {}
+#endif
+
+#endif /* _ZRAM_DEDUP_H_ */
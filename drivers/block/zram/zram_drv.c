@@ -32,6 +32,10 @@
 #include <linux/string.h>
 #include <linux/vmalloc.h>
 #include <linux/ratelimit.h>
+#include <linux/file.h>
+#include <linux/fs.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <linux/err.h>
 
@@ -59,7 +63,11 @@ void page_endio(struct page *page, int rw, int err);
 /* Globals */
 static int zram_major;
 static struct zram *zram_devices;
+#ifdef CONFIG_ZRAM_LZ4_COMPRESS
 static const char *default_compressor = "lz4";
+#else
+static const char *default_compressor = "lzo";
+#endif
 
 /*
  * We don't need to see memory allocation errors more than once every 1
@@ -69,6 +77,7 @@ static const char *default_compressor = "lz4";
 
 /* Module params (documentation at end) */
 extern unsigned int zram_num_devices;
+static unsigned int num_devices;
 
 static inline void deprecated_attr_warn(const char *name)
 {
@@ -183,6 +192,20 @@ static ssize_t max_comp_streams_show(struct device *dev,
 	return scnprintf(buf, PAGE_SIZE, "%d\n", val);
 }
 
+static ssize_t comp_streams_contended_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	u64 val = 0;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	if (init_done(zram))
+		val = zcomp_strm_contended(zram->comp);
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%llu\n", val);
+}
+
 static ssize_t mem_limit_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
@@ -309,6 +332,41 @@ static ssize_t comp_algorithm_store(struct device *dev,
 	return len;
 }
 
+#ifdef CONFIG_ZRAM_DEDUP
+static ssize_t use_dedup_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	bool val;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	val = zram->use_dedup;
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", (int)val);
+}
+
+static ssize_t use_dedup_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	int val;
+	struct zram *zram = dev_to_zram(dev);
+
+	if (kstrtoint(buf, 10, &val) || (val != 0 && val != 1))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change dedup usage for initialized device\n");
+		return -EBUSY;
+	}
+	zram->use_dedup = val;
+	up_write(&zram->init_lock);
+	return len;
+}
+#endif
+
 /* flag operations needs meta->tb_lock */
 static int zram_test_flag(struct zram_meta *meta, u32 index,
 			enum zram_pageflags flag)
@@ -341,6 +399,23 @@ static void zram_set_obj_size(struct zram_meta *meta,
 	meta->table[index].value = (flags << ZRAM_FLAG_SHIFT) | size;
 }
 
+static inline bool zram_dedup_enabled(struct zram_meta *meta)
+{
+#ifdef CONFIG_ZRAM_DEDUP
+	return meta->use_dedup;
+#else
+	return false;
+#endif
+}
+
+/* zsmalloc handle of a stored (not same filled) page */
+static unsigned long zram_get_handle(struct zram_meta *meta, u32 index)
+{
+	if (zram_dedup_enabled(meta))
+		return meta->table[index].entry->handle;
+	return meta->table[index].handle;
+}
+
 static inline int is_partial_io(struct bio_vec *bvec)
 {
 	return bvec->bv_len != PAGE_SIZE;
@@ -379,9 +454,14 @@ static void zram_meta_free(struct zram_meta *meta, u64 disksize)
 	for (index = 0; index < num_pages; index++) {
 		unsigned long handle = meta->table[index].handle;
 
-		if (!handle)
+		if (!handle || zram_test_flag(meta, index, ZRAM_SAME) ||
+				zram_test_flag(meta, index, ZRAM_WB))
 			continue;
 
+		if (zram_dedup_enabled(meta)) {
+			zram_dedup_put(meta, meta->table[index].entry);
+			continue;
+		}
 		zs_free(meta->mem_pool, handle);
 	}
 
@@ -390,7 +470,8 @@ static void zram_meta_free(struct zram_meta *meta, u64 disksize)
 	kfree(meta);
 }
 
-static struct zram_meta *zram_meta_alloc(int device_id, u64 disksize)
+static struct zram_meta *zram_meta_alloc(int device_id, u64 disksize,
+					bool use_dedup)
 {
 	size_t num_pages;
 	char pool_name[8];
@@ -413,6 +494,7 @@ static struct zram_meta *zram_meta_alloc(int device_id, u64 disksize)
 		pr_err("Error creating memory pool\n");
 		goto out_error;
 	}
+	zram_dedup_init(meta, use_dedup);
 
 	return meta;
 
@@ -431,7 +513,8 @@ static inline bool zram_meta_get(struct zram *zram)
 
 static inline void zram_meta_put(struct zram *zram)
 {
-	atomic_dec(&zram->refcount);
+	if (atomic_dec_and_test(&zram->refcount))
+		wake_up(&zram->io_done);
 }
 
 static void update_position(u32 *index, int *offset, struct bio_vec *bvec)
@@ -441,36 +524,621 @@ static void update_position(u32 *index, int *offset, struct bio_vec *bvec)
 	*offset = (*offset + bvec->bv_len) % PAGE_SIZE;
 }
 
-static int page_zero_filled(void *ptr)
+/*
+ * Check whether the page is filled with one repeated machine word and
+ * return that word in @element. Zero filled pages are the common case.
+ */
+static int page_same_filled(void *ptr, unsigned long *element)
 {
 	unsigned int pos;
 	unsigned long *page;
+	unsigned long val;
 
 	page = (unsigned long *)ptr;
+	val = page[0];
 
-	for (pos = 0; pos != PAGE_SIZE / sizeof(*page); pos++) {
-		if (page[pos])
+	for (pos = 1; pos != PAGE_SIZE / sizeof(*page); pos++) {
+		if (page[pos] != val)
 			return 0;
 	}
 
+	*element = val;
 	return 1;
 }
 
-static void handle_zero_page(struct bio_vec *bvec)
+static void zram_fill_page(char *ptr, unsigned long len,
+					unsigned long value)
+{
+	unsigned long *page = (unsigned long *)ptr;
+	int i;
+
+	WARN_ON_ONCE(!IS_ALIGNED(len, sizeof(unsigned long)));
+	if (likely(value == 0)) {
+		memset(ptr, 0, len);
+	} else {
+		for (i = 0; i < len / sizeof(*page); i++)
+			page[i] = value;
+	}
+}
+
+static void handle_same_page(struct bio_vec *bvec, unsigned long element)
 {
 	struct page *page = bvec->bv_page;
 	void *user_mem;
 
 	user_mem = kmap_atomic(page);
-	if (is_partial_io(bvec))
-		memset(user_mem + bvec->bv_offset, 0, bvec->bv_len);
-	else
+	if (is_partial_io(bvec)) {
+		/*
+		 * partial I/O starts at a word aligned offset for any
+		 * sector aligned request, so the pattern stays in phase
+		 */
+		zram_fill_page(user_mem + bvec->bv_offset, bvec->bv_len,
+				element);
+	} else if (!element) {
 		clear_page(user_mem);
+	} else {
+		zram_fill_page(user_mem, PAGE_SIZE, element);
+	}
 	kunmap_atomic(user_mem);
 
 	flush_dcache_page(page);
 }
 
+static void zram_accessed(struct zram_meta *meta, u32 index)
+{
+	zram_clear_flag(meta, index, ZRAM_IDLE);
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+	meta->table[index].ac_time = jiffies;
+#endif
+}
+
+static inline bool zram_allocated(struct zram_meta *meta, u32 index)
+{
+	return meta->table[index].handle ||
+			zram_test_flag(meta, index, ZRAM_ZERO);
+}
+
+/*
+ * Mark every stored slot idle. Slots that are read or written
+ * afterwards lose the flag again, so what is still idle at the next
+ * "writeback idle" has not been touched in between.
+ */
+static ssize_t idle_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zram_meta *meta;
+	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	unsigned long index;
+
+	if (!sysfs_streq(buf, "all"))
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		up_read(&zram->init_lock);
+		return -EINVAL;
+	}
+
+	meta = zram->meta;
+	for (index = 0; index < nr_pages; index++) {
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (zram_allocated(meta, index) &&
+				!zram_test_flag(meta, index, ZRAM_UNDER_WB))
+			zram_set_flag(meta, index, ZRAM_IDLE);
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+	}
+
+	up_read(&zram->init_lock);
+
+	return len;
+}
+
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+static struct dentry *zram_debugfs_root;
+
+/* age buckets in seconds: <1, 1-2, 2-4, ... 2^(N-2) and above */
+#define ZRAM_AGE_BUCKETS	18
+
+static void zram_debugfs_create(void)
+{
+	zram_debugfs_root = debugfs_create_dir("zram", NULL);
+}
+
+static void zram_debugfs_destroy(void)
+{
+	debugfs_remove_recursive(zram_debugfs_root);
+}
+
+static ssize_t read_block_state(struct file *file, char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	char *kbuf;
+	ssize_t index, written = 0;
+	struct zram *zram = file->private_data;
+	struct zram_meta *meta;
+	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	unsigned long now = jiffies;
+
+	kbuf = vmalloc(count);
+	if (!kbuf)
+		return -ENOMEM;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		up_read(&zram->init_lock);
+		vfree(kbuf);
+		return -EINVAL;
+	}
+
+	meta = zram->meta;
+	for (index = *ppos; index < nr_pages; index++) {
+		int copied;
+
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (!zram_allocated(meta, index))
+			goto next;
+
+		copied = snprintf(kbuf + written, count,
+			"%12zd %12u %c%c%c%c%c\n",
+			index,
+			jiffies_to_msecs(now - meta->table[index].ac_time),
+			zram_test_flag(meta, index, ZRAM_ZERO) ? 'z' : '.',
+			zram_test_flag(meta, index, ZRAM_SAME) ? 's' : '.',
+			zram_test_flag(meta, index, ZRAM_WB) ? 'w' : '.',
+			zram_test_flag(meta, index, ZRAM_HUGE) ? 'h' : '.',
+			zram_test_flag(meta, index, ZRAM_IDLE) ? 'i' : '.');
+
+		if (count < copied) {
+			bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+			break;
+		}
+		written += copied;
+		count -= copied;
+next:
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		*ppos += 1;
+	}
+
+	up_read(&zram->init_lock);
+	if (copy_to_user(buf, kbuf, written))
+		written = -EFAULT;
+	vfree(kbuf);
+
+	return written;
+}
+
+static const struct file_operations proc_zram_block_state_op = {
+	.open = simple_open,
+	.read = read_block_state,
+	.llseek = default_llseek,
+};
+
+static int zram_age_histogram_show(struct seq_file *m, void *v)
+{
+	struct zram *zram = m->private;
+	struct zram_meta *meta;
+	unsigned long hist[ZRAM_AGE_BUCKETS] = { 0 };
+	unsigned long idle[ZRAM_AGE_BUCKETS] = { 0 };
+	unsigned long nr_pages, index, now = jiffies;
+	int i;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		up_read(&zram->init_lock);
+		return 0;
+	}
+
+	meta = zram->meta;
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		unsigned long age;
+
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (zram_allocated(meta, index)) {
+			age = (now - meta->table[index].ac_time) / HZ;
+			i = min_t(int, fls_long(age), ZRAM_AGE_BUCKETS - 1);
+			hist[i]++;
+			if (zram_test_flag(meta, index, ZRAM_IDLE))
+				idle[i]++;
+		}
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		if (!(index % 4096))
+			cond_resched();
+	}
+	up_read(&zram->init_lock);
+
+	seq_printf(m, "%-14s %10s %10s\n", "age(s)", "slots", "idle");
+	for (i = 0; i < ZRAM_AGE_BUCKETS; i++) {
+		char range[16];
+
+		if (!i)
+			snprintf(range, sizeof(range), "<1");
+		else if (i == ZRAM_AGE_BUCKETS - 1)
+			snprintf(range, sizeof(range), ">=%lu", 1UL << (i - 1));
+		else
+			snprintf(range, sizeof(range), "%lu-%lu",
+					1UL << (i - 1), (1UL << i) - 1);
+		seq_printf(m, "%-14s %10lu %10lu\n", range, hist[i], idle[i]);
+	}
+
+	return 0;
+}
+
+static int zram_age_histogram_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, zram_age_histogram_show, inode->i_private);
+}
+
+static const struct file_operations zram_age_histogram_fops = {
+	.open = zram_age_histogram_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void zram_debugfs_register(struct zram *zram)
+{
+	if (!zram_debugfs_root)
+		return;
+
+	zram->debugfs_dir = debugfs_create_dir(zram->disk->disk_name,
+						zram_debugfs_root);
+	debugfs_create_file("block_state", 0400, zram->debugfs_dir,
+				zram, &proc_zram_block_state_op);
+	debugfs_create_file("age_histogram", 0400, zram->debugfs_dir,
+				zram, &zram_age_histogram_fops);
+}
+
+static void zram_debugfs_unregister(struct zram *zram)
+{
+	debugfs_remove_recursive(zram->debugfs_dir);
+}
+#else
+static void zram_debugfs_create(void) {}
+static void zram_debugfs_destroy(void) {}
+static void zram_debugfs_register(struct zram *zram) {}
+static void zram_debugfs_unregister(struct zram *zram) {}
+#endif
+
+#ifdef CONFIG_ZRAM_WRITEBACK
+static bool zram_wb_enabled(struct zram *zram)
+{
+	return zram->backing_dev;
+}
+
+static void reset_bdev(struct zram *zram)
+{
+	struct block_device *bdev;
+
+	if (!zram_wb_enabled(zram))
+		return;
+
+	bdev = zram->bdev;
+	/* hope filp_close flush all of IO */
+	set_blocksize(bdev, zram->old_block_size);
+	blkdev_put(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+	filp_close(zram->backing_dev, NULL);
+	zram->backing_dev = NULL;
+	zram->old_block_size = 0;
+	zram->bdev = NULL;
+
+	vfree(zram->bitmap);
+	zram->bitmap = NULL;
+	zram->nr_pages = 0;
+}
+
+static ssize_t backing_dev_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct file *file;
+	char *p;
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	file = zram->backing_dev;
+	if (!file) {
+		memcpy(buf, "none\n", 5);
+		up_read(&zram->init_lock);
+		return 5;
+	}
+
+	p = d_path(&file->f_path, buf, PAGE_SIZE - 1);
+	if (IS_ERR(p)) {
+		ret = PTR_ERR(p);
+		goto out;
+	}
+
+	ret = strlen(p);
+	memmove(buf, p, ret);
+	buf[ret++] = '\n';
+out:
+	up_read(&zram->init_lock);
+	return ret;
+}
+
+static ssize_t backing_dev_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	char *file_name;
+	size_t sz;
+	struct file *backing_dev = NULL;
+	struct inode *inode;
+	struct address_space *mapping;
+	unsigned int old_block_size = 0;
+	unsigned long nr_pages, *bitmap = NULL;
+	struct block_device *bdev = NULL;
+	int err;
+	struct zram *zram = dev_to_zram(dev);
+
+	file_name = kmalloc(PATH_MAX, GFP_KERNEL);
+	if (!file_name)
+		return -ENOMEM;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		pr_info("Can't setup backing device for initialized device\n");
+		err = -EBUSY;
+		goto out;
+	}
+
+	strlcpy(file_name, buf, PATH_MAX);
+	/* ignore trailing newline */
+	sz = strlen(file_name);
+	if (sz > 0 && file_name[sz - 1] == '\n')
+		file_name[sz - 1] = 0x00;
+
+	backing_dev = filp_open(file_name, O_RDWR | O_LARGEFILE, 0);
+	if (IS_ERR(backing_dev)) {
+		err = PTR_ERR(backing_dev);
+		backing_dev = NULL;
+		goto out;
+	}
+
+	mapping = backing_dev->f_mapping;
+	inode = mapping->host;
+
+	/* Support only block device in this moment */
+	if (!S_ISBLK(inode->i_mode)) {
+		err = -ENOTBLK;
+		goto out;
+	}
+
+	bdev = bdgrab(I_BDEV(inode));
+	err = blkdev_get(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL, zram);
+	if (err < 0) {
+		bdev = NULL;
+		goto out;
+	}
+
+	nr_pages = i_size_read(inode) >> PAGE_SHIFT;
+	bitmap = vzalloc(BITS_TO_LONGS(nr_pages) * sizeof(long));
+	if (!bitmap) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	old_block_size = block_size(bdev);
+	err = set_blocksize(bdev, PAGE_SIZE);
+	if (err)
+		goto out;
+
+	reset_bdev(zram);
+
+	zram->old_block_size = old_block_size;
+	zram->bdev = bdev;
+	zram->backing_dev = backing_dev;
+	zram->bitmap = bitmap;
+	zram->nr_pages = nr_pages;
+	up_write(&zram->init_lock);
+
+	pr_info("setup backing device %s\n", file_name);
+	kfree(file_name);
+
+	return len;
+out:
+	vfree(bitmap);
+
+	if (bdev)
+		blkdev_put(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+
+	if (backing_dev)
+		filp_close(backing_dev, NULL);
+
+	up_write(&zram->init_lock);
+
+	kfree(file_name);
+
+	return err;
+}
+
+static unsigned long alloc_block_bdev(struct zram *zram)
+{
+	unsigned long blk_idx = 1;
+retry:
+	/* skip 0 bit to confuse zram.handle = 0 */
+	blk_idx = find_next_zero_bit(zram->bitmap, zram->nr_pages, blk_idx);
+	if (blk_idx >= zram->nr_pages)
+		return 0;
+
+	if (test_and_set_bit(blk_idx, zram->bitmap))
+		goto retry;
+
+	atomic64_inc(&zram->stats.bd_count);
+	return blk_idx;
+}
+
+static void free_block_bdev(struct zram *zram, unsigned long blk_idx)
+{
+	int was_set;
+
+	was_set = test_and_clear_bit(blk_idx, zram->bitmap);
+	WARN_ON_ONCE(!was_set);
+	atomic64_dec(&zram->stats.bd_count);
+}
+
+static void zram_bdev_end_io_sync(struct bio *bio, int err)
+{
+	complete(bio->bi_private);
+}
+
+/* read or write one page of the backing device and wait for it */
+static int zram_bdev_rw_sync(struct zram *zram, struct page *page,
+			unsigned long blk_idx, int rw)
+{
+	DECLARE_COMPLETION_ONSTACK(done);
+	struct bio *bio;
+	int ret;
+
+	bio = bio_alloc(GFP_NOIO, 1);
+	if (!bio)
+		return -ENOMEM;
+
+	bio->bi_sector = blk_idx * (PAGE_SIZE >> SECTOR_SHIFT);
+	bio->bi_bdev = zram->bdev;
+	if (!bio_add_page(bio, page, PAGE_SIZE, 0)) {
+		bio_put(bio);
+		return -EIO;
+	}
+	bio->bi_private = &done;
+	bio->bi_end_io = zram_bdev_end_io_sync;
+
+	submit_bio(rw | REQ_SYNC, bio);
+	wait_for_completion(&done);
+
+	ret = test_bit(BIO_UPTODATE, &bio->bi_flags) ? 0 : -EIO;
+	bio_put(bio);
+
+	if (rw == READ)
+		atomic64_inc(&zram->stats.bd_reads);
+	else
+		atomic64_inc(&zram->stats.bd_writes);
+	return ret;
+}
+
+static void zram_bdev_end_read(struct bio *bio, int err)
+{
+	struct bio *parent = bio->bi_private;
+	struct zram *zram = parent->bi_bdev->bd_disk->private_data;
+
+	if (!err && !test_bit(BIO_UPTODATE, &bio->bi_flags))
+		err = -EIO;
+	if (!err)
+		flush_dcache_page(bio->bi_io_vec[0].bv_page);
+	bio_put(bio);
+
+	if (err)
+		atomic64_inc(&zram->stats.failed_reads);
+	else
+		set_bit(BIO_UPTODATE, &parent->bi_flags);
+	bio_endio(parent, err);
+	zram_meta_put(zram);
+}
+
+/*
+ * Read a whole page from the backing device without waiting for it,
+ * @parent is completed from the bio end_io callback.
+ */
+static int read_from_bdev_async(struct zram *zram, struct bio_vec *bvec,
+			unsigned long blk_idx, struct bio *parent)
+{
+	struct bio *bio;
+
+	bio = bio_alloc(GFP_NOIO, 1);
+	if (!bio)
+		return -ENOMEM;
+
+	bio->bi_sector = blk_idx * (PAGE_SIZE >> SECTOR_SHIFT);
+	bio->bi_bdev = zram->bdev;
+	if (!bio_add_page(bio, bvec->bv_page, bvec->bv_len, bvec->bv_offset)) {
+		bio_put(bio);
+		return -EIO;
+	}
+	bio->bi_private = parent;
+	bio->bi_end_io = zram_bdev_end_read;
+
+	/* dropped by zram_bdev_end_read(), keeps reset waiting for us */
+	zram_meta_get(zram);
+	atomic64_inc(&zram->stats.bd_reads);
+	submit_bio(READ, bio);
+	return 1;
+}
+
+/* read a written back page into a kernel buffer, may sleep */
+static int read_from_bdev_mem(struct zram *zram, unsigned long blk_idx,
+			char *mem)
+{
+	struct page *page;
+	void *src;
+	int ret;
+
+	page = alloc_page(GFP_NOIO);
+	if (!page)
+		return -ENOMEM;
+
+	ret = zram_bdev_rw_sync(zram, page, blk_idx, READ);
+	if (!ret) {
+		src = kmap_atomic(page);
+		memcpy(mem, src, PAGE_SIZE);
+		kunmap_atomic(src);
+	}
+	__free_page(page);
+	return ret;
+}
+
+/*
+ * Read a written back slot into @bvec. Whole page reads of a single
+ * page bio (the swap-in case) are done asynchronously and return 1.
+ */
+static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
+			unsigned long blk_idx, int offset, struct bio *parent)
+{
+	struct page *page = bvec->bv_page;
+	unsigned char *user_mem, *uncmem;
+	int ret;
+
+	if (!is_partial_io(bvec)) {
+		if (parent)
+			return read_from_bdev_async(zram, bvec, blk_idx,
+							parent);
+		ret = zram_bdev_rw_sync(zram, page, blk_idx, READ);
+		if (!ret)
+			flush_dcache_page(page);
+		return ret;
+	}
+
+	uncmem = kmalloc(PAGE_SIZE, GFP_NOIO);
+	if (!uncmem)
+		return -ENOMEM;
+
+	ret = read_from_bdev_mem(zram, blk_idx, uncmem);
+	if (!ret) {
+		user_mem = kmap_atomic(page);
+		memcpy(user_mem + bvec->bv_offset, uncmem + offset,
+				bvec->bv_len);
+		kunmap_atomic(user_mem);
+		flush_dcache_page(page);
+	}
+	kfree(uncmem);
+	return ret;
+}
+
+#else
+static inline void reset_bdev(struct zram *zram) {}
+static inline void free_block_bdev(struct zram *zram, unsigned long blk_idx) {}
+static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
+			unsigned long blk_idx, int offset, struct bio *parent)
+{
+	return -EIO;
+}
+static int read_from_bdev_mem(struct zram *zram, unsigned long blk_idx,
+			char *mem)
+{
+	return -EIO;
+}
+#endif
+
 
 /*
  * To protect concurrent access to the same index entry,
@@ -482,6 +1150,28 @@ static void zram_free_page(struct zram *zram, size_t index)
 	struct zram_meta *meta = zram->meta;
 	unsigned long handle = meta->table[index].handle;
 
+	zram_clear_flag(meta, index, ZRAM_HUGE);
+	zram_clear_flag(meta, index, ZRAM_UNDER_WB);
+	zram_clear_flag(meta, index, ZRAM_IDLE);
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+	meta->table[index].ac_time = 0;
+#endif
+
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		zram_clear_flag(meta, index, ZRAM_WB);
+		free_block_bdev(zram, meta->table[index].element);
+		meta->table[index].element = 0;
+		return;
+	}
+
+	/* Same element filled pages keep the pattern instead of a handle */
+	if (zram_test_flag(meta, index, ZRAM_SAME)) {
+		zram_clear_flag(meta, index, ZRAM_SAME);
+		meta->table[index].element = 0;
+		atomic64_dec(&zram->stats.same_pages);
+		return;
+	}
+
 	if (unlikely(!handle)) {
 		/*
 		 * No memory is allocated for zero filled pages.
@@ -494,10 +1184,19 @@ static void zram_free_page(struct zram *zram, size_t index)
 		return;
 	}
 
-	zs_free(meta->mem_pool, handle);
-
-	atomic64_sub(zram_get_obj_size(meta, index),
-			&zram->stats.compr_data_size);
+	if (zram_dedup_enabled(meta)) {
+		/* other slots still share the object, only drop our ref */
+		if (!zram_dedup_put(meta, meta->table[index].entry))
+			atomic64_sub(zram_get_obj_size(meta, index),
+					&zram->stats.dedup_saved_bytes);
+		else
+			atomic64_sub(zram_get_obj_size(meta, index),
+					&zram->stats.compr_data_size);
+	} else {
+		zs_free(meta->mem_pool, handle);
+		atomic64_sub(zram_get_obj_size(meta, index),
+				&zram->stats.compr_data_size);
+	}
 	atomic64_dec(&zram->stats.pages_stored);
 
 	meta->table[index].handle = 0;
@@ -516,11 +1215,31 @@ static int zram_decompress_page(struct zram *zram, char *mem, u32 index)
 	handle = meta->table[index].handle;
 	size = zram_get_obj_size(meta, index);
 
+	if (zram_test_flag(meta, index, ZRAM_SAME)) {
+		unsigned long element = meta->table[index].element;
+
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		zram_fill_page(mem, PAGE_SIZE, element);
+		return 0;
+	}
+
+	/*
+	 * Only the partial write path gets here for a written back slot,
+	 * reads are served by read_from_bdev() before mapping the page.
+	 */
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		unsigned long blk_idx = meta->table[index].element;
+
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		return read_from_bdev_mem(zram, blk_idx, mem);
+	}
+
 	if (!handle || zram_test_flag(meta, index, ZRAM_ZERO)) {
 		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
 		clear_page(mem);
 		return 0;
 	}
+	handle = zram_get_handle(meta, index);
 
 	cmem = zs_map_object(meta->mem_pool, handle, ZS_MM_RO);
 	if (size == PAGE_SIZE)
@@ -540,7 +1259,7 @@ static int zram_decompress_page(struct zram *zram, char *mem, u32 index)
 }
 
 static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
-			  u32 index, int offset)
+			  u32 index, int offset, struct bio *bio)
 {
 	int ret;
 	struct page *page;
@@ -549,10 +1268,23 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 	page = bvec->bv_page;
 
 	bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+	if (zram_test_flag(meta, index, ZRAM_SAME)) {
+		unsigned long element = meta->table[index].element;
+
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		handle_same_page(bvec, element);
+		return 0;
+	}
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		unsigned long blk_idx = meta->table[index].element;
+
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+		return read_from_bdev(zram, bvec, blk_idx, offset, bio);
+	}
 	if (unlikely(!meta->table[index].handle) ||
 			zram_test_flag(meta, index, ZRAM_ZERO)) {
 		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
-		handle_zero_page(bvec);
+		handle_same_page(bvec, 0);
 		return 0;
 	}
 	bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
@@ -617,6 +1349,10 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 	struct zcomp_strm *zstrm;
 	bool locked = false;
 	unsigned long alloced_pages;
+	unsigned long element;
+	struct zram_entry *entry = NULL;
+	bool dedup_hit = false;
+	u32 checksum = 0;
 
 	page = bvec->bv_page;
 	if (is_partial_io(bvec)) {
@@ -647,20 +1383,49 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 		uncmem = user_mem;
 	}
 
-	if (page_zero_filled(uncmem)) {
+	if (page_same_filled(uncmem, &element)) {
 		if (user_mem)
 			kunmap_atomic(user_mem);
 		/* Free memory associated with this sector now. */
 		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
 		zram_free_page(zram, index);
-		zram_set_flag(meta, index, ZRAM_ZERO);
+		if (!element) {
+			zram_set_flag(meta, index, ZRAM_ZERO);
+		} else {
+			zram_set_flag(meta, index, ZRAM_SAME);
+			meta->table[index].element = element;
+		}
 		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
 
-		atomic64_inc(&zram->stats.zero_pages);
+		if (!element)
+			atomic64_inc(&zram->stats.zero_pages);
+		else
+			atomic64_inc(&zram->stats.same_pages);
 		ret = 0;
 		goto out;
 	}
 
+	if (zram_dedup_enabled(meta)) {
+		checksum = zram_dedup_checksum(uncmem);
+		/* the stream buffer is free until we compress into it */
+		entry = zram_dedup_find(zram, uncmem, checksum, zstrm->buffer);
+		if (entry) {
+			if (!is_partial_io(bvec)) {
+				kunmap_atomic(user_mem);
+				user_mem = NULL;
+				uncmem = NULL;
+			}
+			zcomp_strm_release(zram->comp, zstrm);
+			locked = false;
+
+			dedup_hit = true;
+			clen = entry->len;
+			atomic64_inc(&zram->stats.dedup_hits);
+			atomic64_add(clen, &zram->stats.dedup_saved_bytes);
+			goto store;
+		}
+	}
+
 	ret = zcomp_compress(zram->comp, zstrm, uncmem, &clen);
 	if (!is_partial_io(bvec)) {
 		kunmap_atomic(user_mem);
@@ -712,6 +1477,16 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 	locked = false;
 	zs_unmap_object(meta->mem_pool, handle);
 
+	if (zram_dedup_enabled(meta)) {
+		entry = zram_dedup_insert(meta, handle, clen, checksum);
+		if (!entry) {
+			zs_free(meta->mem_pool, handle);
+			ret = -ENOMEM;
+			goto out;
+		}
+	}
+
+store:
 	/*
 	 * Free memory associated with this sector
 	 * before overwriting unused sectors.
@@ -719,12 +1494,18 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 	bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
 	zram_free_page(zram, index);
 
-	meta->table[index].handle = handle;
+	if (entry)
+		meta->table[index].entry = entry;
+	else
+		meta->table[index].handle = handle;
 	zram_set_obj_size(meta, index, clen);
+	if (clen == PAGE_SIZE)
+		zram_set_flag(meta, index, ZRAM_HUGE);
 	bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
 
 	/* Update stats */
-	atomic64_add(clen, &zram->stats.compr_data_size);
+	if (!dedup_hit)
+		atomic64_add(clen, &zram->stats.compr_data_size);
 	atomic64_inc(&zram->stats.pages_stored);
 out:
 	if (locked)
@@ -734,8 +1515,12 @@ out:
 	return ret;
 }
 
+/*
+ * @bio is the parent bio if it consists of this single bvec only, so a
+ * read may complete it asynchronously, in which case 1 is returned.
+ */
 static int zram_bvec_rw(struct zram *zram, struct bio_vec *bvec, u32 index,
-			int offset, int rw)
+			int offset, int rw, struct bio *bio)
 {
 	unsigned long start_time = jiffies;
 	int ret;
@@ -745,7 +1530,7 @@ static int zram_bvec_rw(struct zram *zram, struct bio_vec *bvec, u32 index,
 
 	if (rw == READ) {
 		atomic64_inc(&zram->stats.num_reads);
-		ret = zram_bvec_read(zram, bvec, index, offset);
+		ret = zram_bvec_read(zram, bvec, index, offset, bio);
 	} else {
 		atomic64_inc(&zram->stats.num_writes);
 		ret = zram_bvec_write(zram, bvec, index, offset);
@@ -753,7 +1538,11 @@ static int zram_bvec_rw(struct zram *zram, struct bio_vec *bvec, u32 index,
 
 	generic_end_io_acct(rw, &zram->disk->part0, start_time);
 
-	if (unlikely(ret)) {
+	bit_spin_lock(ZRAM_ACCESS, &zram->meta->table[index].value);
+	zram_accessed(zram->meta, index);
+	bit_spin_unlock(ZRAM_ACCESS, &zram->meta->table[index].value);
+
+	if (unlikely(ret < 0)) {
 		if (rw == READ)
 			atomic64_inc(&zram->stats.failed_reads);
 		else
@@ -835,13 +1624,17 @@ static void zram_reset_device(struct zram *zram)
 	/* Reset stats */
 	memset(&zram->stats, 0, sizeof(zram->stats));
 	zram->disksize = 0;
-	zram->max_comp_streams = 1;
+	zram->max_comp_streams = num_possible_cpus();
 	set_capacity(zram->disk, 0);
 
 	up_write(&zram->init_lock);
 	/* I/O operation under all of CPU are done so let's free */
 	zram_meta_free(meta, disksize);
 	zcomp_destroy(comp);
+
+	down_write(&zram->init_lock);
+	reset_bdev(zram);
+	up_write(&zram->init_lock);
 }
 
 static ssize_t disksize_store(struct device *dev,
@@ -858,7 +1651,8 @@ static ssize_t disksize_store(struct device *dev,
 		return -EINVAL;
 
 	disksize = PAGE_ALIGN(disksize);
-	meta = zram_meta_alloc(zram->disk->first_minor, disksize);
+	meta = zram_meta_alloc(zram->disk->first_minor, disksize,
+				zram->use_dedup);
 	if (!meta)
 		return -ENOMEM;
 
@@ -964,6 +1758,20 @@ static void __zram_make_request(struct zram *zram, struct bio *bio)
 	}
 
 	rw = bio_data_dir(bio);
+	if (rw == READ && bio->bi_vcnt == 1 && !offset &&
+			bio_iovec(bio)->bv_len == PAGE_SIZE) {
+		int ret = zram_bvec_rw(zram, bio_iovec(bio), index, 0, rw, bio);
+
+		if (ret < 0)
+			goto out;
+		if (ret == 0) {
+			set_bit(BIO_UPTODATE, &bio->bi_flags);
+			bio_endio(bio, 0);
+		}
+		/* otherwise completed by the backing device read */
+		return;
+	}
+
 	bio_for_each_segment(bvec, bio, i) {
 		int max_transfer_size = PAGE_SIZE - offset;
 
@@ -978,15 +1786,18 @@ static void __zram_make_request(struct zram *zram, struct bio *bio)
 			bv.bv_len = max_transfer_size;
 			bv.bv_offset = bvec->bv_offset;
 
-			if (zram_bvec_rw(zram, &bv, index, offset, rw) < 0)
+			if (zram_bvec_rw(zram, &bv, index, offset, rw,
+						NULL) < 0)
 				goto out;
 
 			bv.bv_len = bvec->bv_len - max_transfer_size;
 			bv.bv_offset += max_transfer_size;
-			if (zram_bvec_rw(zram, &bv, index + 1, 0, rw) < 0)
+			if (zram_bvec_rw(zram, &bv, index + 1, 0, rw,
+						NULL) < 0)
 				goto out;
 		} else
-			if (zram_bvec_rw(zram, bvec, index, offset, rw) < 0)
+			if (zram_bvec_rw(zram, bvec, index, offset, rw,
+						NULL) < 0)
 				goto out;
 
 		update_position(&index, &offset, bvec);
@@ -1067,7 +1878,7 @@ static int zram_rw_page(struct block_device *bdev, sector_t sector,
 	bv.bv_len = PAGE_SIZE;
 	bv.bv_offset = 0;
 
-	err = zram_bvec_rw(zram, &bv, index, offset, rw);
+	err = zram_bvec_rw(zram, &bv, index, offset, rw, NULL);
 put_zram:
 	zram_meta_put(zram);
 out:
@@ -1090,6 +1901,116 @@ static const struct block_device_operations zram_devops = {
 	.owner = THIS_MODULE
 };
 
+#ifdef CONFIG_ZRAM_WRITEBACK
+static ssize_t writeback_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zram_meta *meta;
+	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	unsigned long index, blk_idx = 0;
+	struct page *page;
+	ssize_t ret = len;
+	enum zram_pageflags mode;
+
+	if (sysfs_streq(buf, "huge"))
+		mode = ZRAM_HUGE;
+	else if (sysfs_streq(buf, "idle"))
+		mode = ZRAM_IDLE;
+	else
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		ret = -EINVAL;
+		goto release_init_lock;
+	}
+
+	if (!zram_wb_enabled(zram)) {
+		ret = -ENODEV;
+		goto release_init_lock;
+	}
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page) {
+		ret = -ENOMEM;
+		goto release_init_lock;
+	}
+
+	meta = zram->meta;
+	for (index = 0; index < nr_pages; index++) {
+		if (!blk_idx) {
+			blk_idx = alloc_block_bdev(zram);
+			if (!blk_idx) {
+				ret = -ENOSPC;
+				break;
+			}
+		}
+
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (!meta->table[index].handle ||
+				zram_test_flag(meta, index, ZRAM_SAME) ||
+				zram_test_flag(meta, index, ZRAM_WB) ||
+				zram_test_flag(meta, index, ZRAM_UNDER_WB) ||
+				!zram_test_flag(meta, index, mode)) {
+			bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+			continue;
+		}
+		/* cleared by zram_free_page() if the slot changes meanwhile */
+		zram_set_flag(meta, index, ZRAM_UNDER_WB);
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+
+		if (zram_decompress_page(zram, page_address(page), index) ||
+			zram_bdev_rw_sync(zram, page, blk_idx, WRITE)) {
+			bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+			zram_clear_flag(meta, index, ZRAM_UNDER_WB);
+			bit_spin_unlock(ZRAM_ACCESS,
+					&meta->table[index].value);
+			continue;
+		}
+
+		bit_spin_lock(ZRAM_ACCESS, &meta->table[index].value);
+		if (!zram_test_flag(meta, index, ZRAM_UNDER_WB)) {
+			/* freed or rewritten, reuse blk_idx for the next one */
+			bit_spin_unlock(ZRAM_ACCESS,
+					&meta->table[index].value);
+			continue;
+		}
+
+		zram_free_page(zram, index);
+		zram_set_flag(meta, index, ZRAM_WB);
+		meta->table[index].element = blk_idx;
+		blk_idx = 0;
+		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
+	}
+
+	if (blk_idx)
+		free_block_bdev(zram, blk_idx);
+	__free_page(page);
+release_init_lock:
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+static ssize_t bd_stat_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	ret = scnprintf(buf, PAGE_SIZE,
+		"%8llu %8llu %8llu\n",
+		(u64)atomic64_read(&zram->stats.bd_count),
+		(u64)atomic64_read(&zram->stats.bd_reads),
+		(u64)atomic64_read(&zram->stats.bd_writes));
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+#endif
+
 static DEVICE_ATTR_WO(compact);
 static DEVICE_ATTR_RW(disksize);
 static DEVICE_ATTR_RO(initstate);
@@ -1099,7 +2020,16 @@ static DEVICE_ATTR_RO(mem_used_total);
 static DEVICE_ATTR_RW(mem_limit);
 static DEVICE_ATTR_RW(mem_used_max);
 static DEVICE_ATTR_RW(max_comp_streams);
+static DEVICE_ATTR_RO(comp_streams_contended);
 static DEVICE_ATTR_RW(comp_algorithm);
+static DEVICE_ATTR_WO(idle);
+#ifdef CONFIG_ZRAM_WRITEBACK
+static DEVICE_ATTR_RW(backing_dev);
+static DEVICE_ATTR_WO(writeback);
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+static DEVICE_ATTR_RW(use_dedup);
+#endif
 
 static ssize_t io_stat_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
@@ -1135,14 +2065,15 @@ static ssize_t mm_stat_show(struct device *dev,
 	max_used = atomic_long_read(&zram->stats.max_used_pages);
 
 	ret = scnprintf(buf, PAGE_SIZE,
-			"%8llu %8llu %8llu %8lu %8ld %8llu %8llu\n",
+			"%8llu %8llu %8llu %8lu %8ld %8llu %8llu %8llu\n",
 			orig_size << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.compr_data_size),
 			mem_used << PAGE_SHIFT,
 			zram->limit_pages << PAGE_SHIFT,
 			max_used << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.zero_pages),
-			(u64)atomic64_read(&zram->stats.num_migrated));
+			(u64)atomic64_read(&zram->stats.num_migrated),
+			(u64)atomic64_read(&zram->stats.same_pages));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1150,6 +2081,9 @@ static ssize_t mm_stat_show(struct device *dev,
 
 static DEVICE_ATTR_RO(io_stat);
 static DEVICE_ATTR_RO(mm_stat);
+#ifdef CONFIG_ZRAM_WRITEBACK
+static DEVICE_ATTR_RO(bd_stat);
+#endif
 ZRAM_ATTR_RO(num_reads);
 ZRAM_ATTR_RO(num_writes);
 ZRAM_ATTR_RO(failed_reads);
@@ -1157,7 +2091,12 @@ ZRAM_ATTR_RO(failed_writes);
 ZRAM_ATTR_RO(invalid_io);
 ZRAM_ATTR_RO(notify_free);
 ZRAM_ATTR_RO(zero_pages);
+ZRAM_ATTR_RO(same_pages);
 ZRAM_ATTR_RO(compr_data_size);
+#ifdef CONFIG_ZRAM_DEDUP
+ZRAM_ATTR_RO(dedup_hits);
+ZRAM_ATTR_RO(dedup_saved_bytes);
+#endif
 
 static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_disksize.attr,
@@ -1171,15 +2110,28 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_invalid_io.attr,
 	&dev_attr_notify_free.attr,
 	&dev_attr_zero_pages.attr,
+	&dev_attr_same_pages.attr,
 	&dev_attr_orig_data_size.attr,
 	&dev_attr_compr_data_size.attr,
 	&dev_attr_mem_used_total.attr,
 	&dev_attr_mem_limit.attr,
 	&dev_attr_mem_used_max.attr,
 	&dev_attr_max_comp_streams.attr,
+	&dev_attr_comp_streams_contended.attr,
 	&dev_attr_comp_algorithm.attr,
 	&dev_attr_io_stat.attr,
 	&dev_attr_mm_stat.attr,
+	&dev_attr_idle.attr,
+#ifdef CONFIG_ZRAM_WRITEBACK
+	&dev_attr_backing_dev.attr,
+	&dev_attr_writeback.attr,
+	&dev_attr_bd_stat.attr,
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+	&dev_attr_use_dedup.attr,
+	&dev_attr_dedup_hits.attr,
+	&dev_attr_dedup_saved_bytes.attr,
+#endif
 	NULL,
 };
 
@@ -1187,6 +2139,119 @@ static struct attribute_group zram_disk_attr_group = {
 	.attrs = zram_disk_attrs,
 };
 
+/*
+ * Aggregate statistics for all zram devices in /sys/kernel/zram/.
+ * Using one device per CPU as equal priority swap areas spreads pool and
+ * table contention while swap round-robins between them; these nodes
+ * keep the sum of all devices readable in one place.
+ */
+static struct kobject *zram_kobj;
+
+static ssize_t num_devices_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", zram_num_devices);
+}
+
+static ssize_t total_mm_stat_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	u64 orig_size = 0, compr_size = 0, mem_used = 0, max_used = 0;
+	u64 zero_pages = 0, same_pages = 0, num_migrated = 0;
+	unsigned int i, nr_init = 0;
+
+	for (i = 0; i < zram_num_devices; i++) {
+		struct zram *zram = &zram_devices[i];
+
+		down_read(&zram->init_lock);
+		if (init_done(zram)) {
+			nr_init++;
+			mem_used += zs_get_total_pages(zram->meta->mem_pool);
+		}
+		orig_size += atomic64_read(&zram->stats.pages_stored);
+		compr_size += atomic64_read(&zram->stats.compr_data_size);
+		max_used += atomic_long_read(&zram->stats.max_used_pages);
+		zero_pages += atomic64_read(&zram->stats.zero_pages);
+		same_pages += atomic64_read(&zram->stats.same_pages);
+		num_migrated += atomic64_read(&zram->stats.num_migrated);
+		up_read(&zram->init_lock);
+	}
+
+	return scnprintf(buf, PAGE_SIZE,
+			"%8u %8llu %8llu %8llu %8llu %8llu %8llu %8llu\n",
+			nr_init,
+			orig_size << PAGE_SHIFT,
+			compr_size,
+			mem_used << PAGE_SHIFT,
+			max_used << PAGE_SHIFT,
+			zero_pages,
+			num_migrated,
+			same_pages);
+}
+
+static ssize_t total_io_stat_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	u64 num_reads = 0, num_writes = 0, failed_reads = 0;
+	u64 failed_writes = 0, notify_free = 0;
+	unsigned int i;
+
+	for (i = 0; i < zram_num_devices; i++) {
+		struct zram *zram = &zram_devices[i];
+
+		num_reads += atomic64_read(&zram->stats.num_reads);
+		num_writes += atomic64_read(&zram->stats.num_writes);
+		failed_reads += atomic64_read(&zram->stats.failed_reads);
+		failed_writes += atomic64_read(&zram->stats.failed_writes);
+		notify_free += atomic64_read(&zram->stats.notify_free);
+	}
+
+	return scnprintf(buf, PAGE_SIZE,
+			"%8llu %8llu %8llu %8llu %8llu\n",
+			num_reads, num_writes, failed_reads,
+			failed_writes, notify_free);
+}
+
+static struct kobj_attribute num_devices_attr = __ATTR_RO(num_devices);
+static struct kobj_attribute total_mm_stat_attr =
+	__ATTR(mm_stat, 0444, total_mm_stat_show, NULL);
+static struct kobj_attribute total_io_stat_attr =
+	__ATTR(io_stat, 0444, total_io_stat_show, NULL);
+
+static struct attribute *zram_total_attrs[] = {
+	&num_devices_attr.attr,
+	&total_mm_stat_attr.attr,
+	&total_io_stat_attr.attr,
+	NULL,
+};
+
+static struct attribute_group zram_total_attr_group = {
+	.attrs = zram_total_attrs,
+};
+
+static void zram_total_stats_create(void)
+{
+	zram_kobj = kobject_create_and_add("zram", kernel_kobj);
+	if (!zram_kobj)
+		return;
+
+	if (sysfs_create_group(zram_kobj, &zram_total_attr_group)) {
+		pr_warn("Error creating aggregate sysfs group\n");
+		kobject_put(zram_kobj);
+		zram_kobj = NULL;
+	}
+}
+
+static void zram_total_stats_destroy(void)
+{
+	if (!zram_kobj)
+		return;
+
+	sysfs_remove_group(zram_kobj, &zram_total_attr_group);
+	kobject_put(zram_kobj);
+	zram_kobj = NULL;
+}
+
 static int create_device(struct zram *zram, int device_id)
 {
 	struct request_queue *queue;
@@ -1259,7 +2324,9 @@ static int create_device(struct zram *zram, int device_id)
 	}
 	strlcpy(zram->compressor, default_compressor, sizeof(zram->compressor));
 	zram->meta = NULL;
-	zram->max_comp_streams = 1;
+	/* the stream pool is further capped by the number of online CPUs */
+	zram->max_comp_streams = num_possible_cpus();
+	zram_debugfs_register(zram);
 	return 0;
 
 out_free_disk:
@@ -1276,8 +2343,10 @@ static void destroy_devices(unsigned int nr)
 	struct zram *zram;
 	unsigned int i;
 
+	zram_total_stats_destroy();
 	for (i = 0; i < nr; i++) {
 		zram = &zram_devices[i];
+		zram_debugfs_unregister(zram);
 		/*
 		 * Remove sysfs first, so no one will perform a disksize
 		 * store while we destroy the devices
@@ -1294,6 +2363,7 @@ static void destroy_devices(unsigned int nr)
 
 	kfree(zram_devices);
 	unregister_blkdev(zram_major, "zram");
+	zram_debugfs_destroy();
 	pr_info("Destroyed %u device(s)\n", nr);
 }
 
@@ -1301,6 +2371,10 @@ static int __init zram_init(void)
 {
 	int ret, dev_id;
 
+	/* the module parameter overrides the built-in default */
+	if (num_devices)
+		zram_num_devices = num_devices;
+
 	if (zram_num_devices > max_num_devices) {
 		pr_warn("Invalid value for num_devices: %u\n",
 				zram_num_devices);
@@ -1313,9 +2387,12 @@ static int __init zram_init(void)
 		return -EBUSY;
 	}
 
+	zram_debugfs_create();
+
 	/* Allocate the device array and initialize each one */
 	zram_devices = kzalloc(zram_num_devices * sizeof(struct zram), GFP_KERNEL);
 	if (!zram_devices) {
+		zram_debugfs_destroy();
 		unregister_blkdev(zram_major, "zram");
 		return -ENOMEM;
 	}
@@ -1326,6 +2403,7 @@ static int __init zram_init(void)
 			goto out_error;
 	}
 
+	zram_total_stats_create();
 	pr_info("Created %u device(s)\n", zram_num_devices);
 	return 0;
 
@@ -1342,6 +2420,9 @@ static void __exit zram_exit(void)
 module_init(zram_init);
 module_exit(zram_exit);
 
+module_param(num_devices, uint, 0);
+MODULE_PARM_DESC(num_devices, "Number of zram devices");
+
 MODULE_LICENSE("Dual BSD/GPL");
 MODULE_AUTHOR("Nitin Gupta <ngupta@vflare.org>");
 MODULE_DESCRIPTION("Compressed RAM Block Device");
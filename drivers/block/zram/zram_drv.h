@@ -19,6 +19,7 @@
 #include <linux/zsmalloc.h>
 
 #include "zcomp.h"
+#include "zram_dedup.h"
 
 /*
  * Some arbitrary value. This is just to catch
@@ -68,6 +69,13 @@ enum zram_pageflags {
 	/* Page consists entirely of zeros */
 	ZRAM_ZERO = ZRAM_FLAG_SHIFT,
 	ZRAM_ACCESS,	/* page is now accessed */
+	/* Page is filled with one repeated non-zero word (table.element) */
+	ZRAM_SAME,
+	ZRAM_HUGE,	/* Incompressible page, stored as is */
+	/* Page lives on the backing device at block table.element */
+	ZRAM_WB,
+	ZRAM_UNDER_WB,	/* page is being written to the backing device */
+	ZRAM_IDLE,	/* not accessed since it was last marked idle */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -76,8 +84,15 @@ enum zram_pageflags {
 
 /* Allocated for each disk page */
 struct zram_table_entry {
-	unsigned long handle;
+	union {
+		unsigned long handle;
+		unsigned long element;	/* fill pattern of a ZRAM_SAME page */
+		struct zram_entry *entry;	/* shared object, dedup only */
+	};
 	unsigned long value;
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+	unsigned long ac_time;	/* jiffies of last read or write */
+#endif
 };
 
 struct zram_stats {
@@ -90,13 +105,27 @@ struct zram_stats {
 	atomic64_t invalid_io;	/* non-page-aligned I/O requests */
 	atomic64_t notify_free;	/* no. of swap slot free notifications */
 	atomic64_t zero_pages;		/* no. of zero filled pages */
+	atomic64_t same_pages;		/* no. of same element filled pages */
 	atomic64_t pages_stored;	/* no. of pages currently stored */
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
+	atomic64_t dedup_hits;		/* no. of writes matching a stored page */
+	atomic64_t dedup_saved_bytes;	/* compressed bytes not stored twice */
+#ifdef CONFIG_ZRAM_WRITEBACK
+	atomic64_t bd_count;		/* no. of pages in backing device */
+	atomic64_t bd_reads;		/* no. of reads from backing device */
+	atomic64_t bd_writes;		/* no. of writes to backing device */
+#endif
 };
 
 struct zram_meta {
 	struct zram_table_entry *table;
 	struct zs_pool *mem_pool;
+#ifdef CONFIG_ZRAM_DEDUP
+	bool use_dedup;
+	/* zram_entry objects indexed by content checksum */
+	struct rb_root dedup_root;
+	spinlock_t dedup_lock;
+#endif
 };
 
 struct zram {
@@ -110,6 +139,8 @@ struct zram {
 	 */
 	unsigned long limit_pages;
 	int max_comp_streams;
+	/* deduplicate identical pages, applied at disksize_store() */
+	bool use_dedup;
 
 	struct zram_stats stats;
 	atomic_t refcount; /* refcount for zram_meta */
@@ -121,5 +152,16 @@ struct zram {
 	 */
 	u64 disksize;	/* bytes */
 	char compressor[10];
+#ifdef CONFIG_ZRAM_WRITEBACK
+	struct file *backing_dev;
+	struct block_device *bdev;
+	unsigned int old_block_size;
+	/* allocated blocks of the backing device, block 0 is never used */
+	unsigned long *bitmap;
+	unsigned long nr_pages;
+#endif
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+	struct dentry *debugfs_dir;
+#endif
 };
 #endif
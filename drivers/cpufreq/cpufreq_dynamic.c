@@ -305,11 +305,12 @@ static inline cputime64_t get_cpu_idle_time(unsigned int cpu, cputime64_t *wall,
 	u64 idle_time = get_cpu_idle_time_us(cpu, wall);
 
 	if (idle_time == -1ULL)
-		return get_cpu_idle_time_jiffy(cpu, wall);
+		idle_time = get_cpu_idle_time_jiffy(cpu, wall);
 	else if (current_io_is_busy != 1)
 		*iowait = get_cpu_iowait_time_us(cpu, wall);
 
-	return idle_time;
+	/* The runtime of down-weighted task groups counts as idle */
+	return idle_time + sched_freq_discount_us(cpu);
 }
 
 static inline void recalculate_down_threshold(struct cpu_dbs_info_s *this_dbs_info)
@@ -685,6 +686,7 @@ static void dbs_check_cpu(struct cpu_dbs_info_s *this_dbs_info)
 	unsigned int min_supporting_freq = 0;
 	unsigned int max_freq_hard = policy->max;
 	unsigned int max_freq_soft = policy->max;
+	unsigned int group_floor = 0;
 
 	bool boosted = (current_input_boost_freq > 0) && (ktime_to_us(ktime_get()) < (last_input_time + current_input_boost_us));
 	bool active = !(suspend || standby);
@@ -717,6 +719,7 @@ static void dbs_check_cpu(struct cpu_dbs_info_s *this_dbs_info)
 
 		j_dbs_info = &per_cpu(cs_cpu_dbs_info, j);
 
+		group_floor = max(group_floor, sched_freq_floor(j));
 		cur_idle_time = get_cpu_idle_time(j, &cur_wall_time, &cur_io_time);
 
 		wall_time = (unsigned int) cputime64_sub(cur_wall_time,
@@ -842,6 +845,16 @@ static void dbs_check_cpu(struct cpu_dbs_info_s *this_dbs_info)
 		return;
 	}
 
+	/* Keep to the floor of the task groups runnable on these cpus */
+	if (group_floor > max_freq_hard)
+		group_floor = max_freq_hard;
+
+	if (policy->cur < group_floor) {
+		this_dbs_info->requested_freq = group_floor;
+		__cpufreq_driver_target(policy, group_floor, CPUFREQ_RELATION_L);
+		return;
+	}
+
 	/* Check for frequency increase */
 	if (max_load > (active ? current_up_threshold : 99)) {
 		if (standby) {
@@ -938,6 +951,8 @@ static void dbs_check_cpu(struct cpu_dbs_info_s *this_dbs_info)
 
 		if (this_dbs_info->requested_freq < policy->min)
 			this_dbs_info->requested_freq = policy->min;
+		if (this_dbs_info->requested_freq < group_floor)
+			this_dbs_info->requested_freq = group_floor;
 
 		__cpufreq_driver_target(policy, this_dbs_info->requested_freq,
 				CPUFREQ_RELATION_L);
@@ -0,0 +1,280 @@
+/*
+ * drivers/cpufreq/cpufreq_input_boost.c
+ *
+ * Governor independent frequency boost on touch and key input.
+ *
+ * On input the minimum frequency of every online CPU is raised to
+ * boost_freq and the APE and DDR OPPs are requested at 100% for
+ * boost_ms. Events keep extending the boost while they keep coming.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/input.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+#include <linux/jiffies.h>
+#include <linux/mfd/dbx500-prcmu.h>
+
+#define INPUT_BOOST_QOS_NAME	"input_boost"
+
+static unsigned int boost_freq = 800000;
+module_param(boost_freq, uint, 0644);
+MODULE_PARM_DESC(boost_freq, "Minimum frequency while boosted in kHz, 0 disables");
+
+static unsigned int boost_ms = 100;
+module_param(boost_ms, uint, 0644);
+MODULE_PARM_DESC(boost_ms, "Boost duration after the last input event");
+
+static bool boost_opp = true;
+module_param(boost_opp, bool, 0644);
+MODULE_PARM_DESC(boost_opp, "Also request the APE and DDR OPPs at 100% while boosted");
+
+static unsigned int boost_count;
+module_param(boost_count, uint, 0444);
+MODULE_PARM_DESC(boost_count, "Number of boosts started");
+
+static struct workqueue_struct *input_boost_wq;
+
+/* Written from the input event path, read by the works */
+static unsigned long boost_until;
+static bool boost_pending;
+
+/* Only touched by the works, they are serialized on input_boost_wq */
+static bool boosted;
+static bool opp_boosted;
+
+static void input_boost_update_policies(void)
+{
+	unsigned int cpu;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu)
+		cpufreq_update_policy(cpu);
+	put_online_cpus();
+}
+
+static void input_boost_start_fn(struct work_struct *work);
+static void input_boost_stop_fn(struct work_struct *work);
+static DECLARE_WORK(input_boost_start_work, input_boost_start_fn);
+static DECLARE_DELAYED_WORK(input_boost_stop_work, input_boost_stop_fn);
+
+static void input_boost_start_fn(struct work_struct *work)
+{
+	boost_pending = false;
+
+	if (!boosted) {
+		boosted = true;
+		boost_count++;
+
+		if (boost_opp) {
+			prcmu_qos_update_requirement(PRCMU_QOS_APE_OPP,
+					INPUT_BOOST_QOS_NAME, 100);
+			prcmu_qos_update_requirement(PRCMU_QOS_DDR_OPP,
+					INPUT_BOOST_QOS_NAME, 100);
+			opp_boosted = true;
+		}
+
+		input_boost_update_policies();
+	}
+
+	queue_delayed_work(input_boost_wq, &input_boost_stop_work,
+					msecs_to_jiffies(boost_ms));
+}
+
+static void input_boost_stop_fn(struct work_struct *work)
+{
+	unsigned long until = ACCESS_ONCE(boost_until);
+
+	/* Extended by later events */
+	if (time_before(jiffies, until)) {
+		queue_delayed_work(input_boost_wq, &input_boost_stop_work,
+							until - jiffies);
+		return;
+	}
+
+	if (!boosted)
+		return;
+
+	boosted = false;
+
+	if (opp_boosted) {
+		prcmu_qos_update_requirement(PRCMU_QOS_APE_OPP,
+				INPUT_BOOST_QOS_NAME, PRCMU_QOS_DEFAULT_VALUE);
+		prcmu_qos_update_requirement(PRCMU_QOS_DDR_OPP,
+				INPUT_BOOST_QOS_NAME, PRCMU_QOS_DEFAULT_VALUE);
+		opp_boosted = false;
+	}
+
+	input_boost_update_policies();
+}
+
+static int input_boost_policy_notifier(struct notifier_block *nb,
+					unsigned long event, void *data)
+{
+	struct cpufreq_policy *policy = data;
+
+	if (event != CPUFREQ_ADJUST || !boosted || !boost_freq)
+		return NOTIFY_DONE;
+
+	cpufreq_verify_within_limits(policy,
+			min(boost_freq, policy->max), policy->max);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block input_boost_policy_nb = {
+	.notifier_call = input_boost_policy_notifier,
+};
+
+/**
+ * cpufreq_input_boost_kick - boost as on input, for other event sources
+ * @duration_ms: minimum time the boost lasts
+ *
+ * Can be called from interrupt context. A running boost is only extended.
+ */
+void cpufreq_input_boost_kick(unsigned int duration_ms)
+{
+	unsigned long until = jiffies + msecs_to_jiffies(duration_ms);
+
+	if (!boost_freq || !duration_ms || !input_boost_wq)
+		return;
+
+	if (!(boosted || boost_pending) || time_after(until, boost_until))
+		boost_until = until;
+
+	/* The running boost picks up the new end time by itself */
+	if (boosted || boost_pending)
+		return;
+
+	boost_pending = true;
+	queue_work(input_boost_wq, &input_boost_start_work);
+}
+EXPORT_SYMBOL_GPL(cpufreq_input_boost_kick);
+
+static void input_boost_event(struct input_handle *handle,
+		unsigned int type, unsigned int code, int value)
+{
+	cpufreq_input_boost_kick(boost_ms);
+}
+
+static int input_boost_connect(struct input_handler *handler,
+		struct input_dev *dev, const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int error;
+
+	handle = kzalloc(sizeof(struct input_handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "cpufreq_input_boost";
+
+	error = input_register_handle(handle);
+	if (error)
+		goto err_register;
+
+	error = input_open_device(handle);
+	if (error)
+		goto err_open;
+
+	return 0;
+
+err_open:
+	input_unregister_handle(handle);
+err_register:
+	kfree(handle);
+	return error;
+}
+
+static void input_boost_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id input_boost_ids[] = {
+	/* multi-touch touchscreen */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_MT_POSITION_X)] =
+			BIT_MASK(ABS_MT_POSITION_X) |
+			BIT_MASK(ABS_MT_POSITION_Y) },
+	},
+	/* touchpad */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_KEYBIT |
+			INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.keybit = { [BIT_WORD(BTN_TOUCH)] = BIT_MASK(BTN_TOUCH) },
+		.absbit = { [BIT_WORD(ABS_X)] =
+			BIT_MASK(ABS_X) | BIT_MASK(ABS_Y) },
+	},
+	/* keys */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT,
+		.evbit = { BIT_MASK(EV_KEY) },
+	},
+	{ },
+};
+
+static struct input_handler input_boost_handler = {
+	.event		= input_boost_event,
+	.connect	= input_boost_connect,
+	.disconnect	= input_boost_disconnect,
+	.name		= "cpufreq_input_boost",
+	.id_table	= input_boost_ids,
+};
+
+static int __init cpufreq_input_boost_init(void)
+{
+	int ret;
+
+	input_boost_wq = alloc_workqueue("input_boost", WQ_HIGHPRI, 1);
+	if (!input_boost_wq)
+		return -ENOMEM;
+
+	prcmu_qos_add_requirement(PRCMU_QOS_APE_OPP, INPUT_BOOST_QOS_NAME,
+						PRCMU_QOS_DEFAULT_VALUE);
+	prcmu_qos_add_requirement(PRCMU_QOS_DDR_OPP, INPUT_BOOST_QOS_NAME,
+						PRCMU_QOS_DEFAULT_VALUE);
+
+	ret = cpufreq_register_notifier(&input_boost_policy_nb,
+						CPUFREQ_POLICY_NOTIFIER);
+	if (ret)
+		goto err_notifier;
+
+	ret = input_register_handler(&input_boost_handler);
+	if (ret)
+		goto err_handler;
+
+	return 0;
+
+err_handler:
+	cpufreq_unregister_notifier(&input_boost_policy_nb,
+						CPUFREQ_POLICY_NOTIFIER);
+err_notifier:
+	prcmu_qos_remove_requirement(PRCMU_QOS_DDR_OPP, INPUT_BOOST_QOS_NAME);
+	prcmu_qos_remove_requirement(PRCMU_QOS_APE_OPP, INPUT_BOOST_QOS_NAME);
+	destroy_workqueue(input_boost_wq);
+	return ret;
+}
+late_initcall(cpufreq_input_boost_init);
+
+MODULE_DESCRIPTION("Governor independent cpufreq input boost");
+MODULE_LICENSE("GPL");
@@ -30,6 +30,7 @@
 #include <linux/kthread.h>
 #include <linux/slab.h>
 #include <linux/kernel_stat.h>
+#include <linux/irq_work.h>
 #include <asm/cputime.h>
 
 #define CREATE_TRACE_POINTS
@@ -45,6 +46,13 @@ struct cpufreq_interactive_cpuinfo {
 	u64 time_in_idle_timestamp;
 	u64 cputime_speedadj;
 	u64 cputime_speedadj_timestamp;
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+	/* Also under load_lock, updated from the scheduler hook */
+	unsigned int nr_running;
+	u64 sched_load_timestamp;
+	u64 time_discounted;
+	bool sched_load_enabled;
+#endif
 	struct cpufreq_policy *policy;
 	struct cpufreq_frequency_table *freq_table;
 	spinlock_t target_freq_lock; /*protects target freq */
@@ -118,6 +126,23 @@ static int timer_slack_val = DEFAULT_TIMER_SLACK;
 
 static bool io_is_busy;
 
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+/*
+ * A task waking up or migrating onto a CPU after a slice of at least this
+ * many usecs ramps the CPU to hispeed_freq without waiting for the timer.
+ */
+#define DEFAULT_SCHED_BIG_TASK (4 * USEC_PER_MSEC)
+static unsigned long sched_big_task_us = DEFAULT_SCHED_BIG_TASK;
+
+/* Runnable tasks beyond this do not add to the load of a CPU */
+#define SCHED_LOAD_MAX_NR_RUNNING 4
+
+/* CPUs to re-evaluate from sched_ramp_work, out of scheduler context */
+static cpumask_t sched_ramp_cpumask;
+static spinlock_t sched_ramp_cpumask_lock;
+static struct irq_work sched_ramp_work;
+#endif
+
 static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 		unsigned int event);
 
@@ -164,7 +189,24 @@ static inline cputime64_t get_cpu_idle_time(unsigned int cpu,
 	else if (!io_is_busy)
 		idle_time += get_cpu_iowait_time_us(cpu, wall);
 
-	return idle_time;
+	/* The runtime of down-weighted task groups counts as idle */
+	return idle_time + sched_freq_discount_us(cpu);
+}
+
+/* The caller shall hold load_lock */
+static void cpufreq_interactive_reset_load(
+	struct cpufreq_interactive_cpuinfo *pcpu, unsigned int cpu)
+{
+	pcpu->time_in_idle =
+		get_cpu_idle_time(cpu, &pcpu->time_in_idle_timestamp);
+	pcpu->cputime_speedadj = 0;
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+	pcpu->cputime_speedadj_timestamp = ktime_to_us(ktime_get());
+	pcpu->sched_load_timestamp = local_clock();
+	pcpu->time_discounted = sched_freq_discount_us(cpu);
+#else
+	pcpu->cputime_speedadj_timestamp = pcpu->time_in_idle_timestamp;
+#endif
 }
 
 static void cpufreq_interactive_timer_resched(
@@ -174,11 +216,7 @@ static void cpufreq_interactive_timer_resched(
 	unsigned long flags;
 
 	spin_lock_irqsave(&pcpu->load_lock, flags);
-	pcpu->time_in_idle =
-		get_cpu_idle_time(smp_processor_id(),
-				     &pcpu->time_in_idle_timestamp);
-	pcpu->cputime_speedadj = 0;
-	pcpu->cputime_speedadj_timestamp = pcpu->time_in_idle_timestamp;
+	cpufreq_interactive_reset_load(pcpu, smp_processor_id());
 	expires = jiffies + usecs_to_jiffies(timer_rate);
 	mod_timer_pinned(&pcpu->cpu_timer, expires);
 
@@ -209,10 +247,7 @@ static void cpufreq_interactive_timer_start(int cpu)
 	}
 
 	spin_lock_irqsave(&pcpu->load_lock, flags);
-	pcpu->time_in_idle =
-		get_cpu_idle_time(cpu, &pcpu->time_in_idle_timestamp);
-	pcpu->cputime_speedadj = 0;
-	pcpu->cputime_speedadj_timestamp = pcpu->time_in_idle_timestamp;
+	cpufreq_interactive_reset_load(pcpu, cpu);
 	spin_unlock_irqrestore(&pcpu->load_lock, flags);
 }
 
@@ -340,6 +375,41 @@ static unsigned int choose_freq(
 	return freq;
 }
 
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+/*
+ * Integrate the runqueue length since the last event. This runs from the
+ * scheduler hook, so it keeps to local_clock() and accumulates in ns,
+ * the timer scales the sum back to usecs. The caller shall hold load_lock.
+ */
+static void update_sched_load(struct cpufreq_interactive_cpuinfo *pcpu)
+{
+	u64 now = local_clock();
+
+	if (now > pcpu->sched_load_timestamp)
+		pcpu->cputime_speedadj += (now - pcpu->sched_load_timestamp) *
+			min_t(unsigned int, pcpu->nr_running,
+			      SCHED_LOAD_MAX_NR_RUNNING) * pcpu->policy->cur;
+
+	pcpu->sched_load_timestamp = now;
+}
+
+static u64 update_load(int cpu)
+{
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+	u64 discounted = sched_freq_discount_us(cpu);
+	u64 hidden;
+
+	update_sched_load(pcpu);
+
+	/* The runtime of down-weighted task groups is taken back out */
+	hidden = (discounted - pcpu->time_discounted) * NSEC_PER_USEC *
+		pcpu->policy->cur;
+	pcpu->cputime_speedadj -= min(hidden, pcpu->cputime_speedadj);
+	pcpu->time_discounted = discounted;
+
+	return ktime_to_us(ktime_get());
+}
+#else
 static u64 update_load(int cpu)
 {
 	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
@@ -364,6 +434,7 @@ static u64 update_load(int cpu)
 	pcpu->time_in_idle_timestamp = now;
 	return now;
 }
+#endif
 
 static void cpufreq_interactive_timer(unsigned long data)
 {
@@ -393,6 +464,10 @@ static void cpufreq_interactive_timer(unsigned long data)
 	if (WARN_ON_ONCE(!delta_time))
 		goto rearm;
 
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+	cputime_speedadj = div_u64(cputime_speedadj, NSEC_PER_USEC);
+#endif
+
 	spin_lock_irqsave(&pcpu->target_freq_lock, flags);
 	do_div(cputime_speedadj, delta_time);
 	loadadjfreq = (unsigned int)cputime_speedadj * 100;
@@ -412,6 +487,8 @@ static void cpufreq_interactive_timer(unsigned long data)
 		new_freq = choose_freq(pcpu, loadadjfreq);
 	}
 
+	new_freq = max(new_freq, sched_freq_floor(data));
+
 	if (pcpu->target_freq >= hispeed_freq &&
 	    new_freq > pcpu->target_freq &&
 	    now - pcpu->hispeed_validate_time <
@@ -649,6 +726,131 @@ static void cpufreq_interactive_boost(void)
 		wake_up_process(speedchange_task);
 }
 
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+/*
+ * Ramp the CPUs flagged by the scheduler hook to hispeed_freq, the same
+ * way a boost pulse would. Anything above hispeed_freq is still left to
+ * the timer and above_hispeed_delay.
+ */
+static void cpufreq_interactive_sched_ramp(struct irq_work *work)
+{
+	unsigned int cpu;
+	cpumask_t tmp_mask;
+	cpumask_t ramp_mask;
+	unsigned long flags;
+	struct cpufreq_interactive_cpuinfo *pcpu;
+
+	spin_lock_irqsave(&sched_ramp_cpumask_lock, flags);
+	tmp_mask = sched_ramp_cpumask;
+	cpumask_clear(&sched_ramp_cpumask);
+	spin_unlock_irqrestore(&sched_ramp_cpumask_lock, flags);
+
+	cpumask_clear(&ramp_mask);
+	for_each_cpu(cpu, &tmp_mask) {
+		pcpu = &per_cpu(cpuinfo, cpu);
+		if (!down_read_trylock(&pcpu->enable_sem))
+			continue;
+		if (!pcpu->governor_enabled) {
+			up_read(&pcpu->enable_sem);
+			continue;
+		}
+
+		spin_lock_irqsave(&pcpu->target_freq_lock, flags);
+		if (pcpu->target_freq < hispeed_freq) {
+			trace_cpufreq_interactive_sched_ramp(cpu,
+				pcpu->nr_running * 100, pcpu->target_freq,
+				pcpu->policy->cur, hispeed_freq);
+			pcpu->target_freq = hispeed_freq;
+			pcpu->hispeed_validate_time =
+				ktime_to_us(ktime_get());
+			pcpu->floor_freq = hispeed_freq;
+			pcpu->floor_validate_time =
+				pcpu->hispeed_validate_time;
+			cpumask_set_cpu(cpu, &ramp_mask);
+		}
+		spin_unlock_irqrestore(&pcpu->target_freq_lock, flags);
+		up_read(&pcpu->enable_sem);
+	}
+
+	if (cpumask_empty(&ramp_mask))
+		return;
+
+	spin_lock_irqsave(&speedchange_cpumask_lock, flags);
+	cpumask_or(&speedchange_cpumask, &speedchange_cpumask, &ramp_mask);
+	spin_unlock_irqrestore(&speedchange_cpumask_lock, flags);
+	wake_up_process(speedchange_task);
+}
+
+/*
+ * Called by the scheduler with its locks held and interrupts off. Account
+ * the load and defer any frequency change to sched_ramp_work.
+ */
+static void cpufreq_interactive_sched_load(int cpu,
+		enum sched_load_event event, unsigned int nr_running,
+		u64 burst)
+{
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+	unsigned long flags;
+	bool ramp;
+
+	spin_lock_irqsave(&pcpu->load_lock, flags);
+	if (!pcpu->sched_load_enabled) {
+		spin_unlock_irqrestore(&pcpu->load_lock, flags);
+		return;
+	}
+
+	/* A migration is followed by the enqueue that carries the count */
+	if (event != SCHED_LOAD_MIGRATE) {
+		update_sched_load(pcpu);
+		pcpu->nr_running = nr_running;
+	}
+	spin_unlock_irqrestore(&pcpu->load_lock, flags);
+
+	trace_cpufreq_interactive_sched_load(cpu, event, nr_running, burst);
+
+	ramp = (event == SCHED_LOAD_WAKEUP || event == SCHED_LOAD_MIGRATE) &&
+		burst >= (u64)sched_big_task_us * NSEC_PER_USEC &&
+		ACCESS_ONCE(pcpu->target_freq) < hispeed_freq;
+	if (!ramp)
+		return;
+
+	spin_lock_irqsave(&sched_ramp_cpumask_lock, flags);
+	cpumask_set_cpu(cpu, &sched_ramp_cpumask);
+	spin_unlock_irqrestore(&sched_ramp_cpumask_lock, flags);
+	irq_work_queue(&sched_ramp_work);
+}
+
+static void cpufreq_interactive_sched_load_start(int cpu)
+{
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+	unsigned long flags;
+
+	spin_lock_irqsave(&pcpu->load_lock, flags);
+	update_sched_load(pcpu);
+	pcpu->nr_running = nr_running_cpu(cpu);
+	pcpu->sched_load_enabled = true;
+	spin_unlock_irqrestore(&pcpu->load_lock, flags);
+}
+
+static void cpufreq_interactive_sched_load_stop(int cpu)
+{
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+	unsigned long flags;
+
+	spin_lock_irqsave(&pcpu->load_lock, flags);
+	pcpu->sched_load_enabled = false;
+	spin_unlock_irqrestore(&pcpu->load_lock, flags);
+}
+#else
+static inline void cpufreq_interactive_sched_load_start(int cpu)
+{
+}
+
+static inline void cpufreq_interactive_sched_load_stop(int cpu)
+{
+}
+#endif
+
 static int cpufreq_interactive_notifier(
 	struct notifier_block *nb, unsigned long val, void *data)
 {
@@ -1033,6 +1235,29 @@ static ssize_t store_io_is_busy(struct kobject *kobj,
 static struct global_attr io_is_busy_attr = __ATTR(io_is_busy, 0644,
 		show_io_is_busy, store_io_is_busy);
 
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+static ssize_t show_sched_big_task_us(struct kobject *kobj,
+			struct attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", sched_big_task_us);
+}
+
+static ssize_t store_sched_big_task_us(struct kobject *kobj,
+			struct attribute *attr, const char *buf, size_t count)
+{
+	int ret;
+	unsigned long val;
+
+	ret = kstrtoul(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+	sched_big_task_us = val;
+	return count;
+}
+
+define_one_global_rw(sched_big_task_us);
+#endif
+
 static struct attribute *interactive_attributes[] = {
 	&target_loads_attr.attr,
 	&above_hispeed_delay_attr.attr,
@@ -1045,6 +1270,9 @@ static struct attribute *interactive_attributes[] = {
 	&boostpulse.attr,
 	&boostpulse_duration.attr,
 	&io_is_busy_attr.attr,
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+	&sched_big_task_us.attr,
+#endif
 	NULL,
 };
 
@@ -1107,6 +1335,7 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 			pcpu->max_freq = policy->max;
 			down_write(&pcpu->enable_sem);
 			cpufreq_interactive_timer_start(j);
+			cpufreq_interactive_sched_load_start(j);
 			pcpu->governor_enabled = 1;
 			up_write(&pcpu->enable_sem);
 		}
@@ -1130,6 +1359,12 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 		idle_notifier_register(&cpufreq_interactive_idle_nb);
 		cpufreq_register_notifier(
 			&cpufreq_notifier_block, CPUFREQ_TRANSITION_NOTIFIER);
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+		rc = sched_load_notify_register(cpufreq_interactive_sched_load);
+		if (rc)
+			pr_warn("cpufreq_interactive: scheduler load hook busy, "
+				"no load will be seen\n");
+#endif
 		mutex_unlock(&gov_lock);
 		break;
 
@@ -1139,6 +1374,7 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 			pcpu = &per_cpu(cpuinfo, j);
 			down_write(&pcpu->enable_sem);
 			pcpu->governor_enabled = 0;
+			cpufreq_interactive_sched_load_stop(j);
 			del_timer_sync(&pcpu->cpu_timer);
 			del_timer_sync(&pcpu->cpu_slack_timer);
 			up_write(&pcpu->enable_sem);
@@ -1149,6 +1385,10 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 			return 0;
 		}
 
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+		sched_load_notify_unregister(cpufreq_interactive_sched_load);
+		irq_work_sync(&sched_ramp_work);
+#endif
 		cpufreq_unregister_notifier(
 			&cpufreq_notifier_block, CPUFREQ_TRANSITION_NOTIFIER);
 		idle_notifier_unregister(&cpufreq_interactive_idle_nb);
@@ -1231,6 +1471,10 @@ static int __init cpufreq_interactive_init(void)
 	spin_lock_init(&target_loads_lock);
 	spin_lock_init(&speedchange_cpumask_lock);
 	spin_lock_init(&above_hispeed_delay_lock);
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE_SCHED_LOAD
+	spin_lock_init(&sched_ramp_cpumask_lock);
+	init_irq_work(&sched_ramp_work, cpufreq_interactive_sched_ramp);
+#endif
 	mutex_init(&gov_lock);
 	speedchange_task =
 		kthread_create(cpufreq_interactive_speedchange_task, NULL,
@@ -0,0 +1,421 @@
+/*
+ * drivers/cpufreq/cpufreq_record.c
+ *
+ * Records what the cpufreq governors react to, for offline replay.
+ *
+ * While enabled, the load of every online CPU is sampled every sample_ms,
+ * and frequency transitions, touch and key input and display vsyncs are
+ * logged with their time into a ring buffer. Reading
+ * /sys/kernel/debug/cpufreq_record/trace returns the buffered records,
+ * oldest first, as an array of struct cpufreq_record_entry.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ */
+
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/input.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/tick.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
+#include <linux/debugfs.h>
+#include <linux/uaccess.h>
+
+enum {
+	CPUFREQ_RECORD_LOAD,	/* a: load per mille, b: frequency in kHz */
+	CPUFREQ_RECORD_FREQ,	/* a: new frequency, b: old frequency */
+	CPUFREQ_RECORD_INPUT,	/* a: type << 16 | code, b: value */
+	CPUFREQ_RECORD_VSYNC,
+};
+
+struct cpufreq_record_entry {
+	u64 time_ns;
+	u8 type;
+	u8 cpu;
+	u16 reserved;
+	u32 a;
+	u32 b;
+} __packed;
+
+static unsigned int buffer_kb = 256;
+module_param(buffer_kb, uint, 0644);
+MODULE_PARM_DESC(buffer_kb, "Size of the ring buffer, used when recording starts");
+
+static unsigned int sample_ms = 20;
+module_param(sample_ms, uint, 0644);
+MODULE_PARM_DESC(sample_ms, "Load sampling period");
+
+static unsigned int overruns;
+module_param(overruns, uint, 0444);
+MODULE_PARM_DESC(overruns, "Records overwritten before they were read");
+
+static DEFINE_MUTEX(record_mutex);
+static DEFINE_SPINLOCK(record_lock);
+static struct cpufreq_record_entry *record_buf;
+static unsigned int record_size;
+static unsigned int record_head;
+static unsigned int record_count;
+static bool recording;
+
+struct record_cpu {
+	u64 prev_idle;
+	u64 prev_wall;
+};
+
+static DEFINE_PER_CPU(struct record_cpu, record_cpus);
+
+static void record_sample_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(record_sample_work, record_sample_fn);
+
+static void cpufreq_record_add(u8 type, unsigned int cpu, u32 a, u32 b)
+{
+	struct cpufreq_record_entry *e;
+	unsigned long flags;
+
+	spin_lock_irqsave(&record_lock, flags);
+	if (!recording)
+		goto out;
+
+	e = &record_buf[record_head];
+	e->time_ns = ktime_to_ns(ktime_get());
+	e->type = type;
+	e->cpu = cpu;
+	e->reserved = 0;
+	e->a = a;
+	e->b = b;
+
+	record_head = (record_head + 1) % record_size;
+	if (record_count < record_size)
+		record_count++;
+	else
+		overruns++;
+out:
+	spin_unlock_irqrestore(&record_lock, flags);
+}
+
+/**
+ * cpufreq_record_vsync - log a display vsync
+ *
+ * Can be called from interrupt context.
+ */
+void cpufreq_record_vsync(void)
+{
+	if (ACCESS_ONCE(recording))
+		cpufreq_record_add(CPUFREQ_RECORD_VSYNC, smp_processor_id(),
+				   0, 0);
+}
+EXPORT_SYMBOL_GPL(cpufreq_record_vsync);
+
+static void record_sample_fn(struct work_struct *work)
+{
+	struct record_cpu *rc;
+	u64 idle, wall, d_idle, d_wall;
+	unsigned int cpu, load;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu) {
+		rc = &per_cpu(record_cpus, cpu);
+		idle = get_cpu_idle_time_us(cpu, &wall);
+		d_idle = idle - rc->prev_idle;
+		d_wall = wall - rc->prev_wall;
+		rc->prev_idle = idle;
+		rc->prev_wall = wall;
+
+		if (!d_wall || d_idle > d_wall)
+			load = 0;
+		else
+			load = div64_u64((d_wall - d_idle) * 1000, d_wall);
+
+		cpufreq_record_add(CPUFREQ_RECORD_LOAD, cpu, load,
+				   cpufreq_quick_get(cpu));
+	}
+	put_online_cpus();
+
+	if (ACCESS_ONCE(recording))
+		schedule_delayed_work(&record_sample_work,
+				      msecs_to_jiffies(sample_ms));
+}
+
+static int record_transition_notifier(struct notifier_block *nb,
+				      unsigned long val, void *data)
+{
+	struct cpufreq_freqs *freqs = data;
+
+	if (val == CPUFREQ_POSTCHANGE)
+		cpufreq_record_add(CPUFREQ_RECORD_FREQ, freqs->cpu,
+				   freqs->new, freqs->old);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block record_transition_nb = {
+	.notifier_call = record_transition_notifier,
+};
+
+static void record_input_event(struct input_handle *handle,
+		unsigned int type, unsigned int code, int value)
+{
+	/* A report closes every touch frame, the coordinates are not needed */
+	if (type != EV_KEY && !(type == EV_SYN && code == SYN_REPORT))
+		return;
+
+	cpufreq_record_add(CPUFREQ_RECORD_INPUT, smp_processor_id(),
+			   type << 16 | code, value);
+}
+
+static int record_input_connect(struct input_handler *handler,
+		struct input_dev *dev, const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int error;
+
+	handle = kzalloc(sizeof(struct input_handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "cpufreq_record";
+
+	error = input_register_handle(handle);
+	if (error)
+		goto err_register;
+
+	error = input_open_device(handle);
+	if (error)
+		goto err_open;
+
+	return 0;
+
+err_open:
+	input_unregister_handle(handle);
+err_register:
+	kfree(handle);
+	return error;
+}
+
+static void record_input_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id record_input_ids[] = {
+	/* multi-touch touchscreen */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_MT_POSITION_X)] =
+			BIT_MASK(ABS_MT_POSITION_X) |
+			BIT_MASK(ABS_MT_POSITION_Y) },
+	},
+	/* keys */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT,
+		.evbit = { BIT_MASK(EV_KEY) },
+	},
+	{ },
+};
+
+static struct input_handler record_input_handler = {
+	.event		= record_input_event,
+	.connect	= record_input_connect,
+	.disconnect	= record_input_disconnect,
+	.name		= "cpufreq_record",
+	.id_table	= record_input_ids,
+};
+
+static int record_start(void)
+{
+	struct cpufreq_record_entry *buf;
+	unsigned int size, cpu;
+	int ret;
+
+	size = buffer_kb * 1024 / sizeof(struct cpufreq_record_entry);
+	if (!size)
+		return -EINVAL;
+
+	buf = vmalloc(size * sizeof(struct cpufreq_record_entry));
+	if (!buf)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct record_cpu *rc = &per_cpu(record_cpus, cpu);
+
+		rc->prev_idle = get_cpu_idle_time_us(cpu, &rc->prev_wall);
+	}
+
+	spin_lock_irq(&record_lock);
+	record_buf = buf;
+	record_size = size;
+	record_head = 0;
+	record_count = 0;
+	overruns = 0;
+	recording = true;
+	spin_unlock_irq(&record_lock);
+
+	ret = cpufreq_register_notifier(&record_transition_nb,
+					CPUFREQ_TRANSITION_NOTIFIER);
+	if (ret)
+		goto err;
+
+	ret = input_register_handler(&record_input_handler);
+	if (ret) {
+		cpufreq_unregister_notifier(&record_transition_nb,
+					    CPUFREQ_TRANSITION_NOTIFIER);
+		goto err;
+	}
+
+	schedule_delayed_work(&record_sample_work, msecs_to_jiffies(sample_ms));
+	return 0;
+
+err:
+	spin_lock_irq(&record_lock);
+	recording = false;
+	record_buf = NULL;
+	spin_unlock_irq(&record_lock);
+	vfree(buf);
+	return ret;
+}
+
+/* The buffer is kept for reading until the next start */
+static void record_stop(void)
+{
+	spin_lock_irq(&record_lock);
+	recording = false;
+	spin_unlock_irq(&record_lock);
+
+	cancel_delayed_work_sync(&record_sample_work);
+	input_unregister_handler(&record_input_handler);
+	cpufreq_unregister_notifier(&record_transition_nb,
+				    CPUFREQ_TRANSITION_NOTIFIER);
+}
+
+static bool enable;
+/* Boot parameters are parsed before cpufreq and input are up */
+static bool record_ready;
+
+static int enable_set(const char *val, const struct kernel_param *kp)
+{
+	bool old;
+	int ret;
+
+	mutex_lock(&record_mutex);
+	old = enable;
+	ret = param_set_bool(val, kp);
+	if (ret || old == enable || !record_ready)
+		goto out;
+
+	if (enable) {
+		/* Drop the records of the previous run */
+		vfree(record_buf);
+		record_buf = NULL;
+		ret = record_start();
+		if (ret)
+			enable = false;
+	} else {
+		record_stop();
+	}
+out:
+	mutex_unlock(&record_mutex);
+	return ret;
+}
+
+static struct kernel_param_ops enable_ops = {
+	.set = enable_set,
+	.get = param_get_bool,
+};
+
+module_param_cb(enable, &enable_ops, &enable, 0644);
+MODULE_PARM_DESC(enable, "Record governor inputs");
+
+struct record_snapshot {
+	size_t len;
+	char data[0];
+};
+
+static int record_trace_open(struct inode *inode, struct file *file)
+{
+	struct record_snapshot *snap;
+	unsigned int count, first, n;
+	size_t entry = sizeof(struct cpufreq_record_entry);
+
+	mutex_lock(&record_mutex);
+
+	count = ACCESS_ONCE(record_count);
+	snap = vmalloc(sizeof(*snap) + count * entry);
+	if (!snap) {
+		mutex_unlock(&record_mutex);
+		return -ENOMEM;
+	}
+
+	spin_lock_irq(&record_lock);
+	if (record_buf) {
+		/* Newer records are left out, they did not fit */
+		first = (record_head + record_size - record_count) % record_size;
+		count = min(count, record_count);
+		n = min(count, record_size - first);
+		memcpy(snap->data, &record_buf[first], n * entry);
+		memcpy(snap->data + n * entry, record_buf, (count - n) * entry);
+	} else {
+		count = 0;
+	}
+	spin_unlock_irq(&record_lock);
+	mutex_unlock(&record_mutex);
+
+	snap->len = count * entry;
+	file->private_data = snap;
+	return 0;
+}
+
+static ssize_t record_trace_read(struct file *file, char __user *buf,
+				 size_t len, loff_t *ppos)
+{
+	struct record_snapshot *snap = file->private_data;
+
+	return simple_read_from_buffer(buf, len, ppos, snap->data, snap->len);
+}
+
+static int record_trace_release(struct inode *inode, struct file *file)
+{
+	vfree(file->private_data);
+	return 0;
+}
+
+static const struct file_operations record_trace_fops = {
+	.open		= record_trace_open,
+	.read		= record_trace_read,
+	.llseek		= default_llseek,
+	.release	= record_trace_release,
+};
+
+static int __init cpufreq_record_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("cpufreq_record", NULL);
+	if (IS_ERR_OR_NULL(dir))
+		return -ENOMEM;
+
+	debugfs_create_file("trace", S_IRUSR, dir, NULL, &record_trace_fops);
+
+	mutex_lock(&record_mutex);
+	record_ready = true;
+	if (enable && record_start())
+		enable = false;
+	mutex_unlock(&record_mutex);
+
+	return 0;
+}
+late_initcall(cpufreq_record_init);
+
+MODULE_DESCRIPTION("Recorder of the cpufreq governor inputs");
+MODULE_LICENSE("GPL");
@@ -143,18 +143,25 @@ static int get_index_all_cpufreq_stat(struct all_cpufreq_stats *all_stat,
 void acct_update_power(struct task_struct *task, cputime_t cputime) {
 	struct cpufreq_power_stats *powerstats;
 	struct cpufreq_stats *stats;
-	unsigned int cpu_num, curr;
+	unsigned int cpu_num, curr = 0, usecs;
 
 	if (!task)
 		return;
 	cpu_num = task_cpu(task);
 	powerstats = per_cpu(cpufreq_power_stats, cpu_num);
 	stats = per_cpu(cpufreq_stats_table, cpu_num);
-	if (!powerstats || !stats)
+	if (!stats || stats->last_index >= stats->state_num)
 		return;
 
-	curr = powerstats->curr[stats->last_index];
-	task->cpu_power += curr * cputime_to_usecs(cputime);
+	usecs = cputime_to_usecs(cputime);
+	if (powerstats) {
+		curr = powerstats->curr[stats->last_index];
+		task->cpu_power += curr * usecs;
+	}
+
+	uid_cputime_account_freq(task_uid(task),
+				 stats->freq_table[stats->last_index], usecs,
+				 (unsigned long long)curr * usecs);
 }
 EXPORT_SYMBOL_GPL(acct_update_power);
 
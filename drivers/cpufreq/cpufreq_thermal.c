@@ -0,0 +1,355 @@
+/*
+ * drivers/cpufreq/cpufreq_thermal.c
+ *
+ * Predictive thermal limiting for ux500.
+ *
+ * Every poll_ms the DB8500 die temperature and the battery temperature
+ * measured by the AB8500 are read through the hwmon drivers, and each is
+ * extrapolated horizon_ms ahead along its recent slope. While one of the
+ * predictions is above its target the limit level goes up by one, once
+ * all of them are hyst degrees below their targets it goes down by one.
+ * Each level caps a little more, in this order:
+ *
+ *  - the ARM frequency, one frequency table step per level down to
+ *    floor_freq,
+ *  - the online CPUs, to one, through the hotplug manager,
+ *  - the APE and DDR OPPs, to 50%, through a PRCMU QoS ceiling.
+ *
+ * A hwmon alarm raises the level by alarm_levels at once, without waiting
+ * for the next poll.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/hwmon.h>
+#include <linux/hotplug_mgr.h>
+#include <linux/workqueue.h>
+#include <linux/jiffies.h>
+#include <linux/math64.h>
+#include <linux/mfd/dbx500-prcmu.h>
+
+#define THERMAL_MAX_STEPS	16
+
+/* abx500 hwmon index of BAT_CTRL, in millidegrees */
+#define THERMAL_AB8500_BAT_CTRL	4
+
+static unsigned int poll_ms = 1000;
+module_param(poll_ms, uint, 0644);
+MODULE_PARM_DESC(poll_ms, "Time between two temperature readings");
+
+static unsigned int horizon_ms = 10000;
+module_param(horizon_ms, uint, 0644);
+MODULE_PARM_DESC(horizon_ms, "How far ahead the temperatures are predicted");
+
+static int db_target = 80;
+module_param(db_target, int, 0644);
+MODULE_PARM_DESC(db_target, "DB8500 die temperature to stay below, in degrees C");
+
+static int bat_target = 45;
+module_param(bat_target, int, 0644);
+MODULE_PARM_DESC(bat_target, "Battery temperature to stay below, in degrees C");
+
+static unsigned int hyst = 3;
+module_param(hyst, uint, 0644);
+MODULE_PARM_DESC(hyst, "Degrees below the targets before limits are lifted");
+
+static unsigned int alarm_levels = 2;
+module_param(alarm_levels, uint, 0644);
+MODULE_PARM_DESC(alarm_levels, "Levels a hwmon alarm raises the limit by");
+
+static unsigned int floor_freq = 400000;
+module_param(floor_freq, uint, 0444);
+MODULE_PARM_DESC(floor_freq, "Lowest frequency cap in kHz");
+
+static unsigned int level;
+module_param(level, uint, 0444);
+MODULE_PARM_DESC(level, "Current limit level, 0 for none");
+
+static int db_temp;
+module_param(db_temp, int, 0444);
+MODULE_PARM_DESC(db_temp, "Last DB8500 die temperature in degrees C");
+
+static int bat_temp;
+module_param(bat_temp, int, 0444);
+MODULE_PARM_DESC(bat_temp, "Last battery temperature in degrees C");
+
+static unsigned int throttle_count;
+module_param(throttle_count, uint, 0444);
+MODULE_PARM_DESC(throttle_count, "Number of times the limit level went up");
+
+struct thermal_sensor {
+	int (*read)(int *temp);		/* millidegrees C */
+	int *target;			/* degrees C */
+	int *reading;			/* degrees C */
+	bool valid;
+	int temp;
+	int slope;			/* millidegrees C per second */
+	unsigned long stamp;
+};
+
+static int thermal_read_db(int *temp)
+{
+	int val = dbx500_temp_read();
+
+	if (val < 0)
+		return val;
+
+	*temp = val * 1000;
+	return 0;
+}
+
+static int thermal_read_bat(int *temp)
+{
+	return abx500_temp_read(THERMAL_AB8500_BAT_CTRL, temp);
+}
+
+static struct thermal_sensor thermal_sensors[] = {
+	{ .read = thermal_read_db, .target = &db_target, .reading = &db_temp },
+	{ .read = thermal_read_bat, .target = &bat_target,
+	  .reading = &bat_temp },
+};
+
+/* Frequency caps by level, highest first, freqs[0] is no cap */
+static unsigned int freqs[THERMAL_MAX_STEPS + 1];
+static unsigned int nr_steps;
+
+/* Only touched by the work, or before it is started */
+static unsigned int cap_freq;
+static bool hotplug_capped;
+static bool opp_capped;
+
+static struct hotplug_request thermal_hotplug_req;
+static atomic_t alarm_pending = ATOMIC_INIT(0);
+
+static struct workqueue_struct *thermal_wq;
+static void thermal_poll_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(thermal_poll_work, thermal_poll_fn);
+
+static void thermal_sensor_update(struct thermal_sensor *s,
+				  unsigned long now)
+{
+	unsigned int ms;
+	int temp, rate;
+
+	if (s->read(&temp)) {
+		s->valid = false;
+		return;
+	}
+
+	if (s->valid) {
+		ms = jiffies_to_msecs(now - s->stamp);
+		if (!ms)
+			return;
+		rate = (temp - s->temp) * 1000 / (int)ms;
+		s->slope = (3 * s->slope + rate) / 4;
+	} else {
+		s->slope = 0;
+	}
+
+	s->temp = temp;
+	s->stamp = now;
+	s->valid = true;
+	*s->reading = temp / 1000;
+}
+
+/* Millidegrees the sensor is predicted to be above its target */
+static int thermal_sensor_excess(struct thermal_sensor *s)
+{
+	s64 predicted = s->temp +
+		div_s64((s64)s->slope * horizon_ms, 1000);
+
+	return (int)(predicted - *s->target * 1000);
+}
+
+static void thermal_update_policies(void)
+{
+	unsigned int cpu;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu)
+		cpufreq_update_policy(cpu);
+	put_online_cpus();
+}
+
+static void thermal_apply(unsigned int new_level)
+{
+	unsigned int old_freq = cap_freq;
+	bool hotplug = new_level > nr_steps;
+	bool opp = new_level > nr_steps + 1;
+
+	if (new_level > level)
+		throttle_count++;
+	level = new_level;
+
+	cap_freq = freqs[min(new_level, nr_steps)];
+	if (cap_freq == freqs[0])
+		cap_freq = 0;
+	if (cap_freq != old_freq)
+		thermal_update_policies();
+
+	if (hotplug != hotplug_capped) {
+		hotplug_mgr_update_request(&thermal_hotplug_req, 0,
+					   hotplug ? 1 : 0);
+		hotplug_capped = hotplug;
+	}
+
+	if (opp != opp_capped) {
+		prcmu_qos_set_ceiling(PRCMU_QOS_APE_OPP, opp ? 50 : 0);
+		prcmu_qos_set_ceiling(PRCMU_QOS_DDR_OPP, opp ? 50 : 0);
+		opp_capped = opp;
+	}
+}
+
+static void thermal_poll_fn(struct work_struct *work)
+{
+	unsigned int new_level = level;
+	unsigned long now = jiffies;
+	int excess = INT_MIN;
+	bool alarm;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(thermal_sensors); i++) {
+		struct thermal_sensor *s = &thermal_sensors[i];
+
+		thermal_sensor_update(s, now);
+		if (s->valid)
+			excess = max(excess, thermal_sensor_excess(s));
+	}
+
+	alarm = atomic_xchg(&alarm_pending, 0);
+	if (alarm)
+		new_level += alarm_levels;
+
+	if (excess > 0)
+		new_level++;
+	else if (!alarm && new_level && excess < -(int)hyst * 1000)
+		new_level--;
+
+	/* Beyond the frequency steps come hotplug and then the OPPs */
+	new_level = min(new_level, nr_steps + 2);
+	if (new_level != level)
+		thermal_apply(new_level);
+
+	queue_delayed_work(thermal_wq, &thermal_poll_work,
+			   msecs_to_jiffies(poll_ms));
+}
+
+static int thermal_hwmon_notify(struct notifier_block *nb,
+				unsigned long val, void *v)
+{
+	/* Alarms are also notified as they clear */
+	if (!val)
+		return NOTIFY_DONE;
+
+	atomic_set(&alarm_pending, 1);
+	cancel_delayed_work(&thermal_poll_work);
+	queue_delayed_work(thermal_wq, &thermal_poll_work, 0);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block thermal_hwmon_nb = {
+	.notifier_call = thermal_hwmon_notify,
+};
+
+static int thermal_policy_notifier(struct notifier_block *nb,
+				   unsigned long event, void *data)
+{
+	struct cpufreq_policy *policy = data;
+	unsigned int cap = ACCESS_ONCE(cap_freq);
+
+	if (event != CPUFREQ_ADJUST || !cap)
+		return NOTIFY_DONE;
+
+	cpufreq_verify_within_limits(policy, 0, cap);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block thermal_policy_nb = {
+	.notifier_call = thermal_policy_notifier,
+};
+
+/* The distinct frequencies of the table down to floor_freq, highest first */
+static int __init thermal_init_freqs(void)
+{
+	struct cpufreq_frequency_table *table;
+	unsigned int f;
+	int i, j, n = 0;
+
+	table = cpufreq_frequency_get_table(0);
+	if (!table)
+		return -ENODEV;
+
+	for (i = 0; table[i].frequency != CPUFREQ_TABLE_END; i++) {
+		f = table[i].frequency;
+		if (f == CPUFREQ_ENTRY_INVALID || f < floor_freq)
+			continue;
+
+		for (j = 0; j < n && freqs[j] > f; j++)
+			;
+		if (j < n && freqs[j] == f)
+			continue;
+		if (n == ARRAY_SIZE(freqs)) {
+			/* the lowest falls off */
+			if (j == n)
+				continue;
+			n--;
+		}
+		memmove(&freqs[j + 1], &freqs[j], (n - j) * sizeof(freqs[0]));
+		freqs[j] = f;
+		n++;
+	}
+
+	if (!n)
+		return -ENODEV;
+
+	nr_steps = n - 1;
+	return 0;
+}
+
+static int __init cpufreq_thermal_init(void)
+{
+	int ret;
+
+	ret = thermal_init_freqs();
+	if (ret)
+		return ret;
+
+	thermal_wq = alloc_workqueue("cpufreq_thermal", WQ_FREEZABLE, 1);
+	if (!thermal_wq)
+		return -ENOMEM;
+
+	hotplug_mgr_add_request(&thermal_hotplug_req, "thermal", 0, 0);
+
+	ret = cpufreq_register_notifier(&thermal_policy_nb,
+					CPUFREQ_POLICY_NOTIFIER);
+	if (ret)
+		goto err_notifier;
+
+	hwmon_notifier_register(&thermal_hwmon_nb);
+
+	queue_delayed_work(thermal_wq, &thermal_poll_work,
+			   msecs_to_jiffies(poll_ms));
+	return 0;
+
+err_notifier:
+	hotplug_mgr_remove_request(&thermal_hotplug_req);
+	destroy_workqueue(thermal_wq);
+	return ret;
+}
+late_initcall(cpufreq_thermal_init);
+
+MODULE_DESCRIPTION("Predictive thermal limiting for ux500");
+MODULE_LICENSE("GPL");
@@ -32,6 +32,7 @@
 #include <linux/kthread.h>
 #include <linux/slab.h>
 #include <linux/input/input_boost.h>
+#include <linux/hotplug_mgr.h>
 #include <linux/mfd/dbx500-prcmu.h>
 
 #include <asm/cputime.h>
@@ -72,6 +73,11 @@ static struct mutex gov_lock;
 /* workqueues handle hotplugging */
 static struct workqueue_struct *hotplug_add_wq;
 static struct work_struct hotplug_add_work;
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+/* CPU add/remove decisions become votes to the hotplug manager */
+static struct hotplug_request zenx_hotplug_req;
+#endif
+
 static cpumask_t hotplug_add_cpumask;
 static spinlock_t hotplug_add_cpumask_lock;
 static struct workqueue_struct *hotplug_remove_wq;
@@ -656,7 +662,11 @@ static void cpufreq_zenx_hotplug_add_cpu_work(struct work_struct *work)
 		}
 
 		if (likely(cpu > 0)) {
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+			hotplug_mgr_vote_cpu(&zenx_hotplug_req, cpu, true);
+#else
 			cpu_up(cpu);
+#endif
 		}
 		up_read(&pcpu->enable_sem);
 	}
@@ -685,7 +695,11 @@ static void cpufreq_zenx_hotplug_remove_cpu_work(struct work_struct *work)
 		}
 
 		if (likely(cpu > 0)) {
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+			hotplug_mgr_vote_cpu(&zenx_hotplug_req, cpu, false);
+#else
 			cpu_down(cpu);
+#endif
 		}
 
 		up_read(&pcpu->enable_sem);
@@ -1314,6 +1328,9 @@ static int cpufreq_governor_zenx(struct cpufreq_policy *policy,
 		idle_notifier_register(&cpufreq_zenx_idle_nb);
 		cpufreq_register_notifier(
 			&cpufreq_notifier_block, CPUFREQ_TRANSITION_NOTIFIER);
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+		hotplug_mgr_add_request(&zenx_hotplug_req, "zenx", 0, 0);
+#endif
 		mutex_unlock(&gov_lock);
 		break;
 
@@ -1338,6 +1355,12 @@ static int cpufreq_governor_zenx(struct cpufreq_policy *policy,
 		idle_notifier_unregister(&cpufreq_zenx_idle_nb);
 		sysfs_remove_group(cpufreq_global_kobject,
 				&zenx_attr_group);
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+		/* Flush votes still in flight before dropping the request */
+		flush_workqueue(hotplug_add_wq);
+		flush_workqueue(hotplug_remove_wq);
+		hotplug_mgr_remove_request(&zenx_hotplug_req);
+#endif
 		mutex_unlock(&gov_lock);
 
 		/*
@@ -415,6 +415,8 @@
  *	  profile_number		-> switches profile (possible value depends on amount of profiles in cpufreq_zzmoove_profiles.h file,
  *					   please check this file for futher details!) 0 no profile set = tuneable mode, default 0)
  *	  version_profiles		-> read only and shows version of profile header file
+ *	  profile_blob			-> write only, takes a whole binary struct zzmoove_profile in one write and applies it
+ *					   at the next sample (profile_number is set to 0 then)
  *
  *	  if ZZMOOVE_DEBUG is defined:
  *	  debug				-> read only and shows various usefull debugging infos
@@ -432,11 +434,14 @@
 #include <linux/jiffies.h>
 #include <linux/kernel_stat.h>
 #include <linux/mutex.h>
+#include <linux/rwsem.h>
+#include <linux/spinlock.h>
 #include <linux/hrtimer.h>
 #include <linux/tick.h>
 #include <linux/ktime.h>
 #include <linux/sched.h>
 #include <linux/earlysuspend.h>
+#include <linux/hotplug_mgr.h>
 
 // ZZ: include profiles header file and set name for 'custom' profile (informational for a changed profile value)
 #include "cpufreq_zzmoove_profiles.h"
@@ -643,6 +648,16 @@ static unsigned int fast_scaling_asleep;			// ZZ: for setting fast scaling value
 static unsigned int freq_step_asleep;				// ZZ: for setting freq step value at early suspend
 static unsigned int disable_hotplug_asleep;			// ZZ: for setting hotplug on/off at early suspend
 
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+// ZZ: hotplug decisions become votes to the hotplug manager
+static struct hotplug_request zz_hotplug_req;
+#define zz_cpu_up(cpu)		hotplug_mgr_vote_cpu(&zz_hotplug_req, (cpu), true)
+#define zz_cpu_down(cpu)	hotplug_mgr_vote_cpu(&zz_hotplug_req, (cpu), false)
+#else
+#define zz_cpu_up(cpu)		cpu_up(cpu)
+#define zz_cpu_down(cpu)	cpu_down(cpu)
+#endif
+
 struct work_struct hotplug_offline_work;			// ZZ: hotplugging down work
 struct work_struct hotplug_online_work;				// ZZ: hotplugging up work
 
@@ -1017,7 +1032,7 @@ static inline void enable_offline_cores(void)
 
 	for (i = 1; i < possible_cpus; i++) {			// ZZ: enable all offline cores
 	    if (!cpu_online(i))
-	    cpu_up(i);
+	    zz_cpu_up(i);
 	}
 	enable_cores = false;					// ZZ: reset enable flag again
 }
@@ -2592,666 +2607,742 @@ static ssize_t store_scaling_block_force_down(struct kobject *a, struct attribut
 	return count;
 }
 
-static ssize_t store_profile_number(struct kobject *a, struct attribute *b,
-					const char *buf, size_t count)
+// ZZ: held for writing while a profile is applied and for reading by every sample
+static DECLARE_RWSEM(profile_blob_sem);
+
+// ZZ: apply all tuneables of a profile, values out of range are kept as they are
+static int apply_profile(struct zzmoove_profile *p)
 {
 	struct cpufreq_frequency_table *table;		// ZZ: for tuneables using system table
-	unsigned int input;				// ZZ: regular input handling of this tuneable
-	int ret;					// ZZ: regular input handling of this tuneable
-	int i = 0;					// ZZ: for main profile loop
 	int t = 0;					// ZZ: for tuneables sub-loops
 	unsigned int j;					// ZZ: for tuneables update routines
 
 	table = cpufreq_frequency_get_table(0);		// ZZ: for tuneables using system table
-	ret = sscanf(buf, "%u", &input);		// ZZ: regular input handling of this tuneable
 
-	if (ret != 1)
-	    return -EINVAL;
-
-	// ZZ: if input is 0 set profile to custom mode
-	if (input == 0) {
-	    dbs_tuners_ins.profile_number = input;
-	    strncpy(dbs_tuners_ins.profile, custom_profile, sizeof(dbs_tuners_ins.profile));
-	return count;
+	// ZZ: set disable_hotplug value
+	if (p->disable_hotplug > 0) {
+	    dbs_tuners_ins.disable_hotplug = true;
+	    enable_cores = true;
+	    queue_work_on(0, dbs_wq, &hotplug_online_work);
+	} else {
+	    dbs_tuners_ins.disable_hotplug = false;
 	}
 
-	for (i = 0; (unlikely(zzmoove_profiles[i].profile_number != PROFILE_TABLE_END)); i++) {
-	    if (unlikely(zzmoove_profiles[i].profile_number == input)) {
-
-		// ZZ: set disable_hotplug value
-		if (zzmoove_profiles[i].disable_hotplug > 0) {
-		    dbs_tuners_ins.disable_hotplug = true;
-		    enable_cores = true;
-		    queue_work_on(0, dbs_wq, &hotplug_online_work);
-		} else {
-		    dbs_tuners_ins.disable_hotplug = false;
-		}
+	// ZZ: set disable_hotplug_sleep value
+	if (p->disable_hotplug_sleep > 0)
+	    dbs_tuners_ins.disable_hotplug_sleep = true;
+	else
+	    dbs_tuners_ins.disable_hotplug_sleep = false;
 
-		// ZZ: set disable_hotplug_sleep value
-		if (zzmoove_profiles[i].disable_hotplug_sleep > 0)
-		    dbs_tuners_ins.disable_hotplug_sleep = true;
-		else
-		    dbs_tuners_ins.disable_hotplug_sleep = false;
-
-		// ZZ: set down_threshold value
-		if (zzmoove_profiles[i].down_threshold > 11 && zzmoove_profiles[i].down_threshold <= 100
-		    && zzmoove_profiles[i].down_threshold < zzmoove_profiles[i].up_threshold)
-		    dbs_tuners_ins.down_threshold = zzmoove_profiles[i].down_threshold;
-
-		// ZZ: set down_threshold_hotplug1 value
-		if ((zzmoove_profiles[i].down_threshold_hotplug1 <= 100
-		    && zzmoove_profiles[i].down_threshold_hotplug1 >= 1)
-		    || zzmoove_profiles[i].down_threshold_hotplug1 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug1 = zzmoove_profiles[i].down_threshold_hotplug1;
-		    hotplug_thresholds[0][0] = zzmoove_profiles[i].down_threshold_hotplug1;
-		}
+	// ZZ: set down_threshold value
+	if (p->down_threshold > 11 && p->down_threshold <= 100
+	    && p->down_threshold < p->up_threshold)
+	    dbs_tuners_ins.down_threshold = p->down_threshold;
+
+	// ZZ: set down_threshold_hotplug1 value
+	if ((p->down_threshold_hotplug1 <= 100
+	    && p->down_threshold_hotplug1 >= 1)
+	    || p->down_threshold_hotplug1 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug1 = p->down_threshold_hotplug1;
+	    hotplug_thresholds[0][0] = p->down_threshold_hotplug1;
+	}
 #if (MAX_CORES == 4 || MAX_CORES == 8)
-		// ZZ: set down_threshold_hotplug2 value
-		if ((zzmoove_profiles[i].down_threshold_hotplug2 <= 100
-		    && zzmoove_profiles[i].down_threshold_hotplug2 >= 1)
-		    || zzmoove_profiles[i].down_threshold_hotplug2 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug2 = zzmoove_profiles[i].down_threshold_hotplug2;
-		    hotplug_thresholds[0][1] = zzmoove_profiles[i].down_threshold_hotplug2;
-		}
+	// ZZ: set down_threshold_hotplug2 value
+	if ((p->down_threshold_hotplug2 <= 100
+	    && p->down_threshold_hotplug2 >= 1)
+	    || p->down_threshold_hotplug2 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug2 = p->down_threshold_hotplug2;
+	    hotplug_thresholds[0][1] = p->down_threshold_hotplug2;
+	}
 
-		// ZZ: set down_threshold_hotplug3 value
-		if ((zzmoove_profiles[i].down_threshold_hotplug3 <= 100
-		    && zzmoove_profiles[i].down_threshold_hotplug3 >= 1)
-		    || zzmoove_profiles[i].down_threshold_hotplug3 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug3 = zzmoove_profiles[i].down_threshold_hotplug3;
-		    hotplug_thresholds[0][2] = zzmoove_profiles[i].down_threshold_hotplug3;
-		}
+	// ZZ: set down_threshold_hotplug3 value
+	if ((p->down_threshold_hotplug3 <= 100
+	    && p->down_threshold_hotplug3 >= 1)
+	    || p->down_threshold_hotplug3 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug3 = p->down_threshold_hotplug3;
+	    hotplug_thresholds[0][2] = p->down_threshold_hotplug3;
+	}
 #endif
 #if (MAX_CORES == 8)
-		// ZZ: set down_threshold_hotplug4 value
-		if ((zzmoove_profiles[i].down_threshold_hotplug4 <= 100
-		    && zzmoove_profiles[i].down_threshold_hotplug4 >= 1)
-		    || zzmoove_profiles[i].down_threshold_hotplug4 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug4 = zzmoove_profiles[i].down_threshold_hotplug4;
-		    hotplug_thresholds[0][3] = zzmoove_profiles[i].down_threshold_hotplug4;
-		}
+	// ZZ: set down_threshold_hotplug4 value
+	if ((p->down_threshold_hotplug4 <= 100
+	    && p->down_threshold_hotplug4 >= 1)
+	    || p->down_threshold_hotplug4 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug4 = p->down_threshold_hotplug4;
+	    hotplug_thresholds[0][3] = p->down_threshold_hotplug4;
+	}
 
-		// ZZ: set down_threshold_hotplug5 value
-		if ((zzmoove_profiles[i].down_threshold_hotplug5 <= 100
-		    && zzmoove_profiles[i].down_threshold_hotplug5 >= 1)
-		    || zzmoove_profiles[i].down_threshold_hotplug5 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug5 = zzmoove_profiles[i].down_threshold_hotplug5;
-		    hotplug_thresholds[0][4] = zzmoove_profiles[i].down_threshold_hotplug5;
-		}
+	// ZZ: set down_threshold_hotplug5 value
+	if ((p->down_threshold_hotplug5 <= 100
+	    && p->down_threshold_hotplug5 >= 1)
+	    || p->down_threshold_hotplug5 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug5 = p->down_threshold_hotplug5;
+	    hotplug_thresholds[0][4] = p->down_threshold_hotplug5;
+	}
 
-		// ZZ: set down_threshold_hotplug6 value
-		if ((zzmoove_profiles[i].down_threshold_hotplug6 <= 100
-		    && zzmoove_profiles[i].down_threshold_hotplug6 >= 1)
-		    || zzmoove_profiles[i].down_threshold_hotplug6 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug6 = zzmoove_profiles[i].down_threshold_hotplug6;
-		    hotplug_thresholds[0][5] = zzmoove_profiles[i].down_threshold_hotplug6;
-		}
+	// ZZ: set down_threshold_hotplug6 value
+	if ((p->down_threshold_hotplug6 <= 100
+	    && p->down_threshold_hotplug6 >= 1)
+	    || p->down_threshold_hotplug6 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug6 = p->down_threshold_hotplug6;
+	    hotplug_thresholds[0][5] = p->down_threshold_hotplug6;
+	}
 
-		// ZZ: set down_threshold_hotplug7 value
-		if ((zzmoove_profiles[i].down_threshold_hotplug7 <= 100
-		    && zzmoove_profiles[i].down_threshold_hotplug7 >= 1)
-		    || zzmoove_profiles[i].down_threshold_hotplug7 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug7 = zzmoove_profiles[i].down_threshold_hotplug7;
-		    hotplug_thresholds[0][6] = zzmoove_profiles[i].down_threshold_hotplug7;
-		}
+	// ZZ: set down_threshold_hotplug7 value
+	if ((p->down_threshold_hotplug7 <= 100
+	    && p->down_threshold_hotplug7 >= 1)
+	    || p->down_threshold_hotplug7 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug7 = p->down_threshold_hotplug7;
+	    hotplug_thresholds[0][6] = p->down_threshold_hotplug7;
+	}
 #endif
-		// ZZ: set down_threshold_hotplug_freq1 value
-		if (zzmoove_profiles[i].down_threshold_hotplug_freq1 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug_freq1 = zzmoove_profiles[i].down_threshold_hotplug_freq1;
-		    hotplug_thresholds_freq[1][0] = zzmoove_profiles[i].down_threshold_hotplug_freq1;
-		}
+	// ZZ: set down_threshold_hotplug_freq1 value
+	if (p->down_threshold_hotplug_freq1 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug_freq1 = p->down_threshold_hotplug_freq1;
+	    hotplug_thresholds_freq[1][0] = p->down_threshold_hotplug_freq1;
+	}
 
-		if (table && zzmoove_profiles[i].down_threshold_hotplug_freq1 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].down_threshold_hotplug_freq1) {
-			    dbs_tuners_ins.down_threshold_hotplug_freq1 = zzmoove_profiles[i].down_threshold_hotplug_freq1;
-			    hotplug_thresholds_freq[1][0] = zzmoove_profiles[i].down_threshold_hotplug_freq1;
-			}
-		    }
+	if (table && p->down_threshold_hotplug_freq1 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->down_threshold_hotplug_freq1) {
+		    dbs_tuners_ins.down_threshold_hotplug_freq1 = p->down_threshold_hotplug_freq1;
+		    hotplug_thresholds_freq[1][0] = p->down_threshold_hotplug_freq1;
 		}
+	    }
+	}
 #if (MAX_CORES == 4 || MAX_CORES == 8)
-		// ZZ: set down_threshold_hotplug_freq2 value
-		if (zzmoove_profiles[i].down_threshold_hotplug_freq2 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug_freq2 = zzmoove_profiles[i].down_threshold_hotplug_freq2;
-		    hotplug_thresholds_freq[1][1] = zzmoove_profiles[i].down_threshold_hotplug_freq2;
-		}
+	// ZZ: set down_threshold_hotplug_freq2 value
+	if (p->down_threshold_hotplug_freq2 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug_freq2 = p->down_threshold_hotplug_freq2;
+	    hotplug_thresholds_freq[1][1] = p->down_threshold_hotplug_freq2;
+	}
 
-		if (table && zzmoove_profiles[i].down_threshold_hotplug_freq2 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].down_threshold_hotplug_freq2) {
-			    dbs_tuners_ins.down_threshold_hotplug_freq2 = zzmoove_profiles[i].down_threshold_hotplug_freq2;
-			    hotplug_thresholds_freq[1][1] = zzmoove_profiles[i].down_threshold_hotplug_freq2;
-			}
-		    }
+	if (table && p->down_threshold_hotplug_freq2 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->down_threshold_hotplug_freq2) {
+		    dbs_tuners_ins.down_threshold_hotplug_freq2 = p->down_threshold_hotplug_freq2;
+		    hotplug_thresholds_freq[1][1] = p->down_threshold_hotplug_freq2;
 		}
+	    }
+	}
 
-		// ZZ: set down_threshold_hotplug_freq3 value
-		if (zzmoove_profiles[i].down_threshold_hotplug_freq3 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug_freq3 = zzmoove_profiles[i].down_threshold_hotplug_freq3;
-		    hotplug_thresholds_freq[1][2] = zzmoove_profiles[i].down_threshold_hotplug_freq3;
-		}
+	// ZZ: set down_threshold_hotplug_freq3 value
+	if (p->down_threshold_hotplug_freq3 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug_freq3 = p->down_threshold_hotplug_freq3;
+	    hotplug_thresholds_freq[1][2] = p->down_threshold_hotplug_freq3;
+	}
 
-		if (table && zzmoove_profiles[i].down_threshold_hotplug_freq3 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].down_threshold_hotplug_freq3) {
-			    dbs_tuners_ins.down_threshold_hotplug_freq3 = zzmoove_profiles[i].down_threshold_hotplug_freq3;
-			    hotplug_thresholds_freq[1][2] = zzmoove_profiles[i].down_threshold_hotplug_freq3;
-			}
-		    }
+	if (table && p->down_threshold_hotplug_freq3 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->down_threshold_hotplug_freq3) {
+		    dbs_tuners_ins.down_threshold_hotplug_freq3 = p->down_threshold_hotplug_freq3;
+		    hotplug_thresholds_freq[1][2] = p->down_threshold_hotplug_freq3;
 		}
+	    }
+	}
 #endif
 #if (MAX_CORES == 8)
-		// ZZ: set down_threshold_hotplug_freq4 value
-		if (zzmoove_profiles[i].down_threshold_hotplug_freq4 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug_freq4 = zzmoove_profiles[i].down_threshold_hotplug_freq4;
-		    hotplug_thresholds_freq[1][3] = zzmoove_profiles[i].down_threshold_hotplug_freq4;
-		}
+	// ZZ: set down_threshold_hotplug_freq4 value
+	if (p->down_threshold_hotplug_freq4 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug_freq4 = p->down_threshold_hotplug_freq4;
+	    hotplug_thresholds_freq[1][3] = p->down_threshold_hotplug_freq4;
+	}
 
-		if (table && zzmoove_profiles[i].down_threshold_hotplug_freq4 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].down_threshold_hotplug_freq4) {
-			    dbs_tuners_ins.down_threshold_hotplug_freq4 = zzmoove_profiles[i].down_threshold_hotplug_freq4;
-			    hotplug_thresholds_freq[1][3] = zzmoove_profiles[i].down_threshold_hotplug_freq4;
-			}
-		    }
+	if (table && p->down_threshold_hotplug_freq4 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->down_threshold_hotplug_freq4) {
+		    dbs_tuners_ins.down_threshold_hotplug_freq4 = p->down_threshold_hotplug_freq4;
+		    hotplug_thresholds_freq[1][3] = p->down_threshold_hotplug_freq4;
 		}
+	    }
+	}
 
-		// ZZ: set down_threshold_hotplug_freq5 value
-		if (zzmoove_profiles[i].down_threshold_hotplug_freq5 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug_freq5 = zzmoove_profiles[i].down_threshold_hotplug_freq5;
-		    hotplug_thresholds_freq[1][4] = zzmoove_profiles[i].down_threshold_hotplug_freq5;
-		}
+	// ZZ: set down_threshold_hotplug_freq5 value
+	if (p->down_threshold_hotplug_freq5 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug_freq5 = p->down_threshold_hotplug_freq5;
+	    hotplug_thresholds_freq[1][4] = p->down_threshold_hotplug_freq5;
+	}
 
-		if (table && zzmoove_profiles[i].down_threshold_hotplug_freq5 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].down_threshold_hotplug_freq5) {
-			    dbs_tuners_ins.down_threshold_hotplug_freq5 = zzmoove_profiles[i].down_threshold_hotplug_freq5;
-			    hotplug_thresholds_freq[1][4] = zzmoove_profiles[i].down_threshold_hotplug_freq5;
-			}
-		    }
+	if (table && p->down_threshold_hotplug_freq5 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->down_threshold_hotplug_freq5) {
+		    dbs_tuners_ins.down_threshold_hotplug_freq5 = p->down_threshold_hotplug_freq5;
+		    hotplug_thresholds_freq[1][4] = p->down_threshold_hotplug_freq5;
 		}
+	    }
+	}
 
-		// ZZ: set down_threshold_hotplug_freq6 value
-		if (zzmoove_profiles[i].down_threshold_hotplug_freq6 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug_freq6 = zzmoove_profiles[i].down_threshold_hotplug_freq6;
-		    hotplug_thresholds_freq[1][5] = zzmoove_profiles[i].down_threshold_hotplug_freq6;
-		}
+	// ZZ: set down_threshold_hotplug_freq6 value
+	if (p->down_threshold_hotplug_freq6 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug_freq6 = p->down_threshold_hotplug_freq6;
+	    hotplug_thresholds_freq[1][5] = p->down_threshold_hotplug_freq6;
+	}
 
-		if (table && zzmoove_profiles[i].down_threshold_hotplug_freq6 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].down_threshold_hotplug_freq6) {
-			    dbs_tuners_ins.down_threshold_hotplug_freq6 = zzmoove_profiles[i].down_threshold_hotplug_freq6;
-			    hotplug_thresholds_freq[1][5] = zzmoove_profiles[i].down_threshold_hotplug_freq6;
-			}
-		    }
+	if (table && p->down_threshold_hotplug_freq6 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->down_threshold_hotplug_freq6) {
+		    dbs_tuners_ins.down_threshold_hotplug_freq6 = p->down_threshold_hotplug_freq6;
+		    hotplug_thresholds_freq[1][5] = p->down_threshold_hotplug_freq6;
 		}
+	    }
+	}
 
-		// ZZ: set down_threshold_hotplug_freq7 value
-		if (zzmoove_profiles[i].down_threshold_hotplug_freq7 == 0) {
-		    dbs_tuners_ins.down_threshold_hotplug_freq7 = zzmoove_profiles[i].down_threshold_hotplug_freq7;
-		    hotplug_thresholds_freq[1][6] = zzmoove_profiles[i].down_threshold_hotplug_freq7;
-		}
+	// ZZ: set down_threshold_hotplug_freq7 value
+	if (p->down_threshold_hotplug_freq7 == 0) {
+	    dbs_tuners_ins.down_threshold_hotplug_freq7 = p->down_threshold_hotplug_freq7;
+	    hotplug_thresholds_freq[1][6] = p->down_threshold_hotplug_freq7;
+	}
 
-		if (table && zzmoove_profiles[i].down_threshold_hotplug_freq7 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].down_threshold_hotplug_freq7) {
-			    dbs_tuners_ins.down_threshold_hotplug_freq7 = zzmoove_profiles[i].down_threshold_hotplug_freq7;
-			    hotplug_thresholds_freq[1][6] = zzmoove_profiles[i].down_threshold_hotplug_freq7;
-			}
-		    }
+	if (table && p->down_threshold_hotplug_freq7 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->down_threshold_hotplug_freq7) {
+		    dbs_tuners_ins.down_threshold_hotplug_freq7 = p->down_threshold_hotplug_freq7;
+		    hotplug_thresholds_freq[1][6] = p->down_threshold_hotplug_freq7;
 		}
+	    }
+	}
 #endif
-		// ZZ: set down_threshold_sleep value
-		if (zzmoove_profiles[i].down_threshold_sleep > 11 && zzmoove_profiles[i].down_threshold_sleep <= 100
-		    && zzmoove_profiles[i].down_threshold_sleep < dbs_tuners_ins.up_threshold_sleep)
-		    dbs_tuners_ins.down_threshold_sleep = zzmoove_profiles[i].down_threshold_sleep;
+	// ZZ: set down_threshold_sleep value
+	if (p->down_threshold_sleep > 11 && p->down_threshold_sleep <= 100
+	    && p->down_threshold_sleep < dbs_tuners_ins.up_threshold_sleep)
+	    dbs_tuners_ins.down_threshold_sleep = p->down_threshold_sleep;
 
-		// ZZ: set early_demand value
-		dbs_tuners_ins.early_demand = !!zzmoove_profiles[i].early_demand;
-		dbs_tuners_ins.early_demand_sleep = !!zzmoove_profiles[i].early_demand_sleep;
+	// ZZ: set early_demand value
+	dbs_tuners_ins.early_demand = !!p->early_demand;
+	dbs_tuners_ins.early_demand_sleep = !!p->early_demand_sleep;
 
-		// ZZ: set fast_scaling value
-		if (zzmoove_profiles[i].fast_scaling <= 13 && zzmoove_profiles[i].fast_scaling >= 0)
-		    dbs_tuners_ins.fast_scaling = zzmoove_profiles[i].fast_scaling;
+	// ZZ: set fast_scaling value
+	if (p->fast_scaling <= 13 && p->fast_scaling >= 0)
+	    dbs_tuners_ins.fast_scaling = p->fast_scaling;
 
-		if (zzmoove_profiles[i].fast_scaling > 12) {
-		    scaling_mode_up   = 0;
-		    scaling_mode_down = 0;
+	if (p->fast_scaling > 12) {
+	    scaling_mode_up   = 0;
+	    scaling_mode_down = 0;
 
-		} else if (zzmoove_profiles[i].fast_scaling > 8) {
-		    scaling_mode_up   = 0;
-		    scaling_mode_down = zzmoove_profiles[i].fast_scaling - 8;
+	} else if (p->fast_scaling > 8) {
+	    scaling_mode_up   = 0;
+	    scaling_mode_down = p->fast_scaling - 8;
 
-		} else if (zzmoove_profiles[i].fast_scaling > 4) {
-		    scaling_mode_up   = zzmoove_profiles[i].fast_scaling - 4;
-		    scaling_mode_down = zzmoove_profiles[i].fast_scaling - 4;
+	} else if (p->fast_scaling > 4) {
+	    scaling_mode_up   = p->fast_scaling - 4;
+	    scaling_mode_down = p->fast_scaling - 4;
 
-		} else {
-		    scaling_mode_up   = zzmoove_profiles[i].fast_scaling;
-		    scaling_mode_down = 0;
-		}
+	} else {
+	    scaling_mode_up   = p->fast_scaling;
+	    scaling_mode_down = 0;
+	}
+
+	// ZZ: set fast_scaling_sleep value
+	if (p->fast_scaling_sleep <= 8 && p->fast_scaling_sleep >= 0)
+	    dbs_tuners_ins.fast_scaling_sleep = p->fast_scaling_sleep;
 
-		// ZZ: set fast_scaling_sleep value
-		if (zzmoove_profiles[i].fast_scaling_sleep <= 8 && zzmoove_profiles[i].fast_scaling_sleep >= 0)
-		    dbs_tuners_ins.fast_scaling_sleep = zzmoove_profiles[i].fast_scaling_sleep;
+	// ZZ: set freq_limit value
+	if (table && p->freq_limit == 0) {
+	    max_scaling_freq_soft = max_scaling_freq_hard;
+
+	    if (freq_table_order == 1)
+		limit_table_start = max_scaling_freq_soft;
+	    else
+		limit_table_end = table[freq_table_size].frequency;
 
-		// ZZ: set freq_limit value
-		if (table && zzmoove_profiles[i].freq_limit == 0) {
-		    max_scaling_freq_soft = max_scaling_freq_hard;
+	    freq_limit_awake = dbs_tuners_ins.freq_limit = p->freq_limit;
 
+	} else if (table && p->freq_limit <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->freq_limit) {
+		    max_scaling_freq_soft = t;
 		    if (freq_table_order == 1)
 			limit_table_start = max_scaling_freq_soft;
 		    else
-			limit_table_end = table[freq_table_size].frequency;
-
-		    freq_limit_awake = dbs_tuners_ins.freq_limit = zzmoove_profiles[i].freq_limit;
-
-		} else if (table && zzmoove_profiles[i].freq_limit <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].freq_limit) {
-			    max_scaling_freq_soft = t;
-			    if (freq_table_order == 1)
-				limit_table_start = max_scaling_freq_soft;
-			    else
-				limit_table_end = table[t].frequency;
-			}
-		    }
-		    freq_limit_awake = dbs_tuners_ins.freq_limit = zzmoove_profiles[i].freq_limit;
+			limit_table_end = table[t].frequency;
 		}
+	    }
+	    freq_limit_awake = dbs_tuners_ins.freq_limit = p->freq_limit;
+	}
 
-		// ZZ: set freq_limit_sleep value
-		if (table && zzmoove_profiles[i].freq_limit_sleep == 0) {
-		    freq_limit_asleep = dbs_tuners_ins.freq_limit_sleep = zzmoove_profiles[i].freq_limit_sleep;
+	// ZZ: set freq_limit_sleep value
+	if (table && p->freq_limit_sleep == 0) {
+	    freq_limit_asleep = dbs_tuners_ins.freq_limit_sleep = p->freq_limit_sleep;
 
-		} else if (table && zzmoove_profiles[i].freq_limit_sleep <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].freq_limit_sleep)
-			    freq_limit_asleep = dbs_tuners_ins.freq_limit_sleep = zzmoove_profiles[i].freq_limit_sleep;
-		    }
-		}
+	} else if (table && p->freq_limit_sleep <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->freq_limit_sleep)
+		    freq_limit_asleep = dbs_tuners_ins.freq_limit_sleep = p->freq_limit_sleep;
+	    }
+	}
 
-		// ZZ: set freq_step value
-		if (zzmoove_profiles[i].freq_step > 100)
-		    dbs_tuners_ins.freq_step = 100;
-		else
-		    dbs_tuners_ins.freq_step = zzmoove_profiles[i].freq_step;
+	// ZZ: set freq_step value
+	if (p->freq_step > 100)
+	    dbs_tuners_ins.freq_step = 100;
+	else
+	    dbs_tuners_ins.freq_step = p->freq_step;
 
-		// ZZ: set freq_step_sleep value
-		if (zzmoove_profiles[i].freq_step_sleep > 100)
-		    dbs_tuners_ins.freq_step_sleep = 100;
-		else
-		    dbs_tuners_ins.freq_step_sleep = zzmoove_profiles[i].freq_step_sleep;
+	// ZZ: set freq_step_sleep value
+	if (p->freq_step_sleep > 100)
+	    dbs_tuners_ins.freq_step_sleep = 100;
+	else
+	    dbs_tuners_ins.freq_step_sleep = p->freq_step_sleep;
 
-		// ZZ: set grad_up_threshold value
-		if (zzmoove_profiles[i].grad_up_threshold < 100 && zzmoove_profiles[i].grad_up_threshold > 1)
-		    dbs_tuners_ins.grad_up_threshold = zzmoove_profiles[i].grad_up_threshold;
+	// ZZ: set grad_up_threshold value
+	if (p->grad_up_threshold < 100 && p->grad_up_threshold > 1)
+	    dbs_tuners_ins.grad_up_threshold = p->grad_up_threshold;
 
-		// ZZ: set grad_up_threshold value
-		if (zzmoove_profiles[i].grad_up_threshold_sleep < 100 && zzmoove_profiles[i].grad_up_threshold_sleep > 1)
-		    dbs_tuners_ins.grad_up_threshold_sleep = zzmoove_profiles[i].grad_up_threshold_sleep;
+	// ZZ: set grad_up_threshold value
+	if (p->grad_up_threshold_sleep < 100 && p->grad_up_threshold_sleep > 1)
+	    dbs_tuners_ins.grad_up_threshold_sleep = p->grad_up_threshold_sleep;
 
-		// ZZ: set hotplug_block_up_cycles value
-		if (zzmoove_profiles[i].hotplug_block_up_cycles >= 0)
-		    dbs_tuners_ins.hotplug_block_up_cycles = zzmoove_profiles[i].hotplug_block_up_cycles;
+	// ZZ: set hotplug_block_up_cycles value
+	if (p->hotplug_block_up_cycles >= 0)
+	    dbs_tuners_ins.hotplug_block_up_cycles = p->hotplug_block_up_cycles;
 
-		// ZZ: set hotplug_block_down_cycles value
-		if (zzmoove_profiles[i].hotplug_block_down_cycles >= 0)
-		    dbs_tuners_ins.hotplug_block_down_cycles = zzmoove_profiles[i].hotplug_block_down_cycles;
+	// ZZ: set hotplug_block_down_cycles value
+	if (p->hotplug_block_down_cycles >= 0)
+	    dbs_tuners_ins.hotplug_block_down_cycles = p->hotplug_block_down_cycles;
 
-		// ZZ: set hotplug_idle_threshold value
-		if (zzmoove_profiles[i].hotplug_idle_threshold >= 0 && zzmoove_profiles[i].hotplug_idle_threshold < 100)
-		    dbs_tuners_ins.hotplug_idle_threshold = zzmoove_profiles[i].hotplug_idle_threshold;
+	// ZZ: set hotplug_idle_threshold value
+	if (p->hotplug_idle_threshold >= 0 && p->hotplug_idle_threshold < 100)
+	    dbs_tuners_ins.hotplug_idle_threshold = p->hotplug_idle_threshold;
 
-		// ZZ: set hotplug_idle_freq value
-		if (zzmoove_profiles[i].hotplug_idle_freq == 0) {
-		    dbs_tuners_ins.hotplug_idle_freq = zzmoove_profiles[i].hotplug_idle_freq;
+	// ZZ: set hotplug_idle_freq value
+	if (p->hotplug_idle_freq == 0) {
+	    dbs_tuners_ins.hotplug_idle_freq = p->hotplug_idle_freq;
 
-		} else if (table && zzmoove_profiles[i].hotplug_idle_freq <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].hotplug_idle_freq) {
-			    dbs_tuners_ins.hotplug_idle_freq = zzmoove_profiles[i].hotplug_idle_freq;
-			}
-		    }
+	} else if (table && p->hotplug_idle_freq <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->hotplug_idle_freq) {
+		    dbs_tuners_ins.hotplug_idle_freq = p->hotplug_idle_freq;
 		}
+	    }
+	}
 
-		// ZZ: set ignore_nice_load value
-		if (zzmoove_profiles[i].ignore_nice_load > 1)
-		    zzmoove_profiles[i].ignore_nice_load = 1;
+	// ZZ: set ignore_nice_load value
+	if (p->ignore_nice_load > 1)
+	    p->ignore_nice_load = 1;
 
-		dbs_tuners_ins.ignore_nice = zzmoove_profiles[i].ignore_nice_load;
+	dbs_tuners_ins.ignore_nice = p->ignore_nice_load;
 
-		// we need to re-evaluate prev_cpu_idle
-		for_each_online_cpu(j) {
-		    struct cpu_dbs_info_s *dbs_info;
-		    dbs_info = &per_cpu(cs_cpu_dbs_info, j);
-		    dbs_info->prev_cpu_idle = get_cpu_idle_time(j,
-						&dbs_info->prev_cpu_wall);
-		if (dbs_tuners_ins.ignore_nice)
-		    dbs_info->prev_cpu_nice = kcpustat_cpu(j).cpustat[CPUTIME_NICE];
-		}
+	// we need to re-evaluate prev_cpu_idle
+	for_each_online_cpu(j) {
+	    struct cpu_dbs_info_s *dbs_info;
+	    dbs_info = &per_cpu(cs_cpu_dbs_info, j);
+	    dbs_info->prev_cpu_idle = get_cpu_idle_time(j,
+					&dbs_info->prev_cpu_wall);
+	if (dbs_tuners_ins.ignore_nice)
+	    dbs_info->prev_cpu_nice = kcpustat_cpu(j).cpustat[CPUTIME_NICE];
+	}
 #ifdef CONFIG_CPU_FREQ_LCD_FREQ_DFS
-		// ZZ: set lcdfreq_enable value
-		if (zzmoove_profiles[i].lcdfreq_enable > 0) {
-		    dbs_tuners_ins.lcdfreq_enable = true;
-		} else {
-		    dbs_tuners_ins.lcdfreq_enable = false;
-		    // Set screen to 60Hz when stopping to switch
-		    lcdfreq_lock_current = 0;
-		    _lcdfreq_lock(lcdfreq_lock_current);
-		}
+	// ZZ: set lcdfreq_enable value
+	if (p->lcdfreq_enable > 0) {
+	    dbs_tuners_ins.lcdfreq_enable = true;
+	} else {
+	    dbs_tuners_ins.lcdfreq_enable = false;
+	    // Set screen to 60Hz when stopping to switch
+	    lcdfreq_lock_current = 0;
+	    _lcdfreq_lock(lcdfreq_lock_current);
+	}
 
-		// ZZ: set lcdfreq_kick_in_cores value
-		if (zzmoove_profiles[i].lcdfreq_kick_in_cores <= possible_cpus
-		    || zzmoove_profiles[i].lcdfreq_kick_in_cores == 0)
-		    dbs_tuners_ins.lcdfreq_kick_in_cores = zzmoove_profiles[i].lcdfreq_kick_in_cores;
+	// ZZ: set lcdfreq_kick_in_cores value
+	if (p->lcdfreq_kick_in_cores <= possible_cpus
+	    || p->lcdfreq_kick_in_cores == 0)
+	    dbs_tuners_ins.lcdfreq_kick_in_cores = p->lcdfreq_kick_in_cores;
 
-		// ZZ: set lcdfreq_kick_in_down_delay value
-		if (zzmoove_profiles[i].lcdfreq_kick_in_down_delay >= 0) {
-		    dbs_tuners_ins.lcdfreq_kick_in_down_delay = zzmoove_profiles[i].lcdfreq_kick_in_down_delay;
-		    dbs_tuners_ins.lcdfreq_kick_in_down_left = dbs_tuners_ins.lcdfreq_kick_in_down_delay;
-		}
+	// ZZ: set lcdfreq_kick_in_down_delay value
+	if (p->lcdfreq_kick_in_down_delay >= 0) {
+	    dbs_tuners_ins.lcdfreq_kick_in_down_delay = p->lcdfreq_kick_in_down_delay;
+	    dbs_tuners_ins.lcdfreq_kick_in_down_left = dbs_tuners_ins.lcdfreq_kick_in_down_delay;
+	}
 
-		// ZZ: set lcdfreq_kick_in_freq value
-		if (table && zzmoove_profiles[i].lcdfreq_kick_in_freq <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].lcdfreq_kick_in_freq) {
-			    dbs_tuners_ins.lcdfreq_kick_in_freq = zzmoove_profiles[i].lcdfreq_kick_in_freq;
-			}
-		    }
+	// ZZ: set lcdfreq_kick_in_freq value
+	if (table && p->lcdfreq_kick_in_freq <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->lcdfreq_kick_in_freq) {
+		    dbs_tuners_ins.lcdfreq_kick_in_freq = p->lcdfreq_kick_in_freq;
 		}
+	    }
+	}
 
-		// ZZ: set lcdfreq_kick_in_up_delay value
-		if (zzmoove_profiles[i].lcdfreq_kick_in_up_delay >= 0) {
-		    dbs_tuners_ins.lcdfreq_kick_in_up_delay = zzmoove_profiles[i].lcdfreq_kick_in_up_delay;
-		    dbs_tuners_ins.lcdfreq_kick_in_up_left = dbs_tuners_ins.lcdfreq_kick_in_up_delay;
-		}
+	// ZZ: set lcdfreq_kick_in_up_delay value
+	if (p->lcdfreq_kick_in_up_delay >= 0) {
+	    dbs_tuners_ins.lcdfreq_kick_in_up_delay = p->lcdfreq_kick_in_up_delay;
+	    dbs_tuners_ins.lcdfreq_kick_in_up_left = dbs_tuners_ins.lcdfreq_kick_in_up_delay;
+	}
 #endif
-		// ZZ: set sampling_down_factor value
-		if (zzmoove_profiles[i].sampling_down_factor <= MAX_SAMPLING_DOWN_FACTOR
-		    && zzmoove_profiles[i].sampling_down_factor >= 1)
-		    dbs_tuners_ins.sampling_down_factor = zzmoove_profiles[i].sampling_down_factor;
-
-		    // ZZ: Reset down sampling multiplier in case it was active
-		    for_each_online_cpu(j) {
-			struct cpu_dbs_info_s *dbs_info;
-			dbs_info = &per_cpu(cs_cpu_dbs_info, j);
-			dbs_info->rate_mult = 1;
-		    }
+	// ZZ: set sampling_down_factor value
+	if (p->sampling_down_factor <= MAX_SAMPLING_DOWN_FACTOR
+	    && p->sampling_down_factor >= 1)
+	    dbs_tuners_ins.sampling_down_factor = p->sampling_down_factor;
 
-		// ZZ: set sampling_down_max_momentum value
-		if (zzmoove_profiles[i].sampling_down_max_momentum <= MAX_SAMPLING_DOWN_FACTOR - dbs_tuners_ins.sampling_down_factor
-		    && zzmoove_profiles[i].sampling_down_max_momentum >= 0) {
-		    dbs_tuners_ins.sampling_down_max_mom = zzmoove_profiles[i].sampling_down_max_momentum;
-		    orig_sampling_down_max_mom = dbs_tuners_ins.sampling_down_max_mom;
-		}
+	    // ZZ: Reset down sampling multiplier in case it was active
+	    for_each_online_cpu(j) {
+		struct cpu_dbs_info_s *dbs_info;
+		dbs_info = &per_cpu(cs_cpu_dbs_info, j);
+		dbs_info->rate_mult = 1;
+	    }
 
-		// ZZ: Reset sampling down factor to default if momentum was disabled
+	// ZZ: set sampling_down_max_momentum value
+	if (p->sampling_down_max_momentum <= MAX_SAMPLING_DOWN_FACTOR - dbs_tuners_ins.sampling_down_factor
+	    && p->sampling_down_max_momentum >= 0) {
+	    dbs_tuners_ins.sampling_down_max_mom = p->sampling_down_max_momentum;
+	    orig_sampling_down_max_mom = dbs_tuners_ins.sampling_down_max_mom;
+	}
+
+	// ZZ: Reset sampling down factor to default if momentum was disabled
+	if (dbs_tuners_ins.sampling_down_max_mom == 0)
+	    dbs_tuners_ins.sampling_down_factor = DEF_SAMPLING_DOWN_FACTOR;
+
+	    // ZZ: Reset momentum_adder and reset down sampling multiplier in case momentum was disabled
+	    for_each_online_cpu(j) {
+		struct cpu_dbs_info_s *dbs_info;
+		dbs_info = &per_cpu(cs_cpu_dbs_info, j);
+		dbs_info->momentum_adder = 0;
 		if (dbs_tuners_ins.sampling_down_max_mom == 0)
-		    dbs_tuners_ins.sampling_down_factor = DEF_SAMPLING_DOWN_FACTOR;
-
-		    // ZZ: Reset momentum_adder and reset down sampling multiplier in case momentum was disabled
-		    for_each_online_cpu(j) {
-			struct cpu_dbs_info_s *dbs_info;
-			dbs_info = &per_cpu(cs_cpu_dbs_info, j);
-			dbs_info->momentum_adder = 0;
-			if (dbs_tuners_ins.sampling_down_max_mom == 0)
-			dbs_info->rate_mult = 1;
-		    }
+		dbs_info->rate_mult = 1;
+	    }
 
-		// ZZ: set sampling_down_momentum_sensitivity value
-		if (zzmoove_profiles[i].sampling_down_momentum_sensitivity <= MAX_SAMPLING_DOWN_MOMENTUM_SENSITIVITY
-		    && zzmoove_profiles[i].sampling_down_momentum_sensitivity >= 1) {
-		    dbs_tuners_ins.sampling_down_mom_sens = zzmoove_profiles[i].sampling_down_momentum_sensitivity;
+	// ZZ: set sampling_down_momentum_sensitivity value
+	if (p->sampling_down_momentum_sensitivity <= MAX_SAMPLING_DOWN_MOMENTUM_SENSITIVITY
+	    && p->sampling_down_momentum_sensitivity >= 1) {
+	    dbs_tuners_ins.sampling_down_mom_sens = p->sampling_down_momentum_sensitivity;
 
-		    // ZZ: Reset momentum_adder
-		    for_each_online_cpu(j) {
-			struct cpu_dbs_info_s *dbs_info;
-			dbs_info = &per_cpu(cs_cpu_dbs_info, j);
-			dbs_info->momentum_adder = 0;
-		    }
+	    // ZZ: Reset momentum_adder
+	    for_each_online_cpu(j) {
+		struct cpu_dbs_info_s *dbs_info;
+		dbs_info = &per_cpu(cs_cpu_dbs_info, j);
+		dbs_info->momentum_adder = 0;
+	    }
 
-		// ZZ: set sampling_rate value
-		dbs_tuners_ins.sampling_rate = dbs_tuners_ins.sampling_rate_current
-		= max(zzmoove_profiles[i].sampling_rate, min_sampling_rate);
+	// ZZ: set sampling_rate value
+	dbs_tuners_ins.sampling_rate = dbs_tuners_ins.sampling_rate_current
+	= max(p->sampling_rate, min_sampling_rate);
 
-		// ZZ: set sampling_rate_idle value
-		if (zzmoove_profiles[i].sampling_rate_idle == 0) {
-		    dbs_tuners_ins.sampling_rate_current = dbs_tuners_ins.sampling_rate
-		    = dbs_tuners_ins.sampling_rate_idle;
-		} else {
-		    dbs_tuners_ins.sampling_rate_idle = max(zzmoove_profiles[i].sampling_rate_idle, min_sampling_rate);
-		}
+	// ZZ: set sampling_rate_idle value
+	if (p->sampling_rate_idle == 0) {
+	    dbs_tuners_ins.sampling_rate_current = dbs_tuners_ins.sampling_rate
+	    = dbs_tuners_ins.sampling_rate_idle;
+	} else {
+	    dbs_tuners_ins.sampling_rate_idle = max(p->sampling_rate_idle, min_sampling_rate);
+	}
 
-		// ZZ: set sampling_rate_idle_delay value
-		if (zzmoove_profiles[i].sampling_rate_idle_delay >= 0) {
-		    sampling_rate_step_up_delay = 0;
-		    sampling_rate_step_down_delay = 0;
-		    dbs_tuners_ins.sampling_rate_idle_delay = zzmoove_profiles[i].sampling_rate_idle_delay;
-		}
+	// ZZ: set sampling_rate_idle_delay value
+	if (p->sampling_rate_idle_delay >= 0) {
+	    sampling_rate_step_up_delay = 0;
+	    sampling_rate_step_down_delay = 0;
+	    dbs_tuners_ins.sampling_rate_idle_delay = p->sampling_rate_idle_delay;
+	}
 
-		// ZZ: set sampling_rate_idle_threshold value
-		if (zzmoove_profiles[i].sampling_rate_idle_threshold <= 100)
-		    dbs_tuners_ins.sampling_rate_idle_threshold = zzmoove_profiles[i].sampling_rate_idle_threshold;
+	// ZZ: set sampling_rate_idle_threshold value
+	if (p->sampling_rate_idle_threshold <= 100)
+	    dbs_tuners_ins.sampling_rate_idle_threshold = p->sampling_rate_idle_threshold;
 
-		// ZZ: set sampling_rate_sleep_multiplier value
-		if (zzmoove_profiles[i].sampling_rate_sleep_multiplier <= MAX_SAMPLING_RATE_SLEEP_MULTIPLIER
-		    && zzmoove_profiles[i].sampling_rate_sleep_multiplier >= 1)
-		    dbs_tuners_ins.sampling_rate_sleep_multiplier = zzmoove_profiles[i].sampling_rate_sleep_multiplier;
+	// ZZ: set sampling_rate_sleep_multiplier value
+	if (p->sampling_rate_sleep_multiplier <= MAX_SAMPLING_RATE_SLEEP_MULTIPLIER
+	    && p->sampling_rate_sleep_multiplier >= 1)
+	    dbs_tuners_ins.sampling_rate_sleep_multiplier = p->sampling_rate_sleep_multiplier;
 
-		// ZZ: set scaling_block_cycles value
-		if (zzmoove_profiles[i].scaling_block_cycles >= 0) {
-		    dbs_tuners_ins.scaling_block_cycles = zzmoove_profiles[i].scaling_block_cycles;
-		    if (zzmoove_profiles[i].scaling_block_cycles == 0)
-			scaling_block_cycles_count = 0;
-		}
+	// ZZ: set scaling_block_cycles value
+	if (p->scaling_block_cycles >= 0) {
+	    dbs_tuners_ins.scaling_block_cycles = p->scaling_block_cycles;
+	    if (p->scaling_block_cycles == 0)
+		scaling_block_cycles_count = 0;
+	}
 
-		// ZZ: set scaling_block_freq value
-		if (zzmoove_profiles[i].scaling_block_freq == 0) {
-		    dbs_tuners_ins.scaling_block_freq = zzmoove_profiles[i].scaling_block_freq;
+	// ZZ: set scaling_block_freq value
+	if (p->scaling_block_freq == 0) {
+	    dbs_tuners_ins.scaling_block_freq = p->scaling_block_freq;
 
-		} else if (table && zzmoove_profiles[i].scaling_block_freq <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].scaling_block_freq) {
-			    dbs_tuners_ins.scaling_block_freq = zzmoove_profiles[i].scaling_block_freq;
-			}
-		    }
+	} else if (table && p->scaling_block_freq <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->scaling_block_freq) {
+		    dbs_tuners_ins.scaling_block_freq = p->scaling_block_freq;
 		}
+	    }
+	}
 
-		// ZZ: set scaling_block_threshold value
-		if (zzmoove_profiles[i].scaling_block_threshold >= 0
-		    && zzmoove_profiles[i].scaling_block_threshold <= 100)
-		    dbs_tuners_ins.scaling_block_threshold = zzmoove_profiles[i].scaling_block_threshold;
-
-		// ZZ: set scaling_block_force_down value
-		if (zzmoove_profiles[i].scaling_block_force_down >= 0
-		    && zzmoove_profiles[i].scaling_block_force_down != 1)
-		    dbs_tuners_ins.scaling_block_cycles = zzmoove_profiles[i].scaling_block_cycles;
-
-		// ZZ: set smooth_up value
-		if (zzmoove_profiles[i].smooth_up <= 100 && zzmoove_profiles[i].smooth_up >= 1)
-		    dbs_tuners_ins.smooth_up = zzmoove_profiles[i].smooth_up;
-
-		// ZZ: set smooth_up_sleep value
-		if (zzmoove_profiles[i].smooth_up_sleep <= 100 && zzmoove_profiles[i].smooth_up_sleep >= 1)
-		    dbs_tuners_ins.smooth_up_sleep = zzmoove_profiles[i].smooth_up_sleep;
-
-		// ZZ: set up_threshold value
-		if (zzmoove_profiles[i].up_threshold <= 100 && zzmoove_profiles[i].up_threshold
-		    >= zzmoove_profiles[i].down_threshold)
-		    dbs_tuners_ins.up_threshold = zzmoove_profiles[i].up_threshold;
-
-		// ZZ: set up_threshold_hotplug1 value
-		if (zzmoove_profiles[i].up_threshold_hotplug1 >= 0 && zzmoove_profiles[i].up_threshold_hotplug1 <= 100) {
-		    dbs_tuners_ins.up_threshold_hotplug1 = zzmoove_profiles[i].up_threshold_hotplug1;
-		    hotplug_thresholds[0][0] = zzmoove_profiles[i].up_threshold_hotplug1;
-		}
+	// ZZ: set scaling_block_threshold value
+	if (p->scaling_block_threshold >= 0
+	    && p->scaling_block_threshold <= 100)
+	    dbs_tuners_ins.scaling_block_threshold = p->scaling_block_threshold;
+
+	// ZZ: set scaling_block_force_down value
+	if (p->scaling_block_force_down >= 0
+	    && p->scaling_block_force_down != 1)
+	    dbs_tuners_ins.scaling_block_cycles = p->scaling_block_cycles;
+
+	// ZZ: set smooth_up value
+	if (p->smooth_up <= 100 && p->smooth_up >= 1)
+	    dbs_tuners_ins.smooth_up = p->smooth_up;
+
+	// ZZ: set smooth_up_sleep value
+	if (p->smooth_up_sleep <= 100 && p->smooth_up_sleep >= 1)
+	    dbs_tuners_ins.smooth_up_sleep = p->smooth_up_sleep;
+
+	// ZZ: set up_threshold value
+	if (p->up_threshold <= 100 && p->up_threshold
+	    >= p->down_threshold)
+	    dbs_tuners_ins.up_threshold = p->up_threshold;
+
+	// ZZ: set up_threshold_hotplug1 value
+	if (p->up_threshold_hotplug1 >= 0 && p->up_threshold_hotplug1 <= 100) {
+	    dbs_tuners_ins.up_threshold_hotplug1 = p->up_threshold_hotplug1;
+	    hotplug_thresholds[0][0] = p->up_threshold_hotplug1;
+	}
 #if (MAX_CORES == 4 || MAX_CORES == 8)
-		// ZZ: set up_threshold_hotplug2 value
-		if (zzmoove_profiles[i].up_threshold_hotplug2 >= 0 && zzmoove_profiles[i].up_threshold_hotplug2 <= 100) {
-		    dbs_tuners_ins.up_threshold_hotplug2 = zzmoove_profiles[i].up_threshold_hotplug2;
-		    hotplug_thresholds[0][1] = zzmoove_profiles[i].up_threshold_hotplug2;
-		}
+	// ZZ: set up_threshold_hotplug2 value
+	if (p->up_threshold_hotplug2 >= 0 && p->up_threshold_hotplug2 <= 100) {
+	    dbs_tuners_ins.up_threshold_hotplug2 = p->up_threshold_hotplug2;
+	    hotplug_thresholds[0][1] = p->up_threshold_hotplug2;
+	}
 
-		// ZZ: set up_threshold_hotplug3 value
-		if (zzmoove_profiles[i].up_threshold_hotplug3 >= 0 && zzmoove_profiles[i].up_threshold_hotplug3 <= 100) {
-		    dbs_tuners_ins.up_threshold_hotplug3 = zzmoove_profiles[i].up_threshold_hotplug3;
-		    hotplug_thresholds[0][2] = zzmoove_profiles[i].up_threshold_hotplug3;
-		}
+	// ZZ: set up_threshold_hotplug3 value
+	if (p->up_threshold_hotplug3 >= 0 && p->up_threshold_hotplug3 <= 100) {
+	    dbs_tuners_ins.up_threshold_hotplug3 = p->up_threshold_hotplug3;
+	    hotplug_thresholds[0][2] = p->up_threshold_hotplug3;
+	}
 #endif
 #if (MAX_CORES == 8)
-		// ZZ: set up_threshold_hotplug4 value
-		if (zzmoove_profiles[i].up_threshold_hotplug4 >= 0 && zzmoove_profiles[i].up_threshold_hotplug4 <= 100) {
-		    dbs_tuners_ins.up_threshold_hotplug4 = zzmoove_profiles[i].up_threshold_hotplug4;
-		    hotplug_thresholds[0][3] = zzmoove_profiles[i].up_threshold_hotplug4;
-		}
+	// ZZ: set up_threshold_hotplug4 value
+	if (p->up_threshold_hotplug4 >= 0 && p->up_threshold_hotplug4 <= 100) {
+	    dbs_tuners_ins.up_threshold_hotplug4 = p->up_threshold_hotplug4;
+	    hotplug_thresholds[0][3] = p->up_threshold_hotplug4;
+	}
 
-		// ZZ: set up_threshold_hotplug5 value
-		if (zzmoove_profiles[i].up_threshold_hotplug5 >= 0 && zzmoove_profiles[i].up_threshold_hotplug5 <= 100) {
-		    dbs_tuners_ins.up_threshold_hotplug5 = zzmoove_profiles[i].up_threshold_hotplug5;
-		    hotplug_thresholds[0][4] = zzmoove_profiles[i].up_threshold_hotplug5;
-		}
+	// ZZ: set up_threshold_hotplug5 value
+	if (p->up_threshold_hotplug5 >= 0 && p->up_threshold_hotplug5 <= 100) {
+	    dbs_tuners_ins.up_threshold_hotplug5 = p->up_threshold_hotplug5;
+	    hotplug_thresholds[0][4] = p->up_threshold_hotplug5;
+	}
 
-		// ZZ: set up_threshold_hotplug6 value
-		if (zzmoove_profiles[i].up_threshold_hotplug6 >= 0 && zzmoove_profiles[i].up_threshold_hotplug6 <= 100) {
-		    dbs_tuners_ins.up_threshold_hotplug6 = zzmoove_profiles[i].up_threshold_hotplug6;
-		    hotplug_thresholds[0][5] = zzmoove_profiles[i].up_threshold_hotplug6;
-		}
+	// ZZ: set up_threshold_hotplug6 value
+	if (p->up_threshold_hotplug6 >= 0 && p->up_threshold_hotplug6 <= 100) {
+	    dbs_tuners_ins.up_threshold_hotplug6 = p->up_threshold_hotplug6;
+	    hotplug_thresholds[0][5] = p->up_threshold_hotplug6;
+	}
 
-		// ZZ: set up_threshold_hotplug7 value
-		if (zzmoove_profiles[i].up_threshold_hotplug7 >= 0 && zzmoove_profiles[i].up_threshold_hotplug7 <= 100) {
-		    dbs_tuners_ins.up_threshold_hotplug7 = zzmoove_profiles[i].up_threshold_hotplug7;
-		    hotplug_thresholds[0][6] = zzmoove_profiles[i].up_threshold_hotplug7;
-		}
+	// ZZ: set up_threshold_hotplug7 value
+	if (p->up_threshold_hotplug7 >= 0 && p->up_threshold_hotplug7 <= 100) {
+	    dbs_tuners_ins.up_threshold_hotplug7 = p->up_threshold_hotplug7;
+	    hotplug_thresholds[0][6] = p->up_threshold_hotplug7;
+	}
 #endif
-		// ZZ: set up_threshold_hotplug_freq1 value
-		if (zzmoove_profiles[i].up_threshold_hotplug_freq1 == 0) {
-		    dbs_tuners_ins.up_threshold_hotplug_freq1 = zzmoove_profiles[i].up_threshold_hotplug_freq1;
-		    hotplug_thresholds_freq[0][0] = zzmoove_profiles[i].up_threshold_hotplug_freq1;
-		}
+	// ZZ: set up_threshold_hotplug_freq1 value
+	if (p->up_threshold_hotplug_freq1 == 0) {
+	    dbs_tuners_ins.up_threshold_hotplug_freq1 = p->up_threshold_hotplug_freq1;
+	    hotplug_thresholds_freq[0][0] = p->up_threshold_hotplug_freq1;
+	}
 
-		if (table && zzmoove_profiles[i].up_threshold_hotplug_freq1 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-		        if (table[t].frequency == zzmoove_profiles[i].up_threshold_hotplug_freq1) {
-			    dbs_tuners_ins.up_threshold_hotplug_freq1 = zzmoove_profiles[i].up_threshold_hotplug_freq1;
-			    hotplug_thresholds_freq[0][0] = zzmoove_profiles[i].up_threshold_hotplug_freq1;
-		        }
-		    }
-		}
+	if (table && p->up_threshold_hotplug_freq1 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+	        if (table[t].frequency == p->up_threshold_hotplug_freq1) {
+		    dbs_tuners_ins.up_threshold_hotplug_freq1 = p->up_threshold_hotplug_freq1;
+		    hotplug_thresholds_freq[0][0] = p->up_threshold_hotplug_freq1;
+	        }
+	    }
+	}
 
 #if (MAX_CORES == 4 || MAX_CORES == 8)
-		// ZZ: set up_threshold_hotplug_freq2 value
-		if (zzmoove_profiles[i].up_threshold_hotplug_freq2 == 0) {
-		    dbs_tuners_ins.up_threshold_hotplug_freq2 = zzmoove_profiles[i].up_threshold_hotplug_freq2;
-		    hotplug_thresholds_freq[0][1] = zzmoove_profiles[i].up_threshold_hotplug_freq2;
-		}
+	// ZZ: set up_threshold_hotplug_freq2 value
+	if (p->up_threshold_hotplug_freq2 == 0) {
+	    dbs_tuners_ins.up_threshold_hotplug_freq2 = p->up_threshold_hotplug_freq2;
+	    hotplug_thresholds_freq[0][1] = p->up_threshold_hotplug_freq2;
+	}
 
-		if (table && zzmoove_profiles[i].up_threshold_hotplug_freq2 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].up_threshold_hotplug_freq2) {
-			    dbs_tuners_ins.up_threshold_hotplug_freq2 = zzmoove_profiles[i].up_threshold_hotplug_freq2;
-			    hotplug_thresholds_freq[0][1] = zzmoove_profiles[i].up_threshold_hotplug_freq2;
-			}
-		    }
+	if (table && p->up_threshold_hotplug_freq2 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->up_threshold_hotplug_freq2) {
+		    dbs_tuners_ins.up_threshold_hotplug_freq2 = p->up_threshold_hotplug_freq2;
+		    hotplug_thresholds_freq[0][1] = p->up_threshold_hotplug_freq2;
 		}
+	    }
+	}
 
-		// ZZ: set up_threshold_hotplug_freq3 value
-		if (zzmoove_profiles[i].up_threshold_hotplug_freq3 == 0) {
-		    dbs_tuners_ins.up_threshold_hotplug_freq3 = zzmoove_profiles[i].up_threshold_hotplug_freq3;
-		    hotplug_thresholds_freq[0][2] = zzmoove_profiles[i].up_threshold_hotplug_freq3;
-		}
+	// ZZ: set up_threshold_hotplug_freq3 value
+	if (p->up_threshold_hotplug_freq3 == 0) {
+	    dbs_tuners_ins.up_threshold_hotplug_freq3 = p->up_threshold_hotplug_freq3;
+	    hotplug_thresholds_freq[0][2] = p->up_threshold_hotplug_freq3;
+	}
 
-		if (table && zzmoove_profiles[i].up_threshold_hotplug_freq3 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].up_threshold_hotplug_freq3) {
-			    dbs_tuners_ins.up_threshold_hotplug_freq3 = zzmoove_profiles[i].up_threshold_hotplug_freq3;
-			    hotplug_thresholds_freq[0][2] = zzmoove_profiles[i].up_threshold_hotplug_freq3;
-			}
-		    }
+	if (table && p->up_threshold_hotplug_freq3 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->up_threshold_hotplug_freq3) {
+		    dbs_tuners_ins.up_threshold_hotplug_freq3 = p->up_threshold_hotplug_freq3;
+		    hotplug_thresholds_freq[0][2] = p->up_threshold_hotplug_freq3;
 		}
+	    }
+	}
 #endif
 #if (MAX_CORES == 8)
-		// ZZ: set up_threshold_hotplug_freq4 value
-		if (zzmoove_profiles[i].up_threshold_hotplug_freq4 == 0) {
-		    dbs_tuners_ins.up_threshold_hotplug_freq4 = zzmoove_profiles[i].up_threshold_hotplug_freq4;
-		    hotplug_thresholds_freq[0][3] = zzmoove_profiles[i].up_threshold_hotplug_freq4;
-		}
+	// ZZ: set up_threshold_hotplug_freq4 value
+	if (p->up_threshold_hotplug_freq4 == 0) {
+	    dbs_tuners_ins.up_threshold_hotplug_freq4 = p->up_threshold_hotplug_freq4;
+	    hotplug_thresholds_freq[0][3] = p->up_threshold_hotplug_freq4;
+	}
 
-		if (table && zzmoove_profiles[i].up_threshold_hotplug_freq4 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].up_threshold_hotplug_freq4) {
-			    dbs_tuners_ins.up_threshold_hotplug_freq4 = zzmoove_profiles[i].up_threshold_hotplug_freq4;
-			    hotplug_thresholds_freq[0][3] = zzmoove_profiles[i].up_threshold_hotplug_freq4;
-			}
-		    }
+	if (table && p->up_threshold_hotplug_freq4 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->up_threshold_hotplug_freq4) {
+		    dbs_tuners_ins.up_threshold_hotplug_freq4 = p->up_threshold_hotplug_freq4;
+		    hotplug_thresholds_freq[0][3] = p->up_threshold_hotplug_freq4;
 		}
+	    }
+	}
 
-		// ZZ: set up_threshold_hotplug_freq5 value
-		if (zzmoove_profiles[i].up_threshold_hotplug_freq5 == 0) {
-		    dbs_tuners_ins.up_threshold_hotplug_freq5 = zzmoove_profiles[i].up_threshold_hotplug_freq5;
-		    hotplug_thresholds_freq[0][4] = zzmoove_profiles[i].up_threshold_hotplug_freq5;
-		}
+	// ZZ: set up_threshold_hotplug_freq5 value
+	if (p->up_threshold_hotplug_freq5 == 0) {
+	    dbs_tuners_ins.up_threshold_hotplug_freq5 = p->up_threshold_hotplug_freq5;
+	    hotplug_thresholds_freq[0][4] = p->up_threshold_hotplug_freq5;
+	}
 
-		if (table && zzmoove_profiles[i].up_threshold_hotplug_freq5 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].up_threshold_hotplug_freq5) {
-			    dbs_tuners_ins.up_threshold_hotplug_freq5 = zzmoove_profiles[i].up_threshold_hotplug_freq5;
-			    hotplug_thresholds_freq[0][4] = zzmoove_profiles[i].up_threshold_hotplug_freq5;
-			}
-		    }
+	if (table && p->up_threshold_hotplug_freq5 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->up_threshold_hotplug_freq5) {
+		    dbs_tuners_ins.up_threshold_hotplug_freq5 = p->up_threshold_hotplug_freq5;
+		    hotplug_thresholds_freq[0][4] = p->up_threshold_hotplug_freq5;
 		}
+	    }
+	}
 
-		// ZZ: set up_threshold_hotplug_freq6 value
-		if (zzmoove_profiles[i].up_threshold_hotplug_freq6 == 0) {
-		    dbs_tuners_ins.up_threshold_hotplug_freq6 = zzmoove_profiles[i].up_threshold_hotplug_freq6;
-		    hotplug_thresholds_freq[0][5] = zzmoove_profiles[i].up_threshold_hotplug_freq6;
-		}
+	// ZZ: set up_threshold_hotplug_freq6 value
+	if (p->up_threshold_hotplug_freq6 == 0) {
+	    dbs_tuners_ins.up_threshold_hotplug_freq6 = p->up_threshold_hotplug_freq6;
+	    hotplug_thresholds_freq[0][5] = p->up_threshold_hotplug_freq6;
+	}
 
-		if (table && zzmoove_profiles[i].up_threshold_hotplug_freq6 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].up_threshold_hotplug_freq6) {
-			    dbs_tuners_ins.up_threshold_hotplug_freq6 = zzmoove_profiles[i].up_threshold_hotplug_freq6;
-			    hotplug_thresholds_freq[0][5] = zzmoove_profiles[i].up_threshold_hotplug_freq6;
-			}
-		    }
+	if (table && p->up_threshold_hotplug_freq6 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->up_threshold_hotplug_freq6) {
+		    dbs_tuners_ins.up_threshold_hotplug_freq6 = p->up_threshold_hotplug_freq6;
+		    hotplug_thresholds_freq[0][5] = p->up_threshold_hotplug_freq6;
 		}
+	    }
+	}
 
-		// ZZ: set up_threshold_hotplug_freq7 value
-		if (zzmoove_profiles[i].up_threshold_hotplug_freq7 == 0) {
-		    dbs_tuners_ins.up_threshold_hotplug_freq7 = zzmoove_profiles[i].up_threshold_hotplug_freq7;
-		    hotplug_thresholds_freq[0][6] = zzmoove_profiles[i].up_threshold_hotplug_freq7;
-		}
+	// ZZ: set up_threshold_hotplug_freq7 value
+	if (p->up_threshold_hotplug_freq7 == 0) {
+	    dbs_tuners_ins.up_threshold_hotplug_freq7 = p->up_threshold_hotplug_freq7;
+	    hotplug_thresholds_freq[0][6] = p->up_threshold_hotplug_freq7;
+	}
 
-		if (table && zzmoove_profiles[i].up_threshold_hotplug_freq7 <= table[max_scaling_freq_hard].frequency) {
-		    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
-			if (table[t].frequency == zzmoove_profiles[i].up_threshold_hotplug_freq7) {
-			    dbs_tuners_ins.up_threshold_hotplug_freq7 = zzmoove_profiles[i].up_threshold_hotplug_freq7;
-			    hotplug_thresholds_freq[0][6] = zzmoove_profiles[i].up_threshold_hotplug_freq7;
-			}
-		    }
+	if (table && p->up_threshold_hotplug_freq7 <= table[max_scaling_freq_hard].frequency) {
+	    for (t = 0; (table[t].frequency != CPUFREQ_TABLE_END); t++) {
+		if (table[t].frequency == p->up_threshold_hotplug_freq7) {
+		    dbs_tuners_ins.up_threshold_hotplug_freq7 = p->up_threshold_hotplug_freq7;
+		    hotplug_thresholds_freq[0][6] = p->up_threshold_hotplug_freq7;
 		}
+	    }
+	}
 #endif
-		// ZZ: set up_threshold_sleep value
-		if (zzmoove_profiles[i].up_threshold_sleep <= 100 && zzmoove_profiles[i].up_threshold_sleep
-		    > dbs_tuners_ins.down_threshold_sleep)
-		    dbs_tuners_ins.up_threshold_sleep = zzmoove_profiles[i].up_threshold_sleep;
+	// ZZ: set up_threshold_sleep value
+	if (p->up_threshold_sleep <= 100 && p->up_threshold_sleep
+	    > dbs_tuners_ins.down_threshold_sleep)
+	    dbs_tuners_ins.up_threshold_sleep = p->up_threshold_sleep;
 #ifdef ENABLE_LEGACY_MODE
-		// ZZ: set legacy_mode value
-		if (zzmoove_profiles[i].legacy_mode > 0)
-		    dbs_tuners_ins.legacy_mode = true;
-		else
-		    dbs_tuners_ins.legacy_mode = false;
+	// ZZ: set legacy_mode value
+	if (p->legacy_mode > 0)
+	    dbs_tuners_ins.legacy_mode = true;
+	else
+	    dbs_tuners_ins.legacy_mode = false;
 #endif
-		dbs_tuners_ins.profile_number = input;
+	dbs_tuners_ins.profile_number = p->profile_number;
 
-		// ZZ: set profile to custom mode
-		strncpy(dbs_tuners_ins.profile, zzmoove_profiles[i].profile_name, sizeof(dbs_tuners_ins.profile));
-		return count;
-	     }
-	   }
+	// ZZ: set profile to custom mode
+	strncpy(dbs_tuners_ins.profile, p->profile_name, sizeof(dbs_tuners_ins.profile));
+	return 0;
+	}
+return -EINVAL;
+}
+
+static ssize_t store_profile_number(struct kobject *a, struct attribute *b,
+					const char *buf, size_t count)
+{
+	unsigned int input;				// ZZ: regular input handling of this tuneable
+	int ret;					// ZZ: regular input handling of this tuneable
+	int i = 0;					// ZZ: for main profile loop
+
+	ret = sscanf(buf, "%u", &input);		// ZZ: regular input handling of this tuneable
+
+	if (ret != 1)
+	    return -EINVAL;
+
+	// ZZ: if input is 0 set profile to custom mode
+	if (input == 0) {
+	    dbs_tuners_ins.profile_number = input;
+	    strncpy(dbs_tuners_ins.profile, custom_profile, sizeof(dbs_tuners_ins.profile));
+	return count;
+	}
+
+	for (i = 0; (unlikely(zzmoove_profiles[i].profile_number != PROFILE_TABLE_END)); i++) {
+	    if (unlikely(zzmoove_profiles[i].profile_number == input)) {
+		down_write(&profile_blob_sem);
+		ret = apply_profile(&zzmoove_profiles[i]);
+		up_write(&profile_blob_sem);
+		return ret ? -EINVAL : count;
+	    }
 	}
 return -EINVAL;
 }
 
+/*
+ * ZZ: a whole profile written in one go to 'profile_blob' as a binary struct zzmoove_profile
+ * is staged here and applied by the next sample, with all samples held off while it is applied
+ * so that none of them runs with tuneables of both the old and the new profile
+ */
+static DEFINE_SPINLOCK(profile_blob_lock);
+static struct zzmoove_profile profile_blob_staged;
+static bool profile_blob_pending;
+
+static ssize_t store_profile_blob(struct kobject *a, struct attribute *b,
+					const char *buf, size_t count)
+{
+	const struct zzmoove_profile *p = (const struct zzmoove_profile *)buf;
+
+	if (count != sizeof(struct zzmoove_profile))
+	    return -EINVAL;
+
+	// ZZ: the name is shown in 'profile' and has to be terminated
+	if (strnlen(p->profile_name, sizeof(p->profile_name)) == sizeof(p->profile_name))
+	    return -EINVAL;
+
+	// ZZ: apply_profile() stops half way through on this one, refuse it upfront
+	if (p->sampling_down_momentum_sensitivity > MAX_SAMPLING_DOWN_MOMENTUM_SENSITIVITY
+	    || p->sampling_down_momentum_sensitivity < 1)
+	    return -EINVAL;
+
+	spin_lock(&profile_blob_lock);
+	memcpy(&profile_blob_staged, p, sizeof(profile_blob_staged));
+
+	// ZZ: a loaded profile is not one of the build-in ones
+	profile_blob_staged.profile_number = 0;
+	if (!profile_blob_staged.profile_name[0])
+	    strncpy(profile_blob_staged.profile_name, custom_profile, sizeof(profile_blob_staged.profile_name));
+	profile_blob_pending = true;
+	spin_unlock(&profile_blob_lock);
+
+	return count;
+}
+
+static struct global_attr profile_blob = __ATTR(profile_blob, 0200, NULL, store_profile_blob);
+
+// ZZ: called by the sample which picks up a staged profile, before it evaluates the load
+static void apply_profile_blob(void)
+{
+	struct zzmoove_profile p;
+	bool pending;
+
+	spin_lock(&profile_blob_lock);
+	pending = profile_blob_pending;
+	if (pending)
+	    memcpy(&p, &profile_blob_staged, sizeof(p));
+	profile_blob_pending = false;
+	spin_unlock(&profile_blob_lock);
+
+	if (!pending)
+	    return;
+
+	down_write(&profile_blob_sem);
+	apply_profile(&p);
+	up_write(&profile_blob_sem);
+}
+
 // Yank: add hotplug up/down threshold sysfs store interface
 #define store_up_threshold_hotplug_freq(name,core)						\
 static ssize_t store_up_threshold_hotplug_freq##name						\
@@ -3634,6 +3725,7 @@ static struct attribute *dbs_attributes[] = {
 	&dev_attr_version_profiles.attr,
 	&profile.attr,
 	&profile_number.attr,
+	&profile_blob.attr,
 #ifdef ZZMOOVE_DEBUG
 	&dev_attr_debug.attr,
 #endif
@@ -4273,39 +4365,39 @@ static void __cpuinit hotplug_offline_work_fn(struct work_struct *work)
 		if (cur_load < hotplug_thresholds[1][2] && cpu_online(3)
 		    && (hotplug_thresholds_freq[1][2] == 0 || cur_freq <= hotplug_thresholds_freq[1][2]
 		    || max_freq_too_low))
-		    cpu_down(3);
+		    zz_cpu_down(3);
 		if (cur_load < hotplug_thresholds[1][1] && cpu_online(2)
 		    && (hotplug_thresholds_freq[1][1] == 0 || cur_freq <= hotplug_thresholds_freq[1][1]
 		    || max_freq_too_low))
-		    cpu_down(2);
+		    zz_cpu_down(2);
 		if (cur_load < hotplug_thresholds[1][0] && cpu_online(1)
 		    && (hotplug_thresholds_freq[1][0] == 0 || cur_freq <= hotplug_thresholds_freq[1][0]
 		    || max_freq_too_low))
-		    cpu_down(1);
+		    zz_cpu_down(1);
 	    } else if (num_online_cpus() > 2) {
 		if (cur_load < hotplug_thresholds[1][1] && cpu_online(2)
 		    && (hotplug_thresholds_freq[1][1] == 0 || cur_freq <= hotplug_thresholds_freq[1][1]
 		    || max_freq_too_low))
-		    cpu_down(2);
+		    zz_cpu_down(2);
 		if (cur_load < hotplug_thresholds[1][0] && cpu_online(1)
 		    && (hotplug_thresholds_freq[1][0] == 0 || cur_freq <= hotplug_thresholds_freq[1][0]
 		    || max_freq_too_low))
-		    cpu_down(1);
+		    zz_cpu_down(1);
 	    } else if (num_online_cpus() > 1 && cpu_online(2)) {
 		if (cur_load < hotplug_thresholds[1][1]
 		    && (hotplug_thresholds_freq[1][1] == 0 || cur_freq <= hotplug_thresholds_freq[1][1]
 		    || max_freq_too_low))
-		    cpu_down(2);
+		    zz_cpu_down(2);
 	    } else if (num_online_cpus() > 1 && cpu_online(3)) {
 		if (cur_load < hotplug_thresholds[1][2]
 		    && (hotplug_thresholds_freq[1][2] == 0 || cur_freq <= hotplug_thresholds_freq[1][2]
 		    || max_freq_too_low))
-		cpu_down(3);
+		zz_cpu_down(3);
 	    } else if (num_online_cpus() > 1) {
 		if (cur_load < hotplug_thresholds[1][0] && cpu_online(1)
 		    && (hotplug_thresholds_freq[1][0] == 0 || cur_freq <= hotplug_thresholds_freq[1][0]
 		    || max_freq_too_low))
-		    cpu_down(1);
+		    zz_cpu_down(1);
 	    }
 
 	} else {
@@ -4317,7 +4409,7 @@ static void __cpuinit hotplug_offline_work_fn(struct work_struct *work)
 		&& (hotplug_thresholds_freq[1][cpu-1] == 0
 		|| cur_freq <= hotplug_thresholds_freq[1][cpu-1]
 		|| max_freq_too_low))
-		cpu_down(cpu);
+		zz_cpu_down(cpu);
 	    }
 #ifdef ENABLE_LEGACY_MODE
 	}
@@ -4350,47 +4442,47 @@ static void __cpuinit hotplug_online_work_fn(struct work_struct *work)
 		    if (hotplug_thresholds[0][0] != 0 && cur_load >= hotplug_thresholds[0][0] && !cpu_online(1)
 			&& (hotplug_thresholds_freq[0][0] == 0 || cur_freq >= hotplug_thresholds_freq[0][0]
 			|| max_freq_too_low))
-			cpu_up(1);
+			zz_cpu_up(1);
 		    if (hotplug_thresholds[0][1] != 0 && cur_load >= hotplug_thresholds[0][1] && !cpu_online(2)
 			&& (hotplug_thresholds_freq[0][1] == 0 || cur_freq >= hotplug_thresholds_freq[0][1]
 			|| max_freq_too_low))
-			cpu_up(2);
+			zz_cpu_up(2);
 		    if (hotplug_thresholds[0][2] != 0 && cur_load >= hotplug_thresholds[0][2] && !cpu_online(3)
 			&& (hotplug_thresholds_freq[0][2] == 0 || cur_freq >= hotplug_thresholds_freq[0][2]
 			|| max_freq_too_low))
-			cpu_up(3);
+			zz_cpu_up(3);
 		} else if (num_online_cpus() < 3 && cpu_online(3)) {
 		    if (hotplug_thresholds[0][0] != 0 && cur_load >= hotplug_thresholds[0][0] && !cpu_online(1)
 			&& (hotplug_thresholds_freq[0][0] == 0 || cur_freq >= hotplug_thresholds_freq[0][0]
 			|| max_freq_too_low))
-			cpu_up(1);
+			zz_cpu_up(1);
 		    if (hotplug_thresholds[0][1] != 0 && cur_load >= hotplug_thresholds[0][1] && !cpu_online(2)
 			&& (hotplug_thresholds_freq[0][1] == 0 || cur_freq >= hotplug_thresholds_freq[0][1]
 			|| max_freq_too_low))
-			cpu_up(2);
+			zz_cpu_up(2);
 		} else if (num_online_cpus() < 3 && cpu_online(2)) {
 		    if (hotplug_thresholds[0][0] != 0 && cur_load >= hotplug_thresholds[0][0] && !cpu_online(1)
 			&& (hotplug_thresholds_freq[0][0] == 0 || cur_freq >= hotplug_thresholds_freq[0][0]
 			|| max_freq_too_low))
-			cpu_up(1);
+			zz_cpu_up(1);
 		    if (hotplug_thresholds[0][2] != 0 && cur_load >= hotplug_thresholds[0][2] && !cpu_online(3)
 			&& (hotplug_thresholds_freq[0][2] == 0 || cur_freq >= hotplug_thresholds_freq[0][2]
 			|| max_freq_too_low))
-			cpu_up(3);
+			zz_cpu_up(3);
 		} else if (num_online_cpus() < 3) {
 		    if (hotplug_thresholds[0][1] != 0 && cur_load >= hotplug_thresholds[0][1] && !cpu_online(2)
 			&& (hotplug_thresholds_freq[0][1] == 0 || cur_freq >= hotplug_thresholds_freq[0][1]
 			|| max_freq_too_low))
-			cpu_up(2);
+			zz_cpu_up(2);
 		    if (hotplug_thresholds[0][2] != 0 && cur_load >= hotplug_thresholds[0][2] && !cpu_online(3)
 			&& (hotplug_thresholds_freq[0][2] == 0 || cur_freq >= hotplug_thresholds_freq[0][2]
 			|| max_freq_too_low))
-			cpu_up(3);
+			zz_cpu_up(3);
 		} else if (num_online_cpus() < 4) {
 		    if (hotplug_thresholds[0][2] != 0 && cur_load >= hotplug_thresholds[0][2] && !cpu_online(3)
 			&& (hotplug_thresholds_freq[0][2] == 0 || cur_freq >= hotplug_thresholds_freq[0][2]
 			|| max_freq_too_low))
-			cpu_up(3);
+			zz_cpu_up(3);
 		}
 
 	} else {
@@ -4400,7 +4492,7 @@ static void __cpuinit hotplug_online_work_fn(struct work_struct *work)
 		if (!cpu_online(i) && hotplug_thresholds[0][i-1] != 0 && cur_load >= hotplug_thresholds[0][i-1]
 		    && (hotplug_thresholds_freq[0][i-1] == 0 || cur_freq >= hotplug_thresholds_freq[0][i-1]
 		    || boost_hotplug || max_freq_too_low))
-		    cpu_up(i);
+		    zz_cpu_up(i);
 	    }
 #ifdef ENABLE_LEGACY_MODE
 	}
@@ -4413,15 +4505,22 @@ static void do_dbs_timer(struct work_struct *work)
 	struct cpu_dbs_info_s *dbs_info =
 		container_of(work, struct cpu_dbs_info_s, work.work);
 	unsigned int cpu = dbs_info->cpu;
+	int delay;
+
+	mutex_lock(&dbs_info->timer_mutex);
+
+	// ZZ: a staged profile takes effect between two samples
+	if (unlikely(ACCESS_ONCE(profile_blob_pending)))
+	    apply_profile_blob();
 
 	// We want all CPUs to do sampling nearly on same jiffy
-	int delay = usecs_to_jiffies(dbs_tuners_ins.sampling_rate_current * dbs_info->rate_mult); // ZZ: Sampling down momentum - added multiplier
+	delay = usecs_to_jiffies(dbs_tuners_ins.sampling_rate_current * dbs_info->rate_mult); // ZZ: Sampling down momentum - added multiplier
 
 	delay -= jiffies % delay;
 
-	mutex_lock(&dbs_info->timer_mutex);
-
+	down_read(&profile_blob_sem);
 	dbs_check_cpu(dbs_info);
+	up_read(&profile_blob_sem);
 
 	queue_delayed_work_on(cpu, dbs_wq, &dbs_info->work, delay);
 	mutex_unlock(&dbs_info->timer_mutex);
@@ -4779,6 +4878,9 @@ static int cpufreq_governor_dbs(struct cpufreq_policy *policy,
 			cpufreq_register_notifier(
 					&dbs_cpufreq_notifier_block,
 					CPUFREQ_TRANSITION_NOTIFIER);
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+			hotplug_mgr_add_request(&zz_hotplug_req, "zzmoove", 0, 0);
+#endif
 		}
 
 		mutex_unlock(&dbs_mutex);
@@ -4789,10 +4891,13 @@ static int cpufreq_governor_dbs(struct cpufreq_policy *policy,
 	case CPUFREQ_GOV_STOP:
 		/*
 		 * ZZ: enable all cores to avoid cores staying in offline state
-		 * when changing to a non-hotplugging-able governor
+		 * when changing to a non-hotplugging-able governor, the hotplug
+		 * manager does that by itself once our request is gone
 		 */
+#ifndef CONFIG_CPU_HOTPLUG_MGR
 		enable_cores = true;
 		queue_work_on(0, dbs_wq, &hotplug_online_work);
+#endif
 
 		dbs_timer_exit(this_dbs_info);
 
@@ -4815,6 +4920,14 @@ static int cpufreq_governor_dbs(struct cpufreq_policy *policy,
 		    sysfs_remove_group(cpufreq_global_kobject,
 		   &dbs_attr_group);
 
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+		if (!dbs_enable) {
+		    cancel_work_sync(&hotplug_offline_work);
+		    cancel_work_sync(&hotplug_online_work);
+		    hotplug_mgr_remove_request(&zz_hotplug_req);
+		}
+#endif
+
 		unregister_early_suspend(&_powersave_early_suspend);
 
 #ifdef CONFIG_CPU_FREQ_LCD_FREQ_DFS
@@ -0,0 +1,559 @@
+/*
+ * drivers/cpufreq/hotplug_mgr.c
+ *
+ * Single arbitration point for CPU hotplug.
+ *
+ * Governors, use-case governors, thermal and userspace each hold a
+ * struct hotplug_request with a demand (min_cpus) and a limit (max_cpus)
+ * on the number of online CPUs. The highest demand wins, clamped by the
+ * lowest limit. The result is applied from a freezable workqueue with:
+ *
+ *  - up_delay_ms / down_delay_ms: how long the target must stay above /
+ *    below the online count before CPUs are plugged / unplugged,
+ *  - min_offline_ms / min_online_ms: how long the configuration must
+ *    have been stable before CPUs are plugged / unplugged again.
+ *
+ * Going below a limit is never delayed. With no demand at all every
+ * present CPU is brought online. Userspace votes through the
+ * user_min_cpus and user_max_cpus module parameters rather than through
+ * the sysfs online files, which the manager will not respect.
+ *
+ * With CONFIG_SCHED_CPU_PARK and the park parameter set, CPUs are parked
+ * rather than unplugged: they stay online, out of scheduling, in the
+ * deepest idle state. The counts above are then counts of active CPUs.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ */
+
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/cpu.h>
+#include <linux/sched.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/hotplug_mgr.h>
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/hotplug_mgr.h>
+
+static unsigned int up_delay_ms;
+module_param(up_delay_ms, uint, 0644);
+MODULE_PARM_DESC(up_delay_ms, "Time the demand must stay above the online count");
+
+static unsigned int down_delay_ms = 500;
+module_param(down_delay_ms, uint, 0644);
+MODULE_PARM_DESC(down_delay_ms, "Time the demand must stay below the online count");
+
+static unsigned int min_offline_ms = 200;
+module_param(min_offline_ms, uint, 0644);
+MODULE_PARM_DESC(min_offline_ms, "Minimum residency before plugging a CPU");
+
+static unsigned int min_online_ms = 1000;
+module_param(min_online_ms, uint, 0644);
+MODULE_PARM_DESC(min_online_ms, "Minimum residency before unplugging a CPU");
+
+#ifdef CONFIG_SCHED_CPU_PARK
+static bool park = true;
+module_param(park, bool, 0644);
+MODULE_PARM_DESC(park, "Park CPUs instead of unplugging them");
+#else
+#define park	false
+#endif
+
+/* Protects the request list and the votes */
+static DEFINE_SPINLOCK(hotplug_mgr_lock);
+static LIST_HEAD(hotplug_mgr_requests);
+
+/* Serializes decisions */
+static DEFINE_MUTEX(hotplug_mgr_mutex);
+static u64 up_since;
+static u64 down_since;
+
+static struct workqueue_struct *hotplug_mgr_wq;
+static void hotplug_mgr_evaluate(struct work_struct *work);
+static DECLARE_WORK(hotplug_mgr_kick_work, hotplug_mgr_evaluate);
+static DECLARE_DELAYED_WORK(hotplug_mgr_retry_work, hotplug_mgr_evaluate);
+
+/* Residency statistics, updated from the CPU notifier */
+static DEFINE_SPINLOCK(hotplug_mgr_stats_lock);
+static unsigned int config_cur;
+static u64 config_timestamp;
+static u64 config_time[NR_CPUS + 1];
+static unsigned int config_entries[NR_CPUS + 1];
+static unsigned int nr_deferred;
+
+enum {
+	HOTPLUG_MGR_UP,
+	HOTPLUG_MGR_DOWN,
+	HOTPLUG_MGR_UNPARK,
+	HOTPLUG_MGR_PARK,
+	HOTPLUG_MGR_NR_OPS,
+};
+
+static const char * const hotplug_mgr_op_names[HOTPLUG_MGR_NR_OPS] = {
+	"up", "down", "unpark", "park",
+};
+
+/* Latency of the successful operations, only touched under the mutex */
+static struct {
+	unsigned int count;
+	u64 total;
+	u64 max;
+} op_stats[HOTPLUG_MGR_NR_OPS];
+
+static struct hotplug_request user_req = {
+	.node = LIST_HEAD_INIT(user_req.node),
+	.name = "user",
+};
+
+static inline u64 hotplug_mgr_now(void)
+{
+	return ktime_to_ns(ktime_get());
+}
+
+/* Online CPUs that are not parked */
+static inline unsigned int hotplug_mgr_running(void)
+{
+	return num_active_cpus();
+}
+
+static void hotplug_mgr_kick(void)
+{
+	if (hotplug_mgr_wq)
+		queue_work(hotplug_mgr_wq, &hotplug_mgr_kick_work);
+}
+
+/* The caller shall hold hotplug_mgr_lock */
+static bool __hotplug_mgr_set(struct hotplug_request *req,
+			unsigned int min_cpus, unsigned int max_cpus)
+{
+	if (req->min_cpus == min_cpus && req->max_cpus == max_cpus)
+		return false;
+
+	req->min_cpus = min_cpus;
+	req->max_cpus = max_cpus;
+	trace_hotplug_mgr_request(req->name, min_cpus, max_cpus);
+	return true;
+}
+
+int hotplug_mgr_add_request(struct hotplug_request *req, const char *name,
+			    unsigned int min_cpus, unsigned int max_cpus)
+{
+	unsigned long flags;
+
+	req->name = name;
+	req->min_cpus = 0;
+	req->max_cpus = 0;
+
+	spin_lock_irqsave(&hotplug_mgr_lock, flags);
+	list_add_tail(&req->node, &hotplug_mgr_requests);
+	__hotplug_mgr_set(req, min_cpus, max_cpus);
+	spin_unlock_irqrestore(&hotplug_mgr_lock, flags);
+
+	hotplug_mgr_kick();
+	return 0;
+}
+EXPORT_SYMBOL_GPL(hotplug_mgr_add_request);
+
+void hotplug_mgr_update_request(struct hotplug_request *req,
+				unsigned int min_cpus, unsigned int max_cpus)
+{
+	unsigned long flags;
+	bool changed;
+
+	spin_lock_irqsave(&hotplug_mgr_lock, flags);
+	changed = __hotplug_mgr_set(req, min_cpus, max_cpus);
+	spin_unlock_irqrestore(&hotplug_mgr_lock, flags);
+
+	if (changed)
+		hotplug_mgr_kick();
+}
+EXPORT_SYMBOL_GPL(hotplug_mgr_update_request);
+
+void hotplug_mgr_remove_request(struct hotplug_request *req)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&hotplug_mgr_lock, flags);
+	list_del_init(&req->node);
+	__hotplug_mgr_set(req, 0, 0);
+	spin_unlock_irqrestore(&hotplug_mgr_lock, flags);
+
+	hotplug_mgr_kick();
+}
+EXPORT_SYMBOL_GPL(hotplug_mgr_remove_request);
+
+/*
+ * Translate a per CPU decision of a governor into a demand. CPUs are
+ * plugged in ascending and unplugged in descending order, so wanting
+ * @cpu online means wanting @cpu + 1 CPUs and wanting it offline means
+ * wanting at most @cpu.
+ */
+void hotplug_mgr_vote_cpu(struct hotplug_request *req, unsigned int cpu,
+			  bool online)
+{
+	unsigned long flags;
+	unsigned int min_cpus;
+	bool changed;
+
+	if (!cpu)
+		return;
+
+	spin_lock_irqsave(&hotplug_mgr_lock, flags);
+	min_cpus = req->min_cpus;
+	if (online)
+		min_cpus = max(min_cpus, cpu + 1);
+	else if (!min_cpus || min_cpus > cpu)
+		min_cpus = cpu;
+	changed = __hotplug_mgr_set(req, min_cpus, req->max_cpus);
+	spin_unlock_irqrestore(&hotplug_mgr_lock, flags);
+
+	if (changed)
+		hotplug_mgr_kick();
+}
+EXPORT_SYMBOL_GPL(hotplug_mgr_vote_cpu);
+
+static void hotplug_mgr_aggregate(unsigned int *demand, unsigned int *limit)
+{
+	struct hotplug_request *req;
+	unsigned long flags;
+
+	*demand = 0;
+	*limit = num_present_cpus();
+
+	spin_lock_irqsave(&hotplug_mgr_lock, flags);
+	list_for_each_entry(req, &hotplug_mgr_requests, node) {
+		if (req->min_cpus > *demand)
+			*demand = req->min_cpus;
+		if (req->max_cpus && req->max_cpus < *limit)
+			*limit = req->max_cpus;
+	}
+	spin_unlock_irqrestore(&hotplug_mgr_lock, flags);
+}
+
+static u64 hotplug_mgr_last_change(void)
+{
+	unsigned long flags;
+	u64 last;
+
+	spin_lock_irqsave(&hotplug_mgr_stats_lock, flags);
+	last = config_timestamp;
+	spin_unlock_irqrestore(&hotplug_mgr_stats_lock, flags);
+
+	return last;
+}
+
+/* Time left until both @since + @delay_ms and @last + @residency_ms */
+static u64 hotplug_mgr_wait(u64 now, u64 since, unsigned int delay_ms,
+			    u64 last, unsigned int residency_ms)
+{
+	u64 until = since + (u64)delay_ms * NSEC_PER_MSEC;
+	u64 stable = last + (u64)residency_ms * NSEC_PER_MSEC;
+
+	if (stable > until)
+		until = stable;
+
+	return until > now ? until - now : 0;
+}
+
+static void hotplug_mgr_account(void);
+
+static void hotplug_mgr_op_done(int op, u64 start)
+{
+	u64 t = hotplug_mgr_now() - start;
+
+	op_stats[op].count++;
+	op_stats[op].total += t;
+	if (t > op_stats[op].max)
+		op_stats[op].max = t;
+}
+
+/* The notifier does not see parking, account for it here */
+static int hotplug_mgr_park(unsigned int cpu, bool parked)
+{
+	u64 start = hotplug_mgr_now();
+	int ret;
+
+	ret = parked ? sched_cpu_park(cpu) : sched_cpu_unpark(cpu);
+	if (!ret) {
+		hotplug_mgr_op_done(parked ? HOTPLUG_MGR_PARK :
+				    HOTPLUG_MGR_UNPARK, start);
+		hotplug_mgr_account();
+	}
+
+	return ret;
+}
+
+static void hotplug_mgr_plug(unsigned int target)
+{
+	unsigned int cpu;
+	u64 start;
+
+	/* Parked CPUs come back first, they are the cheap ones */
+	for_each_online_cpu(cpu) {
+		if (hotplug_mgr_running() >= target)
+			return;
+		if (cpu_parked(cpu))
+			hotplug_mgr_park(cpu, false);
+	}
+
+	for_each_present_cpu(cpu) {
+		if (hotplug_mgr_running() >= target)
+			break;
+		if (cpu_online(cpu))
+			continue;
+		start = hotplug_mgr_now();
+		if (!cpu_up(cpu))
+			hotplug_mgr_op_done(HOTPLUG_MGR_UP, start);
+	}
+}
+
+static void hotplug_mgr_unplug(unsigned int target)
+{
+	int cpu;
+	u64 start;
+
+	for (cpu = nr_cpu_ids - 1; cpu > 0; cpu--) {
+		if (hotplug_mgr_running() <= target)
+			break;
+		if (!cpu_active(cpu))
+			continue;
+		if (park) {
+			hotplug_mgr_park(cpu, true);
+			continue;
+		}
+		start = hotplug_mgr_now();
+		if (!cpu_down(cpu))
+			hotplug_mgr_op_done(HOTPLUG_MGR_DOWN, start);
+	}
+}
+
+static void hotplug_mgr_evaluate(struct work_struct *work)
+{
+	unsigned int demand, limit, target, online;
+	const char *action = "hold";
+	u64 now, wait = 0;
+
+	mutex_lock(&hotplug_mgr_mutex);
+
+	hotplug_mgr_aggregate(&demand, &limit);
+	online = hotplug_mgr_running();
+
+	/* Without any demand all CPUs go online, as without hotplug */
+	target = demand ? demand : num_present_cpus();
+	target = clamp(target, 1U, max(limit, 1U));
+	now = hotplug_mgr_now();
+
+	if (target > online) {
+		down_since = 0;
+		if (!up_since)
+			up_since = now;
+		wait = hotplug_mgr_wait(now, up_since, up_delay_ms,
+				hotplug_mgr_last_change(), min_offline_ms);
+		if (!wait) {
+			action = "up";
+			up_since = 0;
+			hotplug_mgr_plug(target);
+		}
+	} else if (target < online) {
+		up_since = 0;
+		if (online > limit) {
+			/* Limits are applied at once, the rest waits as usual */
+			trace_hotplug_mgr_decision(online, target, demand,
+						   limit, "limit");
+			hotplug_mgr_unplug(limit);
+			online = hotplug_mgr_running();
+		}
+		if (target < online) {
+			if (!down_since)
+				down_since = now;
+			wait = hotplug_mgr_wait(now, down_since, down_delay_ms,
+				hotplug_mgr_last_change(), min_online_ms);
+			if (!wait) {
+				action = "down";
+				down_since = 0;
+				hotplug_mgr_unplug(target);
+			}
+		} else {
+			action = "limit";
+			down_since = 0;
+		}
+	} else {
+		up_since = 0;
+		down_since = 0;
+	}
+
+	if (wait) {
+		action = target > online ? "defer up" : "defer down";
+		nr_deferred++;
+		queue_delayed_work(hotplug_mgr_wq, &hotplug_mgr_retry_work,
+			msecs_to_jiffies(div_u64(wait, NSEC_PER_MSEC)) + 1);
+	}
+
+	trace_hotplug_mgr_decision(online, target, demand, limit, action);
+
+	mutex_unlock(&hotplug_mgr_mutex);
+}
+
+static void hotplug_mgr_account(void)
+{
+	unsigned long flags;
+	u64 now = hotplug_mgr_now();
+
+	spin_lock_irqsave(&hotplug_mgr_stats_lock, flags);
+	config_time[config_cur] += now - config_timestamp;
+	config_timestamp = now;
+	config_cur = hotplug_mgr_running();
+	config_entries[config_cur]++;
+	spin_unlock_irqrestore(&hotplug_mgr_stats_lock, flags);
+}
+
+static int __cpuinit hotplug_mgr_cpu_callback(struct notifier_block *nfb,
+					unsigned long action, void *hcpu)
+{
+	switch (action & ~CPU_TASKS_FROZEN) {
+	case CPU_ONLINE:
+	case CPU_DEAD:
+		hotplug_mgr_account();
+		break;
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block __refdata hotplug_mgr_cpu_notifier = {
+	.notifier_call = hotplug_mgr_cpu_callback,
+};
+
+static unsigned int user_min_cpus;
+static unsigned int user_max_cpus;
+
+static int user_vote_set(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_uint(val, kp);
+
+	if (ret)
+		return ret;
+
+	hotplug_mgr_update_request(&user_req, user_min_cpus, user_max_cpus);
+	return 0;
+}
+
+static struct kernel_param_ops user_vote_ops = {
+	.set = user_vote_set,
+	.get = param_get_uint,
+};
+
+module_param_cb(user_min_cpus, &user_vote_ops, &user_min_cpus, 0644);
+MODULE_PARM_DESC(user_min_cpus, "Userspace demand on online CPUs, 0 for none");
+module_param_cb(user_max_cpus, &user_vote_ops, &user_max_cpus, 0644);
+MODULE_PARM_DESC(user_max_cpus, "Userspace limit on online CPUs, 0 for none");
+
+#ifdef CONFIG_DEBUG_FS
+static int hotplug_mgr_summary_show(struct seq_file *s, void *data)
+{
+	struct hotplug_request *req;
+	unsigned int demand, limit;
+	unsigned long flags;
+	unsigned int i;
+	u64 now = hotplug_mgr_now();
+
+	seq_printf(s, "%-8s %12s %8s\n", "online", "time_ms", "entries");
+
+	spin_lock_irqsave(&hotplug_mgr_stats_lock, flags);
+	for (i = 1; i <= num_possible_cpus(); i++) {
+		u64 t = config_time[i];
+
+		if (i == config_cur)
+			t += now - config_timestamp;
+		seq_printf(s, "%-8u %12llu %8u\n", i,
+			   (unsigned long long)div_u64(t, NSEC_PER_MSEC),
+			   config_entries[i]);
+	}
+	spin_unlock_irqrestore(&hotplug_mgr_stats_lock, flags);
+
+	hotplug_mgr_aggregate(&demand, &limit);
+	seq_printf(s, "\nonline %u running %u demand %u limit %u\n",
+		   num_online_cpus(), hotplug_mgr_running(), demand, limit);
+	seq_printf(s, "deferred %u\n", nr_deferred);
+
+	seq_printf(s, "\n%-8s %8s %10s %10s\n", "op", "count", "avg_us",
+		   "max_us");
+	mutex_lock(&hotplug_mgr_mutex);
+	for (i = 0; i < HOTPLUG_MGR_NR_OPS; i++) {
+		u64 avg = op_stats[i].count ?
+			div_u64(op_stats[i].total, op_stats[i].count) : 0;
+
+		seq_printf(s, "%-8s %8u %10llu %10llu\n",
+			   hotplug_mgr_op_names[i], op_stats[i].count,
+			   (unsigned long long)div_u64(avg, NSEC_PER_USEC),
+			   (unsigned long long)div_u64(op_stats[i].max,
+						       NSEC_PER_USEC));
+	}
+	mutex_unlock(&hotplug_mgr_mutex);
+
+	seq_printf(s, "\n%-16s %8s %8s\n", "request", "min", "max");
+	spin_lock_irqsave(&hotplug_mgr_lock, flags);
+	list_for_each_entry(req, &hotplug_mgr_requests, node)
+		seq_printf(s, "%-16s %8u %8u\n", req->name,
+			   req->min_cpus, req->max_cpus);
+	spin_unlock_irqrestore(&hotplug_mgr_lock, flags);
+
+	return 0;
+}
+
+static int hotplug_mgr_summary_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, hotplug_mgr_summary_show, inode->i_private);
+}
+
+static const struct file_operations hotplug_mgr_summary_fops = {
+	.open		= hotplug_mgr_summary_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init hotplug_mgr_debugfs_init(void)
+{
+	debugfs_create_file("hotplug_mgr", S_IRUGO, NULL, NULL,
+			    &hotplug_mgr_summary_fops);
+	return 0;
+}
+late_initcall(hotplug_mgr_debugfs_init);
+#endif
+
+/*
+ * Early enough for governors and drivers registering from fs_initcall or
+ * device_initcall, requests made before this are only kicked here.
+ */
+static int __init hotplug_mgr_init(void)
+{
+	unsigned long flags;
+
+	hotplug_mgr_wq = alloc_ordered_workqueue("hotplug_mgr", WQ_FREEZABLE);
+	if (!hotplug_mgr_wq)
+		return -ENOMEM;
+
+	config_timestamp = hotplug_mgr_now();
+	config_cur = hotplug_mgr_running();
+	config_entries[config_cur]++;
+	register_hotcpu_notifier(&hotplug_mgr_cpu_notifier);
+
+	spin_lock_irqsave(&hotplug_mgr_lock, flags);
+	list_add_tail(&user_req.node, &hotplug_mgr_requests);
+	spin_unlock_irqrestore(&hotplug_mgr_lock, flags);
+
+	hotplug_mgr_kick();
+	return 0;
+}
+core_initcall(hotplug_mgr_init);
+
+MODULE_DESCRIPTION("CPU hotplug request arbitration");
+MODULE_LICENSE("GPL");
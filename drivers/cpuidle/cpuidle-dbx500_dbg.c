@@ -24,6 +24,7 @@
 
 #include <mach/pm.h>
 #include <mach/pm-timer.h>
+#include <mach/cpuidle.h>
 #include <mach/gpio.h>
 
 #include <asm/hardware/gic.h>
@@ -1133,6 +1134,35 @@ static int ap_family_show(struct seq_file *s, void *iter)
 	return 0;
 }
 
+/*
+ * Idle states chosen by the ux500 governor that turned out too deep
+ * (woken up before the break-even time) or too shallow (slept long
+ * enough for the next state while the prediction said otherwise).
+ */
+static int mispredict_show(struct seq_file *s, void *iter)
+{
+	struct cpuidle_driver *drv = cpuidle_get_driver();
+	unsigned int too_deep, too_shallow;
+	int cpu, i;
+
+	if (!drv)
+		return 0;
+
+	seq_printf(s, "%-4s %-10s %12s %12s\n", "cpu", "state",
+		   "too_deep", "too_shallow");
+
+	for_each_possible_cpu(cpu) {
+		for (i = 0; i < drv->state_count; i++) {
+			ux500_cpuidle_gov_mispredicts(cpu, i, &too_deep,
+						      &too_shallow);
+			seq_printf(s, "%-4d %-10s %12u %12u\n", cpu,
+				   drv->states[i].name, too_deep, too_shallow);
+		}
+	}
+
+	return 0;
+}
+
 static int deepest_state_open_file(struct inode *inode, struct file *file)
 {
 	return single_open(file, deepest_state_print, inode->i_private);
@@ -1154,6 +1184,12 @@ static int ap_family_open(struct inode *inode,
 	return single_open(file, ap_family_show, inode->i_private);
 }
 
+static int mispredict_open(struct inode *inode,
+			   struct file *file)
+{
+	return single_open(file, mispredict_show, inode->i_private);
+}
+
 static int wake_latency_open(struct inode *inode,
 			  struct file *file)
 {
@@ -1204,6 +1240,14 @@ static const struct file_operations wake_latency_fops = {
 	.owner = THIS_MODULE,
 };
 
+static const struct file_operations mispredict_fops = {
+	.open = mispredict_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+	.owner = THIS_MODULE,
+};
+
 static struct dentry *cpuidle_dir;
 
 static void __init setup_debugfs(void)
@@ -1267,6 +1311,11 @@ static void __init setup_debugfs(void)
 					       &ap_family_fops)))
 		goto fail;
 
+	if (IS_ERR_OR_NULL(debugfs_create_file("mispredict", S_IRUGO,
+					       cpuidle_dir, NULL,
+					       &mispredict_fops)))
+		goto fail;
+
 	return;
 fail:
 	debugfs_remove_recursive(cpuidle_dir);
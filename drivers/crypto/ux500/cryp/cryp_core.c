@@ -22,6 +22,7 @@
 #include <linux/platform_device.h>
 #include <linux/regulator/dbx500-prcmu.h>
 #include <linux/semaphore.h>
+#include <linux/workqueue.h>
 
 #include <crypto/aes.h>
 #include <crypto/algapi.h>
@@ -46,15 +47,46 @@ static atomic_t session_id;
 static struct stedma40_chan_cfg *mem_to_engine;
 static struct stedma40_chan_cfg *engine_to_mem;
 
+/*
+ * AES requests shorter than this are fed to the FIFOs by the CPU also in DMA
+ * mode, setting up the DMA and mapping the lists costs more than it saves.
+ */
+static unsigned int cryp_dma_min_size = 1024;
+module_param(cryp_dma_min_size, uint, 0644);
+MODULE_PARM_DESC(cryp_dma_min_size,
+		 "Smallest request in bytes using DMA in DMA mode");
+
+#define CRYP_QUEUE_LENGTH	100
+
 /**
  * struct cryp_driver_data - data specific to the driver.
  *
  * @device_list: A list of registered devices to choose from.
  * @device_allocation: A semaphore initialized with number of devices.
+ * @queue: Queued ablkcipher requests.
+ * @queue_lock: Lock for the queue.
+ * @queue_wq: Workqueue running the queued requests.
+ * @queue_work: Work running the queued requests.
  */
 struct cryp_driver_data {
 	struct klist device_list;
 	struct semaphore device_allocation;
+	struct crypto_queue queue;
+	spinlock_t queue_lock;
+	struct workqueue_struct *queue_wq;
+	struct work_struct queue_work;
+};
+
+/**
+ * struct cryp_req_ctx - Request context
+ * @algodir: Encrypt or decrypt.
+ * @algomode: Algorithm and block mode.
+ * @blocksize: Size of blocks.
+ */
+struct cryp_req_ctx {
+	enum cryp_algorithm_dir algodir;
+	enum cryp_algo_mode algomode;
+	u32 blocksize;
 };
 
 /**
@@ -1336,268 +1368,199 @@ static void des3_decrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
 				__func__);
 }
 
-static int aes_ecb_encrypt(struct ablkcipher_request *areq)
+static int cryp_cra_init(struct crypto_tfm *tfm)
+{
+	tfm->crt_ablkcipher.reqsize = sizeof(struct cryp_req_ctx);
+
+	return 0;
+}
+
+/*
+ * Runs a request on the device, the tfm context is only written here for
+ * ablkcipher requests, as the queue work runs one request at a time.
+ */
+static int cryp_crypt(struct ablkcipher_request *areq)
 {
 	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
 	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
+	struct cryp_req_ctx *rctx = ablkcipher_request_ctx(areq);
 
-	pr_debug(DEV_DBG_NAME " [%s]", __func__);
+	ctx->config.algodir = rctx->algodir;
+	ctx->config.algomode = rctx->algomode;
+	ctx->blocksize = rctx->blocksize;
 
-	ctx->config.algodir = CRYP_ALGORITHM_ENCRYPT;
-	ctx->config.algomode = CRYP_ALGO_AES_ECB;
-	ctx->blocksize = AES_BLOCK_SIZE;
-
-	if (cryp_mode == CRYP_MODE_DMA)
+	/*
+	 * DMA is currently not working for DES, short requests run the non
+	 * DMA version also in DMA mode.
+	 */
+	if (cryp_mode == CRYP_MODE_DMA && mode_is_aes(rctx->algomode) &&
+	    areq->nbytes >= cryp_dma_min_size)
 		return ablk_dma_crypt(areq);
 
-	/* For everything except DMA, we run the non DMA version. */
 	return ablk_crypt(areq);
 }
 
-static int aes_ecb_decrypt(struct ablkcipher_request *areq)
+/*
+ * Running a request allocates and powers the device, which may sleep. The
+ * requests are therefore queued and run back to back by the queue work, so
+ * that they can be issued from atomic context, as IPsec and dm-crypt do.
+ */
+static void cryp_queue_work(struct work_struct *work)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
+	struct crypto_async_request *async_req;
+	struct crypto_async_request *backlog;
+	int ret;
 
-	pr_debug(DEV_DBG_NAME " [%s]", __func__);
+	for (;;) {
+		spin_lock_bh(&driver_data.queue_lock);
+		backlog = crypto_get_backlog(&driver_data.queue);
+		async_req = crypto_dequeue_request(&driver_data.queue);
+		spin_unlock_bh(&driver_data.queue_lock);
 
-	ctx->config.algodir = CRYP_ALGORITHM_DECRYPT;
-	ctx->config.algomode = CRYP_ALGO_AES_ECB;
-	ctx->blocksize = AES_BLOCK_SIZE;
+		if (!async_req)
+			break;
 
-	if (cryp_mode == CRYP_MODE_DMA)
-		return ablk_dma_crypt(areq);
+		if (backlog)
+			backlog->complete(backlog, -EINPROGRESS);
 
-	/* For everything except DMA, we run the non DMA version. */
-	return ablk_crypt(areq);
+		ret = cryp_crypt(ablkcipher_request_cast(async_req));
+
+		local_bh_disable();
+		async_req->complete(async_req, ret);
+		local_bh_enable();
+	}
 }
 
-static int aes_cbc_encrypt(struct ablkcipher_request *areq)
+static int cryp_enqueue(struct ablkcipher_request *areq,
+			enum cryp_algorithm_dir algodir,
+			enum cryp_algo_mode algomode, u32 blocksize)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-	u32 *flags = &cipher->base.crt_flags;
+	struct cryp_req_ctx *rctx = ablkcipher_request_ctx(areq);
+	int ret;
 
-	pr_debug(DEV_DBG_NAME " [%s]", __func__);
+	rctx->algodir = algodir;
+	rctx->algomode = algomode;
+	rctx->blocksize = blocksize;
 
-	ctx->config.algodir = CRYP_ALGORITHM_ENCRYPT;
-	ctx->config.algomode = CRYP_ALGO_AES_CBC;
-	ctx->blocksize = AES_BLOCK_SIZE;
+	spin_lock_bh(&driver_data.queue_lock);
+	ret = ablkcipher_enqueue_request(&driver_data.queue, areq);
+	spin_unlock_bh(&driver_data.queue_lock);
 
-	/* Only DMA for ablkcipher, since givcipher not yet supported */
-	if ((cryp_mode == CRYP_MODE_DMA) &&
-			(*flags & CRYPTO_ALG_TYPE_ABLKCIPHER))
-		return ablk_dma_crypt(areq);
+	queue_work(driver_data.queue_wq, &driver_data.queue_work);
 
-	/* For everything except DMA, we run the non DMA version. */
-	return ablk_crypt(areq);
+	return ret;
 }
 
-static int aes_cbc_decrypt(struct ablkcipher_request *areq)
+static int aes_ecb_encrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-	u32 *flags = &cipher->base.crt_flags;
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_DECRYPT;
-	ctx->config.algomode = CRYP_ALGO_AES_CBC;
-	ctx->blocksize = AES_BLOCK_SIZE;
+	return cryp_enqueue(areq, CRYP_ALGORITHM_ENCRYPT, CRYP_ALGO_AES_ECB,
+			    AES_BLOCK_SIZE);
+}
 
-	/* Only DMA for ablkcipher, since givcipher not yet supported */
-	if ((cryp_mode == CRYP_MODE_DMA) &&
-			(*flags & CRYPTO_ALG_TYPE_ABLKCIPHER))
-		return ablk_dma_crypt(areq);
+static int aes_ecb_decrypt(struct ablkcipher_request *areq)
+{
+	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	/* For everything except DMA, we run the non DMA version. */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_DECRYPT, CRYP_ALGO_AES_ECB,
+			    AES_BLOCK_SIZE);
 }
 
-static int aes_ctr_encrypt(struct ablkcipher_request *areq)
+static int aes_cbc_encrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-	u32 *flags = &cipher->base.crt_flags;
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_ENCRYPT;
-	ctx->config.algomode = CRYP_ALGO_AES_CTR;
-	ctx->blocksize = AES_BLOCK_SIZE;
+	return cryp_enqueue(areq, CRYP_ALGORITHM_ENCRYPT, CRYP_ALGO_AES_CBC,
+			    AES_BLOCK_SIZE);
+}
 
-	/* Only DMA for ablkcipher, since givcipher not yet supported */
-	if ((cryp_mode == CRYP_MODE_DMA) &&
-			(*flags & CRYPTO_ALG_TYPE_ABLKCIPHER))
-		return ablk_dma_crypt(areq);
+static int aes_cbc_decrypt(struct ablkcipher_request *areq)
+{
+	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	/* For everything except DMA, we run the non DMA version. */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_DECRYPT, CRYP_ALGO_AES_CBC,
+			    AES_BLOCK_SIZE);
 }
 
-static int aes_ctr_decrypt(struct ablkcipher_request *areq)
+static int aes_ctr_encrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-	u32 *flags = &cipher->base.crt_flags;
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_DECRYPT;
-	ctx->config.algomode = CRYP_ALGO_AES_CTR;
-	ctx->blocksize = AES_BLOCK_SIZE;
+	return cryp_enqueue(areq, CRYP_ALGORITHM_ENCRYPT, CRYP_ALGO_AES_CTR,
+			    AES_BLOCK_SIZE);
+}
 
-	/* Only DMA for ablkcipher, since givcipher not yet supported */
-	if ((cryp_mode == CRYP_MODE_DMA) &&
-			(*flags & CRYPTO_ALG_TYPE_ABLKCIPHER))
-		return ablk_dma_crypt(areq);
+static int aes_ctr_decrypt(struct ablkcipher_request *areq)
+{
+	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	/* For everything except DMA, we run the non DMA version. */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_DECRYPT, CRYP_ALGO_AES_CTR,
+			    AES_BLOCK_SIZE);
 }
 
 static int des_ecb_encrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_ENCRYPT;
-	ctx->config.algomode = CRYP_ALGO_DES_ECB;
-	ctx->blocksize = DES_BLOCK_SIZE;
-
-	/*
-	 * Run the non DMA version also for DMA, since DMA is currently not
-	 * working for DES.
-	 */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_ENCRYPT, CRYP_ALGO_DES_ECB,
+			    DES_BLOCK_SIZE);
 }
 
 static int des_ecb_decrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_DECRYPT;
-	ctx->config.algomode = CRYP_ALGO_DES_ECB;
-	ctx->blocksize = DES_BLOCK_SIZE;
-
-	/*
-	 * Run the non DMA version also for DMA, since DMA is currently not
-	 * working for DES.
-	 */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_DECRYPT, CRYP_ALGO_DES_ECB,
+			    DES_BLOCK_SIZE);
 }
 
 static int des_cbc_encrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_ENCRYPT;
-	ctx->config.algomode = CRYP_ALGO_DES_CBC;
-	ctx->blocksize = DES_BLOCK_SIZE;
-
-	/*
-	 * Run the non DMA version also for DMA, since DMA is currently not
-	 * working for DES.
-	 */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_ENCRYPT, CRYP_ALGO_DES_CBC,
+			    DES_BLOCK_SIZE);
 }
 
 static int des_cbc_decrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_DECRYPT;
-	ctx->config.algomode = CRYP_ALGO_DES_CBC;
-	ctx->blocksize = DES_BLOCK_SIZE;
-
-	/*
-	 * Run the non DMA version also for DMA, since DMA is currently not
-	 * working for DES.
-	 */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_DECRYPT, CRYP_ALGO_DES_CBC,
+			    DES_BLOCK_SIZE);
 }
 
 static int des3_ecb_encrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_ENCRYPT;
-	ctx->config.algomode = CRYP_ALGO_TDES_ECB;
-	ctx->blocksize = DES3_EDE_BLOCK_SIZE;
-
-	/*
-	 * Run the non DMA version also for DMA, since DMA is currently not
-	 * working for DES.
-	 */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_ENCRYPT, CRYP_ALGO_TDES_ECB,
+			    DES3_EDE_BLOCK_SIZE);
 }
 
 static int des3_ecb_decrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_DECRYPT;
-	ctx->config.algomode = CRYP_ALGO_TDES_ECB;
-	ctx->blocksize = DES3_EDE_BLOCK_SIZE;
-
-	/*
-	 * Run the non DMA version also for DMA, since DMA is currently not
-	 * working for DES.
-	 */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_DECRYPT, CRYP_ALGO_TDES_ECB,
+			    DES3_EDE_BLOCK_SIZE);
 }
 
 static int des3_cbc_encrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_ENCRYPT;
-	ctx->config.algomode = CRYP_ALGO_TDES_CBC;
-	ctx->blocksize = DES3_EDE_BLOCK_SIZE;
-
-	/*
-	 * Run the non DMA version also for DMA, since DMA is currently not
-	 * working for DES.
-	 */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_ENCRYPT, CRYP_ALGO_TDES_CBC,
+			    DES3_EDE_BLOCK_SIZE);
 }
 
 static int des3_cbc_decrypt(struct ablkcipher_request *areq)
 {
-	struct crypto_ablkcipher *cipher = crypto_ablkcipher_reqtfm(areq);
-	struct cryp_ctx *ctx = crypto_ablkcipher_ctx(cipher);
-
 	pr_debug(DEV_DBG_NAME " [%s]", __func__);
 
-	ctx->config.algodir = CRYP_ALGORITHM_DECRYPT;
-	ctx->config.algomode = CRYP_ALGO_TDES_CBC;
-	ctx->blocksize = DES3_EDE_BLOCK_SIZE;
-
-	/*
-	 * Run the non DMA version also for DMA, since DMA is currently not
-	 * working for DES.
-	 */
-	return ablk_crypt(areq);
+	return cryp_enqueue(areq, CRYP_ALGORITHM_DECRYPT, CRYP_ALGO_TDES_CBC,
+			    DES3_EDE_BLOCK_SIZE);
 }
 
 /**
@@ -1685,6 +1648,7 @@ static struct crypto_alg aes_ecb_alg = {
 	.cra_ctxsize		=	sizeof(struct cryp_ctx),
 	.cra_alignmask		=	3,
 	.cra_type		=	&crypto_ablkcipher_type,
+	.cra_init		=	cryp_cra_init,
 	.cra_module		=	THIS_MODULE,
 	.cra_list		=	LIST_HEAD_INIT(aes_ecb_alg.cra_list),
 	.cra_u			=	{
@@ -1711,6 +1675,7 @@ static struct crypto_alg aes_cbc_alg = {
 	.cra_ctxsize		=	sizeof(struct cryp_ctx),
 	.cra_alignmask		=	3,
 	.cra_type		=	&crypto_ablkcipher_type,
+	.cra_init		=	cryp_cra_init,
 	.cra_module		=	THIS_MODULE,
 	.cra_list		=	LIST_HEAD_INIT(aes_cbc_alg.cra_list),
 	.cra_u			=	{
@@ -1738,6 +1703,7 @@ static struct crypto_alg aes_ctr_alg = {
 	.cra_ctxsize		=	sizeof(struct cryp_ctx),
 	.cra_alignmask		=	3,
 	.cra_type		=	&crypto_ablkcipher_type,
+	.cra_init		=	cryp_cra_init,
 	.cra_module		=	THIS_MODULE,
 	.cra_list		=	LIST_HEAD_INIT(aes_ctr_alg.cra_list),
 	.cra_u			=	{
@@ -1765,6 +1731,7 @@ static struct crypto_alg des_ecb_alg = {
 	.cra_ctxsize		=	sizeof(struct cryp_ctx),
 	.cra_alignmask		=	3,
 	.cra_type		=	&crypto_ablkcipher_type,
+	.cra_init		=	cryp_cra_init,
 	.cra_module		=	THIS_MODULE,
 	.cra_list		=	LIST_HEAD_INIT(des_ecb_alg.cra_list),
 	.cra_u			=	{
@@ -1791,6 +1758,7 @@ static struct crypto_alg des_cbc_alg = {
 	.cra_ctxsize		=	sizeof(struct cryp_ctx),
 	.cra_alignmask		=	3,
 	.cra_type		=	&crypto_ablkcipher_type,
+	.cra_init		=	cryp_cra_init,
 	.cra_module		=	THIS_MODULE,
 	.cra_list		=	LIST_HEAD_INIT(des_cbc_alg.cra_list),
 	.cra_u			=	{
@@ -1818,6 +1786,7 @@ static struct crypto_alg des3_ecb_alg = {
 	.cra_ctxsize		=	sizeof(struct cryp_ctx),
 	.cra_alignmask		=	3,
 	.cra_type		=	&crypto_ablkcipher_type,
+	.cra_init		=	cryp_cra_init,
 	.cra_module		=	THIS_MODULE,
 	.cra_list		=	LIST_HEAD_INIT(des3_ecb_alg.cra_list),
 	.cra_u			=	{
@@ -1844,6 +1813,7 @@ static struct crypto_alg des3_cbc_alg = {
 	.cra_ctxsize		=	sizeof(struct cryp_ctx),
 	.cra_alignmask		=	3,
 	.cra_type		=	&crypto_ablkcipher_type,
+	.cra_init		=	cryp_cra_init,
 	.cra_module		=	THIS_MODULE,
 	.cra_list		=	LIST_HEAD_INIT(des3_cbc_alg.cra_list),
 	.cra_u			=	{
@@ -2287,17 +2257,32 @@ static struct platform_driver cryp_driver = {
 
 static int __init ux500_cryp_mod_init(void)
 {
+	int ret;
+
 	pr_debug("[%s] is called!", __func__);
 	klist_init(&driver_data.device_list, NULL, NULL);
 	/* Initialize the semaphore to 0 devices (locked state) */
 	sema_init(&driver_data.device_allocation, 0);
-	return platform_driver_register(&cryp_driver);
+
+	crypto_init_queue(&driver_data.queue, CRYP_QUEUE_LENGTH);
+	spin_lock_init(&driver_data.queue_lock);
+	INIT_WORK(&driver_data.queue_work, cryp_queue_work);
+	driver_data.queue_wq = create_singlethread_workqueue("ux500_cryp");
+	if (!driver_data.queue_wq)
+		return -ENOMEM;
+
+	ret = platform_driver_register(&cryp_driver);
+	if (ret)
+		destroy_workqueue(driver_data.queue_wq);
+
+	return ret;
 }
 
 static void __exit ux500_cryp_mod_fini(void)
 {
 	pr_debug("[%s] is called!", __func__);
 	platform_driver_unregister(&cryp_driver);
+	destroy_workqueue(driver_data.queue_wq);
 	return;
 }
 
@@ -23,6 +23,7 @@
 
 #include <linux/regulator/dbx500-prcmu.h>
 #include <linux/dmaengine.h>
+#include <linux/workqueue.h>
 #include <linux/bitops.h>
 
 #include <crypto/internal/hash.h>
@@ -41,6 +42,13 @@ static int hash_mode;
 module_param(hash_mode, int, 0);
 MODULE_PARM_DESC(hash_mode, "CPU or DMA mode. CPU = 0 (default), DMA = 1");
 
+static unsigned int hash_dma_min_size = HASH_DMA_PERFORMANCE_MIN_SIZE;
+module_param(hash_dma_min_size, uint, 0644);
+MODULE_PARM_DESC(hash_dma_min_size,
+		 "Smallest request in bytes using DMA in DMA mode");
+
+#define HASH_QUEUE_LENGTH	100
+
 /**
  * Pre-calculated empty message digests.
  */
@@ -77,10 +85,26 @@ static u8 zero_message_hmac_sha256[SHA256_DIGEST_SIZE] = {
  *
  * @device_list:	A list of registered devices to choose from.
  * @device_allocation:	A semaphore initialized with number of devices.
+ * @queue:		Queued ahash requests.
+ * @queue_lock:		Lock for the queue.
+ * @queue_wq:		Workqueue running the queued requests.
+ * @queue_work:		Work running the queued requests.
  */
 struct hash_driver_data {
 	struct klist		device_list;
 	struct semaphore	device_allocation;
+	struct crypto_queue	queue;
+	spinlock_t		queue_lock;
+	struct workqueue_struct	*queue_wq;
+	struct work_struct	queue_work;
+};
+
+/**
+ * struct hash_req_ctx - The context of a request.
+ * @op:		The operation to run for the request.
+ */
+struct hash_req_ctx {
+	int	(*op)(struct ahash_request *req);
 };
 
 static struct hash_driver_data	driver_data;
@@ -593,7 +617,7 @@ static int hash_init(struct ahash_request *req)
 					"to CPU mode for data size < %d",
 					__func__, HASH_DMA_ALIGN_SIZE);
 		} else {
-			if (req->nbytes >= HASH_DMA_PERFORMANCE_MIN_SIZE &&
+			if (req->nbytes >= hash_dma_min_size &&
 					hash_dma_valid_data(req->src,
 						req->nbytes)) {
 				ctx->dma_mode = true;
@@ -603,7 +627,7 @@ static int hash_init(struct ahash_request *req)
 						" CPU mode for datalength < %d"
 						" or non-aligned data, except "
 						"in last nent", __func__,
-						HASH_DMA_PERFORMANCE_MIN_SIZE);
+						hash_dma_min_size);
 			}
 		}
 	}
@@ -1613,11 +1637,122 @@ static int hmac_sha256_setkey(struct crypto_ahash *tfm,
 	return hash_setkey(tfm, key, keylen, HASH_ALGO_SHA256);
 }
 
+/*
+ * The operations allocate and power the device, which may sleep, and keep
+ * the state of the calculation in the tfm context. They are therefore queued
+ * and run one after the other, in order, by the queue work, so that they can
+ * be issued from atomic context, as IPsec does.
+ */
+static void hash_queue_work(struct work_struct *work)
+{
+	struct crypto_async_request *async_req;
+	struct crypto_async_request *backlog;
+	struct ahash_request *req;
+	struct hash_req_ctx *rctx;
+	int ret;
+
+	for (;;) {
+		spin_lock_bh(&driver_data.queue_lock);
+		backlog = crypto_get_backlog(&driver_data.queue);
+		async_req = crypto_dequeue_request(&driver_data.queue);
+		spin_unlock_bh(&driver_data.queue_lock);
+
+		if (!async_req)
+			break;
+
+		if (backlog)
+			backlog->complete(backlog, -EINPROGRESS);
+
+		req = ahash_request_cast(async_req);
+		rctx = ahash_request_ctx(req);
+		ret = rctx->op(req);
+
+		local_bh_disable();
+		async_req->complete(async_req, ret);
+		local_bh_enable();
+	}
+}
+
+static int hash_enqueue(struct ahash_request *req,
+		int (*op)(struct ahash_request *req))
+{
+	struct hash_req_ctx *rctx = ahash_request_ctx(req);
+	int ret;
+
+	rctx->op = op;
+
+	spin_lock_bh(&driver_data.queue_lock);
+	ret = ahash_enqueue_request(&driver_data.queue, req);
+	spin_unlock_bh(&driver_data.queue_lock);
+
+	queue_work(driver_data.queue_wq, &driver_data.queue_work);
+
+	return ret;
+}
+
+static int ahash_update_async(struct ahash_request *req)
+{
+	return hash_enqueue(req, ahash_update);
+}
+
+static int ahash_final_async(struct ahash_request *req)
+{
+	return hash_enqueue(req, ahash_final);
+}
+
+static int ahash_sha1_init_async(struct ahash_request *req)
+{
+	return hash_enqueue(req, ahash_sha1_init);
+}
+
+static int ahash_sha1_digest_async(struct ahash_request *req)
+{
+	return hash_enqueue(req, ahash_sha1_digest);
+}
+
+static int ahash_sha256_init_async(struct ahash_request *req)
+{
+	return hash_enqueue(req, ahash_sha256_init);
+}
+
+static int ahash_sha256_digest_async(struct ahash_request *req)
+{
+	return hash_enqueue(req, ahash_sha256_digest);
+}
+
+static int hmac_sha1_init_async(struct ahash_request *req)
+{
+	return hash_enqueue(req, hmac_sha1_init);
+}
+
+static int hmac_sha1_digest_async(struct ahash_request *req)
+{
+	return hash_enqueue(req, hmac_sha1_digest);
+}
+
+static int hmac_sha256_init_async(struct ahash_request *req)
+{
+	return hash_enqueue(req, hmac_sha256_init);
+}
+
+static int hmac_sha256_digest_async(struct ahash_request *req)
+{
+	return hash_enqueue(req, hmac_sha256_digest);
+}
+
+static int hash_cra_init(struct crypto_tfm *tfm)
+{
+	crypto_ahash_set_reqsize(__crypto_ahash_cast(tfm),
+			sizeof(struct hash_req_ctx));
+
+	return 0;
+}
+
 static struct ahash_alg ahash_sha1_alg = {
-	.init			 = ahash_sha1_init,
-	.update			 = ahash_update,
-	.final			 = ahash_final,
-	.digest			 = ahash_sha1_digest,
+	.init			 = ahash_sha1_init_async,
+	.update			 = ahash_update_async,
+	.final			 = ahash_final_async,
+	.digest			 = ahash_sha1_digest_async,
 	.halg.digestsize	 = SHA1_DIGEST_SIZE,
 	.halg.statesize		 = sizeof(struct hash_ctx),
 	.halg.base = {
@@ -1626,15 +1761,16 @@ static struct ahash_alg ahash_sha1_alg = {
 		.cra_flags	 = CRYPTO_ALG_TYPE_AHASH | CRYPTO_ALG_ASYNC,
 		.cra_blocksize	 = SHA1_BLOCK_SIZE,
 		.cra_ctxsize	 = sizeof(struct hash_ctx),
+		.cra_init	 = hash_cra_init,
 		.cra_module	 = THIS_MODULE,
 	}
 };
 
 static struct ahash_alg ahash_sha256_alg = {
-	.init			 = ahash_sha256_init,
-	.update			 = ahash_update,
-	.final			 = ahash_final,
-	.digest			 = ahash_sha256_digest,
+	.init			 = ahash_sha256_init_async,
+	.update			 = ahash_update_async,
+	.final			 = ahash_final_async,
+	.digest			 = ahash_sha256_digest_async,
 	.halg.digestsize	 = SHA256_DIGEST_SIZE,
 	.halg.statesize		 = sizeof(struct hash_ctx),
 	.halg.base = {
@@ -1643,16 +1779,17 @@ static struct ahash_alg ahash_sha256_alg = {
 		.cra_flags       = CRYPTO_ALG_TYPE_AHASH | CRYPTO_ALG_ASYNC,
 		.cra_blocksize   = SHA256_BLOCK_SIZE,
 		.cra_ctxsize	 = sizeof(struct hash_ctx),
+		.cra_init	 = hash_cra_init,
 		.cra_type	 = &crypto_ahash_type,
 		.cra_module      = THIS_MODULE,
 	}
 };
 
 static struct ahash_alg hmac_sha1_alg = {
-	.init			 = hmac_sha1_init,
-	.update			 = ahash_update,
-	.final			 = ahash_final,
-	.digest			 = hmac_sha1_digest,
+	.init			 = hmac_sha1_init_async,
+	.update			 = ahash_update_async,
+	.final			 = ahash_final_async,
+	.digest			 = hmac_sha1_digest_async,
 	.setkey			 = hmac_sha1_setkey,
 	.halg.digestsize	 = SHA1_DIGEST_SIZE,
 	.halg.statesize		 = sizeof(struct hash_ctx),
@@ -1662,16 +1799,17 @@ static struct ahash_alg hmac_sha1_alg = {
 		.cra_flags       = CRYPTO_ALG_TYPE_AHASH | CRYPTO_ALG_ASYNC,
 		.cra_blocksize   = SHA1_BLOCK_SIZE,
 		.cra_ctxsize	 = sizeof(struct hash_ctx),
+		.cra_init	 = hash_cra_init,
 		.cra_type	 = &crypto_ahash_type,
 		.cra_module      = THIS_MODULE,
 	}
 };
 
 static struct ahash_alg hmac_sha256_alg = {
-	.init			 = hmac_sha256_init,
-	.update			 = ahash_update,
-	.final			 = ahash_final,
-	.digest			 = hmac_sha256_digest,
+	.init			 = hmac_sha256_init_async,
+	.update			 = ahash_update_async,
+	.final			 = ahash_final_async,
+	.digest			 = hmac_sha256_digest_async,
 	.setkey			 = hmac_sha256_setkey,
 	.halg.digestsize	 = SHA256_DIGEST_SIZE,
 	.halg.statesize		 = sizeof(struct hash_ctx),
@@ -1681,6 +1819,7 @@ static struct ahash_alg hmac_sha256_alg = {
 		.cra_flags       = CRYPTO_ALG_TYPE_AHASH | CRYPTO_ALG_ASYNC,
 		.cra_blocksize   = SHA256_BLOCK_SIZE,
 		.cra_ctxsize	 = sizeof(struct hash_ctx),
+		.cra_init	 = hash_cra_init,
 		.cra_type	 = &crypto_ahash_type,
 		.cra_module      = THIS_MODULE,
 	}
@@ -2052,11 +2191,24 @@ static struct platform_driver hash_driver = {
  */
 static int __init ux500_hash_mod_init(void)
 {
+	int ret;
+
 	klist_init(&driver_data.device_list, NULL, NULL);
 	/* Initialize the semaphore to 0 devices (locked state) */
 	sema_init(&driver_data.device_allocation, 0);
 
-	return platform_driver_register(&hash_driver);
+	crypto_init_queue(&driver_data.queue, HASH_QUEUE_LENGTH);
+	spin_lock_init(&driver_data.queue_lock);
+	INIT_WORK(&driver_data.queue_work, hash_queue_work);
+	driver_data.queue_wq = create_singlethread_workqueue("ux500_hash");
+	if (!driver_data.queue_wq)
+		return -ENOMEM;
+
+	ret = platform_driver_register(&hash_driver);
+	if (ret)
+		destroy_workqueue(driver_data.queue_wq);
+
+	return ret;
 }
 
 /**
@@ -2065,6 +2217,7 @@ static int __init ux500_hash_mod_init(void)
 static void __exit ux500_hash_mod_fini(void)
 {
 	platform_driver_unregister(&hash_driver);
+	destroy_workqueue(driver_data.queue_wq);
 	return;
 }
 
@@ -23,6 +23,9 @@
 
 #include "ste_dma40_ll.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/dma40.h>
+
 #ifdef CONFIG_STE_DMA40_DEBUG
 #include "ste_dma40_debug.h"
 #define MARK sted40_history_text((char *)__func__)
@@ -143,8 +146,9 @@ static u32 d40_backup_regs_chan[] = {
  * struct d40_lli_pool - Structure for keeping LLIs in memory
  *
  * @base: Pointer to memory area when the pre_alloc_lli's are not large
- * enough, IE bigger than the most common case, 1 dst and 1 src. NULL if
- * pre_alloc_lli is used.
+ * enough, IE bigger than the most common case, 1 dst and 1 src. Kept when
+ * pre_alloc_lli is used or the descriptor is cached, for later transfers.
+ * @base_size: The size in bytes of the memory at base.
  * @dma_addr: DMA address, if mapped
  * @size: The size in bytes of the memory at base or the size of pre_alloc_lli.
  * @pre_alloc_lli: Pre allocated area for the most common case of transfers,
@@ -152,6 +156,7 @@ static u32 d40_backup_regs_chan[] = {
  */
 struct d40_lli_pool {
 	void	*base;
+	int	 base_size;
 	int	 size;
 	dma_addr_t	dma_addr;
 	/* Space for dst and src, plus an extra for padding */
@@ -175,6 +180,7 @@ struct d40_lli_pool {
  * @node: List entry.
  * @is_in_client_list: true if the client owns this descriptor.
  * @cyclic: true if this is a cyclic job
+ * @periods_per_irq: number of links of a cyclic job between interrupts.
  *
  * This descriptor is used for both logical and physical transfers.
  */
@@ -195,6 +201,7 @@ struct d40_desc {
 
 	bool				 is_in_client_list;
 	bool				 cyclic;
+	unsigned int			 periods_per_irq;
 };
 
 /**
@@ -258,6 +265,9 @@ struct d40_base;
  * @tasklet: Tasklet that gets scheduled from interrupt context to complete a
  * transfer and call client callback.
  * @client: Cliented owned descriptor list.
+ * @free_descs: Cache of freed descriptors, with their lli memory, for the
+ * next transfers. Protected by @lock like the other lists.
+ * @nr_free_descs: Number of descriptors in @free_descs.
  * @pending_queue: Submitted jobs, to be issued by issue_pending()
  * @active: Active descriptor.
  * @done: Completed jobs
@@ -274,6 +284,9 @@ struct d40_base;
  * @runtime_direction: runtime configured direction.
  * @src_dev_addr: device source address for the channel transfer.
  * @dst_dev_addr: device destination address for the channel transfer.
+ * @irq_callback: Callback of a cyclic job to call from the interrupt handler,
+ * once @lock is released.
+ * @irq_callback_param: Parameter of @irq_callback.
  *
  * This struct can either "be" a logical or a physical channel.
  */
@@ -288,6 +301,8 @@ struct d40_chan {
 	struct dma_chan			 chan;
 	struct tasklet_struct		 tasklet;
 	struct list_head		 client;
+	struct list_head		 free_descs;
+	int				 nr_free_descs;
 	struct list_head		 pending_queue;
 	struct list_head		 active;
 	struct list_head		 done;
@@ -307,6 +322,8 @@ struct d40_chan {
 	dma_addr_t			 src_dev_addr;
 	dma_addr_t			 dst_dev_addr;
 	struct list_head		list;
+	dma_async_tx_callback		 irq_callback;
+	void				*irq_callback_param;
 };
 
 /**
@@ -443,6 +460,16 @@ static void __iomem *chan_base(struct d40_chan *chan)
 #define chan_err(d40c, format, arg...)		\
 	d40_err(chan2dev(d40c), format, ## arg)
 
+/*
+ * Descriptors cached per channel, and the smallest lli memory allocated for a
+ * descriptor. The memory covers the scatterlists of up to 16 entries that most
+ * MMC and audio transfers use, so a cached descriptor rarely needs a new
+ * allocation.
+ */
+#define D40_DESC_CACHE_SIZE	16
+#define D40_LLI_POOL_MIN_SIZE	(16 * 2 * sizeof(struct d40_phy_lli) + \
+				 sizeof(struct d40_phy_lli))
+
 static int d40_pool_lli_alloc(struct d40_chan *d40c, struct d40_desc *d40d,
 			      int lli_len)
 {
@@ -458,14 +485,21 @@ static int d40_pool_lli_alloc(struct d40_chan *d40c, struct d40_desc *d40d,
 	if (lli_len == 1) {
 		base = d40d->lli_pool.pre_alloc_lli;
 		d40d->lli_pool.size = sizeof(d40d->lli_pool.pre_alloc_lli);
-		d40d->lli_pool.base = NULL;
 	} else {
 		d40d->lli_pool.size = lli_len * 2 * align;
 
-		base = kmalloc(d40d->lli_pool.size + align, GFP_NOWAIT);
-		d40d->lli_pool.base = base;
+		if (d40d->lli_pool.base_size < d40d->lli_pool.size + align) {
+			int size = max_t(int, d40d->lli_pool.size + align,
+					 D40_LLI_POOL_MIN_SIZE);
 
-		if (d40d->lli_pool.base == NULL)
+			kfree(d40d->lli_pool.base);
+			d40d->lli_pool.base = kmalloc(size, GFP_NOWAIT);
+			d40d->lli_pool.base_size = d40d->lli_pool.base ?
+						   size : 0;
+		}
+		base = d40d->lli_pool.base;
+
+		if (base == NULL)
 			return -ENOMEM;
 	}
 
@@ -485,8 +519,6 @@ static int d40_pool_lli_alloc(struct d40_chan *d40c, struct d40_desc *d40d,
 
 		if (dma_mapping_error(d40c->base->dev,
 				      d40d->lli_pool.dma_addr)) {
-			kfree(d40d->lli_pool.base);
-			d40d->lli_pool.base = NULL;
 			d40d->lli_pool.dma_addr = 0;
 			return -ENOMEM;
 		}
@@ -495,14 +527,14 @@ static int d40_pool_lli_alloc(struct d40_chan *d40c, struct d40_desc *d40d,
 	return 0;
 }
 
+/* The lli memory at base is kept for the next use of the descriptor */
 static void d40_pool_lli_free(struct d40_chan *d40c, struct d40_desc *d40d)
 {
 	if (d40d->lli_pool.dma_addr)
 		dma_unmap_single(d40c->base->dev, d40d->lli_pool.dma_addr,
 				 d40d->lli_pool.size, DMA_TO_DEVICE);
 
-	kfree(d40d->lli_pool.base);
-	d40d->lli_pool.base = NULL;
+	d40d->lli_pool.dma_addr = 0;
 	d40d->lli_pool.size = 0;
 	d40d->lli_log.src = NULL;
 	d40d->lli_log.dst = NULL;
@@ -576,6 +608,21 @@ static void d40_desc_remove(struct d40_desc *d40d)
 	list_del(&d40d->node);
 }
 
+/* Clears a descriptor for reuse, keeping its lli memory */
+static void d40_desc_reset(struct d40_chan *d40c, struct d40_desc *d40d)
+{
+	void *base;
+	int base_size;
+
+	d40_pool_lli_free(d40c, d40d);
+
+	base = d40d->lli_pool.base;
+	base_size = d40d->lli_pool.base_size;
+	memset(d40d, 0, sizeof(*d40d));
+	d40d->lli_pool.base = base;
+	d40d->lli_pool.base_size = base_size;
+}
+
 static struct d40_desc *d40_desc_get(struct d40_chan *d40c)
 {
 	struct d40_desc *desc = NULL;
@@ -588,12 +635,20 @@ static struct d40_desc *d40_desc_get(struct d40_chan *d40c)
 			if (async_tx_test_ack(&d->txd)) {
 				d40_desc_remove(d);
 				desc = d;
-				memset(desc, 0, sizeof(*desc));
+				d40_desc_reset(d40c, desc);
 				break;
 			}
 		}
 	}
 
+	if (!desc && !list_empty(&d40c->free_descs)) {
+		desc = list_first_entry(&d40c->free_descs, struct d40_desc,
+					node);
+		d40_desc_remove(desc);
+		d40c->nr_free_descs--;
+		d40_desc_reset(d40c, desc);
+	}
+
 	if (!desc)
 		desc = kmem_cache_zalloc(d40c->base->desc_slab, GFP_NOWAIT);
 
@@ -603,12 +658,41 @@ static struct d40_desc *d40_desc_get(struct d40_chan *d40c)
 	return desc;
 }
 
+static void d40_desc_release(struct d40_chan *d40c, struct d40_desc *d40d)
+{
+	kfree(d40d->lli_pool.base);
+	kmem_cache_free(d40c->base->desc_slab, d40d);
+}
+
+/*
+ * Freed descriptors go to the channel's cache, already under the channel
+ * lock, so that the next transfers are set up without the slab and mostly
+ * without allocating lli memory.
+ */
 static void d40_desc_free(struct d40_chan *d40c, struct d40_desc *d40d)
 {
 
 	d40_pool_lli_free(d40c, d40d);
 	d40_lcla_free_all(d40c, d40d);
-	kmem_cache_free(d40c->base->desc_slab, d40d);
+
+	if (d40c->nr_free_descs < D40_DESC_CACHE_SIZE) {
+		list_add(&d40d->node, &d40c->free_descs);
+		d40c->nr_free_descs++;
+	} else {
+		d40_desc_release(d40c, d40d);
+	}
+}
+
+static void d40_desc_cache_drain(struct d40_chan *d40c)
+{
+	struct d40_desc *d40d;
+	struct d40_desc *_d;
+
+	list_for_each_entry_safe(d40d, _d, &d40c->free_descs, node) {
+		d40_desc_remove(d40d);
+		d40_desc_release(d40c, d40d);
+	}
+	d40c->nr_free_descs = 0;
 }
 
 static void d40_desc_submit(struct d40_chan *d40c, struct d40_desc *desc)
@@ -695,7 +779,8 @@ static int d40_desc_log_lli_to_lcxa(struct d40_chan *d40c,
 			next_lcla = d40d->cyclic ? first_lcla : -EINVAL;
 
 		interrupt = d40d->cyclic
-			    ? d40d->txd.flags & DMA_PREP_INTERRUPT
+			    ? (d40d->txd.flags & DMA_PREP_INTERRUPT) &&
+			      (lli_current + 1) % d40d->periods_per_irq == 0
 			    : next_lcla == -EINVAL;
 
 		if (d40d->cyclic && curr_lcla == first_lcla) {
@@ -1367,6 +1452,12 @@ redo:
 		return;
 
 	if (d40d->cyclic) {
+		if (d40c->dma_cfg.cyclic_irq_callback &&
+		    (d40d->txd.flags & DMA_PREP_INTERRUPT)) {
+			d40c->irq_callback = d40d->txd.callback;
+			d40c->irq_callback_param = d40d->txd.callback_param;
+			return;
+		}
 		d40c->pending_tx++;
 		tasklet_schedule(&d40c->tasklet);
 		return;
@@ -1409,9 +1500,8 @@ redo:
 		goto redo;
 }
 
-static void dma_tasklet(unsigned long data)
+static void d40_tasklet_run(struct d40_chan *d40c)
 {
-	struct d40_chan *d40c = (struct d40_chan *) data;
 	struct d40_desc *d40d;
 	unsigned long flags;
 	dma_async_tx_callback callback;
@@ -1444,6 +1534,8 @@ static void dma_tasklet(unsigned long data)
 
 	callback = d40d->txd.callback;
 	callback_param = d40d->txd.callback_param;
+	if (!(d40d->txd.flags & DMA_PREP_INTERRUPT))
+		callback = NULL;
 
 	if (!d40d->cyclic) {
 		if (async_tx_test_ack(&d40d->txd)) {
@@ -1464,7 +1556,8 @@ static void dma_tasklet(unsigned long data)
 
 	spin_unlock_irqrestore(&d40c->lock, flags);
 
-	if (callback && (d40d->txd.flags & DMA_PREP_INTERRUPT))
+	/* The descriptor may already be reused, only the copies are valid */
+	if (callback)
 		callback(callback_param);
 
 	return;
@@ -1476,6 +1569,15 @@ err:
 	spin_unlock_irqrestore(&d40c->lock, flags);
 }
 
+static void dma_tasklet(unsigned long data)
+{
+	struct d40_chan *d40c = (struct d40_chan *) data;
+
+	trace_d40_tasklet_entry(d40c->chan.chan_id);
+	d40_tasklet_run(d40c);
+	trace_d40_tasklet_exit(d40c->chan.chan_id);
+}
+
 static irqreturn_t d40_handle_interrupt(int irq, void *data)
 {
 	static const struct d40_interrupt_lookup il[] = {
@@ -1499,6 +1601,10 @@ static irqreturn_t d40_handle_interrupt(int irq, void *data)
 	struct d40_chan *d40c;
 	unsigned long flags;
 	struct d40_base *base = data;
+	dma_async_tx_callback callback;
+	void *callback_param;
+
+	trace_d40_interrupt_entry(irq);
 
 	spin_lock_irqsave(&base->interrupt_lock, flags);
 #ifdef CONFIG_STE_DMA40_DEBUG
@@ -1549,13 +1655,22 @@ static irqreturn_t d40_handle_interrupt(int irq, void *data)
 #endif
 		}
 
+		callback = d40c->irq_callback;
+		callback_param = d40c->irq_callback_param;
+		d40c->irq_callback = NULL;
+
 		spin_unlock(&d40c->lock);
+
+		if (callback)
+			callback(callback_param);
 	}
 #ifdef CONFIG_STE_DMA40_DEBUG
 	sted40_history_text("IRQ leave");
 #endif
 	spin_unlock_irqrestore(&base->interrupt_lock, flags);
 
+	trace_d40_interrupt_exit(irq);
+
 	return IRQ_HANDLED;
 }
 
@@ -2252,8 +2367,10 @@ d40_prep_sg(struct dma_chan *dchan, struct scatterlist *sg_src,
 	if (desc == NULL)
 		goto err;
 
-	if (sg_next(&sg_src[sg_len - 1]) == sg_src)
+	if (sg_next(&sg_src[sg_len - 1]) == sg_src) {
 		desc->cyclic = true;
+		desc->periods_per_irq = 1;
+	}
 
 	if (direction != DMA_NONE) {
 		dma_addr_t dev_addr = d40_get_dev_addr(chan, direction);
@@ -2454,6 +2571,7 @@ static void d40_free_chan_resources(struct dma_chan *chan)
 
 	if (err)
 		chan_err(d40c, "Failed to free channel\n");
+	d40_desc_cache_drain(d40c);
 	spin_unlock_irqrestore(&d40c->lock, flags);
 }
 
@@ -2478,12 +2596,27 @@ static struct dma_async_tx_descriptor *d40_prep_memcpy(struct dma_chan *chan,
 	return d40_prep_sg(chan, &src_sg, &dst_sg, 1, DMA_NONE, dma_flags);
 }
 
-/*static*/ struct dma_async_tx_descriptor *
+static struct dma_async_tx_descriptor *
 d40_prep_memcpy_sg(struct dma_chan *chan,
 		   struct scatterlist *dst_sg, unsigned int dst_nents,
 		   struct scatterlist *src_sg, unsigned int src_nents,
 		   unsigned long dma_flags)
 {
+	struct scatterlist *src, *dst;
+	int i;
+
+	/*
+	 * Each source element is linked with the destination element of the
+	 * same index, so the lists must be split the same way.
+	 */
+	if (src_nents != dst_nents || !src_nents)
+		return NULL;
+
+	for (src = src_sg, dst = dst_sg, i = 0; i < src_nents;
+	     src = sg_next(src), dst = sg_next(dst), i++)
+		if (sg_dma_len(src) != sg_dma_len(dst))
+			return NULL;
+
 	return d40_prep_sg(chan, src_sg, dst_sg, src_nents,
 						DMA_NONE, dma_flags);
 }
@@ -2510,6 +2643,9 @@ dma40_prep_dma_cyclic(struct dma_chan *chan, dma_addr_t dma_addr,
 	int i;
 
 	sg = kcalloc(periods + 1, sizeof(struct scatterlist), GFP_ATOMIC);
+	if (!sg)
+		return NULL;
+
 	for (i = 0; i < periods; i++) {
 		sg_dma_address(&sg[i]) = dma_addr;
 		sg_dma_len(&sg[i]) = period_len;
@@ -2526,6 +2662,21 @@ dma40_prep_dma_cyclic(struct dma_chan *chan, dma_addr_t dma_addr,
 
 	kfree(sg);
 
+	/*
+	 * The links are written to LCLA when the job is started, the
+	 * interrupt interval can still be set here.
+	 */
+	if (txd) {
+		struct d40_chan *d40c = container_of(chan, struct d40_chan,
+						     chan);
+		struct d40_desc *desc = container_of(txd, struct d40_desc,
+						     txd);
+		unsigned int n = d40c->dma_cfg.periods_per_irq;
+
+		if (chan_is_logical(d40c) && n > 1 && periods % n == 0)
+			desc->periods_per_irq = n;
+	}
+
 	return txd;
 }
 
@@ -2892,6 +3043,7 @@ static void __init d40_chan_init(struct d40_base *base, struct dma_device *dma,
 		INIT_LIST_HEAD(&d40c->queue);
 		INIT_LIST_HEAD(&d40c->pending_queue);
 		INIT_LIST_HEAD(&d40c->client);
+		INIT_LIST_HEAD(&d40c->free_descs);
 		INIT_LIST_HEAD(&d40c->prepare_queue);
 
 		tasklet_init(&d40c->tasklet, dma_tasklet,
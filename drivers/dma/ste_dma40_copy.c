@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) ST-Ericsson SA 2012
+ *
+ * Offload of large page copies to the DMA40.
+ *
+ * License terms: GNU General Public License (GPL) version 2
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/highmem.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/scatterlist.h>
+#include <linux/completion.h>
+#include <linux/workqueue.h>
+#include <linux/mutex.h>
+
+#include <asm/sizes.h>
+#include <plat/ste_dma40.h>
+
+/*
+ * Copies shorter than this are done by the CPU. Setting up the transfer and
+ * the cache maintenance of the buffers cost more than the CPU copy for short
+ * copies.
+ */
+static unsigned int min_size = SZ_256K;
+module_param(min_size, uint, 0644);
+MODULE_PARM_DESC(min_size, "Smallest copy in bytes offloaded to the DMA");
+
+/*
+ * An element counter of an lli holds at most 0xffff elements, split the
+ * copy in segments that fit.
+ */
+#define COPY_SEG_SIZE SZ_256K
+
+/* Idle time before the physical channel is given back */
+#define COPY_CHAN_IDLE_MS 1000
+
+#define COPY_TIMEOUT_MS 1000
+
+/*
+ * The default memcpy configurations are byte wide, as dmaengine memcpy users
+ * may give any alignment. Page copies are always aligned, use the widest
+ * elements and bursts on a physical channel.
+ */
+static struct stedma40_chan_cfg copy_conf = {
+	.mode = STEDMA40_MODE_PHYSICAL,
+	.dir = STEDMA40_MEM_TO_MEM,
+
+	.src_dev_type = STEDMA40_DEV_SRC_MEMORY,
+	.src_info.data_width = STEDMA40_DOUBLEWORD_WIDTH,
+	.src_info.psize = STEDMA40_PSIZE_PHY_16,
+	.src_info.flow_ctrl = STEDMA40_NO_FLOW_CTRL,
+
+	.dst_dev_type = STEDMA40_DEV_DST_MEMORY,
+	.dst_info.data_width = STEDMA40_DOUBLEWORD_WIDTH,
+	.dst_info.psize = STEDMA40_PSIZE_PHY_16,
+	.dst_info.flow_ctrl = STEDMA40_NO_FLOW_CTRL,
+};
+
+static struct dma_chan *copy_chan;
+static int copy_users;
+static DEFINE_MUTEX(copy_lock);
+
+static void copy_chan_release(struct work_struct *work)
+{
+	mutex_lock(&copy_lock);
+	if (copy_users == 0 && copy_chan) {
+		dma_release_channel(copy_chan);
+		copy_chan = NULL;
+	}
+	mutex_unlock(&copy_lock);
+}
+static DECLARE_DELAYED_WORK(copy_chan_release_work, copy_chan_release);
+
+/* The channel is requested at first use and kept while copies keep coming */
+static struct dma_chan *copy_chan_get(void)
+{
+	struct dma_chan *chan;
+	dma_cap_mask_t mask;
+
+	mutex_lock(&copy_lock);
+	if (!copy_chan) {
+		dma_cap_zero(mask);
+		dma_cap_set(DMA_SG, mask);
+		copy_chan = dma_request_channel(mask, stedma40_filter,
+						&copy_conf);
+	}
+	chan = copy_chan;
+	if (chan)
+		copy_users++;
+	mutex_unlock(&copy_lock);
+
+	return chan;
+}
+
+static void copy_chan_put(void)
+{
+	mutex_lock(&copy_lock);
+	if (--copy_users == 0)
+		schedule_delayed_work(&copy_chan_release_work,
+				      msecs_to_jiffies(COPY_CHAN_IDLE_MS));
+	mutex_unlock(&copy_lock);
+}
+
+static void cpu_copy_pages(struct page *dst, struct page *src,
+			   unsigned int nr_pages)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr_pages; i++)
+		copy_highpage(dst + i, src + i);
+}
+
+static void dma_copy_done(void *data)
+{
+	complete(data);
+}
+
+static int dma_copy_pages(struct dma_chan *chan, struct page *dst,
+			  struct page *src, size_t len)
+{
+	struct device *dev = chan->device->dev;
+	struct dma_async_tx_descriptor *txd;
+	struct scatterlist *src_sg, *dst_sg;
+	struct completion done;
+	dma_addr_t src_addr, dst_addr;
+	unsigned int nents = DIV_ROUND_UP(len, COPY_SEG_SIZE);
+	unsigned int i;
+	int ret = 0;
+
+	src_sg = kmalloc(2 * nents * sizeof(struct scatterlist), GFP_KERNEL);
+	if (!src_sg)
+		return -ENOMEM;
+	dst_sg = src_sg + nents;
+
+	src_addr = dma_map_page(dev, src, 0, len, DMA_TO_DEVICE);
+	dst_addr = dma_map_page(dev, dst, 0, len, DMA_FROM_DEVICE);
+
+	sg_init_table(src_sg, nents);
+	sg_init_table(dst_sg, nents);
+	for (i = 0; i < nents; i++) {
+		size_t offset = i * COPY_SEG_SIZE;
+		size_t seg_len = min_t(size_t, len - offset, COPY_SEG_SIZE);
+
+		sg_dma_address(&src_sg[i]) = src_addr + offset;
+		sg_dma_len(&src_sg[i]) = seg_len;
+		sg_dma_address(&dst_sg[i]) = dst_addr + offset;
+		sg_dma_len(&dst_sg[i]) = seg_len;
+	}
+
+	txd = chan->device->device_prep_dma_sg(chan, dst_sg, nents,
+					       src_sg, nents,
+					       DMA_PREP_INTERRUPT |
+					       DMA_CTRL_ACK);
+	if (!txd) {
+		ret = -EBUSY;
+		goto unmap;
+	}
+
+	init_completion(&done);
+	txd->callback = dma_copy_done;
+	txd->callback_param = &done;
+
+	if (dma_submit_error(txd->tx_submit(txd))) {
+		ret = -EIO;
+		goto unmap;
+	}
+	dma_async_issue_pending(chan);
+
+	if (!wait_for_completion_timeout(&done,
+					 msecs_to_jiffies(COPY_TIMEOUT_MS))) {
+		dev_warn(dev, "%s: copy of %zu bytes timed out\n", __func__,
+			 len);
+		dmaengine_terminate_all(chan);
+		ret = -ETIMEDOUT;
+	}
+
+unmap:
+	dma_unmap_page(dev, dst_addr, len, DMA_FROM_DEVICE);
+	dma_unmap_page(dev, src_addr, len, DMA_TO_DEVICE);
+	kfree(src_sg);
+
+	return ret;
+}
+
+/**
+ * stedma40_copy_pages() - Copies physically contiguous pages
+ *
+ * @dst: First destination page
+ * @src: First source page
+ * @nr_pages: Number of pages to copy
+ *
+ * Copies of at least min_size bytes are done by the DMA while the calling
+ * thread sleeps, shorter copies and copies the DMA fails to do are done by
+ * the CPU. Must be called from a context that can sleep.
+ */
+void stedma40_copy_pages(struct page *dst, struct page *src,
+			 unsigned int nr_pages)
+{
+	size_t len = (size_t)nr_pages << PAGE_SHIFT;
+	struct dma_chan *chan;
+	int ret;
+
+	if (len < min_size)
+		goto cpu_copy;
+
+	chan = copy_chan_get();
+	if (!chan)
+		goto cpu_copy;
+
+	ret = dma_copy_pages(chan, dst, src, len);
+	copy_chan_put();
+	if (ret == 0)
+		return;
+
+cpu_copy:
+	cpu_copy_pages(dst, src, nr_pages);
+}
+EXPORT_SYMBOL(stedma40_copy_pages);
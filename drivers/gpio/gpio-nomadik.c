@@ -23,6 +23,8 @@
 #include <linux/interrupt.h>
 #include <linux/irq.h>
 #include <linux/slab.h>
+#include <linux/timer.h>
+#include <linux/jiffies.h>
 
 #include <asm/mach/irq.h>
 #include <plat/gpio-nomadik.h>
@@ -61,6 +63,22 @@ struct nmk_gpio_chip {
 	u32 fimsc;
 	u32 pull_up;
 	u32 lowemi;
+	/*
+	 * Software debounce, set through gpio_set_debounce(). An edge on a
+	 * pin in debounce_mask within debounce[] of the last one handled is
+	 * acked and dropped, and a single edge is handled for all of those
+	 * once the time is up.
+	 */
+	u32 debounce_mask;
+	u32 debounce_pending;
+	unsigned long debounce[NMK_GPIO_PER_CHIP];
+	unsigned long last_edge[NMK_GPIO_PER_CHIP];
+	struct timer_list debounce_timer;
+	/* Wakeup statistics, and the levels wakeups are checked against */
+	u32 suspend_level;
+	unsigned int wakeups[NMK_GPIO_PER_CHIP];
+	unsigned int wakeups_filtered[NMK_GPIO_PER_CHIP];
+	unsigned int edges_filtered[NMK_GPIO_PER_CHIP];
 };
 
 static struct nmk_gpio_chip *
@@ -815,22 +833,103 @@ static struct irq_chip nmk_gpio_irq_chip = {
 	.irq_shutdown	= nmk_gpio_irq_shutdown,
 };
 
+/*
+ * Returns true if the edge on @bit is a bounce of the last one handled. It
+ * is acked here, since handle_edge_irq() will not see it.
+ */
+static bool nmk_gpio_debounced(struct nmk_gpio_chip *nmk_chip, int bit)
+{
+	unsigned long now = jiffies;
+	unsigned long end;
+	bool bounce;
+
+	spin_lock(&nmk_chip->lock);
+
+	end = nmk_chip->last_edge[bit] + nmk_chip->debounce[bit];
+	bounce = time_before(now, end);
+	if (bounce) {
+		writel(BIT(bit), nmk_chip->addr + NMK_GPIO_IC);
+		nmk_chip->edges_filtered[bit]++;
+		if (!nmk_chip->debounce_pending ||
+		    time_before(end, nmk_chip->debounce_timer.expires))
+			mod_timer(&nmk_chip->debounce_timer, end);
+		nmk_chip->debounce_pending |= BIT(bit);
+	} else {
+		nmk_chip->last_edge[bit] = now;
+	}
+
+	spin_unlock(&nmk_chip->lock);
+
+	return bounce;
+}
+
+static void nmk_gpio_debounce_timer(unsigned long data)
+{
+	struct nmk_gpio_chip *nmk_chip = (struct nmk_gpio_chip *)data;
+	unsigned int first_irq = NOMADIK_GPIO_TO_IRQ(nmk_chip->chip.base);
+	unsigned long now = jiffies;
+	unsigned long next = 0;
+	unsigned long flags;
+	u32 pending = 0;
+	u32 left;
+	int bit;
+
+	spin_lock_irqsave(&nmk_chip->lock, flags);
+
+	left = nmk_chip->debounce_pending;
+	while (left) {
+		unsigned long end;
+
+		bit = __ffs(left);
+		left &= ~BIT(bit);
+
+		end = nmk_chip->last_edge[bit] + nmk_chip->debounce[bit];
+		if (time_before(now, end)) {
+			if (!next || time_before(end, next))
+				next = end;
+			continue;
+		}
+		nmk_chip->last_edge[bit] = now;
+		pending |= BIT(bit);
+	}
+	nmk_chip->debounce_pending &= ~pending;
+	if (nmk_chip->debounce_pending)
+		mod_timer(&nmk_chip->debounce_timer, next);
+
+	spin_unlock(&nmk_chip->lock);
+
+	/* Handlers read the level, one edge tells them it has settled */
+	while (pending) {
+		bit = __ffs(pending);
+		pending &= ~BIT(bit);
+		generic_handle_irq(first_irq + bit);
+	}
+
+	local_irq_restore(flags);
+}
+
 static void __nmk_gpio_irq_handler(unsigned int irq, struct irq_desc *desc,
 				   u32 status)
 {
 	struct nmk_gpio_chip *nmk_chip;
 	struct irq_chip *host_chip = irq_get_chip(irq);
 	unsigned int first_irq;
+	u32 debounce;
 
 	chained_irq_enter(host_chip, desc);
 
 	nmk_chip = irq_get_handler_data(irq);
 	first_irq = NOMADIK_GPIO_TO_IRQ(nmk_chip->chip.base);
+	debounce = ACCESS_ONCE(nmk_chip->debounce_mask);
 	while (status) {
 		int bit = __ffs(status);
 
-		generic_handle_irq(first_irq + bit);
 		status &= ~BIT(bit);
+		if (unlikely(debounce & BIT(bit)) &&
+		    nmk_gpio_debounced(nmk_chip, bit))
+			continue;
+
+		generic_handle_irq(first_irq + bit);
 	}
 
 	chained_irq_exit(host_chip, desc);
@@ -942,6 +1041,27 @@ static int nmk_gpio_make_output(struct gpio_chip *chip, unsigned offset,
 	return 0;
 }
 
+static int nmk_gpio_set_debounce(struct gpio_chip *chip, unsigned offset,
+				 unsigned debounce)
+{
+	struct nmk_gpio_chip *nmk_chip =
+		container_of(chip, struct nmk_gpio_chip, chip);
+	unsigned long flags;
+
+	spin_lock_irqsave(&nmk_chip->lock, flags);
+
+	nmk_chip->debounce[offset] = usecs_to_jiffies(debounce);
+	nmk_chip->last_edge[offset] = jiffies - nmk_chip->debounce[offset];
+	if (debounce)
+		nmk_chip->debounce_mask |= BIT(offset);
+	else
+		nmk_chip->debounce_mask &= ~BIT(offset);
+
+	spin_unlock_irqrestore(&nmk_chip->lock, flags);
+
+	return 0;
+}
+
 static int nmk_gpio_to_irq(struct gpio_chip *chip, unsigned offset)
 {
 	struct nmk_gpio_chip *nmk_chip =
@@ -1010,6 +1130,15 @@ static void nmk_gpio_dbg_show(struct seq_file *s, struct gpio_chip *chip)
 					irq, trigger,
 					irqd_is_wakeup_set(&desc->irq_data)
 						? " wakeup" : "");
+				if (nmk_chip->debounce_mask & bitmask)
+					seq_printf(s, " debounce %ums (%u)",
+						jiffies_to_msecs(
+						nmk_chip->debounce[i]),
+						nmk_chip->edges_filtered[i]);
+				if (nmk_chip->wakeups[i])
+					seq_printf(s, " woke %u (%u filtered)",
+						nmk_chip->wakeups[i],
+						nmk_chip->wakeups_filtered[i]);
 			}
 		}
 
@@ -1029,6 +1158,7 @@ static struct gpio_chip nmk_gpio_template = {
 	.get			= nmk_gpio_get_input,
 	.direction_output	= nmk_gpio_make_output,
 	.set			= nmk_gpio_set_output,
+	.set_debounce		= nmk_gpio_set_debounce,
 	.to_irq			= nmk_gpio_to_irq,
 	.dbg_show		= nmk_gpio_dbg_show,
 	.can_sleep		= 0,
@@ -1088,10 +1218,41 @@ void nmk_gpio_wakeups_suspend(void)
 		writel(chip->fwimsc & chip->real_wake,
 		       chip->addr + NMK_GPIO_FWIMSC);
 
+		chip->suspend_level = readl(chip->addr + NMK_GPIO_DAT);
+
 		clk_disable(chip->clk);
 	}
 }
 
+/*
+ * Counts the pins that woke the system up. A debounced pin that is back at
+ * the level it had when going to sleep only glitched: its edge is acked, so
+ * that no handler runs and nothing keeps the system awake for it.
+ */
+static void nmk_gpio_wakeups_check(struct nmk_gpio_chip *chip)
+{
+	u32 woke = readl(chip->addr + NMK_GPIO_IS) & chip->real_wake;
+	u32 glitched;
+	int bit;
+
+	if (!woke)
+		return;
+
+	glitched = woke & chip->debounce_mask &
+		~(readl(chip->addr + NMK_GPIO_DAT) ^ chip->suspend_level);
+	if (glitched)
+		writel(glitched, chip->addr + NMK_GPIO_IC);
+
+	while (woke) {
+		bit = __ffs(woke);
+		woke &= ~BIT(bit);
+
+		chip->wakeups[bit]++;
+		if (glitched & BIT(bit))
+			chip->wakeups_filtered[bit]++;
+	}
+}
+
 void nmk_gpio_wakeups_resume(void)
 {
 	int i;
@@ -1104,6 +1265,8 @@ void nmk_gpio_wakeups_resume(void)
 
 		clk_enable(chip->clk);
 
+		nmk_gpio_wakeups_check(chip);
+
 		writel(chip->rwimsc, chip->addr + NMK_GPIO_RWIMSC);
 		writel(chip->fwimsc, chip->addr + NMK_GPIO_FWIMSC);
 
@@ -1193,6 +1356,8 @@ static int __devinit nmk_gpio_probe(struct platform_device *dev)
 	nmk_chip->set_ioforce = pdata->set_ioforce;
 	nmk_chip->sleepmode = pdata->supports_sleepmode;
 	spin_lock_init(&nmk_chip->lock);
+	setup_timer(&nmk_chip->debounce_timer, nmk_gpio_debounce_timer,
+		    (unsigned long)nmk_chip);
 
 	chip = &nmk_chip->chip;
 	chip->base = pdata->first_gpio;
@@ -0,0 +1,204 @@
+/*
+ * drivers/gpu/ion/ion_page_pool.c
+ *
+ * Copyright (C) 2011 Google, Inc.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <linux/highmem.h>
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/swap.h>
+#include <linux/workqueue.h>
+#include "ion_priv.h"
+
+/*
+ * Pages given back to a pool are dirty until the zero work has cleared them.
+ * An allocation takes a clean page if there is one, otherwise it clears a
+ * dirty page itself, and only goes to the page allocator when the pool is
+ * empty. The pages of all pools are given back to the system by the shrinker
+ * when memory runs low.
+ */
+
+static LIST_HEAD(pools);
+static DEFINE_MUTEX(pools_lock);
+
+static void ion_page_pool_zero(struct page *page, unsigned int order)
+{
+	int i;
+
+	for (i = 0; i < (1 << order); i++)
+		clear_highpage(page + i);
+}
+
+static void ion_page_pool_zero_work(struct work_struct *work)
+{
+	struct ion_page_pool *pool = container_of(work, struct ion_page_pool,
+						  zero_work);
+	struct page *page;
+
+	for (;;) {
+		mutex_lock(&pool->mutex);
+		if (list_empty(&pool->dirty_items)) {
+			mutex_unlock(&pool->mutex);
+			break;
+		}
+		page = list_first_entry(&pool->dirty_items, struct page, lru);
+		list_del(&page->lru);
+		pool->dirty_count--;
+		mutex_unlock(&pool->mutex);
+
+		ion_page_pool_zero(page, pool->order);
+
+		mutex_lock(&pool->mutex);
+		list_add_tail(&page->lru, &pool->clean_items);
+		pool->clean_count++;
+		mutex_unlock(&pool->mutex);
+	}
+}
+
+struct page *ion_page_pool_alloc(struct ion_page_pool *pool)
+{
+	struct page *page = NULL;
+	bool dirty = false;
+
+	mutex_lock(&pool->mutex);
+	if (!list_empty(&pool->clean_items)) {
+		page = list_first_entry(&pool->clean_items, struct page, lru);
+		pool->clean_count--;
+	} else if (!list_empty(&pool->dirty_items)) {
+		page = list_first_entry(&pool->dirty_items, struct page, lru);
+		pool->dirty_count--;
+		dirty = true;
+	}
+	if (page)
+		list_del(&page->lru);
+	mutex_unlock(&pool->mutex);
+
+	if (!page)
+		return alloc_pages(pool->gfp_mask | __GFP_ZERO, pool->order);
+
+	if (dirty)
+		ion_page_pool_zero(page, pool->order);
+
+	return page;
+}
+
+void ion_page_pool_free(struct ion_page_pool *pool, struct page *page)
+{
+	mutex_lock(&pool->mutex);
+	list_add_tail(&page->lru, &pool->dirty_items);
+	pool->dirty_count++;
+	mutex_unlock(&pool->mutex);
+
+	queue_work(system_unbound_wq, &pool->zero_work);
+}
+
+static int ion_page_pool_total(struct ion_page_pool *pool)
+{
+	return (pool->clean_count + pool->dirty_count) << pool->order;
+}
+
+/*
+ * Frees up to nr_to_scan pages of the pool, dirty pages first as nothing has
+ * been spent on them yet. Returns the number of pages freed.
+ */
+static int ion_page_pool_trim(struct ion_page_pool *pool, int nr_to_scan)
+{
+	struct page *page;
+	int freed = 0;
+
+	mutex_lock(&pool->mutex);
+	while (freed < nr_to_scan) {
+		if (!list_empty(&pool->dirty_items)) {
+			page = list_first_entry(&pool->dirty_items,
+						struct page, lru);
+			pool->dirty_count--;
+		} else if (!list_empty(&pool->clean_items)) {
+			page = list_first_entry(&pool->clean_items,
+						struct page, lru);
+			pool->clean_count--;
+		} else {
+			break;
+		}
+		list_del(&page->lru);
+		__free_pages(page, pool->order);
+		freed += 1 << pool->order;
+	}
+	mutex_unlock(&pool->mutex);
+
+	return freed;
+}
+
+static int ion_page_pool_shrink(struct shrinker *shrinker,
+				struct shrink_control *sc)
+{
+	struct ion_page_pool *pool;
+	int nr_to_scan = sc->nr_to_scan;
+	int total = 0;
+
+	/* The pools may be busy with the allocation that is reclaiming */
+	if (!mutex_trylock(&pools_lock))
+		return nr_to_scan ? -1 : 0;
+
+	list_for_each_entry(pool, &pools, list) {
+		if (nr_to_scan > 0)
+			nr_to_scan -= ion_page_pool_trim(pool, nr_to_scan);
+		total += ion_page_pool_total(pool);
+	}
+
+	mutex_unlock(&pools_lock);
+
+	return total;
+}
+
+static struct shrinker ion_page_pool_shrinker = {
+	.shrink = ion_page_pool_shrink,
+	.seeks = DEFAULT_SEEKS,
+};
+
+struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order)
+{
+	struct ion_page_pool *pool = kzalloc(sizeof(struct ion_page_pool),
+					     GFP_KERNEL);
+	if (!pool)
+		return NULL;
+	INIT_LIST_HEAD(&pool->clean_items);
+	INIT_LIST_HEAD(&pool->dirty_items);
+	mutex_init(&pool->mutex);
+	INIT_WORK(&pool->zero_work, ion_page_pool_zero_work);
+	pool->gfp_mask = gfp_mask;
+	pool->order = order;
+
+	mutex_lock(&pools_lock);
+	if (list_empty(&pools))
+		register_shrinker(&ion_page_pool_shrinker);
+	list_add_tail(&pool->list, &pools);
+	mutex_unlock(&pools_lock);
+
+	return pool;
+}
+
+void ion_page_pool_destroy(struct ion_page_pool *pool)
+{
+	mutex_lock(&pools_lock);
+	list_del(&pool->list);
+	if (list_empty(&pools))
+		unregister_shrinker(&ion_page_pool_shrinker);
+	mutex_unlock(&pools_lock);
+
+	cancel_work_sync(&pool->zero_work);
+	ion_page_pool_trim(pool, INT_MAX);
+	kfree(pool);
+}
@@ -21,6 +21,7 @@
 #include <linux/mm_types.h>
 #include <linux/mutex.h>
 #include <linux/rbtree.h>
+#include <linux/workqueue.h>
 #include <linux/ion.h>
 
 struct ion_mapping;
@@ -181,4 +182,40 @@ void ion_carveout_free(struct ion_heap *heap, ion_phys_addr_t addr,
  */
 #define ION_CARVEOUT_ALLOCATE_FAIL -1
 
+/**
+ * struct ion_page_pool - pagepool struct
+ * @clean_count:	number of zeroed items in the pool
+ * @dirty_count:	number of items in the pool waiting to be zeroed
+ * @clean_items:	list of zeroed pages, linked through page->lru
+ * @dirty_items:	list of pages waiting to be zeroed
+ * @mutex:		lock protecting this struct and especially the counts
+ *			and item lists
+ * @gfp_mask:		gfp_mask to use from alloc
+ * @order:		order of pages in the pool
+ * @zero_work:		zeroes the dirty pages in the background
+ * @list:		node in the list of pools walked by the shrinker
+ *
+ * Allows you to keep a pool of pre allocated, zeroed pages to use from your
+ * heap, so buffers allocated over and over at the same sizes neither go back
+ * to the page allocator nor are zeroed in the allocating thread. Pages are
+ * zeroed in the background when given back. The pools are trimmed by a
+ * shrinker under memory pressure.
+ */
+struct ion_page_pool {
+	int clean_count;
+	int dirty_count;
+	struct list_head clean_items;
+	struct list_head dirty_items;
+	struct mutex mutex;
+	gfp_t gfp_mask;
+	unsigned int order;
+	struct work_struct zero_work;
+	struct list_head list;
+};
+
+struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order);
+void ion_page_pool_destroy(struct ion_page_pool *);
+struct page *ion_page_pool_alloc(struct ion_page_pool *);
+void ion_page_pool_free(struct ion_page_pool *, struct page *);
+
 #endif /* _ION_PRIV_H */
@@ -17,6 +17,7 @@
 #include "mali_kernel_core.h"
 #if MALI_TIMELINE_PROFILING_ENABLED
 #include "mali_osk_profiling.h"
+#include "mali_linux_trace.h"
 #endif
 
 /**
@@ -365,6 +366,9 @@ void mali_gp_job_start(struct mali_gp_core *core, struct mali_gp_job *job)
 	_mali_osk_profiling_add_event(MALI_PROFILING_EVENT_TYPE_START|MALI_PROFILING_MAKE_EVENT_CHANNEL_GP(0), job->pid, job->tid, 0, 0, 0);
 #endif
 
+	trace_mali_job_start(MALI_FALSE, 0, job->id, job->pid,
+	                     job->frame_builder_id, job->flush_id);
+
 	core->running_job = job;
 }
 
@@ -710,6 +714,11 @@ static void mali_gp_post_process_job(struct mali_gp_core *core, mali_bool suspen
 
 		if (MALI_TRUE != suspend)
 		{
+			trace_mali_job_done(MALI_FALSE, 0, core->running_job->id,
+			                    core->running_job->pid,
+			                    core->running_job->frame_builder_id,
+			                    core->running_job->flush_id);
+
 			/* We are no longer running a job... */
 			core->running_job = NULL;
 			_mali_osk_timer_del(core->timeout_timer);
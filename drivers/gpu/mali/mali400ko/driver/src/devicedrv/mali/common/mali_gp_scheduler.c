@@ -17,6 +17,7 @@
 #include "mali_gp_job.h"
 #include "mali_group.h"
 #include "mali_cluster.h"
+#include "mali_platform.h"
 
 enum mali_gp_slot_state
 {
@@ -38,6 +39,7 @@ struct mali_gp_slot
 
 static u32 gp_version = 0;
 static _MALI_OSK_LIST_HEAD(job_queue);                          /* List of jobs with some unscheduled work */
+static u32 job_queue_depth = 0;                                 /* Number of jobs in job_queue */
 static struct mali_gp_slot slot;
 
 /* Variables to allow safe pausing of the scheduler */
@@ -151,6 +153,7 @@ static void mali_gp_scheduler_schedule(void)
 
 		/* Remove from queue of unscheduled jobs */
 		_mali_osk_list_del(&job->list);
+		job_queue_depth--;
 	}
 	else
 	{
@@ -307,11 +310,18 @@ _mali_osk_errcode_t _mali_ukk_gp_start_job(_mali_uk_gp_start_job_s *args)
 	mali_gp_scheduler_lock();
 
 	_mali_osk_list_addtail(&job->list, &job_queue);
+	job_queue_depth++;
 
 	MALI_DEBUG_PRINT(3, ("Mali GP scheduler: Job %u (0x%08X) queued\n", mali_gp_job_get_id(job), job));
 
 	mali_gp_scheduler_schedule();
 
+	/* Jobs still queued are waiting for the GP core */
+	if (0 < job_queue_depth)
+	{
+		mali_gpu_job_queue_handler(job_queue_depth);
+	}
+
 	mali_gp_scheduler_unlock();
 
 	return _MALI_OSK_ERR_OK;
@@ -401,6 +411,7 @@ void mali_gp_scheduler_abort_session(struct mali_session_data *session)
 		{
 			MALI_DEBUG_PRINT(4, ("Mali GP scheduler: Removing GP job 0x%08x from queue\n", job));
 			_mali_osk_list_del(&(job->list));
+			job_queue_depth--;
 			mali_gp_job_delete(job);
 		}
 	}
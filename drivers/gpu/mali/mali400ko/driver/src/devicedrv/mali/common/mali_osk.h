@@ -1662,6 +1662,14 @@ u64 _mali_osk_time_get_ns( void );
  * @return the number of leading zeros.
  */
 u32 _mali_osk_clz( u32 val );
+
+/** @brief Divide a 64-bit value by a 32-bit value
+ *
+ * @param dividend 64-bit value to divide
+ * @param divisor 32-bit value to divide by, must not be 0
+ * @return the quotient.
+ */
+u64 _mali_osk_div_u64( u64 dividend, u32 divisor );
 /** @} */ /* end group _mali_osk_math */
 
 /** @defgroup _mali_osk_wait_queue OSK Wait Queue functionality
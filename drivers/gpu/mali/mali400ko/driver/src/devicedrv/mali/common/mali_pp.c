@@ -17,6 +17,7 @@
 #include "mali_kernel_core.h"
 #if MALI_TIMELINE_PROFILING_ENABLED
 #include "mali_osk_profiling.h"
+#include "mali_linux_trace.h"
 #endif
 
 /* See mali_gp.c file for description on how to handle the interrupt mask.
@@ -403,6 +404,9 @@ void mali_pp_job_start(struct mali_pp_core *core, struct mali_pp_job *job, u32 s
 	_mali_osk_profiling_add_event(MALI_PROFILING_EVENT_TYPE_START|MALI_PROFILING_MAKE_EVENT_CHANNEL_PP(core->core_id), job->pid, job->tid, 0, 0, 0);
 #endif
 
+	trace_mali_job_start(MALI_TRUE, core->core_id, job->id, job->pid,
+	                     job->frame_builder_id, job->flush_id);
+
 	core->running_job = job;
 	core->running_sub_job = sub_job;
 }
@@ -656,6 +660,11 @@ static void mali_pp_post_process_job(struct mali_pp_core *core)
 		                          val0, val1, core->counter_src0_used | (core->counter_src1_used << 8), 0, 0);
 #endif
 
+		trace_mali_job_done(MALI_TRUE, core->core_id, core->running_job->id,
+		                    core->running_job->pid,
+		                    core->running_job->frame_builder_id,
+		                    core->running_job->flush_id);
+
 		/* We are no longer running a job... */
 		core->running_job = NULL;
 		_mali_osk_timer_del(core->timeout_timer);
@@ -51,6 +51,7 @@ struct mali_pp_job
 	mali_bool barrier;                                 /**< [in] MALI_TRUE means wait for all my previous jobs to complete before scheduling this one */
 	mali_bool active_barrier;                          /**< [in] Changes from MALI_TRUE to MALI_FALSE when barrier has been resolved */
 	mali_bool no_notification;                         /**< [in] MALI_TRUE means do not notify user space when this job has completed */
+	u64 queue_time;                                    /**< Time (ns) the job was put in the scheduler queue */
 };
 
 struct mali_pp_job *mali_pp_job_create(struct mali_session_data *session, _mali_uk_pp_start_job_s *args, u32 id);
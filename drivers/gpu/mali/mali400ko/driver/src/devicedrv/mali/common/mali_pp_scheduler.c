@@ -23,6 +23,13 @@
 
 bool mali_pp_scheduler_balance_jobs = false;
 
+/*
+ * Start the next sub job of a job directly on the core that completed the
+ * previous one, from the completion bottom half, instead of walking the
+ * scheduler queue and the slots again.
+ */
+bool mali_pp_scheduler_batch_sub_jobs = true;
+
 static mali_bool mali_pp_scheduler_is_suspended(void);
 
 enum mali_pp_slot_state
@@ -41,6 +48,22 @@ struct mali_pp_slot
 	 */
 	enum mali_pp_slot_state state;
 	struct mali_session_data *session;
+	u64 idle_since;                  /* Time the slot went idle with work queued, or 0 */
+};
+
+struct mali_pp_scheduler_stats
+{
+	u32 frames;
+	u32 frame_jobs;                  /* Jobs queued for the current frame */
+	u32 max_frame_jobs;
+	u32 jobs;
+	u32 batched_sub_jobs;            /* Sub jobs started from the completion of the previous one */
+	u32 starts;                      /* Jobs with their first sub job started */
+	u64 total_start_latency;
+	u64 max_start_latency;
+	u32 idle_gaps;
+	u64 total_idle_gap;
+	u64 max_idle_gap;
 };
 
 static u32 pp_version = 0;
@@ -49,6 +72,13 @@ static struct mali_pp_slot slots[MALI_MAX_NUMBER_OF_PP_GROUPS];
 static u32 num_slots = 0;
 static u32 num_slots_idle = 0;
 
+/* Statistics, protected by the scheduler lock */
+static struct mali_pp_scheduler_stats stats;
+/* A frame is the jobs of one flush of a frame builder */
+static struct mali_session_data *stats_session = NULL;
+static u32 stats_frame_builder_id = 0;
+static u32 stats_flush_id = 0;
+
 /* Variables to allow safe pausing of the scheduler */
 static _mali_osk_wait_queue_t *pp_scheduler_working_wait_queue = NULL;
 static u32 pause_count = 0;
@@ -95,6 +125,7 @@ _mali_osk_errcode_t mali_pp_scheduler_initialize(void)
 				slots[num_slots].group = group;
 				slots[num_slots].state = MALI_PP_SLOT_STATE_IDLE;
 				slots[num_slots].session = NULL;
+				slots[num_slots].idle_since = 0;
 				num_slots++;
 				num_slots_idle++;
 			}
@@ -167,6 +198,90 @@ static mali_bool mali_pp_scheduler_session_has_running_jobs(struct mali_session_
 	return MALI_FALSE;
 }
 
+static void mali_pp_scheduler_stats_job_queued(struct mali_pp_job *job)
+{
+	MALI_ASSERT_PP_SCHEDULER_LOCKED();
+
+	if (stats_session != mali_pp_job_get_session(job) ||
+	    stats_frame_builder_id != mali_pp_job_get_frame_builder_id(job) ||
+	    stats_flush_id != mali_pp_job_get_flush_id(job))
+	{
+		stats_session = mali_pp_job_get_session(job);
+		stats_frame_builder_id = mali_pp_job_get_frame_builder_id(job);
+		stats_flush_id = mali_pp_job_get_flush_id(job);
+		stats.frames++;
+		stats.frame_jobs = 0;
+	}
+
+	stats.frame_jobs++;
+	stats.jobs++;
+	if (stats.frame_jobs > stats.max_frame_jobs)
+	{
+		stats.max_frame_jobs = stats.frame_jobs;
+	}
+}
+
+static _mali_osk_errcode_t mali_pp_scheduler_start_sub_job(u32 i, struct mali_pp_job *job, u32 sub_job)
+{
+	u64 now;
+
+	MALI_ASSERT_PP_SCHEDULER_LOCKED();
+
+	MALI_DEBUG_PRINT(4, ("Mali PP scheduler: Starting job %u (0x%08X) part %u/%u\n", mali_pp_job_get_id(job), job, sub_job + 1, mali_pp_job_get_sub_job_count(job)));
+	if (_MALI_OSK_ERR_OK != mali_group_start_pp_job(slots[i].group, job, sub_job))
+	{
+		MALI_DEBUG_PRINT(3, ("Mali PP scheduler: Failed to start PP job\n"));
+		return _MALI_OSK_ERR_FAULT;
+	}
+
+	MALI_DEBUG_PRINT(4, ("Mali PP scheduler: Job %u (0x%08X) part %u/%u started\n", mali_pp_job_get_id(job), job, sub_job + 1, mali_pp_job_get_sub_job_count(job)));
+
+	now = _mali_osk_time_get_ns();
+	if (0 == sub_job)
+	{
+		u64 latency = now - job->queue_time;
+
+		stats.starts++;
+		stats.total_start_latency += latency;
+		if (latency > stats.max_start_latency)
+		{
+			stats.max_start_latency = latency;
+		}
+	}
+	if (0 != slots[i].idle_since)
+	{
+		u64 gap = now - slots[i].idle_since;
+
+		stats.idle_gaps++;
+		stats.total_idle_gap += gap;
+		if (gap > stats.max_idle_gap)
+		{
+			stats.max_idle_gap = gap;
+		}
+		slots[i].idle_since = 0;
+	}
+
+	/* Mark this sub job as started */
+	mali_pp_job_mark_sub_job_started(job, sub_job);
+
+	/* Mark slot as busy */
+	slots[i].state = MALI_PP_SLOT_STATE_WORKING;
+	slots[i].session =  mali_pp_job_get_session(job);
+	num_slots_idle--;
+
+	if (!mali_pp_job_has_unstarted_sub_jobs(job))
+	{
+		/*
+		* All sub jobs have now started for this job, remove this job from the job queue.
+		* The job will now only be referred to by the slots which are running it.
+		* The last slot to complete will make sure it is returned to user space.
+		*/
+		_mali_osk_list_del(&job->list);
+	}
+
+	return _MALI_OSK_ERR_OK;
+}
+
 static void mali_pp_scheduler_schedule(void)
 {
 	u32 i;
@@ -260,38 +375,18 @@ static void mali_pp_scheduler_schedule(void)
 
 		sub_job = mali_pp_job_get_first_unstarted_sub_job(job);
 
-		MALI_DEBUG_PRINT(4, ("Mali PP scheduler: Starting job %u (0x%08X) part %u/%u\n", mali_pp_job_get_id(job), job, sub_job + 1, mali_pp_job_get_sub_job_count(job)));
-		if (_MALI_OSK_ERR_OK == mali_group_start_pp_job(slots[i].group, job, sub_job))
+		if (_MALI_OSK_ERR_OK != mali_pp_scheduler_start_sub_job(i, job, sub_job))
 		{
-			MALI_DEBUG_PRINT(4, ("Mali PP scheduler: Job %u (0x%08X) part %u/%u started\n", mali_pp_job_get_id(job), job, sub_job + 1, mali_pp_job_get_sub_job_count(job)));
-
-			/* Mark this sub job as started */
-			mali_pp_job_mark_sub_job_started(job, sub_job);
-
-			/* Mark slot as busy */
-			slots[i].state = MALI_PP_SLOT_STATE_WORKING;
-			slots[i].session =  mali_pp_job_get_session(job);
-			num_slots_idle--;
+			return;
+		}
 
-			if (!mali_pp_job_has_unstarted_sub_jobs(job))
-			{
-				/*
-				* All sub jobs have now started for this job, remove this job from the job queue.
-				* The job will now only be referred to by the slots which are running it.
-				* The last slot to complete will make sure it is returned to user space.
-				*/
-				_mali_osk_list_del(&job->list);
 #if MALI_PP_SCHEDULER_FORCE_NO_JOB_OVERLAP
-				MALI_DEBUG_PRINT(6, ("Mali PP scheduler: Skip scheduling more jobs when MALI_PP_SCHEDULER_FORCE_NO_JOB_OVERLAP is set.\n"));
-				return;
-#endif
-			}
-		}
-		else
+		if (!mali_pp_job_has_unstarted_sub_jobs(job))
 		{
-			MALI_DEBUG_PRINT(3, ("Mali PP scheduler: Failed to start PP job\n"));
+			MALI_DEBUG_PRINT(6, ("Mali PP scheduler: Skip scheduling more jobs when MALI_PP_SCHEDULER_FORCE_NO_JOB_OVERLAP is set.\n"));
 			return;
 		}
+#endif
 	}
 }
 
@@ -347,6 +442,7 @@ void mali_pp_scheduler_do_schedule(void)
 void mali_pp_scheduler_job_done(struct mali_group *group, struct mali_pp_job *job, u32 sub_job, mali_bool success)
 {
 	u32 i;
+	u32 slot_done = num_slots;
 	mali_bool job_is_done;
 
 	MALI_DEBUG_PRINT(3, ("Mali PP scheduler: Job %u (0x%08X) part %u/%u completed (%s)\n", mali_pp_job_get_id(job), job, sub_job + 1, mali_pp_job_get_sub_job_count(job), success ? "success" : "failure"));
@@ -363,6 +459,25 @@ void mali_pp_scheduler_job_done(struct mali_group *group, struct mali_pp_job *jo
 			slots[i].session = NULL;
 			num_slots_idle++;
 			mali_pp_job_mark_sub_job_completed(job, success);
+			if (!_mali_osk_list_empty(&job_queue))
+			{
+				slots[i].idle_since = _mali_osk_time_get_ns();
+			}
+			slot_done = i;
+		}
+	}
+
+	/*
+	 * A job with unstarted sub jobs is at the head of the queue, and has
+	 * already passed its barrier, so its next sub job can go straight onto
+	 * the core that just finished.
+	 */
+	if (0 == pause_count && mali_pp_scheduler_batch_sub_jobs &&
+	    slot_done < num_slots && mali_pp_job_has_unstarted_sub_jobs(job))
+	{
+		if (_MALI_OSK_ERR_OK == mali_pp_scheduler_start_sub_job(slot_done, job, mali_pp_job_get_first_unstarted_sub_job(job)))
+		{
+			stats.batched_sub_jobs++;
 		}
 	}
 
@@ -453,7 +568,9 @@ _mali_osk_errcode_t _mali_ukk_pp_start_job(_mali_uk_pp_start_job_s *args)
 
 	mali_pp_scheduler_lock();
 
+	job->queue_time = _mali_osk_time_get_ns();
 	_mali_osk_list_addtail(&job->list, &job_queue);
+	mali_pp_scheduler_stats_job_queued(job);
 
 	MALI_DEBUG_PRINT(3, ("Mali PP scheduler: Job %u (0x%08X) with %u parts queued\n", mali_pp_job_get_id(job), job, mali_pp_job_get_sub_job_count(job)));
 
@@ -594,3 +711,37 @@ u32 mali_pp_scheduler_dump_state(char *buf, u32 size)
 	return n;
 }
 #endif
+
+u32 mali_pp_scheduler_dump_stats(char *buf, u32 size)
+{
+	struct mali_pp_scheduler_stats s;
+
+	mali_pp_scheduler_lock();
+	s = stats;
+	mali_pp_scheduler_unlock();
+
+	return _mali_osk_snprintf(buf, size,
+	                          "frames: %u\n"
+	                          "jobs: %u\n"
+	                          "jobs per frame: avg %u max %u\n"
+	                          "batched sub jobs: %u\n"
+	                          "start latency (us): avg %llu max %llu\n"
+	                          "idle gaps: %u\n"
+	                          "idle gap (us): avg %llu max %llu\n",
+	                          s.frames, s.jobs,
+	                          s.frames ? s.jobs / s.frames : 0, s.max_frame_jobs,
+	                          s.batched_sub_jobs,
+	                          _mali_osk_div_u64(_mali_osk_div_u64(s.total_start_latency, s.starts ? s.starts : 1), 1000),
+	                          _mali_osk_div_u64(s.max_start_latency, 1000),
+	                          s.idle_gaps,
+	                          _mali_osk_div_u64(_mali_osk_div_u64(s.total_idle_gap, s.idle_gaps ? s.idle_gaps : 1), 1000),
+	                          _mali_osk_div_u64(s.max_idle_gap, 1000));
+}
+
+void mali_pp_scheduler_reset_stats(void)
+{
+	mali_pp_scheduler_lock();
+	_mali_osk_memset(&stats, 0, sizeof(stats));
+	stats_session = NULL;
+	mali_pp_scheduler_unlock();
+}
@@ -35,4 +35,18 @@ void mali_pp_scheduler_abort_session(struct mali_session_data *session);
 
 u32 mali_pp_scheduler_dump_state(char *buf, u32 size);
 
+/** @brief Print the PP scheduler statistics
+ *
+ * Jobs per frame, time from queueing a job until its first sub job starts,
+ * and time a core is left idle between sub jobs while work is queued.
+ *
+ * @param buf Buffer to print to
+ * @param size Size of the buffer
+ * @return Number of characters printed
+ */
+u32 mali_pp_scheduler_dump_stats(char *buf, u32 size);
+
+/** @brief Clear the PP scheduler statistics */
+void mali_pp_scheduler_reset_stats(void);
+
 #endif /* __MALI_PP_SCHEDULER_H__ */
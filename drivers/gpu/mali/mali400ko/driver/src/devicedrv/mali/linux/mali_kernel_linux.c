@@ -31,8 +31,8 @@
 #include "mali_kernel_license.h"
 #include "mali_dma_buf.h"
 
-/* Streamline support for the Mali driver */
-#if defined(CONFIG_TRACEPOINTS) && MALI_TIMELINE_PROFILING_ENABLED
+/* Streamline support for the Mali driver, and the job tracepoints */
+#if defined(CONFIG_TRACEPOINTS)
 /* Ask Linux to create the tracepoints */
 #define CREATE_TRACE_POINTS
 #include "mali_linux_trace.h"
@@ -92,6 +92,10 @@ extern bool mali_pp_scheduler_balance_jobs;
 module_param(mali_pp_scheduler_balance_jobs, bool, S_IRUSR | S_IWUSR | S_IWGRP | S_IRGRP | S_IROTH);
 MODULE_PARM_DESC(mali_pp_scheduler_balance_jobs, "Mali PP forces balance jobs at starts");
 
+extern bool mali_pp_scheduler_batch_sub_jobs;
+module_param(mali_pp_scheduler_batch_sub_jobs, bool, S_IRUSR | S_IWUSR | S_IWGRP | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(mali_pp_scheduler_batch_sub_jobs, "Mali PP starts the next sub job from the completion of the previous one");
+
 extern int mali_oskmem_allocorder;
 module_param(mali_oskmem_allocorder, int, S_IRUSR | S_IWUSR | S_IWGRP | S_IRGRP | S_IROTH);
 MODULE_PARM_DESC(mali_utilization_sampling_rate, "Mali OS kernel memory allocation order");
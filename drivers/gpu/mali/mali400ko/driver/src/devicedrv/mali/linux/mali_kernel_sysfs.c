@@ -39,6 +39,7 @@
 #include "mali_group.h"
 #include "mali_gp.h"
 #include "mali_pp.h"
+#include "mali_pp_scheduler.h"
 #include "mali_l2_cache.h"
 #include "mali_hw_core.h"
 #include "mali_kernel_core.h"
@@ -972,6 +973,29 @@ static const struct file_operations memory_usage_fops = {
 	.read = memory_used_read,
 };
 
+static ssize_t pp_scheduler_stats_read(struct file *filp, char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	char buf[256];
+	size_t r;
+
+	r = mali_pp_scheduler_dump_stats(buf, sizeof(buf));
+	return simple_read_from_buffer(ubuf, cnt, ppos, buf, r);
+}
+
+/* Any write clears the statistics */
+static ssize_t pp_scheduler_stats_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
+{
+	mali_pp_scheduler_reset_stats();
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations pp_scheduler_stats_fops = {
+	.owner = THIS_MODULE,
+	.read = pp_scheduler_stats_read,
+	.write = pp_scheduler_stats_write,
+};
+
 
 static ssize_t user_settings_write(struct file *filp, const char __user *ubuf, size_t cnt, loff_t *ppos)
 {
@@ -1208,6 +1232,7 @@ int mali_sysfs_register(struct mali_dev *device, dev_t dev, const char *mali_dev
 			}
 
 			debugfs_create_file("memory_usage", 0400, mali_debugfs_dir, NULL, &memory_usage_fops);
+			debugfs_create_file("pp_scheduler_stats", 0600, mali_debugfs_dir, NULL, &pp_scheduler_stats_fops);
 
 #if MALI_INTERNAL_TIMELINE_PROFILING_ENABLED
 			mali_profiling_dir = debugfs_create_dir("profiling", mali_debugfs_dir);
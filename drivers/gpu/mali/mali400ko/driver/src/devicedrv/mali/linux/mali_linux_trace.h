@@ -119,6 +119,61 @@ TRACE_EVENT(mali_sw_counters,
     TP_printk("counters were %s", __entry->counters == NULL? "NULL" : "not NULL")
 );
 
+/**
+ * Define the tracepoints emitted when a job is started on a GP or PP core
+ * and when the core is done with it, whether or not the driver is built
+ * with profiling. The frame builder and flush ids tell which frame of
+ * which surface the job renders.
+ *
+ * @param pp MALI_TRUE for a PP core, MALI_FALSE for the GP.
+ * @param core_id The core the job runs on.
+ * @param job_id The kernel job id.
+ * @param pid Process ID of the submitting process.
+ * @param frame_builder_id The originating frame builder.
+ * @param flush_id The flush within the frame builder.
+ */
+DECLARE_EVENT_CLASS(mali_job,
+
+    TP_PROTO(int pp, unsigned int core_id, unsigned int job_id, pid_t pid,
+        unsigned int frame_builder_id, unsigned int flush_id),
+
+    TP_ARGS(pp, core_id, job_id, pid, frame_builder_id, flush_id),
+
+    TP_STRUCT__entry(
+        __field(int, pp)
+        __field(unsigned int, core_id)
+        __field(unsigned int, job_id)
+        __field(pid_t, pid)
+        __field(unsigned int, frame_builder_id)
+        __field(unsigned int, flush_id)
+    ),
+
+    TP_fast_assign(
+        __entry->pp = pp;
+        __entry->core_id = core_id;
+        __entry->job_id = job_id;
+        __entry->pid = pid;
+        __entry->frame_builder_id = frame_builder_id;
+        __entry->flush_id = flush_id;
+    ),
+
+    TP_printk("core=%s%u job=%u pid=%d frame_builder=%u flush=%u",
+        __entry->pp ? "pp" : "gp", __entry->core_id, __entry->job_id,
+        __entry->pid, __entry->frame_builder_id, __entry->flush_id)
+);
+
+DEFINE_EVENT(mali_job, mali_job_start,
+    TP_PROTO(int pp, unsigned int core_id, unsigned int job_id, pid_t pid,
+        unsigned int frame_builder_id, unsigned int flush_id),
+    TP_ARGS(pp, core_id, job_id, pid, frame_builder_id, flush_id)
+);
+
+DEFINE_EVENT(mali_job, mali_job_done,
+    TP_PROTO(int pp, unsigned int core_id, unsigned int job_id, pid_t pid,
+        unsigned int frame_builder_id, unsigned int flush_id),
+    TP_ARGS(pp, core_id, job_id, pid, frame_builder_id, flush_id)
+);
+
 #endif /* MALI_LINUX_TRACE_H */
 
 /* This part must exist outside the header guard. */
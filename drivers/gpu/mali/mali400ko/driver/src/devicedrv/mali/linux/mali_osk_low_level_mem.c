@@ -23,6 +23,8 @@
 #include <linux/mm.h>
 #include <linux/dma-mapping.h>
 #include <linux/spinlock.h>
+#include <linux/highmem.h>
+#include <linux/workqueue.h>
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3,1,0)
 #include <linux/shrinker.h>
 #endif
@@ -85,16 +87,26 @@ static void _allocation_list_item_release(AllocationList * item);
 
 /* Variable declarations */
 static DEFINE_SPINLOCK(allocation_list_spinlock);
+/* Pages ready for use: zeroed and flushed from the CPU caches */
 static AllocationList * pre_allocated_memory = (AllocationList*) NULL ;
 static int pre_allocated_memory_size_current  = 0;
+/* Released pages, waiting for mali_mem_zero_work to zero them */
+static AllocationList * dirty_memory = (AllocationList*) NULL ;
+static int dirty_memory_size_current  = 0;
 #ifdef MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_MB
 	static int pre_allocated_memory_size_max      = MALI_OS_MEMORY_KERNEL_BUFFER_SIZE_IN_MB * 1024 * 1024;
 #else
 	static int pre_allocated_memory_size_max      = 16 * 1024 * 1024; /* 6 MiB */
 #endif
+static int pre_allocated_memory_block_order = 4;
 
 module_param(pre_allocated_memory_size_max, int, S_IRUSR | S_IWUSR | S_IWGRP | S_IRGRP | S_IROTH);
 MODULE_PARM_DESC(pre_allocated_memory_size_max, "Mali pre-allocated kernel memory size");
+module_param(pre_allocated_memory_block_order, int, S_IRUSR | S_IWUSR | S_IWGRP | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(pre_allocated_memory_block_order, "Order of the blocks the Mali page pool is refilled with, 0 for single pages");
+
+static void mali_mem_zero(struct work_struct *work);
+static DECLARE_WORK(mali_mem_zero_work, mali_mem_zero);
 
 static struct vm_operations_struct mali_kernel_vm_ops =
 {
@@ -127,10 +139,10 @@ static int mali_mem_shrink(struct shrinker *shrinker, struct shrink_control *sc)
 
 	if (0 == nr)
 	{
-		return pre_allocated_memory_size_current / PAGE_SIZE;
+		return (pre_allocated_memory_size_current + dirty_memory_size_current) / PAGE_SIZE;
 	}
 
-	if (0 == pre_allocated_memory_size_current)
+	if (0 == pre_allocated_memory_size_current + dirty_memory_size_current)
 	{
 		/* No pages availble */
 		return 0;
@@ -142,6 +154,19 @@ static int mali_mem_shrink(struct shrinker *shrinker, struct shrink_control *sc)
 		return -1;
 	}
 
+	/* Dirty pages first, they would cost zeroing to be used */
+	while (dirty_memory && nr > 0)
+	{
+		item = dirty_memory;
+		dirty_memory = item->next;
+
+		_kernel_page_release(item->physaddr);
+		_mali_osk_free(item);
+
+		dirty_memory_size_current -= PAGE_SIZE;
+		--nr;
+	}
+
 	while (pre_allocated_memory && nr > 0)
 	{
 		item = pre_allocated_memory;
@@ -155,7 +180,7 @@ static int mali_mem_shrink(struct shrinker *shrinker, struct shrink_control *sc)
 	}
 	spin_unlock_irqrestore(&allocation_list_spinlock,flags);
 
-	return pre_allocated_memory_size_current / PAGE_SIZE;
+	return (pre_allocated_memory_size_current + dirty_memory_size_current) / PAGE_SIZE;
 }
 
 struct shrinker mali_mem_shrinker = {
@@ -173,6 +198,17 @@ void mali_osk_low_level_mem_init(void)
 void mali_osk_low_level_mem_term(void)
 {
 	unregister_shrinker(&mali_mem_shrinker);
+	cancel_work_sync(&mali_mem_zero_work);
+
+	while ( NULL != dirty_memory )
+	{
+		AllocationList *item;
+		item = dirty_memory;
+		dirty_memory = item->next;
+		_kernel_page_release(item->physaddr);
+		_mali_osk_free( item );
+	}
+	dirty_memory_size_current  = 0;
 
 	while ( NULL != pre_allocated_memory )
 	{
@@ -216,7 +252,62 @@ static void _kernel_page_release(u32 physical_address)
 	__free_page( unmap_page );
 }
 
-static AllocationList * _allocation_list_item_get(void)
+/*
+ * Refills the pool with the pages of one higher order block, split so that
+ * each of them is released on its own. Fewer, larger requests to the buddy
+ * allocator, and physically contiguous runs of Mali pages.
+ */
+static void _kernel_page_block_allocate(void)
+{
+	const int order = pre_allocated_memory_block_order;
+	AllocationList *list = NULL;
+	AllocationList *tail = NULL;
+	struct page *block;
+	unsigned long flags;
+	int i, count = 0;
+
+	block = alloc_pages(GFP_HIGHUSER | __GFP_ZERO | __GFP_NORETRY | __GFP_NOWARN | __GFP_COLD, order);
+	if ( NULL == block )
+	{
+		return;
+	}
+	split_page(block, order);
+
+	for (i = 0; i < (1 << order); i++)
+	{
+		AllocationList *item = _mali_osk_malloc( sizeof(AllocationList) );
+		if ( NULL == item )
+		{
+			break;
+		}
+
+		/* Ensure page is flushed from CPU caches. */
+		item->physaddr = dma_map_page(NULL, block + i, 0, PAGE_SIZE, DMA_BIDIRECTIONAL);
+		item->next = list;
+		list = item;
+		if ( NULL == tail ) tail = item;
+		count++;
+	}
+
+	/* The pages without a list item go back */
+	for (; i < (1 << order); i++)
+	{
+		__free_page(block + i);
+	}
+
+	if ( NULL == list )
+	{
+		return;
+	}
+
+	spin_lock_irqsave(&allocation_list_spinlock,flags);
+	tail->next = pre_allocated_memory;
+	pre_allocated_memory = list;
+	pre_allocated_memory_size_current += count * PAGE_SIZE;
+	spin_unlock_irqrestore(&allocation_list_spinlock,flags);
+}
+
+static AllocationList * _allocation_list_item_get_pooled(void)
 {
 	AllocationList *item = NULL;
 	unsigned long flags;
@@ -227,11 +318,34 @@ static AllocationList * _allocation_list_item_get(void)
 		item = pre_allocated_memory;
 		pre_allocated_memory = pre_allocated_memory->next;
 		pre_allocated_memory_size_current -= PAGE_SIZE;
+	}
+	spin_unlock_irqrestore(&allocation_list_spinlock,flags);
 
-		spin_unlock_irqrestore(&allocation_list_spinlock,flags);
+	return item;
+}
+
+static AllocationList * _allocation_list_item_get(void)
+{
+	AllocationList *item;
+
+	item = _allocation_list_item_get_pooled();
+	if ( item )
+	{
 		return item;
 	}
-	spin_unlock_irqrestore(&allocation_list_spinlock,flags);
+
+	/* Refill with a block where the pool has room for it */
+	if ( pre_allocated_memory_block_order > 0 &&
+	     pre_allocated_memory_size_current + dirty_memory_size_current +
+	     (PAGE_SIZE << pre_allocated_memory_block_order) <= pre_allocated_memory_size_max )
+	{
+		_kernel_page_block_allocate();
+		item = _allocation_list_item_get_pooled();
+		if ( item )
+		{
+			return item;
+		}
+	}
 
 	item = _mali_osk_malloc( sizeof(AllocationList) );
 	if ( NULL == item)
@@ -253,12 +367,14 @@ static void _allocation_list_item_release(AllocationList * item)
 {
 	unsigned long flags;
 	spin_lock_irqsave(&allocation_list_spinlock,flags);
-	if ( pre_allocated_memory_size_current < pre_allocated_memory_size_max)
+	if ( pre_allocated_memory_size_current + dirty_memory_size_current < pre_allocated_memory_size_max)
 	{
-		item->next = pre_allocated_memory;
-		pre_allocated_memory = item;
-		pre_allocated_memory_size_current += PAGE_SIZE;
+		/* Zeroed in the background before it is handed out again */
+		item->next = dirty_memory;
+		dirty_memory = item;
+		dirty_memory_size_current += PAGE_SIZE;
 		spin_unlock_irqrestore(&allocation_list_spinlock,flags);
+		schedule_work(&mali_mem_zero_work);
 		return;
 	}
 	spin_unlock_irqrestore(&allocation_list_spinlock,flags);
@@ -267,6 +383,44 @@ static void _allocation_list_item_release(AllocationList * item)
 	_mali_osk_free( item );
 }
 
+static void mali_mem_zero(struct work_struct *work)
+{
+	AllocationList *list, *item, *tail;
+	unsigned long flags;
+	int count;
+
+	for (;;)
+	{
+		spin_lock_irqsave(&allocation_list_spinlock,flags);
+		list = dirty_memory;
+		count = dirty_memory_size_current / PAGE_SIZE;
+		dirty_memory = NULL;
+		dirty_memory_size_current = 0;
+		spin_unlock_irqrestore(&allocation_list_spinlock,flags);
+
+		if ( NULL == list )
+		{
+			return;
+		}
+
+		for (item = list; ; item = item->next)
+		{
+			clear_highpage(pfn_to_page(item->physaddr >> PAGE_SHIFT));
+			/* The GPU must not see stale cache lines either */
+			dma_sync_single_for_device(NULL, item->physaddr, PAGE_SIZE, DMA_BIDIRECTIONAL);
+			tail = item;
+			if ( NULL == item->next ) break;
+			cond_resched();
+		}
+
+		spin_lock_irqsave(&allocation_list_spinlock,flags);
+		tail->next = pre_allocated_memory;
+		pre_allocated_memory = list;
+		pre_allocated_memory_size_current += count * PAGE_SIZE;
+		spin_unlock_irqrestore(&allocation_list_spinlock,flags);
+	}
+}
+
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,26)
 static int mali_kernel_memory_cpu_page_fault_handler(struct vm_area_struct *vma, struct vm_fault *vmf)
@@ -15,8 +15,14 @@
 
 #include "mali_osk.h"
 #include <linux/bitops.h>
+#include <linux/math64.h>
 
 u32 inline _mali_osk_clz( u32 input )
 {
 	return 32-fls(input);
 }
+
+u64 _mali_osk_div_u64( u64 dividend, u32 divisor )
+{
+	return div_u64(dividend, divisor);
+}
@@ -36,6 +36,10 @@ void mali_gpu_utilization_handler(u32 utilization)
 {
 }
 
+void mali_gpu_job_queue_handler(u32 depth)
+{
+}
+
 void set_mali_parent_power_domain(void* dev)
 {
 }
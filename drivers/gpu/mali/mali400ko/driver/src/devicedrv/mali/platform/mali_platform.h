@@ -66,6 +66,15 @@ _mali_osk_errcode_t mali_platform_power_mode_change(mali_power_mode power_mode);
  */
 void mali_gpu_utilization_handler(u32 utilization);
 
+/** @brief Platform specific handling of queued GP jobs
+ *
+ * Called when a GP job is queued and has to wait for the GP core, so that
+ * the platform can raise the clocks before the utilization data shows it.
+ *
+ * @param depth The number of GP jobs waiting to be started.
+ */
+void mali_gpu_job_queue_handler(u32 depth);
+
 /** @brief Setting the power domain of MALI
  *
  * This function sets the power domain of MALI if Linux run time power management is enabled
@@ -45,6 +45,9 @@
 
 #define MALI_MAX_UTILIZATION		256
 
+/* GP jobs waiting for the core before APE_100_OPP is requested up front */
+#define MALI_QUEUE_BOOST_DEPTH		2
+
 #define PRCMU_SGACLK			0x0014
 #define PRCMU_PLLSOC0			0x0080
 
@@ -110,8 +113,18 @@ module_param(mali_last_utilization, uint, 0444);
 static struct regulator *regulator;
 static struct clk *clk_sga;
 static struct work_struct mali_utilization_work;
+static struct work_struct mali_queue_boost_work;
 static struct workqueue_struct *mali_utilization_workqueue;
 
+/*By default, platform start with 50% APE OPP and 25% DDR OPP*/
+static u32 has_requested_low = 1;
+
+static u32 queue_boost_depth = MALI_QUEUE_BOOST_DEPTH;
+/* When the queue last requested APE_100_OPP */
+static unsigned long queue_boost_jiffies;
+
+extern int mali_utilization_sampling_rate;
+
 #if CONFIG_HAS_WAKELOCK
 static struct wake_lock wakelock;
 #endif
@@ -303,6 +316,45 @@ error:
 	MALI_ERROR(_MALI_OSK_ERR_FAULT);
 }
 
+static void mali_request_high(void)
+{
+	/*Request 100% APE_OPP.*/
+	prcmu_qos_update_requirement(PRCMU_QOS_APE_OPP, "mali", PRCMU_QOS_MAX_VALUE);
+	/*
+	* Since the utilization values will be reported higher
+	* if DDR_OPP is lowered, we also request 100% DDR_OPP.
+	*/
+	prcmu_qos_update_requirement(PRCMU_QOS_DDR_OPP, "mali", PRCMU_QOS_MAX_VALUE);
+	has_requested_low = 0;
+}
+
+/*
+ * The utilization is sampled over a whole period, so a load ramping up is
+ * seen late. A deepening GP job queue requests APE_100_OPP right away, and
+ * the request is held until a sample is taken entirely after the boost, the
+ * first one still covers the time before it.
+ */
+static void mali_queue_boost_function(struct work_struct *ptr)
+{
+	mutex_lock(&mali_boost_lock);
+	if (has_requested_low) {
+		MALI_DEBUG_PRINT(5, ("MALI GP queue boost\n"));
+		mali_request_high();
+		queue_boost_jiffies = jiffies ? jiffies : 1;
+	}
+	mutex_unlock(&mali_boost_lock);
+}
+
+static bool mali_queue_boost_held(void)
+{
+	if (queue_boost_jiffies && time_before(jiffies, queue_boost_jiffies +
+			msecs_to_jiffies(2 * mali_utilization_sampling_rate)))
+		return true;
+
+	queue_boost_jiffies = 0;
+	return false;
+}
+
 /* Rationale behind the values for: (switching between APE_50_OPP and APE_100_OPP)
 * MALI_HIGH_LEVEL_UTILIZATION_LIMIT and MALI_LOW_LEVEL_UTILIZATION_LIMIT
 * When operating at half clock frequency a faster clock is requested when
@@ -336,9 +388,6 @@ error:
  */
 void mali_utilization_function(struct work_struct *ptr)
 {
-	/*By default, platform start with 50% APE OPP and 25% DDR OPP*/
-	static u32 has_requested_low = 1;
-
 	MALI_DEBUG_PRINT(5, ("MALI GPU utilization: %u\n", mali_last_utilization));
 
 	mutex_lock(&mali_boost_lock);
@@ -355,19 +404,13 @@ void mali_utilization_function(struct work_struct *ptr)
 		if (mali_last_utilization >= up_threshold) {
 			if (has_requested_low) {
 				MALI_DEBUG_PRINT(5, ("MALI GPU utilization: %u SIGNAL_HIGH\n", mali_last_utilization));
-				/*Request 100% APE_OPP.*/
-				prcmu_qos_update_requirement(PRCMU_QOS_APE_OPP, "mali", PRCMU_QOS_MAX_VALUE);
-				/*
-				* Since the utilization values will be reported higher
-				* if DDR_OPP is lowered, we also request 100% DDR_OPP.
-				*/
-				prcmu_qos_update_requirement(PRCMU_QOS_DDR_OPP, "mali", PRCMU_QOS_MAX_VALUE);
-				has_requested_low = 0;
+				mali_request_high();
 				mutex_unlock(&mali_boost_lock);
 				return;		//After we switch to APE_100_OPP we want to measure utilization once again before entering boost logic
 			}
 		} else {
-			if (mali_last_utilization < mali_utilization_high_to_low) {
+			if (mali_last_utilization < mali_utilization_high_to_low &&
+			    !mali_queue_boost_held()) {
 				if (!has_requested_low) {
 					/*Remove APE_OPP and DDR_OPP requests*/
 					prcmu_qos_update_requirement(PRCMU_QOS_DDR_OPP, "mali", PRCMU_QOS_DEFAULT_VALUE);
@@ -412,6 +455,13 @@ void mali_utilization_function(struct work_struct *ptr)
 
 }
 
+void mali_gpu_job_queue_handler(u32 depth)
+{
+	/* Called with the GP scheduler lock held, defer to the workqueue */
+	if (queue_boost_depth && depth >= queue_boost_depth && has_requested_low)
+		queue_work(mali_utilization_workqueue, &mali_queue_boost_work);
+}
+
 int get_mali_workload(void)
 {
 	return mali_last_utilization * sgaclk_freq() / 256; 
@@ -601,6 +651,24 @@ static ssize_t mali_boost_delay_store(struct kobject *kobj, struct kobj_attribut
 }
 ATTR_RW(mali_boost_delay);
 
+static ssize_t mali_queue_boost_depth_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", queue_boost_depth);
+}
+
+static ssize_t mali_queue_boost_depth_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	int val;
+
+	if (sscanf(buf, "%u", &val)) {
+		/* 0 disables */
+		queue_boost_depth = val;
+	}
+
+	return count;
+}
+ATTR_RW(mali_queue_boost_depth);
+
 static ssize_t mali_boost_low_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
 {
 	sprintf(buf, "%sDOWNthreshold: %u\n", buf, boost_downthreshold);
@@ -770,6 +838,7 @@ static struct attribute *mali_attrs[] = {
 	&mali_gpu_vape_50_opp_interface.attr,
 	&mali_auto_boost_interface.attr, 
 	&mali_boost_delay_interface.attr, 
+	&mali_queue_boost_depth_interface.attr,
 	&mali_boost_low_interface.attr, 
 	&mali_boost_high_interface.attr, 
 	&mali_dvfs_config_interface.attr, 
@@ -804,6 +873,7 @@ _mali_osk_errcode_t mali_platform_init()
 		}
 
 		INIT_WORK(&mali_utilization_work, mali_utilization_function);
+		INIT_WORK(&mali_queue_boost_work, mali_queue_boost_function);
 		//TODO register a notifier block with prcmu opp update func to monitor ape opp
 		INIT_DELAYED_WORK(&mali_boost_delayedwork, mali_boost_work);
 
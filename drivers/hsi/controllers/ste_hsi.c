@@ -24,6 +24,13 @@
 
 #include <mach/hsi.h>
 
+/*
+ * Scatterlist entries of one DMA transfer. A message of up to this many
+ * entries is taken by the DMA path, and TX messages queued behind each other
+ * on a channel are sent in one transfer up to this many entries in all.
+ */
+#define STE_HSI_DMA_MAX_SG	8
+
 /*
  * Copy of HSIR/HSIT context for restoring after HW reset (Vape power off).
  */
@@ -79,10 +86,22 @@ struct ste_hsi_controller {
 };
 
 #ifdef CONFIG_STE_DMA40
+/**
+ * struct ste_hsi_channel_dma - DMA of one HSI channel and direction
+ * @dma_chan: DMA engine channel
+ * @desc: descriptor of the transfer in progress
+ * @cookie: cookie of the transfer in progress
+ * @sg: scatterlist of the messages of the transfer
+ * @sg_len: number of entries used in @sg
+ * @nr_msgs: number of messages, at the head of the queue, in the transfer
+ */
 struct ste_hsi_channel_dma {
 	struct dma_chan *dma_chan;
 	struct dma_async_tx_descriptor *desc;
 	dma_cookie_t cookie;
+	struct scatterlist sg[STE_HSI_DMA_MAX_SG];
+	unsigned int sg_len;
+	unsigned int nr_msgs;
 };
 #endif
 
@@ -473,6 +492,18 @@ static int ste_hsi_start_irq(struct hsi_msg *msg)
 static int ste_hsi_start_transfer(struct ste_hsi_port *ste_port,
 				  struct list_head *queue);
 #ifdef CONFIG_STE_DMA40
+static unsigned int ste_hsi_msg_len(struct hsi_msg *msg)
+{
+	struct scatterlist *sg;
+	unsigned int len = 0;
+	int i;
+
+	for_each_sg(msg->sgt.sgl, sg, msg->sgt.nents, i)
+		len += sg->length;
+
+	return len;
+}
+
 static void ste_hsi_dma_callback(void *dma_async_param)
 {
 	struct hsi_msg *msg = dma_async_param;
@@ -480,15 +511,16 @@ static void ste_hsi_dma_callback(void *dma_async_param)
 	struct ste_hsi_port *ste_port = client_to_ste_port(msg->cl);
 	struct ste_hsi_controller *ste_hsi = client_to_ste_controller(msg->cl);
 	struct list_head *queue;
-	struct dma_chan *chan;
+	struct hsi_msg *tmp;
 	struct ste_hsi_channel_dma *hsi_dma_chan;
 	char *dma_enable_address;
 	enum dma_data_direction direction;
+	unsigned int i;
 	u32 dma_mask;
+	LIST_HEAD(done);
 
-	/* Message finished, remove from list and notify client */
+	/* Messages finished, remove from list and notify clients */
 	spin_lock_bh(&ste_hsi->lock);
-	list_del(&msg->link);
 
 	if (msg->ttype == HSI_MSG_WRITE) {
 		queue = &ste_port->txqueue[msg->channel];
@@ -502,9 +534,8 @@ static void ste_hsi_dma_callback(void *dma_async_param)
 		hsi_dma_chan = &ste_port->rx_dma[msg->channel];
 	}
 
-	dma_sync_sg_for_cpu(&hsi->device, msg->sgt.sgl,
-			    msg->sgt.nents, direction);
-	chan = hsi_dma_chan->dma_chan;
+	dma_sync_sg_for_cpu(&hsi->device, hsi_dma_chan->sg,
+			    hsi_dma_chan->sg_len, direction);
 
 	/* disable DMA channel on HSI controller */
 	dma_mask = readl(dma_enable_address);
@@ -512,17 +543,28 @@ static void ste_hsi_dma_callback(void *dma_async_param)
 
 	hsi_dma_chan->desc = NULL;
 
-	dma_unmap_sg(&hsi->device, msg->sgt.sgl, msg->sgt.nents, direction);
+	dma_unmap_sg(&hsi->device, hsi_dma_chan->sg, hsi_dma_chan->sg_len,
+		     direction);
 
-	msg->status = HSI_STATUS_COMPLETED;
-	msg->actual_len = sg_dma_len(msg->sgt.sgl);
+	/* The messages of the transfer are the ones at the head of the queue */
+	for (i = 0; i < hsi_dma_chan->nr_msgs && !list_empty(queue); i++) {
+		tmp = list_first_entry(queue, struct hsi_msg, link);
+		tmp->status = HSI_STATUS_COMPLETED;
+		tmp->actual_len = ste_hsi_msg_len(tmp);
+		list_move_tail(&tmp->link, &done);
+	}
+	hsi_dma_chan->nr_msgs = 0;
 
 	spin_unlock_bh(&ste_hsi->lock);
 
-	msg->complete(msg);
+	list_for_each_entry_safe(msg, tmp, &done, link) {
+		list_del(&msg->link);
+		msg->complete(msg);
+	}
 
 	ste_hsi_clock_disable(hsi);
 
+	/* TX messages queued meanwhile go in the next transfer */
 	spin_lock_bh(&ste_hsi->lock);
 	ste_hsi_start_transfer(ste_port, queue);
 	spin_unlock_bh(&ste_hsi->lock);
@@ -561,10 +603,15 @@ static int ste_hsi_start_dma(struct hsi_msg *msg)
 	struct dma_async_tx_descriptor *desc;
 	struct dma_chan *chan;
 	struct ste_hsi_channel_dma *hsi_dma_chan;
+	struct list_head *queue;
+	struct hsi_msg *next;
+	struct scatterlist *sg;
 	char *dma_enable_address;
 	enum dma_data_direction direction;
 	u32 dma_mask;
+	int nents;
 	int err;
+	int i;
 
 	err = ste_hsi_clock_enable(hsi);
 	if (unlikely(err))
@@ -573,11 +620,13 @@ static int ste_hsi_start_dma(struct hsi_msg *msg)
 	ste_hsi_context(ste_hsi);
 
 	if (msg->ttype == HSI_MSG_WRITE) {
+		queue = &ste_port->txqueue[msg->channel];
 		direction = DMA_TO_DEVICE;
 		dma_enable_address = ste_hsi->tx_base + STE_HSI_TX_DMAEN;
 		hsi_dma_chan = &ste_port->tx_dma[msg->channel];
 	} else {
 		u32 val;
+		queue = &ste_port->rxqueue[msg->channel];
 		direction = DMA_FROM_DEVICE;
 		dma_enable_address = ste_hsi->rx_base + STE_HSI_RX_DMAEN;
 		hsi_dma_chan = &ste_port->rx_dma[msg->channel];
@@ -590,27 +639,53 @@ static int ste_hsi_start_dma(struct hsi_msg *msg)
 
 	chan = hsi_dma_chan->dma_chan;
 
-	if (0 == dma_map_sg(&hsi->device, msg->sgt.sgl, msg->sgt.nents,
-			    direction)) {
+	/*
+	 * Gather the queued messages into one transfer. A read completes only
+	 * when its buffer is full, so reads are not gathered: the first one
+	 * would wait for data meant for the next ones.
+	 */
+	sg_init_table(hsi_dma_chan->sg, STE_HSI_DMA_MAX_SG);
+	hsi_dma_chan->sg_len = 0;
+	hsi_dma_chan->nr_msgs = 0;
+	next = msg;
+	list_for_each_entry_from(next, queue, link) {
+		if (next != msg && (direction == DMA_FROM_DEVICE ||
+				    next->status != HSI_STATUS_QUEUED))
+			break;
+		if (hsi_dma_chan->sg_len + next->sgt.nents > STE_HSI_DMA_MAX_SG)
+			break;
+
+		for_each_sg(next->sgt.sgl, sg, next->sgt.nents, i)
+			sg_set_page(&hsi_dma_chan->sg[hsi_dma_chan->sg_len++],
+				    sg_page(sg), sg->length, sg->offset);
+		next->actual_len = 0;
+		next->status = HSI_STATUS_PROCEEDING;
+		hsi_dma_chan->nr_msgs++;
+	}
+	sg_mark_end(&hsi_dma_chan->sg[hsi_dma_chan->sg_len - 1]);
+
+	nents = dma_map_sg(&hsi->device, hsi_dma_chan->sg,
+			   hsi_dma_chan->sg_len, direction);
+	if (0 == nents) {
 		dev_dbg(&hsi->device, "DMA map SG failed !\n");
 		err = -ENOMEM;
-		goto out;
+		goto requeue;
 	}
 	/* Prepare the scatterlist */
 	desc = chan->device->device_prep_slave_sg(chan,
-						  msg->sgt.sgl,
-						  msg->sgt.nents,
+						  hsi_dma_chan->sg,
+						  nents,
 						  direction,
 						  DMA_PREP_INTERRUPT |
 						  DMA_CTRL_ACK);
 
 	if (!desc) {
-		dma_unmap_sg(&hsi->device, msg->sgt.sgl, msg->sgt.nents,
-			     direction);
+		dma_unmap_sg(&hsi->device, hsi_dma_chan->sg,
+			     hsi_dma_chan->sg_len, direction);
 		/* "Complete" DMA (errorpath) */
 		ste_hsi_terminate_dma_chan(hsi_dma_chan);
 		err = -EBUSY;
-		goto out;
+		goto requeue;
 	}
 	desc->callback = ste_hsi_dma_callback;
 	desc->callback_param = msg;
@@ -624,9 +699,18 @@ static int ste_hsi_start_dma(struct hsi_msg *msg)
 	dma_mask = readl(dma_enable_address);
 	writel(dma_mask | 1 << msg->channel, dma_enable_address);
 
-out:
-	if (unlikely(err))
-		ste_hsi_clock_disable(hsi);
+	return 0;
+
+requeue:
+	/* The messages gathered behind the first are started again later */
+	next = msg;
+	list_for_each_entry_continue(next, queue, link) {
+		if (--hsi_dma_chan->nr_msgs == 0)
+			break;
+		next->status = HSI_STATUS_QUEUED;
+	}
+	hsi_dma_chan->nr_msgs = 0;
+	ste_hsi_clock_disable(hsi);
 
 	return err;
 }
@@ -1311,15 +1395,16 @@ static int ste_hsi_async(struct hsi_msg *msg)
 	if (unlikely(!msg))
 		return -ENOSYS;
 
-	if (msg->sgt.nents > 1)
-		return -ENOSYS;
-
 	if (unlikely(msg->break_frame))
 		return ste_hsi_async_break(msg);
 
 	ste_port = client_to_ste_port(msg->cl);
 	ste_hsi = client_to_ste_controller(msg->cl);
 
+	/* Only the DMA path handles a scatterlist of several entries */
+	if (msg->sgt.nents > (ste_hsi->use_dma ? STE_HSI_DMA_MAX_SG : 1))
+		return -ENOSYS;
+
 	if (msg->ttype == HSI_MSG_WRITE) {
 		/* TX transfer */
 		BUG_ON(msg->channel >= ste_port->channels);
@@ -40,6 +40,8 @@
 
 #define DEFAULT_MONITOR_DELAY 1000
 
+static struct abx500_temp *abx500_temp_dev;
+
 /*
  * Thresholds are considered inactive if set to 0.
  * To avoid confusion for user space applications,
@@ -643,6 +645,8 @@ static int __devinit abx500_temp_probe(struct platform_device *pdev)
 		dev_err(&pdev->dev, "irq setup failed (%d)\n", err);
 		goto exit_sysfs_group;
 	}
+
+	abx500_temp_dev = data;
 	return 0;
 
 exit_sysfs_group:
@@ -660,6 +664,7 @@ static int __devexit abx500_temp_remove(struct platform_device *pdev)
 {
 	struct abx500_temp *data = platform_get_drvdata(pdev);
 
+	abx500_temp_dev = NULL;
 	gpadc_monitor_exit(data);
 	hwmon_device_unregister(data->hwmon_dev);
 	sysfs_remove_group(&pdev->dev.kobj, &abx500_temp_group);
@@ -669,6 +674,27 @@ static int __devexit abx500_temp_remove(struct platform_device *pdev)
 	return 0;
 }
 
+/**
+ * abx500_temp_read - read a monitored sensor for in-kernel users
+ * @index: hwmon index of the sensor, 1 for temp1_input
+ * @val: the value of temp<index>_input, in the same unit
+ *
+ * Returns 0 or a negative error code.
+ */
+int abx500_temp_read(int index, int *val)
+{
+	struct abx500_temp *data = abx500_temp_dev;
+
+	if (!data)
+		return -ENODEV;
+	if (index < 1 || index > data->monitored_sensors)
+		return -EINVAL;
+
+	*val = data->ops.read_sensor(data, data->gpadc_addr[index - 1]);
+	return 0;
+}
+EXPORT_SYMBOL(abx500_temp_read);
+
 static int abx500_temp_suspend(struct platform_device *pdev,
 			       pm_message_t state)
 {
@@ -28,6 +28,15 @@
 /* This driver monitors DB thermal*/
 #define NUM_SENSORS 1
 
+/*
+ * A sensor without thsensor_get_temp cannot be read, it only interrupts
+ * when the temperature leaves the HOTMON window. For in-kernel users the
+ * window is kept TRACK_STEP degrees wide and moved along on each
+ * interrupt, so the temperature is known to within one step.
+ */
+#define TRACK_STEP 3
+#define TRACK_START 40
+
 struct dbx500_temp {
 	struct platform_device *pdev;
 	struct device *hwmon_dev;
@@ -39,6 +48,8 @@ struct dbx500_temp {
 	unsigned char max_alarm[NUM_SENSORS];
 	unsigned short measure_time;
 	bool monitoring_active;
+	bool tracking;
+	int track_low;
 	struct mutex lock;
 	struct dbx500_temp_ops *ops;
 	struct work_struct thermal_warning_work;
@@ -73,6 +84,16 @@ static inline void stop_temp_monitoring(struct dbx500_temp *data)
 	}
 }
 
+static struct dbx500_temp *dbx500_temp_dev;
+
+/* The caller shall hold data->lock */
+static void track_window(struct dbx500_temp *data, int low)
+{
+	data->track_low = clamp(low, 0, 0xFF - TRACK_STEP);
+	(void) data->ops->config_hotmon(data->track_low,
+					data->track_low + TRACK_STEP);
+}
+
 static void print_thermal_warning(struct work_struct *work)
 {
 	struct dbx500_temp *data = container_of(work, struct dbx500_temp,
@@ -112,12 +133,15 @@ static ssize_t set_min(struct device *dev, struct device_attribute *devattr,
 
 	data->min[attr->index - 1] = val;
 
-	stop_temp_monitoring(data);
+	/* while tracking the alarms follow from the window */
+	if (!data->tracking) {
+		stop_temp_monitoring(data);
 
-	(void) data->ops->config_hotmon(data->min[attr->index - 1],
-			data->max[attr->index - 1]);
+		(void) data->ops->config_hotmon(data->min[attr->index - 1],
+				data->max[attr->index - 1]);
 
-	start_temp_monitoring(data, (attr->index - 1));
+		start_temp_monitoring(data, (attr->index - 1));
+	}
 
 	mutex_unlock(&data->lock);
 	return count;
@@ -140,12 +164,14 @@ static ssize_t set_max(struct device *dev, struct device_attribute *devattr,
 
 	data->max[attr->index - 1] = val;
 
-	stop_temp_monitoring(data);
+	if (!data->tracking) {
+		stop_temp_monitoring(data);
 
-	(void) data->ops->config_hotmon(data->min[attr->index - 1],
-		data->max[attr->index - 1]);
+		(void) data->ops->config_hotmon(data->min[attr->index - 1],
+			data->max[attr->index - 1]);
 
-	start_temp_monitoring(data, (attr->index - 1));
+		start_temp_monitoring(data, (attr->index - 1));
+	}
 
 	mutex_unlock(&data->lock);
 
@@ -284,11 +310,23 @@ static irqreturn_t prcmu_hotmon_low_irq_handler(int irq, void *irq_data)
 {
 	struct platform_device *pdev = irq_data;
 	struct dbx500_temp *data = platform_get_drvdata(pdev);
+	bool alarm = true;
 
 	mutex_lock(&data->lock);
-	data->min_alarm[0] = 1;
+	if (data->tracking) {
+		track_window(data, data->track_low - TRACK_STEP);
+		if (data->max[0] && data->track_low + TRACK_STEP <= data->max[0])
+			data->max_alarm[0] = 0;
+		alarm = data->min[0] && !data->min_alarm[0] &&
+			data->track_low + TRACK_STEP <= data->min[0];
+	}
+	if (alarm)
+		data->min_alarm[0] = 1;
 	mutex_unlock(&data->lock);
 
+	if (!alarm)
+		return IRQ_HANDLED;
+
 	sysfs_notify(&pdev->dev.kobj, NULL, "temp1_min_alarm");
 	schedule_work(&data->thermal_warning_work);
 	return IRQ_HANDLED;
@@ -298,11 +336,23 @@ static irqreturn_t prcmu_hotmon_high_irq_handler(int irq, void *irq_data)
 {
 	struct platform_device *pdev = irq_data;
 	struct dbx500_temp *data = platform_get_drvdata(pdev);
+	bool alarm = true;
 
 	mutex_lock(&data->lock);
-	data->max_alarm[0] = 1;
+	if (data->tracking) {
+		track_window(data, data->track_low + TRACK_STEP);
+		if (data->min[0] && data->track_low >= data->min[0])
+			data->min_alarm[0] = 0;
+		alarm = data->max[0] && !data->max_alarm[0] &&
+			data->track_low >= data->max[0];
+	}
+	if (alarm)
+		data->max_alarm[0] = 1;
 	mutex_unlock(&data->lock);
 
+	if (!alarm)
+		return IRQ_HANDLED;
+
 	hwmon_notify(data->max_alarm[0], NULL);
 	sysfs_notify(&pdev->dev.kobj, NULL, "temp1_max_alarm");
 	schedule_work(&data->thermal_warning_work);
@@ -410,6 +460,7 @@ static int __devinit dbx500_temp_probe(struct platform_device *pdev)
 		goto exit_free_irq_high;
 	}
 
+	dbx500_temp_dev = data;
 	return 0;
 
 exit_free_irq_high: 
@@ -427,6 +478,7 @@ static int __devexit dbx500_temp_remove(struct platform_device *pdev)
 {
 	struct dbx500_temp *data = platform_get_drvdata(pdev);
 
+	dbx500_temp_dev = NULL;
 	hwmon_device_unregister(data->hwmon_dev);
 	sysfs_remove_group(&pdev->dev.kobj, &dbx500_temp_group);
 	if (data->ops->thsensor_get_temp)
@@ -440,6 +492,39 @@ static int __devexit dbx500_temp_remove(struct platform_device *pdev)
 	return 0;
 }
 
+/**
+ * dbx500_temp_read - the DBX500 die temperature for in-kernel users
+ *
+ * Returns degrees Celsius or a negative error code. A sensor that cannot
+ * be read is followed with the HOTMON window from the first call on, its
+ * value settles within a few measure periods.
+ */
+int dbx500_temp_read(void)
+{
+	struct dbx500_temp *data = dbx500_temp_dev;
+	int val;
+
+	if (!data)
+		return -ENODEV;
+
+	if (data->ops->thsensor_get_temp)
+		return data->ops->thsensor_get_temp();
+
+	mutex_lock(&data->lock);
+	if (!data->tracking) {
+		data->tracking = true;
+		stop_temp_monitoring(data);
+		track_window(data, TRACK_START);
+		(void) data->ops->start_temp_sense(data->measure_time);
+		data->monitoring_active = true;
+	}
+	val = data->track_low + TRACK_STEP / 2;
+	mutex_unlock(&data->lock);
+
+	return val;
+}
+EXPORT_SYMBOL(dbx500_temp_read);
+
 /* No action required in suspend/resume, thus the lack of functions */
 static struct platform_driver dbx500_temp_driver = {
 	.driver = {
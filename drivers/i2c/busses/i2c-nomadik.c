@@ -23,6 +23,9 @@
 #include <linux/io.h>
 #include <linux/regulator/consumer.h>
 #include <linux/pm_runtime.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/scatterlist.h>
 
 #include <plat/i2c.h>
 
@@ -104,6 +107,15 @@
 /* maximum threshold value */
 #define MAX_I2C_FIFO_THRESHOLD	15
 
+/*
+ * Shorter messages are moved by the FIFO interrupts, setting up a DMA
+ * transfer costs more than the few interrupts they take.
+ */
+#define NMK_I2C_DMA_THRESHOLD	32
+/* Size of the DMA bounce buffer, longer messages use interrupts */
+#define NMK_I2C_DMA_MAX_LEN	256
+#define NMK_I2C_DMA_TIMEOUT_MS	100
+
 enum i2c_status {
 	I2C_NOP,
 	I2C_ON_GOING,
@@ -148,6 +160,14 @@ struct i2c_nmk_client {
  * @result: controller propogated result.
  * @regulator: pointer to i2c regulator.
  * @busy: Busy doing transfer.
+ * @phybase: physical address of the controller registers.
+ * @dma_requested: the DMA channels have been asked for.
+ * @dma_rx: DMA channel reading the Rx FIFO, NULL if DMA is not used.
+ * @dma_tx: DMA channel filling the Tx FIFO, NULL if DMA is not used.
+ * @dma_buf: bounce buffer of the DMA transfers.
+ * @dma_sg: scatterlist of the current DMA transfer.
+ * @dma_len: length of the current DMA transfer, 0 if none.
+ * @dma_complete: acknowledge completion of a DMA transfer.
  */
 struct nmk_i2c_dev {
 	struct platform_device		*pdev;
@@ -162,6 +182,14 @@ struct nmk_i2c_dev {
 	int				result;
 	struct regulator		*regulator;
 	bool				busy;
+	resource_size_t			phybase;
+	bool				dma_requested;
+	struct dma_chan			*dma_rx;
+	struct dma_chan			*dma_tx;
+	void				*dma_buf;
+	struct scatterlist		dma_sg;
+	size_t				dma_len;
+	struct completion		dma_complete;
 };
 
 /* controller's abort causes */
@@ -389,6 +417,165 @@ static void setup_i2c_controller(struct nmk_i2c_dev *dev)
 	writel(dev->cfg.rft, dev->virtbase + I2C_RFTR);
 }
 
+static void nmk_i2c_dma_release(struct nmk_i2c_dev *dev)
+{
+	if (dev->dma_rx)
+		dma_release_channel(dev->dma_rx);
+	if (dev->dma_tx)
+		dma_release_channel(dev->dma_tx);
+	dev->dma_rx = NULL;
+	dev->dma_tx = NULL;
+	kfree(dev->dma_buf);
+	dev->dma_buf = NULL;
+}
+
+/**
+ * nmk_i2c_dma_request() - get the DMA channels of the controller
+ * @dev: private data of controller
+ *
+ * Called at the first transfer, the DMA controller may not be there yet
+ * when the I2C controllers are probed. Without DMA channels all data is
+ * moved by the FIFO interrupts.
+ */
+static void nmk_i2c_dma_request(struct nmk_i2c_dev *dev)
+{
+	struct nmk_i2c_controller *pdata = dev->pdev->dev.platform_data;
+	struct dma_slave_config rx_conf = {
+		.src_addr = dev->phybase + I2C_RFR,
+		.src_addr_width = DMA_SLAVE_BUSWIDTH_1_BYTE,
+		.direction = DMA_FROM_DEVICE,
+		.src_maxburst = 1,
+	};
+	struct dma_slave_config tx_conf = {
+		.dst_addr = dev->phybase + I2C_TFR,
+		.dst_addr_width = DMA_SLAVE_BUSWIDTH_1_BYTE,
+		.direction = DMA_TO_DEVICE,
+		.dst_maxburst = 1,
+	};
+	dma_cap_mask_t mask;
+
+	dev->dma_requested = true;
+
+	if (!pdata->dma_filter)
+		return;
+
+	dev->dma_buf = kmalloc(NMK_I2C_DMA_MAX_LEN, GFP_KERNEL);
+	if (!dev->dma_buf)
+		return;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_SLAVE, mask);
+
+	dev->dma_rx = dma_request_channel(mask, pdata->dma_filter,
+					pdata->dma_rx_param);
+	dev->dma_tx = dma_request_channel(mask, pdata->dma_filter,
+					pdata->dma_tx_param);
+	if (!dev->dma_rx || !dev->dma_tx) {
+		dev_warn(&dev->pdev->dev, "no DMA channels, using interrupts\n");
+		nmk_i2c_dma_release(dev);
+		return;
+	}
+
+	dmaengine_slave_config(dev->dma_rx, &rx_conf);
+	dmaengine_slave_config(dev->dma_tx, &tx_conf);
+}
+
+static void nmk_i2c_dma_callback(void *param)
+{
+	struct nmk_i2c_dev *dev = param;
+
+	complete(&dev->dma_complete);
+}
+
+/**
+ * nmk_i2c_dma_start() - move the data of the current message by DMA
+ * @dev: private data of controller
+ * @rx: the message is a read
+ *
+ * Returns 0 if a DMA transfer has been started, the whole message is then
+ * taken from the client data so that the FIFO interrupts have nothing
+ * left to do. Otherwise the message is to be moved by interrupts.
+ */
+static int nmk_i2c_dma_start(struct nmk_i2c_dev *dev, bool rx)
+{
+	struct dma_chan *chan = rx ? dev->dma_rx : dev->dma_tx;
+	enum dma_data_direction dir = rx ? DMA_FROM_DEVICE : DMA_TO_DEVICE;
+	struct dma_async_tx_descriptor *desc;
+	size_t len = dev->cli.count;
+
+	dev->dma_len = 0;
+
+	if (!chan || len < dev->cfg.dma_threshold ||
+			len > NMK_I2C_DMA_MAX_LEN)
+		return -EINVAL;
+
+	if (!rx)
+		memcpy(dev->dma_buf, dev->cli.buffer, len);
+
+	sg_init_one(&dev->dma_sg, dev->dma_buf, len);
+	if (dma_map_sg(chan->device->dev, &dev->dma_sg, 1, dir) != 1)
+		return -ENOMEM;
+
+	desc = dmaengine_prep_slave_sg(chan, &dev->dma_sg, 1,
+			rx ? DMA_DEV_TO_MEM : DMA_MEM_TO_DEV,
+			DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc) {
+		dma_unmap_sg(chan->device->dev, &dev->dma_sg, 1, dir);
+		return -EBUSY;
+	}
+
+	init_completion(&dev->dma_complete);
+	desc->callback = nmk_i2c_dma_callback;
+	desc->callback_param = dev;
+	dmaengine_submit(desc);
+	dma_async_issue_pending(chan);
+
+	i2c_set_bit(dev->virtbase + I2C_CR, I2C_CR_DMA_SLE |
+			(rx ? I2C_CR_DMA_RX_EN : I2C_CR_DMA_TX_EN));
+
+	dev->dma_len = len;
+	dev->cli.count = 0;
+	dev->cli.xfer_bytes += len;
+
+	return 0;
+}
+
+/**
+ * nmk_i2c_dma_finish() - complete the DMA transfer of the current message
+ * @dev: private data of controller
+ * @rx: the message is a read
+ * @status: status of the I2C transaction
+ *
+ * The transaction can be done before the DMA has drained the Rx FIFO,
+ * wait for the DMA too before handing the data to the client.
+ */
+static int nmk_i2c_dma_finish(struct nmk_i2c_dev *dev, bool rx, int status)
+{
+	struct dma_chan *chan = rx ? dev->dma_rx : dev->dma_tx;
+	enum dma_data_direction dir = rx ? DMA_FROM_DEVICE : DMA_TO_DEVICE;
+
+	if (!status && !dev->result &&
+			!wait_for_completion_timeout(&dev->dma_complete,
+				msecs_to_jiffies(NMK_I2C_DMA_TIMEOUT_MS))) {
+		dev_err(&dev->pdev->dev, "DMA to slave 0x%x timed out\n",
+				dev->cli.slave_adr);
+		status = -ETIMEDOUT;
+	}
+
+	if (status || dev->result)
+		dmaengine_terminate_all(chan);
+
+	i2c_clr_bit(dev->virtbase + I2C_CR, I2C_CR_DMA_SLE |
+			I2C_CR_DMA_RX_EN | I2C_CR_DMA_TX_EN);
+	dma_unmap_sg(chan->device->dev, &dev->dma_sg, 1, dir);
+
+	if (rx && !status && !dev->result)
+		memcpy(dev->cli.buffer, dev->dma_buf, dev->dma_len);
+	dev->dma_len = 0;
+
+	return status;
+}
+
 /**
  * read_i2c() - Read from I2C client device
  * @dev: private data of I2C Driver
@@ -404,6 +591,9 @@ static int read_i2c(struct nmk_i2c_dev *dev, u16 flags)
 	u32 mcr;
 	u32 irq_mask = 0;
 	int timeout;
+	bool dma;
+
+	dma = nmk_i2c_dma_start(dev, true) == 0;
 
 	mcr = load_i2c_mcr_reg(dev, flags);
 	writel(mcr, dev->virtbase + I2C_MCR);
@@ -418,8 +608,11 @@ static int read_i2c(struct nmk_i2c_dev *dev, u16 flags)
 	init_completion(&dev->xfer_complete);
 
 	/* enable interrupts by setting the mask */
-	irq_mask = (I2C_IT_RXFNF | I2C_IT_RXFF |
-			I2C_IT_MAL | I2C_IT_BERR);
+	irq_mask = (I2C_IT_MAL | I2C_IT_BERR);
+
+	/* the DMA drains the Rx FIFO */
+	if (!dma)
+		irq_mask |= (I2C_IT_RXFNF | I2C_IT_RXFF);
 
 	if (dev->stop)
 		irq_mask |= I2C_IT_MTD;
@@ -447,6 +640,10 @@ static int read_i2c(struct nmk_i2c_dev *dev, u16 flags)
 				dev->cli.slave_adr);
 		status = -ETIMEDOUT;
 	}
+
+	if (dma)
+		status = nmk_i2c_dma_finish(dev, true, status);
+
 	return status;
 }
 
@@ -481,6 +678,9 @@ static int write_i2c(struct nmk_i2c_dev *dev, u16 flags)
 	u32 mcr;
 	u32 irq_mask = 0;
 	int timeout;
+	bool dma;
+
+	dma = nmk_i2c_dma_start(dev, false) == 0;
 
 	mcr = load_i2c_mcr_reg(dev, flags);
 
@@ -536,6 +736,9 @@ static int write_i2c(struct nmk_i2c_dev *dev, u16 flags)
 		status = -ETIMEDOUT;
 	}
 
+	if (dma)
+		status = nmk_i2c_dma_finish(dev, false, status);
+
 	return status;
 }
 
@@ -647,6 +850,9 @@ static int nmk_i2c_xfer(struct i2c_adapter *i2c_adap,
 	if (status)
 		goto out;
 
+	if (!dev->dma_requested)
+		nmk_i2c_dma_request(dev);
+
 	/* Attempt three times to send the message queue */
 	for (j = 0; j < 3; j++) {
 		/* setup the i2c controller */
@@ -978,6 +1184,7 @@ static int __devinit nmk_i2c_probe(struct platform_device *pdev)
 		ret = -ENOMEM;
 		goto err_no_ioremap;
 	}
+	dev->phybase = res->start;
 
 	dev->irq = platform_get_irq(pdev, 0);
 	ret = request_irq(dev->irq, i2c_irq_handler, IRQF_DISABLED,
@@ -1022,6 +1229,8 @@ static int __devinit nmk_i2c_probe(struct platform_device *pdev)
 	dev->cfg.tft	= pdata->tft;
 	dev->cfg.rft	= pdata->rft;
 	dev->cfg.sm	= pdata->sm;
+	dev->cfg.dma_threshold = pdata->dma_threshold ?
+		pdata->dma_threshold : NMK_I2C_DMA_THRESHOLD;
 
 	i2c_set_adapdata(adap, dev);
 
@@ -1063,6 +1272,7 @@ static int __devexit nmk_i2c_remove(struct platform_device *pdev)
 	struct nmk_i2c_dev *dev = platform_get_drvdata(pdev);
 
 	i2c_del_adapter(&dev->adap);
+	nmk_i2c_dma_release(dev);
 	flush_i2c_fifo(dev);
 	disable_all_interrupts(dev);
 	clear_all_interrupts(dev);
@@ -96,7 +96,10 @@ static void evdev_event(struct input_handle *handle,
 	struct input_event event;
 	struct timespec ts;
 
-	ktime_get_ts(&ts);
+	if (handle->dev->timestamp.tv64)
+		ts = ktime_to_timespec(handle->dev->timestamp);
+	else
+		ktime_get_ts(&ts);
 	event.time.tv_sec = ts.tv_sec;
 	event.time.tv_usec = ts.tv_nsec / NSEC_PER_USEC;
 	event.type = type;
@@ -410,6 +413,10 @@ static ssize_t evdev_read(struct file *file, char __user *buffer,
 		if (input_event_to_user(buffer + retval, &event))
 			return -EFAULT;
 
+		if (event.type == EV_SYN && event.code == SYN_REPORT)
+			input_account_latency(evdev->handle.dev,
+					      timeval_to_ktime(event.time));
+
 		retval += input_event_size();
 	}
 
@@ -28,6 +28,9 @@
 #include <linux/rcupdate.h>
 #include "input-compat.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/input.h>
+
 MODULE_AUTHOR("Vojtech Pavlik <vojtech@suse.cz>");
 MODULE_DESCRIPTION("Input core");
 MODULE_LICENSE("GPL");
@@ -325,8 +328,35 @@ static void input_handle_event(struct input_dev *dev,
 
 	if (disposition & INPUT_PASS_TO_HANDLERS)
 		input_pass_event(dev, type, code, value);
+
+	/* The timestamp only holds for the frame it was set for */
+	if (type == EV_SYN && code == SYN_REPORT) {
+		if (disposition & INPUT_PASS_TO_HANDLERS)
+			trace_input_frame(dev);
+		dev->timestamp.tv64 = 0;
+	}
 }
 
+/**
+ * input_account_latency() - account a frame handed to userspace
+ * @dev: input device the frame came from
+ * @timestamp: timestamp of the frame
+ *
+ * Called by input handlers when userspace reads the end of a frame.
+ */
+void input_account_latency(struct input_dev *dev, ktime_t timestamp)
+{
+	s64 us = ktime_us_delta(ktime_get(), timestamp);
+	int i = 0;
+
+	while (i < INPUT_LATENCY_BUCKETS - 1 &&
+	       us >= (INPUT_LATENCY_MIN_US << i))
+		i++;
+
+	atomic_inc(&dev->latency[i]);
+}
+EXPORT_SYMBOL(input_account_latency);
+
 /**
  * input_event() - report new input event
  * @dev: device that generated the event
@@ -1291,12 +1321,51 @@ static ssize_t input_dev_show_properties(struct device *dev,
 }
 static DEVICE_ATTR(properties, S_IRUGO, input_dev_show_properties, NULL);
 
+/*
+ * Histogram of the latency from the timestamp of a frame to userspace
+ * reading it, one line per bucket with its upper bound. Writing resets it.
+ */
+static ssize_t input_dev_show_latency(struct device *dev,
+				      struct device_attribute *attr,
+				      char *buf)
+{
+	struct input_dev *input_dev = to_input_dev(dev);
+	int len = 0;
+	int i;
+
+	for (i = 0; i < INPUT_LATENCY_BUCKETS - 1; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "<%u us: %d\n",
+				 INPUT_LATENCY_MIN_US << i,
+				 atomic_read(&input_dev->latency[i]));
+	len += scnprintf(buf + len, PAGE_SIZE - len, ">=%u us: %d\n",
+			 INPUT_LATENCY_MIN_US << (i - 1),
+			 atomic_read(&input_dev->latency[i]));
+
+	return len;
+}
+
+static ssize_t input_dev_store_latency(struct device *dev,
+				       struct device_attribute *attr,
+				       const char *buf, size_t count)
+{
+	struct input_dev *input_dev = to_input_dev(dev);
+	int i;
+
+	for (i = 0; i < INPUT_LATENCY_BUCKETS; i++)
+		atomic_set(&input_dev->latency[i], 0);
+
+	return count;
+}
+static DEVICE_ATTR(latency, S_IRUGO | S_IWUSR,
+		   input_dev_show_latency, input_dev_store_latency);
+
 static struct attribute *input_dev_attrs[] = {
 	&dev_attr_name.attr,
 	&dev_attr_phys.attr,
 	&dev_attr_uniq.attr,
 	&dev_attr_modalias.attr,
 	&dev_attr_properties.attr,
+	&dev_attr_latency.attr,
 	NULL
 };
 
@@ -263,6 +263,16 @@ struct _reg_ioctl {
 
 static struct workqueue_struct *bt404_ts_tmr_workqueue;
 
+/*
+ * Read the status and the points of a touch report in one transaction,
+ * from the point status register on, instead of reading the status first
+ * and the point buffer next. Only for firmwares that lay out the point
+ * buffer right after the point status.
+ */
+static bool burst_read;
+module_param(burst_read, bool, 0644);
+MODULE_PARM_DESC(burst_read, "Read a touch report in one transaction");
+
 struct _ts_zinitix_coord {
 	u16	x;
 	u16	y;
@@ -1635,6 +1645,15 @@ static void bt404_ts_report_touch_data(struct bt404_ts_data *data,
 	input_sync(data->input_dev_ts);
 }
 
+static irqreturn_t bt404_ts_hardirq(int irq, void *dev_id)
+{
+	struct bt404_ts_data *data = dev_id;
+
+	input_set_timestamp(data->input_dev_ts, ktime_get());
+
+	return IRQ_WAKE_THREAD;
+}
+
 static irqreturn_t bt404_ts_interrupt(int irq, void *dev_id)
 {
 	struct bt404_ts_data *data = dev_id;
@@ -1673,8 +1692,13 @@ static irqreturn_t bt404_ts_interrupt(int irq, void *dev_id)
 #endif
 	}
 #endif
-	ret = bt404_ts_read_data(client, BT404_POINT_STATUS_REG,
-						(u8 *)(&data->touch_info), 4);
+	if (burst_read)
+		ret = bt404_ts_read_data(client, BT404_POINT_STATUS_REG,
+					(u8 *)(&data->touch_info),
+					sizeof(struct _ts_zinitix_point_info));
+	else
+		ret = bt404_ts_read_data(client, BT404_POINT_STATUS_REG,
+					(u8 *)(&data->touch_info), 4);
 	if (ret < 0) {
 		dev_err(&client->dev, "%s: err: rd (point status) (%d)\n",
 							__func__, ret);
@@ -1718,13 +1742,15 @@ static irqreturn_t bt404_ts_interrupt(int irq, void *dev_id)
 	if ((status >> 1) & 0b111) {
 		/* touch screen interrupt*/
 
-		ret = bt404_ts_read_data(client, BT404_POINT_REG,
+		if (!burst_read) {
+			ret = bt404_ts_read_data(client, BT404_POINT_REG,
 					(u8 *)(&data->touch_info),
 					sizeof(struct _ts_zinitix_point_info));
-		if (ret < 0) {
-			dev_err(&client->dev, "%s: err: rd (points)\n",
+			if (ret < 0) {
+				dev_err(&client->dev, "%s: err: rd (points)\n",
 								__func__);
-			goto out_esd_start;
+				goto out_esd_start;
+			}
 		}
 #if !defined(CONFIG_MACH_CODINA_EURO) && !defined(CONFIG_MACH_CODINA_CHN)
 		if (data->pdata->panel_type == EX_CLEAR_PANEL) {
@@ -3808,6 +3834,60 @@ static struct attribute_group touchscreen_temp_attr_group = {
 	.attrs = touchscreen_temp_attributes,
 };
 
+#ifdef CONFIG_TOUCHSCREEN_DOUBLETAP2WAKE
+/*
+ * With the screen off and the chip kept powered for doubletap2wake, the
+ * idle mode of the chip scans at a low rate until a finger is down, and
+ * the periodical ESD interrupt is stopped.
+ */
+static int bt404_ts_dt2w_lp_enter(void *priv)
+{
+	struct bt404_ts_data *data = priv;
+	int ret;
+
+	if (!data->enabled)
+		return -ENODEV;
+
+	down(&data->work_lock);
+#if	BT404_ESD_TIMER_INTERVAL
+	if (data->use_esd_timer) {
+		bt404_ts_write_reg(data->client,
+				BT404_PERIODICAL_INTERRUPT_INTERVAL, 0);
+		bt404_ts_esd_timer_stop(data);
+	}
+#endif
+	ret = bt404_ts_write_cmd(data->client, BT404_IDLE_CMD);
+	up(&data->work_lock);
+
+	return ret;
+}
+
+static void bt404_ts_dt2w_lp_exit(void *priv)
+{
+	struct bt404_ts_data *data = priv;
+
+	if (!data->enabled)
+		return;
+
+	down(&data->work_lock);
+	bt404_ts_write_cmd(data->client, BT404_WAKEUP_CMD);
+#if	BT404_ESD_TIMER_INTERVAL
+	if (data->use_esd_timer) {
+		bt404_ts_write_reg(data->client,
+				BT404_PERIODICAL_INTERRUPT_INTERVAL,
+				BT404_SCAN_RATE_HZ * BT404_ESD_TIMER_INTERVAL);
+		bt404_ts_esd_timer_start(BT404_CHECK_ESD_TIMER, data);
+	}
+#endif
+	up(&data->work_lock);
+}
+
+static const struct dt2w_lp_ops bt404_ts_dt2w_lp_ops = {
+	.enter	= bt404_ts_dt2w_lp_enter,
+	.exit	= bt404_ts_dt2w_lp_exit,
+};
+#endif
+
 static int bt404_ts_probe(struct i2c_client *client,
 					const struct i2c_device_id *i2c_id)
 {
@@ -4058,7 +4138,8 @@ static int bt404_ts_probe(struct i2c_client *client,
 	data->irq = client->irq;
 
 	if (data->irq) {
-		ret = request_threaded_irq(data->irq, NULL, bt404_ts_interrupt,
+		ret = request_threaded_irq(data->irq, bt404_ts_hardirq,
+			bt404_ts_interrupt,
 			IRQF_TRIGGER_FALLING | IRQF_ONESHOT, BT404_TS_DEVICE,
 									data);
 		if (ret) {
@@ -4138,6 +4219,9 @@ static int bt404_ts_probe(struct i2c_client *client,
 	dev_info(&client->dev, "successfully probed.\n");
 
 	data_ = data;
+#ifdef CONFIG_TOUCHSCREEN_DOUBLETAP2WAKE
+	doubletap2wake_set_lp_ops(&bt404_ts_dt2w_lp_ops, data);
+#endif
 
 	return 0;
 
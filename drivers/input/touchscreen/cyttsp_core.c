@@ -1229,6 +1229,15 @@ exit_xy_worker:
 	return;
 }
 
+static irqreturn_t cyttsp_hardirq(int irq, void *handle)
+{
+	struct cyttsp *ts = (struct cyttsp *)handle;
+
+	input_set_timestamp(ts->input, ktime_get());
+
+	return IRQ_WAKE_THREAD;
+}
+
 static irqreturn_t cyttsp_irq(int irq, void *handle)
 {
 	struct cyttsp *ts = (struct cyttsp *)handle;
@@ -2054,7 +2063,7 @@ static int cyttsp_open(struct input_dev *dev)
 	}
 	/* enable interrupts */
 	ts->irq = gpio_to_irq(ts->platform_data->irq_gpio);
-	ret = request_threaded_irq(ts->irq, NULL, cyttsp_irq,
+	ret = request_threaded_irq(ts->irq, cyttsp_hardirq, cyttsp_irq,
 			IRQF_TRIGGER_FALLING | IRQF_ONESHOT,
 			ts->input->name, ts);
 	if (ret < 0) {
@@ -59,6 +59,13 @@ static bool scr_suspended = false, exec_count = true;
 static struct input_dev * doubletap2wake_pwrdev;
 static DEFINE_MUTEX(pwrkeyworklock);
 
+/* Low power scan while the screen is off */
+static bool dt2w_lp_scan = true;
+module_param_named(dt2w_lp_scan, dt2w_lp_scan, bool, 0644);
+static const struct dt2w_lp_ops *dt2w_lp_ops;
+static void *dt2w_lp_priv;
+static bool dt2w_lp_active;
+
 #ifdef CONFIG_TOUCHSCREEN_DOUBLETAP2WAKE_WAKELOCK
 static struct wake_lock dt2w_wake_lock;
 bool is_dt2w_wakelock_active(void) {
@@ -74,6 +81,14 @@ void doubletap2wake_setdev(struct input_dev * input_device) {
 }
 EXPORT_SYMBOL(doubletap2wake_setdev);
 
+/* Low power scan setter */
+void doubletap2wake_set_lp_ops(const struct dt2w_lp_ops *ops, void *priv)
+{
+	dt2w_lp_ops = ops;
+	dt2w_lp_priv = priv;
+}
+EXPORT_SYMBOL(doubletap2wake_set_lp_ops);
+
 /* PowerKey work func */
 static void doubletap2wake_presspwr(struct work_struct * doubletap2wake_presspwr_work) {
 	if (!mutex_trylock(&pwrkeyworklock))
@@ -168,6 +183,21 @@ void dt2w_set_scr_suspended(bool suspended)
 {
 	scr_suspended = suspended;
 	doubletap2wake_reset();
+
+	/*
+	 * A double tap only needs the controller to notice the first touch,
+	 * it is back at the normal scan rate for the rest of the gesture.
+	 */
+	if (suspended && dt2w_switch && dt2w_lp_scan && dt2w_lp_ops &&
+	    !dt2w_lp_active) {
+		dt2w_lp_active = dt2w_lp_ops->enter(dt2w_lp_priv) == 0;
+		if (dt2w_debug)
+			pr_err("[doubletap2wake]: low power scan %s\n",
+				dt2w_lp_active ? "on" : "failed");
+	} else if (!suspended && dt2w_lp_active) {
+		dt2w_lp_ops->exit(dt2w_lp_priv);
+		dt2w_lp_active = false;
+	}
 }
 
 #ifdef CONFIG_TOUCHSCREEN_ZINITIX_BT404
@@ -311,6 +311,15 @@ static inline void hw_reboot_normal(struct mms_ts_info *info)
 	hw_reboot(info, false);
 }
 
+static irqreturn_t mms_ts_hardirq(int irq, void *dev_id)
+{
+	struct mms_ts_info *info = dev_id;
+
+	input_set_timestamp(info->input_dev_ts, ktime_get());
+
+	return IRQ_WAKE_THREAD;
+}
+
 static irqreturn_t mms_ts_interrupt(int irq, void *dev_id)
 {
 	struct mms_ts_info *info = dev_id;
@@ -2788,7 +2797,7 @@ static int __devinit mms_ts_probe(struct i2c_client *client,
 		goto err_init_device;
 	}
 
-	ret = request_threaded_irq(client->irq, NULL, mms_ts_interrupt,
+	ret = request_threaded_irq(client->irq, mms_ts_hardirq, mms_ts_interrupt,
 				   IRQF_TRIGGER_FALLING | IRQF_ONESHOT,
 				   "mms_ts", info);
 	if (ret < 0) {
@@ -21,6 +21,7 @@
 #include <linux/percpu.h>
 #include <linux/atomic.h>
 #include <linux/scatterlist.h>
+#include <linux/ktime.h>
 #include <asm/page.h>
 #include <asm/unaligned.h>
 #include <crypto/hash.h>
@@ -31,6 +32,9 @@
 
 #define DM_MSG_PREFIX "crypt"
 
+/* Encryptions of one sector each a cipher is timed on at table load */
+#define CRYPT_BENCH_SECTORS	256
+
 /*
  * context holding the current state of a multi-part conversion
  */
@@ -44,6 +48,8 @@ struct convert_context {
 	unsigned int idx_out;
 	sector_t sector;
 	atomic_t pending;
+	/* Request of the next block, kept while the cipher completes inline */
+	struct ablkcipher_request *req;
 };
 
 /*
@@ -102,13 +108,14 @@ struct iv_lmk_private {
  * Crypt: maps a linear range of a block device
  * and encrypts / decrypts at the same time.
  */
-enum flags { DM_CRYPT_SUSPENDED, DM_CRYPT_KEY_VALID };
+enum flags { DM_CRYPT_SUSPENDED, DM_CRYPT_KEY_VALID, DM_CRYPT_INLINE_READS };
 
 /*
- * Duplicated per-CPU state for cipher.
+ * Duplicated per-CPU state for cipher. Conversions may be preempted and
+ * go on elsewhere, so it is shared by all of them and must not change
+ * after initialization.
  */
 struct crypt_cpu {
-	struct ablkcipher_request *req;
 	/* ESSIV: struct crypto_cipher *essiv_tfm */
 	void *iv_private;
 	struct crypto_ablkcipher *tfms[0];
@@ -153,6 +160,9 @@ struct crypt_config {
 	struct crypt_cpu __percpu *cpu;
 	unsigned tfms_count;
 
+	/* CPU the last read was decrypted on, only a hint */
+	int read_cpu;
+
 	/*
 	 * Layout of each crypto request:
 	 *
@@ -181,6 +191,7 @@ static struct kmem_cache *_crypt_io_pool;
 
 static void clone_init(struct dm_crypt_io *, struct bio *);
 static void kcryptd_queue_crypt(struct dm_crypt_io *io);
+static void kcryptd_crypt_read_convert(struct dm_crypt_io *io);
 static u8 *iv_of_dmreq(struct crypt_config *cc, struct dm_crypt_request *dmreq);
 
 static struct crypt_cpu *this_crypt_config(struct crypt_config *cc)
@@ -665,6 +676,7 @@ static void crypt_convert_init(struct crypt_config *cc,
 	ctx->idx_in = bio_in ? bio_in->bi_idx : 0;
 	ctx->idx_out = bio_out ? bio_out->bi_idx : 0;
 	ctx->sector = sector + cc->iv_offset;
+	ctx->req = NULL;
 	init_completion(&ctx->restart);
 }
 
@@ -751,13 +763,13 @@ static void crypt_alloc_req(struct crypt_config *cc,
 	struct crypt_cpu *this_cc = this_crypt_config(cc);
 	unsigned key_index = ctx->sector & (cc->tfms_count - 1);
 
-	if (!this_cc->req)
-		this_cc->req = mempool_alloc(cc->req_pool, GFP_NOIO);
+	if (!ctx->req)
+		ctx->req = mempool_alloc(cc->req_pool, GFP_NOIO);
 
-	ablkcipher_request_set_tfm(this_cc->req, this_cc->tfms[key_index]);
-	ablkcipher_request_set_callback(this_cc->req,
+	ablkcipher_request_set_tfm(ctx->req, this_cc->tfms[key_index]);
+	ablkcipher_request_set_callback(ctx->req,
 	    CRYPTO_TFM_REQ_MAY_BACKLOG | CRYPTO_TFM_REQ_MAY_SLEEP,
-	    kcryptd_async_done, dmreq_of_req(cc, this_cc->req));
+	    kcryptd_async_done, dmreq_of_req(cc, ctx->req));
 }
 
 /*
@@ -766,8 +778,7 @@ static void crypt_alloc_req(struct crypt_config *cc,
 static int crypt_convert(struct crypt_config *cc,
 			 struct convert_context *ctx)
 {
-	struct crypt_cpu *this_cc = this_crypt_config(cc);
-	int r;
+	int r = 0;
 
 	atomic_set(&ctx->pending, 1);
 
@@ -778,7 +789,7 @@ static int crypt_convert(struct crypt_config *cc,
 
 		atomic_inc(&ctx->pending);
 
-		r = crypt_convert_block(cc, ctx, this_cc->req);
+		r = crypt_convert_block(cc, ctx, ctx->req);
 
 		switch (r) {
 		/* async */
@@ -786,8 +797,9 @@ static int crypt_convert(struct crypt_config *cc,
 		case -EBUSY:
 			wait_for_completion(&ctx->restart);
 			INIT_COMPLETION(ctx->restart);
-			this_cc->req = NULL;
+			ctx->req = NULL;
 			ctx->sector++;
+			r = 0;
 			continue;
 
 		/* sync */
@@ -800,11 +812,17 @@ static int crypt_convert(struct crypt_config *cc,
 		/* error */
 		default:
 			atomic_dec(&ctx->pending);
-			return r;
+			break;
 		}
+		break;
 	}
 
-	return 0;
+	if (ctx->req) {
+		mempool_free(ctx->req, cc->req_pool);
+		ctx->req = NULL;
+	}
+
+	return r;
 }
 
 static void dm_crypt_bio_destructor(struct bio *bio)
@@ -966,7 +984,14 @@ static void crypt_endio(struct bio *clone, int error)
 	bio_put(clone);
 
 	if (rw == READ && !error) {
-		kcryptd_queue_crypt(io);
+		/*
+		 * With inline_reads, decrypt right in the completion when it
+		 * may sleep, saving the trip through kcryptd.
+		 */
+		if (test_bit(DM_CRYPT_INLINE_READS, &cc->flags) && preemptible())
+			kcryptd_crypt_read_convert(io);
+		else
+			kcryptd_queue_crypt(io);
 		return;
 	}
 
@@ -1227,12 +1252,29 @@ static void kcryptd_crypt(struct work_struct *work)
 		kcryptd_crypt_write_convert(io);
 }
 
+/*
+ * Writes are encrypted on the CPU that submitted them, in their order.
+ * Reads all complete on the CPU taking the disk interrupt, their
+ * decryption is spread over the online CPUs.
+ */
 static void kcryptd_queue_crypt(struct dm_crypt_io *io)
 {
 	struct crypt_config *cc = io->target->private;
+	int cpu;
 
 	INIT_WORK(&io->work, kcryptd_crypt);
-	queue_work(cc->crypt_queue, &io->work);
+
+	if (bio_data_dir(io->base_bio) == WRITE) {
+		queue_work(cc->crypt_queue, &io->work);
+		return;
+	}
+
+	cpu = cpumask_next(ACCESS_ONCE(cc->read_cpu), cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		cpu = cpumask_first(cpu_online_mask);
+	cc->read_cpu = cpu;
+
+	queue_work_on(cpu, cc->crypt_queue, &io->work);
 }
 
 /*
@@ -1292,6 +1334,149 @@ static int crypt_alloc_tfms(struct crypt_config *cc, int cpu, char *ciphermode)
 	return 0;
 }
 
+/*
+ * Implementations tried at table load besides the default one, formatted
+ * with the chain mode and the cipher. The fastest of them is used.
+ */
+static const char *crypt_cipher_drivers[] = {
+	"%s-%s-ux500",		/* ux500 cryp hardware */
+	"%s-%s-neonbs",		/* NEON bit-sliced */
+	"%s(%s-asm)",		/* ARM assembler */
+};
+
+static bool select_cipher = true;
+module_param(select_cipher, bool, 0644);
+MODULE_PARM_DESC(select_cipher, "Time the cipher implementations at table load and use the fastest");
+
+struct crypt_bench {
+	struct completion done;
+	int err;
+};
+
+static void crypt_bench_done(struct crypto_async_request *async_req, int error)
+{
+	struct crypt_bench *bench = async_req->data;
+
+	if (error == -EINPROGRESS)
+		return;
+
+	bench->err = error;
+	complete(&bench->done);
+}
+
+/*
+ * ns @name takes to encrypt CRYPT_BENCH_SECTORS sectors one at a time,
+ * like crypt_convert() does, or 0 if it is not available.
+ */
+static u64 crypt_bench_cipher(const char *name, unsigned key_size,
+			      struct page *page, char *driver)
+{
+	struct crypto_ablkcipher *tfm;
+	struct ablkcipher_request *req = NULL;
+	struct crypt_bench bench;
+	struct scatterlist sg;
+	u8 iv[32] = { 0 };
+	u8 *key;
+	ktime_t start;
+	u64 ns = 0;
+	int i, r;
+
+	tfm = crypto_alloc_ablkcipher(name, 0, 0);
+	if (IS_ERR(tfm))
+		return 0;
+
+	key = kzalloc(key_size, GFP_KERNEL);
+	if (!key || crypto_ablkcipher_ivsize(tfm) > sizeof(iv) ||
+	    crypto_ablkcipher_setkey(tfm, key, key_size))
+		goto out;
+
+	req = ablkcipher_request_alloc(tfm, GFP_KERNEL);
+	if (!req)
+		goto out;
+
+	init_completion(&bench.done);
+	ablkcipher_request_set_callback(req,
+	    CRYPTO_TFM_REQ_MAY_BACKLOG | CRYPTO_TFM_REQ_MAY_SLEEP,
+	    crypt_bench_done, &bench);
+
+	start = ktime_get();
+	for (i = 0; i < CRYPT_BENCH_SECTORS; i++) {
+		sg_init_table(&sg, 1);
+		sg_set_page(&sg, page, 1 << SECTOR_SHIFT,
+			    (i << SECTOR_SHIFT) & ~PAGE_MASK);
+		ablkcipher_request_set_crypt(req, &sg, &sg,
+					     1 << SECTOR_SHIFT, iv);
+
+		r = crypto_ablkcipher_encrypt(req);
+		if (r == -EINPROGRESS || r == -EBUSY) {
+			wait_for_completion(&bench.done);
+			INIT_COMPLETION(bench.done);
+			r = bench.err;
+		}
+		if (r)
+			goto out;
+	}
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start)) ?: 1;
+
+	strlcpy(driver, crypto_tfm_alg_driver_name(crypto_ablkcipher_tfm(tfm)),
+		CRYPTO_MAX_ALG_NAME);
+out:
+	ablkcipher_request_free(req);
+	kfree(key);
+	crypto_free_ablkcipher(tfm);
+	return ns;
+}
+
+/*
+ * Replaces the crypto API name in @cipher_api by the driver name of the
+ * fastest implementation. Keeps it as it is if nothing could be timed.
+ */
+static void crypt_select_cipher(struct crypt_config *cc, char *cipher_api,
+				const char *chainmode, const char *cipher)
+{
+	unsigned key_size = cc->key_size >> ilog2(cc->tfms_count);
+	char *name, *driver, *best;
+	struct page *page;
+	u64 ns, best_ns = 0;
+	int i;
+
+	name = kmalloc(3 * CRYPTO_MAX_ALG_NAME, GFP_KERNEL);
+	page = alloc_page(GFP_KERNEL);
+	if (!name || !page)
+		goto out;
+	driver = name + CRYPTO_MAX_ALG_NAME;
+	best = driver + CRYPTO_MAX_ALG_NAME;
+
+	for (i = -1; i < (int)ARRAY_SIZE(crypt_cipher_drivers); i++) {
+		if (i < 0)
+			strlcpy(name, cipher_api, CRYPTO_MAX_ALG_NAME);
+		else
+			snprintf(name, CRYPTO_MAX_ALG_NAME,
+				 crypt_cipher_drivers[i], chainmode, cipher);
+
+		/* The default may well be one of the others */
+		if (best_ns && !strcmp(name, best))
+			continue;
+
+		ns = crypt_bench_cipher(name, key_size, page, driver);
+		if (ns && (!best_ns || ns < best_ns)) {
+			best_ns = ns;
+			strlcpy(best, driver, CRYPTO_MAX_ALG_NAME);
+		}
+	}
+
+	if (best_ns) {
+		DMINFO("%s: using %s, %llu KiB/s", cipher_api, best,
+		       div64_u64(((u64)CRYPT_BENCH_SECTORS << SECTOR_SHIFT) *
+				 (NSEC_PER_SEC >> 10), best_ns));
+		strlcpy(cipher_api, best, CRYPTO_MAX_ALG_NAME);
+	}
+out:
+	if (page)
+		__free_page(page);
+	kfree(name);
+}
+
 static int crypt_setkey_allcpus(struct crypt_config *cc)
 {
 	unsigned subkey_size = cc->key_size >> ilog2(cc->tfms_count);
@@ -1347,7 +1532,6 @@ static int crypt_wipe_key(struct crypt_config *cc)
 static void crypt_dtr(struct dm_target *ti)
 {
 	struct crypt_config *cc = ti->private;
-	struct crypt_cpu *cpu_cc;
 	int cpu;
 
 	ti->private = NULL;
@@ -1361,12 +1545,8 @@ static void crypt_dtr(struct dm_target *ti)
 		destroy_workqueue(cc->crypt_queue);
 
 	if (cc->cpu)
-		for_each_possible_cpu(cpu) {
-			cpu_cc = per_cpu_ptr(cc->cpu, cpu);
-			if (cpu_cc->req)
-				mempool_free(cpu_cc->req, cc->req_pool);
+		for_each_possible_cpu(cpu)
 			crypt_free_tfms(cc, cpu);
-		}
 
 	if (cc->bs)
 		bioset_free(cc->bs);
@@ -1474,6 +1654,9 @@ static int crypt_ctr_cipher(struct dm_target *ti,
 		goto bad_mem;
 	}
 
+	if (select_cipher)
+		crypt_select_cipher(cc, cipher_api, chainmode, cipher);
+
 	/* Allocate cipher */
 	for_each_possible_cpu(cpu) {
 		ret = crypt_alloc_tfms(cc, cpu, cipher_api);
@@ -1572,7 +1755,7 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 	char dummy;
 
 	static struct dm_arg _args[] = {
-		{0, 1, "Invalid number of feature args"},
+		{0, 2, "Invalid number of feature args"},
 	};
 
 	if (argc < 5) {
@@ -1667,15 +1850,20 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 		if (ret)
 			goto bad;
 
-		opt_string = dm_shift_arg(&as);
+		while (opt_params--) {
+			opt_string = dm_shift_arg(&as);
 
-		if (opt_params == 1 && opt_string &&
-		    !strcasecmp(opt_string, "allow_discards"))
-			ti->num_discard_requests = 1;
-		else if (opt_params) {
-			ret = -EINVAL;
-			ti->error = "Invalid feature arguments";
-			goto bad;
+			if (opt_string &&
+			    !strcasecmp(opt_string, "allow_discards"))
+				ti->num_discard_requests = 1;
+			else if (opt_string &&
+				 !strcasecmp(opt_string, "inline_reads"))
+				set_bit(DM_CRYPT_INLINE_READS, &cc->flags);
+			else {
+				ret = -EINVAL;
+				ti->error = "Invalid feature arguments";
+				goto bad;
+			}
 		}
 	}
 
@@ -1762,8 +1950,14 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 		DMEMIT(" %llu %s %llu", (unsigned long long)cc->iv_offset,
 				cc->dev->name, (unsigned long long)cc->start);
 
+		i = !!ti->num_discard_requests +
+		    test_bit(DM_CRYPT_INLINE_READS, &cc->flags);
+		if (i)
+			DMEMIT(" %u", i);
 		if (ti->num_discard_requests)
-			DMEMIT(" 1 allow_discards");
+			DMEMIT(" allow_discards");
+		if (test_bit(DM_CRYPT_INLINE_READS, &cc->flags))
+			DMEMIT(" inline_reads");
 
 		break;
 	}
@@ -1860,7 +2054,7 @@ static int crypt_iterate_devices(struct dm_target *ti,
 
 static struct target_type crypt_target = {
 	.name   = "crypt",
-	.version = {1, 11, 0},
+	.version = {1, 12, 0},
 	.module = THIS_MODULE,
 	.ctr    = crypt_ctr,
 	.dtr    = crypt_dtr,
@@ -111,6 +111,9 @@
 static bool no_bm; /* No battery management */
 module_param(no_bm, bool, S_IRUGO);
 
+static bool no_reg_cache; /* Every access goes to the chip */
+module_param(no_reg_cache, bool, S_IRUGO);
+
 #define AB9540_MODEM_CTRL2_REG			0x23
 #define AB9540_MODEM_CTRL2_SWDBBRSTN_BIT	BIT(2)
 
@@ -149,6 +152,169 @@ static int ab8500_get_chip_id(struct device *dev)
 	return ab8500 ? (int)ab8500->chip_id : -EINVAL;
 }
 
+/*
+ * Register cache
+ *
+ * Every access to the AB8500 is a round trip through the PRCMU I2C
+ * mailbox. The registers of the ranges below only change when they are
+ * written from here, so they are written through to a cache and read
+ * back from it, and a masked write that changes no bit of one is not
+ * sent at all. All other registers are volatile. A write to one of the
+ * reset registers drops the cache of the bank it resets.
+ */
+struct ab8500_reg_range {
+	u8 first;
+	u8 last;
+};
+
+struct ab8500_cache_bank {
+	u8 bank;
+	const struct ab8500_reg_range *ranges;
+	int num_ranges;
+};
+
+#define AB8500_CACHE_BANK(_bank, _ranges)		\
+	{						\
+		.bank = _bank,				\
+		.ranges = _ranges,			\
+		.num_ranges = ARRAY_SIZE(_ranges),	\
+	}
+
+#define AB8500_BANK_SIZE	256
+
+struct ab8500_reg_cache {
+	u8 value[AB8500_BANK_SIZE];
+	DECLARE_BITMAP(valid, AB8500_BANK_SIZE);
+};
+
+/* LDOs, not the Vape and Varm settings written with prcmu_abb_write() */
+static const struct ab8500_reg_range ab8500_regu_ctrl1_cached[] = {
+	{ 0x80, 0x83 },
+};
+
+static const struct ab8500_reg_range ab8500_regu_ctrl2_cached[] = {
+	{ 0x06, 0x06 },
+	{ 0x09, 0x0A },
+	{ 0x1F, 0x21 },
+	{ 0x2E, 0x2F },
+};
+
+/* Not the reset, ANC and sidetone FIR ports and interrupt sources */
+static const struct ab8500_reg_range ab8500_audio_cached[] = {
+	{ 0x00, 0x00 },
+	{ 0x02, 0x52 },
+	{ 0x65, 0x65 },
+	{ 0x67, 0x67 },
+	{ 0x69, 0x83 },
+};
+
+/* GPIO select, direction, output and pull, not the inputs */
+static const struct ab8500_reg_range ab8500_misc_cached[] = {
+	{ 0x00, 0x05 },
+	{ 0x10, 0x15 },
+	{ 0x20, 0x25 },
+	{ 0x30, 0x35 },
+};
+
+static const struct ab8500_cache_bank ab8500_cache_banks[] = {
+	AB8500_CACHE_BANK(AB8500_REGU_CTRL1, ab8500_regu_ctrl1_cached),
+	AB8500_CACHE_BANK(AB8500_REGU_CTRL2, ab8500_regu_ctrl2_cached),
+	AB8500_CACHE_BANK(AB8500_AUDIO, ab8500_audio_cached),
+	AB8500_CACHE_BANK(AB8500_MISC, ab8500_misc_cached),
+};
+
+/* Writes that reset the registers of a bank: STW4500CTRL3 and AUDSWRESET */
+static const struct {
+	u16 addr;
+	u8 bank;
+} ab8500_cache_resets[] = {
+	{ AB8500_SYS_CTRL2_BLOCK << 8 | 0x00, AB8500_AUDIO },
+	{ AB8500_AUDIO << 8 | 0x01, AB8500_AUDIO },
+};
+
+static struct ab8500_reg_cache *ab8500_cache_find(struct ab8500 *ab8500,
+	u8 bank, u8 reg)
+{
+	const struct ab8500_cache_bank *cb;
+	int i, j;
+
+	if (!ab8500->reg_cache)
+		return NULL;
+
+	for (i = 0; i < ARRAY_SIZE(ab8500_cache_banks); i++) {
+		cb = &ab8500_cache_banks[i];
+		if (cb->bank != bank)
+			continue;
+		for (j = 0; j < cb->num_ranges; j++)
+			if (reg >= cb->ranges[j].first &&
+			    reg <= cb->ranges[j].last)
+				return &ab8500->reg_cache[i];
+		break;
+	}
+	return NULL;
+}
+
+/* Called with ab8500->lock held, as are the other cache helpers */
+static bool ab8500_cache_read(struct ab8500 *ab8500, u16 addr, u8 *value)
+{
+	struct ab8500_reg_cache *cache;
+	u8 reg = addr & 0xFF;
+
+	cache = ab8500_cache_find(ab8500, addr >> 8, reg);
+	if (!cache || !test_bit(reg, cache->valid))
+		return false;
+
+	*value = cache->value[reg];
+	return true;
+}
+
+static void ab8500_cache_fill(struct ab8500 *ab8500, u16 addr, u8 value)
+{
+	struct ab8500_reg_cache *cache;
+	u8 reg = addr & 0xFF;
+
+	cache = ab8500_cache_find(ab8500, addr >> 8, reg);
+	if (cache) {
+		cache->value[reg] = value;
+		set_bit(reg, cache->valid);
+	}
+}
+
+/* A failed or partial write leaves the register unknown */
+static void ab8500_cache_drop(struct ab8500 *ab8500, u16 addr)
+{
+	struct ab8500_reg_cache *cache;
+	u8 reg = addr & 0xFF;
+
+	cache = ab8500_cache_find(ab8500, addr >> 8, reg);
+	if (cache)
+		clear_bit(reg, cache->valid);
+}
+
+static void ab8500_cache_reset(struct ab8500 *ab8500, u16 addr)
+{
+	int i, j;
+
+	if (!ab8500->reg_cache)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(ab8500_cache_resets); i++) {
+		if (ab8500_cache_resets[i].addr != addr)
+			continue;
+		for (j = 0; j < ARRAY_SIZE(ab8500_cache_banks); j++)
+			if (ab8500_cache_banks[j].bank ==
+			    ab8500_cache_resets[i].bank)
+				bitmap_zero(ab8500->reg_cache[j].valid,
+					    AB8500_BANK_SIZE);
+	}
+}
+
+static void ab8500_cache_written(struct ab8500 *ab8500, u16 addr, u8 value)
+{
+	ab8500_cache_reset(ab8500, addr);
+	ab8500_cache_fill(ab8500, addr, value);
+}
+
 static int set_register_interruptible(struct ab8500 *ab8500, u8 bank,
 	u8 reg, u8 data)
 {
@@ -164,9 +330,13 @@ static int set_register_interruptible(struct ab8500 *ab8500, u8 bank,
 	mutex_lock(&ab8500->lock);
 
 	ret = ab8500->write(ab8500, addr, data);
-	if (ret < 0)
+	if (ret < 0) {
 		dev_err(ab8500->dev, "failed to write reg %#x: %d\n",
 			addr, ret);
+		ab8500_cache_drop(ab8500, addr);
+	} else {
+		ab8500_cache_written(ab8500, addr, data);
+	}
 	mutex_unlock(&ab8500->lock);
 
 	return ret;
@@ -194,13 +364,21 @@ static int get_register_interruptible(struct ab8500 *ab8500, u8 bank,
 
 	mutex_lock(&ab8500->lock);
 
+	if (ab8500_cache_read(ab8500, addr, value)) {
+		ret = *value;
+		goto out;
+	}
+
 	ret = ab8500->read(ab8500, addr);
-	if (ret < 0)
+	if (ret < 0) {
 		dev_err(ab8500->dev, "failed to read reg %#x: %d\n",
 			addr, ret);
-	else
+	} else {
 		*value = ret;
+		ab8500_cache_fill(ab8500, addr, ret);
+	}
 
+out:
 	mutex_unlock(&ab8500->lock);
 	dev_vdbg(ab8500->dev, "rd: addr %#x => data %#x\n", addr, ret);
 
@@ -226,12 +404,31 @@ static int mask_and_set_register_interruptible(struct ab8500 *ab8500, u8 bank,
 	/* put the u8 bank and u8 reg together into a an u16.
 	 * bank on higher 8 bits and reg in lower */
 	u16 addr = ((u16)bank) << 8 | reg;
+	u8 data;
 
 	mutex_lock(&ab8500->lock);
 
-	if (ab8500->write_masked == NULL) {
-		u8 data;
+	if (ab8500_cache_read(ab8500, addr, &data)) {
+		u8 old = data;
+
+		data = (~bitmask & data) | (bitmask & bitvalues);
+		if (data == old) {
+			ret = 0;
+			goto out;
+		}
 
+		ret = ab8500->write(ab8500, addr, data);
+		if (ret < 0) {
+			dev_err(ab8500->dev, "failed to write reg %#x: %d\n",
+				addr, ret);
+			ab8500_cache_drop(ab8500, addr);
+		} else {
+			ab8500_cache_written(ab8500, addr, data);
+		}
+		goto out;
+	}
+
+	if (ab8500->write_masked == NULL) {
 		ret = ab8500->read(ab8500, addr);
 		if (ret < 0) {
 			dev_err(ab8500->dev, "failed to read reg %#x: %d\n",
@@ -246,6 +443,8 @@ static int mask_and_set_register_interruptible(struct ab8500 *ab8500, u8 bank,
 		if (ret < 0)
 			dev_err(ab8500->dev, "failed to write reg %#x: %d\n",
 				addr, ret);
+		else
+			ab8500_cache_written(ab8500, addr, data);
 
 		dev_vdbg(ab8500->dev, "mask: addr %#x => data %#x\n", addr,
 			data);
@@ -255,6 +454,10 @@ static int mask_and_set_register_interruptible(struct ab8500 *ab8500, u8 bank,
 	if (ret < 0)
 		dev_err(ab8500->dev, "failed to modify reg %#x: %d\n", addr,
 			ret);
+	else if (bitmask == 0xFF)
+		ab8500_cache_written(ab8500, addr, bitvalues);
+	else
+		ab8500_cache_reset(ab8500, addr);
 out:
 	mutex_unlock(&ab8500->lock);
 	return ret;
@@ -273,12 +476,104 @@ static int ab8500_mask_and_set_register(struct device *dev,
 	return ret;
 }
 
+/*
+ * The PRCMU firmware moves one register per mailbox transfer, so a page
+ * is still one transfer per register not in the cache, but all of them
+ * under one lock, back to back.
+ */
+static int get_register_page_interruptible(struct ab8500 *ab8500, u8 bank,
+	u8 first_reg, u8 *regvals, u8 numregs)
+{
+	int ret = 0;
+	u16 addr;
+	int i;
+
+	if (first_reg + numregs > AB8500_BANK_SIZE)
+		return -EINVAL;
+
+	mutex_lock(&ab8500->lock);
+
+	for (i = 0; i < numregs; i++) {
+		addr = ((u16)bank) << 8 | (first_reg + i);
+		if (ab8500_cache_read(ab8500, addr, &regvals[i]))
+			continue;
+
+		ret = ab8500->read(ab8500, addr);
+		if (ret < 0) {
+			dev_err(ab8500->dev, "failed to read reg %#x: %d\n",
+				addr, ret);
+			break;
+		}
+		regvals[i] = ret;
+		ab8500_cache_fill(ab8500, addr, ret);
+	}
+
+	mutex_unlock(&ab8500->lock);
+
+	return ret < 0 ? ret : 0;
+}
+
+static int ab8500_get_register_page(struct device *dev, u8 bank,
+	u8 first_reg, u8 *regvals, u8 numregs)
+{
+	int ret;
+	struct ab8500 *ab8500 = dev_get_drvdata(dev->parent);
+
+	atomic_inc(&ab8500->transfer_ongoing);
+	ret = get_register_page_interruptible(ab8500, bank, first_reg,
+					      regvals, numregs);
+	atomic_dec(&ab8500->transfer_ongoing);
+	return ret;
+}
+
+static int set_register_page_interruptible(struct ab8500 *ab8500, u8 bank,
+	u8 first_reg, u8 *regvals, u8 numregs)
+{
+	int ret = 0;
+	u16 addr;
+	int i;
+
+	if (first_reg + numregs > AB8500_BANK_SIZE)
+		return -EINVAL;
+
+	mutex_lock(&ab8500->lock);
+
+	for (i = 0; i < numregs; i++) {
+		addr = ((u16)bank) << 8 | (first_reg + i);
+		ret = ab8500->write(ab8500, addr, regvals[i]);
+		if (ret < 0) {
+			dev_err(ab8500->dev, "failed to write reg %#x: %d\n",
+				addr, ret);
+			ab8500_cache_drop(ab8500, addr);
+			break;
+		}
+		ab8500_cache_written(ab8500, addr, regvals[i]);
+	}
+
+	mutex_unlock(&ab8500->lock);
+
+	return ret < 0 ? ret : 0;
+}
+
+static int ab8500_set_register_page(struct device *dev, u8 bank,
+	u8 first_reg, u8 *regvals, u8 numregs)
+{
+	int ret;
+	struct ab8500 *ab8500 = dev_get_drvdata(dev->parent);
+
+	atomic_inc(&ab8500->transfer_ongoing);
+	ret = set_register_page_interruptible(ab8500, bank, first_reg,
+					      regvals, numregs);
+	atomic_dec(&ab8500->transfer_ongoing);
+	return ret;
+}
+
 static struct abx500_ops ab8500_ops = {
 	.get_chip_id = ab8500_get_chip_id,
 	.get_register = ab8500_get_register,
 	.set_register = ab8500_set_register,
-	.get_register_page = NULL,
-	.set_register_page = NULL,
+	.get_register_page = ab8500_get_register_page,
+	.set_register_page = ab8500_set_register_page,
 	.mask_and_set_register = ab8500_mask_and_set_register,
 	.event_registers_startup_state_get = NULL,
 	.startup_irq_enabled = NULL,
@@ -1559,6 +1854,14 @@ int __devinit ab8500_init(struct ab8500 *ab8500, enum ab8500_version version)
 			AB8500_IT_MASK1_REG + ab8500->irq_reg_offset[i], 0xff);
 	}
 
+	if (!no_reg_cache) {
+		ab8500->reg_cache = kcalloc(ARRAY_SIZE(ab8500_cache_banks),
+					    sizeof(*ab8500->reg_cache),
+					    GFP_KERNEL);
+		if (!ab8500->reg_cache)
+			dev_warn(ab8500->dev, "no register cache\n");
+	}
+
 	ret = abx500_register_ops(ab8500->dev, &ab8500_ops);
 	if (ret)
 		goto out_freeoldmask;
@@ -1650,6 +1953,8 @@ out_removeirq:
 	if (ab8500->irq_base)
 		ab8500_irq_remove(ab8500);
 out_freeoldmask:
+	kfree(ab8500->reg_cache);
+	ab8500->reg_cache = NULL;
 	kfree(ab8500->oldmask);
 out_freemask:
 	kfree(ab8500->mask);
@@ -1675,6 +1980,7 @@ int __devexit ab8500_exit(struct ab8500 *ab8500)
 		free_irq(ab8500->irq, ab8500);
 		ab8500_irq_remove(ab8500);
 	}
+	kfree(ab8500->reg_cache);
 	kfree(ab8500->oldmask);
 	kfree(ab8500->mask);
 
@@ -103,6 +103,20 @@ int abx500_get_register_page_interruptible(struct device *dev, u8 bank,
 }
 EXPORT_SYMBOL(abx500_get_register_page_interruptible);
 
+int abx500_set_register_page_interruptible(struct device *dev, u8 bank,
+	u8 first_reg, u8 *regvals, u8 numregs)
+{
+	struct abx500_ops *ops;
+
+	lookup_ops(dev->parent, &ops);
+	if ((ops != NULL) && (ops->set_register_page != NULL))
+		return ops->set_register_page(dev, bank,
+			first_reg, regvals, numregs);
+	else
+		return -ENOTSUPP;
+}
+EXPORT_SYMBOL(abx500_set_register_page_interruptible);
+
 int abx500_mask_and_set_register_interruptible(struct device *dev, u8 bank,
 	u8 reg, u8 bitmask, u8 bitvalues)
 {
@@ -2038,6 +2038,276 @@ static ssize_t prcmu_mcdeclk_show(struct kobject *kobj, struct kobj_attribute *a
 }
 ATTR_RO(prcmu_mcdeclk);
 
+#ifdef AB8500
+#define LIVEOPP_VARM_VSEL_MASK		AB8500_VARM_VSEL_MASK
+#endif
+#ifdef AB8505
+#define LIVEOPP_VARM_VSEL_MASK		AB8505_VARM_VSEL_MASK
+#endif
+
+/*
+ * The Varm of every step as "<kHz>:<raw>,..." - save it from userspace
+ * after a characterisation and write it back at boot.
+ */
+static ssize_t arm_varm_table_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	int i, len = 0;
+
+	for (i = 0; i < ARRAY_SIZE(liveopp_arm); i++)
+		len += sprintf(buf + len, "%s%u:%#04x", i ? "," : "",
+			       liveopp_arm[i].freq_show, liveopp_arm[i].varm_raw);
+	len += sprintf(buf + len, "\n");
+
+	return len;
+}
+
+static ssize_t arm_varm_table_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	const char *p = buf;
+	u32 freq, varm;
+	int i, n;
+
+	while (sscanf(p, "%u:%x%n", &freq, &varm, &n) == 2) {
+		if (varm & ~(LIVEOPP_VARM_VSEL_MASK | 0x80)) {
+			pr_err("[LiveOPP] Invalid varm %#x\n", varm);
+			return -EINVAL;
+		}
+		for (i = 0; i < ARRAY_SIZE(liveopp_arm); i++) {
+			if (liveopp_arm[i].freq_show == freq) {
+				liveopp_arm[i].varm_raw = varm;
+				break;
+			}
+		}
+		p += n;
+		if (*p != ',')
+			break;
+		p++;
+	}
+
+	return count;
+}
+ATTR_RW(arm_varm_table);
+
+#ifdef CONFIG_LIVEOPP_CHARACTERISE
+/*
+ * Characterisation: for each enabled step, pin both cores at it, run a
+ * stress kernel with a known result on every online cpu and lower Varm
+ * one selection at a time until a run gives a wrong result. The step is
+ * left at its lowest good Varm plus a margin. A wrong result is the
+ * usual failure, but a step bad enough hangs the device instead; the
+ * table is only in RAM until saved, so rebooting restores the stock one.
+ * The step and Varm being tried are logged before each run.
+ */
+#define LIVEOPP_CHAR_MARGIN		2	/* Varm selections */
+#define LIVEOPP_CHAR_MAX_STEPS		16
+#define LIVEOPP_CHAR_RUN_MS		2000
+#define LIVEOPP_CHAR_BYTES		(64 * 1024)
+#define LIVEOPP_CHAR_WORDS		(LIVEOPP_CHAR_BYTES / sizeof(u32))
+
+struct liveopp_char_work {
+	u32 *buf;
+	u32 expected;
+	bool failed;
+	struct completion done;
+};
+
+static DEFINE_MUTEX(liveopp_char_mutex);
+static struct task_struct *liveopp_char_task;
+static int liveopp_char_step = -1;	/* -1: all enabled steps */
+static u8 liveopp_char_result[ARRAY_SIZE(liveopp_arm)];
+
+/* Integer, multiply and L1/L2 load/store work with a fixed result */
+static u32 liveopp_stress(u32 *buf)
+{
+	u32 x = 0x2545f491, sum = 0;
+	int i;
+
+	for (i = 0; i < LIVEOPP_CHAR_WORDS; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[i] = x * (i | 1) + sum;
+		sum = ((sum << 3) | (sum >> 29)) ^
+			buf[(i * 7) & (LIVEOPP_CHAR_WORDS - 1)];
+	}
+
+	return sum;
+}
+
+static int liveopp_stress_thread(void *data)
+{
+	struct liveopp_char_work *work = data;
+	unsigned long end = jiffies + msecs_to_jiffies(LIVEOPP_CHAR_RUN_MS);
+
+	while (time_before(jiffies, end) && !work->failed) {
+		if (liveopp_stress(work->buf) != work->expected)
+			work->failed = true;
+		cond_resched();
+	}
+
+	complete(&work->done);
+	return 0;
+}
+
+/* Runs the stress kernel on all online cpus, true if all got it right */
+static bool liveopp_stress_all(u32 expected)
+{
+	struct liveopp_char_work work[NR_CPUS];
+	struct task_struct *task;
+	bool ok = true;
+	int cpu;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu) {
+		work[cpu].buf = kmalloc(LIVEOPP_CHAR_BYTES, GFP_KERNEL);
+		work[cpu].expected = expected;
+		work[cpu].failed = false;
+		init_completion(&work[cpu].done);
+		task = NULL;
+		if (work[cpu].buf)
+			task = kthread_create(liveopp_stress_thread, &work[cpu],
+					      "liveopp_stress/%d", cpu);
+		if (IS_ERR_OR_NULL(task)) {
+			work[cpu].failed = true;
+			complete(&work[cpu].done);
+			continue;
+		}
+		kthread_bind(task, cpu);
+		wake_up_process(task);
+	}
+	for_each_online_cpu(cpu) {
+		wait_for_completion(&work[cpu].done);
+		if (work[cpu].failed)
+			ok = false;
+		kfree(work[cpu].buf);
+	}
+	put_online_cpus();
+
+	return ok;
+}
+
+static int liveopp_set_varm(int idx, u8 varm)
+{
+	if (current_arm_idx != idx)
+		return -EBUSY;
+
+	liveopp_arm[idx].varm_raw = varm;
+	prcmu_abb_write(AB8500_REGU_CTRL2, AB8500_VARM_SEL1, &varm, 1);
+	udelay(liveopp_varm_us);
+
+	return 0;
+}
+
+static void liveopp_characterise_step(int idx, u32 expected)
+{
+	u8 stock = liveopp_arm[idx].varm_raw;
+	u8 vsel = stock & LIVEOPP_VARM_VSEL_MASK;
+	u8 good = vsel;
+	int n;
+
+	if (cpufreq_update_freq(0, liveopp_arm[idx].freq_show,
+				liveopp_arm[idx].freq_show) ||
+	    current_arm_idx != idx) {
+		pr_err("[LiveOPP] Cannot pin %u kHz\n", liveopp_arm[idx].freq_show);
+		return;
+	}
+
+	for (n = 1; n <= LIVEOPP_CHAR_MAX_STEPS && n <= vsel; n++) {
+		u8 varm = (stock & ~LIVEOPP_VARM_VSEL_MASK) | (vsel - n);
+
+		pr_info("[LiveOPP] %u kHz: trying varm %#04x (%d uV)\n",
+			liveopp_arm[idx].freq_show, varm, varm_uv(varm));
+		if (liveopp_set_varm(idx, varm) || !liveopp_stress_all(expected))
+			break;
+		good = vsel - n;
+		if (kthread_should_stop())
+			break;
+	}
+
+	good = min_t(u8, good + LIVEOPP_CHAR_MARGIN, vsel);
+	liveopp_char_result[idx] = (stock & ~LIVEOPP_VARM_VSEL_MASK) | good;
+	if (liveopp_set_varm(idx, liveopp_char_result[idx]))
+		liveopp_arm[idx].varm_raw = stock;
+
+	pr_info("[LiveOPP] %u kHz: varm %#04x (%d uV), stock %#04x\n",
+		liveopp_arm[idx].freq_show, liveopp_char_result[idx],
+		varm_uv(liveopp_char_result[idx]), stock);
+}
+
+static int liveopp_characterise_thread(void *data)
+{
+	struct cpufreq_policy policy;
+	u32 expected;
+	u32 *buf;
+	int i;
+
+	buf = kmalloc(LIVEOPP_CHAR_BYTES, GFP_KERNEL);
+	if (!buf || cpufreq_get_policy(&policy, 0))
+		goto out;
+
+	/* The reference result, at the stock table */
+	expected = liveopp_stress(buf);
+
+	memset(liveopp_char_result, 0, sizeof(liveopp_char_result));
+	for (i = 0; i < ARRAY_SIZE(liveopp_arm) && !kthread_should_stop(); i++) {
+		if (!liveopp_arm[i].enable ||
+		    (liveopp_char_step >= 0 && liveopp_char_step != i))
+			continue;
+		liveopp_characterise_step(i, expected);
+	}
+
+	cpufreq_update_freq(0, policy.min, policy.max);
+out:
+	kfree(buf);
+	mutex_lock(&liveopp_char_mutex);
+	liveopp_char_task = NULL;
+	mutex_unlock(&liveopp_char_mutex);
+
+	return 0;
+}
+
+static ssize_t arm_characterise_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	int i, len;
+
+	len = sprintf(buf, "%s\n", liveopp_char_task ? "running" : "idle");
+	for (i = 0; i < ARRAY_SIZE(liveopp_arm); i++)
+		if (liveopp_char_result[i])
+			len += sprintf(buf + len, "%u:%#04x\n",
+				       liveopp_arm[i].freq_show,
+				       liveopp_char_result[i]);
+
+	return len;
+}
+
+/* "all" or a step index starts a characterisation */
+static ssize_t arm_characterise_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	struct task_struct *task;
+	int step;
+
+	if (sysfs_streq(buf, "all"))
+		step = -1;
+	else if (sscanf(buf, "%d", &step) != 1 || step < 0 ||
+		 step >= ARRAY_SIZE(liveopp_arm))
+		return -EINVAL;
+
+	mutex_lock(&liveopp_char_mutex);
+	if (liveopp_char_task) {
+		mutex_unlock(&liveopp_char_mutex);
+		return -EBUSY;
+	}
+	liveopp_char_step = step;
+	task = kthread_run(liveopp_characterise_thread, NULL, "liveopp_char");
+	if (!IS_ERR(task))
+		liveopp_char_task = task;
+	mutex_unlock(&liveopp_char_mutex);
+
+	return IS_ERR(task) ? PTR_ERR(task) : count;
+}
+ATTR_RW(arm_characterise);
+#endif /* CONFIG_LIVEOPP_CHARACTERISE */
+
 static struct attribute *liveopp_attrs[] = {
 #if CONFIG_LIVEOPP_DEBUG > 1
 	&liveopp_start_interface.attr, 
@@ -2062,6 +2332,10 @@ static struct attribute *liveopp_attrs[] = {
 	&arm_step08_interface.attr,
 	&arm_step09_interface.attr,
 	&prcmu_mcdeclk_interface.attr,
+	&arm_varm_table_interface.attr,
+#ifdef CONFIG_LIVEOPP_CHARACTERISE
+	&arm_characterise_interface.attr,
+#endif
 	NULL,
 };
 
@@ -3550,6 +3824,76 @@ static int db8500_prcmu_config_esram0_deep_sleep(u8 state)
 	return 0;
 }
 
+static int config_hotdog(u8 threshold)
+{
+	mutex_lock(&mb4_transfer.lock);
+
+	while (readl(PRCM_MBOX_CPU_VAL) & MBOX_BIT(4))
+		cpu_relax();
+
+	writeb(threshold, (tcdm_base + PRCM_REQ_MB4_HOTDOG_THRESHOLD));
+	writeb(MB4H_HOTDOG, (tcdm_base + PRCM_MBOX_HEADER_REQ_MB4));
+
+	writel(MBOX_BIT(4), PRCM_MBOX_CPU_SET);
+	wait_for_completion(&mb4_transfer.work);
+
+	mutex_unlock(&mb4_transfer.lock);
+
+	return 0;
+}
+
+static int config_hotmon(u8 low, u8 high)
+{
+	mutex_lock(&mb4_transfer.lock);
+
+	while (readl(PRCM_MBOX_CPU_VAL) & MBOX_BIT(4))
+		cpu_relax();
+
+	writeb(low, (tcdm_base + PRCM_REQ_MB4_HOTMON_LOW));
+	writeb(high, (tcdm_base + PRCM_REQ_MB4_HOTMON_HIGH));
+	writeb((HOTMON_CONFIG_LOW | HOTMON_CONFIG_HIGH),
+		(tcdm_base + PRCM_REQ_MB4_HOTMON_CONFIG));
+	writeb(MB4H_HOTMON, (tcdm_base + PRCM_MBOX_HEADER_REQ_MB4));
+
+	writel(MBOX_BIT(4), PRCM_MBOX_CPU_SET);
+	wait_for_completion(&mb4_transfer.work);
+
+	mutex_unlock(&mb4_transfer.lock);
+
+	return 0;
+}
+
+static int config_hot_period(u16 val)
+{
+	mutex_lock(&mb4_transfer.lock);
+
+	while (readl(PRCM_MBOX_CPU_VAL) & MBOX_BIT(4))
+		cpu_relax();
+
+	writew(val, (tcdm_base + PRCM_REQ_MB4_HOT_PERIOD));
+	writeb(MB4H_HOT_PERIOD, (tcdm_base + PRCM_MBOX_HEADER_REQ_MB4));
+
+	writel(MBOX_BIT(4), PRCM_MBOX_CPU_SET);
+	wait_for_completion(&mb4_transfer.work);
+
+	mutex_unlock(&mb4_transfer.lock);
+
+	return 0;
+}
+
+static int start_temp_sense(u16 cycles32k)
+{
+	if (cycles32k == 0xFFFF)
+		return -EINVAL;
+
+	return config_hot_period(cycles32k);
+}
+
+static int stop_temp_sense(void)
+{
+	return config_hot_period(0xFFFF);
+}
+
 static int prcmu_a9wdog(u8 cmd, u8 d0, u8 d1, u8 d2, u8 d3)
 {
 	trace_u8500_a9_wdog(cmd, d0, d1, d2, d3);
@@ -5203,8 +5547,16 @@ static struct ux500_wdt_ops db8500_wdt_ops = {
 	.config = config_a9wdog,
 };
 
+static struct dbx500_temp_ops db8500_temp_ops = {
+	.config_hotdog = config_hotdog,
+	.config_hotmon = config_hotmon,
+	.start_temp_sense = start_temp_sense,
+	.stop_temp_sense = stop_temp_sense,
+};
+
 static struct dbx500_temp_pdata db8500_temp_pdata = {
-	.ops = NULL,
+	.ops = &db8500_temp_ops,
+	.monitoring_active = false,
 };
 
 static struct resource u8500_thsens_resources[] = {
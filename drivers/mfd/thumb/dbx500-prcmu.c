@@ -356,6 +356,158 @@ int prcmu_get_val(enum prcmu_val type)
 	return dbx500_prcmu_context.get_val(type);
 }
 
+/*
+ * Asynchronous OPP requests
+ *
+ * An OPP change sleeps until the PRCMU firmware acks it through the
+ * mailbox. prcmu_set_val_async() hands the change to an ordered worker
+ * and returns at once; @complete is called from the worker with the
+ * result. A request still pending when a newer one for the same value
+ * comes in is superseded: its @complete gets -ECANCELED and only the
+ * newer one goes to the firmware.
+ */
+struct prcmu_val_async {
+	struct work_struct work;
+	bool pending;
+	u8 value;
+	prcmu_val_complete_t complete;
+	void *data;
+};
+
+static struct prcmu_val_async prcmu_val_async[PRCMU_VAL_MAX];
+static DEFINE_SPINLOCK(prcmu_val_async_lock);
+static struct workqueue_struct *prcmu_val_wq;
+
+/* Takes the pending request of @req, if any, off it */
+static bool prcmu_val_async_take(struct prcmu_val_async *req, u8 *value,
+				 prcmu_val_complete_t *complete, void **data)
+{
+	unsigned long flags;
+	bool pending;
+
+	spin_lock_irqsave(&prcmu_val_async_lock, flags);
+	pending = req->pending;
+	if (pending) {
+		*value = req->value;
+		*complete = req->complete;
+		*data = req->data;
+		req->pending = false;
+	}
+	spin_unlock_irqrestore(&prcmu_val_async_lock, flags);
+
+	return pending;
+}
+
+static void prcmu_val_async_work(struct work_struct *work)
+{
+	struct prcmu_val_async *req =
+		container_of(work, struct prcmu_val_async, work);
+	enum prcmu_val type = req - prcmu_val_async;
+	prcmu_val_complete_t complete;
+	void *data;
+	u8 value;
+	int r;
+
+	if (!prcmu_val_async_take(req, &value, &complete, &data))
+		return;
+
+	r = dbx500_prcmu_context.set_val(type, value);
+	if (complete)
+		complete(type, value, r, data);
+}
+
+/**
+ * prcmu_set_val_async - request an OPP change without waiting for it
+ * @type: the OPP to change
+ * @value: the new OPP
+ * @complete: called with the result once the firmware acked, may be NULL
+ * @data: passed to @complete
+ *
+ * @complete runs in process context and must not wait for other
+ * requests of @type.
+ */
+int prcmu_set_val_async(enum prcmu_val type, u8 value,
+			prcmu_val_complete_t complete, void *data)
+{
+	struct prcmu_val_async *req;
+	prcmu_val_complete_t old_complete = NULL;
+	void *old_data = NULL;
+	unsigned long flags;
+	u8 old_value = 0;
+	bool superseded;
+	int r;
+
+	if (type >= PRCMU_VAL_MAX)
+		return -EINVAL;
+
+	if (!prcmu_val_wq) {
+		r = dbx500_prcmu_context.set_val(type, value);
+		if (complete)
+			complete(type, value, r, data);
+		return r;
+	}
+
+	req = &prcmu_val_async[type];
+
+	spin_lock_irqsave(&prcmu_val_async_lock, flags);
+	superseded = req->pending;
+	if (superseded) {
+		old_value = req->value;
+		old_complete = req->complete;
+		old_data = req->data;
+	}
+	req->pending = true;
+	req->value = value;
+	req->complete = complete;
+	req->data = data;
+	spin_unlock_irqrestore(&prcmu_val_async_lock, flags);
+
+	queue_work(prcmu_val_wq, &req->work);
+
+	if (superseded && old_complete)
+		old_complete(type, old_value, -ECANCELED, old_data);
+
+	return 0;
+}
+EXPORT_SYMBOL(prcmu_set_val_async);
+
+/**
+ * prcmu_cancel_val_async - drop the pending request for an OPP
+ * @type: the OPP
+ *
+ * Waits for a request the worker already sent to the firmware, so that a
+ * synchronous change made afterwards is not overwritten by it.
+ */
+void prcmu_cancel_val_async(enum prcmu_val type)
+{
+	struct prcmu_val_async *req;
+	prcmu_val_complete_t complete;
+	void *data;
+	u8 value;
+
+	if (type >= PRCMU_VAL_MAX || !prcmu_val_wq)
+		return;
+
+	req = &prcmu_val_async[type];
+	if (prcmu_val_async_take(req, &value, &complete, &data) && complete)
+		complete(type, value, -ECANCELED, data);
+	flush_work(&req->work);
+}
+EXPORT_SYMBOL(prcmu_cancel_val_async);
+
+/**
+ * prcmu_flush_val_async - wait until the pending request for an OPP is done
+ * @type: the OPP
+ */
+void prcmu_flush_val_async(enum prcmu_val type)
+{
+	if (type >= PRCMU_VAL_MAX || !prcmu_val_wq)
+		return;
+
+	flush_work(&prcmu_val_async[type].work);
+}
+EXPORT_SYMBOL(prcmu_flush_val_async);
+
 int prcmu_enable_out(enum prcmu_out out)
 {
 	return dbx500_prcmu_context.enable(out);
@@ -767,6 +919,14 @@ static struct platform_driver dbx500_prcmu_driver __refdata = {
 
 static int __init dbx500_prcmu_init(void)
 {
+	int i;
+
+	for (i = 0; i < PRCMU_VAL_MAX; i++)
+		INIT_WORK(&prcmu_val_async[i].work, prcmu_val_async_work);
+	prcmu_val_wq = alloc_ordered_workqueue("prcmu_opp", 0);
+	if (!prcmu_val_wq)
+		dbx500_prcmu_error("no async opp workqueue");
+
 	return platform_driver_register(&dbx500_prcmu_driver);
 }
 
@@ -40,11 +40,16 @@
 #include <video/mcde.h>
 #include <video/b2r2_blt.h>
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/compdev.h>
+
 #define NUM_COMPDEV_BUFS 2
 
 static LIST_HEAD(dev_list);
 static DEFINE_MUTEX(dev_list_lock);
 static int dev_counter;
+/* Ids of the frames posted, for tracing */
+static atomic_t frame_seq = ATOMIC_INIT(0);
 
 struct compdev_buffer {
 	struct hwmem_alloc *alloc;
@@ -64,6 +69,7 @@ struct compdev_display_work {
 	int blt_handle;
 	int b2r2_req_id;
 	enum compdev_transform  mcde_transform;
+	u32 frame;
 };
 
 struct dss_context {
@@ -92,6 +98,7 @@ struct compdev {
 	post_scene_info_callback si_cb;
 	size_changed_callback sc_cb;
 	struct compdev_scene_info s_info;
+	u32 frame;
 	u8 sync_count;
 	u8 image_count;
 	struct compdev_img images[NUM_COMPDEV_BUFS];
@@ -590,6 +597,8 @@ static int compdev_blt(struct compdev *cd,
 		dev_err(cd->dev,
 			"%s: Failed b2r2_blt_request (%d), blt_handle %d\n",
 			__func__, req_id, blt_handle);
+	} else {
+		trace_compdev_blit(cd->frame, req_id);
 	}
 
 	return req_id;
@@ -597,7 +606,8 @@ static int compdev_blt(struct compdev *cd,
 
 static int compdev_post_buffers_dss(struct dss_context *dss_ctx,
 		struct compdev_img *img1, struct compdev_img *img2,
-		bool tripple_buffer, enum compdev_transform mcde_transform)
+		bool tripple_buffer, enum compdev_transform mcde_transform,
+		u32 frame)
 {
 	int ret = 0;
 	int i = 0;
@@ -678,6 +688,8 @@ static int compdev_post_buffers_dss(struct dss_context *dss_ctx,
 	/* Do the display update */
 	for (i = 0; i < 2; i++) {
 		if (update_ovly[i]) {
+			mcde_dss_set_frame_id(dss_ctx->ddev, frame);
+			trace_compdev_commit(frame, dss_ctx->ddev->chnl_id);
 			mcde_dss_update_overlay(dss_ctx->ovly[i],
 					tripple_buffer);
 			break;
@@ -706,11 +718,11 @@ static void compdev_display_worker_function(struct work_struct *w)
 	if (dw->img_count == 1)
 		compdev_post_buffers_dss(dw->dss_ctx,
 				&dw->img1, NULL, false,
-				dw->mcde_transform);
+				dw->mcde_transform, dw->frame);
 	else if (dw->img_count == 2)
 		compdev_post_buffers_dss(dw->dss_ctx,
 				&dw->img1, &dw->img2, false,
-				dw->mcde_transform);
+				dw->mcde_transform, dw->frame);
 
 	if (dw->img1_alloc != NULL) {
 		hwmem_release(dw->img1_alloc);
@@ -768,6 +780,7 @@ int compdev_add_display_work(struct compdev *cd,
 
 	dw->dss_ctx = dss_ctx;
 	dw->mcde_transform = cd->mcde_transform;
+	dw->frame = cd->frame;
 	queue_work(cd->display_worker_thread, &dw->work);
 
 	return 0;
@@ -803,6 +816,55 @@ static bool transform_needed(struct compdev_img *src_img,
 	return false;
 }
 
+/*
+ * A single YUV overlay covering the whole display, typically fullscreen
+ * video, can be rotated by MCDE instead of B2R2. The image rotation is
+ * folded into the channel rotation, and the overlay is scanned out as is
+ * with MCDE doing the colour conversion.
+ */
+static void compdev_try_ovly_rotation(struct compdev *cd,
+		struct compdev_img *src_img)
+{
+	int rot = to_degree(src_img->transform);
+	enum compdev_transform tot_trans;
+	struct compdev_rect *dst_rect = &src_img->dst_rect;
+	u16 width;
+	u16 height;
+
+	if (!cd->mcde_rotation || cd->s_info.img_count != 1 ||
+			cd->s_info.reuse_fb_img || cd->sync_count != 1)
+		return;
+
+	if (!(src_img->flags & COMPDEV_OVERLAY_FLAG) ||
+			src_img->fmt != COMPDEV_FMT_YUV422 ||
+			src_img->transform == COMPDEV_TRANSFORM_ROT_0 ||
+			to_transform(rot) != src_img->transform)
+		return;
+
+	/* The destination, in display coordinates, must be the whole display */
+	mcde_dss_get_native_resolution(cd->dss_ctx.ddev, &width, &height);
+	if (dst_rect->x != 0 || dst_rect->y != 0 ||
+			dst_rect->width != width || dst_rect->height != height)
+		return;
+
+	tot_trans = to_transform((to_degree(cd->mcde_transform) + rot) % 360);
+
+	/* No scaling, MCDE can't scale */
+	if ((tot_trans & COMPDEV_TRANSFORM_ROT_90_CW) ?
+			(src_img->src_rect.width != height ||
+			src_img->src_rect.height != width) :
+			(src_img->src_rect.width != width ||
+			src_img->src_rect.height != height))
+		return;
+
+	dev_dbg(cd->dev, "%s: MCDE rotation %d (image %d)\n", __func__,
+			to_degree(tot_trans), rot);
+
+	/* Reset by the next scene info */
+	cd->mcde_transform = tot_trans;
+	src_img->transform = COMPDEV_TRANSFORM_ROT_0;
+}
+
 /* Remove GPU transform if using MCDE rotation */
 static void update_transform(struct compdev *cd,
 		struct compdev_img *src_img)
@@ -891,6 +953,38 @@ static int compdev_reuse_fb(struct compdev *cd, struct compdev_img **image1,
 	return 0;
 }
 
+/*
+ * A dma-buf of a hwmem buffer is turned into the hwmem buffer name while the
+ * fd is still valid, in the context of the posting process. The rest of
+ * compdev, the workers and the listeners, then handle it as any hwmem buffer.
+ */
+static int compdev_resolve_dma_buf(struct compdev *cd,
+		struct compdev_img *img)
+{
+	struct hwmem_alloc *alloc;
+	s32 name;
+
+	if (img->buf.type != COMPDEV_PTR_DMA_BUF_FD_OFFSET)
+		return 0;
+
+	alloc = hwmem_resolve_by_dma_buf_fd(img->buf.fd);
+	if (IS_ERR(alloc)) {
+		dev_warn(cd->dev, "%s: Not a hwmem dma-buf, fd %d\n",
+				__func__, img->buf.fd);
+		return PTR_ERR(alloc);
+	}
+
+	name = hwmem_get_name(alloc);
+	hwmem_release(alloc);
+	if (name < 0)
+		return name;
+
+	img->buf.type = COMPDEV_PTR_HWMEM_BUF_NAME_OFFSET;
+	img->buf.hwmem_buf_name = name;
+
+	return 0;
+}
+
 static int compdev_post_buffer_locked(struct compdev *cd,
 		struct compdev_img *src_img)
 {
@@ -916,6 +1010,8 @@ static int compdev_post_buffer_locked(struct compdev *cd,
 	update_transform(cd, src_img);
 
 	if (!bypass_case) {
+		compdev_try_ovly_rotation(cd, src_img);
+
 		if (transform_needed(src_img, cd->mcde_transform)) {
 			u16 width = 0;
 			u16 height = 0;
@@ -1035,7 +1131,7 @@ static int compdev_post_buffer_locked(struct compdev *cd,
 			/* Do the refresh */
 			compdev_post_buffers_dss(&cd->dss_ctx,
 					img[0], img[1],
-					true, cd->mcde_transform);
+					true, cd->mcde_transform, cd->frame);
 
 			/*
 			 * Free references to the temp buffers,
@@ -1091,6 +1187,11 @@ static int compdev_post_single_buffer_asynch_locked(struct compdev *cd,
 		cd->display_work = NULL;
 	}
 
+	cd->frame = atomic_inc_return(&frame_seq);
+	trace_compdev_frame(cd->dev_index, cd->frame, 1);
+	if (b2r2_req_id >= 0)
+		trace_compdev_blit(cd->frame, b2r2_req_id);
+
 	cd->display_work = kzalloc(sizeof(*cd->display_work),
 			GFP_KERNEL);
 	if (cd->display_work != NULL) {
@@ -1122,6 +1223,8 @@ static int compdev_post_scene_info_locked(struct compdev *cd,
 
 	cd->s_info = *s_info;
 	cd->sync_count = cd->s_info.img_count;
+	cd->frame = atomic_inc_return(&frame_seq);
+	trace_compdev_frame(cd->dev_index, cd->frame, s_info->img_count);
 
 	if (cd->mcde_rotation) {
 		if (cd->sync_count >= 1 || cd->s_info.reuse_fb_img) {
@@ -1270,7 +1373,9 @@ static long compdev_ioctl(struct file *file,
 			mutex_unlock(&cd->lock);
 			return -EFAULT;
 		}
-		ret = compdev_post_buffer_locked(cd, &img);
+		ret = compdev_resolve_dma_buf(cd, &img);
+		if (ret == 0)
+			ret = compdev_post_buffer_locked(cd, &img);
 		mutex_unlock(&cd->lock);
 		break;
 	case COMPDEV_POST_SCENE_INFO_IOC:
@@ -10,6 +10,8 @@
  */
 
 #include <linux/hwmem.h>
+#include <linux/bitmap.h>
+#include <linux/log2.h>
 
 #include <asm/pgtable.h>
 
@@ -58,6 +60,15 @@ static u32 range_length(struct cach_range *range);
 static void region_2_range(struct hwmem_region *region, u32 buffer_size,
 						struct cach_range *range);
 
+static void init_dirty_map(struct cach_buf *buf);
+/* Marks the lines of region that are inside limit as dirty */
+static void mark_region_dirty(struct cach_buf *buf,
+		struct hwmem_region *region, struct cach_range *limit);
+/* Only chunks entirely inside range are cleared */
+static void clear_dirty(struct cach_buf *buf, struct cach_range *range);
+static void clear_all_dirty(struct cach_buf *buf);
+static void update_dirty_range(struct cach_buf *buf);
+
 static void *offset_2_vaddr(struct cach_buf *buf, u32 offset);
 static u32 offset_2_paddr(struct cach_buf *buf, u32 offset);
 
@@ -79,6 +90,8 @@ void cach_init_buf(struct cach_buf *buf,
 	buf->mem_type = mem_type;
 
 	buf->cache_settings = cachi_get_cache_settings(cache_settings);
+
+	init_dirty_map(buf);
 }
 
 void cach_set_buf_addrs(struct cach_buf *buf, void* vaddr, u32 paddr)
@@ -97,17 +110,15 @@ void cach_set_buf_addrs(struct cach_buf *buf, void* vaddr, u32 paddr)
 		buf->range_in_cpu_cache.end = buf->size;
 		align_range_up(&buf->range_in_cpu_cache,
 						get_dcache_granularity());
-		buf->range_dirty_in_cpu_cache.start = 0;
-		buf->range_dirty_in_cpu_cache.end = buf->size;
-		align_range_up(&buf->range_dirty_in_cpu_cache,
-						get_dcache_granularity());
+		bitmap_fill(buf->dirty_map, CACH_DIRTY_CHUNKS);
+		update_dirty_range(buf);
 	} else {
 		flush_cpu_dcache(buf->vstart, buf->pstart, buf->size, false,
 									&tmp);
 		drain_cpu_write_buf();
 
 		null_range(&buf->range_in_cpu_cache);
-		null_range(&buf->range_dirty_in_cpu_cache);
+		clear_all_dirty(buf);
 	}
 	null_range(&buf->range_invalid_in_cpu_cache);
 }
@@ -229,8 +240,12 @@ static void sync_buf_pre_cpu(struct cach_buf *buf, enum hwmem_access access,
 				intersect_range(&buf->range_in_cpu_cache,
 					&region_range, &dirty_range_addition);
 
-			expand_range(&buf->range_dirty_in_cpu_cache,
-							&dirty_range_addition);
+			/*
+			 * Track the lines of the region rather than its
+			 * bounding range, a sub rectangle of an image then
+			 * only costs its own lines when it is cleaned.
+			 */
+			mark_region_dirty(buf, region, &dirty_range_addition);
 		}
 	}
 	if (buf->cache_settings & HWMEM_ALLOC_HINT_WRITE_COMBINE) {
@@ -304,7 +319,7 @@ static void invalidate_cpu_cache(struct cach_buf *buf, struct cach_range *range)
 
 		if (flushed_everything) {
 			null_range(&buf->range_invalid_in_cpu_cache);
-			null_range(&buf->range_dirty_in_cpu_cache);
+			clear_all_dirty(buf);
 		} else {
 			/*
 			 * No need to shrink range_in_cpu_cache as invalidate
@@ -320,11 +335,27 @@ static void invalidate_cpu_cache(struct cach_buf *buf, struct cach_range *range)
 static void clean_cpu_cache(struct cach_buf *buf, struct cach_range *range)
 {
 	struct cach_range intersection;
+	u32 chunk_size = 1 << buf->dirty_chunk_shift;
+	u32 first, last, chunk, dirty_len;
+	bool cleaned_everything = false;
 
 	intersect_range(&buf->range_dirty_in_cpu_cache, range, &intersection);
-	if (is_non_empty_range(&intersection)) {
-		bool cleaned_everything;
+	if (!is_non_empty_range(&intersection))
+		return;
 
+	first = intersection.start >> buf->dirty_chunk_shift;
+	last = (intersection.end - 1) >> buf->dirty_chunk_shift;
+	dirty_len = 0;
+	for (chunk = first; chunk <= last; chunk++)
+		if (test_bit(chunk, buf->dirty_map))
+			dirty_len += chunk_size;
+
+	if (dirty_len >= get_dcache_clean_all_length() ||
+			dirty_len >= range_length(&intersection)) {
+		/*
+		 * Either everything is dirty or a clean of the entire cache is
+		 * cheaper than cleaning the dirty parts one by one.
+		 */
 		expand_range_2_edge(&intersection,
 					&buf->range_dirty_in_cpu_cache);
 
@@ -335,16 +366,41 @@ static void clean_cpu_cache(struct cach_buf *buf, struct cach_range *range)
 				buf->cache_settings &
 					HWMEM_ALLOC_HINT_INNER_CACHE_ONLY,
 							&cleaned_everything);
+	} else {
+		/* Clean each run of dirty chunks inside intersection */
+		chunk = find_next_bit(buf->dirty_map, last + 1, first);
+		while (chunk <= last) {
+			u32 end_chunk = find_next_zero_bit(buf->dirty_map,
+							last + 1, chunk);
+			struct cach_range run = {
+				.start = chunk << buf->dirty_chunk_shift,
+				.end = end_chunk << buf->dirty_chunk_shift,
+			};
+			struct cach_range run_l;
+			bool tmp;
+
+			intersect_range(&run, &intersection, &run_l);
+
+			clean_cpu_dcache(
+				offset_2_vaddr(buf, run_l.start),
+				offset_2_paddr(buf, run_l.start),
+				range_length(&run_l),
+				buf->cache_settings &
+					HWMEM_ALLOC_HINT_INNER_CACHE_ONLY,
+							&tmp);
 
-		if (cleaned_everything)
-			null_range(&buf->range_dirty_in_cpu_cache);
-		else
-			shrink_range(&buf->range_dirty_in_cpu_cache,
-								&intersection);
-
-		if (buf->mem_type == HWMEM_MEM_SCATTERED_SYS)
-			outer_flush_all();
+			chunk = find_next_bit(buf->dirty_map, last + 1,
+								end_chunk);
+		}
 	}
+
+	if (cleaned_everything)
+		clear_all_dirty(buf);
+	else
+		clear_dirty(buf, &intersection);
+
+	if (buf->mem_type == HWMEM_MEM_SCATTERED_SYS)
+		outer_flush_all();
 }
 
 static void flush_cpu_cache(struct cach_buf *buf, struct cach_range *range)
@@ -368,14 +424,13 @@ static void flush_cpu_cache(struct cach_buf *buf, struct cach_range *range)
 		if (flushed_everything) {
 			if (!speculative_data_prefetch())
 				null_range(&buf->range_in_cpu_cache);
-			null_range(&buf->range_dirty_in_cpu_cache);
+			clear_all_dirty(buf);
 			null_range(&buf->range_invalid_in_cpu_cache);
 		} else {
 			if (!speculative_data_prefetch())
 				shrink_range(&buf->range_in_cpu_cache,
 							 &intersection);
-			shrink_range(&buf->range_dirty_in_cpu_cache,
-								&intersection);
+			clear_dirty(buf, &intersection);
 			shrink_range(&buf->range_invalid_in_cpu_cache,
 								&intersection);
 		}
@@ -478,6 +533,107 @@ static void region_2_range(struct hwmem_region *region, u32 buffer_size,
 	align_range_up(range, get_dcache_granularity());
 }
 
+static void init_dirty_map(struct cach_buf *buf)
+{
+	u32 shift = ilog2(get_dcache_granularity());
+
+	while (shift < 31 && (buf->size >> shift) >= CACH_DIRTY_CHUNKS)
+		shift++;
+
+	buf->dirty_chunk_shift = shift;
+	clear_all_dirty(buf);
+}
+
+static void mark_region_dirty(struct cach_buf *buf,
+		struct hwmem_region *region, struct cach_range *limit)
+{
+	u32 i;
+
+	if (!is_non_empty_range(limit))
+		return;
+
+	/*
+	 * Lines closer than a chunk end up in the same or neighbouring chunks
+	 * anyway. Region sanity is not checked, see region_2_range().
+	 */
+	if (region->size < (1 << buf->dirty_chunk_shift) ||
+				region->end <= region->start) {
+		bitmap_set(buf->dirty_map,
+			limit->start >> buf->dirty_chunk_shift,
+			((limit->end - 1) >> buf->dirty_chunk_shift) -
+			(limit->start >> buf->dirty_chunk_shift) + 1);
+	} else {
+		for (i = 0; i < region->count; i++) {
+			struct cach_range line;
+			struct cach_range line_l;
+
+			line.start = region->offset + i * region->size +
+								region->start;
+			line.end = region->offset + i * region->size +
+								region->end;
+			if (line.start >= limit->end)
+				break;
+
+			intersect_range(&line, limit, &line_l);
+			if (!is_non_empty_range(&line_l))
+				continue;
+
+			bitmap_set(buf->dirty_map,
+				line_l.start >> buf->dirty_chunk_shift,
+				((line_l.end - 1) >> buf->dirty_chunk_shift) -
+				(line_l.start >> buf->dirty_chunk_shift) + 1);
+		}
+	}
+
+	update_dirty_range(buf);
+}
+
+static void clear_dirty(struct cach_buf *buf, struct cach_range *range)
+{
+	u32 chunk_size = 1 << buf->dirty_chunk_shift;
+	u32 first;
+	u32 end;
+
+	if (!is_non_empty_range(range))
+		return;
+
+	first = align_up(range->start, chunk_size) >> buf->dirty_chunk_shift;
+	/* The last chunk may be cut short by the end of the buffer */
+	if (range->end >= buf->size)
+		end = DIV_ROUND_UP(buf->size, chunk_size);
+	else
+		end = range->end >> buf->dirty_chunk_shift;
+
+	if (end > first)
+		bitmap_clear(buf->dirty_map, first, end - first);
+
+	update_dirty_range(buf);
+}
+
+static void clear_all_dirty(struct cach_buf *buf)
+{
+	bitmap_zero(buf->dirty_map, CACH_DIRTY_CHUNKS);
+	null_range(&buf->range_dirty_in_cpu_cache);
+}
+
+static void update_dirty_range(struct cach_buf *buf)
+{
+	u32 first = find_first_bit(buf->dirty_map, CACH_DIRTY_CHUNKS);
+	u32 last;
+
+	if (first >= CACH_DIRTY_CHUNKS) {
+		null_range(&buf->range_dirty_in_cpu_cache);
+		return;
+	}
+	last = find_last_bit(buf->dirty_map, CACH_DIRTY_CHUNKS);
+
+	buf->range_dirty_in_cpu_cache.start = first << buf->dirty_chunk_shift;
+	buf->range_dirty_in_cpu_cache.end = min((last + 1) <<
+				buf->dirty_chunk_shift, buf->size);
+	align_range_up(&buf->range_dirty_in_cpu_cache,
+						get_dcache_granularity());
+}
+
 static void *offset_2_vaddr(struct cach_buf *buf, u32 offset)
 {
 	return (void *)((u32)buf->vstart + offset);
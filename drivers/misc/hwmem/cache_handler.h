@@ -31,6 +31,12 @@ struct cach_range {
 	u32 end; /* Exclusive */
 };
 
+/*
+ * Number of chunks the dirty map splits a buffer in. A chunk is at least a
+ * cache line, larger buffers get larger chunks.
+ */
+#define CACH_DIRTY_CHUNKS 256
+
 /*
  * Internal, do not touch!
  */
@@ -47,6 +53,13 @@ struct cach_buf {
 	struct cach_range range_in_cpu_cache;
 	struct cach_range range_dirty_in_cpu_cache;
 	struct cach_range range_invalid_in_cpu_cache;
+
+	/*
+	 * Chunks that might be dirty in the CPU cache,
+	 * range_dirty_in_cpu_cache always spans all of them.
+	 */
+	u32 dirty_chunk_shift;
+	DECLARE_BITMAP(dirty_map, CACH_DIRTY_CHUNKS);
 };
 
 void cach_init_buf(struct cach_buf *buf, enum hwmem_mem_type,
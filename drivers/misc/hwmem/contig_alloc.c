@@ -12,23 +12,36 @@
 #include <linux/kernel.h>
 #include <linux/err.h>
 #include <linux/list.h>
+#include <linux/rbtree.h>
 #include <linux/slab.h>
 #include <linux/mm.h>
 #include <linux/debugfs.h>
 #include <linux/uaccess.h>
 #include <linux/module.h>
+#include <linux/math64.h>
 #include <linux/vmalloc.h>
 #include <linux/pasr.h>
+#include <linux/device.h>
+#include <linux/dma-contiguous.h>
 #include <asm/sizes.h>
 
 #define MAX_INSTANCE_NAME_LENGTH 31
 
 struct alloc {
+	/* Address ordered, holds both free and used blocks */
 	struct list_head list;
+	/* Only valid when !in_use, see instance->free_tree */
+	struct rb_node free_node;
 
 	bool in_use;
 	phys_addr_t paddr;
 	size_t size;
+
+#ifdef CONFIG_HWMEM_CMA
+	/* Only used by instances backed by a CMA area */
+	struct page *pages;
+	struct vm_struct *vm_area;
+#endif /* #ifdef CONFIG_HWMEM_CMA */
 };
 
 struct instance {
@@ -41,6 +54,20 @@ struct instance {
 	size_t region_size;
 
 	struct list_head alloc_list;
+	/* Free blocks ordered by size, then address */
+	struct rb_root free_tree;
+	unsigned int free_count;
+	size_t free_size;
+
+#ifdef CONFIG_HWMEM_CMA
+	/*
+	 * Device owning the CMA area the region is made of, NULL if the
+	 * region is a carveout. A CMA backed instance only keeps the
+	 * allocations that are in use in alloc_list, the free parts of the
+	 * region belong to the page allocator.
+	 */
+	struct device *cma_dev;
+#endif /* #ifdef CONFIG_HWMEM_CMA */
 
 #ifdef CONFIG_DEBUG_FS
 	struct inode *debugfs_inode;
@@ -59,6 +86,9 @@ static DEFINE_MUTEX(lock);
 
 void *cona_create(const char *name, phys_addr_t region_paddr,
 							size_t region_size);
+#ifdef CONFIG_HWMEM_CMA
+void *cona_create_cma(const char *name, struct device *dev);
+#endif /* #ifdef CONFIG_HWMEM_CMA */
 void *cona_alloc(void *instance, size_t size);
 void cona_free(void *instance, void *alloc);
 phys_addr_t cona_get_alloc_paddr(void *alloc);
@@ -69,10 +99,21 @@ static int init_alloc_list(struct instance *instance);
 static void clean_alloc_list(struct instance *instance);
 static struct alloc *find_free_alloc_bestfit(struct instance *instance,
 								size_t size);
-static struct alloc *split_allocation(struct alloc *alloc,
-							size_t new_alloc_size);
+static struct alloc *split_allocation(struct instance *instance,
+				struct alloc *alloc, size_t new_alloc_size);
 static phys_addr_t get_alloc_offset(struct instance *instance,
 							struct alloc *alloc);
+static void insert_free_alloc(struct instance *instance, struct alloc *alloc);
+static void erase_free_alloc(struct instance *instance, struct alloc *alloc);
+#ifdef CONFIG_HWMEM_CMA
+static struct alloc *cma_alloc_l(struct instance *instance, size_t size);
+static void cma_free_l(struct instance *instance, struct alloc *alloc);
+
+static inline bool is_cma_instance(struct instance *instance)
+{
+	return instance->cma_dev != NULL;
+}
+#endif /* #ifdef CONFIG_HWMEM_CMA */
 
 void *cona_create(const char *name, phys_addr_t region_paddr,
 							size_t region_size)
@@ -135,6 +176,7 @@ void *cona_create(const char *name, phys_addr_t region_paddr,
 	pasr_put(instance->region_paddr, instance->region_size);
 
 	INIT_LIST_HEAD(&instance->alloc_list);
+	instance->free_tree = RB_ROOT;
 	ret = init_alloc_list(instance);
 	if (ret < 0)
 		goto init_alloc_list_failed;
@@ -159,6 +201,44 @@ vmem_alloc_failed:
 	return ERR_PTR(ret);
 }
 
+#ifdef CONFIG_HWMEM_CMA
+void *cona_create_cma(const char *name, struct device *dev)
+{
+	struct instance *instance;
+	struct cma *cma = dev_get_cma_area(dev);
+
+	if (cma == NULL)
+		return ERR_PTR(-ENODEV);
+
+	instance = kzalloc(sizeof(*instance), GFP_KERNEL);
+	if (instance == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	memcpy(instance->name, name, MAX_INSTANCE_NAME_LENGTH + 1);
+	/* Truncate name if necessary */
+	instance->name[MAX_INSTANCE_NAME_LENGTH] = '\0';
+	instance->region_paddr = cma_get_base(cma);
+	instance->region_size = cma_get_size(cma);
+	instance->cma_dev = dev;
+	instance->free_tree = RB_ROOT;
+
+	/*
+	 * No kernel virtual region and no PASR bookkeeping here, the pages
+	 * are owned by the page allocator until they are allocated.
+	 */
+	INIT_LIST_HEAD(&instance->alloc_list);
+
+	pr_info("hwmem: %s backed by CMA, start: 0x%08x, size: %u\n",
+		name, instance->region_paddr, instance->region_size);
+
+	mutex_lock(&lock);
+	list_add_tail(&instance->list, &instance_list);
+	mutex_unlock(&lock);
+
+	return instance;
+}
+#endif /* #ifdef CONFIG_HWMEM_CMA */
+
 void *cona_alloc(void *instance, size_t size)
 {
 	struct instance *instance_l = (struct instance *)instance;
@@ -167,16 +247,22 @@ void *cona_alloc(void *instance, size_t size)
 	if (size == 0)
 		return ERR_PTR(-EINVAL);
 
+#ifdef CONFIG_HWMEM_CMA
+	if (is_cma_instance(instance_l))
+		return cma_alloc_l(instance_l, size);
+#endif /* #ifdef CONFIG_HWMEM_CMA */
+
 	mutex_lock(&lock);
 
 	alloc = find_free_alloc_bestfit(instance_l, size);
 	if (IS_ERR(alloc))
 		goto out;
 	if (size < alloc->size) {
-		alloc = split_allocation(alloc, size);
+		alloc = split_allocation(instance_l, alloc, size);
 		if (IS_ERR(alloc))
 			goto out;
 	} else {
+		erase_free_alloc(instance_l, alloc);
 		alloc->in_use = true;
 	}
 
@@ -201,6 +287,13 @@ void cona_free(void *instance, void *alloc)
 	struct alloc *alloc_l = (struct alloc *)alloc;
 	struct alloc *other;
 
+#ifdef CONFIG_HWMEM_CMA
+	if (is_cma_instance(instance_l)) {
+		cma_free_l(instance_l, alloc_l);
+		return;
+	}
+#endif /* #ifdef CONFIG_HWMEM_CMA */
+
 	mutex_lock(&lock);
 
 	alloc_l->in_use = false;
@@ -211,9 +304,15 @@ void cona_free(void *instance, void *alloc)
 	instance_l->cona_status_max_cont -= alloc_l->size;
 #endif /* #ifdef CONFIG_DEBUG_FS */
 
+	/*
+	 * alloc_list is address ordered so only the direct neighbours can be
+	 * merged with. The merged block changes size and is therefore
+	 * reinserted in the free tree.
+	 */
 	other = list_entry(alloc_l->list.prev, struct alloc, list);
 	if ((alloc_l->list.prev != &instance_l->alloc_list) &&
 							!other->in_use) {
+		erase_free_alloc(instance_l, other);
 		other->size += alloc_l->size;
 		list_del(&alloc_l->list);
 		kfree(alloc_l);
@@ -222,10 +321,12 @@ void cona_free(void *instance, void *alloc)
 	other = list_entry(alloc_l->list.next, struct alloc, list);
 	if ((alloc_l->list.next != &instance_l->alloc_list) &&
 							!other->in_use) {
+		erase_free_alloc(instance_l, other);
 		alloc_l->size += other->size;
 		list_del(&other->list);
 		kfree(other);
 	}
+	insert_free_alloc(instance_l, alloc_l);
 
 	mutex_unlock(&lock);
 }
@@ -239,6 +340,25 @@ void *cona_get_alloc_kaddr(void *instance, void *alloc)
 {
 	struct instance *instance_l = (struct instance *)instance;
 
+#ifdef CONFIG_HWMEM_CMA
+	if (is_cma_instance(instance_l)) {
+		struct alloc *alloc_l = (struct alloc *)alloc;
+
+		/*
+		 * The caller maps the buffer itself, all it needs is a piece
+		 * of kernel virtual address space to map it into.
+		 */
+		if (alloc_l->vm_area == NULL) {
+			alloc_l->vm_area = get_vm_area(alloc_l->size,
+								VM_IOREMAP);
+			if (alloc_l->vm_area == NULL)
+				return ERR_PTR(-ENOMEM);
+		}
+
+		return alloc_l->vm_area->addr;
+	}
+#endif /* #ifdef CONFIG_HWMEM_CMA */
+
 	return instance_l->region_kaddr + get_alloc_offset(instance_l,
 							(struct alloc *)alloc);
 }
@@ -281,6 +401,7 @@ static int init_alloc_list(struct instance *instance)
 								PAGE_SIZE;
 			alloc->in_use = false;
 			list_add_tail(&alloc->list, &instance->alloc_list);
+			insert_free_alloc(instance, alloc);
 			curr_pos = alloc->paddr + alloc->size;
 		}
 
@@ -311,6 +432,7 @@ static int init_alloc_list(struct instance *instance)
 	alloc->size = region_end - curr_pos;
 	alloc->in_use = false;
 	list_add_tail(&alloc->list, &instance->alloc_list);
+	insert_free_alloc(instance, alloc);
 
 	return 0;
 
@@ -330,29 +452,38 @@ static void clean_alloc_list(struct instance *instance)
 
 		kfree(i);
 	}
+
+	instance->free_tree = RB_ROOT;
+	instance->free_count = 0;
+	instance->free_size = 0;
 }
 
 static struct alloc *find_free_alloc_bestfit(struct instance *instance,
 								size_t size)
 {
-	size_t best_diff = ~(size_t)0;
-	struct alloc *alloc = NULL, *i;
+	struct rb_node *node = instance->free_tree.rb_node;
+	struct alloc *alloc = NULL;
 
-	list_for_each_entry(i, &instance->alloc_list, list) {
-		size_t diff = i->size - size;
-		if (i->in_use || i->size < size)
-			continue;
-		if (diff < best_diff) {
+	/*
+	 * Smallest block that is large enough, the lowest addressed one if
+	 * there are several of that size.
+	 */
+	while (node != NULL) {
+		struct alloc *i = rb_entry(node, struct alloc, free_node);
+
+		if (i->size < size) {
+			node = node->rb_right;
+		} else {
 			alloc = i;
-			best_diff = diff;
+			node = node->rb_left;
 		}
 	}
 
 	return alloc != NULL ? alloc : ERR_PTR(-ENOMEM);
 }
 
-static struct alloc *split_allocation(struct alloc *alloc,
-							size_t new_alloc_size)
+static struct alloc *split_allocation(struct instance *instance,
+				struct alloc *alloc, size_t new_alloc_size)
 {
 	struct alloc *new_alloc;
 
@@ -363,8 +494,11 @@ static struct alloc *split_allocation(struct alloc *alloc,
 	new_alloc->in_use = true;
 	new_alloc->paddr = alloc->paddr;
 	new_alloc->size = new_alloc_size;
+
+	erase_free_alloc(instance, alloc);
 	alloc->size -= new_alloc_size;
 	alloc->paddr += new_alloc_size;
+	insert_free_alloc(instance, alloc);
 
 	list_add_tail(&new_alloc->list, &alloc->list);
 
@@ -377,6 +511,127 @@ static phys_addr_t get_alloc_offset(struct instance *instance,
 	return alloc->paddr - instance->region_paddr;
 }
 
+static void insert_free_alloc(struct instance *instance, struct alloc *alloc)
+{
+	struct rb_node **new = &instance->free_tree.rb_node;
+	struct rb_node *parent = NULL;
+
+	while (*new != NULL) {
+		struct alloc *i = rb_entry(*new, struct alloc, free_node);
+
+		parent = *new;
+		if (alloc->size < i->size ||
+			(alloc->size == i->size && alloc->paddr < i->paddr))
+			new = &(*new)->rb_left;
+		else
+			new = &(*new)->rb_right;
+	}
+
+	rb_link_node(&alloc->free_node, parent, new);
+	rb_insert_color(&alloc->free_node, &instance->free_tree);
+
+	instance->free_count++;
+	instance->free_size += alloc->size;
+}
+
+static void erase_free_alloc(struct instance *instance, struct alloc *alloc)
+{
+	rb_erase(&alloc->free_node, &instance->free_tree);
+
+	instance->free_count--;
+	instance->free_size -= alloc->size;
+}
+
+#ifdef CONFIG_HWMEM_CMA
+static struct alloc *cma_alloc_l(struct instance *instance, size_t size)
+{
+	struct alloc *alloc;
+	struct page *pages;
+	int count;
+	phys_addr_t paddr;
+
+	size = PAGE_ALIGN(size);
+	count = size >> PAGE_SHIFT;
+
+	alloc = kzalloc(sizeof(struct alloc), GFP_KERNEL);
+	if (alloc == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	/*
+	 * Allocate without holding the lock, migrating the movable pages out
+	 * of the way can take a while.
+	 */
+	pages = dma_alloc_from_contiguous(instance->cma_dev, count,
+							get_order(size));
+	if (pages == NULL)
+		goto no_mem;
+
+	/*
+	 * B2R2 can't handle buffers crossing a 64MiB boundary, see
+	 * init_alloc_list(). Retry naturally aligned if we got one, that will
+	 * never cross as long as the buffer is smaller than 64MiB.
+	 */
+	paddr = page_to_phys(pages);
+	if ((paddr & ~(SZ_64M - 1)) != ((paddr + size - 1) & ~(SZ_64M - 1))) {
+		dma_release_from_contiguous(instance->cma_dev, pages, count);
+
+		pages = NULL;
+		if (size <= SZ_64M)
+			pages = cma_alloc(dev_get_cma_area(instance->cma_dev),
+							count, get_order(size));
+		if (pages == NULL)
+			goto no_mem;
+		paddr = page_to_phys(pages);
+	}
+
+	alloc->in_use = true;
+	alloc->pages = pages;
+	alloc->paddr = paddr;
+	alloc->size = size;
+
+	mutex_lock(&lock);
+
+	list_add_tail(&alloc->list, &instance->alloc_list);
+
+#ifdef CONFIG_DEBUG_FS
+	instance->cona_status_max_cont += alloc->size;
+	instance->cona_status_max_check = max(instance->cona_status_max_check,
+					instance->cona_status_max_cont);
+#endif /* #ifdef CONFIG_DEBUG_FS */
+
+	mutex_unlock(&lock);
+
+	return alloc;
+
+no_mem:
+	kfree(alloc);
+
+	return ERR_PTR(-ENOMEM);
+}
+
+static void cma_free_l(struct instance *instance, struct alloc *alloc)
+{
+	mutex_lock(&lock);
+
+	list_del(&alloc->list);
+
+#ifdef CONFIG_DEBUG_FS
+	instance->cona_status_max_cont -= alloc->size;
+#endif /* #ifdef CONFIG_DEBUG_FS */
+
+	mutex_unlock(&lock);
+
+	/* The caller has already unmapped the buffer from the area */
+	if (alloc->vm_area != NULL)
+		free_vm_area(alloc->vm_area);
+
+	dma_release_from_contiguous(instance->cma_dev, alloc->pages,
+						alloc->size >> PAGE_SHIFT);
+
+	kfree(alloc);
+}
+#endif /* #ifdef CONFIG_HWMEM_CMA */
+
 /* Debug */
 
 #ifdef CONFIG_DEBUG_FS
@@ -447,6 +702,19 @@ static int print_alloc_status(struct instance *instance, char **buf,
 {
 	int ret;
 	int i;
+	struct rb_node *last = rb_last(&instance->free_tree);
+	size_t largest_free = 0;
+	unsigned int fragmentation = 0;
+
+	/*
+	 * Fragmentation is the share of the free memory that is not part of
+	 * the largest free block, 0 means all free memory is contiguous.
+	 */
+	if (last != NULL) {
+		largest_free = rb_entry(last, struct alloc, free_node)->size;
+		fragmentation = 100 - (unsigned int)div_u64(
+				(u64)largest_free * 100, instance->free_size);
+	}
 
 	for (i = 0; i < 2; i++) {
 		size_t buf_size_l;
@@ -457,13 +725,19 @@ static int print_alloc_status(struct instance *instance, char **buf,
 
 		ret = snprintf(*buf, buf_size_l, "Overall peak usage:\t%10u "
 				"(%dMB)\nCurrent max usage:\t%10u (%dMB)\n"
-				"Current biggest free:\t%10d (%dMB)\n",
+				"Current biggest free:\t%10d (%dMB)\n"
+				"Free blocks:\t\t%10u\n"
+				"Largest free block:\t%10u (%dMB)\n"
+				"Fragmentation:\t\t%10u%%\n",
 				instance->cona_status_max_check,
 				instance->cona_status_max_check/1024/1024,
 				instance->cona_status_max_cont,
 				instance->cona_status_max_cont/1024/1024,
 				instance->cona_status_biggest_free,
-				instance->cona_status_biggest_free/1024/1024);
+				instance->cona_status_biggest_free/1024/1024,
+				instance->free_count,
+				largest_free, largest_free/1024/1024,
+				fragmentation);
 
 		if (ret < 0)
 			return -ENOMSG;
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) ST-Ericsson SA 2012
+ *
+ * Hardware memory driver, hwmem
+ *
+ * dma-buf export and import of hwmem buffers.
+ *
+ * License terms: GNU General Public License (GPL), version 2.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/fs.h>
+#include <linux/err.h>
+#include <linux/slab.h>
+#include <linux/sched.h>
+#include <linux/scatterlist.h>
+#include <linux/dma-buf.h>
+#include <linux/hwmem.h>
+
+extern void hwmem_get(struct hwmem_alloc *alloc);
+
+/*
+ * A dma-buf of a hwmem buffer only refers to the hwmem allocation, so that
+ * every user, the ones mapping the dma-buf and the ones resolving it back
+ * into the allocation, shares the hwmem cache domain tracking.
+ */
+
+static enum hwmem_access dir_to_access(enum dma_data_direction dir)
+{
+	switch (dir) {
+	case DMA_TO_DEVICE:
+		return HWMEM_ACCESS_READ;
+	case DMA_FROM_DEVICE:
+		return HWMEM_ACCESS_WRITE;
+	default:
+		return HWMEM_ACCESS_READ | HWMEM_ACCESS_WRITE;
+	}
+}
+
+static void set_domain_all(struct hwmem_alloc *alloc, enum hwmem_access access,
+		enum hwmem_domain domain, size_t start, size_t len)
+{
+	struct hwmem_region region = {
+		.offset = 0,
+		.count = 1,
+		.start = start,
+		.end = start + len,
+	};
+	size_t size;
+
+	hwmem_get_info(alloc, &size, NULL, NULL);
+	region.size = size;
+	if (region.end > size)
+		region.end = size;
+
+	hwmem_set_domain(alloc, access, domain, &region);
+}
+
+static struct sg_table *hwmem_map_dma_buf(struct dma_buf_attachment *attach,
+		enum dma_data_direction dir)
+{
+	struct hwmem_alloc *alloc = attach->dmabuf->priv;
+	struct hwmem_mem_chunk *chunks;
+	struct scatterlist *sg;
+	struct sg_table *sgt;
+	size_t nr_chunks;
+	int ret;
+	int i;
+
+	ret = hwmem_pin(alloc, NULL, &nr_chunks);
+	if (ret < 0)
+		return ERR_PTR(ret);
+
+	chunks = kmalloc(nr_chunks * sizeof(*chunks), GFP_KERNEL);
+	sgt = kzalloc(sizeof(*sgt), GFP_KERNEL);
+	if (chunks == NULL || sgt == NULL) {
+		ret = -ENOMEM;
+		goto alloc_failed;
+	}
+
+	ret = hwmem_pin(alloc, chunks, &nr_chunks);
+	if (ret < 0)
+		goto pin_failed;
+
+	ret = sg_alloc_table(sgt, nr_chunks, GFP_KERNEL);
+	if (ret < 0)
+		goto sg_alloc_failed;
+
+	/* There is no IOMMU, the device address is the physical address */
+	for_each_sg(sgt->sgl, sg, sgt->nents, i) {
+		sg_set_page(sg, phys_to_page(chunks[i].paddr), chunks[i].size,
+							0);
+		sg_dma_address(sg) = chunks[i].paddr;
+		sg_dma_len(sg) = chunks[i].size;
+	}
+
+	/* The device is about to access the buffer */
+	set_domain_all(alloc, dir_to_access(dir), HWMEM_DOMAIN_SYNC, 0,
+								SIZE_MAX);
+
+	kfree(chunks);
+
+	return sgt;
+
+sg_alloc_failed:
+	hwmem_unpin(alloc);
+pin_failed:
+alloc_failed:
+	kfree(sgt);
+	kfree(chunks);
+
+	return ERR_PTR(ret);
+}
+
+static void hwmem_unmap_dma_buf(struct dma_buf_attachment *attach,
+		struct sg_table *sgt, enum dma_data_direction dir)
+{
+	hwmem_unpin(attach->dmabuf->priv);
+	sg_free_table(sgt);
+	kfree(sgt);
+}
+
+static void hwmem_dma_buf_release(struct dma_buf *dmabuf)
+{
+	hwmem_release(dmabuf->priv);
+}
+
+static int hwmem_begin_cpu_access(struct dma_buf *dmabuf, size_t start,
+		size_t len, enum dma_data_direction dir)
+{
+	set_domain_all(dmabuf->priv, dir_to_access(dir), HWMEM_DOMAIN_CPU,
+								start, len);
+
+	return 0;
+}
+
+static void hwmem_end_cpu_access(struct dma_buf *dmabuf, size_t start,
+		size_t len, enum dma_data_direction dir)
+{
+	/* Synced when a device next maps or resolves the buffer */
+}
+
+static void *hwmem_dma_buf_kmap(struct dma_buf *dmabuf, unsigned long pgnum)
+{
+	void *kaddr = hwmem_kmap(dmabuf->priv);
+
+	if (kaddr == NULL)
+		return NULL;
+
+	return kaddr + pgnum * PAGE_SIZE;
+}
+
+static void hwmem_dma_buf_kunmap(struct dma_buf *dmabuf, unsigned long pgnum,
+		void *addr)
+{
+	hwmem_kunmap(dmabuf->priv);
+}
+
+/*
+ * Holding the fd gives access to the buffer whatever the hwmem access of the
+ * thread group is. Give the current thread group the access of the fd so that
+ * hwmem, and drivers checking the access, accept the buffer.
+ */
+static void grant_fd_access(struct dma_buf *dmabuf)
+{
+	struct hwmem_alloc *alloc = dmabuf->priv;
+	enum hwmem_access fd_access = HWMEM_ACCESS_IMPORT;
+	enum hwmem_access access;
+
+	if (dmabuf->file->f_mode & FMODE_READ)
+		fd_access |= HWMEM_ACCESS_READ;
+	if (dmabuf->file->f_mode & FMODE_WRITE)
+		fd_access |= HWMEM_ACCESS_WRITE;
+
+	hwmem_get_info(alloc, NULL, NULL, &access);
+	if ((access & fd_access) != fd_access)
+		hwmem_set_access(alloc, access | fd_access,
+						task_tgid_nr(current));
+}
+
+static int hwmem_dma_buf_mmap(struct dma_buf *dmabuf,
+		struct vm_area_struct *vma)
+{
+	grant_fd_access(dmabuf);
+
+	return hwmem_mmap(dmabuf->priv, vma);
+}
+
+static const struct dma_buf_ops hwmem_dma_buf_ops = {
+	.map_dma_buf = hwmem_map_dma_buf,
+	.unmap_dma_buf = hwmem_unmap_dma_buf,
+	.release = hwmem_dma_buf_release,
+	.begin_cpu_access = hwmem_begin_cpu_access,
+	.end_cpu_access = hwmem_end_cpu_access,
+	.kmap_atomic = hwmem_dma_buf_kmap,
+	.kunmap_atomic = hwmem_dma_buf_kunmap,
+	.kmap = hwmem_dma_buf_kmap,
+	.kunmap = hwmem_dma_buf_kunmap,
+	.mmap = hwmem_dma_buf_mmap,
+};
+
+struct dma_buf *hwmem_export_dma_buf(struct hwmem_alloc *alloc, int flags)
+{
+	struct dma_buf *dmabuf;
+	size_t size;
+
+	hwmem_get_info(alloc, &size, NULL, NULL);
+
+	/* The dma-buf holds a buffer reference */
+	hwmem_get(alloc);
+	dmabuf = dma_buf_export(alloc, &hwmem_dma_buf_ops, size, flags);
+	if (IS_ERR(dmabuf))
+		hwmem_release(alloc);
+
+	return dmabuf;
+}
+EXPORT_SYMBOL(hwmem_export_dma_buf);
+
+struct hwmem_alloc *hwmem_resolve_by_dma_buf_fd(int fd)
+{
+	struct hwmem_alloc *alloc;
+	struct dma_buf *dmabuf;
+
+	dmabuf = dma_buf_get(fd);
+	if (IS_ERR(dmabuf))
+		return ERR_CAST(dmabuf);
+
+	/* Only buffers exported by hwmem have an allocation to resolve to */
+	if (dmabuf->ops != &hwmem_dma_buf_ops) {
+		alloc = ERR_PTR(-EINVAL);
+		goto out;
+	}
+
+	alloc = dmabuf->priv;
+	hwmem_get(alloc);
+	grant_fd_access(dmabuf);
+
+out:
+	dma_buf_put(dmabuf);
+
+	return alloc;
+}
+EXPORT_SYMBOL(hwmem_resolve_by_dma_buf_fd);
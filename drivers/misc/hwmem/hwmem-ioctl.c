@@ -20,6 +20,7 @@
 #include <linux/hwmem.h>
 #include <linux/device.h>
 #include <linux/sched.h>
+#include <linux/dma-buf.h>
 
 static int hwmem_open(struct inode *inode, struct file *file);
 static int hwmem_ioctl_mmap(struct file *file, struct vm_area_struct *vma);
@@ -293,6 +294,52 @@ error:
 	return ret;
 }
 
+#ifdef CONFIG_HWMEM_DMA_BUF
+static int export_dma_buf(struct hwmem_file *hwfile, s32 id)
+{
+	int ret;
+	struct hwmem_alloc *alloc;
+	struct dma_buf *dmabuf;
+	enum hwmem_access access;
+
+	alloc = resolve_id(hwfile, id);
+	if (IS_ERR(alloc))
+		return PTR_ERR(alloc);
+
+	/* The fd must not give more access than the process has */
+	hwmem_get_info(alloc, NULL, NULL, &access);
+	if (!(access & HWMEM_ACCESS_READ))
+		return -EPERM;
+
+	dmabuf = hwmem_export_dma_buf(alloc, (access & HWMEM_ACCESS_WRITE) ?
+							O_RDWR : O_RDONLY);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	ret = dma_buf_fd(dmabuf, O_CLOEXEC);
+	if (ret < 0)
+		dma_buf_put(dmabuf);
+
+	return ret;
+}
+
+static s32 import_dma_buf(struct hwmem_file *hwfile, int fd)
+{
+	s32 ret;
+	struct hwmem_alloc *alloc;
+
+	alloc = hwmem_resolve_by_dma_buf_fd(fd);
+	if (IS_ERR(alloc))
+		return PTR_ERR(alloc);
+
+	ret = create_id(hwfile, alloc);
+	if (ret < 0)
+		hwmem_release(alloc);
+
+	return ret;
+}
+#endif
+
 static int import_fd(struct hwmem_file *hwfile, s32 name)
 {
 	int ret;
@@ -484,6 +531,14 @@ static long hwmem_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	case HWMEM_IMPORT_FD_IOC:
 		ret = import_fd(hwfile, (s32)arg);
 		break;
+#ifdef CONFIG_HWMEM_DMA_BUF
+	case HWMEM_EXPORT_DMA_BUF_IOC:
+		ret = export_dma_buf(hwfile, (s32)arg);
+		break;
+	case HWMEM_IMPORT_DMA_BUF_IOC:
+		ret = import_dma_buf(hwfile, (int)arg);
+		break;
+#endif
 	}
 
 	mutex_unlock(&hwfile->lock);
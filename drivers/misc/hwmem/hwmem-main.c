@@ -28,10 +28,22 @@
 #include <linux/io.h>
 #include <linux/kallsyms.h>
 #include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <linux/jiffies.h>
+#include <asm/sizes.h>
 #include "cache_handler.h"
 
 #define S32_MAX 2147483647
 
+/*
+ * Released contiguous buffers are kept mapped in a pool for a while so that
+ * the same size can be handed out again without going through the
+ * allocator, the mapping and the clearing.
+ */
+#define POOL_MAX_BUFFERS	8
+#define POOL_MAX_SIZE		(16 * SZ_1M)
+#define POOL_TIMEOUT		(2 * HZ)
+
 struct hwmem_alloc_threadg_info {
 	struct list_head list;
 
@@ -53,6 +65,10 @@ struct hwmem_alloc {
 	void *kaddr;
 	size_t size;
 	s32 name;
+	/* Thread group that allocated the buffer */
+	pid_t owner_tgid;
+	/* When the buffer was put in the pool */
+	unsigned long pool_time;
 
 	/* Access control */
 	enum hwmem_access default_access;
@@ -86,6 +102,16 @@ static LIST_HEAD(alloc_list);
 static DEFINE_IDR(global_idr);
 static DEFINE_MUTEX(lock);
 
+/* Oldest first, accessed under lock */
+static LIST_HEAD(pool_list);
+static unsigned int pool_num_buffers;
+static size_t pool_size;
+static u32 pool_hits;
+static u32 pool_misses;
+
+static void pool_expire(struct work_struct *work);
+static DECLARE_DELAYED_WORK(pool_expire_work, pool_expire);
+
 static void vm_open(struct vm_area_struct *vma);
 static void vm_close(struct vm_area_struct *vma);
 static struct vm_operations_struct vm_ops = {
@@ -148,7 +174,101 @@ static void clear_alloc_mem(struct hwmem_alloc *alloc)
 	cach_set_domain(&alloc->cach_buf, HWMEM_ACCESS_WRITE,
 						HWMEM_DOMAIN_CPU, NULL);
 
-	memset(alloc->kaddr, 0, alloc->size);
+	neon_memset(alloc->kaddr, 0, alloc->size);
+}
+
+static void free_alloc_mem(struct hwmem_alloc *alloc)
+{
+	kunmap_alloc(alloc);
+
+	if (!IS_ERR_OR_NULL(alloc->allocator_hndl))
+		alloc->mem_type->allocator_api.free(
+					alloc->mem_type->allocator_instance,
+							alloc->allocator_hndl);
+
+	kfree(alloc);
+}
+
+static bool is_poolable(enum hwmem_mem_type mem_type, size_t size)
+{
+	return mem_type == HWMEM_MEM_CONTIGUOUS_SYS && size <= POOL_MAX_SIZE;
+}
+
+static void pool_remove(struct hwmem_alloc *alloc)
+{
+	list_del(&alloc->list);
+	pool_num_buffers--;
+	pool_size -= alloc->size;
+}
+
+static bool pool_put(struct hwmem_alloc *alloc)
+{
+	if (!is_poolable(alloc->mem_type->id, alloc->size))
+		return false;
+
+	/* Make room by dropping the oldest buffers */
+	while (!list_empty(&pool_list) &&
+			(pool_num_buffers >= POOL_MAX_BUFFERS ||
+			pool_size + alloc->size > POOL_MAX_SIZE)) {
+		struct hwmem_alloc *oldest = list_first_entry(&pool_list,
+						struct hwmem_alloc, list);
+
+		pool_remove(oldest);
+		free_alloc_mem(oldest);
+	}
+
+	alloc->pool_time = jiffies;
+	list_add_tail(&alloc->list, &pool_list);
+	pool_num_buffers++;
+	pool_size += alloc->size;
+
+	schedule_delayed_work(&pool_expire_work, POOL_TIMEOUT);
+
+	return true;
+}
+
+static struct hwmem_alloc *pool_get(size_t size, enum hwmem_alloc_flags flags,
+					enum hwmem_mem_type mem_type)
+{
+	struct hwmem_alloc *alloc;
+
+	if (!is_poolable(mem_type, size))
+		return NULL;
+
+	/* Newest first, its cache lines are the most likely to be useful */
+	list_for_each_entry_reverse(alloc, &pool_list, list) {
+		if (alloc->size == size && alloc->flags == flags) {
+			pool_remove(alloc);
+			pool_hits++;
+			return alloc;
+		}
+	}
+
+	pool_misses++;
+
+	return NULL;
+}
+
+static void pool_expire(struct work_struct *work)
+{
+	struct hwmem_alloc *alloc;
+	struct hwmem_alloc *tmp;
+
+	mutex_lock(&lock);
+
+	list_for_each_entry_safe(alloc, tmp, &pool_list, list) {
+		if (time_before(jiffies, alloc->pool_time + POOL_TIMEOUT)) {
+			schedule_delayed_work(&pool_expire_work,
+					alloc->pool_time + POOL_TIMEOUT -
+								jiffies);
+			break;
+		}
+
+		pool_remove(alloc);
+		free_alloc_mem(alloc);
+	}
+
+	mutex_unlock(&lock);
 }
 
 static void destroy_alloc(struct hwmem_alloc *alloc)
@@ -162,14 +282,14 @@ static void destroy_alloc(struct hwmem_alloc *alloc)
 
 	clean_alloc_threadg_info_list(alloc);
 
-	kunmap_alloc(alloc);
-
-	if (!IS_ERR_OR_NULL(alloc->allocator_hndl))
-		alloc->mem_type->allocator_api.free(
-					alloc->mem_type->allocator_instance,
-							alloc->allocator_hndl);
+	/*
+	 * Only fully set up buffers are pooled, a failed hwmem_alloc() also
+	 * ends up here.
+	 */
+	if (alloc->kaddr != NULL && pool_put(alloc))
+		return;
 
-	kfree(alloc);
+	free_alloc_mem(alloc);
 }
 
 #define DMA_ALLOC_RETRY		10
@@ -230,12 +350,20 @@ static int kmap_alloc(struct hwmem_alloc *alloc)
         if (sprint_symbol(creator, (unsigned long)alloc->creator) < 0)
                 creator[0] = '\0';
 
+#ifdef CONFIG_HWMEM_CMA
+	/*
+	 * The contiguous allocator hands out CMA memory itself, the buffer
+	 * only needs to be mapped.
+	 */
+	skipped = 1;
+#else
 	/*
 	 * Don't use CMA for allocations by U8500's Trusted Execution Engine -
 	 * it doesn't seem to like it.
 	 */
 	if (strstr(creator, "tee"))
 		skipped = 1;
+#endif
 
 	pgprot = PAGE_KERNEL;
 	cach_set_pgprot_cache_options(&alloc->cach_buf, &pgprot);
@@ -261,10 +389,12 @@ static int kmap_alloc(struct hwmem_alloc *alloc)
 		}
 
 		if (ret < 0) {
+#ifndef CONFIG_HWMEM_CMA
 			if (!skipped)
 				pr_err("[cma] failed to allocate %d bytes (creator %s)\n", alloc->size, creator);
 			else
 				pr_err("[cma] skipped allocation (creator=%s, size = %d)\n", creator, alloc->size);
+#endif
 			alloc_kaddr = alloc->mem_type->allocator_api.get_alloc_kaddr(
 				alloc->mem_type->allocator_instance, alloc->allocator_hndl);
 			if (IS_ERR(alloc_kaddr))
@@ -339,6 +469,27 @@ struct hwmem_alloc *hwmem_alloc(size_t size, enum hwmem_alloc_flags flags,
 
 	size = PAGE_ALIGN(size);
 
+	alloc = pool_get(size, flags, mem_type);
+	if (alloc != NULL) {
+		pid_t tgid = task_tgid_nr(current);
+
+		atomic_set(&alloc->ref_cnt, 1);
+		alloc->default_access = def_access;
+#ifdef CONFIG_DEBUG_FS
+		alloc->creator = __builtin_return_address(0);
+		alloc->creator_tgid = tgid;
+#endif
+		list_add_tail(&alloc->list, &alloc_list);
+
+		/* The cache state in cach_buf is still valid */
+		if (!(flags & HWMEM_ALLOC_HINT_NO_CLEAR) ||
+						alloc->owner_tgid != tgid)
+			clear_alloc_mem(alloc);
+		alloc->owner_tgid = tgid;
+
+		goto out;
+	}
+
 	alloc = kzalloc(sizeof(struct hwmem_alloc), GFP_KERNEL);
 	if (alloc == NULL) {
 		ret = -ENOMEM;
@@ -349,6 +500,7 @@ struct hwmem_alloc *hwmem_alloc(size_t size, enum hwmem_alloc_flags flags,
 	atomic_inc(&alloc->ref_cnt);
 	alloc->flags = flags;
 	alloc->default_access = def_access;
+	alloc->owner_tgid = task_tgid_nr(current);
 	INIT_LIST_HEAD(&alloc->threadg_info_list);
 #ifdef CONFIG_DEBUG_FS
 	alloc->creator = __builtin_return_address(0);
@@ -424,6 +576,12 @@ void hwmem_release(struct hwmem_alloc *alloc)
 }
 EXPORT_SYMBOL(hwmem_release);
 
+/* Adds a buffer reference, for the dma-buf export */
+void hwmem_get(struct hwmem_alloc *alloc)
+{
+	atomic_inc(&alloc->ref_cnt);
+}
+
 int hwmem_set_domain(struct hwmem_alloc *alloc, enum hwmem_access access,
 		enum hwmem_domain domain, struct hwmem_region *region)
 {
@@ -824,6 +982,10 @@ static void init_debugfs(void)
 	struct dentry *debugfs_root_dir = debugfs_create_dir("hwmem", NULL);
 	(void)debugfs_create_file("allocs", 0444, debugfs_root_dir, 0,
 							&debugfs_allocs_fops);
+	(void)debugfs_create_u32("pool_hits", 0444, debugfs_root_dir,
+								&pool_hits);
+	(void)debugfs_create_u32("pool_misses", 0444, debugfs_root_dir,
+								&pool_misses);
 }
 
 #endif /* #ifdef CONFIG_DEBUG_FS */
@@ -23,6 +23,9 @@
 #include <linux/moduleparam.h>
 #include <linux/fcntl.h>
 #include <linux/spinlock.h>
+#include <linux/mm.h>
+#include <linux/uaccess.h>
+#include <linux/modem_audio.h>
 #include <mach/mbox_channels-db5500.h>
 
 MODULE_DESCRIPTION("Modem Audio Driver");
@@ -59,6 +62,12 @@ MODULE_LICENSE("GPLv2");
 #define MAX_NUM_RX_BUFF		NUM_DSP_BUFFER
 #define NR_OF_DATAWORDS_REQD_FOR_ACK	1
 
+/*
+ * The mailbox keeps a pointer to the message until it is sent: each
+ * frame of a batch gets its own message, reused MAX_TX_MSGS frames later
+ */
+#define MAX_TX_MSGS		16
+
 /**
  * Message types, must be identical in DSP Side
  * VCS_MBOX_MSG_WRITE_IF_SETUP : DSP -> ARM
@@ -84,8 +93,13 @@ MODULE_LICENSE("GPLv2");
  * @max_rx_buffs : No. of DSP buffers available to read
  * @write_offset : Size of each buffer in the DSP
  * @read_offset : Size of each buffer in the DSP
+ * @rx_phys : Physical address of the first RX buffer in DSP
+ * @tx_phys : Physical address of the first TX buffer in DSP
  * @rx_buff : Buffer for incoming data
- * @tx_buff : Buffer for outgoing data
+ * @tx_buff : Messages for outgoing data
+ * @ctrl : Control page shared with a reader using mmap
+ * @mapped : The control page is mapped, RX frames go to its ring
+ * @wake_frames : RX frames to wait for before waking up the reader
  * @tx_buffer_num : Buffer counter for writing to DSP
  * @rx_buffer_num : Buffer counter for reading  to DSP
  * @rx_buffer_read :  Buffer counter for reading from userspace
@@ -101,8 +115,13 @@ struct mad_data {
 	int	max_rx_buffs;
 	int	write_offset;
 	int	read_offset;
+	phys_addr_t	rx_phys;
+	phys_addr_t	tx_phys;
 	u32	*rx_buff;
 	u32	*tx_buff;
+	struct mad_ctrl	*ctrl;
+	bool	mapped;
+	u32	wake_frames;
 	int	tx_buffer_num;
 	int	rx_buffer_num;
 	int	rx_buffer_read;
@@ -121,6 +140,8 @@ static int mad_read(struct file *filp, char __user *buff, size_t count,
 static int mad_write(struct file *filp, const char __user *buff, size_t count,
 		loff_t *offp);
 static unsigned int mad_select(struct file *filp, poll_table *wait);
+static long mad_ioctl(struct file *filp, unsigned int cmd, unsigned long arg);
+static int mad_mmap(struct file *filp, struct vm_area_struct *vma);
 static void mad_send_cb(u32 *data, u32 len, void *arg);
 static int mad_open(struct inode *ino, struct file *filp);
 static int mad_close(struct inode *ino, struct file *filp);
@@ -131,6 +152,8 @@ static const struct file_operations mad_fops = {
 	.read    = mad_read,
 	.write   = mad_write,
 	.poll    = mad_select,
+	.unlocked_ioctl = mad_ioctl,
+	.mmap    = mad_mmap,
 	.owner   = THIS_MODULE,
 };
 
@@ -151,6 +174,41 @@ static void mad_send_cb(u32 *data, u32 len, void *arg)
 	dev_dbg(mad_dev.this_device, "%s", __func__);
 }
 
+/* Number of RX frames the reader has not consumed yet */
+static u32 mad_rx_pending(struct mad_data *mad)
+{
+	if (mad->mapped)
+		return mad->ctrl->rx_head - ACCESS_ONCE(mad->ctrl->rx_tail);
+
+	return mad->data_written;
+}
+
+/**
+ * mad_rx_queue - Hand an RX frame to a reader using mmap
+ * @len -Data length in the buffer
+ * @index -Buffer number
+ */
+static void mad_rx_queue(struct mad_data *mad, u32 len, u32 index)
+{
+	struct mad_ctrl *ctrl = mad->ctrl;
+	u32 head = ctrl->rx_head;
+	u32 pending = head - ACCESS_ONCE(ctrl->rx_tail);
+
+	if (pending >= MAD_RX_RING_SIZE) {
+		ctrl->rx_overflows++;
+		return;
+	}
+
+	ctrl->rx_desc[head & (MAD_RX_RING_SIZE - 1)].len = len;
+	ctrl->rx_desc[head & (MAD_RX_RING_SIZE - 1)].index = index;
+	/* The descriptor must be visible before the new head */
+	smp_wmb();
+	ctrl->rx_head = head + 1;
+
+	if (pending + 1 >= mad->wake_frames)
+		wake_up_interruptible(&mad->readq);
+}
+
 /**
  * mad_receive_cb - This callback function is for receiving data from mailbox
  * @data -Pointer to the data buffer
@@ -185,10 +243,19 @@ static void mad_receive_cb(u32 *data, u32 length, void *priv)
 			mad->max_tx_buffs * mad->write_offset);
 		if (mad->dsp_shm_write_ptr == NULL)
 			dev_err(mad_dev.this_device, "incrt write address");
+		mad->tx_phys = mad->dsp_shm_write_ptr ? data[1] : 0;
 
 		/* Initialize all buffer numbers */
 		mad->tx_buffer_num = 0;
 
+		if (mad->ctrl) {
+			mad->ctrl->tx_offset = offset_in_page(data[1]);
+			mad->ctrl->tx_buf_size = mad->write_offset;
+			mad->ctrl->tx_nr_bufs = mad->max_tx_buffs;
+			mad->ctrl->tx_next = 0;
+			mad->ctrl->setup++;
+		}
+
 		/* Send ACK to the DSP */
 		msg.channel = CHANNEL_NUM_TX;
 		msg.data = &ack_to_dsp;
@@ -219,12 +286,21 @@ static void mad_receive_cb(u32 *data, u32 length, void *priv)
 
 		mad->dsp_shm_read_ptr =  ioremap(data[1],
 			mad->max_rx_buffs * mad->read_offset);
+		mad->rx_phys = mad->dsp_shm_read_ptr ? data[1] : 0;
 
 		/* Initialize all buffer numbers and flags */
 		mad->rx_buffer_num  = 0;
 		mad->rx_buffer_read = 0;
 		mad->data_written   = 0;
 
+		if (mad->ctrl) {
+			mad->ctrl->rx_offset = offset_in_page(data[1]);
+			mad->ctrl->rx_buf_size = mad->read_offset;
+			mad->ctrl->rx_nr_bufs = mad->max_rx_buffs;
+			mad->ctrl->rx_tail = mad->ctrl->rx_head;
+			mad->ctrl->setup++;
+		}
+
 		/* Send ACK to the DSP */
 		msg.channel = CHANNEL_NUM_TX;
 		msg.data = &ack_to_dsp;
@@ -256,6 +332,9 @@ static void mad_receive_cb(u32 *data, u32 length, void *priv)
 			else
 				dev_warn(mad_dev.this_device, "%s :0-len msg",
 						__func__);
+		} else if (mad->mapped) {
+			/* No copy: the reader gets the buffer number */
+			mad_rx_queue(mad, data[1], data[2]);
 		} else {
 			mad->rx_buff[mad->rx_buffer_num] = data[1];
 			mad->rx_buffer_num++;
@@ -282,7 +361,8 @@ static void mad_receive_cb(u32 *data, u32 length, void *priv)
 				mad->data_written = MAX_NUM_RX_BUFF ;
 			}
 			spin_unlock_irqrestore(&mad->lock, flags);
-			wake_up_interruptible(&mad->readq);
+			if (mad->data_written >= mad->wake_frames)
+				wake_up_interruptible(&mad->readq);
 		}
 	} else {
 		/* received Invalid message */
@@ -299,9 +379,13 @@ static int mad_read(struct file *filp, char __user *buff, size_t count,
 
 	dev_dbg(mad_dev.this_device, "%s", __func__);
 
+	if (mad->mapped)
+		return -EBUSY;
+
+	/* Frames left from the last wakeup are read without waiting */
 	if (!(mad->data_written > 0)) {
 		if (wait_event_interruptible(mad->readq,
-			((mad->data_written > 0) &&
+			((mad->data_written >= mad->wake_frames) &&
 			(mad->dsp_shm_read_ptr != NULL))))
 			return -ERESTARTSYS;
 	}
@@ -346,12 +430,46 @@ static int mad_read(struct file *filp, char __user *buff, size_t count,
 	return size;
 }
 
+/**
+ * mad_send_frame - Hand the frame in the current TX buffer to the DSP
+ * @count -Data length in the buffer
+ */
+static int mad_send_frame(u32 count)
+{
+	struct mbox_channel_msg msg;
+	u32 *words;
+	int retval;
+
+	words = mad->tx_buff +
+		(mad->tx_buffer_num % MAX_TX_MSGS) * MAX_NR_OF_DATAWORDS;
+	words[0] = VCS_MBOX_MSG_IF_ENC_DATA;
+	words[1] = count;
+	words[2] = mad->tx_buffer_num;
+
+	if (mad->tx_buffer_num < (mad->max_tx_buffs-1))
+		mad->tx_buffer_num++;
+	else
+		mad->tx_buffer_num = 0;
+	if (mad->ctrl)
+		mad->ctrl->tx_next = mad->tx_buffer_num;
+
+	msg.channel = CHANNEL_NUM_TX;
+	msg.data = words;
+	msg.length = MAX_NR_OF_DATAWORDS;
+	msg.cb = mad_send_cb;
+	msg.priv = mad;
+
+	retval = mbox_channel_send(&msg);
+	if (retval)
+		dev_err(mad_dev.this_device, "%s:can't send data", __func__);
+	return retval;
+}
+
 static int mad_write(struct file *filp, const char __user *buff, size_t count,
 								loff_t *offp)
 {
 	int retval = 0;
 	void __iomem  *dsp_write_address;
-	struct mbox_channel_msg msg;
 
 	dev_dbg(mad_dev.this_device, "%s", __func__);
 
@@ -369,27 +487,103 @@ static int mad_write(struct file *filp, const char __user *buff, size_t count,
 		return -EFAULT;
 	}
 
-	mad->tx_buff[0] = VCS_MBOX_MSG_IF_ENC_DATA;
-	mad->tx_buff[1] = count;
-	mad->tx_buff[2] = mad->tx_buffer_num;
+	retval = mad_send_frame(count);
+	if (retval)
+		return retval;
+	return count;
+}
 
-	if (mad->tx_buffer_num < (mad->max_tx_buffs-1))
-		mad->tx_buffer_num++;
-	else
-		mad->tx_buffer_num = 0;
+/**
+ * mad_send_batch - Hand frames already written in the TX window to the DSP
+ * @arg -User pointer to a struct mad_tx_batch
+ */
+static int mad_send_batch(unsigned long arg)
+{
+	struct mad_tx_batch batch;
+	int i, retval;
 
-	msg.channel = CHANNEL_NUM_TX;
-	msg.data = mad->tx_buff;
-	msg.length = MAX_NR_OF_DATAWORDS;
-	msg.cb = mad_send_cb;
-	msg.priv = mad;
+	if (copy_from_user(&batch, (void __user *)arg, sizeof(batch)))
+		return -EFAULT;
 
-	retval = mbox_channel_send(&msg);
-	if (retval) {
-		dev_err(mad_dev.this_device, "%s:can't send data", __func__);
-		return retval;
+	if (mad->dsp_shm_write_ptr == NULL)
+		return -EAGAIN;
+	if (batch.nr > MAD_TX_BATCH_MAX)
+		return -EINVAL;
+
+	for (i = 0; i < batch.nr; i++) {
+		if (!batch.len[i] || batch.len[i] > mad->write_offset)
+			return -EINVAL;
+		retval = mad_send_frame(batch.len[i]);
+		if (retval)
+			return retval;
+	}
+	return 0;
+}
+
+static long mad_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
+{
+	u32 frames;
+
+	switch (cmd) {
+	case MAD_SET_WAKEUP:
+		if (get_user(frames, (u32 __user *)arg))
+			return -EFAULT;
+		if (!frames || frames > min(MAD_RX_RING_SIZE, MAX_NUM_RX_BUFF))
+			return -EINVAL;
+		mad->wake_frames = frames;
+		return 0;
+	case MAD_TX_SEND:
+		return mad_send_batch(arg);
+	default:
+		return -ENOTTY;
 	}
-	return count;
+}
+
+/*
+ * The control page is mapped read/write, the DSP buffers uncached, RX
+ * read-only. Mapping the control page switches RX from read() to its ring.
+ */
+static int mad_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	unsigned long offset = vma->vm_pgoff << PAGE_SHIFT;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	phys_addr_t phys;
+	unsigned long len;
+	int err;
+
+	switch (offset) {
+	case MAD_MMAP_CTRL:
+		if (size > PAGE_SIZE)
+			return -EINVAL;
+		err = remap_pfn_range(vma, vma->vm_start,
+				virt_to_phys(mad->ctrl) >> PAGE_SHIFT,
+				size, vma->vm_page_prot);
+		if (!err)
+			mad->mapped = true;
+		return err;
+	case MAD_MMAP_RX:
+		if (vma->vm_flags & VM_WRITE)
+			return -EPERM;
+		phys = mad->rx_phys;
+		len = mad->max_rx_buffs * mad->read_offset;
+		break;
+	case MAD_MMAP_TX:
+		phys = mad->tx_phys;
+		len = mad->max_tx_buffs * mad->write_offset;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (!phys)
+		return -EAGAIN;
+	if (size < PAGE_ALIGN(offset_in_page(phys) + len) ||
+	    size > MAD_MMAP_WINDOW)
+		return -EINVAL;
+
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+	return io_remap_pfn_range(vma, vma->vm_start, phys >> PAGE_SHIFT,
+				  size, vma->vm_page_prot);
 }
 
 static unsigned int mad_select(struct file *filp, poll_table *wait)
@@ -402,7 +596,8 @@ static unsigned int mad_select(struct file *filp, poll_table *wait)
 	poll_wait(filp, &mad->readq,  wait);
 	spin_lock_irqsave(&mad->lock, flags);
 
-	if ((true == mad->read_setup_msg) && (mad->data_written > 0))
+	if ((true == mad->read_setup_msg) &&
+	    (mad_rx_pending(mad) >= mad->wake_frames))
 		mask |= POLLIN | POLLRDNORM;    /* allow readable */
 	spin_unlock_irqrestore(&mad->lock, flags);
 
@@ -429,13 +624,30 @@ static int mad_open(struct inode *ino, struct file *filp)
 		goto error;
 	}
 
-	mad->tx_buff =  kzalloc(MAX_NR_OF_DATAWORDS, GFP_KERNEL);
+	mad->tx_buff =  kzalloc(MAX_TX_MSGS * MAX_NR_OF_DATAWORDS *
+				sizeof(*mad->tx_buff), GFP_KERNEL);
 	if (mad->tx_buff == NULL) {
 		dev_err(mad_dev.this_device, "%s:TX memory\n", __func__);
 		err = -ENOMEM;
 		goto error;
 	}
 
+	mad->ctrl = (struct mad_ctrl *)get_zeroed_page(GFP_KERNEL);
+	if (mad->ctrl == NULL) {
+		dev_err(mad_dev.this_device, "%s:ctrl memory\n", __func__);
+		err = -ENOMEM;
+		goto error;
+	}
+	mad->ctrl->rx_offset = offset_in_page(mad->rx_phys);
+	mad->ctrl->rx_buf_size = mad->read_offset;
+	mad->ctrl->rx_nr_bufs = mad->max_rx_buffs;
+	mad->ctrl->tx_offset = offset_in_page(mad->tx_phys);
+	mad->ctrl->tx_buf_size = mad->write_offset;
+	mad->ctrl->tx_nr_bufs = mad->max_tx_buffs;
+	mad->ctrl->tx_next = mad->tx_buffer_num;
+	mad->mapped = false;
+	mad->wake_frames = 1;
+
 	/* Init spinlock for critical section access*/
 	spin_lock_init(&mad->lock);
 	init_waitqueue_head(&(mad->readq));
@@ -450,6 +662,8 @@ static int mad_open(struct inode *ino, struct file *filp)
 
 	return 0;
 error:
+	free_page((unsigned long)mad->ctrl);
+	mad->ctrl = NULL;
 	kfree(mad->rx_buff);
 	kfree(mad->tx_buff);
 	return err;
@@ -465,6 +679,9 @@ static int mad_close(struct inode *ino, struct file *filp)
 	}
 	kfree(mad->rx_buff);
 	kfree(mad->tx_buff);
+	mad->mapped = false;
+	free_page((unsigned long)mad->ctrl);
+	mad->ctrl = NULL;
 	mad->data_written = 0;
 	mad->rx_buffer_num = 0;
 	mad->rx_buffer_read = 0;
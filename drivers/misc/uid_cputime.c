@@ -14,6 +14,7 @@
  */
 
 #include <linux/atomic.h>
+#include <linux/cpufreq.h>
 #include <linux/err.h>
 #include <linux/hashtable.h>
 #include <linux/init.h>
@@ -24,7 +25,9 @@
 #include <linux/sched.h>
 #include <linux/seq_file.h>
 #include <linux/slab.h>
+#include <linux/sort.h>
 #include <linux/uaccess.h>
+#include <linux/workqueue.h>
 
 #define UID_HASH_BITS	10
 DECLARE_HASHTABLE(hash_table, UID_HASH_BITS);
@@ -40,6 +43,11 @@ struct uid_entry {
 	cputime_t active_stime;
 	unsigned long long active_power;
 	unsigned long long power;
+#ifdef CONFIG_UID_CPUTIME_FREQ
+	/* us at each frequency of uid_freqs, allocated on first use */
+	u64 *time_in_state;
+	unsigned long long freq_power;
+#endif
 	struct hlist_node hash;
 };
 
@@ -74,6 +82,255 @@ static struct uid_entry *find_or_register_uid(uid_t uid)
 	return uid_entry;
 }
 
+#ifdef CONFIG_UID_CPUTIME_FREQ
+/*
+ * Time in state is accounted from the cputime updates into a small per cpu
+ * hash, which only takes an uncontended per cpu lock. The hash is folded
+ * into the uid entries when it fills up and when the stats are read.
+ */
+#define UID_FREQ_MAX		32
+#define UID_CACHE_BITS		6
+#define UID_CACHE_SIZE		(1 << UID_CACHE_BITS)
+
+struct uid_freq_cache {
+	spinlock_t lock;
+	unsigned int used;
+	unsigned int dropped;
+	bool valid[UID_CACHE_SIZE];
+	uid_t uid[UID_CACHE_SIZE];
+	unsigned long long power[UID_CACHE_SIZE];
+	/* UID_CACHE_SIZE rows of uid_nr_freqs */
+	u64 *time;
+};
+
+static DEFINE_PER_CPU(struct uid_freq_cache, uid_freq_cache);
+static unsigned int uid_freqs[UID_FREQ_MAX];
+static unsigned int uid_nr_freqs;
+static bool uid_freq_ready;
+
+static void uid_freq_fold_fn(struct work_struct *work);
+static DECLARE_WORK(uid_freq_fold_work, uid_freq_fold_fn);
+
+static int uid_freq_index(unsigned int freq)
+{
+	int i;
+
+	for (i = 0; i < uid_nr_freqs; i++)
+		if (uid_freqs[i] == freq)
+			return i;
+	return -1;
+}
+
+void uid_cputime_account_freq(uid_t uid, unsigned int freq,
+			      unsigned int usecs, unsigned long long power)
+{
+	struct uid_freq_cache *c;
+	unsigned long flags;
+	unsigned int h, i;
+	int f;
+
+	if (!ACCESS_ONCE(uid_freq_ready))
+		return;
+	smp_rmb();
+
+	f = uid_freq_index(freq);
+	if (f < 0)
+		return;
+
+	local_irq_save(flags);
+	c = &__get_cpu_var(uid_freq_cache);
+	spin_lock(&c->lock);
+
+	h = hash_32(uid, UID_CACHE_BITS);
+	for (i = 0; i < UID_CACHE_SIZE; i++, h = (h + 1) & (UID_CACHE_SIZE - 1)) {
+		if (c->valid[h] && c->uid[h] == uid)
+			break;
+		if (!c->valid[h]) {
+			c->valid[h] = true;
+			c->uid[h] = uid;
+			c->used++;
+			break;
+		}
+	}
+
+	if (i < UID_CACHE_SIZE) {
+		c->time[h * uid_nr_freqs + f] += usecs;
+		c->power[h] += power;
+	} else {
+		c->dropped++;
+	}
+
+	if (c->used >= UID_CACHE_SIZE * 3 / 4)
+		schedule_work(&uid_freq_fold_work);
+
+	spin_unlock(&c->lock);
+	local_irq_restore(flags);
+}
+
+/* Called with uid_lock held */
+static void uid_freq_fold(void)
+{
+	struct uid_freq_cache *c;
+	struct uid_entry *uid_entry;
+	unsigned long flags;
+	unsigned int cpu, h, f;
+	u64 *time;
+
+	if (!uid_freq_ready)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		c = &per_cpu(uid_freq_cache, cpu);
+		spin_lock_irqsave(&c->lock, flags);
+		for (h = 0; h < UID_CACHE_SIZE; h++) {
+			if (!c->valid[h])
+				continue;
+
+			time = &c->time[h * uid_nr_freqs];
+			uid_entry = find_or_register_uid(c->uid[h]);
+			if (uid_entry && !uid_entry->time_in_state)
+				uid_entry->time_in_state = kcalloc(uid_nr_freqs,
+						sizeof(u64), GFP_ATOMIC);
+			if (uid_entry && uid_entry->time_in_state) {
+				for (f = 0; f < uid_nr_freqs; f++)
+					uid_entry->time_in_state[f] += time[f];
+				uid_entry->freq_power += c->power[h];
+			} else {
+				c->dropped++;
+			}
+
+			memset(time, 0, uid_nr_freqs * sizeof(u64));
+			c->power[h] = 0;
+			c->valid[h] = false;
+		}
+		c->used = 0;
+		spin_unlock_irqrestore(&c->lock, flags);
+	}
+}
+
+static void uid_freq_fold_fn(struct work_struct *work)
+{
+	mutex_lock(&uid_lock);
+	uid_freq_fold();
+	mutex_unlock(&uid_lock);
+}
+
+/*
+ * Binary layout, native endian:
+ *	u32 nr_freqs, u32 dropped samples, u32 freq[nr_freqs] in kHz,
+ *	then per uid: u32 uid, u32 0, u64 power, u64 time[nr_freqs] in us.
+ * power is the sum of current times us, 0 without a current table.
+ */
+static int uid_time_in_state_show(struct seq_file *m, void *v)
+{
+	struct uid_entry *uid_entry;
+	struct hlist_node *node;
+	unsigned long bkt;
+	unsigned int cpu;
+	u32 hdr[2], rec[2];
+
+	mutex_lock(&uid_lock);
+	uid_freq_fold();
+
+	hdr[0] = uid_nr_freqs;
+	hdr[1] = 0;
+	for_each_possible_cpu(cpu)
+		hdr[1] += per_cpu(uid_freq_cache, cpu).dropped;
+	seq_write(m, hdr, sizeof(hdr));
+	seq_write(m, uid_freqs, uid_nr_freqs * sizeof(u32));
+
+	hash_for_each(hash_table, bkt, node, uid_entry, hash) {
+		if (!uid_entry->time_in_state)
+			continue;
+		rec[0] = uid_entry->uid;
+		rec[1] = 0;
+		seq_write(m, rec, sizeof(rec));
+		seq_write(m, &uid_entry->freq_power, sizeof(u64));
+		seq_write(m, uid_entry->time_in_state,
+			  uid_nr_freqs * sizeof(u64));
+	}
+
+	mutex_unlock(&uid_lock);
+	return 0;
+}
+
+static int uid_time_in_state_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, uid_time_in_state_show, PDE(inode)->data);
+}
+
+static const struct file_operations uid_time_in_state_fops = {
+	.open		= uid_time_in_state_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int uid_freq_cmp(const void *a, const void *b)
+{
+	return *(const unsigned int *)a - *(const unsigned int *)b;
+}
+
+/* The frequency tables are only known once the cpufreq driver is up */
+static int __init uid_freq_init(void)
+{
+	struct cpufreq_frequency_table *table;
+	struct uid_freq_cache *c;
+	unsigned int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		table = cpufreq_frequency_get_table(cpu);
+		if (!table)
+			continue;
+		for (i = 0; table[i].frequency != CPUFREQ_TABLE_END; i++) {
+			unsigned int freq = table[i].frequency;
+
+			if (freq == CPUFREQ_ENTRY_INVALID ||
+			    uid_freq_index(freq) >= 0)
+				continue;
+			if (uid_nr_freqs == UID_FREQ_MAX) {
+				pr_warn("%s: too many frequencies\n", __func__);
+				break;
+			}
+			uid_freqs[uid_nr_freqs++] = freq;
+		}
+	}
+
+	if (!uid_nr_freqs)
+		return 0;
+
+	sort(uid_freqs, uid_nr_freqs, sizeof(unsigned int), uid_freq_cmp, NULL);
+
+	for_each_possible_cpu(cpu) {
+		c = &per_cpu(uid_freq_cache, cpu);
+		spin_lock_init(&c->lock);
+		c->time = kcalloc(UID_CACHE_SIZE * uid_nr_freqs, sizeof(u64),
+				  GFP_KERNEL);
+		if (!c->time)
+			goto err;
+	}
+
+	proc_create_data("time_in_state", S_IRUGO, parent,
+			 &uid_time_in_state_fops, NULL);
+
+	smp_wmb();
+	uid_freq_ready = true;
+	return 0;
+
+err:
+	for_each_possible_cpu(cpu) {
+		kfree(per_cpu(uid_freq_cache, cpu).time);
+		per_cpu(uid_freq_cache, cpu).time = NULL;
+	}
+	return -ENOMEM;
+}
+late_initcall(uid_freq_init);
+#else
+static inline void uid_freq_fold(void)
+{
+}
+#endif
+
 static int uid_stat_show(struct seq_file *m, void *v)
 {
 	struct uid_entry *uid_entry;
@@ -177,11 +434,17 @@ static ssize_t uid_remove_write(struct file *file,
 
 	mutex_lock(&uid_lock);
 
+	/* Or the removed uids come back from the per cpu caches */
+	uid_freq_fold();
+
 	for (; uid_start <= uid_end; uid_start++) {
 		hash_for_each_possible_safe(hash_table, uid_entry, node, tmp,
 							hash, (uid_t)uid_start) {
 			if (uid_start == uid_entry->uid) {
 				hash_del(&uid_entry->hash);
+#ifdef CONFIG_UID_CPUTIME_FREQ
+				kfree(uid_entry->time_in_state);
+#endif
 				kfree(uid_entry);
 			}
 		}
@@ -489,8 +489,10 @@ struct mmc_async_req *mmc_start_req(struct mmc_host *host,
 	struct mmc_async_req *data = host->areq;
 
 	/* Prepare a new request */
-	if (areq)
+	if (areq && !areq->prepared)
 		mmc_pre_req(host, areq->mrq, !host->areq);
+	if (areq)
+		areq->prepared = false;
 
 	if (host->areq) {
 		mmc_wait_for_req_done(host, host->areq->mrq);
@@ -518,6 +520,27 @@ struct mmc_async_req *mmc_start_req(struct mmc_host *host,
 }
 EXPORT_SYMBOL(mmc_start_req);
 
+/**
+ *	mmc_prepare_req - prepare a request ahead of mmc_start_req
+ *	@host: MMC host that will run the request
+ *	@areq: async request to prepare
+ *
+ *	Let the host do the pre processing of a request that is queued
+ *	behind the next one, while an earlier request is running. The host
+ *	keeps up to max_prepared_reqs requests prepared, the others are
+ *	prepared when they are started. The request must then be passed
+ *	to mmc_start_req(), which skips the pre processing.
+ */
+void mmc_prepare_req(struct mmc_host *host, struct mmc_async_req *areq)
+{
+	if (areq->prepared)
+		return;
+
+	mmc_pre_req(host, areq->mrq, false);
+	areq->prepared = true;
+}
+EXPORT_SYMBOL(mmc_prepare_req);
+
 /**
  *	mmc_wait_for_req - start a request and wait for completion
  *	@host: MMC host to start command
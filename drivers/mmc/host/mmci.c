@@ -31,6 +31,7 @@
 #include <linux/dma-mapping.h>
 #include <linux/amba/mmci.h>
 #include <linux/pm_runtime.h>
+#include <linux/blk-iopoll.h>
 
 #include <asm/div64.h>
 #include <asm/io.h>
@@ -42,6 +43,18 @@
 
 static unsigned int fmax = 515633;
 
+#ifdef CONFIG_MMC_MMCI_IOPOLL
+/*
+ * Above this many requests per second the interrupts of a host are
+ * handled from the iopoll softirq, 0 never does.
+ */
+static unsigned int iopoll_rate = 200;
+#define MMCI_IOPOLL_WINDOW	(HZ / 10)
+/* Events handled per poll, and how long to wait for a command response */
+#define MMCI_IOPOLL_WEIGHT	8
+#define MMCI_IOPOLL_SPIN_USEC	50
+#endif
+
 #ifdef _MMC_SAFE_ACCESS_
 mmc_is_available = 0;
 EXPORT_SYMBOL(mmc_is_available);
@@ -365,17 +378,37 @@ mmci_request_end(struct mmci_host *host, struct mmc_request *mrq)
 	pm_runtime_put_autosuspend(mmc_dev(host->mmc));
 }
 
+static inline u32 mmci_get_mask0(struct mmci_host *host)
+{
+#ifdef CONFIG_MMC_MMCI_IOPOLL
+	if (host->iopoll_masked)
+		return host->iopoll_mask0;
+#endif
+	return readl(host->base + MMCIMASK0);
+}
+
+static inline void mmci_set_mask0(struct mmci_host *host, u32 mask)
+{
+#ifdef CONFIG_MMC_MMCI_IOPOLL
+	if (host->iopoll_masked) {
+		host->iopoll_mask0 = mask;
+		return;
+	}
+#endif
+	writel(mask, host->base + MMCIMASK0);
+}
+
 static void mmci_set_mask1(struct mmci_host *host, unsigned int mask)
 {
 	void __iomem *base = host->base;
 
 	if (host->singleirq) {
-		unsigned int mask0 = readl(base + MMCIMASK0);
+		unsigned int mask0 = mmci_get_mask0(host);
 
 		mask0 &= ~MCI_IRQ1MASK;
 		mask0 |= mask;
 
-		writel(mask0, base + MMCIMASK0);
+		mmci_set_mask0(host, mask0);
 	}
 
 	writel(mask, base + MMCIMASK1);
@@ -421,7 +454,7 @@ static void mmci_dma_setup(struct mmci_host *host)
 	}
 
 	/* initialize pre request cookie */
-	host->next_data.cookie = 1;
+	host->next_cookie = 1;
 
 	/* Try to acquire a generic DMA engine slave channel */
 	dma_cap_zero(mask);
@@ -482,6 +515,30 @@ static void mmci_dma_setup(struct mmci_host *host)
 		if (max_seg_size < host->mmc->max_seg_size)
 			host->mmc->max_seg_size = max_seg_size;
 	}
+
+	if (host->dma_rx_channel || host->dma_tx_channel)
+		host->mmc->max_prepared_reqs = MMCI_MAX_PREPARED;
+}
+
+/*
+ * Forget the jobs prepared on @chan, or on both channels if NULL: a
+ * terminated or released channel frees the descriptors it held. The
+ * requests are mapped again when they are started.
+ */
+static void mmci_dma_drop_prepared(struct mmci_host *host,
+				   struct dma_chan *chan)
+{
+	struct mmci_host_next *nd;
+	int i;
+
+	for (i = 0; i < MMCI_MAX_PREPARED; i++) {
+		nd = &host->next_data[i];
+		if (!chan || nd->dma_chan == chan) {
+			nd->dma_desc = NULL;
+			nd->dma_chan = NULL;
+		}
+	}
+	host->dma_resets++;
 }
 
 /*
@@ -497,6 +554,7 @@ static inline void mmci_dma_release(struct mmci_host *host)
 	if (host->dma_tx_channel && plat->dma_tx_param)
 		dma_release_channel(host->dma_tx_channel);
 	host->dma_rx_channel = host->dma_tx_channel = NULL;
+	mmci_dma_drop_prepared(host, NULL);
 }
 
 /*
@@ -508,8 +566,6 @@ static void mmci_dma_disable(struct mmci_host *host)
 		mmci_dma_release(host);
 		host->dma_current = NULL;
 		host->dma_desc_current = NULL;
-		host->next_data.dma_desc = NULL;
-		host->next_data.dma_chan = NULL;
 		host->dma_was_disabled = 1;
 	}
 }
@@ -527,6 +583,7 @@ static void mmci_dma_data_error(struct mmci_host *host, struct mmc_data *data)
 {
 	dev_err(mmc_dev(host->mmc), "error during DMA transfer!\n");
 	dmaengine_terminate_all(host->dma_current);
+	mmci_dma_drop_prepared(host, host->dma_current);
 	host->dma_current = NULL;
 	host->dma_desc_current = NULL;
 	data->host_cookie = 0;
@@ -661,11 +718,15 @@ static int inline mmci_dma_prep_data(struct mmci_host *host,
 				    &host->dma_desc_current);
 }
 
-static inline int mmci_dma_prep_next(struct mmci_host *host,
-				     struct mmc_data *data)
+static struct mmci_host_next *mmci_dma_free_next(struct mmci_host *host)
 {
-	struct mmci_host_next *nd = &host->next_data;
-	return __mmci_dma_prep_data(host, data, &nd->dma_chan, &nd->dma_desc);
+	int i;
+
+	for (i = 0; i < MMCI_MAX_PREPARED; i++)
+		if (!host->next_data[i].dma_desc)
+			return &host->next_data[i];
+
+	return NULL;
 }
 
 static int mmci_dma_start_data(struct mmci_host *host)
@@ -700,22 +761,35 @@ static int mmci_dma_start_data(struct mmci_host *host)
 	 * to fire next DMA request. When that happens, MMCI will
 	 * call mmci_data_end()
 	 */
-	writel(readl(host->base + MMCIMASK0) | MCI_DATAENDMASK,
-	       host->base + MMCIMASK0);
+	mmci_set_mask0(host, mmci_get_mask0(host) | MCI_DATAENDMASK);
 	return 0;
 }
 
 static void mmci_get_next_data(struct mmci_host *host, struct mmc_data *data)
 {
-	struct mmci_host_next *next = &host->next_data;
+	struct mmci_host_next *next;
+	int i;
+
+	host->dma_desc_current = NULL;
+	host->dma_current = NULL;
 
-	WARN_ON(data->host_cookie && data->host_cookie != next->cookie);
-	WARN_ON(!data->host_cookie && (next->dma_desc || next->dma_chan));
+	if (!data->host_cookie)
+		return;
+
+	for (i = 0; i < MMCI_MAX_PREPARED; i++) {
+		next = &host->next_data[i];
+		if (next->dma_desc && next->cookie == data->host_cookie) {
+			host->dma_desc_current = next->dma_desc;
+			host->dma_current = next->dma_chan;
+			next->dma_desc = NULL;
+			next->dma_chan = NULL;
+			return;
+		}
+	}
 
-	host->dma_desc_current = next->dma_desc;
-	host->dma_current = next->dma_chan;
-	next->dma_desc = NULL;
-	next->dma_chan = NULL;
+	/* The prepared job was dropped, it is prepared again at start */
+	mmci_dma_unmap(host, data);
+	data->host_cookie = 0;
 }
 
 static void mmci_pre_request(struct mmc_host *mmc, struct mmc_request *mrq,
@@ -723,7 +797,11 @@ static void mmci_pre_request(struct mmc_host *mmc, struct mmc_request *mrq,
 {
 	struct mmci_host *host = mmc_priv(mmc);
 	struct mmc_data *data = mrq->data;
-	struct mmci_host_next *nd = &host->next_data;
+	struct dma_async_tx_descriptor *desc;
+	struct mmci_host_next *nd;
+	struct dma_chan *chan;
+	unsigned int resets;
+	unsigned long flags;
 
 	if (!data)
 		return;
@@ -738,8 +816,35 @@ static void mmci_pre_request(struct mmc_host *mmc, struct mmc_request *mrq,
 	 * is_first_req is set. Instead, prepare DMA while
 	 * start command is being issued.
 	 */
-	if (!is_first_req && !mmci_dma_prep_next(host, data))
-		data->host_cookie = ++nd->cookie < 0 ? 1 : nd->cookie;
+	if (is_first_req)
+		return;
+
+	/*
+	 * Slots are filled here and emptied by mmci_request(), both called
+	 * by the host claimer. The interrupt handler may only drop them.
+	 */
+	nd = mmci_dma_free_next(host);
+	if (!nd)
+		return;
+
+	resets = ACCESS_ONCE(host->dma_resets);
+	if (__mmci_dma_prep_data(host, data, &chan, &desc))
+		return;
+
+	spin_lock_irqsave(&host->lock, flags);
+	if (host->dma_resets == resets && !nd->dma_desc) {
+		if (++host->next_cookie < 0)
+			host->next_cookie = 1;
+		nd->dma_desc = desc;
+		nd->dma_chan = chan;
+		nd->cookie = host->next_cookie;
+		data->host_cookie = host->next_cookie;
+	}
+	spin_unlock_irqrestore(&host->lock, flags);
+
+	/* The channel was reset meanwhile and took the descriptor along */
+	if (!data->host_cookie)
+		mmci_dma_unmap(host, data);
 }
 
 static void mmci_post_request(struct mmc_host *mmc, struct mmc_request *mrq,
@@ -754,8 +859,9 @@ static void mmci_post_request(struct mmc_host *mmc, struct mmc_request *mrq,
 	mmci_dma_unmap(host, data);
 
 	if (err) {
-		struct mmci_host_next *next = &host->next_data;
 		struct dma_chan *chan;
+		unsigned long flags;
+
 		if (data->flags & MMC_DATA_READ)
 			chan = host->dma_rx_channel;
 		else
@@ -764,8 +870,9 @@ static void mmci_post_request(struct mmc_host *mmc, struct mmc_request *mrq,
 		if (chan)
 			dmaengine_terminate_all(chan);
 
-		next->dma_desc = NULL;
-		next->dma_chan = NULL;
+		spin_lock_irqsave(&host->lock, flags);
+		mmci_dma_drop_prepared(host, chan);
+		spin_unlock_irqrestore(&host->lock, flags);
 	}
 }
 
@@ -940,7 +1047,7 @@ static void mmci_start_data(struct mmci_host *host, struct mmc_data *data)
 		irqmask = MCI_TXFIFOHALFEMPTYMASK;
 	}
 
-	writel(readl(base + MMCIMASK0) & ~MCI_DATAENDMASK, base + MMCIMASK0);
+	mmci_set_mask0(host, mmci_get_mask0(host) & ~MCI_DATAENDMASK);
 	mmci_set_mask1(host, irqmask);
 }
 
@@ -1272,7 +1379,7 @@ static irqreturn_t mmci_pio_irq(int irq, void *dev_id)
 	 */
 	if (host->size == 0) {
 		mmci_set_mask1(host, 0);
-		writel(readl(base + MMCIMASK0) | MCI_DATAENDMASK, base + MMCIMASK0);
+		mmci_set_mask0(host, mmci_get_mask0(host) | MCI_DATAENDMASK);
 	}
 
 	return IRQ_HANDLED;
@@ -1281,42 +1388,150 @@ static irqreturn_t mmci_pio_irq(int irq, void *dev_id)
 /*
  * Handle completion of command and data transfers.
  */
-static irqreturn_t mmci_irq(int irq, void *dev_id)
+/* Handle the pending irq0 events once, returns them. Called with the lock */
+static u32 mmci_irq_events(struct mmci_host *host, int irq)
 {
-	struct mmci_host *host = dev_id;
+	struct mmc_command *cmd;
+	struct mmc_data *data;
 	u32 status;
-	int ret = 0;
 
-	spin_lock(&host->lock);
+	status = readl(host->base + MMCISTATUS);
 
-	do {
-		struct mmc_command *cmd;
-		struct mmc_data *data;
+	if (host->singleirq) {
+		if (status & readl(host->base + MMCIMASK1))
+			mmci_pio_irq(irq, host);
 
-		status = readl(host->base + MMCISTATUS);
+		status &= ~MCI_IRQ1MASK;
+	}
+
+	status &= mmci_get_mask0(host);
+	writel(status, host->base + MMCICLEAR);
+
+	dev_dbg(mmc_dev(host->mmc), "irq0 (data+cmd) %08x\n", status);
+
+	data = host->data;
+	if (status & (MCI_DATACRCFAIL|MCI_DATATIMEOUT|MCI_STARTBITERR|
+		      MCI_TXUNDERRUN|MCI_RXOVERRUN|MCI_DATAEND|
+		      MCI_DATABLOCKEND) && data)
+		mmci_data_irq(host, data, status);
+
+	cmd = host->cmd;
+	if (status & (MCI_CMDCRCFAIL|MCI_CMDTIMEOUT|MCI_CMDSENT|MCI_CMDRESPEND) && cmd)
+		mmci_cmd_irq(host, cmd, status);
+
+	return status;
+}
+
+#ifdef CONFIG_MMC_MMCI_IOPOLL
+/*
+ * Under a high request rate the interrupt only masks the host and
+ * schedules mmci_iopoll(). A request takes two or three interrupts, for
+ * the command responses and the end of the data. The poll handles them
+ * in one pass: after sending a command it waits a few microseconds for
+ * the response instead of taking one more interrupt, and it leaves the
+ * host unmasked for the end of the data, which takes milliseconds.
+ */
+static int mmci_iopoll(struct blk_iopoll *iop, int budget)
+{
+	struct mmci_host *host = container_of(iop, struct mmci_host, iopoll);
+	unsigned long flags;
+	int done = 0, spin;
 
-		if (host->singleirq) {
-			if (status & readl(host->base + MMCIMASK1))
-				mmci_pio_irq(irq, dev_id);
+	spin_lock_irqsave(&host->lock, flags);
+
+	while (done < budget) {
+		if (mmci_irq_events(host, 0)) {
+			done++;
+			continue;
+		}
 
-			status &= ~MCI_IRQ1MASK;
+		/* Nothing pending, a command in flight answers shortly */
+		if (!host->cmd)
+			break;
+		for (spin = 0; spin < MMCI_IOPOLL_SPIN_USEC; spin++) {
+			if (readl(host->base + MMCISTATUS) &
+			    mmci_get_mask0(host))
+				break;
+			udelay(1);
 		}
+		if (spin == MMCI_IOPOLL_SPIN_USEC)
+			break;
+	}
+
+	host->iopoll_masked = false;
+	writel(host->iopoll_mask0, host->base + MMCIMASK0);
 
-		status &= readl(host->base + MMCIMASK0);
-		writel(status, host->base + MMCICLEAR);
+	spin_unlock_irqrestore(&host->lock, flags);
+
+	if (done < budget)
+		blk_iopoll_complete(iop);
+	return done;
+}
+
+/* Called with the lock, returns true if the events are left to the poll */
+static bool mmci_iopoll_sched(struct mmci_host *host)
+{
+	if (!host->iopoll_on || !blk_iopoll_enabled || host->iopoll_masked)
+		return false;
+
+	/* The FIFO of a PIO transfer is served from the interrupt */
+	if (host->data && !dma_inprogress(host))
+		return false;
 
-		dev_dbg(mmc_dev(host->mmc), "irq0 (data+cmd) %08x\n", status);
+	if (blk_iopoll_sched_prep(&host->iopoll))
+		return false;
 
-		data = host->data;
-		if (status & (MCI_DATACRCFAIL|MCI_DATATIMEOUT|MCI_STARTBITERR|
-			      MCI_TXUNDERRUN|MCI_RXOVERRUN|MCI_DATAEND|
-			      MCI_DATABLOCKEND) && data)
-			mmci_data_irq(host, data, status);
+	host->iopoll_mask0 = readl(host->base + MMCIMASK0);
+	host->iopoll_masked = true;
+	writel(0, host->base + MMCIMASK0);
+	blk_iopoll_sched(&host->iopoll);
 
-		cmd = host->cmd;
-		if (status & (MCI_CMDCRCFAIL|MCI_CMDTIMEOUT|MCI_CMDSENT|MCI_CMDRESPEND) && cmd)
-			mmci_cmd_irq(host, cmd, status);
+	return true;
+}
 
+/* Called with the lock for each request */
+static void mmci_iopoll_account(struct mmci_host *host)
+{
+	unsigned long elapsed = jiffies - host->rq_window;
+	unsigned int rate;
+
+	host->rq_count++;
+	if (elapsed < MMCI_IOPOLL_WINDOW)
+		return;
+
+	rate = host->rq_count * HZ / elapsed;
+	if (host->iopoll_on)
+		host->iopoll_on = iopoll_rate && rate >= iopoll_rate / 2;
+	else
+		host->iopoll_on = iopoll_rate && rate >= iopoll_rate;
+
+	host->rq_count = 0;
+	host->rq_window = jiffies;
+}
+#else
+static inline bool mmci_iopoll_sched(struct mmci_host *host)
+{
+	return false;
+}
+
+static inline void mmci_iopoll_account(struct mmci_host *host) { }
+#endif
+
+static irqreturn_t mmci_irq(int irq, void *dev_id)
+{
+	struct mmci_host *host = dev_id;
+	u32 status;
+	int ret = 0;
+
+	spin_lock(&host->lock);
+
+	if (mmci_iopoll_sched(host)) {
+		spin_unlock(&host->lock);
+		return IRQ_HANDLED;
+	}
+
+	do {
+		status = mmci_irq_events(host, irq);
 		ret = 1;
 	} while (status);
 
@@ -1344,6 +1559,7 @@ static void mmci_request(struct mmc_host *mmc, struct mmc_request *mrq)
 	spin_lock_irqsave(&host->lock, flags);
 
 	host->mrq = mrq;
+	mmci_iopoll_account(host);
 
 	if (mrq->data) {
 		dmaprep_after_cmd =
@@ -1607,10 +1823,10 @@ static void mmci_abort_request(struct mmc_host *mmc)
 		writel(0, host->base + MMCIARGUMENT);
 		writel(0, host->base + MMCICOMMAND);
 		writel(0, host->base + MMCIDATACTRL);
-		writel(0, host->base + MMCIMASK0);
+		mmci_set_mask0(host, 0);
 		writel(0, host->base + MMCIMASK1);
 		writel(0xfff, host->base + MMCICLEAR);
-		writel(MCI_IRQENABLE, host->base + MMCIMASK0);
+		mmci_set_mask0(host, MCI_IRQENABLE);
 	} else {
 		dev_warn(mmc_dev(mmc), "Nothing to abort, "
 			"request already completed?\n");
@@ -1945,8 +2161,17 @@ static int __devinit mmci_probe(struct amba_device *dev,
 
 	writel(MCI_IRQENABLE, host->base + MMCIMASK0);
 
+#ifdef CONFIG_MMC_MMCI_IOPOLL
+	blk_iopoll_init(&host->iopoll, MMCI_IOPOLL_WEIGHT, mmci_iopoll);
+	blk_iopoll_enable(&host->iopoll);
+	host->rq_window = jiffies;
+#endif
+
 	amba_set_drvdata(dev, mmc);
 
+	/* The cards and SDIO functions below are children, they wait for us */
+	device_enable_async_suspend(&dev->dev);
+
 	dev_info(&dev->dev, "%s: PL%03x manf %x rev%u at 0x%08llx irq %d,%d (pio)\n",
 		 mmc_hostname(mmc), amba_part(dev), amba_manf(dev),
 		 amba_rev(dev), (unsigned long long)dev->res.start,
@@ -2003,6 +2228,9 @@ static int __devexit mmci_remove(struct amba_device *dev)
 
 		mmc_remove_host(mmc);
 
+#ifdef CONFIG_MMC_MMCI_IOPOLL
+		blk_iopoll_disable(&host->iopoll);
+#endif
 		writel(0, host->base + MMCIMASK0);
 		writel(0, host->base + MMCIMASK1);
 
@@ -2255,6 +2483,10 @@ static void __exit mmci_exit(void)
 module_init(mmci_init);
 module_exit(mmci_exit);
 module_param(fmax, uint, 0444);
+#ifdef CONFIG_MMC_MMCI_IOPOLL
+module_param(iopoll_rate, uint, 0644);
+MODULE_PARM_DESC(iopoll_rate, "Requests per second above which completions are polled, 0 to never poll");
+#endif
 
 MODULE_DESCRIPTION("ARM PrimeCell PL180/181 Multimedia Card Interface driver");
 MODULE_LICENSE("GPL");
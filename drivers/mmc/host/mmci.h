@@ -161,6 +161,9 @@
 
 #define NR_SG		128
 
+/* DMA jobs that can be prepared ahead of the running one */
+#define MMCI_MAX_PREPARED	3
+
 struct clk;
 struct variant_data;
 struct dma_chan;
@@ -212,12 +215,26 @@ struct mmci_host {
 	struct dma_chan		*dma_rx_channel;
 	struct dma_chan		*dma_tx_channel;
 	struct dma_async_tx_descriptor	*dma_desc_current;
-	struct mmci_host_next	next_data;
+	struct mmci_host_next	next_data[MMCI_MAX_PREPARED];
+	s32			next_cookie;
+	/* Bumped when the channels drop their prepared descriptors */
+	unsigned int		dma_resets;
 	bool			dma_was_disabled;
 
 #define dma_inprogress(host)	((host)->dma_current)
 #else
 #define dma_inprogress(host)	(0)
 #endif
+
+#ifdef CONFIG_MMC_MMCI_IOPOLL
+	/* Completions from the iopoll softirq, see mmci_iopoll() */
+	struct blk_iopoll	iopoll;
+	bool			iopoll_on;
+	/* MASK0 is cleared, the mask in use is iopoll_mask0 */
+	bool			iopoll_masked;
+	u32			iopoll_mask0;
+	unsigned int		rq_count;
+	unsigned long		rq_window;
+#endif
 };
 
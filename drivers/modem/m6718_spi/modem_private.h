@@ -36,6 +36,9 @@
 #define IPC_L1_HDR_SIZE (4)
 #define IPC_L2_HDR_SIZE (4)
 
+/* largest L1 frame built by merging queued L2 PDUs */
+#define IPC_L1_MERGE_MAX_SIZE (8*1024)
+
 /* tx queue item (frame) */
 struct ipc_tx_queue {
 	struct list_head node;
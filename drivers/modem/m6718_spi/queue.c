@@ -75,7 +75,9 @@ int ipc_queue_push_frame(struct ipc_link_context *context, u8 channel,
 	u32 l2_hdr;
 	unsigned long flags;
 	struct ipc_tx_queue *frame;
+#ifndef CONFIG_MODEM_M6718_SPI_ENABLE_FEATURE_MERGE_FRAMES
 	int *tx_frame_counter = &context->tx_frame_counter;
+#endif
 	int qcount;
 
 	/*
@@ -103,8 +105,10 @@ int ipc_queue_push_frame(struct ipc_link_context *context, u8 channel,
 	memcpy(frame->data + IPC_L2_HDR_SIZE, data, length);
 
 	spin_lock_irqsave(&context->tx_q_update_lock, flags);
+#ifndef CONFIG_MODEM_M6718_SPI_ENABLE_FEATURE_MERGE_FRAMES
 	frame->counter = *tx_frame_counter;
 	*tx_frame_counter = (*tx_frame_counter + 1) % MAX_FRAME_COUNTER;
+#endif
 	list_add_tail(&frame->node, &context->tx_q);
 	qcount = atomic_add_return(1, &context->tx_q_count);
 	/* tx_q_free could go negative here */
@@ -127,6 +131,69 @@ int ipc_queue_push_frame(struct ipc_link_context *context, u8 channel,
 	return 0;
 }
 
+#ifdef CONFIG_MODEM_M6718_SPI_ENABLE_FEATURE_MERGE_FRAMES
+/*
+ * Append the PDUs queued behind the first one to it, as long as they fit in
+ * IPC_L1_MERGE_MAX_SIZE. Each PDU is already padded to FRAME_LENGTH_ALIGN so
+ * the receiver finds the next L2 header right after it. The state machine
+ * is the only consumer of the queue, so the frames counted here are still
+ * at its head when they are taken.
+ */
+static struct ipc_tx_queue *ipc_queue_merge(struct ipc_link_context *context,
+	struct ipc_tx_queue *first)
+{
+	struct ipc_tx_queue *merged;
+	struct ipc_tx_queue *frame;
+	struct ipc_tx_queue *tmp;
+	unsigned long flags;
+	LIST_HEAD(frames);
+	int total = first->len;
+	int nbr = 0;
+	u8 *data;
+
+	spin_lock_irqsave(&context->tx_q_update_lock, flags);
+	list_for_each_entry(frame, &context->tx_q, node) {
+		if (total + frame->len > IPC_L1_MERGE_MAX_SIZE)
+			break;
+		total += frame->len;
+		nbr++;
+	}
+	spin_unlock_irqrestore(&context->tx_q_update_lock, flags);
+
+	if (nbr == 0)
+		return first;
+
+	merged = ipc_queue_new_frame(context, total);
+	if (merged == NULL)
+		return first;
+
+	spin_lock_irqsave(&context->tx_q_update_lock, flags);
+	list_add_tail(&first->node, &frames);
+	while (nbr--) {
+		frame = list_first_entry(&context->tx_q,
+				struct ipc_tx_queue, node);
+		list_move_tail(&frame->node, &frames);
+		atomic_dec(&context->tx_q_count);
+		context->tx_q_free += frame->len;
+	}
+	spin_unlock_irqrestore(&context->tx_q_update_lock, flags);
+
+	data = merged->data;
+	merged->actual_len = 0;
+	list_for_each_entry_safe(frame, tmp, &frames, node) {
+		memcpy(data, frame->data, frame->len);
+		data += frame->len;
+		merged->actual_len += frame->actual_len;
+		ipc_queue_delete_frame(frame);
+	}
+
+	dev_dbg(&context->sdev->dev,
+		"link %d: merged tx frames into %d bytes\n",
+		context->link->id, merged->len);
+	return merged;
+}
+#endif
+
 struct ipc_tx_queue *ipc_queue_get_frame(struct ipc_link_context *context)
 {
 	unsigned long flags;
@@ -140,6 +207,14 @@ struct ipc_tx_queue *ipc_queue_get_frame(struct ipc_link_context *context)
 	context->tx_q_free += frame->len;
 	spin_unlock_irqrestore(&context->tx_q_update_lock, flags);
 
+#ifdef CONFIG_MODEM_M6718_SPI_ENABLE_FEATURE_MERGE_FRAMES
+	/* L1 frames are numbered as they are sent rather than queued */
+	frame = ipc_queue_merge(context, frame);
+	frame->counter = context->tx_frame_counter;
+	context->tx_frame_counter =
+		(context->tx_frame_counter + 1) % MAX_FRAME_COUNTER;
+#endif
+
 	dev_dbg(&context->sdev->dev,
 		"link %d: get tx frame %d, new count %d, "
 		"new free %d\n",
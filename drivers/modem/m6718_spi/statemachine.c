@@ -530,6 +530,65 @@ static u8 sm_act_rx_wr_dat_enter(u8 event, struct ipc_link_context *context)
 	return IPC_SM_RUN_NONE;
 }
 
+static void sm_rx_deliver(struct ipc_link_context *context,
+	unsigned char l2_header, unsigned int l2_length, u8 *l2_data)
+{
+	/* pass received frame up to L2mux layer */
+	if (!modem_protocol_channel_is_open(l2_header)) {
+		dev_err(&context->sdev->dev,
+			"link %d error: received frame on invalid channel %d, "
+			"frame discarded\n",
+			context->link->id, l2_header);
+	} else {
+#ifdef CONFIG_MODEM_M6718_SPI_ENABLE_FEATURE_THROUGHPUT_MEASUREMENT
+		/*
+		 * Discard loopback frames if we are taking throughput
+		 * measurements - we'll be loading the links and so will likely
+		 * overload the buffers.
+		 */
+		if (!ipc_util_channel_is_loopback(l2_header))
+#endif
+			modem_m6718_spi_receive(context->sdev,
+				l2_header, l2_length, l2_data);
+	}
+}
+
+#ifdef CONFIG_MODEM_M6718_SPI_ENABLE_FEATURE_MERGE_FRAMES
+/* deliver the L2 PDUs following the first one in a merged L1 frame */
+static void sm_rx_deliver_merged(struct ipc_link_context *context,
+	unsigned int l2_length)
+{
+	u8  *pdu = context->frame->data;
+	int left = context->frame->len;
+	u32 frame_hdr;
+
+	for (;;) {
+		/* PDUs are padded to 4 bytes */
+		l2_length = IPC_L2_HDR_SIZE + ALIGN(l2_length, 4);
+		pdu += l2_length;
+		left -= l2_length;
+		if (left < IPC_L2_HDR_SIZE)
+			break;
+
+		/* the rest of the frame is padding */
+		frame_hdr = *(u32 *)pdu;
+		if (frame_hdr == 0)
+			break;
+
+		l2_length = ipc_util_get_l2_length(frame_hdr);
+		if (l2_length > left - IPC_L2_HDR_SIZE) {
+			dev_err(&context->sdev->dev,
+				"link %d: truncated merged frame: L2 len %d "
+				"left %d\n",
+				context->link->id, l2_length, left);
+			break;
+		}
+		sm_rx_deliver(context, ipc_util_get_l2_channel(frame_hdr),
+			l2_length, pdu + IPC_L2_HDR_SIZE);
+	}
+}
+#endif
+
 static const struct ipc_sm_state *sm_act_rx_wr_dat_exit(u8 event,
 	struct ipc_link_context *context)
 {
@@ -574,24 +633,11 @@ static const struct ipc_sm_state *sm_act_rx_wr_dat_exit(u8 event,
 	if (ipc_util_channel_is_loopback(l2_header))
 		ipc_dbg_verify_rx_frame(context);
 
-	/* pass received frame up to L2mux layer */
-	if (!modem_protocol_channel_is_open(l2_header)) {
-		dev_err(&context->sdev->dev,
-			"link %d error: received frame on invalid channel %d, "
-			"frame discarded\n",
-			context->link->id, l2_header);
-	} else {
-#ifdef CONFIG_MODEM_M6718_SPI_ENABLE_FEATURE_THROUGHPUT_MEASUREMENT
-		/*
-		 * Discard loopback frames if we are taking throughput
-		 * measurements - we'll be loading the links and so will likely
-		 * overload the buffers.
-		 */
-		if (!ipc_util_channel_is_loopback(l2_header))
+	sm_rx_deliver(context, l2_header, l2_length, l2_data);
+#ifdef CONFIG_MODEM_M6718_SPI_ENABLE_FEATURE_MERGE_FRAMES
+	if (l2_length <= context->frame->len - IPC_L2_HDR_SIZE)
+		sm_rx_deliver_merged(context, l2_length);
 #endif
-			modem_m6718_spi_receive(context->sdev,
-				l2_header, l2_length, l2_data);
-	}
 
 	/* data is copied by L2mux so free the frame here */
 	ipc_queue_delete_frame(context->frame);
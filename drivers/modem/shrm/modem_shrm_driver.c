@@ -256,6 +256,63 @@ static int audio_receive(struct shrm_dev *shrm, void *data,
 	return ret;
 }
 
+/*
+ * A message may skip the queue if the tasklet draining the queue has
+ * nothing queued or in flight, or the receiver would see it out of order.
+ */
+static bool rx_queue_idle(struct message_queue *q, struct tasklet_struct *t)
+{
+	bool idle;
+
+	spin_lock(&q->update_lock);
+	idle = list_empty(&q->msg_list) &&
+		!test_bit(TASKLET_STATE_SCHED, &t->state);
+#ifdef CONFIG_SMP
+	idle = idle && !test_bit(TASKLET_STATE_RUN, &t->state);
+#endif
+	spin_unlock(&q->update_lock);
+
+	return idle;
+}
+
+/*
+ * Hands a network message to its receiver straight from the receive buffer,
+ * saving the copies into and out of the queue. Returns true if the message
+ * was taken.
+ */
+static bool rx_direct(struct shrm_dev *shrm, struct message_queue *q,
+		int idx, u8 *data, u32 n_bytes)
+{
+#ifdef CONFIG_U8500_SHRM_SVNET
+	struct tasklet_struct *t;
+	struct l3if_handler *hd;
+
+	if (idx == ISI_MESSAGING)
+		t = &phonet_rcv_tasklet;
+	else if (idx == IPCDATAINDX)
+		t = &ipcdata_rcv_tasklet;
+	else
+		return false;
+
+	list_for_each_entry(hd, &ipc_list.list, list) {
+		if (hd->indx != idx)
+			continue;
+		if (!hd->handler || !rx_queue_idle(q, t))
+			return false;
+		hd->handler(n_bytes, data, hd->sipc);
+		return true;
+	}
+#endif
+#ifdef CONFIG_U8500_SHRM_DEFAULT_NET
+	if (idx == ISI_MESSAGING && shrm->netdev_flag_up &&
+			rx_queue_idle(q, &phonet_rcv_tasklet)) {
+		shrm_net_receive_msg(shrm->ndev, data, n_bytes);
+		return true;
+	}
+#endif
+	return false;
+}
+
 /**
  * common_receive() - Receive common channel completion callback
  * @shrm:	pointer to the shrm device information structure
@@ -292,6 +349,8 @@ static int common_receive(struct shrm_dev *shrm, void *data,
 	}
 	isa_dev = &shrm->isa_context->isadev[idx];
 	q = &isa_dev->dl_queue;
+	if (rx_direct(shrm, q, idx, data, n_bytes))
+		return 0;
 	spin_lock(&q->update_lock);
 	/* Memcopy RX data first */
 	if ((q->writeptr+n_bytes) >= q->size) {
@@ -56,7 +56,6 @@ void shm_fifo_init(struct shrm_dev *shrm)
 	ape_shm_fifo_0.availablesize = shrm->ape_common_fifo_size;
 	ape_shm_fifo_0.end_addr_fifo    = shrm->ape_common_fifo_size;
 	ape_shm_fifo_0.fifo_virtual_addr = shrm->ape_common_fifo_base;
-	spin_lock_init(&ape_shm_fifo_0.fifo_update_lock);
 
 
 	cmt_shm_fifo_0.reader_local_rptr	= 0;
@@ -78,7 +77,6 @@ void shm_fifo_init(struct shrm_dev *shrm)
 	ape_shm_fifo_1.availablesize = shrm->ape_audio_fifo_size;
 	ape_shm_fifo_1.end_addr_fifo    = shrm->ape_audio_fifo_size;
 	ape_shm_fifo_1.fifo_virtual_addr = shrm->ape_audio_fifo_base;
-	spin_lock_init(&ape_shm_fifo_1.fifo_update_lock);
 
 	cmt_shm_fifo_1.reader_local_rptr	= 0;
 	cmt_shm_fifo_1.reader_local_wptr	= 0;
@@ -130,7 +128,6 @@ void write_boot_info_resp(struct shrm_dev *shrm, u32 config,
 	u8 msg_length;
 	version = SHRM_VER;
 
-	spin_lock_bh(&fifo->fifo_update_lock);
 	/* Read L1 header read content of reader_local_rptr */
 	msg = (u32 *)
 		(fifo->writer_local_wptr+fifo->fifo_virtual_addr);
@@ -150,9 +147,8 @@ void write_boot_info_resp(struct shrm_dev *shrm, u32 config,
 		*msg = ca_csc_inactivity_timer;
 		msg_length = L1_NORMAL_MSG;
 	}
-	fifo->writer_local_wptr += msg_length;
-	fifo->availablesize -= msg_length;
-	spin_unlock_bh(&fifo->fifo_update_lock);
+	wmb();
+	ACCESS_ONCE(fifo->writer_local_wptr) += msg_length;
 }
 
 /**
@@ -176,6 +172,7 @@ int shm_write_msg_to_fifo(struct shrm_dev *shrm, u8 channel,
 	struct fifo_write_params *fifo = NULL;
 	u32 l1_header = 0, l2_header = 0;
 	u32 requiredsize;
+	u32 rptr, wptr;
 	u32 size = 0;
 	u32 *msg;
 	u8 *src;
@@ -194,6 +191,17 @@ int shm_write_msg_to_fifo(struct shrm_dev *shrm, u8 channel,
 	/* Add size of L1 & L2 header */
 	requiredsize += 2;
 
+	/*
+	 * Writers of a channel are serialised by the callers, the only other
+	 * user of the pointers is the read notification moving the read
+	 * pointer forward. Work on a snapshot of it, the free space can only
+	 * grow behind our back.
+	 */
+	rptr = ACCESS_ONCE(fifo->writer_local_rptr);
+	wptr = fifo->writer_local_wptr;
+	fifo->availablesize = fifo->end_addr_fifo -
+		((wptr + fifo->end_addr_fifo - rptr) % fifo->end_addr_fifo);
+
 	/* if availablesize = or < requiredsize then error */
 	if (fifo->availablesize <= requiredsize) {
 		/* Fatal ERROR - should never happens */
@@ -238,144 +246,61 @@ int shm_write_msg_to_fifo(struct shrm_dev *shrm, u8 channel,
 				((length + L2_HEADER_SIZE) & MASK_0_39_BIT));
 	}
 
-	/*
-	 * Need to take care race condition for fifo->availablesize
-	 * & fifo->writer_local_rptr with Ac_Read_notification interrupt.
-	 * One option could be use stack variable for LocalRptr and recompute
-	 * fifo->availablesize,based on flag enabled in the
-	 * Ac_read_notification
-	 */
 	l2_header = ((l2header << L2_HEADER_OFFSET) |
 					((length) & MASK_0_39_BIT));
-	spin_lock_bh(&fifo->fifo_update_lock);
-	/* Check Local Rptr is less than or equal to Local WPtr */
-	if (fifo->writer_local_rptr <= fifo->writer_local_wptr) {
-		msg = (u32 *)
-			(fifo->fifo_virtual_addr+fifo->writer_local_wptr);
-
-		/* check enough place bewteen writer_local_wptr & end of FIFO */
-		if ((fifo->end_addr_fifo-fifo->writer_local_wptr) >=
-							requiredsize) {
-			/* Add L1 header and L2 header */
-			*msg = l1_header;
-			msg++;
-			*msg = l2_header;
-			msg++;
-
-			/* copy the l2 message in 1 memcpy */
-			memcpy((void *)msg, addr, length);
-			/* UpdateWptr */
-			fifo->writer_local_wptr += requiredsize;
-			fifo->availablesize -= requiredsize;
-			fifo->writer_local_wptr %= fifo->end_addr_fifo;
-		} else {
-			/*
-			 * message is split between and of FIFO and beg of FIFO
-			 * copy first part from writer_local_wptr to end of FIFO
-			 */
-			size = fifo->end_addr_fifo-fifo->writer_local_wptr;
-
-			if (size == 1) {
-				/* Add L1 header */
-				*msg = l1_header;
-				msg++;
-				/* UpdateWptr */
-				fifo->writer_local_wptr = 0;
-				fifo->availablesize -= size;
-				/*
-				 * copy second part from beg of FIFO
-				 * with remaining part of msg
-				 */
-				msg =	(u32 *)
-						fifo->fifo_virtual_addr;
-				*msg = l2_header;
-				msg++;
-
-				/* copy the l3 message in 1 memcpy */
-				memcpy((void *)msg, addr, length);
-				/* UpdateWptr */
-				fifo->writer_local_wptr +=
-							requiredsize-size;
-				fifo->availablesize -=
-							(requiredsize-size);
-			} else if (size == 2) {
-				/* Add L1 header and L2 header */
-				*msg = l1_header;
-				msg++;
-				*msg = l2_header;
-				msg++;
-
-				/* UpdateWptr */
-				fifo->writer_local_wptr = 0;
-				fifo->availablesize -= size;
-
-				/*
-				 * copy second part from beg of FIFO
-				 * with remaining part of msg
-				 */
-				msg =	(u32 *)
-						fifo->fifo_virtual_addr;
-				/* copy the l3 message in 1 memcpy */
-				memcpy((void *)msg, addr, length);
-
-				/* UpdateWptr */
-				fifo->writer_local_wptr +=
-							requiredsize-size;
-				fifo->availablesize -=
-							(requiredsize-size);
-			} else {
-				/* Add L1 header and L2 header */
-				*msg = l1_header;
-				msg++;
-				*msg = l2_header;
-				msg++;
-
-				/* copy the l2 message in 1 memcpy */
-				memcpy((void *)msg, addr, (size-2)*4);
-
-
-				/* UpdateWptr */
-				fifo->writer_local_wptr = 0;
-				fifo->availablesize -= size;
-
-				/*
-				 * copy second part from beg of FIFO
-				 * with remaining part of msg
-				 */
-				msg = (u32 *)fifo->fifo_virtual_addr;
-				src = (u8 *)addr+((size - 2) * 4);
-				memcpy((void *)msg, src,
-						(length-((size - 2) * 4)));
-
-				/* UpdateWptr */
-				fifo->writer_local_wptr +=
-							requiredsize-size;
-				fifo->availablesize -=
-							(requiredsize-size);
-			}
+	msg = (u32 *)(fifo->fifo_virtual_addr + wptr);
 
-		}
-	} else {
-		/* writer_local_rptr > writer_local_wptr */
-		msg = (u32 *)
-			(fifo->fifo_virtual_addr+fifo->writer_local_wptr);
+	if ((rptr > wptr) || ((fifo->end_addr_fifo - wptr) >= requiredsize)) {
 		/* Add L1 header and L2 header */
 		*msg = l1_header;
 		msg++;
 		*msg = l2_header;
 		msg++;
+
+		/* copy the l2 message in 1 memcpy */
+		memcpy((void *)msg, addr, length);
+		wptr = (wptr + requiredsize) % fifo->end_addr_fifo;
+	} else {
 		/*
-		 * copy message possbile between writer_local_wptr up
-		 * to writer_local_rptr copy the l3 message in 1 memcpy
+		 * message is split between end of FIFO and beg of FIFO
+		 * copy first part from writer_local_wptr to end of FIFO
 		 */
-		memcpy((void *)msg, addr, length);
+		size = fifo->end_addr_fifo - wptr;
 
-		/* UpdateWptr */
-		fifo->writer_local_wptr += requiredsize;
-		fifo->availablesize -= requiredsize;
+		/* Add L1 header */
+		*msg = l1_header;
+		msg++;
+		if (size == 1)
+			msg = (u32 *)fifo->fifo_virtual_addr;
+		/* Add L2 header */
+		*msg = l2_header;
+		msg++;
+		if (size == 2)
+			msg = (u32 *)fifo->fifo_virtual_addr;
 
+		if (size <= 2) {
+			/* copy the l3 message in 1 memcpy */
+			memcpy((void *)msg, addr, length);
+		} else {
+			memcpy((void *)msg, addr, (size - 2) * 4);
+			/*
+			 * copy second part from beg of FIFO
+			 * with remaining part of msg
+			 */
+			msg = (u32 *)fifo->fifo_virtual_addr;
+			src = (u8 *)addr + ((size - 2) * 4);
+			memcpy((void *)msg, src, (length - ((size - 2) * 4)));
+		}
+		wptr = requiredsize - size;
 	}
-	spin_unlock_bh(&fifo->fifo_update_lock);
+
+	/*
+	 * The message must be in the FIFO before the new write pointer can be
+	 * seen, the modem may be told about it at once from another CPU.
+	 */
+	wmb();
+	ACCESS_ONCE(fifo->writer_local_wptr) = wptr;
+
 	return length;
 }
 
@@ -605,6 +530,7 @@ u8 is_the_only_one_unread_message(struct shrm_dev *shrm,
 {
 	struct fifo_write_params *fifo = NULL;
 	u32 messagesize = 0;
+	u32 rptr, wptr;
 	u8 is_only_one_unread_msg = 0;
 
 	if (channel == COMMON_CHANNEL)
@@ -616,20 +542,17 @@ u8 is_the_only_one_unread_message(struct shrm_dev *shrm,
 	messagesize = ((length + 3) / 4);
 	/* Add size of L1 & L2 header */
 	messagesize += 2;
-	/*
-	 * possibility of race condition with Ac Read notification interrupt.
-	 * need to check ?
-	 */
-	if (fifo->writer_local_wptr > fifo->writer_local_rptr)
+	/* The read notification may move the read pointer, use one value */
+	rptr = ACCESS_ONCE(fifo->writer_local_rptr);
+	wptr = fifo->writer_local_wptr;
+	if (wptr > rptr)
 		is_only_one_unread_msg =
-			((fifo->writer_local_rptr + messagesize) ==
-			fifo->writer_local_wptr) ? 1 : 0;
+			((rptr + messagesize) == wptr) ? 1 : 0;
 	else
 		/* Msg split between end of fifo and starting of Fifo */
 		is_only_one_unread_msg =
-			(((fifo->writer_local_rptr + messagesize) %
-			fifo->end_addr_fifo) == fifo->writer_local_wptr) ?
-									1 : 0;
+			(((rptr + messagesize) %
+			fifo->end_addr_fifo) == wptr) ? 1 : 0;
 
 	return is_only_one_unread_msg;
 }
@@ -643,7 +566,9 @@ void update_ca_common_local_wptr(struct shrm_dev *shrm)
 	struct fifo_read_params *fifo = &cmt_shm_fifo_0;
 
 	fifo->shared_wptr =
-		(*((u32 *)shrm->ca_common_shared_wptr));
+		ACCESS_ONCE(*((u32 *)shrm->ca_common_shared_wptr));
+	/* The messages are read only after the pointer telling they are in */
+	rmb();
 	fifo->reader_local_wptr = fifo->shared_wptr;
 }
 
@@ -656,7 +581,9 @@ void update_ca_audio_local_wptr(struct shrm_dev *shrm)
 	struct fifo_read_params *fifo = &cmt_shm_fifo_1;
 
 	fifo->shared_wptr =
-		(*((u32 *)shrm->ca_audio_shared_wptr));
+		ACCESS_ONCE(*((u32 *)shrm->ca_audio_shared_wptr));
+	/* The messages are read only after the pointer telling they are in */
+	rmb();
 	fifo->reader_local_wptr = fifo->shared_wptr;
 }
 
@@ -669,29 +596,19 @@ void update_ac_common_local_rptr(struct shrm_dev *shrm)
 	 * shared read pointer
 	 */
 	struct fifo_write_params *fifo;
-	u32 free_space = 0;
 
 	fifo = &ape_shm_fifo_0;
 
-	spin_lock_bh(&fifo->fifo_update_lock);
 	fifo->shared_rptr =
-		(*((u32 *)shrm->ac_common_shared_rptr));
-
-	if (fifo->shared_rptr >= fifo->writer_local_rptr)
-		free_space =
-			(fifo->shared_rptr-fifo->writer_local_rptr);
-	else {
-		free_space =
-			(fifo->end_addr_fifo-fifo->writer_local_rptr);
-		free_space += fifo->shared_rptr;
-	}
-
-	/* Chance of race condition of below variables with write_msg */
-	fifo->availablesize += free_space;
-	fifo->writer_local_rptr = fifo->shared_rptr;
+		ACCESS_ONCE(*((u32 *)shrm->ac_common_shared_rptr));
+	/*
+	 * The modem has read the messages up to shared_rptr, the writer may
+	 * fill their space as soon as it sees the new read pointer.
+	 */
+	smp_mb();
+	ACCESS_ONCE(fifo->writer_local_rptr) = fifo->shared_rptr;
 	log_this(82, "rptr", fifo->shared_rptr, NULL, 0);
 	trace_printk("rptr : 0x%04x\n", fifo->shared_rptr);
-	spin_unlock_bh(&fifo->fifo_update_lock);
 }
 
 void update_ac_audio_local_rptr(struct shrm_dev *shrm)
@@ -701,28 +618,19 @@ void update_ac_audio_local_rptr(struct shrm_dev *shrm)
 	 * shared read pointer
 	 */
 	struct fifo_write_params *fifo;
-	u32 free_space = 0;
 
 	fifo = &ape_shm_fifo_1;
-	spin_lock_bh(&fifo->fifo_update_lock);
-	fifo->shared_rptr =
-		(*((u32 *)shrm->ac_audio_shared_rptr));
-
-	if (fifo->shared_rptr >= fifo->writer_local_rptr)
-		free_space =
-			(fifo->shared_rptr-fifo->writer_local_rptr);
-	else {
-		free_space =
-			(fifo->end_addr_fifo-fifo->writer_local_rptr);
-		free_space += fifo->shared_rptr;
-	}
 
-	/* Chance of race condition of below variables with write_msg */
-	fifo->availablesize += free_space;
-	fifo->writer_local_rptr = fifo->shared_rptr;
+	fifo->shared_rptr =
+		ACCESS_ONCE(*((u32 *)shrm->ac_audio_shared_rptr));
+	/*
+	 * The modem has read the messages up to shared_rptr, the writer may
+	 * fill their space as soon as it sees the new read pointer.
+	 */
+	smp_mb();
+	ACCESS_ONCE(fifo->writer_local_rptr) = fifo->shared_rptr;
 	log_this(80, "rptr", fifo->shared_rptr, NULL, 0);
 	trace_printk("rptr : 0x%04x\n", fifo->shared_rptr);
-	spin_unlock_bh(&fifo->fifo_update_lock);
 }
 
 void update_ac_common_shared_wptr(struct shrm_dev *shrm)
@@ -735,15 +643,15 @@ void update_ac_common_shared_wptr(struct shrm_dev *shrm)
 
 	fifo = &ape_shm_fifo_0;
 
-	spin_lock_bh(&fifo->fifo_update_lock);
+	/*
+	 * The writer has the messages in the FIFO before it moves the local
+	 * write pointer, see shm_write_msg_to_fifo().
+	 */
+	fifo->shared_wptr = ACCESS_ONCE(fifo->writer_local_wptr);
 	/* Update shared pointer fifo offset of the IPC zone */
-	(*((u32 *)shrm->ac_common_shared_wptr)) =
-						fifo->writer_local_wptr;
-
-	fifo->shared_wptr = fifo->writer_local_wptr;
+	ACCESS_ONCE(*((u32 *)shrm->ac_common_shared_wptr)) = fifo->shared_wptr;
 	log_this(83, "wptr", fifo->shared_wptr, NULL, 0);
 	trace_printk("wptr : 0x%04x\n", fifo->shared_wptr);
-	spin_unlock_bh(&fifo->fifo_update_lock);
 }
 
 void update_ac_audio_shared_wptr(struct shrm_dev *shrm)
@@ -755,14 +663,16 @@ void update_ac_audio_shared_wptr(struct shrm_dev *shrm)
 	struct fifo_write_params *fifo;
 
 	fifo = &ape_shm_fifo_1;
-	spin_lock_bh(&fifo->fifo_update_lock);
+
+	/*
+	 * The writer has the messages in the FIFO before it moves the local
+	 * write pointer, see shm_write_msg_to_fifo().
+	 */
+	fifo->shared_wptr = ACCESS_ONCE(fifo->writer_local_wptr);
 	/* Update shared pointer fifo offset of the IPC zone */
-	(*((u32 *)shrm->ac_audio_shared_wptr)) =
-						fifo->writer_local_wptr;
-	fifo->shared_wptr = fifo->writer_local_wptr;
+	ACCESS_ONCE(*((u32 *)shrm->ac_audio_shared_wptr)) = fifo->shared_wptr;
 	log_this(81, "wptr", fifo->shared_wptr, NULL, 0);
 	trace_printk("wptr : 0x%04x\n", fifo->shared_wptr);
-	spin_unlock_bh(&fifo->fifo_update_lock);
 }
 
 void update_ca_common_shared_rptr(struct shrm_dev *shrm)
@@ -775,8 +685,10 @@ void update_ca_common_shared_rptr(struct shrm_dev *shrm)
 
 	fifo = &cmt_shm_fifo_0;
 
+	/* The messages are read before the modem may write over them */
+	mb();
 	/* Update shared pointer fifo offset of the IPC zone */
-	(*((u32 *)shrm->ca_common_shared_rptr)) =
+	ACCESS_ONCE(*((u32 *)shrm->ca_common_shared_rptr)) =
 						fifo->reader_local_rptr;
 	fifo->shared_rptr = fifo->reader_local_rptr;
 }
@@ -791,8 +703,10 @@ void update_ca_audio_shared_rptr(struct shrm_dev *shrm)
 
 	fifo = &cmt_shm_fifo_1;
 
+	/* The messages are read before the modem may write over them */
+	mb();
 	/* Update shared pointer fifo offset of the IPC zone */
-	(*((u32 *)shrm->ca_audio_shared_rptr)) =
+	ACCESS_ONCE(*((u32 *)shrm->ca_audio_shared_rptr)) =
 						fifo->reader_local_rptr;
 	fifo->shared_rptr = fifo->reader_local_rptr;
 }
@@ -822,11 +736,9 @@ void get_writer_pointers(u8 channel_type, u32 *writer_local_rptr,
 	else /* channel_type = AUDIO_CHANNEL */
 		fifo = &ape_shm_fifo_1;
 
-	spin_lock_bh(&fifo->fifo_update_lock);
-	*writer_local_rptr = fifo->writer_local_rptr;
-	*writer_local_wptr = fifo->writer_local_wptr;
-	*shared_wptr = fifo->shared_wptr;
-	spin_unlock_bh(&fifo->fifo_update_lock);
+	*writer_local_rptr = ACCESS_ONCE(fifo->writer_local_rptr);
+	*writer_local_wptr = ACCESS_ONCE(fifo->writer_local_wptr);
+	*shared_wptr = ACCESS_ONCE(fifo->shared_wptr);
 }
 
 void set_ca_msg_0_read_notif_send(u8 val)
@@ -11,6 +11,9 @@
 #include <linux/delay.h>
 #include <linux/netlink.h>
 #include <linux/kthread.h>
+#include <linux/interrupt.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/modem/shrm/shrm.h>
 #include <linux/modem/shrm/shrm_driver.h>
 #include <linux/modem/shrm/shrm_private.h>
@@ -91,6 +94,66 @@ static DEFINE_SPINLOCK(boot_lock);
 static DEFINE_SPINLOCK(mod_stuck_lock);
 static DEFINE_SPINLOCK(start_timer_lock);
 
+/*
+ * With a poll budget, the message pending interrupt of a channel is masked
+ * from the interrupt until its tasklet has drained the FIFO. The tasklet
+ * polls the FIFO write pointer for messages the modem writes meanwhile, up
+ * to budget times, and sends the read notification once all are read.
+ */
+static unsigned int rx_poll_budget = 32;
+module_param(rx_poll_budget, uint, 0644);
+MODULE_PARM_DESC(rx_poll_budget,
+		"FIFO polls per interrupt and channel, 0 to not poll");
+
+struct shrm_rx_stats {
+	unsigned long irqs;
+	unsigned long msgs;
+	unsigned long polled;
+	unsigned long read_notifs;
+};
+
+static struct shrm_rx_stats common_rx_stats;
+static struct shrm_rx_stats audio_rx_stats;
+
+/* Bit 0 set while the interrupt of the channel is masked for polling */
+static unsigned long ca_0_polling;
+static unsigned long ca_1_polling;
+
+/*
+ * The AC is let to sleep when the access timer expires after the last read
+ * notification. The timer is at least ac_awake_min_ms; when messages come
+ * closer together than ac_awake_max_ms on average, it is held for twice the
+ * average gap between messages so that a burst of small writes keeps the
+ * modem awake instead of waking it for every message.
+ */
+static unsigned int ac_awake_min_ms = 25;
+module_param(ac_awake_min_ms, uint, 0644);
+MODULE_PARM_DESC(ac_awake_min_ms, "Shortest AC keep awake time in ms");
+
+static unsigned int ac_awake_max_ms = 100;
+module_param(ac_awake_max_ms, uint, 0644);
+MODULE_PARM_DESC(ac_awake_max_ms,
+		"Longest AC keep awake time in ms, 0 to not adapt it");
+
+struct shrm_ac_stats {
+	unsigned long msgs;
+	unsigned long wakes;
+	unsigned long sleeps;
+};
+
+static struct shrm_ac_stats ac_stats;
+static DEFINE_SPINLOCK(ac_awake_lock);
+/* Average gap between sent messages in us, scaled by 8 */
+static u32 ac_tx_gap_avg;
+static ktime_t ac_last_tx;
+/* The AC is released, under ac_state_mutex */
+static bool ac_released = true;
+
+#ifdef CONFIG_DEBUG_FS
+static struct dentry *rx_stats_dentry;
+static struct dentry *ac_stats_dentry;
+#endif
+
 enum shrm_nl {
 	SHRM_NL_MOD_RESET = 1,
 	SHRM_NL_MOD_QUERY_STATE,
@@ -127,12 +190,61 @@ void shm_mod_reset_req_work(struct kthread_work *work)
 	prcmu_modem_reset();
 }
 
+static void ac_note_tx(void)
+{
+	unsigned long flags;
+	ktime_t now = ktime_get();
+	u32 gap;
+
+	spin_lock_irqsave(&ac_awake_lock, flags);
+	ac_stats.msgs++;
+	gap = min_t(s64, ktime_us_delta(now, ac_last_tx), USEC_PER_SEC);
+	ac_tx_gap_avg += gap - (ac_tx_gap_avg >> 3);
+	ac_last_tx = now;
+	spin_unlock_irqrestore(&ac_awake_lock, flags);
+}
+
+static unsigned int ac_awake_ms(void)
+{
+	unsigned int gap_ms = ACCESS_ONCE(ac_tx_gap_avg) / (8 * USEC_PER_MSEC);
+	unsigned int max_ms = ac_awake_max_ms;
+	unsigned int awake_ms = ac_awake_min_ms;
+
+	if (gap_ms < max_ms)
+		awake_ms = clamp(2 * gap_ms, awake_ms, max_ms);
+
+	return awake_ms;
+}
+
+static ktime_t ac_awake_time(void)
+{
+	unsigned int awake_ms = ac_awake_ms();
+
+	return ktime_set(awake_ms / MSEC_PER_SEC,
+			 (awake_ms % MSEC_PER_SEC) * NSEC_PER_MSEC);
+}
+
+/* Called with ac_state_mutex held */
+static void ac_request(struct shrm_dev *shrm)
+{
+	if (ac_released) {
+		ac_released = false;
+		ac_stats.wakes++;
+	}
+	modem_request(shrm->modem);
+}
+
 static void shm_ac_sleep_req_work(struct kthread_work *work)
 {
 	if (boot_state == BOOT_DONE) {
 		mutex_lock(&ac_state_mutex);
-		if (atomic_read(&ac_sleep_disable_count) == 0)
+		if (atomic_read(&ac_sleep_disable_count) == 0) {
 			modem_release(shm_dev->modem);
+			if (!ac_released) {
+				ac_released = true;
+				ac_stats.sleeps++;
+			}
+		}
 		mutex_unlock(&ac_state_mutex);
 	}
 }
@@ -140,7 +252,7 @@ static void shm_ac_sleep_req_work(struct kthread_work *work)
 static void shm_ac_wake_req_work(struct kthread_work *work)
 {
 	mutex_lock(&ac_state_mutex);
-	modem_request(shm_dev->modem);
+	ac_request(shm_dev);
 	mutex_unlock(&ac_state_mutex);
 }
 
@@ -330,9 +442,8 @@ static int check_modem_in_reset(void)
 #endif
 }
 
-void shm_ca_msgpending_0_tasklet(unsigned long tasklet_data)
+static void ca_msgpending_0(struct shrm_dev *shrm)
 {
-	struct shrm_dev *shrm = (struct shrm_dev *)tasklet_data;
 	u32 reader_local_rptr;
 	u32 reader_local_wptr;
 	u32 shared_rptr;
@@ -396,9 +507,19 @@ void shm_ca_msgpending_0_tasklet(unsigned long tasklet_data)
 	dev_dbg(shrm->dev, "%s OUT\n", __func__);
 }
 
-void shm_ca_msgpending_1_tasklet(unsigned long tasklet_data)
+void shm_ca_msgpending_0_tasklet(unsigned long tasklet_data)
 {
 	struct shrm_dev *shrm = (struct shrm_dev *)tasklet_data;
+
+	ca_msgpending_0(shrm);
+
+	/* Messages written after the FIFO was found empty raise it again */
+	if (test_and_clear_bit(0, &ca_0_polling))
+		enable_irq(shrm->ca_msg_pending_notif_0_irq);
+}
+
+static void ca_msgpending_1(struct shrm_dev *shrm)
+{
 	u32 reader_local_rptr;
 	u32 reader_local_wptr;
 	u32 shared_rptr;
@@ -447,6 +568,16 @@ void shm_ca_msgpending_1_tasklet(unsigned long tasklet_data)
 	dev_dbg(shrm->dev, "%s OUT\n", __func__);
 }
 
+void shm_ca_msgpending_1_tasklet(unsigned long tasklet_data)
+{
+	struct shrm_dev *shrm = (struct shrm_dev *)tasklet_data;
+
+	ca_msgpending_1(shrm);
+
+	if (test_and_clear_bit(0, &ca_1_polling))
+		enable_irq(shrm->ca_msg_pending_notif_1_irq);
+}
+
 void shm_ac_read_notif_0_tasklet(unsigned long tasklet_data)
 {
 	struct shrm_dev *shrm = (struct shrm_dev *)tasklet_data;
@@ -504,8 +635,7 @@ void shm_ac_read_notif_0_tasklet(unsigned long tasklet_data)
 		dev_err(shrm->dev, "Invalid boot state\n");
 	}
 	/* start timer here */
-	hrtimer_start(&timer, ktime_set(0, 25*NSEC_PER_MSEC),
-			HRTIMER_MODE_REL);
+	hrtimer_start(&timer, ac_awake_time(), HRTIMER_MODE_REL);
 	atomic_dec(&ac_sleep_disable_count);
 
 	dev_dbg(shrm->dev, "%s OUT\n", __func__);
@@ -542,8 +672,7 @@ void shm_ac_read_notif_1_tasklet(unsigned long tasklet_data)
 		shrm_audio_tx_state = SHRM_IDLE;
 	}
 	/* start timer here */
-	hrtimer_start(&timer, ktime_set(0, 25*NSEC_PER_MSEC),
-			HRTIMER_MODE_REL);
+	hrtimer_start(&timer, ac_awake_time(), HRTIMER_MODE_REL);
 	atomic_dec(&ac_sleep_disable_count);
 	atomic_dec(&ac_msg_pend_1);
 
@@ -612,7 +741,7 @@ void shm_ca_wake_req_work(struct kthread_work *work)
 		shm_fifo_init(shrm);
 	}
 	mutex_lock(&ac_state_mutex);
-	modem_request(shrm->modem);
+	ac_request(shrm);
 	mutex_unlock(&ac_state_mutex);
 
 	local_irq_save(flags);
@@ -806,7 +935,7 @@ static void send_ac_msg_pend_notify_0_work(struct kthread_work *work)
 
 	mutex_lock(&ac_state_mutex);
 	atomic_inc(&ac_sleep_disable_count);
-	modem_request(shrm->modem);
+	ac_request(shrm);
 	mutex_unlock(&ac_state_mutex);
 
 	spin_lock_irqsave(&start_timer_lock, flags);
@@ -856,7 +985,7 @@ static void send_ac_msg_pend_notify_1_work(struct kthread_work *work)
 		atomic_inc(&ac_sleep_disable_count);
 		atomic_inc(&ac_msg_pend_1);
 	}
-	modem_request(shrm->modem);
+	ac_request(shrm);
 	mutex_unlock(&ac_state_mutex);
 
 	spin_lock_irqsave(&start_timer_lock, flags);
@@ -925,6 +1054,68 @@ void shm_nl_receive(struct sk_buff *skb)
 	};
 }
 
+#ifdef CONFIG_DEBUG_FS
+static void rx_stats_show_one(struct seq_file *s, const char *name,
+			      const struct shrm_rx_stats *st)
+{
+	unsigned long per_irq = st->irqs ? st->msgs * 100 / st->irqs : 0;
+
+	seq_printf(s, "%-8s %10lu %10lu %10lu %10lu %7lu.%02lu\n", name,
+		   st->irqs, st->msgs, st->polled, st->read_notifs,
+		   per_irq / 100, per_irq % 100);
+}
+
+static int rx_stats_show(struct seq_file *s, void *unused)
+{
+	seq_printf(s, "%-8s %10s %10s %10s %10s %10s\n", "channel", "irqs",
+		   "msgs", "polled", "read_notif", "msgs/irq");
+	rx_stats_show_one(s, "common", &common_rx_stats);
+	rx_stats_show_one(s, "audio", &audio_rx_stats);
+
+	return 0;
+}
+
+static int rx_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rx_stats_show, inode->i_private);
+}
+
+static const struct file_operations rx_stats_fops = {
+	.open = rx_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int ac_stats_show(struct seq_file *s, void *unused)
+{
+	unsigned long msgs = ac_stats.msgs;
+	unsigned long per_msg = msgs ? ac_stats.wakes * 100 / msgs : 0;
+
+	seq_printf(s, "msgs:          %lu\n", msgs);
+	seq_printf(s, "wakes:         %lu\n", ac_stats.wakes);
+	seq_printf(s, "sleeps:        %lu\n", ac_stats.sleeps);
+	seq_printf(s, "wakes/msg:     %lu.%02lu\n", per_msg / 100,
+		   per_msg % 100);
+	seq_printf(s, "avg gap (us):  %u\n", ACCESS_ONCE(ac_tx_gap_avg) >> 3);
+	seq_printf(s, "awake (ms):    %u\n", ac_awake_ms());
+
+	return 0;
+}
+
+static int ac_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ac_stats_show, inode->i_private);
+}
+
+static const struct file_operations ac_stats_fops = {
+	.open = ac_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+#endif
+
 int shrm_protocol_init(struct shrm_dev *shrm,
 			received_msg_handler common_rx_handler,
 			received_msg_handler audio_rx_handler)
@@ -1062,6 +1253,12 @@ int shrm_protocol_init(struct shrm_dev *shrm,
 
 	netlink_set_nonroot(NETLINK_SHRM, NL_NONROOT_RECV);
 #endif
+#ifdef CONFIG_DEBUG_FS
+	rx_stats_dentry = debugfs_create_file("shrm_rx_stats", S_IRUGO, NULL,
+					      NULL, &rx_stats_fops);
+	ac_stats_dentry = debugfs_create_file("shrm_ac_wake_stats", S_IRUGO,
+					      NULL, NULL, &ac_stats_fops);
+#endif
 #ifdef CONFIG_U8500_KERNEL_CLIENT
 	err = u8500_kernel_client_init(shrm);
 #endif
@@ -1099,6 +1296,10 @@ free_kw1:
 
 void shrm_protocol_deinit(struct shrm_dev *shrm)
 {
+#ifdef CONFIG_DEBUG_FS
+	debugfs_remove(ac_stats_dentry);
+	debugfs_remove(rx_stats_dentry);
+#endif
 #ifdef CONFIG_U8500_KERNEL_CLIENT
 	u8500_kernel_client_exit();
 #endif
@@ -1271,6 +1472,9 @@ irqreturn_t ca_msg_pending_notif_0_irq_handler(int irq, void *ctrlr)
 	}
 
 	tasklet_schedule(&shm_ca_0_tasklet);
+	common_rx_stats.irqs++;
+	if (rx_poll_budget && !test_and_set_bit(0, &ca_0_polling))
+		disable_irq_nosync(irq);
 
 	local_irq_save(flags);
 	preempt_disable();
@@ -1316,6 +1520,9 @@ irqreturn_t ca_msg_pending_notif_1_irq_handler(int irq, void *ctrlr)
 	}
 
 	tasklet_schedule(&shm_ca_1_tasklet);
+	audio_rx_stats.irqs++;
+	if (rx_poll_budget && !test_and_set_bit(0, &ca_1_polling))
+		disable_irq_nosync(irq);
 
 	local_irq_save(flags);
 	preempt_disable();
@@ -1428,6 +1635,7 @@ int shm_write_msg(struct shrm_dev *shrm, u8 l2_header,
 		}
 		return ret;
 	}
+	ac_note_tx();
 	/*
 	 * notify only if new msg copied is the only unread one
 	 * otherwise it means that reading process is ongoing
@@ -1488,6 +1696,7 @@ void ca_msg_read_notification_0(struct shrm_dev *shrm)
 		local_irq_restore(flags);
 		set_ca_msg_0_read_notif_send(1);
 		shrm_common_rx_state = SHRM_PTR_BUSY;
+		common_rx_stats.read_notifs++;
 	}
 
 	dev_dbg(shrm->dev, "%s OUT\n", __func__);
@@ -1530,6 +1739,7 @@ void ca_msg_read_notification_1(struct shrm_dev *shrm)
 		local_irq_restore(flags);
 		set_ca_msg_1_read_notif_send(1);
 		shrm_audio_rx_state = SHRM_PTR_BUSY;
+		audio_rx_stats.read_notifs++;
 	}
 	dev_dbg(shrm->dev, "%s OUT\n", __func__);
 }
@@ -1548,6 +1758,8 @@ void ca_msg_read_notification_1(struct shrm_dev *shrm)
  */
 void receive_messages_common(struct shrm_dev *shrm)
 {
+	unsigned int budget = rx_poll_budget;
+	bool poll = budget != 0;
 	u8 l2_header;
 	u32 len;
 
@@ -1565,10 +1777,23 @@ void receive_messages_common(struct shrm_dev *shrm)
 	}
 	(*rx_common_handler)(l2_header, &recieve_common_msg, len,
 					shrm);
-	/* SendReadNotification */
-	ca_msg_read_notification_0(shrm);
+	common_rx_stats.msgs++;
+	/* SendReadNotification, once the FIFO is drained when polling */
+	if (!poll)
+		ca_msg_read_notification_0(shrm);
+
+	for (;;) {
+		if (!read_remaining_messages_common()) {
+			if (!budget)
+				break;
+			/* Poll for messages written meanwhile */
+			budget--;
+			update_ca_common_local_wptr(shrm);
+			if (!read_remaining_messages_common())
+				break;
+			common_rx_stats.polled++;
+		}
 
-	while (read_remaining_messages_common()) {
 		if (check_modem_in_reset()) {
 			dev_err(shrm->dev, "%s:Modem state reset or unknown.\n",
 					__func__);
@@ -1581,7 +1806,11 @@ void receive_messages_common(struct shrm_dev *shrm)
 		(*rx_common_handler)(l2_header,
 					&recieve_common_msg, len,
 					shrm);
+		common_rx_stats.msgs++;
 	}
+
+	if (poll)
+		ca_msg_read_notification_0(shrm);
 }
 
 /**
@@ -1596,6 +1825,8 @@ void receive_messages_common(struct shrm_dev *shrm)
  */
 void receive_messages_audio(struct shrm_dev *shrm)
 {
+	unsigned int budget = rx_poll_budget;
+	bool poll = budget != 0;
 	u8 l2_header;
 	u32 len;
 
@@ -1614,10 +1845,23 @@ void receive_messages_audio(struct shrm_dev *shrm)
 	}
 	(*rx_audio_handler)(l2_header, &recieve_audio_msg,
 					len, shrm);
+	audio_rx_stats.msgs++;
+
+	/* SendReadNotification, once the FIFO is drained when polling */
+	if (!poll)
+		ca_msg_read_notification_1(shrm);
+	for (;;) {
+		if (!read_remaining_messages_audio()) {
+			if (!budget)
+				break;
+			/* Poll for messages written meanwhile */
+			budget--;
+			update_ca_audio_local_wptr(shrm);
+			if (!read_remaining_messages_audio())
+				break;
+			audio_rx_stats.polled++;
+		}
 
-	/* SendReadNotification */
-	ca_msg_read_notification_1(shrm);
-	while (read_remaining_messages_audio())	{
 		if (check_modem_in_reset()) {
 			dev_err(shrm->dev, "%s:Modem state reset or unknown.\n",
 					__func__);
@@ -1630,7 +1874,11 @@ void receive_messages_audio(struct shrm_dev *shrm)
 		(*rx_audio_handler)(l2_header,
 					&recieve_audio_msg, len,
 					shrm);
+		audio_rx_stats.msgs++;
 	}
+
+	if (poll)
+		ca_msg_read_notification_1(shrm);
 }
 
 u8 get_boot_state()
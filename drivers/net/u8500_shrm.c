@@ -22,6 +22,56 @@
 #include <net/phonet/pep.h>
 
 
+/* Fills in the metadata of a received skb and passes it up */
+static void shrm_net_rx_skb(struct net_device *dev, struct sk_buff *skb,
+		u32 msgsize)
+{
+	skb_reset_mac_header(skb);
+	__skb_pull(skb, dev->hard_header_len);
+	/*Write metadata, and then pass to the receive level*/
+	skb->dev = dev;/*kmalloc(sizeof(struct net_device), GFP_ATOMIC);*/
+	skb->protocol = htons(ETH_P_PHONET);
+	skb->priority = 0;
+	skb->ip_summed = CHECKSUM_UNNECESSARY; /* don't check it */
+	if (likely(netif_rx_ni(skb) == NET_RX_SUCCESS)) {
+		dev->stats.rx_packets++;
+		dev->stats.rx_bytes += msgsize;
+	} else
+		dev->stats.rx_dropped++;
+}
+
+/**
+ * shrm_net_receive_msg() - receive a message straight from the rx buffer
+ * @dev:	pointer to the network device structure
+ * @data:	message read from the FIFO
+ * @msgsize:	message length
+ *
+ * Builds the skb from the message as it was read from the FIFO, for
+ * messages that do not have to wait in the ISI queue.
+ */
+int shrm_net_receive_msg(struct net_device *dev, const void *data,
+		u32 msgsize)
+{
+	struct sk_buff *skb;
+	struct shrm_net_iface_priv *net_iface_priv =
+		(struct shrm_net_iface_priv *)netdev_priv(dev);
+	struct shrm_dev *shrm = net_iface_priv->shrm_device;
+
+	skb = dev_alloc_skb(msgsize);
+	if (!skb) {
+		if (printk_ratelimit())
+			dev_notice(shrm->dev,
+			"isa rx: low on mem - packet dropped\n");
+		dev->stats.rx_dropped++;
+		return -ENOMEM;
+	}
+
+	memcpy(skb_put(skb, msgsize), data, msgsize);
+	shrm_net_rx_skb(dev, skb, msgsize);
+
+	return msgsize;
+}
+
 /**
  * shrm_net_receive() - receive data and copy to user space buffer
  * @dev:	pointer to the network device structure
@@ -89,18 +139,7 @@ int shrm_net_receive(struct net_device *dev)
 	remove_msg_from_queue(q);
 	spin_unlock_bh(&q->update_lock);
 
-	skb_reset_mac_header(skb);
-	__skb_pull(skb, dev->hard_header_len);
-	/*Write metadata, and then pass to the receive level*/
-	skb->dev = dev;/*kmalloc(sizeof(struct net_device), GFP_ATOMIC);*/
-	skb->protocol = htons(ETH_P_PHONET);
-	skb->priority = 0;
-	skb->ip_summed = CHECKSUM_UNNECESSARY; /* don't check it */
-	if (likely(netif_rx_ni(skb) == NET_RX_SUCCESS)) {
-		dev->stats.rx_packets++;
-		dev->stats.rx_bytes += msgsize;
-	} else
-		dev->stats.rx_dropped++;
+	shrm_net_rx_skb(dev, skb, msgsize);
 
 	return msgsize;
 out:
@@ -130,6 +130,9 @@ static int bcmsdh_sdmmc_probe(struct sdio_func *func,
 
 		gInstance->func[func->num] = func;
 
+		/* Suspended before and resumed after the MMC host, in parallel */
+		device_enable_async_suspend(&func->dev);
+
 		if (func->num == 2) {
 	#ifdef WL_CFG80211
 			wl_cfg80211_set_parent_dev(&func->dev);
@@ -1749,6 +1749,7 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 	wl_event_msg_t event;
 	int tout_rx = 0;
 	int tout_ctrl = 0;
+	struct sk_buff_head rxq;
 
 #ifdef DHD_RX_DUMP
 #ifdef DHD_RX_FULL_DUMP
@@ -1760,6 +1761,8 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 
 	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
 
+	__skb_queue_head_init(&rxq);
+
 	for (i = 0; pktbuf && i < numpkt; i++, pktbuf = pnext) {
 #ifdef WLBTAMP
 		struct ether_header *eh;
@@ -1940,25 +1943,31 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 		dhdp->dstats.rx_bytes += skb->len;
 		dhdp->rx_packets++; /* Local count */
 
-		if (in_interrupt()) {
+		__skb_queue_tail(&rxq, skb);
+	}
+
+	/* Deliver the whole chain in one go. From the DPC thread the
+	 * packets are handed straight to the stack with bottom halves
+	 * disabled, instead of queueing each one to the backlog and
+	 * running the softirq once per packet as netif_rx_ni() does.
+	 */
+	if (in_interrupt()) {
+		while ((skb = __skb_dequeue(&rxq)) != NULL)
 			netif_rx(skb);
-		} else {
-			/* If the receive is not processed inside an ISR,
-			 * the softirqd must be woken explicitly to service
-			 * the NET_RX_SOFTIRQ.  In 2.6 kernels, this is handled
-			 * by netif_rx_ni(), but in earlier kernels, we need
-			 * to do it manually.
-			 */
+	} else {
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 0)
-			netif_rx_ni(skb);
+		local_bh_disable();
+		while ((skb = __skb_dequeue(&rxq)) != NULL)
+			netif_receive_skb(skb);
+		local_bh_enable();
 #else
-			ulong flags;
+		ulong flags;
+		while ((skb = __skb_dequeue(&rxq)) != NULL)
 			netif_rx(skb);
-			local_irq_save(flags);
-			RAISE_RX_SOFTIRQ();
-			local_irq_restore(flags);
+		local_irq_save(flags);
+		RAISE_RX_SOFTIRQ();
+		local_irq_restore(flags);
 #endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 0) */
-		}
 	}
 
 	DHD_OS_WAKE_LOCK_RX_TIMEOUT_ENABLE(dhdp, tout_rx);
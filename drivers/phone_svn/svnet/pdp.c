@@ -30,15 +30,71 @@
 
 extern int vnet_start_xmit(struct sk_buff *skb, struct net_device *ndev);
 
+#define PDP_NAPI_WEIGHT		64
+
+/*
+ * Received packets are queued to the device and passed to GRO from its
+ * NAPI poll, so the segments of a TCP download are merged before the
+ * stack (and RPS) see them, instead of going one by one to netif_rx_ni().
+ */
+int pdp_rx(struct net_device *ndev, struct sk_buff *skb)
+{
+	struct pdp_priv *priv = netdev_priv(ndev);
+
+	if (unlikely(!netif_running(ndev) ||
+		     skb_queue_len(&priv->rxq) >= netdev_max_backlog)) {
+		ndev->stats.rx_dropped++;
+		kfree_skb(skb);
+		return NET_RX_DROP;
+	}
+
+	skb_queue_tail(&priv->rxq, skb);
+
+	/* Run the poll on the way out if called from process context */
+	local_bh_disable();
+	napi_schedule(&priv->napi);
+	local_bh_enable();
+
+	return NET_RX_SUCCESS;
+}
+
+static int pdp_poll(struct napi_struct *napi, int budget)
+{
+	struct pdp_priv *priv = container_of(napi, struct pdp_priv, napi);
+	struct sk_buff *skb;
+	int work = 0;
+
+	while (work < budget && (skb = skb_dequeue(&priv->rxq)) != NULL) {
+		napi_gro_receive(napi, skb);
+		work++;
+	}
+
+	if (work < budget) {
+		napi_complete(napi);
+		/* A packet queued after the dequeue and before the complete */
+		if (!skb_queue_empty(&priv->rxq))
+			napi_schedule(napi);
+	}
+
+	return work;
+}
+
 static int vnet_open(struct net_device *ndev)
 {
+	struct pdp_priv *priv = netdev_priv(ndev);
+
+	napi_enable(&priv->napi);
 	netif_start_queue(ndev);
 	return 0;
 }
 
 static int vnet_stop(struct net_device *ndev)
 {
+	struct pdp_priv *priv = netdev_priv(ndev);
+
 	netif_stop_queue(ndev);
+	napi_disable(&priv->napi);
+	skb_queue_purge(&priv->rxq);
 	return 0;
 }
 
@@ -88,6 +144,8 @@ struct net_device* create_pdp(int channel, struct net_device *parent)
 	priv = netdev_priv(ndev);
 	priv->channel = channel;
 	priv->parent = parent;
+	skb_queue_head_init(&priv->rxq);
+	netif_napi_add(ndev, &priv->napi, pdp_poll, PDP_NAPI_WEIGHT);
 
 #ifdef CONFIG_DEBUG_PRINTK
 	printk("[create_rmnet] channel: %d\n", channel);
@@ -110,6 +168,7 @@ void destroy_pdp(struct net_device **ndev)
 		return;
 
 	unregister_netdev(*ndev);
+	skb_queue_purge(&((struct pdp_priv *)netdev_priv(*ndev))->rxq);
 	free_netdev(*ndev);
 	*ndev = NULL;
 }
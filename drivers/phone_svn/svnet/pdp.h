@@ -26,9 +26,12 @@
 struct pdp_priv {
 	int channel;
 	struct net_device *parent;
+	struct napi_struct napi;
+	struct sk_buff_head rxq;
 };
 
 extern struct net_device* create_pdp(int channel, struct net_device *parent);
 extern void destroy_pdp(struct net_device **);
+extern int pdp_rx(struct net_device *ndev, struct sk_buff *skb);
 
 #endif /* __PACKET_DATA_PROTOCOL_H__ */
@@ -1630,7 +1630,7 @@ static int _read_pdp(struct ringbuf *rb, int len,
 
 	_dbg("%s: pdp packet %p len %d\n", __func__, skb, skb->len);
 
-	r = netif_rx_ni(skb);
+	r = pdp_rx(ndev, skb);
 	if (r != NET_RX_SUCCESS)
 		dev_err(&ndev->dev, "pdp rx error: %d\n", r);
 
@@ -2089,7 +2089,7 @@ static int _read_pdp_from_shrm(u8 *buf, int len, int res)
 
 	skb_reset_mac_header(skb);
 
-	r = netif_rx_ni(skb);
+	r = pdp_rx(ndev, skb);
 	if (r != NET_RX_SUCCESS)
 		dev_err(&ndev->dev, "pdp rx error: %d\n", r);
 
@@ -2722,6 +2722,9 @@ static int __devinit ab8500_fg_probe(struct platform_device *pdev)
 	/* Work delayed Queue to run the state machine */
 	INIT_DELAYED_WORK_DEFERRABLE(&di->fg_periodic_work,
 		ab8500_fg_periodic_work);
+	/* The periodic run can be late, it only tracks the capacity */
+	set_timer_slack_class(&di->fg_periodic_work.timer,
+		TIMER_SLACK_BACKGROUND);
 
 	/* Work to check low battery condition */
 	INIT_DELAYED_WORK_DEFERRABLE(&di->fg_low_bat_work,
@@ -97,6 +97,9 @@
 
 #define SEC_TO_SAMPLE(S)		(S * 4)
 
+/* The number of CC samples per conversion is an 8 bit register */
+#define CC_NCONV_ACCU_MAX_SAMPLES	255
+
 #define NBR_AVG_SAMPLES			20
 
 #define LOW_BAT_CHECK_INTERVAL		(5 * HZ)
@@ -370,6 +373,9 @@ struct ab8500_gpadc {
  * @cc_lock:		Mutex for locking the CC
  * @lowbat_wake_lock	Wakelock for low battery
  * @cc_wake_lock	Wakelock for Coulomb Counter
+ * @wakeups_cc:		CC conversion interrupts since @wakeups_since
+ * @wakeups_poll:	Runs of the periodic work since @wakeups_since
+ * @wakeups_since:	Time in jiffies the wakeup counts were cleared
  */
 struct ab8500_fg {
 	struct device *dev;
@@ -436,6 +442,9 @@ struct ab8500_fg {
 	struct wake_lock lowbat_wake_lock;
 	struct wake_lock lowbat_poweroff_wake_lock;
 	struct wake_lock cc_wake_lock;
+	unsigned int wakeups_cc;
+	unsigned int wakeups_poll;
+	unsigned long wakeups_since;
 };
 static LIST_HEAD(ab8500_fg_list);
 
@@ -852,6 +861,25 @@ cc_err:
 	return ret;
 }
 
+/**
+ * ab8500_fg_set_accu_time() - set the CC accumulation time
+ * @di:		pointer to the ab8500_fg structure
+ * @sec:	accumulation time in seconds
+ *
+ * The CC interrupts at the end of every accumulation. The CC is only
+ * restarted when the time changes.
+ */
+static void ab8500_fg_set_accu_time(struct ab8500_fg *di, int sec)
+{
+	int samples = min(SEC_TO_SAMPLE(sec), CC_NCONV_ACCU_MAX_SAMPLES);
+
+	if (di->fg_samples == samples)
+		return;
+
+	di->fg_samples = samples;
+	ab8500_fg_coulomb_counter(di, true);
+}
+
 /**
  * ab8500_fg_inst_curr_start() - start battery instantaneous current
  * @di:         pointer to the ab8500_fg structure
@@ -2057,6 +2085,15 @@ static void ab8500_fg_algorithm_discharging(struct ab8500_fg *di)
 				di->high_curr_cnt = 0;
 			}
 
+			/*
+			 * The capacity comes from the voltage while the
+			 * current is low, the CC only has to tell when it
+			 * rises. Accumulate longer to wake up less often.
+			 */
+			if (di->bat->fg_params->accu_low_curr)
+				ab8500_fg_set_accu_time(di,
+					di->bat->fg_params->accu_low_curr);
+
 			if (di->recovery_needed) {
 				ab8500_fg_discharge_state_to(di,
 					AB8500_FG_DISCHARGE_RECOVERY);
@@ -2086,6 +2123,8 @@ static void ab8500_fg_algorithm_discharging(struct ab8500_fg *di)
 			if (!di->high_curr_mode) {
 				di->high_curr_mode = true;
 				di->high_curr_cnt = 0;
+				ab8500_fg_set_accu_time(di,
+					di->bat->fg_params->accu_high_curr);
 			}
 
 			di->high_curr_cnt +=
@@ -2459,6 +2498,8 @@ static void ab8500_fg_periodic_work(struct work_struct *work)
 	struct ab8500_fg *di = container_of(work, struct ab8500_fg,
 		fg_periodic_work.work);
 
+	di->wakeups_poll++;
+
 	if (di->init_capacity) {
 		/* A dummy read that will return 0 */
 		di->inst_curr = ab8500_fg_inst_curr(di);
@@ -2590,6 +2631,7 @@ static irqreturn_t ab8500_fg_cc_convend_handler(int irq, void *_di)
 {
 	struct ab8500_fg *di = _di;
 
+	di->wakeups_cc++;
 	wake_lock_timeout(&di->cc_wake_lock, HZ*2);
 	queue_work(di->fg_wq, &di->fg_acc_cur_work);
 
@@ -3508,6 +3550,36 @@ static ssize_t abb_fg_average_current_show(struct kobject *kobj, struct kobj_att
 
 static struct kobj_attribute abb_fg_average_current_interface = __ATTR(average_current, 0444, abb_fg_average_current_show, NULL);
 
+/* Wakeups of the FG per hour, writing clears the counts */
+static ssize_t abb_fg_wakeups_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	unsigned long secs;
+	unsigned int total;
+
+	if (!di_)
+		return 0;
+
+	secs = (jiffies - di_->wakeups_since) / HZ;
+	total = di_->wakeups_cc + di_->wakeups_poll;
+
+	return sprintf(buf, "%lu/h (%u cc, %u poll in %lu s)\n",
+		secs ? total * 3600UL / secs : 0,
+		di_->wakeups_cc, di_->wakeups_poll, secs);
+}
+
+static ssize_t abb_fg_wakeups_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	if (di_) {
+		di_->wakeups_cc = 0;
+		di_->wakeups_poll = 0;
+		di_->wakeups_since = jiffies;
+	}
+
+	return count;
+}
+
+static struct kobj_attribute abb_fg_wakeups_interface = __ATTR(fg_wakeups, 0644, abb_fg_wakeups_show, abb_fg_wakeups_store);
+
 static ssize_t abb_fg_instant_current_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
 {
 	if (di_)
@@ -3528,6 +3600,7 @@ static struct attribute *abb_fg_attrs[] = {
 	&abb_fg_pwroff_threshold_interface.attr, 
 	&abb_fg_instant_current_interface.attr,
 	&abb_fg_average_current_interface.attr,
+	&abb_fg_wakeups_interface.attr,
 	NULL,
 };
 
@@ -3690,6 +3763,9 @@ static int __devinit ab8500_fg_probe(struct platform_device *pdev)
 	/* Work delayed Queue to run the state machine */
 	INIT_DELAYED_WORK_DEFERRABLE(&di->fg_periodic_work,
 		ab8500_fg_periodic_work);
+	/* The periodic run can be late, it only tracks the capacity */
+	set_timer_slack_class(&di->fg_periodic_work.timer,
+		TIMER_SLACK_BACKGROUND);
 
 	/* Work to check low battery condition */
 	INIT_DELAYED_WORK_DEFERRABLE(&di->fg_low_bat_work,
@@ -3745,6 +3821,8 @@ static int __devinit ab8500_fg_probe(struct platform_device *pdev)
 	list_add(&di->node, &ab8500_fg_list);
 
 
+	di->wakeups_since = jiffies;
+
 	/* Calibrate the fg first time */
 	di->flags.calibrate = true;
 	di->calib_state = AB8500_FG_CALIB_INIT;
@@ -10,6 +10,7 @@
 #include <linux/miscdevice.h>
 #include <linux/fs.h>
 #include <linux/ioctl.h>
+#include <linux/sensors_core.h>
 
 #include <mach/board-sec-ux500.h>
 #include <linux/earlysuspend.h>
@@ -32,6 +33,7 @@
 #define ALPS_POLL_INTERVAL			100	/* msecs */
 #define ALPS_INPUT_FUZZ				0	/* event threshold */
 #define ALPS_INPUT_FLAT				0
+#define ALPS_BATCH_SIZE				512	/* events */
 
 extern int hscd_get_magnetic_field_data(int *xyz);
 extern int hscd_activate(int flgatm, int flg, int dtime);
@@ -44,6 +46,7 @@ struct alps_data {
 	struct input_polled_dev *alps_idev;
 	struct mutex alps_lock;
 	struct miscdevice alps_device;
+	struct sensors_batch batch;
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	struct early_suspend alps_early_suspend;
 #endif
@@ -149,47 +152,45 @@ static const struct file_operations alps_fops = {
 	.unlocked_ioctl = alps_ioctl,
 };
 
-static void accsns_poll(struct input_dev *idev)
+/* Samples are batched when a batch latency is set, the SYN is always sent */
+static void alps_report_xyz(struct sensors_batch *batch, unsigned int code_x,
+		unsigned int code_y, unsigned int code_z, int *xyz, int sensor)
+{
+	sensors_batch_event(batch, EV_ABS, code_x, xyz[0]);
+	sensors_batch_event(batch, EV_ABS, code_y, xyz[1]);
+	sensors_batch_event(batch, EV_ABS, code_z, xyz[2]);
+	sensors_batch_event(batch, EV_SYN, SYN_REPORT, sensor);
+}
+
+static void accsns_poll(struct alps_data *data)
 {
 	if (disable) return;
 	if	(system_rev >= CODINA_TMO_R0_1)	{
 
 		int xyz[3];
 		
-		if (bma222e_get_acceleration_data(xyz) == 0) {
-			input_report_abs(idev, EVENT_TYPE_ACCEL_X, xyz[0]);
-			input_report_abs(idev, EVENT_TYPE_ACCEL_Y, xyz[1]);
-			input_report_abs(idev, EVENT_TYPE_ACCEL_Z, xyz[2]);
-			idev->sync = 0;
-			input_event(idev, EV_SYN, SYN_REPORT, 1);
-		}
+		if (bma222e_get_acceleration_data(xyz) == 0)
+			alps_report_xyz(&data->batch, EVENT_TYPE_ACCEL_X,
+				EVENT_TYPE_ACCEL_Y, EVENT_TYPE_ACCEL_Z, xyz, 1);
 
 	}	else	{
 
 		int xyz[3];
 		
-		if (accsns_get_acceleration_data(xyz) == 0) {
-			input_report_abs(idev, EVENT_TYPE_ACCEL_X, xyz[0]);
-			input_report_abs(idev, EVENT_TYPE_ACCEL_Y, xyz[1]);
-			input_report_abs(idev, EVENT_TYPE_ACCEL_Z, xyz[2]);
-			idev->sync = 0;
-			input_event(idev, EV_SYN, SYN_REPORT, 1);
-		}
+		if (accsns_get_acceleration_data(xyz) == 0)
+			alps_report_xyz(&data->batch, EVENT_TYPE_ACCEL_X,
+				EVENT_TYPE_ACCEL_Y, EVENT_TYPE_ACCEL_Z, xyz, 1);
 	}
 }
 
-static void hscd_poll(struct input_dev *idev)
+static void hscd_poll(struct alps_data *data)
 {
 	int xyz[3];
 	if (disable) return;
 
-	if (hscd_get_magnetic_field_data(xyz) == 0) {
-		input_report_abs(idev, EVENT_TYPE_MAGV_X, xyz[0]);
-		input_report_abs(idev, EVENT_TYPE_MAGV_Y, xyz[1]);
-		input_report_abs(idev, EVENT_TYPE_MAGV_Z, xyz[2]);
-		idev->sync = 0;
-		input_event(idev, EV_SYN, SYN_REPORT, 2);
-	}
+	if (hscd_get_magnetic_field_data(xyz) == 0)
+		alps_report_xyz(&data->batch, EVENT_TYPE_MAGV_X,
+			EVENT_TYPE_MAGV_Y, EVENT_TYPE_MAGV_Z, xyz, 2);
 }
 
 static void alps_poll(struct input_polled_dev *dev)
@@ -202,13 +203,68 @@ static void alps_poll(struct input_polled_dev *dev)
 		data->alps_idev->poll_interval = data->delay;
 
 	if (data->flgM)
-			hscd_poll(data->alps_idev->input);
+			hscd_poll(data);
 	if (data->flgA)
-			accsns_poll(data->alps_idev->input);
+			accsns_poll(data);
 	mutex_unlock(&data->alps_lock);
 	}
 }
 
+static struct alps_data *alps_dev_to_data(struct device *dev)
+{
+	struct input_polled_dev *poll_dev = input_get_drvdata(to_input_dev(dev));
+
+	return poll_dev->private;
+}
+
+static ssize_t alps_batch_latency_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct alps_data *data = alps_dev_to_data(dev);
+
+	return sprintf(buf, "%u\n", data->batch.max_latency);
+}
+
+/* Max time in ms a sample may wait before it is reported, 0 to not batch */
+static ssize_t alps_batch_latency_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct alps_data *data = alps_dev_to_data(dev);
+	unsigned long latency;
+
+	if (strict_strtoul(buf, 10, &latency))
+		return -EINVAL;
+
+	sensors_batch_set_latency(&data->batch, latency);
+
+	return count;
+}
+
+static ssize_t alps_batch_flush_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct alps_data *data = alps_dev_to_data(dev);
+
+	sensors_batch_flush(&data->batch);
+
+	return count;
+}
+
+static DEVICE_ATTR(batch_latency, S_IRUGO | S_IWUSR | S_IWGRP,
+		alps_batch_latency_show, alps_batch_latency_store);
+static DEVICE_ATTR(batch_flush, S_IWUSR | S_IWGRP,
+		NULL, alps_batch_flush_store);
+
+static struct attribute *alps_batch_attributes[] = {
+	&dev_attr_batch_latency.attr,
+	&dev_attr_batch_flush.attr,
+	NULL
+};
+
+static const struct attribute_group alps_batch_attr_group = {
+	.attrs = alps_batch_attributes,
+};
+
 static int alps_probe(struct platform_device *dev)
 {
 	int ret;
@@ -265,10 +321,18 @@ static int alps_probe(struct platform_device *dev)
 	input_set_abs_params(idev, EVENT_TYPE_MAGV_Z,
 			-4096, 4096, ALPS_INPUT_FUZZ, ALPS_INPUT_FLAT);
 
-	ret = input_register_polled_device(data->alps_idev);
+	ret = sensors_batch_init(&data->batch, idev, ALPS_BATCH_SIZE);
 	if (ret)
 		goto out_idev;
 
+	ret = input_register_polled_device(data->alps_idev);
+	if (ret)
+		goto out_batch;
+
+	ret = sysfs_create_group(&idev->dev.kobj, &alps_batch_attr_group);
+	if (ret)
+		goto exit_sysfs_create_group_failed;
+
 	data->alps_device.minor = MISC_DYNAMIC_MINOR;
 	data->alps_device.name = "alps_io";
 	data->alps_device.fops = &alps_fops;
@@ -291,7 +355,11 @@ static int alps_probe(struct platform_device *dev)
 	return 0;
 
 exit_misc_device_register_failed:
+	sysfs_remove_group(&idev->dev.kobj, &alps_batch_attr_group);
+exit_sysfs_create_group_failed:
 	input_unregister_polled_device(data->alps_idev);
+out_batch:
+	sensors_batch_destroy(&data->batch);
 out_idev:
 	input_free_polled_device(data->alps_idev);
 out_device:
@@ -309,7 +377,10 @@ static int alps_remove(struct platform_device *dev)
 	struct alps_data *data = platform_get_drvdata(dev);
 
 	misc_deregister(&data->alps_device);
+	sysfs_remove_group(&data->alps_idev->input->dev.kobj,
+			&alps_batch_attr_group);
 	input_unregister_polled_device(data->alps_idev);
+	sensors_batch_destroy(&data->batch);
 	input_free_polled_device(data->alps_idev);
 	platform_device_unregister(data->pdev);
 	mutex_destroy(&data->alps_lock);
@@ -325,6 +396,7 @@ static int alps_suspend(struct device *dev)
 	struct alps_data *data = platform_get_drvdata(pdev);
 
 	data->suspend_flag = ON;
+	sensors_batch_flush(&data->batch);
 
 	return 0;
 }
@@ -346,6 +418,8 @@ static void alps_early_suspend(struct early_suspend *handler)
 	data = container_of(handler, struct alps_data, alps_early_suspend);
 
 	data->suspend_flag = ON;
+	/* Polling stops, report what was taken before */
+	sensors_batch_flush(&data->batch);
 }
 
 static void alps_early_resume(struct early_suspend *handler)
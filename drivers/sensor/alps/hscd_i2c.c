@@ -587,6 +587,9 @@ static int hscd_probe(struct i2c_client *client,
 	atomic_set(&flgEna, 0);
 	atomic_set(&delay, 100);
 
+	/* Resumed after its I2C adapter, in parallel with the others */
+	device_enable_async_suspend(&client->dev);
+
 	pr_info("%s: success.\n", __func__);
 
 	return 0;
@@ -671,7 +674,8 @@ static void __exit hscd_exit(void)
 	i2c_del_driver(&hscd_driver);
 }
 
-module_init(hscd_init);
+/* Used by alps-input only once it is opened, probes with msleep()s */
+device_initcall_async(hscd_init);
 module_exit(hscd_exit);
 
 MODULE_DESCRIPTION("Alps hscd Device");
@@ -909,6 +909,7 @@ static int taos_opt_probe(struct i2c_client *client,
 	taos->alsout = pdata->alsout;
 	taos->client = client;
 	i2c_set_clientdata(client, taos);
+	device_enable_async_suspend(&client->dev);
 	taos->threshold_high = PRX_THRSH_HI_PARAM;
 	taos->threshold_low = PRX_THRSH_LO_PARAM;
 	taos->initial_offset = taos_get_initial_offset(taos);
@@ -1241,7 +1242,8 @@ static int taos_set_enable(const char *val, struct kernel_param *kp)
 }
 module_param_call(enabled, taos_set_enable, param_get_int, &enabled, 0644);
 
-module_init(taos_opt_init);
+/* Nothing waits for the sensor at boot, it probes with msleep()s */
+device_initcall_async(taos_opt_init);
 module_exit(taos_opt_exit);
 MODULE_AUTHOR("SAMSUNG");
 MODULE_DESCRIPTION("Optical Sensor driver for TMD2672");
@@ -10,7 +10,7 @@
 #include <linux/device.h>
 #include <linux/fs.h>
 #include <linux/err.h>
-//#include <linux/sensors_core.h>
+#include <linux/sensors_core.h>
 
 struct class *sensors_class;
 static atomic_t sensor_count;
@@ -71,6 +71,138 @@ void sensors_unregister(struct device *dev)
 	// TODO : Unregister device
 }
 
+/*
+ * Every sample is reported, even when none of its values changed since the
+ * previous one and the input core would otherwise drop the SYN_REPORT.
+ */
+static void sensors_batch_report(struct input_dev *input, unsigned int type,
+				 unsigned int code, int value)
+{
+	if (type == EV_SYN)
+		input->sync = false;
+	input_event(input, type, code, value);
+}
+
+static void sensors_batch_flush_work(struct work_struct *work)
+{
+	struct sensors_batch *batch = container_of(work, struct sensors_batch,
+						   flush_work.work);
+
+	sensors_batch_flush(batch);
+}
+
+/**
+ * sensors_batch_init() - Sets up the batching of the events of an input device
+ *
+ * @batch: Batch to set up
+ * @input: Input device the events are reported to
+ * @size: Number of events the FIFO holds, rounded up to a power of two
+ *
+ * Batching is off until a max latency is set with sensors_batch_set_latency().
+ */
+int sensors_batch_init(struct sensors_batch *batch, struct input_dev *input,
+		       unsigned int size)
+{
+	int ret;
+
+	ret = kfifo_alloc(&batch->fifo, size, GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	batch->input = input;
+	spin_lock_init(&batch->lock);
+	INIT_DELAYED_WORK(&batch->flush_work, sensors_batch_flush_work);
+	batch->max_latency = 0;
+
+	return 0;
+}
+
+void sensors_batch_destroy(struct sensors_batch *batch)
+{
+	cancel_delayed_work_sync(&batch->flush_work);
+	kfifo_free(&batch->fifo);
+}
+
+/**
+ * sensors_batch_event() - Reports or queues an event of a sample
+ *
+ * @batch: Batch of the input device
+ * @type, @code, @value: The event, as for input_event()
+ *
+ * A sample ends with its EV_SYN event. The FIFO is flushed when it has no
+ * room left for another sample. May be called from any context.
+ */
+void sensors_batch_event(struct sensors_batch *batch, unsigned int type,
+			 unsigned int code, int value)
+{
+	struct sensors_batch_event ev;
+	unsigned long flags;
+	bool full = false;
+
+	if (!batch->max_latency) {
+		sensors_batch_report(batch->input, type, code, value);
+		return;
+	}
+
+	ev.time = ktime_get();
+	ev.type = type;
+	ev.code = code;
+	ev.value = value;
+
+	spin_lock_irqsave(&batch->lock, flags);
+	if (kfifo_is_empty(&batch->fifo))
+		schedule_delayed_work(&batch->flush_work,
+				      msecs_to_jiffies(batch->max_latency));
+	if (kfifo_put(&batch->fifo, &ev)) {
+		full = type == EV_SYN && kfifo_avail(&batch->fifo) <
+					 SENSORS_BATCH_SAMPLE_EVENTS;
+	} else {
+		/* A sample longer than SENSORS_BATCH_SAMPLE_EVENTS */
+		while (kfifo_get(&batch->fifo, &ev)) {
+			input_set_timestamp(batch->input, ev.time);
+			sensors_batch_report(batch->input, ev.type, ev.code,
+					     ev.value);
+		}
+		sensors_batch_report(batch->input, type, code, value);
+	}
+	spin_unlock_irqrestore(&batch->lock, flags);
+
+	if (full)
+		sensors_batch_flush(batch);
+}
+
+/**
+ * sensors_batch_flush() - Reports all queued events
+ *
+ * @batch: Batch of the input device
+ */
+void sensors_batch_flush(struct sensors_batch *batch)
+{
+	struct sensors_batch_event ev;
+	unsigned long flags;
+
+	spin_lock_irqsave(&batch->lock, flags);
+	cancel_delayed_work(&batch->flush_work);
+	while (kfifo_get(&batch->fifo, &ev)) {
+		input_set_timestamp(batch->input, ev.time);
+		sensors_batch_report(batch->input, ev.type, ev.code, ev.value);
+	}
+	spin_unlock_irqrestore(&batch->lock, flags);
+}
+
+/**
+ * sensors_batch_set_latency() - Sets how long events may be queued
+ *
+ * @batch: Batch of the input device
+ * @max_latency: Max latency in ms, 0 reports every event as it comes
+ */
+void sensors_batch_set_latency(struct sensors_batch *batch,
+			       unsigned int max_latency)
+{
+	batch->max_latency = max_latency;
+	sensors_batch_flush(batch);
+}
+
 static int __init sensors_class_init(void)
 {
 #ifdef CONFIG_DEBUG_PRINTK
@@ -96,6 +228,11 @@ static void __exit sensors_class_exit(void)
 
 EXPORT_SYMBOL_GPL(sensors_register);
 EXPORT_SYMBOL_GPL(sensors_unregister);
+EXPORT_SYMBOL_GPL(sensors_batch_init);
+EXPORT_SYMBOL_GPL(sensors_batch_destroy);
+EXPORT_SYMBOL_GPL(sensors_batch_event);
+EXPORT_SYMBOL_GPL(sensors_batch_flush);
+EXPORT_SYMBOL_GPL(sensors_batch_set_latency);
 
 /* exported for the APM Power driver, APM emulation */
 EXPORT_SYMBOL_GPL(sensors_class);
@@ -356,6 +356,8 @@ struct vendor_data {
  * @sgt_rx: scattertable for the RX transfer
  * @sgt_tx: scattertable for the TX transfer
  * @dummypage: a dummy page used for driving data on the bus with DMA
+ * @dma_last: last transfer of the message covered by the running DMA job
+ * @dma_len: bytes of the running DMA job
  */
 struct pl022 {
 	struct amba_device		*adev;
@@ -388,6 +390,8 @@ struct pl022 {
 	struct sg_table			sgt_tx;
 	char				*dummypage;
 	bool				dma_running;
+	struct spi_transfer		*dma_last;
+	unsigned int			dma_len;
 #endif
 };
 
@@ -815,8 +819,9 @@ static void dma_callback(void *data)
 
 	unmap_free_dma_scatter(pl022);
 
-	/* Update total bytes transferred */
-	msg->actual_length += pl022->cur_transfer->len;
+	/* Update total bytes transferred, the job may span several */
+	msg->actual_length += pl022->dma_len;
+	pl022->cur_transfer = pl022->dma_last;
 	if (pl022->cur_transfer->cs_change)
 		pl022->cur_chip->
 			cs_control(SSP_CHIP_DESELECT);
@@ -826,19 +831,30 @@ static void dma_callback(void *data)
 	tasklet_schedule(&pl022->pump_transfers);
 }
 
-static void setup_dma_scatter(struct pl022 *pl022,
+/* Number of scatterlist entries setup_dma_scatter() needs for a buffer */
+static unsigned int dma_scatter_pages(const void *buffer, unsigned int length)
+{
+	if (buffer)
+		return DIV_ROUND_UP(offset_in_page(buffer) + length, PAGE_SIZE);
+	return DIV_ROUND_UP(length, PAGE_SIZE);
+}
+
+/*
+ * Fill in the entries from @sg on for one transfer, returning the entry
+ * following the last one used.
+ */
+static struct scatterlist *setup_dma_scatter(struct pl022 *pl022,
 			      void *buffer,
 			      unsigned int length,
-			      struct sg_table *sgtab)
+			      struct scatterlist *sg)
 {
-	struct scatterlist *sg;
 	int bytesleft = length;
 	void *bufp = buffer;
 	int mapbytes;
-	int i;
+	unsigned int i, pages = dma_scatter_pages(buffer, length);
 
 	if (buffer) {
-		for_each_sg(sgtab->sgl, sg, sgtab->nents, i) {
+		for (i = 0; i < pages; i++, sg = sg_next(sg)) {
 			/*
 			 * If there are less bytes left than what fits
 			 * in the current page (plus page alignment offset)
@@ -859,7 +875,7 @@ static void setup_dma_scatter(struct pl022 *pl022,
 		}
 	} else {
 		/* Map the dummy buffer on every page */
-		for_each_sg(sgtab->sgl, sg, sgtab->nents, i) {
+		for (i = 0; i < pages; i++, sg = sg_next(sg)) {
 			if (bytesleft < PAGE_SIZE)
 				mapbytes = bytesleft;
 			else
@@ -874,6 +890,7 @@ static void setup_dma_scatter(struct pl022 *pl022,
 		}
 	}
 	BUG_ON(bytesleft);
+	return sg;
 }
 
 /**
@@ -892,7 +909,11 @@ static int configure_dma(struct pl022 *pl022)
 		.direction = DMA_MEM_TO_DEV,
 		.device_fc = false,
 	};
-	unsigned int pages;
+	struct spi_transfer *first = pl022->cur_transfer;
+	struct spi_transfer *last = first;
+	struct spi_transfer *next;
+	struct scatterlist *rx_sg, *tx_sg;
+	unsigned int rx_pages, tx_pages;
 	int ret;
 	int rx_sglen, tx_sglen;
 	struct dma_chan *rxchan = pl022->dma_rx_channel;
@@ -994,23 +1015,53 @@ static int configure_dma(struct pl022 *pl022)
 	dmaengine_slave_config(rxchan, &rx_conf);
 	dmaengine_slave_config(txchan, &tx_conf);
 
+	/*
+	 * The transfers following this one without a chip select change or
+	 * a delay in between, and reading and writing the same way, go in the
+	 * same job: one descriptor per direction and a single interrupt.
+	 */
+	rx_pages = dma_scatter_pages(first->rx_buf, first->len);
+	tx_pages = dma_scatter_pages(first->tx_buf, first->len);
+	pl022->dma_len = first->len;
+	while (!last->cs_change && !last->delay_usecs &&
+	       last->transfer_list.next != &pl022->cur_msg->transfers) {
+		next = list_entry(last->transfer_list.next,
+				  struct spi_transfer, transfer_list);
+		if (!next->rx_buf != !first->rx_buf ||
+		    !next->tx_buf != !first->tx_buf ||
+		    next->len % pl022->cur_chip->n_bytes)
+			break;
+		rx_pages += dma_scatter_pages(next->rx_buf, next->len);
+		tx_pages += dma_scatter_pages(next->tx_buf, next->len);
+		pl022->dma_len += next->len;
+		last = next;
+	}
+	pl022->dma_last = last;
+
 	/* Create sglists for the transfers */
-	pages = DIV_ROUND_UP(pl022->cur_transfer->len, PAGE_SIZE);
-	dev_dbg(&pl022->adev->dev, "using %d pages for transfer\n", pages);
+	dev_dbg(&pl022->adev->dev, "using %d/%d pages for %u bytes\n",
+		rx_pages, tx_pages, pl022->dma_len);
 
-	ret = sg_alloc_table(&pl022->sgt_rx, pages, GFP_ATOMIC);
+	ret = sg_alloc_table(&pl022->sgt_rx, rx_pages, GFP_ATOMIC);
 	if (ret)
 		goto err_alloc_rx_sg;
 
-	ret = sg_alloc_table(&pl022->sgt_tx, pages, GFP_ATOMIC);
+	ret = sg_alloc_table(&pl022->sgt_tx, tx_pages, GFP_ATOMIC);
 	if (ret)
 		goto err_alloc_tx_sg;
 
 	/* Fill in the scatterlists for the RX+TX buffers */
-	setup_dma_scatter(pl022, pl022->rx,
-			  pl022->cur_transfer->len, &pl022->sgt_rx);
-	setup_dma_scatter(pl022, pl022->tx,
-			  pl022->cur_transfer->len, &pl022->sgt_tx);
+	rx_sg = pl022->sgt_rx.sgl;
+	tx_sg = pl022->sgt_tx.sgl;
+	for (next = first; ; next = list_entry(next->transfer_list.next,
+				struct spi_transfer, transfer_list)) {
+		rx_sg = setup_dma_scatter(pl022, next->rx_buf, next->len,
+					  rx_sg);
+		tx_sg = setup_dma_scatter(pl022, (void *)next->tx_buf,
+					  next->len, tx_sg);
+		if (next == last)
+			break;
+	}
 
 	/* Map DMA buffers */
 	rx_sglen = dma_map_sg(rxchan->device->dev, pl022->sgt_rx.sgl,
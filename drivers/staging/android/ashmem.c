@@ -28,6 +28,8 @@
 #include <linux/bitops.h>
 #include <linux/mutex.h>
 #include <linux/shmem_fs.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include "ashmem.h"
 
 #define ASHMEM_NAME_PREFIX "dev/ashmem/"
@@ -60,6 +62,7 @@ struct ashmem_range {
 	size_t pgstart;			/* starting page, inclusive */
 	size_t pgend;			/* ending page, inclusive */
 	unsigned int purged;		/* ASHMEM_NOT or ASHMEM_WAS_PURGED */
+	unsigned long unpinned_time;	/* jiffies when unpinned */
 };
 
 /* LRU list of unpinned pages, protected by ashmem_mutex */
@@ -139,6 +142,7 @@ static int range_alloc(struct ashmem_area *asma,
 	range->pgstart = start;
 	range->pgend = end;
 	range->purged = purged;
+	range->unpinned_time = jiffies;
 
 	list_add_tail(&range->unpinned, &prev_range->unpinned);
 
@@ -336,6 +340,91 @@ out:
 	return ret;
 }
 
+/*
+ * range_split_purged - splits the top 'pages' pages off a range as a new
+ * purged range, returns the first page of the split off range or, if there
+ * is no memory for it, the first page of the range
+ *
+ * Caller must hold ashmem_mutex.
+ */
+static size_t range_split_purged(struct ashmem_range *range, size_t pages)
+{
+	struct ashmem_range *purged;
+	size_t pgstart = range->pgend + 1 - pages;
+
+	/* We are reclaiming, do not wait for memory */
+	purged = kmem_cache_zalloc(ashmem_range_cachep,
+				   GFP_NOWAIT | __GFP_NOWARN);
+	if (unlikely(!purged))
+		return range->pgstart;
+
+	purged->asma = range->asma;
+	purged->pgstart = pgstart;
+	purged->pgend = range->pgend;
+	purged->purged = ASHMEM_WAS_PURGED;
+	purged->unpinned_time = range->unpinned_time;
+
+	/* the unpinned list is sorted from the last page down */
+	list_add_tail(&purged->unpinned, &range->unpinned);
+	range_shrink(range, range->pgstart, pgstart - 1);
+
+	return pgstart;
+}
+
+/*
+ * ashmem_purge_range - purges up to 'nr' pages of a range on the LRU list,
+ * returns the number of pages purged
+ *
+ * A range larger than 'nr' is split so that the shrinker frees about what
+ * it was asked for.
+ *
+ * Caller must hold ashmem_mutex.
+ */
+static size_t ashmem_purge_range(struct ashmem_range *range, unsigned long nr)
+{
+	struct inode *inode = range->asma->file->f_dentry->d_inode;
+	size_t pgstart = range->pgstart;
+	size_t pgend = range->pgend;
+
+	if (range_size(range) > nr)
+		pgstart = range_split_purged(range, nr);
+
+	vmtruncate_range(inode, pgstart * PAGE_SIZE,
+			 (pgend + 1) * PAGE_SIZE - 1);
+
+	if (pgstart == range->pgstart) {
+		lru_del(range);
+		range->purged = ASHMEM_WAS_PURGED;
+	}
+
+	return pgend - pgstart + 1;
+}
+
+/*
+ * ashmem_purge_area - purges 'first' and then the other ranges on the LRU
+ * list of its area, up to 'nr' pages, returns the number of pages purged
+ *
+ * Caller must hold ashmem_mutex.
+ */
+static unsigned long ashmem_purge_area(struct ashmem_range *first,
+				       unsigned long nr)
+{
+	struct ashmem_range *range, *next;
+	unsigned long freed;
+
+	freed = ashmem_purge_range(first, nr);
+
+	list_for_each_entry_safe(range, next, &first->asma->unpinned_list,
+				 unpinned) {
+		if (freed >= nr)
+			break;
+		if (range_on_lru(range))
+			freed += ashmem_purge_range(range, nr - freed);
+	}
+
+	return freed;
+}
+
 /*
  * ashmem_shrink - our cache shrinker, called from mm/vmscan.c :: shrink_slab
  *
@@ -347,13 +436,16 @@ out:
  * Return value is the number of objects (pages) remaining, or -1 if we cannot
  * proceed without risk of deadlock (due to gfp_mask).
  *
- * We approximate LRU via least-recently-unpinned, jettisoning unpinned partial
- * chunks of ashmem regions LRU-wise one-at-a-time until we hit 'nr_to_scan'
- * pages freed.
+ * We approximate LRU via least-recently-unpinned: the area of the least
+ * recently unpinned range has that range and then its other unpinned ranges
+ * purged in a row, which keeps its backing file hot, until we hit
+ * 'nr_to_scan' pages freed.
  */
 static int ashmem_shrink(struct shrinker *s, struct shrink_control *sc)
 {
-	struct ashmem_range *range, *next;
+	struct ashmem_range *range;
+	unsigned long nr = sc->nr_to_scan;
+	unsigned long freed;
 
 	/* We might recurse into filesystem code, so bail out if necessary */
 	if (sc->nr_to_scan && !(sc->gfp_mask & __GFP_FS))
@@ -364,18 +456,11 @@ static int ashmem_shrink(struct shrinker *s, struct shrink_control *sc)
 	if (!mutex_trylock(&ashmem_mutex))
 		return -1;
 
-	list_for_each_entry_safe(range, next, &ashmem_lru_list, lru) {
-		struct inode *inode = range->asma->file->f_dentry->d_inode;
-		loff_t start = range->pgstart * PAGE_SIZE;
-		loff_t end = (range->pgend + 1) * PAGE_SIZE - 1;
-
-		vmtruncate_range(inode, start, end);
-		range->purged = ASHMEM_WAS_PURGED;
-		lru_del(range);
-
-		sc->nr_to_scan -= range_size(range);
-		if (sc->nr_to_scan <= 0)
-			break;
+	while (nr && !list_empty(&ashmem_lru_list)) {
+		range = list_first_entry(&ashmem_lru_list, struct ashmem_range,
+					 lru);
+		freed = ashmem_purge_area(range, nr);
+		nr -= min(freed, nr);
 	}
 	mutex_unlock(&ashmem_mutex);
 
@@ -697,6 +782,63 @@ static struct miscdevice ashmem_misc = {
 	.fops = &ashmem_fops,
 };
 
+#ifdef CONFIG_DEBUG_FS
+/*
+ * The ranges the shrinker may purge, least recently unpinned first: pages,
+ * milliseconds since unpinned, first and last page, and area name
+ */
+static int ashmem_lru_show(struct seq_file *s, void *unused)
+{
+	struct ashmem_range *range;
+
+	mutex_lock(&ashmem_mutex);
+	list_for_each_entry(range, &ashmem_lru_list, lru)
+		seq_printf(s, "%zu %u %zu %zu %s\n", range_size(range),
+			   jiffies_to_msecs(jiffies - range->unpinned_time),
+			   range->pgstart, range->pgend,
+			   range->asma->name + ASHMEM_NAME_PREFIX_LEN);
+	mutex_unlock(&ashmem_mutex);
+
+	return 0;
+}
+
+static int ashmem_lru_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ashmem_lru_show, inode->i_private);
+}
+
+static const struct file_operations ashmem_lru_fops = {
+	.open = ashmem_lru_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static struct dentry *ashmem_debugfs;
+
+static void ashmem_debugfs_init(void)
+{
+	ashmem_debugfs = debugfs_create_dir("ashmem", NULL);
+	if (IS_ERR_OR_NULL(ashmem_debugfs))
+		return;
+	debugfs_create_file("lru", S_IRUGO, ashmem_debugfs, NULL,
+			    &ashmem_lru_fops);
+}
+
+static void ashmem_debugfs_exit(void)
+{
+	debugfs_remove_recursive(ashmem_debugfs);
+}
+#else
+static inline void ashmem_debugfs_init(void)
+{
+}
+
+static inline void ashmem_debugfs_exit(void)
+{
+}
+#endif
+
 static int __init ashmem_init(void)
 {
 	int ret;
@@ -724,6 +866,7 @@ static int __init ashmem_init(void)
 	}
 
 	register_shrinker(&ashmem_shrinker);
+	ashmem_debugfs_init();
 
 	printk(KERN_INFO "ashmem: initialized\n");
 
@@ -734,6 +877,7 @@ static void __exit ashmem_exit(void)
 {
 	int ret;
 
+	ashmem_debugfs_exit();
 	unregister_shrinker(&ashmem_shrinker);
 
 	ret = misc_deregister(&ashmem_misc);
@@ -22,6 +22,7 @@
 #include <linux/file.h>
 #include <linux/freezer.h>
 #include <linux/fs.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
 #include <linux/miscdevice.h>
 #include <linux/mm.h>
@@ -113,6 +114,9 @@ module_param_named(proc_no_lock, binder_debug_no_lock, bool, S_IWUSR | S_IRUGO);
 static char *binder_devices_param = CONFIG_ANDROID_BINDER_DEVICES;
 module_param_named(devices, binder_devices_param, charp, S_IRUGO);
 
+static bool binder_inherit_rt = true;
+module_param_named(inherit_rt, binder_inherit_rt, bool, S_IWUSR | S_IRUGO);
+
 static DECLARE_WAIT_QUEUE_HEAD(binder_user_error_wait);
 static int binder_stop_on_user_error;
 
@@ -306,6 +310,21 @@ struct binder_buffer {
 	uint8_t data[0];
 };
 
+/*
+ * Recently freed buffers of a proc, so that small sync transactions can
+ * skip the best fit search of the free buffer tree.
+ */
+#define BINDER_BUF_CACHE_SIZE	4
+#define BINDER_BUF_CACHE_SLACK	PAGE_SIZE
+
+struct binder_buf_cache_entry {
+	struct binder_buffer *buffer;
+	size_t size;
+};
+
+/* Round trips of sync transactions, bucket i counts those below 2^i us */
+#define BINDER_LATENCY_BUCKETS	20
+
 enum binder_deferred_state {
 	BINDER_DEFERRED_PUT_FILES    = 0x01,
 	BINDER_DEFERRED_FLUSH        = 0x02,
@@ -333,6 +352,11 @@ struct binder_proc {
 	struct rb_root allocated_buffers;
 	size_t free_async_space;
 
+	struct binder_buf_cache_entry buf_cache[BINDER_BUF_CACHE_SIZE];
+	unsigned int buf_cache_next;
+	unsigned int buf_cache_hits;
+	unsigned int buf_cache_misses;
+
 	struct page **pages;
 	size_t buffer_size;
 	uint32_t buffer_free;
@@ -347,6 +371,7 @@ struct binder_proc {
 	long default_priority;
 	struct dentry *debugfs_entry;
 	struct binder_context *context;
+	unsigned int latency[BINDER_LATENCY_BUCKETS];
 };
 
 enum {
@@ -371,6 +396,9 @@ struct binder_thread {
 		/* we are also waiting on */
 	wait_queue_head_t wait;
 	struct binder_stats stats;
+	int rt_inherited;
+	int saved_policy;
+	int saved_rt_priority;
 };
 
 struct binder_transaction {
@@ -389,7 +417,12 @@ struct binder_transaction {
 	unsigned int	flags;
 	long	priority;
 	long	saved_priority;
+	int	policy;
+	int	rt_priority;
+	int	saved_policy;
+	int	saved_rt_priority;
 	uid_t	sender_euid;
+	ktime_t	start_time;
 };
 
 static void
@@ -562,6 +595,23 @@ static void binder_set_nice(long nice)
 	binder_user_error("%d RLIMIT_NICE not set\n", current->pid);
 }
 
+static inline int binder_rt_policy(int policy)
+{
+	return policy == SCHED_FIFO || policy == SCHED_RR;
+}
+
+static void binder_set_scheduler(int policy, int rt_priority)
+{
+	struct sched_param param = { .sched_priority = rt_priority };
+
+	if (current->policy == policy && current->rt_priority == rt_priority)
+		return;
+	if (sched_setscheduler_nocheck(current, policy, &param))
+		binder_debug(BINDER_DEBUG_PRIORITY_CAP,
+			     "%d: scheduler %d/%d not set\n",
+			     current->pid, policy, rt_priority);
+}
+
 static size_t binder_buffer_size(struct binder_proc *proc,
 				 struct binder_buffer *buffer)
 {
@@ -605,6 +655,44 @@ static void binder_insert_free_buffer(struct binder_proc *proc,
 	rb_insert_color(&new_buffer->rb_node, &proc->free_buffers);
 }
 
+static void binder_buf_cache_add(struct binder_proc *proc,
+				 struct binder_buffer *buffer, size_t size)
+{
+	struct binder_buf_cache_entry *e;
+
+	e = &proc->buf_cache[proc->buf_cache_next];
+	proc->buf_cache_next = (proc->buf_cache_next + 1) % BINDER_BUF_CACHE_SIZE;
+	e->buffer = buffer;
+	e->size = size;
+}
+
+static struct binder_buf_cache_entry *
+binder_buf_cache_lookup(struct binder_proc *proc, size_t size)
+{
+	struct binder_buf_cache_entry *e;
+	int i;
+
+	for (i = 0; i < BINDER_BUF_CACHE_SIZE; i++) {
+		e = &proc->buf_cache[i];
+		if (e->buffer && e->size >= size &&
+		    e->size - size <= BINDER_BUF_CACHE_SLACK)
+			return e;
+	}
+	return NULL;
+}
+
+/* A free buffer that leaves the free tree must not be handed out again */
+static void binder_erase_free_buffer(struct binder_proc *proc,
+				     struct binder_buffer *buffer)
+{
+	int i;
+
+	rb_erase(&buffer->rb_node, &proc->free_buffers);
+	for (i = 0; i < BINDER_BUF_CACHE_SIZE; i++)
+		if (proc->buf_cache[i].buffer == buffer)
+			proc->buf_cache[i].buffer = NULL;
+}
+
 static void binder_insert_allocated_buffer(struct binder_proc *proc,
 					   struct binder_buffer *new_buffer)
 {
@@ -765,11 +853,13 @@ static struct binder_buffer *binder_alloc_buf(struct binder_proc *proc,
 {
 	struct rb_node *n = proc->free_buffers.rb_node;
 	struct binder_buffer *buffer;
+	struct binder_buf_cache_entry *cached = NULL;
 	size_t buffer_size;
 	struct rb_node *best_fit = NULL;
 	void *has_page_addr;
 	void *end_page_addr;
 	size_t size, data_offsets_size;
+	int exact_fit = 0;
 
 	if (proc->vma == NULL) {
 		pr_err("%d: binder_alloc_buf, no vma\n",
@@ -799,6 +889,19 @@ static struct binder_buffer *binder_alloc_buf(struct binder_proc *proc,
 		return NULL;
 	}
 
+	if (!is_async)
+		cached = binder_buf_cache_lookup(proc, size);
+	if (cached) {
+		buffer = cached->buffer;
+		buffer_size = cached->size;
+		BUG_ON(!buffer->free);
+		best_fit = &buffer->rb_node;
+		exact_fit = buffer_size == size;
+		proc->buf_cache_hits++;
+		goto found;
+	}
+	proc->buf_cache_misses++;
+
 	while (n) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 		BUG_ON(!buffer->free);
@@ -811,6 +914,7 @@ static struct binder_buffer *binder_alloc_buf(struct binder_proc *proc,
 			n = n->rb_right;
 		else {
 			best_fit = n;
+			exact_fit = 1;
 			break;
 		}
 	}
@@ -819,18 +923,20 @@ static struct binder_buffer *binder_alloc_buf(struct binder_proc *proc,
 			proc->pid, size);
 		return NULL;
 	}
-	if (n == NULL) {
+	if (!exact_fit) {
 		buffer = rb_entry(best_fit, struct binder_buffer, rb_node);
 		buffer_size = binder_buffer_size(proc, buffer);
 	}
 
+found:
+
 	binder_debug(BINDER_DEBUG_BUFFER_ALLOC,
 		     "%d: binder_alloc_buf size %zd got buffer %pK size %zd\n",
 		      proc->pid, size, buffer, buffer_size);
 
 	has_page_addr =
 		(void *)(((uintptr_t)buffer->data + buffer_size) & PAGE_MASK);
-	if (n == NULL) {
+	if (!exact_fit) {
 		if (size + sizeof(struct binder_buffer) + 4 >= buffer_size)
 			buffer_size = size; /* no room for other buffers */
 		else
@@ -844,7 +950,7 @@ static struct binder_buffer *binder_alloc_buf(struct binder_proc *proc,
 	    (void *)PAGE_ALIGN((uintptr_t)buffer->data), end_page_addr, NULL))
 		return NULL;
 
-	rb_erase(best_fit, &proc->free_buffers);
+	binder_erase_free_buffer(proc, buffer);
 	buffer->free = 0;
 	binder_insert_allocated_buffer(proc, buffer);
 	if (buffer_size != size) {
@@ -964,7 +1070,7 @@ static void binder_free_buf(struct binder_proc *proc,
 		struct binder_buffer *next = list_entry(buffer->entry.next,
 						struct binder_buffer, entry);
 		if (next->free) {
-			rb_erase(&next->rb_node, &proc->free_buffers);
+			binder_erase_free_buffer(proc, next);
 			binder_delete_free_buffer(proc, next);
 		}
 	}
@@ -973,11 +1079,12 @@ static void binder_free_buf(struct binder_proc *proc,
 						struct binder_buffer, entry);
 		if (prev->free) {
 			binder_delete_free_buffer(proc, buffer);
-			rb_erase(&prev->rb_node, &proc->free_buffers);
+			binder_erase_free_buffer(proc, prev);
 			buffer = prev;
 		}
 	}
 	binder_insert_free_buffer(proc, buffer);
+	binder_buf_cache_add(proc, buffer, binder_buffer_size(proc, buffer));
 }
 
 static struct binder_node *binder_get_node(struct binder_proc *proc,
@@ -1291,6 +1398,17 @@ static int binder_dec_ref(struct binder_ref **ptr_to_ref, int strong)
 	return 0;
 }
 
+/* Called with the reply to @t, @proc is the proc that sent @t */
+static void binder_account_latency(struct binder_proc *proc,
+				   struct binder_transaction *t)
+{
+	s64 us = ktime_us_delta(ktime_get(), t->start_time);
+	int bucket;
+
+	bucket = us > 0 ? min_t(int, fls64(us), BINDER_LATENCY_BUCKETS - 1) : 0;
+	proc->latency[bucket]++;
+}
+
 static void binder_pop_transaction(struct binder_thread *target_thread,
 				   struct binder_transaction *t)
 {
@@ -1944,6 +2062,10 @@ static void binder_transaction(struct binder_proc *proc,
 			goto err_empty_call_stack;
 		}
 		binder_set_nice(in_reply_to->saved_priority);
+		binder_set_scheduler(in_reply_to->saved_policy,
+				     in_reply_to->saved_rt_priority);
+		if (!in_reply_to->to_parent)
+			thread->rt_inherited = 0;
 		if (in_reply_to->to_thread != thread) {
 			binder_user_error("%d:%d got reply transaction with bad transaction stack, transaction %d has target %d:%d\n",
 				proc->pid, thread->pid, in_reply_to->debug_id,
@@ -2067,9 +2189,10 @@ static void binder_transaction(struct binder_proc *proc,
 			     (u64)tr->data_size, (u64)tr->offsets_size,
 			     (u64)extra_buffers_size);
 
-	if (!reply && !(tr->flags & TF_ONE_WAY))
+	if (!reply && !(tr->flags & TF_ONE_WAY)) {
 		t->from = thread;
-	else
+		t->start_time = ktime_get();
+	} else
 		t->from = NULL;
 #if defined(CONFIG_MACH_P4NOTE) || defined(CONFIG_MACH_KONA)
 	/* workaround code for invalid binder proc */
@@ -2087,6 +2210,8 @@ static void binder_transaction(struct binder_proc *proc,
 	t->code = tr->code;
 	t->flags = tr->flags;
 	t->priority = task_nice(current);
+	t->policy = current->policy;
+	t->rt_priority = current->rt_priority;
 
 	trace_binder_transaction(reply, t, target_node);
 
@@ -2267,6 +2392,7 @@ static void binder_transaction(struct binder_proc *proc,
 	}
 	if (reply) {
 		BUG_ON(t->buffer->async_transaction != 0);
+		binder_account_latency(target_proc, in_reply_to);
 		binder_pop_transaction(target_thread, in_reply_to);
 	} else if (!(t->flags & TF_ONE_WAY)) {
 		BUG_ON(t->buffer->async_transaction != 0);
@@ -2286,7 +2412,10 @@ static void binder_transaction(struct binder_proc *proc,
 	list_add_tail(&t->work.entry, target_list);
 	tcomplete->type = BINDER_WORK_TRANSACTION_COMPLETE;
 	list_add_tail(&tcomplete->entry, &thread->todo);
-	if (target_wait)
+	/* The sender waits for the reply, let the target run in its place */
+	if (target_wait && !(t->flags & TF_ONE_WAY))
+		wake_up_interruptible_sync(target_wait);
+	else if (target_wait)
 		wake_up_interruptible(target_wait);
 	return;
 
@@ -2793,6 +2922,12 @@ retry:
 						 binder_stop_on_user_error < 2);
 		}
 		binder_set_nice(proc->default_priority);
+		/* Left over from a transaction that did not get its reply */
+		if (thread->rt_inherited) {
+			binder_set_scheduler(thread->saved_policy,
+					     thread->saved_rt_priority);
+			thread->rt_inherited = 0;
+		}
 		if (non_block) {
 			if (!binder_has_proc_work(proc, thread))
 				ret = -EAGAIN;
@@ -2964,6 +3099,20 @@ retry:
 			tr.target.ptr = target_node->ptr;
 			tr.cookie =  target_node->cookie;
 			t->saved_priority = task_nice(current);
+			t->saved_policy = current->policy;
+			t->saved_rt_priority = current->rt_priority;
+			if (binder_inherit_rt && !(t->flags & TF_ONE_WAY) &&
+			    binder_rt_policy(t->policy) &&
+			    (!binder_rt_policy(current->policy) ||
+			     current->rt_priority < t->rt_priority)) {
+				if (!thread->rt_inherited) {
+					thread->saved_policy = current->policy;
+					thread->saved_rt_priority =
+						current->rt_priority;
+					thread->rt_inherited = 1;
+				}
+				binder_set_scheduler(t->policy, t->rt_priority);
+			}
 			if (t->priority < target_node->min_priority &&
 			    !(t->flags & TF_ONE_WAY))
 				binder_set_nice(t->priority);
@@ -4020,7 +4169,7 @@ static void print_binder_proc_stats(struct seq_file *m,
 {
 	struct binder_work *w;
 	struct rb_node *n;
-	int count, strong, weak;
+	int count, strong, weak, i;
 
 	seq_printf(m, "proc %d\n", proc->pid);
 	seq_printf(m, "context %s\n", proc->context->name);
@@ -4053,6 +4202,8 @@ static void print_binder_proc_stats(struct seq_file *m,
 	for (n = rb_first(&proc->allocated_buffers); n != NULL; n = rb_next(n))
 		count++;
 	seq_printf(m, "  buffers: %d\n", count);
+	seq_printf(m, "  buffer cache hits %u misses %u\n",
+		   proc->buf_cache_hits, proc->buf_cache_misses);
 
 	count = 0;
 	list_for_each_entry(w, &proc->todo, entry) {
@@ -4066,6 +4217,20 @@ static void print_binder_proc_stats(struct seq_file *m,
 	}
 	seq_printf(m, "  pending transactions: %d\n", count);
 
+	for (i = 0; i < BINDER_LATENCY_BUCKETS; i++)
+		if (proc->latency[i])
+			break;
+	if (i < BINDER_LATENCY_BUCKETS) {
+		seq_puts(m, "  round trip latency:\n");
+		for (; i < BINDER_LATENCY_BUCKETS - 1; i++)
+			if (proc->latency[i])
+				seq_printf(m, "    < %lu us: %u\n", 1UL << i,
+					   proc->latency[i]);
+		if (proc->latency[i])
+			seq_printf(m, "    >= %lu us: %u\n", 1UL << (i - 1),
+				   proc->latency[i]);
+	}
+
 	print_binder_stats(m, "  ", &proc->stats);
 }
 
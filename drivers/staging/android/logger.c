@@ -25,6 +25,8 @@
 #include <linux/poll.h>
 #include <linux/slab.h>
 #include <linux/time.h>
+#include <linux/percpu.h>
+#include <linux/mm.h>
 #include "logger.h"
 
 #include <asm/ioctls.h>
@@ -49,6 +51,7 @@ struct logger_log {
 	size_t			w_off;	/* current write head offset */
 	size_t			head;	/* new readers start here */
 	size_t			size;	/* size of the log */
+	struct logger_mmap_header *meta; /* shared with mmap readers */
 };
 
 /*
@@ -65,6 +68,21 @@ struct logger_reader {
 	int			r_ver;	/* reader ABI version */
 };
 
+/*
+ * struct logger_stage - a staging buffer for the payload of a write
+ *
+ * Writers copy the payload from user-space into the staging buffer of the
+ * CPU they run on, without log->mutex, and only take the mutex to commit
+ * the whole entry to the ring. The buffer belongs to the writer that set
+ * 'busy', a writer that finds it busy allocates its own.
+ */
+struct logger_stage {
+	atomic_t		busy;
+	unsigned char		buf[LOGGER_ENTRY_MAX_PAYLOAD];
+};
+
+static struct logger_stage __percpu *logger_stages;
+
 /* logger_offset - returns index 'n' into the log via (optimized) modulus */
 #define logger_offset(n)	((n) & (log->size - 1))
 
@@ -370,62 +388,47 @@ static void fix_up_readers(struct logger_log *log, size_t len)
 }
 
 /*
- * do_write_log - writes 'len' bytes from 'buf' to 'log'
+ * logger_meta_begin, logger_meta_end - bracket an update of the ring, and
+ * publish the new offsets to mmap readers.
  *
  * The caller needs to hold log->mutex.
  */
-static void do_write_log(struct logger_log *log, const void *buf, size_t count)
+static inline void logger_meta_begin(struct logger_log *log)
 {
-	size_t len;
-
-	len = min(count, log->size - log->w_off);
-	memcpy(log->buffer + log->w_off, buf, len);
-
-	if (count != len)
-		memcpy(log->buffer, buf + len, count - len);
-
-	log->w_off = logger_offset(log->w_off + count);
+	if (!log->meta)
+		return;
+	log->meta->seq++;
+	smp_wmb();
+}
 
+static inline void logger_meta_end(struct logger_log *log, size_t written)
+{
+	if (!log->meta)
+		return;
+	log->meta->w_off = log->w_off;
+	log->meta->head = log->head;
+	log->meta->written += written;
+	smp_wmb();
+	log->meta->seq++;
 }
 
 /*
- * do_write_log_user - writes 'len' bytes from the user-space buffer 'buf' to
- * the log 'log'
+ * do_write_log - writes 'len' bytes from 'buf' to 'log'
  *
  * The caller needs to hold log->mutex.
- *
- * Returns 'count' on success, negative error code on failure.
  */
-static ssize_t do_write_log_from_user(struct logger_log *log,
-				      const void __user *buf, size_t count)
+static void do_write_log(struct logger_log *log, const void *buf, size_t count)
 {
 	size_t len;
 
 	len = min(count, log->size - log->w_off);
-	if (len && copy_from_user(log->buffer + log->w_off, buf, len))
-		return -EFAULT;
+	memcpy(log->buffer + log->w_off, buf, len);
 
 	if (count != len)
-		if (copy_from_user(log->buffer, buf + len, count - len))
-			return -EFAULT;
-
-	/* print as kernel log if the log string starts with "!@" */
-	if (count >= 2) {
-		if (log->buffer[log->w_off] == '!'
-		    && log->buffer[logger_offset(log->w_off + 1)] == '@') {
-			char tmp[256];
-			int i;
-			for (i = 0; i < min(count, sizeof(tmp) - 1); i++)
-				tmp[i] =
-				    log->buffer[logger_offset(log->w_off + i)];
-			tmp[i] = '\0';
-;
-		}
-	}
+		memcpy(log->buffer, buf + len, count - len);
 
 	log->w_off = logger_offset(log->w_off + count);
 
-	return count;
 }
 
 /*
@@ -437,64 +440,83 @@ ssize_t logger_aio_write(struct kiocb *iocb, const struct iovec *iov,
 			 unsigned long nr_segs, loff_t ppos)
 {
 	struct logger_log *log = file_get_log(iocb->ki_filp);
-	size_t orig = log->w_off;
+	struct logger_stage *stage;
 	struct logger_entry header;
 	struct timespec now;
+	unsigned char *payload;
 	ssize_t ret = 0;
 
 	if (!enabled)
 		return 0;
 
-	now = current_kernel_time();
-
-	header.pid = current->tgid;
-	header.tid = current->pid;
-	header.sec = now.tv_sec;
-	header.nsec = now.tv_nsec;
-	header.euid = current_euid();
 	header.len = min_t(size_t, iocb->ki_left, LOGGER_ENTRY_MAX_PAYLOAD);
-	header.hdr_size = sizeof(struct logger_entry);
 
 	/* null writes succeed, return zero */
 	if (unlikely(!header.len))
 		return 0;
 
-	mutex_lock(&log->mutex);
-
-	/*
-	 * Fix up any readers, pulling them forward to the first readable
-	 * entry after (what will be) the new write offset. We do this now
-	 * because if we partially fail, we can end up with clobbered log
-	 * entries that encroach on readable buffer.
-	 */
-	fix_up_readers(log, sizeof(struct logger_entry) + header.len);
-
-	do_write_log(log, &header, sizeof(struct logger_entry));
+	/* Any CPU's buffer would do, the local one is likely to be free */
+	stage = per_cpu_ptr(logger_stages, raw_smp_processor_id());
+	if (!atomic_xchg(&stage->busy, 1)) {
+		payload = stage->buf;
+	} else {
+		stage = NULL;
+		payload = kmalloc(header.len, GFP_KERNEL);
+		if (!payload)
+			return -ENOMEM;
+	}
 
-	while (nr_segs-- > 0) {
+	while (nr_segs-- > 0 && ret < header.len) {
 		size_t len;
-		ssize_t nr;
 
 		/* figure out how much of this vector we can keep */
 		len = min_t(size_t, iov->iov_len, header.len - ret);
 
-		/* write out this segment's payload */
-		nr = do_write_log_from_user(log, iov->iov_base, len);
-		if (unlikely(nr < 0)) {
-			log->w_off = orig;
-			mutex_unlock(&log->mutex);
-			return nr;
+		if (copy_from_user(payload + ret, iov->iov_base, len)) {
+			ret = -EFAULT;
+			goto out;
 		}
 
 		iov++;
-		ret += nr;
+		ret += len;
 	}
+	header.len = ret;
+
+	mutex_lock(&log->mutex);
+
+	/* Stamped under the mutex, the ring stays in timestamp order */
+	now = current_kernel_time();
+
+	header.pid = current->tgid;
+	header.tid = current->pid;
+	header.sec = now.tv_sec;
+	header.nsec = now.tv_nsec;
+	header.euid = current_euid();
+	header.hdr_size = sizeof(struct logger_entry);
+
+	/*
+	 * Fix up any readers, pulling them forward to the first readable
+	 * entry after (what will be) the new write offset.
+	 */
+	logger_meta_begin(log);
+	fix_up_readers(log, sizeof(struct logger_entry) + header.len);
+
+	do_write_log(log, &header, sizeof(struct logger_entry));
+	do_write_log(log, payload, header.len);
+	logger_meta_end(log, sizeof(struct logger_entry) + header.len);
 
 	mutex_unlock(&log->mutex);
 
 	/* wake up any blocked readers */
 	wake_up_interruptible(&log->wq);
 
+out:
+	if (stage) {
+		smp_mb();
+		atomic_set(&stage->busy, 0);
+	} else {
+		kfree(payload);
+	}
 	return ret;
 }
 
@@ -615,6 +637,37 @@ static long logger_set_version(struct logger_reader *reader, void __user *arg)
 	return 0;
 }
 
+/*
+ * logger_set_read_offset - move the read head of an mmap reader, so that
+ * poll() waits for entries past what it consumed from the mapping.
+ *
+ * Caller must hold log->mutex.
+ */
+static long logger_set_read_offset(struct logger_log *log,
+				   struct logger_reader *reader,
+				   unsigned long off)
+{
+	struct logger_entry scratch;
+	struct logger_entry *entry;
+
+	if (off >= log->size)
+		return -EINVAL;
+
+	/* Anything but the write head has to be a live entry */
+	if (off != log->w_off) {
+		if (off != log->head &&
+		    !clock_interval(log->head, log->w_off, off))
+			return -EINVAL;
+		entry = get_entry_header(log, off, &scratch);
+		if (entry->hdr_size != sizeof(struct logger_entry) ||
+		    entry->len > LOGGER_ENTRY_MAX_PAYLOAD)
+			return -EINVAL;
+	}
+
+	reader->r_off = off;
+	return 0;
+}
+
 static long logger_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
 	struct logger_log *log = file_get_log(file);
@@ -661,9 +714,11 @@ static long logger_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 			ret = -EBADF;
 			break;
 		}
+		logger_meta_begin(log);
 		list_for_each_entry(reader, &log->readers, list)
 			reader->r_off = log->w_off;
 		log->head = log->w_off;
+		logger_meta_end(log, 0);
 		ret = 0;
 		break;
 	case LOGGER_GET_VERSION:
@@ -682,6 +737,14 @@ static long logger_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		reader = file->private_data;
 		ret = logger_set_version(reader, argp);
 		break;
+	case LOGGER_SET_READ_OFFSET:
+		if (!(file->f_mode & FMODE_READ)) {
+			ret = -EBADF;
+			break;
+		}
+		reader = file->private_data;
+		ret = logger_set_read_offset(log, reader, arg);
+		break;
 	}
 
 	mutex_unlock(&log->mutex);
@@ -689,11 +752,64 @@ static long logger_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	return ret;
 }
 
+/*
+ * logger_mmap - the log's mmap file operation
+ *
+ * Maps the header page and, after it, the ring, read-only. The ring holds
+ * the entries of every uid and version 2 headers, so the reader needs to
+ * be allowed to read all entries and to have asked for version 2.
+ */
+static int logger_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct logger_reader *reader;
+	struct logger_log *log;
+	unsigned long addr;
+	size_t off;
+	int ret;
+
+	if (!(file->f_mode & FMODE_READ))
+		return -EBADF;
+
+	reader = file->private_data;
+	log = reader->log;
+
+	if (!reader->r_all)
+		return -EACCES;
+	if (reader->r_ver < 2 || !log->meta)
+		return -EINVAL;
+	if (vma->vm_pgoff ||
+	    vma->vm_end - vma->vm_start != PAGE_SIZE + log->size)
+		return -EINVAL;
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_flags |= VM_DONTEXPAND | VM_DONTCOPY;
+
+	ret = vm_insert_page(vma, vma->vm_start, virt_to_page(log->meta));
+	if (ret)
+		return ret;
+
+	/* The ring is in the module area when the logger is a module */
+	addr = vma->vm_start + PAGE_SIZE;
+	for (off = 0; off < log->size; off += PAGE_SIZE, addr += PAGE_SIZE) {
+		void *p = log->buffer + off;
+
+		ret = vm_insert_page(vma, addr, is_vmalloc_or_module_addr(p) ?
+				     vmalloc_to_page(p) : virt_to_page(p));
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 static const struct file_operations logger_fops = {
 	.owner = THIS_MODULE,
 	.read = logger_read,
 	.aio_write = logger_aio_write,
 	.poll = logger_poll,
+	.mmap = logger_mmap,
 	.unlocked_ioctl = logger_ioctl,
 	.compat_ioctl = logger_ioctl,
 	.open = logger_open,
@@ -706,7 +822,7 @@ static const struct file_operations logger_fops = {
  * (LOGGER_ENTRY_MAX_PAYLOAD + sizeof(struct logger_entry)).
  */
 #define DEFINE_LOGGER_DEVICE(VAR, NAME, SIZE) \
-static unsigned char _buf_ ## VAR[SIZE]; \
+static unsigned char _buf_ ## VAR[SIZE] __aligned(PAGE_SIZE); \
 static struct logger_log VAR = { \
 	.buffer = _buf_ ## VAR, \
 	.misc = { \
@@ -752,6 +868,11 @@ static int __init init_log(struct logger_log *log)
 {
 	int ret;
 
+	/* Without it the log works, but cannot be mapped */
+	log->meta = (void *)get_zeroed_page(GFP_KERNEL);
+	if (log->meta)
+		log->meta->size = log->size;
+
 	ret = misc_register(&log->misc);
 	if (unlikely(ret)) {
 //		printk(KERN_ERR "logger: failed to register misc "
@@ -769,6 +890,10 @@ static int __init logger_init(void)
 {
 	int ret;
 
+	logger_stages = alloc_percpu(struct logger_stage);
+	if (!logger_stages)
+		return -ENOMEM;
+
 	ret = init_log(&log_main);
 	if (unlikely(ret))
 		goto out;
@@ -51,6 +51,20 @@ struct logger_entry {
 	char		msg[0];		/* the entry's payload */
 };
 
+/*
+ * The first page of a read-only mmap() of a log; the ring itself follows,
+ * holding version 2 entries. 'seq' is odd while the ring is updated, a
+ * reader copies an entry out, then checks that 'seq' has not changed or
+ * that the writer has not gone past the entry.
+ */
+struct logger_mmap_header {
+	__u32		seq;		/* update count */
+	__u32		w_off;		/* offset of the next entry */
+	__u32		head;		/* offset of the oldest entry */
+	__u32		size;		/* size of the ring */
+	__u32		written;	/* bytes written, wrapping */
+};
+
 #define LOGGER_LOG_RADIO	"log_radio"	/* radio-related messages */
 #define LOGGER_LOG_EVENTS	"log_events"	/* system/hardware events */
 #define LOGGER_LOG_SYSTEM	"log_system"	/* system/framework messages */
@@ -67,5 +81,6 @@ struct logger_entry {
 #define LOGGER_FLUSH_LOG		_IO(__LOGGERIO, 4) /* flush log */
 #define LOGGER_GET_VERSION		_IO(__LOGGERIO, 5) /* abi version */
 #define LOGGER_SET_VERSION		_IO(__LOGGERIO, 6) /* abi version */
+#define LOGGER_SET_READ_OFFSET		_IO(__LOGGERIO, 7) /* mmap position */
 
 #endif /* _LINUX_LOGGER_H */
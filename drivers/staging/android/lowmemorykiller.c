@@ -13,6 +13,11 @@
  * drops below 4096 pages and kill processes with a oom_score_adj value of 0 or
  * higher when the free memory drops below 1024 pages.
  *
+ * With /sys/module/lowmemorykiller/parameters/vmpressure_mode set, the
+ * thresholds are only checked when reclaim reports a vmpressure of at least
+ * /sys/module/lowmemorykiller/parameters/vmpressure_level (0-100), and the
+ * shrinker no longer runs from every shrink_slab() call.
+ *
  * The driver considers memory used for caches to be free, but if a large
  * percentage of the cached memory is locked this can be very inaccurate
  * and processes may not get killed until the normal oom killer is triggered.
@@ -42,6 +47,13 @@
 #include <linux/ratelimit.h>
 #include <linux/rcupdate.h>
 #include <linux/notifier.h>
+#include <linux/vmpressure.h>
+#include <linux/workqueue.h>
+#include <linux/ktime.h>
+#include <linux/err.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/wait.h>
 #ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_DO_NOT_KILL_PROCESS
 #include <linux/string.h>
 #endif
@@ -106,6 +118,12 @@ static bool is_in_donotkill_proc_list(char *proc_name)
 
 static unsigned long lowmem_deathpending_timeout;
 
+/* vmpressure mode, see lowmem_vmpressure_work_fn() */
+#define LOWMEM_VMPRESSURE_CRITICAL	95
+static bool lowmem_vmpressure_mode;
+static unsigned long lowmem_vmpressure_level = 60;
+static unsigned long lowmem_last_pressure;
+
 #define lowmem_print(level, x...)			\
 	do {						\
 		if (lowmem_debug_level >= (level))	\
@@ -118,152 +136,544 @@ static unsigned long lowmem_deathpending_timeout;
 			pr_err_ratelimited(x);			\
 	} while (0)
 
-static int lowmem_shrink(struct shrinker *s, struct shrink_control *sc)
+/*
+ * Returns the lowest oom_score_adj to kill for the given free and
+ * file pages, OOM_SCORE_ADJ_MAX + 1 if nothing has to be killed.
+ */
+static int lowmem_min_score_adj(int other_free, int other_file, int *minfree)
 {
-	struct task_struct *tsk;
-	struct task_struct *selected = NULL;
-	int rem = 0;
-	int tasksize;
 	int i;
-	int min_score_adj = OOM_SCORE_ADJ_MAX + 1;
-	int minfree = 0;
-	int selected_tasksize = 0;
-	int selected_oom_score_adj;
 	int array_size = ARRAY_SIZE(lowmem_adj);
-	int other_free = global_page_state(NR_FREE_PAGES) - totalreserve_pages;
-	int other_file = global_page_state(NR_FILE_PAGES) -
-						global_page_state(NR_SHMEM);
 
 	if (lowmem_adj_size < array_size)
 		array_size = lowmem_adj_size;
 	if (lowmem_minfree_size < array_size)
 		array_size = lowmem_minfree_size;
 	for (i = 0; i < array_size; i++) {
-		minfree = lowmem_minfree[i];
-		if (other_free < minfree && other_file < minfree) {
-			min_score_adj = lowmem_adj[i];
+		*minfree = lowmem_minfree[i];
+		if (other_free < *minfree && other_file < *minfree)
+			return lowmem_adj[i];
+	}
+
+	return OOM_SCORE_ADJ_MAX + 1;
+}
+
+#ifdef CONFIG_DEBUG_FS
+/* victim selection cost, see /sys/kernel/debug/lowmemorykiller/ */
+static u64 lowmem_select_count;
+static u64 lowmem_select_time_ns;
+static u64 lowmem_select_max_ns;
+#endif
+
+/*
+ * Killed tasks whose memory is not freed yet. Their rss is counted as
+ * free in the minfree comparison, so reclaim does not pick a second
+ * victim while the first one is still exiting. An entry is dropped when
+ * the victim's mm has been torn down (mm_exit notifier) or after
+ * LOWMEM_VICTIM_TIMEOUT, if something keeps the mm alive.
+ */
+#define LOWMEM_MAX_VICTIMS	8
+#define LOWMEM_VICTIM_TIMEOUT	(2 * HZ)
+/* kill to free latency: <1ms, then power of two ms up to >=1024ms */
+#define LOWMEM_LATENCY_BUCKETS	12
+
+struct lowmem_victim {
+	struct mm_struct *mm;	/* holds a mm_count reference */
+	int rss;
+	unsigned long kill_jiffies;
+	ktime_t kill_time;
+};
+
+static DEFINE_SPINLOCK(lowmem_victim_lock);
+static struct lowmem_victim lowmem_victims[LOWMEM_MAX_VICTIMS];
+static int lowmem_victim_count;
+static int lowmem_victim_rss;
+static DECLARE_WAIT_QUEUE_HEAD(lowmem_victim_wait);
+static u64 lowmem_kill_latency[LOWMEM_LATENCY_BUCKETS];
+static u64 lowmem_victim_expired;
+static unsigned int lowmem_victim_wait_ms = 20;
+
+/* caller holds lowmem_victim_lock */
+static void lowmem_victim_del(struct lowmem_victim *victim)
+{
+	lowmem_victim_rss -= victim->rss;
+	lowmem_victim_count--;
+	victim->mm = NULL;
+}
+
+static void lowmem_track_victim(struct task_struct *tsk, int rss)
+{
+	struct task_struct *p;
+	struct mm_struct *mm;
+	int i;
+
+	p = find_lock_task_mm(tsk);
+	if (!p)
+		return;
+	mm = p->mm;
+
+	spin_lock(&lowmem_victim_lock);
+	for (i = 0; i < LOWMEM_MAX_VICTIMS; i++) {
+		if (lowmem_victims[i].mm == mm)
+			break;
+		if (!lowmem_victims[i].mm) {
+			atomic_inc(&mm->mm_count);
+			lowmem_victims[i].mm = mm;
+			lowmem_victims[i].rss = rss;
+			lowmem_victims[i].kill_jiffies = jiffies;
+			lowmem_victims[i].kill_time = ktime_get();
+			lowmem_victim_rss += rss;
+			lowmem_victim_count++;
 			break;
 		}
 	}
-	if (sc->nr_to_scan > 0)
-		lowmem_print(3, "lowmem_shrink %lu, %x, ofree %d %d, ma %d\n",
-				sc->nr_to_scan, sc->gfp_mask, other_free,
-				other_file, min_score_adj);
-	rem = global_page_state(NR_ACTIVE_ANON) +
-		global_page_state(NR_ACTIVE_FILE) +
-		global_page_state(NR_INACTIVE_ANON) +
-		global_page_state(NR_INACTIVE_FILE);
-	if (sc->nr_to_scan <= 0 || min_score_adj == OOM_SCORE_ADJ_MAX + 1) {
-		lowmem_print(5, "lowmem_shrink %lu, %x, return %d\n",
-			     sc->nr_to_scan, sc->gfp_mask, rem);
-		return rem;
+	spin_unlock(&lowmem_victim_lock);
+	task_unlock(p);
+}
+
+/* returns the rss of the victims still exiting, drops stale ones */
+static int lowmem_victims_pending(void)
+{
+	struct mm_struct *expired[LOWMEM_MAX_VICTIMS];
+	int i, n = 0, rss;
+
+	if (!ACCESS_ONCE(lowmem_victim_count))
+		return 0;
+
+	spin_lock(&lowmem_victim_lock);
+	for (i = 0; i < LOWMEM_MAX_VICTIMS; i++) {
+		if (lowmem_victims[i].mm &&
+		    time_after(jiffies, lowmem_victims[i].kill_jiffies +
+			       LOWMEM_VICTIM_TIMEOUT)) {
+			expired[n++] = lowmem_victims[i].mm;
+			lowmem_victim_del(&lowmem_victims[i]);
+			lowmem_victim_expired++;
+		}
 	}
-	selected_oom_score_adj = min_score_adj;
+	rss = lowmem_victim_rss;
+	spin_unlock(&lowmem_victim_lock);
 
-	rcu_read_lock();
-	for_each_process(tsk) {
-		struct task_struct *p;
-		int oom_score_adj;
+	for (i = 0; i < n; i++)
+		mmdrop(expired[i]);
 
-		if (tsk->flags & PF_KTHREAD)
-			continue;
+	return rss;
+}
 
-		p = find_lock_task_mm(tsk);
-		if (!p)
-			continue;
+static int lowmem_mm_exit_notifier(struct notifier_block *nb,
+				   unsigned long action, void *data)
+{
+	struct mm_struct *mm = data;
+	s64 ms;
+	int i, bucket;
+	bool found = false;
 
-		if (test_tsk_thread_flag(p, TIF_MEMDIE) &&
-		    time_before_eq(jiffies, lowmem_deathpending_timeout)) {
-			task_unlock(p);
-			rcu_read_unlock();
-			return 0;
-		}
-		oom_score_adj = p->signal->oom_score_adj;
-		if (oom_score_adj < min_score_adj) {
-			task_unlock(p);
+	if (!ACCESS_ONCE(lowmem_victim_count))
+		return NOTIFY_DONE;
+
+	spin_lock(&lowmem_victim_lock);
+	for (i = 0; i < LOWMEM_MAX_VICTIMS; i++) {
+		if (lowmem_victims[i].mm != mm)
 			continue;
-		}
-		tasksize = get_mm_rss(p->mm);
+
+		ms = ktime_to_ms(ktime_sub(ktime_get(),
+					   lowmem_victims[i].kill_time));
+		bucket = ms > 0 ? min_t(int, fls(ms), LOWMEM_LATENCY_BUCKETS - 1) : 0;
+		lowmem_kill_latency[bucket]++;
+		lowmem_print(3, "victim mm freed %lldms after kill, rss %d\n",
+			     ms, lowmem_victims[i].rss);
+		lowmem_victim_del(&lowmem_victims[i]);
+		found = true;
+		break;
+	}
+	spin_unlock(&lowmem_victim_lock);
+
+	if (found) {
+		/* mmput() still holds its own mm_count reference */
+		mmdrop(mm);
+		wake_up_all(&lowmem_victim_wait);
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block lowmem_mm_exit_nb = {
+	.notifier_call = lowmem_mm_exit_notifier,
+};
+
+/*
+ * Lets a direct reclaimer wait a little for the victims to free their
+ * memory instead of going on reclaiming or killing again.
+ */
+static void lowmem_wait_for_victims(void)
+{
+	if (!lowmem_victim_wait_ms || current_is_kswapd() ||
+	    test_thread_flag(TIF_MEMDIE) || fatal_signal_pending(current))
+		return;
+
+	wait_event_timeout(lowmem_victim_wait,
+			   !ACCESS_ONCE(lowmem_victim_count),
+			   msecs_to_jiffies(lowmem_victim_wait_ms));
+}
+
+/*
+ * Makes tsk the selected victim if it is bigger or has a higher
+ * oom_score_adj than the current one. Returns -EBUSY if tsk is an
+ * earlier victim that is still exiting.
+ */
+static int lowmem_check_task(struct task_struct *tsk, int min_score_adj,
+			     struct task_struct **selected,
+			     int *selected_tasksize,
+			     int *selected_oom_score_adj)
+{
+	struct task_struct *p;
+	int oom_score_adj;
+	int tasksize;
+
+	if (tsk->flags & PF_KTHREAD)
+		return 0;
+
+	p = find_lock_task_mm(tsk);
+	if (!p)
+		return 0;
+
+	if (test_tsk_thread_flag(p, TIF_MEMDIE) &&
+	    time_before_eq(jiffies, lowmem_deathpending_timeout)) {
 		task_unlock(p);
-		if (tasksize <= 0)
-			continue;
-		if (selected) {
-			if (oom_score_adj < selected_oom_score_adj)
-				continue;
-			if (oom_score_adj == selected_oom_score_adj &&
-			    tasksize <= selected_tasksize)
-				continue;
-		}
+		return -EBUSY;
+	}
+	oom_score_adj = p->signal->oom_score_adj;
+	if (oom_score_adj < min_score_adj) {
+		task_unlock(p);
+		return 0;
+	}
+	tasksize = get_mm_rss(p->mm);
+	task_unlock(p);
+	if (tasksize <= 0)
+		return 0;
+	if (*selected) {
+		if (oom_score_adj < *selected_oom_score_adj)
+			return 0;
+		if (oom_score_adj == *selected_oom_score_adj &&
+		    tasksize <= *selected_tasksize)
+			return 0;
+	}
 
 #ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_DO_NOT_KILL_PROCESS
-		if (is_in_donotkill_proc_list(p->comm)) {
-			lowmem_print_ratelimited(2, "[lmk] the process '%s' is inside the donotkill_proc_names\n", p->comm);
-			lowmem_print_ratelimited(2, "[lmk] set oom_score_adj from %d to %d for (%s)\n", p->signal->oom_score_adj, 0, p->comm);
-			p->signal->oom_score_adj = 0;
-			continue;
-		}
+	if (is_in_donotkill_proc_list(p->comm)) {
+		lowmem_print_ratelimited(2, "[lmk] the process '%s' is inside the donotkill_proc_names\n", p->comm);
+		lowmem_print_ratelimited(2, "[lmk] set oom_score_adj from %d to %d for (%s)\n", p->signal->oom_score_adj, 0, p->comm);
+		/* the adj index is rehashed lazily, the scan rereads the adj */
+		p->signal->oom_score_adj = 0;
+		return 0;
+	}
 #endif
 
-		selected = p;
-		selected_tasksize = tasksize;
-		selected_oom_score_adj = oom_score_adj;
-		lowmem_print(2, "select '%s' (%d), adj %d, size %d, to kill\n",
-			     p->comm, p->pid, oom_score_adj, tasksize);
+	*selected = p;
+	*selected_tasksize = tasksize;
+	*selected_oom_score_adj = oom_score_adj;
+	lowmem_print(2, "select '%s' (%d), adj %d, size %d, to kill\n",
+		     p->comm, p->pid, oom_score_adj, tasksize);
+	return 0;
+}
+
+/*
+ * Returns the victim with a reference held, NULL if there is none or
+ * ERR_PTR(-EBUSY) if an earlier victim is still exiting.
+ */
+static struct task_struct *lowmem_select(int min_score_adj,
+					 int *selected_tasksize,
+					 int *selected_oom_score_adj)
+{
+	struct task_struct *tsk;
+	struct task_struct *selected = NULL;
+	int ret = 0;
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_ADJ_INDEX
+	struct hlist_node *node;
+	int b;
+
+	/* only the highest bucket holding a candidate is looked at */
+	spin_lock(&oom_adj_index_lock);
+	for (b = OOM_ADJ_BUCKETS - 1;
+	     b >= oom_adj_bucket(min_score_adj) && !selected && !ret; b--) {
+		hlist_for_each_entry(tsk, node, &oom_adj_buckets[b],
+				     oom_adj_node) {
+			ret = lowmem_check_task(tsk, min_score_adj, &selected,
+						selected_tasksize,
+						selected_oom_score_adj);
+			if (ret)
+				break;
+		}
 	}
-	if (selected) {
+	if (!ret && selected)
+		get_task_struct(selected);
+	spin_unlock(&oom_adj_index_lock);
+#else
+	rcu_read_lock();
+	for_each_process(tsk) {
+		ret = lowmem_check_task(tsk, min_score_adj, &selected,
+					selected_tasksize,
+					selected_oom_score_adj);
+		if (ret)
+			break;
+	}
+	if (!ret && selected)
+		get_task_struct(selected);
+	rcu_read_unlock();
+#endif
+
+	if (ret)
+		return ERR_PTR(ret);
+	return selected;
+}
+
+/*
+ * Kills the biggest task with the highest oom_score_adj at or above
+ * min_score_adj. Returns the rss of the killed task in pages, 0 if
+ * nothing was killed, -EBUSY if an earlier victim is still exiting.
+ */
+static int lowmem_kill(int min_score_adj, int minfree, int other_free,
+		       int other_file)
+{
+	struct task_struct *selected;
+	int selected_tasksize = 0;
+	int selected_oom_score_adj = min_score_adj;
+	int ret = 0;
+#ifdef CONFIG_DEBUG_FS
+	ktime_t start = ktime_get();
+	u64 delta;
+#endif
+
+	selected = lowmem_select(min_score_adj, &selected_tasksize,
+				 &selected_oom_score_adj);
+
+#ifdef CONFIG_DEBUG_FS
+	delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+	lowmem_select_count++;
+	lowmem_select_time_ns += delta;
+	if (delta > lowmem_select_max_ns)
+		lowmem_select_max_ns = delta;
+#endif
+
+	if (IS_ERR(selected))
+		return PTR_ERR(selected);
+	if (!selected)
+		return 0;
+
 #ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_DO_NOT_KILL_PROCESS
-		if (!is_in_donotkill_proc_list(selected->comm)) {
+	if (!is_in_donotkill_proc_list(selected->comm)) {
 #endif
-			lowmem_print(1, "Killing '%s' (%d), adj %d,\n" \
-				"   to free %ldkB on behalf of '%s' (%d) because\n" \
-				"   cache %ldkB is below limit %ldkB for oom_score_adj %d\n" \
-				"   Free memory is %ldkB above reserved\n",
-			     selected->comm, selected->pid,
-			     selected_oom_score_adj,
-			     selected_tasksize * (long)(PAGE_SIZE / 1024),
-			     current->comm, current->pid,
-			     other_file * (long)(PAGE_SIZE / 1024),
-			     minfree * (long)(PAGE_SIZE / 1024),
-			     min_score_adj,
-			     other_free * (long)(PAGE_SIZE / 1024));
-			lowmem_deathpending_timeout = jiffies + HZ;
-			send_sig(SIGKILL, selected, 0);
-			set_tsk_thread_flag(selected, TIF_MEMDIE);
-			rem -= selected_tasksize;
+		lowmem_print(1, "Killing '%s' (%d), adj %d,\n" \
+			"   to free %ldkB on behalf of '%s' (%d) because\n" \
+			"   cache %ldkB is below limit %ldkB for oom_score_adj %d\n" \
+			"   Free memory is %ldkB above reserved\n",
+		     selected->comm, selected->pid,
+		     selected_oom_score_adj,
+		     selected_tasksize * (long)(PAGE_SIZE / 1024),
+		     current->comm, current->pid,
+		     other_file * (long)(PAGE_SIZE / 1024),
+		     minfree * (long)(PAGE_SIZE / 1024),
+		     min_score_adj,
+		     other_free * (long)(PAGE_SIZE / 1024));
+		lowmem_deathpending_timeout = jiffies + HZ;
+		send_sig(SIGKILL, selected, 0);
+		set_tsk_thread_flag(selected, TIF_MEMDIE);
+		lowmem_track_victim(selected, selected_tasksize);
+		ret = selected_tasksize;
 #ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_DO_NOT_KILL_PROCESS
-		} else {
-			lowmem_print(1, "[lmk] the process '%s' is inside the donotkill_proc_names\n", selected->comm);
-			lowmem_print(2, "[lmk] set oom_score_adj from %d to %d for (%s)\n", selected->signal->oom_score_adj, 0, selected->comm);
-			selected->signal->oom_score_adj = 0;
-			rcu_read_unlock();
-			/* give the system time to free up the memory */
-			msleep_interruptible(20);
+	} else {
+		lowmem_print(1, "[lmk] the process '%s' is inside the donotkill_proc_names\n", selected->comm);
+		lowmem_print(2, "[lmk] set oom_score_adj from %d to %d for (%s)\n", selected->signal->oom_score_adj, 0, selected->comm);
+		selected->signal->oom_score_adj = 0;
+		oom_adj_index_update(selected);
+		put_task_struct(selected);
+		/* give the system time to free up the memory */
+		msleep_interruptible(20);
+		return 0;
+	}
+#endif
+	put_task_struct(selected);
 
-		}
+	return ret;
+}
 
-#endif
+static int lowmem_shrink(struct shrinker *s, struct shrink_control *sc)
+{
+	int rem = 0;
+	int killed;
+	int min_score_adj;
+	int minfree = 0;
+	int other_free, other_file;
+
+	/* kills are driven by vmpressure, stay off the reclaim path */
+	if (lowmem_vmpressure_mode)
+		return 0;
+
+	other_free = global_page_state(NR_FREE_PAGES) - totalreserve_pages +
+		lowmem_victims_pending();
+	other_file = global_page_state(NR_FILE_PAGES) -
+						global_page_state(NR_SHMEM);
+	min_score_adj = lowmem_min_score_adj(other_free, other_file, &minfree);
+
+	if (sc->nr_to_scan > 0)
+		lowmem_print(3, "lowmem_shrink %lu, %x, ofree %d %d, ma %d\n",
+				sc->nr_to_scan, sc->gfp_mask, other_free,
+				other_file, min_score_adj);
+	rem = global_page_state(NR_ACTIVE_ANON) +
+		global_page_state(NR_ACTIVE_FILE) +
+		global_page_state(NR_INACTIVE_ANON) +
+		global_page_state(NR_INACTIVE_FILE);
+	if (sc->nr_to_scan <= 0 || min_score_adj == OOM_SCORE_ADJ_MAX + 1) {
+		lowmem_print(5, "lowmem_shrink %lu, %x, return %d\n",
+			     sc->nr_to_scan, sc->gfp_mask, rem);
+		return rem;
 	}
 
+	killed = lowmem_kill(min_score_adj, minfree, other_free, other_file);
+	if (killed)
+		lowmem_wait_for_victims();
+	if (killed < 0)
+		return 0;
+	rem -= killed;
+
 	lowmem_print(4, "lowmem_shrink %lu, %x, return %d\n",
 		     sc->nr_to_scan, sc->gfp_mask, rem);
-	rcu_read_unlock();
 	return rem;
 }
 
+/*
+ * vmpressure mode: reclaim reports its scanned/reclaimed ratio through
+ * the vmpressure notifier and the minfree check runs from a work item
+ * only when that ratio reaches vmpressure_level. At critical pressure
+ * (reclaim fails for almost every scanned page) the page cache is not
+ * counted as free any more, it is evidently not reclaimable.
+ */
+static void lowmem_vmpressure_work_fn(struct work_struct *work)
+{
+	int min_score_adj;
+	int minfree = 0;
+	int other_free, other_file;
+
+	other_free = global_page_state(NR_FREE_PAGES) - totalreserve_pages +
+		lowmem_victims_pending();
+	other_file = global_page_state(NR_FILE_PAGES) -
+						global_page_state(NR_SHMEM);
+	if (lowmem_last_pressure >= LOWMEM_VMPRESSURE_CRITICAL)
+		other_file = 0;
+
+	min_score_adj = lowmem_min_score_adj(other_free, other_file, &minfree);
+	lowmem_print(3, "vmpressure %lu, ofree %d %d, ma %d\n",
+		     lowmem_last_pressure, other_free, other_file,
+		     min_score_adj);
+	if (min_score_adj == OOM_SCORE_ADJ_MAX + 1)
+		return;
+
+	lowmem_kill(min_score_adj, minfree, other_free, other_file);
+}
+
+static DECLARE_WORK(lowmem_vmpressure_work, lowmem_vmpressure_work_fn);
+
+/* called from the reclaim path, must not block */
+static int lowmem_vmpressure_notifier(struct notifier_block *nb,
+				      unsigned long action, void *data)
+{
+	unsigned long pressure = action;
+
+	if (!lowmem_vmpressure_mode || pressure < lowmem_vmpressure_level)
+		return NOTIFY_DONE;
+
+	lowmem_last_pressure = pressure;
+	if (!work_pending(&lowmem_vmpressure_work))
+		schedule_work(&lowmem_vmpressure_work);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block lowmem_vmpressure_nb = {
+	.notifier_call = lowmem_vmpressure_notifier,
+};
+
 static struct shrinker lowmem_shrinker = {
 	.shrink = lowmem_shrink,
 	.seeks = DEFAULT_SEEKS * 16
 };
 
+#ifdef CONFIG_DEBUG_FS
+static struct dentry *lowmem_debugfs_root;
+
+static int lowmem_kill_latency_show(struct seq_file *m, void *v)
+{
+	int i;
+
+	seq_printf(m, "%10s %10llu\n", "<1ms", lowmem_kill_latency[0]);
+	for (i = 1; i < LOWMEM_LATENCY_BUCKETS - 1; i++)
+		seq_printf(m, "%8dms %10llu\n", 1 << (i - 1),
+			   lowmem_kill_latency[i]);
+	seq_printf(m, "%7d+ms %10llu\n", 1 << (i - 1),
+		   lowmem_kill_latency[i]);
+	seq_printf(m, "%10s %10llu\n", "expired", lowmem_victim_expired);
+
+	return 0;
+}
+
+static int lowmem_kill_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lowmem_kill_latency_show, NULL);
+}
+
+static const struct file_operations lowmem_kill_latency_fops = {
+	.open = lowmem_kill_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void __init lowmem_debugfs_init(void)
+{
+	lowmem_debugfs_root = debugfs_create_dir("lowmemorykiller", NULL);
+	if (!lowmem_debugfs_root)
+		return;
+
+	debugfs_create_u64("select_count", S_IRUGO, lowmem_debugfs_root,
+			   &lowmem_select_count);
+	debugfs_create_u64("select_time_ns", S_IRUGO, lowmem_debugfs_root,
+			   &lowmem_select_time_ns);
+	debugfs_create_u64("select_max_ns", S_IRUGO, lowmem_debugfs_root,
+			   &lowmem_select_max_ns);
+	debugfs_create_file("kill_to_free_latency", S_IRUGO,
+			    lowmem_debugfs_root, NULL,
+			    &lowmem_kill_latency_fops);
+}
+
+static void __exit lowmem_debugfs_exit(void)
+{
+	debugfs_remove_recursive(lowmem_debugfs_root);
+}
+#else
+static inline void lowmem_debugfs_init(void)
+{
+}
+
+static inline void lowmem_debugfs_exit(void)
+{
+}
+#endif
+
 static int __init lowmem_init(void)
 {
+	lowmem_debugfs_init();
 	register_shrinker(&lowmem_shrinker);
+	vmpressure_notifier_register(&lowmem_vmpressure_nb);
+	mm_exit_register(&lowmem_mm_exit_nb);
 	return 0;
 }
 
 static void __exit lowmem_exit(void)
 {
+	mm_exit_unregister(&lowmem_mm_exit_nb);
+	vmpressure_notifier_unregister(&lowmem_vmpressure_nb);
+	cancel_work_sync(&lowmem_vmpressure_work);
 	unregister_shrinker(&lowmem_shrinker);
+	lowmem_debugfs_exit();
 }
 
 #ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_AUTODETECT_OOM_ADJ_VALUES
@@ -357,6 +767,12 @@ module_param_array_named(adj, lowmem_adj, int, &lowmem_adj_size,
 module_param_array_named(minfree, lowmem_minfree, uint, &lowmem_minfree_size,
 			 S_IRUGO | S_IWUSR);
 module_param_named(debug_level, lowmem_debug_level, uint, S_IRUGO | S_IWUSR);
+module_param_named(vmpressure_mode, lowmem_vmpressure_mode, bool,
+		   S_IRUGO | S_IWUSR);
+module_param_named(vmpressure_level, lowmem_vmpressure_level, ulong,
+		   S_IRUGO | S_IWUSR);
+module_param_named(victim_wait_ms, lowmem_victim_wait_ms, uint,
+		   S_IRUGO | S_IWUSR);
 
 #ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_DO_NOT_KILL_PROCESS
 module_param_named(donotkill_proc, donotkill_proc.enabled, uint, S_IRUGO | S_IWUSR);
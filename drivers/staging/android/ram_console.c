@@ -86,20 +86,29 @@ static void ram_console_update(const char *s, unsigned int count)
 	uint8_t *buffer_end = buffer->data + ram_console_buffer_size;
 	uint8_t *block;
 	uint8_t *par;
+	size_t end;
 	int size = ECC_BLOCK_SIZE;
 #endif
 	memcpy(buffer->data + buffer->start, s, count);
 #ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
+	/*
+	 * Short writes would encode the same block over and over, only
+	 * encode the blocks this write completes. The block still being
+	 * filled is not checked when the old log is saved.
+	 */
+	end = buffer->start + count;
+	if (end < ram_console_buffer_size)
+		end &= ~(ECC_BLOCK_SIZE - 1);
 	block = buffer->data + (buffer->start & ~(ECC_BLOCK_SIZE - 1));
 	par = ram_console_par_buffer +
 	      (buffer->start / ECC_BLOCK_SIZE) * ECC_SIZE;
-	do {
+	while (block < buffer->data + end) {
 		if (block + ECC_BLOCK_SIZE > buffer_end)
 			size = buffer_end - block;
 		ram_console_encode_rs8(block, size, par);
 		block += ECC_BLOCK_SIZE;
 		par += ECC_SIZE;
-	} while (block < buffer->data + buffer->start + count);
+	}
 #endif
 }
 
@@ -168,14 +177,24 @@ ram_console_save_old(struct ram_console_buffer *buffer, const char *bootinfo,
 #ifdef CONFIG_ANDROID_RAM_CONSOLE_ERROR_CORRECTION
 	uint8_t *block;
 	uint8_t *par;
+	uint8_t *partial = NULL;
 	char strbuf[80];
 	int strbuf_len = 0;
 
+	/* The parity of a block still being filled is stale */
+	if (buffer->start & (ECC_BLOCK_SIZE - 1))
+		partial = buffer->data + (buffer->start & ~(ECC_BLOCK_SIZE - 1));
+
 	block = buffer->data;
 	par = ram_console_par_buffer;
 	while (block < buffer->data + buffer->size) {
 		int numerr;
 		int size = ECC_BLOCK_SIZE;
+		if (block == partial) {
+			block += ECC_BLOCK_SIZE;
+			par += ECC_SIZE;
+			continue;
+		}
 		if (block + size > buffer->data + ram_console_buffer_size)
 			size = buffer->data + ram_console_buffer_size - block;
 		numerr = ram_console_decode_rs8(block, size, par);
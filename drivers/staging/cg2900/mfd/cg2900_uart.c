@@ -1719,18 +1719,61 @@ static void send_skb_to_core(struct uart_info *uart_info, struct sk_buff *skb)
 	}
 }
 
+/**
+ * rx_data_len() - Get the data length of a packet from its header.
+ * @state:	Header state the packet is in.
+ * @hdr:	Header, after the H:4 byte.
+ *
+ * Returns:
+ *   Number of data bytes after the header, -EINVAL on a bad state.
+ */
+static int rx_data_len(enum uart_rx_state state, const u8 *hdr)
+{
+	switch (state) {
+	case W4_DBG_HDR:
+	case W4_EVENT_HDR:
+	case W4_DEV_MGMT_HDR:
+		/* Device management events are similar to BT HCI Header */
+		return ((struct hci_event_hdr *)hdr)->plen;
+	case W4_ACL_HDR:
+		return le16_to_cpu(((struct hci_acl_hdr *)hdr)->dlen);
+	case W4_NFC_HDR:
+		/*
+		 * NFC Packet(s) have 1 extra byte for checksum.
+		 * This is not indicated by the byte length determined
+		 * from the received NFC Packet over HCI. So
+		 * length of received NFC packet should be updated
+		 * accordingly.
+		 */
+		return le16_to_cpu(((struct nfc_hci_hdr *)hdr)->plen) +
+			NFC_CHECKSUM_DATA_LEN;
+	case W4_ANT_CMD_HDR:
+		return ((struct ant_cmd_hci_hdr *)hdr)->plen;
+	case W4_ANT_DAT_HDR:
+		return ((struct ant_dat_hci_hdr *)hdr)->plen;
+	case W4_FM_RADIO_HDR:
+		return ((union fm_leg_evt_or_irq *)hdr)->param_length;
+	case W4_GNSS_HDR:
+		return le16_to_cpu(((struct gnss_hci_hdr *)hdr)->plen);
+	default:
+		return -EINVAL;
+	}
+}
+
 /**
  * check_data_len() - Check number of bytes to receive.
  * @len:	Number of bytes left to receive.
+ * @rx_queue:	Complete packets to hand to CG2900 Core.
  */
-static void check_data_len(struct uart_info *uart_info, int len)
+static void check_data_len(struct uart_info *uart_info, int len,
+			   struct sk_buff_head *rx_queue)
 {
 	/* First get number of bytes left in the sk_buffer */
 	register int room = skb_tailroom(uart_info->rx_skb);
 
 	if (!len) {
 		/* No data left to receive. Transmit to CG2900 Core */
-		send_skb_to_core(uart_info, uart_info->rx_skb);
+		__skb_queue_tail(rx_queue, uart_info->rx_skb);
 	} else if (len > room) {
 		dev_err(MAIN_DEV, "Data length is too large (%d > %d)\n",
 			len, room);
@@ -1788,7 +1831,9 @@ static void work_restart_sleep(struct work_struct *work)
  * @count:	Number of bytes received
  *
  * The cg2900_hu_receive() function handles received UART data and puts it
- * together to one complete packet.
+ * together to one complete packet. A DMA burst usually holds several
+ * packets: those that are whole in it are copied straight into an skb of
+ * their size, and all are handed to CG2900 Core once the burst is parsed.
  *
  * Returns:
  *   Number of bytes not handled, i.e. 0 = no error.
@@ -1799,17 +1844,13 @@ static int cg2900_hu_receive(struct hci_uart *hu,
 	const u8 *r_ptr;
 	u8 *w_ptr;
 	int len;
-	struct hci_event_hdr	*evt;
-	struct hci_acl_hdr	*acl;
-	struct nfc_hci_hdr	*nfc;
-	struct ant_cmd_hci_hdr	*ant_cmd;
-	struct ant_dat_hci_hdr	*ant_dat;
-	union fm_leg_evt_or_irq	*fm;
-	struct gnss_hci_hdr	*gnss;
 	struct uart_info *uart_info = dev_get_drvdata(hu->proto->dev);
+	struct sk_buff_head rx_queue;
+	struct sk_buff *skb;
 	u8 *tmp;
 
 	r_ptr = (const u8 *)data;
+	__skb_queue_head_init(&rx_queue);
 
 ;
 	spin_lock_bh(&(uart_info->transmission_lock));
@@ -1852,86 +1893,29 @@ static int cg2900_hu_receive(struct hci_uart *hu,
 
 		/* Handle the different states */
 		tmp = uart_info->rx_skb->data + CG2900_SKB_RESERVE;
-		switch (uart_info->rx_state) {
-		case W4_DATA:
+		if (uart_info->rx_state == W4_DATA) {
 			/*
 			 * Whole data packet has been received.
 			 * Transmit it to CG2900 Core.
 			 */
-			send_skb_to_core(uart_info, uart_info->rx_skb);
+			__skb_queue_tail(&rx_queue, uart_info->rx_skb);
 
 			uart_info->rx_state = W4_PACKET_TYPE;
 			uart_info->rx_skb = NULL;
 			continue;
+		}
 
-		case W4_DBG_HDR:
-		case W4_EVENT_HDR:
-			evt = (struct hci_event_hdr *)tmp;
-			check_data_len(uart_info, evt->plen);
-			/* Header read. Continue with next bytes */
-			continue;
-
-		case W4_ACL_HDR:
-			acl = (struct hci_acl_hdr *)tmp;
-			check_data_len(uart_info, le16_to_cpu(acl->dlen));
-			/* Header read. Continue with next bytes */
-			continue;
-
-		case W4_NFC_HDR:
-			nfc = (struct nfc_hci_hdr *)tmp;
-			/*
-			 * NFC Packet(s) have 1 extra byte for checksum.
-			 * This is not indicated by the byte length determined
-			 * from the received NFC Packet over HCI. So
-			 * length of received NFC packet should be updated
-			 * accordingly.
-			 */
-			check_data_len(uart_info, le16_to_cpu(nfc->plen) +
-					NFC_CHECKSUM_DATA_LEN);
-			/* Header read. Continue with next bytes */
-			continue;
-
-		case W4_ANT_CMD_HDR:
-			ant_cmd = (struct ant_cmd_hci_hdr *)tmp;
-			check_data_len(uart_info, ant_cmd->plen);
-			/* Header read. Continue with next bytes */
-			continue;
-
-		case W4_ANT_DAT_HDR:
-			ant_dat = (struct ant_dat_hci_hdr *)tmp;
-			check_data_len(uart_info, ant_dat->plen);
-			/* Header read. Continue with next bytes */
-			continue;
-
-		case W4_FM_RADIO_HDR:
-			fm = (union fm_leg_evt_or_irq *)tmp;
-			check_data_len(uart_info, fm->param_length);
-			/* Header read. Continue with next bytes */
-			continue;
-
-		case W4_GNSS_HDR:
-			gnss = (struct gnss_hci_hdr *)tmp;
-			check_data_len(uart_info, le16_to_cpu(gnss->plen));
-			/* Header read. Continue with next bytes */
-			continue;
-
-		case W4_DEV_MGMT_HDR:
-			/*
-			 * Device management events are similar to
-			 * BT HCI Header
-			 */
-			evt = (struct hci_event_hdr *)tmp;
-			check_data_len(uart_info, evt->plen);
+		len = rx_data_len(uart_info->rx_state, tmp);
+		if (len >= 0) {
+			check_data_len(uart_info, len, &rx_queue);
 			/* Header read. Continue with next bytes */
 			continue;
-
-		default:
-			dev_err(MAIN_DEV,
-				"Bad state indicating memory overwrite "
-				"(0x%X)\n", (u8)(uart_info->rx_state));
-			break;
 		}
 
+		dev_err(MAIN_DEV,
+			"Bad state indicating memory overwrite "
+			"(0x%X)\n", (u8)(uart_info->rx_state));
+
 check_h4_header:
 		/* Check which H:4 packet this is and update RX states */
 		if (*r_ptr == HCI_BT_EVT_H4_CHANNEL) {
@@ -1969,6 +1953,25 @@ check_h4_header:
 			continue;
 		}
 
+		/* A packet whole in the burst is taken in one copy */
+		if (count > HCI_H4_SIZE + uart_info->rx_count) {
+			len = HCI_H4_SIZE + uart_info->rx_count +
+				rx_data_len(uart_info->rx_state,
+					    r_ptr + HCI_H4_SIZE);
+			if (count >= len && len <= RX_SKB_MAX_SIZE) {
+				skb = alloc_rx_skb(len, GFP_ATOMIC);
+				if (skb) {
+					memcpy(skb_put(skb, len), r_ptr, len);
+					__skb_queue_tail(&rx_queue, skb);
+					uart_info->rx_state = W4_PACKET_TYPE;
+					uart_info->rx_count = 0;
+					r_ptr += len;
+					count -= len;
+					continue;
+				}
+			}
+		}
+
 		/*
 		 * Allocate packet. We do not yet know the size and therefore
 		 * allocate max size.
@@ -1984,8 +1987,8 @@ check_h4_header:
 			uart_info->rx_in_progress = false;
 			spin_unlock_bh(&(uart_info->transmission_lock));
 
-			spin_unlock_bh(&uart_info->rx_skb_lock);
-			return 0;
+			count = 0;
+			goto out;
 		}
 
 		/* Write the H:4 header first in the sk_buffer */
@@ -1999,7 +2002,12 @@ check_h4_header:
 
 	(void)queue_work(uart_info->wq, &uart_info->restart_sleep_work.work);
 
+out:
 	spin_unlock_bh(&uart_info->rx_skb_lock);
+
+	while ((skb = __skb_dequeue(&rx_queue)))
+		send_skb_to_core(uart_info, skb);
+
 	return count;
 }
 
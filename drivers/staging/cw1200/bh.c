@@ -22,6 +22,7 @@
 #include "hwio.h"
 #include "wsm.h"
 #include "sbus.h"
+#include "debug.h"
 
 #if defined(CONFIG_CW1200_BH_DEBUG)
 //#define bh_printk(...) printk(__VA_ARGS__)
@@ -39,6 +40,10 @@
 #define PIGGYBACK_CTRL_REG	(2)
 #define EFFECTIVE_BUF_SIZE	(MAX_SZ_RD_WR_BUFFERS - PIGGYBACK_CTRL_REG)
 
+/* Frames read back to back, following the piggybacked control register,
+ * before the TX path gets its turn. */
+#define RX_BURST_MAX		(8)
+
 typedef int (*cw1200_wsm_handler)(struct cw1200_common *priv,
 	u8 *data, size_t size);
 
@@ -132,30 +137,38 @@ static struct sk_buff *cw1200_get_skb(struct cw1200_common *priv, size_t len)
 	struct sk_buff *skb;
 	size_t alloc_len = (len > SDIO_BLOCK_SIZE) ? len : SDIO_BLOCK_SIZE;
 
-	if (len > SDIO_BLOCK_SIZE || !priv->skb_cache) {
-		skb = dev_alloc_skb(alloc_len
-				+ WSM_TX_EXTRA_HEADROOM
-				+ 8  /* TKIP IV */
-				+ 12 /* TKIP ICV + MIC */
-				- 2  /* Piggyback */);
-		/* In AP mode RXed SKB can be looped back as a broadcast.
-		 * Here we reserve enough space for headers. */
+	if (len <= SDIO_BLOCK_SIZE) {
+		skb = __skb_dequeue(&priv->skb_pool);
+		if (skb) {
+			cw1200_debug_skb_recycled(priv, true);
+			return skb;
+		}
+		cw1200_debug_skb_recycled(priv, false);
+	}
+
+	skb = dev_alloc_skb(alloc_len
+			+ WSM_TX_EXTRA_HEADROOM
+			+ 8  /* TKIP IV */
+			+ 12 /* TKIP ICV + MIC */
+			- 2  /* Piggyback */);
+	/* In AP mode RXed SKB can be looped back as a broadcast.
+	 * Here we reserve enough space for headers. */
+	if (skb)
 		skb_reserve(skb, WSM_TX_EXTRA_HEADROOM
 				+ 8 /* TKIP IV */
 				- WSM_RX_EXTRA_HEADROOM);
-	} else {
-		skb = priv->skb_cache;
-		priv->skb_cache = NULL;
-	}
 	return skb;
 }
 
+/* RX buffers not passed up are kept for the next frames, up to the number
+ * of device buffers. The pool is only used by the BH thread. */
 static void cw1200_put_skb(struct cw1200_common *priv, struct sk_buff *skb)
 {
-	if (priv->skb_cache)
+	if (skb_queue_len(&priv->skb_pool) >=
+			max_t(int, priv->wsm_caps.numInpChBufs, 1))
 		dev_kfree_skb(skb);
 	else
-		priv->skb_cache = skb;
+		__skb_queue_tail(&priv->skb_pool, skb);
 }
 
 static int cw1200_bh_read_ctrl_reg(struct cw1200_common *priv,
@@ -230,6 +243,8 @@ static int cw1200_bh(void *arg)
 	u16 ctrl_reg = 0;
 	int tx_allowed;
 	int pending_tx = 0;
+	int tx_burst, burst;
+	int rx_burst = 0;
 	long status;
 
 	for (;;) {
@@ -357,9 +372,20 @@ rx:
 			}
 
 			read_len = 0;
+			++rx_burst;
+
+			/* Next frame is already announced: read it at once
+			 * instead of going through the TX path in between. */
+			if ((ctrl_reg & ST90TDS_CONT_NEXT_LEN_MASK) &&
+					rx_burst < RX_BURST_MAX)
+				goto rx;
 		}
 
 tx:
+		if (rx_burst > 1)
+			cw1200_debug_rx_burst(priv, rx_burst);
+		rx_burst = 0;
+
 		/* HACK! One buffer is reserved for control path */
 		BUG_ON(priv->hw_bufs_used > priv->wsm_caps.numInpChBufs);
 		tx_allowed =
@@ -383,8 +409,10 @@ tx:
 				}
 			}
 
+			tx_burst = 0;
+tx_next:
 			wsm_alloc_tx_buffer(priv);
-			ret = wsm_get_tx(priv, &data, &tx_len);
+			ret = wsm_get_tx(priv, &data, &tx_len, &burst);
 			if (ret <= 0) {
 				wsm_release_tx_buffer(priv, 1);
 				if (WARN_ON(ret < 0))
@@ -432,7 +460,18 @@ tx:
 
 				wsm_txed(priv, data);
 				priv->wsm_tx_seq = (priv->wsm_tx_seq + 1) & 7;
+				++tx_burst;
+
+				/* More frames are queued and the device has
+				 * buffers for them: send them in a row, without
+				 * waiting for the thread to be woken up again
+				 * and reading the control register. */
+				if (burst > 1 && priv->hw_bufs_used <
+						priv->wsm_caps.numInpChBufs)
+					goto tx_next;
 			}
+			if (tx_burst > 1)
+				cw1200_debug_tx_burst(priv, tx_burst);
 		}
 
 		/* HACK!!! Device tends not to send interrupt
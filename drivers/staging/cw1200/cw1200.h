@@ -91,6 +91,10 @@ struct cw1200_common {
 	struct wsm_set_bss_params	bss_params;
 	struct cw1200_ht_info		ht_info;
 	struct wsm_set_pm		powersave_mode;
+	struct delayed_work		ps_policy_work;
+	atomic_t			ps_frames;
+	unsigned			ps_rate;
+	bool				ps_fast;
 	int				cqm_rssi_thold;
 	unsigned			cqm_rssi_hyst;
 	unsigned			cqm_tx_failure_thold;
@@ -123,7 +127,7 @@ struct cw1200_common {
 	int				wsm_tx_seq;	/* byte */
 	int				hw_bufs_used;
 	wait_queue_head_t		hw_bufs_used_wq;
-	struct sk_buff			*skb_cache;
+	struct sk_buff_head		skb_pool;
 	bool				powersave_enabled;
 	bool				device_can_sleep;
 
@@ -70,6 +70,7 @@ static void cw1200_queue_status_show(struct seq_file *seq,
 	seq_printf(seq, "Queue       %d:\n", q->queue_id);
 	seq_printf(seq, "  capacity: %d\n", q->capacity);
 	seq_printf(seq, "  queued:   %d\n", q->num_queued);
+	seq_printf(seq, "  max:      %d\n", q->max_queued);
 	seq_printf(seq, "  pending:  %d\n", q->num_pending);
 	seq_printf(seq, "  sent:     %d\n", q->num_sent);
 	seq_printf(seq, "  locked:   %s\n", q->tx_locked_cnt ? "yes" : "no");
@@ -168,6 +169,8 @@ static int cw1200_status_show(struct seq_file *seq, void *v)
 			priv->bss_params.operationalRateSet);
 		seq_printf(seq, "Powersave:  %s\n",
 			priv->powersave_mode.pmMode ? "off" : "on");
+		seq_printf(seq, "Fast PSM:   %s (%u frames/s)\n",
+			priv->ps_fast ? "on" : "off", priv->ps_rate);
 	}
 	seq_printf(seq, "HT:         %s\n",
 		cw1200_is_ht(&priv->ht_info) ? "on" : "off");
@@ -249,14 +252,22 @@ static int cw1200_status_show(struct seq_file *seq, void *v)
 		d->tx_agg);
 	seq_printf(seq, "MULTI TXed: %d (%d)\n",
 		d->tx_multi, d->tx_multi_frames);
+	seq_printf(seq, "TX burst:   %d (%d)\n",
+		d->tx_burst, d->tx_burst_frames);
 	seq_printf(seq, "RXed:       %d\n",
 		d->rx);
 	seq_printf(seq, "AGG RXed:   %d\n",
 		d->rx_agg);
+	seq_printf(seq, "RX burst:   %d (%d)\n",
+		d->rx_burst, d->rx_burst_frames);
 	seq_printf(seq, "TX miss:    %d\n",
 		d->tx_cache_miss);
 	seq_printf(seq, "TX copy:    %d\n",
 		d->tx_copy);
+	seq_printf(seq, "RX recycle: %d/%d (%d pooled)\n",
+		d->skb_recycle_hit,
+		d->skb_recycle_hit + d->skb_recycle_miss,
+		skb_queue_len(&priv->skb_pool));
 	seq_printf(seq, "Scan:       %s\n",
 		atomic_read(&priv->scan.in_progress) ? "active" : "idle");
 	seq_printf(seq, "Led state:  0x%.2X\n",
@@ -13,8 +13,14 @@ struct cw1200_debug_priv {
 	int rx_agg;
 	int tx_multi;
 	int tx_multi_frames;
+	int tx_burst;
+	int tx_burst_frames;
+	int rx_burst;
+	int rx_burst_frames;
 	int tx_cache_miss;
 	int tx_copy;
+	int skb_recycle_hit;
+	int skb_recycle_miss;
 };
 
 int cw1200_debug_init(struct cw1200_common *priv);
@@ -37,6 +43,20 @@ static inline void cw1200_debug_txed_multi(struct cw1200_common *priv,
 	priv->debug->tx_multi_frames += count;
 }
 
+static inline void cw1200_debug_tx_burst(struct cw1200_common *priv,
+					  int count)
+{
+	++priv->debug->tx_burst;
+	priv->debug->tx_burst_frames += count;
+}
+
+static inline void cw1200_debug_rx_burst(struct cw1200_common *priv,
+					  int count)
+{
+	++priv->debug->rx_burst;
+	priv->debug->rx_burst_frames += count;
+}
+
 static inline void cw1200_debug_rxed(struct cw1200_common *priv)
 {
 	++priv->debug->rx;
@@ -57,6 +77,15 @@ static inline void cw1200_debug_tx_copy(struct cw1200_common *priv)
 	++priv->debug->tx_copy;
 }
 
+static inline void cw1200_debug_skb_recycled(struct cw1200_common *priv,
+					     bool hit)
+{
+	if (hit)
+		++priv->debug->skb_recycle_hit;
+	else
+		++priv->debug->skb_recycle_miss;
+}
+
 #else /* CONFIG_CW1200_DEBUGFS */
 
 static inline int cw1200_debug_init(struct cw1200_common *priv)
@@ -81,6 +110,16 @@ static inline void cw1200_debug_txed_multi(struct cw1200_common *priv,
 {
 }
 
+static inline void cw1200_debug_tx_burst(struct cw1200_common *priv,
+					  int count)
+{
+}
+
+static inline void cw1200_debug_rx_burst(struct cw1200_common *priv,
+					  int count)
+{
+}
+
 static inline void cw1200_debug_rxed(struct cw1200_common *priv)
 {
 }
@@ -97,6 +136,11 @@ static inline void cw1200_debug_tx_copy(struct cw1200_common *priv)
 {
 }
 
+static inline void cw1200_debug_skb_recycled(struct cw1200_common *priv,
+					     bool hit)
+{
+}
+
 #endif /* CONFIG_CW1200_DEBUGFS */
 
 #endif /* CW1200_DEBUG_H_INCLUDED */
@@ -313,6 +313,7 @@ struct ieee80211_hw *cw1200_init_common(size_t priv_data_len)
 	INIT_DELAYED_WORK(&priv->keep_alive_work, cw1200_keep_alive_work);
 #endif /* CONFIG_CW1200_FIRMWARE_DOES_NOT_SUPPORT_KEEPALIVE */
 	INIT_WORK(&priv->tx_failure_work, cw1200_tx_failure_work);
+	INIT_DELAYED_WORK(&priv->ps_policy_work, cw1200_ps_policy_work);
 	INIT_WORK(&priv->set_tim_work, cw1200_set_tim_work);
 	INIT_WORK(&priv->multicast_start_work, cw1200_multicast_start_work);
 	INIT_WORK(&priv->multicast_stop_work, cw1200_multicast_stop_work);
@@ -334,6 +335,7 @@ struct ieee80211_hw *cw1200_init_common(size_t priv_data_len)
 		}
 	}
 
+	__skb_queue_head_init(&priv->skb_pool);
 	init_waitqueue_head(&priv->channel_switch_done);
 	init_waitqueue_head(&priv->wsm_cmd_wq);
 	init_waitqueue_head(&priv->wsm_startup_done);
@@ -405,10 +407,7 @@ void cw1200_unregister_common(struct ieee80211_hw *dev)
 	destroy_workqueue(priv->workqueue);
 	priv->workqueue = NULL;
 
-	if (priv->skb_cache) {
-		dev_kfree_skb(priv->skb_cache);
-		priv->skb_cache = NULL;
-	}
+	__skb_queue_purge(&priv->skb_pool);
 
 	for (i = 0; i < 4; ++i)
 		cw1200_queue_deinit(&priv->tx_queue[i]);
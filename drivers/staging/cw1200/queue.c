@@ -184,17 +184,22 @@ size_t cw1200_queue_get_num_queued(struct cw1200_queue *queue,
 	if (!link_id_map)
 		return 0;
 
-	spin_lock_bh(&queue->lock);
-	if (likely(link_id_map == (u32) -1))
-		ret = queue->num_queued - queue->num_pending;
-	else {
+	/* No lock: the BH thread, the only one taking frames off the queue,
+	 * asks before cw1200_queue_get(). Meanwhile others only add frames or
+	 * give pending ones back, so the count may be low, but it is never
+	 * negative as num_pending is read last. Only a concurrent
+	 * cw1200_queue_clear() makes cw1200_queue_get() find nothing. */
+	if (likely(link_id_map == (u32) -1)) {
+		ret = ACCESS_ONCE(queue->num_queued);
+		smp_rmb();
+		ret -= ACCESS_ONCE(queue->num_pending);
+	} else {
 		ret = 0;
 		for (i = 0, bit = 1; i < map_capacity; ++i, bit <<= 1) {
 			if (link_id_map & bit)
-				ret += queue->link_map_cache[i];
+				ret += ACCESS_ONCE(queue->link_map_cache[i]);
 		}
 	}
-	spin_unlock_bh(&queue->lock);
 	return ret;
 }
 
@@ -229,6 +234,8 @@ int cw1200_queue_put(struct cw1200_queue *queue, struct cw1200_common *priv,
 
 		++queue->num_queued;
 		++queue->link_map_cache[link_id];
+		if (queue->num_queued > queue->max_queued)
+			queue->max_queued = queue->num_queued;
 
 		spin_lock_bh(&stats->lock);
 		++stats->num_queued;
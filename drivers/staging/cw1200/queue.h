@@ -25,6 +25,7 @@ struct cw1200_queue {
 	struct cw1200_queue_stats *stats;
 	size_t			capacity;
 	size_t			num_queued;
+	size_t			max_queued;
 	size_t			num_pending;
 	size_t			num_sent;
 	struct cw1200_queue_item *pool;
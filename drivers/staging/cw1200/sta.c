@@ -28,6 +28,13 @@
 //
 ;
 static int __cw1200_flush(struct cw1200_common *priv, bool drop);
+static void cw1200_ps_policy_apply(struct cw1200_common *priv);
+
+/* Powersave policy: traffic is sampled every period, in frames per period.
+ * Fast PSM is entered above the enter rate and left below the leave rate. */
+#define CW1200_PS_POLICY_PERIOD		(HZ)
+#define CW1200_PS_FAST_ENTER_RATE	(10)
+#define CW1200_PS_FAST_LEAVE_RATE	(2)
 
 static inline void __cw1200_free_event_queue(struct list_head *list)
 {
@@ -112,6 +119,7 @@ void cw1200_stop(struct ieee80211_hw *dev)
 #if defined(CONFIG_CW1200_FIRMWARE_DOES_NOT_SUPPORT_KEEPALIVE)
 	cancel_delayed_work_sync(&priv->keep_alive_work);
 #endif /* CONFIG_CW1200_FIRMWARE_DOES_NOT_SUPPORT_KEEPALIVE */
+	cancel_delayed_work_sync(&priv->ps_policy_work);
 
 	mutex_lock(&priv->conf_mutex);
 	switch (priv->join_status) {
@@ -285,9 +293,13 @@ int cw1200_config(struct ieee80211_hw *dev, u32 changed)
 	}
 
 	if (changed & IEEE80211_CONF_CHANGE_PS) {
-		priv->powersave_mode.pmMode =
-				(conf->flags & IEEE80211_CONF_PS) ?
-				WSM_PSM_PS : WSM_PSM_ACTIVE;
+		if (conf->flags & IEEE80211_CONF_PS) {
+			cw1200_ps_policy_apply(priv);
+			queue_delayed_work(priv->workqueue,
+				&priv->ps_policy_work, CW1200_PS_POLICY_PERIOD);
+		} else {
+			priv->powersave_mode.pmMode = WSM_PSM_ACTIVE;
+		}
 		if (priv->join_status == CW1200_JOIN_STATUS_STA)
 			WARN_ON(wsm_set_pm(priv, &priv->powersave_mode));
 	}
@@ -816,6 +828,55 @@ void cw1200_tx_failure_work(struct work_struct *work)
 #endif /* CONFIG_CW1200_USE_STE_EXTENSIONS */
 }
 
+/* With traffic going on, fast PSM keeps the device awake for an idle period
+ * after each frame instead of polling every buffered frame with PS-Poll.
+ * The busier the link, the shorter the idle period needed. */
+static void cw1200_ps_policy_apply(struct cw1200_common *priv)
+{
+	priv->powersave_mode.pmMode = WSM_PSM_PS;
+	priv->powersave_mode.fastPsmIdlePeriod = 0;
+	if (priv->ps_fast) {
+		priv->powersave_mode.pmMode |= WSM_PM_F_FAST_PSM_ENABLE;
+		/* In units of 500us */
+		priv->powersave_mode.fastPsmIdlePeriod =
+			clamp(4000 / max(priv->ps_rate, 1U), 4U, 255U);
+	}
+}
+
+void cw1200_ps_policy_work(struct work_struct *work)
+{
+	struct cw1200_common *priv =
+		container_of(work, struct cw1200_common, ps_policy_work.work);
+	bool fast;
+
+	mutex_lock(&priv->conf_mutex);
+	if (!(priv->powersave_mode.pmMode & WSM_PSM_PS)) {
+		/* Powersave is off, stop sampling */
+		priv->ps_fast = false;
+		priv->ps_rate = 0;
+		mutex_unlock(&priv->conf_mutex);
+		return;
+	}
+
+	priv->ps_rate = (priv->ps_rate + atomic_xchg(&priv->ps_frames, 0)) / 2;
+	fast = priv->ps_fast;
+	if (!fast && priv->ps_rate >= CW1200_PS_FAST_ENTER_RATE)
+		fast = true;
+	else if (fast && priv->ps_rate <= CW1200_PS_FAST_LEAVE_RATE)
+		fast = false;
+
+	if (fast != priv->ps_fast) {
+		priv->ps_fast = fast;
+		cw1200_ps_policy_apply(priv);
+		if (priv->join_status == CW1200_JOIN_STATUS_STA)
+			WARN_ON(wsm_set_pm(priv, &priv->powersave_mode));
+	}
+
+	queue_delayed_work(priv->workqueue, &priv->ps_policy_work,
+			CW1200_PS_POLICY_PERIOD);
+	mutex_unlock(&priv->conf_mutex);
+}
+
 /* ******************************************************************** */
 /* Internal API								*/
 
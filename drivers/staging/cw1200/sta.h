@@ -58,6 +58,7 @@ void cw1200_bss_loss_work(struct work_struct *work);
 void cw1200_connection_loss_work(struct work_struct *work);
 void cw1200_keep_alive_work(struct work_struct *work);
 void cw1200_tx_failure_work(struct work_struct *work);
+void cw1200_ps_policy_work(struct work_struct *work);
 
 /* ******************************************************************** */
 /* Internal API								*/
@@ -597,6 +597,7 @@ void cw1200_tx_confirm_cb(struct cw1200_common *priv,
 #endif /* CONFIG_CW1200_FIRMWARE_DOES_NOT_SUPPORT_KEEPALIVE */
 			priv->cqm_tx_failure_count = 0;
 			++tx_count;
+			atomic_inc(&priv->ps_frames);
 			cw1200_debug_txed(priv);
 			if (arg->flags & WSM_TX_STATUS_AGGREGATION) {
 				/* Do not report aggregation to mac80211:
@@ -738,6 +739,8 @@ void cw1200_rx_cb(struct cw1200_common *priv,
 	}
 
 	cw1200_debug_rxed(priv);
+	if (ieee80211_is_data(frame_control))
+		atomic_inc(&priv->ps_frames);
 	if (arg->flags & WSM_RX_STATUS_AGGREGATE)
 		cw1200_debug_rxed_agg(priv);
 
@@ -1452,7 +1452,7 @@ found:
 }
 
 int wsm_get_tx(struct cw1200_common *priv, u8 **data,
-	       size_t *tx_len)
+	       size_t *tx_len, int *burst)
 {
 	struct wsm_tx *wsm = NULL;
 	struct ieee80211_tx_info *tx_info;
@@ -1476,6 +1476,7 @@ int wsm_get_tx(struct cw1200_common *priv, u8 **data,
 		BUG_ON(!priv->wsm_cmd.ptr);
 		*data = priv->wsm_cmd.ptr;
 		*tx_len = priv->wsm_cmd.len;
+		*burst = 1;
 		spin_unlock(&priv->wsm_cmd.lock);
 	} else {
 		for (;;) {
@@ -1486,6 +1487,10 @@ int wsm_get_tx(struct cw1200_common *priv, u8 **data,
 					&tx_allowed_mask, &more))
 				break;
 
+			/* Frames of the queue, this one included */
+			*burst = cw1200_queue_get_num_queued(queue,
+					tx_allowed_mask);
+
 			if (cw1200_queue_get(queue,
 					tx_allowed_mask,
 					&wsm, &tx_info))
@@ -1500,7 +1500,8 @@ struct wsm_cmd {
 /* ******************************************************************** */
 /* WSM TX buffer access							*/
 
-int wsm_get_tx(struct cw1200_common *priv, u8 ** data, size_t * tx_len);
+int wsm_get_tx(struct cw1200_common *priv, u8 **data,
+	       size_t *tx_len, int *burst);
 void wsm_txed(struct cw1200_common *priv, u8 * data);
 
 /* ******************************************************************** */
@@ -20,6 +20,7 @@
 #include <linux/vmalloc.h>
 #include <linux/mutex.h>
 #include <linux/workqueue.h>
+#include <linux/hwmem.h>
 #include <linux/mfd/dbx500-prcmu.h>
 #include <linux/mmio.h>
 #include <linux/ratelimit.h>
@@ -167,6 +168,17 @@ struct mmio_info {
 	struct delayed_work trace_work;
 	int trace_allowed;
 	struct mutex lock;
+	/* capture buffers, under lock */
+	struct list_head capture_bufs;
+	unsigned int next_buf_id;
+};
+
+struct mmio_capture_buf {
+	struct list_head list;
+	struct file *owner;
+	unsigned int id;
+	struct hwmem_alloc *alloc;
+	size_t size;
 };
 
 /* Samsung+ */
@@ -1488,6 +1500,126 @@ out:
 	return err;
 }
 
+/*
+ * Capture buffers stay pinned from registration on, so that the ISP can be
+ * given their address once. Frames then go from the ISP to B2R2 and compdev,
+ * which take the same buffers by hwmem name or dma-buf fd, without being
+ * mapped or copied. hwmem only does cache maintenance when the CPU domain
+ * has been entered through MMIO_CAM_SYNC_BUF.
+ */
+static struct mmio_capture_buf *mmio_find_buf(struct mmio_info *info,
+		unsigned int id)
+{
+	struct mmio_capture_buf *buf;
+
+	list_for_each_entry(buf, &info->capture_bufs, list)
+		if (buf->id == id)
+			return buf;
+	return NULL;
+}
+
+static int mmio_register_buf(struct mmio_info *info, struct file *filp,
+		struct capture_buf_t *arg)
+{
+	struct mmio_capture_buf *buf;
+	struct hwmem_mem_chunk chunk;
+	size_t nr_chunks = 1;
+	int err;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	if (arg->is_dma_buf)
+		buf->alloc = hwmem_resolve_by_dma_buf_fd(arg->handle);
+	else
+		buf->alloc = hwmem_resolve_by_name(arg->handle);
+	if (IS_ERR(buf->alloc)) {
+		err = PTR_ERR(buf->alloc);
+		goto err_free;
+	}
+
+	/* The ISP needs physically contiguous buffers */
+	err = hwmem_pin(buf->alloc, &chunk, &nr_chunks);
+	if (err) {
+		dev_err(info->dev, "capture buffer not contiguous\n");
+		goto err_release;
+	}
+	hwmem_get_info(buf->alloc, &buf->size, NULL, NULL);
+
+	buf->owner = filp;
+	mutex_lock(&info->lock);
+	buf->id = ++info->next_buf_id;
+	list_add_tail(&buf->list, &info->capture_bufs);
+	mutex_unlock(&info->lock);
+
+	arg->id = buf->id;
+	arg->phys_addr = chunk.paddr;
+	arg->size = buf->size;
+	return 0;
+
+err_release:
+	hwmem_release(buf->alloc);
+err_free:
+	kfree(buf);
+	return err;
+}
+
+static void mmio_free_buf(struct mmio_capture_buf *buf)
+{
+	list_del(&buf->list);
+	hwmem_unpin(buf->alloc);
+	hwmem_release(buf->alloc);
+	kfree(buf);
+}
+
+static int mmio_unregister_buf(struct mmio_info *info,
+		struct capture_buf_t *arg)
+{
+	struct mmio_capture_buf *buf;
+	int err = 0;
+
+	mutex_lock(&info->lock);
+	buf = mmio_find_buf(info, arg->id);
+	if (buf)
+		mmio_free_buf(buf);
+	else
+		err = -EINVAL;
+	mutex_unlock(&info->lock);
+	return err;
+}
+
+static int mmio_sync_buf(struct mmio_info *info, struct capture_buf_t *arg)
+{
+	struct mmio_capture_buf *buf;
+	struct hwmem_region region;
+	int err;
+
+	mutex_lock(&info->lock);
+	buf = mmio_find_buf(info, arg->id);
+	if (!buf) {
+		err = -EINVAL;
+		goto out;
+	}
+
+	region.offset = 0;
+	region.count = 1;
+	region.start = 0;
+	region.end = buf->size;
+	region.size = buf->size;
+
+	if (arg->cpu_access)
+		err = hwmem_set_domain(buf->alloc, arg->cpu_access,
+				HWMEM_DOMAIN_CPU, &region);
+	else
+		err = hwmem_set_domain(buf->alloc,
+				HWMEM_ACCESS_READ | HWMEM_ACCESS_WRITE,
+				HWMEM_DOMAIN_SYNC, &region);
+out:
+	mutex_unlock(&info->lock);
+	return err;
+}
+
 static int mmio_set_trace_buffer(struct mmio_info *info,
 		struct trace_buf_t *buf)
 {
@@ -1871,6 +2003,42 @@ static long mmio_ioctl(struct file *filp, u32 cmd,
 
 			ret = mmio_set_trace_buffer(info, &data.mmio_arg.trace_buf);
 			break;
+		case MMIO_CAM_REGISTER_BUF:
+		case MMIO_CAM_UNREGISTER_BUF:
+		case MMIO_CAM_SYNC_BUF:
+			dev_dbg(info->dev, "mmio_ioctl: capture buffer 0x%X\n", cmd);
+			no_of_bytes = sizeof(struct mmio_input_output_t);
+			memset(&data, 0, sizeof(struct mmio_input_output_t));
+
+			if (copy_from_user
+					(&data, (struct mmio_input_output_t *)arg, no_of_bytes)) {
+				dev_err(info->dev, "Copy from userspace failed\n");
+				ret = -EFAULT;
+				break;
+			}
+
+			if (cmd == MMIO_CAM_UNREGISTER_BUF) {
+				ret = mmio_unregister_buf(info,
+						&data.mmio_arg.capture_buf);
+				break;
+			}
+			if (cmd == MMIO_CAM_SYNC_BUF) {
+				ret = mmio_sync_buf(info, &data.mmio_arg.capture_buf);
+				break;
+			}
+
+			ret = mmio_register_buf(info, filp, &data.mmio_arg.capture_buf);
+			if (ret)
+				break;
+
+			if (copy_to_user((struct mmio_input_output_t *)arg,
+						&data, no_of_bytes)) {
+				dev_err(info->dev, "Copy to userspace failed\n");
+				data.mmio_arg.capture_buf.cpu_access = 0;
+				mmio_unregister_buf(info, &data.mmio_arg.capture_buf);
+				ret = -EFAULT;
+			}
+			break;
 
 			/* Samsung+ */
 		case MMIO_CAM_FLASH_SET_MODE:
@@ -1994,10 +2162,14 @@ static long mmio_ioctl(struct file *filp, u32 cmd,
 static int mmio_release(struct inode *node, struct file *filp)
 {
 	struct mmio_info *info = filp->private_data;
+	struct mmio_capture_buf *buf, *tmp;
 	BUG_ON(info == NULL);
 ;
 
 	mutex_lock(&info->lock);
+	list_for_each_entry_safe(buf, tmp, &info->capture_bufs, list)
+		if (buf->owner == filp)
+			mmio_free_buf(buf);
 	if (info->trace_buffer) {
 		flush_delayed_work_sync(&info->trace_work);
 		iounmap(info->trace_buffer);
@@ -2529,6 +2701,7 @@ static int __devinit mmio_probe(struct platform_device *pdev)
 	info->misc_dev.parent = pdev->dev.parent;
 
 	mutex_init(&info->lock);
+	INIT_LIST_HEAD(&info->capture_bufs);
 
 	info->xshutdown_enabled = 0;
 	info->xshutdown_is_active_high = 0;
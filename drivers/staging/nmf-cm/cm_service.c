@@ -22,6 +22,7 @@
 #include "cmld.h"
 #include "cm_service.h"
 #include "cm_dma.h"
+#include "cm_stream.h"
 
 /* Panic managment */
 static void service_tasklet_func(unsigned long);
@@ -102,6 +103,7 @@ static void service_tasklet_func(unsigned long unused)
 				 */
 				if (osalEnv.mpc[i].coreId == SIA_CORE_ID)
 					cmdma_stop_dma();
+				cm_stream_panic(osalEnv.mpc[i].coreId);
 
 				/*
 				 * wake up all trace readers to let them
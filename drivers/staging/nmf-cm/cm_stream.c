@@ -0,0 +1,380 @@
+/*
+ * License terms: GNU General Public License (GPL), version 2.
+ */
+
+/** \file cm_stream.c
+ *
+ * Kernel pass-through streams to a DSP decoder component, see cm_stream.h
+ *
+ */
+
+#include <linux/module.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+
+#include <cm/engine/api/cm_engine.h>
+
+#include "osal-kernel.h"
+#include "cm_dma.h"
+#include "cm_stream.h"
+
+/* Slots start on a DMA burst boundary */
+#define CM_STREAM_SLOT_ALIGN	32
+
+struct cm_stream {
+	struct list_head entry;
+	struct cm_stream_config cfg;
+	t_nmf_core_id coreId;
+	t_cm_instance_handle component;
+	t_cm_bf_host2mpc_handle host2mpcId;
+	t_cm_bf_mpc2host_handle mpc2hostId;
+	t_skelwrapper skel;		/**< routes notifications to us */
+	t_cm_memory_handle ring_handle;
+	t_cm_memory_handle pcm_handle;
+	struct cm_stream_ring *ring;	/**< kernel mapping of the ring */
+	u8 *slot_base;
+	unsigned int wr;		/**< next slot to write */
+	struct mutex lock;		/**< serializes writers and events */
+	wait_queue_head_t waitq;
+	atomic_t ack_pending;		/**< notifications to acknowledge */
+	struct work_struct ack_work;
+	bool dead;
+};
+
+static LIST_HEAD(stream_list);
+static DEFINE_SPINLOCK(stream_list_lock);
+
+static unsigned int cm_stream_rd(struct cm_stream *s)
+{
+	return ACCESS_ONCE(s->ring->rd);
+}
+
+static bool cm_stream_has_space(struct cm_stream *s)
+{
+	return s->dead || (s->wr + 1) % s->cfg.slots != cm_stream_rd(s);
+}
+
+static bool cm_stream_empty(struct cm_stream *s)
+{
+	return s->dead || s->wr == cm_stream_rd(s);
+}
+
+/* Called with s->lock held */
+static int cm_stream_push(struct cm_stream *s, t_uint32 methodIndex,
+			  const u32 *args, unsigned int nr_args)
+{
+	t_event_params_handle event;
+	unsigned int i;
+
+	event = CM_ENGINE_AllocEvent(s->host2mpcId);
+	if (event == NULL)
+		return -EBUSY;
+
+	for (i = 0; i < nr_args; i++)
+		event[i] = args[i];
+
+	return CM_ENGINE_PushEvent(s->host2mpcId, event, methodIndex) == CM_OK ?
+		0 : -EIO;
+}
+
+/*
+ * Notifications come in tasklet context, where the CM engine locks can't
+ * be taken: they are acknowledged from a work.
+ */
+static void cm_stream_notify(void *data, t_uint32 methodIndex,
+			     t_event_params_handle ptr)
+{
+	struct cm_stream *s = data;
+
+	if (methodIndex == 1) {
+		pr_err("[CM] %s: stream error %u\n", __func__, ptr[0]);
+		s->dead = true;
+	}
+	wake_up(&s->waitq);
+
+	atomic_inc(&s->ack_pending);
+	schedule_work(&s->ack_work);
+}
+
+static void cm_stream_ack_work(struct work_struct *work)
+{
+	struct cm_stream *s = container_of(work, struct cm_stream, ack_work);
+	int n = atomic_xchg(&s->ack_pending, 0);
+
+	while (n--)
+		CM_ENGINE_AcknowledgeEvent(s->mpc2hostId);
+}
+
+static int cm_stream_alloc(struct cm_stream *s, unsigned int size,
+			   t_cm_memory_handle *handle,
+			   t_cm_system_address *sysAddr, t_uint32 *mpcAddr)
+{
+	t_cm_error err;
+
+	/* 16 bit words: two bytes of the host per word of the MPC */
+	err = CM_ENGINE_AllocMpcMemory(s->cfg.domain, s->cfg.client,
+				       CM_MM_MPC_SDRAM16, (size + 1) / 2,
+				       CM_MM_MPC_ALIGN_16WORDS, handle);
+	if (err != CM_OK)
+		return -ENOMEM;
+
+	if (CM_ENGINE_GetMpcMemorySystemAddress(*handle, sysAddr) != CM_OK ||
+	    CM_ENGINE_GetMpcMemoryMpcAddress(*handle, mpcAddr) != CM_OK) {
+		CM_ENGINE_FreeMpcMemory(*handle);
+		*handle = 0;
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+static void cm_stream_release(struct cm_stream *s)
+{
+	t_nmf_mpc2host_handle upLayerThis;
+
+	/* No more notifications once stopped, acknowledge the last ones */
+	if (s->component)
+		CM_ENGINE_StopComponent(s->component, s->cfg.client);
+	flush_work(&s->ack_work);
+
+	if (s->mpc2hostId)
+		CM_ENGINE_UnbindComponentToCMCore(s->component,
+						  s->cfg.notify_itf,
+						  &upLayerThis, s->cfg.client);
+	if (s->host2mpcId)
+		CM_ENGINE_UnbindComponentFromCMCore(s->host2mpcId);
+	if (s->component)
+		CM_ENGINE_DestroyComponent(s->component, s->cfg.client);
+	if (s->pcm_handle)
+		CM_ENGINE_FreeMpcMemory(s->pcm_handle);
+	if (s->ring_handle)
+		CM_ENGINE_FreeMpcMemory(s->ring_handle);
+	kfree(s);
+}
+
+/**
+ * cm_stream_open - instantiate a decoder and set up its buffers
+ * @cfg: description of the stream, see cm_stream.h
+ *
+ * Returns the stream or an ERR_PTR().
+ */
+struct cm_stream *cm_stream_open(const struct cm_stream_config *cfg)
+{
+	struct cm_stream *s;
+	t_cm_system_address ring_sys, pcm_sys;
+	t_uint32 ring_mpc, pcm_mpc;
+	unsigned int hdr, pcm_size;
+	u32 args[8];
+	int err;
+
+	if (cfg->slots < 2 || cfg->slots > CM_STREAM_MAX_SLOTS ||
+	    !cfg->slot_size || cfg->slot_size > 0xffff ||
+	    !cfg->pcm_segments || !cfg->pcm_segment_size ||
+	    cfg->pcm_segment_size > 0xffff)
+		return ERR_PTR(-EINVAL);
+
+	s = kzalloc(sizeof(*s), GFP_KERNEL);
+	if (s == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	s->cfg = *cfg;
+	mutex_init(&s->lock);
+	init_waitqueue_head(&s->waitq);
+	atomic_set(&s->ack_pending, 0);
+	INIT_WORK(&s->ack_work, cm_stream_ack_work);
+
+	/* The DMA relink area is the one of the SIA audio channel */
+	if (CM_ENGINE_GetDomainCoreId(cfg->domain, &s->coreId) != CM_OK ||
+	    s->coreId != SIA_CORE_ID) {
+		err = -EINVAL;
+		goto out;
+	}
+
+	hdr = ALIGN(sizeof(*s->ring) + cfg->slots * sizeof(u16),
+		    CM_STREAM_SLOT_ALIGN);
+	err = cm_stream_alloc(s, hdr + cfg->slots * ALIGN(cfg->slot_size,
+							  CM_STREAM_SLOT_ALIGN),
+			      &s->ring_handle, &ring_sys, &ring_mpc);
+	if (err)
+		goto out;
+	s->ring = (struct cm_stream_ring *)ring_sys.logical;
+	s->slot_base = (u8 *)s->ring + hdr;
+	memset(s->ring, 0, hdr);
+
+	pcm_size = cfg->pcm_segments * cfg->pcm_segment_size;
+	err = cm_stream_alloc(s, pcm_size, &s->pcm_handle, &pcm_sys,
+			      &pcm_mpc);
+	if (err)
+		goto out;
+
+	err = -ENODEV;
+	if (CM_ENGINE_InstantiateComponent(cfg->template_name, cfg->domain,
+					   cfg->client, NMF_SCHED_URGENT,
+					   NULL, NULL, &s->component) != CM_OK) {
+		s->component = 0;
+		goto out;
+	}
+
+	if (CM_ENGINE_BindComponentFromCMCore(s->component, cfg->itf, 4,
+					      CM_MM_MPC_SDRAM16,
+					      &s->host2mpcId, cfg->client,
+					      NULL) != CM_OK) {
+		s->host2mpcId = 0;
+		goto out;
+	}
+
+	s->skel.kernel_cb = cm_stream_notify;
+	s->skel.kernel_data = s;
+	if (CM_ENGINE_BindComponentToCMCore(s->component, cfg->notify_itf,
+					    CM_STREAM_MAX_SLOTS,
+					    (t_nmf_mpc2host_handle)&s->skel,
+					    NULL, &s->mpc2hostId,
+					    cfg->client) != CM_OK) {
+		s->mpc2hostId = 0;
+		goto out;
+	}
+	s->skel.mpc2hostId = s->mpc2hostId;
+
+	err = cmdma_setup_relink_area(pcm_sys.physical, cfg->pcm_per_addr,
+				      cfg->pcm_segments, cfg->pcm_segment_size,
+				      cfg->pcm_LOS, CMDMA_MEM_2_PER);
+	if (err)
+		goto out;
+
+	err = -ENODEV;
+	if (CM_ENGINE_StartComponent(s->component, cfg->client) != CM_OK)
+		goto out_dma;
+
+	args[0] = ring_mpc & 0xffff;
+	args[1] = ring_mpc >> 16;
+	args[2] = cfg->slots;
+	args[3] = cfg->slot_size;
+	args[4] = pcm_mpc & 0xffff;
+	args[5] = pcm_mpc >> 16;
+	args[6] = cfg->pcm_segments;
+	args[7] = cfg->pcm_segment_size;
+	mutex_lock(&s->lock);
+	err = cm_stream_push(s, 0, args, 8);
+	mutex_unlock(&s->lock);
+	if (err)
+		goto out_dma;
+
+	spin_lock_bh(&stream_list_lock);
+	list_add(&s->entry, &stream_list);
+	spin_unlock_bh(&stream_list_lock);
+
+	return s;
+
+out_dma:
+	cmdma_stop_dma();
+out:
+	cm_stream_release(s);
+	return ERR_PTR(err);
+}
+EXPORT_SYMBOL_GPL(cm_stream_open);
+
+/**
+ * cm_stream_write - queue one compressed frame
+ * @stream: the stream
+ * @buf: the frame, at most slot_size bytes
+ * @count: its length
+ * @nonblock: fail with -EAGAIN rather than wait for a free slot
+ */
+ssize_t cm_stream_write(struct cm_stream *s, const char __user *buf,
+			size_t count, bool nonblock)
+{
+	u32 wr;
+	int err;
+
+	if (!count || count > s->cfg.slot_size)
+		return -EINVAL;
+
+	if (mutex_lock_interruptible(&s->lock))
+		return -ERESTARTSYS;
+
+	while (!cm_stream_has_space(s)) {
+		mutex_unlock(&s->lock);
+		if (nonblock)
+			return -EAGAIN;
+		if (wait_event_interruptible(s->waitq, cm_stream_has_space(s)))
+			return -ERESTARTSYS;
+		if (mutex_lock_interruptible(&s->lock))
+			return -ERESTARTSYS;
+	}
+
+	err = -EIO;
+	if (s->dead)
+		goto out;
+
+	err = -EFAULT;
+	if (copy_from_user(s->slot_base + s->wr *
+			   ALIGN(s->cfg.slot_size, CM_STREAM_SLOT_ALIGN),
+			   buf, count))
+		goto out;
+	s->ring->len[s->wr] = count;
+
+	/* The frame must be in memory before the DSP sees the index */
+	wmb();
+	wr = (s->wr + 1) % s->cfg.slots;
+	s->ring->wr = wr;
+	s->wr = wr;
+
+	err = cm_stream_push(s, 1, &wr, 1);
+out:
+	mutex_unlock(&s->lock);
+	return err ? err : count;
+}
+EXPORT_SYMBOL_GPL(cm_stream_write);
+
+/**
+ * cm_stream_drain - wait for the decoder to consume all queued frames
+ */
+int cm_stream_drain(struct cm_stream *s)
+{
+	if (wait_event_interruptible(s->waitq, cm_stream_empty(s)))
+		return -ERESTARTSYS;
+
+	return s->dead ? -EIO : 0;
+}
+EXPORT_SYMBOL_GPL(cm_stream_drain);
+
+/**
+ * cm_stream_close - stop the decoder and the PCM DMA and free the stream
+ */
+void cm_stream_close(struct cm_stream *s)
+{
+	spin_lock_bh(&stream_list_lock);
+	list_del(&s->entry);
+	spin_unlock_bh(&stream_list_lock);
+
+	mutex_lock(&s->lock);
+	if (!s->dead)
+		cm_stream_push(s, 2, NULL, 0);
+	mutex_unlock(&s->lock);
+
+	cmdma_stop_dma();
+	cm_stream_release(s);
+}
+EXPORT_SYMBOL_GPL(cm_stream_close);
+
+/*
+ * Called from the service tasklet when an MPC panics: its streams can't go
+ * on, wake up their writers.
+ */
+void cm_stream_panic(t_nmf_core_id coreId)
+{
+	struct cm_stream *s;
+
+	spin_lock(&stream_list_lock);
+	list_for_each_entry(s, &stream_list, entry) {
+		if (s->coreId != coreId)
+			continue;
+		s->dead = true;
+		wake_up(&s->waitq);
+	}
+	spin_unlock(&stream_list_lock);
+}
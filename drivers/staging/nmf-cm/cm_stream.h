@@ -0,0 +1,72 @@
+/*
+ * License terms: GNU General Public License (GPL), version 2.
+ */
+
+/** \file cm_stream.h
+ *
+ * Kernel pass-through streams to a DSP decoder component
+ *
+ * A stream feeds compressed frames to a decoder component running on the
+ * SIA, through a ring of frame slots in MPC memory, and has the decoded
+ * PCM go from a second MPC buffer to the MSP through the DMA40 relink
+ * list set up by cmdma_setup_relink_area(). The ARM only wakes up to
+ * refill the ring when the decoder notifies it has consumed frames.
+ *
+ * The decoder component and its skeleton and stub must have been pushed
+ * to the component cache (CM_PUSHCOMPONENT) beforehand, by the owner of
+ * the memory domain the stream is created in.
+ *
+ * The decoder provides \a itf, whose methods take 16 bit parameters, 32 bit
+ * values being passed low half first:
+ *  - 0: configure(ring, slots, slot_size, pcm, segments, segment_size),
+ *       with ring and pcm the MPC addresses of the two buffers,
+ *  - 1: kick(wr), frames up to slot wr (excluded) are ready,
+ *  - 2: stop().
+ *
+ * It requires \a notify_itf, with methods:
+ *  - 0: consumed(rd), slots up to rd (excluded) are free again,
+ *  - 1: error(code), the stream cannot go on.
+ *
+ * The ring starts with a header of 16 bit words, struct cm_stream_ring,
+ * followed by the length in bytes of each slot and then the slots.
+ */
+
+#ifndef __CM_STREAM_H
+#define __CM_STREAM_H
+
+#include <linux/types.h>
+#include <cm/engine/api/cm_engine.h>
+
+#define CM_STREAM_MAX_SLOTS	64
+
+struct cm_stream_config {
+	const char *template_name;	/**< decoder component template */
+	const char *itf;		/**< decoder control interface */
+	const char *notify_itf;		/**< decoder notification interface */
+	t_cm_domain_id domain;		/**< SIA memory domain */
+	t_nmf_client_id client;		/**< owner of the domain */
+	unsigned int slots;		/**< compressed frame slots */
+	unsigned int slot_size;		/**< bytes per slot */
+	unsigned int pcm_segments;	/**< DMA segments of the PCM buffer */
+	unsigned int pcm_segment_size;	/**< bytes per segment */
+	unsigned int pcm_per_addr;	/**< MSP TX FIFO physical address */
+	unsigned int pcm_LOS;		/**< first logical channel link */
+};
+
+struct cm_stream_ring {
+	u16 wr;				/**< written by the host */
+	u16 rd;				/**< written by the DSP */
+	u16 len[0];			/**< bytes in each slot */
+};
+
+struct cm_stream;
+
+struct cm_stream *cm_stream_open(const struct cm_stream_config *cfg);
+ssize_t cm_stream_write(struct cm_stream *stream, const char __user *buf,
+			size_t count, bool nonblock);
+int cm_stream_drain(struct cm_stream *stream);
+void cm_stream_close(struct cm_stream *stream);
+
+void cm_stream_panic(t_nmf_core_id coreId);
+
+#endif
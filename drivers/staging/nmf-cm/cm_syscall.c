@@ -222,6 +222,7 @@ inline int cmld_BindComponentToCMCore(struct cm_channel_priv* channelPriv,
 	skelwrapper->upperLayerThis = data.in.upLayerThis;
 	skelwrapper->mpc2hostId = data.out.mpc2hostId;
 	skelwrapper->channelPriv = channelPriv;
+	skelwrapper->kernel_cb = NULL;
 	mutex_lock(&channelPriv->skelListLock);
 	list_add(&skelwrapper->entry, &channelPriv->skelList);
 	mutex_unlock(&channelPriv->skelListLock);
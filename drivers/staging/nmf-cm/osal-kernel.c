@@ -321,6 +321,12 @@ void OSAL_PostDfc(t_nmf_mpc2host_handle upLayerTHIS, t_uint32 methodIndex, t_eve
 	t_skelwrapper* skelwrapper = (t_skelwrapper*)upLayerTHIS;
 	struct osal_msg* message;
 
+	/* In-kernel receivers acknowledge the event themselves */
+	if (skelwrapper->kernel_cb) {
+		skelwrapper->kernel_cb(skelwrapper->kernel_data, methodIndex, ptr);
+		return;
+	}
+
 	/* If the clannel has been closed, no more reader exists
 	   => discard the message */
 	if (skelwrapper->channelPriv->state == CHANNEL_CLOSED) {
@@ -101,6 +101,8 @@ typedef struct {
 	t_cm_bf_mpc2host_handle mpc2hostId;  /**< mpc2host ID */
 	t_nmf_mpc2host_handle upperLayerThis;/**< upper-layer handle */
 	struct cm_channel_priv* channelPriv; /**< Per-channel private data. The actual message queue is hold here */
+	void (*kernel_cb)(void *, t_uint32, t_event_params_handle); /**< in-kernel receiver (cm_stream), called in tasklet context instead of queuing */
+	void *kernel_data;                   /**< kernel_cb argument */
 } t_skelwrapper;
 
 /** Message description for MPC to HOST communication
@@ -8,9 +8,23 @@
 #include <linux/spinlock.h>
 #include <linux/bitops.h>
 #include <linux/pasr.h>
+#include <linux/suspend.h>
+#include <linux/syscore_ops.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/gfp.h>
+#include <linux/pfn.h>
 
 #include "helper.h"
 
+/* Number of free list entries pasr_pick_block() looks at */
+#define PASR_PICK_SCAN		8
+/*
+ * A segment with at least this much free memory is nearly empty, allocations
+ * steer away from it and it is emptied before suspend.
+ */
+#define PASR_NEARLY_FREE	(PASR_SECTION_SZ - PASR_SECTION_SZ / 4)
+
 enum pasr_state {
 	PASR_REFRESH,
 	PASR_NO_REFRESH,
@@ -18,6 +32,12 @@ enum pasr_state {
 
 struct pasr_fw {
 	struct pasr_map *map;
+
+	/* Statistics of the last suspend cycle and all of them */
+	u32 nr_off_last;
+	u32 nr_held_last;
+	u32 nr_suspend;
+	u32 nr_off_total;
 };
 
 static struct pasr_fw pasr;
@@ -131,6 +151,225 @@ out:
 	return;
 }
 
+struct page *pasr_pick_block(struct list_head *list)
+{
+	struct page *page, *best = NULL;
+	unsigned long best_free = ULONG_MAX;
+	int n = 0;
+
+	if (!pasr.map)
+		return list_entry(list->next, struct page, lru);
+
+	/*
+	 * Called under the zone lock, the free sizes are read unlocked as
+	 * this is only a hint.
+	 */
+	list_for_each_entry(page, list, lru) {
+		struct pasr_section *s = pasr_addr2section(pasr.map,
+							page_to_phys(page));
+		unsigned long free = s ? ACCESS_ONCE(s->free_size) : 0;
+
+		if (free < best_free) {
+			best = page;
+			best_free = free;
+		}
+
+		if (best_free < PASR_NEARLY_FREE || ++n == PASR_PICK_SCAN)
+			break;
+	}
+
+	return best;
+}
+
+static unsigned int pasr_count_off(void)
+{
+	struct pasr_section *s;
+	unsigned int nr = 0;
+	int i, j;
+
+	for_each_pasr_section(i, j, (*pasr.map), s) {
+		u8 bit = (s->start - s->die->start) >> PASR_SECTION_SZ_BITS;
+
+		if (test_bit(bit, &s->die->mem_reg))
+			nr++;
+	}
+
+	return nr;
+}
+
+#ifdef CONFIG_PASR_SUSPEND_COMPACT
+/*
+ * Empty a nearly free segment by allocating it, migrating its movable
+ * pages away. The segment is then unused memory owned by us, so it is
+ * handed to PASR as free until resume.
+ */
+static bool pasr_hold_section(struct pasr_section *s)
+{
+	unsigned long start_pfn = PFN_DOWN(s->start);
+	unsigned long end_pfn = start_pfn + (PASR_SECTION_SZ >> PAGE_SHIFT);
+	unsigned long pfn;
+	struct zone *zone;
+
+	if (s->free_size < PASR_NEARLY_FREE ||
+			s->free_size == PASR_SECTION_SZ)
+		return false;
+
+	if (!pfn_valid(start_pfn) || !pfn_valid(end_pfn - 1))
+		return false;
+
+	/* alloc_contig_range() works within a single zone */
+	zone = page_zone(pfn_to_page(start_pfn));
+	if (page_zone(pfn_to_page(end_pfn - 1)) != zone)
+		return false;
+
+	/* Leave CMA areas alone, their allocator owns the migratetypes */
+	for (pfn = start_pfn; pfn < end_pfn; pfn += pageblock_nr_pages) {
+		if (!pfn_valid(pfn) ||
+			get_pageblock_migratetype(pfn_to_page(pfn)) !=
+							MIGRATE_MOVABLE)
+			return false;
+	}
+
+	if (alloc_contig_range(start_pfn, end_pfn, MIGRATE_MOVABLE))
+		return false;
+
+	pasr_put(s->start, PASR_SECTION_SZ);
+	s->held = true;
+
+	return true;
+}
+
+static void pasr_release_sections(void)
+{
+	struct pasr_section *s;
+	int i, j;
+
+	for_each_pasr_section(i, j, (*pasr.map), s) {
+		if (!s->held)
+			continue;
+
+		pasr_get(s->start, PASR_SECTION_SZ);
+		free_contig_range(PFN_DOWN(s->start),
+					PASR_SECTION_SZ >> PAGE_SHIFT);
+		s->held = false;
+	}
+}
+
+static int pasr_pm_notifier(struct notifier_block *nb,
+					unsigned long event, void *unused)
+{
+	struct pasr_section *s;
+	int i, j;
+
+	switch (event) {
+	case PM_SUSPEND_PREPARE:
+		pasr.nr_held_last = 0;
+		for_each_pasr_section(i, j, (*pasr.map), s) {
+			if (pasr_hold_section(s))
+				pasr.nr_held_last++;
+		}
+		pr_debug("%s(): emptied %u sections\n", __func__,
+							pasr.nr_held_last);
+		break;
+	case PM_POST_SUSPEND:
+		pasr_release_sections();
+		break;
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block pasr_pm_nb = {
+	.notifier_call = pasr_pm_notifier,
+};
+#endif /* CONFIG_PASR_SUSPEND_COMPACT */
+
+/*
+ * Runs with one CPU and interrupts off right before the DDR goes to
+ * self-refresh, the mask is final at that point.
+ */
+static int pasr_syscore_suspend(void)
+{
+	pasr.nr_off_last = pasr_count_off();
+	pasr.nr_off_total += pasr.nr_off_last;
+	pasr.nr_suspend++;
+
+	return 0;
+}
+
+static void pasr_syscore_resume(void)
+{
+	pr_info("PASR: %u sections were not refreshed during suspend\n",
+							pasr.nr_off_last);
+}
+
+static struct syscore_ops pasr_syscore_ops = {
+	.suspend = pasr_syscore_suspend,
+	.resume = pasr_syscore_resume,
+};
+
+#ifdef CONFIG_DEBUG_FS
+static int pasr_sections_show(struct seq_file *m, void *unused)
+{
+	struct pasr_section *s;
+	int i, j;
+
+	seq_printf(m, "%10s %10s %8s\n", "start", "free", "refresh");
+	for_each_pasr_section(i, j, (*pasr.map), s) {
+		u8 bit = (s->start - s->die->start) >> PASR_SECTION_SZ_BITS;
+
+		seq_printf(m, "%#10x %10lu %8s\n", s->start, s->free_size,
+			test_bit(bit, &s->die->mem_reg) ? "off" : "on");
+	}
+
+	return 0;
+}
+
+static int pasr_sections_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pasr_sections_show, NULL);
+}
+
+static const struct file_operations pasr_sections_fops = {
+	.open = pasr_sections_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void __init pasr_debugfs_init(void)
+{
+	struct dentry *dir = debugfs_create_dir("pasr", NULL);
+
+	if (IS_ERR_OR_NULL(dir))
+		return;
+
+	debugfs_create_file("sections", 0444, dir, NULL, &pasr_sections_fops);
+	debugfs_create_u32("off_last_suspend", 0444, dir, &pasr.nr_off_last);
+	debugfs_create_u32("held_last_suspend", 0444, dir,
+							&pasr.nr_held_last);
+	debugfs_create_u32("suspend_count", 0444, dir, &pasr.nr_suspend);
+	debugfs_create_u32("off_total", 0444, dir, &pasr.nr_off_total);
+}
+#else
+static inline void pasr_debugfs_init(void) { }
+#endif /* CONFIG_DEBUG_FS */
+
+static int __init pasr_late_init(void)
+{
+	if (!pasr.map)
+		return 0;
+
+	register_syscore_ops(&pasr_syscore_ops);
+#ifdef CONFIG_PASR_SUSPEND_COMPACT
+	register_pm_notifier(&pasr_pm_nb);
+#endif
+	pasr_debugfs_init();
+
+	return 0;
+}
+late_initcall(pasr_late_init);
+
 int pasr_register_mask_function(phys_addr_t addr, void *function, void *cookie)
 {
 	struct pasr_die *die = pasr_addr2die(pasr.map, addr);
@@ -30,7 +30,7 @@ struct pasr_die *pasr_addr2die(struct pasr_map *map, phys_addr_t addr)
 		if (start == d->start)
 			return d;
 		else if (start > d->start)
-			left = mid;
+			left = mid + 1;
 		else
 			right = mid;
 	}
@@ -65,7 +65,7 @@ struct pasr_section *pasr_addr2section(struct pasr_map *map
 		if (addr == s->start)
 			return s;
 		else if (addr > s->start)
-			left = mid;
+			left = mid + 1;
 		else
 			right = mid;
 	}
@@ -25,6 +25,8 @@
 #include <linux/atomic.h>
 #include <linux/types.h>
 #include <linux/vmalloc.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
 
 #include "vnswap.h"
 
@@ -55,6 +57,42 @@ struct file *backing_storage_file;
 
 static DEFINE_SPINLOCK(vnswap_original_bio_lock);
 
+/* submits batches released from a plug, see vnswap_unplug() */
+static struct workqueue_struct *vnswap_wq;
+
+/*
+ * Write batch: one multi-page bio to physically contiguous backing
+ * storage blocks. original_bio[i] is the swap bio of bi_io_vec[i].
+ */
+struct vnswap_batch {
+	struct bio *bio;
+	struct work_struct work;
+	struct bio *original_bio[VNSWAP_BATCH_MAX_PAGES];
+};
+
+/* per task batch, hung off the caller's blk_plug */
+struct vnswap_plug_cb {
+	struct blk_plug_cb cb;
+	struct vnswap_batch *batch;
+};
+
+/*
+ * Readahead cache entry.
+ * nand_offset: cached backing storage block, -1 (free or invalidated)
+ * busy: read in flight, uptodate: page holds nand_offset data
+ * Lock order: vnswap_table_lock -> vnswap_ra_lock
+ */
+struct vnswap_ra_entry {
+	int nand_offset;
+	int busy;
+	int uptodate;
+	struct page *page;
+};
+
+static DEFINE_SPINLOCK(vnswap_ra_lock);
+static struct vnswap_ra_entry vnswap_ra_cache[VNSWAP_RA_MAX_PAGES];
+static int vnswap_ra_next;
+
 void vnswap_init_disksize(u64 disksize)
 {
 	int i;
@@ -574,6 +612,168 @@ out_bio_put:
 	bio_put(bio);
 }
 
+void vnswap_batch_end_write(struct bio *bio, int err)
+{
+	struct vnswap_batch *batch = (struct vnswap_batch *) bio->bi_private;
+	struct bio *original_bio;
+	int i;
+
+	dprintk("%s %d: (error, bi_vcnt) = (%d, %d)\n",
+			__func__, __LINE__, err, bio->bi_vcnt);
+
+	if (err) {
+		atomic_inc(&vnswap_device->stats.vnswap_bio_end_fail_w1_num);
+		pr_err("%s %d: (error, bio->bi_size, bio->bi_vcnt) = " \
+				"(%d, %d, %d)\n",
+				__func__, __LINE__, err, bio->bi_size,
+				bio->bi_vcnt);
+	}
+
+	/* complete every swap bio of the batch in one pass */
+	for (i = 0; i < bio->bi_vcnt; i++) {
+		original_bio = batch->original_bio[i];
+		if (err) {
+			bio_io_error(original_bio);
+			continue;
+		}
+		set_bit(BIO_UPTODATE, &original_bio->bi_flags);
+		bio_endio(original_bio, 0);
+	}
+
+	bio_put(bio);
+	kfree(batch);
+}
+
+static void vnswap_batch_submit(struct vnswap_batch *batch)
+{
+	dprintk("%s %d: (bi_sector, bi_vcnt) = (%llu, %d)\n",
+			__func__, __LINE__, (u64) batch->bio->bi_sector,
+			batch->bio->bi_vcnt);
+
+	atomic_inc(&vnswap_device->stats.vnswap_batched_bios);
+	atomic_add(batch->bio->bi_vcnt,
+		&vnswap_device->stats.vnswap_batched_pages);
+	submit_bio(WRITE, batch->bio);
+}
+
+static void vnswap_batch_work(struct work_struct *work)
+{
+	struct vnswap_batch *batch =
+		container_of(work, struct vnswap_batch, work);
+
+	vnswap_batch_submit(batch);
+}
+
+/*
+ * Called when the plug is flushed, possibly from schedule() of a task
+ * which is about to sleep, so the bio is handed to vnswap_wq instead of
+ * being submitted from here.
+ */
+static void vnswap_unplug(struct blk_plug_cb *cb)
+{
+	struct vnswap_plug_cb *plug_cb =
+		container_of(cb, struct vnswap_plug_cb, cb);
+
+	if (plug_cb->batch) {
+		INIT_WORK(&plug_cb->batch->work, vnswap_batch_work);
+		queue_work(vnswap_wq, &plug_cb->batch->work);
+	}
+	kfree(plug_cb);
+}
+
+/* refer mddev_check_plugged() */
+static struct vnswap_plug_cb *vnswap_check_plugged(void)
+{
+	struct blk_plug *plug = current->plug;
+	struct vnswap_plug_cb *plug_cb;
+
+	if (!plug || !vnswap_wq)
+		return NULL;
+
+	list_for_each_entry(plug_cb, &plug->cb_list, cb.list)
+		if (plug_cb->cb.callback == vnswap_unplug)
+			return plug_cb;
+
+	plug_cb = kzalloc(sizeof(*plug_cb), GFP_NOIO);
+	if (!plug_cb)
+		return NULL;
+
+	plug_cb->cb.callback = vnswap_unplug;
+	list_add(&plug_cb->cb.list, &plug->cb_list);
+	return plug_cb;
+}
+
+/*
+ * Add a swap-out to the caller's write batch.
+ * The free area allocator hands out nand_offsets in ascending order, so
+ * adjacent swap-outs normally land in adjacent backing storage blocks;
+ * a batch is cut as soon as the next block is not physically contiguous
+ * or the backing queue refuses a larger bio.
+ * Returns 0 when the page was batched, otherwise the caller has to fall
+ * back to vnswap_submit_bio().
+ */
+int vnswap_batch_write(int nand_offset, struct page *page,
+	struct bio *original_bio)
+{
+	struct vnswap_plug_cb *plug_cb;
+	struct vnswap_batch *batch;
+	sector_t sector;
+
+	plug_cb = vnswap_check_plugged();
+	if (!plug_cb)
+		return -EAGAIN;
+
+	sector = backing_storage_bmap[nand_offset] << (PAGE_SHIFT - 9);
+	batch = plug_cb->batch;
+	if (batch) {
+		if (batch->bio->bi_sector + (batch->bio->bi_size >> 9) ==
+				sector &&
+			bio_add_page(batch->bio, page, PAGE_SIZE, 0) ==
+				PAGE_SIZE)
+			goto added;
+
+		vnswap_batch_submit(batch);
+		plug_cb->batch = NULL;
+	}
+
+	batch = kmalloc(sizeof(*batch), GFP_NOIO);
+	if (!batch) {
+		atomic_inc(&vnswap_device->stats.vnswap_bio_no_mem_num);
+		return -ENOMEM;
+	}
+
+	batch->bio = bio_alloc(GFP_NOIO, VNSWAP_BATCH_MAX_PAGES);
+	if (!batch->bio) {
+		atomic_inc(&vnswap_device->stats.vnswap_bio_no_mem_num);
+		kfree(batch);
+		return -ENOMEM;
+	}
+
+	batch->bio->bi_sector = sector;
+	batch->bio->bi_bdev = backing_storage_bdev;
+	batch->bio->bi_private = (void *) batch;
+	batch->bio->bi_end_io = vnswap_batch_end_write;
+
+	if (bio_add_page(batch->bio, page, PAGE_SIZE, 0) != PAGE_SIZE) {
+		bio_put(batch->bio);
+		kfree(batch);
+		return -EAGAIN;
+	}
+	plug_cb->batch = batch;
+
+added:
+	batch->original_bio[batch->bio->bi_vcnt - 1] = original_bio;
+
+	dprintk("%s %d: (nand_offset, bi_vcnt) = (%d, %d)\n",
+			__func__, __LINE__, nand_offset, batch->bio->bi_vcnt);
+
+	atomic_inc(&vnswap_device->stats.
+		vnswap_stored_pages);
+	atomic_inc(&vnswap_device->stats.
+		vnswap_write_pages);
+	return 0;
+}
+
 /* Insert entry into VNSWAP_IO sub system */
 int vnswap_submit_bio(int rw, int nand_offset,
 	struct page *page, struct bio *original_bio)
@@ -629,6 +829,227 @@ out:
 	return ret;
 }
 
+static void vnswap_ra_free_cache(void)
+{
+	int i;
+
+	for (i = 0; i < VNSWAP_RA_MAX_PAGES; i++) {
+		if (vnswap_ra_cache[i].page)
+			__free_page(vnswap_ra_cache[i].page);
+		vnswap_ra_cache[i].page = NULL;
+	}
+}
+
+int vnswap_set_readahead_window(int window)
+{
+	int i;
+
+	if (window < 0 || window > VNSWAP_RA_MAX_PAGES)
+		return -EINVAL;
+
+	down_write(&vnswap_device->lock);
+	/* cache pages are kept until exit, bios may still use them */
+	if (window && !vnswap_ra_cache[0].page) {
+		for (i = 0; i < VNSWAP_RA_MAX_PAGES; i++) {
+			vnswap_ra_cache[i].page = alloc_page(GFP_KERNEL);
+			if (!vnswap_ra_cache[i].page) {
+				vnswap_ra_free_cache();
+				up_write(&vnswap_device->lock);
+				return -ENOMEM;
+			}
+			vnswap_ra_cache[i].nand_offset = -1;
+			vnswap_ra_cache[i].busy = 0;
+			vnswap_ra_cache[i].uptodate = 0;
+		}
+	}
+	vnswap_device->ra_window = window;
+	up_write(&vnswap_device->lock);
+
+	return 0;
+}
+
+/* drop a cached block whose slot is freed or rewritten */
+static void vnswap_ra_invalidate(int nand_offset)
+{
+	unsigned long flags;
+	int i;
+
+	if (!vnswap_ra_cache[0].page)
+		return;
+
+	spin_lock_irqsave(&vnswap_ra_lock, flags);
+	for (i = 0; i < VNSWAP_RA_MAX_PAGES; i++) {
+		if (vnswap_ra_cache[i].nand_offset == nand_offset) {
+			vnswap_ra_cache[i].nand_offset = -1;
+			vnswap_ra_cache[i].uptodate = 0;
+		}
+	}
+	spin_unlock_irqrestore(&vnswap_ra_lock, flags);
+}
+
+/* copy a read ahead block into page, returns 1 on hit */
+static int vnswap_ra_lookup(int nand_offset, struct page *page)
+{
+	struct vnswap_ra_entry *entry;
+	unsigned char *user_mem, *cache_mem;
+	unsigned long flags;
+	int i, hit = 0;
+
+	if (!vnswap_device->ra_window)
+		return 0;
+
+	spin_lock_irqsave(&vnswap_ra_lock, flags);
+	for (i = 0; i < VNSWAP_RA_MAX_PAGES; i++) {
+		entry = &vnswap_ra_cache[i];
+		if (entry->nand_offset != nand_offset ||
+			entry->busy || !entry->uptodate)
+			continue;
+
+		user_mem = kmap_atomic(page);
+		cache_mem = kmap_atomic(entry->page);
+		memcpy(user_mem, cache_mem, PAGE_SIZE);
+		kunmap_atomic(cache_mem);
+		kunmap_atomic(user_mem);
+		flush_dcache_page(page);
+
+		/* the page lives in the swap cache from now on */
+		entry->nand_offset = -1;
+		entry->uptodate = 0;
+		hit = 1;
+		break;
+	}
+	spin_unlock_irqrestore(&vnswap_ra_lock, flags);
+
+	if (hit)
+		atomic_inc(&vnswap_device->stats.vnswap_ra_hits);
+
+	return hit;
+}
+
+static void vnswap_ra_end_read(struct bio *bio, int err)
+{
+	const int uptodate = test_bit(BIO_UPTODATE, &bio->bi_flags);
+	struct vnswap_ra_entry *entry;
+	unsigned long flags;
+	int i;
+
+	dprintk("%s %d: (uptodate, error, bi_vcnt) = (%d, %d, %d)\n",
+			__func__, __LINE__, uptodate, err, bio->bi_vcnt);
+
+	spin_lock_irqsave(&vnswap_ra_lock, flags);
+	for (i = 0; i < bio->bi_vcnt; i++) {
+		entry = &vnswap_ra_cache[page_private(
+			bio->bi_io_vec[i].bv_page)];
+		entry->busy = 0;
+		entry->uptodate = uptodate && !err &&
+			entry->nand_offset != -1;
+	}
+	spin_unlock_irqrestore(&vnswap_ra_lock, flags);
+
+	bio_put(bio);
+}
+
+/* take the oldest idle entry, called with vnswap_ra_lock held */
+static int vnswap_ra_get_entry(void)
+{
+	int i, slot;
+
+	for (i = 0; i < VNSWAP_RA_MAX_PAGES; i++) {
+		slot = (vnswap_ra_next + i) % VNSWAP_RA_MAX_PAGES;
+		if (!vnswap_ra_cache[slot].busy) {
+			vnswap_ra_next = (slot + 1) % VNSWAP_RA_MAX_PAGES;
+			return slot;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Read the used slots following nand_offset which are physically
+ * contiguous with it into the readahead cache, in one bio.
+ */
+static void vnswap_ra_issue(int nand_offset)
+{
+	int slots[VNSWAP_RA_MAX_PAGES];
+	int window, i, k, n = 0, m;
+	unsigned long flags;
+	struct bio *bio;
+
+	window = vnswap_device->ra_window;
+	if (!window)
+		return;
+
+	spin_lock(&vnswap_table_lock);
+	spin_lock_irqsave(&vnswap_ra_lock, flags);
+	for (k = 1; k <= window; k++) {
+		m = nand_offset + k;
+		if (m >= vnswap_device->bs_size ||
+			!test_bit(m, backing_storage_bitmap) ||
+			backing_storage_bmap[m] !=
+				backing_storage_bmap[nand_offset] + k)
+			break;
+
+		/* the rest of the window was read ahead before */
+		for (i = 0; i < VNSWAP_RA_MAX_PAGES; i++)
+			if (vnswap_ra_cache[i].nand_offset == m)
+				break;
+		if (i < VNSWAP_RA_MAX_PAGES)
+			break;
+
+		i = vnswap_ra_get_entry();
+		if (i < 0)
+			break;
+		vnswap_ra_cache[i].nand_offset = m;
+		vnswap_ra_cache[i].busy = 1;
+		vnswap_ra_cache[i].uptodate = 0;
+		slots[n++] = i;
+	}
+	spin_unlock_irqrestore(&vnswap_ra_lock, flags);
+	spin_unlock(&vnswap_table_lock);
+
+	if (!n)
+		return;
+
+	bio = bio_alloc(GFP_NOIO, n);
+	if (!bio) {
+		atomic_inc(&vnswap_device->stats.vnswap_bio_no_mem_num);
+		k = 0;
+		goto release;
+	}
+
+	bio->bi_sector = backing_storage_bmap[nand_offset + 1] <<
+					(PAGE_SHIFT - 9);
+	bio->bi_bdev = backing_storage_bdev;
+	bio->bi_end_io = vnswap_ra_end_read;
+	for (k = 0; k < n; k++) {
+		set_page_private(vnswap_ra_cache[slots[k]].page, slots[k]);
+		if (bio_add_page(bio, vnswap_ra_cache[slots[k]].page,
+				PAGE_SIZE, 0) != PAGE_SIZE)
+			break;
+	}
+
+	if (k) {
+		dprintk("%s %d: (nand_offset, pages) = (%d, %d)\n",
+				__func__, __LINE__, nand_offset + 1, k);
+		atomic_add(k, &vnswap_device->stats.vnswap_ra_pages);
+		submit_bio(READ, bio);
+	} else {
+		bio_put(bio);
+	}
+
+release:
+	/* entries the bio could not take */
+	if (k < n) {
+		spin_lock_irqsave(&vnswap_ra_lock, flags);
+		for (; k < n; k++) {
+			vnswap_ra_cache[slots[k]].nand_offset = -1;
+			vnswap_ra_cache[slots[k]].busy = 0;
+		}
+		spin_unlock_irqrestore(&vnswap_ra_lock, flags);
+	}
+}
+
 int vnswap_bvec_read(struct vnswap *vnswap, struct bio_vec *bvec,
 	u32 index, struct bio *bio)
 {
@@ -667,8 +1088,17 @@ int vnswap_bvec_read(struct vnswap *vnswap, struct bio_vec *bvec,
 	dprintk("%s %d: (index, nand_offset) = (%d, %d)\n",
 			__func__, __LINE__, index, nand_offset);
 
+	if (vnswap_ra_lookup(nand_offset, page)) {
+		/* single page bio, see __vnswap_make_request() */
+		set_bit(BIO_UPTODATE, &bio->bi_flags);
+		bio_endio(bio, 0);
+		goto out;
+	}
+
 	/* Read nand_offset position backing storage into page */
 	ret = vnswap_submit_bio(0, nand_offset, page, bio);
+	if (!ret)
+		vnswap_ra_issue(nand_offset);
 
 out:
 	return ret;
@@ -700,6 +1130,7 @@ int vnswap_bvec_write(struct vnswap *vnswap, struct bio_vec *bvec,
 	if (nand_offset != -1) {
 		atomic_inc(&vnswap_device->stats.
 			vnswap_double_mapped_slot_num);
+		vnswap_ra_invalidate(nand_offset);
 		clear_bit(nand_offset, backing_storage_bitmap);
 		vnswap_table[index] = -1;
 		atomic_dec(&vnswap_device->stats.
@@ -713,6 +1144,7 @@ int vnswap_bvec_write(struct vnswap *vnswap, struct bio_vec *bvec,
 		spin_unlock(&vnswap_table_lock);
 		return ret;
 	}
+	vnswap_ra_invalidate(nand_offset);
 	set_bit(nand_offset, backing_storage_bitmap);
 	vnswap_table[index] = nand_offset;
 	atomic_inc(&vnswap_device->stats.
@@ -721,7 +1153,9 @@ int vnswap_bvec_write(struct vnswap *vnswap, struct bio_vec *bvec,
 
 	dprintk("%s %d: (index, nand_offset) = (%d, %d)\n",
 			__func__, __LINE__, index, nand_offset);
-	ret = vnswap_submit_bio(1, nand_offset, page, bio);
+	ret = vnswap_batch_write(nand_offset, page, bio);
+	if (ret)
+		ret = vnswap_submit_bio(1, nand_offset, page, bio);
 
 	if (ret) {
 		spin_lock(&vnswap_table_lock);
@@ -930,6 +1364,7 @@ void vnswap_slot_free_notify(struct block_device *bdev, unsigned long index)
 		vnswap_stored_pages);
 	atomic_dec(&vnswap_device->stats.
 		vnswap_used_slot_num);
+	vnswap_ra_invalidate(nand_offset);
 	clear_bit(nand_offset, backing_storage_bitmap);
 	vnswap_table[index] = -1;
 
@@ -1088,6 +1523,12 @@ int __init vnswap_init(void)
 	backing_storage_bdev = NULL;
 	backing_storage_file = NULL;
 
+	/* swap-out path, keep a rescuer for memory pressure */
+	vnswap_wq = alloc_workqueue("vnswap", WQ_MEM_RECLAIM | WQ_HIGHPRI, 0);
+	if (!vnswap_wq)
+		pr_warn("%s %d: Unable to allocate vnswap_wq, " \
+			"write batching is disabled\n", __func__, __LINE__);
+
 	/* Allocate and initialize the device */
 	vnswap_device = kzalloc(sizeof(struct vnswap), GFP_KERNEL);
 	if (!vnswap_device) {
@@ -1112,6 +1553,8 @@ free_devices:
 	kfree(vnswap_device);
 
 unregister:
+	if (vnswap_wq)
+		destroy_workqueue(vnswap_wq);
 	unregister_blkdev(vnswap_major, "vnswap");
 
 out:
@@ -1124,10 +1567,14 @@ void __exit vnswap_exit(void)
 
 	unregister_blkdev(vnswap_major, "vnswap");
 
+	if (vnswap_wq)
+		destroy_workqueue(vnswap_wq);
+
 	if (backing_storage_file)
 		filp_close(backing_storage_file, NULL);
 	if (swap_header_page)
 		__free_page(swap_header_page);
+	vnswap_ra_free_cache();
 	kfree(vnswap_device);
 	if (backing_storage_bmap)
 		vfree(backing_storage_bmap);
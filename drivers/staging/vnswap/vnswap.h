@@ -53,6 +53,21 @@
 
 #define MAX_BACKING_STORAGE_FILENAME_LEN	127
 
+/*
+ * Max pages gathered into one backing storage write bio.
+ * Swap-outs issued under one blk_plug (one reclaim pass) whose slots are
+ * physically contiguous in the backing file are merged up to this size.
+ */
+#define VNSWAP_BATCH_MAX_PAGES	32
+
+/*
+ * Max swap-in readahead window (pages).
+ * A backing storage read also fetches up to this many following slots,
+ * as long as they are in use and physically contiguous, into a small
+ * cache that the next swap faults are served from.
+ */
+#define VNSWAP_RA_MAX_PAGES	16
+
 struct vnswap_stats {
 	u64 vnswap_is_init;	/* vnswap_init success or fail */
 	u64 vnswap_total_slot_num;	/* total  slot number */
@@ -89,6 +104,14 @@ struct vnswap_stats {
 		/* total write_fail_because_of_backing_storage_full number */
 	int vnswap_backing_storage_open_fail;
 		/* backing storage file open fail */
+	atomic_t vnswap_batched_bios;
+		/* total write bios built from batched pages */
+	atomic_t vnswap_batched_pages;
+		/* total pages written through batched bios */
+	atomic_t vnswap_ra_pages;
+		/* total pages read ahead into the readahead cache */
+	atomic_t vnswap_ra_hits;
+		/* total reads served from the readahead cache */
 };
 
 struct vnswap {
@@ -103,11 +126,13 @@ struct vnswap {
 		/* vnswap init success: VNSWAP_INIT_DISKSIZE_SUCCESS |
 		* VNSWAP_INIT_BACKING_STORAGE_SUCCESS ,
 		* others: vnswap init fail*/
+	int ra_window;	/* swap-in readahead window (pages), 0: off */
 	struct vnswap_stats stats;
 };
 
 extern void vnswap_init_disksize(u64 disksize);
 extern int vnswap_init_backing_storage(void);
+extern int vnswap_set_readahead_window(int window);
 
 extern struct vnswap *vnswap_device;
 extern struct block_device *backing_storage_bdev;
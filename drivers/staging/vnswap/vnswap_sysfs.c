@@ -16,6 +16,7 @@
 #include <linux/fs.h>
 #include <linux/atomic.h>
 #include <linux/types.h>
+#include <linux/math64.h>
 
 #include "vnswap.h"
 
@@ -94,7 +95,8 @@ static ssize_t vnswap_swap_info_show(struct device *dev,
 {
 	return sprintf(buf, "(%d, %d, %d) (%llu, %d, %d, %d, %d, %d) " \
 						"(%d, %d, %d, %d, %d, %d, " \
-						"%d, %d, %d, %d, %d, %d)\n",
+						"%d, %d, %d, %d, %d, %d) " \
+						"(%d, %d)\n",
 		vnswap_device->stats.vnswap_stored_pages.counter,
 		vnswap_device->stats.vnswap_write_pages.counter,
 		vnswap_device->stats.vnswap_read_pages.counter,
@@ -115,10 +117,45 @@ static ssize_t vnswap_swap_info_show(struct device *dev,
 		vnswap_device->stats.vnswap_bio_invalid_num.counter,
 		vnswap_device->stats.vnswap_bio_no_mem_num.counter,
 		vnswap_device->stats.vnswap_not_mapped_read_pages.counter,
-		vnswap_device->stats.vnswap_backing_storage_open_fail
+		vnswap_device->stats.vnswap_backing_storage_open_fail,
+		vnswap_device->stats.vnswap_batched_bios.counter,
+		vnswap_device->stats.vnswap_batched_pages.counter
 	);
 }
 
+static ssize_t readahead_window_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%d\n", vnswap_device->ra_window);
+}
+
+static ssize_t readahead_window_store(struct device *dev,
+	struct device_attribute *attr, const char *buf, size_t len)
+{
+	int ret, window;
+
+	ret = kstrtoint(buf, 10, &window);
+	if (ret)
+		return ret;
+
+	ret = vnswap_set_readahead_window(window);
+	if (ret)
+		return ret;
+
+	return len;
+}
+
+static ssize_t readahead_stat_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	int ra_pages = atomic_read(&vnswap_device->stats.vnswap_ra_pages);
+	int ra_hits = atomic_read(&vnswap_device->stats.vnswap_ra_hits);
+
+	/* (read ahead pages, hits, hit ratio %) */
+	return sprintf(buf, "(%d, %d, %d)\n", ra_pages, ra_hits,
+			ra_pages ? (int) div_u64((u64) ra_hits * 100, ra_pages) : 0);
+}
+
 static DEVICE_ATTR(disksize, S_IRUGO | S_IWUSR, disksize_show,
 	disksize_store);
 static DEVICE_ATTR(swap_filename, S_IRUGO | S_IWUSR, swap_filename_show,
@@ -129,6 +166,10 @@ static DEVICE_ATTR(vnswap_init, S_IRUGO | S_IWUSR,
 	vnswap_init_show, NULL);
 static DEVICE_ATTR(vnswap_swap_info, S_IRUGO | S_IWUSR,
 	vnswap_swap_info_show, NULL);
+static DEVICE_ATTR(readahead_window, S_IRUGO | S_IWUSR,
+	readahead_window_show, readahead_window_store);
+static DEVICE_ATTR(readahead_stat, S_IRUGO,
+	readahead_stat_show, NULL);
 
 static struct attribute *vnswap_disk_attrs[] = {
 	&dev_attr_disksize.attr,
@@ -136,6 +177,8 @@ static struct attribute *vnswap_disk_attrs[] = {
 	&dev_attr_init_backing_storage.attr,
 	&dev_attr_vnswap_init.attr,
 	&dev_attr_vnswap_swap_info.attr,
+	&dev_attr_readahead_window.attr,
+	&dev_attr_readahead_stat.attr,
 	NULL,
 };
 
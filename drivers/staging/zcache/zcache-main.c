@@ -32,6 +32,7 @@
 #include <linux/crypto.h>
 #include <linux/string.h>
 #include <linux/idr.h>
+#include <linux/workqueue.h>
 #include "tmem.h"
 
 #include <linux/zsmalloc.h>
@@ -611,6 +612,42 @@ out:
 	return;
 }
 
+/*
+ * Hard limit of the pageframes zbud may hold, in percent of totalram_pages.
+ * Over the limit ephemeral puts are rejected and a work evicts the oldest
+ * zbpgs to ZBUD_EVICT_BATCH below it, so that the cache keeps turning over
+ * to recently evicted pagecache pages instead of holding the first ones.
+ */
+#define ZBUD_EVICT_BATCH 32
+
+static unsigned int zbud_page_count_policy_percent = 10;
+static unsigned long zcache_zbud_over_limit_puts;
+
+static unsigned long zbud_max_raw_pages(void)
+{
+	return (zbud_page_count_policy_percent * totalram_pages) / 100;
+}
+
+static void zbud_limit_work_func(struct work_struct *work)
+{
+	long nr = atomic_read(&zcache_zbud_curr_raw_pages) -
+			zbud_max_raw_pages() + ZBUD_EVICT_BATCH;
+
+	if (nr > 0)
+		zbud_evict_pages(nr);
+}
+
+static DECLARE_WORK(zbud_limit_work, zbud_limit_work_func);
+
+static bool zbud_over_limit(void)
+{
+	if (atomic_read(&zcache_zbud_curr_raw_pages) < zbud_max_raw_pages())
+		return false;
+	zcache_zbud_over_limit_puts++;
+	schedule_work(&zbud_limit_work);
+	return true;
+}
+
 static void __init zbud_init(void)
 {
 	int i;
@@ -661,6 +698,39 @@ static int zbud_show_cumul_chunk_counts(char *buf)
 		chunks == 0 ? 0 : sum_total_chunks / chunks);
 	return p - buf;
 }
+
+static ssize_t zbud_page_count_policy_percent_show(struct kobject *kobj,
+						   struct kobj_attribute *attr,
+						   char *buf)
+{
+	return sprintf(buf, "%u\n", zbud_page_count_policy_percent);
+}
+
+static ssize_t zbud_page_count_policy_percent_store(struct kobject *kobj,
+						    struct kobj_attribute *attr,
+						    const char *buf,
+						    size_t count)
+{
+	unsigned long val;
+	int err;
+
+	if (!capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	err = kstrtoul(buf, 10, &val);
+	if (err || (val == 0) || (val > 75))
+		return -EINVAL;
+	zbud_page_count_policy_percent = val;
+	schedule_work(&zbud_limit_work);
+	return count;
+}
+
+static struct kobj_attribute zcache_zbud_page_count_policy_percent_attr = {
+		.attr = { .name = "zbud_page_count_policy_percent",
+			  .mode = 0644 },
+		.show = zbud_page_count_policy_percent_show,
+		.store = zbud_page_count_policy_percent_store,
+};
 #endif
 
 /**********
@@ -933,6 +1003,8 @@ static unsigned long zcache_flobj_total;
 static unsigned long zcache_flobj_found;
 static unsigned long zcache_failed_eph_puts;
 static unsigned long zcache_failed_pers_puts;
+static unsigned long zcache_eph_get_hits;
+static unsigned long zcache_eph_get_misses;
 
 /*
  * Tmem operations assume the poolid implies the invoking client.
@@ -1178,6 +1250,8 @@ static void *zcache_pampd_create(char *data, size_t size, bool raw, int eph,
 	u64 total_zsize;
 
 	if (eph) {
+		if (zbud_over_limit())
+			goto out;
 		ret = zcache_compress(page, &cdata, &clen);
 		if (ret == 0)
 			goto out;
@@ -1447,6 +1521,9 @@ ZCACHE_SYSFS_RO(flobj_total);
 ZCACHE_SYSFS_RO(flobj_found);
 ZCACHE_SYSFS_RO(failed_eph_puts);
 ZCACHE_SYSFS_RO(failed_pers_puts);
+ZCACHE_SYSFS_RO(eph_get_hits);
+ZCACHE_SYSFS_RO(eph_get_misses);
+ZCACHE_SYSFS_RO(zbud_over_limit_puts);
 ZCACHE_SYSFS_RO(zbud_curr_zbytes);
 ZCACHE_SYSFS_RO(zbud_cumul_zpages);
 ZCACHE_SYSFS_RO(zbud_cumul_zbytes);
@@ -1484,6 +1561,9 @@ static struct attribute *zcache_attrs[] = {
 	&zcache_flobj_found_attr.attr,
 	&zcache_failed_eph_puts_attr.attr,
 	&zcache_failed_pers_puts_attr.attr,
+	&zcache_eph_get_hits_attr.attr,
+	&zcache_eph_get_misses_attr.attr,
+	&zcache_zbud_over_limit_puts_attr.attr,
 	&zcache_compress_poor_attr.attr,
 	&zcache_mean_compress_poor_attr.attr,
 	&zcache_zbud_curr_raw_pages_attr.attr,
@@ -1506,6 +1586,7 @@ static struct attribute *zcache_attrs[] = {
 	&zcache_zv_max_zsize_attr.attr,
 	&zcache_zv_max_mean_zsize_attr.attr,
 	&zcache_zv_page_count_policy_percent_attr.attr,
+	&zcache_zbud_page_count_policy_percent_attr.attr,
 	NULL,
 };
 
@@ -1600,6 +1681,12 @@ static int zcache_get_page(int cli_id, int pool_id, struct tmem_oid *oidp,
 		if (atomic_read(&pool->obj_count) > 0)
 			ret = tmem_get(pool, oidp, index, (char *)(page),
 					&size, 0, is_ephemeral(pool));
+		if (is_ephemeral(pool)) {
+			if (ret >= 0)
+				zcache_eph_get_hits++;
+			else
+				zcache_eph_get_misses++;
+		}
 		zcache_put_pool(pool);
 	}
 	local_irq_restore(flags);
@@ -16,6 +16,9 @@
 #include <linux/tee.h>
 #include <linux/slab.h>
 #include <linux/hwmem.h>
+#include <linux/list.h>
+#include <linux/jiffies.h>
+#include <linux/workqueue.h>
 
 #define TEED_NAME "tee"
 #define TEED_PFX "TEE: "
@@ -25,6 +28,51 @@
 
 static struct mutex sync;
 
+/*
+ * Secure world instances of the trusted applications opened through the
+ * kernel API, kept alive keepalive_ms after their last session is closed so
+ * that the next open of the same UUID does not load the TA again. Protected
+ * by sync.
+ */
+struct tee_cached_ta {
+	struct list_head list;
+	struct tee_uuid uuid;
+	uint32_t id;
+	unsigned int users;
+	unsigned long last_used;
+};
+
+static LIST_HEAD(ta_cache);
+
+static unsigned int keepalive_ms = 10000;
+module_param(keepalive_ms, uint, 0644);
+MODULE_PARM_DESC(keepalive_ms, "Time an unused TA is kept open, 0 to close it at once");
+
+static void ta_cache_reap(struct work_struct *work);
+static DECLARE_DELAYED_WORK(ta_cache_work, ta_cache_reap);
+
+/* Entries into the secure world, total and over the last second */
+static unsigned long world_switches;
+module_param(world_switches, ulong, 0444);
+MODULE_PARM_DESC(world_switches, "Number of calls to the secure world");
+
+static unsigned int switch_rate;
+static unsigned int rate_count;
+static unsigned long rate_stamp;
+
+static int get_switch_rate(char *buffer, const struct kernel_param *kp)
+{
+	unsigned long elapsed = jiffies - rate_stamp;
+
+	/* Nothing has closed the window for a while, it is the rate then */
+	if (elapsed >= 2 * HZ)
+		return sprintf(buffer, "%lu", rate_count * HZ / elapsed);
+
+	return sprintf(buffer, "%u", switch_rate);
+}
+module_param_call(world_switch_rate, NULL, get_switch_rate, NULL, 0444);
+MODULE_PARM_DESC(world_switch_rate, "Calls to the secure world per second");
+
 static int tee_open(struct inode *inode, struct file *file);
 static int tee_release(struct inode *inode, struct file *file);
 static int tee_read(struct file *filp, char __user *buffer,
@@ -39,6 +87,75 @@ static inline void set_emsg(struct tee_session *ts, u32 msg, int line)
 	ts->origin = TEED_ORIGIN_DRIVER;
 }
 
+static int sec_world(struct tee_session *ts, int sec_cmd)
+{
+	unsigned long elapsed = jiffies - rate_stamp;
+
+	world_switches++;
+	if (elapsed >= HZ) {
+		switch_rate = rate_count * HZ / elapsed;
+		rate_count = 0;
+		rate_stamp = jiffies;
+	}
+	rate_count++;
+
+	return call_sec_world(ts, sec_cmd);
+}
+
+static struct tee_cached_ta *ta_cache_find(const struct tee_uuid *uuid)
+{
+	struct tee_cached_ta *ta;
+
+	if (!uuid)
+		return NULL;
+
+	list_for_each_entry(ta, &ta_cache, list) {
+		if (!memcmp(&ta->uuid, uuid, sizeof(*uuid)))
+			return ta;
+	}
+
+	return NULL;
+}
+
+static void ta_cache_close(struct tee_cached_ta *ta)
+{
+	struct tee_session ts;
+
+	/* A TA that was never invoked was never opened either */
+	if (ta->id) {
+		memset(&ts, 0, sizeof(ts));
+		ts.id = ta->id;
+		sec_world(&ts, TEED_CLOSE_SESSION);
+	}
+
+	list_del(&ta->list);
+	kfree(ta);
+}
+
+static void ta_cache_reap(struct work_struct *work)
+{
+	struct tee_cached_ta *ta, *next;
+	unsigned long keepalive;
+	bool idle = false;
+
+	mutex_lock(&sync);
+
+	keepalive = msecs_to_jiffies(keepalive_ms);
+	list_for_each_entry_safe(ta, next, &ta_cache, list) {
+		if (ta->users)
+			continue;
+		if (time_after_eq(jiffies, ta->last_used + keepalive))
+			ta_cache_close(ta);
+		else
+			idle = true;
+	}
+
+	if (idle)
+		schedule_delayed_work(&ta_cache_work, keepalive);
+
+	mutex_unlock(&sync);
+}
+
 static void reset_session(struct tee_session *ts)
 {
 	int i;
@@ -378,7 +495,7 @@ static int invoke_command(struct tee_session *ts,
 		}
 	}
 
-	if (call_sec_world(ts, TEED_INVOKE)) {
+	if (sec_world(ts, TEED_INVOKE)) {
 		set_emsg(ts, TEED_ERROR_COMMUNICATION, __LINE__);
 		ret = -EINVAL;
 		goto err;
@@ -512,8 +629,11 @@ static int tee_write(struct file *filp, const char __user *buffer,
 			break;
 
 		case TEED_CLOSE_SESSION:
-			/* no caching implemented yet... */
-			if (call_sec_world(ts, TEED_CLOSE_SESSION)) {
+			/*
+			 * Not cached, the state of a TA opened from user space
+			 * is private to its client.
+			 */
+			if (sec_world(ts, TEED_CLOSE_SESSION)) {
 				set_emsg(ts, TEED_ERROR_COMMUNICATION,
 					 __LINE__);
 				ret = -EINVAL;
@@ -572,6 +692,7 @@ int teec_open_session(struct tee_context *context,
 		      unsigned int *error_origin)
 {
 	int res = TEED_SUCCESS;
+	struct tee_cached_ta *ta;
 
 	if (session == NULL || destination == NULL) {
 		pr_err(TEED_PFX "[%s] session or destination == NULL\n",
@@ -604,6 +725,22 @@ int teec_open_session(struct tee_context *context,
 	session->ta = NULL;
 	session->id = 0;
 
+	mutex_lock(&sync);
+	ta = ta_cache_find(destination);
+	if (!ta) {
+		/* Uncached if this fails, closed with the session */
+		ta = kzalloc(sizeof(*ta), GFP_KERNEL);
+		if (ta) {
+			memcpy(&ta->uuid, destination, sizeof(ta->uuid));
+			list_add(&ta->list, &ta_cache);
+		}
+	}
+	if (ta) {
+		ta->users++;
+		session->id = ta->id;
+	}
+	mutex_unlock(&sync);
+
 exit:
 	return res;
 }
@@ -612,6 +749,7 @@ EXPORT_SYMBOL(teec_open_session);
 int teec_close_session(struct tee_session *session)
 {
 	int res = TEED_SUCCESS;
+	struct tee_cached_ta *ta;
 
 	mutex_lock(&sync);
 
@@ -621,7 +759,22 @@ int teec_close_session(struct tee_session *session)
 		goto exit;
 	}
 
-	if (call_sec_world(session, TEED_CLOSE_SESSION)) {
+	ta = ta_cache_find(session->uuid);
+	if (ta && ta->users) {
+		/* The TA stays open for the next session to the same UUID */
+		ta->last_used = jiffies;
+		if (--ta->users)
+			goto exit;
+		if (keepalive_ms) {
+			schedule_delayed_work(&ta_cache_work,
+					      msecs_to_jiffies(keepalive_ms));
+			goto exit;
+		}
+		ta_cache_close(ta);
+		goto exit;
+	}
+
+	if (sec_world(session, TEED_CLOSE_SESSION)) {
 		pr_err(TEED_PFX "[%s] error, call_sec_world failed\n",
 		       __func__);
 		res = TEED_ERROR_GENERIC;
@@ -639,24 +792,18 @@ exit:
 }
 EXPORT_SYMBOL(teec_close_session);
 
-int teec_invoke_command(
-	struct tee_session *session, unsigned int command_id,
-	struct tee_operation *operation,
-	unsigned int *error_origin)
+static int invoke_locked(struct tee_session *session, unsigned int command_id,
+			 struct tee_operation *operation,
+			 unsigned int *error_origin)
 {
 	int res = TEED_SUCCESS;
+	struct tee_cached_ta *ta;
 	int i;
 
-	mutex_lock(&sync);
-
-	if (session == NULL || operation == NULL || error_origin == NULL) {
-		pr_err(TEED_PFX "[%s] error, input parameters == NULL\n",
-		       __func__);
-		if (error_origin != NULL)
-			*error_origin = TEED_ORIGIN_DRIVER;
-		res = TEED_ERROR_BAD_PARAMETERS;
-		goto exit;
-	}
+	/* Another session may have opened the TA in the meantime */
+	ta = ta_cache_find(session->uuid);
+	if (ta && ta->id && !session->id)
+		session->id = ta->id;
 
 	for (i = 0; i < 4; ++i) {
 		/* We only want to translate memrefs in use. */
@@ -672,7 +819,7 @@ int teec_invoke_command(
 	/*
 	 * Call secure world
 	 */
-	if (call_sec_world(session, TEED_INVOKE)) {
+	if (sec_world(session, TEED_INVOKE)) {
 		pr_err(TEED_PFX "[%s] error, call_sec_world failed\n",
 		       __func__);
 		if (error_origin != NULL)
@@ -687,15 +834,82 @@ int teec_invoke_command(
 		res = session->err;
 	}
 
+	if (ta && !ta->id)
+		ta->id = session->id;
+
 	memrefs_phys_to_virt(session);
 	session->op = NULL;
 
+	return res;
+}
+
+int teec_invoke_command(
+	struct tee_session *session, unsigned int command_id,
+	struct tee_operation *operation,
+	unsigned int *error_origin)
+{
+	int res;
+
+	mutex_lock(&sync);
+
+	if (session == NULL || operation == NULL || error_origin == NULL) {
+		pr_err(TEED_PFX "[%s] error, input parameters == NULL\n",
+		       __func__);
+		if (error_origin != NULL)
+			*error_origin = TEED_ORIGIN_DRIVER;
+		res = TEED_ERROR_BAD_PARAMETERS;
+		goto exit;
+	}
+
+	res = invoke_locked(session, command_id, operation, error_origin);
+
 exit:
 	mutex_unlock(&sync);
 	return res;
 }
 EXPORT_SYMBOL(teec_invoke_command);
 
+int teec_invoke_commands(struct tee_session *session,
+			 struct tee_invocation *invocations,
+			 unsigned int count, unsigned int *error_origin)
+{
+	int res = TEED_SUCCESS;
+	unsigned int i;
+
+	mutex_lock(&sync);
+
+	if (session == NULL || invocations == NULL || error_origin == NULL) {
+		pr_err(TEED_PFX "[%s] error, input parameters == NULL\n",
+		       __func__);
+		if (error_origin != NULL)
+			*error_origin = TEED_ORIGIN_DRIVER;
+		res = TEED_ERROR_BAD_PARAMETERS;
+		goto exit;
+	}
+
+	for (i = 0; i < count; i++) {
+		invocations[i].result = TEED_ERROR_CANCEL;
+		if (res != TEED_SUCCESS)
+			continue;
+
+		if (invocations[i].operation == NULL) {
+			*error_origin = TEED_ORIGIN_DRIVER;
+			res = TEED_ERROR_BAD_PARAMETERS;
+			invocations[i].result = res;
+			continue;
+		}
+
+		res = invoke_locked(session, invocations[i].command_id,
+				    invocations[i].operation, error_origin);
+		invocations[i].result = res;
+	}
+
+exit:
+	mutex_unlock(&sync);
+	return res;
+}
+EXPORT_SYMBOL(teec_invoke_commands);
+
 int teec_allocate_shared_memory(struct tee_context *context,
 				struct tee_sharedmemory *shared_memory)
 {
@@ -758,6 +972,13 @@ static int __init tee_init(void)
 static void __exit tee_exit(void)
 {
 	misc_deregister(&tee_dev);
+
+	cancel_delayed_work_sync(&ta_cache_work);
+	mutex_lock(&sync);
+	while (!list_empty(&ta_cache))
+		ta_cache_close(list_first_entry(&ta_cache,
+						struct tee_cached_ta, list));
+	mutex_unlock(&sync);
 }
 
 subsys_initcall(tee_init);
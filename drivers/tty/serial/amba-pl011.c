@@ -55,6 +55,8 @@
 #include <linux/delay.h>
 #include <linux/io.h>
 #include <linux/pm_runtime.h>
+#include <linux/timer.h>
+#include <linux/jiffies.h>
 
 #include <plat/pincfg.h>
 #include <plat/gpio-nomadik.h>
@@ -153,6 +155,7 @@ static struct uart_amba_port *amba_ports[UART_NR];
 struct pl011_sgbuf {
 	struct scatterlist sg;
 	char *buf;
+	unsigned int taken;	/* chars already taken by the poll timer */
 };
 
 struct pl011_dmarx_data {
@@ -163,6 +166,12 @@ struct pl011_dmarx_data {
 	struct pl011_sgbuf	sgbuf_b;
 	dma_cookie_t		cookie;
 	bool			running;
+	unsigned int		buf_size;
+	struct timer_list	timer;
+	unsigned int		poll_rate;	/* ms, 0 for no polling */
+	unsigned int		poll_timeout;	/* ms */
+	unsigned long		last_jiffies;	/* chars last taken */
+	bool			polling;
 };
 
 struct pl011_dmatx_data {
@@ -272,13 +281,13 @@ static int pl011_fifo_to_tty(struct uart_amba_port *uap)
 #define PL011_DMA_BUFFER_SIZE PAGE_SIZE
 
 static int pl011_sgbuf_init(struct dma_chan *chan, struct pl011_sgbuf *sg,
-	enum dma_data_direction dir)
+	unsigned int size, enum dma_data_direction dir)
 {
-	sg->buf = kmalloc(PL011_DMA_BUFFER_SIZE, GFP_KERNEL);
+	sg->buf = kmalloc(size, GFP_KERNEL);
 	if (!sg->buf)
 		return -ENOMEM;
 
-	sg_init_one(&sg->sg, sg->buf, PL011_DMA_BUFFER_SIZE);
+	sg_init_one(&sg->sg, sg->buf, size);
 
 	if (dma_map_sg(chan->device->dev, &sg->sg, 1, dir) != 1) {
 		kfree(sg->buf);
@@ -350,6 +359,11 @@ static void pl011_dma_probe_initcall(struct uart_amba_port *uap)
 		dmaengine_slave_config(chan, &rx_conf);
 		uap->dmarx.chan = chan;
 
+		uap->dmarx.buf_size = plat->dma_rx_buf_size ?
+			plat->dma_rx_buf_size : PL011_DMA_BUFFER_SIZE;
+		uap->dmarx.poll_rate = plat->dma_rx_poll_rate;
+		uap->dmarx.poll_timeout = plat->dma_rx_poll_timeout;
+
 		dev_info(uap->port.dev, "DMA channel RX %s\n",
 			 dma_chan_name(uap->dmarx.chan));
 	}
@@ -728,6 +742,7 @@ static int pl011_dma_rx_trigger_dma(struct uart_amba_port *uap)
 	/* Some data to go along to the callback */
 	desc->callback = pl011_dma_rx_callback;
 	desc->callback_param = uap;
+	sgbuf->taken = 0;
 	dmarx->cookie = dmaengine_submit(desc);
 	dma_async_issue_pending(rxchan);
 
@@ -757,6 +772,9 @@ static void pl011_dma_rx_chars(struct uart_amba_port *uap,
 	int dma_count = 0;
 	u32 fifotaken = 0; /* only used for vdbg() */
 
+	/* The poll timer may have taken the start of the buffer already */
+	pending = pending > sgbuf->taken ? pending - sgbuf->taken : 0;
+
 	/* Pick everything from the DMA first */
 	if (pending) {
 		/* Sync in buffer */
@@ -768,11 +786,13 @@ static void pl011_dma_rx_chars(struct uart_amba_port *uap,
 		 * as it can.
 		 */
 		dma_count = tty_insert_flip_string(uap->port.state->port.tty,
-						   sgbuf->buf, pending);
+						   sgbuf->buf + sgbuf->taken,
+						   pending);
 
 		/* Return buffer to device */
 		dma_sync_sg_for_device(dev, &sgbuf->sg, 1, DMA_FROM_DEVICE);
 
+		uap->dmarx.last_jiffies = jiffies;
 		uap->port.icount.rx += dma_count;
 		if (dma_count < pending)
 			dev_warn(uap->port.dev,
@@ -811,12 +831,42 @@ static void pl011_dma_rx_chars(struct uart_amba_port *uap,
 	spin_lock(&uap->port.lock);
 }
 
+/*
+ * On the ST variants the DMA only takes bursts out of the FIFO, so each
+ * pause in the incoming data ends in a receive timeout, at which the job is
+ * stopped, the rest read from the FIFO and a new job started. Timeouts less
+ * than poll_timeout apart mean a stream is coming in: the timeout is then
+ * masked and a timer takes the chars out of the running job every
+ * poll_rate ms instead. The FIFO is only emptied by hand when the DMA has
+ * not moved for a whole poll period, and the timeout comes back once the
+ * line has been idle for poll_timeout.
+ */
+static bool pl011_dma_rx_streaming(struct uart_amba_port *uap)
+{
+	struct pl011_dmarx_data *dmarx = &uap->dmarx;
+
+	return dmarx->poll_rate && !dmarx->polling &&
+		time_before(jiffies, dmarx->last_jiffies +
+			    msecs_to_jiffies(dmarx->poll_timeout));
+}
+
+static void pl011_dma_rx_poll_start(struct uart_amba_port *uap)
+{
+	uap->dmarx.polling = true;
+	uap->im &= ~UART011_RTIM;
+	writew(uap->im, uap->port.membase + UART011_IMSC);
+
+	mod_timer(&uap->dmarx.timer,
+		  jiffies + msecs_to_jiffies(uap->dmarx.poll_rate));
+}
+
 static void pl011_dma_rx_irq(struct uart_amba_port *uap)
 {
 	struct pl011_dmarx_data *dmarx = &uap->dmarx;
 	struct dma_chan *rxchan = dmarx->chan;
 	struct pl011_sgbuf *sgbuf = dmarx->use_buf_b ?
 		&dmarx->sgbuf_b : &dmarx->sgbuf_a;
+	bool streaming = pl011_dma_rx_streaming(uap);
 	size_t pending;
 	struct dma_tx_state state;
 	enum dma_status dmastat;
@@ -839,7 +889,7 @@ static void pl011_dma_rx_irq(struct uart_amba_port *uap)
 	uap->dmarx.running = false;
 
 	pending = sgbuf->sg.length - state.residue;
-	BUG_ON(pending > PL011_DMA_BUFFER_SIZE);
+	BUG_ON(pending > dmarx->buf_size);
 	/* Then we terminate the transfer - we now know our residue */
 	dmaengine_terminate_all(rxchan);
 
@@ -856,7 +906,72 @@ static void pl011_dma_rx_irq(struct uart_amba_port *uap)
 			"fall back to interrupt mode\n");
 		uap->im |= UART011_RXIM;
 		writew(uap->im, uap->port.membase + UART011_IMSC);
+	} else if (streaming) {
+		pl011_dma_rx_poll_start(uap);
+	}
+}
+
+static void pl011_dma_rx_poll(unsigned long data)
+{
+	struct uart_amba_port *uap = (struct uart_amba_port *)data;
+	struct pl011_dmarx_data *dmarx = &uap->dmarx;
+	struct tty_struct *tty = uap->port.state->port.tty;
+	struct device *dev = dmarx->chan->device->dev;
+	struct pl011_sgbuf *sgbuf;
+	struct dma_tx_state state;
+	unsigned long flags;
+	unsigned int pending;
+	int count = 0;
+
+	spin_lock_irqsave(&uap->port.lock, flags);
+	if (!dmarx->polling)
+		goto out;
+	if (!dmarx->running)
+		goto stop;
+
+	sgbuf = dmarx->use_buf_b ? &dmarx->sgbuf_b : &dmarx->sgbuf_a;
+	dmarx->chan->device->device_tx_status(dmarx->chan, dmarx->cookie,
+					      &state);
+	pending = sgbuf->sg.length - state.residue;
+
+	if (pending > sgbuf->taken) {
+		pending -= sgbuf->taken;
+		dma_sync_single_range_for_cpu(dev, sg_dma_address(&sgbuf->sg),
+					      sgbuf->taken, pending,
+					      DMA_FROM_DEVICE);
+		count = tty_insert_flip_string(tty, sgbuf->buf + sgbuf->taken,
+					       pending);
+		dma_sync_single_range_for_device(dev,
+					sg_dma_address(&sgbuf->sg),
+					sgbuf->taken, pending,
+					DMA_FROM_DEVICE);
+		sgbuf->taken += count;
+		uap->port.icount.rx += count;
+		dmarx->last_jiffies = jiffies;
+	} else if (!(readw(uap->port.membase + UART01x_FR) & UART01x_FR_RXFE)) {
+		/* Less than a burst is left waiting in the FIFO */
+		pl011_dma_rx_irq(uap);
+		if (!dmarx->running)
+			goto stop;
+	}
+
+	if (time_before(jiffies, dmarx->last_jiffies +
+			msecs_to_jiffies(dmarx->poll_timeout))) {
+		mod_timer(&dmarx->timer,
+			  jiffies + msecs_to_jiffies(dmarx->poll_rate));
+		goto out;
 	}
+
+stop:
+	/* Back to the receive timeout interrupt */
+	dmarx->polling = false;
+	uap->im |= UART011_RTIM;
+	writew(uap->im, uap->port.membase + UART011_IMSC);
+out:
+	spin_unlock_irqrestore(&uap->port.lock, flags);
+
+	if (count)
+		tty_flip_buffer_push(tty);
 }
 
 static void pl011_dma_rx_callback(void *data)
@@ -878,7 +993,7 @@ static void pl011_dma_rx_callback(void *data)
 	dmarx->use_buf_b = !lastbuf;
 	ret = pl011_dma_rx_trigger_dma(uap);
 
-	pl011_dma_rx_chars(uap, PL011_DMA_BUFFER_SIZE, lastbuf, false);
+	pl011_dma_rx_chars(uap, dmarx->buf_size, lastbuf, false);
 	spin_unlock_irq(&uap->port.lock);
 	/*
 	 * Do this check after we picked the DMA chars so we don't
@@ -902,6 +1017,7 @@ static inline void pl011_dma_rx_stop(struct uart_amba_port *uap)
 	/* FIXME.  Just disable the DMA enable */
 	uap->dmacr &= ~UART011_RXDMAE;
 	writew(uap->dmacr, uap->port.membase + UART011_DMACR);
+	uap->dmarx.polling = false;
 }
 
 static void pl011_dma_startup(struct uart_amba_port *uap)
@@ -929,7 +1045,7 @@ static void pl011_dma_startup(struct uart_amba_port *uap)
 
 	/* Allocate and map DMA RX buffers */
 	ret = pl011_sgbuf_init(uap->dmarx.chan, &uap->dmarx.sgbuf_a,
-			       DMA_FROM_DEVICE);
+			       uap->dmarx.buf_size, DMA_FROM_DEVICE);
 	if (ret) {
 		dev_err(uap->port.dev, "failed to init DMA %s: %d\n",
 			"RX buffer A", ret);
@@ -937,7 +1053,7 @@ static void pl011_dma_startup(struct uart_amba_port *uap)
 	}
 
 	ret = pl011_sgbuf_init(uap->dmarx.chan, &uap->dmarx.sgbuf_b,
-			       DMA_FROM_DEVICE);
+			       uap->dmarx.buf_size, DMA_FROM_DEVICE);
 	if (ret) {
 		dev_err(uap->port.dev, "failed to init DMA %s: %d\n",
 			"RX buffer B", ret);
@@ -947,6 +1063,10 @@ static void pl011_dma_startup(struct uart_amba_port *uap)
 	}
 
 	uap->using_rx_dma = true;
+	uap->dmarx.polling = false;
+	uap->dmarx.last_jiffies = jiffies -
+		msecs_to_jiffies(uap->dmarx.poll_timeout);
+	setup_timer(&uap->dmarx.timer, pl011_dma_rx_poll, (unsigned long)uap);
 
 skip_rx:
 	/* Turn on DMA error (RX/TX will be enabled on demand) */
@@ -981,6 +1101,7 @@ static void pl011_dma_shutdown(struct uart_amba_port *uap)
 	spin_lock_irq(&uap->port.lock);
 	uap->dmacr &= ~(UART011_DMAONERR | UART011_RXDMAE | UART011_TXDMAE);
 	writew(uap->dmacr, uap->port.membase + UART011_DMACR);
+	uap->dmarx.polling = false;
 	spin_unlock_irq(&uap->port.lock);
 
 	if (uap->using_tx_dma) {
@@ -999,6 +1120,7 @@ static void pl011_dma_shutdown(struct uart_amba_port *uap)
 	}
 
 	if (uap->using_rx_dma) {
+		del_timer_sync(&uap->dmarx.timer);
 		dmaengine_terminate_all(uap->dmarx.chan);
 		/* Clean up the RX DMA */
 		pl011_sgbuf_free(uap->dmarx.chan, &uap->dmarx.sgbuf_a,
@@ -31,6 +31,8 @@
 
 #include <linux/atomic.h>
 
+#include <asm/unaligned.h>
+
 #include "u_ether.h"
 #include "rndis.h"
 
@@ -76,6 +78,19 @@
  *   - MS-Windows drivers sometimes emit undocumented requests.
  */
 
+/* Packets per transfer; the host is told the first, the second caps what
+ * goes to the host within the transfer size it asked for.
+ */
+static unsigned int rndis_ul_max_pkt_per_xfer = 3;
+module_param(rndis_ul_max_pkt_per_xfer, uint, S_IRUGO);
+MODULE_PARM_DESC(rndis_ul_max_pkt_per_xfer,
+	"most packets per transfer from the host");
+
+static unsigned int rndis_dl_max_pkt_per_xfer = 10;
+module_param(rndis_dl_max_pkt_per_xfer, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(rndis_dl_max_pkt_per_xfer,
+	"most packets per transfer to the host, 1 for one each");
+
 struct rndis_ep_descs {
 	struct usb_endpoint_descriptor	*in;
 	struct usb_endpoint_descriptor	*out;
@@ -311,14 +326,13 @@ static struct usb_gadget_strings *rndis_strings[] = {
 static struct sk_buff *rndis_add_header(struct gether *port,
 					struct sk_buff *skb)
 {
-	struct sk_buff *skb2;
-
-	skb2 = skb_realloc_headroom(skb, sizeof(struct rndis_packet_msg_type));
-	if (skb2)
-		rndis_add_hdr(skb2);
-
-	dev_kfree_skb_any(skb);
-	return skb2;
+	/* the net device asks for the headroom, so this rarely copies */
+	if (skb_cow_head(skb, sizeof(struct rndis_packet_msg_type))) {
+		dev_kfree_skb_any(skb);
+		return NULL;
+	}
+	rndis_add_hdr(skb);
+	return skb;
 }
 
 static void rndis_response_available(void *_rndis)
@@ -398,6 +412,12 @@ static void rndis_command_complete(struct usb_ep *ep, struct usb_request *req)
 	if (status < 0)
 		ERROR(cdev, "RNDIS command error %d, %d/%d\n",
 			status, req->actual, req->length);
+	else if (get_unaligned_le32(req->buf) == REMOTE_NDIS_INITIALIZE_MSG) {
+		rndis->port.dl_max_pkts_per_xfer = rndis_dl_max_pkt_per_xfer;
+		rndis->port.dl_max_xfer_size =
+			rndis_get_dl_max_xfer_size(rndis->config);
+		gether_update_dl_max_xfer(&rndis->port);
+	}
 //	spin_unlock(&dev->lock);
 }
 
@@ -555,6 +575,7 @@ static void rndis_disable(struct usb_function *f)
 
 	rndis_uninit(rndis->config);
 	gether_disconnect(&rndis->port);
+	rndis->port.dl_max_pkts_per_xfer = 0;
 
 	usb_ep_disable(rndis->notify);
 	rndis->notify->driver_data = NULL;
@@ -706,6 +727,7 @@ rndis_bind(struct usb_configuration *c, struct usb_function *f)
 	rndis->config = status;
 
 	rndis_set_param_medium(rndis->config, NDIS_MEDIUM_802_3, 0);
+	rndis_set_max_pkt_xfer(rndis->config, rndis->port.ul_max_pkts_per_xfer);
 	rndis_set_host_mac(rndis->config, rndis->ethaddr);
 
 	if (rndis_set_param_vendor(rndis->config, rndis->vendorID,
@@ -843,6 +865,9 @@ rndis_bind_config(struct usb_configuration *c, u8 ethaddr[ETH_ALEN],
 	rndis->port.header_len = sizeof(struct rndis_packet_msg_type);
 	rndis->port.wrap = rndis_add_header;
 	rndis->port.unwrap = rndis_rm_hdr;
+	rndis->port.fill_header = rndis_fill_hdr;
+	rndis->port.ul_max_pkts_per_xfer =
+		clamp_t(unsigned int, rndis_ul_max_pkt_per_xfer, 1, 10);
 
 	rndis->port.func.name = "rndis";
 	rndis->port.func.strings = rndis_strings;
@@ -24,6 +24,7 @@
 
 #include <linux/kernel.h>
 #include <linux/gfp.h>
+#include <linux/slab.h>
 #include <linux/device.h>
 #include <linux/ctype.h>
 #include <linux/etherdevice.h>
@@ -77,10 +78,19 @@ struct eth_dev {
 						struct sk_buff *skb,
 						struct sk_buff_head *list);
 
+	/* packets for the host gathered into one transfer, see tx_agg_xmit */
+	struct list_head	tx_agg_free;
+	struct eth_agg		*tx_agg;
+	unsigned		tx_agg_pkts;	/* most per transfer, 0 if off */
+	unsigned		tx_agg_size;
+	bool			tx_agg_alloced;
+	void			(*fill_header)(void *buf, unsigned data_len);
+
 	struct work_struct	work;
 
 	unsigned long		todo;
 #define	WORK_RX_MEMORY		0
+#define	WORK_TX_AGG		1
 
 	bool			zlp;
 	u8			host_mac[ETH_ALEN];
@@ -92,6 +102,16 @@ struct eth_dev {
 
 #define DEFAULT_QLEN	2	/* double buffering by default */
 
+#define TX_AGG_BUFS	4
+#define TX_AGG_SIZE	16384	/* bytes, at most, of one gathered transfer */
+
+struct eth_agg {
+	struct list_head	list;
+	unsigned		len;
+	unsigned		pkts;
+	u8			*buf;
+};
+
 
 #ifdef CONFIG_USB_GADGET_DUALSPEED
 
@@ -235,8 +255,11 @@ rx_submit(struct eth_dev *dev, struct usb_request *req, gfp_t gfp_flags)
 	 * means receivers can't recover lost synch on their own (because
 	 * new packets don't only start after a short RX).
 	 */
-	size += sizeof(struct ethhdr) + dev->net->mtu + RX_EXTRA;
+	size += sizeof(struct ethhdr) + dev->net->mtu;
 	size += dev->port_usb->header_len;
+	if (dev->port_usb->ul_max_pkts_per_xfer > 1)
+		size *= dev->port_usb->ul_max_pkts_per_xfer;
+	size += RX_EXTRA;
 	size += out->maxpacket - 1;
 	size -= size % out->maxpacket;
 
@@ -448,6 +471,48 @@ static void rx_fill(struct eth_dev *dev, gfp_t gfp_flags)
 	spin_unlock_irqrestore(&dev->req_lock, flags);
 }
 
+static void tx_agg_alloc(struct eth_dev *dev)
+{
+	struct eth_agg	*agg;
+	unsigned long	flags;
+	int		i;
+
+	if (dev->tx_agg_alloced)
+		return;
+
+	for (i = 0; i < TX_AGG_BUFS; i++) {
+		agg = kzalloc(sizeof(*agg), GFP_KERNEL);
+		if (!agg)
+			break;
+		agg->buf = kmalloc(TX_AGG_SIZE, GFP_KERNEL);
+		if (!agg->buf) {
+			kfree(agg);
+			break;
+		}
+		spin_lock_irqsave(&dev->req_lock, flags);
+		list_add(&agg->list, &dev->tx_agg_free);
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+	}
+	/* with fewer buffers, more packets just go out on their own */
+	dev->tx_agg_alloced = true;
+}
+
+static void tx_agg_release(struct eth_dev *dev)
+{
+	struct eth_agg	*agg, *next;
+
+	if (dev->tx_agg)
+		list_add(&dev->tx_agg->list, &dev->tx_agg_free);
+	dev->tx_agg = NULL;
+
+	list_for_each_entry_safe(agg, next, &dev->tx_agg_free, list) {
+		list_del(&agg->list);
+		kfree(agg->buf);
+		kfree(agg);
+	}
+	dev->tx_agg_alloced = false;
+}
+
 static void eth_work(struct work_struct *work)
 {
 	struct eth_dev	*dev = container_of(work, struct eth_dev, work);
@@ -457,10 +522,15 @@ static void eth_work(struct work_struct *work)
 			rx_fill(dev, GFP_KERNEL);
 	}
 
+	if (test_and_clear_bit(WORK_TX_AGG, &dev->todo))
+		tx_agg_alloc(dev);
+
 	if (dev->todo)
 		DBG(dev, "work done, flags = 0x%lx\n", dev->todo);
 }
 
+static void tx_agg_flush(struct eth_dev *dev);
+
 static void tx_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	struct sk_buff	*skb = req->context;
@@ -485,10 +555,152 @@ static void tx_complete(struct usb_ep *ep, struct usb_request *req)
 	dev_kfree_skb_any(skb);
 
 	atomic_dec(&dev->tx_qlen);
+	tx_agg_flush(dev);
+	if (netif_carrier_ok(dev->net))
+		netif_wake_queue(dev->net);
+}
+
+static void tx_agg_complete(struct usb_ep *ep, struct usb_request *req)
+{
+	struct eth_agg	*agg = req->context;
+	struct eth_dev	*dev = ep->driver_data;
+
+	switch (req->status) {
+	default:
+		dev->net->stats.tx_errors++;
+		VDBG(dev, "tx err %d\n", req->status);
+		/* FALLTHROUGH */
+	case -ECONNRESET:		/* unlink */
+	case -ESHUTDOWN:		/* disconnect etc */
+		break;
+	case 0:
+		dev->net->stats.tx_bytes += agg->len
+			- agg->pkts * dev->header_len;
+	}
+	dev->net->stats.tx_packets += agg->pkts;
+
+	spin_lock(&dev->req_lock);
+	list_add(&req->list, &dev->tx_reqs);
+	list_add(&agg->list, &dev->tx_agg_free);
+	spin_unlock(&dev->req_lock);
+
+	atomic_dec(&dev->tx_qlen);
+	tx_agg_flush(dev);
 	if (netif_carrier_ok(dev->net))
 		netif_wake_queue(dev->net);
 }
 
+/* Sends the packets gathered so far, if a request is free for them */
+static void tx_agg_flush(struct eth_dev *dev)
+{
+	struct usb_request	*req;
+	struct eth_agg		*agg;
+	struct usb_ep		*in = NULL;
+	unsigned long		flags;
+	unsigned		length;
+
+	spin_lock_irqsave(&dev->lock, flags);
+	if (dev->port_usb)
+		in = dev->port_usb->in_ep;
+	spin_unlock_irqrestore(&dev->lock, flags);
+	if (!in)
+		return;
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	agg = dev->tx_agg;
+	if (!agg || list_empty(&dev->tx_reqs)) {
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+		return;
+	}
+	dev->tx_agg = NULL;
+	req = container_of(dev->tx_reqs.next, struct usb_request, list);
+	list_del(&req->list);
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+
+	/* tx_agg_size leaves room for the byte of zlp framing */
+	length = agg->len;
+	if (!dev->zlp && (length % in->maxpacket) == 0)
+		length++;
+
+	req->buf = agg->buf;
+	req->context = agg;
+	req->complete = tx_agg_complete;
+	req->zero = 1;
+	req->length = length;
+	req->no_interrupt = 0;
+
+	if (usb_ep_queue(in, req, GFP_ATOMIC)) {
+		DBG(dev, "tx queue err\n");
+		dev->net->stats.tx_dropped += agg->pkts;
+		spin_lock_irqsave(&dev->req_lock, flags);
+		list_add(&req->list, &dev->tx_reqs);
+		list_add(&agg->list, &dev->tx_agg_free);
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+		return;
+	}
+	dev->net->trans_start = jiffies;
+	atomic_inc(&dev->tx_qlen);
+}
+
+/*
+ * While transfers to the host are in flight, packets are copied one after
+ * the other into a buffer that goes out as a single transfer once one of
+ * them completes, or once the buffer holds as many packets or bytes as the
+ * host takes. A packet on an idle link still goes out on its own at once.
+ *
+ * Returns 0 when it took @skb, -EBUSY when the queue has to wait for a
+ * completion, and -EAGAIN when @skb is to go out on its own.
+ */
+static int tx_agg_xmit(struct eth_dev *dev, struct sk_buff *skb)
+{
+	unsigned	len = dev->header_len + skb->len;
+	struct eth_agg	*agg;
+	unsigned long	flags;
+	bool		full;
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	agg = dev->tx_agg;
+	if (agg && (agg->pkts >= dev->tx_agg_pkts
+			|| agg->len + len > dev->tx_agg_size)) {
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+		tx_agg_flush(dev);
+		spin_lock_irqsave(&dev->req_lock, flags);
+		if (dev->tx_agg) {
+			spin_unlock_irqrestore(&dev->req_lock, flags);
+			return -EBUSY;
+		}
+		agg = NULL;
+	}
+	if (!agg) {
+		/* tx_complete flushes what is gathered while tx_qlen > 0 */
+		if (!atomic_read(&dev->tx_qlen) || len > dev->tx_agg_size
+				|| list_empty(&dev->tx_agg_free)) {
+			spin_unlock_irqrestore(&dev->req_lock, flags);
+			return -EAGAIN;
+		}
+		agg = list_first_entry(&dev->tx_agg_free, struct eth_agg,
+				       list);
+		list_del(&agg->list);
+		agg->len = 0;
+		agg->pkts = 0;
+		dev->tx_agg = agg;
+	}
+
+	dev->fill_header(agg->buf + agg->len, skb->len);
+	skb_copy_bits(skb, 0, agg->buf + agg->len + dev->header_len,
+		      skb->len);
+	agg->len += len;
+	agg->pkts++;
+	full = agg->pkts >= dev->tx_agg_pkts
+		|| agg->len + len > dev->tx_agg_size;
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+
+	dev_kfree_skb_any(skb);
+	if (full)
+		tx_agg_flush(dev);
+	return 0;
+}
+
 static inline int is_promisc(u16 cdc_filter)
 {
 	return cdc_filter & USB_CDC_PACKET_TYPE_PROMISCUOUS;
@@ -542,6 +754,16 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		/* ignores USB_CDC_PACKET_TYPE_DIRECTED */
 	}
 
+	if (dev->tx_agg_pkts) {
+		switch (tx_agg_xmit(dev, skb)) {
+		case 0:
+			return NETDEV_TX_OK;
+		case -EBUSY:
+			netif_stop_queue(net);
+			return NETDEV_TX_BUSY;
+		}
+	}
+
 	spin_lock_irqsave(&dev->req_lock, flags);
 	/*
 	 * this freelist can be empty if an interrupt triggered disconnect()
@@ -802,6 +1024,7 @@ int gether_setup_name(struct usb_gadget *g, u8 ethaddr[ETH_ALEN],
 	INIT_WORK(&dev->work, eth_work);
 	INIT_LIST_HEAD(&dev->tx_reqs);
 	INIT_LIST_HEAD(&dev->rx_reqs);
+	INIT_LIST_HEAD(&dev->tx_agg_free);
 
 	skb_queue_head_init(&dev->rx_frames);
 
@@ -857,6 +1080,7 @@ void gether_cleanup(void)
 
 	unregister_netdev(the_dev->net);
 	flush_work_sync(&the_dev->work);
+	tx_agg_release(the_dev);
 	free_netdev(the_dev->net);
 
 	the_dev = NULL;
@@ -913,6 +1137,10 @@ struct net_device *gether_connect(struct gether *link)
 		dev->header_len = link->header_len;
 		dev->unwrap = link->unwrap;
 		dev->wrap = link->wrap;
+		dev->fill_header = link->fill_header;
+
+		/* RNDIS needs room to push its header in front of packets */
+		dev->net->needed_headroom = link->header_len;
 
 		spin_lock(&dev->lock);
 		dev->port_usb = link;
@@ -926,6 +1154,9 @@ struct net_device *gether_connect(struct gether *link)
 		}
 		spin_unlock(&dev->lock);
 
+		/* the host may have told RNDIS its limits already */
+		gether_update_dl_max_xfer(link);
+
 		netif_carrier_on(dev->net);
 		if (netif_running(dev->net))
 			eth_start(dev, GFP_ATOMIC);
@@ -974,6 +1205,12 @@ void gether_disconnect(struct gether *link)
 	 */
 	usb_ep_disable(link->in_ep);
 	spin_lock(&dev->req_lock);
+	dev->tx_agg_pkts = 0;
+	if (dev->tx_agg) {
+		dev->net->stats.tx_dropped += dev->tx_agg->pkts;
+		list_add(&dev->tx_agg->list, &dev->tx_agg_free);
+		dev->tx_agg = NULL;
+	}
 	while (!list_empty(&dev->tx_reqs)) {
 		req = container_of(dev->tx_reqs.next,
 					struct usb_request, list);
@@ -1006,9 +1243,49 @@ void gether_disconnect(struct gether *link)
 	dev->header_len = 0;
 	dev->unwrap = NULL;
 	dev->wrap = NULL;
+	dev->fill_header = NULL;
+	dev->net->needed_headroom = 0;
 
 	spin_lock(&dev->lock);
 	dev->port_usb = NULL;
 	link->ioport = NULL;
 	spin_unlock(&dev->lock);
 }
+
+/**
+ * gether_update_dl_max_xfer - let packets to the host share transfers
+ * @link: the USB link, on which gether_connect() was called
+ * Context: irqs blocked
+ *
+ * This is called once the function and the host agreed on the most
+ * packets, link->dl_max_pkts_per_xfer, and the most bytes,
+ * link->dl_max_xfer_size, of one transfer to the host. One packet per
+ * transfer, or no fill_header() hook, turns gathering packets off.
+ */
+void gether_update_dl_max_xfer(struct gether *link)
+{
+	struct eth_dev		*dev = link->ioport;
+	unsigned long		flags;
+	unsigned		size;
+
+	if (!dev)
+		return;
+
+	size = min_t(unsigned, link->dl_max_xfer_size, TX_AGG_SIZE);
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	if (link->dl_max_pkts_per_xfer > 1 && dev->fill_header
+			&& size > 2 * (dev->header_len + ETH_FRAME_LEN)) {
+		/* one byte is kept for zlp framing */
+		dev->tx_agg_size = size - 1;
+		dev->tx_agg_pkts = link->dl_max_pkts_per_xfer;
+	} else {
+		dev->tx_agg_pkts = 0;
+	}
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+
+	DBG(dev, "tx aggregation %u pkts, %u bytes\n",
+		dev->tx_agg_pkts, dev->tx_agg_size);
+	if (dev->tx_agg_pkts && !dev->tx_agg_alloced)
+		defer_kevent(dev, WORK_TX_AGG);
+}
@@ -274,10 +274,16 @@ static int ux500_dma_is_compatible(struct dma_channel *channel,
 	if (length < Ux500_USB_DMA_MIN_TRANSFER_SIZE)
 		return 0;
 
+	/* the channel moves words from word aligned buffers only */
+	if ((unsigned long)buf & 0x3)
+		return 0;
+
 	list_for_each_entry(f, &cdev->config->functions, list) {
+		/* "mtp" moves whole files, so its endpoints do use DMA, and
+		 * so does "rndis": the packets it gathers for the host start
+		 * aligned, single packets and those from the host don't.
+		 */
 		if (!strcmp(f->name, "cdc_ethernet") ||
-			!strcmp(f->name, "rndis") ||
-			!strcmp(f->name, "mtp") ||
 			!strcmp(f->name, "phonet") ||
 			!strcmp(f->name, "adb") ||
 			!strncmp(f->name, "acm", 3)) {
@@ -36,6 +36,9 @@
 #include <linux/err.h>
 #include <linux/hwmem.h>
 #include <linux/kref.h>
+#ifdef CONFIG_B2R2_FENCE
+#include <linux/sw_sync.h>
+#endif
 
 #include "b2r2_internal.h"
 #include "b2r2_control.h"
@@ -312,6 +315,57 @@ static int limit_blits(int n_split, struct b2r2_blt_req *user_req)
 	return n_split;
 }
 
+/**
+ * Estimate the cost of a request, in pixels read and written
+ */
+static u32 request_cost(struct b2r2_blt_req *user_req)
+{
+	u32 cost = (u32)user_req->dst_rect.width *
+			(u32)user_req->dst_rect.height;
+
+	if (!(user_req->flags & (B2R2_BLT_FLAG_SOURCE_FILL |
+			B2R2_BLT_FLAG_SOURCE_FILL_RAW)))
+		cost += (u32)user_req->src_rect.width *
+				(u32)user_req->src_rect.height;
+
+	if (user_req->flags & B2R2_BLT_FLAG_BG_BLEND)
+		cost += (u32)user_req->bg_rect.width *
+				(u32)user_req->bg_rect.height;
+
+	return cost;
+}
+
+/**
+ * Choose the core of a request executed on one core. A handle keeps
+ * using the core it has requests active on, so that its jobs stay in
+ * order, else the core with the least work ahead of it is taken.
+ */
+static int pick_core(struct b2r2_control_instance **ctl, int count)
+{
+	int i;
+	int best = 0;
+	u64 best_load = ULLONG_MAX;
+
+	for (i = 0; i < count; i++) {
+		bool active;
+		u64 load;
+
+		mutex_lock(&ctl[i]->lock);
+		active = ctl[i]->no_of_active_requests != 0;
+		mutex_unlock(&ctl[i]->lock);
+		if (active)
+			return i;
+
+		load = b2r2_core_get_load(ctl[i]->control);
+		if (load < best_load) {
+			best = i;
+			best_load = load;
+		}
+	}
+
+	return best;
+}
+
 /**
  * Check if the format inherently requires the b2r2 scaling engine to be active
  */
@@ -716,6 +770,7 @@ static int b2r2_alloc_request(struct b2r2_blt_req *user_req,
 
 	/* Initialize the structure */
 	INIT_LIST_HEAD(&request->list);
+	INIT_LIST_HEAD(&request->batch);
 
 	/*
 	 * If the user specified a color look-up table,
@@ -761,12 +816,133 @@ exit:
 	return ret;
 }
 
+/**
+ * struct b2r2_blt_fences - The sync fences of a blit request
+ *
+ * @in: Fence the request is held back for, or NULL
+ * @out: Fence signalled when the request is done, returned
+ */
+struct b2r2_blt_fences {
+	struct sync_fence *in;
+	struct sync_fence *out;
+};
+
+#ifdef CONFIG_B2R2_FENCE
+/**
+ * Create a fence signalled when its timeline is incremented to 1.
+ */
+static struct sync_fence *create_fence(struct sw_sync_timeline **timeline_out)
+{
+	struct sw_sync_timeline *timeline;
+	struct sync_pt *pt;
+	struct sync_fence *fence;
+
+	timeline = sw_sync_timeline_create("b2r2");
+	if (timeline == NULL)
+		return NULL;
+
+	pt = sw_sync_pt_create(timeline, 1);
+	if (pt == NULL)
+		goto pt_failed;
+
+	fence = sync_fence_create("b2r2", pt);
+	if (fence == NULL)
+		goto fence_failed;
+
+	*timeline_out = timeline;
+	return fence;
+
+fence_failed:
+	sync_pt_free(pt);
+pt_failed:
+	sync_timeline_destroy(&timeline->obj);
+	return NULL;
+}
+
+/**
+ * Give the split requests the fences of the request. The output fence
+ * signals when all of them are done.
+ */
+static int attach_fences(struct b2r2_blt_fences *fences,
+		struct b2r2_blt_request **requests, int count)
+{
+	int i;
+	struct sync_fence *out = NULL;
+
+	for (i = 0; i < count; i++) {
+		struct sync_fence *fence;
+		struct sync_fence *merged;
+
+		fence = create_fence(&requests[i]->timeline);
+		if (fence == NULL)
+			goto fence_failed;
+
+		if (out == NULL) {
+			out = fence;
+			continue;
+		}
+
+		merged = sync_fence_merge("b2r2", out, fence);
+		sync_fence_put(fence);
+		sync_fence_put(out);
+		out = merged;
+		if (out == NULL) {
+			i++;
+			goto fence_failed;
+		}
+	}
+
+	if (fences->in != NULL) {
+		for (i = 0; i < count; i++) {
+			get_file(fences->in->file);
+			requests[i]->in_fence = fences->in;
+		}
+	}
+
+	fences->out = out;
+
+	return 0;
+
+fence_failed:
+	while (i-- > 0) {
+		sync_timeline_destroy(&requests[i]->timeline->obj);
+		requests[i]->timeline = NULL;
+	}
+	if (out != NULL)
+		sync_fence_put(out);
+
+	return -ENOMEM;
+}
+
+/**
+ * Return a fence for a request already done.
+ */
+static int signalled_fence(struct b2r2_blt_fences *fences)
+{
+	struct sw_sync_timeline *timeline;
+
+	fences->out = create_fence(&timeline);
+	if (fences->out == NULL)
+		return -ENOMEM;
+
+	sw_sync_timeline_inc(timeline, 1);
+	sync_timeline_destroy(&timeline->obj);
+
+	return 0;
+}
+#endif
+
 /**
  * Do the blit job split on available cores.
+ *
+ * @req: The request, in kernel memory
+ * @us_req: true if the pointers of @req are user space pointers
+ * @fences: The sync fences of the request, or NULL
  */
-static int b2r2_blt_blit_internal(int handle,
-		struct b2r2_blt_req *user_req,
-		bool us_req)
+static int b2r2_blt_blit_req(int handle,
+		struct b2r2_blt_req *req,
+		bool us_req,
+		struct b2r2_blt_fences *fences)
 {
 	int request_id;
 	int i;
@@ -796,18 +972,7 @@ static int b2r2_blt_blit_internal(int handle,
 		return -ENOSYS;
 	}
 
-	/* Get the user data */
-	if (us_req) {
-		if (copy_from_user(&ureq, user_req, sizeof(ureq))) {
-			b2r2_log_err(b2r2_blt->dev,
-				"%s: copy_from_user failed\n",
-				__func__);
-			ret = -EFAULT;
-			goto exit;
-		}
-	} else {
-		memcpy(&ureq, user_req, sizeof(ureq));
-	}
+	memcpy(&ureq, req, sizeof(ureq));
 
 	/*
 	 * B2R2 cannot handle destination clipping on buffers
@@ -838,6 +1003,12 @@ static int b2r2_blt_blit_internal(int handle,
 	n_blit = 1;
 #endif
 
+	/* Balance the requests not split over the cores */
+	if (n_blit == 1 && n_instance > 1) {
+		i = pick_core(ctl, n_instance);
+		swap(ctl[0], ctl[i]);
+	}
+
 	for (i = 0; i < n_blit; i++) {
 		ret = b2r2_alloc_request(&ureq, us_req, &split_requests[i]);
 		if (ret < 0 || !split_requests[i]) {
@@ -866,6 +1037,10 @@ static int b2r2_blt_blit_internal(int handle,
 		goto exit;
 	}
 
+	for (i = 0; i < n_blit; i++)
+		split_requests[i]->job.cost =
+			request_cost(&split_requests[i]->user_req);
+
 #ifdef CONFIG_B2R2_GENERIC_ONLY
 	if (ureq.flags & B2R2_BLT_FLAG_BG_BLEND) {
 		/*
@@ -882,6 +1057,17 @@ static int b2r2_blt_blit_internal(int handle,
 		/* Use the generic path for all operations */
 	ret = b2r2_generic_blt(split_requests[0]);
 #else
+#ifdef CONFIG_B2R2_FENCE
+	if (fences != NULL && !(ureq.flags & B2R2_BLT_FLAG_DRY_RUN)) {
+		ret = attach_fences(fences, split_requests, n_blit);
+		if (ret < 0) {
+			for (i = 0; i < n_blit; i++)
+				b2r2_free_request(split_requests[i]);
+			goto exit;
+		}
+	}
+#endif
+
 	/* Call each blitter control */
 	for (i = 0; i < n_blit; i++) {
 		ret = b2r2_control_blt(split_requests[i]);
@@ -911,6 +1097,11 @@ static int b2r2_blt_blit_internal(int handle,
 			 */
 			if (split_requests[j]->instance->control->bypass)
 				continue;
+#ifdef CONFIG_B2R2_FENCE
+			/* The held back jobs are released when added */
+			if (fences != NULL && fences->in != NULL)
+				continue;
+#endif
 			rtmp = b2r2_control_waitjob(split_requests[j]);
 			if (rtmp < 0) {
 				b2r2_log_err(b2r2_blt->dev,
@@ -922,6 +1113,13 @@ static int b2r2_blt_blit_internal(int handle,
 			ret = (ret >= 0) ? rtmp : ret;
 		}
 	}
+#ifdef CONFIG_B2R2_FENCE
+	/* Signalled with an error by the released requests */
+	if (ret < 0 && fences != NULL && fences->out != NULL) {
+		sync_fence_put(fences->out);
+		fences->out = NULL;
+	}
+#endif
 #endif
 #ifdef CONFIG_B2R2_GENERIC_FALLBACK
 	if (ret == -ENOSYS) {
@@ -937,6 +1135,15 @@ static int b2r2_blt_blit_internal(int handle,
 			goto exit;
 		}
 
+#ifdef CONFIG_B2R2_FENCE
+		/* The generic path is synchronous, wait here */
+		if (fences != NULL && fences->in != NULL) {
+			ret = sync_fence_wait(fences->in, -1);
+			if (ret < 0)
+				goto exit;
+		}
+#endif
+
 		b2r2_log_info(b2r2_blt->dev,
 			"b2r2_blt=%d Going generic.\n", ret);
 		ret = b2r2_alloc_request(&ureq, us_req, &request_gen);
@@ -953,12 +1160,19 @@ static int b2r2_blt_blit_internal(int handle,
 		memcpy(&request_gen->user_req, &ureq,
 				sizeof(request_gen->user_req));
 		request_gen->core_mask = 1;
+		if (n_instance > 1)
+			request_gen->aux_control = ctl[1]->control;
 		request_gen->job.job_id = request_id;
 		request_gen->job.data = (int) ctl[0]->control->data;
 
 		ret = b2r2_generic_blt(request_gen);
 		b2r2_log_info(b2r2_blt->dev, "\nb2r2_generic_blt=%d "
 			"Generic done.\n", ret);
+#ifdef CONFIG_B2R2_FENCE
+		if (ret >= 0 && fences != NULL &&
+				!(ureq.flags & B2R2_BLT_FLAG_DRY_RUN))
+			ret = signalled_fence(fences);
+#endif
 	}
 #endif
 exit:
@@ -969,6 +1183,279 @@ exit:
 	return ret;
 }
 
+static int b2r2_blt_blit_internal(int handle,
+		struct b2r2_blt_req *user_req,
+		bool us_req)
+{
+	struct b2r2_blt_req ureq;
+
+	/* Get the user data */
+	if (us_req) {
+		if (copy_from_user(&ureq, user_req, sizeof(ureq))) {
+			b2r2_log_err(b2r2_blt->dev,
+				"%s: copy_from_user failed\n",
+				__func__);
+			return -EFAULT;
+		}
+	} else {
+		memcpy(&ureq, user_req, sizeof(ureq));
+	}
+
+	return b2r2_blt_blit_req(handle, &ureq, us_req, NULL);
+}
+
+#ifdef CONFIG_B2R2_FENCE
+/**
+ * Do a blit job synchronized through sync fences.
+ *
+ * @ufreq: User space pointer to the fenced request
+ */
+static int b2r2_blt_fence_internal(int handle,
+		struct b2r2_blt_fence_req __user *ufreq)
+{
+	int ret;
+	int fd;
+	struct b2r2_blt_fence_req freq;
+	struct b2r2_blt_req ureq;
+	struct b2r2_blt_fences fences = { NULL, NULL };
+
+	if (copy_from_user(&freq, ufreq, sizeof(freq))) {
+		b2r2_log_err(b2r2_blt->dev,
+			"%s: copy_from_user failed\n",
+			__func__);
+		return -EFAULT;
+	}
+	if (freq.size != sizeof(freq))
+		return -EINVAL;
+
+	if (copy_from_user(&ureq, freq.req, sizeof(ureq))) {
+		b2r2_log_err(b2r2_blt->dev,
+			"%s: copy_from_user failed\n",
+			__func__);
+		return -EFAULT;
+	}
+
+	if (freq.in_fence >= 0) {
+		fences.in = sync_fence_fdget(freq.in_fence);
+		if (fences.in == NULL)
+			return -EINVAL;
+
+		/* Only asynchronous requests are held back in the driver */
+		if ((ureq.flags & B2R2_BLT_FLAG_ASYNCH) == 0) {
+			ret = sync_fence_wait(fences.in, -1);
+			sync_fence_put(fences.in);
+			fences.in = NULL;
+			if (ret < 0)
+				return ret;
+		}
+	}
+
+	fd = get_unused_fd();
+	if (fd < 0) {
+		ret = fd;
+		goto exit;
+	}
+
+	ret = b2r2_blt_blit_req(handle, &ureq, true, &fences);
+
+	/* No fence for a dry run */
+	if (fences.out == NULL) {
+		put_unused_fd(fd);
+		fd = -1;
+	}
+
+	if (put_user(fd, &ufreq->out_fence)) {
+		if (fences.out != NULL) {
+			put_unused_fd(fd);
+			sync_fence_put(fences.out);
+		}
+		ret = -EFAULT;
+		goto exit;
+	}
+
+	if (fences.out != NULL)
+		sync_fence_install(fences.out, fd);
+
+exit:
+	if (fences.in != NULL)
+		sync_fence_put(fences.in);
+
+	return ret;
+}
+#endif
+
+/**
+ * Run the requests of a batch one by one, each waited for before the next
+ * one is started to keep the order.
+ */
+static int b2r2_blt_batch_one_by_one(int handle,
+		struct b2r2_blt_req *ureqs, int count, bool us_req)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (i < count - 1)
+			ureqs[i].flags &= ~B2R2_BLT_FLAG_ASYNCH;
+
+		ret = b2r2_blt_blit_req(handle, &ureqs[i], us_req, NULL);
+		if (ret < 0)
+			break;
+	}
+
+	return ret;
+}
+
+#ifndef CONFIG_B2R2_GENERIC_ONLY
+/**
+ * Chain the requests of a batch into one job on the given core.
+ */
+static int b2r2_blt_batch_submit(struct b2r2_control_instance *ctl,
+		struct b2r2_blt_req *ureqs, int count, bool us_req)
+{
+	int request_id;
+	int i;
+	int ret = 0;
+	u32 cost = 0;
+	struct b2r2_blt_request *requests[B2R2_BLT_MAX_BATCH];
+
+	/* The id needs to be universal on all cores */
+	request_id = get_next_job_id();
+
+	for (i = 0; i < count; i++) {
+		ret = b2r2_alloc_request(&ureqs[i], us_req, &requests[i]);
+		if (ret < 0 || !requests[i]) {
+			b2r2_log_err(b2r2_blt->dev, "%s: Failed to alloc mem\n",
+				__func__);
+			while (i-- > 0)
+				b2r2_free_request(requests[i]);
+			return -ENOMEM;
+		}
+		requests[i]->instance = ctl;
+		requests[i]->core_mask = (1 << ctl->control_id);
+		requests[i]->job.job_id = request_id;
+		requests[i]->job.data = (int) ctl->control->data;
+		cost += request_cost(&ureqs[i]);
+	}
+
+	/* The batch is one job, the one of the last request */
+	requests[count - 1]->job.cost = cost;
+
+	/* Consumes the requests */
+	ret = b2r2_control_blt_batch(requests, count);
+	if (ret < 0)
+		return ret;
+
+	/* Nothing was added for a dry run */
+	if (ret == 0) {
+		ret = b2r2_control_waitjob(requests[count - 1]);
+		if (ret < 0) {
+			b2r2_log_err(b2r2_blt->dev,
+				"%s: b2r2_control_waitjob failed.\n",
+				__func__);
+			return ret;
+		}
+	}
+
+	return request_id;
+}
+#endif
+
+/**
+ * Do a batch of blit jobs as one job on one core.
+ */
+static int b2r2_blt_batch_internal(int handle,
+		struct b2r2_blt_req *user_reqs, int count,
+		bool us_req)
+{
+	int i;
+	int n_instance = 0;
+	int ret = 0;
+	u32 dry_run = 0;
+	struct b2r2_blt_data *blt_data;
+	struct b2r2_blt_req *ureqs;
+	struct b2r2_control_instance *ctl[B2R2_MAX_NBR_DEVICES];
+
+	if (count < 1 || count > B2R2_BLT_MAX_BATCH)
+		return -EINVAL;
+
+	blt_data = get_data(handle);
+	if (blt_data == NULL) {
+		b2r2_log_warn(b2r2_blt->dev,
+			"%s, blitter instance not found (handle=%d)\n",
+			__func__, handle);
+		return -ENOSYS;
+	}
+
+	ureqs = kmalloc(count * sizeof(*ureqs), GFP_KERNEL);
+	if (ureqs == NULL)
+		return -ENOMEM;
+
+	/* Get the b2r2 core controls for the job */
+	get_control_instances(blt_data, ctl, B2R2_MAX_NBR_DEVICES, &n_instance);
+	if (n_instance == 0) {
+		b2r2_log_err(b2r2_blt->dev, "%s: No b2r2 cores available.\n",
+			__func__);
+		ret = -ENOSYS;
+		goto exit;
+	}
+
+	/* Get the user data */
+	if (us_req) {
+		if (copy_from_user(ureqs, user_reqs,
+				count * sizeof(*ureqs))) {
+			b2r2_log_err(b2r2_blt->dev,
+				"%s: copy_from_user failed\n",
+				__func__);
+			ret = -EFAULT;
+			goto exit;
+		}
+	} else {
+		memcpy(ureqs, user_reqs, count * sizeof(*ureqs));
+	}
+
+	for (i = 0; i < count; i++) {
+		/* See b2r2_blt_blit_internal */
+		b2r2_recalculate_rects(b2r2_blt->dev, &ureqs[i]);
+
+		if (!b2r2_validate_user_req(b2r2_blt->dev, &ureqs[i])) {
+			b2r2_log_warn(b2r2_blt->dev,
+				"%s: b2r2_validate_user_req failed.\n",
+				__func__);
+			ret = -EINVAL;
+			goto exit;
+		}
+
+		dry_run |= ureqs[i].flags & B2R2_BLT_FLAG_DRY_RUN;
+	}
+
+	/* The batch is waited for and reported as its last request */
+	for (i = 0; i < count; i++) {
+		if (i < count - 1)
+			ureqs[i].flags &= ~(B2R2_BLT_FLAG_REPORT_WHEN_DONE |
+				B2R2_BLT_FLAG_REPORT_PERFORMANCE);
+		ureqs[i].flags |= dry_run;
+	}
+
+#ifdef CONFIG_B2R2_GENERIC_ONLY
+	ret = -ENOSYS;
+#else
+	ret = b2r2_blt_batch_submit(ctl[pick_core(ctl, n_instance)], ureqs,
+			count, us_req);
+#endif
+
+	/* No optimized path for some request */
+	if (ret == -ENOSYS)
+		ret = b2r2_blt_batch_one_by_one(handle, ureqs, count,
+				us_req);
+
+exit:
+	release_control_instances(ctl, n_instance);
+	kfree(ureqs);
+
+	return ret;
+}
+
 /**
  * Free the memory used for the b2r2_blt device
  */
@@ -1131,6 +1618,40 @@ exit:
 }
 EXPORT_SYMBOL(b2r2_blt_request);
 
+int b2r2_blt_request_batch(int handle,
+		struct b2r2_blt_req *user_reqs, int count)
+{
+	int ret = 0;
+	int i;
+
+	if (!atomic_inc_not_zero(&blt_refcount.refcount))
+		return -ENOSYS;
+
+	b2r2_core_on_reset_completion_wait();
+
+	/* Exclude some currently unsupported cases */
+	for (i = 0; i < count; i++) {
+		if ((user_reqs[i].flags & B2R2_BLT_FLAG_REPORT_WHEN_DONE) ||
+				(user_reqs[i].flags &
+					B2R2_BLT_FLAG_REPORT_PERFORMANCE) ||
+				(user_reqs[i].report1 != 0)) {
+			b2r2_log_err(b2r2_blt->dev,
+				"%s No callback support in the kernel API\n",
+				__func__);
+			ret = -ENOSYS;
+			goto exit;
+		}
+	}
+
+	ret = b2r2_blt_batch_internal(handle, user_reqs, count, false);
+
+exit:
+	kref_put(&blt_refcount, b2r2_blt_release);
+
+	return ret;
+}
+EXPORT_SYMBOL(b2r2_blt_request_batch);
+
 int b2r2_blt_synch(int handle, int request_id)
 {
 	int ret = 0;
@@ -1270,6 +1791,37 @@ static long b2r2_blt_ioctl_us(struct file *file,
 		break;
 	}
 
+	case B2R2_BLT_BATCH_IOC: {
+		/* arg is user pointer to struct b2r2_blt_batch */
+		struct b2r2_blt_batch batch;
+
+		if (copy_from_user(&batch, (void *)arg, sizeof(batch))) {
+			b2r2_log_err(b2r2_blt->dev,
+				"%s: copy_from_user failed\n",
+				__func__);
+			ret = -EFAULT;
+			goto exit;
+		}
+		if (batch.size != sizeof(batch)) {
+			ret = -EINVAL;
+			goto exit;
+		}
+
+		ret = b2r2_blt_batch_internal(handle, batch.reqs,
+				batch.count, true);
+		break;
+	}
+
+	case B2R2_BLT_FENCE_IOC:
+		/* arg is user pointer to struct b2r2_blt_fence_req */
+#ifdef CONFIG_B2R2_FENCE
+		ret = b2r2_blt_fence_internal(handle,
+				(struct b2r2_blt_fence_req __user *) arg);
+#else
+		ret = -ENOSYS;
+#endif
+		break;
+
 	case B2R2_BLT_SYNCH_IOC:
 		/* arg is request_id */
 		ret = b2r2_blt_synch(handle, (int) arg);
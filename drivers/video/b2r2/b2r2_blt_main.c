@@ -29,12 +29,16 @@
 #include <linux/debugfs.h>
 #endif
 #include <asm/cacheflush.h>
+#include <asm/smp_plat.h>
 #include <linux/smp.h>
 #include <linux/dma-mapping.h>
 #include <linux/sched.h>
 #include <linux/err.h>
 #include <linux/hwmem.h>
 #include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <trace/events/b2r2.h>
 
 #include "b2r2_internal.h"
 #include "b2r2_control.h"
@@ -68,10 +72,23 @@ static void inc_stat(struct b2r2_control *cont, unsigned long *stat);
 static void dec_stat(struct b2r2_control *cont, unsigned long *stat);
 
 #ifndef CONFIG_B2R2_GENERIC_ONLY
+static void record_stage(struct b2r2_control *cont, enum b2r2_stage stage,
+		s64 nsec);
+static s64 request_stage(struct b2r2_blt_request *request,
+		enum b2r2_stage stage);
 static void job_callback(struct b2r2_core_job *job);
 static void job_release(struct b2r2_core_job *job);
 static int job_acquire_resources(struct b2r2_core_job *job, bool atomic);
 static void job_release_resources(struct b2r2_core_job *job, bool atomic);
+static void job_callback_batch(struct b2r2_core_job *job);
+static void job_release_batch(struct b2r2_core_job *job);
+static int job_acquire_resources_batch(struct b2r2_core_job *job, bool atomic);
+static void job_release_resources_batch(struct b2r2_core_job *job,
+		bool atomic);
+#endif
+
+#ifdef CONFIG_B2R2_FENCE
+static void cancel_held_jobs(struct b2r2_control_instance *instance);
 #endif
 
 #ifdef CONFIG_B2R2_GENERIC
@@ -171,6 +188,49 @@ static void clean_l1_cache_range_all_cpus(struct sync_args *sa)
 }
 #endif
 
+/**
+ * flush_l1_cache_range() - Cleans and invalidates L1 cache for all CPU:s
+ *
+ * Maintenance by virtual address is broadcast by the hardware to the other
+ * CPU:s on ARMv7 SMP, only the CPU:s not doing that need the IPI.
+ *
+ * @cont: The b2r2 control
+ * @sa: Pointer to sync_args structure
+ */
+static void flush_l1_cache_range(struct b2r2_control *cont,
+		struct sync_args *sa)
+{
+#ifdef CONFIG_SMP
+	if (cache_ops_need_broadcast()) {
+		inc_stat(cont, &cont->stat_n_cache_ipis);
+		flush_l1_cache_range_all_cpus(sa);
+		return;
+	}
+#endif
+	flush_l1_cache_range_curr_cpu(sa);
+}
+
+/**
+ * clean_l1_cache_range() - Cleans L1 cache for all CPU:s
+ *
+ * See flush_l1_cache_range()
+ *
+ * @cont: The b2r2 control
+ * @sa: Pointer to sync_args structure
+ */
+static void clean_l1_cache_range(struct b2r2_control *cont,
+		struct sync_args *sa)
+{
+#ifdef CONFIG_SMP
+	if (cache_ops_need_broadcast()) {
+		inc_stat(cont, &cont->stat_n_cache_ipis);
+		clean_l1_cache_range_all_cpus(sa);
+		return;
+	}
+#endif
+	clean_l1_cache_range_curr_cpu(sa);
+}
+
 /**
  * b2r2_blt_open - Implements file open on the b2r2_blt device
  *
@@ -191,6 +251,9 @@ int b2r2_control_open(struct b2r2_control_instance *instance)
 	mutex_init(&instance->lock);
 	init_waitqueue_head(&instance->report_list_waitq);
 	init_waitqueue_head(&instance->synch_done_waitq);
+#ifdef CONFIG_B2R2_FENCE
+	INIT_LIST_HEAD(&instance->fence_list);
+#endif
 	dec_stat(cont, &cont->stat_n_in_open);
 
 	return ret;
@@ -215,6 +278,11 @@ int b2r2_control_release(struct b2r2_control_instance *instance)
 
 	inc_stat(cont, &cont->stat_n_in_release);
 
+#ifdef CONFIG_B2R2_FENCE
+	/* Input fences of other processes may never signal */
+	cancel_held_jobs(instance);
+#endif
+
 	/* Finish all outstanding requests */
 	ret = b2r2_control_synch(instance, 0);
 	if (ret < 0)
@@ -376,31 +444,213 @@ size_t b2r2_control_read_id(struct b2r2_control_instance *instance,
 
 #ifndef CONFIG_B2R2_GENERIC_ONLY
 /**
- * b2r2_blt - Implementation of the B2R2 blit request
+ * unresolve_request_bufs() - Unresolves all buffers of a request
  *
- * @instance: The B2R2 BLT instance
- * @request; The request to perform
+ * @request: The request
  */
-int b2r2_control_blt(struct b2r2_blt_request *request)
+static void unresolve_request_bufs(struct b2r2_control *cont,
+		struct b2r2_blt_request *request)
+{
+	unresolve_buf(cont, &request->user_req.src_img.buf,
+		&request->src_resolved);
+	unresolve_buf(cont, &request->user_req.src_mask.buf,
+		&request->src_mask_resolved);
+	unresolve_buf(cont, &request->user_req.dst_img.buf,
+		&request->dst_resolved);
+	if (request->user_req.flags & B2R2_BLT_FLAG_BG_BLEND)
+		unresolve_buf(cont, &request->user_req.bg_img.buf,
+			&request->bg_resolved);
+}
+
+/**
+ * is_same_buf() - Tells if two buffer specifications give the same memory
+ *
+ * Only buffers that are costly to resolve are considered.
+ */
+static bool is_same_buf(struct b2r2_blt_buf *a, struct b2r2_blt_buf *b)
+{
+	if (a->type != b->type)
+		return false;
+
+	switch (a->type) {
+	case B2R2_BLT_PTR_FD_OFFSET:
+		return a->fd == b->fd;
+	case B2R2_BLT_PTR_HWMEM_BUF_NAME_OFFSET:
+		return a->hwmem_buf_name == b->hwmem_buf_name;
+	default:
+		return false;
+	}
+}
+
+/**
+ * find_batch_buf() - Finds a buffer resolved by an earlier request of
+ *                    a batch
+ *
+ * @batch: The requests of the batch prepared so far
+ * @buf: The buffer specification to look for
+ *
+ * Returns the resolved buffer, NULL if not found
+ */
+static struct b2r2_resolved_buf *find_batch_buf(struct list_head *batch,
+		struct b2r2_blt_buf *buf)
+{
+	struct b2r2_blt_request *request;
+
+	list_for_each_entry(request, batch, batch) {
+		struct b2r2_blt_req *req = &request->user_req;
+
+		if (is_same_buf(&req->src_img.buf, buf))
+			return &request->src_resolved;
+		if (is_same_buf(&req->src_mask.buf, buf))
+			return &request->src_mask_resolved;
+		if (is_same_buf(&req->dst_img.buf, buf))
+			return &request->dst_resolved;
+		if ((req->flags & B2R2_BLT_FLAG_BG_BLEND) &&
+				is_same_buf(&req->bg_img.buf, buf))
+			return &request->bg_resolved;
+	}
+
+	return NULL;
+}
+
+/**
+ * borrow_buf() - Resolves a buffer from the same buffer resolved by an
+ *                earlier request of the batch
+ *
+ * @img: The image
+ * @rect_2b_used: The rectangle of the image that will be used
+ * @is_dst: true if the image is a destination
+ * @owner: The buffer already resolved
+ * @resolved: Gathered information about the buffer
+ *
+ * The lookup, pinning and mapping are shared with @owner, only what
+ * depends on the image is checked and set up again. The buffer is
+ * unresolved with @owner.
+ *
+ * Returns 0 if OK else negative error code
+ */
+static int borrow_buf(struct b2r2_control *cont,
+		struct b2r2_blt_img *img,
+		struct b2r2_blt_rect *rect_2b_used,
+		bool is_dst,
+		struct b2r2_resolved_buf *owner,
+		struct b2r2_resolved_buf *resolved)
+{
+	*resolved = *owner;
+	resolved->borrowed = true;
+
+	if (resolved->hwmem_alloc != NULL) {
+		enum hwmem_mem_type mem_type;
+		enum hwmem_access access;
+		enum hwmem_access required_access;
+		struct hwmem_region region;
+		int ret;
+
+		hwmem_get_info(resolved->hwmem_alloc, &resolved->file_len,
+				&mem_type, &access);
+
+		required_access = (is_dst ? HWMEM_ACCESS_WRITE :
+				HWMEM_ACCESS_READ) | HWMEM_ACCESS_IMPORT;
+		if ((required_access & access) != required_access)
+			return -EACCES;
+
+		if (resolved->file_len < img->buf.offset +
+				(__u32)b2r2_get_img_size(cont->dev, img))
+			return -EINVAL;
+
+		set_up_hwmem_region(cont, img, rect_2b_used, &region);
+		ret = hwmem_set_domain(resolved->hwmem_alloc,
+			required_access, HWMEM_DOMAIN_SYNC, &region);
+		if (ret < 0)
+			return ret;
+	} else {
+		if (img->buf.offset + img->buf.len > resolved->file_len)
+			return -ESPIPE;
+
+		resolved->virtual_address = (void *)
+			(resolved->file_virtual_start + img->buf.offset);
+	}
+
+	resolved->physical_address =
+		resolved->file_physical_start + img->buf.offset;
+
+	return 0;
+}
+
+/**
+ * resolve_req_buf() - Resolves a buffer of a request
+ *
+ * @batch: The requests already prepared for the same job, or NULL
+ *
+ * See resolve_buf()
+ */
+static int resolve_req_buf(struct b2r2_control *cont,
+		struct list_head *batch,
+		struct b2r2_blt_img *img,
+		struct b2r2_blt_rect *rect_2b_used,
+		bool is_dst,
+		struct b2r2_resolved_buf *resolved)
+{
+	struct b2r2_resolved_buf *owner = NULL;
+
+	if (batch != NULL)
+		owner = find_batch_buf(batch, &img->buf);
+	if (owner != NULL)
+		return borrow_buf(cont, img, rect_2b_used, is_dst, owner,
+			resolved);
+
+	return resolve_buf(cont, img, rect_2b_used, is_dst, resolved);
+}
+
+/**
+ * wait_for_synch() - Waits for an ongoing synch of the instance
+ *
+ * Returns 0 if OK, -EAGAIN if interrupted
+ */
+static int wait_for_synch(struct b2r2_control_instance *instance)
 {
-	int ret = 0;
-	struct b2r2_blt_rect actual_dst_rect;
-	int request_id = 0;
-	struct b2r2_node *last_node = request->first_node;
-	int node_count;
-	struct b2r2_control_instance *instance = request->instance;
 	struct b2r2_control *cont = instance->control;
+	int ret;
 
-	unsigned long long thread_runtime_at_start = 0;
+	inc_stat(cont, &cont->stat_n_in_blt_synch);
 
-	if (request->profile) {
-		ktime_get_ts(&request->ts_start);
-		thread_runtime_at_start = task_sched_runtime(current);
+	/* Wait here if synch is ongoing */
+	ret = wait_event_interruptible(instance->synch_done_waitq,
+			!is_synching(instance));
+	if (ret) {
+		b2r2_log_warn(cont->dev, "%s: Sync wait interrupted, %d\n",
+			__func__, ret);
+		ret = -EAGAIN;
 	}
 
-	b2r2_log_info(cont->dev, "%s\n", __func__);
+	dec_stat(cont, &cont->stat_n_in_blt_synch);
 
-	inc_stat(cont, &cont->stat_n_in_blt);
+	return ret;
+}
+
+/**
+ * prepare_request() - Resolves the buffers and builds the node list of
+ *                     a blit request
+ *
+ * @request: The request
+ * @batch: The requests already prepared for the same job, or NULL
+ *
+ * Returns 0 if the job of the request is ready to be added, 1 if the
+ * request shall not be executed (dry run or bypass), else a negative error
+ * code. Nothing is left resolved unless 0 is returned. The request itself
+ * is not released.
+ */
+static int prepare_request(struct b2r2_blt_request *request,
+		struct list_head *batch)
+{
+	int ret = 0;
+	struct b2r2_blt_rect actual_dst_rect;
+	struct b2r2_node *last_node;
+	struct b2r2_node_tmpl *tmpl = NULL;
+	u32 node_count;
+	struct b2r2_control_instance *instance = request->instance;
+	struct b2r2_control *cont = instance->control;
+	s64 nsec;
 
 	/* Debug prints of incoming request */
 	b2r2_log_info(cont->dev,
@@ -461,10 +711,16 @@ int b2r2_control_blt(struct b2r2_blt_request *request)
 
 	dec_stat(cont, &cont->stat_n_in_blt_synch);
 
+	trace_b2r2_request(&request->job, request->user_req.flags,
+		request->user_req.src_img.fmt, request->user_req.dst_img.fmt,
+		request->user_req.dst_rect.width,
+		request->user_req.dst_rect.height);
+	request->ts_stage = ktime_get();
+
 	/* Resolve the buffers */
 
 	/* Source buffer */
-	ret = resolve_buf(cont, &request->user_req.src_img,
+	ret = resolve_req_buf(cont, batch, &request->user_req.src_img,
 		&request->user_req.src_rect,
 		false, &request->src_resolved);
 	if (ret < 0) {
@@ -476,7 +732,7 @@ int b2r2_control_blt(struct b2r2_blt_request *request)
 
 	/* Background buffer */
 	if (request->user_req.flags & B2R2_BLT_FLAG_BG_BLEND) {
-		ret = resolve_buf(cont, &request->user_req.bg_img,
+		ret = resolve_req_buf(cont, batch, &request->user_req.bg_img,
 			&request->user_req.bg_rect,
 			false, &request->bg_resolved);
 		if (ret < 0) {
@@ -488,7 +744,7 @@ int b2r2_control_blt(struct b2r2_blt_request *request)
 	}
 
 	/* Source mask buffer */
-	ret = resolve_buf(cont, &request->user_req.src_mask,
+	ret = resolve_req_buf(cont, batch, &request->user_req.src_mask,
 			&request->user_req.src_rect, false,
 			&request->src_mask_resolved);
 	if (ret < 0) {
@@ -500,7 +756,8 @@ int b2r2_control_blt(struct b2r2_blt_request *request)
 
 	/* Destination buffer */
 	get_actual_dst_rect(&request->user_req, &actual_dst_rect);
-	ret = resolve_buf(cont, &request->user_req.dst_img, &actual_dst_rect,
+	ret = resolve_req_buf(cont, batch, &request->user_req.dst_img,
+		&actual_dst_rect,
 		true, &request->dst_resolved);
 	if (ret < 0) {
 		b2r2_log_warn(cont->dev, "%s: Resolve dst buf failed, %d\n",
@@ -509,6 +766,9 @@ int b2r2_control_blt(struct b2r2_blt_request *request)
 		goto resolve_dst_buf_failed;
 	}
 
+	nsec = request_stage(request, B2R2_STAGE_RESOLVE);
+	trace_b2r2_resolve(&request->job, nsec);
+
 	/* Debug prints of resolved buffers */
 	b2r2_log_info(cont->dev, "src.rbuf={%X,%p,%d} {%p,%X,%X,%d}\n",
 		request->src_resolved.physical_address,
@@ -538,6 +798,11 @@ int b2r2_control_blt(struct b2r2_blt_request *request)
 		request->dst_resolved.file_virtual_start,
 		request->dst_resolved.file_len);
 
+	/* The node list of an equal request can be reused */
+	tmpl = b2r2_node_split_lookup(cont, request, &node_count);
+	if (tmpl != NULL)
+		goto alloc_nodes;
+
 	/* Calculate the number of nodes (and resources) needed for this job */
 	ret = b2r2_node_split_analyze(request, MAX_TMP_BUF_SIZE, &node_count,
 		&request->bufs, &request->buf_count,
@@ -572,11 +837,13 @@ int b2r2_control_blt(struct b2r2_blt_request *request)
 		goto generate_nodes_failed;
 	}
 
+alloc_nodes:
 	/* Allocate the nodes needed */
 #ifdef B2R2_USE_NODE_GEN
 	request->first_node = b2r2_blt_alloc_nodes(cont,
 		node_count);
 	if (request->first_node == NULL) {
+		ret = -ENOMEM;
 		b2r2_log_warn(cont->dev, "%s: Failed to allocate nodes,"
 			" ret = %d\n", __func__, ret);
 		goto generate_nodes_failed;
@@ -584,6 +851,8 @@ int b2r2_control_blt(struct b2r2_blt_request *request)
 #else
 	ret = b2r2_node_alloc(cont, node_count, &(request->first_node));
 	if (ret < 0 || request->first_node == NULL) {
+		if (ret >= 0)
+			ret = -ENOMEM;
 		b2r2_log_warn(cont->dev,
 			"%s: Failed to allocate nodes, ret = %d\n",
 			__func__, ret);
@@ -591,23 +860,38 @@ int b2r2_control_blt(struct b2r2_blt_request *request)
 	}
 #endif
 
-	/* Build the B2R2 node list */
-	ret = b2r2_node_split_configure(cont, &request->node_split_job,
-			request->first_node);
+	if (tmpl != NULL) {
+		b2r2_node_split_reuse(cont, tmpl, request,
+				request->first_node);
+		tmpl = NULL;
+		inc_stat(cont, &cont->stat_n_node_cache_hits);
+	} else {
+		/* Build the B2R2 node list */
+		ret = b2r2_node_split_configure(cont,
+				&request->node_split_job, request->first_node);
 
-	if (ret < 0) {
-		b2r2_log_warn(cont->dev, "%s:"
-			" Failed to perform node split, ret = %d\n",
-			__func__, ret);
-		goto generate_nodes_failed;
+		if (ret < 0) {
+			b2r2_log_warn(cont->dev, "%s:"
+				" Failed to perform node split, ret = %d\n",
+				__func__, ret);
+			goto generate_nodes_failed;
+		}
+
+		b2r2_node_split_store(cont, request, request->first_node);
+		inc_stat(cont, &cont->stat_n_node_cache_misses);
 	}
 
+	nsec = request_stage(request, B2R2_STAGE_NODES);
+	trace_b2r2_node_gen(&request->job, nsec);
+
 	/*
 	 * Exit here if dry run or if we choose to
 	 * omit blit jobs through debugfs
 	 */
-	if (request->user_req.flags & B2R2_BLT_FLAG_DRY_RUN || cont->bypass)
+	if (request->user_req.flags & B2R2_BLT_FLAG_DRY_RUN || cont->bypass) {
+		ret = 1;
 		goto exit_dry_run;
+	}
 
 	/* Configure the request */
 	last_node = request->first_node;
@@ -661,92 +945,450 @@ int b2r2_control_blt(struct b2r2_blt_request *request)
 		sync_buf(cont, &request->user_req.src_mask,
 			&request->src_mask_resolved, false, NULL);
 
-	/* Destination buffer */
-	if (!(request->user_req.flags &
-				B2R2_BLT_FLAG_DST_NO_CACHE_FLUSH) &&
-			(request->user_req.dst_img.buf.type !=
-				B2R2_BLT_PTR_PHYSICAL) &&
-			!b2r2_is_mb_fmt(request->user_req.dst_img.fmt))
-		/* MB formats are never touched by SW */
-		sync_buf(cont, &request->user_req.dst_img,
-			&request->dst_resolved, true,
-			&request->user_req.dst_rect);
+	/* Destination buffer */
+	if (!(request->user_req.flags &
+				B2R2_BLT_FLAG_DST_NO_CACHE_FLUSH) &&
+			(request->user_req.dst_img.buf.type !=
+				B2R2_BLT_PTR_PHYSICAL) &&
+			!b2r2_is_mb_fmt(request->user_req.dst_img.fmt))
+		/* MB formats are never touched by SW */
+		sync_buf(cont, &request->user_req.dst_img,
+			&request->dst_resolved, true,
+			&request->user_req.dst_rect);
+
+	nsec = request_stage(request, B2R2_STAGE_CACHE_SYNC);
+	trace_b2r2_cache_sync(&request->job, nsec);
+
+#ifdef CONFIG_DEBUG_FS
+	/* Remember latest request for debugfs */
+	mutex_lock(&cont->last_req_lock);
+	cont->latest_request[cont->buf_index] = *request;
+
+	/* Calculate, buf_index = (buf_index + 1) % last_request_count */
+	cont->buf_index++;
+	if (cont->buf_index >= cont->last_request_count)
+		cont->buf_index = 0;
+	mutex_unlock(&cont->last_req_lock);
+#endif
+
+	return 0;
+
+exit_dry_run:
+no_optimized_path:
+generate_nodes_failed:
+	if (tmpl != NULL)
+		b2r2_node_split_put(tmpl);
+	unresolve_buf(cont, &request->user_req.dst_img.buf,
+		&request->dst_resolved);
+resolve_dst_buf_failed:
+	unresolve_buf(cont, &request->user_req.src_mask.buf,
+		&request->src_mask_resolved);
+resolve_src_mask_buf_failed:
+	if (request->user_req.flags & B2R2_BLT_FLAG_BG_BLEND)
+		unresolve_buf(cont, &request->user_req.bg_img.buf,
+				&request->bg_resolved);
+resolve_bg_buf_failed:
+	unresolve_buf(cont, &request->user_req.src_img.buf,
+		&request->src_resolved);
+resolve_src_buf_failed:
+	return ret;
+}
+
+/**
+ * add_job() - Adds the job of a prepared request to b2r2_core
+ *
+ * @request: The request
+ *
+ * Returns the request id if OK else negative error code
+ */
+static int add_job(struct b2r2_blt_request *request)
+{
+	int request_id;
+	struct b2r2_control_instance *instance = request->instance;
+	struct b2r2_control *cont = instance->control;
+
+	/* Submit the job */
+	b2r2_log_info(cont->dev, "%s: Submitting job\n", __func__);
+
+	inc_stat(cont, &cont->stat_n_in_blt_add);
+
+	mutex_lock(&instance->lock);
+
+	/* Add the job to b2r2_core */
+	request_id = b2r2_core_job_add(cont, &request->job);
+	request->request_id = request_id;
+
+	dec_stat(cont, &cont->stat_n_in_blt_add);
+
+	if (request_id < 0) {
+		b2r2_log_warn(cont->dev, "%s: Failed to add job, ret = %d\n",
+			__func__, request_id);
+		mutex_unlock(&instance->lock);
+		return request_id;
+	}
+
+	inc_stat(cont, &cont->stat_n_jobs_added);
+
+#ifdef CONFIG_B2R2_FENCE
+	/* A held back request was counted when it was held back */
+	if (request->in_fence != NULL) {
+		mutex_unlock(&instance->lock);
+		return request_id;
+	}
+#endif
+
+	instance->no_of_active_requests++;
+	mutex_unlock(&instance->lock);
+
+	return request_id;
+}
+
+/**
+ * dec_active_requests() - Accounts for a request that is done
+ *
+ * @instance: The instance of the request
+ *
+ * Wakes up the synching threads when no request is active any more.
+ * instance->lock must be held.
+ */
+static void dec_active_requests(struct b2r2_control_instance *instance)
+{
+	BUG_ON(instance->no_of_active_requests == 0);
+	instance->no_of_active_requests--;
+	if (instance->synching &&
+			instance->no_of_active_requests == 0) {
+		instance->synching = false;
+		/* Wake up all syncing */
+
+		wake_up_interruptible_all(
+			&instance->synch_done_waitq);
+	}
+}
+
+#ifdef CONFIG_B2R2_FENCE
+/**
+ * signal_fence() - Signals the fence of a request, if any
+ *
+ * @request: The request
+ * @done: true if the job was done, false signals an error
+ */
+static void signal_fence(struct b2r2_blt_request *request, bool done)
+{
+	if (request->timeline == NULL)
+		return;
+
+	if (done)
+		sw_sync_timeline_inc(request->timeline, 1);
+
+	/* Not signalled yet means error, the pt holds the timeline */
+	sync_timeline_destroy(&request->timeline->obj);
+	request->timeline = NULL;
+}
+
+/**
+ * drop_held_job() - Releases a held back request without executing it
+ *
+ * @request: The request, prepared and counted as active
+ */
+static void drop_held_job(struct b2r2_blt_request *request)
+{
+	struct b2r2_control_instance *instance = request->instance;
+	struct b2r2_control *cont = instance->control;
+
+	mutex_lock(&instance->lock);
+	dec_active_requests(instance);
+	mutex_unlock(&instance->lock);
+
+	unresolve_request_bufs(cont, request);
+	job_release(&request->job);
+	dec_stat(cont, &cont->stat_n_jobs_released);
+
+	dec_stat(cont, &cont->stat_n_in_blt);
+}
+
+/**
+ * fence_work_function() - Adds the job of a request held back for its
+ *                         input fence, once that fence has signalled
+ */
+static void fence_work_function(struct work_struct *work)
+{
+	struct b2r2_blt_request *request = container_of(work,
+			struct b2r2_blt_request, fence_work);
+	struct b2r2_control_instance *instance = request->instance;
+	struct b2r2_control *cont = instance->control;
+	int request_id;
+
+	mutex_lock(&instance->lock);
+	list_del_init(&request->list);
+	mutex_unlock(&instance->lock);
+
+	if (request->in_fence->status < 0) {
+		b2r2_log_warn(cont->dev, "%s: Input fence error %d\n",
+			__func__, request->in_fence->status);
+		drop_held_job(request);
+		return;
+	}
+
+	request_id = add_job(request);
+	if (request_id < 0) {
+		drop_held_job(request);
+		return;
+	}
+
+	sync_fence_put(request->in_fence);
+	request->in_fence = NULL;
+
+	/* The request is not waited for, see b2r2_control_waitjob */
+	b2r2_core_job_release(&request->job, __func__);
+	dec_stat(cont, &cont->stat_n_in_blt);
+}
+
+static void fence_signaled(struct sync_fence *fence,
+		struct sync_fence_waiter *waiter)
+{
+	struct b2r2_blt_request *request = container_of(waiter,
+			struct b2r2_blt_request, fence_waiter);
+
+	/* May be called in atomic context, adding a job may sleep */
+	schedule_work(&request->fence_work);
+}
+
+/**
+ * hold_job() - Holds back the job of a prepared request until its input
+ *              fence signals
+ *
+ * @request: The request, consumed
+ *
+ * Returns the request id
+ */
+static int hold_job(struct b2r2_blt_request *request)
+{
+	struct b2r2_control_instance *instance = request->instance;
+	int request_id = request->job.job_id;
+	int ret;
+
+	INIT_WORK(&request->fence_work, fence_work_function);
+	sync_fence_waiter_init(&request->fence_waiter, fence_signaled);
+
+	mutex_lock(&instance->lock);
+	instance->no_of_active_requests++;
+	list_add_tail(&request->list, &instance->fence_list);
+	mutex_unlock(&instance->lock);
+
+	/* Signalled already, or in error */
+	ret = sync_fence_wait_async(request->in_fence, &request->fence_waiter);
+	if (ret != 0)
+		fence_work_function(&request->fence_work);
+
+	return request_id;
+}
+
+/**
+ * cancel_held_jobs() - Releases the requests of an instance still held
+ *                      back for their input fence
+ *
+ * @instance: The instance
+ */
+static void cancel_held_jobs(struct b2r2_control_instance *instance)
+{
+	struct b2r2_blt_request *request;
+	struct b2r2_blt_request *tmp;
+	LIST_HEAD(held);
+
+	mutex_lock(&instance->lock);
+	list_for_each_entry_safe(request, tmp, &instance->fence_list, list) {
+		list_del_init(&request->list);
+		/* Else the work is queued already, it is synched for */
+		if (sync_fence_cancel_async(request->in_fence,
+				&request->fence_waiter) == 0)
+			list_add_tail(&request->list, &held);
+	}
+	mutex_unlock(&instance->lock);
+
+	list_for_each_entry_safe(request, tmp, &held, list) {
+		list_del_init(&request->list);
+		drop_held_job(request);
+	}
+}
+#endif
+
+/**
+ * b2r2_blt - Implementation of the B2R2 blit request
+ *
+ * @instance: The B2R2 BLT instance
+ * @request; The request to perform
+ */
+int b2r2_control_blt(struct b2r2_blt_request *request)
+{
+	int ret = 0;
+	int request_id = 0;
+	struct b2r2_control_instance *instance = request->instance;
+	struct b2r2_control *cont = instance->control;
+
+	unsigned long long thread_runtime_at_start = 0;
+
+	if (request->profile) {
+		ktime_get_ts(&request->ts_start);
+		thread_runtime_at_start = task_sched_runtime(current);
+	}
+
+	b2r2_log_info(cont->dev, "%s\n", __func__);
+
+	inc_stat(cont, &cont->stat_n_in_blt);
+
+	ret = wait_for_synch(instance);
+	if (ret < 0)
+		goto synch_interrupted;
+
+	ret = prepare_request(request, NULL);
+	if (ret != 0) {
+		/* Nothing to do for a dry run */
+		if (ret > 0)
+			ret = 0;
+		goto prepare_failed;
+	}
+
+	if (request->profile)
+		request->nsec_active_in_cpu =
+			(s64)(task_sched_runtime(current) -
+					thread_runtime_at_start);
+
+#ifdef CONFIG_B2R2_FENCE
+	if (request->in_fence != NULL)
+		return hold_job(request);
+#endif
+
+	request_id = add_job(request);
+	if (request_id < 0) {
+		ret = request_id;
+		goto job_add_failed;
+	}
+
+	return request_id;
+
+job_add_failed:
+	unresolve_request_bufs(cont, request);
+prepare_failed:
+synch_interrupted:
+	if (((request->user_req.flags & B2R2_BLT_FLAG_DRY_RUN) == 0 ||
+			cont->bypass) && (ret != 0))
+		b2r2_log_warn(cont->dev, "%s returns with error %d\n",
+			__func__, ret);
+	job_release(&request->job);
+	dec_stat(cont, &cont->stat_n_jobs_released);
+
+	dec_stat(cont, &cont->stat_n_in_blt);
+
+	return ret;
+}
+
+/**
+ * b2r2_control_blt_batch - Adds a batch of blit requests as one job
+ *
+ * @requests: The requests, in the order they shall be executed
+ * @count: Number of requests
+ *
+ * The node lists of the requests are chained and added as the job of the
+ * last request, which is the one to wait for. A buffer used by several
+ * requests is only resolved once. All requests are consumed, whatever
+ * the outcome.
+ *
+ * Returns 0 if the job was added, 1 if the batch shall not be executed
+ * (dry run or bypass), else a negative error code. -ENOSYS tells that
+ * a request has no optimized path.
+ */
+int b2r2_control_blt_batch(struct b2r2_blt_request **requests, int count)
+{
+	int ret = 0;
+	int i = 0;
+	int request_id;
+	struct b2r2_blt_request *head = requests[count - 1];
+	struct b2r2_blt_request *request;
+	struct b2r2_blt_request *tmp;
+	struct b2r2_node *last_node = NULL;
+	struct b2r2_control_instance *instance = head->instance;
+	struct b2r2_control *cont = instance->control;
+
+	unsigned long long thread_runtime_at_start = 0;
+
+	if (head->profile) {
+		ktime_get_ts(&head->ts_start);
+		thread_runtime_at_start = task_sched_runtime(current);
+	}
+
+	b2r2_log_info(cont->dev, "%s: %d requests\n", __func__, count);
 
-#ifdef CONFIG_DEBUG_FS
-	/* Remember latest request for debugfs */
-	mutex_lock(&cont->last_req_lock);
-	cont->latest_request[cont->buf_index] = *request;
+	inc_stat(cont, &cont->stat_n_in_blt);
 
-	/* Calculate, buf_index = (buf_index + 1) % last_request_count */
-	cont->buf_index++;
-	if (cont->buf_index >= cont->last_request_count)
-		cont->buf_index = 0;
-	mutex_unlock(&cont->last_req_lock);
-#endif
+	ret = wait_for_synch(instance);
+	if (ret < 0)
+		goto release;
 
-	/* Submit the job */
-	b2r2_log_info(cont->dev, "%s: Submitting job\n", __func__);
+	for (i = 0; i < count; i++) {
+		request = requests[i];
 
-	inc_stat(cont, &cont->stat_n_in_blt_add);
+		ret = prepare_request(request, &head->batch);
+		if (ret != 0)
+			goto release;
 
-	if (request->profile)
-		request->nsec_active_in_cpu =
-			(s64)(task_sched_runtime(current) -
-					thread_runtime_at_start);
+		/* The previous node list continues with this one */
+		if (last_node != NULL)
+			last_node->node.GROUP0.B2R2_NIP =
+				request->first_node->physical_address;
 
-	mutex_lock(&instance->lock);
+		last_node = request->first_node;
+		while (last_node->next)
+			last_node = last_node->next;
 
-	/* Add the job to b2r2_core */
-	request_id = b2r2_core_job_add(cont, &request->job);
-	request->request_id = request_id;
+		if (request != head)
+			list_add_tail(&request->batch, &head->batch);
+	}
 
-	dec_stat(cont, &cont->stat_n_in_blt_add);
+	if (count > 1) {
+		head->job.first_node_address =
+			requests[0]->first_node->physical_address;
+		head->job.callback = job_callback_batch;
+		head->job.release = job_release_batch;
+		head->job.acquire_resources = job_acquire_resources_batch;
+		head->job.release_resources = job_release_resources_batch;
+	}
+
+	if (head->profile)
+		head->nsec_active_in_cpu =
+			(s64)(task_sched_runtime(current) -
+					thread_runtime_at_start);
 
+	request_id = add_job(head);
 	if (request_id < 0) {
-		b2r2_log_warn(cont->dev, "%s: Failed to add job, ret = %d\n",
-			__func__, request_id);
 		ret = request_id;
-		mutex_unlock(&instance->lock);
-		goto job_add_failed;
+		unresolve_request_bufs(cont, head);
+		i = count - 1;
+		goto release;
 	}
 
-	inc_stat(cont, &cont->stat_n_jobs_added);
-
-	instance->no_of_active_requests++;
-	mutex_unlock(&instance->lock);
+	return 0;
 
-	return ret >= 0 ? request_id : ret;
+release:
+	/* The requests prepared, then the ones left */
+	list_for_each_entry_safe(request, tmp, &head->batch, batch) {
+		list_del_init(&request->batch);
+		unresolve_request_bufs(cont, request);
+		job_release(&request->job);
+		dec_stat(cont, &cont->stat_n_jobs_released);
+	}
+	for (; i < count; i++) {
+		job_release(&requests[i]->job);
+		dec_stat(cont, &cont->stat_n_jobs_released);
+	}
 
-job_add_failed:
-exit_dry_run:
-no_optimized_path:
-generate_nodes_failed:
-	unresolve_buf(cont, &request->user_req.dst_img.buf,
-		&request->dst_resolved);
-resolve_dst_buf_failed:
-	unresolve_buf(cont, &request->user_req.src_mask.buf,
-		&request->src_mask_resolved);
-resolve_src_mask_buf_failed:
-	if (request->user_req.flags & B2R2_BLT_FLAG_BG_BLEND)
-		unresolve_buf(cont, &request->user_req.bg_img.buf,
-				&request->bg_resolved);
-resolve_bg_buf_failed:
-	unresolve_buf(cont, &request->user_req.src_img.buf,
-		&request->src_resolved);
-resolve_src_buf_failed:
-synch_interrupted:
-	if (((request->user_req.flags & B2R2_BLT_FLAG_DRY_RUN) == 0 ||
-			cont->bypass) && (ret != 0))
+	if (ret < 0)
 		b2r2_log_warn(cont->dev, "%s returns with error %d\n",
 			__func__, ret);
-	job_release(&request->job);
-	dec_stat(cont, &cont->stat_n_jobs_released);
 
 	dec_stat(cont, &cont->stat_n_in_blt);
 
 	return ret;
 }
-
 int b2r2_control_waitjob(struct b2r2_blt_request *request)
 {
 	int ret = 0;
@@ -806,15 +1448,11 @@ static void job_callback(struct b2r2_core_job *job)
 	b2r2_debug_buffers_unresolve(cont, request);
 
 	/* Unresolve the buffers */
-	unresolve_buf(cont, &request->user_req.src_img.buf,
-		&request->src_resolved);
-	unresolve_buf(cont, &request->user_req.src_mask.buf,
-		&request->src_mask_resolved);
-	unresolve_buf(cont, &request->user_req.dst_img.buf,
-		&request->dst_resolved);
-	if (request->user_req.flags & B2R2_BLT_FLAG_BG_BLEND)
-		unresolve_buf(cont, &request->user_req.bg_img.buf,
-			&request->bg_resolved);
+	unresolve_request_bufs(cont, request);
+
+#ifdef CONFIG_B2R2_FENCE
+	signal_fence(request, job->job_state == B2R2_CORE_JOB_DONE);
+#endif
 
 	/* Move to report list if the job shall be reported */
 	/* FIXME: Use a smaller struct? */
@@ -841,16 +1479,7 @@ static void job_callback(struct b2r2_core_job *job)
 	 * Decrease number of active requests and wake up
 	 * synching threads if active requests reaches zero
 	 */
-	BUG_ON(request->instance->no_of_active_requests == 0);
-	request->instance->no_of_active_requests--;
-	if (request->instance->synching &&
-			request->instance->no_of_active_requests == 0) {
-		request->instance->synching = false;
-		/* Wake up all syncing */
-
-		wake_up_interruptible_all(
-			&request->instance->synch_done_waitq);
-	}
+	dec_active_requests(request->instance);
 	mutex_unlock(&request->instance->lock);
 
 #ifdef CONFIG_DEBUG_FS
@@ -879,6 +1508,15 @@ static void job_callback(struct b2r2_core_job *job)
 		b2r2_call_profiler_blt_done(request);
 	}
 
+	if (job->job_state == B2R2_CORE_JOB_DONE) {
+		record_stage(cont, B2R2_STAGE_QUEUE, ktime_to_ns(
+			ktime_sub(job->ts_triggered, job->ts_added)));
+		record_stage(cont, B2R2_STAGE_HW, job->nsec_active_in_hw);
+		record_stage(cont, B2R2_STAGE_CALLBACK, ktime_to_ns(
+			ktime_sub(ktime_get(), job->ts_done)));
+	}
+	trace_b2r2_callback(job, job->job_id, job->job_state);
+
 	/* Local addref / release within this func */
 	b2r2_core_job_release(job, __func__);
 }
@@ -914,6 +1552,13 @@ static void job_release(struct b2r2_core_job *job)
 #endif
 	}
 
+#ifdef CONFIG_B2R2_FENCE
+	/* Never executed */
+	signal_fence(request, false);
+	if (request->in_fence != NULL)
+		sync_fence_put(request->in_fence);
+#endif
+
 	/* Release memory for the request */
 	if (request->clut != NULL) {
 		dma_free_coherent(cont->dev, CLUT_SIZE, request->clut,
@@ -1044,6 +1689,148 @@ static void job_release_resources(struct b2r2_core_job *job, bool atomic)
 	}
 }
 
+/**
+ * Called when the job of a batch is done or cancelled
+ *
+ * @job: The job of the last request of the batch
+ */
+static void job_callback_batch(struct b2r2_core_job *job)
+{
+	struct b2r2_blt_request *request =
+		container_of(job, struct b2r2_blt_request, job);
+	struct b2r2_core *core = (struct b2r2_core *) job->data;
+	struct b2r2_blt_request *member;
+
+	list_for_each_entry(member, &request->batch, batch)
+		unresolve_request_bufs(core->control, member);
+
+	job_callback(job);
+}
+
+/**
+ * Called when the job of a batch should be released
+ *
+ * @job: The job of the last request of the batch
+ */
+static void job_release_batch(struct b2r2_core_job *job)
+{
+	struct b2r2_blt_request *request =
+		container_of(job, struct b2r2_blt_request, job);
+	struct b2r2_core *core = (struct b2r2_core *) job->data;
+	struct b2r2_blt_request *member;
+	struct b2r2_blt_request *tmp;
+
+	list_for_each_entry_safe(member, tmp, &request->batch, batch) {
+		list_del_init(&member->batch);
+		job_release(&member->job);
+		/* The batch counts as one released job */
+		dec_stat(core->control, &core->control->stat_n_jobs_released);
+	}
+
+	job_release(job);
+}
+
+/**
+ * assign_tmp_bufs() - Lets the nodes of a request use the temp buffers
+ *
+ * @request: The request
+ */
+static int assign_tmp_bufs(struct b2r2_control *cont,
+		struct b2r2_blt_request *request)
+{
+	int i;
+
+	if (request->buf_count == 0)
+		return 0;
+
+	for (i = 0; i < request->buf_count; i++) {
+		if (cont->tmp_bufs[i].buf.size < request->bufs[i].size) {
+			b2r2_log_err(cont->dev, "%s: "
+					"cont->tmp_bufs[i].buf.size < "
+					"request->bufs[i].size\n", __func__);
+			return -ENOMSG;
+		}
+
+		request->bufs[i].phys_addr = cont->tmp_bufs[i].buf.phys_addr;
+		request->bufs[i].virt_addr = cont->tmp_bufs[i].buf.virt_addr;
+	}
+
+	return b2r2_node_split_assign_buffers(cont, &request->node_split_job,
+			request->first_node, request->bufs,
+			request->buf_count);
+}
+
+/**
+ * Allocates the temp buffers for the job of a batch, see
+ * job_acquire_resources().
+ *
+ * The node lists of a batch are executed one after the other, so all
+ * requests use the same temp buffers.
+ *
+ * @job: The job of the last request of the batch
+ */
+static int job_acquire_resources_batch(struct b2r2_core_job *job, bool atomic)
+{
+	struct b2r2_blt_request *request =
+		container_of(job, struct b2r2_blt_request, job);
+	struct b2r2_core *core = (struct b2r2_core *) job->data;
+	struct b2r2_control *cont = core->control;
+	struct b2r2_blt_request *member;
+	u32 buf_count = request->buf_count;
+	int ret;
+	int i;
+
+	b2r2_log_info(cont->dev, "%s\n", __func__);
+
+	list_for_each_entry(member, &request->batch, batch)
+		buf_count = max(buf_count, member->buf_count);
+
+	if (buf_count == 0)
+		return 0;
+
+	if (buf_count > MAX_TMP_BUFS_NEEDED) {
+		b2r2_log_err(cont->dev,
+				"%s: buf_count > MAX_TMP_BUFS_NEEDED\n",
+				__func__);
+		return -ENOMSG;
+	}
+
+	if (cont->tmp_bufs[0].in_use)
+		return -EAGAIN;
+
+	list_for_each_entry(member, &request->batch, batch) {
+		ret = assign_tmp_bufs(cont, member);
+		if (ret < 0)
+			return ret;
+	}
+	ret = assign_tmp_bufs(cont, request);
+	if (ret < 0)
+		return ret;
+
+	for (i = 0; i < buf_count; i++)
+		cont->tmp_bufs[i].in_use = true;
+
+	return 0;
+}
+
+/**
+ * Frees the resources of the job of a batch, see job_release_resources().
+ *
+ * @job: The job of the last request of the batch
+ */
+static void job_release_resources_batch(struct b2r2_core_job *job,
+		bool atomic)
+{
+	struct b2r2_blt_request *request =
+		container_of(job, struct b2r2_blt_request, job);
+	struct b2r2_blt_request *member;
+
+	list_for_each_entry(member, &request->batch, batch)
+		job_release_resources(&member->job, atomic);
+
+	job_release_resources(job, atomic);
+}
+
 #endif /* !CONFIG_B2R2_GENERIC_ONLY */
 
 #ifdef CONFIG_B2R2_GENERIC
@@ -1240,6 +2027,151 @@ static void job_release_resources_gen(struct b2r2_core_job *job, bool atomic)
 	/* Nothing so far. Temporary buffers are pre-allocated */
 }
 
+/* Tiles the generic path keeps in flight at once */
+#define B2R2_GENERIC_LANES 2
+
+/**
+ * struct gen_lane - Nodes and work buffers a tile of the generic path runs
+ *                   through
+ *
+ * @cont:       Core the tiles of the lane are added to
+ * @first_node: The node list, configured for the request
+ * @work_bufs:  Intermediate buffers between the passes
+ * @job:        Tile job running on the lane, if any
+ */
+struct gen_lane {
+	struct b2r2_control *cont;
+	struct b2r2_node *first_node;
+	struct b2r2_work_buf work_bufs[4];
+	struct b2r2_core_job *job;
+};
+
+static void gen_lane_free(struct gen_lane *lane)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(lane->work_bufs); i++) {
+		if (lane->work_bufs[i].virt_addr == NULL)
+			continue;
+		dma_free_coherent(lane->cont->dev, lane->work_bufs[i].size,
+			lane->work_bufs[i].virt_addr,
+			lane->work_bufs[i].phys_addr);
+		memset(&lane->work_bufs[i], 0, sizeof(lane->work_bufs[i]));
+	}
+
+	if (lane->first_node) {
+#ifdef B2R2_USE_NODE_GEN
+		b2r2_blt_free_nodes(lane->cont, lane->first_node);
+#else
+		b2r2_node_free(lane->cont, lane->first_node);
+#endif
+		lane->first_node = NULL;
+	}
+}
+
+/* Gives the lane its own copy of the nodes and work buffers of lane 0 */
+static int gen_lane_setup(struct b2r2_blt_request *request,
+		struct gen_lane *lane, int node_count, u32 buf_size,
+		u32 buf_count)
+{
+	struct b2r2_control *cont = lane->cont;
+	int i;
+	int ret;
+
+#ifdef B2R2_USE_NODE_GEN
+	lane->first_node = b2r2_blt_alloc_nodes(cont, node_count);
+	if (lane->first_node == NULL)
+		return -ENOMEM;
+#else
+	ret = b2r2_node_alloc(cont, node_count, &lane->first_node);
+	if (ret < 0 || lane->first_node == NULL) {
+		lane->first_node = NULL;
+		return -ENOMEM;
+	}
+#endif
+
+	for (i = 0; i < buf_count; i++) {
+		lane->work_bufs[i].size = buf_size;
+		lane->work_bufs[i].virt_addr = dma_alloc_coherent(cont->dev,
+				buf_size, &lane->work_bufs[i].phys_addr,
+				GFP_DMA | GFP_KERNEL);
+		if (lane->work_bufs[i].virt_addr == NULL) {
+			ret = -ENOMEM;
+			goto fail;
+		}
+	}
+
+	ret = b2r2_generic_configure(request, lane->first_node,
+			lane->work_bufs, buf_count);
+	if (ret >= 0)
+		return 0;
+
+fail:
+	gen_lane_free(lane);
+	return ret;
+}
+
+static struct b2r2_core_job *gen_tile_job(struct b2r2_blt_request *request,
+		struct gen_lane *lane)
+{
+	struct b2r2_node *last_node = lane->first_node;
+	/*
+	 * Tile jobs are freed by the supplied release function
+	 * when ref_count on a tile_job reaches zero.
+	 */
+	struct b2r2_core_job *tile_job = kmalloc(sizeof(*tile_job),
+						GFP_KERNEL);
+
+	if (tile_job == NULL)
+		return NULL;
+
+	while (last_node->next)
+		last_node = last_node->next;
+
+	tile_job->job_id = request->job.job_id;
+	tile_job->tag = request->job.tag;
+	tile_job->data = (int) lane->cont->data;
+	tile_job->prio = request->job.prio;
+	tile_job->first_node_address = lane->first_node->physical_address;
+	tile_job->last_node_address = last_node->physical_address;
+	tile_job->callback = tile_job_callback_gen;
+	tile_job->release = tile_job_release_gen;
+	/* Work buffers and nodes are pre-allocated */
+	tile_job->acquire_resources = job_acquire_resources_gen;
+	tile_job->release_resources = job_release_resources_gen;
+
+	return tile_job;
+}
+
+/* Waits for the tile running on the lane, returns its time in hardware */
+static s32 gen_lane_wait(struct gen_lane *lane)
+{
+	struct b2r2_core_job *job = lane->job;
+	struct b2r2_control *cont = lane->cont;
+	s32 nsec = 0;
+	int ret;
+
+	if (job == NULL)
+		return 0;
+	lane->job = NULL;
+
+	b2r2_log_info(cont->dev, "%s: Synchronous, waiting\n", __func__);
+
+	inc_stat(cont, &cont->stat_n_in_blt_wait);
+	ret = b2r2_core_job_wait(job);
+	dec_stat(cont, &cont->stat_n_in_blt_wait);
+
+	if (ret < 0 && ret != -ENOENT)
+		b2r2_log_warn(cont->dev, "%s: Failed to wait job, ret = %d\n",
+			__func__, ret);
+	else
+		nsec = job->nsec_active_in_hw;
+
+	/* Release matching the addref in b2r2_core_job_add */
+	b2r2_core_job_release(job, __func__);
+	return nsec;
+}
+
 /**
  * b2r2_generic_blt - Generic implementation of the B2R2 blit request
  *
@@ -1261,8 +2193,12 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 	const s32 dst_img_width = request->user_req.dst_img.width;
 	const s32 dst_img_height = request->user_req.dst_img.height;
 	const enum b2r2_blt_flag flags = request->user_req.flags;
+	/* Lane 0 runs on the request's nodes and core */
+	struct gen_lane lanes[B2R2_GENERIC_LANES];
+	int n_lanes = 1;
+	u32 tile_nr = 0;
 	/* Descriptors for the temporary buffers */
-	struct b2r2_work_buf work_bufs[4];
+	struct b2r2_work_buf *work_bufs = lanes[0].work_bufs;
 	struct b2r2_blt_rect dst_rect_tile;
 	int i;
 	struct b2r2_control_instance *instance = request->instance;
@@ -1295,7 +2231,8 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 		thread_runtime_at_start = task_sched_runtime(current);
 	}
 
-	memset(work_bufs, 0, sizeof(work_bufs));
+	memset(lanes, 0, sizeof(lanes));
+	lanes[0].cont = cont;
 
 	b2r2_log_info(cont->dev, "%s\n", __func__);
 
@@ -1485,6 +2422,21 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 	if (flags & B2R2_BLT_FLAG_DRY_RUN || cont->bypass)
 		goto exit_dry_run;
 
+	/*
+	 * A blit of more than one tile gets a second lane, on the second
+	 * core if there is one. It goes on with just one lane otherwise.
+	 */
+	lanes[0].first_node = request->first_node;
+	if (dst_rect->width > tmp_buf_width ||
+			dst_rect->height > tmp_buf_height) {
+		lanes[1].cont = request->aux_control ?
+				request->aux_control : cont;
+		if (gen_lane_setup(request, &lanes[1], node_count,
+				tmp_buf_width * tmp_buf_height * 4,
+				tmp_buf_count) == 0)
+			n_lanes = 2;
+	}
+
 	/*
 	 * Configure the request and make sure
 	 * that its job is run only for the LAST tile.
@@ -1555,36 +2507,41 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 	mutex_unlock(&cont->last_req_lock);
 #endif
 
-	/*
-	 * Same nodes are reused for all the jobs needed to complete the blit.
-	 * Nodes are NOT released together with associated job,
-	 * as is the case with optimized b2r2_blt() path.
-	 */
 	mutex_lock(&instance->lock);
 	instance->no_of_active_requests++;
 	mutex_unlock(&instance->lock);
 	/*
-	 * Process all but the last row in the destination rectangle.
+	 * Tiles go through the lanes in turn: the nodes of one lane are set
+	 * up for the next tile while the hardware still runs the tile of the
+	 * other, on the second core if there is one. The last tile is run
+	 * with the job from the request once all others are done, so that
+	 * clients are notified when the whole blit is complete and not just
+	 * part of it.
+	 *
 	 * Consider only the tiles that will actually end up inside
-	 * the destination image.
-	 * dst_rect->height - tmp_buf_height being <=0 is allright.
-	 * The loop will not be entered since y will always be equal to or
-	 * greater than zero.
-	 * Early exit check at the beginning handles the cases when nothing
-	 * at all should be processed.
+	 * the destination image. Early exit check at the beginning handles
+	 * the cases when nothing at all should be processed.
 	 */
 	y = 0;
 	if (dst_rect->y < 0)
 		y = -dst_rect->y;
 
-	for (; y < dst_rect->height - tmp_buf_height &&
-			y + dst_rect->y < dst_img_height - tmp_buf_height;
-			y += tmp_buf_height) {
-		/* Tile in the destination rectangle being processed */
-		struct b2r2_blt_rect dst_rect_tile;
+	for (;; y += tmp_buf_height) {
+		bool last_row = y >= dst_rect->height - tmp_buf_height ||
+			y + dst_rect->y >= dst_img_height - tmp_buf_height;
+
+		/*
+		 * Only the last row can be cut, by the destination image
+		 * or by dst_rect, in the same way as for width.
+		 */
 		dst_rect_tile.y = y;
-		dst_rect_tile.width = tmp_buf_width;
-		dst_rect_tile.height = tmp_buf_height;
+		if (y + dst_rect->y + tmp_buf_height > dst_img_height)
+			dst_rect_tile.height =
+				dst_img_height - (y + dst_rect->y);
+		else if (y + tmp_buf_height > dst_rect->height)
+			dst_rect_tile.height = dst_rect->height - y;
+		else
+			dst_rect_tile.height = tmp_buf_height;
 
 		x = 0;
 		if (dst_rect->x < 0)
@@ -1592,39 +2549,12 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 
 		for (; x < dst_rect->width && x + dst_rect->x < dst_img_width;
 				x += tmp_buf_width) {
-			/*
-			 * Tile jobs are freed by the supplied release function
-			 * when ref_count on a tile_job reaches zero.
-			 */
-			struct b2r2_core_job *tile_job =
-				kmalloc(sizeof(*tile_job), GFP_KERNEL);
-			if (tile_job == NULL) {
-				/*
-				 * Skip this tile. Do not abort,
-				 * just hope for better luck
-				 * with rest of the tiles.
-				 * Memory might become available.
-				 */
-				b2r2_log_info(cont->dev, "%s: Failed to alloc "
-						"job. Skipping tile at (x, y)="
-						"(%d, %d)\n", __func__, x, y);
-				continue;
-			}
-			tile_job->job_id = request->job.job_id;
-			tile_job->tag = request->job.tag;
-			tile_job->data = request->job.data;
-			tile_job->prio = request->job.prio;
-			tile_job->first_node_address =
-					request->job.first_node_address;
-			tile_job->last_node_address =
-					request->job.last_node_address;
-			tile_job->callback = tile_job_callback_gen;
-			tile_job->release = tile_job_release_gen;
-			/* Work buffers and nodes are pre-allocated */
-			tile_job->acquire_resources =
-				job_acquire_resources_gen;
-			tile_job->release_resources =
-				job_release_resources_gen;
+			bool last = last_row &&
+				(x + tmp_buf_width >= dst_rect->width ||
+				x + dst_rect->x + tmp_buf_width >=
+							dst_img_width);
+			struct gen_lane *lane;
+			struct b2r2_core_job *tile_job;
 
 			dst_rect_tile.x = x;
 			if (x + dst_rect->x + tmp_buf_width > dst_img_width) {
@@ -1644,13 +2574,39 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 				/* Whole tile can be written. */
 				dst_rect_tile.width = tmp_buf_width;
 			}
+
+			if (last) {
+				for (i = 0; i < n_lanes; i++)
+					nsec_active_in_b2r2 +=
+						gen_lane_wait(&lanes[i]);
+				lane = &lanes[0];
+				tile_job = &request->job;
+			} else {
+				lane = &lanes[tile_nr++ % n_lanes];
+				nsec_active_in_b2r2 += gen_lane_wait(lane);
+				tile_job = gen_tile_job(request, lane);
+				if (tile_job == NULL) {
+					/*
+					 * Skip this tile. Do not abort,
+					 * just hope for better luck
+					 * with rest of the tiles.
+					 * Memory might become available.
+					 */
+					b2r2_log_info(cont->dev, "%s: Failed "
+						"to alloc job. Skipping tile "
+						"at (x, y)=(%d, %d)\n",
+						__func__, x, y);
+					continue;
+				}
+			}
+
 			/*
 			 * Where applicable, calculate area in src buffer
 			 * that is needed to generate the specified part
 			 * of destination rectangle.
 			 */
 			b2r2_generic_set_areas(request,
-				request->first_node, &dst_rect_tile);
+				lane->first_node, &dst_rect_tile);
 			/* Submit the job */
 			b2r2_log_info(cont->dev,
 				"%s: Submitting job\n", __func__);
@@ -1659,7 +2615,7 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 
 			mutex_lock(&instance->lock);
 
-			request_id = b2r2_core_job_add(cont, tile_job);
+			request_id = b2r2_core_job_add(lane->cont, tile_job);
 
 			dec_stat(cont, &cont->stat_n_in_blt_add);
 
@@ -1669,6 +2625,8 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 					__func__, request_id);
 				ret = request_id;
 				mutex_unlock(&instance->lock);
+				if (!last)
+					kfree(tile_job);
 				goto job_add_failed;
 			}
 
@@ -1676,14 +2634,21 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 
 			mutex_unlock(&instance->lock);
 
-			/* Wait for the job to be done */
+			if (!last) {
+				/* Waited for when the lane comes round */
+				lane->job = tile_job;
+				continue;
+			}
+
+			/*
+			 * This is the last tile. Wait for the job-struct from
+			 * the request.
+			 */
 			b2r2_log_info(cont->dev, "%s: Synchronous, waiting\n",
 				__func__);
 
 			inc_stat(cont, &cont->stat_n_in_blt_wait);
-
-			ret = b2r2_core_job_wait(tile_job);
-
+			ret = b2r2_core_job_wait(&request->job);
 			dec_stat(cont, &cont->stat_n_in_blt_wait);
 
 			if (ret < 0 && ret != -ENOENT)
@@ -1694,167 +2659,10 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 				b2r2_log_info(cont->dev,
 					"%s: Synchronous wait done\n",
 					__func__);
-
-				nsec_active_in_b2r2 +=
-					tile_job->nsec_active_in_hw;
-			}
-			/* Release matching the addref in b2r2_core_job_add */
-			b2r2_core_job_release(tile_job, __func__);
-		}
-	}
-
-	x = 0;
-	if (dst_rect->x < 0)
-		x = -dst_rect->x;
-
-	for (; x < dst_rect->width &&
-			x + dst_rect->x < dst_img_width; x += tmp_buf_width) {
-		struct b2r2_core_job *tile_job = NULL;
-		if (x + tmp_buf_width < dst_rect->width &&
-				x + dst_rect->x + tmp_buf_width <
-				dst_img_width) {
-			/*
-			 * Tile jobs are freed by the supplied release function
-			 * when ref_count on a tile_job reaches zero.
-			 * Do NOT allocate a tile_job for the last tile.
-			 * Send the job from the request. This way clients
-			 * will be notified when the whole blit is complete
-			 * and not just part of it.
-			 */
-			tile_job = kmalloc(sizeof(*tile_job), GFP_KERNEL);
-			if (tile_job == NULL) {
-				b2r2_log_info(cont->dev, "%s: Failed to alloc "
-					"job. Skipping tile at (x, y)="
-					"(%d, %d)\n", __func__, x, y);
-				continue;
-			}
-			tile_job->job_id = request->job.job_id;
-			tile_job->tag = request->job.tag;
-			tile_job->data = request->job.data;
-			tile_job->prio = request->job.prio;
-			tile_job->first_node_address =
-				request->job.first_node_address;
-			tile_job->last_node_address =
-				request->job.last_node_address;
-			tile_job->callback = tile_job_callback_gen;
-			tile_job->release = tile_job_release_gen;
-			tile_job->acquire_resources =
-				job_acquire_resources_gen;
-			tile_job->release_resources =
-				job_release_resources_gen;
-		}
-
-		dst_rect_tile.x = x;
-		if (x + dst_rect->x + tmp_buf_width > dst_img_width) {
-			/*
-			 * Only a part of the tile can be written.
-			 * Limit imposed by buffer size.
-			 */
-			dst_rect_tile.width = dst_img_width - (x + dst_rect->x);
-		} else if (x + tmp_buf_width > dst_rect->width) {
-			/*
-			 * Only a part of the tile can be written.
-			 * In this case limit imposed by dst_rect size.
-			 */
-			dst_rect_tile.width = dst_rect->width - x;
-		} else {
-			/* Whole tile can be written. */
-			dst_rect_tile.width = tmp_buf_width;
-		}
-		/*
-		 * y is now the last row. Either because the whole dst_rect
-		 * has been processed, or because the last row that will be
-		 * written to dst_img has been reached. Limits imposed in
-		 * the same way as for width.
-		 */
-		dst_rect_tile.y = y;
-		if (y + dst_rect->y + tmp_buf_height > dst_img_height)
-			dst_rect_tile.height =
-				dst_img_height - (y + dst_rect->y);
-		else if (y + tmp_buf_height > dst_rect->height)
-			dst_rect_tile.height = dst_rect->height - y;
-		else
-			dst_rect_tile.height = tmp_buf_height;
-
-		b2r2_generic_set_areas(request,
-			request->first_node, &dst_rect_tile);
-
-		b2r2_log_info(cont->dev, "%s: Submitting job\n", __func__);
-		inc_stat(cont, &cont->stat_n_in_blt_add);
-
-		mutex_lock(&instance->lock);
-		if (x + tmp_buf_width < dst_rect->width &&
-				x + dst_rect->x + tmp_buf_width <
-				dst_img_width) {
-			request_id = b2r2_core_job_add(cont, tile_job);
-		} else {
-			/*
-			 * Last tile. Send the job-struct from the request.
-			 * Clients will be notified once it completes.
-			 */
-			request_id = b2r2_core_job_add(cont, &request->job);
-		}
-
-		dec_stat(cont, &cont->stat_n_in_blt_add);
-
-		if (request_id < 0) {
-			b2r2_log_warn(cont->dev, "%s: Failed to add tile job, "
-				"ret = %d\n", __func__, request_id);
-			ret = request_id;
-			mutex_unlock(&instance->lock);
-			if (tile_job != NULL)
-				kfree(tile_job);
-			goto job_add_failed;
-		}
-
-		inc_stat(cont, &cont->stat_n_jobs_added);
-		mutex_unlock(&instance->lock);
-
-		b2r2_log_info(cont->dev, "%s: Synchronous, waiting\n",
-			__func__);
-
-		inc_stat(cont, &cont->stat_n_in_blt_wait);
-		if (x + tmp_buf_width < dst_rect->width &&
-				x + dst_rect->x + tmp_buf_width <
-				dst_img_width) {
-			ret = b2r2_core_job_wait(tile_job);
-		} else {
-			/*
-			 * This is the last tile. Wait for the job-struct from
-			 * the request.
-			 */
-			ret = b2r2_core_job_wait(&request->job);
-		}
-		dec_stat(cont, &cont->stat_n_in_blt_wait);
-
-		if (ret < 0 && ret != -ENOENT)
-			b2r2_log_warn(cont->dev,
-				"%s: Failed to wait job, ret = %d\n",
-				__func__, ret);
-		else {
-			b2r2_log_info(cont->dev,
-				"%s: Synchronous wait done\n", __func__);
-
-			if (x + tmp_buf_width < dst_rect->width &&
-					x + dst_rect->x + tmp_buf_width <
-					dst_img_width)
-				nsec_active_in_b2r2 +=
-					tile_job->nsec_active_in_hw;
-			else
 				nsec_active_in_b2r2 +=
 					request->job.nsec_active_in_hw;
-		}
+			}
 
-		/*
-		 * Release matching the addref in b2r2_core_job_add.
-		 * Make sure that the correct job-struct is released
-		 * when the last tile is processed.
-		 */
-		if (x + tmp_buf_width < dst_rect->width &&
-				x + dst_rect->x + tmp_buf_width <
-				dst_img_width) {
-			b2r2_core_job_release(tile_job, __func__);
-		} else {
 			/*
 			 * Update profiling information before
 			 * the request is released together with
@@ -1877,10 +2685,17 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 				b2r2_call_profiler_blt_done(request);
 			}
 
+			/* Release matching the addref in b2r2_core_job_add */
 			b2r2_core_job_release(&request->job, __func__);
 		}
+
+		if (last_row)
+			break;
 	}
 
+	if (n_lanes > 1)
+		gen_lane_free(&lanes[1]);
+
 	dec_stat(cont, &cont->stat_n_in_blt);
 
 	for (i = 0; i < tmp_buf_count; i++) {
@@ -1894,6 +2709,10 @@ int b2r2_generic_blt(struct b2r2_blt_request *request)
 	return request_id;
 
 job_add_failed:
+	for (i = 0; i < n_lanes; i++)
+		gen_lane_wait(&lanes[i]);
+	if (n_lanes > 1)
+		gen_lane_free(&lanes[1]);
 exit_dry_run:
 generic_conf_failed:
 alloc_work_bufs_failed:
@@ -2035,7 +2854,11 @@ static void set_up_hwmem_region(struct b2r2_control *cont,
 	}
 }
 
-static int resolve_hwmem(struct b2r2_control *cont,
+/*
+ * Pins and maps the hwmem buffer in resolved_buf->hwmem_alloc, which holds a
+ * buffer reference. The reference is released if it fails.
+ */
+static int resolve_hwmem_alloc(struct b2r2_control *cont,
 		struct b2r2_blt_img *img,
 		struct b2r2_blt_rect *rect_2b_used,
 		bool is_dst,
@@ -2049,15 +2872,6 @@ static int resolve_hwmem(struct b2r2_control *cont,
 	size_t mem_chunk_length = 1;
 	struct hwmem_region region;
 
-	resolved_buf->hwmem_alloc =
-			hwmem_resolve_by_name(img->buf.hwmem_buf_name);
-	if (IS_ERR(resolved_buf->hwmem_alloc)) {
-		return_value = PTR_ERR(resolved_buf->hwmem_alloc);
-		b2r2_log_info(cont->dev, "%s: hwmem_resolve_by_name failed, "
-			"error code: %i\n", __func__, return_value);
-		goto resolve_failed;
-	}
-
 	hwmem_get_info(resolved_buf->hwmem_alloc, &resolved_buf->file_len,
 			&mem_type, &access);
 
@@ -2121,12 +2935,56 @@ size_check_failed:
 buf_scattered:
 access_check_failed:
 	hwmem_release(resolved_buf->hwmem_alloc);
-resolve_failed:
+	resolved_buf->hwmem_alloc = NULL;
 
 out:
 	return return_value;
 }
 
+static int resolve_hwmem(struct b2r2_control *cont,
+		struct b2r2_blt_img *img,
+		struct b2r2_blt_rect *rect_2b_used,
+		bool is_dst,
+		struct b2r2_resolved_buf *resolved_buf)
+{
+	int return_value;
+
+	resolved_buf->hwmem_alloc =
+			hwmem_resolve_by_name(img->buf.hwmem_buf_name);
+	if (IS_ERR(resolved_buf->hwmem_alloc)) {
+		return_value = PTR_ERR(resolved_buf->hwmem_alloc);
+		resolved_buf->hwmem_alloc = NULL;
+		b2r2_log_info(cont->dev, "%s: hwmem_resolve_by_name failed, "
+			"error code: %i\n", __func__, return_value);
+		return return_value;
+	}
+
+	return resolve_hwmem_alloc(cont, img, rect_2b_used, is_dst,
+			resolved_buf);
+}
+
+/*
+ * Resolves a dma-buf fd of a buffer exported by hwmem. Returns -ENOENT if the
+ * fd is not such a dma-buf, so that the caller tries the other fd types.
+ */
+static int resolve_dma_buf(struct b2r2_control *cont,
+		struct b2r2_blt_img *img,
+		struct b2r2_blt_rect *rect_2b_used,
+		bool is_dst,
+		struct b2r2_resolved_buf *resolved_buf)
+{
+	struct hwmem_alloc *alloc;
+
+	alloc = hwmem_resolve_by_dma_buf_fd(img->buf.fd);
+	if (IS_ERR(alloc))
+		return -ENOENT;
+
+	resolved_buf->hwmem_alloc = alloc;
+
+	return resolve_hwmem_alloc(cont, img, rect_2b_used, is_dst,
+			resolved_buf);
+}
+
 static void unresolve_hwmem(struct b2r2_resolved_buf *resolved_buf)
 {
 	hwmem_kunmap(resolved_buf->hwmem_alloc);
@@ -2146,6 +3004,10 @@ static void unresolve_buf(struct b2r2_control *cont,
 		struct b2r2_blt_buf *buf,
 		struct b2r2_resolved_buf *resolved)
 {
+	/* Unresolved with the request it was borrowed from */
+	if (resolved->borrowed)
+		return;
+
 #ifdef CONFIG_ANDROID_PMEM
 	if (resolved->is_pmem && resolved->filep)
 		put_pmem_file(resolved->filep);
@@ -2227,6 +3089,17 @@ static int resolve_buf(struct b2r2_control *cont,
 
 		/* FD + OFFSET type */
 	case B2R2_BLT_PTR_FD_OFFSET: {
+		/*
+		 * A dma-buf of a hwmem buffer is resolved like a hwmem buffer,
+		 * with the access of the fd and without copying or cache
+		 * maintenance beyond what hwmem's domain tracking needs.
+		 */
+		ret = resolve_dma_buf(cont, img, rect_2b_used, is_dst,
+				resolved);
+		if (ret != -ENOENT)
+			break;
+		ret = 0;
+
 		/*
 		 * TODO: Do we need to check if the process is allowed to
 		 * read/write (depending on if it's dst or src) to the file?
@@ -2309,9 +3182,18 @@ static void sync_buf(struct b2r2_control *cont,
 	struct sync_args sa;
 	u32 start_phys, end_phys;
 
-	if (B2R2_BLT_PTR_NONE == img->buf.type ||
-			B2R2_BLT_PTR_HWMEM_BUF_NAME_OFFSET == img->buf.type)
+	if (B2R2_BLT_PTR_NONE == img->buf.type)
+		return;
+
+	/*
+	 * Hwmem keeps track of the domain that last wrote the buffer, and
+	 * does the maintenance needed when the buffer is resolved. Nothing
+	 * at all is done for a buffer only written by hardware.
+	 */
+	if (resolved->hwmem_alloc != NULL) {
+		inc_stat(cont, &cont->stat_n_cache_syncs_skipped);
 		return;
+	}
 
 	start_phys = resolved->physical_address;
 	end_phys = resolved->physical_address + img->buf.len;
@@ -2330,9 +3212,12 @@ static void sync_buf(struct b2r2_control *cont,
 		 */
 		wmb();
 
+		inc_stat(cont, &cont->stat_n_cache_syncs_skipped);
 		return;
 	}
 
+	inc_stat(cont, &cont->stat_n_cache_syncs);
+
 	/*
 	 * src_mask does not have rect.
 	 * Also flush full buffer for planar and semiplanar YUV formats
@@ -2437,21 +3322,13 @@ static void sync_buf(struct b2r2_control *cont,
 		 */
 
 		/* Flush L1 cache */
-#ifdef CONFIG_SMP
-		flush_l1_cache_range_all_cpus(&sa);
-#else
-		flush_l1_cache_range_curr_cpu(&sa);
-#endif
+		flush_l1_cache_range(cont, &sa);
 
 		/* Flush L2 cache */
 		outer_flush_range(start_phys, end_phys);
 	} else {
 		/* Clean L1 cache */
-#ifdef CONFIG_SMP
-		clean_l1_cache_range_all_cpus(&sa);
-#else
-		clean_l1_cache_range_curr_cpu(&sa);
-#endif
+		clean_l1_cache_range(cont, &sa);
 
 		/* Clean L2 cache */
 		outer_clean_range(start_phys, end_phys);
@@ -2514,6 +3391,57 @@ static void dec_stat(struct b2r2_control *cont, unsigned long *stat)
 	mutex_unlock(&cont->stat_lock);
 }
 
+#ifndef CONFIG_B2R2_GENERIC_ONLY
+/**
+ * record_stage() - Adds a sample to the latency histogram of a stage
+ *
+ * @stage: The stage
+ * @nsec: Time spent in the stage
+ */
+static void record_stage(struct b2r2_control *cont, enum b2r2_stage stage,
+		s64 nsec)
+{
+	struct b2r2_stage_hist *hist = &cont->stage_hist[stage];
+	u32 usec;
+	int bucket = 0;
+
+	if (nsec < 0)
+		nsec = 0;
+
+	usec = (u32)min_t(u64, div_u64(nsec, NSEC_PER_USEC), U32_MAX);
+	if (usec > 0)
+		bucket = min_t(int, ilog2(usec), B2R2_STAGE_HIST_BUCKETS - 1);
+
+	mutex_lock(&cont->stat_lock);
+	hist->count++;
+	hist->total_nsec += nsec;
+	if (nsec > hist->max_nsec)
+		hist->max_nsec = nsec;
+	hist->buckets[bucket]++;
+	mutex_unlock(&cont->stat_lock);
+}
+
+/**
+ * request_stage() - Ends a stage of a request done by the CPU
+ *
+ * @request: The request
+ * @stage: The stage ended
+ *
+ * The next stage starts now. Returns the time spent in the stage.
+ */
+static s64 request_stage(struct b2r2_blt_request *request,
+		enum b2r2_stage stage)
+{
+	ktime_t now = ktime_get();
+	s64 nsec = ktime_to_ns(ktime_sub(now, request->ts_stage));
+
+	request->ts_stage = now;
+	record_stage(request->instance->control, stage, nsec);
+
+	return nsec;
+}
+#endif
+
 
 #ifdef CONFIG_DEBUG_FS
 /**
@@ -2855,6 +3783,16 @@ static int debugfs_b2r2_blt_stat_read(struct file *filp, char __user *buf,
 		cont->stat_n_in_synch_job);
 	dev_size += sprintf(Buf + dev_size, "Clients in query_cap : %lu\n",
 		cont->stat_n_in_query_cap);
+	dev_size += sprintf(Buf + dev_size, "Node cache hits      : %lu\n",
+		cont->stat_n_node_cache_hits);
+	dev_size += sprintf(Buf + dev_size, "Node cache misses    : %lu\n",
+		cont->stat_n_node_cache_misses);
+	dev_size += sprintf(Buf + dev_size, "Cache syncs          : %lu\n",
+		cont->stat_n_cache_syncs);
+	dev_size += sprintf(Buf + dev_size, "Cache syncs skipped  : %lu\n",
+		cont->stat_n_cache_syncs_skipped);
+	dev_size += sprintf(Buf + dev_size, "Cache sync IPIs      : %lu\n",
+		cont->stat_n_cache_ipis);
 	mutex_unlock(&cont->stat_lock);
 
 	/* No more to read if offset != 0 */
@@ -2884,6 +3822,132 @@ static const struct file_operations debugfs_b2r2_blt_stat_fops = {
 	.read  = debugfs_b2r2_blt_stat_read,
 };
 
+static const char * const stage_names[B2R2_NUM_STAGES] = {
+	[B2R2_STAGE_RESOLVE] = "resolve",
+	[B2R2_STAGE_NODES] = "nodes",
+	[B2R2_STAGE_CACHE_SYNC] = "cache",
+	[B2R2_STAGE_QUEUE] = "queue",
+	[B2R2_STAGE_HW] = "hw",
+	[B2R2_STAGE_CALLBACK] = "done",
+};
+
+/**
+ * debugfs_b2r2_stage_latency_read() - Implements debugfs read for the
+ *                                     latency histograms of the stages
+ * @filp: File pointer
+ * @buf: User space buffer
+ * @count: Number of bytes to read
+ * @f_pos: File position
+ *
+ * Returns number of bytes read or negative error code
+ */
+static int debugfs_b2r2_stage_latency_read(struct file *filp,
+		char __user *buf, size_t count, loff_t *f_pos)
+{
+	size_t dev_size = 0;
+	int ret = 0;
+	int i;
+	int j;
+	char *Buf = kmalloc(sizeof(char) * 4096, GFP_KERNEL);
+	struct b2r2_control *cont = filp->f_dentry->d_inode->i_private;
+
+	if (Buf == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	mutex_lock(&cont->stat_lock);
+	dev_size += sprintf(Buf + dev_size, "%-13s", "usec");
+	for (i = 0; i < B2R2_NUM_STAGES; i++)
+		dev_size += sprintf(Buf + dev_size, " %9s", stage_names[i]);
+	dev_size += sprintf(Buf + dev_size, "\n");
+
+	for (j = 0; j < B2R2_STAGE_HIST_BUCKETS; j++) {
+		if (j == 0)
+			dev_size += sprintf(Buf + dev_size, "%-13s", "< 2");
+		else if (j == B2R2_STAGE_HIST_BUCKETS - 1)
+			dev_size += sprintf(Buf + dev_size, ">= %-10u",
+				1 << j);
+		else
+			dev_size += sprintf(Buf + dev_size, "%5u - %-5u",
+				1 << j, (1 << (j + 1)) - 1);
+
+		for (i = 0; i < B2R2_NUM_STAGES; i++)
+			dev_size += sprintf(Buf + dev_size, " %9u",
+				cont->stage_hist[i].buckets[j]);
+		dev_size += sprintf(Buf + dev_size, "\n");
+	}
+
+	dev_size += sprintf(Buf + dev_size, "%-13s", "count");
+	for (i = 0; i < B2R2_NUM_STAGES; i++)
+		dev_size += sprintf(Buf + dev_size, " %9u",
+			cont->stage_hist[i].count);
+	dev_size += sprintf(Buf + dev_size, "\n%-13s", "avg");
+	for (i = 0; i < B2R2_NUM_STAGES; i++) {
+		struct b2r2_stage_hist *hist = &cont->stage_hist[i];
+
+		dev_size += sprintf(Buf + dev_size, " %9llu", hist->count ?
+			div_u64(div_u64(hist->total_nsec, hist->count),
+				NSEC_PER_USEC) : 0);
+	}
+	dev_size += sprintf(Buf + dev_size, "\n%-13s", "max");
+	for (i = 0; i < B2R2_NUM_STAGES; i++)
+		dev_size += sprintf(Buf + dev_size, " %9llu",
+			div_u64(cont->stage_hist[i].max_nsec, NSEC_PER_USEC));
+	dev_size += sprintf(Buf + dev_size, "\n");
+	mutex_unlock(&cont->stat_lock);
+
+	/* No more to read if offset != 0 */
+	if (*f_pos > dev_size)
+		goto out;
+
+	if (*f_pos + count > dev_size)
+		count = dev_size - *f_pos;
+
+	if (copy_to_user(buf, Buf, count))
+		ret = -EINVAL;
+	*f_pos += count;
+	ret = count;
+
+out:
+	if (Buf != NULL)
+		kfree(Buf);
+	return ret;
+}
+
+/**
+ * debugfs_b2r2_stage_latency_write() - Clears the latency histograms
+ * @filp: File pointer
+ * @buf: User space buffer
+ * @count: Number of bytes to write
+ * @f_pos: File position
+ *
+ * Returns number of bytes written
+ */
+static int debugfs_b2r2_stage_latency_write(struct file *filp,
+		const char __user *buf, size_t count, loff_t *f_pos)
+{
+	struct b2r2_control *cont = filp->f_dentry->d_inode->i_private;
+
+	mutex_lock(&cont->stat_lock);
+	memset(cont->stage_hist, 0, sizeof(cont->stage_hist));
+	mutex_unlock(&cont->stat_lock);
+
+	*f_pos += count;
+
+	return count;
+}
+
+/**
+ * debugfs_b2r2_stage_latency_fops() - File operations for the latency
+ *                                     histograms debugfs
+ */
+static const struct file_operations debugfs_b2r2_stage_latency_fops = {
+	.owner = THIS_MODULE,
+	.read  = debugfs_b2r2_stage_latency_read,
+	.write = debugfs_b2r2_stage_latency_write,
+};
+
 /**
  * debugfs_b2r2_bypass_read() - Implements debugfs read for
  *                             B2R2 Core Enable/Disable
@@ -3054,6 +4118,9 @@ int b2r2_control_init(struct b2r2_control *cont)
 		debugfs_create_file("stats", 0664,
 			cont->debugfs_root_dir,
 			cont, &debugfs_b2r2_blt_stat_fops);
+		debugfs_create_file("stage_latency", 0664,
+			cont->debugfs_root_dir,
+			cont, &debugfs_b2r2_stage_latency_fops);
 		debugfs_create_file("bypass", 0664,
 			cont->debugfs_root_dir,
 			cont, &debugfs_b2r2_bypass_fops);
@@ -51,6 +51,7 @@
 #include <linux/kref.h>
 #include <linux/ktime.h>
 #include <linux/mutex.h>
+#include <linux/math64.h>
 
 #include "b2r2_internal.h"
 #include "b2r2_core.h"
@@ -61,6 +62,9 @@
 #include "b2r2_timing.h"
 #include "b2r2_debug.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/b2r2.h>
+
 /**
  * B2R2 Hardware defines below
  */
@@ -390,9 +394,13 @@ int b2r2_core_job_add(struct b2r2_control *control,
 	}
 
 	core->stat_n_jobs_added++;
+	core->pending_cost += job->cost;
 
 	/* Initialise internal job data */
 	init_job(job);
+	job->ts_added = ktime_get();
+	job->ts_triggered = ktime_set(0, 0);
+	job->ts_done = ktime_set(0, 0);
 
 	/* Initial reference, should be released by caller of this function */
 	job->ref_count = 1;
@@ -556,6 +564,8 @@ static bool cancel_job(struct b2r2_core *core, struct b2r2_core_job *job)
 
 	/* Handle done list & callback */
 	if (found_job) {
+		core->pending_cost -= job->cost;
+
 		/* Job is canceled */
 		job->job_state = B2R2_CORE_JOB_CANCELED;
 
@@ -863,6 +873,7 @@ static void timeout_work_function(struct work_struct *ptr)
 		b2r2_log_warn(core->dev, "%s: Job timeout\n", __func__);
 
 		list_del_init(&job->list);
+		core->pending_cost -= job->cost;
 
 		/* Job is cancelled */
 		job->job_state = B2R2_CORE_JOB_CANCELED;
@@ -988,6 +999,46 @@ static void stop_hw_timer(struct b2r2_core *core, struct b2r2_core_job *job)
 	}
 }
 
+/**
+ * update_load() - Accounts for the time a done job spent in hardware
+ *
+ * @core: The b2r2 core entity
+ * @job: The job, done
+ *
+ * core->lock _must_ be held when calling this function
+ */
+static void update_load(struct b2r2_core *core, struct b2r2_core_job *job)
+{
+	core->pending_cost -= job->cost;
+
+	if (job->nsec_active_in_hw <= 0)
+		return;
+
+	core->nsec_busy += job->nsec_active_in_hw;
+
+	/* Running average over the last eight or so jobs */
+	if (job->cost >= B2R2_MIN_COST_SAMPLE) {
+		u32 sample = (u32)div_u64((u64)job->nsec_active_in_hw << 10,
+				job->cost);
+
+		core->nsec_per_kcost = core->nsec_per_kcost -
+			(core->nsec_per_kcost >> 3) + (sample >> 3);
+	}
+}
+
+u64 b2r2_core_get_load(struct b2r2_control *control)
+{
+	struct b2r2_core *core = control->data;
+	unsigned long flags;
+	u64 load;
+
+	spin_lock_irqsave(&core->lock, flags);
+	load = ((u64)core->pending_cost * core->nsec_per_kcost) >> 10;
+	spin_unlock_irqrestore(&core->lock, flags);
+
+	return load;
+}
+
 /**
  * init_job() - Initializes a job structure from filled in client data.
  *              Reference count will be set to 1
@@ -1347,6 +1398,8 @@ static void trigger_job(struct b2r2_core *core, struct b2r2_core_job *job)
 
 	reset_hw_timer(job);
 	job->job_state = B2R2_CORE_JOB_RUNNING;
+	job->ts_triggered = ktime_get();
+	trace_b2r2_hw_start(job, job->job_id, job->queue);
 
 	/* Enable interrupt */
 	writel(readl(&core->hw->BLT_ITM0) | job->interrupt_context,
@@ -1478,6 +1531,9 @@ static void handle_queue_event(struct b2r2_core *core,
 		return;
 	}
 
+	update_load(core, job);
+	job->ts_done = ktime_get();
+	trace_b2r2_hw_done(job, job->job_id, job->nsec_active_in_hw);
 
 	/*
 	 * Atomic context release resources, release resources will
@@ -2010,6 +2066,10 @@ static int debugfs_b2r2_stat_read(struct file *filp, char __user *buf,
 	size_t dev_size = 0;
 	int ret = 0;
 	int i = 0;
+	unsigned long flags;
+	ktime_t now;
+	s64 window;
+	s64 busy;
 	char *tmpbuf = kmalloc(sizeof(char) * 4096, GFP_KERNEL);
 	struct b2r2_core *core = filp->f_dentry->d_inode->i_private;
 
@@ -2036,6 +2096,21 @@ static int debugfs_b2r2_stat_read(struct file *filp, char __user *buf,
 	dev_size += sprintf(tmpbuf + dev_size, "Clock requests    : %lu\n",
 			core->clock_request_count);
 
+	/* Utilisation since the previous read */
+	spin_lock_irqsave(&core->lock, flags);
+	now = ktime_get();
+	window = ktime_to_ns(ktime_sub(now, core->util_start));
+	busy = core->nsec_busy - core->util_busy_start;
+	core->util_start = now;
+	core->util_busy_start = core->nsec_busy;
+	dev_size += sprintf(tmpbuf + dev_size, "Pending cost      : %lu\n",
+			core->pending_cost);
+	dev_size += sprintf(tmpbuf + dev_size, "Nsec per kcost    : %u\n",
+			core->nsec_per_kcost);
+	spin_unlock_irqrestore(&core->lock, flags);
+	dev_size += sprintf(tmpbuf + dev_size, "Utilisation       : %u%%\n",
+			window > 0 ? (u32)div64_s64(busy * 100, window) : 0);
+
 	/* No more to read if offset != 0 */
 	if (*f_pos > dev_size)
 		goto out;
@@ -2406,6 +2481,9 @@ static int b2r2_probe(struct platform_device *pdev)
 	/* Init job queues */
 	INIT_LIST_HEAD(&core->prio_queue);
 
+	core->nsec_per_kcost = B2R2_DEFAULT_NSEC_PER_KCOST;
+	core->util_start = ktime_get();
+
 #ifdef HANDLE_TIMEOUTED_JOBS
 	/* Create work queue for callbacks & timeout */
 	INIT_DELAYED_WORK(&core->timeout_work, timeout_work_function);
@@ -2556,6 +2634,9 @@ static int b2r2_probe(struct platform_device *pdev)
 	control->bypass = false;
 	b2r2_blt_add_control(control);
 
+	/* Nothing else depends on B2R2 being suspended or resumed */
+	device_enable_async_suspend(&pdev->dev);
+
 	b2r2_core[pdev->id] = core;
 	dev_info(&pdev->dev, "%s done.\n", __func__);
 
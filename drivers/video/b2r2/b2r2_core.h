@@ -44,6 +44,14 @@
 #define JOB_TIMEOUT (HZ/2)
 #endif
 
+/**
+ * B2R2_DEFAULT_NSEC_PER_KCOST - Hardware time per 1024 pixels until jobs
+ *                               have been measured
+ * B2R2_MIN_COST_SAMPLE - Smaller jobs do not give a usable time per pixel
+ */
+#define B2R2_DEFAULT_NSEC_PER_KCOST 5120
+#define B2R2_MIN_COST_SAMPLE 4096
+
 /**
  * B2R2_CLOCK_ALWAYS_ON - Define this to disable power save clock turn off
  */
@@ -129,6 +137,12 @@ struct addref_release {
  * @stat_n_jobs_removed: Number of jobs removed (statistics)
  * @stat_n_jobs_in_prio_list: Number of jobs in prio list (statistics)
  *
+ * @pending_cost: Cost of the jobs queued and running
+ * @nsec_per_kcost: Measured hardware time per 1024 cost units
+ * @nsec_busy: Total time jobs spent in hardware
+ * @util_start: Start of the utilisation reported in debugfs
+ * @util_busy_start: nsec_busy at util_start
+ *
  * @debugfs_root_dir: Root directory for B2R2 debugfs
  *
  * @ar: Circular array of addref / release debug structs
@@ -177,6 +191,13 @@ struct b2r2_core {
 
 	unsigned long    stat_n_jobs_in_prio_list;
 
+	/* Load, for the choice of core */
+	unsigned long    pending_cost;
+	u32              nsec_per_kcost;
+	s64              nsec_busy;
+	ktime_t          util_start;
+	s64              util_busy_start;
+
 #ifdef CONFIG_DEBUG_FS
 	struct dentry *debugfs_root_dir;
 	struct dentry *debugfs_core_root_dir;
@@ -278,6 +299,19 @@ struct b2r2_core_job *b2r2_core_job_find(struct b2r2_control *control,
 struct b2r2_core_job *b2r2_core_job_find_first_with_tag(
 		struct b2r2_control *control, int tag);
 
+/**
+ * b2r2_core_get_load() - Estimates the time needed for the jobs queued
+ *                        and running on a core
+ *
+ * The estimate is the cost of the jobs times the time per cost unit
+ * measured on the core for the last jobs.
+ *
+ * @control: The b2r2 control entity
+ *
+ * Returns the estimated time in nanoseconds
+ */
+u64 b2r2_core_get_load(struct b2r2_control *control);
+
 /**
  * b2r2_core_job_addref() - Increase the job reference count.
  *
@@ -9,6 +9,7 @@
  */
 
 #include <linux/dma-mapping.h>
+#include <linux/mutex.h>
 
 #include "b2r2_filters.h"
 #include "b2r2_internal.h"
@@ -236,11 +237,23 @@ static struct b2r2_filter_spec blur_filter = {
 	},
 };
 
+/*
+ * All coefficient tables live in one coherent block shared by the B2R2
+ * cores, each filter at a fixed stride with the vertical table after the
+ * horizontal one.
+ */
+#define B2R2_FILTER_STRIDE ALIGN(B2R2_HF_TABLE_SIZE + B2R2_VF_TABLE_SIZE, 64)
+#define B2R2_FILTER_COUNT (filters_size + 3)
+
+static DEFINE_MUTEX(coeffs_lock);
+static int coeffs_users;
+static struct device *coeffs_dev;
+static void *coeffs_block;
+static dma_addr_t coeffs_block_phys;
+
 /* Private function declarations */
-static int alloc_filter_coeffs(struct device *dev,
-		struct b2r2_filter_spec *filter);
-static void free_filter_coeffs(struct device *dev,
-		struct b2r2_filter_spec *filter);
+static void set_filter_coeffs(struct b2r2_filter_spec *filter, int index);
+static void clear_filter_coeffs(struct b2r2_filter_spec *filter);
 
 /* Public functions */
 
@@ -251,13 +264,29 @@ int b2r2_filters_init(struct b2r2_control *cont)
 	if (cont->filters_initialized)
 		return 0;
 
-	for (i = 0; i < filters_size; i++) {
-		alloc_filter_coeffs(cont->dev, &filters[i]);
+	mutex_lock(&coeffs_lock);
+
+	if (coeffs_users == 0) {
+		coeffs_block = dma_alloc_coherent(cont->dev,
+				B2R2_FILTER_COUNT * B2R2_FILTER_STRIDE,
+				&coeffs_block_phys, GFP_DMA | GFP_KERNEL);
+		if (coeffs_block == NULL) {
+			/* Scaling falls back to no filtering */
+			mutex_unlock(&coeffs_lock);
+			return 0;
+		}
+		coeffs_dev = get_device(cont->dev);
+
+		for (i = 0; i < filters_size; i++)
+			set_filter_coeffs(&filters[i], i);
+
+		set_filter_coeffs(&bilinear_filter, i++);
+		set_filter_coeffs(&default_downscale_filter, i++);
+		set_filter_coeffs(&blur_filter, i);
 	}
+	coeffs_users++;
 
-	alloc_filter_coeffs(cont->dev, &bilinear_filter);
-	alloc_filter_coeffs(cont->dev, &default_downscale_filter);
-	alloc_filter_coeffs(cont->dev, &blur_filter);
+	mutex_unlock(&coeffs_lock);
 
 	cont->filters_initialized = 1;
 
@@ -271,13 +300,25 @@ void b2r2_filters_exit(struct b2r2_control *cont)
 	if (!cont->filters_initialized)
 		return;
 
-	for (i = 0; i < filters_size; i++) {
-		free_filter_coeffs(cont->dev, &filters[i]);
+	mutex_lock(&coeffs_lock);
+
+	if (--coeffs_users == 0) {
+		for (i = 0; i < filters_size; i++)
+			clear_filter_coeffs(&filters[i]);
+
+		clear_filter_coeffs(&bilinear_filter);
+		clear_filter_coeffs(&default_downscale_filter);
+		clear_filter_coeffs(&blur_filter);
+
+		dma_free_coherent(coeffs_dev,
+				B2R2_FILTER_COUNT * B2R2_FILTER_STRIDE,
+				coeffs_block, coeffs_block_phys);
+		put_device(coeffs_dev);
+		coeffs_dev = NULL;
+		coeffs_block = NULL;
 	}
 
-	free_filter_coeffs(cont->dev, &bilinear_filter);
-	free_filter_coeffs(cont->dev, &default_downscale_filter);
-	free_filter_coeffs(cont->dev, &blur_filter);
+	mutex_unlock(&coeffs_lock);
 
 	cont->filters_initialized = 0;
 }
@@ -324,52 +365,25 @@ struct b2r2_filter_spec *b2r2_filter_blur()
 }
 
 /* Private functions */
-static int alloc_filter_coeffs(struct device *dev,
-		struct b2r2_filter_spec *filter)
+static void set_filter_coeffs(struct b2r2_filter_spec *filter, int index)
 {
-	int ret;
-
-	filter->h_coeffs_dma_addr = dma_alloc_coherent(dev,
-			B2R2_HF_TABLE_SIZE, &(filter->h_coeffs_phys_addr),
-			GFP_DMA | GFP_KERNEL);
-	if (filter->h_coeffs_dma_addr == NULL) {
-		ret = -ENOMEM;
-		goto error;
-	}
+	u32 offset = index * B2R2_FILTER_STRIDE;
 
-	filter->v_coeffs_dma_addr = dma_alloc_coherent(dev,
-			B2R2_VF_TABLE_SIZE, &(filter->v_coeffs_phys_addr),
-			GFP_DMA | GFP_KERNEL);
-	if (filter->v_coeffs_dma_addr == NULL) {
-		ret = -ENOMEM;
-		goto error;
-	}
+	filter->h_coeffs_dma_addr = coeffs_block + offset;
+	filter->h_coeffs_phys_addr = coeffs_block_phys + offset;
+	filter->v_coeffs_dma_addr = coeffs_block + offset +
+			B2R2_HF_TABLE_SIZE;
+	filter->v_coeffs_phys_addr = coeffs_block_phys + offset +
+			B2R2_HF_TABLE_SIZE;
 
 	memcpy(filter->h_coeffs_dma_addr, filter->h_coeffs,
 			B2R2_HF_TABLE_SIZE);
 	memcpy(filter->v_coeffs_dma_addr, filter->v_coeffs,
 			B2R2_VF_TABLE_SIZE);
-
-	return 0;
-
-error:
-	free_filter_coeffs(dev, filter);
-	return ret;
-
 }
 
-static void free_filter_coeffs(struct device *dev,
-		struct b2r2_filter_spec *filter)
+static void clear_filter_coeffs(struct b2r2_filter_spec *filter)
 {
-	if (filter->h_coeffs_dma_addr != NULL)
-		dma_free_coherent(dev, B2R2_HF_TABLE_SIZE,
-				filter->h_coeffs_dma_addr,
-				filter->h_coeffs_phys_addr);
-	if (filter->v_coeffs_dma_addr != NULL)
-		dma_free_coherent(dev, B2R2_VF_TABLE_SIZE,
-				filter->v_coeffs_dma_addr,
-				filter->v_coeffs_phys_addr);
-
 	filter->h_coeffs_dma_addr = NULL;
 	filter->h_coeffs_phys_addr = 0;
 	filter->v_coeffs_dma_addr = NULL;
@@ -18,6 +18,9 @@
 #include <linux/ktime.h>
 #include <video/b2r2_blt.h>
 #include <linux/debugfs.h>
+#ifdef CONFIG_B2R2_FENCE
+#include <linux/sw_sync.h>
+#endif
 
 #include "b2r2_global.h"
 #include "b2r2_hw.h"
@@ -162,6 +165,11 @@ struct b2r2_control_instance {
 	u32 no_of_active_requests;
 	bool synching;
 	wait_queue_head_t synch_done_waitq;
+
+#ifdef CONFIG_B2R2_FENCE
+	/* Requests held back until their input fence signals */
+	struct list_head fence_list;
+#endif
 };
 
 /**
@@ -201,6 +209,8 @@ struct b2r2_node {
  * @file_physical_start: Physical address of file start
  * @file_virtual_start: Virtual address of file start
  * @file_len: File len
+ * @borrowed: true if the buffer is resolved by another request of the
+ *            same batch, which also unresolves it
  *
  */
 struct b2r2_resolved_buf {
@@ -213,6 +223,7 @@ struct b2r2_resolved_buf {
 	u32                   file_physical_start;
 	u32                   file_virtual_start;
 	u32                   file_len;
+	bool                  borrowed;
 };
 
 /**
@@ -350,6 +361,8 @@ struct b2r2_node_split_job {
  *                      in by the client.
  * @last_node_address: Physical address of the last node. Filled
  *                     in by the client.
+ * @cost: Estimated amount of work of the job, in pixels read and written.
+ *        Filled in by the client, 0 if unknown.
  *
  * @callback: Function that will be called when the job is done.
  * @acquire_resources: Function that allocates the resources needed
@@ -375,6 +388,9 @@ struct b2r2_node_split_job {
  * @interrupt_context: Context for interrupt
  * @hw_ts_start: The point when the b2r2 HW queue is activated for this job
  * @nsec_active_in_hw: Time spent on the b2r2 HW queue for this job
+ * @ts_added: When the job was added to b2r2_core
+ * @ts_triggered: When the job was put in a B2R2 HW queue, zero if never
+ * @ts_done: When the B2R2 HW was done with the job, zero if never
  *
  * @end_sentinel: Memory overwrite guard
  */
@@ -387,6 +403,7 @@ struct b2r2_core_job {
 	int prio;
 	u32 first_node_address;
 	u32 last_node_address;
+	u32 cost;
 	void (*callback)(struct b2r2_core_job *);
 	int (*acquire_resources)(struct b2r2_core_job *,
 		bool atomic);
@@ -419,6 +436,11 @@ struct b2r2_core_job {
 	struct timespec hw_ts_start;
 	s64 nsec_active_in_hw;
 
+	/* Stage timestamps */
+	ktime_t ts_added;
+	ktime_t ts_triggered;
+	ktime_t ts_done;
+
 	u32 end_sentinel;
 };
 
@@ -427,6 +449,8 @@ struct b2r2_core_job {
  *
  * @instance:           Back pointer to the instance structure
  * @list:               List item to keep track of requests per instance
+ * @batch:              Requests executed before this one in the same job,
+ *                      list item in that list for those requests
  * @user_req:           The request received from userspace
  * @job:                The administration structure for the B2R2 job
  *                      consisting of one or more nodes
@@ -435,6 +459,7 @@ struct b2r2_core_job {
  * @first_node:         Pointer to the first B2R2 node
  * @request_id:         Request id for this job
  * @core_mask:          Bit mask with the cores doing part of the job
+ * @aux_control:        Second core the generic path may spread tiles over
  * @node_split_handle:  Handle of the node split
  * @src_resolved:       Calculated info about the source buffer
  * @src_mask_resolved:  Calculated info about the source mask buffer
@@ -446,16 +471,23 @@ struct b2r2_core_job {
  *                      processing the job.
  * @total_time_nsec:    Total job execution time including context switches and
  *                      queue time.
+ * @ts_stage:           End of the last stage of the request done by the CPU
+ * @in_fence:           Fence the job is held back for until it signals
+ * @fence_waiter:       Async waiter on in_fence
+ * @fence_work:         Adds the job once in_fence has signalled
+ * @timeline:           Timeline of the fence signalled when the job is done
  */
 struct b2r2_blt_request {
 	struct b2r2_control_instance   *instance;
 	struct list_head           list;
+	struct list_head           batch;
 	struct b2r2_blt_req        user_req;
 	struct b2r2_core_job       job;
 	struct b2r2_node_split_job node_split_job;
 	struct b2r2_node           *first_node;
 	int                        request_id;
 	u32                        core_mask;
+	struct b2r2_control        *aux_control;
 
 	/* Resolved buffer addresses */
 	struct b2r2_resolved_buf src_resolved;
@@ -476,6 +508,15 @@ struct b2r2_blt_request {
 	struct timespec ts_start;
 	s64 nsec_active_in_cpu;
 	s64 total_time_nsec;
+	ktime_t ts_stage;
+
+#ifdef CONFIG_B2R2_FENCE
+	/* Fence the job is held back for, and the one signalled when done */
+	struct sync_fence *in_fence;
+	struct sync_fence_waiter fence_waiter;
+	struct work_struct fence_work;
+	struct sw_sync_timeline *timeline;
+#endif
 };
 
 /**
@@ -532,6 +573,57 @@ struct b2r2_mem_dump {
 	struct dentry                 *debugfs_dst_info;
 };
 
+/**
+ * struct b2r2_node_cache - Node lists of recent requests, for reuse
+ *
+ * @lock: Protects the cache
+ * @list: The cached node lists, most recently used first
+ * @count: Number of cached node lists
+ */
+struct b2r2_node_cache {
+	struct mutex     lock;
+	struct list_head list;
+	int              count;
+};
+
+/**
+ * enum b2r2_stage - The stages of a blit request that are timed
+ *
+ * @B2R2_STAGE_RESOLVE: Resolving the buffers
+ * @B2R2_STAGE_NODES: Building the node list
+ * @B2R2_STAGE_CACHE_SYNC: Cache maintenance of the buffers
+ * @B2R2_STAGE_QUEUE: Waiting for a B2R2 HW queue
+ * @B2R2_STAGE_HW: Active in the B2R2 HW
+ * @B2R2_STAGE_CALLBACK: From B2R2 HW done until the request is handled
+ */
+enum b2r2_stage {
+	B2R2_STAGE_RESOLVE,
+	B2R2_STAGE_NODES,
+	B2R2_STAGE_CACHE_SYNC,
+	B2R2_STAGE_QUEUE,
+	B2R2_STAGE_HW,
+	B2R2_STAGE_CALLBACK,
+	B2R2_NUM_STAGES,
+};
+
+#define B2R2_STAGE_HIST_BUCKETS 16
+
+/**
+ * struct b2r2_stage_hist - Latency histogram of one request stage
+ *
+ * @count: Number of samples
+ * @total_nsec: Sum of the samples
+ * @max_nsec: Largest sample
+ * @buckets: Bucket n holds the samples of 2^n to 2^(n+1) usec, the first
+ *           one also those below 1 usec and the last one all above
+ */
+struct b2r2_stage_hist {
+	u32 count;
+	u64 total_nsec;
+	s64 max_nsec;
+	u32 buckets[B2R2_STAGE_HIST_BUCKETS];
+};
+
 /**
  * struct b2r2_control - The b2r2 core control structure
  *
@@ -567,6 +659,14 @@ struct b2r2_mem_dump {
  * @stat_n_in_query_cap: Number of clients currently in query cap
  * @stat_n_in_open: Number of clients currently in b2r2_blt_open
  * @stat_n_in_release: Number of clients currently in b2r2_blt_release
+ * @stat_n_node_cache_hits: Number of node lists taken from the node cache
+ * @stat_n_node_cache_misses: Number of node lists built by the node splitter
+ * @stat_n_cache_syncs: Number of buffers synched by CPU cache maintenance
+ * @stat_n_cache_syncs_skipped: Number of buffers needing no maintenance by
+ *                              B2R2 (coherent, or synched by hwmem)
+ * @stat_n_cache_ipis: Number of maintenance operations done on all CPU:s
+ * @stage_hist: Latency histograms of the request stages
+ * @node_cache: Node lists of recent requests
  * @last_job_lock: Mutex protecting last_job
  * @last_job: The last running job on this b2r2 instance
  * @last_job_chars: Temporary buffer used in printing last_job
@@ -603,6 +703,13 @@ struct b2r2_control {
 	unsigned long                   stat_n_in_query_cap;
 	unsigned long                   stat_n_in_open;
 	unsigned long                   stat_n_in_release;
+	unsigned long                   stat_n_node_cache_hits;
+	unsigned long                   stat_n_node_cache_misses;
+	unsigned long                   stat_n_cache_syncs;
+	unsigned long                   stat_n_cache_syncs_skipped;
+	unsigned long                   stat_n_cache_ipis;
+	struct b2r2_stage_hist          stage_hist[B2R2_NUM_STAGES];
+	struct b2r2_node_cache          node_cache;
 	struct mutex                    last_job_lock;
 	struct b2r2_node                *last_job;
 	char                            *last_job_chars;
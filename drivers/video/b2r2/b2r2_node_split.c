@@ -17,6 +17,8 @@
 #include "b2r2_utils.h"
 
 #include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/kref.h>
 
 /*
  * Macros and constants
@@ -28,10 +30,85 @@
 /* Upscaling needs overlapping of strips */
 #define B2R2_UPSCALE_OVERLAP 8
 
+/* Node lists kept in the node cache and their max length */
+#define B2R2_NODE_CACHE_SIZE 8
+#define B2R2_NODE_CACHE_MAX_NODES 16
+
 /*
  * Internal types
  */
 
+/**
+ * struct b2r2_node_key_img - the parts of an image a node list depends on
+ */
+struct b2r2_node_key_img {
+	enum b2r2_blt_fmt fmt;
+	s32 width;
+	s32 height;
+	u32 pitch;
+};
+
+/**
+ * struct b2r2_node_key - what makes requests get the same node list
+ *
+ * All of the request but the buffers themselves.
+ */
+struct b2r2_node_key {
+	u32 flags;
+	u32 transform;
+	u32 global_alpha;
+	u32 src_color;
+	u32 dst_color;
+	struct b2r2_node_key_img src_img;
+	struct b2r2_node_key_img bg_img;
+	struct b2r2_node_key_img dst_img;
+	struct b2r2_blt_rect src_rect;
+	struct b2r2_blt_rect bg_rect;
+	struct b2r2_blt_rect dst_rect;
+	struct b2r2_blt_rect dst_clip_rect;
+};
+
+/* Buffer an address register points into */
+enum b2r2_node_addr {
+	B2R2_NODE_ADDR_NONE,
+	B2R2_NODE_ADDR_SRC,
+	B2R2_NODE_ADDR_BG,
+	B2R2_NODE_ADDR_DST,
+	B2R2_NODE_ADDR_COUNT,
+};
+
+/**
+ * struct b2r2_node_tmpl_node - a cached node
+ *
+ * @addr: The buffer of the target and the source 1 to 3 base addresses
+ */
+struct b2r2_node_tmpl_node {
+	struct b2r2_link_list node;
+	int src_tmp_index;
+	int dst_tmp_index;
+	int src_index;
+	u8 addr[4];
+};
+
+/**
+ * struct b2r2_node_tmpl - a cached node list
+ *
+ * @list: Item in the node cache
+ * @ref: References, one is held by the node cache
+ * @key: The requests the node list is for
+ * @job: The node split job after the node list was configured
+ * @node_count: Number of nodes
+ * @nodes: The nodes, with the addresses of the buffers in @job
+ */
+struct b2r2_node_tmpl {
+	struct list_head list;
+	struct kref ref;
+	struct b2r2_node_key key;
+	struct b2r2_node_split_job job;
+	u32 node_count;
+	struct b2r2_node_tmpl_node nodes[0];
+};
+
 
 /*
  * Global variables
@@ -3220,12 +3297,264 @@ static void reset_nodes(struct b2r2_node *node)
 	}
 }
 
+static void set_key_img(struct b2r2_node_key_img *key,
+		const struct b2r2_blt_img *img)
+{
+	key->fmt = img->fmt;
+	key->width = img->width;
+	key->height = img->height;
+	key->pitch = img->pitch;
+}
+
+static void set_key(struct b2r2_node_key *key,
+		const struct b2r2_blt_request *req)
+{
+	const struct b2r2_blt_req *ureq = &req->user_req;
+
+	/* Compared with memcmp, padding included */
+	memset(key, 0, sizeof(*key));
+
+	key->flags = ureq->flags;
+	key->transform = ureq->transform;
+	key->global_alpha = ureq->global_alpha;
+	key->src_color = ureq->src_color;
+	key->dst_color = ureq->dst_color;
+	set_key_img(&key->src_img, &ureq->src_img);
+	set_key_img(&key->dst_img, &ureq->dst_img);
+	key->src_rect = ureq->src_rect;
+	key->dst_rect = ureq->dst_rect;
+	key->dst_clip_rect = ureq->dst_clip_rect;
+	if (ureq->flags & B2R2_BLT_FLAG_BG_BLEND) {
+		set_key_img(&key->bg_img, &ureq->bg_img);
+		key->bg_rect = ureq->bg_rect;
+	}
+}
+
+static void free_tmpl(struct kref *ref)
+{
+	kfree(container_of(ref, struct b2r2_node_tmpl, ref));
+}
+
+void b2r2_node_split_put(struct b2r2_node_tmpl *tmpl)
+{
+	kref_put(&tmpl->ref, free_tmpl);
+}
+
+struct b2r2_node_tmpl *b2r2_node_split_lookup(struct b2r2_control *cont,
+		const struct b2r2_blt_request *req, u32 *node_count)
+{
+	struct b2r2_node_cache *cache = &cont->node_cache;
+	struct b2r2_node_tmpl *tmpl;
+	struct b2r2_node_key key;
+
+	if (req->user_req.flags & B2R2_BLT_FLAG_CLUT_COLOR_CORRECTION)
+		return NULL;
+
+	set_key(&key, req);
+
+	mutex_lock(&cache->lock);
+	list_for_each_entry(tmpl, &cache->list, list) {
+		if (memcmp(&tmpl->key, &key, sizeof(key)) == 0) {
+			list_move(&tmpl->list, &cache->list);
+			kref_get(&tmpl->ref);
+			mutex_unlock(&cache->lock);
+
+			*node_count = tmpl->node_count;
+			return tmpl;
+		}
+	}
+	mutex_unlock(&cache->lock);
+
+	return NULL;
+}
+
+static void rebase_buf(struct b2r2_node_split_buf *buf, u32 delta)
+{
+	if (buf->addr)
+		buf->addr += delta;
+	if (buf->chroma_addr)
+		buf->chroma_addr += delta;
+	if (buf->chroma_cr_addr)
+		buf->chroma_cr_addr += delta;
+}
+
+void b2r2_node_split_reuse(struct b2r2_control *cont,
+		struct b2r2_node_tmpl *tmpl, struct b2r2_blt_request *req,
+		struct b2r2_node *first)
+{
+	struct b2r2_node_split_job *this = &req->node_split_job;
+	struct b2r2_node *node = first;
+	u32 delta[B2R2_NODE_ADDR_COUNT];
+	u32 i;
+
+	b2r2_log_info(cont->dev, "%s\n", __func__);
+
+	/* Buffers are at the offset from their address they were before */
+	delta[B2R2_NODE_ADDR_NONE] = 0;
+	delta[B2R2_NODE_ADDR_SRC] = req->src_resolved.physical_address -
+			tmpl->job.src.addr;
+	delta[B2R2_NODE_ADDR_BG] = req->bg_resolved.physical_address -
+			tmpl->job.bg.addr;
+	delta[B2R2_NODE_ADDR_DST] = req->dst_resolved.physical_address -
+			tmpl->job.dst.addr;
+
+	memcpy(this, &tmpl->job, sizeof(*this));
+	rebase_buf(&this->src, delta[B2R2_NODE_ADDR_SRC]);
+	rebase_buf(&this->bg, delta[B2R2_NODE_ADDR_BG]);
+	rebase_buf(&this->dst, delta[B2R2_NODE_ADDR_DST]);
+
+	req->bufs = this->work_bufs;
+	req->buf_count = this->buf_count;
+
+	for (i = 0; i < tmpl->node_count && node != NULL; i++) {
+		struct b2r2_node_tmpl_node *t = &tmpl->nodes[i];
+
+		node->node = t->node;
+		node->src_tmp_index = t->src_tmp_index;
+		node->dst_tmp_index = t->dst_tmp_index;
+		node->src_index = t->src_index;
+
+		node->node.GROUP1.B2R2_TBA += delta[t->addr[0]];
+		node->node.GROUP3.B2R2_SBA += delta[t->addr[1]];
+		node->node.GROUP4.B2R2_SBA += delta[t->addr[2]];
+		node->node.GROUP5.B2R2_SBA += delta[t->addr[3]];
+
+		node->node.GROUP0.B2R2_NIP = node->next != NULL ?
+				node->next->physical_address : 0;
+		node = node->next;
+	}
+
+	b2r2_node_split_put(tmpl);
+}
+
+/**
+ * addr_of() - gives the buffer the address in a register points into
+ *
+ * Returns the buffer, or -1 for an address that is not from one of them.
+ */
+static int addr_of(const struct b2r2_node_split_job *this, u32 addr)
+{
+	const struct b2r2_node_split_buf *bufs[B2R2_NODE_ADDR_COUNT] = {
+		[B2R2_NODE_ADDR_SRC] = &this->src,
+		[B2R2_NODE_ADDR_BG] = &this->bg,
+		[B2R2_NODE_ADDR_DST] = &this->dst,
+	};
+	int found = B2R2_NODE_ADDR_NONE;
+	int i;
+
+	/* Intermediate buffers are assigned later */
+	if (addr == 0)
+		return B2R2_NODE_ADDR_NONE;
+
+	for (i = B2R2_NODE_ADDR_SRC; i < B2R2_NODE_ADDR_COUNT; i++) {
+		if (addr != bufs[i]->addr && addr != bufs[i]->chroma_addr &&
+				addr != bufs[i]->chroma_cr_addr)
+			continue;
+
+		/* Several buffers on the same address can't be told apart */
+		if (found != B2R2_NODE_ADDR_NONE)
+			return -1;
+		found = i;
+	}
+
+	return found != B2R2_NODE_ADDR_NONE ? found : -1;
+}
+
+void b2r2_node_split_store(struct b2r2_control *cont,
+		const struct b2r2_blt_request *req, struct b2r2_node *first)
+{
+	struct b2r2_node_cache *cache = &cont->node_cache;
+	const struct b2r2_node_split_job *this = &req->node_split_job;
+	struct b2r2_node_tmpl *tmpl;
+	struct b2r2_node_tmpl *pos;
+	struct b2r2_node *node;
+	u32 node_count = 0;
+	u32 i;
+
+	if (req->user_req.flags & B2R2_BLT_FLAG_CLUT_COLOR_CORRECTION)
+		return;
+
+	for (node = first; node != NULL; node = node->next)
+		node_count++;
+	if (node_count == 0 || node_count > B2R2_NODE_CACHE_MAX_NODES)
+		return;
+
+	tmpl = kmalloc(sizeof(*tmpl) + node_count * sizeof(tmpl->nodes[0]),
+			GFP_KERNEL);
+	if (tmpl == NULL)
+		return;
+
+	for (i = 0, node = first; node != NULL; i++, node = node->next) {
+		struct b2r2_node_tmpl_node *t = &tmpl->nodes[i];
+		int addr[4];
+		int j;
+
+		addr[0] = addr_of(this, node->node.GROUP1.B2R2_TBA);
+		addr[1] = addr_of(this, node->node.GROUP3.B2R2_SBA);
+		addr[2] = addr_of(this, node->node.GROUP4.B2R2_SBA);
+		addr[3] = addr_of(this, node->node.GROUP5.B2R2_SBA);
+		for (j = 0; j < 4; j++) {
+			if (addr[j] < 0)
+				goto not_cached;
+			t->addr[j] = addr[j];
+		}
+
+		t->node = node->node;
+		t->src_tmp_index = node->src_tmp_index;
+		t->dst_tmp_index = node->dst_tmp_index;
+		t->src_index = node->src_index;
+	}
+
+	kref_init(&tmpl->ref);
+	set_key(&tmpl->key, req);
+	memcpy(&tmpl->job, this, sizeof(tmpl->job));
+	tmpl->node_count = node_count;
+
+	mutex_lock(&cache->lock);
+	list_for_each_entry(pos, &cache->list, list) {
+		/* Stored meanwhile */
+		if (memcmp(&pos->key, &tmpl->key, sizeof(tmpl->key)) == 0) {
+			mutex_unlock(&cache->lock);
+			goto not_cached;
+		}
+	}
+
+	if (cache->count == B2R2_NODE_CACHE_SIZE) {
+		pos = list_entry(cache->list.prev, struct b2r2_node_tmpl, list);
+		list_del(&pos->list);
+		b2r2_node_split_put(pos);
+		cache->count--;
+	}
+	list_add(&tmpl->list, &cache->list);
+	cache->count++;
+	mutex_unlock(&cache->lock);
+
+	return;
+
+not_cached:
+	kfree(tmpl);
+}
+
 int b2r2_node_split_init(struct b2r2_control *cont)
 {
+	mutex_init(&cont->node_cache.lock);
+	INIT_LIST_HEAD(&cont->node_cache.list);
+	cont->node_cache.count = 0;
+
 	return 0;
 }
 
 void b2r2_node_split_exit(struct b2r2_control *cont)
 {
+	struct b2r2_node_cache *cache = &cont->node_cache;
+	struct b2r2_node_tmpl *tmpl;
+	struct b2r2_node_tmpl *tmp;
 
+	mutex_lock(&cache->lock);
+	list_for_each_entry_safe(tmpl, tmp, &cache->list, list) {
+		list_del(&tmpl->list);
+		b2r2_node_split_put(tmpl);
+	}
+	cache->count = 0;
+	mutex_unlock(&cache->lock);
 }
@@ -107,6 +107,56 @@ void b2r2_node_split_unassign_buffers(struct b2r2_control *cont,
 void b2r2_node_split_cancel(struct b2r2_control *cont,
 		struct b2r2_node_split_job *job);
 
+struct b2r2_node_tmpl;
+
+/**
+ * b2r2_node_split_lookup() - Looks for a cached node list for a request
+ *
+ * @req        - The request, with its buffers resolved
+ * @node_count - Number of nodes required for the job
+ *
+ * A node list is cached for requests equal to an earlier one in all but the
+ * buffer addresses. On a hit, b2r2_node_split_reuse() replaces the calls to
+ * b2r2_node_split_analyze() and b2r2_node_split_configure().
+ *
+ * Returns:
+ *   A reference to the cached node list, NULL if there is none.
+ */
+struct b2r2_node_tmpl *b2r2_node_split_lookup(struct b2r2_control *cont,
+		const struct b2r2_blt_request *req, u32 *node_count);
+
+/**
+ * b2r2_node_split_reuse() - Fills a node list from a cached one
+ *
+ * @tmpl  - The cached node list, its reference is dropped
+ * @req   - The request
+ * @first - The first node in the list of nodes to use
+ *
+ * Sets up the node split job, the intermediate buffers and the nodes of the
+ * request as b2r2_node_split_analyze() and b2r2_node_split_configure() would,
+ * with the buffer addresses of the request.
+ */
+void b2r2_node_split_reuse(struct b2r2_control *cont,
+		struct b2r2_node_tmpl *tmpl, struct b2r2_blt_request *req,
+		struct b2r2_node *first);
+
+/**
+ * b2r2_node_split_put() - Drops a reference to a cached node list
+ */
+void b2r2_node_split_put(struct b2r2_node_tmpl *tmpl);
+
+/**
+ * b2r2_node_split_store() - Caches the node list of a request
+ *
+ * @req   - The request, with its node list configured
+ * @first - The first node in the node list
+ *
+ * Node lists that are long, use a color look-up table or can not be told
+ * apart from the buffer addresses they use are not cached.
+ */
+void b2r2_node_split_store(struct b2r2_control *cont,
+		const struct b2r2_blt_request *req, struct b2r2_node *first);
+
 /**
  * b2r2_node_split_init() - Initializes the node split module
  *
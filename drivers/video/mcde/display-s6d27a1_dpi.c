@@ -129,6 +129,7 @@ struct s6d27a1_dpi {
 
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	struct early_suspend			earlysuspend;
+	struct work_struct			resume_work;
 #endif
 };
 
@@ -1281,6 +1282,7 @@ static void s6d27a1_dpi_mcde_early_suspend(
 			struct early_suspend *earlysuspend);
 static void s6d27a1_dpi_mcde_late_resume(
 			struct early_suspend *earlysuspend);
+static void s6d27a1_dpi_resume_work(struct work_struct *work);
 #endif
 
 #ifdef ESD_OPERATION
@@ -1504,6 +1506,7 @@ ret = device_create_file(&(ddev->dev), &dev_attr_mcde_chnl);
 	}
 
 #ifdef CONFIG_HAS_EARLYSUSPEND
+	INIT_WORK(&lcd->resume_work, s6d27a1_dpi_resume_work);
 	lcd->earlysuspend.level   = EARLY_SUSPEND_LEVEL_DISABLE_FB - 1;
 	lcd->earlysuspend.suspend = s6d27a1_dpi_mcde_early_suspend;
 	lcd->earlysuspend.resume  = s6d27a1_dpi_mcde_late_resume;
@@ -1537,6 +1540,9 @@ static int __devexit s6d27a1_dpi_mcde_remove(
 	struct s6d27a1_dpi *lcd = dev_get_drvdata(&ddev->dev);
 
 	dev_dbg(&ddev->dev, "Invoked %s\n", __func__);
+#ifdef CONFIG_HAS_EARLYSUSPEND
+	flush_work(&lcd->resume_work);
+#endif
 	s6d27a1_dpi_power(lcd, FB_BLANK_POWERDOWN);
 
 	if (lcd->pd->bl_ctrl)
@@ -1553,6 +1559,9 @@ static void s6d27a1_dpi_mcde_shutdown(struct mcde_display_device *ddev)
 	struct s6d27a1_dpi *lcd = dev_get_drvdata(&ddev->dev);
 
 	dev_dbg(&ddev->dev, "Invoked %s\n", __func__);
+#ifdef CONFIG_HAS_EARLYSUSPEND
+	flush_work(&lcd->resume_work);
+#endif
 	mutex_lock(&ddev->display_lock);
 	s6d27a1_dpi_power(lcd, FB_BLANK_POWERDOWN);
 #ifdef CONFIG_HAS_EARLYSUSPEND
@@ -1629,7 +1638,9 @@ static void s6d27a1_dpi_mcde_early_suspend(
 						struct s6d27a1_dpi,
 						earlysuspend);
 	pm_message_t dummy;
-	
+
+	flush_work(&lcd->resume_work);
+
 	#ifdef CONFIG_DB8500_LIVEOPP
 	schedule_work(&requirements_remove_work);
 	#endif
@@ -1649,8 +1660,22 @@ static void s6d27a1_dpi_mcde_late_resume(
 	schedule_work(&requirements_add_work);
 	#endif
 
-	s6d27a1_dpi_mcde_resume(lcd->mdd);
+	/*
+	 * Most of the panel power on is spent in fixed delays, let the
+	 * handlers after this one resume meanwhile. Display updates wait for
+	 * the power on to be done.
+	 */
+	INIT_COMPLETION(lcd->mdd->power_on_done);
+	schedule_work(&lcd->resume_work);
+}
 
+static void s6d27a1_dpi_resume_work(struct work_struct *work)
+{
+	struct s6d27a1_dpi *lcd = container_of(work, struct s6d27a1_dpi,
+						resume_work);
+
+	s6d27a1_dpi_mcde_resume(lcd->mdd);
+	complete_all(&lcd->mdd->power_on_done);
 }
 #endif
 
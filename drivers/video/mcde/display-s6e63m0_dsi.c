@@ -222,77 +222,84 @@ static int s6e63m0_dsi_dcs_write_sequence(struct mcde_display_device *ddev,
 
 /* used to write DSI/DCS commands when video stream active */
 #define MAX_DCS_CMD_ALLOWED	(DSILINK_MAX_DSI_DIRECT_CMD_WRITE - 1)
-static int s6e63m0_write_dcs_vid_cmd(struct mcde_display_device *ddev, u8 cmd, u8* p_data, int len)
+/*
+ * Adds cmd to the batch, longer parameter lists being split in chunks
+ * preceded by their GLOBAL_PARAM offset. Nothing is added on error.
+ */
+static int s6e63m0_batch_dcs_vid_cmd(struct mcde_dsi_batch *batch, u8 cmd,
+							const u8 *data, int len)
 {
-	int retries = 1;
-	int len_to_write;
-	u8 *data;
-	int write_len;
-	int ret = 0;
-	u8 globalPara = MAX_DCS_CMD_ALLOWED;
-
-	do {
-		len_to_write = len;
-		data = p_data;
-		write_len = len_to_write;
-		if (write_len > MAX_DCS_CMD_ALLOWED)
-			write_len = MAX_DCS_CMD_ALLOWED;
-
-		ret = mcde_dsi_dcs_write(ddev->chnl_state, cmd, data, write_len);
-		dev_vdbg(&ddev->dev, "Send DCS cmd %x, len %d, ret=%d\n",
-			cmd, write_len, ret);
-
-		len_to_write -= write_len;
-		data += write_len;
+	int mark = batch->len;
+	int write_len = min_t(int, len, MAX_DCS_CMD_ALLOWED);
+	u8 globalPara;
+	int ret;
 
-		while ((len_to_write > 0) && (ret == 0)) {
+	ret = mcde_dsi_batch_dcs(batch, cmd, data, write_len);
+	for (globalPara = write_len; !ret && globalPara < len;
+						globalPara += write_len) {
+		write_len = min_t(int, len - globalPara, MAX_DCS_CMD_ALLOWED);
+		ret = mcde_dsi_batch_dcs(batch, DCS_CMD_GLOBAL_PARAM,
+							&globalPara, 1);
+		if (!ret)
+			ret = mcde_dsi_batch_dcs(batch, cmd, data + globalPara,
+								write_len);
+	}
+	if (ret)
+		batch->len = mark;
 
-			write_len = len_to_write;
-			if (write_len > MAX_DCS_CMD_ALLOWED)
-				write_len = MAX_DCS_CMD_ALLOWED;
+	return ret;
+}
 
-			ret = mcde_dsi_dcs_write(ddev->chnl_state,
-						DCS_CMD_GLOBAL_PARAM,
-						&globalPara, 1);
-			dev_vdbg(&ddev->dev, "Send DCS GLOBAL_PARAM, data %d, ret=%d\n",
-				globalPara, ret);
-			ret = mcde_dsi_dcs_write(ddev->chnl_state, cmd, data, write_len);
-			dev_vdbg(&ddev->dev, "Send DCS cmd %x, len %d, ret=%d\n",
-				cmd, write_len, ret);
+static int s6e63m0_batch_flush(struct mcde_display_device *ddev,
+						struct mcde_dsi_batch *batch)
+{
+	int ret = mcde_dsi_write_batch(ddev->chnl_state, batch);
 
-			len_to_write-= write_len;
-			data += write_len;
-			globalPara += write_len;
-		}
-		if (ret)
-			usleep_range(8000,8000);
-	}while (ret && --retries);
-	if (ret) {
-		dev_warn(&ddev->dev, "Failed to send DCS cmd %x, error %d\n",
-			cmd, ret);
-	}
+	if (ret)
+		dev_warn(&ddev->dev, "Failed to send DCS cmds, error %d\n", ret);
 	return ret;
 }
 
-static int s6e63m0_write_dcs_vid_seq(struct mcde_display_device *ddev,
-							const u8 *p_seq)
+/* Sends what the batch holds first where it is full or a delay is needed */
+static int s6e63m0_batch_dcs_vid_seq(struct mcde_display_device *ddev,
+				struct mcde_dsi_batch *batch, const u8 *p_seq)
 {
 	int ret = 0;
 
 	while ((p_seq[0] != DCS_CMD_SEQ_END) && !ret) {
 		if (p_seq[0] == DCS_CMD_SEQ_DELAY_MS) {
+			ret = s6e63m0_batch_flush(ddev, batch);
 			msleep(p_seq[1]);
 			p_seq += 2;
-		} else {
-			ret = s6e63m0_write_dcs_vid_cmd(ddev, p_seq[1],
-				(u8 *)&p_seq[2], p_seq[0] - 1);
-			p_seq += p_seq[0] + 1;
+			continue;
 		}
+
+		ret = s6e63m0_batch_dcs_vid_cmd(batch, p_seq[1], &p_seq[2],
+								p_seq[0] - 1);
+		if (ret == -ENOSPC && batch->len) {
+			ret = s6e63m0_batch_flush(ddev, batch);
+			continue;
+		}
+		p_seq += p_seq[0] + 1;
 	}
 
 	return ret;
 }
 
+static int s6e63m0_write_dcs_vid_seq(struct mcde_display_device *ddev,
+							const u8 *p_seq)
+{
+	struct mcde_dsi_batch batch;
+	int ret;
+
+	mcde_dsi_batch_init(&batch);
+	ret = s6e63m0_batch_dcs_vid_seq(ddev, &batch, p_seq);
+	if (ret == 0)
+		ret = s6e63m0_batch_flush(ddev, &batch);
+
+	return ret;
+}
+
 static int s6e63m0_dsi_read_panel_id(struct s6e63m0_dsi_lcd *lcd)
 {
 	int readret = 0;
@@ -432,24 +439,27 @@ static int get_gamma_value_from_bl(int brightness)
 
 }
 
-static int s6e63m0_set_gamma(struct s6e63m0_dsi_lcd *lcd)
+static int s6e63m0_set_gamma(struct s6e63m0_dsi_lcd *lcd,
+						struct mcde_dsi_batch *batch)
 {
 	int ret = 0;
 	int i=0;
 	struct mcde_display_device *ddev = lcd->ddev;
 	
-	ret = s6e63m0_write_dcs_vid_seq(ddev, lcd->gamma_seq[lcd->bl]);
+	ret = s6e63m0_batch_dcs_vid_seq(ddev, batch, lcd->gamma_seq[lcd->bl]);
 #if 0
 	for (i=3; i<24 ; i++)
 	printk("gamma_seq[%d][%x]...current_gamma=[%d]\n",i,lcd->gamma_seq[lcd->bl][i],lcd->current_gamma);
 #endif
 	if (ret == 0)
-		ret = s6e63m0_write_dcs_vid_seq(ddev, DCS_CMD_SEQ_GAMMA_SET_UPDATE);
+		ret = s6e63m0_batch_dcs_vid_seq(ddev, batch,
+						DCS_CMD_SEQ_GAMMA_SET_UPDATE);
 	
 	return ret;
 }
 
-static int s6e63m0_set_acl(struct s6e63m0_dsi_lcd *lcd)
+static int s6e63m0_set_acl(struct s6e63m0_dsi_lcd *lcd,
+						struct mcde_dsi_batch *batch)
 {
 	int ret = 0;
 	struct mcde_display_device *ddev = lcd->ddev;
@@ -470,14 +480,14 @@ static int s6e63m0_set_acl(struct s6e63m0_dsi_lcd *lcd)
 		switch (lcd->bl) {
 		case 0 ... 2: /* 30cd ~ 60cd */
 			if (lcd->cur_acl != 0) {
-				ret = s6e63m0_write_dcs_vid_seq(ddev, SEQ_ACL_NULL_DSI);
+				ret = s6e63m0_batch_dcs_vid_seq(ddev, batch, SEQ_ACL_NULL_DSI);
 				dev_dbg(lcd->dev, "ACL_cutoff_set Percentage : off!!\n");
 				lcd->cur_acl = 0;
 			}
 			break;
 		case 3 ... 24: /* 70cd ~ 250 */
 			if (lcd->cur_acl != 40) {
-				ret |= s6e63m0_write_dcs_vid_seq(ddev, SEQ_ACL_40P_DSI);
+				ret |= s6e63m0_batch_dcs_vid_seq(ddev, batch, SEQ_ACL_40P_DSI);
 				dev_dbg(lcd->dev, "ACL_cutoff_set Percentage : 40!!\n");
 				lcd->cur_acl = 40;
 			}
@@ -485,7 +495,7 @@ static int s6e63m0_set_acl(struct s6e63m0_dsi_lcd *lcd)
 			
 		default:
 			if (lcd->cur_acl != 40) {
-				ret |= s6e63m0_write_dcs_vid_seq(ddev, SEQ_ACL_40P_DSI);
+				ret |= s6e63m0_batch_dcs_vid_seq(ddev, batch, SEQ_ACL_40P_DSI);
 				dev_dbg(lcd->dev, "ACL_cutoff_set Percentage : 40!!\n");
 				lcd->cur_acl = 40;
 			}
@@ -493,7 +503,7 @@ static int s6e63m0_set_acl(struct s6e63m0_dsi_lcd *lcd)
 			break;
 		}
 	} else {
-			ret = s6e63m0_write_dcs_vid_seq(ddev, SEQ_ACL_NULL_DSI);
+			ret = s6e63m0_batch_dcs_vid_seq(ddev, batch, SEQ_ACL_NULL_DSI);
 			lcd->cur_acl = 0;
 			dev_dbg(lcd->dev, "ACL_cutoff_set Percentage : off!!\n");
 	}
@@ -506,7 +516,8 @@ static int s6e63m0_set_acl(struct s6e63m0_dsi_lcd *lcd)
 	return ret;
 	}
 
-static int s6e63m0_set_elvss(struct s6e63m0_dsi_lcd *lcd)
+static int s6e63m0_set_elvss(struct s6e63m0_dsi_lcd *lcd,
+						struct mcde_dsi_batch *batch)
 {
 	u8 elvss_val;
 	int gamma_index;
@@ -542,7 +553,8 @@ static int s6e63m0_set_elvss(struct s6e63m0_dsi_lcd *lcd)
 
 				DCS_CMD_SEQ_ELVSS_SET[gamma_index] = elvss_val;
 
-			ret = s6e63m0_write_dcs_vid_seq(ddev, DCS_CMD_SEQ_ELVSS_SET);
+			ret = s6e63m0_batch_dcs_vid_seq(ddev, batch,
+							DCS_CMD_SEQ_ELVSS_SET);
 		}
 	return ret;
 }
@@ -550,6 +562,7 @@ static int s6e63m0_dsi_update_brightness(struct mcde_display_device *ddev,
 						int brightness)
 {
 	struct s6e63m0_dsi_lcd *lcd = dev_get_drvdata(&ddev->dev);
+	struct mcde_dsi_batch batch;
 	int ret = 0;
 	int gamma = 0;
 	int i =0;
@@ -569,9 +582,12 @@ static int s6e63m0_dsi_update_brightness(struct mcde_display_device *ddev,
 		
 		lcd->current_gamma = gamma;
 		
-		s6e63m0_set_gamma(lcd);
-		s6e63m0_set_acl(lcd);
-		s6e63m0_set_elvss(lcd);
+		/* All of it goes to the panel in one go */
+		mcde_dsi_batch_init(&batch);
+		s6e63m0_set_gamma(lcd, &batch);
+		s6e63m0_set_acl(lcd, &batch);
+		s6e63m0_set_elvss(lcd, &batch);
+		ret = s6e63m0_batch_flush(ddev, &batch);
 
 		dev_dbg(&ddev->dev, "Update Brightness: gamma=%d\n", gamma);
 	}
@@ -1462,8 +1478,13 @@ device_attribute *attr, const char *buf, size_t size)
 		if (lcd->acl_enable != value) {
 			mutex_lock(&lcd->lock);
 			lcd->acl_enable = value;
-			if (lcd->panel_awake)
-				s6e63m0_set_acl(lcd);
+			if (lcd->panel_awake) {
+				struct mcde_dsi_batch batch;
+
+				mcde_dsi_batch_init(&batch);
+				s6e63m0_set_acl(lcd, &batch);
+				s6e63m0_batch_flush(lcd->ddev, &batch);
+			}
 			mutex_unlock(&lcd->lock);			
 		}
 		return size;
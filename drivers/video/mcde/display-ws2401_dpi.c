@@ -128,6 +128,7 @@ struct ws2401_dpi {
 
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	struct early_suspend			earlysuspend;
+	struct work_struct			resume_work;
 #endif
 };
 
@@ -1249,6 +1250,7 @@ static void ws2401_dpi_mcde_early_suspend(
 			struct early_suspend *earlysuspend);
 static void ws2401_dpi_mcde_late_resume(
 			struct early_suspend *earlysuspend);
+static void ws2401_dpi_resume_work(struct work_struct *work);
 #endif
 
 #ifdef ESD_OPERATION
@@ -1462,6 +1464,7 @@ static int __devinit ws2401_dpi_mcde_probe(
 	}
 
 #ifdef CONFIG_HAS_EARLYSUSPEND
+	INIT_WORK(&lcd->resume_work, ws2401_dpi_resume_work);
 	lcd->earlysuspend.level   = EARLY_SUSPEND_LEVEL_DISABLE_FB - 1;
 	lcd->earlysuspend.suspend = ws2401_dpi_mcde_early_suspend;
 	lcd->earlysuspend.resume  = ws2401_dpi_mcde_late_resume;
@@ -1496,6 +1499,9 @@ static int __devexit ws2401_dpi_mcde_remove(
 	struct ws2401_dpi *lcd = dev_get_drvdata(&ddev->dev);
 
 	dev_dbg(&ddev->dev, "Invoked %s\n", __func__);
+#ifdef CONFIG_HAS_EARLYSUSPEND
+	flush_work(&lcd->resume_work);
+#endif
 	ws2401_dpi_power(lcd, FB_BLANK_POWERDOWN);
 
 	if (lcd->pd->bl_ctrl)
@@ -1512,6 +1518,9 @@ static void ws2401_dpi_mcde_shutdown(struct mcde_display_device *ddev)
 	struct ws2401_dpi *lcd = dev_get_drvdata(&ddev->dev);
 
 	dev_dbg(&ddev->dev, "Invoked %s\n", __func__);
+#ifdef CONFIG_HAS_EARLYSUSPEND
+	flush_work(&lcd->resume_work);
+#endif
 
 	#ifdef ESD_OPERATION
 	if (lcd->esd_enable) {
@@ -1599,6 +1608,8 @@ static void ws2401_dpi_mcde_early_suspend(
 						earlysuspend);
 	pm_message_t dummy;
 
+	flush_work(&lcd->resume_work);
+
 	#ifdef ESD_OPERATION
 	if (lcd->esd_enable) {
 
@@ -1622,20 +1633,16 @@ static void ws2401_dpi_mcde_early_suspend(
 
 }
 
-static void ws2401_dpi_mcde_late_resume(
-		struct early_suspend *earlysuspend)
+static void ws2401_dpi_resume_work(struct work_struct *work)
 {
-	struct ws2401_dpi *lcd = container_of(earlysuspend,
-						struct ws2401_dpi,
-						earlysuspend);
+	struct ws2401_dpi *lcd = container_of(work, struct ws2401_dpi,
+						resume_work);
 
 	#ifdef ESD_OPERATION
 	if (lcd->lcd_connected)
 		enable_irq(GPIO_TO_IRQ(lcd->esd_port));
 	#endif
 
-	schedule_work(&requirements_add_work);
-
 	ws2401_dpi_mcde_resume(lcd->mdd);
 
 	#ifdef ESD_OPERATION
@@ -1647,6 +1654,26 @@ static void ws2401_dpi_mcde_late_resume(
 	} else
 		pr_info("%s lcd_connected : %d", __func__, lcd->lcd_connected);
 	#endif
+
+	complete_all(&lcd->mdd->power_on_done);
+}
+
+static void ws2401_dpi_mcde_late_resume(
+		struct early_suspend *earlysuspend)
+{
+	struct ws2401_dpi *lcd = container_of(earlysuspend,
+						struct ws2401_dpi,
+						earlysuspend);
+
+	schedule_work(&requirements_add_work);
+
+	/*
+	 * Most of the panel power on is spent in fixed delays, let the
+	 * handlers after this one resume meanwhile. Display updates wait for
+	 * the power on to be done.
+	 */
+	INIT_COMPLETION(lcd->mdd->power_on_done);
+	schedule_work(&lcd->resume_work);
 }
 #endif
 
@@ -284,6 +284,33 @@ int nova_dsilink_dsi_write(struct dsilink_device *dsilink, u8 *data, int len)
 								-1, data, len);
 }
 
+/* Sends the packets of buf one after the other, stopping at the first error */
+int nova_dsilink_write_batch(struct dsilink_device *dsilink, const u8 *buf,
+								int len)
+{
+	int ret = 0;
+
+	if (!dsilink->enabled || !dsilink->reserved)
+		return -EINVAL;
+
+	DSILINK_TRACE(dsilink->dev);
+
+	while (len >= DSILINK_BATCH_HDR && !ret) {
+		u8 *data = (u8 *)buf + DSILINK_BATCH_HDR;
+		int n = buf[2];
+
+		if (buf[0] == DSILINK_CMD_DCS_WRITE)
+			dsilink_debugfs_print_cmd(buf[1], data, n, "WRITE");
+
+		ret = dsilink->ops.write(dsilink->io, dsilink->dev, buf[0],
+							buf[1], data, n);
+		buf += DSILINK_BATCH_HDR + n;
+		len -= DSILINK_BATCH_HDR + n;
+	}
+
+	return ret;
+}
+
 int nova_dsilink_dsi_read(struct dsilink_device *dsilink,
 						u8 cmd, u32 *data, int *len)
 {
@@ -417,4 +417,6 @@ void mcde_display_init_device(struct mcde_display_device *ddev)
 
 	mutex_init(&ddev->display_lock);
 	mutex_init(&ddev->vsync_lock);
+	init_completion(&ddev->power_on_done);
+	complete_all(&ddev->power_on_done);
 }
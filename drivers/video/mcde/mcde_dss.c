@@ -268,6 +268,10 @@ static int dss_update_channel_locked(struct mcde_display_device *ddev,
 					bool tripple_buffer)
 {
 	int ret;
+
+	/* Scanout waits for a panel power on started by the display driver */
+	wait_for_completion(&ddev->power_on_done);
+
 	/* Do not perform an update if power mode is off */
 	if (ddev->get_power_mode(ddev) == MCDE_DISPLAY_PM_OFF) {
 		ret = 0;
@@ -299,6 +303,51 @@ int mcde_dss_update_overlay(struct mcde_overlay *ovly, bool tripple_buffer)
 }
 EXPORT_SYMBOL(mcde_dss_update_overlay);
 
+/* Non-blocking buffer change of a running video mode display */
+int mcde_dss_queue_flip(struct mcde_overlay *ovly, u32 paddr,
+	void (*done)(void *data), void *data)
+{
+	int ret;
+
+	if (!ovly->state)
+		return -EAGAIN;
+
+	mutex_lock(&ovly->ddev->display_lock);
+	ret = mcde_ovly_queue_flip(ovly->state, paddr, done, data);
+	if (!ret)
+		ovly->info.paddr = paddr;
+	mutex_unlock(&ovly->ddev->display_lock);
+	return ret;
+}
+EXPORT_SYMBOL(mcde_dss_queue_flip);
+
+int mcde_dss_set_update_area(struct mcde_display_device *ddev,
+	u16 x, u16 y, u16 w, u16 h)
+{
+	int ret;
+
+	if (!ddev->chnl_state)
+		return -EINVAL;
+
+	mutex_lock(&ddev->display_lock);
+	ret = mcde_chnl_set_update_area(ddev->chnl_state, x, y, w, h);
+	mutex_unlock(&ddev->display_lock);
+	return ret;
+}
+EXPORT_SYMBOL(mcde_dss_set_update_area);
+
+int mcde_dss_set_frame_id(struct mcde_display_device *ddev, u32 frame)
+{
+	if (!ddev->chnl_state)
+		return -EINVAL;
+
+	mutex_lock(&ddev->display_lock);
+	mcde_chnl_set_frame_id(ddev->chnl_state, frame);
+	mutex_unlock(&ddev->display_lock);
+	return 0;
+}
+EXPORT_SYMBOL(mcde_dss_set_frame_id);
+
 void mcde_dss_get_overlay_info(struct mcde_overlay *ovly,
 				struct mcde_overlay_info *info) {
 	if (info)
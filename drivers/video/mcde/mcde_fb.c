@@ -630,6 +630,99 @@ mcde_fb_blank_end:
 	return ret;
 }
 
+#ifdef CONFIG_SW_SYNC
+static void mcde_fb_flip_done(void *data)
+{
+	struct mcde_fb *mfb = data;
+
+	sw_sync_timeline_inc(mfb->timeline, 1);
+}
+
+/*
+ * When triple buffered, a buffer change alone is queued for the next frame
+ * and the release of the buffer it replaces advances the timeline. Anything
+ * else is applied in full, waiting for it.
+ */
+static int flip_display(struct fb_info *fbi, struct fb_var_screeninfo *var)
+{
+	struct mcde_fb *mfb = to_mcde_fb(fbi);
+	struct mcde_overlay_info info;
+	int ret;
+
+	if (!mfb->timeline)
+		return apply_var(fbi, fb_to_display(fbi));
+
+	mfb->flip_seq++;
+	if (mfb->num_ovlys == 1 && var->yres_virtual / var->yres == 3) {
+		get_ovly_info(fbi, mfb->ovlys[0], &info);
+		if (!mcde_dss_queue_flip(mfb->ovlys[0], info.paddr,
+						mcde_fb_flip_done, mfb))
+			return 0;
+	}
+
+	ret = apply_var(fbi, fb_to_display(fbi));
+	sw_sync_timeline_inc(mfb->timeline, 1);
+	return ret;
+}
+
+static int pan_display_fence(struct fb_info *fbi,
+	struct mcde_fb_flip __user *uflip)
+{
+	struct mcde_fb *mfb = to_mcde_fb(fbi);
+	struct fb_var_screeninfo var = fbi->var;
+	struct mcde_fb_flip flip;
+	struct sync_fence *fence = NULL;
+	struct sync_pt *pt;
+	int fd = -1;
+	int ret;
+
+	if (copy_from_user(&flip, uflip, sizeof(flip)))
+		return -EFAULT;
+
+	var.yoffset = flip.yoffset;
+	ret = fb_pan_display(fbi, &var);
+	if (ret)
+		return ret;
+
+	if (mfb->timeline) {
+		fd = get_unused_fd();
+		if (fd < 0)
+			return fd;
+
+		pt = sw_sync_pt_create(mfb->timeline, mfb->flip_seq);
+		if (pt == NULL)
+			goto pt_failed;
+
+		fence = sync_fence_create("mcde_fb", pt);
+		if (fence == NULL)
+			goto fence_failed;
+	}
+
+	if (put_user(fd, &uflip->release_fence)) {
+		if (fence != NULL) {
+			put_unused_fd(fd);
+			sync_fence_put(fence);
+		}
+		return -EFAULT;
+	}
+
+	if (fence != NULL)
+		sync_fence_install(fence, fd);
+	return 0;
+
+fence_failed:
+	sync_pt_free(pt);
+pt_failed:
+	put_unused_fd(fd);
+	return -ENOMEM;
+}
+#else
+static int flip_display(struct fb_info *fbi, struct fb_var_screeninfo *var)
+{
+	return apply_var(fbi, fb_to_display(fbi));
+}
+#endif
+
 static int mcde_fb_pan_display(struct fb_var_screeninfo *var,
 	struct fb_info *fbi)
 {
@@ -657,7 +750,7 @@ static int mcde_fb_pan_display(struct fb_var_screeninfo *var,
 	} else {
 		fbi->var.xoffset = var->xoffset;
 		fbi->var.yoffset = var->yoffset;
-		ret = apply_var(fbi, fb_to_display(fbi));
+		ret = flip_display(fbi, var);
 	}
 
 	return ret;
@@ -707,6 +800,28 @@ static int mcde_fb_ioctl(struct fb_info *fbi, unsigned int cmd,
 		fbi->var = var;
 		return 0;
 	}
+
+	if (cmd == MCDE_SET_UPDATE_AREA_IOC) {
+		struct mcde_fb_update_area area;
+		struct mcde_display_device *ddev = fb_to_display(fbi);
+
+		if (!ddev)
+			return -ENODEV;
+
+		if (copy_from_user(&area, (void *)arg, sizeof(area))) {
+			dev_warn(fbi->dev,
+				"%s: copy_from_user failed\n",
+				__func__);
+			return -EFAULT;
+		}
+		return mcde_dss_set_update_area(ddev, area.x, area.y,
+							area.w, area.h);
+	}
+
+#ifdef CONFIG_SW_SYNC
+	if (cmd == MCDE_PAN_DISPLAY_FENCE_IOC)
+		return pan_display_fence(fbi, (struct mcde_fb_flip __user *)arg);
+#endif
 	return -EINVAL;
 }
 
@@ -801,6 +916,10 @@ struct fb_info *mcde_fb_create(struct mcde_display_device *ddev,
 	}
 	init_fb(fbi);
 	mfb = to_mcde_fb(fbi);
+#ifdef CONFIG_SW_SYNC
+	/* Without a timeline flips are applied synchronously, with no fences */
+	mfb->timeline = sw_sync_timeline_create("mcde_fb");
+#endif
 
 	if (ddev->fictive == false) {
 		ret = mcde_dss_open_channel(ddev);
@@ -874,6 +993,10 @@ apply_var_failed:
 display_enable_failed:
 	mcde_dss_close_channel(ddev);
 channel_open_failed:
+#ifdef CONFIG_SW_SYNC
+	if (mfb->timeline)
+		sync_timeline_destroy(&mfb->timeline->obj);
+#endif
 	framebuffer_release(fbi);
 	fbi = NULL;
 fb_alloc_failed:
@@ -905,6 +1028,11 @@ void mcde_fb_destroy(struct mcde_display_device *dev)
 		if (mfb->ovlys[i])
 			mcde_dss_destroy_overlay(mfb->ovlys[i]);
 	}
+#ifdef CONFIG_SW_SYNC
+	/* The flips were all released as the channel was disabled */
+	if (mfb->timeline)
+		sync_timeline_destroy(&mfb->timeline->obj);
+#endif
 
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	if (dev->fictive == false)
@@ -27,6 +27,7 @@
 #include <linux/workqueue.h>
 #include <linux/time.h>
 #include <linux/atomic.h>
+#include <linux/cpufreq.h>
 
 #include <linux/mfd/dbx500-prcmu.h>
 
@@ -177,13 +178,17 @@ void mcde_wreg(u32 reg, u32 val)
 
 static struct mcde_ovly_state *overlays;
 static struct mcde_chnl_state *channels;
+
+/* Refresh rate in percent of the full rate, lowered on static content */
+static u32 refresh_pct = 100;
+
 static inline u32 get_ovly_bw(struct mcde_ovly_state *ovly)
 {
 	if (!ovly || !ovly->regs.enabled)
 		return 0;
 
 	//TODO: Use pixclock for fps
-	return ovly->regs.ppl * ovly->regs.lpf * 60;
+	return ovly->regs.ppl * ovly->regs.lpf * 60 / 100 * refresh_pct;
 }
 
 static void update_opp_requirements(void)
@@ -743,9 +748,19 @@ static inline void mcde_remove_vsync_capture_listener(
 	}
 }
 
+/* Vsyncs of the main display pace the scheduler and the governors */
+static inline void mcde_report_vsync(struct mcde_chnl_state *chnl)
+{
+	if (chnl->id != MCDE_CHNL_A)
+		return;
+	sched_frame_vsync(ktime_to_ns(ktime_get()));
+	cpufreq_record_vsync();
+}
+
 static inline void mcde_handle_vsync(struct mcde_chnl_state *chnl)
 {
 	trace_vsync(chnl->id, chnl->state);
+	mcde_report_vsync(chnl);
 	atomic_inc(&chnl->vsync_cnt);
 	chnl->vcmp_cnt_wait = atomic_read(&chnl->vcmp_cnt) + 1;
 	if (chnl->port.type == MCDE_PORTTYPE_DSI) {
@@ -787,13 +802,84 @@ static inline void mcde_handle_vcmp_state_stopping(struct mcde_chnl_state *chnl)
 		set_channel_state_atomic(chnl, CHNLSTATE_STOPPED);
 }
 
+/*
+ * Releases the buffer replaced by the flip latched at the last VCMP, the
+ * frame showing it being complete, and writes the queued flip to the
+ * shadowed source registers, for the next frame to take.
+ */
+static void ovly_latch_flip(struct mcde_ovly_state *ovly)
+{
+	if (!ovly)
+		return;
+
+	if (ovly->flip_latched) {
+		ovly->flip_latched = false;
+		ovly->latched_done(ovly->latched_data);
+	}
+	if (!ovly->flip_queued)
+		return;
+
+	ovly->regs.baseaddress0 = ovly->flip_paddr;
+	ovly->regs.baseaddress1 = ovly->flip_paddr + ovly->stride;
+	mcde_wreg(MCDE_EXTSRC0A0 + ovly->idx * MCDE_EXTSRC0A0_GROUPOFFSET,
+		ovly->regs.baseaddress0);
+	mcde_wreg(MCDE_EXTSRC0A1 + ovly->idx * MCDE_EXTSRC0A1_GROUPOFFSET,
+		ovly->regs.baseaddress1);
+
+	ovly->flip_queued = false;
+	ovly->flip_latched = true;
+	ovly->latched_done = ovly->flip_done;
+	ovly->latched_data = ovly->flip_data;
+}
+
+static void mcde_chnl_latch_flips(struct mcde_chnl_state *chnl)
+{
+	spin_lock(&chnl->flip_lock);
+	ovly_latch_flip(chnl->ovly0);
+	ovly_latch_flip(chnl->ovly1);
+	spin_unlock(&chnl->flip_lock);
+}
+
+/* Once the flow is stopped no buffer is read any more */
+static void ovly_flush_flip(struct mcde_ovly_state *ovly)
+{
+	if (!ovly)
+		return;
+
+	if (ovly->flip_latched) {
+		ovly->flip_latched = false;
+		ovly->latched_done(ovly->latched_data);
+	}
+	if (ovly->flip_queued) {
+		ovly->flip_queued = false;
+		ovly->flip_done(ovly->flip_data);
+	}
+}
+
+static void mcde_chnl_flush_flips(struct mcde_chnl_state *chnl)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&chnl->flip_lock, flags);
+	ovly_flush_flip(chnl->ovly0);
+	ovly_flush_flip(chnl->ovly1);
+	spin_unlock_irqrestore(&chnl->flip_lock, flags);
+	wake_up_all(&chnl->vcmp_waitq);
+}
+
 static inline void mcde_handle_vcmp(struct mcde_chnl_state *chnl)
 {
 	trace_vcmp(chnl->id, chnl->state);
+	if (chnl->frame_id != chnl->scanout_frame_id) {
+		chnl->scanout_frame_id = chnl->frame_id;
+		trace_scanout(chnl->id, chnl->frame_id);
+	}
 	if (!chnl->vcmp_per_field ||
 			(chnl->vcmp_per_field && chnl->even_vcmp)) {
 		if (chnl->state == CHNLSTATE_STOPPING)
 			mcde_handle_vcmp_state_stopping(chnl);
+		else if (chnl->state == CHNLSTATE_RUNNING)
+			mcde_chnl_latch_flips(chnl);
 
 		wake_up_all(&chnl->vcmp_waitq);
 	}
@@ -809,6 +895,7 @@ static void handle_dsi_irq(struct mcde_chnl_state *chnl)
 	events = nova_dsilink_handle_irq(chnl->dsilink);
 	if (events & DSILINK_IRQ_BTA_TE) {
 		trace_vsync(chnl->id, chnl->state);
+		mcde_report_vsync(chnl);
 		atomic_inc(&chnl->vsync_cnt);
 		chnl->vcmp_cnt_wait = atomic_read(&chnl->vcmp_cnt) + 1;
 
@@ -862,6 +949,7 @@ static irqreturn_t mcde_irq_handler(int irq, void *dev)
 	u32 active_interrupts;
 
 	active_interrupts = mcde_rreg(MCDE_AIS);
+	trace_isr(active_interrupts, true);
 
 	if (active_interrupts & (MCDE_AIS_DSI0AI_MASK |
 				MCDE_AIS_DSI1AI_MASK |
@@ -943,6 +1031,8 @@ static irqreturn_t mcde_irq_handler(int irq, void *dev)
 		mcde_wreg(MCDE_RISPP, irq_status);
 	}
 
+	trace_isr(active_interrupts, false);
+
 	return IRQ_HANDLED;
 }
 
@@ -1211,10 +1301,112 @@ static struct lcdclk_prop lcdclk_prop[] = {
 
 static unsigned int custom_lcdclk = 49920000;
 
+#ifdef CONFIG_MCDE_IDLE_REFRESH
+/*
+ * A video mode panel is refreshed at the full rate also when nothing new
+ * is posted. After idle_refresh_ms without updates LCDCLK is lowered to
+ * two thirds, the next update restores it. Both switches are done right
+ * after a frame is completed, in the vertical blanking.
+ */
+#define IDLE_REFRESH_MS 1000
+
+static unsigned int idle_refresh_ms = IDLE_REFRESH_MS;
+static unsigned long idle_refresh_last;
+/* LCDCLK to restore, 0 when running at the full rate */
+static unsigned long idle_refresh_clk;
+static struct mcde_chnl_state *idle_refresh_chnl;
+
+static void idle_refresh_function(struct work_struct *work);
+static DECLARE_DELAYED_WORK(idle_refresh_work, idle_refresh_function);
+
+/* mcde_lock must be held */
+static void idle_refresh_restore(void)
+{
+	if (!idle_refresh_clk)
+		return;
+
+	prcmu_set_clock_rate(PRCMU_LCDCLK, idle_refresh_clk);
+	idle_refresh_clk = 0;
+	refresh_pct = 100;
+	update_opp_requirements();
+}
+
+/*
+ * Called for each update of a running video mode channel, after the last
+ * frame has completed. mcde_lock must be held.
+ */
+static void idle_refresh_update(struct mcde_chnl_state *chnl)
+{
+	if (chnl->port.type != MCDE_PORTTYPE_DPI)
+		return;
+
+	idle_refresh_last = jiffies;
+	idle_refresh_restore();
+
+	if (idle_refresh_ms && !delayed_work_pending(&idle_refresh_work)) {
+		idle_refresh_chnl = chnl;
+		schedule_delayed_work(&idle_refresh_work,
+					msecs_to_jiffies(idle_refresh_ms));
+	}
+}
+
+static void idle_refresh_function(struct work_struct *work)
+{
+	struct mcde_chnl_state *chnl = idle_refresh_chnl;
+	unsigned long idle_end;
+	unsigned long clk;
+	long idle_clk;
+	int vcmp_cnt;
+
+	mcde_lock(__func__, __LINE__);
+
+	if (!idle_refresh_ms || idle_refresh_clk || !chnl->enabled ||
+				chnl->state != CHNLSTATE_RUNNING)
+		goto out;
+
+	/* Updated meanwhile */
+	idle_end = idle_refresh_last + msecs_to_jiffies(idle_refresh_ms);
+	if (time_before(jiffies, idle_end)) {
+		schedule_delayed_work(&idle_refresh_work, idle_end - jiffies);
+		goto out;
+	}
+
+	clk = prcmu_clock_rate(PRCMU_LCDCLK);
+	idle_clk = prcmu_round_clock_rate(PRCMU_LCDCLK, clk * 2 / 3);
+	if (idle_clk <= 0 || idle_clk >= clk)
+		goto out;
+
+	vcmp_cnt = atomic_read(&chnl->vcmp_cnt);
+	if (wait_event_timeout(chnl->vcmp_waitq,
+			atomic_read(&chnl->vcmp_cnt) > vcmp_cnt,
+			msecs_to_jiffies(CHNL_TIMEOUT)) == 0)
+		goto out;
+
+	if (prcmu_set_clock_rate(PRCMU_LCDCLK, idle_clk))
+		goto out;
+
+	idle_refresh_clk = clk;
+	refresh_pct = idle_clk * 100 / clk;
+	update_opp_requirements();
+	dev_dbg(&mcde_dev->dev, "Idle refresh, LCDCLK %lu -> %ld\n",
+							clk, idle_clk);
+out:
+	mcde_unlock(__func__, __LINE__);
+}
+#endif
+
 static void lcdclk_thread(struct work_struct *ws2401_lcdclk_work)
 {
 	msleep(200);
 
+#ifdef CONFIG_MCDE_IDLE_REFRESH
+	/* The rate set here is the full rate */
+	mcde_lock(__func__, __LINE__);
+	idle_refresh_clk = 0;
+	refresh_pct = 100;
+	mcde_unlock(__func__, __LINE__);
+#endif
+
 	if ((custom_lcdclk != 0) && (lcdclk_usr == -2)) {
 		pr_err("[MCDE] LCDCLK %dHz\n", custom_lcdclk);
 		LCDCLK_SET(custom_lcdclk);
@@ -1281,9 +1473,35 @@ out:
 }
 ATTR_RW(lcdclk);
 
+#ifdef CONFIG_MCDE_IDLE_REFRESH
+static ssize_t idle_refresh_ms_show(struct kobject *kobj,
+				struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", idle_refresh_ms);
+}
+
+static ssize_t idle_refresh_ms_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int tmp;
+
+	if (kstrtouint(buf, 10, &tmp))
+		return -EINVAL;
+
+	/* 0 disables, restored at the next update */
+	idle_refresh_ms = tmp;
+
+	return count;
+}
+ATTR_RW(idle_refresh_ms);
+#endif
+
 static struct attribute *mcde_attrs[] = {
  
 	&lcdclk_interface.attr, 
+#ifdef CONFIG_MCDE_IDLE_REFRESH
+	&idle_refresh_ms_interface.attr,
+#endif
 	NULL,
 };
 
@@ -2001,6 +2219,11 @@ void update_channel_registers(enum mcde_chnl chnl_id, struct chnl_regs *regs,
 	u8 green;
 	u8 blue;
 	u32 stripwidth = 0;
+	/* Command mode updates can be limited to a part of the screen */
+	bool update_area = port->type == MCDE_PORTTYPE_DSI &&
+		port->mode == MCDE_PORTMODE_CMD &&
+		!port->update_auto_trig && !regs->roten;
+	u32 xres = update_area ? regs->ppl : video_mode->xres;
 
 	dev_vdbg(&mcde_dev->dev, "%s\n", __func__);
 
@@ -2008,8 +2231,7 @@ void update_channel_registers(enum mcde_chnl chnl_id, struct chnl_regs *regs,
 	 * Select appropriate fifo watermark.
 	 * Watermark will be saturated at fifo size inside MCDE.
 	 */
-	fifo_wtrmrk = video_mode->xres /
-		get_pkt_div(video_mode->xres, port, fifo);
+	fifo_wtrmrk = xres / get_pkt_div(xres, port, fifo);
 
 	/* Don't set larger than fifo size */
 	switch (chnl_id) {
@@ -2158,6 +2380,11 @@ void update_channel_registers(enum mcde_chnl chnl_id, struct chnl_regs *regs,
 		#endif
 		/* -445681 display padding */
 
+		if (update_area) {
+			screen_ppl = regs->ppl;
+			screen_lpf = regs->lpf;
+		}
+
 		pkt_div = get_pkt_div(screen_ppl, port, fifo);
 
 		if (video_mode->interlaced)
@@ -2707,6 +2934,37 @@ fail_set_state:
 	return 0;
 }
 
+static int dsi_direct_write_begin(struct mcde_chnl_state *chnl)
+{
+	mcde_lock(__func__, __LINE__);
+
+	_mcde_chnl_enable(chnl);
+	if (enable_mcde_hw()) {
+		mcde_unlock(__func__, __LINE__);
+		return -EINVAL;
+	}
+	if (!chnl->formatter_updated)
+		(void)update_channel_static_registers(chnl);
+
+	/*
+	 * Some panels don't allow commands during update in command mode
+	 * Issue not seen on video mode panels, so we let DSI link do the
+	 * arbitration on packet level.
+	*/
+	if (chnl->port.mode == MCDE_PORTMODE_CMD)
+		set_channel_state_sync(chnl, CHNLSTATE_DSI_WRITE);
+
+	return 0;
+}
+
+static void dsi_direct_write_end(struct mcde_chnl_state *chnl)
+{
+	if (chnl->port.mode == MCDE_PORTMODE_CMD)
+		set_channel_state_atomic(chnl, CHNLSTATE_IDLE);
+
+	mcde_unlock(__func__, __LINE__);
+}
+
 static int mcde_dsi_direct_cmd_write(struct mcde_chnl_state *chnl,
 			bool dcs, u8 cmd, u8 *data, int len)
 {
@@ -2717,23 +2975,9 @@ static int mcde_dsi_direct_cmd_write(struct mcde_chnl_state *chnl,
 
 	if ((len <= DSILINK_MAX_DSI_DIRECT_CMD_WRITE && !dcs) ||
 	    (len <  DSILINK_MAX_DSI_DIRECT_CMD_WRITE &&  dcs)) {
-		mcde_lock(__func__, __LINE__);
-
-		_mcde_chnl_enable(chnl);
-		if (enable_mcde_hw()) {
-			mcde_unlock(__func__, __LINE__);
-			return -EINVAL;
-		}
-		if (!chnl->formatter_updated)
-			(void)update_channel_static_registers(chnl);
-
-		/*
-		 * Some panels don't allow commands during update in command mode
-		 * Issue not seen on video mode panels, so we let DSI link do the
-		 * arbitration on packet level.
-		*/
-		if (chnl->port.mode == MCDE_PORTMODE_CMD)
-			set_channel_state_sync(chnl, CHNLSTATE_DSI_WRITE);
+		ret = dsi_direct_write_begin(chnl);
+		if (ret)
+			return ret;
 
 		if (dcs)
 			ret = nova_dsilink_dcs_write(chnl->dsilink,
@@ -2741,10 +2985,7 @@ static int mcde_dsi_direct_cmd_write(struct mcde_chnl_state *chnl,
 		else
 			ret = nova_dsilink_dsi_write(chnl->dsilink, data, len);
 
-		if (chnl->port.mode == MCDE_PORTMODE_CMD)
-			set_channel_state_atomic(chnl, CHNLSTATE_IDLE);
-
-		mcde_unlock(__func__, __LINE__);
+		dsi_direct_write_end(chnl);
 	} else if (len <= MCDE_MAX_DSI_DIRECT_CMD_WRITE) {
 		ret = mcde_fifo_write_data(chnl, cmd, data, len);
 	} else {
@@ -2764,6 +3005,74 @@ int mcde_dsi_dcs_write(struct mcde_chnl_state *chnl, u8 cmd, u8* data, int len)
 	return mcde_dsi_direct_cmd_write(chnl, true, cmd, data, len);
 }
 
+void mcde_dsi_batch_init(struct mcde_dsi_batch *batch)
+{
+	batch->len = 0;
+}
+
+static int dsi_batch_add(struct mcde_dsi_batch *batch,
+		enum dsilink_cmd_datatype type, u8 cmd, const u8 *data, int len)
+{
+	u8 *p = &batch->buf[batch->len];
+
+	if (batch->len + DSILINK_BATCH_HDR + len > MCDE_DSI_BATCH_SIZE)
+		return -ENOSPC;
+
+	p[0] = type;
+	p[1] = cmd;
+	p[2] = len;
+	memcpy(p + DSILINK_BATCH_HDR, data, len);
+	batch->len += DSILINK_BATCH_HDR + len;
+	return 0;
+}
+
+/* Only commands the link sends directly can be batched */
+int mcde_dsi_batch_dcs(struct mcde_dsi_batch *batch,
+		u8 cmd, const u8 *data, int len)
+{
+	if (len < 0 || len >= DSILINK_MAX_DSI_DIRECT_CMD_WRITE)
+		return -EINVAL;
+
+	return dsi_batch_add(batch, DSILINK_CMD_DCS_WRITE, cmd, data, len);
+}
+
+int mcde_dsi_batch_generic(struct mcde_dsi_batch *batch,
+		const u8 *data, int len)
+{
+	if (len < 0 || len > DSILINK_MAX_DSI_DIRECT_CMD_WRITE)
+		return -EINVAL;
+
+	return dsi_batch_add(batch, DSILINK_CMD_GENERIC_WRITE, -1, data, len);
+}
+
+/*
+ * Sends the whole batch taking the lock and, in command mode, waiting for
+ * the running update once, instead of once per command. The batch is empty
+ * on return.
+ */
+int mcde_dsi_write_batch(struct mcde_chnl_state *chnl,
+		struct mcde_dsi_batch *batch)
+{
+	int ret = 0;
+
+	if (!chnl || chnl->port.type != MCDE_PORTTYPE_DSI) {
+		ret = -EINVAL;
+		goto out;
+	}
+	if (!batch->len)
+		goto out;
+
+	ret = dsi_direct_write_begin(chnl);
+	if (ret)
+		goto out;
+
+	ret = nova_dsilink_write_batch(chnl->dsilink, batch->buf, batch->len);
+	dsi_direct_write_end(chnl);
+out:
+	batch->len = 0;
+	return ret;
+}
+
 int mcde_dsi_dcs_read(struct mcde_chnl_state *chnl, u8 cmd, u32 *data, int *len)
 {
 	int ret = 0;
@@ -3005,7 +3314,7 @@ static int _mcde_chnl_apply(struct mcde_chnl_state *chnl)
 	chnl->regs.blend_en = chnl->blend_en;
 	chnl->regs.alpha_blend = chnl->alpha_blend;
 
-	/* For now the update area will always be full screen */
+	/* Full screen, chnl_setup_update_area() limits single updates */
 	chnl->regs.x   = 0;
 	chnl->regs.y   = 0;
 
@@ -3298,6 +3607,119 @@ static void stop_channel_if_needed(struct mcde_chnl_state *chnl)
 
 }
 
+static bool ovly_set_update_area(struct mcde_ovly_state *ovly,
+					u16 x, u16 y, u16 w, u16 h)
+{
+	/* The part of the overlay inside the area */
+	u16 x1 = max(ovly->dst_x, x);
+	u16 y1 = max(ovly->dst_y, y);
+	u16 x2 = min(ovly->dst_x + ovly->w, x + w);
+	u16 y2 = min(ovly->dst_y + ovly->h, y + h);
+
+	if (x1 >= x2 || y1 >= y2)
+		return false;
+
+	ovly->regs.ppl = x2 - x1;
+	ovly->regs.lpf = y2 - y1;
+	ovly->regs.cropx = ovly->src_x + x1 - ovly->dst_x;
+	ovly->regs.cropy = ovly->src_y + y1 - ovly->dst_y;
+	ovly->regs.xpos = x1 - x;
+	ovly->regs.ypos = y1 - y;
+	ovly->regs.dirty = true;
+
+	return true;
+}
+
+static int set_dsi_window(struct mcde_chnl_state *chnl,
+					u16 x, u16 y, u16 w, u16 h)
+{
+	u8 col[4] = { x >> 8, x & 0xFF, (x + w - 1) >> 8, (x + w - 1) & 0xFF };
+	u8 page[4] = { y >> 8, y & 0xFF, (y + h - 1) >> 8, (y + h - 1) & 0xFF };
+	int ret;
+
+	ret = nova_dsilink_dcs_write(chnl->dsilink,
+				DCS_CMD_SET_COLUMN_ADDRESS, col, sizeof(col));
+	if (!ret)
+		ret = nova_dsilink_dcs_write(chnl->dsilink,
+				DCS_CMD_SET_PAGE_ADDRESS, page, sizeof(page));
+	return ret;
+}
+
+/*
+ * Limits the frame sent to a command mode panel to the update area, or
+ * restores the full screen after a partial update.
+ */
+static void chnl_setup_update_area(struct mcde_chnl_state *chnl)
+{
+	struct mcde_ovly_state *ovlys[] = { chnl->ovly0, chnl->ovly1 };
+	u16 x = chnl->update_x;
+	u16 y = chnl->update_y;
+	u16 w = chnl->update_w;
+	u16 h = chnl->update_h;
+	bool partial;
+	int i;
+
+	chnl->update_w = 0;
+	chnl->update_h = 0;
+
+	partial = w && h && chnl->port.type == MCDE_PORTTYPE_DSI &&
+		chnl->port.mode == MCDE_PORTMODE_CMD &&
+		!chnl->port.update_auto_trig && !chnl->regs.roten &&
+		!chnl->vmode.interlaced && !chnl->first_frame_vsync_fix &&
+		(w < chnl->vmode.xres || h < chnl->vmode.yres);
+
+	for (i = 0; partial && i < ARRAY_SIZE(ovlys); i++)
+		if (ovlys[i] && ovlys[i]->inuse &&
+				!ovly_set_update_area(ovlys[i], x, y, w, h))
+			partial = false;
+
+	if (partial && set_dsi_window(chnl, x, y, w, h))
+		partial = false;
+
+	if (partial) {
+		chnl->regs.x = x;
+		chnl->regs.y = y;
+		chnl->regs.ppl = w;
+		chnl->regs.lpf = h;
+		chnl->regs.dirty = true;
+		chnl->partial_update = true;
+		return;
+	}
+
+	if (!chnl->partial_update)
+		return;
+
+	/* Back to the full screen */
+	for (i = 0; i < ARRAY_SIZE(ovlys); i++) {
+		struct mcde_ovly_state *ovly = ovlys[i];
+
+		if (!ovly || !ovly->inuse)
+			continue;
+
+		ovly->regs.ppl = ovly->w;
+		ovly->regs.lpf = ovly->h;
+		ovly->regs.cropx = ovly->src_x;
+		ovly->regs.cropy = ovly->src_y;
+		ovly->regs.xpos = ovly->dst_x;
+		ovly->regs.ypos = ovly->dst_y;
+		ovly->regs.dirty = true;
+	}
+
+	/* A rotated channel has been applied since */
+	if (!chnl->regs.roten) {
+		chnl->regs.x = 0;
+		chnl->regs.y = 0;
+		chnl->regs.ppl = chnl->vmode.xres;
+		chnl->regs.lpf = chnl->vmode.yres;
+		chnl->regs.dirty = true;
+	}
+
+	if (set_dsi_window(chnl, 0, 0, chnl->vmode.xres, chnl->vmode.yres))
+		dev_warn(&mcde_dev->dev, "%s: Failed to reset window, "
+					"chnl=%d\n", __func__, chnl->id);
+	chnl->partial_update = false;
+}
+
 static int _mcde_chnl_update(struct mcde_chnl_state *chnl,
 					bool tripple_buffer)
 {
@@ -3321,6 +3743,7 @@ static int _mcde_chnl_update(struct mcde_chnl_state *chnl,
 	/* Syncronize updates with panel vsync */
 	if (!chnl->port.update_auto_trig || chnl->state != CHNLSTATE_RUNNING) {
 		/* Command mode or video mode stopped */
+		mcde_chnl_flush_flips(chnl);
 		set_channel_state_sync(chnl, CHNLSTATE_SETUP);
 		curr_vcmp_cnt = atomic_read(&chnl->vcmp_cnt);
 	} else if (chnl->port.sync_src == MCDE_SYNCSRC_TE0 ||
@@ -3336,8 +3759,16 @@ static int _mcde_chnl_update(struct mcde_chnl_state *chnl,
 	}
 	chnl->vcmp_cnt_wait = curr_vcmp_cnt + 1;
 
+#ifdef CONFIG_MCDE_IDLE_REFRESH
+	if (chnl->port.update_auto_trig && chnl->state == CHNLSTATE_RUNNING)
+		idle_refresh_update(chnl);
+#endif
+
 	/* No access of HW before this line */
 
+	if (!chnl->port.update_auto_trig)
+		chnl_setup_update_area(chnl);
+
 	chnl_update_overlay(chnl, chnl->ovly0);
 	chnl_update_overlay(chnl, chnl->ovly1);
 
@@ -3521,6 +3952,39 @@ int mcde_chnl_set_power_mode(struct mcde_chnl_state *chnl,
 	return 0;
 }
 
+int mcde_chnl_set_update_area(struct mcde_chnl_state *chnl,
+				u16 x, u16 y, u16 w, u16 h)
+{
+	dev_vdbg(&mcde_dev->dev, "%s\n", __func__);
+
+	if (!chnl->reserved)
+		return -EINVAL;
+
+	if (x + w > chnl->vmode.xres || y + h > chnl->vmode.yres)
+		return -EINVAL;
+
+	mcde_lock(__func__, __LINE__);
+	chnl->update_x = x;
+	chnl->update_y = y;
+	chnl->update_w = w;
+	chnl->update_h = h;
+	mcde_unlock(__func__, __LINE__);
+
+	dev_vdbg(&mcde_dev->dev, "%s exit\n", __func__);
+
+	return 0;
+}
+EXPORT_SYMBOL(mcde_chnl_set_update_area);
+
+/* Tag the next update with the id of the frame it shows, for tracing */
+void mcde_chnl_set_frame_id(struct mcde_chnl_state *chnl, u32 frame)
+{
+	mcde_lock(__func__, __LINE__);
+	chnl->next_frame_id = frame;
+	mcde_unlock(__func__, __LINE__);
+}
+EXPORT_SYMBOL(mcde_chnl_set_frame_id);
+
 int mcde_chnl_apply(struct mcde_chnl_state *chnl)
 {
 	int ret ;
@@ -3554,6 +4018,7 @@ int mcde_chnl_update(struct mcde_chnl_state *chnl,
 
 	mcde_lock(__func__, __LINE__);
 
+	chnl->frame_id = chnl->next_frame_id;
 	ret = _mcde_chnl_update(chnl, tripple_buffer);
 	mcde_debugfs_channel_update(chnl->id);
 	if (chnl->ovly0)
@@ -3628,6 +4093,7 @@ void mcde_chnl_disable(struct mcde_chnl_state *chnl)
 	cancel_delayed_work(&hw_timeout_work);
 	/* The channel must be stopped before it is disabled */
 	WARN_ON_ONCE(chnl->state == CHNLSTATE_RUNNING);
+	mcde_chnl_flush_flips(chnl);
 	disable_mcde_hw(false, true);
 	chnl->enabled = false;
 	mcde_unlock(__func__, __LINE__);
@@ -3722,6 +4188,46 @@ void mcde_ovly_set_source_buf(
 	ovly->kaddr = kaddr;
 }
 
+/*
+ * Shows paddr from the frame after the next VCMP on, without waiting for
+ * it, as long as nothing but the buffer changed. At most one flip is
+ * queued on top of the one latched. done(data) is called in interrupt
+ * context once the buffer shown before is no longer read. Returns -EAGAIN
+ * where a full update is needed instead.
+ */
+int mcde_ovly_queue_flip(struct mcde_ovly_state *ovly, u32 paddr,
+	void (*done)(void *data), void *data)
+{
+	struct mcde_chnl_state *chnl = ovly->chnl;
+	unsigned long flags;
+	int ret = 0;
+
+	if (!ovly->inuse || ovly->dirty || !ovly->paddr || !paddr ||
+			!chnl->port.update_auto_trig)
+		return -EAGAIN;
+
+	if (wait_event_timeout(chnl->vcmp_waitq, !ovly->flip_queued ||
+			chnl->state != CHNLSTATE_RUNNING,
+			msecs_to_jiffies(CHNL_TIMEOUT)) == 0)
+		return -ETIMEDOUT;
+
+	mcde_lock(__func__, __LINE__);
+	spin_lock_irqsave(&chnl->flip_lock, flags);
+	if (chnl->state != CHNLSTATE_RUNNING || ovly->flip_queued) {
+		ret = -EAGAIN;
+	} else {
+		ovly->paddr = paddr;
+		ovly->flip_paddr = paddr;
+		ovly->flip_done = done;
+		ovly->flip_data = data;
+		ovly->flip_queued = true;
+	}
+	spin_unlock_irqrestore(&chnl->flip_lock, flags);
+	mcde_unlock(__func__, __LINE__);
+
+	return ret;
+}
+
 void mcde_ovly_set_source_info(struct mcde_ovly_state *ovly,
 	u32 stride, enum mcde_ovly_pix_fmt pix_fmt)
 {
@@ -4082,6 +4588,7 @@ static int probe_hw(struct platform_device *pdev)
 		init_waitqueue_head(&channels[i].state_waitq);
 		init_waitqueue_head(&channels[i].vcmp_waitq);
 		init_waitqueue_head(&channels[i].vsync_waitq);
+		spin_lock_init(&channels[i].flip_lock);
 
 		mcde_debugfs_channel_create(i, &channels[i]);
 		mcde_debugfs_overlay_create(i, 0, channels[i].ovly0);
@@ -93,6 +93,19 @@ struct mcde_ovly_state {
 
 	/* Applied settings */
 	struct ovly_regs regs;
+
+	/*
+	 * Flip waiting for the next VCMP, and the one latched at the last
+	 * VCMP, whose done is called once the frame showing it completed.
+	 * Protected by the channel's flip_lock.
+	 */
+	bool flip_queued;
+	u32 flip_paddr;
+	void (*flip_done)(void *data);
+	void *flip_data;
+	bool flip_latched;
+	void (*latched_done)(void *data);
+	void *latched_data;
 };
 
 struct chnl_regs {
@@ -203,6 +216,7 @@ struct mcde_chnl_state {
 	wait_queue_head_t state_waitq;
 	wait_queue_head_t vcmp_waitq;
 	wait_queue_head_t vsync_waitq;
+	spinlock_t flip_lock;
 	atomic_t vcmp_cnt;
 	int vcmp_cnt_wait;
 	atomic_t vsync_cnt;
@@ -254,6 +268,22 @@ struct mcde_chnl_state {
 	bool first_frame_vsync_fix;
 	bool force_disable;
 
+	/* Area of the next update, zero size for all of the screen */
+	u16 update_x;
+	u16 update_y;
+	u16 update_w;
+	u16 update_h;
+	/* The panel window is set to a part of the screen */
+	bool partial_update;
+
+	/*
+	 * Id of the frame of the next update, of the last update and of the
+	 * last frame traced as scanned out
+	 */
+	u32 next_frame_id;
+	u32 frame_id;
+	u32 scanout_frame_id;
+
 	atomic_t force_restart;
 	int force_restart_frame_cnt;
 	int force_restart_first_cnt;
@@ -91,6 +91,35 @@ TRACE_EVENT(vsync,
 	TP_printk("chnl=%d %d", __entry->chnl, __entry->state)
 );
 
+/* First VCMP after the update of a frame, set by mcde_chnl_set_frame_id() */
+TRACE_EVENT(scanout,
+	TP_PROTO(int chnl, u32 frame),
+	TP_ARGS(chnl, frame),
+	TP_STRUCT__entry(
+		__field(	int,	chnl	)
+		__field(	u32,	frame	)
+	),
+	TP_fast_assign(
+		__entry->chnl = chnl;
+		__entry->frame = frame;
+	),
+	TP_printk("chnl=%d frame=%u", __entry->chnl, __entry->frame)
+);
+
+TRACE_EVENT(isr,
+	TP_PROTO(u32 ais, bool begin),
+	TP_ARGS(ais, begin),
+	TP_STRUCT__entry(
+		__field(	u32,	ais	)
+		__field(	bool,	begin	)
+	),
+	TP_fast_assign(
+		__entry->ais = ais;
+		__entry->begin = begin;
+	),
+	TP_printk("ais=0x%08x %s", __entry->ais, __entry->begin ? "begin" : "end")
+);
+
 TRACE_EVENT(chnl_err,
 	TP_PROTO(unsigned int err),
 	TP_ARGS(err),
@@ -23,9 +23,14 @@
 #include <linux/notifier.h>
 #include <linux/reboot.h>
 #include <linux/writeback.h>
+#include <linux/fs.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 
 #define DYN_FSYNC_VERSION_MAJOR 1
-#define DYN_FSYNC_VERSION_MINOR 2
+#define DYN_FSYNC_VERSION_MINOR 3
 
 /*
  * fsync_mutex protects dyn_fsync_active during early suspend / late resume
@@ -37,6 +42,175 @@ bool early_suspend_active __read_mostly = false;
 bool dyn_fsync_active __read_mostly = false;
 bool dyn_fdatasync_active __read_mostly = false;
 
+/*
+ * Batched fsync: instead of returning at once, fsync writes the data of
+ * the file and waits for one commit of the filesystem (->sync_fs) shared
+ * by all the fsyncs of a window. A caller whose batch has not committed
+ * by the deadline does its own fsync, nothing is ever left unsynced.
+ * Only the filesystems in dyn_fsync_batch_fs are batched, their sync_fs
+ * must commit the metadata of all inodes (a journal commit, a checkpoint).
+ */
+bool dyn_fsync_batch __read_mostly = false;
+static unsigned int dyn_fsync_window_ms = 20;
+static unsigned int dyn_fsync_deadline_ms = 200;
+static char dyn_fsync_batch_fs[64] = "ext4 f2fs";
+
+struct fsync_batch {
+	struct list_head list;
+	struct super_block *sb;
+	struct delayed_work work;
+	wait_queue_head_t wait;
+	unsigned int users;		/* callers in dyn_fsync_batched() */
+	unsigned long seq;		/* batch callers join */
+	unsigned long done_seq;		/* last committed batch */
+	int err;			/* of the last commit */
+	bool queued;
+};
+
+/* protects the list and all the batches */
+static DEFINE_SPINLOCK(fsync_batch_lock);
+static LIST_HEAD(fsync_batch_list);
+
+static void fsync_batch_commit(struct work_struct *work)
+{
+	struct fsync_batch *b = container_of(work, struct fsync_batch,
+					     work.work);
+	unsigned long seq;
+	int err;
+
+	spin_lock(&fsync_batch_lock);
+	seq = b->seq++;
+	b->queued = false;
+	spin_unlock(&fsync_batch_lock);
+
+	/* the waiters of the batch hold the superblock */
+	err = b->sb->s_op->sync_fs(b->sb, 1);
+
+	spin_lock(&fsync_batch_lock);
+	b->done_seq = seq;
+	b->err = err;
+	spin_unlock(&fsync_batch_lock);
+	wake_up_all(&b->wait);
+}
+
+static struct fsync_batch *fsync_batch_get(struct super_block *sb)
+{
+	struct fsync_batch *b, *new = NULL;
+
+again:
+	spin_lock(&fsync_batch_lock);
+	list_for_each_entry(b, &fsync_batch_list, list)
+		if (b->sb == sb)
+			goto found;
+	if (new) {
+		b = new;
+		new = NULL;
+		list_add(&b->list, &fsync_batch_list);
+		goto found;
+	}
+	spin_unlock(&fsync_batch_lock);
+
+	new = kzalloc(sizeof(*new), GFP_KERNEL);
+	if (!new)
+		return NULL;
+	new->sb = sb;
+	INIT_DELAYED_WORK(&new->work, fsync_batch_commit);
+	init_waitqueue_head(&new->wait);
+	new->done_seq = ULONG_MAX;
+	goto again;
+
+found:
+	b->users++;
+	spin_unlock(&fsync_batch_lock);
+	kfree(new);
+	return b;
+}
+
+static void fsync_batch_put(struct fsync_batch *b)
+{
+	bool last;
+
+	spin_lock(&fsync_batch_lock);
+	last = !--b->users;
+	if (last)
+		list_del(&b->list);
+	spin_unlock(&fsync_batch_lock);
+
+	/*
+	 * Nobody holds the superblock for a commit whose waiters all timed
+	 * out, it must not run later.
+	 */
+	if (last) {
+		cancel_delayed_work_sync(&b->work);
+		kfree(b);
+	}
+}
+
+static bool dyn_fsync_batched_fs(struct super_block *sb)
+{
+	const char *name = sb->s_type->name;
+	const char *p = dyn_fsync_batch_fs;
+	size_t len = strlen(name);
+
+	if (!sb->s_op->sync_fs)
+		return false;
+
+	while ((p = strstr(p, name))) {
+		if ((p == dyn_fsync_batch_fs || p[-1] == ' ') &&
+		    (p[len] == '\0' || p[len] == ' ' || p[len] == '\n'))
+			return true;
+		p += len;
+	}
+	return false;
+}
+
+/**
+ * dyn_fsync_batched - fsync a range as part of a batched commit
+ *
+ * Called by vfs_fsync_range() while batching is enabled.
+ */
+int dyn_fsync_batched(struct file *file, loff_t start, loff_t end,
+		      int datasync)
+{
+	struct super_block *sb = file->f_mapping->host->i_sb;
+	struct fsync_batch *b;
+	unsigned long seq;
+	long left;
+	int err;
+
+	if (!dyn_fsync_batched_fs(sb) || !(b = fsync_batch_get(sb)))
+		return file->f_op->fsync(file, start, end, datasync);
+
+	err = filemap_write_and_wait_range(file->f_mapping, start, end);
+	if (err)
+		goto out;
+
+	spin_lock(&fsync_batch_lock);
+	seq = b->seq;
+	if (!b->queued) {
+		b->queued = true;
+		schedule_delayed_work(&b->work,
+				msecs_to_jiffies(dyn_fsync_window_ms));
+	}
+	spin_unlock(&fsync_batch_lock);
+
+	left = wait_event_timeout(b->wait,
+			ACCESS_ONCE(b->done_seq) == seq ||
+			(long)(ACCESS_ONCE(b->done_seq) - seq) > 0,
+			msecs_to_jiffies(dyn_fsync_deadline_ms));
+	if (!left) {
+		err = file->f_op->fsync(file, start, end, datasync);
+		goto out;
+	}
+
+	spin_lock(&fsync_batch_lock);
+	err = b->err;
+	spin_unlock(&fsync_batch_lock);
+out:
+	fsync_batch_put(b);
+	return err;
+}
+
 static ssize_t dyn_fdatasync_active_show(struct kobject *kobj,
 		struct kobj_attribute *attr, char *buf)
 {
@@ -93,6 +267,80 @@ static ssize_t dyn_fsync_active_store(struct kobject *kobj,
 	return count;
 }
 
+static ssize_t dyn_fsync_batch_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", (dyn_fsync_batch ? 1 : 0));
+}
+
+static ssize_t dyn_fsync_batch_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int data;
+
+	if (sscanf(buf, "%u\n", &data) != 1 || data > 1)
+		return -EINVAL;
+
+	dyn_fsync_batch = data;
+	return count;
+}
+
+static ssize_t dyn_fsync_window_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", dyn_fsync_window_ms);
+}
+
+static ssize_t dyn_fsync_window_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int data;
+
+	if (sscanf(buf, "%u\n", &data) != 1 || data > 1000)
+		return -EINVAL;
+
+	dyn_fsync_window_ms = data;
+	return count;
+}
+
+static ssize_t dyn_fsync_deadline_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", dyn_fsync_deadline_ms);
+}
+
+static ssize_t dyn_fsync_deadline_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int data;
+
+	if (sscanf(buf, "%u\n", &data) != 1 || data < 1 || data > 10000)
+		return -EINVAL;
+
+	dyn_fsync_deadline_ms = data;
+	return count;
+}
+
+static ssize_t dyn_fsync_batch_fs_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%s\n", dyn_fsync_batch_fs);
+}
+
+static ssize_t dyn_fsync_batch_fs_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	char names[sizeof(dyn_fsync_batch_fs)];
+
+	if (count >= sizeof(names))
+		return -EINVAL;
+
+	/* read racily by fsync, a torn list only batches less */
+	strlcpy(names, buf, count + 1);
+	strcpy(dyn_fsync_batch_fs, strim(names));
+	return count;
+}
+
 static ssize_t dyn_fsync_version_show(struct kobject *kobj,
 		struct kobj_attribute *attr, char *buf)
 {
@@ -117,6 +365,26 @@ static struct kobj_attribute dyn_fdatasync_active_attribute =
 		dyn_fdatasync_active_show,
 		dyn_fdatasync_active_store);
 
+static struct kobj_attribute dyn_fsync_batch_attribute =
+	__ATTR(Dyn_fsync_batch, 0644,
+		dyn_fsync_batch_show,
+		dyn_fsync_batch_store);
+
+static struct kobj_attribute dyn_fsync_window_attribute =
+	__ATTR(Dyn_fsync_window_ms, 0644,
+		dyn_fsync_window_show,
+		dyn_fsync_window_store);
+
+static struct kobj_attribute dyn_fsync_deadline_attribute =
+	__ATTR(Dyn_fsync_deadline_ms, 0644,
+		dyn_fsync_deadline_show,
+		dyn_fsync_deadline_store);
+
+static struct kobj_attribute dyn_fsync_batch_fs_attribute =
+	__ATTR(Dyn_fsync_batch_fs, 0644,
+		dyn_fsync_batch_fs_show,
+		dyn_fsync_batch_fs_store);
+
 static struct kobj_attribute dyn_fsync_version_attribute = 
 	__ATTR(Dyn_fsync_version, 0444, dyn_fsync_version_show, NULL);
 
@@ -127,6 +395,10 @@ static struct attribute *dyn_fsync_active_attrs[] =
 	{
 		&dyn_fsync_active_attribute.attr,
 		&dyn_fdatasync_active_attribute.attr,
+		&dyn_fsync_batch_attribute.attr,
+		&dyn_fsync_window_attribute.attr,
+		&dyn_fsync_deadline_attribute.attr,
+		&dyn_fsync_batch_fs_attribute.attr,
 		&dyn_fsync_version_attribute.attr,
 		&dyn_fsync_earlysuspend_attribute.attr,
 		NULL,
@@ -35,6 +35,7 @@
 #include <linux/anon_inodes.h>
 #include <linux/device.h>
 #include <linux/freezer.h>
+#include <linux/hrtimer.h>
 #include <asm/uaccess.h>
 #include <asm/io.h>
 #include <asm/mman.h>
@@ -89,7 +90,10 @@
  */
 
 /* Epoll private bits inside the event mask */
-#define EP_PRIVATE_BITS (EPOLLWAKEUP | EPOLLONESHOT | EPOLLET)
+#define EP_PRIVATE_BITS (EPOLLWAKEUP | EPOLLONESHOT | EPOLLET | \
+			 EPOLLEXCLUSIVE | EPOLLBATCH)
+
+#define EPOLLINOUT_BITS (POLLIN | POLLOUT)
 
 /* Maximum number of nesting allowed inside epoll sets */
 #define EP_MAX_NESTS 4
@@ -202,6 +206,10 @@ struct eventpoll {
 	/* wakeup_source used when ep_scan_ready_list is running */
 	struct wakeup_source *ws;
 
+	/* Delays the wakeups for EPOLLBATCH events, armed under ->lock */
+	struct hrtimer batch_timer;
+	int batch_armed;
+
 	/* The user that created the eventpoll descriptor */
 	struct user_struct *user;
 
@@ -248,6 +256,9 @@ struct ep_send_events_data {
 /* Maximum number of epoll watched descriptors, per user */
 static long max_user_watches __read_mostly;
 
+/* Window the wakeups for EPOLLBATCH descriptors are coalesced over */
+static int batch_usecs __read_mostly = 500;
+
 /*
  * This mutex is used to serialize ep_free() and eventpoll_release_file().
  */
@@ -283,6 +294,8 @@ static LIST_HEAD(tfile_check_list);
 
 static long zero;
 static long long_max = LONG_MAX;
+static int batch_usecs_min;
+static int batch_usecs_max = USEC_PER_SEC / 10;
 
 ctl_table epoll_table[] = {
 	{
@@ -294,6 +307,15 @@ ctl_table epoll_table[] = {
 		.extra1		= &zero,
 		.extra2		= &long_max,
 	},
+	{
+		.procname	= "batch_usecs",
+		.data		= &batch_usecs,
+		.maxlen		= sizeof(batch_usecs),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &batch_usecs_min,
+		.extra2		= &batch_usecs_max,
+	},
 	{ }
 };
 #endif /* CONFIG_SYSCTL */
@@ -717,6 +739,7 @@ static void ep_free(struct eventpoll *ep)
 	}
 
 	mutex_unlock(&epmutex);
+	hrtimer_cancel(&ep->batch_timer);
 	mutex_destroy(&ep->mtx);
 	free_uid(ep->user);
 	wakeup_source_unregister(ep->ws);
@@ -830,6 +853,32 @@ void eventpoll_release_file(struct file *file)
 	mutex_unlock(&epmutex);
 }
 
+static enum hrtimer_restart ep_batch_timer_fn(struct hrtimer *timer)
+{
+	struct eventpoll *ep = container_of(timer, struct eventpoll,
+					    batch_timer);
+	unsigned long flags;
+	int pwake = 0;
+
+	spin_lock_irqsave(&ep->lock, flags);
+
+	ep->batch_armed = 0;
+	if (ep_events_available(ep)) {
+		if (waitqueue_active(&ep->wq))
+			wake_up_locked(&ep->wq);
+		if (waitqueue_active(&ep->poll_wait))
+			pwake++;
+	}
+
+	spin_unlock_irqrestore(&ep->lock, flags);
+
+	/* We have to call this outside the lock */
+	if (pwake)
+		ep_poll_safewake(&ep->poll_wait);
+
+	return HRTIMER_NORESTART;
+}
+
 static int ep_alloc(struct eventpoll **pep)
 {
 	int error;
@@ -850,6 +899,8 @@ static int ep_alloc(struct eventpoll **pep)
 	ep->rbr = RB_ROOT;
 	ep->ovflist = EP_UNACTIVE_PTR;
 	ep->user = user;
+	hrtimer_init(&ep->batch_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	ep->batch_timer.function = ep_batch_timer_fn;
 
 	*pep = ep;
 
@@ -897,6 +948,7 @@ static struct epitem *ep_find(struct eventpoll *ep, struct file *file, int fd)
 static int ep_poll_callback(wait_queue_t *wait, unsigned mode, int sync, void *key)
 {
 	int pwake = 0;
+	int ewake = 0;
 	unsigned long flags;
 	struct epitem *epi = ep_item_from_wait(wait);
 	struct eventpoll *ep = epi->ep;
@@ -960,6 +1012,41 @@ static int ep_poll_callback(wait_queue_t *wait, unsigned mode, int sync, void *k
 		__pm_stay_awake(epi->ws);
 	}
 
+	/*
+	 * An EPOLLEXCLUSIVE item only counts as a wakeup of the target's wait
+	 * queue if it has a waiter to hand the event to, so that the next
+	 * exclusive item gets the event otherwise.
+	 */
+	if (waitqueue_active(&ep->wq) &&
+	    (epi->event.events & EPOLLEXCLUSIVE) &&
+	    !((unsigned long)key & POLLFREE)) {
+		switch ((unsigned long)key & EPOLLINOUT_BITS) {
+		case POLLIN:
+			if (epi->event.events & POLLIN)
+				ewake = 1;
+			break;
+		case POLLOUT:
+			if (epi->event.events & POLLOUT)
+				ewake = 1;
+			break;
+		case 0:
+			ewake = 1;
+			break;
+		}
+	}
+
+	/* The first event of a batch arms the wakeup, the others ride on it */
+	if ((epi->event.events & EPOLLBATCH) && batch_usecs) {
+		if (!ep->batch_armed) {
+			ep->batch_armed = 1;
+			hrtimer_start(&ep->batch_timer,
+				      ns_to_ktime((u64)batch_usecs *
+						  NSEC_PER_USEC),
+				      HRTIMER_MODE_REL);
+		}
+		goto out_unlock;
+	}
+
 	/*
 	 * Wake up ( if active ) both the eventpoll wait list and the ->poll()
 	 * wait list.
@@ -976,7 +1063,10 @@ out_unlock:
 	if (pwake)
 		ep_poll_safewake(&ep->poll_wait);
 
-	return 1;
+	if (!(epi->event.events & EPOLLEXCLUSIVE))
+		ewake = 1;
+
+	return ewake;
 }
 
 /*
@@ -993,7 +1083,10 @@ static void ep_ptable_queue_proc(struct file *file, wait_queue_head_t *whead,
 		init_waitqueue_func_entry(&pwq->wait, ep_poll_callback);
 		pwq->whead = whead;
 		pwq->base = epi;
-		add_wait_queue(whead, &pwq->wait);
+		if (epi->event.events & EPOLLEXCLUSIVE)
+			add_wait_queue_exclusive(whead, &pwq->wait);
+		else
+			add_wait_queue(whead, &pwq->wait);
 		list_add_tail(&pwq->llink, &epi->pwqlist);
 		epi->nwait++;
 	} else {
@@ -1744,6 +1837,18 @@ SYSCALL_DEFINE4(epoll_ctl, int, epfd, int, op, int, fd,
 	if (file == tfile || !is_file_epoll(file))
 		goto error_tgt_fput;
 
+	/*
+	 * EPOLLEXCLUSIVE picks the kind of wait queue entry, which is only
+	 * done when the item is inserted, and makes no sense for nested
+	 * epoll files, which are woken through ep_poll_safewake().
+	 */
+	if (ep_op_has_event(op) && (epds.events & EPOLLEXCLUSIVE)) {
+		if (op == EPOLL_CTL_MOD)
+			goto error_tgt_fput;
+		if (op == EPOLL_CTL_ADD && is_file_epoll(tfile))
+			goto error_tgt_fput;
+	}
+
 	/*
 	 * At this point it is safe to assume that the "private_data" contains
 	 * our own data structure.
@@ -1804,8 +1909,10 @@ SYSCALL_DEFINE4(epoll_ctl, int, epfd, int, op, int, fd,
 		break;
 	case EPOLL_CTL_MOD:
 		if (epi) {
-			epds.events |= POLLERR | POLLHUP;
-			error = ep_modify(ep, epi, &epds);
+			if (!(epi->event.events & EPOLLEXCLUSIVE)) {
+				epds.events |= POLLERR | POLLHUP;
+				error = ep_modify(ep, epi, &epds);
+			}
 		} else
 			error = -ENOENT;
 		break;
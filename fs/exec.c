@@ -980,6 +980,7 @@ static int de_thread(struct task_struct *tsk)
 		if (unlikely(leader->ptrace))
 			__wake_up_parent(leader, leader->parent);
 		write_unlock_irq(&tasklist_lock);
+		oom_adj_index_replace(leader, tsk);
 		threadgroup_change_end(tsk);
 
 		release_task(leader);
@@ -99,7 +99,7 @@ int FsMountVol(struct super_block *sb)
 	err = buf_init(sb);
 	if (!err)
 		err = ffsMountVol(sb);
-	else
+	if (err)
 		buf_shutdown(sb);
 
 	sm_V(&z_sem);
@@ -33,6 +33,11 @@
 /*                                                                      */
 /************************************************************************/
 
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
+#include <linux/blkdev.h>
+
 #include "exfat_config.h"
 #include "exfat_data.h"
 
@@ -67,20 +72,49 @@ static void push_to_lru(BUF_CACHE_T *bp, BUF_CACHE_T *list);
 static void move_to_mru(BUF_CACHE_T *bp, BUF_CACHE_T *list);
 static void move_to_lru(BUF_CACHE_T *bp, BUF_CACHE_T *list);
 
+static struct kmem_cache *exfat_extent_cachep;
+
 /*======================================================================*/
 /*  Cache Initialization Functions                                      */
 /*======================================================================*/
 
+/* one more doubling for every power of two of 256MB of RAM */
+static u32 cache_scale_shift(void)
+{
+	unsigned long mb = totalram_pages >> (20 - PAGE_SHIFT);
+
+	return min_t(u32, ilog2(max(mb >> 8, 1UL)), CACHE_SCALE_MAX);
+}
+
 s32 buf_init(struct super_block *sb)
 {
 	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+	u32 shift = cache_scale_shift();
 
 	int i;
 
+	p_fs->FAT_cache_size = FAT_CACHE_SIZE << shift;
+	p_fs->FAT_cache_hash_mask = (FAT_CACHE_HASH_SIZE << shift) - 1;
+	p_fs->buf_cache_size = BUF_CACHE_SIZE << shift;
+	p_fs->buf_cache_hash_mask = (BUF_CACHE_HASH_SIZE << shift) - 1;
+	p_fs->extent_cache_size = EXTENT_CACHE_SIZE << shift;
+	p_fs->FAT_ra_start = p_fs->FAT_ra_end = 0;
+
+	/* one allocation for the entries and the hash heads of both caches */
+	p_fs->FAT_cache_array = vmalloc(sizeof(BUF_CACHE_T) *
+			(p_fs->FAT_cache_size + p_fs->FAT_cache_hash_mask + 1 +
+			 p_fs->buf_cache_size + p_fs->buf_cache_hash_mask + 1));
+	if (!p_fs->FAT_cache_array)
+		return FFS_MEMORYERR;
+
+	p_fs->FAT_cache_hash_list = p_fs->FAT_cache_array + p_fs->FAT_cache_size;
+	p_fs->buf_cache_array = p_fs->FAT_cache_hash_list + p_fs->FAT_cache_hash_mask + 1;
+	p_fs->buf_cache_hash_list = p_fs->buf_cache_array + p_fs->buf_cache_size;
+
 	/* LRU list */
 	p_fs->FAT_cache_lru_list.next = p_fs->FAT_cache_lru_list.prev = &p_fs->FAT_cache_lru_list;
 
-	for (i = 0; i < FAT_CACHE_SIZE; i++) {
+	for (i = 0; i < p_fs->FAT_cache_size; i++) {
 		p_fs->FAT_cache_array[i].drv = -1;
 		p_fs->FAT_cache_array[i].sec = ~0;
 		p_fs->FAT_cache_array[i].flag = 0;
@@ -91,7 +125,7 @@ s32 buf_init(struct super_block *sb)
 
 	p_fs->buf_cache_lru_list.next = p_fs->buf_cache_lru_list.prev = &p_fs->buf_cache_lru_list;
 
-	for (i = 0; i < BUF_CACHE_SIZE; i++) {
+	for (i = 0; i < p_fs->buf_cache_size; i++) {
 		p_fs->buf_cache_array[i].drv = -1;
 		p_fs->buf_cache_array[i].sec = ~0;
 		p_fs->buf_cache_array[i].flag = 0;
@@ -101,29 +135,40 @@ s32 buf_init(struct super_block *sb)
 	}
 
 	/* HASH list */
-	for (i = 0; i < FAT_CACHE_HASH_SIZE; i++) {
+	for (i = 0; i <= p_fs->FAT_cache_hash_mask; i++) {
 		p_fs->FAT_cache_hash_list[i].drv = -1;
 		p_fs->FAT_cache_hash_list[i].sec = ~0;
 		p_fs->FAT_cache_hash_list[i].hash_next = p_fs->FAT_cache_hash_list[i].hash_prev = &(p_fs->FAT_cache_hash_list[i]);
 	}
 
-	for (i = 0; i < FAT_CACHE_SIZE; i++)
+	for (i = 0; i < p_fs->FAT_cache_size; i++)
 		FAT_cache_insert_hash(sb, &(p_fs->FAT_cache_array[i]));
 
-	for (i = 0; i < BUF_CACHE_HASH_SIZE; i++) {
+	for (i = 0; i <= p_fs->buf_cache_hash_mask; i++) {
 		p_fs->buf_cache_hash_list[i].drv = -1;
 		p_fs->buf_cache_hash_list[i].sec = ~0;
 		p_fs->buf_cache_hash_list[i].hash_next = p_fs->buf_cache_hash_list[i].hash_prev = &(p_fs->buf_cache_hash_list[i]);
 	}
 
-	for (i = 0; i < BUF_CACHE_SIZE; i++)
+	for (i = 0; i < p_fs->buf_cache_size; i++)
 		buf_cache_insert_hash(sb, &(p_fs->buf_cache_array[i]));
 
+	dir_index_setup(sb);
+
 	return FFS_SUCCESS;
 } /* end of buf_init */
 
 s32 buf_shutdown(struct super_block *sb)
 {
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	/* the buffers are released by FAT_release_all and buf_release_all */
+	vfree(p_fs->FAT_cache_array);
+	p_fs->FAT_cache_array = NULL;
+	p_fs->FAT_cache_hash_list = NULL;
+	p_fs->buf_cache_array = NULL;
+	p_fs->buf_cache_hash_list = NULL;
+
 	return FFS_SUCCESS;
 } /* end of buf_shutdown */
 
@@ -416,6 +461,41 @@ u8 *FAT_getblk(struct super_block *sb, u32 sec)
 	return bp->buf_bh->b_data;
 } /* end of FAT_getblk */
 
+/* Read ahead the FAT sectors following the one holding the entry of loc,
+ * so that walking a long chain does not wait on every sector in turn.
+ */
+void FAT_readahead(struct super_block *sb, u32 loc)
+{
+	u32 sec, end, fat_end;
+	struct blk_plug plug;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+	BD_INFO_T *p_bd = &(EXFAT_SB(sb)->bd_info);
+
+	if (p_fs->vol_type == FAT12)
+		return;
+	else if (p_fs->vol_type == FAT16)
+		sec = p_fs->FAT1_start_sector + (loc >> (p_bd->sector_size_bits-1));
+	else
+		sec = p_fs->FAT1_start_sector + (loc >> (p_bd->sector_size_bits-2));
+
+	/* still inside the window read ahead last time */
+	if ((sec >= p_fs->FAT_ra_start) && (sec + 1 < p_fs->FAT_ra_end))
+		return;
+
+	fat_end = p_fs->FAT1_start_sector + p_fs->num_FAT_sectors;
+	end = min(sec + 1 + FAT_RA_SECTORS, fat_end);
+
+	p_fs->FAT_ra_start = sec;
+	p_fs->FAT_ra_end = end;
+
+	blk_start_plug(&plug);
+	for (sec++; sec < end; sec++) {
+		if (FAT_cache_find(sb, sec) == NULL)
+			__breadahead(sb->s_bdev, sec, p_bd->sector_size);
+	}
+	blk_finish_plug(&plug);
+} /* end of FAT_readahead */
+
 void FAT_modify(struct super_block *sb, u32 sec)
 {
 	BUF_CACHE_T *bp;
@@ -475,7 +555,7 @@ static BUF_CACHE_T *FAT_cache_find(struct super_block *sb, u32 sec)
 	BUF_CACHE_T *bp, *hp;
 	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
-	off = (sec + (sec >> p_fs->sectors_per_clu_bits)) & (FAT_CACHE_HASH_SIZE - 1);
+	off = (sec + (sec >> p_fs->sectors_per_clu_bits)) & p_fs->FAT_cache_hash_mask;
 
 	hp = &(p_fs->FAT_cache_hash_list[off]);
 	for (bp = hp->hash_next; bp != hp; bp = bp->hash_next) {
@@ -510,7 +590,7 @@ static void FAT_cache_insert_hash(struct super_block *sb, BUF_CACHE_T *bp)
 	FS_INFO_T *p_fs;
 
 	p_fs = &(EXFAT_SB(sb)->fs_info);
-	off = (bp->sec + (bp->sec >> p_fs->sectors_per_clu_bits)) & (FAT_CACHE_HASH_SIZE-1);
+	off = (bp->sec + (bp->sec >> p_fs->sectors_per_clu_bits)) & p_fs->FAT_cache_hash_mask;
 
 	hp = &(p_fs->FAT_cache_hash_list[off]);
 	bp->hash_next = hp->hash_next;
@@ -697,7 +777,7 @@ static BUF_CACHE_T *buf_cache_find(struct super_block *sb, u32 sec)
 	BUF_CACHE_T *bp, *hp;
 	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
-	off = (sec + (sec >> p_fs->sectors_per_clu_bits)) & (BUF_CACHE_HASH_SIZE - 1);
+	off = (sec + (sec >> p_fs->sectors_per_clu_bits)) & p_fs->buf_cache_hash_mask;
 
 	hp = &(p_fs->buf_cache_hash_list[off]);
 	for (bp = hp->hash_next; bp != hp; bp = bp->hash_next) {
@@ -730,7 +810,7 @@ static void buf_cache_insert_hash(struct super_block *sb, BUF_CACHE_T *bp)
 	FS_INFO_T *p_fs;
 
 	p_fs = &(EXFAT_SB(sb)->fs_info);
-	off = (bp->sec + (bp->sec >> p_fs->sectors_per_clu_bits)) & (BUF_CACHE_HASH_SIZE-1);
+	off = (bp->sec + (bp->sec >> p_fs->sectors_per_clu_bits)) & p_fs->buf_cache_hash_mask;
 
 	hp = &(p_fs->buf_cache_hash_list[off]);
 	bp->hash_next = hp->hash_next;
@@ -745,6 +825,645 @@ static void buf_cache_remove_hash(BUF_CACHE_T *bp)
 	(bp->hash_next)->hash_prev = bp->hash_prev;
 } /* end of buf_cache_remove_hash */
 
+/*======================================================================*/
+/*  Extent Cache Functions                                              */
+/*======================================================================*/
+
+/* A run of clusters of a file that are contiguous on the disk:
+ * file clusters fclus .. fclus+len-1 are at clu .. clu+len-1.
+ * Only used for files with a FAT chain, all calls are made with
+ * p_fs->v_sem held.
+ */
+struct exfat_extent {
+	struct list_head lru;
+	s32 fclus;
+	u32 clu;
+	s32 len;
+};
+
+s32 extent_cache_init(void)
+{
+	exfat_extent_cachep = kmem_cache_create("exfat_extent_cache",
+						sizeof(struct exfat_extent),
+						0, SLAB_RECLAIM_ACCOUNT, NULL);
+	if (exfat_extent_cachep == NULL)
+		return FFS_MEMORYERR;
+
+	return FFS_SUCCESS;
+} /* end of extent_cache_init */
+
+void extent_cache_shutdown(void)
+{
+	kmem_cache_destroy(exfat_extent_cachep);
+} /* end of extent_cache_shutdown */
+
+void extent_cache_inval(struct inode *inode)
+{
+	struct exfat_inode_info *ei = EXFAT_I(inode);
+	struct exfat_extent *ext, *tmp;
+
+	list_for_each_entry_safe(ext, tmp, &ei->extent_lru, lru) {
+		list_del(&ext->lru);
+		kmem_cache_free(exfat_extent_cachep, ext);
+	}
+	ei->nr_extents = 0;
+	ei->extent_start_clu = ei->fid.start_clu;
+} /* end of extent_cache_inval */
+
+/* The runs cached belong to the chain starting at extent_start_clu,
+ * a file removed or rewritten from scratch drops them here.
+ */
+static void extent_cache_check(struct inode *inode)
+{
+	struct exfat_inode_info *ei = EXFAT_I(inode);
+
+	if (ei->extent_start_clu != ei->fid.start_clu)
+		extent_cache_inval(inode);
+} /* end of extent_cache_check */
+
+/* in : inode, fclus
+  * out: cached_fclus, cached_clu
+  * returns 0 if a cached position at or before fclus, and beyond
+  *           cached_fclus on entry, was found
+  *            -1 otherwise
+  */
+s32 extent_cache_lookup(struct inode *inode, s32 fclus, s32 *cached_fclus, u32 *cached_clu)
+{
+	struct exfat_inode_info *ei = EXFAT_I(inode);
+	struct exfat_extent *ext, *best = NULL;
+	s32 off, best_off = *cached_fclus;
+
+	extent_cache_check(inode);
+
+	list_for_each_entry(ext, &ei->extent_lru, lru) {
+		if (ext->fclus > fclus)
+			continue;
+
+		off = min(fclus, ext->fclus + ext->len - 1);
+		if (off > best_off) {
+			best = ext;
+			best_off = off;
+			if (off == fclus)
+				break;
+		}
+	}
+
+	if (best == NULL)
+		return -1;
+
+	list_move(&best->lru, &ei->extent_lru);
+	*cached_fclus = best_off;
+	*cached_clu = best->clu + (best_off - best->fclus);
+
+	return 0;
+} /* end of extent_cache_lookup */
+
+void extent_cache_add(struct inode *inode, s32 fclus, u32 clu, s32 len)
+{
+	struct exfat_inode_info *ei = EXFAT_I(inode);
+	FS_INFO_T *p_fs = &(EXFAT_SB(inode->i_sb)->fs_info);
+	struct exfat_extent *ext;
+
+	extent_cache_check(inode);
+
+	list_for_each_entry(ext, &ei->extent_lru, lru) {
+		/* the same run, seen from another starting point */
+		if ((ext->fclus - fclus) == (s32)(ext->clu - clu) &&
+		    (fclus <= ext->fclus + ext->len) &&
+		    (ext->fclus <= fclus + len)) {
+			if (fclus + len > ext->fclus + ext->len)
+				ext->len = fclus + len - ext->fclus;
+			if (fclus < ext->fclus) {
+				ext->len += ext->fclus - fclus;
+				ext->fclus = fclus;
+				ext->clu = clu;
+			}
+			list_move(&ext->lru, &ei->extent_lru);
+			return;
+		}
+	}
+
+	if (ei->nr_extents >= p_fs->extent_cache_size) {
+		/* reuse the least recently used */
+		ext = list_entry(ei->extent_lru.prev, struct exfat_extent, lru);
+		list_del(&ext->lru);
+	} else {
+		ext = kmem_cache_alloc(exfat_extent_cachep, GFP_NOFS);
+		if (ext == NULL)
+			return;
+		ei->nr_extents++;
+	}
+
+	ext->fclus = fclus;
+	ext->clu = clu;
+	ext->len = len;
+	list_add(&ext->lru, &ei->extent_lru);
+} /* end of extent_cache_add */
+
+#ifdef CONFIG_EXFAT_DIR_INDEX
+/*======================================================================*/
+/*  Directory Index Functions                                           */
+/*======================================================================*/
+
+/* The names of a large directory, hashed by the checksum of their
+ * upcased form that nls_cstring_to_uniname() computes for a lookup, and
+ * by entry position for updates. A name found in the index is compared
+ * with the entries on the disk before it is returned, a name not found
+ * is not in the directory. Only exFAT volumes are indexed, all calls
+ * are made with p_fs->v_sem held.
+ */
+struct exfat_dir_name {
+	struct hlist_node by_name;
+	struct hlist_node by_entry;
+	s32 entry;
+	u16 name_hash;
+	u16 name_len;
+};
+
+struct exfat_dir_index {
+	struct hlist_node hash;
+	struct list_head lru;
+	u32 dir;
+	u32 mask;
+	u32 nr_names;
+	u32 bytes;
+	s32 free_entry;         /* entries from here on are unused, -1 if unknown */
+	CHAIN_T free_clu;       /* cluster holding free_entry */
+	struct hlist_head *names;       /* mask+1 by name, then mask+1 by entry */
+};
+
+#define DIR_INDEX_MIN_BUCKETS   64
+#define DIR_INDEX_MAX_BUCKETS   1024
+#define DIR_INDEX_MAX_BYTES     (CONFIG_EXFAT_DIR_INDEX_MAX_KB << 10)
+
+static struct kmem_cache *exfat_dir_name_cachep;
+
+s32 dir_index_init(void)
+{
+	exfat_dir_name_cachep = kmem_cache_create("exfat_dir_name",
+						  sizeof(struct exfat_dir_name),
+						  0, SLAB_RECLAIM_ACCOUNT, NULL);
+	if (exfat_dir_name_cachep == NULL)
+		return FFS_MEMORYERR;
+
+	return FFS_SUCCESS;
+} /* end of dir_index_init */
+
+void dir_index_shutdown(void)
+{
+	kmem_cache_destroy(exfat_dir_name_cachep);
+} /* end of dir_index_shutdown */
+
+void dir_index_setup(struct super_block *sb)
+{
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+	int i;
+
+	for (i = 0; i < DIR_INDEX_HASH_SIZE; i++)
+		INIT_HLIST_HEAD(&p_fs->dir_index_hash[i]);
+	INIT_LIST_HEAD(&p_fs->dir_index_lru);
+
+	p_fs->dir_index_count = 0;
+	p_fs->dir_index_names = 0;
+	p_fs->dir_index_bytes = 0;
+} /* end of dir_index_setup */
+
+static struct exfat_dir_index *dir_index_find(FS_INFO_T *p_fs, u32 dir)
+{
+	struct exfat_dir_index *di;
+	struct hlist_node *pos;
+
+	hlist_for_each_entry(di, pos, &p_fs->dir_index_hash[dir & (DIR_INDEX_HASH_SIZE-1)], hash) {
+		if (di->dir == dir)
+			return di;
+	}
+	return NULL;
+} /* end of dir_index_find */
+
+static void dir_index_free(FS_INFO_T *p_fs, struct exfat_dir_index *di)
+{
+	struct exfat_dir_name *dn;
+	struct hlist_node *pos, *n;
+	u32 i;
+
+	for (i = 0; i <= di->mask; i++) {
+		hlist_for_each_entry_safe(dn, pos, n, &di->names[i], by_name)
+			kmem_cache_free(exfat_dir_name_cachep, dn);
+	}
+
+	hlist_del(&di->hash);
+	list_del(&di->lru);
+	p_fs->dir_index_count--;
+	p_fs->dir_index_names -= di->nr_names;
+	p_fs->dir_index_bytes -= di->bytes;
+
+	kfree(di->names);
+	kfree(di);
+} /* end of dir_index_free */
+
+void dir_index_release_all(struct super_block *sb)
+{
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	while (!list_empty(&p_fs->dir_index_lru))
+		dir_index_free(p_fs, list_entry(p_fs->dir_index_lru.next,
+						struct exfat_dir_index, lru));
+} /* end of dir_index_release_all */
+
+void dir_index_drop(struct super_block *sb, u32 dir)
+{
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+	struct exfat_dir_index *di;
+
+	di = dir_index_find(p_fs, dir);
+	if (di)
+		dir_index_free(p_fs, di);
+} /* end of dir_index_drop */
+
+/* drop the least recently used indexes while over the limit */
+static void dir_index_shrink(FS_INFO_T *p_fs)
+{
+	while ((p_fs->dir_index_bytes > DIR_INDEX_MAX_BYTES) &&
+	       !list_empty(&p_fs->dir_index_lru))
+		dir_index_free(p_fs, list_entry(p_fs->dir_index_lru.prev,
+						struct exfat_dir_index, lru));
+} /* end of dir_index_shrink */
+
+static s32 dir_index_resize(FS_INFO_T *p_fs, struct exfat_dir_index *di, u32 size)
+{
+	struct hlist_head *names;
+	struct exfat_dir_name *dn;
+	struct hlist_node *pos, *n;
+	u32 i;
+
+	names = kmalloc(2 * size * sizeof(struct hlist_head), GFP_NOFS);
+	if (names == NULL)
+		return -1;
+
+	for (i = 0; i < 2 * size; i++)
+		INIT_HLIST_HEAD(&names[i]);
+
+	for (i = 0; di->names && (i <= di->mask); i++) {
+		hlist_for_each_entry_safe(dn, pos, n, &di->names[i], by_name) {
+			hlist_del(&dn->by_name);
+			hlist_del(&dn->by_entry);
+			hlist_add_head(&dn->by_name, &names[dn->name_hash & (size-1)]);
+			hlist_add_head(&dn->by_entry, &names[size + (dn->entry & (size-1))]);
+		}
+	}
+
+	if (di->names) {
+		kfree(di->names);
+		di->bytes -= 2 * (di->mask + 1) * sizeof(struct hlist_head);
+		p_fs->dir_index_bytes -= 2 * (di->mask + 1) * sizeof(struct hlist_head);
+	}
+	di->names = names;
+	di->mask = size - 1;
+	di->bytes += 2 * size * sizeof(struct hlist_head);
+	p_fs->dir_index_bytes += 2 * size * sizeof(struct hlist_head);
+
+	return 0;
+} /* end of dir_index_resize */
+
+static s32 dir_index_insert(FS_INFO_T *p_fs, struct exfat_dir_index *di,
+			    s32 entry, u16 name_hash, u16 name_len)
+{
+	struct exfat_dir_name *dn;
+
+	dn = kmem_cache_alloc(exfat_dir_name_cachep, GFP_NOFS);
+	if (dn == NULL)
+		return -1;
+
+	dn->entry = entry;
+	dn->name_hash = name_hash;
+	dn->name_len = name_len;
+	hlist_add_head(&dn->by_name, &di->names[name_hash & di->mask]);
+	hlist_add_head(&dn->by_entry, &di->names[di->mask + 1 + (entry & di->mask)]);
+
+	di->nr_names++;
+	di->bytes += sizeof(struct exfat_dir_name);
+	p_fs->dir_index_names++;
+	p_fs->dir_index_bytes += sizeof(struct exfat_dir_name);
+
+	/* keep the chains short, a failure only makes them longer */
+	if ((di->nr_names > 2 * (di->mask + 1)) &&
+	    (di->mask + 1 < DIR_INDEX_MAX_BUCKETS))
+		dir_index_resize(p_fs, di, 2 * (di->mask + 1));
+
+	return 0;
+} /* end of dir_index_insert */
+
+static void dir_index_unlink(FS_INFO_T *p_fs, struct exfat_dir_index *di, s32 entry)
+{
+	struct exfat_dir_name *dn;
+	struct hlist_node *pos, *n;
+
+	hlist_for_each_entry_safe(dn, pos, n, &di->names[di->mask + 1 + (entry & di->mask)], by_entry) {
+		if (dn->entry != entry)
+			continue;
+
+		hlist_del(&dn->by_name);
+		hlist_del(&dn->by_entry);
+		kmem_cache_free(exfat_dir_name_cachep, dn);
+
+		di->nr_names--;
+		di->bytes -= sizeof(struct exfat_dir_name);
+		p_fs->dir_index_names--;
+		p_fs->dir_index_bytes -= sizeof(struct exfat_dir_name);
+	}
+} /* end of dir_index_unlink */
+
+/* returns 1 if the names match, 0 if not, -1 on error */
+static s32 dir_index_match(struct super_block *sb, CHAIN_T *p_dir, s32 entry,
+			   UNI_NAME_T *p_uniname, u32 type)
+{
+	int i, len, num_ext_entries;
+	s32 ret;
+	u32 entry_type;
+	u16 entry_uniname[16], *uniname = p_uniname->name, unichar;
+	DENTRY_T *ep;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	ep = get_entry_in_dir(sb, p_dir, entry, NULL);
+	if (!ep)
+		return -1;
+
+	entry_type = p_fs->fs_func->get_entry_type(ep);
+	if ((entry_type != TYPE_FILE) && (entry_type != TYPE_DIR))
+		return 0;
+	if ((type != TYPE_ALL) && (type != entry_type))
+		return 0;
+
+	num_ext_entries = ((FILE_DENTRY_T *) ep)->num_ext;
+	if (num_ext_entries < 2)
+		return 0;
+
+	ep = get_entry_in_dir(sb, p_dir, entry+1, NULL);
+	if (!ep)
+		return -1;
+
+	if ((p_fs->fs_func->get_entry_type(ep) != TYPE_STREAM) ||
+	    (((STRM_DENTRY_T *) ep)->name_len != p_uniname->name_len))
+		return 0;
+
+	for (i = 2; i <= num_ext_entries; i++) {
+		ep = get_entry_in_dir(sb, p_dir, entry+i, NULL);
+		if (!ep)
+			return -1;
+
+		if (p_fs->fs_func->get_entry_type(ep) != TYPE_EXTEND)
+			return 0;
+
+		len = extract_uni_name_from_name_entry((NAME_DENTRY_T *) ep, entry_uniname, i);
+
+		unichar = *(uniname+len);
+		*(uniname+len) = 0x0;
+
+		ret = nls_uniname_cmp(sb, uniname, entry_uniname);
+
+		*(uniname+len) = unichar;
+
+		if (ret)
+			return 0;
+		uniname += 15;
+	}
+
+	return 1;
+} /* end of dir_index_match */
+
+/* in : sb, p_dir, p_uniname, type
+  * out: dentry, as returned by exfat_find_dir_entry()
+  * returns 0 if the directory is indexed
+  *            -1 otherwise
+  */
+s32 dir_index_lookup(struct super_block *sb, CHAIN_T *p_dir, UNI_NAME_T *p_uniname, u32 type, s32 *dentry)
+{
+	s32 ret;
+	struct exfat_dir_index *di;
+	struct exfat_dir_name *dn;
+	struct hlist_node *pos;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	di = dir_index_find(p_fs, p_dir->dir);
+	if (di == NULL)
+		return -1;
+
+	list_move(&di->lru, &p_fs->dir_index_lru);
+
+	hlist_for_each_entry(dn, pos, &di->names[p_uniname->name_hash & di->mask], by_name) {
+		if ((dn->name_hash != p_uniname->name_hash) ||
+		    (dn->name_len != p_uniname->name_len))
+			continue;
+
+		ret = dir_index_match(sb, p_dir, dn->entry, p_uniname, type);
+		if (ret == 0)
+			continue;
+
+		p_fs->hint_uentry.dir = CLUSTER_32(~0);
+		p_fs->hint_uentry.entry = -1;
+		*dentry = (ret > 0) ? dn->entry : -2;
+		return 0;
+	}
+
+	/* not there, a create will go to the end of the directory */
+	if (di->free_entry >= 0) {
+		p_fs->hint_uentry.dir = p_dir->dir;
+		p_fs->hint_uentry.entry = di->free_entry;
+		p_fs->hint_uentry.clu.dir = di->free_clu.dir;
+		p_fs->hint_uentry.clu.size = di->free_clu.size;
+		p_fs->hint_uentry.clu.flags = di->free_clu.flags;
+	} else {
+		p_fs->hint_uentry.dir = CLUSTER_32(~0);
+		p_fs->hint_uentry.entry = -1;
+	}
+
+	*dentry = -2;
+	return 0;
+} /* end of dir_index_lookup */
+
+/* Called after a lookup had to scan many entries of p_dir */
+void dir_index_build(struct super_block *sb, CHAIN_T *p_dir)
+{
+	int i, k, len;
+	s32 dentry = 0, file_entry = 0, num_ext_entries = 0, order = 0;
+	s32 is_feasible_entry = FALSE;
+	u32 entry_type, name_len = 0, hashed = 0;
+	u16 name_hash = 0, entry_uniname[16], upname;
+	CHAIN_T clu;
+	DENTRY_T *ep;
+	struct exfat_dir_index *di;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	if ((p_fs->vol_type != EXFAT) || (dir_index_find(p_fs, p_dir->dir) != NULL))
+		return;
+
+	di = kzalloc(sizeof(struct exfat_dir_index), GFP_NOFS);
+	if (di == NULL)
+		return;
+
+	di->dir = p_dir->dir;
+	di->free_entry = -1;
+	di->bytes = sizeof(struct exfat_dir_index);
+	hlist_add_head(&di->hash, &p_fs->dir_index_hash[di->dir & (DIR_INDEX_HASH_SIZE-1)]);
+	list_add(&di->lru, &p_fs->dir_index_lru);
+	p_fs->dir_index_count++;
+	p_fs->dir_index_bytes += di->bytes;
+
+	if (dir_index_resize(p_fs, di, DIR_INDEX_MIN_BUCKETS))
+		goto fail;
+
+	clu.dir = p_dir->dir;
+	clu.size = p_dir->size;
+	clu.flags = p_dir->flags;
+
+	while (clu.dir != CLUSTER_32(~0)) {
+		if (p_fs->dev_ejected)
+			goto fail;
+
+		for (i = 0; i < p_fs->dentries_per_clu; i++, dentry++) {
+			ep = get_entry_in_dir(sb, &clu, i, NULL);
+			if (!ep)
+				goto fail;
+
+			entry_type = p_fs->fs_func->get_entry_type(ep);
+
+			if (entry_type == TYPE_UNUSED) {
+				di->free_entry = dentry;
+				di->free_clu.dir = clu.dir;
+				di->free_clu.size = clu.size;
+				di->free_clu.flags = clu.flags;
+				goto out;
+			} else if ((entry_type == TYPE_FILE) || (entry_type == TYPE_DIR)) {
+				file_entry = dentry;
+				num_ext_entries = ((FILE_DENTRY_T *) ep)->num_ext;
+				is_feasible_entry = TRUE;
+				order = 0;
+			} else if ((entry_type == TYPE_STREAM) && is_feasible_entry) {
+				name_len = ((STRM_DENTRY_T *) ep)->name_len;
+				name_hash = 0;
+				hashed = 0;
+				order = 1;
+			} else if ((entry_type == TYPE_EXTEND) && is_feasible_entry && order) {
+				len = extract_uni_name_from_name_entry((NAME_DENTRY_T *) ep, entry_uniname, ++order);
+
+				for (k = 0; (k < len) && (hashed < name_len); k++, hashed++) {
+					SET16_A(&upname, nls_upper(sb, entry_uniname[k]));
+					name_hash = calc_checksum_2byte((void *) &upname, 2, name_hash, CS_DEFAULT);
+				}
+
+				if (order == num_ext_entries) {
+					if (dir_index_insert(p_fs, di, file_entry, name_hash, name_len))
+						goto fail;
+					is_feasible_entry = FALSE;
+				}
+			} else {
+				is_feasible_entry = FALSE;
+			}
+		}
+
+		if (clu.flags == 0x03) {
+			if ((--clu.size) > 0)
+				clu.dir++;
+			else
+				clu.dir = CLUSTER_32(~0);
+		} else {
+			if (FAT_read(sb, clu.dir, &(clu.dir)) != 0)
+				goto fail;
+		}
+	}
+
+out:
+	dir_index_shrink(p_fs);
+	return;
+
+fail:
+	dir_index_free(p_fs, di);
+} /* end of dir_index_build */
+
+static void dir_index_advance_free(struct super_block *sb, struct exfat_dir_index *di, s32 end)
+{
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+	s32 clu_mask = ~(p_fs->dentries_per_clu - 1);
+
+	/* the entries written may end in the next cluster */
+	while ((di->free_entry & clu_mask) != (end & clu_mask)) {
+		if (di->free_clu.flags == 0x03) {
+			if ((--di->free_clu.size) > 0)
+				di->free_clu.dir++;
+			else
+				di->free_clu.dir = CLUSTER_32(~0);
+		} else {
+			if (FAT_read(sb, di->free_clu.dir, &(di->free_clu.dir)) != 0)
+				di->free_clu.dir = CLUSTER_32(~0);
+		}
+
+		if (di->free_clu.dir == CLUSTER_32(~0)) {
+			di->free_entry = -1;
+			return;
+		}
+		di->free_entry = (di->free_entry & clu_mask) + p_fs->dentries_per_clu;
+	}
+
+	di->free_entry = end;
+} /* end of dir_index_advance_free */
+
+/* Called when the name entries of entry are written */
+void dir_index_add(struct super_block *sb, CHAIN_T *p_dir, s32 entry, s32 num_entries, UNI_NAME_T *p_uniname)
+{
+	struct exfat_dir_index *di;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	di = dir_index_find(p_fs, p_dir->dir);
+	if (di == NULL)
+		return;
+
+	dir_index_unlink(p_fs, di, entry);
+	if (dir_index_insert(p_fs, di, entry, p_uniname->name_hash, p_uniname->name_len)) {
+		dir_index_free(p_fs, di);
+		return;
+	}
+
+	if ((di->free_entry >= 0) && (entry + num_entries > di->free_entry))
+		dir_index_advance_free(sb, di, entry + num_entries);
+
+	dir_index_shrink(p_fs);
+} /* end of dir_index_add */
+
+/* Called when entry is deleted */
+void dir_index_remove(struct super_block *sb, CHAIN_T *p_dir, s32 entry)
+{
+	struct exfat_dir_index *di;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	di = dir_index_find(p_fs, p_dir->dir);
+	if (di)
+		dir_index_unlink(p_fs, di, entry);
+} /* end of dir_index_remove */
+
+/* Called when p_dir got the cluster p_clu appended */
+void dir_index_grow(struct super_block *sb, CHAIN_T *p_dir, CHAIN_T *p_clu)
+{
+	struct exfat_dir_index *di;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	di = dir_index_find(p_fs, p_dir->dir);
+	if (di == NULL)
+		return;
+
+	if (di->free_entry < 0) {
+		di->free_entry = (p_dir->size - 1) << (p_fs->cluster_size_bits - DENTRY_SIZE_BITS);
+		di->free_clu.dir = p_clu->dir;
+		di->free_clu.size = 1;
+		di->free_clu.flags = p_clu->flags;
+	} else if (di->free_clu.flags != p_dir->flags) {
+		/* the directory got a FAT chain */
+		di->free_clu.flags = p_dir->flags;
+	} else if (p_dir->flags == 0x03) {
+		di->free_clu.size++;
+	}
+} /* end of dir_index_grow */
+#endif /* CONFIG_EXFAT_DIR_INDEX */
+
 /*======================================================================*/
 /*  Local Function Definitions                                          */
 /*======================================================================*/
@@ -70,6 +70,7 @@ s32  buf_init(struct super_block *sb);
 s32  buf_shutdown(struct super_block *sb);
 s32  FAT_read(struct super_block *sb, u32 loc, u32 *content);
 s32  FAT_write(struct super_block *sb, u32 loc, u32 content);
+void   FAT_readahead(struct super_block *sb, u32 loc);
 u8 *FAT_getblk(struct super_block *sb, u32 sec);
 void   FAT_modify(struct super_block *sb, u32 sec);
 void   FAT_release_all(struct super_block *sb);
@@ -82,4 +83,10 @@ void   buf_release(struct super_block *sb, u32 sec);
 void   buf_release_all(struct super_block *sb);
 void   buf_sync(struct super_block *sb);
 
+s32  extent_cache_init(void);
+void   extent_cache_shutdown(void);
+s32  extent_cache_lookup(struct inode *inode, s32 fclus, s32 *cached_fclus, u32 *cached_clu);
+void   extent_cache_add(struct inode *inode, s32 fclus, u32 clu, s32 len);
+void   extent_cache_inval(struct inode *inode);
+
 #endif /* _EXFAT_CACHE_H */
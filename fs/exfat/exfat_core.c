@@ -138,6 +138,14 @@ s32 ffsInit(void)
 	if (ret)
 		return ret;
 
+	ret = extent_cache_init();
+	if (ret)
+		return ret;
+
+	ret = dir_index_init();
+	if (ret)
+		return ret;
+
 	return FFS_SUCCESS;
 } /* end of ffsInit */
 
@@ -145,6 +153,10 @@ s32 ffsInit(void)
 s32 ffsShutdown(void)
 {
 	s32 ret;
+
+	extent_cache_shutdown();
+	dir_index_shutdown();
+
 	ret = fs_shutdown();
 	if (ret)
 		return ret;
@@ -258,6 +270,7 @@ s32 ffsUmountVol(struct super_block *sb)
 		free_alloc_bitmap(sb);
 	}
 
+	dir_index_release_all(sb);
 	FAT_release_all(sb);
 	buf_release_all(sb);
 
@@ -824,6 +837,7 @@ s32 ffsTruncateFile(struct inode *inode, u64 old_size, u64 new_size)
 
 	/* hint information */
 	fid->hint_last_off = -1;
+	extent_cache_inval(inode);
 	if (fid->rwoffset > fid->size)
 		fid->rwoffset = fid->size;
 
@@ -1285,7 +1299,8 @@ s32 ffsSetStat(struct inode *inode, DIR_ENTRY_T *info)
 s32 ffsMapCluster(struct inode *inode, s32 clu_offset, u32 *clu)
 {
 	s32 num_clusters, num_alloced, modified = FALSE;
-	u32 last_clu, sector = 0;
+	s32 fclus = 0, run_fclus;
+	u32 last_clu, run_clu, sector = 0;
 	CHAIN_T new_clu;
 	DENTRY_T *ep;
 	ENTRY_SET_CACHE_T *es = NULL;
@@ -1305,6 +1320,7 @@ s32 ffsMapCluster(struct inode *inode, s32 clu_offset, u32 *clu)
 	if (fid->flags == 0x03) {
 		if ((clu_offset > 0) && (*clu != CLUSTER_32(~0))) {
 			last_clu += clu_offset - 1;
+			fclus = clu_offset;
 
 			if (clu_offset == num_clusters)
 				*clu = CLUSTER_32(~0);
@@ -1315,16 +1331,34 @@ s32 ffsMapCluster(struct inode *inode, s32 clu_offset, u32 *clu)
 		/* hint information */
 		if ((clu_offset > 0) && (fid->hint_last_off > 0) &&
 			(clu_offset >= fid->hint_last_off)) {
-			clu_offset -= fid->hint_last_off;
+			fclus = fid->hint_last_off;
 			*clu = fid->hint_last_clu;
 		}
 
-		while ((clu_offset > 0) && (*clu != CLUSTER_32(~0))) {
+		/* a cached run may get closer than the hint */
+		if (*clu != CLUSTER_32(~0))
+			extent_cache_lookup(inode, clu_offset, &fclus, clu);
+
+		run_fclus = fclus;
+		run_clu = *clu;
+
+		while ((clu_offset > fclus) && (*clu != CLUSTER_32(~0))) {
+			if (clu_offset - fclus >= FAT_RA_MIN_HOPS)
+				FAT_readahead(sb, *clu);
+
 			last_clu = *clu;
 			if (FAT_read(sb, *clu, clu) == -1)
 				return FFS_MEDIAERR;
-			clu_offset--;
+			fclus++;
+
+			if (*clu != last_clu + 1) {
+				run_fclus = fclus;
+				run_clu = *clu;
+			}
 		}
+
+		if ((*clu != CLUSTER_32(~0)) && (fclus > 0))
+			extent_cache_add(inode, run_fclus, run_clu, fclus - run_fclus + 1);
 	}
 
 	if (*clu == CLUSTER_32(~0)) {
@@ -1360,6 +1394,9 @@ s32 ffsMapCluster(struct inode *inode, s32 clu_offset, u32 *clu)
 		num_clusters += num_alloced;
 		*clu = new_clu.dir;
 
+		if (fid->flags == 0x01)
+			extent_cache_add(inode, fclus, *clu, 1);
+
 		if (p_fs->vol_type == EXFAT) {
 			es = get_entry_set_in_dir(sb, &(fid->dir), fid->entry, ES_ALL_ENTRIES, &ep);
 			if (es == NULL)
@@ -1646,6 +1683,7 @@ s32 ffsRemoveDir(struct inode *inode, FILE_ID_T *fid)
 
 	/* (2) free the clusters */
 	p_fs->fs_func->free_cluster(sb, &clu_to_free, 1);
+	dir_index_drop(sb, clu_to_free.dir);
 
 	fid->size = 0;
 	fid->start_clu = CLUSTER_32(~0);
@@ -2947,6 +2985,8 @@ s32 exfat_init_ext_entry(struct super_block *sb, CHAIN_T *p_dir, s32 entry, s32
 
 	update_dir_checksum(sb, p_dir, entry);
 
+	dir_index_add(sb, p_dir, entry, num_entries, p_uniname);
+
 	return FFS_SUCCESS;
 } /* end of exfat_init_ext_entry */
 
@@ -3077,6 +3117,9 @@ void exfat_delete_dir_entry(struct super_block *sb, CHAIN_T *p_dir, s32 entry, s
 	DENTRY_T *ep;
 	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
 
+	if (order == 0)
+		dir_index_remove(sb, p_dir, entry);
+
 	for (i = order; i < num_entries; i++) {
 		ep = get_entry_in_dir(sb, p_dir, entry+i, &sector);
 		if (!ep)
@@ -3633,6 +3676,8 @@ s32 find_empty_entry(struct inode *inode, CHAIN_T *p_dir, s32 num_entries)
 		p_fs->hint_uentry.clu.size++;
 		p_dir->size++;
 
+		dir_index_grow(sb, p_dir, &clu);
+
 		/* (3) update the directory entry */
 		if (p_fs->vol_type == EXFAT) {
 			if (p_dir->dir != p_fs->root_dir) {
@@ -3776,6 +3821,9 @@ s32 exfat_find_dir_entry(struct super_block *sb, CHAIN_T *p_dir, UNI_NAME_T *p_u
 			return -1; // special case, root directory itself
 	}
 
+	if (!dir_index_lookup(sb, p_dir, p_uniname, type, &dentry))
+		return dentry;
+
 	if (p_dir->dir == CLUSTER_32(0)) /* FAT16 root_dir */
 		dentries_per_clu = p_fs->dentries_in_root;
 	else
@@ -3815,7 +3863,7 @@ s32 exfat_find_dir_entry(struct super_block *sb, CHAIN_T *p_dir, UNI_NAME_T *p_u
 				}
 
 				if (entry_type == TYPE_UNUSED)
-					return -2;
+					goto not_found;
 			} else {
 				num_empty = 0;
 
@@ -3855,6 +3903,9 @@ s32 exfat_find_dir_entry(struct super_block *sb, CHAIN_T *p_dir, UNI_NAME_T *p_u
 						} else if (order == num_ext_entries) {
 							p_fs->hint_uentry.dir = CLUSTER_32(~0);
 							p_fs->hint_uentry.entry = -1;
+
+							if (dentry >= DIR_INDEX_MIN_DENTRIES)
+								dir_index_build(sb, p_dir);
 							return dentry - (num_ext_entries);
 						}
 
@@ -3880,6 +3931,10 @@ s32 exfat_find_dir_entry(struct super_block *sb, CHAIN_T *p_dir, UNI_NAME_T *p_u
 		}
 	}
 
+not_found:
+	if (dentry >= DIR_INDEX_MIN_DENTRIES)
+		dir_index_build(sb, p_dir);
+
 	return -2;
 } /* end of exfat_find_dir_entry */
 
@@ -4693,6 +4748,9 @@ s32 create_dir(struct inode *inode, CHAIN_T *p_dir, UNI_NAME_T *p_uniname, FILE_
 	else if (ret == 0)
 		return FFS_FULL;
 
+	/* the cluster may have held a directory before */
+	dir_index_drop(sb, clu.dir);
+
 	ret = clear_cluster(sb, clu.dir);
 	if (ret != FFS_SUCCESS)
 		return ret;
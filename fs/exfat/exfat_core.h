@@ -486,14 +486,31 @@ typedef struct __FS_INFO_T {
 	struct semaphore v_sem;
 
 	/* FAT cache */
-	BUF_CACHE_T FAT_cache_array[FAT_CACHE_SIZE];
+	u32      FAT_cache_size;
+	u32      FAT_cache_hash_mask;
+	BUF_CACHE_T *FAT_cache_array;
 	BUF_CACHE_T FAT_cache_lru_list;
-	BUF_CACHE_T FAT_cache_hash_list[FAT_CACHE_HASH_SIZE];
+	BUF_CACHE_T *FAT_cache_hash_list;
+	u32      FAT_ra_start;           /* FAT sectors last read ahead */
+	u32      FAT_ra_end;
 
 	/* buf cache */
-	BUF_CACHE_T buf_cache_array[BUF_CACHE_SIZE];
+	u32      buf_cache_size;
+	u32      buf_cache_hash_mask;
+	BUF_CACHE_T *buf_cache_array;
 	BUF_CACHE_T buf_cache_lru_list;
-	BUF_CACHE_T buf_cache_hash_list[BUF_CACHE_HASH_SIZE];
+	BUF_CACHE_T *buf_cache_hash_list;
+
+	u32      extent_cache_size;      /* max cluster runs per inode */
+
+#ifdef CONFIG_EXFAT_DIR_INDEX
+	/* name indexes of large directories, by start cluster */
+	struct hlist_head dir_index_hash[DIR_INDEX_HASH_SIZE];
+	struct list_head dir_index_lru;
+	u32      dir_index_count;
+	u32      dir_index_names;
+	u32      dir_index_bytes;
+#endif
 } FS_INFO_T;
 
 #define ES_2_ENTRIES		2
@@ -626,6 +643,33 @@ s32  search_deleted_or_unused_entry(struct super_block *sb, CHAIN_T *p_dir, s32
 s32  find_empty_entry(struct inode *inode, CHAIN_T *p_dir, s32 num_entries);
 s32  fat_find_dir_entry(struct super_block *sb, CHAIN_T *p_dir, UNI_NAME_T *p_uniname, s32 num_entries, DOS_NAME_T *p_dosname, u32 type);
 s32  exfat_find_dir_entry(struct super_block *sb, CHAIN_T *p_dir, UNI_NAME_T *p_uniname, s32 num_entries, DOS_NAME_T *p_dosname, u32 type);
+
+/* directory index functions (exfat_cache.c) */
+#ifdef CONFIG_EXFAT_DIR_INDEX
+s32  dir_index_init(void);
+void dir_index_shutdown(void);
+void dir_index_setup(struct super_block *sb);
+void dir_index_release_all(struct super_block *sb);
+s32  dir_index_lookup(struct super_block *sb, CHAIN_T *p_dir, UNI_NAME_T *p_uniname, u32 type, s32 *dentry);
+void dir_index_build(struct super_block *sb, CHAIN_T *p_dir);
+void dir_index_add(struct super_block *sb, CHAIN_T *p_dir, s32 entry, s32 num_entries, UNI_NAME_T *p_uniname);
+void dir_index_remove(struct super_block *sb, CHAIN_T *p_dir, s32 entry);
+void dir_index_grow(struct super_block *sb, CHAIN_T *p_dir, CHAIN_T *p_clu);
+void dir_index_drop(struct super_block *sb, u32 dir);
+#else
+static inline s32 dir_index_init(void) { return FFS_SUCCESS; }
+static inline void dir_index_shutdown(void) {}
+static inline void dir_index_setup(struct super_block *sb) {}
+static inline void dir_index_release_all(struct super_block *sb) {}
+static inline s32 dir_index_lookup(struct super_block *sb, CHAIN_T *p_dir,
+		UNI_NAME_T *p_uniname, u32 type, s32 *dentry) { return -1; }
+static inline void dir_index_build(struct super_block *sb, CHAIN_T *p_dir) {}
+static inline void dir_index_add(struct super_block *sb, CHAIN_T *p_dir, s32 entry,
+		s32 num_entries, UNI_NAME_T *p_uniname) {}
+static inline void dir_index_remove(struct super_block *sb, CHAIN_T *p_dir, s32 entry) {}
+static inline void dir_index_grow(struct super_block *sb, CHAIN_T *p_dir, CHAIN_T *p_clu) {}
+static inline void dir_index_drop(struct super_block *sb, u32 dir) {}
+#endif
 s32  fat_count_ext_entries(struct super_block *sb, CHAIN_T *p_dir, s32 entry, DENTRY_T *p_entry);
 s32  exfat_count_ext_entries(struct super_block *sb, CHAIN_T *p_dir, s32 entry, DENTRY_T *p_entry);
 s32  count_dos_name_entries(struct super_block *sb, CHAIN_T *p_dir, u32 type);
@@ -50,9 +50,23 @@
 
 /* cache size (in number of sectors)                */
 /* (should be an exponential value of 2)            */
+/* doubled for every power of two of 256MB of RAM,  */
+/* up to CACHE_SCALE_MAX times                      */
 #define FAT_CACHE_SIZE          128
 #define FAT_CACHE_HASH_SIZE     64
 #define BUF_CACHE_SIZE          256
 #define BUF_CACHE_HASH_SIZE     64
+#define CACHE_SCALE_MAX         3
+
+/* cluster runs cached per inode, scaled like above */
+#define EXTENT_CACHE_SIZE       8
+
+/* FAT sectors read ahead when walking a long chain */
+#define FAT_RA_SECTORS          16
+#define FAT_RA_MIN_HOPS         8
+
+/* directories indexed once a lookup scanned this many entries */
+#define DIR_INDEX_MIN_DENTRIES  256
+#define DIR_INDEX_HASH_SIZE     16
 
 #endif /* _EXFAT_DATA_H */
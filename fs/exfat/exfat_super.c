@@ -57,6 +57,7 @@
 #include <linux/smp_lock.h>
 #endif
 #include <linux/seq_file.h>
+#include <linux/proc_fs.h>
 #include <linux/pagemap.h>
 #include <linux/mpage.h>
 #include <linux/buffer_head.h>
@@ -1893,6 +1894,8 @@ static void exfat_destroy_inode(struct inode *inode)
 		kfree(EXFAT_I(inode)->target);
 	EXFAT_I(inode)->target = NULL;
 
+	extent_cache_inval(inode);
+
 	kmem_cache_free(exfat_inode_cachep, EXFAT_I(inode));
 }
 
@@ -1963,9 +1966,45 @@ static void exfat_free_super(struct exfat_sb_info *sbi)
 	kfree(sbi);
 }
 
+#ifdef CONFIG_EXFAT_DIR_INDEX
+static struct proc_dir_entry *exfat_proc_root;
+
+static int exfat_dir_index_show(struct seq_file *m, void *v)
+{
+	struct super_block *sb = m->private;
+	FS_INFO_T *p_fs = &(EXFAT_SB(sb)->fs_info);
+
+	seq_printf(m, "dir_index_dirs: %u\n", p_fs->dir_index_count);
+	seq_printf(m, "dir_index_names: %u\n", p_fs->dir_index_names);
+	seq_printf(m, "dir_index_kb: %u\n", DIV_ROUND_UP(p_fs->dir_index_bytes, 1024));
+	seq_printf(m, "dir_index_max_kb: %u\n", CONFIG_EXFAT_DIR_INDEX_MAX_KB);
+
+	return 0;
+}
+
+static int exfat_dir_index_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, exfat_dir_index_show, PDE(inode)->data);
+}
+
+static const struct file_operations exfat_dir_index_fops = {
+	.owner		= THIS_MODULE,
+	.open		= exfat_dir_index_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif /* CONFIG_EXFAT_DIR_INDEX */
+
 static void exfat_put_super(struct super_block *sb)
 {
 	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+
+#ifdef CONFIG_EXFAT_DIR_INDEX
+	if (exfat_proc_root)
+		remove_proc_entry(sb->s_id, exfat_proc_root);
+#endif
+
 	if (__is_sb_dirty(sb))
 		exfat_write_super(sb);
 
@@ -2423,6 +2462,12 @@ static int exfat_fill_super(struct super_block *sb, void *data, int silent)
 		goto out_fail2;
 	}
 
+#ifdef CONFIG_EXFAT_DIR_INDEX
+	if (exfat_proc_root)
+		proc_create_data(sb->s_id, S_IRUGO, exfat_proc_root,
+				 &exfat_dir_index_fops, sb);
+#endif
+
 	return 0;
 
 out_fail2:
@@ -2454,6 +2499,8 @@ static void init_once(void *foo)
 	struct exfat_inode_info *ei = (struct exfat_inode_info *)foo;
 
 	INIT_HLIST_NODE(&ei->i_hash_fat);
+	INIT_LIST_HEAD(&ei->extent_lru);
+	ei->nr_extents = 0;
 	inode_init_once(&ei->vfs_inode);
 }
 
@@ -2527,6 +2574,10 @@ static int __init init_exfat(void)
 
 	printk(KERN_INFO "exFAT: Version %s\n", EXFAT_VERSION);
 
+#ifdef CONFIG_EXFAT_DIR_INDEX
+	exfat_proc_root = proc_mkdir("fs/exfat", NULL);
+#endif
+
 	err = exfat_init_inodecache();
 	if (err)
 		goto out;
@@ -2537,6 +2588,10 @@ static int __init init_exfat(void)
 
 	return 0;
 out:
+#ifdef CONFIG_EXFAT_DIR_INDEX
+	if (exfat_proc_root)
+		remove_proc_entry("fs/exfat", NULL);
+#endif
 	FsShutdown();
 	return err;
 }
@@ -2545,6 +2600,10 @@ static void __exit exit_exfat(void)
 {
 	exfat_destroy_inodecache();
 	unregister_filesystem(&exfat_fs_type);
+#ifdef CONFIG_EXFAT_DIR_INDEX
+	if (exfat_proc_root)
+		remove_proc_entry("fs/exfat", NULL);
+#endif
 	FsShutdown();
 }
 
@@ -109,6 +109,9 @@ struct exfat_inode_info {
 	struct rw_semaphore truncate_lock;
 	struct inode vfs_inode;
 	struct rw_semaphore i_alloc_sem; /* protect bmap against truncate */
+	struct list_head extent_lru;	/* cached cluster runs, MRU first */
+	s32 nr_extents;
+	u32 extent_start_clu;		/* start cluster the runs belong to */
 };
 
 #define EXFAT_SB(sb)		((struct exfat_sb_info *)((sb)->s_fs_info))
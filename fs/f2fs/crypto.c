@@ -25,6 +25,8 @@
  */
 #include <crypto/hash.h>
 #include <crypto/sha.h>
+#include <crypto/b128ops.h>
+#include <crypto/gf128mul.h>
 #include <keys/user-type.h>
 #include <keys/encrypted-type.h>
 #include <linux/crypto.h>
@@ -42,6 +44,7 @@
 #include <linux/f2fs_fs.h>
 #include <linux/ratelimit.h>
 #include <linux/bio.h>
+#include <linux/highmem.h>
 
 #include "f2fs.h"
 #include "xattr.h"
@@ -58,6 +61,19 @@ module_param(num_prealloc_crypto_ctxs, uint, 0444);
 MODULE_PARM_DESC(num_prealloc_crypto_ctxs,
 		"Number of crypto contexts to preallocate");
 
+#ifdef CONFIG_F2FS_FS_ENCRYPTION_OFFLOAD
+static char offload_driver[CRYPTO_MAX_ALG_NAME] = "ecb-aes-ux500";
+static unsigned int offload_min_pages = 8;
+
+module_param_string(offload_driver, offload_driver, sizeof(offload_driver),
+		0444);
+MODULE_PARM_DESC(offload_driver,
+		"AES-ECB driver large reads are decrypted with");
+module_param(offload_min_pages, uint, 0644);
+MODULE_PARM_DESC(offload_min_pages,
+		"Smallest read bio, in pages, to offload (0 disables)");
+#endif
+
 static mempool_t *f2fs_bounce_page_pool;
 
 static LIST_HEAD(f2fs_free_crypto_ctxs);
@@ -142,9 +158,11 @@ struct f2fs_crypto_ctx *f2fs_get_crypto_ctx(struct inode *inode)
 	return ctx;
 }
 
+static int f2fs_offload_decrypt_bio(struct bio *bio);
+
 /*
- * Call f2fs_decrypt on every single page, reusing the encryption
- * context.
+ * Decrypt the bio in one offloaded request if it is large enough, else
+ * call f2fs_decrypt on every single page, reusing the encryption context.
  */
 static void completion_pages(struct work_struct *work)
 {
@@ -152,11 +170,15 @@ static void completion_pages(struct work_struct *work)
 		container_of(work, struct f2fs_crypto_ctx, r.work);
 	struct bio *bio = ctx->r.bio;
 	struct bio_vec *bv;
+	int batch = f2fs_offload_decrypt_bio(bio);
 	int i;
 
 	bio_for_each_segment_all(bv, bio, i) {
 		struct page *page = bv->bv_page;
-		int ret = f2fs_decrypt(ctx, page);
+		int ret = batch;
+
+		if (ret == -EOPNOTSUPP)
+			ret = f2fs_decrypt(ctx, page);
 
 		if (ret) {
 			WARN_ON_ONCE(1);
@@ -376,6 +398,147 @@ static int f2fs_page_crypto(struct f2fs_crypto_ctx *ctx,
 	return 0;
 }
 
+#ifdef CONFIG_F2FS_FS_ENCRYPTION_OFFLOAD
+/*
+ * XTS on top of ECB: the offload driver encrypts with the data key, the
+ * tweak of every block is xored in before and after it by the CPU. The
+ * engines that have no XTS of their own can then take a whole bio at once,
+ * the tweaks are a shift per block plus one AES block per page.
+ */
+void f2fs_setup_crypto_offload(struct f2fs_crypt_info *ci, const char *raw_key)
+{
+	const unsigned int keysize = F2FS_AES_256_XTS_KEY_SIZE / 2;
+	struct crypto_ablkcipher *ecb;
+	struct crypto_cipher *tweak;
+
+	if (!offload_driver[0])
+		return;
+
+	ecb = crypto_alloc_ablkcipher(offload_driver, 0, 0);
+	if (IS_ERR(ecb))
+		return;
+	tweak = crypto_alloc_cipher("aes", 0, 0);
+	if (IS_ERR(tweak))
+		goto free_ecb;
+
+	if (crypto_ablkcipher_setkey(ecb, raw_key, keysize) ||
+	    crypto_cipher_setkey(tweak, raw_key + keysize, keysize))
+		goto free_tweak;
+
+	ci->ci_ecb_tfm = ecb;
+	ci->ci_tweak_tfm = tweak;
+	return;
+
+free_tweak:
+	crypto_free_cipher(tweak);
+free_ecb:
+	crypto_free_ablkcipher(ecb);
+}
+
+void f2fs_free_crypto_offload(struct f2fs_crypt_info *ci)
+{
+	if (ci->ci_ecb_tfm)
+		crypto_free_ablkcipher(ci->ci_ecb_tfm);
+	if (ci->ci_tweak_tfm)
+		crypto_free_cipher(ci->ci_tweak_tfm);
+}
+
+/* Xor the XTS tweaks of a page into it */
+static void f2fs_xor_page_tweaks(struct f2fs_crypt_info *ci, struct page *page)
+{
+	u8 xts_tweak[F2FS_XTS_TWEAK_SIZE];
+	pgoff_t index = page->index;
+	be128 t, *block;
+	unsigned int i;
+
+	memcpy(xts_tweak, &index, sizeof(index));
+	memset(&xts_tweak[sizeof(index)], 0,
+			F2FS_XTS_TWEAK_SIZE - sizeof(index));
+	crypto_cipher_encrypt_one(ci->ci_tweak_tfm, (u8 *)&t, xts_tweak);
+
+	block = kmap_atomic(page);
+	for (i = 0; i < PAGE_CACHE_SIZE / sizeof(be128); i++) {
+		if (i)
+			gf128mul_x_ble(&t, &t);
+		be128_xor(&block[i], &block[i], &t);
+	}
+	kunmap_atomic(block);
+}
+
+/*
+ * Decrypts all the pages of a read bio in place with one request to the
+ * offload driver. Returns -EOPNOTSUPP, with the pages untouched, if the
+ * bio is not offloaded.
+ */
+static int f2fs_offload_decrypt_bio(struct bio *bio)
+{
+	struct inode *inode = bio->bi_io_vec[0].bv_page->mapping->host;
+	struct f2fs_crypt_info *ci = F2FS_I(inode)->i_crypt_info;
+	unsigned int nr = bio->bi_vcnt;
+	struct ablkcipher_request *req;
+	DECLARE_F2FS_COMPLETION_RESULT(ecr);
+	struct scatterlist *sg;
+	struct bio_vec *bv;
+	int i, res;
+
+	if (!ci || !ci->ci_ecb_tfm || !offload_min_pages ||
+	    nr < offload_min_pages)
+		return -EOPNOTSUPP;
+
+	bio_for_each_segment_all(bv, bio, i)
+		if (bv->bv_page->mapping->host != inode ||
+		    bv->bv_offset || bv->bv_len != PAGE_CACHE_SIZE)
+			return -EOPNOTSUPP;
+
+	/* The driver maps the source and the destination separately */
+	sg = kmalloc(2 * nr * sizeof(*sg), GFP_NOFS);
+	if (!sg)
+		return -EOPNOTSUPP;
+	req = ablkcipher_request_alloc(ci->ci_ecb_tfm, GFP_NOFS);
+	if (!req) {
+		kfree(sg);
+		return -EOPNOTSUPP;
+	}
+
+	sg_init_table(sg, nr);
+	sg_init_table(sg + nr, nr);
+	bio_for_each_segment_all(bv, bio, i) {
+		f2fs_xor_page_tweaks(ci, bv->bv_page);
+		sg_set_page(&sg[i], bv->bv_page, PAGE_CACHE_SIZE, 0);
+		sg_set_page(&sg[nr + i], bv->bv_page, PAGE_CACHE_SIZE, 0);
+	}
+
+	ablkcipher_request_set_callback(
+		req, CRYPTO_TFM_REQ_MAY_BACKLOG | CRYPTO_TFM_REQ_MAY_SLEEP,
+		f2fs_crypt_complete, &ecr);
+	ablkcipher_request_set_crypt(req, sg, sg + nr, nr * PAGE_CACHE_SIZE,
+					NULL);
+	res = crypto_ablkcipher_decrypt(req);
+	if (res == -EINPROGRESS || res == -EBUSY) {
+		wait_for_completion(&ecr.completion);
+		res = ecr.res;
+	}
+	ablkcipher_request_free(req);
+	kfree(sg);
+
+	if (res) {
+		printk_ratelimited(KERN_ERR
+			"%s: offloaded decryption returned %d\n",
+			__func__, res);
+		return res;
+	}
+
+	bio_for_each_segment_all(bv, bio, i)
+		f2fs_xor_page_tweaks(ci, bv->bv_page);
+	return 0;
+}
+#else
+static int f2fs_offload_decrypt_bio(struct bio *bio)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
 static struct page *alloc_bounce_page(struct f2fs_crypto_ctx *ctx)
 {
 	ctx->w.bounce_page = mempool_alloc(f2fs_bounce_page_pool, GFP_NOWAIT);
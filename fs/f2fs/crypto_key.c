@@ -94,6 +94,7 @@ static void f2fs_free_crypt_info(struct f2fs_crypt_info *ci)
 
 	key_put(ci->ci_keyring_key);
 	crypto_free_ablkcipher(ci->ci_ctfm);
+	f2fs_free_crypto_offload(ci);
 	kmem_cache_free(f2fs_crypt_info_cachep, ci);
 }
 
@@ -159,6 +160,10 @@ retry:
 	crypt_info->ci_data_mode = ctx.contents_encryption_mode;
 	crypt_info->ci_filename_mode = ctx.filenames_encryption_mode;
 	crypt_info->ci_ctfm = NULL;
+#ifdef CONFIG_F2FS_FS_ENCRYPTION_OFFLOAD
+	crypt_info->ci_ecb_tfm = NULL;
+	crypt_info->ci_tweak_tfm = NULL;
+#endif
 	crypt_info->ci_keyring_key = NULL;
 	memcpy(crypt_info->ci_master_key, ctx.master_key_descriptor,
 				sizeof(crypt_info->ci_master_key));
@@ -230,6 +235,9 @@ retry:
 	if (res)
 		goto out;
 
+	if (S_ISREG(inode->i_mode) && mode == F2FS_ENCRYPTION_MODE_AES_256_XTS)
+		f2fs_setup_crypto_offload(crypt_info, raw_key);
+
 	memzero_explicit(raw_key, sizeof(raw_key));
 	if (cmpxchg(&fi->i_crypt_info, NULL, crypt_info) != NULL) {
 		f2fs_free_crypt_info(crypt_info);
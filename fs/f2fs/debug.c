@@ -38,6 +38,8 @@ static void update_general_status(struct f2fs_sb_info *sbi)
 	si->hit_rbtree = atomic64_read(&sbi->read_hit_rbtree);
 	si->hit_total = si->hit_largest + si->hit_cached + si->hit_rbtree;
 	si->total_ext = atomic64_read(&sbi->total_hit_ext);
+	si->shrunk_node = atomic64_read(&sbi->shrunk_ext_node);
+	si->shrunk_tree = atomic64_read(&sbi->shrunk_ext_tree);
 	si->ext_tree = sbi->total_ext_tree;
 	si->ext_node = atomic_read(&sbi->total_ext_node);
 	si->ndirty_node = get_pages(sbi, F2FS_DIRTY_NODES);
@@ -69,6 +71,12 @@ static void update_general_status(struct f2fs_sb_info *sbi)
 	si->dirty_sits = SIT_I(sbi)->dirty_sentries;
 	si->fnids = NM_I(sbi)->fcnt;
 	si->bg_gc = sbi->bg_gc;
+	si->fg_gc = sbi->fg_gc;
+	if (sbi->gc_thread) {
+		si->idle_gc = sbi->gc_thread->idle_gc_count;
+		si->free_secs_off = sbi->gc_thread->free_secs_off;
+		si->free_secs_on = sbi->gc_thread->free_secs_on;
+	}
 	si->util_free = (int)(free_user_blocks(sbi) >> sbi->log_blocks_per_seg)
 		* 100 / (int)(sbi->user_block_count >> sbi->log_blocks_per_seg)
 		/ 2;
@@ -272,6 +280,10 @@ static int stat_show(struct seq_file *s, void *v)
 		seq_printf(s, "CP calls: %d\n", si->cp_count);
 		seq_printf(s, "GC calls: %d (BG: %d)\n",
 			   si->call_count, si->bg_gc);
+		seq_printf(s, "  - foreground rounds: %d\n", si->fg_gc);
+		seq_printf(s, "  - screen off rounds: %d\n", si->idle_gc);
+		seq_printf(s, "  - free sections: screen off %d, screen on %d\n",
+			   si->free_secs_off, si->free_secs_on);
 		seq_printf(s, "  - data segments : %d (%d)\n",
 				si->data_segs, si->bg_data_segs);
 		seq_printf(s, "  - node segments : %d (%d)\n",
@@ -290,8 +302,17 @@ static int stat_show(struct seq_file *s, void *v)
 				!si->total_ext ? 0 :
 				div64_u64(si->hit_total * 100, si->total_ext),
 				si->hit_total, si->total_ext);
+		seq_printf(s, "  - Miss Count: %llu\n",
+				si->total_ext - si->hit_total);
 		seq_printf(s, "  - Inner Struct Count: tree: %d, node: %d\n",
 				si->ext_tree, si->ext_node);
+		seq_printf(s, "  - Shrunk: tree: %llu, node: %llu\n",
+				si->shrunk_tree, si->shrunk_node);
+		seq_printf(s, "  - Memory: %llu KB\n",
+				((unsigned long long)si->ext_tree *
+					sizeof(struct extent_tree) +
+				 (unsigned long long)si->ext_node *
+					sizeof(struct extent_node)) >> 10);
 		seq_puts(s, "\nBalancing F2FS Async:\n");
 		seq_printf(s, "  - inmem: %4d, wb: %4d\n",
 			   si->inmem_pages, si->wb_pages);
@@ -382,6 +403,8 @@ int f2fs_build_stats(struct f2fs_sb_info *sbi)
 	atomic64_set(&sbi->read_hit_rbtree, 0);
 	atomic64_set(&sbi->read_hit_largest, 0);
 	atomic64_set(&sbi->read_hit_cached, 0);
+	atomic64_set(&sbi->shrunk_ext_node, 0);
+	atomic64_set(&sbi->shrunk_ext_tree, 0);
 
 	atomic_set(&sbi->inline_xattr, 0);
 	atomic_set(&sbi->inline_inode, 0);
@@ -33,6 +33,7 @@ static struct extent_node *__attach_extent_node(struct f2fs_sb_info *sbi,
 
 	en->ei = *ei;
 	INIT_LIST_HEAD(&en->list);
+	en->et = et;
 
 	rb_link_node(&en->rb_node, parent, p);
 	rb_insert_color(&en->rb_node, &et->root);
@@ -546,10 +547,16 @@ static unsigned int f2fs_update_extent_tree_range(struct inode *inode,
 	return !__is_extent_same(&prev, &et->largest);
 }
 
+/*
+ * Extent nodes are reclaimed from the head of the global LRU, so that the
+ * extents of a large working set of inodes stay cached as long as they are
+ * used. Trees are only dropped once they hold no node and have no inode.
+ */
 unsigned int f2fs_shrink_extent_tree(struct f2fs_sb_info *sbi, int nr_shrink)
 {
 	struct extent_tree *treevec[EXT_TREE_VEC_SIZE];
-	struct extent_node *en, *tmp;
+	struct extent_tree *et;
+	struct extent_node *en;
 	unsigned long ino = F2FS_ROOT_INO(sbi);
 	struct radix_tree_root *root = &sbi->extent_tree_root;
 	unsigned int found;
@@ -559,53 +566,39 @@ unsigned int f2fs_shrink_extent_tree(struct f2fs_sb_info *sbi, int nr_shrink)
 	if (!test_opt(sbi, EXTENT_CACHE))
 		return 0;
 
-	if (!down_write_trylock(&sbi->extent_tree_lock))
-		goto out;
-
-	/* 1. remove unreferenced extent tree */
-	while ((found = radix_tree_gang_lookup(root,
-				(void **)treevec, ino, EXT_TREE_VEC_SIZE))) {
-		unsigned i;
+	/* 1. remove LRU extent entries */
+	remained = nr_shrink;
 
-		ino = treevec[found - 1]->ino + 1;
-		for (i = 0; i < found; i++) {
-			struct extent_tree *et = treevec[i];
-
-			if (!atomic_read(&et->refcount)) {
-				write_lock(&et->lock);
-				node_cnt += __free_extent_tree(sbi, et, true);
-				write_unlock(&et->lock);
-
-				radix_tree_delete(root, et->ino);
-				kmem_cache_free(extent_tree_slab, et);
-				sbi->total_ext_tree--;
-				tree_cnt++;
+	spin_lock(&sbi->extent_lock);
+	while (remained-- > 0 && !list_empty(&sbi->extent_list)) {
+		en = list_first_entry(&sbi->extent_list,
+					struct extent_node, list);
+		et = en->et;
 
-				if (node_cnt + tree_cnt >= nr_shrink)
-					goto unlock_out;
-			}
+		/* the tree is busy, age the node again */
+		if (!write_trylock(&et->lock)) {
+			list_move_tail(&en->list, &sbi->extent_list);
+			continue;
 		}
-	}
-	up_write(&sbi->extent_tree_lock);
 
-	/* 2. remove LRU extent entries */
-	if (!down_write_trylock(&sbi->extent_tree_lock))
-		goto out;
+		list_del_init(&en->list);
+		spin_unlock(&sbi->extent_lock);
 
-	remained = nr_shrink - (node_cnt + tree_cnt);
+		__detach_extent_node(sbi, et, en);
+		write_unlock(&et->lock);
+		kmem_cache_free(extent_node_slab, en);
+		node_cnt++;
 
-	spin_lock(&sbi->extent_lock);
-	list_for_each_entry_safe(en, tmp, &sbi->extent_list, list) {
-		if (!remained--)
-			break;
-		list_del_init(&en->list);
+		spin_lock(&sbi->extent_lock);
 	}
 	spin_unlock(&sbi->extent_lock);
 
-	/*
-	 * reset ino for searching victims from beginning of global extent tree.
-	 */
-	ino = F2FS_ROOT_INO(sbi);
+	if (node_cnt >= nr_shrink)
+		goto out;
+
+	/* 2. remove empty extent trees of evicted inodes */
+	if (!down_write_trylock(&sbi->extent_tree_lock))
+		goto out;
 
 	while ((found = radix_tree_gang_lookup(root,
 				(void **)treevec, ino, EXT_TREE_VEC_SIZE))) {
@@ -613,12 +606,23 @@ unsigned int f2fs_shrink_extent_tree(struct f2fs_sb_info *sbi, int nr_shrink)
 
 		ino = treevec[found - 1]->ino + 1;
 		for (i = 0; i < found; i++) {
-			struct extent_tree *et = treevec[i];
+			et = treevec[i];
+
+			if (atomic_read(&et->refcount))
+				continue;
 
 			write_lock(&et->lock);
-			node_cnt += __free_extent_tree(sbi, et, false);
+			if (et->count) {
+				write_unlock(&et->lock);
+				continue;
+			}
 			write_unlock(&et->lock);
 
+			radix_tree_delete(root, et->ino);
+			kmem_cache_free(extent_tree_slab, et);
+			sbi->total_ext_tree--;
+			tree_cnt++;
+
 			if (node_cnt + tree_cnt >= nr_shrink)
 				goto unlock_out;
 		}
@@ -626,6 +630,7 @@ unsigned int f2fs_shrink_extent_tree(struct f2fs_sb_info *sbi, int nr_shrink)
 unlock_out:
 	up_write(&sbi->extent_tree_lock);
 out:
+	stat_add_shrunk_extent(sbi, node_cnt, tree_cnt);
 	trace_f2fs_shrink_extent_tree(sbi, node_cnt, tree_cnt);
 
 	return node_cnt + tree_cnt;
@@ -79,6 +79,10 @@ struct f2fs_crypt_info {
 	char		ci_filename_mode;
 	char		ci_flags;
 	struct crypto_ablkcipher *ci_ctfm;
+#ifdef CONFIG_F2FS_FS_ENCRYPTION_OFFLOAD
+	struct crypto_ablkcipher *ci_ecb_tfm;	/* data key, offload driver */
+	struct crypto_cipher *ci_tweak_tfm;	/* tweak key */
+#endif
 	struct key	*ci_keyring_key;
 	char		ci_master_key[F2FS_KEY_DESCRIPTOR_SIZE];
 };
@@ -17,6 +17,10 @@
 #include <linux/delay.h>
 #include <linux/freezer.h>
 #include <linux/blkdev.h>
+#include <linux/genhd.h>
+#ifdef CONFIG_HAS_EARLYSUSPEND
+#include <linux/earlysuspend.h>
+#endif
 
 #include "f2fs.h"
 #include "node.h"
@@ -24,6 +28,99 @@
 #include "gc.h"
 #include <trace/events/f2fs.h>
 
+static LIST_HEAD(gc_thread_list);
+static DEFINE_SPINLOCK(gc_thread_lock);
+static DEFINE_MUTEX(gc_thread_mutex);
+static int gc_thread_count;
+static bool gc_screen_off;
+
+/*
+ * The device is idle if it has no request and completed no I/O for
+ * idle_interval, whoever it came from. Called without gc_mutex, writers
+ * must not wait for the interval.
+ */
+static bool device_idle(struct f2fs_sb_info *sbi,
+				struct f2fs_gc_kthread *gc_th)
+{
+	struct hd_struct *part = &sbi->sb->s_bdev->bd_disk->part0;
+
+	if (!is_idle(sbi) || part_in_flight(part))
+		return false;
+
+	gc_th->last_ios = disk_ios(sbi);
+	wait_event_interruptible_timeout(gc_th->gc_wait_queue_head,
+				kthread_should_stop() || gc_th->gc_wake,
+				msecs_to_jiffies(gc_th->idle_interval));
+	if (kthread_should_stop() || gc_th->gc_wake)
+		return false;
+
+	return is_idle(sbi) && !part_in_flight(part) &&
+				disk_ios(sbi) == gc_th->last_ios;
+}
+
+static void gc_screen_changed(bool screen_off)
+{
+	struct f2fs_gc_kthread *gc_th;
+
+	spin_lock(&gc_thread_lock);
+	gc_screen_off = screen_off;
+	list_for_each_entry(gc_th, &gc_thread_list, list) {
+		gc_th->screen_off = screen_off;
+		if (screen_off)
+			gc_th->free_secs_off = free_sections(gc_th->sbi);
+		else
+			gc_th->free_secs_on = free_sections(gc_th->sbi);
+		gc_th->gc_wake = true;
+		wake_up(&gc_th->gc_wait_queue_head);
+	}
+	spin_unlock(&gc_thread_lock);
+}
+
+#ifdef CONFIG_HAS_EARLYSUSPEND
+static void gc_early_suspend(struct early_suspend *h)
+{
+	gc_screen_changed(true);
+}
+
+static void gc_late_resume(struct early_suspend *h)
+{
+	gc_screen_changed(false);
+}
+
+static struct early_suspend gc_early_suspend_handler = {
+	.level = EARLY_SUSPEND_LEVEL_BLANK_SCREEN,
+	.suspend = gc_early_suspend,
+	.resume = gc_late_resume,
+};
+#endif
+
+static void gc_thread_register(struct f2fs_gc_kthread *gc_th)
+{
+	mutex_lock(&gc_thread_mutex);
+#ifdef CONFIG_HAS_EARLYSUSPEND
+	if (!gc_thread_count++)
+		register_early_suspend(&gc_early_suspend_handler);
+#endif
+	spin_lock(&gc_thread_lock);
+	gc_th->screen_off = gc_screen_off;
+	list_add_tail(&gc_th->list, &gc_thread_list);
+	spin_unlock(&gc_thread_lock);
+	mutex_unlock(&gc_thread_mutex);
+}
+
+static void gc_thread_unregister(struct f2fs_gc_kthread *gc_th)
+{
+	mutex_lock(&gc_thread_mutex);
+	spin_lock(&gc_thread_lock);
+	list_del(&gc_th->list);
+	spin_unlock(&gc_thread_lock);
+#ifdef CONFIG_HAS_EARLYSUSPEND
+	if (!--gc_thread_count)
+		unregister_early_suspend(&gc_early_suspend_handler);
+#endif
+	mutex_unlock(&gc_thread_mutex);
+}
+
 static int gc_thread_func(void *data)
 {
 	struct f2fs_sb_info *sbi = data;
@@ -38,11 +135,18 @@ static int gc_thread_func(void *data)
 			continue;
 		else
 			wait_event_interruptible_timeout(*wq,
-						kthread_should_stop(),
+						kthread_should_stop() ||
+						gc_th->gc_wake,
 						msecs_to_jiffies(wait_ms));
 		if (kthread_should_stop())
 			break;
 
+		/* the screen went off or on, start over from the short sleep */
+		if (gc_th->gc_wake) {
+			gc_th->gc_wake = false;
+			wait_ms = gc_th->min_sleep_time;
+		}
+
 		if (sbi->sb->s_frozen >= SB_FREEZE_WRITE) {
 			increase_sleep_time(gc_th, &wait_ms);
 			continue;
@@ -54,13 +158,26 @@ static int gc_thread_func(void *data)
 		 * 1. There are enough dirty segments.
 		 * 2. IO subsystem is idle by checking the # of writeback pages.
 		 * 3. IO subsystem is idle by checking the # of requests in
-		 *    bdev's request list.
+		 *    bdev's request list, and the disk did no I/O for
+		 *    idle_interval.
+		 *
+		 * With the screen off, GC runs every idle_sleep_time while
+		 * there are victims, to free sections before the user needs
+		 * them and foreground GC has to.
 		 *
 		 * Note) We have to avoid triggering GCs frequently.
 		 * Because it is possible that some segments can be
 		 * invalidated soon after by user update or deletion.
 		 * So, I'd like to wait some time to collect dirty segments.
 		 */
+		if (!device_idle(sbi, gc_th)) {
+			if (gc_th->screen_off)
+				wait_ms = gc_th->idle_sleep_time;
+			else
+				increase_sleep_time(gc_th, &wait_ms);
+			continue;
+		}
+
 		if (!mutex_trylock(&sbi->gc_mutex))
 			continue;
 
@@ -70,10 +187,14 @@ static int gc_thread_func(void *data)
 			continue;
 		}
 
-		if (has_enough_invalid_blocks(sbi))
+		if (gc_th->screen_off) {
+			wait_ms = gc_th->idle_sleep_time;
+			gc_th->idle_gc_count++;
+		} else if (has_enough_invalid_blocks(sbi)) {
 			decrease_sleep_time(gc_th, &wait_ms);
-		else
+		} else {
 			increase_sleep_time(gc_th, &wait_ms);
+		}
 
 		stat_inc_bggc_count(sbi);
 
@@ -109,12 +230,22 @@ int start_gc_thread(struct f2fs_sb_info *sbi)
 
 	gc_th->gc_idle = 0;
 
+	gc_th->idle_interval = DEF_GC_THREAD_IDLE_INTERVAL;
+	gc_th->idle_sleep_time = DEF_GC_THREAD_IDLE_SLEEP_TIME;
+	gc_th->sbi = sbi;
+	gc_th->gc_wake = false;
+	gc_th->free_secs_off = 0;
+	gc_th->free_secs_on = 0;
+	gc_th->idle_gc_count = 0;
+
 	sbi->gc_thread = gc_th;
 	init_waitqueue_head(&sbi->gc_thread->gc_wait_queue_head);
+	gc_thread_register(gc_th);
 	sbi->gc_thread->f2fs_gc_task = kthread_run(gc_thread_func, sbi,
 			"f2fs_gc-%u:%u", MAJOR(dev), MINOR(dev));
 	if (IS_ERR(gc_th->f2fs_gc_task)) {
 		err = PTR_ERR(gc_th->f2fs_gc_task);
+		gc_thread_unregister(gc_th);
 		kfree(gc_th);
 		sbi->gc_thread = NULL;
 	}
@@ -128,6 +259,7 @@ void stop_gc_thread(struct f2fs_sb_info *sbi)
 	if (!gc_th)
 		return;
 	kthread_stop(gc_th->f2fs_gc_task);
+	gc_thread_unregister(gc_th);
 	kfree(gc_th);
 	sbi->gc_thread = NULL;
 }
@@ -824,6 +956,8 @@ int f2fs_gc(struct f2fs_sb_info *sbi, bool sync)
 	};
 
 	cpc.reason = __get_cp_reason(sbi);
+	if (sync)
+		stat_inc_fggc_count(sbi);
 gc_more:
 	segno = NULL_SEGNO;
 
@@ -834,6 +968,7 @@ gc_more:
 
 	if (gc_type == BG_GC && has_not_enough_free_secs(sbi, sec_freed)) {
 		gc_type = FG_GC;
+		stat_inc_fggc_count(sbi);
 		if (__get_victim(sbi, &segno, gc_type) || prefree_segments(sbi))
 			write_checkpoint(sbi, &cpc);
 	}
@@ -16,6 +16,8 @@
 #define DEF_GC_THREAD_MIN_SLEEP_TIME	30000	/* milliseconds */
 #define DEF_GC_THREAD_MAX_SLEEP_TIME	60000
 #define DEF_GC_THREAD_NOGC_SLEEP_TIME	300000	/* wait 5 min */
+#define DEF_GC_THREAD_IDLE_INTERVAL	500	/* no I/O for the device idle */
+#define DEF_GC_THREAD_IDLE_SLEEP_TIME	1000	/* rounds with the screen off */
 #define LIMIT_INVALID_BLOCK	40 /* percentage over total user space */
 #define LIMIT_FREE_BLOCK	40 /* percentage over invalid + free space */
 
@@ -33,6 +35,20 @@ struct f2fs_gc_kthread {
 
 	/* for changing gc mode */
 	unsigned int gc_idle;
+
+	/* for device idle and screen state */
+	unsigned int idle_interval;
+	unsigned int idle_sleep_time;
+	struct f2fs_sb_info *sbi;
+	struct list_head list;		/* in the list of gc threads */
+	unsigned long last_ios;		/* disk I/Os at the last idle check */
+	bool screen_off;
+	bool gc_wake;
+
+	/* free sections at the last screen changes, and rounds screen off */
+	unsigned int free_secs_off;
+	unsigned int free_secs_on;
+	unsigned int idle_gc_count;
 };
 
 struct gc_inode_list {
@@ -108,3 +124,12 @@ static inline int is_idle(struct f2fs_sb_info *sbi)
 	struct request_list *rl = &q->rq;
 	return !(rl->count[BLK_RW_SYNC]) && !(rl->count[BLK_RW_ASYNC]);
 }
+
+/* I/Os completed on the whole disk, other partitions count as well */
+static inline unsigned long disk_ios(struct f2fs_sb_info *sbi)
+{
+	struct hd_struct *part = &sbi->sb->s_bdev->bd_disk->part0;
+
+	return part_stat_read(part, ios[READ]) +
+		part_stat_read(part, ios[WRITE]);
+}
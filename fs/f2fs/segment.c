@@ -580,7 +580,7 @@ static void locate_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno)
 }
 
 static int f2fs_issue_discard(struct f2fs_sb_info *sbi,
-				block_t blkstart, block_t blklen)
+		block_t blkstart, block_t blklen, unsigned long flags)
 {
 	sector_t start = SECTOR_FROM_BLOCK(blkstart);
 	sector_t len = SECTOR_FROM_BLOCK(blklen);
@@ -596,7 +596,8 @@ static int f2fs_issue_discard(struct f2fs_sb_info *sbi,
 			sbi->discard_blks--;
 	}
 	trace_f2fs_issue_discard(sbi->sb, blkstart, blklen);
-	return blkdev_issue_discard(sbi->sb->s_bdev, start, len, GFP_NOFS, 0);
+	return blkdev_issue_discard(sbi->sb->s_bdev, start, len, GFP_NOFS,
+				    flags);
 }
 
 bool discard_next_dnode(struct f2fs_sb_info *sbi, block_t blkaddr)
@@ -611,7 +612,7 @@ bool discard_next_dnode(struct f2fs_sb_info *sbi, block_t blkaddr)
 		if (f2fs_test_bit(offset, se->discard_map))
 			return false;
 
-		err = f2fs_issue_discard(sbi, blkaddr, 1);
+		err = f2fs_issue_discard(sbi, blkaddr, 1, 0);
 	}
 
 	if (err) {
@@ -716,6 +717,9 @@ void clear_prefree_segments(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
 	unsigned long *prefree_map = dirty_i->dirty_segmap[PRE];
 	unsigned int start = 0, end = -1;
+	/* Only FITRIM waits for its discards */
+	unsigned long flags = cpc->reason == CP_DISCARD ?
+					0 : BLKDEV_DISCARD_DEFER;
 
 	mutex_lock(&dirty_i->seglist_lock);
 
@@ -736,7 +740,7 @@ void clear_prefree_segments(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 			continue;
 
 		f2fs_issue_discard(sbi, START_BLOCK(sbi, start),
-				(end - start) << sbi->log_blocks_per_seg);
+				(end - start) << sbi->log_blocks_per_seg, flags);
 	}
 	mutex_unlock(&dirty_i->seglist_lock);
 
@@ -744,7 +748,7 @@ void clear_prefree_segments(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 	list_for_each_entry_safe(entry, this, head, list) {
 		if (cpc->reason == CP_DISCARD && entry->len < cpc->trim_minlen)
 			goto skip;
-		f2fs_issue_discard(sbi, entry->blkaddr, entry->len);
+		f2fs_issue_discard(sbi, entry->blkaddr, entry->len, flags);
 		cpc->trimmed += entry->len;
 skip:
 		list_del(&entry->list);
@@ -10,6 +10,7 @@
 
 #include <linux/init.h>
 #include <linux/module.h>
+#include <linux/math64.h>
 
 #define FUSE_CTL_SUPER_MAGIC 0x65735543
 
@@ -61,6 +62,31 @@ static ssize_t fuse_conn_waiting_read(struct file *file, char __user *buf,
 	return simple_read_from_buffer(buf, len, ppos, tmp, size);
 }
 
+static ssize_t fuse_conn_latency_read(struct file *file, char __user *buf,
+				      size_t len, loff_t *ppos)
+{
+	struct fuse_conn *fc;
+	u64 count, time_us;
+	unsigned max_us;
+	char tmp[96];
+	size_t size;
+
+	fc = fuse_ctl_file_conn_get(file);
+	if (!fc)
+		return 0;
+
+	spin_lock(&fc->lock);
+	count = fc->req_count;
+	time_us = fc->req_time_us;
+	max_us = fc->req_max_us;
+	spin_unlock(&fc->lock);
+	fuse_conn_put(fc);
+
+	size = sprintf(tmp, "requests %llu\navg_us %llu\nmax_us %u\n",
+		       count, count ? div64_u64(time_us, count) : 0, max_us);
+	return simple_read_from_buffer(buf, len, ppos, tmp, size);
+}
+
 static ssize_t fuse_conn_limit_read(struct file *file, char __user *buf,
 				    size_t len, loff_t *ppos, unsigned val)
 {
@@ -188,6 +214,12 @@ static const struct file_operations fuse_ctl_waiting_ops = {
 	.llseek = no_llseek,
 };
 
+static const struct file_operations fuse_ctl_latency_ops = {
+	.open = nonseekable_open,
+	.read = fuse_conn_latency_read,
+	.llseek = no_llseek,
+};
+
 static const struct file_operations fuse_conn_max_background_ops = {
 	.open = nonseekable_open,
 	.read = fuse_conn_max_background_read,
@@ -266,7 +298,9 @@ int fuse_ctl_add_conn(struct fuse_conn *fc)
 				 1, NULL, &fuse_conn_max_background_ops) ||
 	    !fuse_ctl_add_dentry(parent, fc, "congestion_threshold",
 				 S_IFREG | 0600, 1, NULL,
-				 &fuse_conn_congestion_threshold_ops))
+				 &fuse_conn_congestion_threshold_ops) ||
+	    !fuse_ctl_add_dentry(parent, fc, "latency", S_IFREG | 0400, 1,
+				 NULL, &fuse_ctl_latency_ops))
 		goto err;
 
 	return 0;
@@ -246,6 +246,7 @@ static void queue_request(struct fuse_conn *fc, struct fuse_req *req)
 		len_args(req->in.numargs, (struct fuse_arg *) req->in.args);
 	list_add_tail(&req->list, &fc->pending);
 	req->state = FUSE_REQ_PENDING;
+	req->queued = ktime_get();
 	if (!req->waiting) {
 		req->waiting = 1;
 		atomic_inc(&fc->num_waiting);
@@ -304,6 +305,13 @@ __releases(fc->lock)
 	list_del(&req->list);
 	list_del(&req->intr_entry);
 	req->state = FUSE_REQ_FINISHED;
+	if (req->queued.tv64) {
+		unsigned us = ktime_us_delta(ktime_get(), req->queued);
+
+		fc->req_count++;
+		fc->req_time_us += us;
+		fc->req_max_us = max(fc->req_max_us, us);
+	}
 	if (req->background) {
 		if (fc->num_background == fc->max_background) {
 			fc->blocked = 0;
@@ -22,6 +22,7 @@
 #include <linux/rbtree.h>
 #include <linux/poll.h>
 #include <linux/workqueue.h>
+#include <linux/ktime.h>
 
 /** Max number of pages that can be used in a single read request */
 #define FUSE_MAX_PAGES_PER_REQ 32
@@ -33,7 +34,7 @@
 #define FUSE_NAME_MAX 1024
 
 /** Number of dentries for each connection in the control filesystem */
-#define FUSE_CTL_NUM_DENTRIES 5
+#define FUSE_CTL_NUM_DENTRIES 6
 
 /** If the FUSE_DEFAULT_PERMISSIONS flag is given, the filesystem
     module will check permissions based on the file mode.  Otherwise no
@@ -270,6 +271,9 @@ struct fuse_req {
 	/** State of the request */
 	enum fuse_req_state state;
 
+	/** When the request was queued for userspace */
+	ktime_t queued;
+
 	/** The request input */
 	struct fuse_in in;
 
@@ -450,6 +454,9 @@ struct fuse_conn {
 	/** Shortcircuited IO. */
 	unsigned shortcircuit_io:1;
 
+	/** Buffered writes go to the page cache.  Only set in INIT */
+	unsigned writeback_cache:1;
+
 	/*
 	 * The following bitfields are only for optimization purposes
 	 * and hence races in setting them will not cause malfunction
@@ -506,6 +513,11 @@ struct fuse_conn {
 	/** The number of requests waiting for completion */
 	atomic_t num_waiting;
 
+	/** Answered requests and their latency, under lock */
+	u64 req_count;
+	u64 req_time_us;
+	unsigned req_max_us;
+
 	/** Negotiated minor version */
 	unsigned minor;
 
@@ -27,6 +27,7 @@
 #include <linux/bio.h>
 #include <linux/blkdev.h>
 #include <linux/bitops.h>
+#include <linux/math64.h>
 #include <trace/events/jbd2.h>
 
 /*
@@ -317,8 +318,8 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 	int flags;
 	int err;
 	unsigned long long blocknr;
-	ktime_t start_time;
-	u64 commit_time;
+	ktime_t start_time, flush_start;
+	u64 commit_time, flush_time;
 	char *tagp = NULL;
 	journal_header_t *header;
 	journal_block_tag_t *tag = NULL;
@@ -847,6 +848,8 @@ wait_for_iobuf:
 	commit_transaction->t_state = T_COMMIT_JFLUSH;
 	write_unlock(&journal->j_state_lock);
 
+	flush_start = ktime_get();
+
 	if (!JBD2_HAS_INCOMPAT_FEATURE(journal,
 				       JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT)) {
 		err = journal_submit_commit_record(journal, commit_transaction,
@@ -861,6 +864,7 @@ wait_for_iobuf:
 	    journal->j_flags & JBD2_BARRIER) {
 		blkdev_issue_flush(journal->j_dev, GFP_NOFS, NULL);
 	}
+	flush_time = ktime_to_ns(ktime_sub(ktime_get(), flush_start));
 
 	if (err)
 		jbd2_journal_abort(journal, err);
@@ -1026,8 +1030,11 @@ restart_loop:
 	stats.ts_tid = commit_transaction->t_tid;
 	stats.run.rs_handle_count =
 		atomic_read(&commit_transaction->t_handle_count);
+	stats.run.rs_sync_count =
+		atomic_read(&commit_transaction->t_sync_count);
 	trace_jbd2_run_stats(journal->j_fs_dev->bd_dev,
 			     commit_transaction->t_tid, &stats.run);
+	commit_time = ktime_to_ns(ktime_sub(ktime_get(), start_time));
 
 	/*
 	 * Calculate overall stats
@@ -1042,13 +1049,17 @@ restart_loop:
 	journal->j_stats.run.rs_handle_count += stats.run.rs_handle_count;
 	journal->j_stats.run.rs_blocks += stats.run.rs_blocks;
 	journal->j_stats.run.rs_blocks_logged += stats.run.rs_blocks_logged;
+	journal->j_stats.run.rs_sync_count += stats.run.rs_sync_count;
+	journal->j_stats.ts_time_hist[min(fls(div_u64(commit_time, 1000000)),
+					  JBD2_HIST_SLOTS - 1)]++;
+	journal->j_stats.ts_size_hist[min(fls(stats.run.rs_blocks_logged),
+					  JBD2_HIST_SLOTS - 1)]++;
 	spin_unlock(&journal->j_history_lock);
 
 	commit_transaction->t_state = T_COMMIT_CALLBACK;
 	J_ASSERT(commit_transaction == journal->j_committing_transaction);
 	journal->j_commit_sequence = commit_transaction->t_tid;
 	journal->j_committing_transaction = NULL;
-	commit_time = ktime_to_ns(ktime_sub(ktime_get(), start_time));
 
 	/*
 	 * weight the commit time higher than the average time so we don't
@@ -1059,6 +1070,11 @@ restart_loop:
 				journal->j_average_commit_time*3) / 4;
 	else
 		journal->j_average_commit_time = commit_time;
+	if (likely(journal->j_average_flush_time))
+		journal->j_average_flush_time = (flush_time +
+				journal->j_average_flush_time*3) / 4;
+	else
+		journal->j_average_flush_time = flush_time;
 
 	write_unlock(&journal->j_state_lock);
 
@@ -675,9 +675,15 @@ int jbd2_complete_transaction(journal_t *journal, tid_t tid)
 	read_lock(&journal->j_state_lock);
 	if (journal->j_running_transaction &&
 	    journal->j_running_transaction->t_tid == tid) {
+		transaction_t *transaction = journal->j_running_transaction;
+
+		atomic_inc(&transaction->t_sync_count);
 		if (journal->j_commit_request != tid) {
+			ktime_t start = transaction->t_start_time;
+
 			/* transaction not yet started, so request it */
 			read_unlock(&journal->j_state_lock);
+			jbd2_sync_batch(journal, start);
 			jbd2_log_start_commit(journal, tid);
 			goto wait_commit;
 		}
@@ -913,6 +919,10 @@ static int jbd2_seq_info_show(struct seq_file *seq, void *v)
 	    jiffies_to_msecs(s->stats->run.rs_logging / s->stats->ts_tid));
 	seq_printf(seq, "  %lluus average transaction commit time\n",
 		   div_u64(s->journal->j_average_commit_time, 1000));
+	seq_printf(seq, "  %lluus average commit record and flush time\n",
+		   div_u64(s->journal->j_average_flush_time, 1000));
+	seq_printf(seq, "  %lu synchronous waiters per transaction\n",
+	    s->stats->run.rs_sync_count / s->stats->ts_tid);
 	seq_printf(seq, "  %lu handles per transaction\n",
 	    s->stats->run.rs_handle_count / s->stats->ts_tid);
 	seq_printf(seq, "  %lu blocks per transaction\n",
@@ -926,6 +936,35 @@ static void jbd2_seq_info_stop(struct seq_file *seq, void *v)
 {
 }
 
+static void jbd2_seq_hist_show(struct seq_file *seq, const char *name,
+			       unsigned long *hist)
+{
+	int i;
+
+	seq_printf(seq, "%s:\n", name);
+	for (i = 0; i < JBD2_HIST_SLOTS; i++) {
+		if (!i)
+			seq_printf(seq, "  %5u       %lu\n", 0, hist[i]);
+		else if (i < JBD2_HIST_SLOTS - 1)
+			seq_printf(seq, "  %5u-%-5u %lu\n", 1 << (i - 1),
+				   (1 << i) - 1, hist[i]);
+		else
+			seq_printf(seq, "  %5u+      %lu\n", 1 << (i - 1),
+				   hist[i]);
+	}
+}
+
+static int jbd2_seq_info_hist_show(struct seq_file *seq, void *v)
+{
+	struct jbd2_stats_proc_session *s = seq->private;
+
+	if (v != SEQ_START_TOKEN)
+		return 0;
+	jbd2_seq_hist_show(seq, "commit time (ms)", s->stats->ts_time_hist);
+	jbd2_seq_hist_show(seq, "logged blocks", s->stats->ts_size_hist);
+	return 0;
+}
+
 static const struct seq_operations jbd2_seq_info_ops = {
 	.start  = jbd2_seq_info_start,
 	.next   = jbd2_seq_info_next,
@@ -933,7 +972,15 @@ static const struct seq_operations jbd2_seq_info_ops = {
 	.show   = jbd2_seq_info_show,
 };
 
-static int jbd2_seq_info_open(struct inode *inode, struct file *file)
+static const struct seq_operations jbd2_seq_hist_ops = {
+	.start  = jbd2_seq_info_start,
+	.next   = jbd2_seq_info_next,
+	.stop   = jbd2_seq_info_stop,
+	.show   = jbd2_seq_info_hist_show,
+};
+
+static int jbd2_seq_stats_open(struct inode *inode, struct file *file,
+			       const struct seq_operations *ops)
 {
 	journal_t *journal = PDE(inode)->data;
 	struct jbd2_stats_proc_session *s;
@@ -953,7 +1000,7 @@ static int jbd2_seq_info_open(struct inode *inode, struct file *file)
 	s->journal = journal;
 	spin_unlock(&journal->j_history_lock);
 
-	rc = seq_open(file, &jbd2_seq_info_ops);
+	rc = seq_open(file, ops);
 	if (rc == 0) {
 		struct seq_file *m = file->private_data;
 		m->private = s;
@@ -965,6 +1012,16 @@ static int jbd2_seq_info_open(struct inode *inode, struct file *file)
 
 }
 
+static int jbd2_seq_info_open(struct inode *inode, struct file *file)
+{
+	return jbd2_seq_stats_open(inode, file, &jbd2_seq_info_ops);
+}
+
+static int jbd2_seq_hist_open(struct inode *inode, struct file *file)
+{
+	return jbd2_seq_stats_open(inode, file, &jbd2_seq_hist_ops);
+}
+
 static int jbd2_seq_info_release(struct inode *inode, struct file *file)
 {
 	struct seq_file *seq = file->private_data;
@@ -982,6 +1039,14 @@ static const struct file_operations jbd2_seq_info_fops = {
 	.release        = jbd2_seq_info_release,
 };
 
+static const struct file_operations jbd2_seq_hist_fops = {
+	.owner		= THIS_MODULE,
+	.open           = jbd2_seq_hist_open,
+	.read           = seq_read,
+	.llseek         = seq_lseek,
+	.release        = jbd2_seq_info_release,
+};
+
 static struct proc_dir_entry *proc_jbd2_stats;
 
 static void jbd2_stats_proc_init(journal_t *journal)
@@ -990,11 +1055,14 @@ static void jbd2_stats_proc_init(journal_t *journal)
 	if (journal->j_proc_entry) {
 		proc_create_data("info", S_IRUGO, journal->j_proc_entry,
 				 &jbd2_seq_info_fops, journal);
+		proc_create_data("hist", S_IRUGO, journal->j_proc_entry,
+				 &jbd2_seq_hist_fops, journal);
 	}
 }
 
 static void jbd2_stats_proc_exit(journal_t *journal)
 {
+	remove_proc_entry("hist", journal->j_proc_entry);
 	remove_proc_entry("info", journal->j_proc_entry);
 	remove_proc_entry(journal->j_devname, proc_jbd2_stats);
 }
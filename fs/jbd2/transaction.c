@@ -89,6 +89,7 @@ jbd2_get_transaction(journal_t *journal, transaction_t *transaction)
 	atomic_set(&transaction->t_updates, 0);
 	atomic_set(&transaction->t_outstanding_credits, 0);
 	atomic_set(&transaction->t_handle_count, 0);
+	atomic_set(&transaction->t_sync_count, 0);
 	INIT_LIST_HEAD(&transaction->t_inode_list);
 	INIT_LIST_HEAD(&transaction->t_private_list);
 
@@ -1354,6 +1355,52 @@ drop:
 	return err;
 }
 
+/*
+ * Sleep a little before forcing a commit of the transaction which started
+ * at @start, so that other synchronous writers can join it.
+ *
+ * We try and optimize the sleep time against what the underlying disk can
+ * do, instead of having a static sleep time.  Most of what a joiner saves
+ * is the write of the commit record and the cache flush behind it, so we
+ * measure how long that takes, compare it with how long this transaction
+ * has been running, and if run time < flush time then we sleep for the
+ * flush time and commit.  Until a flush has been measured the whole commit
+ * time is used instead.  This greatly helps super fast disks that would
+ * see slowdowns as more threads started doing fsyncs, and on eMMC lets
+ * concurrent fsyncs share one flush.
+ *
+ * But don't do this if this process was the most recent one to perform a
+ * synchronous write.  We do this to detect the case where a single process
+ * is doing a stream of sync writes.  No point in waiting for joiners in
+ * that case.
+ */
+void jbd2_sync_batch(journal_t *journal, ktime_t start)
+{
+	pid_t pid = current->pid;
+	u64 batch_time, trans_time;
+
+	if (journal->j_last_sync_writer == pid)
+		return;
+	journal->j_last_sync_writer = pid;
+
+	read_lock(&journal->j_state_lock);
+	batch_time = journal->j_average_flush_time;
+	if (!batch_time)
+		batch_time = journal->j_average_commit_time;
+	read_unlock(&journal->j_state_lock);
+
+	trans_time = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	batch_time = max_t(u64, batch_time, 1000*journal->j_min_batch_time);
+	batch_time = min_t(u64, batch_time, 1000*journal->j_max_batch_time);
+
+	if (trans_time < batch_time) {
+		ktime_t expires = ktime_add_ns(ktime_get(), batch_time);
+		set_current_state(TASK_UNINTERRUPTIBLE);
+		schedule_hrtimeout(&expires, HRTIMER_MODE_ABS);
+	}
+}
+
 /**
  * int jbd2_journal_stop() - complete a transaction
  * @handle: tranaction to complete.
@@ -1376,7 +1423,6 @@ int jbd2_journal_stop(handle_t *handle)
 	journal_t *journal = transaction->t_journal;
 	int err, wait_for_commit = 0;
 	tid_t tid;
-	pid_t pid;
 
 	J_ASSERT(journal_current_handle() == handle);
 
@@ -1404,52 +1450,13 @@ int jbd2_journal_stop(handle_t *handle)
 	 * and sleep on IO anyway.  Speeds up many-threaded, many-dir
 	 * operations by 30x or more...
 	 *
-	 * We try and optimize the sleep time against what the
-	 * underlying disk can do, instead of having a static sleep
-	 * time.  This is useful for the case where our storage is so
-	 * fast that it is more optimal to go ahead and force a flush
-	 * and wait for the transaction to be committed than it is to
-	 * wait for an arbitrary amount of time for new writers to
-	 * join the transaction.  We achieve this by measuring how
-	 * long it takes to commit a transaction, and compare it with
-	 * how long this transaction has been running, and if run time
-	 * < commit time then we sleep for the delta and commit.  This
-	 * greatly helps super fast disks that would see slowdowns as
-	 * more threads started doing fsyncs.
-	 *
-	 * But don't do this if this process was the most recent one
-	 * to perform a synchronous write.  We do this to detect the
-	 * case where a single process is doing a stream of sync
-	 * writes.  No point in waiting for joiners in that case.
+	 * See jbd2_sync_batch() for how long.
 	 */
-	pid = current->pid;
-	if (handle->h_sync && journal->j_last_sync_writer != pid) {
-		u64 commit_time, trans_time;
-
-		journal->j_last_sync_writer = pid;
-
-		read_lock(&journal->j_state_lock);
-		commit_time = journal->j_average_commit_time;
-		read_unlock(&journal->j_state_lock);
-
-		trans_time = ktime_to_ns(ktime_sub(ktime_get(),
-						   transaction->t_start_time));
-
-		commit_time = max_t(u64, commit_time,
-				    1000*journal->j_min_batch_time);
-		commit_time = min_t(u64, commit_time,
-				    1000*journal->j_max_batch_time);
-
-		if (trans_time < commit_time) {
-			ktime_t expires = ktime_add_ns(ktime_get(),
-						       commit_time);
-			set_current_state(TASK_UNINTERRUPTIBLE);
-			schedule_hrtimeout(&expires, HRTIMER_MODE_ABS);
-		}
-	}
-
-	if (handle->h_sync)
+	if (handle->h_sync) {
+		atomic_inc(&transaction->t_sync_count);
+		jbd2_sync_batch(journal, transaction->t_start_time);
 		transaction->t_synchronous_commit = 1;
+	}
 	current->journal_info = NULL;
 	atomic_sub(handle->h_buffer_credits,
 		   &transaction->t_outstanding_credits);
@@ -767,6 +767,149 @@ const struct file_operations proc_clear_refs_operations = {
 	.llseek		= noop_llseek,
 };
 
+#ifdef CONFIG_PROCESS_RECLAIM
+struct reclaim_param {
+	struct vm_area_struct *vma;
+	unsigned long nr_to_reclaim;	/* 0 for no limit */
+	unsigned long nr_reclaimed;
+};
+
+static int reclaim_pte_range(pmd_t *pmd, unsigned long addr,
+			     unsigned long end, struct mm_walk *walk)
+{
+	struct reclaim_param *rp = walk->private;
+	struct vm_area_struct *vma = rp->vma;
+	pte_t *pte, ptent;
+	spinlock_t *ptl;
+	struct page *page;
+	LIST_HEAD(page_list);
+	int isolated;
+
+	split_huge_page_pmd(walk->mm, pmd);
+	if (pmd_trans_unstable(pmd))
+		return 0;
+
+cont:
+	isolated = 0;
+	pte = pte_offset_map_lock(vma->vm_mm, pmd, addr, &ptl);
+	for (; addr != end; pte++, addr += PAGE_SIZE) {
+		ptent = *pte;
+		if (!pte_present(ptent))
+			continue;
+
+		page = vm_normal_page(vma, addr, ptent);
+		if (!page)
+			continue;
+
+		/* Pages shared with other processes are theirs too */
+		if (page_mapcount(page) != 1)
+			continue;
+
+		if (isolate_lru_page(page))
+			continue;
+
+		list_add(&page->lru, &page_list);
+		inc_zone_page_state(page, NR_ISOLATED_ANON +
+				    page_is_file_cache(page));
+		if (++isolated >= SWAP_CLUSTER_MAX) {
+			pte++;
+			addr += PAGE_SIZE;
+			break;
+		}
+	}
+	pte_unmap_unlock(pte - 1, ptl);
+
+	/* Pages can not be reclaimed with the page table lock held */
+	rp->nr_reclaimed += reclaim_pages_from_list(&page_list);
+	if (rp->nr_to_reclaim && rp->nr_reclaimed >= rp->nr_to_reclaim)
+		return 1;
+
+	cond_resched();
+	if (addr != end)
+		goto cont;
+
+	return 0;
+}
+
+#define RECLAIM_FILE 1
+#define RECLAIM_ANON 2
+#define RECLAIM_ALL (RECLAIM_FILE | RECLAIM_ANON)
+
+static ssize_t reclaim_write(struct file *file, const char __user *buf,
+			     size_t count, loff_t *ppos)
+{
+	struct task_struct *task;
+	char buffer[32];
+	char *type, *pages;
+	struct mm_struct *mm;
+	struct vm_area_struct *vma;
+	struct reclaim_param rp = { };
+	int types;
+	int rv;
+
+	memset(buffer, 0, sizeof(buffer));
+	if (count > sizeof(buffer) - 1)
+		count = sizeof(buffer) - 1;
+	if (copy_from_user(buffer, buf, count))
+		return -EFAULT;
+
+	/* "<file|anon|all> [pages]" */
+	pages = strstrip(buffer);
+	type = strsep(&pages, " \t");
+	if (!strcmp(type, "file"))
+		types = RECLAIM_FILE;
+	else if (!strcmp(type, "anon"))
+		types = RECLAIM_ANON;
+	else if (!strcmp(type, "all"))
+		types = RECLAIM_ALL;
+	else
+		return -EINVAL;
+	if (pages) {
+		rv = kstrtoul(skip_spaces(pages), 10, &rp.nr_to_reclaim);
+		if (rv < 0)
+			return rv;
+	}
+
+	task = get_proc_task(file->f_path.dentry->d_inode);
+	if (!task)
+		return -ESRCH;
+	mm = get_task_mm(task);
+	if (mm) {
+		struct mm_walk reclaim_walk = {
+			.pmd_entry = reclaim_pte_range,
+			.mm = mm,
+			.private = &rp,
+		};
+
+		down_read(&mm->mmap_sem);
+		for (vma = mm->mmap; vma; vma = vma->vm_next) {
+			if (is_vm_hugetlb_page(vma))
+				continue;
+			if (vma->vm_flags & VM_LOCKED)
+				continue;
+			if (!(types & RECLAIM_ANON) && !vma->vm_file)
+				continue;
+			if (!(types & RECLAIM_FILE) && vma->vm_file)
+				continue;
+			rp.vma = vma;
+			if (walk_page_range(vma->vm_start, vma->vm_end,
+					    &reclaim_walk))
+				break;
+		}
+		up_read(&mm->mmap_sem);
+		mmput(mm);
+	}
+	put_task_struct(task);
+
+	return count;
+}
+
+const struct file_operations proc_reclaim_operations = {
+	.write		= reclaim_write,
+	.llseek		= noop_llseek,
+};
+#endif
+
 typedef struct {
 	u64 pme;
 } pagemap_entry_t;
@@ -44,6 +44,13 @@ void setup_derived_state(struct inode *inode, perm_t perm,
 	info->d_uid = uid;
 	info->d_gid = gid;
 	info->d_mode = mode;
+	info->derived_seq++;
+}
+
+/* the next get_derived_permission() derives the state again */
+void invalidate_derived_state(struct inode *inode)
+{
+	SDCARDFS_I(inode)->derived_parent = NULL;
 }
 
 void get_derived_permission(struct dentry *parent, struct dentry *dentry)
@@ -51,8 +58,26 @@ void get_derived_permission(struct dentry *parent, struct dentry *dentry)
 	struct sdcardfs_sb_info *sbi = SDCARDFS_SB(dentry->d_sb);
 	struct sdcardfs_inode_info *info = SDCARDFS_I(dentry->d_inode);
 	struct sdcardfs_inode_info *parent_info= SDCARDFS_I(parent->d_inode);
+	unsigned int pkgl_gen = packagelist_generation(sbi->pkgl_id);
 	appid_t appid;
 
+	/* The state only depends on the parent's state, the name and the
+	 * package list. Lookups of the same inode again, which media scanning
+	 * does a lot, then skip the package list lock and hash.
+	 */
+	if (info->derived_parent == parent->d_inode &&
+			info->derived_parent_seq == parent_info->derived_seq &&
+			info->derived_name_hash == dentry->d_name.hash &&
+			info->derived_pkgl_gen == pkgl_gen)
+		return;
+
+	info->derived_parent = parent->d_inode;
+	info->derived_parent_seq = parent_info->derived_seq;
+	info->derived_name_hash = dentry->d_name.hash;
+	info->derived_pkgl_gen = pkgl_gen;
+	/* children derived from the previous state derive theirs again */
+	info->derived_seq++;
+
 	/* By default, each inode inherits from its parent.
 	 * the properties are maintained on its private fields
 	 * because the inode attributes will be modified with that of
@@ -492,6 +492,10 @@ static int sdcardfs_rename(struct inode *old_dir, struct dentry *old_dentry,
 	if (err)
 		goto out_err;
 
+	/* the name it was derived from is gone */
+	if (old_dentry->d_inode)
+		invalidate_derived_state(old_dentry->d_inode);
+
 	/* Copy attrs from lower dir, but i_uid/i_gid */
 	fsstack_copy_attr_all(new_dir, lower_new_dir_dentry->d_inode);
 	fsstack_copy_inode_size(new_dir, lower_new_dir_dentry->d_inode);
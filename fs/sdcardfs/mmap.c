@@ -48,6 +48,29 @@ static int sdcardfs_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 	return err;
 }
 
+/*
+ * The faulted pages belong to the lower page cache, shared writable
+ * mappings need the lower ->page_mkwrite to reserve their blocks.
+ */
+static int sdcardfs_page_mkwrite(struct vm_area_struct *vma,
+				 struct vm_fault *vmf)
+{
+	struct file *file;
+	const struct vm_operations_struct *lower_vm_ops;
+	struct vm_area_struct lower_vma;
+
+	memcpy(&lower_vma, vma, sizeof(struct vm_area_struct));
+	file = lower_vma.vm_file;
+	lower_vm_ops = SDCARDFS_F(file)->lower_vm_ops;
+	BUG_ON(!lower_vm_ops);
+	if (!lower_vm_ops->page_mkwrite)
+		return 0;
+
+	/* same workaround as sdcardfs_fault */
+	lower_vma.vm_file = sdcardfs_lower_file(file);
+	return lower_vm_ops->page_mkwrite(&lower_vma, vmf);
+}
+
 static ssize_t sdcardfs_direct_IO(int rw, struct kiocb *iocb, struct iov_iter *iter,
 			      loff_t offset)
 {
@@ -78,4 +101,5 @@ const struct address_space_operations sdcardfs_aops = {
 
 const struct vm_operations_struct sdcardfs_vm_ops = {
 	.fault		= sdcardfs_fault,
+	.page_mkwrite	= sdcardfs_page_mkwrite,
 };
@@ -38,6 +38,8 @@ struct packagelist_data {
 	DECLARE_HASHTABLE(package_to_appid,8);
 	DECLARE_HASHTABLE(appid_with_rw,7);
 	struct mutex hashtable_lock;
+	/* bumped under hashtable_lock whenever the tables are rebuilt */
+	unsigned int generation;
 	struct task_struct *thread_id;
 	gid_t write_gid;
 	char *strtok_last;
@@ -94,6 +96,16 @@ int get_caller_has_rw_locked(void *pkgl_id, derive_t derive) {
 	return ret;
 }
 
+/* Generation of the package list, to revalidate what was derived from it */
+unsigned int packagelist_generation(void *pkgl_id)
+{
+	struct packagelist_data *pkgl_dat = (struct packagelist_data *)pkgl_id;
+
+	if (!pkgl_dat)
+		return 0;
+	return ACCESS_ONCE(pkgl_dat->generation);
+}
+
 appid_t get_appid(void *pkgl_id, const char *app_name)
 {
 	struct packagelist_data *pkgl_dat = (struct packagelist_data *)pkgl_id;
@@ -215,6 +227,9 @@ static int read_package_list(struct packagelist_data *pkgl_dat) {
 	mutex_lock(&pkgl_dat->hashtable_lock);
 
 	remove_all_hashentrys(pkgl_dat);
+	/* get_appid() waits for the rebuild on the lock, so bumping it
+	 * here already makes every derived appid to be looked up again */
+	pkgl_dat->generation++;
 
 	fd = sys_open(kpackageslist_file, O_RDONLY, 0);
 	if (fd < 0) {
@@ -179,6 +179,13 @@ struct sdcardfs_inode_info {
 	uid_t d_uid;
 	gid_t d_gid;
 	mode_t d_mode;
+	/* what the state above was derived from, see get_derived_permission */
+	struct inode *derived_parent;
+	unsigned int derived_parent_seq;
+	unsigned int derived_name_hash;
+	unsigned int derived_pkgl_gen;
+	/* bumped whenever the state above is derived again */
+	unsigned int derived_seq;
 
 	struct inode vfs_inode;
 };
@@ -363,6 +370,7 @@ static inline void sdcardfs_put_real_lower(const struct dentry *dent,
 /* for packagelist.c */
 extern int get_caller_has_rw_locked(void *pkgl_id, derive_t derive);
 extern appid_t get_appid(void *pkgl_id, const char *app_name);
+extern unsigned int packagelist_generation(void *pkgl_id);
 extern int open_flags_to_access_mode(int open_flags);
 extern void * packagelist_create(gid_t write_gid);
 extern void packagelist_destroy(void *pkgl_id);
@@ -373,6 +381,7 @@ extern void packagelist_exit(void);
 extern void setup_derived_state(struct inode *inode, perm_t perm,
 			userid_t userid, uid_t uid, gid_t gid, mode_t mode);
 extern void get_derived_permission(struct dentry *parent, struct dentry *dentry);
+extern void invalidate_derived_state(struct inode *inode);
 extern void update_derived_permission(struct dentry *dentry);
 extern int need_graft_path(struct dentry *dentry);
 extern int is_base_obbpath(struct dentry *dentry);
@@ -24,6 +24,15 @@
 extern bool early_suspend_active;
 extern bool dyn_fsync_active;
 extern bool dyn_fdatasync_active;
+extern bool dyn_fsync_batch;
+extern int dyn_fsync_batched(struct file *file, loff_t start, loff_t end,
+			     int datasync);
+
+/* fsync returns at once, unless it is batched */
+static inline bool dyn_fsync_skip(void)
+{
+	return dyn_fsync_active && !dyn_fsync_batch && !early_suspend_active;
+}
 #endif
 
 #define VALID_FLAGS (SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE| \
@@ -236,17 +245,15 @@ SYSCALL_DEFINE1(syncfs, int, fd)
  */
 int vfs_fsync_range(struct file *file, loff_t start, loff_t end, int datasync)
 {
-#ifdef CONFIG_DYNAMIC_FSYNC
-	if (likely(dyn_fsync_active && !early_suspend_active))
-		return 0;
-	else {
-#endif
 	if (!file->f_op || !file->f_op->fsync)
 		return -EINVAL;
-	return file->f_op->fsync(file, start, end, datasync);
 #ifdef CONFIG_DYNAMIC_FSYNC
-	}
+	if (likely(dyn_fsync_skip()))
+		return 0;
+	if (dyn_fsync_active && dyn_fsync_batch && !early_suspend_active)
+		return dyn_fsync_batched(file, start, end, datasync);
 #endif
+	return file->f_op->fsync(file, start, end, datasync);
 }
 EXPORT_SYMBOL(vfs_fsync_range);
 
@@ -376,7 +383,7 @@ no_async:
 SYSCALL_DEFINE1(fsync, unsigned int, fd)
 {
 #ifdef CONFIG_DYNAMIC_FSYNC
-	if (likely(dyn_fsync_active && !early_suspend_active))
+	if (likely(dyn_fsync_skip()))
 		return 0;
 	else
 #endif
@@ -385,9 +392,11 @@ SYSCALL_DEFINE1(fsync, unsigned int, fd)
 
 SYSCALL_DEFINE1(fdatasync, unsigned int, fd)
 {
-	if (likely(dyn_fsync_active && dyn_fdatasync_active && !early_suspend_active))
+#ifdef CONFIG_DYNAMIC_FSYNC
+	if (likely(dyn_fdatasync_active && dyn_fsync_skip()))
 		return 0;
 	else
+#endif
 		return do_fsync(fd, 1);
 }
 
@@ -459,7 +468,7 @@ SYSCALL_DEFINE(sync_file_range)(int fd, loff_t offset, loff_t nbytes,
 				unsigned int flags)
 {
 #ifdef CONFIG_DYNAMIC_FSYNC
-	if (likely(dyn_fsync_active && !early_suspend_active))
+	if (likely(dyn_fsync_skip()))
 		return 0;
 	else {
 #endif
@@ -563,7 +572,7 @@ SYSCALL_DEFINE(sync_file_range2)(int fd, unsigned int flags,
 				 loff_t offset, loff_t nbytes)
 {
 #ifdef CONFIG_DYNAMIC_FSYNC
-	if (likely(dyn_fsync_active && !early_suspend_active))
+	if (likely(dyn_fsync_skip()))
 		return 0;
 	else
 #endif
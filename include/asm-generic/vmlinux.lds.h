@@ -619,6 +619,7 @@
 #define INIT_CALLS_LEVEL(level)						\
 		VMLINUX_SYMBOL(__initcall##level##_start) = .;		\
 		*(.initcall##level##.init)				\
+		VMLINUX_SYMBOL(__initcall##level##s_start) = .;		\
 		*(.initcall##level##s.init)				\
 
 #define INIT_CALLS							\
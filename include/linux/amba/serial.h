@@ -203,6 +203,9 @@ struct amba_pl011_data {
 	bool (*dma_filter)(struct dma_chan *chan, void *filter_param);
 	void *dma_rx_param;
 	void *dma_tx_param;
+	unsigned int dma_rx_buf_size;	/* bytes, 0 for a page */
+	unsigned int dma_rx_poll_rate;	/* ms, 0 to leave DMA RX unpolled */
+	unsigned int dma_rx_poll_timeout; /* idle ms before polling stops */
         void (*init) (void);
 	void (*exit) (void);
 	void (*reset) (void);
@@ -42,11 +42,18 @@ enum bdi_stat_item {
 	BDI_WRITEBACK,
 	BDI_DIRTIED,
 	BDI_WRITTEN,
+	BDI_READAHEAD,		/* pages read ahead */
+	BDI_RA_HIT,		/* of those, pages used */
+	BDI_RA_WASTE,		/* of those, pages dropped unused */
 	NR_BDI_STAT_ITEMS
 };
 
 #define BDI_STAT_BATCH (8*(1+ilog2(nr_cpu_ids)))
 
+#define BDI_RA_SCALE_SHIFT	8
+#define BDI_RA_SCALE_ONE	(1U << BDI_RA_SCALE_SHIFT)
+#define BDI_RA_TARGET_USEC	4000
+
 struct bdi_writeback {
 	struct backing_dev_info *bdi;	/* our parent bdi */
 	unsigned int nr;
@@ -95,6 +102,15 @@ struct backing_dev_info {
 	unsigned int min_ratio;
 	unsigned int max_ratio, max_prop_frac;
 
+	unsigned int wb_depth;	/* background writes allowed, 0: no limit */
+
+	/* readahead scaled to the read latency, see block/blk-ra.c */
+	unsigned int ra_target_usec;	/* time to read a window, 0: off */
+	unsigned int ra_scale;		/* of ra_pages, BDI_RA_SCALE_ONE is 1 */
+	unsigned long ra_avg_bytes;	/* average read request size */
+	unsigned long ra_avg_ns;	/* average read request time */
+	unsigned long ra_mmap_pages;	/* read-around of read-only mmaps */
+
 	struct bdi_writeback wb;  /* default writeback info for this bdi */
 	spinlock_t wb_lock;	  /* protects work_list */
 
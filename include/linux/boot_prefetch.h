@@ -0,0 +1,27 @@
+#ifndef _LINUX_BOOT_PREFETCH_H
+#define _LINUX_BOOT_PREFETCH_H
+
+#include <linux/types.h>
+
+struct file;
+
+#ifdef CONFIG_BOOT_PREFETCH
+extern bool boot_prefetch_recording;
+extern void __boot_prefetch_record(struct file *filp, pgoff_t offset,
+				   unsigned long nr);
+
+/* Record a read of @nr pages from @offset, while boot reads are recorded */
+static inline void boot_prefetch_record(struct file *filp, pgoff_t offset,
+					unsigned long nr)
+{
+	if (unlikely(boot_prefetch_recording))
+		__boot_prefetch_record(filp, offset, nr);
+}
+#else
+static inline void boot_prefetch_record(struct file *filp, pgoff_t offset,
+					unsigned long nr)
+{
+}
+#endif
+
+#endif /* _LINUX_BOOT_PREFETCH_H */
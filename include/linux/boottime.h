@@ -14,6 +14,16 @@
 #ifndef LINUX_BOOTTIME_H
 #define LINUX_BOOTTIME_H
 
+/**
+ * struct boottime_initcall - State of an initcall being timed.
+ * @time: Time in us when the initcall was called
+ * @cpu: CPU time in ns used by the calling task by then
+ */
+struct boottime_initcall {
+	unsigned long time;
+	unsigned long long cpu;
+};
+
 #ifdef CONFIG_BOOTTIME
 #include <linux/kernel.h>
 
@@ -76,6 +86,22 @@ void __init boottime_deactivate(void);
  */
 void __init boottime_system_up(void);
 
+/**
+ * boottime_initcall_start()
+ * Called by the task about to call an initcall.
+ * @bi: Filled with the state to pass to boottime_initcall_end().
+ */
+void boottime_initcall_start(struct boottime_initcall *bi);
+
+/**
+ * boottime_initcall_end()
+ * Called by the same task when the initcall has returned, records the
+ * wall and CPU time of the initcall.
+ * @fn: The initcall.
+ * @bi: As filled by boottime_initcall_start().
+ */
+void boottime_initcall_end(void *fn, struct boottime_initcall *bi);
+
 #else
 
 #define boottime_mark_wtime(name, time)
@@ -84,6 +110,15 @@ void __init boottime_system_up(void);
 #define boottime_activate(bt)
 #define boottime_deactivate()
 #define boottime_system_up()
+
+static inline void boottime_initcall_start(struct boottime_initcall *bi)
+{
+}
+
+static inline void boottime_initcall_end(void *fn,
+					 struct boottime_initcall *bi)
+{
+}
 #endif
 
 #endif /* LINUX_BOOTTIME_H */
@@ -105,6 +105,14 @@ static inline bool compaction_deferred(struct zone *zone, int order)
 
 #endif /* CONFIG_COMPACTION */
 
+#ifdef CONFIG_COMPACTION_BACKGROUND
+extern void compaction_stall(int order);
+#else
+static inline void compaction_stall(int order)
+{
+}
+#endif
+
 #if defined(CONFIG_COMPACTION) && defined(CONFIG_SYSFS) && defined(CONFIG_NUMA)
 extern int compaction_register_node(struct node *node);
 extern void compaction_unregister_node(struct node *node);
@@ -87,6 +87,8 @@ enum compdev_flag {
 enum compdev_ptr_type {
 	COMPDEV_PTR_PHYSICAL,
 	COMPDEV_PTR_HWMEM_BUF_NAME_OFFSET,
+	/* A dma-buf fd of a hwmem buffer, in buf.fd */
+	COMPDEV_PTR_DMA_BUF_FD_OFFSET,
 };
 
 enum compdev_listener_state {
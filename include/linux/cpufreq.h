@@ -339,6 +339,18 @@ static inline unsigned int cpufreq_quick_get_max(unsigned int cpu)
 }
 #endif
 
+#ifdef CONFIG_CPU_FREQ_RECORD
+void cpufreq_record_vsync(void);
+#else
+static inline void cpufreq_record_vsync(void) { }
+#endif
+
+#ifdef CONFIG_CPU_FREQ_INPUT_BOOST
+void cpufreq_input_boost_kick(unsigned int duration_ms);
+#else
+static inline void cpufreq_input_boost_kick(unsigned int duration_ms) { }
+#endif
+
 
 /*********************************************************************
  *                       CPUFREQ DEFAULT GOVERNOR                    *
@@ -452,4 +464,12 @@ void cpufreq_frequency_table_put_attr(unsigned int cpu);
 
 void acct_update_power(struct task_struct *p, cputime_t cputime);
 
+#ifdef CONFIG_UID_CPUTIME_FREQ
+void uid_cputime_account_freq(uid_t uid, unsigned int freq,
+			      unsigned int usecs, unsigned long long power);
+#else
+static inline void uid_cputime_account_freq(uid_t uid, unsigned int freq,
+			unsigned int usecs, unsigned long long power) { }
+#endif
+
 #endif /* _LINUX_CPUFREQ_H */
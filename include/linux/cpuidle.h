@@ -16,6 +16,7 @@
 #include <linux/kobject.h>
 #include <linux/completion.h>
 #include <linux/hrtimer.h>
+#include <linux/cpumask.h>
 
 #define CPUIDLE_STATE_MAX	8
 #define CPUIDLE_NAME_LEN	16
@@ -25,6 +26,7 @@ struct module;
 
 struct cpuidle_device;
 struct cpuidle_driver;
+struct cpuidle_coupled;
 
 
 /****************************
@@ -57,6 +59,7 @@ struct cpuidle_state {
 
 /* Idle State Flags */
 #define CPUIDLE_FLAG_TIME_VALID	(0x01) /* is residency time measurable? */
+#define CPUIDLE_FLAG_COUPLED	(0x02) /* state applies to multiple cpus */
 
 #define CPUIDLE_DRIVER_FLAGS_MASK (0xFFFF0000)
 
@@ -100,6 +103,12 @@ struct cpuidle_device {
 	struct list_head 	device_list;
 	struct kobject		kobj;
 	struct completion	kobj_unregister;
+
+#ifdef CONFIG_ARCH_NEEDS_CPU_IDLE_COUPLED
+	int			safe_state_index;
+	cpumask_t		coupled_cpus;
+	struct cpuidle_coupled	*coupled;
+#endif
 };
 
 DECLARE_PER_CPU(struct cpuidle_device *, cpuidle_devices);
@@ -151,6 +160,20 @@ extern int cpuidle_wrap_enter(struct cpuidle_device *dev,
 					struct cpuidle_driver *drv, int index));
 extern int cpuidle_play_dead(void);
 
+DECLARE_PER_CPU(unsigned int, cpuidle_exit_latency);
+
+/**
+ * cpuidle_get_exit_latency - exit latency of the state a cpu is idling in
+ * @cpu: the target CPU
+ *
+ * Returns 0 when the cpu is not in a cpuidle state. The value is a hint,
+ * the cpu may be waking up while it is read.
+ */
+static inline unsigned int cpuidle_get_exit_latency(int cpu)
+{
+	return ACCESS_ONCE(per_cpu(cpuidle_exit_latency, cpu));
+}
+
 #else
 static inline void disable_cpuidle(void) { }
 static inline int cpuidle_idle_call(void) { return -ENODEV; }
@@ -173,7 +196,12 @@ static inline int cpuidle_wrap_enter(struct cpuidle_device *dev,
 					struct cpuidle_driver *drv, int index))
 { return -ENODEV; }
 static inline int cpuidle_play_dead(void) {return -ENODEV; }
+static inline unsigned int cpuidle_get_exit_latency(int cpu) { return 0; }
+
+#endif
 
+#ifdef CONFIG_ARCH_NEEDS_CPU_IDLE_COUPLED
+void cpuidle_coupled_parallel_barrier(struct cpuidle_device *dev, atomic_t *a);
 #endif
 
 /******************************
@@ -188,6 +188,8 @@ extern struct klist *bus_get_device_klist(struct bus_type *bus);
  * @owner:	The module owner.
  * @mod_name:	Used for built-in modules.
  * @suppress_bind_attrs: Disables bind/unbind via sysfs.
+ * @probe_late: Set by the driver core while the devices of the driver are
+ *		left for the late probe, see driver_probe_late().
  * @of_match_table: The open firmware table.
  * @probe:	Called to query the existence of a specific device,
  *		whether this driver can work with it, and bind the driver
@@ -220,6 +222,7 @@ struct device_driver {
 	const char		*mod_name;	/* used for built-in modules */
 
 	bool suppress_bind_attrs;	/* disables bind/unbind via sysfs */
+	bool probe_late;
 
 	const struct of_device_id	*of_match_table;
 
@@ -238,6 +241,7 @@ struct device_driver {
 
 extern int __must_check driver_register(struct device_driver *drv);
 extern void driver_unregister(struct device_driver *drv);
+extern int driver_probe_late(const char *name);
 
 extern struct device_driver *driver_find(const char *name,
 					 struct bus_type *bus);
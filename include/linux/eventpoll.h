@@ -26,6 +26,20 @@
 #define EPOLL_CTL_DEL 2
 #define EPOLL_CTL_MOD 3
 
+/*
+ * Coalesce the wakeups for the target file descriptor: the epoll_wait()
+ * callers are woken once per batching window (/proc/sys/fs/epoll/batch_usecs)
+ * instead of once per event.
+ */
+#define EPOLLBATCH (1 << 27)
+
+/*
+ * Set exclusive wakeup mode for the target file descriptor: of the epoll
+ * instances watching it with this flag, only one is woken per event.
+ * Only valid with EPOLL_CTL_ADD.
+ */
+#define EPOLLEXCLUSIVE (1 << 28)
+
 /*
  * Request the handling of system wakeup events so as to prevent system suspends
  * from happening while those events are being processed.
@@ -0,0 +1,63 @@
+/*
+ * include/linux/hotplug_mgr.h
+ *
+ * Arbitration of CPU hotplug requests.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ */
+
+#ifndef _LINUX_HOTPLUG_MGR_H
+#define _LINUX_HOTPLUG_MGR_H
+
+#include <linux/list.h>
+#include <linux/errno.h>
+
+/*
+ * A client vote on the number of online CPUs. 0 means no opinion.
+ *
+ * @min_cpus is a demand, the highest demand of all clients wins.
+ * @max_cpus is a limit, the lowest limit wins and it also wins over any
+ * demand. Load driven clients (governors, use-cases) should only demand,
+ * limits are meant for thermal and userspace.
+ */
+struct hotplug_request {
+	struct list_head node;
+	const char *name;
+	unsigned int min_cpus;
+	unsigned int max_cpus;
+};
+
+#ifdef CONFIG_CPU_HOTPLUG_MGR
+int hotplug_mgr_add_request(struct hotplug_request *req, const char *name,
+			    unsigned int min_cpus, unsigned int max_cpus);
+void hotplug_mgr_update_request(struct hotplug_request *req,
+				unsigned int min_cpus, unsigned int max_cpus);
+void hotplug_mgr_remove_request(struct hotplug_request *req);
+void hotplug_mgr_vote_cpu(struct hotplug_request *req, unsigned int cpu,
+			  bool online);
+#else
+static inline int hotplug_mgr_add_request(struct hotplug_request *req,
+			const char *name, unsigned int min_cpus,
+			unsigned int max_cpus)
+{
+	return -ENOSYS;
+}
+
+static inline void hotplug_mgr_update_request(struct hotplug_request *req,
+			unsigned int min_cpus, unsigned int max_cpus)
+{
+}
+
+static inline void hotplug_mgr_remove_request(struct hotplug_request *req)
+{
+}
+
+static inline void hotplug_mgr_vote_cpu(struct hotplug_request *req,
+			unsigned int cpu, bool online)
+{
+}
+#endif
+
+#endif /* _LINUX_HOTPLUG_MGR_H */
@@ -358,6 +358,9 @@ extern int hrtimer_start(struct hrtimer *timer, ktime_t tim,
 			 const enum hrtimer_mode mode);
 extern int hrtimer_start_range_ns(struct hrtimer *timer, ktime_t tim,
 			unsigned long range_ns, const enum hrtimer_mode mode);
+extern int hrtimer_start_slack(struct hrtimer *timer, ktime_t tim,
+			const enum hrtimer_mode mode,
+			enum timer_slack_class class);
 extern int
 __hrtimer_start_range_ns(struct hrtimer *timer, ktime_t tim,
 			 unsigned long delta_ns,
@@ -18,6 +18,7 @@
 #include <sys/types.h>
 #else
 #include <linux/mm_types.h>
+#include <linux/err.h>
 #endif
 
 #define HWMEM_DEFAULT_DEVICE_NAME "hwmem"
@@ -66,6 +67,11 @@ enum hwmem_alloc_flags {
 	 * @brief Inner cache only
 	 */
 	HWMEM_ALLOC_HINT_INNER_CACHE_ONLY      = (1 << 9),
+	/**
+	 * @brief Don't clear the buffer if it is recycled from a buffer
+	 * previously allocated by the same thread group
+	 */
+	HWMEM_ALLOC_HINT_NO_CLEAR              = (1 << 10),
 	/**
 	 * @brief Reserved for use by the cache handler integration
 	 */
@@ -368,6 +374,31 @@ struct hwmem_get_info_request {
  */
 #define HWMEM_IMPORT_FD_IOC _IO('W', 12)
 
+/**
+ * @brief Export the buffer as a dma-buf.
+ *
+ * The dma-buf holds a buffer reference and keeps the buffer alive until its
+ * last fd is closed. Any process holding the fd can import the buffer, with
+ * the access given by the fd's file mode.
+ *
+ * Input is the buffer identifier. If 0 is specified the buffer associated with
+ * the current file instance will be exported.
+ *
+ * @return A dma-buf fd on success, or a negative error code.
+ */
+#define HWMEM_EXPORT_DMA_BUF_IOC _IO('W', 13)
+
+/**
+ * @brief Import a buffer exported as a dma-buf to allow local access to the
+ * buffer.
+ *
+ * Input is the dma-buf fd.
+ *
+ * @return The imported buffer's identifier on success, or a negative error
+ * code.
+ */
+#define HWMEM_IMPORT_DMA_BUF_IOC _IO('W', 14)
+
 #ifdef __KERNEL__
 
 /* Kernel API */
@@ -592,6 +623,44 @@ struct hwmem_alloc *hwmem_resolve_by_name(s32 name);
  */
 struct hwmem_alloc *hwmem_resolve_by_vm_addr(void *vm_addr);
 
+struct dma_buf;
+
+#ifdef CONFIG_HWMEM_DMA_BUF
+/**
+ * @brief Export the buffer as a dma-buf. The dma-buf adds a buffer reference
+ * that is released when the dma-buf is released.
+ *
+ * @param alloc Buffer to be exported.
+ * @param flags File flags of the dma-buf, e.g. O_RDWR.
+ *
+ * @return Pointer to dma-buf, or a negative error code.
+ */
+struct dma_buf *hwmem_export_dma_buf(struct hwmem_alloc *alloc, int flags);
+
+/**
+ * @brief Resolve a hwmem allocation pointer from a dma-buf fd of a buffer
+ * exported by hwmem. This call will add a buffer reference. Resulting buffer
+ * should be released with a call to hwmem_release.
+ *
+ * @param fd A dma-buf fd.
+ *
+ * @return Pointer to hwmem allocation, or a negative error code. -EINVAL if
+ * the dma-buf is not a hwmem buffer.
+ */
+struct hwmem_alloc *hwmem_resolve_by_dma_buf_fd(int fd);
+#else
+static inline struct dma_buf *hwmem_export_dma_buf(struct hwmem_alloc *alloc,
+								int flags)
+{
+	return ERR_PTR(-ENOSYS);
+}
+
+static inline struct hwmem_alloc *hwmem_resolve_by_dma_buf_fd(int fd)
+{
+	return ERR_PTR(-ENOSYS);
+}
+#endif
+
 /* Integration */
 
 struct hwmem_allocator_api {
@@ -25,6 +25,25 @@ int hwmon_notifier_register(struct notifier_block *nb);
 int hwmon_notifier_unregister(struct notifier_block *nb);
 void hwmon_notify(unsigned long val, void *v);
 
+/* In-kernel readings of the ux500 sensors, see the drivers */
+#if defined(CONFIG_SENSORS_AB8500)
+int abx500_temp_read(int index, int *val);
+#else
+static inline int abx500_temp_read(int index, int *val)
+{
+	return -ENODEV;
+}
+#endif
+
+#if defined(CONFIG_SENSORS_DBX500)
+int dbx500_temp_read(void);
+#else
+static inline int dbx500_temp_read(void)
+{
+	return -ENODEV;
+}
+#endif
+
 /* Scale user input to sensible values */
 static inline int SENSORS_LIMIT(long value, long low, long high)
 {
@@ -109,9 +109,10 @@ enum {
 	INET_DIAG_TOS,
 	INET_DIAG_TCLASS,
 	INET_DIAG_SKMEMINFO,
+	INET_DIAG_CELLINFO,
 };
 
-#define INET_DIAG_MAX INET_DIAG_SKMEMINFO
+#define INET_DIAG_MAX INET_DIAG_CELLINFO
 
 
 /* INET_DIAG_MEM */
@@ -132,6 +133,18 @@ struct tcpvegas_info {
 	__u32	tcpv_minrtt;
 };
 
+/* INET_DIAG_CELLINFO */
+
+struct tcpcell_info {
+	__u32	tcpc_mode;	/* STARTUP, DRAIN, PROBE_BW, PROBE_RTT */
+	__u32	tcpc_bw_lo;	/* delivery rate in bytes per second */
+	__u32	tcpc_bw_hi;
+	__u32	tcpc_min_rtt;	/* usecs */
+	__u32	tcpc_rtt;	/* minimum RTT of the current round, usecs */
+	__u32	tcpc_bdp;	/* packets */
+	__u32	tcpc_gain;	/* cwnd gain of the PROBE_BW phase, << 8 */
+};
+
 #ifdef __KERNEL__
 struct net;
 struct sock;
@@ -159,6 +159,8 @@ extern void (*late_time_init)(void);
 
 extern bool initcall_debug;
 
+int initcall_async(initcall_t fn);
+
 #endif
   
 #ifndef MODULE
@@ -210,6 +212,22 @@ extern bool initcall_debug;
 #define late_initcall(fn)		__define_initcall("7",fn,7)
 #define late_initcall_sync(fn)		__define_initcall("7s",fn,7s)
 
+/*
+ * An async initcall runs in parallel with the initcalls that follow it in
+ * its level, on any CPU. The _sync initcalls of the level and the later
+ * levels run after it has returned, an initcall that needs it done goes
+ * there. Only for initcalls nothing else in their level depends on.
+ */
+#define __define_initcall_async(level,fn,id) \
+	static int __init __async_##fn##id(void) \
+	{ return initcall_async(fn); } \
+	__define_initcall(level,__async_##fn##id,id)
+
+#define subsys_initcall_async(fn)	__define_initcall_async("4",fn,4)
+#define fs_initcall_async(fn)		__define_initcall_async("5",fn,5)
+#define device_initcall_async(fn)	__define_initcall_async("6",fn,6)
+#define late_initcall_async(fn)		__define_initcall_async("7",fn,7)
+
 #define __initcall(fn) device_initcall(fn)
 
 #define __exitcall(fn) \
@@ -290,6 +308,11 @@ void __init parse_early_options(char *cmdline);
 #define device_initcall(fn)		module_init(fn)
 #define late_initcall(fn)		module_init(fn)
 
+#define subsys_initcall_async(fn)	module_init(fn)
+#define fs_initcall_async(fn)		module_init(fn)
+#define device_initcall_async(fn)	module_init(fn)
+#define late_initcall_async(fn)		module_init(fn)
+
 #define security_initcall(fn)		module_init(fn)
 
 /* Each module must use one module_init(). */
@@ -1165,8 +1165,13 @@ struct ff_effect {
 #include <linux/device.h>
 #include <linux/fs.h>
 #include <linux/timer.h>
+#include <linux/ktime.h>
 #include <linux/mod_devicetable.h>
 
+/* The first latency bucket is up to INPUT_LATENCY_MIN_US microseconds */
+#define INPUT_LATENCY_BUCKETS	10
+#define INPUT_LATENCY_MIN_US	250
+
 /**
  * struct input_dev - represents an input device
  * @name: name of the device
@@ -1244,6 +1249,11 @@ struct ff_effect {
  * @going_away: marks devices that are in a middle of unregistering and
  *	causes input_open_device*() fail with -ENODEV.
  * @sync: set to %true when there were no new events since last EV_SYN
+ * @timestamp: time of the hardware event the current frame reports, set
+ *	by the driver with input_set_timestamp(). Zero when not set, the
+ *	events are then stamped when they are reported
+ * @latency: counts of the frames read by userspace, by latency from
+ *	their timestamp, in buckets of doubling width
  * @dev: driver model's view of this device
  * @h_list: list of input handles associated with the device. When
  *	accessing the list dev->mutex must be held
@@ -1313,6 +1323,9 @@ struct input_dev {
 
 	bool sync;
 
+	ktime_t timestamp;
+	atomic_t latency[INPUT_LATENCY_BUCKETS];
+
 	struct device dev;
 
 	struct list_head	h_list;
@@ -1539,6 +1552,22 @@ static inline void input_mt_sync(struct input_dev *dev)
 	input_event(dev, EV_SYN, SYN_MT_REPORT, 0);
 }
 
+/**
+ * input_set_timestamp - stamp the current frame with the hardware event time
+ * @dev: input device
+ * @timestamp: CLOCK_MONOTONIC time of the hardware event, typically taken
+ *	in the hard interrupt handler
+ *
+ * The events up to the next input_sync() carry this time instead of the time
+ * they are reported at.
+ */
+static inline void input_set_timestamp(struct input_dev *dev, ktime_t timestamp)
+{
+	dev->timestamp = timestamp;
+}
+
+void input_account_latency(struct input_dev *dev, ktime_t timestamp);
+
 void input_set_capability(struct input_dev *dev, unsigned int type, unsigned int code);
 
 /**
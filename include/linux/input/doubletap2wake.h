@@ -38,4 +38,18 @@ extern void dt2w_set_scr_suspended(bool);
 /* PowerKey setter */
 extern void doubletap2wake_setdev(struct input_dev *);
 
+/*
+ * Low power scan of the touch controller while the screen is off: a
+ * reduced scan rate, with an interrupt only once a finger is down.
+ * enter() returns 0 when the controller went to low power scan, exit()
+ * brings it back to the normal scan rate.
+ */
+struct dt2w_lp_ops {
+	int (*enter)(void *priv);
+	void (*exit)(void *priv);
+};
+
+/* Low power scan setter, called by the touch driver */
+extern void doubletap2wake_set_lp_ops(const struct dt2w_lp_ops *, void *);
+
 #endif	/* _LINUX_SWEEP2WAKE_H */
@@ -386,6 +386,12 @@ extern void remove_percpu_irq(unsigned int irq, struct irqaction *act);
 
 extern void irq_cpu_online(void);
 extern void irq_cpu_offline(void);
+
+#ifdef CONFIG_IRQ_TIME_STATS
+extern void irq_time_stats_wakeup(unsigned int irq);
+#else
+static inline void irq_time_stats_wakeup(unsigned int irq) { }
+#endif
 extern int __irq_set_affinity_locked(struct irq_data *data,  const struct cpumask *cpumask);
 
 #ifdef CONFIG_GENERIC_HARDIRQS
@@ -17,6 +17,7 @@ struct module;
  * @irq_data:		per irq and chip data passed down to chip functions
  * @timer_rand_state:	pointer to timer rand state struct
  * @kstat_irqs:		irq stats per cpu
+ * @time_stats:		irq handling time stats per cpu
  * @handle_irq:		highlevel irq-events handler
  * @preflow_handler:	handler called before the flow handler (currently used by sparc)
  * @action:		the irq action chain
@@ -39,9 +40,32 @@ struct module;
  * @dir:		/proc/irq/ procfs entry
  * @name:		flow handler name for /proc/interrupts output
  */
+#ifdef CONFIG_IRQ_TIME_STATS
+/**
+ * struct irq_time_stats - per cpu handling time statistics of an interrupt
+ * @handler_ns:		time spent in the hard irq handlers
+ * @handler_max_ns:	longest run of the hard irq handlers
+ * @thread_delay_ns:	time from the wake up to the run of the handler threads
+ * @thread_delay_max_ns: longest delay of a handler thread
+ * @thread_runs:	number of handler thread runs
+ * @wakeups:		number of times the interrupt woke a cpu from idle
+ */
+struct irq_time_stats {
+	u64			handler_ns;
+	u64			handler_max_ns;
+	u64			thread_delay_ns;
+	u64			thread_delay_max_ns;
+	unsigned int		thread_runs;
+	unsigned int		wakeups;
+};
+#endif
+
 struct irq_desc {
 	struct irq_data		irq_data;
 	unsigned int __percpu	*kstat_irqs;
+#ifdef CONFIG_IRQ_TIME_STATS
+	struct irq_time_stats __percpu *time_stats;
+#endif
 	irq_flow_handler_t	handle_irq;
 #ifdef CONFIG_IRQ_PREFLOW_FASTEOI
 	irq_preflow_handler_t	preflow_handler;
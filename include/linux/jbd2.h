@@ -592,6 +592,12 @@ struct transaction_s
 	 */
 	atomic_t		t_handle_count;
 
+	/*
+	 * How many synchronous handles and fsyncs waited for this
+	 * transaction? [no locking]
+	 */
+	atomic_t		t_sync_count;
+
 	/*
 	 * This transaction is being forced and some process is
 	 * waiting for it to finish.
@@ -618,11 +624,17 @@ struct transaction_run_stats_s {
 	__u32			rs_handle_count;
 	__u32			rs_blocks;
 	__u32			rs_blocks_logged;
+	__u32			rs_sync_count;
 };
 
+/* Power of two buckets of the commit time in ms and of the logged blocks */
+#define JBD2_HIST_SLOTS	12
+
 struct transaction_stats_s {
 	unsigned long		ts_tid;
 	struct transaction_run_stats_s run;
+	unsigned long		ts_time_hist[JBD2_HIST_SLOTS];
+	unsigned long		ts_size_hist[JBD2_HIST_SLOTS];
 };
 
 static inline unsigned long
@@ -913,6 +925,12 @@ struct journal_s
 	 */
 	u64			j_average_commit_time;
 
+	/*
+	 * the average amount of time in nanoseconds it takes to write the
+	 * commit record and flush the device cache. [j_state_lock]
+	 */
+	u64			j_average_flush_time;
+
 	/*
 	 * minimum and maximum times that we should wait for
 	 * additional filesystem operations to get batched into a
@@ -980,6 +998,7 @@ void jbd2_update_log_tail(journal_t *journal, tid_t tid, unsigned long block);
 
 /* Commit management */
 extern void jbd2_journal_commit_transaction(journal_t *);
+extern void jbd2_sync_batch(journal_t *, ktime_t);
 
 /* Checkpoint list management */
 int __jbd2_journal_clean_checkpoint_list(journal_t *journal, bool destroy);
@@ -84,4 +84,16 @@ int lz4_decompress(const unsigned char *src, size_t *src_len,
  */
 int lz4_decompress_unknownoutputsize(const unsigned char *src, size_t src_len,
 		unsigned char *dest, size_t *dest_len);
+
+#ifdef CONFIG_LZ4_DECOMPRESS_NEON
+/*
+ * NEON flavours of the decompressors, only to be called between
+ * kernel_neon_begin() and kernel_neon_end(). lz4_decompress() and
+ * lz4_decompress_unknownoutputsize() use them when they can.
+ */
+int lz4_decompress_neon(const unsigned char *src, size_t *src_len,
+		unsigned char *dest, size_t actual_dest_len);
+int lz4_decompress_unknownoutputsize_neon(const unsigned char *src,
+		size_t src_len, unsigned char *dest, size_t *dest_len);
+#endif
 #endif
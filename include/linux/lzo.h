@@ -27,6 +27,15 @@ int lzo1x_1_compress(const unsigned char *src, size_t src_len,
 int lzo1x_decompress_safe(const unsigned char *src, size_t src_len,
 			  unsigned char *dst, size_t *dst_len);
 
+#ifdef CONFIG_LZO_DECOMPRESS_NEON
+/*
+ * NEON flavour of lzo1x_decompress_safe(), which it uses when it can. Only
+ * to be called between kernel_neon_begin() and kernel_neon_end().
+ */
+int lzo1x_decompress_safe_neon(const unsigned char *src, size_t src_len,
+			       unsigned char *dst, size_t *dst_len);
+#endif
+
 /*
  * Return values (< 0 = Error)
  */
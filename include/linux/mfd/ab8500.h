@@ -240,6 +240,7 @@ enum ab8500_version {
 #define AB9540_NUM_IRQ_REGS		20
 /* Forward declaration */
 struct ab8500_charger;
+struct ab8500_reg_cache;
 
 /**
  * struct ab8500 - ab8500 internal structure
@@ -260,6 +261,7 @@ struct ab8500_charger;
  * @mask_size: Actual number of valid entries in mask[], oldmask[] and
  * irq_reg_offset
  * @irq_reg_offset: Array of offsets into IRQ registers
+ * @reg_cache: write-through cache of the non-volatile registers
  */
 struct ab8500 {
 	struct device	*dev;
@@ -283,6 +285,7 @@ struct ab8500 {
 	u8 *oldmask;
 	int mask_size;
 	const int *irq_reg_offset;
+	struct ab8500_reg_cache *reg_cache;
 };
 
 struct ab8500_regulator_platform_data;
@@ -313,6 +313,8 @@ struct ab8500_fg;
  * @high_curr_time:		Time current has to be high to go to recovery
  * @accu_charging:		FG accumulation time while charging
  * @accu_high_curr:		FG accumulation time in high current mode
+ * @accu_low_curr:		FG accumulation time in low current mode, 0 to
+ *				use accu_high_curr
  * @high_curr_threshold:	High current threshold, in mA
  * @lowbat_threshold:		Low battery threshold, in mV
  * @battok_falling_th_sel0	Threshold in mV for battOk signal sel0
@@ -334,6 +336,7 @@ struct ab8500_fg_parameters {
 	int high_curr_time;
 	int accu_charging;
 	int accu_high_curr;
+	int accu_low_curr;
 	int high_curr_threshold;
 	int lowbat_threshold;
 	int battok_falling_th_sel0;
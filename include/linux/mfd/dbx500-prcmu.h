@@ -468,6 +468,14 @@ enum prcmu_val {
 int prcmu_set_val(enum prcmu_val type, u32 value);
 int prcmu_get_val(enum prcmu_val type);
 
+typedef void (*prcmu_val_complete_t)(enum prcmu_val type, u8 value,
+				     int status, void *data);
+
+int prcmu_set_val_async(enum prcmu_val type, u8 value,
+			prcmu_val_complete_t complete, void *data);
+void prcmu_cancel_val_async(enum prcmu_val type);
+void prcmu_flush_val_async(enum prcmu_val type);
+
 /*  prcmu_enable/prcmu_disable */
 enum prcmu_out {
 	SPI2_MUX,
@@ -672,10 +680,13 @@ void prcmu_disable_stm_ape(void);
 unsigned long prcmu_qos_get_cpufreq_opp_delay(void);
 void prcmu_qos_set_cpufreq_opp_delay(unsigned long);
 void prcmu_qos_force_opp(int, s32);
+int prcmu_qos_set_ceiling(int prcmu_qos_class, s32 value);
 int prcmu_qos_requirement(int pm_qos_class);
 bool prcmu_qos_requirement_is_active(int prcmu_qos_class, char *name);
 int prcmu_qos_add_requirement(int pm_qos_class, char *name, s32 value);
 int prcmu_qos_update_requirement(int pm_qos_class, char *name, s32 new_value);
+int prcmu_qos_update_requirement_timeout(int pm_qos_class, char *name,
+					 s32 new_value, unsigned int timeout_ms);
 void prcmu_qos_remove_requirement(int pm_qos_class, char *name);
 int prcmu_qos_add_notifier(int prcmu_qos_class,
 			   struct notifier_block *notifier);
@@ -695,6 +706,11 @@ static inline void prcmu_qos_set_cpufreq_opp_delay(unsigned long n) {}
 
 static inline void prcmu_qos_force_opp(int prcmu_qos_class, s32 i) {}
 
+static inline int prcmu_qos_set_ceiling(int prcmu_qos_class, s32 value)
+{
+	return 0;
+}
+
 static inline int prcmu_qos_requirement(int prcmu_qos_class)
 {
 	return 0;
@@ -712,6 +728,12 @@ static inline int prcmu_qos_update_requirement(int prcmu_qos_class,
 	return 0;
 }
 
+static inline int prcmu_qos_update_requirement_timeout(int prcmu_qos_class,
+		char *name, s32 new_value, unsigned int timeout_ms)
+{
+	return 0;
+}
+
 static inline void prcmu_qos_remove_requirement(int prcmu_qos_class, char *name)
 {
 }
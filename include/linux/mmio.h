@@ -136,6 +136,21 @@ struct trace_buf_t {
 	unsigned int size;
 };
 
+/*
+ * A capture buffer, given by hwmem name or by dma-buf fd. Registering pins
+ * it and returns the address to program the ISP with. cpu_access is the
+ * hwmem access of MMIO_CAM_SYNC_BUF, zero to hand the buffer back to the
+ * ISP, B2R2 and compdev.
+ */
+struct capture_buf_t {
+	int handle;
+	unsigned int is_dma_buf;
+	unsigned int id;
+	unsigned long phys_addr;
+	unsigned int size;
+	unsigned int cpu_access;
+};
+
 #ifdef SRA_SUPPORT
 struct s_reg {
 	unsigned int addr;
@@ -158,6 +173,7 @@ struct mmio_input_output_t {
 		struct xshutdown_info_t	xshutdown_info;
 		enum camera_slot_t	camera_slot;
 		struct trace_buf_t	trace_buf;
+		struct capture_buf_t	capture_buf;
 #ifdef SRA_SUPPORT
 		struct s_reg_list s_reg_list;
 #endif
@@ -218,6 +234,12 @@ struct mmio_input_output_t*)
 #define MMIO_CAM_POWER_PIN_CONTROL  _IOW(MMIO_MAGIC_NUMBER, 0x16, int*)
 #define MMIO_CAM_FRONT_CAM_ID       _IOW(MMIO_MAGIC_NUMBER, 0x17, int*)
 #define MMIO_CAM_REAR_VENDOR_ID     _IOW(MMIO_MAGIC_NUMBER, 0x18, int*)
+#define MMIO_CAM_REGISTER_BUF	_IOWR(MMIO_MAGIC_NUMBER, 0x19,\
+struct mmio_input_output_t*)
+#define MMIO_CAM_UNREGISTER_BUF	_IOW(MMIO_MAGIC_NUMBER, 0x1A,\
+struct mmio_input_output_t*)
+#define MMIO_CAM_SYNC_BUF	_IOW(MMIO_MAGIC_NUMBER, 0x1B,\
+struct mmio_input_output_t*)
 #endif /* USER_SIDE_INTERFACE */
 
 #endif
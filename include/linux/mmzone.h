@@ -340,6 +340,14 @@ struct zone {
 	/* zone watermarks, access with *_wmark_pages(zone) macros */
 	unsigned long watermark[NR_WMARK];
 
+	/*
+	 * Pages kswapd frees over the low and high watermarks after a
+	 * fragmenting fallback or an allocation stall, until it has balanced
+	 * the zone with them or they expire, see zone_watermark_boost()
+	 */
+	unsigned long watermark_boost;
+	unsigned long watermark_boost_expires;
+
 	/*
 	 * When free pages are below this point, additional steps are taken
 	 * when reading the number of free pages to avoid per-cpu counter
@@ -496,6 +504,9 @@ typedef enum {
 	ZONE_CONGESTED,			/* zone has many dirty pages backed by
 					 * a congested BDI
 					 */
+	ZONE_BOOSTED_WATERMARK,		/* watermark boosted, kswapd to be
+					 * woken by the allocation
+					 */
 } zone_flags_t;
 
 static inline void zone_set_flag(struct zone *zone, zone_flags_t flag)
@@ -508,6 +519,12 @@ static inline int zone_test_and_set_flag(struct zone *zone, zone_flags_t flag)
 	return test_and_set_bit(flag, &zone->flags);
 }
 
+static inline int zone_test_and_clear_flag(struct zone *zone,
+					   zone_flags_t flag)
+{
+	return test_and_clear_bit(flag, &zone->flags);
+}
+
 static inline void zone_clear_flag(struct zone *zone, zone_flags_t flag)
 {
 	clear_bit(flag, &zone->flags);
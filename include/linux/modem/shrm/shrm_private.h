@@ -66,11 +66,15 @@ typedef void (*MSG_PENDING_NOTIF)(const u32 Wptr);
  * @availablesize:	available memory in fifo
  * @end_addr_fifo:	fifo end addr
  * @fifo_virtual_addr:	fifo virtual addr
- * @fifo_update_lock:	spin lock to update fifo.
  *
  * On writting a message to FIFO the same has to be read by the modem before
  * writing the next message to the FIFO. In oder to over come this a local
  * write and read pointer is used for internal purpose.
+ *
+ * The FIFO is a single producer, single consumer ring: the writers of a
+ * channel are serialised by their callers and own writer_local_wptr, the read
+ * notification owns writer_local_rptr. The pointers are published with
+ * barriers, no lock is taken.
  */
 struct fifo_write_params {
 	u32 writer_local_rptr;
@@ -80,7 +84,6 @@ struct fifo_write_params {
 	u32 availablesize;
 	u32 end_addr_fifo;
 	u32 *fifo_virtual_addr;
-	spinlock_t fifo_update_lock;
 } ;
 
 /**
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) ST-Ericsson AB 2011
+ *
+ * Modem Audio Driver, mmap interface
+ *
+ * License terms:GNU General Public License (GPLv2)version 2
+ */
+
+#ifndef __MODEM_AUDIO_H
+#define __MODEM_AUDIO_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*
+ * Offsets to mmap() /dev/mad at: the control page, the DSP buffers the
+ * decoded frames are read from and the DSP buffers the encoded frames are
+ * written to. The buffers of a window start at its rx_offset/tx_offset.
+ */
+#define MAD_MMAP_CTRL		0x00000
+#define MAD_MMAP_RX		0x10000
+#define MAD_MMAP_TX		0x20000
+#define MAD_MMAP_WINDOW		0x10000
+
+#define MAD_RX_RING_SIZE	32	/* power of two */
+#define MAD_TX_BATCH_MAX	8
+
+struct mad_rx_desc {
+	__u32 len;		/* bytes in the buffer */
+	__u32 index;		/* buffer number in the RX window */
+};
+
+/*
+ * The control page. The driver adds a descriptor at rx_head for each
+ * decoded frame, the reader advances rx_tail past those it is done with.
+ * setup is bumped each time the DSP sets its buffers up again, after
+ * which the windows must be mapped again.
+ */
+struct mad_ctrl {
+	__u32 rx_head;		/* written by the driver */
+	__u32 rx_tail;		/* written by the reader */
+	__u32 setup;
+	__u32 rx_offset;
+	__u32 rx_buf_size;
+	__u32 rx_nr_bufs;
+	__u32 tx_offset;
+	__u32 tx_buf_size;
+	__u32 tx_nr_bufs;
+	__u32 tx_next;		/* buffer the next frame is written to */
+	__u32 rx_overflows;
+	struct mad_rx_desc rx_desc[MAD_RX_RING_SIZE];
+};
+
+/* Frames written in the TX window from tx_next on, to hand to the DSP */
+struct mad_tx_batch {
+	__u32 nr;
+	__u32 len[MAD_TX_BATCH_MAX];
+};
+
+#define MAD_IO_NUMBER		0xfd
+/* Decoded frames to wait for before poll() and read() return */
+#define MAD_SET_WAKEUP		_IOW(MAD_IO_NUMBER, 1, __u32)
+#define MAD_TX_SEND		_IOW(MAD_IO_NUMBER, 2, struct mad_tx_batch)
+
+#endif
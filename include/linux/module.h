@@ -287,6 +287,9 @@ struct module
 	/* Size of RO sections of the module (text+rodata) */
 	unsigned int init_ro_size, core_ro_size;
 
+	/* Time taken to load and link the module, and by its init */
+	unsigned int load_us, init_us;
+
 	/* Arch-specific module values */
 	struct mod_arch_specific arch;
 
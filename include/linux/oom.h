@@ -67,6 +67,49 @@ static inline void oom_killer_enable(void)
 
 extern struct task_struct *find_lock_task_mm(struct task_struct *p);
 
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_ADJ_INDEX
+/*
+ * Thread group leaders hashed by oom_score_adj, so the lowmemorykiller
+ * only has to look at the highest populated buckets to pick a victim.
+ * Bucket lists are protected by oom_adj_index_lock, which is never
+ * taken inside tasklist_lock, task_lock or siglock.
+ */
+#define OOM_ADJ_BUCKETS		64
+#define OOM_ADJ_BUCKET_WIDTH	\
+	DIV_ROUND_UP(OOM_SCORE_ADJ_MAX - OOM_SCORE_ADJ_MIN + 1, OOM_ADJ_BUCKETS)
+
+static inline int oom_adj_bucket(int oom_score_adj)
+{
+	return (oom_score_adj - OOM_SCORE_ADJ_MIN) / OOM_ADJ_BUCKET_WIDTH;
+}
+
+extern struct hlist_head oom_adj_buckets[OOM_ADJ_BUCKETS];
+extern spinlock_t oom_adj_index_lock;
+
+extern void oom_adj_index_add(struct task_struct *p);
+extern void oom_adj_index_del(struct task_struct *p);
+extern void oom_adj_index_update(struct task_struct *p);
+extern void oom_adj_index_replace(struct task_struct *old,
+				  struct task_struct *new);
+#else
+static inline void oom_adj_index_add(struct task_struct *p)
+{
+}
+
+static inline void oom_adj_index_del(struct task_struct *p)
+{
+}
+
+static inline void oom_adj_index_update(struct task_struct *p)
+{
+}
+
+static inline void oom_adj_index_replace(struct task_struct *old,
+					 struct task_struct *new)
+{
+}
+#endif
+
 /* sysctls */
 extern int sysctl_oom_dump_tasks;
 extern int sysctl_oom_kill_allocating_task;
@@ -8,9 +8,9 @@
 
 #include <linux/mm.h>
 #include <linux/spinlock.h>
-#include <mach/memory.h>
 
 #ifdef CONFIG_PASR
+#include <mach/memory.h>
 
 /**
  * struct pasr_section - Represent either a DDR Bank or Segment depending on
@@ -22,6 +22,8 @@
  * @free_size: Represents the free memory size in the segment.
  * @lock: Protect the free_size counter
  * @die: Pointer to the Die the segment is part of.
+ * @held: The segment has been emptied before suspend and is held by PASR
+ *	until resume.
  */
 struct pasr_section {
 	phys_addr_t start;
@@ -29,6 +31,7 @@ struct pasr_section {
 	unsigned long free_size;
 	spinlock_t *lock;
 	struct pasr_die *die;
+	bool held;
 };
 
 /**
@@ -112,6 +115,17 @@ void pasr_put(phys_addr_t paddr, unsigned long size);
 void pasr_get(phys_addr_t paddr, unsigned long size);
 
 
+/**
+ * pasr_pick_block()
+ *
+ * @list: Non empty buddy free list of MAX_ORDER - 1 blocks.
+ *
+ * Returns the block to allocate from the list. Blocks located in the
+ * segments holding the least free memory are preferred, so that the nearly
+ * empty segments get a chance to become completely free.
+ */
+struct page *pasr_pick_block(struct list_head *list);
+
 static inline void pasr_kput(struct page *page, int order)
 {
 	if (order != MAX_ORDER - 1)
@@ -133,6 +147,8 @@ int __init late_pasr_setup(void);
 int __init pasr_init_core(struct pasr_map *);
 
 #else
+#define pasr_pick_block(list) list_entry((list)->next, struct page, lru)
+
 #define pasr_kput(page, order) do {} while (0)
 #define pasr_kget(page, order) do {} while (0)
 
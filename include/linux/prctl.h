@@ -133,6 +133,15 @@
 #define PR_SET_VMA		0x53564d41
 # define PR_SET_VMA_ANON_NAME		0
 
+/*
+ * Frame deadline hint of a thread
+ * arg3 work in us the thread does before each vsync, 0 clears the hint
+ * arg4 pid of the thread, 0 for the caller
+ */
+#define PR_FRAME_DEADLINE	0x46524d44
+# define PR_FRAME_DEADLINE_SET		0
+# define PR_FRAME_DEADLINE_GET		1
+
 /*
  * If no_new_privs is set, then operations that grant new privileges (i.e.
  * execve) will either fail or not grant them.  This affects suid/sgid,
@@ -140,6 +140,97 @@ extern unsigned long nr_running(void);
 extern unsigned long nr_uninterruptible(void);
 extern unsigned long nr_iowait(void);
 extern unsigned long nr_iowait_cpu(int cpu);
+
+/*
+ * Runqueue events reported to a load notifier. The hook is called with
+ * the runqueue lock (or the task's pi_lock for migrations) held and
+ * interrupts disabled, so it must not sleep or wake up tasks.
+ */
+enum sched_load_event {
+	SCHED_LOAD_ENQUEUE,
+	SCHED_LOAD_DEQUEUE,
+	SCHED_LOAD_WAKEUP,
+	SCHED_LOAD_MIGRATE,
+};
+
+#ifdef CONFIG_SCHED_LOAD_NOTIFY
+
+/*
+ * @nr_running is the number of runnable tasks on @cpu after the event,
+ * @burst the runtime in ns of the task's last slice on a CPU.
+ */
+typedef void (*sched_load_notify_t)(int cpu, enum sched_load_event event,
+				    unsigned int nr_running, u64 burst);
+
+extern int sched_load_notify_register(sched_load_notify_t fn);
+extern void sched_load_notify_unregister(sched_load_notify_t fn);
+extern unsigned long nr_running_cpu(int cpu);
+#endif
+
+#ifdef CONFIG_CGROUP_FREQ_HINTS
+/*
+ * Busy time in us of down-weighted task groups on @cpu, which governors
+ * add to the idle time, and the frequency floor in kHz of the groups with
+ * tasks runnable on @cpu.
+ */
+extern u64 sched_freq_discount_us(int cpu);
+extern unsigned int sched_freq_floor(int cpu);
+#else
+static inline u64 sched_freq_discount_us(int cpu)
+{
+	return 0;
+}
+
+static inline unsigned int sched_freq_floor(int cpu)
+{
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_SCHED_CPU_PARK
+extern int sched_cpu_park(int cpu);
+extern int sched_cpu_unpark(int cpu);
+extern bool cpu_parked(int cpu);
+#else
+static inline int sched_cpu_park(int cpu)
+{
+	return -ENOSYS;
+}
+
+static inline int sched_cpu_unpark(int cpu)
+{
+	return 0;
+}
+
+static inline bool cpu_parked(int cpu)
+{
+	return false;
+}
+#endif
+
+struct task_struct;
+
+#ifdef CONFIG_SCHED_FRAME_DEADLINE
+extern void sched_frame_vsync(u64 timestamp);
+extern int sched_frame_set_budget(struct task_struct *p,
+				  unsigned int budget_us);
+extern void sched_frame_exit(struct task_struct *p);
+#else
+static inline void sched_frame_vsync(u64 timestamp)
+{
+}
+
+static inline int sched_frame_set_budget(struct task_struct *p,
+					 unsigned int budget_us)
+{
+	return -EINVAL;
+}
+
+static inline void sched_frame_exit(struct task_struct *p)
+{
+}
+#endif
+
 extern unsigned long this_cpu_load(void);
 
 
@@ -1331,6 +1422,9 @@ struct task_struct {
 #ifdef CONFIG_SMP
 	struct plist_node pushable_tasks;
 #endif
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_ADJ_INDEX
+	struct hlist_node oom_adj_node;	/* thread group leaders only */
+#endif
 
 	struct mm_struct *mm, *active_mm;
 #ifdef CONFIG_COMPAT_BRK
@@ -1597,6 +1691,19 @@ struct task_struct {
 	unsigned long timer_slack_ns;
 	unsigned long default_timer_slack_ns;
 
+#ifdef CONFIG_SCHED_FRAME_DEADLINE
+	/* Work in us the task has to do before each vsync, 0 if none */
+	unsigned int frame_budget_us;
+	unsigned int frame_boost_seq;
+	unsigned int frame_boosts;
+	unsigned int frame_missed;
+	struct list_head frame_node;
+#endif
+#ifdef CONFIG_CGROUP_FREQ_HINTS
+	/* Counted in the freq_floor_nr of its runqueue */
+	bool sched_freq_floor;
+#endif
+
 	struct list_head	*scm_work_list;
 #ifdef CONFIG_FUNCTION_GRAPH_TRACER
 	/* Index of current stored address in ret_stack */
@@ -1816,6 +1923,8 @@ extern void thread_group_times(struct task_struct *p, cputime_t *ut, cputime_t *
 
 extern int task_free_register(struct notifier_block *n);
 extern int task_free_unregister(struct notifier_block *n);
+extern int mm_exit_register(struct notifier_block *n);
+extern int mm_exit_unregister(struct notifier_block *n);
 
 /*
  * Per process flags
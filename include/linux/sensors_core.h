@@ -11,9 +11,51 @@
 #ifndef __LINUX_SENSORS_CORE_H_INCLUDED
 #define __LINUX_SENSORS_CORE_H_INCLUDED
 
+#include <linux/input.h>
+#include <linux/kfifo.h>
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
 extern struct class *sensors_class;
 extern int sensors_register(struct device *dev,
 	void *drvdata, struct device_attribute *attributes[], char *name);
 extern void sensors_unregister(struct device *dev);
 
+/*
+ * Batching of sensor events. The events of the samples are kept in a FIFO
+ * and reported to the input device together, once the oldest sample is
+ * max_latency ms old or the FIFO is full, so that the readers of the input
+ * device are woken once per batch instead of once per sample. Every event
+ * keeps the time it was taken at as its timestamp.
+ */
+
+/* Most events of one sample, SYN_REPORT included */
+#define SENSORS_BATCH_SAMPLE_EVENTS	8
+
+struct sensors_batch_event {
+	ktime_t time;
+	u16 type;
+	u16 code;
+	s32 value;
+};
+
+struct sensors_batch {
+	struct input_dev *input;
+	DECLARE_KFIFO_PTR(fifo, struct sensors_batch_event);
+	spinlock_t lock;
+	struct delayed_work flush_work;
+	unsigned int max_latency;
+	unsigned int dropped;
+};
+
+extern int sensors_batch_init(struct sensors_batch *batch,
+	struct input_dev *input, unsigned int size);
+extern void sensors_batch_destroy(struct sensors_batch *batch);
+extern void sensors_batch_event(struct sensors_batch *batch,
+	unsigned int type, unsigned int code, int value);
+extern void sensors_batch_flush(struct sensors_batch *batch);
+extern void sensors_batch_set_latency(struct sensors_batch *batch,
+	unsigned int max_latency);
+
 #endif	/* __LINUX_SENSORS_CORE_H_INCLUDED */
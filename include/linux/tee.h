@@ -161,6 +161,18 @@ struct tee_operation {
 
 struct tee_context {};
 
+/**
+ * struct tee_invocation - One command of a teec_invoke_commands() batch.
+ * @command_id: Identifier of the command in the trusted application.
+ * @operation: The payload of the command.
+ * @result: The result of the command, TEED_ERROR_CANCEL if it was not run.
+ */
+struct tee_invocation {
+	unsigned int command_id;
+	struct tee_operation *operation;
+	uint32_t result;
+};
+
 /**
  * struct tee_session - The session of an open tee device.
  * @state: The current state in the linux kernel.
@@ -296,7 +308,8 @@ int teec_open_session(struct tee_context *context, struct tee_session *session,
  * @param session: The opened session to close.
  *
  * Closes the session which has been opened with the specific trusted
- * application.
+ * application. The TA itself is kept open in the secure world for a while
+ * (tee_driver.keepalive_ms), for the next session to the same UUID.
  */
 int teec_close_session(struct tee_session *session);
 
@@ -317,6 +330,23 @@ int teec_invoke_command(struct tee_session *session, unsigned int command_id,
 			struct tee_operation *operation,
 			unsigned int *error_origin);
 
+/**
+ * teec_invoke_commands() - Executes several commands in the specified trusted
+ * application.
+ * @param session: The opened session.
+ * @param invocations: The commands to execute, in order.
+ * @param count: Number of entries in invocations.
+ * @param error_origin: A parameter which will hold the error origin if this
+ *                      function returns any value other than TEEC_SUCCESS.
+ *
+ * Executes the commands back to back without letting other clients of the
+ * TEE in between. The commands after a failed one are not run. Returns the
+ * result of the failed command, or TEEC_SUCCESS.
+ */
+int teec_invoke_commands(struct tee_session *session,
+			 struct tee_invocation *invocations,
+			 unsigned int count, unsigned int *error_origin);
+
 /**
  * teec_allocate_shared_memory() - Allocate shared memory for TEE.
  * @param context: The initialized TEE context structure in which scope to
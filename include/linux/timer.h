@@ -214,6 +214,28 @@ extern int mod_timer_pinned(struct timer_list *timer, unsigned long expires);
 
 extern void set_timer_slack(struct timer_list *time, int slack_hz);
 
+/*
+ * Slack classes, for timers that may run late by a fraction of their
+ * timeout, so that close expirations are handled in one wakeup.
+ */
+enum timer_slack_class {
+	TIMER_SLACK_EXACT,		/* no slack */
+	TIMER_SLACK_DEFAULT,		/* 1/256 of the timeout */
+	TIMER_SLACK_RELAXED,		/* periodic housekeeping */
+	TIMER_SLACK_BACKGROUND,		/* polling nobody waits for */
+	TIMER_SLACK_CLASSES,
+};
+
+/* Slack values below -1 select a class */
+#define TIMER_SLACK_CLASS_BASE	(-2)
+
+extern void set_timer_slack_class(struct timer_list *timer,
+				  enum timer_slack_class class);
+extern unsigned long timer_slack_class_delta(enum timer_slack_class class,
+					     unsigned long delta);
+extern void timer_coalesce_batch(bool hrtimer, unsigned int fired,
+				 unsigned int coalesced);
+
 #define TIMER_NOT_PINNED	0
 #define TIMER_PINNED		1
 /*
@@ -272,6 +294,14 @@ static inline void timer_stats_timer_clear_start_info(struct timer_list *timer)
 }
 #endif
 
+#ifdef CONFIG_TIMER_WAKEUP_STATS
+extern void timer_wakeup_account(void *fn);
+#else
+static inline void timer_wakeup_account(void *fn)
+{
+}
+#endif
+
 extern void add_timer(struct timer_list *timer);
 
 extern int try_to_del_timer_sync(struct timer_list *timer);
@@ -0,0 +1,155 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM b2r2
+
+#if !defined(_TRACE_B2R2_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_B2R2_H
+
+#include <linux/tracepoint.h>
+
+/*
+ * The life of a blit request, as seen by the B2R2 driver. All events carry
+ * the address of the job structure of the request, which links the events
+ * of one request together before it has got a job id.
+ *
+ * b2r2_request is emitted when the request is taken for processing. The
+ * b2r2_resolve, b2r2_node_gen and b2r2_cache_sync events tell the CPU time
+ * in nanoseconds spent resolving the buffers, building the node list and
+ * doing cache maintenance of the buffers. b2r2_hw_start is emitted when the
+ * job is put in a hardware queue, b2r2_hw_done when the hardware is done
+ * with it, with the time the job was active in hardware. b2r2_callback is
+ * emitted when the done (or cancelled) request has been handled.
+ */
+TRACE_EVENT(b2r2_request,
+
+	TP_PROTO(const void *job, u32 flags, u32 src_fmt, u32 dst_fmt,
+		s32 dst_width, s32 dst_height),
+
+	TP_ARGS(job, flags, src_fmt, dst_fmt, dst_width, dst_height),
+
+	TP_STRUCT__entry(
+		__field(	const void *,	job		)
+		__field(	u32,		flags		)
+		__field(	u32,		src_fmt		)
+		__field(	u32,		dst_fmt		)
+		__field(	s32,		dst_width	)
+		__field(	s32,		dst_height	)
+	),
+
+	TP_fast_assign(
+		__entry->job = job;
+		__entry->flags = flags;
+		__entry->src_fmt = src_fmt;
+		__entry->dst_fmt = dst_fmt;
+		__entry->dst_width = dst_width;
+		__entry->dst_height = dst_height;
+	),
+
+	TP_printk("job=%p flags=%#x src_fmt=%#x dst_fmt=%#x dst=%dx%d",
+		__entry->job, __entry->flags, __entry->src_fmt,
+		__entry->dst_fmt, __entry->dst_width, __entry->dst_height)
+);
+
+DECLARE_EVENT_CLASS(b2r2_stage,
+
+	TP_PROTO(const void *job, s64 nsec),
+
+	TP_ARGS(job, nsec),
+
+	TP_STRUCT__entry(
+		__field(	const void *,	job		)
+		__field(	s64,		nsec		)
+	),
+
+	TP_fast_assign(
+		__entry->job = job;
+		__entry->nsec = nsec;
+	),
+
+	TP_printk("job=%p nsec=%lld", __entry->job, __entry->nsec)
+);
+
+DEFINE_EVENT(b2r2_stage, b2r2_resolve,
+	TP_PROTO(const void *job, s64 nsec),
+	TP_ARGS(job, nsec)
+);
+
+DEFINE_EVENT(b2r2_stage, b2r2_node_gen,
+	TP_PROTO(const void *job, s64 nsec),
+	TP_ARGS(job, nsec)
+);
+
+DEFINE_EVENT(b2r2_stage, b2r2_cache_sync,
+	TP_PROTO(const void *job, s64 nsec),
+	TP_ARGS(job, nsec)
+);
+
+TRACE_EVENT(b2r2_hw_start,
+
+	TP_PROTO(const void *job, int job_id, int queue),
+
+	TP_ARGS(job, job_id, queue),
+
+	TP_STRUCT__entry(
+		__field(	const void *,	job		)
+		__field(	int,		job_id		)
+		__field(	int,		queue		)
+	),
+
+	TP_fast_assign(
+		__entry->job = job;
+		__entry->job_id = job_id;
+		__entry->queue = queue;
+	),
+
+	TP_printk("job=%p job_id=%d queue=%d",
+		__entry->job, __entry->job_id, __entry->queue)
+);
+
+TRACE_EVENT(b2r2_hw_done,
+
+	TP_PROTO(const void *job, int job_id, s64 nsec_in_hw),
+
+	TP_ARGS(job, job_id, nsec_in_hw),
+
+	TP_STRUCT__entry(
+		__field(	const void *,	job		)
+		__field(	int,		job_id		)
+		__field(	s64,		nsec_in_hw	)
+	),
+
+	TP_fast_assign(
+		__entry->job = job;
+		__entry->job_id = job_id;
+		__entry->nsec_in_hw = nsec_in_hw;
+	),
+
+	TP_printk("job=%p job_id=%d nsec_in_hw=%lld",
+		__entry->job, __entry->job_id, __entry->nsec_in_hw)
+);
+
+TRACE_EVENT(b2r2_callback,
+
+	TP_PROTO(const void *job, int job_id, int state),
+
+	TP_ARGS(job, job_id, state),
+
+	TP_STRUCT__entry(
+		__field(	const void *,	job		)
+		__field(	int,		job_id		)
+		__field(	int,		state		)
+	),
+
+	TP_fast_assign(
+		__entry->job = job;
+		__entry->job_id = job_id;
+		__entry->state = state;
+	),
+
+	TP_printk("job=%p job_id=%d state=%d",
+		__entry->job, __entry->job_id, __entry->state)
+);
+
+#endif /* _TRACE_B2R2_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
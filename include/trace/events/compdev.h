@@ -0,0 +1,81 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM compdev
+
+#if !defined(_TRACE_COMPDEV_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_COMPDEV_H
+
+#include <linux/tracepoint.h>
+
+/*
+ * The frames composed through compdev. A frame gets its id when the
+ * compositor posts the scene info of the frame, or when a single buffer
+ * is posted asynchronously, compdev_frame is emitted then. compdev_blit
+ * links the B2R2 request done for a buffer of the frame to it, by the job
+ * id of the b2r2_hw_start and b2r2_hw_done events. compdev_commit is
+ * emitted when the frame is handed to the MCDE channel, whose scanout
+ * event tells when the frame reached the display.
+ */
+TRACE_EVENT(compdev_frame,
+
+	TP_PROTO(int dev, u32 frame, int img_count),
+
+	TP_ARGS(dev, frame, img_count),
+
+	TP_STRUCT__entry(
+		__field(	int,		dev		)
+		__field(	u32,		frame		)
+		__field(	int,		img_count	)
+	),
+
+	TP_fast_assign(
+		__entry->dev = dev;
+		__entry->frame = frame;
+		__entry->img_count = img_count;
+	),
+
+	TP_printk("dev=%d frame=%u img_count=%d",
+		__entry->dev, __entry->frame, __entry->img_count)
+);
+
+TRACE_EVENT(compdev_blit,
+
+	TP_PROTO(u32 frame, int job_id),
+
+	TP_ARGS(frame, job_id),
+
+	TP_STRUCT__entry(
+		__field(	u32,		frame		)
+		__field(	int,		job_id		)
+	),
+
+	TP_fast_assign(
+		__entry->frame = frame;
+		__entry->job_id = job_id;
+	),
+
+	TP_printk("frame=%u job_id=%d", __entry->frame, __entry->job_id)
+);
+
+TRACE_EVENT(compdev_commit,
+
+	TP_PROTO(u32 frame, int chnl),
+
+	TP_ARGS(frame, chnl),
+
+	TP_STRUCT__entry(
+		__field(	u32,		frame		)
+		__field(	int,		chnl		)
+	),
+
+	TP_fast_assign(
+		__entry->frame = frame;
+		__entry->chnl = chnl;
+	),
+
+	TP_printk("frame=%u chnl=%d", __entry->frame, __entry->chnl)
+);
+
+#endif /* _TRACE_COMPDEV_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
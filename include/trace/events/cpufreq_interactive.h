@@ -82,6 +82,41 @@ DEFINE_EVENT(loadeval, cpufreq_interactive_notyet,
 	    TP_ARGS(cpu_id, load, curtarg, curactual, newtarg)
 );
 
+DEFINE_EVENT(loadeval, cpufreq_interactive_sched_ramp,
+	    TP_PROTO(unsigned long cpu_id, unsigned long load,
+		     unsigned long curtarg, unsigned long curactual,
+		     unsigned long newtarg),
+	    TP_ARGS(cpu_id, load, curtarg, curactual, newtarg)
+);
+
+TRACE_EVENT(cpufreq_interactive_sched_load,
+	    TP_PROTO(unsigned long cpu_id, int event,
+		     unsigned long nr_running, u64 burst),
+	    TP_ARGS(cpu_id, event, nr_running, burst),
+
+	    TP_STRUCT__entry(
+		    __field(unsigned long, cpu_id     )
+		    __field(          int, event      )
+		    __field(unsigned long, nr_running )
+		    __field(          u64, burst      )
+	    ),
+
+	    TP_fast_assign(
+		    __entry->cpu_id = cpu_id;
+		    __entry->event = event;
+		    __entry->nr_running = nr_running;
+		    __entry->burst = burst;
+	    ),
+
+	    TP_printk("cpu=%lu event=%s nr_running=%lu burst=%llu",
+		      __entry->cpu_id,
+		      __print_symbolic(__entry->event,
+				       { 0, "enqueue" }, { 1, "dequeue" },
+				       { 2, "wakeup" }, { 3, "migrate" }),
+		      __entry->nr_running,
+		      (unsigned long long)__entry->burst)
+);
+
 TRACE_EVENT(cpufreq_interactive_boost,
 	    TP_PROTO(char *s),
 	    TP_ARGS(s),
@@ -0,0 +1,70 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM dma40
+
+#if !defined(_TRACE_DMA40_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_DMA40_H
+
+#include <linux/tracepoint.h>
+
+/*
+ * Entry and exit of the DMA40 interrupt handler and of the channel tasklets
+ * that run the client callbacks, to tell the CPU time spent in them.
+ */
+DECLARE_EVENT_CLASS(d40_irq,
+
+	TP_PROTO(int irq),
+
+	TP_ARGS(irq),
+
+	TP_STRUCT__entry(
+		__field(	int,	irq	)
+	),
+
+	TP_fast_assign(
+		__entry->irq = irq;
+	),
+
+	TP_printk("irq=%d", __entry->irq)
+);
+
+DEFINE_EVENT(d40_irq, d40_interrupt_entry,
+	TP_PROTO(int irq),
+	TP_ARGS(irq)
+);
+
+DEFINE_EVENT(d40_irq, d40_interrupt_exit,
+	TP_PROTO(int irq),
+	TP_ARGS(irq)
+);
+
+DECLARE_EVENT_CLASS(d40_chan,
+
+	TP_PROTO(int chan_id),
+
+	TP_ARGS(chan_id),
+
+	TP_STRUCT__entry(
+		__field(	int,	chan_id	)
+	),
+
+	TP_fast_assign(
+		__entry->chan_id = chan_id;
+	),
+
+	TP_printk("chan_id=%d", __entry->chan_id)
+);
+
+DEFINE_EVENT(d40_chan, d40_tasklet_entry,
+	TP_PROTO(int chan_id),
+	TP_ARGS(chan_id)
+);
+
+DEFINE_EVENT(d40_chan, d40_tasklet_exit,
+	TP_PROTO(int chan_id),
+	TP_ARGS(chan_id)
+);
+
+#endif /* _TRACE_DMA40_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
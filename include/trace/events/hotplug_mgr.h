@@ -0,0 +1,60 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM hotplug_mgr
+
+#if !defined(_TRACE_HOTPLUG_MGR_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_HOTPLUG_MGR_H
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(hotplug_mgr_request,
+	    TP_PROTO(const char *name, unsigned int min_cpus,
+		     unsigned int max_cpus),
+	    TP_ARGS(name, min_cpus, max_cpus),
+
+	    TP_STRUCT__entry(
+		    __string(name, name)
+		    __field(unsigned int, min_cpus)
+		    __field(unsigned int, max_cpus)
+	    ),
+
+	    TP_fast_assign(
+		    __assign_str(name, name);
+		    __entry->min_cpus = min_cpus;
+		    __entry->max_cpus = max_cpus;
+	    ),
+
+	    TP_printk("%s min=%u max=%u", __get_str(name),
+		      __entry->min_cpus, __entry->max_cpus)
+);
+
+TRACE_EVENT(hotplug_mgr_decision,
+	    TP_PROTO(unsigned int online, unsigned int target,
+		     unsigned int demand, unsigned int limit,
+		     const char *action),
+	    TP_ARGS(online, target, demand, limit, action),
+
+	    TP_STRUCT__entry(
+		    __field(unsigned int, online)
+		    __field(unsigned int, target)
+		    __field(unsigned int, demand)
+		    __field(unsigned int, limit)
+		    __field(const char *, action)
+	    ),
+
+	    TP_fast_assign(
+		    __entry->online = online;
+		    __entry->target = target;
+		    __entry->demand = demand;
+		    __entry->limit = limit;
+		    __entry->action = action;
+	    ),
+
+	    TP_printk("online=%u target=%u demand=%u limit=%u %s",
+		      __entry->online, __entry->target, __entry->demand,
+		      __entry->limit, __entry->action)
+);
+
+#endif /* _TRACE_HOTPLUG_MGR_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
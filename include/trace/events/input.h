@@ -0,0 +1,38 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM input
+
+#if !defined(_TRACE_INPUT_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_INPUT_H
+
+#include <linux/input.h>
+#include <linux/tracepoint.h>
+
+/*
+ * input_frame is emitted at the end of each frame of events of a device,
+ * with the time of the hardware event the frame reports when the driver
+ * has set it, zero otherwise.
+ */
+TRACE_EVENT(input_frame,
+
+	TP_PROTO(struct input_dev *dev),
+
+	TP_ARGS(dev),
+
+	TP_STRUCT__entry(
+		__string(	name,		dev->name ? dev->name : "")
+		__field(	s64,		timestamp		)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev->name ? dev->name : "");
+		__entry->timestamp = ktime_to_ns(dev->timestamp);
+	),
+
+	TP_printk("dev=%s timestamp=%lld",
+		__get_str(name), __entry->timestamp)
+);
+
+#endif /* _TRACE_INPUT_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -264,6 +264,36 @@ DEFINE_EVENT(hrtimer_class, hrtimer_cancel,
  *		zero, otherwise it is started
  * @expires:	the itimers expiry time
  */
+/**
+ * timer_coalesce - timers handled in one batch
+ * @hrtimer:	true for an hrtimer interrupt, false for a timer wheel jiffy
+ * @fired:	number of timers that were due
+ * @coalesced:	number of timers that were run ahead of their hard expiry
+ *		(hrtimers), or along with the first timer of the jiffy
+ */
+TRACE_EVENT(timer_coalesce,
+
+	TP_PROTO(bool hrtimer, unsigned int fired, unsigned int coalesced),
+
+	TP_ARGS(hrtimer, fired, coalesced),
+
+	TP_STRUCT__entry(
+		__field( bool,		hrtimer		)
+		__field( unsigned int,	fired		)
+		__field( unsigned int,	coalesced	)
+	),
+
+	TP_fast_assign(
+		__entry->hrtimer	= hrtimer;
+		__entry->fired		= fired;
+		__entry->coalesced	= coalesced;
+	),
+
+	TP_printk("%s fired=%u coalesced=%u",
+		  __entry->hrtimer ? "hrtimer" : "timer",
+		  __entry->fired, __entry->coalesced)
+);
+
 TRACE_EVENT(itimer_state,
 
 	TP_PROTO(int which, const struct itimerval *const value,
@@ -562,6 +562,49 @@ struct b2r2_blt_report {
 	__u32 usec_elapsed;
 };
 
+/**
+ * B2R2_BLT_MAX_BATCH - Max number of requests in a batch
+ */
+#define B2R2_BLT_MAX_BATCH 16
+
+/**
+ * struct b2r2_blt_batch - A batch of blit requests executed as one job
+ *
+ * @size: Size of this structure. Used for versioning. MUST be specified.
+ * @count: Number of requests in reqs, 1 to B2R2_BLT_MAX_BATCH
+ * @reqs: The requests, executed in array order
+ *
+ * A request of the batch sees the result of the requests before it. The
+ * batch is waited for, synched and reported as its last request, the
+ * B2R2_BLT_FLAG_ASYNCH and report flags of the other requests are
+ * ignored. B2R2_BLT_FLAG_DRY_RUN on any request applies to the batch.
+ */
+struct b2r2_blt_batch {
+	__u32               size;
+	__u32               count;
+	struct b2r2_blt_req *reqs;
+};
+
+/**
+ * struct b2r2_blt_fence_req - A blit request synchronized through sync fences
+ *
+ * @size: Size of this structure. Used for versioning. MUST be specified.
+ * @req: The request
+ * @in_fence: Fence fd the request waits for before it is executed, or -1
+ * @out_fence: Returned fence fd, signalled when the request is done
+ *
+ * The request is held back in the driver until @in_fence signals if
+ * B2R2_BLT_FLAG_ASYNCH is set, the ioctl then returns without waiting for
+ * it. An error on @in_fence cancels the request. @out_fence signals with
+ * an error if the request is cancelled.
+ */
+struct b2r2_blt_fence_req {
+	__u32               size;
+	struct b2r2_blt_req *req;
+	__s32               in_fence;
+	__s32               out_fence;
+};
+
 /**
  * B2R2 BLT driver is used in the following way:
  *
@@ -575,6 +618,23 @@ struct b2r2_blt_report {
  *
  *        request_id = ioctl(fd, B2R2_BLT_IOC, (__u32) &blt_request);
  *
+ * Or issue several requests as one job:
+ *        struct b2r2_blt_batch blt_batch;
+ *        blt_batch.size = sizeof(blt_batch);
+ *        blt_batch.count = n;
+ *        blt_batch.reqs = blt_requests;
+ *
+ *        request_id = ioctl(fd, B2R2_BLT_BATCH_IOC, (__u32) &blt_batch);
+ *
+ * Or issue a request chained to other hardware by sync fences:
+ *        struct b2r2_blt_fence_req blt_fence_req;
+ *        blt_fence_req.size = sizeof(blt_fence_req);
+ *        blt_fence_req.req = &blt_request;
+ *        blt_fence_req.in_fence = acquire_fence_fd;
+ *
+ *        request_id = ioctl(fd, B2R2_BLT_FENCE_IOC, (__u32) &blt_fence_req);
+ *        release_fence_fd = blt_fence_req.out_fence;
+ *
  * Wait for a request to finish
  *        ret = ioctl(fd, B2R2_BLT_SYNCH_IOC, (__u32) request_id);
  *
@@ -641,6 +701,29 @@ struct b2r2_blt_report {
 #define B2R2_BLT_QUERY_CAP_IOC  _IOWR(B2R2_BLT_IOC_MAGIC, 3, \
 				  struct b2r2_blt_query_cap)
 
+/**
+ * The B2R2_BLT_BATCH_IOC ioctl adds a batch of blit requests to B2R2.
+ *
+ * Supplied parameter shall be a pointer to a struct b2r2_blt_batch.
+ *
+ * Returns an unique request id for the batch if >= 0, else a negative
+ * error code. Behaves like B2R2_BLT_IOC otherwise.
+ */
+#define B2R2_BLT_BATCH_IOC  _IOW(B2R2_BLT_IOC_MAGIC, 4, struct b2r2_blt_batch)
+
+/**
+ * The B2R2_BLT_FENCE_IOC ioctl adds a blit request synchronized through
+ * sync fences to B2R2.
+ *
+ * Supplied parameter shall be a pointer to a struct b2r2_blt_fence_req,
+ * out_fence is filled in. Requires CONFIG_B2R2_FENCE, -ENOSYS otherwise.
+ *
+ * Returns an unique request id if >= 0, else a negative error code.
+ * Behaves like B2R2_BLT_IOC otherwise.
+ */
+#define B2R2_BLT_FENCE_IOC  _IOWR(B2R2_BLT_IOC_MAGIC, 5, \
+				  struct b2r2_blt_fence_req)
+
 /**
  * struct b2r2_platform_data - The b2r2 core hardware configuration
  *
@@ -681,6 +764,18 @@ int b2r2_blt_close(int handle);
  */
 int b2r2_blt_request(int handle, struct b2r2_blt_req *user_req);
 
+/**
+ * b2r2_blt_request_batch - Request blit operations executed as one job
+ *
+ * @handle: The B2R2 BLT instance handle
+ * @user_reqs: The requests, executed in array order
+ * @count: Number of requests, see struct b2r2_blt_batch
+ *
+ * Returns the request id of the batch on success
+ */
+int b2r2_blt_request_batch(int handle, struct b2r2_blt_req *user_reqs,
+		int count);
+
 /**
  * b2r2_blt_synch - Wait for all or a specified job
  *
@@ -288,6 +288,9 @@ int mcde_chnl_set_rotation(struct mcde_chnl_state *chnl,
 					enum mcde_hw_rotation hw_rot);
 int mcde_chnl_set_power_mode(struct mcde_chnl_state *chnl,
 				enum mcde_display_power_mode power_mode);
+int mcde_chnl_set_update_area(struct mcde_chnl_state *chnl,
+				u16 x, u16 y, u16 w, u16 h);
+void mcde_chnl_set_frame_id(struct mcde_chnl_state *chnl, u32 frame);
 
 int mcde_chnl_apply(struct mcde_chnl_state *chnl);
 int mcde_chnl_update(struct mcde_chnl_state *chnl,
@@ -314,6 +317,8 @@ void mcde_ovly_set_source_area(struct mcde_ovly_state *ovly,
 void mcde_ovly_set_dest_pos(struct mcde_ovly_state *ovly,
 	u16 x, u16 y, u8 z);
 void mcde_ovly_apply(struct mcde_ovly_state *ovly);
+int mcde_ovly_queue_flip(struct mcde_ovly_state *ovly, u32 paddr,
+	void (*done)(void *data), void *data);
 void mcde_ovly_put(struct mcde_ovly_state *ovly);
 
 /* MCDE dsi */
@@ -371,6 +376,25 @@ int mcde_dsi_set_max_pkt_size(struct mcde_chnl_state *chnl);
 int mcde_dsi_turn_on_peripheral(struct mcde_chnl_state *chnl);
 int mcde_dsi_shut_down_peripheral(struct mcde_chnl_state *chnl);
 
+/*
+ * Direct command writes collected in a buffer, for mcde_dsi_write_batch()
+ * to send back to back under a single channel lock and state change.
+ */
+#define MCDE_DSI_BATCH_SIZE 256
+
+struct mcde_dsi_batch {
+	int len;
+	u8 buf[MCDE_DSI_BATCH_SIZE];
+};
+
+void mcde_dsi_batch_init(struct mcde_dsi_batch *batch);
+int mcde_dsi_batch_dcs(struct mcde_dsi_batch *batch,
+		u8 cmd, const u8 *data, int len);
+int mcde_dsi_batch_generic(struct mcde_dsi_batch *batch,
+		const u8 *data, int len);
+int mcde_dsi_write_batch(struct mcde_chnl_state *chnl,
+		struct mcde_dsi_batch *batch);
+
 /* MCDE */
 
 /* Driver data */
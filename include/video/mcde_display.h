@@ -12,6 +12,7 @@
 #define __MCDE_DISPLAY__H__
 
 #include <linux/device.h>
+#include <linux/completion.h>
 #include <linux/pm.h>
 
 #include <video/mcde.h>
@@ -49,6 +50,8 @@ struct mcde_display_device {
 	bool enabled;
 	struct mcde_chnl_state *chnl_state;
 	struct list_head ovlys;
+	/* Not done while the display driver powers on the panel */
+	struct completion power_on_done;
 
 /* TODO: Remove once ESRAM allocator is done */
         u32 rotbuf1;
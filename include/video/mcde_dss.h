@@ -34,6 +34,11 @@ int mcde_dss_apply_overlay(struct mcde_overlay *ovl,
 void mcde_dss_get_overlay_info(struct mcde_overlay *ovly,
 				struct mcde_overlay_info *info);
 int mcde_dss_update_overlay(struct mcde_overlay *ovl, bool tripple_buffer);
+int mcde_dss_queue_flip(struct mcde_overlay *ovl, u32 paddr,
+	void (*done)(void *data), void *data);
+int mcde_dss_set_update_area(struct mcde_display_device *ddev,
+	u16 x, u16 y, u16 w, u16 h);
+int mcde_dss_set_frame_id(struct mcde_display_device *ddev, u32 frame);
 
 void mcde_dss_get_native_resolution(struct mcde_display_device *ddev,
 	u16 *x_res, u16 *y_res);
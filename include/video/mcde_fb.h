@@ -25,10 +25,38 @@
 #ifdef CONFIG_HAS_EARLYSUSPEND
 #include <linux/earlysuspend.h>
 #endif
+#ifdef CONFIG_SW_SYNC
+#include <linux/sw_sync.h>
+#endif
 #endif
 
 #define MCDE_GET_BUFFER_NAME_IOC _IO('M', 1)
 #define MCDE_SET_VSCREENINFO_IOC _IOW('D', 2, struct fb_var_screeninfo)
+#define MCDE_SET_UPDATE_AREA_IOC _IOW('D', 3, struct mcde_fb_update_area)
+#define MCDE_PAN_DISPLAY_FENCE_IOC _IOWR('D', 4, struct mcde_fb_flip)
+
+/*
+ * Damaged area of the screen for MCDE_SET_UPDATE_AREA_IOC. The next update
+ * of a command mode display only sends this area to the panel, it falls
+ * back to the full screen where that is not possible.
+ */
+struct mcde_fb_update_area {
+	uint16_t x;
+	uint16_t y;
+	uint16_t w;
+	uint16_t h;
+};
+
+/*
+ * Buffer to show for MCDE_PAN_DISPLAY_FENCE_IOC. On a triple buffered video
+ * mode display the ioctl returns without waiting for the flip, with
+ * release_fence set to a fence signalled once the buffer shown before is
+ * no longer read, or to -1 if there is none.
+ */
+struct mcde_fb_flip {
+	uint32_t yoffset;
+	int32_t release_fence;
+};
 
 #ifdef __KERNEL__
 #define to_mcde_fb(x) ((struct mcde_fb *)(x)->par)
@@ -43,6 +71,11 @@ struct mcde_fb {
 	int id;
 	struct hwmem_alloc *alloc;
 	int alloc_name;
+#ifdef CONFIG_SW_SYNC
+	/* Counts the buffers released by flips, flip_seq those queued */
+	struct sw_sync_timeline *timeline;
+	u32 flip_seq;
+#endif
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	struct early_suspend early_suspend;
 #endif
@@ -20,6 +20,9 @@
 #define DSILINK_MAX_DCS_READ   4
 #define DSILINK_MAX_DSI_DIRECT_CMD_WRITE 16
 
+/* Write batch entries: datatype, command and length, then the data */
+#define DSILINK_BATCH_HDR 3
+
 /* Interface mode */
 enum dsilink_irq {
 	DSILINK_IRQ_BTA_TE		 = 0x1,
@@ -202,6 +205,8 @@ int nova_dsilink_dcs_write(struct dsilink_device *dsilink, u8 cmd, u8 *data,
 								int len);
 int nova_dsilink_dsi_read(struct dsilink_device *dsilink, u8 cmd, u32 *data,
 								int *len);
+int nova_dsilink_write_batch(struct dsilink_device *dsilink, const u8 *buf,
+								int len);
 void nova_dsilink_te_request(struct dsilink_device *dsilink);
 int nova_dsilink_enable(struct dsilink_device *dsilink);
 void nova_dsilink_disable(struct dsilink_device *dsilink);
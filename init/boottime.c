@@ -23,6 +23,8 @@
 #include <linux/device.h>
 #include <linux/sysfs.h>
 #include <linux/slab.h>
+#include <linux/sched.h>
+#include <linux/math64.h>
 
 /*
  * BOOTTIME_MAX_NAME_LEN is defined in arch/arm/include/asm/setup.h to 64.
@@ -47,6 +49,15 @@ struct boottime_list {
 	struct kernel_cpustat cpu_usage[NR_CPUS];
 };
 
+/* Wall and CPU time of an initcall, initcalls may run in parallel */
+struct boottime_initcall_entry {
+	struct list_head list;
+	char name[BOOTTIME_MAX_NAME_LEN];
+	unsigned long start;
+	unsigned long wall;
+	unsigned long long cpu;
+};
+
 enum boottime_filter_type {
 	BOOTTIME_FILTER_OUT_ZERO,
 	BOOTTIME_FILTER_OUT_LESS_100,
@@ -64,6 +75,8 @@ enum boottime_cpu_load {
 };
 
 static LIST_HEAD(boottime_list);
+static LIST_HEAD(boottime_initcall_list);
+static DEFINE_SPINLOCK(boottime_initcall_lock);
 static __initdata DEFINE_SPINLOCK(boottime_list_lock);
 static __initdata struct boottime_timer boottime_timer;
 static __initdata int num_const_boottime_list;
@@ -178,6 +191,39 @@ void __init boottime_mark(char *name)
 				   BOOTTIME_CPU_LOAD);
 }
 
+void __ref boottime_initcall_start(struct boottime_initcall *bi)
+{
+	if (boottime_done)
+		return;
+
+	bi->time = boottime_timer.get_time ? boottime_timer.get_time() : 0;
+	bi->cpu = task_sched_runtime(current);
+}
+
+void __ref boottime_initcall_end(void *fn, struct boottime_initcall *bi)
+{
+	struct boottime_initcall_entry *e;
+	unsigned long flags;
+
+	if (boottime_done || !boottime_timer.get_time || !bi->time)
+		return;
+
+	e = kmalloc(sizeof(struct boottime_initcall_entry), GFP_KERNEL);
+	if (!e) {
+		printk(KERN_ERR "boottime: failed to allocate memory!\n");
+		return;
+	}
+
+	snprintf(e->name, BOOTTIME_MAX_NAME_LEN, "%pF", fn);
+	e->start = bi->time;
+	e->wall = boottime_timer.get_time() - bi->time;
+	e->cpu = task_sched_runtime(current) - bi->cpu;
+
+	spin_lock_irqsave(&boottime_initcall_lock, flags);
+	list_add_tail(&e->list, &boottime_initcall_list);
+	spin_unlock_irqrestore(&boottime_initcall_lock, flags);
+}
+
 void __init boottime_activate(struct boottime_timer *bt)
 {
 	struct boottime_list *b;
@@ -368,6 +414,17 @@ static int boottime_debugfs_summary_show(struct seq_file *s, void *data)
 	return 0;
 }
 
+static int boottime_debugfs_initcalls_show(struct seq_file *s, void *data)
+{
+	struct boottime_initcall_entry *e;
+
+	list_for_each_entry(e, &boottime_initcall_list, list)
+		seq_printf(s, "[%5lu.%06lu] %s wall: %lu usecs cpu: %llu usecs\n",
+			   e->start / 1000000, e->start % 1000000, e->name,
+			   e->wall, div_u64(e->cpu, NSEC_PER_USEC));
+	return 0;
+}
+
 static int boottime_debugfs_bootgraph_open(struct inode *inode,
 					   struct file *file)
 {
@@ -384,6 +441,14 @@ static int boottime_debugfs_summary_open(struct inode *inode,
 			   inode->i_private);
 }
 
+static int boottime_debugfs_initcalls_open(struct inode *inode,
+					   struct file *file)
+{
+	return single_open(file,
+			   boottime_debugfs_initcalls_show,
+			   inode->i_private);
+}
+
 static const struct file_operations boottime_debugfs_bootgraph_operations = {
 	.open		= boottime_debugfs_bootgraph_open,
 	.read		= seq_read,
@@ -398,6 +463,13 @@ static const struct file_operations boottime_debugfs_summary_operations = {
 	.release	= single_release,
 };
 
+static const struct file_operations boottime_debugfs_initcalls_operations = {
+	.open		= boottime_debugfs_initcalls_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 void boottime_debugfs_init(void)
 {
 	struct dentry *dir;
@@ -417,6 +489,9 @@ void boottime_debugfs_init(void)
 	(void) debugfs_create_file("summary", S_IFREG | S_IRUGO,
 				   dir, NULL,
 				   &boottime_debugfs_summary_operations);
+	(void) debugfs_create_file("initcalls", S_IFREG | S_IRUGO,
+				   dir, NULL,
+				   &boottime_debugfs_initcalls_operations);
 }
 #else
 #define boottime_debugfs_init(x)
@@ -8,6 +8,7 @@
 #include <linux/dirent.h>
 #include <linux/syscalls.h>
 #include <linux/utime.h>
+#include <linux/async.h>
 
 static __initdata char *message;
 static void __init error(char *x)
@@ -569,7 +570,33 @@ static void __init clean_rootfs(void)
 }
 #endif
 
-static int __init populate_rootfs(void)
+/*
+ * The initramfs is unpacked with the async framework, in parallel with the
+ * initcalls after populate_rootfs(). Whoever needs its files waits for it.
+ */
+static bool initramfs_async = true;
+
+static int __init initramfs_async_setup(char *str)
+{
+	strtobool(str, &initramfs_async);
+	return 1;
+}
+__setup("initramfs_async=", initramfs_async_setup);
+
+static LIST_HEAD(initramfs_domain);
+
+/**
+ * wait_for_initramfs() - Wait for the initramfs to be unpacked
+ *
+ * Called before the first exec of user space, and by anything else
+ * looking at the files of the rootfs during the initcalls.
+ */
+void wait_for_initramfs(void)
+{
+	async_synchronize_full_domain(&initramfs_domain);
+}
+
+static void __init do_populate_rootfs(void *unused, async_cookie_t cookie)
 {
 	char *err = unpack_to_rootfs(__initramfs_start, __initramfs_size);
 	if (err)
@@ -586,7 +613,7 @@ static int __init populate_rootfs(void)
 			initrd_end - initrd_start);
 		if (!err) {
 			free_initrd();
-			return 0;
+			return;
 		} else {
 			clean_rootfs();
 			unpack_to_rootfs(__initramfs_start, __initramfs_size);
@@ -622,6 +649,15 @@ static int __init populate_rootfs(void)
 		free_initrd();
 #endif
 	}
+}
+
+static int __init populate_rootfs(void)
+{
+	if (initramfs_async)
+		async_schedule_domain(do_populate_rootfs, NULL,
+				      &initramfs_domain);
+	else
+		do_populate_rootfs(NULL, 0);
 	return 0;
 }
 rootfs_initcall(populate_rootfs);
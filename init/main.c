@@ -767,8 +767,6 @@ static void __init do_ctors(void)
 bool initcall_debug;
 core_param(initcall_debug, initcall_debug, bool, 0644);
 
-static char msgbuf[64];
-
 static int __init_or_module do_one_initcall_debug(initcall_t fn)
 {
 	ktime_t calltime, delta, rettime;
@@ -797,16 +795,21 @@ static int __init_or_module do_one_initcall_debug(initcall_t fn)
 
 int __init_or_module do_one_initcall(initcall_t fn)
 {
+	struct boottime_initcall bi;
 	int count = preempt_count();
+	char msgbuf[64];
 	int ret;
 
 	boottime_mark_symbolic(fn);
+	boottime_initcall_start(&bi);
 
 	if (initcall_debug)
 		ret = do_one_initcall_debug(fn);
 	else
 		ret = fn();
 
+	boottime_initcall_end(fn, &bi);
+
 	msgbuf[0] = 0;
 
 	if (ret && ret != -ENODEV && initcall_debug)
@@ -843,6 +846,15 @@ extern initcall_t __initcall6_start[];
 extern initcall_t __initcall7_start[];
 extern initcall_t __initcall_end[];
 
+extern initcall_t __initcall0s_start[];
+extern initcall_t __initcall1s_start[];
+extern initcall_t __initcall2s_start[];
+extern initcall_t __initcall3s_start[];
+extern initcall_t __initcall4s_start[];
+extern initcall_t __initcall5s_start[];
+extern initcall_t __initcall6s_start[];
+extern initcall_t __initcall7s_start[];
+
 static initcall_t *initcall_levels[] __initdata = {
 	__initcall0_start,
 	__initcall1_start,
@@ -855,6 +867,38 @@ static initcall_t *initcall_levels[] __initdata = {
 	__initcall_end,
 };
 
+/* The async initcalls of a level are done before its _sync initcalls */
+static initcall_t *initcall_sync_levels[] __initdata = {
+	__initcall0s_start,
+	__initcall1s_start,
+	__initcall2s_start,
+	__initcall3s_start,
+	__initcall4s_start,
+	__initcall5s_start,
+	__initcall6s_start,
+	__initcall7s_start,
+};
+
+static bool initcall_parallel = true;
+core_param(initcall_parallel, initcall_parallel, bool, 0);
+
+static __initdata LIST_HEAD(initcall_async_running);
+
+static void __init do_initcall_async(void *data, async_cookie_t cookie)
+{
+	do_one_initcall(data);
+}
+
+/* Called by the stub of an async initcall, see __define_initcall_async() */
+int __init initcall_async(initcall_t fn)
+{
+	if (!initcall_parallel)
+		return do_one_initcall(fn);
+
+	async_schedule_domain(do_initcall_async, fn, &initcall_async_running);
+	return 0;
+}
+
 static char *initcall_level_names[] __initdata = {
 	"early parameters",
 	"core parameters",
@@ -878,8 +922,12 @@ static void __init do_initcall_level(int level)
 		   level, level,
 		   repair_env_string);
 
-	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++)
+	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++) {
+		if (fn == initcall_sync_levels[level])
+			async_synchronize_full_domain(&initcall_async_running);
 		do_one_initcall(*fn);
+	}
+	async_synchronize_full_domain(&initcall_async_running);
 }
 
 static void __init do_initcalls(void)
@@ -1024,6 +1072,8 @@ static int __init kernel_init(void * unused)
 	if (!ramdisk_execute_command)
 		ramdisk_execute_command = "/init";
 
+	wait_for_initramfs();
+
 	if (sys_access((const char __user *) ramdisk_execute_command, 0) != 0) {
 		ramdisk_execute_command = NULL;
 		boottime_mark("mount+0x0/0x0");
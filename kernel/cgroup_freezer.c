@@ -21,6 +21,8 @@
 #include <linux/uaccess.h>
 #include <linux/freezer.h>
 #include <linux/seq_file.h>
+#include <linux/workqueue.h>
+#include <linux/ktime.h>
 
 enum freezer_state {
 	CGROUP_THAWED = 0,
@@ -31,7 +33,15 @@ enum freezer_state {
 struct freezer {
 	struct cgroup_subsys_state css;
 	enum freezer_state state;
-	spinlock_t lock; /* protects _writes_ to state */
+	spinlock_t lock; /* protects _writes_ to state and the stats */
+	struct work_struct frozen_work;
+	ktime_t freeze_start;
+	unsigned int freeze_count;
+	unsigned int last_freeze_us;
+	unsigned int max_freeze_us;
+	unsigned int thaw_count;
+	unsigned int last_thaw_us;
+	unsigned int max_thaw_us;
 };
 
 static inline struct freezer *cgroup_freezer(
@@ -104,6 +114,10 @@ struct cgroup_subsys freezer_subsys;
  * freezer->lock
  *  sighand->siglock (if the cgroup is freezing)
  *
+ * freezer_frozen_work() (holds a css reference instead of cgroup_mutex):
+ * freezer->lock
+ *  read_lock css_set_lock (cgroup iterator start)
+ *
  * freezer_read():
  * cgroup_mutex
  *  freezer->lock
@@ -128,6 +142,8 @@ struct cgroup_subsys freezer_subsys;
  *    task->alloc_lock (inside __thaw_task(), prevents race with refrigerator())
  *     sighand->siglock
  */
+static void freezer_frozen_work(struct work_struct *work);
+
 static struct cgroup_subsys_state *freezer_create(struct cgroup *cgroup)
 {
 	struct freezer *freezer;
@@ -137,6 +153,7 @@ static struct cgroup_subsys_state *freezer_create(struct cgroup *cgroup)
 		return ERR_PTR(-ENOMEM);
 
 	spin_lock_init(&freezer->lock);
+	INIT_WORK(&freezer->frozen_work, freezer_frozen_work);
 	freezer->state = CGROUP_THAWED;
 	return &freezer->css;
 }
@@ -208,6 +225,19 @@ out:
 	rcu_read_unlock();
 }
 
+/*
+ * caller must hold freezer->lock
+ */
+static void freezer_set_frozen(struct freezer *freezer)
+{
+	unsigned int us = ktime_us_delta(ktime_get(), freezer->freeze_start);
+
+	freezer->state = CGROUP_FROZEN;
+	freezer->freeze_count++;
+	freezer->last_freeze_us = us;
+	freezer->max_freeze_us = max(freezer->max_freeze_us, us);
+}
+
 /*
  * caller must hold freezer->lock
  */
@@ -230,7 +260,7 @@ static void update_if_frozen(struct cgroup *cgroup,
 		BUG_ON(nfrozen > 0);
 	} else if (old_state == CGROUP_FREEZING) {
 		if (nfrozen == ntotal)
-			freezer->state = CGROUP_FROZEN;
+			freezer_set_frozen(freezer);
 	} else { /* old_state == CGROUP_FROZEN */
 		BUG_ON(nfrozen != ntotal);
 	}
@@ -238,6 +268,37 @@ static void update_if_frozen(struct cgroup *cgroup,
 	cgroup_iter_end(cgroup, &it);
 }
 
+/*
+ * Moves a FREEZING cgroup on to FROZEN as soon as its tasks are in the
+ * refrigerator, instead of when freezer.state is next read. Tasks that
+ * freeze together share one pass over the cgroup.
+ */
+static void freezer_frozen_work(struct work_struct *work)
+{
+	struct freezer *freezer = container_of(work, struct freezer,
+					       frozen_work);
+
+	spin_lock_irq(&freezer->lock);
+	if (freezer->state == CGROUP_FREEZING)
+		update_if_frozen(freezer->css.cgroup, freezer);
+	spin_unlock_irq(&freezer->lock);
+
+	css_put(&freezer->css);
+}
+
+/* Called by __refrigerator() when @task first freezes */
+void cgroup_freezer_frozen(struct task_struct *task)
+{
+	struct freezer *freezer;
+
+	rcu_read_lock();
+	freezer = task_freezer(task);
+	if (freezer->state == CGROUP_FREEZING && css_tryget(&freezer->css) &&
+	    !schedule_work(&freezer->frozen_work))
+		css_put(&freezer->css);
+	rcu_read_unlock();
+}
+
 static int freezer_read(struct cgroup *cgroup, struct cftype *cft,
 			struct seq_file *m)
 {
@@ -269,18 +330,24 @@ static int try_to_freeze_cgroup(struct cgroup *cgroup, struct freezer *freezer)
 	struct cgroup_iter it;
 	struct task_struct *task;
 	unsigned int num_cant_freeze_now = 0;
+	unsigned int nfrozen = 0, ntotal = 0;
 
+	/* The tasks freeze in parallel, as each next returns to user space */
 	cgroup_iter_start(cgroup, &it);
 	while ((task = cgroup_iter_next(cgroup, &it))) {
-		if (!freeze_task(task))
-			continue;
-		if (is_task_frozen_enough(task))
-			continue;
-		if (!freezing(task) && !freezer_should_skip(task))
+		ntotal++;
+		freeze_task(task);
+		if (freezing(task) && is_task_frozen_enough(task))
+			nfrozen++;
+		else if (!freezing(task) && !freezer_should_skip(task))
 			num_cant_freeze_now++;
 	}
 	cgroup_iter_end(cgroup, &it);
 
+	/* The rest is noticed by freezer_frozen_work() */
+	if (nfrozen == ntotal)
+		freezer_set_frozen(freezer);
+
 	return num_cant_freeze_now ? -EBUSY : 0;
 }
 
@@ -288,11 +355,18 @@ static void unfreeze_cgroup(struct cgroup *cgroup, struct freezer *freezer)
 {
 	struct cgroup_iter it;
 	struct task_struct *task;
+	ktime_t start = ktime_get();
+	unsigned int us;
 
 	cgroup_iter_start(cgroup, &it);
 	while ((task = cgroup_iter_next(cgroup, &it)))
 		__thaw_task(task);
 	cgroup_iter_end(cgroup, &it);
+
+	us = ktime_us_delta(ktime_get(), start);
+	freezer->thaw_count++;
+	freezer->last_thaw_us = us;
+	freezer->max_thaw_us = max(freezer->max_thaw_us, us);
 }
 
 static int freezer_change_state(struct cgroup *cgroup,
@@ -305,18 +379,25 @@ static int freezer_change_state(struct cgroup *cgroup,
 
 	spin_lock_irq(&freezer->lock);
 
-	update_if_frozen(cgroup, freezer);
-
+	/*
+	 * Thawing wakes all tasks in a single pass, and freezing tells
+	 * whether the cgroup is frozen from its own pass.
+	 */
 	switch (goal_state) {
 	case CGROUP_THAWED:
-		if (freezer->state != CGROUP_THAWED)
-			atomic_dec(&system_freezing_cnt);
+		if (freezer->state == CGROUP_THAWED)
+			break;
+		atomic_dec(&system_freezing_cnt);
 		freezer->state = CGROUP_THAWED;
 		unfreeze_cgroup(cgroup, freezer);
 		break;
 	case CGROUP_FROZEN:
-		if (freezer->state == CGROUP_THAWED)
+		if (freezer->state == CGROUP_FROZEN)
+			break;
+		if (freezer->state == CGROUP_THAWED) {
 			atomic_inc(&system_freezing_cnt);
+			freezer->freeze_start = ktime_get();
+		}
 		freezer->state = CGROUP_FREEZING;
 		retval = try_to_freeze_cgroup(cgroup, freezer);
 		break;
@@ -350,12 +431,41 @@ static int freezer_write(struct cgroup *cgroup,
 	return retval;
 }
 
+static int freezer_stat_show(struct cgroup *cgroup, struct cftype *cft,
+			     struct cgroup_map_cb *cb)
+{
+	struct freezer *freezer = cgroup_freezer(cgroup);
+	unsigned int stats[6];
+
+	spin_lock_irq(&freezer->lock);
+	stats[0] = freezer->freeze_count;
+	stats[1] = freezer->last_freeze_us;
+	stats[2] = freezer->max_freeze_us;
+	stats[3] = freezer->thaw_count;
+	stats[4] = freezer->last_thaw_us;
+	stats[5] = freezer->max_thaw_us;
+	spin_unlock_irq(&freezer->lock);
+
+	cb->fill(cb, "freeze_count", stats[0]);
+	cb->fill(cb, "last_freeze_us", stats[1]);
+	cb->fill(cb, "max_freeze_us", stats[2]);
+	cb->fill(cb, "thaw_count", stats[3]);
+	cb->fill(cb, "last_thaw_us", stats[4]);
+	cb->fill(cb, "max_thaw_us", stats[5]);
+
+	return 0;
+}
+
 static struct cftype files[] = {
 	{
 		.name = "state",
 		.read_seq_string = freezer_read,
 		.write_string = freezer_write,
 	},
+	{
+		.name = "stat",
+		.read_map = freezer_stat_show,
+	},
 };
 
 static int freezer_populate(struct cgroup_subsys *ss, struct cgroup *cgroup)
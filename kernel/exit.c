@@ -202,6 +202,7 @@ repeat:
 	}
 
 	write_unlock_irq(&tasklist_lock);
+	oom_adj_index_del(p);
 	release_thread(p);
 	call_rcu(&p->rcu, delayed_put_task_struct);
 
@@ -999,6 +1000,7 @@ void do_exit(long code)
 	taskstats_exit(tsk, group_dead);
 
 	exit_mm(tsk);
+	sched_frame_exit(tsk);
 
 	if (group_dead)
 		acct_process();
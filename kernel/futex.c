@@ -62,6 +62,7 @@
 #include <linux/ptrace.h>
 #include <linux/hugetlb.h>
 #include <linux/freezer.h>
+#include <linux/debugfs.h>
 
 #include <asm/futex.h>
 
@@ -2117,6 +2118,99 @@ static long futex_wait_restart(struct restart_block *restart)
 }
 
 
+#ifdef CONFIG_SMP
+/*
+ * Adaptive spinning on contended PI futexes: while the owner runs on
+ * another CPU it is likely to release the lock before a sleep and wakeup
+ * could be paid for, the same reasoning as mutex_spin_on_owner(). The
+ * counters are approximate.
+ */
+static u32 futex_spin_enabled = 1;
+static u32 futex_spin_acquired;
+static u32 futex_spin_failed;
+
+/*
+ * Returns 1 if the futex was taken, 0 if the caller should go on and block.
+ * Only free futexes are taken, the 0 -> TID transition userspace failed,
+ * so that the spinner never jumps waiters already queued in the kernel.
+ */
+static int futex_spin_on_owner(u32 __user *uaddr)
+{
+	struct task_struct *owner = NULL;
+	u32 uval, curval, vpid = task_pid_vnr(current);
+	pid_t owner_pid = 0;
+	int ret = 0;
+
+	while (!need_resched()) {
+		if (get_futex_value_locked(&uval, uaddr))
+			break;
+
+		if (!uval) {
+			if (cmpxchg_futex_value_locked(&curval, uaddr, 0, vpid))
+				break;
+			if (!curval) {
+				ret = 1;
+				break;
+			}
+			continue;
+		}
+
+		/* Waiters or a dead owner: leave it to the slow path */
+		if (uval & (FUTEX_WAITERS | FUTEX_OWNER_DIED))
+			break;
+
+		if ((uval & FUTEX_TID_MASK) != owner_pid) {
+			if (owner)
+				put_task_struct(owner);
+			owner_pid = uval & FUTEX_TID_MASK;
+			owner = futex_find_get_task(owner_pid);
+			if (!owner || owner == current)
+				break;
+		}
+
+		if (!ACCESS_ONCE(owner->on_cpu))
+			break;
+
+		cpu_relax();
+	}
+
+	if (owner)
+		put_task_struct(owner);
+
+	if (ret)
+		futex_spin_acquired++;
+	else
+		futex_spin_failed++;
+
+	return ret;
+}
+
+static int __init futex_spin_debugfs_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("futex_spin", NULL);
+	if (!dir)
+		return 0;
+
+	debugfs_create_bool("enabled", S_IRUGO | S_IWUSR, dir,
+			    &futex_spin_enabled);
+	debugfs_create_u32("acquired", S_IRUGO | S_IWUSR, dir,
+			   &futex_spin_acquired);
+	debugfs_create_u32("failed", S_IRUGO | S_IWUSR, dir,
+			   &futex_spin_failed);
+
+	return 0;
+}
+late_initcall(futex_spin_debugfs_init);
+#else
+static inline int futex_spin_on_owner(u32 __user *uaddr)
+{
+	return 0;
+}
+#define futex_spin_enabled 0
+#endif
+
 /*
  * Userspace tried a 0 -> TID atomic transition of the futex value
  * and failed. The kernel side here does the whole locking operation:
@@ -2129,6 +2223,7 @@ static int futex_lock_pi(u32 __user *uaddr, unsigned int flags, int detect,
 	struct hrtimer_sleeper timeout, *to = NULL;
 	struct futex_hash_bucket *hb;
 	struct futex_q q = futex_q_init;
+	bool spin = !trylock && futex_spin_enabled;
 	int res, ret;
 
 	if (refill_pi_state_cache())
@@ -2147,6 +2242,13 @@ retry:
 	if (unlikely(ret != 0))
 		goto out;
 
+	/* The key checked uaddr, spin once before the first sleep */
+	if (spin) {
+		spin = false;
+		if (futex_spin_on_owner(uaddr))
+			goto out_put_key;
+	}
+
 retry_private:
 	hb = queue_lock(&q);
 
@@ -1078,6 +1078,38 @@ hrtimer_start(struct hrtimer *timer, ktime_t tim, const enum hrtimer_mode mode)
 }
 EXPORT_SYMBOL_GPL(hrtimer_start);
 
+/**
+ * hrtimer_start_slack - (re)start an hrtimer with a class of slack
+ * @timer:	the timer to be added
+ * @tim:	expiry time
+ * @mode:	expiry mode: absolute (HRTIMER_ABS) or relative (HRTIMER_REL)
+ * @class:	slack class, see enum timer_slack_class
+ *
+ * The timer may run up to a fraction of its timeout late, as set by the
+ * class, along with other timers or wakeups in that range.
+ *
+ * Returns:
+ *  0 on success
+ *  1 when the timer was active
+ */
+int hrtimer_start_slack(struct hrtimer *timer, ktime_t tim,
+			const enum hrtimer_mode mode,
+			enum timer_slack_class class)
+{
+	ktime_t delta = tim;
+
+	if (!(mode & HRTIMER_MODE_REL))
+		delta = ktime_sub(tim, timer->base->get_time());
+	if (delta.tv64 <= 0)
+		return hrtimer_start(timer, tim, mode);
+
+	return __hrtimer_start_range_ns(timer, tim,
+			timer_slack_class_delta(class,
+				min_t(s64, ktime_to_ns(delta), ULONG_MAX)),
+			mode, 1);
+}
+EXPORT_SYMBOL_GPL(hrtimer_start_slack);
+
 
 /**
  * hrtimer_try_to_cancel - try to deactivate a timer
@@ -1264,6 +1296,7 @@ static void __run_hrtimer(struct hrtimer *timer, ktime_t *now)
 	 * the timer base.
 	 */
 	raw_spin_unlock(&cpu_base->lock);
+	timer_wakeup_account(fn);
 	trace_hrtimer_expire_entry(timer, now);
 	restart = fn(timer);
 	trace_hrtimer_expire_exit(timer);
@@ -1297,6 +1330,7 @@ void hrtimer_interrupt(struct clock_event_device *dev)
 {
 	struct hrtimer_cpu_base *cpu_base = &__get_cpu_var(hrtimer_bases);
 	ktime_t expires_next, now, entry_time, delta;
+	unsigned int fired = 0, coalesced = 0;
 	int i, retries = 0;
 
 	BUG_ON(!cpu_base->hres_active);
@@ -1357,6 +1391,12 @@ retry:
 				break;
 			}
 
+			/* Run within its slack, ahead of the hard expiry */
+			if (basenow.tv64 < hrtimer_get_expires_tv64(timer))
+				coalesced++;
+			else
+				fired++;
+
 			__run_hrtimer(timer, &basenow);
 		}
 	}
@@ -1368,6 +1408,11 @@ retry:
 	cpu_base->expires_next = expires_next;
 	raw_spin_unlock(&cpu_base->lock);
 
+	if (fired || coalesced) {
+		timer_coalesce_batch(true, fired, coalesced);
+		fired = coalesced = 0;
+	}
+
 	/* Reprogramming necessary ? */
 	if (expires_next.tv64 == KTIME_MAX ||
 	    !tick_program_event(expires_next, 0)) {
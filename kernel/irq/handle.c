@@ -72,6 +72,8 @@ static void irq_wake_thread(struct irq_desc *desc, struct irqaction *action)
 	if (test_and_set_bit(IRQTF_RUNTHREAD, &action->thread_flags))
 		return;
 
+	irq_time_stats_wake_thread(action);
+
 	/*
 	 * It's safe to OR the mask lockless here. We have only two
 	 * places which write to threads_oneshot: This code and the
@@ -138,6 +140,9 @@ handle_irq_event_percpu(struct irq_desc *desc, struct irqaction *action)
 {
 	irqreturn_t retval = IRQ_NONE;
 	unsigned int flags = 0, irq = desc->irq_data.irq;
+#ifdef CONFIG_IRQ_TIME_STATS
+	u64 start = sched_clock();
+#endif
 
 	do {
 		irqreturn_t res;
@@ -176,6 +181,9 @@ handle_irq_event_percpu(struct irq_desc *desc, struct irqaction *action)
 		action = action->next;
 	} while (action);
 
+#ifdef CONFIG_IRQ_TIME_STATS
+	irq_time_stats_handler(desc, sched_clock() - start);
+#endif
 	add_interrupt_randomness(irq, flags);
 
 	if (!noirqdebug)
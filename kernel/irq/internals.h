@@ -6,6 +6,7 @@
  * of this file for your non core code.
  */
 #include <linux/irqdesc.h>
+#include <linux/sched.h>
 
 #ifdef CONFIG_SPARSE_IRQ
 # define IRQ_BITMAP_BITS	(NR_IRQS + 8196)
@@ -184,3 +185,40 @@ static inline bool irqd_has_set(struct irq_data *d, unsigned int mask)
 {
 	return d->state_use_accessors & mask;
 }
+
+#ifdef CONFIG_IRQ_TIME_STATS
+/* Called with interrupts disabled after the hard irq handlers ran */
+static inline void irq_time_stats_handler(struct irq_desc *desc, u64 ns)
+{
+	struct irq_time_stats *stats = this_cpu_ptr(desc->time_stats);
+
+	stats->handler_ns += ns;
+	if (ns > stats->handler_max_ns)
+		stats->handler_max_ns = ns;
+}
+
+static inline void irq_time_stats_wake_thread(struct irqaction *action)
+{
+	action->wake_time = sched_clock();
+}
+
+/* Called by the handler thread before it runs the thread function */
+static inline void irq_time_stats_thread(struct irq_desc *desc,
+					 struct irqaction *action)
+{
+	struct irq_time_stats *stats;
+	u64 ns = sched_clock() - action->wake_time;
+
+	stats = get_cpu_ptr(desc->time_stats);
+	stats->thread_delay_ns += ns;
+	if (ns > stats->thread_delay_max_ns)
+		stats->thread_delay_max_ns = ns;
+	stats->thread_runs++;
+	put_cpu_ptr(desc->time_stats);
+}
+#else
+static inline void irq_time_stats_handler(struct irq_desc *desc, u64 ns) { }
+static inline void irq_time_stats_wake_thread(struct irqaction *action) { }
+static inline void irq_time_stats_thread(struct irq_desc *desc,
+					 struct irqaction *action) { }
+#endif
@@ -90,6 +90,12 @@ static void desc_set_defaults(unsigned int irq, struct irq_desc *desc, int node,
 	desc->owner = owner;
 	for_each_possible_cpu(cpu)
 		*per_cpu_ptr(desc->kstat_irqs, cpu) = 0;
+#ifdef CONFIG_IRQ_TIME_STATS
+	if (desc->time_stats)
+		for_each_possible_cpu(cpu)
+			memset(per_cpu_ptr(desc->time_stats, cpu), 0,
+			       sizeof(struct irq_time_stats));
+#endif
 	desc_smp_init(desc, node);
 }
 
@@ -154,8 +160,14 @@ static struct irq_desc *alloc_desc(int irq, int node, struct module *owner)
 	if (!desc->kstat_irqs)
 		goto err_desc;
 
-	if (alloc_masks(desc, gfp, node))
+#ifdef CONFIG_IRQ_TIME_STATS
+	desc->time_stats = alloc_percpu(struct irq_time_stats);
+	if (!desc->time_stats)
 		goto err_kstat;
+#endif
+
+	if (alloc_masks(desc, gfp, node))
+		goto err_time_stats;
 
 	raw_spin_lock_init(&desc->lock);
 	lockdep_set_class(&desc->lock, &irq_desc_lock_class);
@@ -164,6 +176,10 @@ static struct irq_desc *alloc_desc(int irq, int node, struct module *owner)
 
 	return desc;
 
+err_time_stats:
+#ifdef CONFIG_IRQ_TIME_STATS
+	free_percpu(desc->time_stats);
+#endif
 err_kstat:
 	free_percpu(desc->kstat_irqs);
 err_desc:
@@ -188,6 +204,9 @@ static void free_desc(unsigned int irq)
 	mutex_unlock(&sparse_irq_lock);
 
 	free_masks(desc);
+#ifdef CONFIG_IRQ_TIME_STATS
+	free_percpu(desc->time_stats);
+#endif
 	free_percpu(desc->kstat_irqs);
 	kfree(desc);
 }
@@ -286,6 +305,9 @@ int __init early_irq_init(void)
 
 	for (i = 0; i < count; i++) {
 		desc[i].kstat_irqs = alloc_percpu(unsigned int);
+#ifdef CONFIG_IRQ_TIME_STATS
+		desc[i].time_stats = alloc_percpu(struct irq_time_stats);
+#endif
 		alloc_masks(&desc[i], GFP_KERNEL, node);
 		raw_spin_lock_init(&desc[i].lock);
 		lockdep_set_class(&desc[i].lock, &irq_desc_lock_class);
@@ -569,3 +591,20 @@ unsigned int kstat_irqs_usr(unsigned int irq)
 	irq_unlock_sparse();
 	return sum;
 }
+
+#ifdef CONFIG_IRQ_TIME_STATS
+/**
+ * irq_time_stats_wakeup - Count a wake up from idle by an interrupt
+ * @irq:	The interrupt number
+ *
+ * Called by the idle code, with interrupts disabled, when @irq is the
+ * interrupt that woke the cpu.
+ */
+void irq_time_stats_wakeup(unsigned int irq)
+{
+	struct irq_desc *desc = irq_to_desc(irq);
+
+	if (desc && desc->time_stats)
+		this_cpu_ptr(desc->time_stats)->wakeups++;
+}
+#endif
@@ -808,6 +808,7 @@ static int irq_thread(void *data)
 
 		irq_thread_check_affinity(desc, action);
 
+		irq_time_stats_thread(desc, action);
 		action_ret = handler_fn(desc, action);
 		if (action_ret == IRQ_HANDLED)
 			atomic_inc(&desc->threads_handled);
@@ -413,6 +413,80 @@ static void register_default_affinity_proc(void)
 #endif
 }
 
+#ifdef CONFIG_IRQ_TIME_STATS
+static int irq_time_stats_show(struct seq_file *p, void *v)
+{
+	struct irq_time_stats sum, *stats;
+	struct irqaction *action;
+	struct irq_desc *desc;
+	unsigned long flags;
+	unsigned int count;
+	int irq, cpu;
+
+	seq_printf(p, "%4s %10s %12s %8s %10s %12s %8s %8s\n", "irq",
+		   "count", "handler_us", "max_us", "threads", "delay_us",
+		   "delay_max", "wakeups");
+
+	for (irq = 0; irq < nr_irqs; irq++) {
+		irq_lock_sparse();
+		desc = irq_to_desc(irq);
+		if (!desc || !desc->time_stats)
+			goto outsparse;
+
+		memset(&sum, 0, sizeof(sum));
+		count = 0;
+		for_each_possible_cpu(cpu) {
+			stats = per_cpu_ptr(desc->time_stats, cpu);
+			sum.handler_ns += stats->handler_ns;
+			sum.handler_max_ns = max(sum.handler_max_ns,
+						 stats->handler_max_ns);
+			sum.thread_delay_ns += stats->thread_delay_ns;
+			sum.thread_delay_max_ns = max(sum.thread_delay_max_ns,
+						stats->thread_delay_max_ns);
+			sum.thread_runs += stats->thread_runs;
+			sum.wakeups += stats->wakeups;
+			count += kstat_irqs_cpu(irq, cpu);
+		}
+		if (!count && !sum.wakeups)
+			goto outsparse;
+
+		seq_printf(p, "%4d %10u %12llu %8llu %10u %12llu %8llu %8u ",
+			   irq, count, div_u64(sum.handler_ns, NSEC_PER_USEC),
+			   div_u64(sum.handler_max_ns, NSEC_PER_USEC),
+			   sum.thread_runs,
+			   div_u64(sum.thread_delay_ns, NSEC_PER_USEC),
+			   div_u64(sum.thread_delay_max_ns, NSEC_PER_USEC),
+			   sum.wakeups);
+
+		raw_spin_lock_irqsave(&desc->lock, flags);
+		action = desc->action;
+		if (action) {
+			seq_printf(p, " %s", action->name);
+			while ((action = action->next) != NULL)
+				seq_printf(p, ", %s", action->name);
+		}
+		raw_spin_unlock_irqrestore(&desc->lock, flags);
+		seq_putc(p, '\n');
+outsparse:
+		irq_unlock_sparse();
+	}
+
+	return 0;
+}
+
+static int irq_time_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, irq_time_stats_show, NULL);
+}
+
+static const struct file_operations irq_time_stats_fops = {
+	.open		= irq_time_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif
+
 void init_irq_proc(void)
 {
 	unsigned int irq;
@@ -425,6 +499,10 @@ void init_irq_proc(void)
 
 	register_default_affinity_proc();
 
+#ifdef CONFIG_IRQ_TIME_STATS
+	proc_create("irq_stats", 0444, NULL, &irq_time_stats_fops);
+#endif
+
 	/*
 	 * Create entries for all existing IRQs.
 	 */
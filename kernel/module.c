@@ -58,6 +58,8 @@
 #include <linux/jump_label.h>
 #include <linux/pfn.h>
 #include <linux/bsearch.h>
+#include <linux/lz4.h>
+#include <asm/unaligned.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/module.h>
@@ -1064,6 +1066,24 @@ static ssize_t show_taint(struct module_attribute *mattr,
 static struct module_attribute modinfo_taint =
 	__ATTR(taint, 0444, show_taint, NULL);
 
+static ssize_t show_load_us(struct module_attribute *mattr,
+			    struct module_kobject *mk, char *buffer)
+{
+	return sprintf(buffer, "%u\n", mk->mod->load_us);
+}
+
+static struct module_attribute modinfo_load_us =
+	__ATTR(load_us, 0444, show_load_us, NULL);
+
+static ssize_t show_init_us(struct module_attribute *mattr,
+			    struct module_kobject *mk, char *buffer)
+{
+	return sprintf(buffer, "%u\n", mk->mod->init_us);
+}
+
+static struct module_attribute modinfo_init_us =
+	__ATTR(init_us, 0444, show_init_us, NULL);
+
 static struct module_attribute *modinfo_attrs[] = {
 	&module_uevent,
 	&modinfo_version,
@@ -1072,6 +1092,8 @@ static struct module_attribute *modinfo_attrs[] = {
 	&modinfo_coresize,
 	&modinfo_initsize,
 	&modinfo_taint,
+	&modinfo_load_us,
+	&modinfo_init_us,
 #ifdef CONFIG_MODULE_UNLOAD
 	&modinfo_refcnt,
 #endif
@@ -2408,6 +2430,100 @@ static inline void kmemleak_load_module(const struct module *mod,
 }
 #endif
 
+#ifdef CONFIG_MODULE_COMPRESS_LZ4
+/* The lz4c -l format, as the kernel image is compressed */
+#define MODULE_LZ4_MAGIC	0x184C2102
+
+static bool module_is_lz4(const void __user *umod, unsigned long len)
+{
+	u8 magic[4];
+
+	if (len < sizeof(magic) || copy_from_user(magic, umod, sizeof(magic)))
+		return false;
+
+	return get_unaligned_le32(magic) == MODULE_LZ4_MAGIC;
+}
+
+/*
+ * Decompress a module installed compressed: lz4 chunks, each after its
+ * compressed size, then the decompressed size of the whole. The image is
+ * decompressed from the compressed copy to where copy_and_check() would
+ * have copied it, so nothing is copied twice.
+ */
+static int module_decompress_lz4(const void __user *umod, unsigned long len,
+				 Elf_Ehdr **hdrp, unsigned long *lenp)
+{
+	u8 *src, *p, *end;
+	u8 *dst = NULL;
+	size_t size, done = 0;
+	int err = -ENOEXEC;
+
+	if (len < 12)
+		return -ENOEXEC;
+
+	src = vmalloc(len);
+	if (!src)
+		return -ENOMEM;
+
+	if (copy_from_user(src, umod, len) != 0) {
+		err = -EFAULT;
+		goto out;
+	}
+
+	size = get_unaligned_le32(src + len - 4);
+	if (size < sizeof(Elf_Ehdr))
+		goto out;
+
+	dst = vmalloc(size);
+	if (!dst) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	p = src + 4;
+	end = src + len - 4;
+	while (end - p >= 4) {
+		size_t chunk = get_unaligned_le32(p);
+		size_t dlen = size - done;
+
+		p += 4;
+		/* Concatenated streams start over with the magic */
+		if (chunk == MODULE_LZ4_MAGIC)
+			continue;
+		if (chunk > end - p ||
+		    lz4_decompress_unknownoutputsize(p, chunk, dst + done,
+						     &dlen) < 0)
+			goto out;
+		done += dlen;
+		p += chunk;
+	}
+
+	if (done == size) {
+		*hdrp = (Elf_Ehdr *)dst;
+		*lenp = size;
+		dst = NULL;
+		err = 0;
+	}
+
+out:
+	vfree(dst);
+	vfree(src);
+	return err;
+}
+#else
+static inline bool module_is_lz4(const void __user *umod, unsigned long len)
+{
+	return false;
+}
+
+static inline int module_decompress_lz4(const void __user *umod,
+					unsigned long len,
+					Elf_Ehdr **hdrp, unsigned long *lenp)
+{
+	return -ENOEXEC;
+}
+#endif
+
 /* Sets info->hdr and info->len. */
 static int copy_and_check(struct load_info *info,
 			  const void __user *umod, unsigned long len,
@@ -2419,13 +2535,19 @@ static int copy_and_check(struct load_info *info,
 	if (len < sizeof(*hdr))
 		return -ENOEXEC;
 
-	/* Suck in entire file: we'll want most of it. */
-	if ((hdr = vmalloc(len)) == NULL)
-		return -ENOMEM;
+	if (module_is_lz4(umod, len)) {
+		err = module_decompress_lz4(umod, len, &hdr, &len);
+		if (err)
+			return err;
+	} else {
+		/* Suck in entire file: we'll want most of it. */
+		if ((hdr = vmalloc(len)) == NULL)
+			return -ENOMEM;
 
-	if (copy_from_user(hdr, umod, len) != 0) {
-		err = -EFAULT;
-		goto free_hdr;
+		if (copy_from_user(hdr, umod, len) != 0) {
+			err = -EFAULT;
+			goto free_hdr;
+		}
 	}
 
 	/* Sanity checks against insmoding binaries or wrong arch,
@@ -3026,6 +3148,7 @@ SYSCALL_DEFINE3(init_module, void __user *, umod,
 		unsigned long, len, const char __user *, uargs)
 {
 	struct module *mod;
+	ktime_t start;
 	int ret = 0;
 
 	/* Must have permission */
@@ -3033,9 +3156,11 @@ SYSCALL_DEFINE3(init_module, void __user *, umod,
 		return -EPERM;
 
 	/* Do all the hard work */
+	start = ktime_get();
 	mod = load_module(umod, len, uargs);
 	if (IS_ERR(mod))
 		return PTR_ERR(mod);
+	mod->load_us = ktime_us_delta(ktime_get(), start);
 
 	blocking_notifier_call_chain(&module_notify_list,
 			MODULE_STATE_COMING, mod);
@@ -3054,8 +3179,10 @@ SYSCALL_DEFINE3(init_module, void __user *, umod,
 
 	do_mod_ctors(mod);
 	/* Start the module */
+	start = ktime_get();
 	if (mod->init != NULL)
 		ret = do_one_initcall(mod->init);
+	mod->init_us = ktime_us_delta(ktime_get(), start);
 	if (ret < 0) {
 		/* Init routine failed: abort.  Try to protect us from
                    buggy refcounters. */
@@ -74,7 +74,7 @@ static void __init rcu_bootup_announce_oddness(void)
 
 #ifdef CONFIG_TREE_PREEMPT_RCU
 
-struct rcu_state rcu_preempt_state = RCU_STATE_INITIALIZER(rcu_preempt);
+struct rcu_state rcu_preempt_state = RCU_STATE_INITIALIZER(rcu_preempt, call_rcu);
 DEFINE_PER_CPU(struct rcu_data, rcu_preempt_data);
 static struct rcu_state *rcu_state = &rcu_preempt_state;
 
@@ -2299,3 +2299,280 @@ static void increment_cpu_stall_ticks(void)
 }
 
 #endif /* #else #ifdef CONFIG_RCU_CPU_STALL_INFO */
+
+#ifdef CONFIG_RCU_NOCB_CPU
+
+/*
+ * Offload callback processing from the CPUs in rcu_nocb_mask.  Callbacks
+ * queued on such a CPU go to a lockless list that is drained by a per-CPU,
+ * per-flavor "rcuo" kthread.  The kthread waits for a grace period through
+ * a callback it queues itself, from a CPU that is not offloaded, and then
+ * invokes the callbacks.  The offloaded CPU thus has no callbacks of its own
+ * and does not get in the way of dyntick-idle.  The boot CPU is never
+ * offloaded, the kthreads run there by default.
+ */
+
+static cpumask_var_t rcu_nocb_mask; /* CPUs to have callbacks offloaded. */
+static bool have_rcu_nocb_mask;	    /* Was rcu_nocb_mask allocated? */
+
+static struct rcu_state *const rcu_nocb_flavors[] = {
+	&rcu_sched_state,
+	&rcu_bh_state,
+#ifdef CONFIG_TREE_PREEMPT_RCU
+	&rcu_preempt_state,
+#endif /* #ifdef CONFIG_TREE_PREEMPT_RCU */
+};
+
+/* Parse the boot-time rcu_nocbs= CPU list from the kernel parameters. */
+static int __init rcu_nocb_setup(char *str)
+{
+	alloc_bootmem_cpumask_var(&rcu_nocb_mask);
+	have_rcu_nocb_mask = true;
+	cpulist_parse(str, rcu_nocb_mask);
+	return 1;
+}
+__setup("rcu_nocbs=", rcu_nocb_setup);
+
+/* Is the specified CPU a no-CBs CPU? */
+static bool rcu_is_nocb_cpu(int cpu)
+{
+	if (have_rcu_nocb_mask)
+		return cpumask_test_cpu(cpu, rcu_nocb_mask);
+	return false;
+}
+
+/*
+ * Enqueue the specified callback onto the specified rcu_data structure's
+ * no-CBs list.  Returns true if the list was empty, in which case the
+ * rcuo kthread needs a wakeup.
+ */
+static bool __call_rcu_nocb_enqueue(struct rcu_data *rdp,
+				    struct rcu_head *rhp)
+{
+	struct rcu_head **old_rhpp;
+
+	old_rhpp = xchg(&rdp->nocb_tail, &rhp->next);
+	ACCESS_ONCE(*old_rhpp) = rhp;
+	atomic_long_inc(&rdp->nocb_q_count);
+	return old_rhpp == &rdp->nocb_head;
+}
+
+/*
+ * This is a helper for __call_rcu(), which invokes this when the normal
+ * callback queue is inoperable.  If this is not a no-CBs CPU, this
+ * function returns false, and the callback takes the normal path.  The
+ * rcuo kthread's own grace-period callback also takes the normal path.
+ *
+ * Waking the kthread with interrupts disabled could deadlock against the
+ * scheduler locks held by the caller, so the wakeup is left to the next
+ * scheduling-clock interrupt or idle entry instead.
+ */
+static bool __call_rcu_nocb(struct rcu_data *rdp, struct rcu_head *rhp,
+			    unsigned long flags)
+{
+	if (!rcu_is_nocb_cpu(rdp->cpu) || current == rdp->nocb_kthread)
+		return false;
+	if (!__call_rcu_nocb_enqueue(rdp, rhp))
+		return true;
+	if (!ACCESS_ONCE(rdp->nocb_kthread))
+		return true; /* Too early in boot, the kthread will see it. */
+	if (irqs_disabled_flags(flags))
+		ACCESS_ONCE(rdp->nocb_defer_wakeup) = true;
+	else
+		wake_up(&rdp->nocb_wq);
+	return true;
+}
+
+/* Do the wakeups that __call_rcu_nocb() had to leave for later. */
+static void do_nocb_deferred_wakeup(int cpu)
+{
+	struct rcu_data *rdp;
+	int i;
+
+	if (!rcu_is_nocb_cpu(cpu))
+		return;
+	for (i = 0; i < ARRAY_SIZE(rcu_nocb_flavors); i++) {
+		rdp = per_cpu_ptr(rcu_nocb_flavors[i]->rda, cpu);
+		if (ACCESS_ONCE(rdp->nocb_defer_wakeup)) {
+			ACCESS_ONCE(rdp->nocb_defer_wakeup) = false;
+			wake_up(&rdp->nocb_wq);
+		}
+	}
+}
+
+static DEFINE_PER_CPU(struct rcu_head, rcu_nocb_barrier_head);
+
+/*
+ * rcu_barrier_func() leaves the no-CBs CPUs alone: their callbacks stay
+ * with the rcuo kthreads whether they are online or not, so a barrier
+ * callback is entrained behind them on each of them here.  This includes
+ * kthreads with an empty list, which might still be invoking a batch.
+ */
+static void rcu_nocb_barrier(struct rcu_state *rsp)
+{
+	struct rcu_head *rhp;
+	struct rcu_data *rdp;
+	int cpu;
+
+	if (!have_rcu_nocb_mask)
+		return;
+	for_each_cpu(cpu, rcu_nocb_mask) {
+		rdp = per_cpu_ptr(rsp->rda, cpu);
+		if (!rdp->nocb_kthread)
+			continue;
+		rhp = &per_cpu(rcu_nocb_barrier_head, cpu);
+		rhp->func = rcu_barrier_callback;
+		rhp->next = NULL;
+		atomic_inc(&rcu_barrier_cpu_count);
+		if (__call_rcu_nocb_enqueue(rdp, rhp))
+			wake_up(&rdp->nocb_wq);
+	}
+}
+
+/*
+ * Per-rcu_data kthread, but only for no-CBs CPUs.  Each kthread invokes
+ * callbacks queued by the corresponding no-CBs CPU.
+ */
+static int rcu_nocb_kthread(void *arg)
+{
+	int c;
+	struct rcu_head *next;
+	struct rcu_head *list;
+	struct rcu_head **tail;
+	struct rcu_data *rdp = arg;
+
+	for (;;) {
+		wait_event_interruptible(rdp->nocb_wq,
+					 ACCESS_ONCE(rdp->nocb_head));
+		list = ACCESS_ONCE(rdp->nocb_head);
+		if (!list)
+			continue;
+
+		/* Pull the ready-to-invoke callbacks onto local list. */
+		ACCESS_ONCE(rdp->nocb_head) = NULL;
+		tail = xchg(&rdp->nocb_tail, &rdp->nocb_head);
+		c = atomic_long_xchg(&rdp->nocb_q_count, 0);
+		wait_rcu_gp(rdp->rsp->call);
+
+		/* Each pass through the following loop invokes a callback. */
+		trace_rcu_batch_start(rdp->rsp->name, 0, c, -1);
+		while (list) {
+			next = list->next;
+			/* Wait for enqueuing to complete, if needed. */
+			while (next == NULL && &list->next != tail) {
+				schedule_timeout_interruptible(1);
+				next = list->next;
+			}
+			debug_rcu_head_unqueue(list);
+			local_bh_disable();
+			__rcu_reclaim(rdp->rsp->name, list);
+			local_bh_enable();
+			list = next;
+			cond_resched();
+		}
+		trace_rcu_batch_end(rdp->rsp->name, c, !!list, 0, 0, 1);
+		rdp->n_nocbs_invoked += c;
+	}
+	return 0;
+}
+
+/* Initialize per-rcu_data variables for no-CBs CPUs. */
+static void __init rcu_boot_init_nocb_percpu_data(struct rcu_data *rdp)
+{
+	rdp->nocb_tail = &rdp->nocb_head;
+	init_waitqueue_head(&rdp->nocb_wq);
+}
+
+/*
+ * Settle the set of no-CBs CPUs.  Without rcu_nocbs=, RCU_NOCB_CPU_ALL
+ * offloads every CPU but the boot CPU.
+ */
+static void __init rcu_init_nocb(void)
+{
+#ifdef CONFIG_RCU_NOCB_CPU_ALL
+	if (!have_rcu_nocb_mask) {
+		alloc_bootmem_cpumask_var(&rcu_nocb_mask);
+		have_rcu_nocb_mask = true;
+		cpumask_copy(rcu_nocb_mask, cpu_possible_mask);
+	}
+#endif /* #ifdef CONFIG_RCU_NOCB_CPU_ALL */
+	if (!have_rcu_nocb_mask)
+		return;
+	if (cpumask_test_cpu(smp_processor_id(), rcu_nocb_mask)) {
+		if (!cpumask_equal(rcu_nocb_mask, cpu_possible_mask))
+			printk(KERN_INFO "\tBoot CPU %d is not offloaded.\n",
+			       smp_processor_id());
+		cpumask_clear_cpu(smp_processor_id(), rcu_nocb_mask);
+	}
+	cpumask_and(rcu_nocb_mask, rcu_nocb_mask, cpu_possible_mask);
+	if (!cpumask_empty(rcu_nocb_mask)) {
+		static char nocb_buf[NR_CPUS * 5] __initdata;
+
+
+		cpulist_scnprintf(nocb_buf, sizeof(nocb_buf), rcu_nocb_mask);
+		printk(KERN_INFO "\tOffload RCU callbacks from CPUs: %s.\n",
+		       nocb_buf);
+	}
+}
+
+/*
+ * Create a kthread for each RCU flavor for each no-CBs CPU, and keep them
+ * on the CPUs that are not offloaded.
+ */
+static int __init rcu_spawn_nocb_kthreads(void)
+{
+	static struct cpumask housekeeping __initdata;
+	struct task_struct *t;
+	struct rcu_data *rdp;
+	int cpu;
+	int i;
+
+	if (!have_rcu_nocb_mask)
+		return 0;
+	cpumask_andnot(&housekeeping, cpu_possible_mask, rcu_nocb_mask);
+	for_each_cpu(cpu, rcu_nocb_mask) {
+		for (i = 0; i < ARRAY_SIZE(rcu_nocb_flavors); i++) {
+			rdp = per_cpu_ptr(rcu_nocb_flavors[i]->rda, cpu);
+			t = kthread_create(rcu_nocb_kthread, rdp, "rcuo%c/%d",
+					   rcu_nocb_flavors[i]->name[4], cpu);
+			if (IS_ERR(t))
+				continue;
+			set_cpus_allowed_ptr(t, &housekeeping);
+			ACCESS_ONCE(rdp->nocb_kthread) = t;
+			wake_up_process(t);
+		}
+	}
+	return 0;
+}
+early_initcall(rcu_spawn_nocb_kthreads);
+
+#else /* #ifdef CONFIG_RCU_NOCB_CPU */
+
+static bool __call_rcu_nocb(struct rcu_data *rdp, struct rcu_head *rhp,
+			    unsigned long flags)
+{
+	return false;
+}
+
+static void do_nocb_deferred_wakeup(int cpu)
+{
+}
+
+static bool rcu_is_nocb_cpu(int cpu)
+{
+	return false;
+}
+
+static void rcu_nocb_barrier(struct rcu_state *rsp)
+{
+}
+
+static void __init rcu_boot_init_nocb_percpu_data(struct rcu_data *rdp)
+{
+}
+
+static void __init rcu_init_nocb(void)
+{
+}
+
+#endif /* #else #ifdef CONFIG_RCU_NOCB_CPU */
@@ -711,11 +711,124 @@ static void set_load_weight(struct task_struct *p)
 	load->inv_weight = prio_to_wmult[prio];
 }
 
+#ifdef CONFIG_SCHED_LOAD_NOTIFY
+static sched_load_notify_t sched_load_notify_fn __read_mostly;
+static DEFINE_MUTEX(sched_load_notify_mutex);
+
+/*
+ * Only one listener is supported, the hook sits in the enqueue and
+ * dequeue fast paths and is kept down to a single pointer test.
+ */
+int sched_load_notify_register(sched_load_notify_t fn)
+{
+	int ret = 0;
+
+	mutex_lock(&sched_load_notify_mutex);
+	if (sched_load_notify_fn)
+		ret = -EBUSY;
+	else
+		rcu_assign_pointer(sched_load_notify_fn, fn);
+	mutex_unlock(&sched_load_notify_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(sched_load_notify_register);
+
+void sched_load_notify_unregister(sched_load_notify_t fn)
+{
+	mutex_lock(&sched_load_notify_mutex);
+	if (sched_load_notify_fn == fn)
+		rcu_assign_pointer(sched_load_notify_fn, NULL);
+	mutex_unlock(&sched_load_notify_mutex);
+
+	/* Callers run with interrupts off, wait for them to finish */
+	synchronize_sched();
+}
+EXPORT_SYMBOL_GPL(sched_load_notify_unregister);
+
+static inline void sched_load_notify(int cpu, struct task_struct *p,
+			enum sched_load_event event, unsigned int nr_running)
+{
+	sched_load_notify_t fn = rcu_dereference_sched(sched_load_notify_fn);
+
+	if (fn)
+		fn(cpu, event, nr_running,
+		   p->se.sum_exec_runtime - p->se.prev_sum_exec_runtime);
+}
+#else
+static inline void sched_load_notify(int cpu, struct task_struct *p,
+			enum sched_load_event event, unsigned int nr_running)
+{
+}
+#endif
+
+#ifdef CONFIG_CGROUP_FREQ_HINTS
+/*
+ * rq->freq_floor only drops once the last queued task of a group with a
+ * floor is gone, until then it is the highest floor seen since.
+ */
+static inline void freq_hints_enqueue(struct rq *rq, struct task_struct *p)
+{
+	unsigned int floor = task_group(p)->freq_floor;
+
+	if (likely(!floor))
+		return;
+
+	p->sched_freq_floor = true;
+	rq->freq_floor_nr++;
+	if (floor > rq->freq_floor)
+		rq->freq_floor = floor;
+}
+
+static inline void freq_hints_dequeue(struct rq *rq, struct task_struct *p)
+{
+	if (likely(!p->sched_freq_floor))
+		return;
+
+	p->sched_freq_floor = false;
+	if (!--rq->freq_floor_nr)
+		rq->freq_floor = 0;
+}
+
+u64 sched_freq_discount_us(int cpu)
+{
+	struct rq *rq = cpu_rq(cpu);
+	unsigned int start;
+	u64 ns;
+
+	do {
+		start = u64_stats_fetch_begin(&rq->freq_discount_sync);
+		ns = rq->freq_discount_ns;
+	} while (u64_stats_fetch_retry(&rq->freq_discount_sync, start));
+
+	return div_u64(ns, NSEC_PER_USEC);
+}
+EXPORT_SYMBOL_GPL(sched_freq_discount_us);
+
+unsigned int sched_freq_floor(int cpu)
+{
+	return ACCESS_ONCE(cpu_rq(cpu)->freq_floor);
+}
+EXPORT_SYMBOL_GPL(sched_freq_floor);
+#else
+static inline void freq_hints_enqueue(struct rq *rq, struct task_struct *p)
+{
+}
+
+static inline void freq_hints_dequeue(struct rq *rq, struct task_struct *p)
+{
+}
+#endif
+
 static void enqueue_task(struct rq *rq, struct task_struct *p, int flags)
 {
 	update_rq_clock(rq);
 	sched_info_queued(p);
 	p->sched_class->enqueue_task(rq, p, flags);
+	freq_hints_enqueue(rq, p);
+	sched_load_notify(cpu_of(rq), p, (flags & ENQUEUE_WAKEUP) ?
+			  SCHED_LOAD_WAKEUP : SCHED_LOAD_ENQUEUE,
+			  rq->nr_running);
 }
 
 static void dequeue_task(struct rq *rq, struct task_struct *p, int flags)
@@ -723,6 +836,8 @@ static void dequeue_task(struct rq *rq, struct task_struct *p, int flags)
 	update_rq_clock(rq);
 	sched_info_dequeued(p);
 	p->sched_class->dequeue_task(rq, p, flags);
+	freq_hints_dequeue(rq, p);
+	sched_load_notify(cpu_of(rq), p, SCHED_LOAD_DEQUEUE, rq->nr_running);
 }
 
 void activate_task(struct rq *rq, struct task_struct *p, int flags)
@@ -1112,6 +1227,8 @@ void set_task_cpu(struct task_struct *p, unsigned int new_cpu)
 	if (task_cpu(p) != new_cpu) {
 		p->se.nr_migrations++;
 		perf_sw_event(PERF_COUNT_SW_CPU_MIGRATIONS, 1, NULL, 0);
+		sched_load_notify(new_cpu, p, SCHED_LOAD_MIGRATE,
+				  cpu_rq(new_cpu)->nr_running);
 	}
 
 	__set_task_cpu(p, new_cpu);
@@ -1262,6 +1379,22 @@ EXPORT_SYMBOL_GPL(kick_process);
 /*
  * ->cpus_allowed is protected by both rq->lock and p->pi_lock
  */
+#ifdef CONFIG_SCHED_CPU_PARK
+static struct cpumask cpu_parked_mask;
+
+/* Tasks that can run on an active CPU are kept off parked CPUs */
+static inline bool cpu_parked_for(int cpu, struct task_struct *p)
+{
+	return cpumask_test_cpu(cpu, &cpu_parked_mask) &&
+		cpumask_intersects(tsk_cpus_allowed(p), cpu_active_mask);
+}
+#else
+static inline bool cpu_parked_for(int cpu, struct task_struct *p)
+{
+	return false;
+}
+#endif
+
 static int select_fallback_rq(int cpu, struct task_struct *p)
 {
 	const struct cpumask *nodemask = cpumask_of_node(cpu_to_node(cpu));
@@ -1341,7 +1474,7 @@ int select_task_rq(struct task_struct *p, int sd_flags, int wake_flags)
 	 *   not worry about this generic constraint ]
 	 */
 	if (unlikely(!cpumask_test_cpu(cpu, tsk_cpus_allowed(p)) ||
-		     !cpu_online(cpu)))
+		     !cpu_online(cpu) || cpu_parked_for(cpu, p)))
 		cpu = select_fallback_rq(task_cpu(p), p);
 
 	return cpu;
@@ -1714,6 +1847,15 @@ static void __sched_fork(struct task_struct *p)
 	p->se.sum_exec_runtime		= 0;
 	p->se.prev_sum_exec_runtime	= 0;
 	p->se.nr_migrations		= 0;
+#ifdef CONFIG_SCHED_FRAME_DEADLINE
+	p->frame_budget_us		= 0;
+	p->frame_boosts			= 0;
+	p->frame_missed			= 0;
+	INIT_LIST_HEAD(&p->frame_node);
+#endif
+#ifdef CONFIG_CGROUP_FREQ_HINTS
+	p->sched_freq_floor		= false;
+#endif
 	p->se.vruntime			= 0;
 	INIT_LIST_HEAD(&p->se.group_node);
 
@@ -2158,6 +2300,14 @@ unsigned long nr_iowait_cpu(int cpu)
 	return atomic_read(&this->nr_iowait);
 }
 
+#ifdef CONFIG_SCHED_LOAD_NOTIFY
+unsigned long nr_running_cpu(int cpu)
+{
+	return cpu_rq(cpu)->nr_running;
+}
+EXPORT_SYMBOL_GPL(nr_running_cpu);
+#endif
+
 unsigned long this_cpu_load(void)
 {
 	struct rq *this = this_rq();
@@ -4122,6 +4272,31 @@ out_unlock:
 }
 EXPORT_SYMBOL(set_user_nice);
 
+#ifdef CONFIG_SCHED_FRAME_DEADLINE
+/*
+ * Move a runnable CFS task that is about to miss its frame to the head of
+ * its runqueue. Its vruntime is relative to min_vruntime while dequeued.
+ */
+void sched_frame_boost_task(struct task_struct *p)
+{
+	unsigned long flags;
+	struct rq *rq;
+
+	rq = task_rq_lock(p, &flags);
+	if (!p->on_rq || task_running(rq, p) ||
+	    p->sched_class != &fair_sched_class)
+		goto out_unlock;
+
+	dequeue_task(rq, p, 0);
+	if ((s64)p->se.vruntime > 0)
+		p->se.vruntime = 0;
+	enqueue_task(rq, p, 0);
+	check_preempt_curr(rq, p, 0);
+out_unlock:
+	task_rq_unlock(rq, p, &flags);
+}
+#endif
+
 /*
  * can_nice - check if a task can reduce its nice value
  * @p: task
@@ -5327,6 +5502,111 @@ static int migration_cpu_stop(void *data)
 	return 0;
 }
 
+#ifdef CONFIG_SCHED_CPU_PARK
+static DEFINE_MUTEX(sched_park_mutex);
+
+bool cpu_parked(int cpu)
+{
+	return cpumask_test_cpu(cpu, &cpu_parked_mask);
+}
+EXPORT_SYMBOL_GPL(cpu_parked);
+
+#define SCHED_PARK_BATCH	32
+#define SCHED_PARK_PASSES	4
+
+/*
+ * Move the queued tasks that may run elsewhere off @cpu, the ones bound
+ * to it stay. Sleeping tasks are placed by select_task_rq() on wakeup.
+ */
+static void sched_push_tasks_off(int cpu)
+{
+	struct task_struct *batch[SCHED_PARK_BATCH];
+	struct task_struct *g, *p;
+	struct migration_arg arg;
+	int pass, i, n;
+
+	for (pass = 0; pass < SCHED_PARK_PASSES; pass++) {
+		n = 0;
+		read_lock(&tasklist_lock);
+		do_each_thread(g, p) {
+			if (task_cpu(p) != cpu || !p->on_rq ||
+			    !cpu_parked_for(cpu, p))
+				continue;
+			get_task_struct(p);
+			batch[n++] = p;
+			if (n == SCHED_PARK_BATCH)
+				goto collected;
+		} while_each_thread(g, p);
+collected:
+		read_unlock(&tasklist_lock);
+
+		if (!n)
+			break;
+
+		for (i = 0; i < n; i++) {
+			arg.task = batch[i];
+			arg.dest_cpu = cpumask_any_and(cpu_active_mask,
+						tsk_cpus_allowed(batch[i]));
+			if (arg.dest_cpu < nr_cpu_ids)
+				stop_one_cpu(cpu, migration_cpu_stop, &arg);
+			put_task_struct(batch[i]);
+		}
+	}
+}
+
+/*
+ * Take @cpu out of scheduling without unplugging it: it is marked
+ * inactive, removed from the sched domains and emptied of the tasks that
+ * can run elsewhere. It then sits in idle until unparked, which only
+ * costs a sched domain rebuild.
+ */
+int sched_cpu_park(int cpu)
+{
+	int ret = 0;
+
+	mutex_lock(&sched_park_mutex);
+	get_online_cpus();
+
+	if (!cpu_online(cpu) || cpu_parked(cpu)) {
+		ret = cpu_online(cpu) ? 0 : -EINVAL;
+		goto out;
+	}
+	if (num_active_cpus() <= 1) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	cpumask_set_cpu(cpu, &cpu_parked_mask);
+	set_cpu_active(cpu, false);
+	cpuset_update_active_cpus();
+	sched_push_tasks_off(cpu);
+out:
+	put_online_cpus();
+	mutex_unlock(&sched_park_mutex);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(sched_cpu_park);
+
+int sched_cpu_unpark(int cpu)
+{
+	mutex_lock(&sched_park_mutex);
+	get_online_cpus();
+
+	if (cpu_parked(cpu)) {
+		cpumask_clear_cpu(cpu, &cpu_parked_mask);
+		set_cpu_active(cpu, true);
+		cpuset_update_active_cpus();
+		/* Let it pull work right away instead of at its next tick */
+		smp_send_reschedule(cpu);
+	}
+
+	put_online_cpus();
+	mutex_unlock(&sched_park_mutex);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(sched_cpu_unpark);
+#endif
+
 #ifdef CONFIG_HOTPLUG_CPU
 
 /*
@@ -5690,8 +5970,15 @@ static int __cpuinit sched_cpu_active(struct notifier_block *nfb,
 				      unsigned long action, void *hcpu)
 {
 	switch (action & ~CPU_TASKS_FROZEN) {
+#ifdef CONFIG_SCHED_CPU_PARK
+	case CPU_ONLINE:
+		/* A CPU coming back from a real unplug is not parked */
+		cpumask_clear_cpu((long)hcpu, &cpu_parked_mask);
+		return NOTIFY_OK;
+#endif
 	case CPU_DOWN_FAILED:
-		set_cpu_active((long)hcpu, true);
+		if (!cpu_parked((long)hcpu))
+			set_cpu_active((long)hcpu, true);
 		return NOTIFY_OK;
 	default:
 		return NOTIFY_DONE;
@@ -8255,6 +8542,41 @@ static u64 cpu_rt_period_read_uint(struct cgroup *cgrp, struct cftype *cft)
 }
 #endif /* CONFIG_RT_GROUP_SCHED */
 
+#ifdef CONFIG_CGROUP_FREQ_HINTS
+static int cpu_freq_load_pct_write_u64(struct cgroup *cgrp,
+				       struct cftype *cftype, u64 pct)
+{
+	if (pct > 100)
+		return -EINVAL;
+
+	cgroup_tg(cgrp)->freq_discount = div_u64((100 - pct) << 10, 100);
+	return 0;
+}
+
+static u64 cpu_freq_load_pct_read_u64(struct cgroup *cgrp, struct cftype *cft)
+{
+	unsigned int discount = cgroup_tg(cgrp)->freq_discount;
+
+	return 100 - DIV_ROUND_CLOSEST(discount * 100, 1 << 10);
+}
+
+/* Tasks already queued get the new floor the next time they are queued */
+static int cpu_freq_floor_write_u64(struct cgroup *cgrp, struct cftype *cftype,
+				    u64 khz)
+{
+	if (khz > UINT_MAX)
+		return -EINVAL;
+
+	cgroup_tg(cgrp)->freq_floor = khz;
+	return 0;
+}
+
+static u64 cpu_freq_floor_read_u64(struct cgroup *cgrp, struct cftype *cft)
+{
+	return cgroup_tg(cgrp)->freq_floor;
+}
+#endif /* CONFIG_CGROUP_FREQ_HINTS */
+
 static struct cftype cpu_files[] = {
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	{
@@ -8291,6 +8613,18 @@ static struct cftype cpu_files[] = {
 		.write_u64 = cpu_rt_period_write_uint,
 	},
 #endif
+#ifdef CONFIG_CGROUP_FREQ_HINTS
+	{
+		.name = "freq_load_pct",
+		.read_u64 = cpu_freq_load_pct_read_u64,
+		.write_u64 = cpu_freq_load_pct_write_u64,
+	},
+	{
+		.name = "freq_floor_khz",
+		.read_u64 = cpu_freq_floor_read_u64,
+		.write_u64 = cpu_freq_floor_write_u64,
+	},
+#endif
 };
 
 static int cpu_cgroup_populate(struct cgroup_subsys *ss, struct cgroup *cont)
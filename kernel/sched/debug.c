@@ -304,6 +304,10 @@ static void print_cpu(struct seq_file *m, int cpu)
 
 	P(ttwu_count);
 	P(ttwu_local);
+#ifdef CONFIG_SCHED_WAKE_CACHE_WARM
+	P(ttwu_warm_local);
+	P(ttwu_warm_migrate);
+#endif
 
 #undef P
 #undef P64
@@ -26,6 +26,7 @@
 #include <linux/slab.h>
 #include <linux/profile.h>
 #include <linux/interrupt.h>
+#include <linux/cpuidle.h>
 
 #include <trace/events/sched.h>
 
@@ -708,6 +709,7 @@ static void update_curr(struct cfs_rq *cfs_rq)
 		trace_sched_stat_runtime(curtask, delta_exec, curr->vruntime);
 		cpuacct_charge(curtask, delta_exec);
 		account_group_exec_runtime(curtask, delta_exec);
+		freq_hints_charge(rq_of(cfs_rq), curtask, delta_exec);
 	}
 
 	account_cfs_rq_runtime(cfs_rq, delta_exec);
@@ -2700,6 +2702,56 @@ done:
 	return target;
 }
 
+#ifdef CONFIG_SCHED_WAKE_CACHE_WARM
+/*
+ * A wakee that ran for less than the migration cost last time has a small
+ * cache footprint, and the waking cpu has the data it was woken for. When
+ * moving it to @target costs more than running it here, because the cpu
+ * has to leave a deep idle state first or because the waker is about to
+ * sleep anyway, keep it local.
+ */
+static int wake_cache_warm(struct task_struct *p, int cpu, int target,
+			   int sync)
+{
+	struct rq *rq = cpu_rq(cpu);
+	u64 runtime, exit_ns;
+	unsigned int nr_running;
+
+	if (!sched_feat(WAKE_CACHE_WARM) || target == cpu)
+		return target;
+
+	runtime = p->se.sum_exec_runtime - p->se.prev_sum_exec_runtime;
+	if (runtime >= sysctl_sched_migration_cost)
+		goto migrate;
+
+	/* Only the waker, which is about to sleep on a sync wakeup */
+	nr_running = rq->nr_running;
+	if (sync && nr_running)
+		nr_running--;
+	if (nr_running > 1)
+		goto migrate;
+
+	exit_ns = (u64)cpuidle_get_exit_latency(target) * NSEC_PER_USEC;
+
+	/* The wakee's own cache is warm on its previous cpu */
+	if (target == task_cpu(p) ? exit_ns > runtime :
+	    sync || exit_ns > runtime) {
+		schedstat_inc(rq, ttwu_warm_local);
+		return cpu;
+	}
+
+migrate:
+	schedstat_inc(rq, ttwu_warm_migrate);
+	return target;
+}
+#else
+static inline int wake_cache_warm(struct task_struct *p, int cpu, int target,
+				  int sync)
+{
+	return target;
+}
+#endif
+
 /*
  * sched_balance_self: balance the current task (running on cpu) in domains
  * that have the 'flag' flag set. In practice, this is SD_BALANCE_FORK and
@@ -2785,6 +2837,7 @@ select_task_rq_fair(struct task_struct *p, int sd_flag, int wake_flags)
 			prev_cpu = cpu;
 
 		new_cpu = select_idle_sibling(p, prev_cpu);
+		new_cpu = wake_cache_warm(p, cpu, new_cpu, sync);
 		goto unlock;
 	}
 
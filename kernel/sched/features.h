@@ -69,3 +69,11 @@ SCHED_FEAT(TTWU_QUEUE, true)
 SCHED_FEAT(FORCE_SD_OVERLAP, false)
 SCHED_FEAT(RT_RUNTIME_SHARE, true)
 SCHED_FEAT(LB_MIN, false)
+
+#ifdef CONFIG_SCHED_WAKE_CACHE_WARM
+/*
+ * Keep short running wakees on the waking cpu rather than paying a cold
+ * cache and an idle exit on another one.
+ */
+SCHED_FEAT(WAKE_CACHE_WARM, true)
+#endif
@@ -0,0 +1,186 @@
+/*
+ * kernel/sched/frame.c
+ *
+ * Frame deadline hints for display tasks.
+ *
+ * A task that renders frames (SurfaceFlinger, RenderThread) sets a budget:
+ * the time it needs before the next vsync to get its frame out. The
+ * display driver reports vsyncs through sched_frame_vsync(). When a hinted
+ * task is still runnable at the point where only its budget is left before
+ * the next vsync, it is moved to the head of its CFS runqueue and the
+ * cpufreq input boost is kicked for the rest of the frame. A hinted task
+ * that is still runnable when the vsync comes has missed it.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ */
+
+#include <linux/sched.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/cpufreq.h>
+#include <linux/module.h>
+
+#include "sched.h"
+
+/* Vsync periods outside of this range are glitches or a restart */
+#define FRAME_PERIOD_MIN	(NSEC_PER_SEC / 120)
+#define FRAME_PERIOD_MAX	(NSEC_PER_SEC / 20)
+
+/* Protects the list of hinted tasks and the frame state */
+static DEFINE_SPINLOCK(frame_lock);
+static LIST_HEAD(frame_tasks);
+static unsigned int frame_seq;
+static u64 frame_last_vsync;
+static u64 frame_period = NSEC_PER_SEC / 60;
+static struct hrtimer frame_timer;
+
+static inline u64 frame_urgent_at(struct task_struct *p, u64 next_vsync)
+{
+	return next_vsync - min_t(u64, (u64)p->frame_budget_us * NSEC_PER_USEC,
+				  frame_period);
+}
+
+/*
+ * Earliest point after @now where a runnable hinted task, not boosted yet
+ * in this frame, gets close to the next vsync. 0 if there is none.
+ */
+static u64 frame_next_urgent(u64 now)
+{
+	u64 next_vsync = frame_last_vsync + frame_period;
+	u64 at, first = 0;
+	struct task_struct *p;
+
+	list_for_each_entry(p, &frame_tasks, frame_node) {
+		if (p->frame_boost_seq == frame_seq)
+			continue;
+		at = frame_urgent_at(p, next_vsync);
+		if (at > now && (!first || at < first))
+			first = at;
+	}
+
+	return first;
+}
+
+static enum hrtimer_restart frame_timer_fn(struct hrtimer *timer)
+{
+	u64 now = ktime_to_ns(ktime_get());
+	u64 next_vsync, next;
+	struct task_struct *p;
+	bool boost = false;
+	unsigned long flags;
+
+	spin_lock_irqsave(&frame_lock, flags);
+	next_vsync = frame_last_vsync + frame_period;
+
+	list_for_each_entry(p, &frame_tasks, frame_node) {
+		if (p->frame_boost_seq == frame_seq || !p->on_rq)
+			continue;
+		if (now < frame_urgent_at(p, next_vsync))
+			continue;
+
+		p->frame_boost_seq = frame_seq;
+		p->frame_boosts++;
+		sched_frame_boost_task(p);
+		boost = true;
+	}
+
+	/* Restarted under the lock, so that it cannot race with a vsync */
+	next = frame_next_urgent(now);
+	if (next)
+		hrtimer_start(timer, ns_to_ktime(next), HRTIMER_MODE_ABS);
+	spin_unlock_irqrestore(&frame_lock, flags);
+
+	/* Until the vsync and through the next frame */
+	if (boost)
+		cpufreq_input_boost_kick(div_u64(next_vsync - now +
+						 frame_period, NSEC_PER_MSEC));
+
+	return HRTIMER_NORESTART;
+}
+
+/**
+ * sched_frame_vsync - report a display vsync
+ * @timestamp: time of the vsync in ns, on the ktime_get() clock
+ *
+ * Called from the display interrupt handler of the main display.
+ */
+void sched_frame_vsync(u64 timestamp)
+{
+	struct task_struct *p;
+	unsigned long flags;
+	u64 delta, next;
+
+	spin_lock_irqsave(&frame_lock, flags);
+
+	delta = timestamp - frame_last_vsync;
+	if (delta >= FRAME_PERIOD_MIN && delta <= FRAME_PERIOD_MAX)
+		frame_period = div_u64(frame_period * 7 + delta, 8);
+	frame_last_vsync = timestamp;
+	frame_seq++;
+
+	/* Still runnable, the frame did not make it */
+	list_for_each_entry(p, &frame_tasks, frame_node)
+		if (p->on_rq)
+			p->frame_missed++;
+
+	next = frame_next_urgent(timestamp);
+	if (next)
+		hrtimer_start(&frame_timer, ns_to_ktime(next),
+			      HRTIMER_MODE_ABS);
+
+	spin_unlock_irqrestore(&frame_lock, flags);
+}
+EXPORT_SYMBOL_GPL(sched_frame_vsync);
+
+/**
+ * sched_frame_set_budget - set the frame deadline hint of a task
+ * @p: the task
+ * @budget_us: time the task needs before each vsync, 0 clears the hint
+ */
+int sched_frame_set_budget(struct task_struct *p, unsigned int budget_us)
+{
+	unsigned long flags;
+	int ret = 0;
+
+	if (budget_us > FRAME_PERIOD_MAX / NSEC_PER_USEC)
+		return -EINVAL;
+
+	spin_lock_irqsave(&frame_lock, flags);
+	if (p->flags & PF_EXITING) {
+		ret = -ESRCH;
+		goto out;
+	}
+
+	p->frame_budget_us = budget_us;
+	if (budget_us && list_empty(&p->frame_node)) {
+		p->frame_boost_seq = frame_seq;
+		list_add(&p->frame_node, &frame_tasks);
+	} else if (!budget_us) {
+		list_del_init(&p->frame_node);
+	}
+out:
+	spin_unlock_irqrestore(&frame_lock, flags);
+
+	return ret;
+}
+
+/* Called from do_exit(), once PF_EXITING is set */
+void sched_frame_exit(struct task_struct *p)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&frame_lock, flags);
+	list_del_init(&p->frame_node);
+	spin_unlock_irqrestore(&frame_lock, flags);
+}
+
+static int __init sched_frame_init(void)
+{
+	hrtimer_init(&frame_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	frame_timer.function = frame_timer_fn;
+
+	return 0;
+}
+early_initcall(sched_frame_init);
@@ -3,6 +3,7 @@
 #include <linux/mutex.h>
 #include <linux/spinlock.h>
 #include <linux/stop_machine.h>
+#include <linux/u64_stats_sync.h>
 
 #include "cpupri.h"
 
@@ -133,6 +134,12 @@ struct task_group {
 #endif
 
 	struct cfs_bandwidth cfs_bandwidth;
+
+#ifdef CONFIG_CGROUP_FREQ_HINTS
+	/* Share of the runtime hidden from the governors, out of 1024 */
+	unsigned int freq_discount;
+	unsigned int freq_floor;	/* kHz */
+#endif
 };
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
@@ -458,11 +465,24 @@ struct rq {
 	/* try_to_wake_up() stats */
 	unsigned int ttwu_count;
 	unsigned int ttwu_local;
+#ifdef CONFIG_SCHED_WAKE_CACHE_WARM
+	unsigned int ttwu_warm_local;
+	unsigned int ttwu_warm_migrate;
+#endif
 #endif
 
 #ifdef CONFIG_SMP
 	struct llist_head wake_list;
 #endif
+
+#ifdef CONFIG_CGROUP_FREQ_HINTS
+	/* Read locklessly by the governors */
+	u64 freq_discount_ns;
+	struct u64_stats_sync freq_discount_sync;
+	/* Queued tasks of groups with a floor, and the highest floor */
+	unsigned int freq_floor_nr;
+	unsigned int freq_floor;
+#endif
 };
 
 static inline int cpu_of(struct rq *rq)
@@ -579,6 +599,26 @@ static inline struct task_group *task_group(struct task_struct *p)
 
 #endif /* CONFIG_CGROUP_SCHED */
 
+#ifdef CONFIG_CGROUP_FREQ_HINTS
+static inline void freq_hints_charge(struct rq *rq, struct task_struct *p,
+				     unsigned long delta_exec)
+{
+	unsigned int discount = task_group(p)->freq_discount;
+
+	if (likely(!discount))
+		return;
+
+	u64_stats_update_begin(&rq->freq_discount_sync);
+	rq->freq_discount_ns += ((u64)delta_exec * discount) >> 10;
+	u64_stats_update_end(&rq->freq_discount_sync);
+}
+#else
+static inline void freq_hints_charge(struct rq *rq, struct task_struct *p,
+				     unsigned long delta_exec)
+{
+}
+#endif
+
 static inline void __set_task_cpu(struct task_struct *p, unsigned int cpu)
 {
 	set_task_rq(p, cpu);
@@ -870,6 +910,9 @@ extern void init_sched_rt_class(void);
 extern void init_sched_fair_class(void);
 
 extern void resched_task(struct task_struct *p);
+#ifdef CONFIG_SCHED_FRAME_DEADLINE
+extern void sched_frame_boost_task(struct task_struct *p);
+#endif
 extern void resched_cpu(int cpu);
 
 extern struct rt_bandwidth def_rt_bandwidth;
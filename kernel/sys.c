@@ -1998,6 +1998,48 @@ static int prctl_set_vma(unsigned long opt, unsigned long start,
 	return error;
 }
 
+#ifdef CONFIG_SCHED_FRAME_DEADLINE
+static int prctl_frame_deadline(unsigned long opt, unsigned long budget_us,
+		unsigned long pid)
+{
+	struct task_struct *tsk;
+	int error;
+
+	if (pid && task_pid_vnr(current) != (pid_t)pid &&
+			!capable(CAP_SYS_NICE))
+		return -EPERM;
+
+	rcu_read_lock();
+	tsk = pid ? find_task_by_vpid((pid_t)pid) : current;
+	if (tsk == NULL) {
+		rcu_read_unlock();
+		return -ESRCH;
+	}
+	get_task_struct(tsk);
+	rcu_read_unlock();
+
+	switch (opt) {
+	case PR_FRAME_DEADLINE_SET:
+		error = sched_frame_set_budget(tsk, budget_us);
+		break;
+	case PR_FRAME_DEADLINE_GET:
+		error = tsk->frame_budget_us;
+		break;
+	default:
+		error = -EINVAL;
+	}
+
+	put_task_struct(tsk);
+	return error;
+}
+#else
+static int prctl_frame_deadline(unsigned long opt, unsigned long budget_us,
+		unsigned long pid)
+{
+	return -EINVAL;
+}
+#endif
+
 SYSCALL_DEFINE5(prctl, int, option, unsigned long, arg2, unsigned long, arg3,
 		unsigned long, arg4, unsigned long, arg5)
 {
@@ -2182,6 +2224,9 @@ SYSCALL_DEFINE5(prctl, int, option, unsigned long, arg2, unsigned long, arg3,
 			put_task_struct(tsk);
 			error = 0;
 			break;
+		case PR_FRAME_DEADLINE:
+			error = prctl_frame_deadline(arg2, arg3, arg4);
+			break;
 		case PR_SET_NO_NEW_PRIVS:
 			if (arg2 != 1 || arg3 || arg4 || arg5)
 				return -EINVAL;
@@ -0,0 +1,132 @@
+/*
+ * kernel/time/timer_slack.c
+ *
+ * Timer slack classes and coalescing statistics.
+ *
+ * A timer in a slack class may run late by a fraction of its timeout:
+ * 1 / 2^shift, the shift being set per class. Timer wheel timers are
+ * rounded within that range, hrtimers get it as their soft range, so that
+ * timers expiring close together are handled in one wakeup.
+ *
+ * Every hrtimer interrupt and every timer wheel jiffy that runs timers
+ * reports how many of them were due and how many came along, through the
+ * timer_coalesce tracepoint and, with CONFIG_TIMER_COALESCE_STATS, in
+ * /sys/kernel/debug/timer_coalesce.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/timer.h>
+#include <linux/percpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+#include <trace/events/timer.h>
+
+/* A shift of BITS_PER_LONG or more means no slack */
+static unsigned int timer_slack_shift[TIMER_SLACK_CLASSES] = {
+	[TIMER_SLACK_EXACT]		= BITS_PER_LONG,
+	[TIMER_SLACK_DEFAULT]		= 8,
+	[TIMER_SLACK_RELAXED]		= 4,
+	[TIMER_SLACK_BACKGROUND]	= 2,
+};
+module_param_named(relaxed_shift, timer_slack_shift[TIMER_SLACK_RELAXED],
+		   uint, 0644);
+MODULE_PARM_DESC(relaxed_shift, "Slack of relaxed timers, 1/2^shift of the timeout");
+module_param_named(background_shift,
+		   timer_slack_shift[TIMER_SLACK_BACKGROUND], uint, 0644);
+MODULE_PARM_DESC(background_shift, "Slack of background timers, 1/2^shift of the timeout");
+
+/**
+ * timer_slack_class_delta - slack allowed for a timeout
+ * @class: the slack class
+ * @delta: the timeout, in any unit
+ *
+ * Returns the slack, in the unit of @delta.
+ */
+unsigned long timer_slack_class_delta(enum timer_slack_class class,
+				      unsigned long delta)
+{
+	unsigned int shift;
+
+	if (class >= TIMER_SLACK_CLASSES)
+		return 0;
+
+	shift = ACCESS_ONCE(timer_slack_shift[class]);
+	if (shift >= BITS_PER_LONG)
+		return 0;
+
+	return delta >> shift;
+}
+EXPORT_SYMBOL_GPL(timer_slack_class_delta);
+
+#ifdef CONFIG_TIMER_COALESCE_STATS
+struct timer_coalesce_stats {
+	unsigned long fired[2];
+	unsigned long coalesced[2];
+};
+
+static DEFINE_PER_CPU(struct timer_coalesce_stats, timer_coalesce_stats);
+#endif
+
+/**
+ * timer_coalesce_batch - report a batch of expired timers
+ * @hrtimer: true for an hrtimer interrupt, false for a timer wheel jiffy
+ * @fired: number of timers that were due
+ * @coalesced: number of timers that came along
+ *
+ * Called by the timer code with interrupts disabled.
+ */
+void timer_coalesce_batch(bool hrtimer, unsigned int fired,
+			  unsigned int coalesced)
+{
+#ifdef CONFIG_TIMER_COALESCE_STATS
+	struct timer_coalesce_stats *st = &__get_cpu_var(timer_coalesce_stats);
+
+	st->fired[hrtimer] += fired;
+	st->coalesced[hrtimer] += coalesced;
+#endif
+	trace_timer_coalesce(hrtimer, fired, coalesced);
+}
+
+#ifdef CONFIG_TIMER_COALESCE_STATS
+static int timer_coalesce_show(struct seq_file *m, void *v)
+{
+	struct timer_coalesce_stats *st;
+	int cpu;
+
+	seq_printf(m, "cpu   hrtimer fired  coalesced    timer fired  coalesced\n");
+	for_each_possible_cpu(cpu) {
+		st = &per_cpu(timer_coalesce_stats, cpu);
+		seq_printf(m, "%-5d %13lu %10lu %14lu %10lu\n", cpu,
+			   st->fired[1], st->coalesced[1],
+			   st->fired[0], st->coalesced[0]);
+	}
+
+	return 0;
+}
+
+static int timer_coalesce_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, timer_coalesce_show, NULL);
+}
+
+static const struct file_operations timer_coalesce_fops = {
+	.open		= timer_coalesce_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init timer_coalesce_init(void)
+{
+	debugfs_create_file("timer_coalesce", S_IRUSR, NULL, NULL,
+			    &timer_coalesce_fops);
+	return 0;
+}
+late_initcall(timer_coalesce_init);
+#endif
@@ -0,0 +1,161 @@
+/*
+ * kernel/time/timer_wakeups.c
+ *
+ * Count, per CPU, the timer and work functions that run out of idle.
+ *
+ * A timer callback that runs in the context of the idle task is what
+ * brought the CPU out of idle, or came along with what did. Delayed work
+ * is accounted to the work function rather than to the workqueue timer.
+ *
+ * Display the top sources of each CPU:
+ * # cat /sys/kernel/debug/timer_wakeups
+ *
+ * Clear the counts:
+ * # echo 0 >/sys/kernel/debug/timer_wakeups
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/cpumask.h>
+#include <linux/timer.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+#define TIMER_WAKEUP_ENTRIES	32
+#define TIMER_WAKEUP_SHOW	10
+
+struct timer_wakeup_entry {
+	void *fn;
+	unsigned int count;
+};
+
+struct timer_wakeup_cpu {
+	struct timer_wakeup_entry entries[TIMER_WAKEUP_ENTRIES];
+	unsigned int overflow;
+};
+
+static DEFINE_PER_CPU(struct timer_wakeup_cpu, timer_wakeup_cpus);
+
+/**
+ * timer_wakeup_account - account a timer function that is about to run
+ * @fn: the timer function, or the work function for delayed work
+ *
+ * Called by the timer code with the function that is going to run.
+ */
+void timer_wakeup_account(void *fn)
+{
+	struct timer_wakeup_cpu *tw;
+	struct timer_wakeup_entry *e;
+	unsigned long flags;
+	int i;
+
+	if (!is_idle_task(current))
+		return;
+
+	local_irq_save(flags);
+	tw = &__get_cpu_var(timer_wakeup_cpus);
+	for (i = 0; i < TIMER_WAKEUP_ENTRIES; i++) {
+		e = &tw->entries[i];
+		if (e->fn == fn || !e->fn) {
+			e->fn = fn;
+			e->count++;
+			goto out;
+		}
+	}
+	tw->overflow++;
+out:
+	local_irq_restore(flags);
+}
+
+static int timer_wakeups_show(struct seq_file *m, void *v)
+{
+	struct timer_wakeup_entry top[TIMER_WAKEUP_SHOW];
+	struct timer_wakeup_cpu *tw;
+	struct timer_wakeup_entry e;
+	unsigned int overflow;
+	int cpu, i, j, n;
+
+	for_each_possible_cpu(cpu) {
+		tw = &per_cpu(timer_wakeup_cpus, cpu);
+		n = 0;
+
+		/* Racy against the owning CPU, it is only statistics */
+		for (i = 0; i < TIMER_WAKEUP_ENTRIES; i++) {
+			e = tw->entries[i];
+			if (!e.fn)
+				break;
+
+			/* Insertion into the sorted top list */
+			for (j = n; j > 0 && top[j - 1].count < e.count; j--)
+				if (j < TIMER_WAKEUP_SHOW)
+					top[j] = top[j - 1];
+			if (j < TIMER_WAKEUP_SHOW)
+				top[j] = e;
+			if (n < TIMER_WAKEUP_SHOW)
+				n++;
+		}
+		overflow = ACCESS_ONCE(tw->overflow);
+
+		seq_printf(m, "cpu%d:\n", cpu);
+		for (i = 0; i < n; i++)
+			seq_printf(m, "%10u  %pf\n", top[i].count, top[i].fn);
+		if (overflow)
+			seq_printf(m, "%10u  (not tracked)\n", overflow);
+	}
+
+	return 0;
+}
+
+static int timer_wakeups_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, timer_wakeups_show, NULL);
+}
+
+static void timer_wakeups_clear(void *info)
+{
+	struct timer_wakeup_cpu *tw = &__get_cpu_var(timer_wakeup_cpus);
+	unsigned long flags;
+
+	local_irq_save(flags);
+	memset(tw, 0, sizeof(*tw));
+	local_irq_restore(flags);
+}
+
+static ssize_t timer_wakeups_write(struct file *file, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	int cpu;
+
+	get_online_cpus();
+	on_each_cpu(timer_wakeups_clear, NULL, 1);
+	/* Offline CPUs do not run timers */
+	for_each_possible_cpu(cpu)
+		if (!cpu_online(cpu))
+			memset(&per_cpu(timer_wakeup_cpus, cpu), 0,
+			       sizeof(struct timer_wakeup_cpu));
+	put_online_cpus();
+
+	return count;
+}
+
+static const struct file_operations timer_wakeups_fops = {
+	.open		= timer_wakeups_open,
+	.read		= seq_read,
+	.write		= timer_wakeups_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init timer_wakeups_init(void)
+{
+	debugfs_create_file("timer_wakeups", S_IRUSR | S_IWUSR, NULL, NULL,
+			    &timer_wakeups_fops);
+	return 0;
+}
+late_initcall(timer_wakeups_init);
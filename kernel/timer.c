@@ -333,6 +333,21 @@ void set_timer_slack(struct timer_list *timer, int slack_hz)
 }
 EXPORT_SYMBOL_GPL(set_timer_slack);
 
+/**
+ * set_timer_slack_class - let a timer run late by a class of slack
+ * @timer: the timer to be modified
+ * @class: the slack class, see enum timer_slack_class
+ *
+ * The slack is a fraction of the timeout set by the class, applied by
+ * the next mod_timer().
+ */
+void set_timer_slack_class(struct timer_list *timer,
+			   enum timer_slack_class class)
+{
+	timer->slack = TIMER_SLACK_CLASS_BASE - class;
+}
+EXPORT_SYMBOL_GPL(set_timer_slack_class);
+
 static void internal_add_timer(struct tvec_base *base, struct timer_list *timer)
 {
 	unsigned long expires = timer->expires;
@@ -801,6 +816,14 @@ unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
 
 	if (timer->slack >= 0) {
 		expires_limit = expires + timer->slack;
+	} else if (timer->slack < -1) {
+		long delta = expires - jiffies;
+
+		if (delta <= 0)
+			return expires;
+
+		expires_limit = expires + timer_slack_class_delta(
+				TIMER_SLACK_CLASS_BASE - timer->slack, delta);
 	} else {
 		long delta = expires - jiffies;
 
@@ -1115,6 +1138,11 @@ static void call_timer_fn(struct timer_list *timer, void (*fn)(unsigned long),
 	 */
 	lock_map_acquire(&lockdep_map);
 
+	/* Delayed work is accounted to the work, not to the workqueue */
+	timer_wakeup_account(fn == delayed_work_timer_fn ?
+			     (void *)((struct delayed_work *)data)->work.func :
+			     (void *)fn);
+
 	trace_timer_expire_entry(timer);
 	fn(data);
 	trace_timer_expire_exit(timer);
@@ -1152,6 +1180,7 @@ static inline void __run_timers(struct tvec_base *base)
 		struct list_head work_list;
 		struct list_head *head = &work_list;
 		int index = base->timer_jiffies & TVR_MASK;
+		unsigned int count = 0;
 
 		/*
 		 * Cascade timers:
@@ -1179,7 +1208,11 @@ static inline void __run_timers(struct tvec_base *base)
 			spin_unlock_irq(&base->lock);
 			call_timer_fn(timer, fn, data);
 			spin_lock_irq(&base->lock);
+			count++;
 		}
+		/* The first timer of the jiffy is the one that was due */
+		if (count)
+			timer_coalesce_batch(false, 1, count - 1);
 	}
 	base->running_timer = NULL;
 	spin_unlock_irq(&base->lock);
@@ -1488,7 +1521,7 @@ static void process_timeout(unsigned long __data)
 signed long __sched schedule_timeout(signed long timeout)
 {
 	struct timer_list timer;
-	unsigned long expire;
+	unsigned long expire, slack;
 
 	switch (timeout)
 	{
@@ -1522,7 +1555,17 @@ signed long __sched schedule_timeout(signed long timeout)
 	expire = timeout + jiffies;
 
 	setup_timer_on_stack(&timer, process_timeout, (unsigned long)current);
-	__mod_timer(&timer, expire, false, TIMER_NOT_PINNED);
+
+	/*
+	 * A task with timer slack lets its sleeps coalesce with other
+	 * timers. The time left is still counted from the requested expiry.
+	 */
+	slack = rt_task(current) ? 0 : nsecs_to_jiffies(current->timer_slack_ns);
+	if (slack)
+		set_timer_slack(&timer, min_t(unsigned long, slack, INT_MAX));
+
+	__mod_timer(&timer, slack ? apply_slack(&timer, expire) : expire,
+		    false, TIMER_NOT_PINNED);
 	schedule();
 	del_singleshot_timer_sync(&timer);
 
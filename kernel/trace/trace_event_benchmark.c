@@ -0,0 +1,312 @@
+/*
+ * tracepoint cost benchmark
+ *
+ * Calls the tracepoints of the most used events in a loop and reports the
+ * cost of one call with whatever probes, enabled events and filters are
+ * set up at the time, on each cpu alone and on all online cpus at once.
+ *
+ * Writing a number of iterations to <debugfs>/tracing/event_benchmark runs
+ * the benchmark, reading the file gives the report of the last run, one
+ * line of key=value pairs per measurement. The "baseline" event is the
+ * cost of the loop itself.
+ */
+#include <linux/blkdev.h>
+#include <linux/completion.h>
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/debugfs.h>
+#include <linux/interrupt.h>
+#include <linux/kthread.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <trace/events/block.h>
+#include <trace/events/irq.h>
+#include <trace/events/power.h>
+#include <trace/events/sched.h>
+
+#include "trace.h"
+
+/* Tracepoints are called with interrupts off, this many at a time */
+#define BENCH_CHUNK		1000
+#define BENCH_DEFAULT_ITERATIONS 100000
+#define BENCH_REPORT_SIZE	(2 * PAGE_SIZE)
+
+static struct irqaction bench_action = {
+	.name = "event_benchmark",
+};
+
+static struct request_queue *bench_queue;
+static struct request *bench_rq;
+
+static void bench_baseline(void)
+{
+	barrier();
+}
+
+static void bench_sched_switch(void)
+{
+	trace_sched_switch(current, current);
+}
+
+static void bench_irq_handler_entry(void)
+{
+	trace_irq_handler_entry(0, &bench_action);
+}
+
+static void bench_cpu_idle(void)
+{
+	trace_cpu_idle(PWR_EVENT_EXIT, smp_processor_id());
+}
+
+static void bench_block_rq_issue(void)
+{
+	trace_block_rq_issue(bench_queue, bench_rq);
+}
+
+struct bench_event {
+	const char *name;
+	void (*call)(void);
+	struct tracepoint *tp;
+};
+
+static struct bench_event bench_events[] = {
+	{ "baseline", bench_baseline, NULL },
+	{ "sched_switch", bench_sched_switch, &__tracepoint_sched_switch },
+	{ "irq_handler_entry", bench_irq_handler_entry,
+	  &__tracepoint_irq_handler_entry },
+	{ "cpu_idle", bench_cpu_idle, &__tracepoint_cpu_idle },
+	{ "block_rq_issue", bench_block_rq_issue,
+	  &__tracepoint_block_rq_issue },
+};
+
+struct bench_work {
+	struct bench_event *event;
+	unsigned long iterations;
+	atomic_t *waiting;
+	struct completion done;
+	u64 ns;
+};
+
+static DEFINE_MUTEX(bench_mutex);
+static char *bench_report;
+static size_t bench_report_len;
+
+static int bench_thread(void *data)
+{
+	struct bench_work *work = data;
+	unsigned long left = work->iterations;
+	unsigned long n;
+	u64 start;
+
+	/* Start together with the threads on the other cpus */
+	atomic_dec(work->waiting);
+	while (atomic_read(work->waiting))
+		cpu_relax();
+
+	work->ns = 0;
+	while (left) {
+		n = min_t(unsigned long, left, BENCH_CHUNK);
+		left -= n;
+		local_irq_disable();
+		start = sched_clock();
+		while (n--)
+			work->event->call();
+		work->ns += sched_clock() - start;
+		local_irq_enable();
+		cond_resched();
+	}
+
+	complete(&work->done);
+	return 0;
+}
+
+static int bench_probes(struct tracepoint *tp)
+{
+	struct tracepoint_func *func;
+	int n = 0;
+
+	if (!tp)
+		return 0;
+
+	rcu_read_lock_sched();
+	func = rcu_dereference_sched(tp->funcs);
+	if (func)
+		for (; func->func; func++)
+			n++;
+	rcu_read_unlock_sched();
+
+	return n;
+}
+
+static unsigned long bench_event_flags(const char *name)
+{
+	struct ftrace_event_call *call;
+	unsigned long flags = 0;
+
+	mutex_lock(&event_mutex);
+	list_for_each_entry(call, &ftrace_events, list) {
+		if (call->name && !strcmp(call->name, name)) {
+			flags = call->flags;
+			break;
+		}
+	}
+	mutex_unlock(&event_mutex);
+
+	return flags;
+}
+
+/* Runs @event on the cpus of @mask at once and reports each cpu */
+static int bench_run(struct bench_event *event, const struct cpumask *mask,
+		     unsigned long iterations)
+{
+	struct bench_work *work;
+	struct task_struct **threads;
+	unsigned long flags = bench_event_flags(event->name);
+	atomic_t waiting;
+	int cpus = cpumask_weight(mask);
+	int probes = bench_probes(event->tp);
+	int ret = 0;
+	int cpu;
+
+	work = kcalloc(nr_cpu_ids, sizeof(*work), GFP_KERNEL);
+	threads = kcalloc(nr_cpu_ids, sizeof(*threads), GFP_KERNEL);
+	if (!work || !threads) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	/* Create all threads first, none may wait for one that never comes */
+	atomic_set(&waiting, cpus);
+	for_each_cpu(cpu, mask) {
+		work[cpu].event = event;
+		work[cpu].iterations = iterations;
+		work[cpu].waiting = &waiting;
+		init_completion(&work[cpu].done);
+		threads[cpu] = kthread_create(bench_thread, &work[cpu],
+					      "event_bench/%d", cpu);
+		if (IS_ERR(threads[cpu])) {
+			ret = PTR_ERR(threads[cpu]);
+			threads[cpu] = NULL;
+			for_each_cpu(cpu, mask)
+				if (threads[cpu])
+					kthread_stop(threads[cpu]);
+			goto out;
+		}
+		kthread_bind(threads[cpu], cpu);
+	}
+
+	for_each_cpu(cpu, mask)
+		wake_up_process(threads[cpu]);
+
+	for_each_cpu(cpu, mask) {
+		wait_for_completion(&work[cpu].done);
+		bench_report_len += scnprintf(bench_report + bench_report_len,
+			BENCH_REPORT_SIZE - bench_report_len,
+			"event=%s cpus=%d cpu=%d khz=%u probes=%d enabled=%d "
+			"filtered=%d iterations=%lu ns_per_event=%llu\n",
+			event->name, cpus, cpu, cpufreq_quick_get(cpu), probes,
+			!!(flags & TRACE_EVENT_FL_ENABLED),
+			!!(flags & TRACE_EVENT_FL_FILTERED), iterations,
+			div_u64(work[cpu].ns, iterations));
+	}
+
+out:
+	kfree(threads);
+	kfree(work);
+	return ret;
+}
+
+static int bench_run_all(unsigned long iterations)
+{
+	int ret = 0;
+	int cpu;
+	int i;
+
+	bench_report_len = 0;
+
+	get_online_cpus();
+	for (i = 0; i < ARRAY_SIZE(bench_events) && !ret; i++) {
+		for_each_online_cpu(cpu) {
+			ret = bench_run(&bench_events[i], cpumask_of(cpu),
+					iterations);
+			if (ret)
+				break;
+		}
+		if (!ret && num_online_cpus() > 1)
+			ret = bench_run(&bench_events[i], cpu_online_mask,
+					iterations);
+	}
+	put_online_cpus();
+
+	return ret;
+}
+
+static ssize_t bench_read(struct file *filp, char __user *ubuf,
+			  size_t cnt, loff_t *ppos)
+{
+	ssize_t ret;
+
+	mutex_lock(&bench_mutex);
+	ret = simple_read_from_buffer(ubuf, cnt, ppos, bench_report,
+				      bench_report_len);
+	mutex_unlock(&bench_mutex);
+
+	return ret;
+}
+
+static ssize_t bench_write(struct file *filp, const char __user *ubuf,
+			   size_t cnt, loff_t *ppos)
+{
+	unsigned long iterations;
+	int ret;
+
+	ret = kstrtoul_from_user(ubuf, cnt, 0, &iterations);
+	if (ret)
+		return ret;
+	if (!iterations)
+		iterations = BENCH_DEFAULT_ITERATIONS;
+
+	mutex_lock(&bench_mutex);
+	ret = bench_run_all(iterations);
+	mutex_unlock(&bench_mutex);
+
+	return ret ? ret : cnt;
+}
+
+static const struct file_operations bench_fops = {
+	.open		= tracing_open_generic,
+	.read		= bench_read,
+	.write		= bench_write,
+	.llseek		= default_llseek,
+};
+
+static __init int trace_event_benchmark_init(void)
+{
+	struct dentry *d_tracer;
+
+	bench_report = kzalloc(BENCH_REPORT_SIZE, GFP_KERNEL);
+	bench_queue = kzalloc(sizeof(*bench_queue), GFP_KERNEL);
+	bench_rq = kzalloc(sizeof(*bench_rq), GFP_KERNEL);
+	if (!bench_report || !bench_queue || !bench_rq) {
+		kfree(bench_rq);
+		kfree(bench_queue);
+		kfree(bench_report);
+		return -ENOMEM;
+	}
+
+	/* A file system read of one page, on no disk */
+	INIT_LIST_HEAD(&bench_rq->queuelist);
+	bench_rq->q = bench_queue;
+	bench_rq->cmd_type = REQ_TYPE_FS;
+	bench_rq->__data_len = PAGE_SIZE;
+
+	d_tracer = tracing_init_dentry();
+	if (!d_tracer)
+		return 0;
+
+	trace_create_file("event_benchmark", 0600, d_tracer, NULL,
+			  &bench_fops);
+
+	return 0;
+}
+fs_initcall(trace_event_benchmark_init);
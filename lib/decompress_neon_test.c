@@ -0,0 +1,165 @@
+/*
+ * Self test of the NEON LZO and LZ4 decompressors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/lz4.h>
+#include <linux/lzo.h>
+#include <asm/neon.h>
+
+#define TEST_MAX_LEN	(4 * PAGE_SIZE)
+
+static const size_t test_lens[] __initconst = {
+	16, 100, PAGE_SIZE, PAGE_SIZE + 37, TEST_MAX_LEN,
+};
+
+/*
+ * Literal runs and matches of every short offset, as the copies of short
+ * offsets overlap and take their own paths, plus long matches.
+ */
+static void __init fill_pattern(u8 *buf, size_t len)
+{
+	u32 seed = 0x12345678;
+	size_t i = 0;
+	size_t run;
+	size_t dist;
+
+	while (i < len) {
+		seed = seed * 1103515245 + 12345;
+		run = (seed >> 16) % 64 + 1;
+		dist = (seed >> 8) % 24 + 1;
+
+		if (i < dist || (seed & 3) == 0) {
+			for (; run > 0 && i < len; run--, i++) {
+				seed = seed * 1103515245 + 12345;
+				buf[i] = seed >> 24;
+			}
+		} else {
+			if ((seed & 0xf0) == 0)
+				run *= 16;
+			for (; run > 0 && i < len; run--, i++)
+				buf[i] = buf[i - dist];
+		}
+	}
+}
+
+static int __init test_lz4(const u8 *src, size_t len, u8 *cbuf, u8 *dbuf,
+			   void *wrkmem)
+{
+	size_t clen;
+	size_t slen;
+	size_t dlen;
+	int ret;
+
+	ret = lz4_compress(src, len, cbuf, &clen, wrkmem);
+	if (ret)
+		return ret;
+
+	memset(dbuf, 0, len);
+	kernel_neon_begin();
+	ret = lz4_decompress_neon(cbuf, &slen, dbuf, len);
+	kernel_neon_end();
+	if (ret || slen != clen || memcmp(src, dbuf, len))
+		return -EINVAL;
+
+	memset(dbuf, 0, len);
+	dlen = TEST_MAX_LEN;
+	kernel_neon_begin();
+	ret = lz4_decompress_unknownoutputsize_neon(cbuf, clen, dbuf, &dlen);
+	kernel_neon_end();
+	if (ret || dlen != len || memcmp(src, dbuf, len))
+		return -EINVAL;
+
+	return 0;
+}
+
+static int __init test_lzo(const u8 *src, size_t len, u8 *cbuf, u8 *dbuf,
+			   void *wrkmem)
+{
+	size_t clen;
+	size_t dlen;
+	int ret;
+
+	ret = lzo1x_1_compress(src, len, cbuf, &clen, wrkmem);
+	if (ret != LZO_E_OK)
+		return ret;
+
+	memset(dbuf, 0, len);
+	dlen = TEST_MAX_LEN;
+	kernel_neon_begin();
+	ret = lzo1x_decompress_safe_neon(cbuf, clen, dbuf, &dlen);
+	kernel_neon_end();
+	if (ret != LZO_E_OK || dlen != len || memcmp(src, dbuf, len))
+		return -EINVAL;
+
+	return 0;
+}
+
+static int __init test_decompress_neon(void)
+{
+	size_t cbuf_len = max_t(size_t, lz4_compressbound(TEST_MAX_LEN),
+				lzo1x_worst_compress(TEST_MAX_LEN));
+	size_t wrkmem_len = max_t(size_t, LZ4_MEM_COMPRESS,
+				  LZO1X_1_MEM_COMPRESS);
+	u8 *src, *cbuf, *dbuf;
+	void *wrkmem;
+	int failed = 0;
+	int i;
+
+	if (!cpu_has_neon()) {
+		pr_info("decompress neon test skipped, no NEON\n");
+		return 0;
+	}
+
+	src = vmalloc(TEST_MAX_LEN);
+	cbuf = vmalloc(cbuf_len);
+	dbuf = vmalloc(TEST_MAX_LEN);
+	wrkmem = vmalloc(wrkmem_len);
+	if (!src || !cbuf || !dbuf || !wrkmem) {
+		failed = -ENOMEM;
+		goto out;
+	}
+
+	fill_pattern(src, TEST_MAX_LEN);
+
+	for (i = 0; i < ARRAY_SIZE(test_lens); i++) {
+		if (test_lz4(src, test_lens[i], cbuf, dbuf, wrkmem)) {
+			pr_err("decompress neon test: lz4 failed for %zu bytes\n",
+			       test_lens[i]);
+			failed = -EINVAL;
+		}
+		if (test_lzo(src, test_lens[i], cbuf, dbuf, wrkmem)) {
+			pr_err("decompress neon test: lzo failed for %zu bytes\n",
+			       test_lens[i]);
+			failed = -EINVAL;
+		}
+	}
+
+	if (!failed)
+		pr_info("decompress neon test passed\n");
+
+out:
+	vfree(wrkmem);
+	vfree(dbuf);
+	vfree(cbuf);
+	vfree(src);
+
+	return failed;
+}
+
+static void __exit test_decompress_neon_exit(void)
+{
+}
+
+module_init(test_decompress_neon);
+module_exit(test_decompress_neon_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Self test of the NEON LZO and LZ4 decompressors");
@@ -47,8 +47,24 @@
 
 #include "lz4defs.h"
 
+/*
+ * The NEON flavour saves the NEON state of the task when it starts, and
+ * NEON can't be used in interrupt context.
+ */
+#if defined(CONFIG_LZ4_DECOMPRESS_NEON) && !defined(STATIC) && \
+	!defined(LZ4_NEON)
+#define LZ4_USE_NEON
+#include <linux/hardirq.h>
+#include <asm/neon.h>
+
+static inline bool lz4_neon_usable(void)
+{
+	return cpu_has_neon() && !in_interrupt();
+}
+#endif
+
 static const int dec32table[] = {0, 3, 2, 3, 0, 0, 0, 0};
-#if LZ4_ARCH64
+#if LZ4_ARCH64 || defined(LZ4_NEON)
 static const int dec64table[] = {0, 0, 0, -1, 0, 1, 2, 3};
 #endif
 
@@ -116,7 +132,7 @@ static int lz4_uncompress(const char *source, char *dest, int osize)
 
 		/* copy repeated sequence */
 		if (unlikely((op - ref) < STEPSIZE)) {
-#if LZ4_ARCH64
+#if LZ4_ARCH64 || defined(LZ4_NEON)
 			int dec64 = dec64table[op - ref];
 #else
 			const int dec64 = 0;
@@ -244,7 +260,7 @@ static int lz4_uncompress_unknownoutputsize(const char *source, char *dest,
 
 		/* copy repeated sequence */
 		if (unlikely((op - ref) < STEPSIZE)) {
-#if LZ4_ARCH64
+#if LZ4_ARCH64 || defined(LZ4_NEON)
 			int dec64 = dec64table[op - ref];
 #else
 			const int dec64 = 0;
@@ -296,6 +312,15 @@ int lz4_decompress(const unsigned char *src, size_t *src_len,
 	int ret = -1;
 	int input_len = 0;
 
+#ifdef LZ4_USE_NEON
+	if (lz4_neon_usable()) {
+		kernel_neon_begin();
+		ret = lz4_decompress_neon(src, src_len, dest, actual_dest_len);
+		kernel_neon_end();
+		return ret;
+	}
+#endif
+
 	input_len = lz4_uncompress(src, dest, actual_dest_len);
 	if (input_len < 0)
 		goto exit_0;
@@ -315,6 +340,16 @@ int lz4_decompress_unknownoutputsize(const unsigned char *src, size_t src_len,
 	int ret = -1;
 	int out_len = 0;
 
+#ifdef LZ4_USE_NEON
+	if (lz4_neon_usable()) {
+		kernel_neon_begin();
+		ret = lz4_decompress_unknownoutputsize_neon(src, src_len,
+					dest, dest_len);
+		kernel_neon_end();
+		return ret;
+	}
+#endif
+
 	out_len = lz4_uncompress_unknownoutputsize(src, dest, src_len,
 					*dest_len);
 	if (out_len < 0)
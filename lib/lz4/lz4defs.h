@@ -141,6 +141,41 @@ typedef struct _U64_S { u64 v; } U64_S;
 
 #endif
 
+#ifdef LZ4_NEON
+/*
+ * The NEON flavour of the decompressor, built by arch/arm/lib/lz4-neon.c,
+ * copies 8 bytes per step with one unaligned NEON load and store, the way
+ * 64-bit architectures do.
+ */
+#undef STEPSIZE
+#define STEPSIZE 8
+
+#undef PUT8
+#define PUT8(s, d)						\
+	asm volatile("vld1.8	{d0}, [%0]\n\t"			\
+		     "vst1.8	{d0}, [%1]"				\
+		     : : "r" (s), "r" (d) : "d0", "memory")
+
+#undef LZ4_COPYSTEP
+#define LZ4_COPYSTEP(s, d)	\
+	do {			\
+		PUT8(s, d);	\
+		d += 8;		\
+		s += 8;		\
+	} while (0)
+
+#undef LZ4_COPYPACKET
+#define LZ4_COPYPACKET(s, d)	LZ4_COPYSTEP(s, d)
+
+#undef LZ4_SECURECOPY
+#define LZ4_SECURECOPY(s, d, e)			\
+	do {					\
+		if (d < e) {			\
+			LZ4_WILDCOPY(s, d, e);	\
+		}				\
+	} while (0)
+#endif
+
 #define LZ4_READ_LITTLEENDIAN_16(d, s, p) \
 	(d = s - get_unaligned_le16(p))
 
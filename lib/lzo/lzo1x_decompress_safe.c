@@ -19,6 +19,17 @@
 #include <linux/lzo.h>
 #include "lzodefs.h"
 
+/*
+ * The NEON flavour saves the NEON state of the task when it starts, and
+ * NEON can't be used in interrupt context.
+ */
+#if defined(CONFIG_LZO_DECOMPRESS_NEON) && !defined(STATIC) && \
+	!defined(LZO_NEON)
+#define LZO_USE_NEON
+#include <linux/hardirq.h>
+#include <asm/neon.h>
+#endif
+
 #define HAVE_IP(x)      ((size_t)(ip_end - ip) >= (size_t)(x))
 #define HAVE_OP(x)      ((size_t)(op_end - op) >= (size_t)(x))
 #define NEED_IP(x)      if (!HAVE_IP(x)) goto input_overrun
@@ -35,8 +46,13 @@
  */
 #define MAX_255_COUNT      ((((size_t)~0) / 255) - 2)
 
+#ifdef LZO_USE_NEON
+static int lzo1x_decompress_safe_c(const unsigned char *in, size_t in_len,
+				   unsigned char *out, size_t *out_len)
+#else
 int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
 			  unsigned char *out, size_t *out_len)
+#endif
 {
 	unsigned char *op;
 	const unsigned char *ip;
@@ -89,7 +105,7 @@ copy_literal_run:
 						COPY8(op, ip);
 						op += 8;
 						ip += 8;
-#  if !defined(__arm__)
+#  if !defined(__arm__) || defined(LZO_NEON)
 						COPY8(op, ip);
 						op += 8;
 						ip += 8;
@@ -192,7 +208,7 @@ copy_literal_run:
 					COPY8(op, m_pos);
 					op += 8;
 					m_pos += 8;
-#  if !defined(__arm__)
+#  if !defined(__arm__) || defined(LZO_NEON)
 					COPY8(op, m_pos);
 					op += 8;
 					m_pos += 8;
@@ -263,6 +279,24 @@ lookbehind_overrun:
 	*out_len = op - out;
 	return LZO_E_LOOKBEHIND_OVERRUN;
 }
+
+#ifdef LZO_USE_NEON
+int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
+			  unsigned char *out, size_t *out_len)
+{
+	int ret;
+
+	if (!cpu_has_neon() || in_interrupt())
+		return lzo1x_decompress_safe_c(in, in_len, out, out_len);
+
+	kernel_neon_begin();
+	ret = lzo1x_decompress_safe_neon(in, in_len, out, out_len);
+	kernel_neon_end();
+
+	return ret;
+}
+#endif
+
 #ifndef STATIC
 EXPORT_SYMBOL_GPL(lzo1x_decompress_safe);
 
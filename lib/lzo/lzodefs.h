@@ -23,6 +23,12 @@
 #if defined(__x86_64__)
 #define COPY8(dst, src)	\
 		put_unaligned(get_unaligned((const u64 *)(src)), (u64 *)(dst))
+#elif defined(LZO_NEON)
+/* The NEON flavour, built by arch/arm/lib/lzo-neon.c */
+#define COPY8(dst, src)	\
+		asm volatile("vld1.8	{d0}, [%1]\n\t"		\
+			     "vst1.8	{d0}, [%0]"			\
+			     : : "r" (dst), "r" (src) : "d0", "memory")
 #else
 #define COPY8(dst, src)	\
 		COPY4(dst, src); COPY4((dst) + 4, (src) + 4)
@@ -225,6 +225,50 @@ static ssize_t max_ratio_store(struct device *dev,
 }
 BDI_SHOW(max_ratio, bdi->max_ratio)
 
+BDI_SHOW(wb_depth, bdi->wb_depth)
+
+static ssize_t ra_target_usec_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned int usec;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &usec);
+	if (ret < 0)
+		return ret;
+
+	bdi->ra_target_usec = usec;
+	if (!usec)
+		bdi->ra_scale = BDI_RA_SCALE_ONE;
+
+	return count;
+}
+BDI_SHOW(ra_target_usec, bdi->ra_target_usec)
+
+BDI_SHOW(ra_window_kb, K((bdi->ra_pages * bdi->ra_scale) >> BDI_RA_SCALE_SHIFT))
+
+static ssize_t mmap_ra_kb_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned long kb;
+	ssize_t ret;
+
+	ret = kstrtoul(buf, 10, &kb);
+	if (ret < 0)
+		return ret;
+
+	bdi->ra_mmap_pages = kb >> (PAGE_SHIFT - 10);
+
+	return count;
+}
+BDI_SHOW(mmap_ra_kb, K(bdi->ra_mmap_pages))
+
+BDI_SHOW(ra_pages_read, bdi_stat_sum(bdi, BDI_READAHEAD))
+BDI_SHOW(ra_hit, bdi_stat_sum(bdi, BDI_RA_HIT))
+BDI_SHOW(ra_waste, bdi_stat_sum(bdi, BDI_RA_WASTE))
+
 #ifndef __ATTR_RW
 #define __ATTR_RW(attr) __ATTR(attr, 0644, attr##_show, attr##_store)
 #endif
@@ -233,6 +277,13 @@ static struct device_attribute bdi_dev_attrs[] = {
 	__ATTR_RW(read_ahead_kb),
 	__ATTR_RW(min_ratio),
 	__ATTR_RW(max_ratio),
+	__ATTR(wb_depth, 0444, wb_depth_show, NULL),
+	__ATTR_RW(ra_target_usec),
+	__ATTR(ra_window_kb, 0444, ra_window_kb_show, NULL),
+	__ATTR_RW(mmap_ra_kb),
+	__ATTR(ra_pages_read, 0444, ra_pages_read_show, NULL),
+	__ATTR(ra_hit, 0444, ra_hit_show, NULL),
+	__ATTR(ra_waste, 0444, ra_waste_show, NULL),
 	__ATTR_NULL,
 };
 
@@ -681,6 +732,8 @@ int bdi_init(struct backing_dev_info *bdi)
 	bdi->min_ratio = 0;
 	bdi->max_ratio = 100;
 	bdi->max_prop_frac = PROP_FRAC_BASE;
+	bdi->ra_target_usec = BDI_RA_TARGET_USEC;
+	bdi->ra_scale = BDI_RA_SCALE_ONE;
 	spin_lock_init(&bdi->wb_lock);
 	INIT_LIST_HEAD(&bdi->bdi_list);
 	INIT_LIST_HEAD(&bdi->work_list);
@@ -0,0 +1,508 @@
+/*
+ * mm/boot_prefetch.c
+ *
+ * Record the file pages a boot uses, prefetch them on the next boot.
+ *
+ * For record_secs after boot, the page cache misses of regular files and
+ * the first use of their readahead pages are recorded, merged into
+ * extents per file. /proc/boot_prefetch/trace returns them, one line per
+ * file in the order the files were first used:
+ *
+ *	<start>+<pages>,<start>+<pages>,... <path>
+ *
+ * Init saves the trace once the boot is done, and on the next boot
+ * writes it to /proc/boot_prefetch/replay as soon as the filesystems are
+ * mounted. A kthread then reads ahead every extent, each file with its
+ * extents sorted by offset. The prefetched pages that get used are
+ * recorded again on that boot, so the trace follows what the boot needs.
+ * Writing anything to /proc/boot_prefetch/trace drops the recording.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/hash.h>
+#include <linux/sort.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/kthread.h>
+#include <linux/proc_fs.h>
+#include <linux/boot_prefetch.h>
+#include <linux/uaccess.h>
+
+#define BP_MAX_FILES		2048
+#define BP_MAX_EXTENTS		16384
+#define BP_HASH_BITS		8
+#define BP_REPLAY_MAX		(1 << 20)
+#define BP_NO_EXTENT		UINT_MAX
+
+struct bp_file {
+	struct hlist_node hash;
+	struct super_block *sb;
+	unsigned long ino;
+	char *path;
+	unsigned int last;	/* last extent recorded for the file */
+};
+
+struct bp_extent {
+	unsigned int file;
+	pgoff_t start;
+	unsigned long len;
+};
+
+static unsigned int record_secs = 60;
+module_param(record_secs, uint, 0444);
+MODULE_PARM_DESC(record_secs, "Seconds after boot during which file reads are recorded");
+
+static unsigned int dropped;
+module_param(dropped, uint, 0444);
+MODULE_PARM_DESC(dropped, "Pages not recorded, the trace was full");
+
+static unsigned long replayed;
+module_param(replayed, ulong, 0444);
+MODULE_PARM_DESC(replayed, "Pages read ahead by the last replay");
+
+bool boot_prefetch_recording;
+static unsigned long record_end;
+
+/* record_lock protects the recording, trace_mutex keeps it allocated */
+static DEFINE_SPINLOCK(record_lock);
+static DEFINE_MUTEX(trace_mutex);
+static struct bp_file *files;
+static struct bp_extent *extents;
+static unsigned int nr_files, nr_extents;
+static struct hlist_head file_hash[1 << BP_HASH_BITS];
+
+static unsigned long replay_running;
+
+static struct hlist_head *bp_hash(struct super_block *sb, unsigned long ino)
+{
+	return &file_hash[hash_long(ino ^ (unsigned long)sb, BP_HASH_BITS)];
+}
+
+static struct bp_file *bp_find_file(struct super_block *sb, unsigned long ino)
+{
+	struct bp_file *f;
+	struct hlist_node *node;
+
+	hlist_for_each_entry(f, node, bp_hash(sb, ino), hash)
+		if (f->sb == sb && f->ino == ino)
+			return f;
+
+	return NULL;
+}
+
+static char *bp_file_path(struct file *filp)
+{
+	char *buf, *p, *path = NULL;
+
+	buf = (char *)__get_free_page(GFP_NOFS);
+	if (!buf)
+		return NULL;
+
+	p = d_path(&filp->f_path, buf, PAGE_SIZE);
+	/* The trace has one path per line */
+	if (!IS_ERR(p) && !strchr(p, '\n'))
+		path = kstrdup(p, GFP_NOFS);
+
+	free_page((unsigned long)buf);
+	return path;
+}
+
+static void bp_add_extent(struct bp_file *f, pgoff_t offset, unsigned long nr)
+{
+	struct bp_extent *e;
+
+	/* Reads of a file mostly go on where the previous one ended */
+	if (f->last != BP_NO_EXTENT) {
+		e = &extents[f->last];
+		if (offset >= e->start && offset <= e->start + e->len) {
+			if (offset + nr > e->start + e->len)
+				e->len = offset + nr - e->start;
+			return;
+		}
+	}
+
+	if (nr_extents == BP_MAX_EXTENTS) {
+		dropped += nr;
+		return;
+	}
+
+	e = &extents[nr_extents];
+	e->file = f - files;
+	e->start = offset;
+	e->len = nr;
+	f->last = nr_extents++;
+}
+
+/**
+ * __boot_prefetch_record - record a read of file pages
+ * @filp: the file read, or NULL
+ * @offset: first page read
+ * @nr: number of pages read
+ *
+ * Called through boot_prefetch_record() while recording.
+ */
+void __boot_prefetch_record(struct file *filp, pgoff_t offset,
+			    unsigned long nr)
+{
+	struct inode *inode;
+	struct bp_file *f;
+	char *path = NULL;
+
+	if (!filp || !nr)
+		return;
+
+	if (time_after(jiffies, record_end)) {
+		boot_prefetch_recording = false;
+		return;
+	}
+
+	inode = filp->f_mapping->host;
+	if (!S_ISREG(inode->i_mode))
+		return;
+
+	spin_lock(&record_lock);
+	if (!files)
+		goto out;
+
+	f = bp_find_file(inode->i_sb, inode->i_ino);
+	if (!f) {
+		spin_unlock(&record_lock);
+		path = bp_file_path(filp);
+		if (!path)
+			return;
+		spin_lock(&record_lock);
+		if (!files)
+			goto out;
+
+		f = bp_find_file(inode->i_sb, inode->i_ino);
+	}
+
+	if (!f) {
+		if (nr_files == BP_MAX_FILES) {
+			dropped += nr;
+			goto out;
+		}
+		f = &files[nr_files++];
+		f->sb = inode->i_sb;
+		f->ino = inode->i_ino;
+		f->path = path;
+		f->last = BP_NO_EXTENT;
+		hlist_add_head(&f->hash, bp_hash(f->sb, f->ino));
+		path = NULL;
+	}
+
+	bp_add_extent(f, offset, nr);
+out:
+	spin_unlock(&record_lock);
+	kfree(path);
+}
+
+/* Called with trace_mutex held */
+static void bp_free_recording(void)
+{
+	struct bp_file *old_files;
+	struct bp_extent *old_extents;
+	unsigned int i, old_nr_files;
+
+	boot_prefetch_recording = false;
+
+	spin_lock(&record_lock);
+	old_files = files;
+	old_extents = extents;
+	old_nr_files = nr_files;
+	files = NULL;
+	extents = NULL;
+	nr_files = 0;
+	nr_extents = 0;
+	for (i = 0; i < ARRAY_SIZE(file_hash); i++)
+		INIT_HLIST_HEAD(&file_hash[i]);
+	spin_unlock(&record_lock);
+
+	for (i = 0; i < old_nr_files; i++)
+		kfree(old_files[i].path);
+	vfree(old_files);
+	vfree(old_extents);
+}
+
+static int bp_extent_cmp(const void *a, const void *b)
+{
+	const struct bp_extent *ea = a, *eb = b;
+
+	if (ea->file != eb->file)
+		return ea->file < eb->file ? -1 : 1;
+	if (ea->start != eb->start)
+		return ea->start < eb->start ? -1 : 1;
+	return 0;
+}
+
+struct bp_snapshot {
+	size_t len;
+	char data[0];
+};
+
+/* Called with trace_mutex held, the paths do not change under it */
+static struct bp_snapshot *bp_build_trace(void)
+{
+	struct bp_snapshot *snap;
+	struct bp_extent *sorted, *e;
+	unsigned int i, n, nf;
+	size_t size = 0, len = 0;
+	pgoff_t end;
+
+	sorted = vmalloc(BP_MAX_EXTENTS * sizeof(*sorted));
+	if (!sorted)
+		return NULL;
+
+	spin_lock(&record_lock);
+	n = nr_extents;
+	nf = nr_files;
+	if (extents)
+		memcpy(sorted, extents, n * sizeof(*sorted));
+	spin_unlock(&record_lock);
+
+	sort(sorted, n, sizeof(*sorted), bp_extent_cmp, NULL);
+
+	/* "start+len," of two 10 digit numbers, the path and its space */
+	for (i = 0; i < nf; i++)
+		size += strlen(files[i].path) + 2;
+	size += n * 22;
+
+	snap = vmalloc(sizeof(*snap) + size + 1);
+	if (!snap)
+		goto out;
+
+	i = 0;
+	while (i < n) {
+		unsigned int file = sorted[i].file;
+		bool first = true;
+
+		while (i < n && sorted[i].file == file) {
+			e = &sorted[i++];
+			end = e->start + e->len;
+			/* Merge the overlapping and adjacent extents */
+			while (i < n && sorted[i].file == file &&
+			       sorted[i].start <= end) {
+				end = max_t(pgoff_t, end,
+					    sorted[i].start + sorted[i].len);
+				i++;
+			}
+			len += scnprintf(snap->data + len, size + 1 - len,
+					 "%s%lu+%lu", first ? "" : ",",
+					 (unsigned long)e->start,
+					 (unsigned long)(end - e->start));
+			first = false;
+		}
+		len += scnprintf(snap->data + len, size + 1 - len, " %s\n",
+				 files[file].path);
+	}
+	snap->len = len;
+out:
+	vfree(sorted);
+	return snap;
+}
+
+static int bp_trace_open(struct inode *inode, struct file *file)
+{
+	struct bp_snapshot *snap = NULL;
+
+	if (!(file->f_mode & FMODE_READ))
+		return 0;
+
+	mutex_lock(&trace_mutex);
+	if (files) {
+		snap = bp_build_trace();
+		if (!snap) {
+			mutex_unlock(&trace_mutex);
+			return -ENOMEM;
+		}
+	}
+	mutex_unlock(&trace_mutex);
+
+	file->private_data = snap;
+	return 0;
+}
+
+static ssize_t bp_trace_read(struct file *file, char __user *buf,
+			     size_t len, loff_t *ppos)
+{
+	struct bp_snapshot *snap = file->private_data;
+
+	if (!snap)
+		return 0;
+
+	return simple_read_from_buffer(buf, len, ppos, snap->data, snap->len);
+}
+
+static ssize_t bp_trace_write(struct file *file, const char __user *buf,
+			      size_t len, loff_t *ppos)
+{
+	mutex_lock(&trace_mutex);
+	bp_free_recording();
+	mutex_unlock(&trace_mutex);
+
+	return len;
+}
+
+static int bp_trace_release(struct inode *inode, struct file *file)
+{
+	vfree(file->private_data);
+	return 0;
+}
+
+static const struct file_operations bp_trace_fops = {
+	.open		= bp_trace_open,
+	.read		= bp_trace_read,
+	.write		= bp_trace_write,
+	.llseek		= default_llseek,
+	.release	= bp_trace_release,
+};
+
+static void bp_replay_file(char *line)
+{
+	struct file *filp;
+	unsigned long start, len;
+	char *path, *ext, *next;
+	int ret;
+
+	path = strchr(line, ' ');
+	if (!path)
+		return;
+	*path++ = '\0';
+
+	filp = filp_open(path, O_RDONLY | O_LARGEFILE, 0);
+	if (IS_ERR(filp))
+		return;
+
+	for (ext = line; ext; ext = next) {
+		next = strchr(ext, ',');
+		if (next)
+			*next++ = '\0';
+
+		if (sscanf(ext, "%lu+%lu", &start, &len) != 2)
+			continue;
+
+		ret = force_page_cache_readahead(filp->f_mapping, filp,
+						 start, len);
+		if (ret > 0)
+			replayed += ret;
+	}
+
+	filp_close(filp, NULL);
+}
+
+struct bp_replay_buf {
+	size_t len;
+	char data[0];
+};
+
+static int bp_replay_fn(void *data)
+{
+	struct bp_replay_buf *rb = data;
+	char *line, *next;
+
+	replayed = 0;
+	for (line = rb->data; line && *line; line = next) {
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+		bp_replay_file(line);
+	}
+
+	vfree(rb);
+	clear_bit(0, &replay_running);
+	return 0;
+}
+
+static int bp_replay_open(struct inode *inode, struct file *file)
+{
+	struct bp_replay_buf *rb;
+
+	rb = vmalloc(sizeof(*rb) + BP_REPLAY_MAX + 1);
+	if (!rb)
+		return -ENOMEM;
+
+	rb->len = 0;
+	file->private_data = rb;
+	return 0;
+}
+
+static ssize_t bp_replay_write(struct file *file, const char __user *buf,
+			       size_t len, loff_t *ppos)
+{
+	struct bp_replay_buf *rb = file->private_data;
+
+	if (len > BP_REPLAY_MAX - rb->len)
+		return -EFBIG;
+	if (copy_from_user(rb->data + rb->len, buf, len))
+		return -EFAULT;
+
+	rb->len += len;
+	return len;
+}
+
+/* The replay starts once the whole trace is written */
+static int bp_replay_release(struct inode *inode, struct file *file)
+{
+	struct bp_replay_buf *rb = file->private_data;
+	struct task_struct *task;
+
+	/* One replay at a time */
+	if (!rb->len || test_and_set_bit(0, &replay_running)) {
+		vfree(rb);
+		return 0;
+	}
+
+	/* The kthread owns the buffer from here */
+	rb->data[rb->len] = '\0';
+	task = kthread_run(bp_replay_fn, rb, "bprefetch");
+	if (IS_ERR(task)) {
+		vfree(rb);
+		clear_bit(0, &replay_running);
+	}
+
+	return 0;
+}
+
+static const struct file_operations bp_replay_fops = {
+	.open		= bp_replay_open,
+	.write		= bp_replay_write,
+	.llseek		= noop_llseek,
+	.release	= bp_replay_release,
+};
+
+static int __init boot_prefetch_init(void)
+{
+	struct proc_dir_entry *dir;
+
+	dir = proc_mkdir("boot_prefetch", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	proc_create("trace", S_IRUSR | S_IWUSR, dir, &bp_trace_fops);
+	proc_create("replay", S_IWUSR, dir, &bp_replay_fops);
+
+	if (!record_secs)
+		return 0;
+
+	files = vzalloc(BP_MAX_FILES * sizeof(*files));
+	extents = vmalloc(BP_MAX_EXTENTS * sizeof(*extents));
+	if (!files || !extents) {
+		vfree(files);
+		vfree(extents);
+		files = NULL;
+		extents = NULL;
+		return -ENOMEM;
+	}
+
+	record_end = jiffies + record_secs * HZ;
+	boot_prefetch_recording = true;
+	return 0;
+}
+fs_initcall(boot_prefetch_init);
@@ -14,6 +14,10 @@
 #include <linux/backing-dev.h>
 #include <linux/sysctl.h>
 #include <linux/sysfs.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
+#include <linux/earlysuspend.h>
+#include <linux/vmpressure.h>
 #include "internal.h"
 
 #ifdef CONFIG_COMPACTION
@@ -1194,4 +1198,134 @@ void compaction_unregister_node(struct node *node)
 }
 #endif /* CONFIG_SYSFS && CONFIG_NUMA */
 
+#ifdef CONFIG_COMPACTION_BACKGROUND
+/*
+ * kcompactd compacts for the highest order of the allocations that went
+ * into the slow path since its last pass. While the screen is off it also
+ * compacts for PAGE_ALLOC_COSTLY_ORDER every KCOMPACTD_INTERVAL, so the
+ * high order allocations of drivers find free blocks when the screen comes
+ * back on. It gives way to reclaim when the last memory pressure, within
+ * KCOMPACTD_INTERVAL, was at least KCOMPACTD_MAX_PRESSURE.
+ */
+#define KCOMPACTD_INTERVAL	(10 * HZ)
+#define KCOMPACTD_MAX_PRESSURE	60
+
+static atomic_t kcompactd_stalls[MAX_ORDER];
+static unsigned long kcompactd_pressure;
+static unsigned long kcompactd_pressure_time;
+static bool kcompactd_screen_on = true;
+static bool kcompactd_wake;
+static DECLARE_WAIT_QUEUE_HEAD(kcompactd_wait);
+
+void compaction_stall(int order)
+{
+	atomic_inc(&kcompactd_stalls[order]);
+	if (!kcompactd_wake && waitqueue_active(&kcompactd_wait)) {
+		kcompactd_wake = true;
+		wake_up_interruptible(&kcompactd_wait);
+	}
+}
+
+/* Highest order that stalled since the last pass, -1 if none */
+static int kcompactd_order(void)
+{
+	int target = -1;
+	int order;
+
+	for (order = MAX_ORDER - 1; order > 0; order--)
+		if (atomic_xchg(&kcompactd_stalls[order], 0) && target < 0)
+			target = order;
+
+	return target;
+}
+
+static bool kcompactd_pressure_high(void)
+{
+	return kcompactd_pressure >= KCOMPACTD_MAX_PRESSURE &&
+	       time_before(jiffies, kcompactd_pressure_time +
+			   KCOMPACTD_INTERVAL);
+}
+
+static int kcompactd(void *unused)
+{
+	long timeout;
+	int order;
+	int nid;
+
+	set_freezable();
+	set_user_nice(current, 5);
+
+	while (!kthread_should_stop()) {
+		timeout = kcompactd_screen_on ? MAX_SCHEDULE_TIMEOUT :
+						KCOMPACTD_INTERVAL;
+		wait_event_freezable_timeout(kcompactd_wait,
+				kcompactd_wake || kthread_should_stop(),
+				timeout);
+		kcompactd_wake = false;
+
+		order = kcompactd_order();
+		if (order < 0) {
+			if (kcompactd_screen_on)
+				continue;
+			order = PAGE_ALLOC_COSTLY_ORDER;
+		}
+		if (kcompactd_pressure_high())
+			continue;
+
+		for_each_online_node(nid)
+			compact_pgdat(NODE_DATA(nid), order);
+	}
+
+	return 0;
+}
+
+static int kcompactd_vmpressure(struct notifier_block *nb,
+				unsigned long pressure, void *data)
+{
+	kcompactd_pressure = pressure;
+	kcompactd_pressure_time = jiffies;
+	return NOTIFY_OK;
+}
+
+static struct notifier_block kcompactd_vmpressure_nb = {
+	.notifier_call = kcompactd_vmpressure,
+};
+
+#ifdef CONFIG_HAS_EARLYSUSPEND
+static void kcompactd_early_suspend(struct early_suspend *h)
+{
+	kcompactd_screen_on = false;
+	wake_up_interruptible(&kcompactd_wait);
+}
+
+static void kcompactd_late_resume(struct early_suspend *h)
+{
+	kcompactd_screen_on = true;
+}
+
+static struct early_suspend kcompactd_early_suspend_desc = {
+	.suspend = kcompactd_early_suspend,
+	.resume = kcompactd_late_resume,
+};
+#endif
+
+static int __init kcompactd_init(void)
+{
+	struct task_struct *task;
+
+	task = kthread_run(kcompactd, NULL, "kcompactd");
+	if (IS_ERR(task)) {
+		pr_err("kcompactd: creating kthread failed\n");
+		return PTR_ERR(task);
+	}
+
+	vmpressure_notifier_register(&kcompactd_vmpressure_nb);
+#ifdef CONFIG_HAS_EARLYSUSPEND
+	register_early_suspend(&kcompactd_early_suspend_desc);
+#endif
+	return 0;
+}
+module_init(kcompactd_init);
+#endif /* CONFIG_COMPACTION_BACKGROUND */
+
 #endif /* CONFIG_COMPACTION */
@@ -34,6 +34,7 @@
 #include <linux/hardirq.h> /* for BUG_ON(!in_atomic()) only */
 #include <linux/memcontrol.h>
 #include <linux/cleancache.h>
+#include <linux/boot_prefetch.h>
 #include "internal.h"
 
 /*
@@ -124,6 +125,10 @@ void __delete_from_page_cache(struct page *page)
 	else
 		cleancache_invalidate_page(mapping, page);
 
+	/* Read ahead and never used, PG_reclaim is clear past writeback */
+	if (PageReadahead(page) && !PageWriteback(page))
+		__inc_bdi_stat(mapping->backing_dev_info, BDI_RA_WASTE);
+
 	radix_tree_delete(&mapping->page_tree, page->index);
 	page->mapping = NULL;
 	/* Leave page->index set: truncation lookup relies upon it */
@@ -1565,6 +1570,8 @@ static void do_sync_mmap_readahead(struct vm_area_struct *vma,
 	unsigned long ra_pages;
 	struct address_space *mapping = file->f_mapping;
 
+	boot_prefetch_record(file, offset, 1);
+
 	/* If we don't want any read-ahead, don't bother */
 	if (VM_RandomReadHint(vma))
 		return;
@@ -1589,9 +1596,14 @@ static void do_sync_mmap_readahead(struct vm_area_struct *vma,
 		return;
 
 	/*
-	 * mmap read-around
+	 * mmap read-around. Read-only mappings, APKs, DEX and libraries,
+	 * are accessed all over the file and may use a smaller window.
 	 */
-	ra_pages = max_sane_readahead(ra->ra_pages);
+	ra_pages = ra_window(mapping, ra);
+	if (!(vma->vm_flags & VM_WRITE) &&
+	    mapping->backing_dev_info->ra_mmap_pages)
+		ra_pages = min(ra_pages, mapping->backing_dev_info->ra_mmap_pages);
+	ra_pages = max_sane_readahead(ra_pages);
 	ra->start = max_t(long, 0, offset - ra_pages / 2);
 	ra->size = ra_pages;
 	ra->async_size = ra_pages / 4;
@@ -89,6 +89,16 @@ static inline void get_page_foll(struct page *page)
 
 extern unsigned long highest_memmap_pfn;
 
+/*
+ * Watermark boost of a zone, zero once it expired
+ */
+static inline unsigned long zone_watermark_boost(struct zone *zone)
+{
+	if (time_after(jiffies, zone->watermark_boost_expires))
+		return 0;
+	return zone->watermark_boost;
+}
+
 /*
  * in mm/vmscan.c:
  */
@@ -192,6 +192,20 @@ static unsigned int ksm_thread_sleep_millisecs = 20;
 /* Boolean to indicate whether to use deferred timer or not */
 static bool use_deferred_timer = true;
 
+/*
+ * Adaptive scanning: ksmd only uses idle cpu time, and doubles its sleep
+ * after each batch that merges nothing, up to sleep_millisecs << this.
+ */
+#define KSM_MAX_SLEEP_SHIFT	6
+static bool ksm_adaptive;
+static unsigned int ksm_sleep_shift;
+
+/* Pages scanned and pages freed by merging, for the yield of the scan */
+static unsigned long ksm_pages_scanned;
+static unsigned long ksm_pages_merged;
+
+static struct task_struct *ksm_thread_task;
+
 #define KSM_RUN_STOP	0
 #define KSM_RUN_MERGE	1
 #define KSM_RUN_UNMERGE	2
@@ -1158,9 +1172,10 @@ static void stable_tree_append(struct rmap_item *rmap_item,
 	rmap_item->address |= STABLE_FLAG;
 	hlist_add_head(&rmap_item->hlist, &stable_node->hlist);
 
-	if (rmap_item->hlist.next)
+	if (rmap_item->hlist.next) {
 		ksm_pages_sharing++;
-	else
+		ksm_pages_merged++;
+	} else
 		ksm_pages_shared++;
 }
 
@@ -1447,6 +1462,7 @@ static void ksm_do_scan(unsigned int scan_npages)
 		rmap_item = scan_get_next_rmap_item(&page);
 		if (!rmap_item)
 			return;
+		ksm_pages_scanned++;
 		if (!PageKsm(page) || !in_stable_tree(rmap_item)) {
 			if (!is_page_scanned(page))
 				cmp_and_merge_page(page, rmap_item);
@@ -1497,24 +1513,36 @@ static int ksmd_should_run(void)
 
 static int ksm_scan_thread(void *nothing)
 {
+	unsigned long merged;
+	unsigned int msecs;
+
 	set_freezable();
 	set_user_nice(current, 5);
 
 	while (!kthread_should_stop()) {
 		mutex_lock(&ksm_thread_mutex);
-		if (ksmd_should_run())
+		if (ksmd_should_run()) {
+			merged = ksm_pages_merged;
 			ksm_do_scan(ksm_thread_pages_to_scan);
+			if (ksm_pages_merged != merged)
+				ksm_sleep_shift = 0;
+			else if (ksm_sleep_shift < KSM_MAX_SLEEP_SHIFT)
+				ksm_sleep_shift++;
+		}
 		mutex_unlock(&ksm_thread_mutex);
 
 		try_to_freeze();
 
 		if (ksmd_should_run()) {
+			msecs = ksm_thread_sleep_millisecs;
+			if (ksm_adaptive)
+				msecs <<= ksm_sleep_shift;
 			if (use_deferred_timer)
 				deferred_schedule_timeout(
-				msecs_to_jiffies(ksm_thread_sleep_millisecs));
+					msecs_to_jiffies(msecs));
 			else
 				schedule_timeout_interruptible(
-				msecs_to_jiffies(ksm_thread_sleep_millisecs));
+					msecs_to_jiffies(msecs));
 		} else {
 			wait_event_freezable(ksm_thread_wait,
 				ksmd_should_run() || kthread_should_stop());
@@ -1591,6 +1619,9 @@ int __ksm_enter(struct mm_struct *mm)
 	set_bit(MMF_VM_MERGEABLE, &mm->flags);
 	atomic_inc(&mm->mm_count);
 
+	/* A new process likely brings new pages to merge, scan at once */
+	ksm_sleep_shift = 0;
+
 	if (needs_wakeup)
 		wake_up_interruptible(&ksm_thread_wait);
 
@@ -2058,6 +2089,58 @@ static ssize_t full_scans_show(struct kobject *kobj,
 }
 KSM_ATTR_RO(full_scans);
 
+static ssize_t adaptive_show(struct kobject *kobj,
+			     struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%d\n", ksm_adaptive);
+}
+
+static ssize_t adaptive_store(struct kobject *kobj,
+			      struct kobj_attribute *attr,
+			      const char *buf, size_t count)
+{
+	struct sched_param param = { .sched_priority = 0 };
+	unsigned long enable;
+	int err;
+
+	err = kstrtoul(buf, 10, &enable);
+	if (err || enable > 1)
+		return -EINVAL;
+
+	mutex_lock(&ksm_thread_mutex);
+	ksm_adaptive = enable;
+	ksm_sleep_shift = 0;
+	sched_setscheduler(ksm_thread_task,
+			   enable ? SCHED_IDLE : SCHED_NORMAL, &param);
+	mutex_unlock(&ksm_thread_mutex);
+
+	return count;
+}
+KSM_ATTR(adaptive);
+
+static ssize_t pages_scanned_show(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", ksm_pages_scanned);
+}
+KSM_ATTR_RO(pages_scanned);
+
+static ssize_t pages_merged_show(struct kobject *kobj,
+				 struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", ksm_pages_merged);
+}
+KSM_ATTR_RO(pages_merged);
+
+static ssize_t cpu_msecs_show(struct kobject *kobj,
+			      struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%llu\n",
+		       div_u64(task_sched_runtime(ksm_thread_task),
+			       NSEC_PER_MSEC));
+}
+KSM_ATTR_RO(cpu_msecs);
+
 static struct attribute *ksm_attrs[] = {
 	&sleep_millisecs_attr.attr,
 	&pages_to_scan_attr.attr,
@@ -2068,6 +2151,10 @@ static struct attribute *ksm_attrs[] = {
 	&pages_volatile_attr.attr,
 	&full_scans_attr.attr,
 	&deferred_timer_attr.attr,
+	&adaptive_attr.attr,
+	&pages_scanned_attr.attr,
+	&pages_merged_attr.attr,
+	&cpu_msecs_attr.attr,
 	NULL,
 };
 
@@ -2092,6 +2179,7 @@ static int __init ksm_init(void)
 		err = PTR_ERR(ksm_thread);
 		goto out_free;
 	}
+	ksm_thread_task = ksm_thread;
 
 #ifdef CONFIG_SYSFS
 	err = sysfs_create_group(mm_kobj, &ksm_attr_group);
@@ -62,6 +62,7 @@ void compare_swap_oom_score_adj(int old_val, int new_val)
 		current->signal->oom_score_adj = new_val;
 	trace_oom_score_adj_update(current);
 	spin_unlock_irq(&sighand->siglock);
+	oom_adj_index_update(current);
 }
 
 /**
@@ -82,10 +83,64 @@ int test_set_oom_score_adj(int new_val)
 	current->signal->oom_score_adj = new_val;
 	trace_oom_score_adj_update(current);
 	spin_unlock_irq(&sighand->siglock);
+	oom_adj_index_update(current);
 
 	return old_val;
 }
 
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_ADJ_INDEX
+/* zero filled hlist heads are empty, usable before any initcall */
+struct hlist_head oom_adj_buckets[OOM_ADJ_BUCKETS];
+DEFINE_SPINLOCK(oom_adj_index_lock);
+
+static void __oom_adj_index_add(struct task_struct *p)
+{
+	hlist_add_head(&p->oom_adj_node,
+		       &oom_adj_buckets[oom_adj_bucket(p->signal->oom_score_adj)]);
+}
+
+/* new thread group leader, called from copy_process() */
+void oom_adj_index_add(struct task_struct *p)
+{
+	spin_lock(&oom_adj_index_lock);
+	__oom_adj_index_add(p);
+	spin_unlock(&oom_adj_index_lock);
+}
+
+/* called from release_task(), a no-op for non leaders */
+void oom_adj_index_del(struct task_struct *p)
+{
+	spin_lock(&oom_adj_index_lock);
+	hlist_del_init(&p->oom_adj_node);
+	spin_unlock(&oom_adj_index_lock);
+}
+
+/* rehash p's thread group after an oom_score_adj change */
+void oom_adj_index_update(struct task_struct *p)
+{
+	struct task_struct *leader;
+
+	spin_lock(&oom_adj_index_lock);
+	leader = p->group_leader;
+	if (!hlist_unhashed(&leader->oom_adj_node)) {
+		hlist_del(&leader->oom_adj_node);
+		__oom_adj_index_add(leader);
+	}
+	spin_unlock(&oom_adj_index_lock);
+}
+
+/* exec by a non leader thread, see de_thread() */
+void oom_adj_index_replace(struct task_struct *old, struct task_struct *new)
+{
+	spin_lock(&oom_adj_index_lock);
+	if (!hlist_unhashed(&old->oom_adj_node)) {
+		hlist_del_init(&old->oom_adj_node);
+		__oom_adj_index_add(new);
+	}
+	spin_unlock(&oom_adj_index_lock);
+}
+#endif
+
 #ifdef CONFIG_NUMA
 /**
  * has_intersects_mems_allowed() - check task eligiblity for kill
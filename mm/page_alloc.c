@@ -60,6 +60,7 @@
 #include <linux/mm_inline.h>
 #include <linux/migrate.h>
 #include <linux/page-debug-flags.h>
+#include <linux/pasr.h>
 
 #include <asm/tlbflush.h>
 #include <asm/div64.h>
@@ -208,6 +209,33 @@ int min_free_order_shift = 1;
  */
 int extra_free_kbytes = 0;
 
+/*
+ * Most pages the watermarks are boosted by after fragmenting fallbacks or
+ * allocation stalls, in 1/10000ths of the high watermark. The boost makes
+ * kswapd free memory ahead of the next burst of allocations.
+ */
+int watermark_boost_factor = 15000;
+
+/* A boost expires this long after the last event that raised it */
+#define WATERMARK_BOOST_EXPIRE	(2 * HZ)
+
+static void boost_watermark(struct zone *zone, enum vm_event_item event)
+{
+	unsigned long max_boost;
+	unsigned long boost;
+
+	if (!watermark_boost_factor)
+		return;
+
+	max_boost = mult_frac(high_wmark_pages(zone), watermark_boost_factor,
+			      10000);
+	boost = zone_watermark_boost(zone) + pageblock_nr_pages;
+	zone->watermark_boost = min(boost, max_boost);
+	zone->watermark_boost_expires = jiffies + WATERMARK_BOOST_EXPIRE;
+	zone_set_flag(zone, ZONE_BOOSTED_WATERMARK);
+	count_vm_event(event);
+}
+
 static unsigned long __meminitdata nr_kernel_pages;
 static unsigned long __meminitdata nr_all_pages;
 static unsigned long __meminitdata dma_reserve;
@@ -581,6 +609,7 @@ static inline void __free_one_page(struct page *page,
 		order++;
 	}
 	set_page_order(page, order);
+	pasr_kput(page, order);
 
 	/*
 	 * If this is not the largest possible page, check if the buddy
@@ -914,10 +943,14 @@ struct page *__rmqueue_smallest(struct zone *zone, unsigned int order,
 		if (list_empty(&area->free_list[migratetype]))
 			continue;
 
-		page = list_entry(area->free_list[migratetype].next,
+		if (current_order == MAX_ORDER - 1)
+			page = pasr_pick_block(&area->free_list[migratetype]);
+		else
+			page = list_entry(area->free_list[migratetype].next,
 							struct page, lru);
 		list_del(&page->lru);
 		rmv_page_order(page);
+		pasr_kget(page, current_order);
 		area->nr_free--;
 		expand(zone, page, order, current_order, area, migratetype);
 		return page;
@@ -1052,7 +1085,17 @@ __rmqueue_fallback(struct zone *zone, int order, int start_migratetype)
 			if (list_empty(&area->free_list[migratetype]))
 				continue;
 
-			page = list_entry(area->free_list[migratetype].next,
+			/* Mixing types in a pageblock fragments the zone */
+			if (current_order < pageblock_order &&
+			    !is_migrate_cma(migratetype))
+				boost_watermark(zone, WATERMARK_BOOST_FRAGMENT);
+
+			if (current_order == MAX_ORDER - 1)
+				page = pasr_pick_block(
+					&area->free_list[migratetype]);
+			else
+				page = list_entry(
+					area->free_list[migratetype].next,
 					struct page, lru);
 			area->nr_free--;
 
@@ -1088,6 +1131,7 @@ __rmqueue_fallback(struct zone *zone, int order, int start_migratetype)
 			/* Remove the page from the freelists */
 			list_del(&page->lru);
 			rmv_page_order(page);
+			pasr_kget(page, current_order);
 
 			/* Take ownership for orders >= pageblock_order */
 			if (current_order >= pageblock_order &&
@@ -1480,6 +1524,7 @@ static int __isolate_free_page(struct page *page, unsigned int order)
 	list_del(&page->lru);
 	zone->free_area[order].nr_free--;
 	rmv_page_order(page);
+	pasr_kget(page, order);
 
 	/* Set the pageblock if the isolated page is at least a pageblock */
 	if (order >= pageblock_order - 1) {
@@ -1590,6 +1635,10 @@ again:
 	zone_statistics(preferred_zone, zone, gfp_flags);
 	local_irq_restore(flags);
 
+	/* Have kswapd reclaim to the boosted watermarks at once */
+	if (unlikely(zone_test_and_clear_flag(zone, ZONE_BOOSTED_WATERMARK)))
+		wakeup_kswapd(zone, 0, zone_idx(zone));
+
 	VM_BUG_ON(bad_range(zone, page));
 	if (prep_new_page(page, order, gfp_flags))
 		goto again;
@@ -2422,6 +2471,10 @@ __alloc_pages_slowpath(gfp_t gfp_mask, unsigned int order,
 	if (NUMA_BUILD && (gfp_mask & GFP_THISNODE) == GFP_THISNODE)
 		goto nopage;
 
+	/* Tell background compaction which orders run short */
+	if (order)
+		compaction_stall(order);
+
 restart:
 	if (!(gfp_mask & __GFP_NO_KSWAPD))
 		wake_all_kswapd(order, zonelist, high_zoneidx,
@@ -2497,6 +2550,9 @@ rebalance:
 						(gfp_mask & __GFP_NO_KSWAPD))
 		goto nopage;
 
+	/* Have kswapd keep more free the next time */
+	boost_watermark(preferred_zone, WATERMARK_BOOST_STALL);
+
 	/* Try direct reclaim and then allocating */
 	page = __alloc_pages_direct_reclaim(gfp_mask, order,
 					zonelist, high_zoneidx,
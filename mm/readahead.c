@@ -17,6 +17,7 @@
 #include <linux/task_io_accounting_ops.h>
 #include <linux/pagevec.h>
 #include <linux/pagemap.h>
+#include <linux/boot_prefetch.h>
 
 unsigned long max_readahead_pages = VM_MAX_READAHEAD * 1024 / PAGE_CACHE_SIZE;
 
@@ -218,6 +219,8 @@ __do_page_cache_readahead(struct address_space *mapping, struct file *filp,
 			SetPageReadahead(page);
 		ret++;
 	}
+	if (ret)
+		__add_bdi_stat(mapping->backing_dev_info, BDI_READAHEAD, ret);
 
 	/*
 	 * Now start the IO.  We ignore I/O errors - if the page is not
@@ -274,6 +277,26 @@ unsigned long max_sane_readahead(unsigned long nr)
 		+ node_page_state(numa_node_id(), NR_FREE_PAGES)) / 2);
 }
 
+/**
+ * ra_window - readahead window of a file
+ * @mapping: address_space of the file
+ * @ra: file_ra_state of the file
+ *
+ * Returns ra->ra_pages scaled to the read latency of the device backing
+ * @mapping, see block/blk-ra.c.
+ */
+unsigned long ra_window(struct address_space *mapping,
+			struct file_ra_state *ra)
+{
+	unsigned int scale = ACCESS_ONCE(mapping->backing_dev_info->ra_scale);
+
+	if (scale == BDI_RA_SCALE_ONE)
+		return ra->ra_pages;
+
+	return max_t(unsigned long,
+		     ((unsigned long)ra->ra_pages * scale) >> BDI_RA_SCALE_SHIFT, 1);
+}
+
 /*
  * Submit IO for the read-ahead request in file_ra_state.
  */
@@ -427,7 +450,7 @@ ondemand_readahead(struct address_space *mapping,
 		   bool hit_readahead_marker, pgoff_t offset,
 		   unsigned long req_size)
 {
-	unsigned long max = max_sane_readahead(ra->ra_pages);
+	unsigned long max = max_sane_readahead(ra_window(mapping, ra));
 
 	/*
 	 * start of file
@@ -533,6 +556,8 @@ void page_cache_sync_readahead(struct address_space *mapping,
 			       struct file_ra_state *ra, struct file *filp,
 			       pgoff_t offset, unsigned long req_size)
 {
+	boot_prefetch_record(filp, offset, req_size);
+
 	/* no read-ahead */
 	if (!ra->ra_pages)
 		return;
@@ -569,6 +594,9 @@ page_cache_async_readahead(struct address_space *mapping,
 			   struct page *page, pgoff_t offset,
 			   unsigned long req_size)
 {
+	/* first use of a page read ahead */
+	boot_prefetch_record(filp, offset, 1);
+
 	/* no read-ahead */
 	if (!ra->ra_pages)
 		return;
@@ -580,6 +608,7 @@ page_cache_async_readahead(struct address_space *mapping,
 		return;
 
 	ClearPageReadahead(page);
+	__inc_bdi_stat(mapping->backing_dev_info, BDI_RA_HIT);
 
 	/*
 	 * Defer asynchronous read-ahead on IO congestion.
@@ -1006,34 +1006,6 @@ static inline unsigned long slabs_node(struct kmem_cache *s, int node)
 	return atomic_long_read(&n->nr_slabs);
 }
 
-static inline unsigned long node_nr_slabs(struct kmem_cache_node *n)
-{
-	return atomic_long_read(&n->nr_slabs);
-}
-
-static inline void inc_slabs_node(struct kmem_cache *s, int node, int objects)
-{
-	struct kmem_cache_node *n = get_node(s, node);
-
-	/*
-	 * May be called early in order to allocate a slab for the
-	 * kmem_cache_node structure. Solve the chicken-egg
-	 * dilemma by deferring the increment of the count during
-	 * bootstrap (see early_kmem_cache_node_alloc).
-	 */
-	if (n) {
-		atomic_long_inc(&n->nr_slabs);
-		atomic_long_add(objects, &n->total_objects);
-	}
-}
-static inline void dec_slabs_node(struct kmem_cache *s, int node, int objects)
-{
-	struct kmem_cache_node *n = get_node(s, node);
-
-	atomic_long_dec(&n->nr_slabs);
-	atomic_long_sub(objects, &n->total_objects);
-}
-
 /* Object debug checks for alloc/free paths */
 static void setup_object_debug(struct kmem_cache *s, struct page *page,
 								void *object)
@@ -1247,12 +1219,6 @@ static inline unsigned long kmem_cache_flags(unsigned long objsize,
 
 static inline unsigned long slabs_node(struct kmem_cache *s, int node)
 							{ return 0; }
-static inline unsigned long node_nr_slabs(struct kmem_cache_node *n)
-							{ return 0; }
-static inline void inc_slabs_node(struct kmem_cache *s, int node,
-							int objects) {}
-static inline void dec_slabs_node(struct kmem_cache *s, int node,
-							int objects) {}
 
 static inline int slab_pre_alloc_hook(struct kmem_cache *s, gfp_t flags)
 							{ return 0; }
@@ -1264,6 +1230,43 @@ static inline void slab_free_hook(struct kmem_cache *s, void *x) {}
 
 #endif /* CONFIG_SLUB_DEBUG */
 
+#if defined(CONFIG_SLUB_DEBUG) || defined(CONFIG_SLUB_SUMMARY)
+static inline unsigned long node_nr_slabs(struct kmem_cache_node *n)
+{
+	return atomic_long_read(&n->nr_slabs);
+}
+
+static inline void inc_slabs_node(struct kmem_cache *s, int node, int objects)
+{
+	struct kmem_cache_node *n = get_node(s, node);
+
+	/*
+	 * May be called early in order to allocate a slab for the
+	 * kmem_cache_node structure. Solve the chicken-egg
+	 * dilemma by deferring the increment of the count during
+	 * bootstrap (see early_kmem_cache_node_alloc).
+	 */
+	if (n) {
+		atomic_long_inc(&n->nr_slabs);
+		atomic_long_add(objects, &n->total_objects);
+	}
+}
+static inline void dec_slabs_node(struct kmem_cache *s, int node, int objects)
+{
+	struct kmem_cache_node *n = get_node(s, node);
+
+	atomic_long_dec(&n->nr_slabs);
+	atomic_long_sub(objects, &n->total_objects);
+}
+#else
+static inline unsigned long node_nr_slabs(struct kmem_cache_node *n)
+							{ return 0; }
+static inline void inc_slabs_node(struct kmem_cache *s, int node,
+							int objects) {}
+static inline void dec_slabs_node(struct kmem_cache *s, int node,
+							int objects) {}
+#endif
+
 /*
  * Slab allocation and freeing
  */
@@ -2063,7 +2066,7 @@ static unsigned long count_partial(struct kmem_cache_node *n,
 
 static inline unsigned long node_nr_objs(struct kmem_cache_node *n)
 {
-#ifdef CONFIG_SLUB_DEBUG
+#if defined(CONFIG_SLUB_DEBUG) || defined(CONFIG_SLUB_SUMMARY)
 	return atomic_long_read(&n->total_objects);
 #else
 	return 0;
@@ -2616,6 +2619,15 @@ static int slub_min_objects;
  */
 static int slub_nomerge;
 
+/*
+ * Lean mode. Caps the free objects kept in the per cpu partial slabs of
+ * a cache at SLUB_LEAN_CPU_PARTIAL bytes instead of a count that only
+ * grows with smaller objects.
+ */
+#define SLUB_LEAN_CPU_PARTIAL	2048
+
+static int slub_lean = IS_ENABLED(CONFIG_SLUB_LEAN);
+
 /*
  * Calculate the order of allocation given an slab object size.
  *
@@ -2752,9 +2764,11 @@ init_kmem_cache_node(struct kmem_cache_node *n, struct kmem_cache *s)
 	n->nr_partial = 0;
 	spin_lock_init(&n->list_lock);
 	INIT_LIST_HEAD(&n->partial);
-#ifdef CONFIG_SLUB_DEBUG
+#if defined(CONFIG_SLUB_DEBUG) || defined(CONFIG_SLUB_SUMMARY)
 	atomic_long_set(&n->nr_slabs, 0);
 	atomic_long_set(&n->total_objects, 0);
+#endif
+#ifdef CONFIG_SLUB_DEBUG
 	INIT_LIST_HEAD(&n->full);
 #endif
 }
@@ -3066,6 +3080,10 @@ static int kmem_cache_open(struct kmem_cache *s,
 	else
 		s->cpu_partial = 30;
 
+	if (slub_lean)
+		s->cpu_partial = min_t(int, s->cpu_partial,
+				       SLUB_LEAN_CPU_PARTIAL / s->size);
+
 	s->refcount = 1;
 #ifdef CONFIG_NUMA
 	s->remote_node_defrag_ratio = 1000;
@@ -3236,6 +3254,15 @@ static int __init setup_slub_nomerge(char *str)
 
 __setup("slub_nomerge", setup_slub_nomerge);
 
+static int __init setup_slub_lean(char *str)
+{
+	get_option(&str, &slub_lean);
+
+	return 1;
+}
+
+__setup("slub_lean=", setup_slub_lean);
+
 static struct kmem_cache *__init create_kmalloc_cache(const char *name,
 						int size, unsigned int flags)
 {
@@ -5500,3 +5527,109 @@ static int __init slab_proc_init(void)
 }
 module_init(slab_proc_init);
 #endif /* CONFIG_SLABINFO */
+
+/*
+ * /proc/slabsummary: the memory of each cache, also without SLUB_DEBUG.
+ * waste_kb is the memory of the slabs less the payload of the objects in
+ * use, so it covers free objects, metadata and the padding of merged
+ * caches.
+ */
+#ifdef CONFIG_SLUB_SUMMARY
+static void *summary_start(struct seq_file *m, loff_t *pos)
+{
+	down_read(&slub_lock);
+	if (!*pos)
+		seq_puts(m, "# name            <objsize> <size> <active_objs> "
+			 "<num_objs> <slabs> <partial> <cpu_partial_slabs> "
+			 "<cpu_partial_kb> <slab_kb> <waste_kb> <aliases>\n");
+
+	return seq_list_start(&slab_caches, *pos);
+}
+
+static void *summary_next(struct seq_file *m, void *p, loff_t *pos)
+{
+	return seq_list_next(p, &slab_caches, pos);
+}
+
+static void summary_stop(struct seq_file *m, void *p)
+{
+	up_read(&slub_lock);
+}
+
+static int summary_show(struct seq_file *m, void *p)
+{
+	struct kmem_cache *s = list_entry(p, struct kmem_cache, list);
+	unsigned long slab_bytes = PAGE_SIZE << oo_order(s->oo);
+	unsigned long nr_partials = 0;
+	unsigned long nr_slabs = 0;
+	unsigned long nr_objs = 0;
+	unsigned long nr_free = 0;
+	unsigned long nr_inuse;
+	unsigned long cpu_slabs = 0;
+	unsigned long slab_kb;
+	unsigned long inuse_kb;
+	int node;
+	int cpu;
+
+	for_each_online_node(node) {
+		struct kmem_cache_node *n = get_node(s, node);
+
+		if (!n)
+			continue;
+
+		nr_partials += n->nr_partial;
+		nr_slabs += node_nr_slabs(n);
+		nr_objs += node_nr_objs(n);
+		nr_free += count_partial(n, count_free);
+	}
+
+	for_each_online_cpu(cpu) {
+		struct page *page;
+
+		page = ACCESS_ONCE(per_cpu_ptr(s->cpu_slab, cpu)->partial);
+		if (page) {
+			cpu_slabs += page->pages;
+			nr_free += page->pobjects;
+		}
+	}
+
+	nr_inuse = nr_objs > nr_free ? nr_objs - nr_free : 0;
+	slab_kb = (nr_slabs * slab_bytes) >> 10;
+	inuse_kb = (nr_inuse * s->objsize) >> 10;
+
+	seq_printf(m, "%-17s %6u %6u %6lu %6lu %6lu %6lu %6lu %6lu %6lu %6lu "
+		   "%4d\n", s->name, s->objsize, s->size, nr_inuse, nr_objs,
+		   nr_slabs, nr_partials, cpu_slabs,
+		   (cpu_slabs * slab_bytes) >> 10, slab_kb,
+		   slab_kb > inuse_kb ? slab_kb - inuse_kb : 0,
+		   s->refcount - 1);
+	return 0;
+}
+
+static const struct seq_operations slabsummary_op = {
+	.start = summary_start,
+	.next = summary_next,
+	.stop = summary_stop,
+	.show = summary_show,
+};
+
+static int slabsummary_open(struct inode *inode, struct file *file)
+{
+	return seq_open(file, &slabsummary_op);
+}
+
+static const struct file_operations proc_slabsummary_operations = {
+	.open		= slabsummary_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= seq_release,
+};
+
+static int __init slab_summary_init(void)
+{
+	proc_create("slabsummary", S_IRUSR, NULL,
+		    &proc_slabsummary_operations);
+	return 0;
+}
+module_init(slab_summary_init);
+#endif /* CONFIG_SLUB_SUMMARY */
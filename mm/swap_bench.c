@@ -0,0 +1,602 @@
+/*
+ * Compressed swap benchmark
+ *
+ * Replays a swap trace over a corpus of page contents against one
+ * compressed swap target, and reports the throughput, the latency
+ * percentiles, the compression ratio and the memory used per operation
+ * type, along with the cpu frequency of the run.
+ *
+ * The files are in <debugfs>/swap_bench:
+ *  - corpus: the page contents, written in whole pages. Left empty, a
+ *    synthetic mix of zero, text like, repetitive and random pages is used.
+ *  - trace: an array of u32, the number of a corpus page, with bit 31 set
+ *    for a swap out and clear for a swap in. Left empty, all corpus pages
+ *    are swapped out and then swapped in.
+ *  - run: writing a target replays the trace against it, reading gives the
+ *    reports of the runs so far, one line of key=value pairs per operation
+ *    type. Truncating it, as "echo lz4 > run" does, clears them first.
+ *
+ * A target is either a crypto compressor ("lzo", "lz4", "lz4hc"), whose
+ * output is kept in kmalloc buffers the way the frontswap backends keep
+ * theirs, or the path of a swap block device such as /dev/block/zram0 or
+ * /dev/block/vnswap0, which is opened exclusively and so cannot be an
+ * active swap device.
+ */
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/blkdev.h>
+#include <linux/bio.h>
+#include <linux/completion.h>
+#include <linux/cpufreq.h>
+#include <linux/crypto.h>
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#define BENCH_SYNTHETIC_PAGES	256
+#define BENCH_REPORT_SIZE	(4 * PAGE_SIZE)
+#define BENCH_OP_WRITE		(1U << 31)
+
+static unsigned int max_pages = 2048;
+module_param(max_pages, uint, 0444);
+MODULE_PARM_DESC(max_pages, "Size of the corpus in pages");
+
+static unsigned int max_ops = 16384;
+module_param(max_ops, uint, 0444);
+MODULE_PARM_DESC(max_ops, "Size of the trace in operations");
+
+static DEFINE_MUTEX(bench_mutex);
+
+static u8 *corpus;
+static unsigned int corpus_pages;
+static u32 *trace;
+static unsigned int trace_len;
+
+static char *bench_report;
+static unsigned int bench_report_len;
+
+struct bench_stats {
+	u32 *ns;
+	unsigned int count;
+	unsigned int errors;
+	u64 total_ns;
+};
+
+struct bench_run {
+	const u32 *ops;
+	unsigned int nr_ops;
+	unsigned int pages;
+	struct bench_stats out;
+	struct bench_stats in;
+	/* Bytes of the pages swapped out and of what holds them */
+	u64 data_bytes;
+	u64 stored_bytes;
+	long mem_used_kb;
+};
+
+/* Zero, text like, repetitive and random pages, in about equal parts */
+static void bench_fill_synthetic(u8 *buf, unsigned int pages)
+{
+	static const char words[] = "the quick brown fox jumps over the lazy dog ";
+	u32 seed = 0x12345678;
+	unsigned int p;
+	size_t i;
+
+	for (p = 0; p < pages; p++, buf += PAGE_SIZE) {
+		switch (p % 4) {
+		case 0:
+			memset(buf, 0, PAGE_SIZE);
+			break;
+		case 1:
+			for (i = 0; i < PAGE_SIZE; i++) {
+				seed = seed * 1103515245 + 12345;
+				buf[i] = (seed >> 24) & 1 ?
+					words[i % (sizeof(words) - 1)] :
+					'a' + (seed >> 16) % 26;
+			}
+			break;
+		case 2:
+			for (i = 0; i < PAGE_SIZE; i += sizeof(u32)) {
+				u32 v = (i / 64) * 0x01010101;
+
+				memcpy(buf + i, &v, sizeof(v));
+			}
+			break;
+		default:
+			for (i = 0; i < PAGE_SIZE; i++) {
+				seed = seed * 1103515245 + 12345;
+				buf[i] = seed >> 24;
+			}
+			break;
+		}
+	}
+}
+
+static int bench_stats_alloc(struct bench_stats *stats, unsigned int nr_ops)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->ns = vmalloc(nr_ops * sizeof(*stats->ns));
+
+	return stats->ns ? 0 : -ENOMEM;
+}
+
+static void bench_stats_add(struct bench_stats *stats, ktime_t start)
+{
+	s64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	stats->ns[stats->count++] = min_t(s64, ns, U32_MAX);
+	stats->total_ns += ns;
+}
+
+static int bench_cmp_u32(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a;
+	u32 y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void bench_report_stats(const char *target, const char *op,
+			       struct bench_stats *stats)
+{
+	unsigned int n = stats->count;
+	u64 kbps = 0;
+
+	if (!n)
+		return;
+
+	sort(stats->ns, n, sizeof(*stats->ns), bench_cmp_u32, NULL);
+	if (stats->total_ns)
+		kbps = div64_u64((u64)n * PAGE_SIZE * 1000000, stats->total_ns);
+
+	bench_report_len += scnprintf(bench_report + bench_report_len,
+		BENCH_REPORT_SIZE - bench_report_len,
+		"target=%s op=%s khz=%u pages=%u errors=%u kb_per_s=%llu "
+		"p50_ns=%u p90_ns=%u p99_ns=%u max_ns=%u\n",
+		target, op, cpufreq_quick_get(0), n, stats->errors, kbps,
+		stats->ns[n / 2], stats->ns[n * 9 / 10], stats->ns[n * 99 / 100],
+		stats->ns[n - 1]);
+}
+
+static void bench_report_run(const char *target, struct bench_run *run)
+{
+	u64 ratio = 0;
+
+	bench_report_stats(target, "out", &run->out);
+	bench_report_stats(target, "in", &run->in);
+
+	/* Hundredths of the size of the pages swapped out */
+	if (run->data_bytes)
+		ratio = div64_u64(run->stored_bytes * 100, run->data_bytes);
+
+	bench_report_len += scnprintf(bench_report + bench_report_len,
+		BENCH_REPORT_SIZE - bench_report_len,
+		"target=%s op=mem data_kb=%llu stored_kb=%llu "
+		"stored_pct=%llu mem_used_kb=%ld\n",
+		target, run->data_bytes >> 10, run->stored_bytes >> 10,
+		ratio, run->mem_used_kb);
+}
+
+static long bench_free_kb(void)
+{
+	struct sysinfo si;
+
+	si_meminfo(&si);
+	return si.freeram << (PAGE_SHIFT - 10);
+}
+
+static int bench_compressor(const char *name, struct bench_run *run)
+{
+	struct crypto_comp *tfm;
+	unsigned int *lens;
+	void **store;
+	u8 *dst;
+	unsigned int i;
+	int ret = 0;
+
+	tfm = crypto_alloc_comp(name, 0, 0);
+	if (IS_ERR(tfm))
+		return PTR_ERR(tfm);
+
+	store = vzalloc(run->pages * sizeof(*store));
+	lens = vzalloc(run->pages * sizeof(*lens));
+	dst = kmalloc(2 * PAGE_SIZE, GFP_KERNEL);
+	if (!store || !lens || !dst) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < run->nr_ops; i++) {
+		unsigned int page = run->ops[i] & ~BENCH_OP_WRITE;
+		const u8 *src = corpus + (size_t)page * PAGE_SIZE;
+		unsigned int dlen;
+		ktime_t start;
+		void *buf;
+
+		start = ktime_get();
+		if (run->ops[i] & BENCH_OP_WRITE) {
+			dlen = 2 * PAGE_SIZE;
+			ret = crypto_comp_compress(tfm, src, PAGE_SIZE, dst,
+						   &dlen);
+			if (ret || dlen >= PAGE_SIZE) {
+				/* Kept as it is, as zram does */
+				run->out.errors += !!ret;
+				dlen = PAGE_SIZE;
+				buf = kmalloc(dlen, GFP_KERNEL);
+				if (buf)
+					memcpy(buf, src, dlen);
+			} else {
+				buf = kmalloc(dlen, GFP_KERNEL);
+				if (buf)
+					memcpy(buf, dst, dlen);
+			}
+			if (!buf) {
+				ret = -ENOMEM;
+				goto out;
+			}
+			bench_stats_add(&run->out, start);
+
+			if (store[page]) {
+				run->data_bytes -= PAGE_SIZE;
+				run->stored_bytes -= ksize(store[page]);
+				kfree(store[page]);
+			}
+			store[page] = buf;
+			lens[page] = dlen;
+			run->data_bytes += PAGE_SIZE;
+			run->stored_bytes += ksize(buf);
+		} else if (store[page]) {
+			dlen = PAGE_SIZE;
+			if (lens[page] == PAGE_SIZE) {
+				memcpy(dst, store[page], PAGE_SIZE);
+				ret = 0;
+			} else {
+				ret = crypto_comp_decompress(tfm, store[page],
+							     lens[page], dst,
+							     &dlen);
+			}
+			bench_stats_add(&run->in, start);
+			if (ret || dlen != PAGE_SIZE ||
+			    memcmp(dst, src, PAGE_SIZE))
+				run->in.errors++;
+		}
+		ret = 0;
+		cond_resched();
+	}
+
+out:
+	if (store) {
+		for (i = 0; i < run->pages; i++)
+			kfree(store[i]);
+	}
+	kfree(dst);
+	vfree(lens);
+	vfree(store);
+	crypto_free_comp(tfm);
+	return ret;
+}
+
+static void bench_bio_end_io(struct bio *bio, int err)
+{
+	if (err)
+		clear_bit(BIO_UPTODATE, &bio->bi_flags);
+	complete(bio->bi_private);
+}
+
+static int bench_bio(struct block_device *bdev, int rw, unsigned int page,
+		     struct page *buf)
+{
+	DECLARE_COMPLETION_ONSTACK(done);
+	struct bio *bio;
+	int ret = 0;
+
+	bio = bio_alloc(GFP_KERNEL, 1);
+	if (!bio)
+		return -ENOMEM;
+
+	bio->bi_bdev = bdev;
+	bio->bi_sector = (sector_t)page << (PAGE_SHIFT - 9);
+	bio->bi_end_io = bench_bio_end_io;
+	bio->bi_private = &done;
+	bio_add_page(bio, buf, PAGE_SIZE, 0);
+
+	submit_bio(rw | REQ_SYNC, bio);
+	wait_for_completion(&done);
+
+	if (!test_bit(BIO_UPTODATE, &bio->bi_flags))
+		ret = -EIO;
+	bio_put(bio);
+
+	return ret;
+}
+
+static int bench_bdev(const char *path, struct bench_run *run)
+{
+	const fmode_t mode = FMODE_READ | FMODE_WRITE | FMODE_EXCL;
+	struct block_device *bdev;
+	unsigned long *written;
+	struct page *buf;
+	sector_t sectors;
+	long free_kb;
+	unsigned int i;
+	int ret = 0;
+
+	bdev = blkdev_get_by_path(path, mode, &bench_mutex);
+	if (IS_ERR(bdev))
+		return PTR_ERR(bdev);
+
+	sectors = i_size_read(bdev->bd_inode) >> 9;
+	if (((sector_t)run->pages << (PAGE_SHIFT - 9)) > sectors) {
+		ret = -ENOSPC;
+		goto out_put;
+	}
+
+	buf = alloc_page(GFP_KERNEL);
+	written = vzalloc(BITS_TO_LONGS(run->pages) * sizeof(long));
+	if (!buf || !written) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	free_kb = bench_free_kb();
+
+	for (i = 0; i < run->nr_ops; i++) {
+		unsigned int page = run->ops[i] & ~BENCH_OP_WRITE;
+		const u8 *src = corpus + (size_t)page * PAGE_SIZE;
+		ktime_t start;
+
+		if (run->ops[i] & BENCH_OP_WRITE) {
+			memcpy(page_address(buf), src, PAGE_SIZE);
+			start = ktime_get();
+			if (bench_bio(bdev, WRITE, page, buf))
+				run->out.errors++;
+			bench_stats_add(&run->out, start);
+			if (!__test_and_set_bit(page, written))
+				run->data_bytes += PAGE_SIZE;
+		} else if (test_bit(page, written)) {
+			start = ktime_get();
+			if (bench_bio(bdev, READ, page, buf) ||
+			    memcmp(page_address(buf), src, PAGE_SIZE))
+				run->in.errors++;
+			bench_stats_add(&run->in, start);
+		}
+		cond_resched();
+	}
+
+	/* What the device took from the rest of the system, roughly */
+	run->mem_used_kb = free_kb - bench_free_kb();
+	run->stored_bytes = max_t(long, run->mem_used_kb, 0) << 10;
+
+	/* Give the memory of the pages back, zram and vnswap free on discard */
+	blkdev_issue_discard(bdev, 0, (sector_t)run->pages << (PAGE_SHIFT - 9),
+			     GFP_KERNEL, 0);
+
+out:
+	vfree(written);
+	if (buf)
+		__free_page(buf);
+out_put:
+	blkdev_put(bdev, mode);
+	return ret;
+}
+
+static int bench_run_target(const char *target)
+{
+	struct bench_run run;
+	u32 *ops = NULL;
+	unsigned int i;
+	int ret;
+
+	memset(&run, 0, sizeof(run));
+
+	run.pages = corpus_pages;
+	if (!run.pages) {
+		run.pages = min_t(unsigned int, BENCH_SYNTHETIC_PAGES,
+				  max_pages);
+		bench_fill_synthetic(corpus, run.pages);
+	}
+
+	run.ops = trace;
+	run.nr_ops = trace_len;
+	if (!run.nr_ops) {
+		ops = vmalloc(2 * run.pages * sizeof(*ops));
+		if (!ops)
+			return -ENOMEM;
+		for (i = 0; i < run.pages; i++) {
+			ops[i] = i | BENCH_OP_WRITE;
+			ops[run.pages + i] = i;
+		}
+		run.ops = ops;
+		run.nr_ops = 2 * run.pages;
+	}
+
+	for (i = 0; i < run.nr_ops; i++) {
+		if ((run.ops[i] & ~BENCH_OP_WRITE) >= run.pages) {
+			ret = -EINVAL;
+			goto out;
+		}
+	}
+
+	ret = bench_stats_alloc(&run.out, run.nr_ops);
+	if (!ret)
+		ret = bench_stats_alloc(&run.in, run.nr_ops);
+	if (ret)
+		goto out;
+
+	if (target[0] == '/')
+		ret = bench_bdev(target, &run);
+	else
+		ret = bench_compressor(target, &run);
+
+	if (!ret)
+		bench_report_run(target, &run);
+
+out:
+	vfree(run.in.ns);
+	vfree(run.out.ns);
+	vfree(ops);
+	return ret;
+}
+
+static int bench_open(struct inode *inode, struct file *filp)
+{
+	filp->private_data = inode->i_private;
+
+	if ((filp->f_mode & FMODE_WRITE) && (filp->f_flags & O_TRUNC)) {
+		mutex_lock(&bench_mutex);
+		*(unsigned int *)inode->i_private = 0;
+		mutex_unlock(&bench_mutex);
+	}
+
+	return 0;
+}
+
+static ssize_t bench_corpus_write(struct file *filp, const char __user *ubuf,
+				  size_t cnt, loff_t *ppos)
+{
+	size_t size = (size_t)max_pages * PAGE_SIZE;
+	loff_t pos = *ppos;
+
+	if (pos < 0 || pos >= size || cnt > size - pos)
+		return -ENOSPC;
+
+	mutex_lock(&bench_mutex);
+	if (copy_from_user(corpus + pos, ubuf, cnt)) {
+		mutex_unlock(&bench_mutex);
+		return -EFAULT;
+	}
+	/* A partial last page keeps whatever was after it */
+	corpus_pages = max_t(unsigned int, corpus_pages,
+			     DIV_ROUND_UP(pos + cnt, PAGE_SIZE));
+	mutex_unlock(&bench_mutex);
+
+	*ppos = pos + cnt;
+	return cnt;
+}
+
+static ssize_t bench_trace_write(struct file *filp, const char __user *ubuf,
+				 size_t cnt, loff_t *ppos)
+{
+	size_t size = (size_t)max_ops * sizeof(*trace);
+	loff_t pos = *ppos;
+
+	if (pos < 0 || pos >= size || cnt > size - pos ||
+	    (pos | cnt) % sizeof(*trace))
+		return -EINVAL;
+
+	mutex_lock(&bench_mutex);
+	if (copy_from_user((u8 *)trace + pos, ubuf, cnt)) {
+		mutex_unlock(&bench_mutex);
+		return -EFAULT;
+	}
+	trace_len = max_t(unsigned int, trace_len,
+			  (pos + cnt) / sizeof(*trace));
+	mutex_unlock(&bench_mutex);
+
+	*ppos = pos + cnt;
+	return cnt;
+}
+
+static ssize_t bench_run_read(struct file *filp, char __user *ubuf,
+			      size_t cnt, loff_t *ppos)
+{
+	ssize_t ret;
+
+	mutex_lock(&bench_mutex);
+	ret = simple_read_from_buffer(ubuf, cnt, ppos, bench_report,
+				      bench_report_len);
+	mutex_unlock(&bench_mutex);
+
+	return ret;
+}
+
+static ssize_t bench_run_write(struct file *filp, const char __user *ubuf,
+			       size_t cnt, loff_t *ppos)
+{
+	char target[64];
+	char *t;
+	int ret;
+
+	if (cnt >= sizeof(target))
+		return -EINVAL;
+	if (copy_from_user(target, ubuf, cnt))
+		return -EFAULT;
+	target[cnt] = '\0';
+	t = strim(target);
+	if (!*t)
+		return cnt;
+
+	mutex_lock(&bench_mutex);
+	ret = bench_run_target(t);
+	mutex_unlock(&bench_mutex);
+
+	return ret ? ret : cnt;
+}
+
+static const struct file_operations bench_corpus_fops = {
+	.open		= bench_open,
+	.write		= bench_corpus_write,
+	.llseek		= default_llseek,
+};
+
+static const struct file_operations bench_trace_fops = {
+	.open		= bench_open,
+	.write		= bench_trace_write,
+	.llseek		= default_llseek,
+};
+
+static const struct file_operations bench_run_fops = {
+	.open		= bench_open,
+	.read		= bench_run_read,
+	.write		= bench_run_write,
+	.llseek		= default_llseek,
+};
+
+static struct dentry *bench_dir;
+
+static int __init swap_bench_init(void)
+{
+	corpus = vzalloc((size_t)max_pages * PAGE_SIZE);
+	trace = vmalloc((size_t)max_ops * sizeof(*trace));
+	bench_report = kzalloc(BENCH_REPORT_SIZE, GFP_KERNEL);
+	if (!corpus || !trace || !bench_report)
+		goto err;
+
+	bench_dir = debugfs_create_dir("swap_bench", NULL);
+	if (!bench_dir)
+		goto err;
+
+	debugfs_create_file("corpus", 0200, bench_dir, &corpus_pages,
+			    &bench_corpus_fops);
+	debugfs_create_file("trace", 0200, bench_dir, &trace_len,
+			    &bench_trace_fops);
+	debugfs_create_file("run", 0600, bench_dir, &bench_report_len,
+			    &bench_run_fops);
+
+	return 0;
+
+err:
+	kfree(bench_report);
+	vfree(trace);
+	vfree(corpus);
+	return -ENOMEM;
+}
+
+static void __exit swap_bench_exit(void)
+{
+	debugfs_remove_recursive(bench_dir);
+	kfree(bench_report);
+	vfree(trace);
+	vfree(corpus);
+}
+
+module_init(swap_bench_init);
+module_exit(swap_bench_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Compressed swap benchmark");
@@ -1013,6 +1013,52 @@ unsigned long reclaim_clean_pages_from_list(struct zone *zone,
 	return ret;
 }
 
+#ifdef CONFIG_PROCESS_RECLAIM
+/*
+ * Reclaims isolated pages regardless of their references, anonymous pages
+ * are written to swap. The pages that could not be reclaimed are put back
+ * on their LRU lists.
+ */
+unsigned long reclaim_pages_from_list(struct list_head *page_list)
+{
+	struct scan_control sc = {
+		.gfp_mask = GFP_KERNEL,
+		.priority = DEF_PRIORITY,
+		.may_writepage = 1,
+		.may_unmap = 1,
+		.may_swap = 1,
+	};
+	unsigned long nr_reclaimed = 0;
+	unsigned long dummy1, dummy2;
+	struct page *page;
+	struct zone *zone;
+	int file;
+	LIST_HEAD(single);
+
+	/* shrink_page_list() wants the pages of one zone */
+	while (!list_empty(page_list)) {
+		page = lru_to_page(page_list);
+		list_move(&page->lru, &single);
+		zone = page_zone(page);
+		file = page_is_file_cache(page);
+		ClearPageActive(page);
+
+		nr_reclaimed += shrink_page_list(&single, zone, &sc,
+						 TTU_UNMAP|TTU_IGNORE_ACCESS,
+						 &dummy1, &dummy2, true);
+		mod_zone_page_state(zone, NR_ISOLATED_ANON + file, -1);
+
+		if (!list_empty(&single)) {
+			page = lru_to_page(&single);
+			list_del(&page->lru);
+			putback_lru_page(page);
+		}
+	}
+
+	return nr_reclaimed;
+}
+#endif
+
 /*
  * Attempt to remove the specified page from its LRU.  Only take this page
  * if it is of the appropriate PageActive status.  Pages which are being
@@ -2384,7 +2430,8 @@ static bool zone_balanced(struct zone *zone, int order,
 			  unsigned long balance_gap, int classzone_idx)
 {
 	if (!zone_watermark_ok_safe(zone, order, high_wmark_pages(zone) +
-				    balance_gap, classzone_idx, 0))
+				    zone_watermark_boost(zone) + balance_gap,
+				    classzone_idx, 0))
 		return false;
 
 	if (COMPACTION_BUILD && order && !compaction_suitable(zone, order))
@@ -2696,6 +2743,8 @@ loop_again:
 				 * spectulatively avoid congestion waits
 				 */
 				zone_clear_flag(zone, ZONE_CONGESTED);
+				/* The boost was met, drop it */
+				zone->watermark_boost = 0;
 				if (i <= *classzone_idx)
 					balanced += zone->present_pages;
 			}
@@ -2988,7 +3037,8 @@ void wakeup_kswapd(struct zone *zone, int order, enum zone_type classzone_idx)
 	}
 	if (!waitqueue_active(&pgdat->kswapd_wait))
 		return;
-	if (zone_watermark_ok_safe(zone, order, low_wmark_pages(zone), 0, 0))
+	if (zone_watermark_ok_safe(zone, order, low_wmark_pages(zone) +
+				   zone_watermark_boost(zone), 0, 0))
 		return;
 
 	trace_mm_vmscan_wakeup_kswapd(pgdat->node_id, zone_idx(zone), order);
@@ -763,6 +763,8 @@ const char * const vmstat_text[] = {
 	"allocstall",
 
 	"pgrotated",
+	"watermark_boost_fragment",
+	"watermark_boost_stall",
 
 #ifdef CONFIG_MIGRATION
 	"pgmigrate_success",
@@ -985,6 +987,7 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 		   "\n        min      %lu"
 		   "\n        low      %lu"
 		   "\n        high     %lu"
+		   "\n        boost    %lu"
 		   "\n        scanned  %lu"
 		   "\n        spanned  %lu"
 		   "\n        present  %lu",
@@ -992,6 +995,7 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 		   min_wmark_pages(zone),
 		   low_wmark_pages(zone),
 		   high_wmark_pages(zone),
+		   zone_watermark_boost(zone),
 		   zone->pages_scanned,
 		   zone->spanned_pages,
 		   zone->present_pages);
@@ -35,6 +35,8 @@
 #include <linux/crypto.h>
 #include <linux/mempool.h>
 #include <linux/zpool.h>
+#include <linux/kthread.h>
+#include <linux/wait.h>
 
 #include <linux/mm_types.h>
 #include <linux/page-flags.h>
@@ -61,6 +63,8 @@ static atomic_t zswap_stored_pages = ATOMIC_INIT(0);
 static u64 zswap_pool_limit_hit;
 /* Pages written back when pool limit was reached */
 static u64 zswap_written_back_pages;
+/* Pages written back by the background writeback thread */
+static u64 zswap_bg_written_back_pages;
 /* Store failed due to a reclaim failure after pool limit was reached */
 static u64 zswap_reject_reclaim_fail;
 /* Compressed page was too big for the allocator to (optimally) store */
@@ -71,6 +75,8 @@ static u64 zswap_reject_alloc_fail;
 static u64 zswap_reject_kmemcache_fail;
 /* Duplicate store was encountered (rare) */
 static u64 zswap_duplicate_entry;
+/* The number of same-value filled pages currently stored in zswap */
+static atomic_t zswap_same_filled_pages = ATOMIC_INIT(0);
 
 /*********************************
 * tunables
@@ -108,6 +114,24 @@ module_param_named(max_compression_ratio,
 static char *zswap_zpool_type = ZSWAP_ZPOOL_DEFAULT;
 module_param_named(zpool, zswap_zpool_type, charp, 0644);
 
+/*
+ * Background writeback starts once the pool exceeds this percentage of
+ * the max pool size and writes back at most bg_writeback_batch of the
+ * least recently stored pages per pass.  0 disables it.
+ */
+static unsigned int zswap_bg_writeback_percent = 90;
+module_param_named(bg_writeback_percent, zswap_bg_writeback_percent,
+		   uint, 0644);
+
+static unsigned int zswap_bg_writeback_batch = 32;
+module_param_named(bg_writeback_batch, zswap_bg_writeback_batch,
+		   uint, 0644);
+
+/* Enable/disable handling same-value filled pages (enabled by default) */
+static bool zswap_same_filled_pages_enabled = true;
+module_param_named(same_filled_pages_enabled, zswap_same_filled_pages_enabled,
+		   bool, 0644);
+
 /* zpool is shared by all of zswap backend  */
 static struct zpool *zswap_pool;
 
@@ -186,17 +210,25 @@ static void zswap_comp_exit(void)
  *            for the zswap_tree structure that contains the entry must
  *            be held while changing the refcount.  Since the lock must
  *            be held, there is no reason to also make refcount atomic.
+ * lru - links the entry into zswap_lru, zpool backed entries only
+ * type - the swap type of the tree the entry belongs to
  * offset - the swap offset for the entry.  Index into the red-black tree.
- * handle - zpool allocation handle that stores the compressed page data
  * length - the length in bytes of the compressed page data.  Needed during
- *          decompression
+ *          decompression.  0 for a same-value filled page.
+ * handle - zpool allocation handle that stores the compressed page data
+ * value - the word a same-value filled page is filled with
  */
 struct zswap_entry {
 	struct rb_node rbnode;
+	struct list_head lru;
+	unsigned int type;
 	pgoff_t offset;
 	int refcount;
 	unsigned int length;
-	unsigned long handle;
+	union {
+		unsigned long handle;
+		unsigned long value;
+	};
 };
 
 struct zswap_header {
@@ -215,6 +247,16 @@ struct zswap_tree {
 
 static struct zswap_tree *zswap_trees[MAX_SWAPFILES];
 
+/*
+ * All zpool backed entries of all trees, most recently stored or loaded
+ * first.  Lock order: tree->lock -> zswap_lru_lock
+ */
+static LIST_HEAD(zswap_lru);
+static DEFINE_SPINLOCK(zswap_lru_lock);
+
+static struct task_struct *zswap_bg_thread;
+static DECLARE_WAIT_QUEUE_HEAD(zswap_bg_wait);
+
 /*********************************
 * zswap entry functions
 **********************************/
@@ -239,6 +281,7 @@ static struct zswap_entry *zswap_entry_cache_alloc(gfp_t gfp)
 		return NULL;
 	entry->refcount = 1;
 	RB_CLEAR_NODE(&entry->rbnode);
+	INIT_LIST_HEAD(&entry->lru);
 	return entry;
 }
 
@@ -302,13 +345,46 @@ static void zswap_rb_erase(struct rb_root *root, struct zswap_entry *entry)
 	}
 }
 
+/*********************************
+* lru functions
+**********************************/
+/* caller must hold the tree lock */
+static void zswap_lru_add(struct zswap_entry *entry)
+{
+	spin_lock(&zswap_lru_lock);
+	list_add(&entry->lru, &zswap_lru);
+	spin_unlock(&zswap_lru_lock);
+}
+
+/* caller must hold the tree lock */
+static void zswap_lru_del(struct zswap_entry *entry)
+{
+	spin_lock(&zswap_lru_lock);
+	list_del_init(&entry->lru);
+	spin_unlock(&zswap_lru_lock);
+}
+
+/* caller must hold the tree lock */
+static void zswap_lru_rotate(struct zswap_entry *entry)
+{
+	spin_lock(&zswap_lru_lock);
+	if (!list_empty(&entry->lru))
+		list_move(&entry->lru, &zswap_lru);
+	spin_unlock(&zswap_lru_lock);
+}
+
 /*
  * Carries out the common pattern of freeing and entry's zpool allocation,
  * freeing the entry itself, and decrementing the number of stored pages.
  */
 static void zswap_free_entry(struct zswap_entry *entry)
 {
-	zpool_free(zswap_pool, entry->handle);
+	if (!entry->length)
+		atomic_dec(&zswap_same_filled_pages);
+	else {
+		zswap_lru_del(entry);
+		zpool_free(zswap_pool, entry->handle);
+	}
 	zswap_entry_cache_free(entry);
 	atomic_dec(&zswap_stored_pages);
 	zswap_pool_total_size = zpool_get_total_size(zswap_pool);
@@ -431,6 +507,16 @@ static bool zswap_is_full(void)
 		DIV_ROUND_UP(zswap_pool_total_size, PAGE_SIZE);
 }
 
+static bool zswap_above_bg_watermark(void)
+{
+	if (!zswap_bg_writeback_percent)
+		return false;
+
+	return totalram_pages * zswap_max_pool_percent / 100 *
+		zswap_bg_writeback_percent / 100 <
+		DIV_ROUND_UP(zswap_pool_total_size, PAGE_SIZE);
+}
+
 /*********************************
 * writeback code
 **********************************/
@@ -646,6 +732,129 @@ end:
 	return ret;
 }
 
+/*
+ * Write back the least recently used entry.
+ * Returns 1 if it was written back, 0 if it vanished or could not be
+ * written back now, -ENOENT if there is nothing left to write back.
+ */
+static int zswap_bg_writeback_one(void)
+{
+	struct zswap_tree *tree;
+	struct zswap_entry *entry;
+	unsigned long handle;
+	unsigned int type;
+	pgoff_t offset;
+	int ret;
+
+	spin_lock(&zswap_lru_lock);
+	if (list_empty(&zswap_lru)) {
+		spin_unlock(&zswap_lru_lock);
+		return -ENOENT;
+	}
+	entry = list_entry(zswap_lru.prev, struct zswap_entry, lru);
+	type = entry->type;
+	offset = entry->offset;
+	/* don't pick the same entry again if it can't be written back now */
+	list_move(&entry->lru, &zswap_lru);
+	spin_unlock(&zswap_lru_lock);
+
+	/* trees are never freed, see zswap_frontswap_invalidate_area() */
+	tree = zswap_trees[type];
+	if (!tree)
+		return 0;
+
+	/* the reference keeps entry->handle valid during writeback */
+	spin_lock(&tree->lock);
+	entry = zswap_entry_find_get(&tree->rbroot, offset);
+	if (!entry) {
+		spin_unlock(&tree->lock);
+		return 0;
+	}
+	if (!entry->length) {
+		/* replaced by a same-value filled page meanwhile */
+		zswap_entry_put(tree, entry);
+		spin_unlock(&tree->lock);
+		return 0;
+	}
+	handle = entry->handle;
+	spin_unlock(&tree->lock);
+
+	ret = zswap_writeback_entry(zswap_pool, handle);
+
+	spin_lock(&tree->lock);
+	zswap_entry_put(tree, entry);
+	spin_unlock(&tree->lock);
+
+	return ret ? 0 : 1;
+}
+
+/*
+ * Writes back cold entries in bounded batches while the pool is above
+ * the background watermark, so that stores rarely find the pool full and
+ * have to write back synchronously from the reclaim path.
+ */
+static int zswap_bg_writeback_thread(void *data)
+{
+	unsigned int i;
+	int ret;
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(zswap_bg_wait,
+				zswap_above_bg_watermark() ||
+				kthread_should_stop());
+
+		for (i = 0; i < zswap_bg_writeback_batch; i++) {
+			if (kthread_should_stop() ||
+			    !zswap_above_bg_watermark())
+				break;
+			ret = zswap_bg_writeback_one();
+			if (ret < 0)
+				break;
+			zswap_bg_written_back_pages += ret;
+			cond_resched();
+		}
+
+		/* let the batch I/O make progress before the next pass */
+		if (zswap_above_bg_watermark())
+			schedule_timeout_interruptible(HZ / 10);
+	}
+
+	return 0;
+}
+
+/*
+ * A page filled with one repeated word (most commonly zero) needs no
+ * compression and no zpool space, only the word is kept in the entry.
+ */
+static int zswap_is_page_same_filled(void *ptr, unsigned long *value)
+{
+	unsigned int pos;
+	unsigned long *page;
+
+	page = (unsigned long *)ptr;
+	for (pos = 1; pos < PAGE_SIZE / sizeof(*page); pos++) {
+		if (page[pos] != page[0])
+			return 0;
+	}
+	*value = page[0];
+	return 1;
+}
+
+static void zswap_fill_page(void *ptr, unsigned long value)
+{
+	unsigned long *page;
+
+	page = (unsigned long *)ptr;
+	if (value == 0)
+		memset(page, 0, PAGE_SIZE);
+	else {
+		unsigned int pos;
+
+		for (pos = 0; pos < PAGE_SIZE / sizeof(*page); pos++)
+			page[pos] = value;
+	}
+}
+
 /*********************************
 * frontswap hooks
 **********************************/
@@ -657,7 +866,7 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	struct zswap_entry *entry, *dupentry;
 	int ret;
 	unsigned int dlen = PAGE_SIZE, len;
-	unsigned long handle;
+	unsigned long handle, value;
 	char *buf;
 	u8 *src, *dst;
 	struct zswap_header *zhdr;
@@ -685,6 +894,20 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 		goto reject;
 	}
 
+	if (zswap_same_filled_pages_enabled) {
+		src = kmap_atomic(page);
+		if (zswap_is_page_same_filled(src, &value)) {
+			kunmap_atomic(src);
+			entry->type = type;
+			entry->offset = offset;
+			entry->length = 0;
+			entry->value = value;
+			atomic_inc(&zswap_same_filled_pages);
+			goto insert_entry;
+		}
+		kunmap_atomic(src);
+	}
+
 	/* compress */
 	dst = get_cpu_var(zswap_dstmem);
 	src = kmap_atomic(page);
@@ -721,10 +944,12 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	put_cpu_var(zswap_dstmem);
 
 	/* populate entry */
+	entry->type = type;
 	entry->offset = offset;
 	entry->handle = handle;
 	entry->length = dlen;
 
+insert_entry:
 	/* map */
 	spin_lock(&tree->lock);
 	do {
@@ -736,12 +961,18 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 			zswap_entry_put(tree, dupentry);
 		}
 	} while (ret == -EEXIST);
+	if (entry->length)
+		zswap_lru_add(entry);
 	spin_unlock(&tree->lock);
 
 	/* update stats */
 	atomic_inc(&zswap_stored_pages);
 	zswap_pool_total_size = zpool_get_total_size(zswap_pool);
 
+	if (zswap_bg_thread && waitqueue_active(&zswap_bg_wait) &&
+	    zswap_above_bg_watermark())
+		wake_up(&zswap_bg_wait);
+
 	return 0;
 
 freepage:
@@ -772,8 +1003,17 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 		spin_unlock(&tree->lock);
 		return -1;
 	}
+	if (entry->length)
+		zswap_lru_rotate(entry);
 	spin_unlock(&tree->lock);
 
+	if (!entry->length) {
+		dst = kmap_atomic(page);
+		zswap_fill_page(dst, entry->value);
+		kunmap_atomic(dst);
+		goto freeentry;
+	}
+
 	/* decompress */
 	dlen = PAGE_SIZE;
 	src = (u8 *)zpool_map_handle(zswap_pool, entry->handle,
@@ -785,6 +1025,7 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 	zpool_unmap_handle(zswap_pool, entry->handle);
 	BUG_ON(ret);
 
+freeentry:
 	spin_lock(&tree->lock);
 	zswap_entry_put(tree, entry);
 	spin_unlock(&tree->lock);
@@ -816,7 +1057,11 @@ static void zswap_frontswap_invalidate_page(unsigned type, pgoff_t offset)
 	spin_unlock(&tree->lock);
 }
 
-/* frees all zswap entries for the given swap type */
+/*
+ * frees all zswap entries for the given swap type
+ * The tree itself is kept and reused by the next swapon of the type, so
+ * the background writeback thread can look it up without locking.
+ */
 static void zswap_frontswap_invalidate_area(unsigned type)
 {
 	struct zswap_tree *tree = zswap_trees[type];
@@ -831,8 +1076,6 @@ static void zswap_frontswap_invalidate_area(unsigned type)
 		zswap_free_entry(entry);
 	tree->rbroot = RB_ROOT;
 	spin_unlock(&tree->lock);
-	kfree(tree);
-	zswap_trees[type] = NULL;
 }
 
 static struct zpool_ops zswap_zpool_ops = {
@@ -843,6 +1086,10 @@ static void zswap_frontswap_init(unsigned type)
 {
 	struct zswap_tree *tree;
 
+	/* emptied by zswap_frontswap_invalidate_area() */
+	if (zswap_trees[type])
+		return;
+
 	tree = kzalloc(sizeof(struct zswap_tree), GFP_KERNEL);
 	if (!tree) {
 		pr_err("alloc failed, zswap disabled for swap type %d\n", type);
@@ -891,12 +1138,16 @@ static int __init zswap_debugfs_init(void)
 			zswap_debugfs_root, &zswap_reject_compress_poor);
 	debugfs_create_u64("written_back_pages", S_IRUGO,
 			zswap_debugfs_root, &zswap_written_back_pages);
+	debugfs_create_u64("bg_written_back_pages", S_IRUGO,
+			zswap_debugfs_root, &zswap_bg_written_back_pages);
 	debugfs_create_u64("duplicate_entry", S_IRUGO,
 			zswap_debugfs_root, &zswap_duplicate_entry);
 	debugfs_create_u64("pool_total_size", S_IRUGO,
 			zswap_debugfs_root, &zswap_pool_total_size);
 	debugfs_create_atomic_t("stored_pages", S_IRUGO,
 			zswap_debugfs_root, &zswap_stored_pages);
+	debugfs_create_atomic_t("same_filled_pages", S_IRUGO,
+			zswap_debugfs_root, &zswap_same_filled_pages);
 
 	return 0;
 }
@@ -955,6 +1206,14 @@ static int __init init_zswap(void)
 	}
 
 	frontswap_register_ops(&zswap_frontswap_ops);
+
+	zswap_bg_thread = kthread_run(zswap_bg_writeback_thread, NULL,
+				      "zswap_wb");
+	if (IS_ERR(zswap_bg_thread)) {
+		pr_warn("background writeback thread creation failed\n");
+		zswap_bg_thread = NULL;
+	}
+
 	if (zswap_debugfs_init())
 		pr_warn("debugfs initialization failed\n");
 	return 0;
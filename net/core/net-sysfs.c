@@ -561,37 +561,22 @@ static ssize_t show_rps_map(struct netdev_rx_queue *queue,
 	return len;
 }
 
-static ssize_t store_rps_map(struct netdev_rx_queue *queue,
-		      struct rx_queue_attribute *attribute,
-		      const char *buf, size_t len)
+/* Sets the RPS map of @queue to the cpus of @mask that are in @cpus */
+static int set_rps_map(struct netdev_rx_queue *queue,
+		       const struct cpumask *mask, const struct cpumask *cpus)
 {
 	struct rps_map *old_map, *map;
-	cpumask_var_t mask;
-	int err, cpu, i;
+	int cpu, i;
 	static DEFINE_SPINLOCK(rps_map_lock);
 
-	if (!capable(CAP_NET_ADMIN))
-		return -EPERM;
-
-	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
-		return -ENOMEM;
-
-	err = bitmap_parse(buf, len, cpumask_bits(mask), nr_cpumask_bits);
-	if (err) {
-		free_cpumask_var(mask);
-		return err;
-	}
-
 	map = kzalloc(max_t(unsigned,
 	    RPS_MAP_SIZE(cpumask_weight(mask)), L1_CACHE_BYTES),
 	    GFP_KERNEL);
-	if (!map) {
-		free_cpumask_var(mask);
+	if (!map)
 		return -ENOMEM;
-	}
 
 	i = 0;
-	for_each_cpu_and(cpu, mask, cpu_online_mask)
+	for_each_cpu_and(cpu, mask, cpus)
 		map->cpus[i++] = cpu;
 
 	if (i)
@@ -613,10 +598,46 @@ static ssize_t store_rps_map(struct netdev_rx_queue *queue,
 		kfree_rcu(old_map, rcu);
 		static_key_slow_dec(&rps_needed);
 	}
+	return 0;
+}
+
+static ssize_t store_rps_map(struct netdev_rx_queue *queue,
+		      struct rx_queue_attribute *attribute,
+		      const char *buf, size_t len)
+{
+	cpumask_var_t mask;
+	int err;
+
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
+		return -ENOMEM;
+
+	err = bitmap_parse(buf, len, cpumask_bits(mask), nr_cpumask_bits);
+	if (!err)
+		err = set_rps_map(queue, mask, cpu_online_mask);
+
 	free_cpumask_var(mask);
-	return len;
+	return err ? err : len;
 }
 
+/*
+ * RPS map of the receive queues of each new device but loopback, from
+ * rps_default_mask= on the command line. It takes the possible cpus, the
+ * packets of a cpu that is offline go to the receiving cpu.
+ */
+static struct cpumask rps_default_mask;
+
+static int __init rps_default_mask_setup(char *str)
+{
+	if (bitmap_parse(str, strlen(str), cpumask_bits(&rps_default_mask),
+			 nr_cpumask_bits))
+		cpumask_clear(&rps_default_mask);
+	return 1;
+}
+__setup("rps_default_mask=", rps_default_mask_setup);
+
 static ssize_t show_rps_dev_flow_table_cnt(struct netdev_rx_queue *queue,
 					   struct rx_queue_attribute *attr,
 					   char *buf)
@@ -766,6 +787,9 @@ static int rx_queue_add_kobject(struct net_device *net, int index)
 		return error;
 	}
 
+	if (!cpumask_empty(&rps_default_mask) && !(net->flags & IFF_LOOPBACK))
+		set_rps_map(queue, &rps_default_mask, cpu_possible_mask);
+
 	kobject_uevent(kobj, KOBJ_ADD);
 	dev_hold(queue->dev);
 
@@ -0,0 +1,349 @@
+/*
+ * TCP Cell: delivery rate and minimum RTT based congestion control
+ *
+ * Cellular links (HSPA and the like) have deep, per user buffers in the
+ * base station. Loss based algorithms fill them and the RTT grows to
+ * seconds, while the link does not get any faster. Cell instead models
+ * the path with two numbers:
+ *
+ *  o the delivery rate, the maximum of the packets acked per round trip
+ *    over the last CELL_BW_ROUNDS rounds,
+ *  o the minimum RTT over the last CELL_MIN_RTT_WIN,
+ *
+ * and keeps cwnd at their product, the bandwidth delay product, times a
+ * gain. This is the model of BBR, without pacing: 3.4 has no pacing in
+ * tcp_output.c, so the gains are applied to cwnd only.
+ *
+ *  o STARTUP grows cwnd by the packets acked, as slow start, until the
+ *    delivery rate stops growing for three rounds or the RTT of a round
+ *    goes over rtt_limit percent of the minimum.
+ *  o DRAIN sets cwnd to the BDP until the queue built in STARTUP drains.
+ *  o PROBE_BW cycles through the gains of cell_cycle_gain, one round each,
+ *    to find more bandwidth and drain the queue probing built. A round
+ *    with a high RTT skips to the draining phase, that is the latency
+ *    based backoff.
+ *  o PROBE_RTT drops cwnd to CELL_MIN_CWND for CELL_PROBE_RTT_MS when the
+ *    minimum RTT has not been seen for CELL_MIN_RTT_WIN, so a minimum
+ *    taken before the buffers filled is measured again.
+ *
+ * Losses are left to the recovery of Linux. ssthresh is not taken below
+ * the BDP, and cwnd goes back to the model once recovery is over.
+ */
+
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/skbuff.h>
+#include <linux/inet_diag.h>
+
+#include <net/tcp.h>
+
+/* Gains are fixed point with CELL_SCALE bits, bandwidth with BW_SCALE */
+#define CELL_SCALE		8
+#define CELL_UNIT		(1 << CELL_SCALE)
+#define BW_SCALE		24
+
+#define CELL_BW_ROUNDS		3
+#define CELL_MIN_RTT_WIN	(10 * HZ)
+#define CELL_PROBE_RTT_MS	200
+#define CELL_MIN_CWND		4
+#define CELL_FULL_BW_ROUNDS	3
+#define CELL_CYCLE_LEN		8
+
+enum cell_mode {
+	CELL_STARTUP,
+	CELL_DRAIN,
+	CELL_PROBE_BW,
+	CELL_PROBE_RTT,
+};
+
+static const u32 cell_cycle_gain[CELL_CYCLE_LEN] = {
+	CELL_UNIT * 5 / 4, CELL_UNIT * 3 / 4,
+	CELL_UNIT, CELL_UNIT, CELL_UNIT, CELL_UNIT, CELL_UNIT, CELL_UNIT,
+};
+
+static int cwnd_gain __read_mostly = CELL_UNIT * 3 / 2;
+static int rtt_limit __read_mostly = 150;
+
+module_param(cwnd_gain, int, 0644);
+MODULE_PARM_DESC(cwnd_gain, "cwnd in BDPs, scaled by 256");
+module_param(rtt_limit, int, 0644);
+MODULE_PARM_DESC(rtt_limit, "RTT of a round, in percent of the minimum, "
+		 "that stops probing");
+
+struct cell {
+	u32	min_rtt_us;	/* minimum RTT of the window */
+	u32	min_rtt_stamp;	/* jiffies the minimum was taken */
+	u32	round_rtt_us;	/* minimum RTT of this round */
+	u32	round_start_us;	/* start of this round */
+	u32	round_end_seq;	/* snd_nxt at the start of this round */
+	u32	delivered;	/* packets acked in this round */
+	u32	bw[CELL_BW_ROUNDS];	/* delivery rate of the last rounds */
+	u32	full_bw;	/* delivery rate STARTUP last grew to */
+	u32	prior_cwnd;	/* cwnd before PROBE_RTT */
+	u32	probe_rtt_done;	/* jiffies PROBE_RTT ends, 0 until drained */
+	u16	acked;		/* packets acked since cong_avoid */
+	u8	mode;
+	u8	cycle_idx;
+	u8	bw_idx;
+	u8	full_bw_cnt;
+	u8	cwnd_limited;	/* this round was limited by cwnd */
+};
+
+static inline u32 cell_now_us(void)
+{
+	return (u32)ktime_to_us(ktime_get());
+}
+
+static u32 cell_max_bw(const struct cell *ca)
+{
+	u32 bw = 0;
+	int i;
+
+	for (i = 0; i < CELL_BW_ROUNDS; i++)
+		bw = max(bw, ca->bw[i]);
+	return bw;
+}
+
+/* The bandwidth delay product times @gain, in packets */
+static u32 cell_target_cwnd(struct sock *sk, u32 gain)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+	const struct cell *ca = inet_csk_ca(sk);
+	u32 bw = cell_max_bw(ca);
+	u64 bdp;
+
+	if (!bw || ca->min_rtt_us == ~0U)
+		return tp->snd_cwnd;
+
+	bdp = (u64)bw * ca->min_rtt_us;
+	bdp = ((bdp >> CELL_SCALE) * gain) >> BW_SCALE;
+	bdp = ((bdp * cwnd_gain) >> CELL_SCALE) + 1;
+
+	return max_t(u32, min_t(u64, bdp, tp->snd_cwnd_clamp), CELL_MIN_CWND);
+}
+
+static bool cell_rtt_high(const struct cell *ca)
+{
+	if (ca->min_rtt_us == ~0U || ca->round_rtt_us == ~0U)
+		return false;
+	return (u64)ca->round_rtt_us * 100 > (u64)ca->min_rtt_us * rtt_limit;
+}
+
+static void cell_start_round(struct sock *sk, u32 now)
+{
+	struct cell *ca = inet_csk_ca(sk);
+
+	ca->round_start_us = now;
+	ca->round_end_seq = tcp_sk(sk)->snd_nxt;
+	ca->round_rtt_us = ~0U;
+	ca->delivered = 0;
+	ca->cwnd_limited = 0;
+}
+
+static void cell_end_round(struct sock *sk)
+{
+	struct cell *ca = inet_csk_ca(sk);
+	u32 now = cell_now_us();
+	u32 interval = now - ca->round_start_us;
+	u32 max_bw = cell_max_bw(ca);
+	bool rtt_high = cell_rtt_high(ca);
+	u32 bw;
+
+	if (interval && ca->delivered) {
+		bw = div_u64((u64)ca->delivered << BW_SCALE, interval);
+		/* A round the application limited only counts if faster */
+		if (ca->cwnd_limited || bw > max_bw) {
+			ca->bw_idx = (ca->bw_idx + 1) % CELL_BW_ROUNDS;
+			ca->bw[ca->bw_idx] = bw;
+			max_bw = cell_max_bw(ca);
+		}
+	}
+
+	switch (ca->mode) {
+	case CELL_STARTUP:
+		if ((u64)max_bw * 4 >= (u64)ca->full_bw * 5) {
+			ca->full_bw = max_bw;
+			ca->full_bw_cnt = 0;
+		} else {
+			ca->full_bw_cnt++;
+		}
+		if (ca->full_bw_cnt >= CELL_FULL_BW_ROUNDS || rtt_high) {
+			ca->full_bw_cnt = CELL_FULL_BW_ROUNDS;
+			ca->mode = CELL_DRAIN;
+		}
+		break;
+	case CELL_PROBE_BW:
+		if (rtt_high)
+			ca->cycle_idx = 1;
+		else
+			ca->cycle_idx = (ca->cycle_idx + 1) % CELL_CYCLE_LEN;
+		break;
+	}
+
+	cell_start_round(sk, now);
+}
+
+static void tcp_cell_init(struct sock *sk)
+{
+	struct cell *ca = inet_csk_ca(sk);
+
+	memset(ca, 0, sizeof(*ca));
+	ca->min_rtt_us = ~0U;
+	ca->min_rtt_stamp = tcp_time_stamp;
+	ca->mode = CELL_STARTUP;
+	cell_start_round(sk, cell_now_us());
+}
+
+static void tcp_cell_pkts_acked(struct sock *sk, u32 num_acked, s32 rtt_us)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+	struct cell *ca = inet_csk_ca(sk);
+
+	ca->delivered += num_acked;
+	ca->acked = min_t(u32, ca->acked + num_acked, 0xffff);
+
+	if (rtt_us > 0) {
+		if ((u32)rtt_us < ca->round_rtt_us)
+			ca->round_rtt_us = rtt_us;
+		if ((u32)rtt_us <= ca->min_rtt_us) {
+			ca->min_rtt_us = rtt_us;
+			ca->min_rtt_stamp = tcp_time_stamp;
+		}
+	}
+
+	if (after(tp->snd_una, ca->round_end_seq))
+		cell_end_round(sk);
+}
+
+static void cell_probe_rtt(struct sock *sk, u32 in_flight)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct cell *ca = inet_csk_ca(sk);
+
+	tp->snd_cwnd = CELL_MIN_CWND;
+
+	if (!ca->probe_rtt_done) {
+		if (in_flight <= CELL_MIN_CWND)
+			ca->probe_rtt_done = (tcp_time_stamp +
+				msecs_to_jiffies(CELL_PROBE_RTT_MS)) | 1;
+		return;
+	}
+
+	if (after(tcp_time_stamp, ca->probe_rtt_done)) {
+		ca->min_rtt_stamp = tcp_time_stamp;
+		ca->mode = ca->full_bw_cnt < CELL_FULL_BW_ROUNDS ?
+				CELL_STARTUP : CELL_PROBE_BW;
+		tp->snd_cwnd = max(ca->prior_cwnd, (u32)CELL_MIN_CWND);
+	}
+}
+
+static void tcp_cell_cong_avoid(struct sock *sk, u32 ack, u32 in_flight)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct cell *ca = inet_csk_ca(sk);
+	u32 acked = ca->acked;
+	u32 target;
+
+	ca->acked = 0;
+	if (tcp_is_cwnd_limited(sk, in_flight))
+		ca->cwnd_limited = 1;
+
+	if (ca->mode != CELL_PROBE_RTT &&
+	    after(tcp_time_stamp, ca->min_rtt_stamp + CELL_MIN_RTT_WIN)) {
+		ca->prior_cwnd = tp->snd_cwnd;
+		ca->probe_rtt_done = 0;
+		ca->mode = CELL_PROBE_RTT;
+	}
+
+	switch (ca->mode) {
+	case CELL_STARTUP:
+		if (ca->cwnd_limited)
+			tp->snd_cwnd = min(tp->snd_cwnd + acked,
+					   tp->snd_cwnd_clamp);
+		return;
+	case CELL_DRAIN:
+		target = cell_target_cwnd(sk, CELL_UNIT);
+		tp->snd_cwnd = target;
+		if (in_flight <= target) {
+			ca->mode = CELL_PROBE_BW;
+			ca->cycle_idx = 2;
+		}
+		return;
+	case CELL_PROBE_BW:
+		target = cell_target_cwnd(sk, cell_cycle_gain[ca->cycle_idx]);
+		if (tp->snd_cwnd < target)
+			tp->snd_cwnd = min(tp->snd_cwnd + acked, target);
+		else
+			tp->snd_cwnd = target;
+		return;
+	case CELL_PROBE_RTT:
+		cell_probe_rtt(sk, in_flight);
+		return;
+	}
+}
+
+static u32 tcp_cell_ssthresh(struct sock *sk)
+{
+	struct cell *ca = inet_csk_ca(sk);
+
+	/* A loss in STARTUP means the pipe is full */
+	if (ca->mode == CELL_STARTUP) {
+		ca->full_bw_cnt = CELL_FULL_BW_ROUNDS;
+		ca->mode = CELL_DRAIN;
+	}
+
+	return max(tcp_reno_ssthresh(sk), cell_target_cwnd(sk, CELL_UNIT));
+}
+
+static void tcp_cell_get_info(struct sock *sk, u32 ext, struct sk_buff *skb)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+	const struct cell *ca = inet_csk_ca(sk);
+
+	if (ext & (1 << (INET_DIAG_CELLINFO - 1))) {
+		u64 bw = (u64)cell_max_bw(ca) * tp->mss_cache * USEC_PER_SEC;
+		struct tcpcell_info info;
+
+		bw >>= BW_SCALE;
+		info.tcpc_mode = ca->mode;
+		info.tcpc_bw_lo = (u32)bw;
+		info.tcpc_bw_hi = (u32)(bw >> 32);
+		info.tcpc_min_rtt = ca->min_rtt_us;
+		info.tcpc_rtt = ca->round_rtt_us;
+		info.tcpc_bdp = cell_target_cwnd(sk, CELL_UNIT);
+		info.tcpc_gain = ca->mode == CELL_PROBE_BW ?
+				cell_cycle_gain[ca->cycle_idx] : CELL_UNIT;
+
+		nla_put(skb, INET_DIAG_CELLINFO, sizeof(info), &info);
+	}
+}
+
+static struct tcp_congestion_ops tcp_cell __read_mostly = {
+	.flags		= TCP_CONG_RTT_STAMP,
+	.init		= tcp_cell_init,
+	.ssthresh	= tcp_cell_ssthresh,
+	.cong_avoid	= tcp_cell_cong_avoid,
+	.min_cwnd	= tcp_reno_min_cwnd,
+	.pkts_acked	= tcp_cell_pkts_acked,
+	.get_info	= tcp_cell_get_info,
+
+	.owner		= THIS_MODULE,
+	.name		= "cell",
+};
+
+static int __init tcp_cell_register(void)
+{
+	BUILD_BUG_ON(sizeof(struct cell) > ICSK_CA_PRIV_SIZE);
+	return tcp_register_congestion_control(&tcp_cell);
+}
+
+static void __exit tcp_cell_unregister(void)
+{
+	tcp_unregister_congestion_control(&tcp_cell);
+}
+
+module_init(tcp_cell_register);
+module_exit(tcp_cell_unregister);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("TCP Cell");
@@ -0,0 +1,259 @@
+#!/usr/bin/perl
+#
+# Attributes the size of vmlinux and the time of its initcalls to the
+# Kconfig symbols and the directories the code is built for, and lists
+# the built-in code of tristate symbols, which could be built as modules.
+#
+# Usage, from the object tree after a build:
+#	scripts/sizereport.pl srctree [initcalls]
+#
+# initcalls is the boottime/initcalls debugfs file of a boot of the image,
+# or the log of a boot with initcall_debug. $NM and $SIZE name the tools
+# of the toolchain the image was built with.
+#
+# Only the objects of the built-in.o files and the head objects are
+# counted, the objects vmlinux takes from lib.a archives are not.
+#
+# The report is one line per entry, sorted by size:
+#	<section> <name> text data bss init_usecs objects
+
+use strict;
+
+my $srctree = shift || '.';
+my $initcalls = shift;
+my $nm = $ENV{'NM'} || 'nm';
+my $size = $ENV{'SIZE'} || 'size';
+
+my %config;		# CONFIG_ symbol => value in .config
+my %tristate;		# symbol => 1 if tristate
+my %makefile;		# directory => { "name.o" or "sub/" => symbol }
+my %dirsym;		# directory => symbol
+my %objsize;		# object => [ text, data, bss ]
+my %func;		# function => object
+my %objtime;		# object => initcall usecs
+
+sub read_config
+{
+	open(my $fh, '<', '.config') or die "sizereport: no .config\n";
+	while (<$fh>) {
+		$config{$1} = $2 if /^CONFIG_(\w+)=(.*)/;
+	}
+	close($fh);
+}
+
+sub read_kconfig
+{
+	my $sym;
+
+	open(my $find, '-|', "find $srctree -name 'Kconfig*' " .
+			    "-not -path '*/.git/*'") or die;
+	while (my $file = <$find>) {
+		chomp($file);
+		open(my $fh, '<', $file) or next;
+		while (<$fh>) {
+			if (/^\s*(?:menu)?config\s+(\w+)/) {
+				$sym = $1;
+			} elsif (/^\s*(?:tristate|def_tristate)\b/ && $sym) {
+				$tristate{$sym} = 1;
+			} elsif (/^\s*(?:choice|endchoice|menu|endmenu|if|endif)\b/) {
+				$sym = undef;
+			}
+		}
+		close($fh);
+	}
+	close($find);
+}
+
+# The symbols of the objects and subdirectories a kbuild Makefile builds in
+sub read_makefile
+{
+	my ($dir) = @_;
+	my %entries;
+	my $line = '';
+
+	return $makefile{$dir} if exists $makefile{$dir};
+
+	foreach my $name ('Kbuild', 'Makefile') {
+		open(my $fh, '<', "$srctree/$dir/$name") or next;
+		while (<$fh>) {
+			chomp;
+			$line .= $_;
+			next if $line =~ s/\\$/ /;
+			if ($line =~ /^\s*[\w-]+-(?:\$\(CONFIG_(\w+)\)|y)\s*[:+]?=\s*(.*)/) {
+				my $sym = $1;
+				foreach my $token (split(/\s+/, $2)) {
+					next if $token eq '' || $token =~ /\$/;
+					$token =~ s/^\.\///;
+					$entries{$token} = $sym
+					    if $sym || !exists $entries{$token};
+				}
+			}
+			$line = '';
+		}
+		close($fh);
+		last;
+	}
+
+	$makefile{$dir} = \%entries;
+	return \%entries;
+}
+
+# Symbol a directory is built for, from the Makefile that descends into it
+sub dir_symbol
+{
+	my ($dir) = @_;
+	my $sym;
+
+	return $dirsym{$dir} if exists $dirsym{$dir};
+
+	if ($dir =~ m|^(.*)/([^/]+)$|) {
+		my ($parent, $base) = ($1, $2);
+		$sym = read_makefile($parent)->{"$base/"};
+		$sym = dir_symbol($parent) if !$sym;
+	} else {
+		# Top level directories come from the top and arch Makefiles
+		$sym = read_makefile('.')->{"$dir/"};
+	}
+	if (!$sym && $dir =~ m|^arch/[^/]+/.|) {
+		my ($arch) = $dir =~ m|^(arch/[^/]+)|;
+		$sym = read_makefile($arch)->{"$dir/"};
+	}
+
+	$dirsym{$dir} = $sym;
+	return $sym;
+}
+
+sub obj_symbol
+{
+	my ($obj) = @_;
+	my ($dir, $base) = $obj =~ m|^(.*)/([^/]+)$|;
+
+	return dir_symbol('.') if !defined $dir;
+	return read_makefile($dir)->{$base} || dir_symbol($dir);
+}
+
+# The objects linked into vmlinux, from the commands of the last link
+sub read_objects
+{
+	my %objs;
+
+	open(my $find, '-|', "find . -name '.built-in.o.cmd' -o " .
+			    "-name '.vmlinux.cmd'") or die;
+	while (my $cmd = <$find>) {
+		chomp($cmd);
+		open(my $fh, '<', $cmd) or next;
+		my $line = <$fh>;
+		close($fh);
+		foreach my $token (split(/\s+/, $line)) {
+			next if $token !~ /\.o$/ || $token =~ /built-in\.o$/ ||
+				$token =~ /\.tmp_/ || $token =~ /^-/;
+			$token =~ s/^\.\///;
+			$objs{$token} = 1 if -f $token;
+		}
+	}
+	close($find);
+
+	return sort keys %objs;
+}
+
+sub read_sizes
+{
+	my @objs = @_;
+
+	while (my @batch = splice(@objs, 0, 200)) {
+		open(my $fh, '-|', $size, @batch) or die "sizereport: $size\n";
+		while (<$fh>) {
+			next if !/^\s*(\d+)\s+(\d+)\s+(\d+)\s+\d+\s+\S+\s+(\S+)/;
+			my $obj = $4;
+			$obj =~ s/^\.\///;
+			$objsize{$obj} = [ $1, $2, $3 ];
+		}
+		close($fh);
+	}
+}
+
+sub read_functions
+{
+	my @objs = @_;
+	my $obj;
+
+	while (my @batch = splice(@objs, 0, 200)) {
+		open(my $fh, '-|', $nm, '--defined-only', '-A', @batch) or
+			die "sizereport: $nm\n";
+		while (<$fh>) {
+			next if !/^(\S+?):\S*\s+[tT]\s+(\S+)$/;
+			$obj = $1;
+			$obj =~ s/^\.\///;
+			$func{$2} = $obj if !exists $func{$2};
+		}
+		close($fh);
+	}
+}
+
+sub read_initcalls
+{
+	open(my $fh, '<', $initcalls) or die "sizereport: no $initcalls\n";
+	while (<$fh>) {
+		my ($fn, $usecs);
+
+		if (/\]\s+(\S+)\s+wall:\s+(\d+)\s+usecs/) {
+			($fn, $usecs) = ($1, $2);
+		} elsif (/initcall\s+(\S+)\s+returned\s+\S+\s+after\s+(\d+)\s+usecs/) {
+			($fn, $usecs) = ($1, $2);
+		} else {
+			next;
+		}
+		$fn =~ s/\+0x.*$//;
+		$objtime{$func{$fn}} += $usecs if exists $func{$fn};
+	}
+	close($fh);
+}
+
+sub add
+{
+	my ($sum, $key, $obj) = @_;
+	my $e = $sum->{$key} ||= [ 0, 0, 0, 0, 0 ];
+
+	$e->[$_] += $objsize{$obj}->[$_] for (0 .. 2);
+	$e->[3] += $objtime{$obj} || 0;
+	$e->[4]++;
+}
+
+sub report
+{
+	my ($section, $sum) = @_;
+
+	foreach my $key (sort { $sum->{$b}->[0] + $sum->{$b}->[1] <=>
+				$sum->{$a}->[0] + $sum->{$a}->[1] } keys %$sum) {
+		printf("%s %s %d %d %d %d %d\n", $section, $key,
+		       @{$sum->{$key}});
+	}
+}
+
+read_config();
+read_kconfig();
+my @objs = read_objects();
+die "sizereport: no objects, build vmlinux first\n" if !@objs;
+read_sizes(@objs);
+if ($initcalls) {
+	read_functions(@objs);
+	read_initcalls();
+}
+
+my (%bysym, %bydir, %modular, %total);
+foreach my $obj (grep { exists $objsize{$_} } @objs) {
+	my $sym = obj_symbol($obj);
+	my ($dir) = $obj =~ m|^(.*)/|;
+
+	add(\%total, 'vmlinux', $obj);
+	add(\%bysym, $sym ? "CONFIG_$sym" : 'always', $obj);
+	add(\%bydir, $dir || '.', $obj);
+	add(\%modular, "CONFIG_$sym", $obj)
+		if $sym && $tristate{$sym} && ($config{$sym} || '') eq 'y';
+}
+
+print "# section name text data bss init_usecs objects\n";
+report('total', \%total);
+report('symbol', \%bysym);
+report('dir', \%bydir);
+report('modular', \%modular);
@@ -52,6 +52,20 @@ static struct platform_device ux500_pcm = {
 		},
 };
 
+#ifdef CONFIG_SND_SOC_UX500_AB8500
+static struct ux500_pcm_platform_data ux500_pcm_deep_buffer_data = {
+		.deep_buffer = true,
+};
+
+static struct platform_device ux500_pcm_deep_buffer = {
+		.name = "ux500-pcm",
+		.id = 1,
+		.dev = {
+			.platform_data = &ux500_pcm_deep_buffer_data,
+		},
+};
+#endif
+
 #ifdef CONFIG_SND_SOC_UX500_AV8100
 static struct platform_device av8100_codec = {
 		.name = "av8100-codec",
@@ -225,6 +239,23 @@ struct snd_soc_dai_link u8500_dai_links[] = {
 	.ops = ux500_gen_msp0_ops,
 	},
 	#endif
+	#ifdef CONFIG_SND_SOC_UX500_AB8500
+	/*
+	 * Deep buffer playback on the DAIs of ab8500_0. Last, as the device
+	 * numbers of the other links are known by userspace. Only one of the
+	 * two plays at a time, the MSP takes a single playback stream.
+	 */
+	{
+	.name = "ab8500_0_deep_buffer",
+	.stream_name = "ab8500_0_deep_buffer",
+	.cpu_dai_name = "ux500-msp-i2s.1",
+	.codec_dai_name = "ab8500-codec-dai.0",
+	.platform_name = "ux500-pcm.1",
+	.codec_name = "ab8500-codec.0",
+	.init = NULL,
+	.ops = ux500_ab8500_ops,
+	},
+	#endif
 };
 
 static struct snd_soc_card u8500_drvdata = {
@@ -267,6 +298,9 @@ static int __init u8500_soc_init(void)
 	pr_debug("%s: Register device to generate a probe for Ux500-pcm platform.\n",
 		__func__);
 	platform_device_register(&ux500_pcm);
+	#ifdef CONFIG_SND_SOC_UX500_AB8500
+	platform_device_register(&ux500_pcm_deep_buffer);
+	#endif
 
 	pr_debug("%s: Allocate platform device 'soc-audio'.\n",
 		__func__);
@@ -292,6 +326,7 @@ static int __init u8500_soc_init(void)
 		u8500_drvdata.name);
 	platform_set_drvdata(u8500_platform_dev, &u8500_drvdata);
 	u8500_drvdata.dev = &u8500_platform_dev->dev;
+	device_enable_async_suspend(&u8500_platform_dev->dev);
 
 	pr_debug("%s: Card %s: Add platform device.\n",
 		__func__,
@@ -14,10 +14,15 @@
 
 #include <asm/page.h>
 
+#include <linux/debugfs.h>
 #include <linux/dma-mapping.h>
 #include <linux/dmaengine.h>
 #include <linux/dma-mapping.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/workqueue.h>
 
 #include <plat/ste_dma40.h>
@@ -28,6 +33,40 @@
 
 #include "ux500_pcm.h"
 
+/*
+ * Number of playback periods completed per DMA interrupt. Raising it lets
+ * the CPU sleep through several periods of low-power (deep buffer)
+ * playback, the application is then woken once per interrupt. Only used
+ * for buffers of at least twice as many periods, which are a multiple of it.
+ */
+static unsigned int playback_periods_per_irq = 1;
+module_param(playback_periods_per_irq, uint, 0644);
+MODULE_PARM_DESC(playback_periods_per_irq,
+		 "Playback periods completed per DMA interrupt");
+
+/*
+ * Streams with periods of at most fast_period_ms are served with the least
+ * latency, for games and touch sounds: the periods are completed from the
+ * DMA interrupt handler instead of its tasklet, and the channel has realtime
+ * priority on the bus. 0 disables it.
+ */
+static unsigned int fast_period_ms = 5;
+module_param(fast_period_ms, uint, 0644);
+MODULE_PARM_DESC(fast_period_ms, "Longest period in ms of fast streams");
+
+/* Timing of the period interrupts of the last stream of each direction */
+struct ux500_pcm_latency {
+	bool fast;
+	unsigned int period_us;
+	unsigned int buffer_us;
+	unsigned int irqs;
+	unsigned int late_max_us;
+	unsigned int late_sum_us;
+};
+
+static struct ux500_pcm_latency pcm_latency[2];
+static DEFINE_SPINLOCK(pcm_latency_lock);
+
 static struct snd_pcm_hardware ux500_pcm_hw_playback = {
 	.info = SNDRV_PCM_INFO_INTERLEAVED |
 		SNDRV_PCM_INFO_MMAP |
@@ -72,6 +111,36 @@ static struct snd_pcm_hardware ux500_pcm_hw_capture = {
 	.periods_max = UX500_PLATFORM_PERIODS_MAX,
 };
 
+static struct snd_pcm_hardware ux500_pcm_hw_deep_buffer = {
+	.info = SNDRV_PCM_INFO_INTERLEAVED |
+		SNDRV_PCM_INFO_MMAP |
+		SNDRV_PCM_INFO_RESUME |
+		SNDRV_PCM_INFO_PAUSE,
+	.formats = SNDRV_PCM_FMTBIT_S16_LE |
+		SNDRV_PCM_FMTBIT_U16_LE |
+		SNDRV_PCM_FMTBIT_S16_BE |
+		SNDRV_PCM_FMTBIT_U16_BE |
+		SNDRV_PCM_FMTBIT_S32_LE,
+	.rates = SNDRV_PCM_RATE_KNOT,
+	.rate_min = UX500_PLATFORM_MIN_RATE_PLAYBACK,
+	.rate_max = UX500_PLATFORM_MAX_RATE_PLAYBACK,
+	.channels_min = UX500_PLATFORM_MIN_CHANNELS,
+	.channels_max = UX500_PLATFORM_MAX_CHANNELS,
+	.buffer_bytes_max = UX500_PLATFORM_BUFFER_BYTES_MAX,
+	.period_bytes_min = UX500_PLATFORM_DEEP_PERIODS_BYTES_MIN,
+	.period_bytes_max = UX500_PLATFORM_PERIODS_BYTES_MAX,
+	.periods_min = UX500_PLATFORM_PERIODS_MIN,
+	.periods_max = UX500_PLATFORM_DEEP_PERIODS_MAX,
+};
+
+static bool is_deep_buffer(struct snd_soc_platform *platform)
+{
+	struct ux500_pcm_platform_data *pdata =
+		dev_get_platdata(platform->dev);
+
+	return pdata != NULL && pdata->deep_buffer;
+}
+
 static const char *stream_str(struct snd_pcm_substream *substream)
 {
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
@@ -80,6 +149,49 @@ static const char *stream_str(struct snd_pcm_substream *substream)
 		return "Capture";
 }
 
+static void ux500_pcm_latency_start(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct ux500_pcm_private *private = runtime->private_data;
+	struct ux500_pcm_latency *latency = &pcm_latency[substream->stream];
+	unsigned long flags;
+
+	spin_lock_irqsave(&pcm_latency_lock, flags);
+	memset(latency, 0, sizeof(*latency));
+	latency->fast = private->fast;
+	latency->period_us = div_u64((u64)runtime->period_size * USEC_PER_SEC,
+				     runtime->rate);
+	latency->buffer_us = div_u64((u64)runtime->buffer_size * USEC_PER_SEC,
+				     runtime->rate);
+	spin_unlock_irqrestore(&pcm_latency_lock, flags);
+
+	private->last_period = ktime_get();
+}
+
+/* How late the interrupt is, compared to the period time */
+static void ux500_pcm_latency_account(struct snd_pcm_substream *substream)
+{
+	struct ux500_pcm_private *private = substream->runtime->private_data;
+	struct ux500_pcm_latency *latency = &pcm_latency[substream->stream];
+	ktime_t now = ktime_get();
+	unsigned int interval_us, expected_us;
+	unsigned int late_us = 0;
+	unsigned long flags;
+
+	interval_us = ktime_us_delta(now, private->last_period);
+	private->last_period = now;
+
+	spin_lock_irqsave(&pcm_latency_lock, flags);
+	expected_us = latency->period_us * private->periods_per_irq;
+	if (interval_us > expected_us)
+		late_us = interval_us - expected_us;
+	latency->irqs++;
+	latency->late_sum_us += late_us;
+	if (late_us > latency->late_max_us)
+		latency->late_max_us = late_us;
+	spin_unlock_irqrestore(&pcm_latency_lock, flags);
+}
+
 static void
 ux500_pcm_dma_eot_handler(void *data)
 {
@@ -99,10 +211,12 @@ ux500_pcm_dma_eot_handler(void *data)
 
 		/* calc the offset in the circular buffer */
 		private->offset += frames_to_bytes(runtime,
-				runtime->period_size);
+				runtime->period_size) * private->periods_per_irq;
 		private->offset %= frames_to_bytes(runtime,
 				runtime->period_size) * runtime->periods;
 
+		ux500_pcm_latency_account(substream);
+
 		snd_pcm_period_elapsed(substream);
 	}
 }
@@ -206,17 +320,25 @@ static int ux500_pcm_open(struct snd_pcm_substream *substream)
 	struct ux500_pcm_private *private;
 	struct snd_soc_pcm_runtime *rtd = substream->private_data;
 	struct snd_soc_dai *dai = rtd->cpu_dai;
+	struct snd_pcm_hardware *hw;
 	int ret;
 
 	pr_debug("%s: MSP %d (%s): Enter.\n", __func__,
 		dai->id,
 		stream_str(substream));
 
+	if (is_deep_buffer(rtd->platform)) {
+		if (stream_id != SNDRV_PCM_STREAM_PLAYBACK)
+			return -ENODEV;
+		hw = &ux500_pcm_hw_deep_buffer;
+	} else if (stream_id == SNDRV_PCM_STREAM_PLAYBACK) {
+		hw = &ux500_pcm_hw_playback;
+	} else {
+		hw = &ux500_pcm_hw_capture;
+	}
+
 	pr_debug("%s: Set runtime hwparams.\n", __func__);
-	if (stream_id == SNDRV_PCM_STREAM_PLAYBACK)
-		snd_soc_set_runtime_hwparams(substream, &ux500_pcm_hw_playback);
-	else
-		snd_soc_set_runtime_hwparams(substream, &ux500_pcm_hw_capture);
+	snd_soc_set_runtime_hwparams(substream, hw);
 
 	/* ensure that buffer size is a multiple of period size */
 	ret = snd_pcm_hw_constraint_integer(
@@ -244,8 +366,7 @@ static int ux500_pcm_open(struct snd_pcm_substream *substream)
 		__func__,
 		stream_str(substream));
 
-	runtime->hw = (stream_id == SNDRV_PCM_STREAM_PLAYBACK) ?
-		ux500_pcm_hw_playback : ux500_pcm_hw_capture;
+	runtime->hw = *hw;
 
 	return 0;
 }
@@ -379,13 +500,26 @@ ux500_pcm_prepare(struct snd_pcm_substream *substream)
 
 	dma_cfg = dma_params->dma_cfg;
 
+	private->fast = runtime->period_size * 1000 <=
+			fast_period_ms * runtime->rate;
+
+	private->periods_per_irq = 1;
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+		unsigned int n = playback_periods_per_irq;
+
 		dma_cfg->src_info.data_width = mem_data_width;
 		dma_cfg->dst_info.data_width = per_data_width;
+
+		if (!private->fast && n > 1 && runtime->periods >= 2 * n &&
+				runtime->periods % n == 0)
+			private->periods_per_irq = n;
 	} else {
 		dma_cfg->src_info.data_width = per_data_width;
 		dma_cfg->dst_info.data_width = mem_data_width;
 	}
+	dma_cfg->periods_per_irq = private->periods_per_irq;
+	dma_cfg->realtime = private->fast;
+	dma_cfg->cyclic_irq_callback = private->fast;
 
 	dma_cap_zero(mask);
 	dma_cap_set(DMA_SLAVE, mask);
@@ -415,6 +549,7 @@ ux500_pcm_trigger(struct snd_pcm_substream *substream, int cmd)
 		}
 
 		private->offset = 0;
+		ux500_pcm_latency_start(substream);
 		ret = ux500_pcm_dma_start(
 				substream,
 				runtime->dma_addr,
@@ -488,10 +623,15 @@ int ux500_pcm_new(struct snd_card *card,
 		struct snd_soc_dai *dai,
 		struct snd_pcm *pcm)
 {
+	struct snd_soc_pcm_runtime *rtd = pcm->private_data;
+
 	pr_debug("%s: pcm = %d\n", __func__, (int)pcm);
 
 	pcm->info_flags = 0;
-	strcpy(pcm->name, "UX500_PCM");
+	if (is_deep_buffer(rtd->platform))
+		strcpy(pcm->name, "UX500_PCM_DEEP_BUFFER");
+	else
+		strcpy(pcm->name, "UX500_PCM");
 
 	pr_debug("%s: pcm->name = %s.\n", __func__, pcm->name);
 
@@ -526,6 +666,56 @@ struct snd_soc_platform_driver ux500_pcm_soc_drv = {
 };
 EXPORT_SYMBOL(ux500_pcm_soc_drv);
 
+#ifdef CONFIG_DEBUG_FS
+static struct dentry *ux500_pcm_debugfs;
+
+static int ux500_pcm_latency_show(struct seq_file *s, void *unused)
+{
+	struct ux500_pcm_latency latency[2];
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&pcm_latency_lock, flags);
+	memcpy(latency, pcm_latency, sizeof(latency));
+	spin_unlock_irqrestore(&pcm_latency_lock, flags);
+
+	for (i = 0; i < ARRAY_SIZE(latency); i++) {
+		struct ux500_pcm_latency *l = &latency[i];
+
+		seq_printf(s, "%s: %s, period %u us, buffer %u us, "
+			"%u irqs, late max %u us avg %u us\n",
+			i == SNDRV_PCM_STREAM_PLAYBACK ? "Playback" : "Capture",
+			l->fast ? "fast" : "normal", l->period_us,
+			l->buffer_us, l->irqs, l->late_max_us,
+			l->irqs ? l->late_sum_us / l->irqs : 0);
+	}
+
+	/*
+	 * Sound played is heard after the playback buffer, sound captured is
+	 * seen after a capture period, both plus the interrupt lateness.
+	 */
+	seq_printf(s, "Round trip: %u us\n",
+		latency[SNDRV_PCM_STREAM_PLAYBACK].buffer_us +
+		latency[SNDRV_PCM_STREAM_PLAYBACK].late_max_us +
+		latency[SNDRV_PCM_STREAM_CAPTURE].period_us +
+		latency[SNDRV_PCM_STREAM_CAPTURE].late_max_us);
+
+	return 0;
+}
+
+static int ux500_pcm_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ux500_pcm_latency_show, NULL);
+}
+
+static const struct file_operations ux500_pcm_latency_fops = {
+	.open = ux500_pcm_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+#endif
+
 static int __devexit ux500_pcm_drv_probe(struct platform_device *pdev)
 {
 	int ret;
@@ -565,6 +755,12 @@ static int __init ux500_pcm_drv_init(void)
 {
 	pr_debug("%s: Register ux500-pcm platform driver.\n", __func__);
 
+#ifdef CONFIG_DEBUG_FS
+	ux500_pcm_debugfs = debugfs_create_file("ux500-pcm-latency", S_IRUGO,
+						snd_soc_debugfs_root, NULL,
+						&ux500_pcm_latency_fops);
+#endif
+
 	return platform_driver_register(&ux500_pcm_driver);
 }
 
@@ -573,6 +769,10 @@ static void __exit ux500_pcm_drv_exit(void)
 	pr_debug("%s: Unregister ux500-pcm platform driver.\n", __func__);
 
 	platform_driver_unregister(&ux500_pcm_driver);
+
+#ifdef CONFIG_DEBUG_FS
+	debugfs_remove(ux500_pcm_debugfs);
+#endif
 }
 
 module_init(ux500_pcm_drv_init);
@@ -15,6 +15,7 @@
 #define UX500_PCM_H
 
 #include <asm/page.h>
+#include <linux/ktime.h>
 #include <linux/workqueue.h>
 
 #define UX500_PLATFORM_MIN_RATE_PLAYBACK 8000
@@ -36,6 +37,17 @@
 #define UX500_PLATFORM_PERIODS_MAX		48
 #define UX500_PLATFORM_BUFFER_BYTES_MAX		(2048 * PAGE_SIZE)
 
+/*
+ * Playback only device for streams that can take a long latency, like music
+ * with the screen off. Long periods let the CPU sleep in between.
+ */
+#define UX500_PLATFORM_DEEP_PERIODS_BYTES_MIN	32768
+#define UX500_PLATFORM_DEEP_PERIODS_MAX		8
+
+struct ux500_pcm_platform_data {
+	bool deep_buffer;
+};
+
 extern struct snd_soc_platform ux500_soc_platform;
 
 struct ux500_pcm_private {
@@ -45,6 +57,9 @@ struct ux500_pcm_private {
 	int msp_id;
 	int stream_id;
 	unsigned int offset;
+	unsigned int periods_per_irq;
+	bool fast;
+	ktime_t last_period;
 };
 
 struct ux500_pcm_dma_params {
@@ -0,0 +1,124 @@
+# display pipeline cpu time per frame
+# Licensed under the terms of the GNU GPL License version 2
+#
+# Splits the time into frames at the vcmp (frame done) events of an MCDE
+# channel, 0 by default, and reports per frame the cpu time spent in the
+# MCDE and DMA40 interrupt handlers, the DMA40 channel tasklets and the
+# B2R2 request stages, and the time B2R2 jobs ran in hardware.
+#
+# perf script only feeds tracepoint samples to python, the cycles and
+# cache misses per frame come from a counting run over the same events:
+#
+#   perf stat -a -e cycles -e cache-misses -e mcde:vcmp sleep 10
+#
+# divided by the number of mcde:vcmp events of the channel.
+
+import os
+import sys
+
+sys.path.append(os.environ['PERF_EXEC_PATH'] + \
+	'/scripts/python/Perf-Trace-Util/lib/Perf/Trace')
+
+from Core import *
+
+usage = "perf script -s display-frames.py [chnl]\n";
+
+for_chnl = 0
+
+if len(sys.argv) > 2:
+	sys.exit(usage)
+
+if len(sys.argv) > 1:
+	for_chnl = int(sys.argv[1])
+
+stages = ["mcde_isr", "d40_isr", "d40_tasklet", "b2r2_resolve",
+	  "b2r2_node_gen", "b2r2_cache_sync", "b2r2_hw"]
+
+frame = dict.fromkeys(stages, 0)
+totals = dict.fromkeys(stages, 0)
+maxima = dict.fromkeys(stages, 0)
+frames = 0
+
+# Start time of the running handler, per cpu and stage
+running = autodict()
+
+def nsecs_of(secs, nsecs):
+	return secs * 1000000000 + nsecs
+
+def stage_begin(stage, cpu, secs, nsecs):
+	running[cpu][stage] = nsecs_of(secs, nsecs)
+
+def stage_end(stage, cpu, secs, nsecs):
+	start = running[cpu][stage]
+	if start:
+		frame[stage] += nsecs_of(secs, nsecs) - start
+		running[cpu][stage] = 0
+
+def trace_end():
+	print "%d frames on channel %d\n" % (frames, for_chnl)
+	if frames == 0:
+		return
+	print "%-16s %12s %12s" % ("stage", "avg_us", "max_us")
+	for stage in stages:
+		print "%-16s %12d %12d" % (stage, totals[stage] / frames / 1000,
+					   maxima[stage] / 1000)
+
+def mcde__vcmp(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	chnl, state):
+	global frames
+	if chnl != for_chnl:
+		return
+	frames += 1
+	for stage in stages:
+		totals[stage] += frame[stage]
+		maxima[stage] = max(maxima[stage], frame[stage])
+		frame[stage] = 0
+
+def mcde__isr(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	ais, begin):
+	if begin:
+		stage_begin("mcde_isr", common_cpu, common_secs, common_nsecs)
+	else:
+		stage_end("mcde_isr", common_cpu, common_secs, common_nsecs)
+
+def dma40__d40_interrupt_entry(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	irq):
+	stage_begin("d40_isr", common_cpu, common_secs, common_nsecs)
+
+def dma40__d40_interrupt_exit(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	irq):
+	stage_end("d40_isr", common_cpu, common_secs, common_nsecs)
+
+def dma40__d40_tasklet_entry(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	chan_id):
+	stage_begin("d40_tasklet", common_cpu, common_secs, common_nsecs)
+
+def dma40__d40_tasklet_exit(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	chan_id):
+	stage_end("d40_tasklet", common_cpu, common_secs, common_nsecs)
+
+def b2r2__b2r2_resolve(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	job, nsec):
+	frame["b2r2_resolve"] += nsec
+
+def b2r2__b2r2_node_gen(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	job, nsec):
+	frame["b2r2_node_gen"] += nsec
+
+def b2r2__b2r2_cache_sync(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	job, nsec):
+	frame["b2r2_cache_sync"] += nsec
+
+def b2r2__b2r2_hw_done(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	job, job_id, nsec_in_hw):
+	frame["b2r2_hw"] += nsec_in_hw
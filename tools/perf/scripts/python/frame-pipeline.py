@@ -0,0 +1,218 @@
+# latency of each stage of a frame, from input to scanout
+# Licensed under the terms of the GNU GPL License version 2
+#
+# Follows each frame composed through compdev, by the frame id of the
+# compdev and mcde:scanout events, and splits its latency into stages:
+#
+#   app      the first input frame since the last frame to the last binder
+#            transaction to SurfaceFlinger, given its pid
+#   gpu      the first Mali job start to the last job done since the last
+#            frame
+#   sf       that binder transaction to the scene of the frame being posted
+#   compose  the scene posted to the frame committed to the MCDE channel
+#   b2r2     the B2R2 jobs of the frame in hardware, during compose
+#   display  the commit to the first VCMP of the frame
+#
+# A vsync is missed when the channel shows the previous frame again while
+# this one is on its way; the stage that took the longest of the frame is
+# counted as the reason.
+
+import os
+import sys
+
+sys.path.append(os.environ['PERF_EXEC_PATH'] + \
+	'/scripts/python/Perf-Trace-Util/lib/Perf/Trace')
+
+from Core import *
+
+usage = "perf script -s frame-pipeline.py [surfaceflinger pid]\n";
+
+sf_pid = -1
+
+if len(sys.argv) > 2:
+	sys.exit(usage)
+
+if len(sys.argv) > 1:
+	sf_pid = int(sys.argv[1])
+
+stages = ["app", "gpu", "sf", "compose", "b2r2", "display", "total"]
+
+samples = dict((stage, []) for stage in stages)
+reasons = {}
+missed = 0
+frames = 0
+
+# What happened since the scene of the last frame was posted
+pending = {}
+
+# Frames on their way, by id, and the frame of a B2R2 job
+inflight = {}
+blit_frame = {}
+
+# Per channel, the time of the last scanout and the VCMPs since then
+last_scanout = {}
+repeats = autodict()
+
+def nsecs_of(secs, nsecs):
+	return secs * 1000000000 + nsecs
+
+def reset_pending():
+	pending.clear()
+	pending["input"] = 0
+	pending["binder"] = 0
+	pending["gpu_start"] = 0
+	pending["gpu_done"] = 0
+
+reset_pending()
+
+def span(frame, start, end):
+	if frame.get(start) and frame.get(end) and frame[end] >= frame[start]:
+		return frame[end] - frame[start]
+	return None
+
+def frame_done(frame, chnl, now):
+	global frames, missed
+
+	frame["scanout"] = now
+	start = frame["input"] or frame["binder"] or frame["begin"]
+	frame["start"] = start
+
+	times = {}
+	times["app"] = span(frame, "input", "binder")
+	times["gpu"] = span(frame, "gpu_start", "gpu_done")
+	times["sf"] = span(frame, "binder", "begin")
+	times["compose"] = span(frame, "begin", "commit")
+	times["b2r2"] = span(frame, "b2r2_start", "b2r2_done")
+	times["display"] = span(frame, "commit", "scanout")
+	times["total"] = span(frame, "start", "scanout")
+
+	frames += 1
+	for stage in stages:
+		if times[stage] is not None:
+			samples[stage].append(times[stage])
+
+	# The VCMPs showing the last frame again after this one started
+	n = 0
+	for vcmp in repeats[chnl] or []:
+		if vcmp > start:
+			n += 1
+	repeats[chnl] = []
+	last_scanout[chnl] = now
+	if n == 0:
+		return
+
+	missed += n
+	worst = None
+	for stage in stages[:-1]:
+		if times[stage] is not None and \
+		   (worst is None or times[stage] > times[worst]):
+			worst = stage
+	if worst:
+		reasons[worst] = reasons.get(worst, 0) + n
+
+def percentile(values, pct):
+	return values[min(len(values) - 1, len(values) * pct / 100)]
+
+def trace_end():
+	print "%d frames, %d missed vsyncs\n" % (frames, missed)
+	if frames == 0:
+		return
+	print "%-10s %8s %10s %10s %10s %10s" % ("stage", "frames",
+		"p50_us", "p90_us", "p99_us", "max_us")
+	for stage in stages:
+		values = sorted(samples[stage])
+		if not values:
+			continue
+		print "%-10s %8d %10d %10d %10d %10d" % (stage, len(values),
+			percentile(values, 50) / 1000,
+			percentile(values, 90) / 1000,
+			percentile(values, 99) / 1000,
+			values[-1] / 1000)
+	if missed:
+		print "\nmissed vsyncs by longest stage:"
+		for stage in stages:
+			if stage in reasons:
+				print "%-10s %8d" % (stage, reasons[stage])
+
+def input__input_frame(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	name, timestamp):
+	if not pending["input"]:
+		pending["input"] = nsecs_of(common_secs, common_nsecs)
+
+def binder__binder_transaction(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	debug_id, target_node, to_proc, to_thread, reply, code, flags):
+	if to_proc == sf_pid and not reply:
+		pending["binder"] = nsecs_of(common_secs, common_nsecs)
+
+def mali__mali_job_start(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	pp, core_id, job_id, pid, frame_builder_id, flush_id):
+	if not pending["gpu_start"]:
+		pending["gpu_start"] = nsecs_of(common_secs, common_nsecs)
+
+def mali__mali_job_done(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	pp, core_id, job_id, pid, frame_builder_id, flush_id):
+	if pending["gpu_start"]:
+		pending["gpu_done"] = nsecs_of(common_secs, common_nsecs)
+
+def compdev__compdev_frame(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	dev, frame, img_count):
+	inflight[frame] = dict(pending)
+	inflight[frame]["begin"] = nsecs_of(common_secs, common_nsecs)
+	reset_pending()
+
+def compdev__compdev_blit(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	frame, job_id):
+	if frame in inflight:
+		blit_frame[job_id] = inflight[frame]
+
+def compdev__compdev_commit(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	frame, chnl):
+	if frame in inflight:
+		inflight[frame]["commit"] = nsecs_of(common_secs, common_nsecs)
+		inflight[frame]["chnl"] = chnl
+
+def b2r2__b2r2_hw_start(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	job, job_id, queue):
+	frame = blit_frame.get(job_id)
+	if frame is not None and not frame.get("b2r2_start"):
+		frame["b2r2_start"] = nsecs_of(common_secs, common_nsecs)
+
+def b2r2__b2r2_hw_done(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	job, job_id, nsec_in_hw):
+	frame = blit_frame.pop(job_id, None)
+	if frame is not None:
+		frame["b2r2_done"] = nsecs_of(common_secs, common_nsecs)
+
+def mcde__vcmp(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	chnl, state):
+	if chnl in last_scanout:
+		if not repeats[chnl]:
+			repeats[chnl] = []
+		repeats[chnl].append(nsecs_of(common_secs, common_nsecs))
+
+def mcde__scanout(event_name, context, common_cpu,
+	common_secs, common_nsecs, common_pid, common_comm,
+	chnl, frame):
+	now = nsecs_of(common_secs, common_nsecs)
+	# The VCMP this scanout is traced from does not show the last frame
+	if repeats[chnl]:
+		repeats[chnl].pop()
+	# Frames of the channel replaced before they were shown are dropped
+	for f in [f for f in inflight
+		  if f < frame and inflight[f].get("chnl") == chnl]:
+		del inflight[f]
+	if frame in inflight:
+		frame_done(inflight.pop(frame), chnl, now)
+	else:
+		last_scanout[chnl] = now
+		repeats[chnl] = []